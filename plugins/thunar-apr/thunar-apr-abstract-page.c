@@ -52,6 +52,7 @@ static void thunar_apr_abstract_page_set_property (GObject                    *o
                                                    guint                       prop_id,
                                                    const GValue               *value,
                                                    GParamSpec                 *pspec);
+static void thunar_apr_abstract_page_map          (GtkWidget                  *widget);
 static void thunar_apr_abstract_page_file_changed (ThunarAprAbstractPage      *abstract_page,
                                                    ThunarxFileInfo            *file);
 
@@ -70,13 +71,17 @@ THUNARX_DEFINE_ABSTRACT_TYPE (ThunarAprAbstractPage,
 static void
 thunar_apr_abstract_page_class_init (ThunarAprAbstractPageClass *klass)
 {
-  GObjectClass *gobject_class;
+  GtkWidgetClass *gtkwidget_class;
+  GObjectClass   *gobject_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->dispose = thunar_apr_abstract_page_dispose;
   gobject_class->get_property = thunar_apr_abstract_page_get_property;
   gobject_class->set_property = thunar_apr_abstract_page_set_property;
 
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->map = thunar_apr_abstract_page_map;
+
   /**
    * ThunarAprAbstractPage:file:
    *
@@ -95,7 +100,9 @@ thunar_apr_abstract_page_class_init (ThunarAprAbstractPageClass *klass)
    * @file          : a #ThunarxFileInfo.
    *
    * Emitted by @abstract_page whenever the associated
-   * @file changes.
+   * @file changes. While @abstract_page is not mapped, i.e.
+   * its tab was not selected yet, this is delayed until it
+   * is mapped.
    **/
   abstract_page_signals[FILE_CHANGED] =
     g_signal_new ("file-changed",
@@ -176,10 +183,33 @@ thunar_apr_abstract_page_set_property (GObject      *object,
 
 
 
+static void
+thunar_apr_abstract_page_map (GtkWidget *widget)
+{
+  ThunarAprAbstractPage *abstract_page = THUNAR_APR_ABSTRACT_PAGE (widget);
+
+  (*GTK_WIDGET_CLASS (thunar_apr_abstract_page_parent_class)->map) (widget);
+
+  /* load the contents now that the page is visible */
+  if (abstract_page->changed_pending && abstract_page->file != NULL)
+    thunar_apr_abstract_page_file_changed (abstract_page, abstract_page->file);
+}
+
+
+
 static void
 thunar_apr_abstract_page_file_changed (ThunarAprAbstractPage *abstract_page,
                                        ThunarxFileInfo       *file)
 {
+  /* don't load anything for pages nobody looks at */
+  if (!gtk_widget_get_mapped (GTK_WIDGET (abstract_page)))
+    {
+      abstract_page->changed_pending = TRUE;
+      return;
+    }
+
+  abstract_page->changed_pending = FALSE;
+
   /* emit the "file-changed" signal */
   g_signal_emit (G_OBJECT (abstract_page), abstract_page_signals[FILE_CHANGED], 0, file);
 }
@@ -48,6 +48,9 @@ struct _ThunarAprAbstractPage
 {
   ThunarxPropertyPage __parent__;
   ThunarxFileInfo    *file;
+
+  /* whether the file changed while the page was not mapped */
+  gboolean            changed_pending;
 };
 
 GType            thunar_apr_abstract_page_get_type      (void) G_GNUC_CONST;
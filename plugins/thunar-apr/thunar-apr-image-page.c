@@ -32,6 +32,12 @@
 
 
 
+/* the number of images whose info is remembered */
+#define IMAGE_INFO_CACHE_SIZE (64)
+
+
+
+static void thunar_apr_image_page_dispose       (GObject                  *object);
 static void thunar_apr_image_page_file_changed  (ThunarAprAbstractPage    *abstract_page,
                                                  ThunarxFileInfo          *file);
 
@@ -63,6 +69,23 @@ static const struct
 
 
 
+typedef struct
+{
+  gchar *key;
+  gchar *filename;
+
+  /* the pixbuf format, %NULL if unknown */
+  gchar *type;
+  gint   width;
+  gint   height;
+
+#ifdef HAVE_EXIF
+  gchar *exif[G_N_ELEMENTS (TAIP_EXIF)];
+#endif
+} ImageInfo;
+
+
+
 struct _ThunarAprImagePageClass
 {
   ThunarAprAbstractPageClass __parent__;
@@ -74,6 +97,9 @@ struct _ThunarAprImagePage
   GtkWidget            *type_label;
   GtkWidget            *dimensions_label;
 
+  /* the pending load of the image info */
+  GCancellable         *cancellable;
+
 #ifdef HAVE_EXIF
   GtkWidget            *exif_labels[G_N_ELEMENTS (TAIP_EXIF)];
 #endif
@@ -87,10 +113,19 @@ THUNARX_DEFINE_TYPE (ThunarAprImagePage,
 
 
 
+/* the info of the recently shown images, by URI and modification time */
+static GHashTable *image_info_cache = NULL;
+
+
+
 static void
 thunar_apr_image_page_class_init (ThunarAprImagePageClass *klass)
 {
   ThunarAprAbstractPageClass *thunarapr_abstract_page_class;
+  GObjectClass               *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->dispose = thunar_apr_image_page_dispose;
 
   thunarapr_abstract_page_class = THUNAR_APR_ABSTRACT_PAGE_CLASS (klass);
   thunarapr_abstract_page_class->file_changed = thunar_apr_image_page_file_changed;
@@ -211,24 +246,246 @@ thunar_apr_image_page_init (ThunarAprImagePage *image_page)
 
 
 
+static void
+thunar_apr_image_page_dispose (GObject *object)
+{
+  ThunarAprImagePage *image_page = THUNAR_APR_IMAGE_PAGE (object);
+
+  /* the pending load leaves the page alone once cancelled */
+  if (image_page->cancellable != NULL)
+    {
+      g_cancellable_cancel (image_page->cancellable);
+      g_object_unref (image_page->cancellable);
+      image_page->cancellable = NULL;
+    }
+
+  (*G_OBJECT_CLASS (thunar_apr_image_page_parent_class)->dispose) (object);
+}
+
+
+
+static void
+image_info_free (gpointer data)
+{
+  ImageInfo *info = data;
+#ifdef HAVE_EXIF
+  guint      n;
+
+  for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+    g_free (info->exif[n]);
+#endif
+
+  g_free (info->type);
+  g_free (info->filename);
+  g_free (info->key);
+  g_slice_free (ImageInfo, info);
+}
+
+
+
+static void
+thunar_apr_image_page_set_format (ThunarAprImagePage *image_page,
+                                  const ImageInfo    *info)
+{
+  gchar *text;
+
+  if (G_LIKELY (info->type != NULL))
+    {
+      /* update the "Image Type" label */
+      gtk_label_set_text (GTK_LABEL (image_page->type_label), info->type);
+
+      /* update the "Image Size" label */
+      text = g_strdup_printf (ngettext ("%dx%d pixel", "%dx%d pixels", info->width + info->height), info->width, info->height);
+      gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), text);
+      g_free (text);
+    }
+  else
+    {
+      /* tell the user that we're unable to determine the file info */
+      gtk_label_set_text (GTK_LABEL (image_page->type_label), _("Unknown"));
+      gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), _("Unknown"));
+    }
+}
+
+
+
+#ifdef HAVE_EXIF
+static void
+thunar_apr_image_page_set_exif (ThunarAprImagePage *image_page,
+                                const ImageInfo    *info)
+{
+  guint n;
+
+  /* show the labels of the available Exif data */
+  for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+    {
+      if (info->exif[n] != NULL)
+        {
+          gtk_label_set_text (GTK_LABEL (image_page->exif_labels[n]), info->exif[n]);
+          gtk_widget_show (image_page->exif_labels[n]);
+        }
+      else
+        {
+          gtk_widget_hide (image_page->exif_labels[n]);
+        }
+    }
+}
+#endif
+
+
+
+static void
+thunar_apr_image_page_loaded (ThunarAprImagePage *image_page,
+                              ImageInfo          *info)
+{
+  /* drop all images at once when the cache is full, this is rare */
+  if (G_UNLIKELY (image_info_cache == NULL))
+    image_info_cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, image_info_free);
+  else if (g_hash_table_size (image_info_cache) >= IMAGE_INFO_CACHE_SIZE)
+    g_hash_table_remove_all (image_info_cache);
+
+  g_hash_table_replace (image_info_cache, info->key, info);
+
+  g_clear_object (&image_page->cancellable);
+}
+
+
+
+#ifdef HAVE_EXIF
+static void
+thunar_apr_image_page_exif_thread (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+  ImageInfo *info = task_data;
+  ExifEntry *exif_entry;
+  ExifData  *exif_data;
+  gchar      exif_buffer[1024];
+  guint      n;
+
+  /* libexif stops reading once it found the Exif block at the start of the file */
+  exif_data = g_cancellable_is_cancelled (cancellable) ? NULL : exif_data_new_from_file (info->filename);
+  if (G_LIKELY (exif_data != NULL))
+    {
+      for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+        {
+          /* lookup the entry for the tag and determine the value */
+          exif_entry = exif_data_get_entry (exif_data, TAIP_EXIF[n].tag);
+          if (G_LIKELY (exif_entry != NULL)
+              && exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
+            {
+              info->exif[n] = (g_utf8_validate (exif_buffer, -1, NULL)) ? g_strdup (exif_buffer) : g_filename_display_name (exif_buffer);
+            }
+        }
+
+      exif_data_free (exif_data);
+    }
+
+  g_task_return_pointer (task, info, image_info_free);
+}
+
+
+
+static void
+thunar_apr_image_page_exif_ready (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  ThunarAprImagePage *image_page;
+  ImageInfo          *info;
+
+  /* if the load was cancelled, the page may be gone already */
+  info = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (G_UNLIKELY (info == NULL))
+    return;
+
+  image_page = THUNAR_APR_IMAGE_PAGE (user_data);
+  thunar_apr_image_page_set_exif (image_page, info);
+  thunar_apr_image_page_loaded (image_page, info);
+}
+#endif
+
+
+
+static void
+thunar_apr_image_page_format_thread (GTask        *task,
+                                     gpointer      source_object,
+                                     gpointer      task_data,
+                                     GCancellable *cancellable)
+{
+  GdkPixbufFormat *format;
+  ImageInfo       *info = task_data;
+
+  /* the loaders only read the header to determine the size */
+  format = g_cancellable_is_cancelled (cancellable) ? NULL : gdk_pixbuf_get_file_info (info->filename, &info->width, &info->height);
+  if (G_LIKELY (format != NULL))
+    info->type = g_strdup_printf ("%s (%s)", gdk_pixbuf_format_get_name (format), gdk_pixbuf_format_get_description (format));
+
+  g_task_return_pointer (task, info, image_info_free);
+}
+
+
+
+static void
+thunar_apr_image_page_format_ready (GObject      *object,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  ThunarAprImagePage *image_page;
+  ImageInfo          *info;
+#ifdef HAVE_EXIF
+  GTask              *task;
+#endif
+
+  /* if the load was cancelled, the page may be gone already */
+  info = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (G_UNLIKELY (info == NULL))
+    return;
+
+  /* show the format right away, the Exif data follows */
+  image_page = THUNAR_APR_IMAGE_PAGE (user_data);
+  thunar_apr_image_page_set_format (image_page, info);
+
+#ifdef HAVE_EXIF
+  if (G_LIKELY (info->type != NULL))
+    {
+      task = g_task_new (NULL, image_page->cancellable, thunar_apr_image_page_exif_ready, image_page);
+      g_task_set_task_data (task, info, NULL);
+      g_task_run_in_thread (task, thunar_apr_image_page_exif_thread);
+      g_object_unref (task);
+      return;
+    }
+#endif
+
+  thunar_apr_image_page_loaded (image_page, info);
+}
+
+
+
 static void
 thunar_apr_image_page_file_changed (ThunarAprAbstractPage *abstract_page,
                                     ThunarxFileInfo       *file)
 {
   ThunarAprImagePage *image_page = THUNAR_APR_IMAGE_PAGE (abstract_page);
-  GdkPixbufFormat    *format;
+  ImageInfo          *info;
+  GFileInfo          *file_info;
+  guint64             mtime = 0;
   gchar              *filename;
-  gchar              *text;
   gchar              *uri;
-  gint                height;
-  gint                width;
+  gchar              *key;
+  GTask              *task;
 #ifdef HAVE_EXIF
-  ExifEntry          *exif_entry;
-  ExifData           *exif_data;
-  gchar               exif_buffer[1024];
   guint               n;
 #endif
 
+  /* stop loading the info of the previous file */
+  if (image_page->cancellable != NULL)
+    {
+      g_cancellable_cancel (image_page->cancellable);
+      g_clear_object (&image_page->cancellable);
+    }
+
   /* determine the URI for the file */
   uri = thunarx_file_info_get_uri (file);
   if (G_UNLIKELY (uri == NULL))
@@ -236,76 +493,53 @@ thunar_apr_image_page_file_changed (ThunarAprAbstractPage *abstract_page,
 
   /* determine the local path of the file */
   filename = g_filename_from_uri (uri, NULL, NULL);
-  if (G_LIKELY (filename != NULL))
+  if (G_UNLIKELY (filename == NULL))
     {
-      /* determine the pixbuf format */
-      format = gdk_pixbuf_get_file_info (filename, &width, &height);
-      if (G_LIKELY (format != NULL))
-        {
-          /* update the "Image Type" label */
-          text = g_strdup_printf ("%s (%s)", gdk_pixbuf_format_get_name (format), gdk_pixbuf_format_get_description (format));
-          gtk_label_set_text (GTK_LABEL (image_page->type_label), text);
-          g_free (text);
+      g_free (uri);
+      return;
+    }
 
-          /* update the "Image Size" label */
-          text = g_strdup_printf (ngettext ("%dx%d pixel", "%dx%d pixels", width + height), width, height);
-          gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), text);
-          g_free (text);
+  /* the info stays valid as long as the file is not modified */
+  file_info = thunarx_file_info_get_file_info (file);
+  if (G_LIKELY (file_info != NULL))
+    {
+      mtime = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      g_object_unref (file_info);
+    }
+  key = g_strdup_printf ("%s\n%" G_GUINT64_FORMAT, uri, mtime);
+  g_free (uri);
 
+  info = (image_info_cache != NULL) ? g_hash_table_lookup (image_info_cache, key) : NULL;
+  if (info != NULL)
+    {
+      /* the image was shown before */
+      thunar_apr_image_page_set_format (image_page, info);
 #ifdef HAVE_EXIF
-          /* hide all Exif labels (will be shown again if data is available) */
-          for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
-            gtk_widget_hide (image_page->exif_labels[n]);
-
-          /* try to load the Exif data for the file */
-          exif_data = exif_data_new_from_file (filename);
-          if (G_LIKELY (exif_data != NULL))
-            {
-              /* update all Exif labels */
-              for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
-                {
-                  /* lookup the entry for the tag */
-                  exif_entry = exif_data_get_entry (exif_data, TAIP_EXIF[n].tag);
-                  if (G_LIKELY (exif_entry != NULL))
-                    {
-                      /* determine the value */
-                      if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
-                        {
-                          /* setup the label text */
-                          text = (g_utf8_validate (exif_buffer, -1, NULL)) ? g_strdup (exif_buffer) : g_filename_display_name (exif_buffer);
-                          gtk_label_set_text (GTK_LABEL (image_page->exif_labels[n]), text);
-                          g_free (text);
-
-                          /* show the label */
-                          gtk_widget_show (image_page->exif_labels[n]);
-                        }
-                    }
-                }
-
-              /* cleanup */
-              exif_data_free (exif_data);
-            }
+      thunar_apr_image_page_set_exif (image_page, info);
 #endif
-        }
-      else
-        {
-          /* tell the user that we're unable to determine the file info */
-          gtk_label_set_text (GTK_LABEL (image_page->type_label), _("Unknown"));
-          gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), _("Unknown"));
+      g_free (filename);
+      g_free (key);
+      return;
+    }
+
+  gtk_label_set_text (GTK_LABEL (image_page->type_label), _("Loading..."));
+  gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), _("Loading..."));
 
 #ifdef HAVE_EXIF
-          /* hide all Exif labels */
-          for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
-            gtk_widget_hide (image_page->exif_labels[n]);
+  /* hide all Exif labels (will be shown again if data is available) */
+  for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+    gtk_widget_hide (image_page->exif_labels[n]);
 #endif
-        }
-    }
 
-  /* cleanup */
-  g_free (filename);
-  g_free (uri);
+  /* reading the image can take long on network shares, so it is
+   * done in a thread, the info is handed back with the result */
+  info = g_slice_new0 (ImageInfo);
+  info->key = key;
+  info->filename = filename;
+
+  image_page->cancellable = g_cancellable_new ();
+  task = g_task_new (NULL, image_page->cancellable, thunar_apr_image_page_format_ready, image_page);
+  g_task_set_task_data (task, info, NULL);
+  g_task_run_in_thread (task, thunar_apr_image_page_format_thread);
+  g_object_unref (task);
 }
-
-
-
-
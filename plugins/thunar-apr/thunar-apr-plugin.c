@@ -57,6 +57,10 @@ thunar_extension_initialize (ThunarxProviderPlugin *plugin)
   g_message ("Initializing ThunarApr extension");
 #endif
 
+  /* the image page loads in threads and caches the image info, so the
+   * code has to stay around */
+  thunarx_provider_plugin_set_resident (plugin, TRUE);
+
   /* register the types provided by this plugin */
   thunar_apr_abstract_page_register_type (plugin);
   thunar_apr_desktop_page_register_type (plugin);
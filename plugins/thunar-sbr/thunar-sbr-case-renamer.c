@@ -37,18 +37,23 @@ enum
 
 
 
-static void   thunar_sbr_case_renamer_get_property  (GObject                    *object,
-                                                     guint                       prop_id,
-                                                     GValue                     *value,
-                                                     GParamSpec                 *pspec);
-static void   thunar_sbr_case_renamer_set_property  (GObject                    *object,
-                                                     guint                       prop_id,
-                                                     const GValue               *value,
-                                                     GParamSpec                 *pspec);
-static gchar *thunar_sbr_case_renamer_process       (ThunarxRenamer             *renamer,
-                                                     ThunarxFileInfo            *file,
-                                                     const gchar                *text,
-                                                     guint                       idx);
+static void     thunar_sbr_case_renamer_get_property     (GObject                    *object,
+                                                          guint                       prop_id,
+                                                          GValue                     *value,
+                                                          GParamSpec                 *pspec);
+static void     thunar_sbr_case_renamer_set_property     (GObject                    *object,
+                                                          guint                       prop_id,
+                                                          const GValue               *value,
+                                                          GParamSpec                 *pspec);
+static gchar   *thunar_sbr_case_renamer_process          (ThunarxRenamer             *renamer,
+                                                          ThunarxFileInfo            *file,
+                                                          const gchar                *text,
+                                                          guint                       idx);
+static gpointer thunar_sbr_case_renamer_snapshot         (ThunarxRenamer             *renamer);
+static gchar   *thunar_sbr_case_renamer_process_snapshot (gconstpointer               snapshot,
+                                                          ThunarxFileInfo            *file,
+                                                          const gchar                *text,
+                                                          guint                       idx);
 
 
 
@@ -81,6 +86,9 @@ thunar_sbr_case_renamer_class_init (ThunarSbrCaseRenamerClass *klass)
 
   thunarxrenamer_class = THUNARX_RENAMER_CLASS (klass);
   thunarxrenamer_class->process = thunar_sbr_case_renamer_process;
+  thunarxrenamer_class->snapshot = thunar_sbr_case_renamer_snapshot;
+  thunarxrenamer_class->process_snapshot = thunar_sbr_case_renamer_process_snapshot;
+  thunarxrenamer_class->free_snapshot = g_free;
 
   /**
    * ThunarSbrCaseRenamer:mode:
@@ -223,14 +231,10 @@ tscr_utf8_strcase (const gchar *text,
 
 
 static gchar*
-thunar_sbr_case_renamer_process (ThunarxRenamer  *renamer,
-                                 ThunarxFileInfo *file,
-                                 const gchar     *text,
-                                 guint            idx)
+tscr_process (ThunarSbrCaseRenamerMode  mode,
+              const gchar              *text)
 {
-  ThunarSbrCaseRenamer *case_renamer = THUNAR_SBR_CASE_RENAMER (renamer);
-
-  switch (case_renamer->mode)
+  switch (mode)
     {
     case THUNAR_SBR_CASE_RENAMER_MODE_LOWER:
       return g_utf8_strdown (text, -1);
@@ -252,6 +256,42 @@ thunar_sbr_case_renamer_process (ThunarxRenamer  *renamer,
 
 
 
+static gchar*
+thunar_sbr_case_renamer_process (ThunarxRenamer  *renamer,
+                                 ThunarxFileInfo *file,
+                                 const gchar     *text,
+                                 guint            idx)
+{
+  return tscr_process (THUNAR_SBR_CASE_RENAMER (renamer)->mode, text);
+}
+
+
+
+static gpointer
+thunar_sbr_case_renamer_snapshot (ThunarxRenamer *renamer)
+{
+  ThunarSbrCaseRenamerMode *mode;
+
+  /* the mode is all we need */
+  mode = g_new (ThunarSbrCaseRenamerMode, 1);
+  *mode = THUNAR_SBR_CASE_RENAMER (renamer)->mode;
+
+  return mode;
+}
+
+
+
+static gchar*
+thunar_sbr_case_renamer_process_snapshot (gconstpointer    snapshot,
+                                          ThunarxFileInfo *file,
+                                          const gchar     *text,
+                                          guint            idx)
+{
+  return tscr_process (*((const ThunarSbrCaseRenamerMode *) snapshot), text);
+}
+
+
+
 /**
  * thunar_sbr_case_renamer_new:
  *
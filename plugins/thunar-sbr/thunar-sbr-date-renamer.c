@@ -40,6 +40,7 @@
 
 #ifdef HAVE_EXIF
 #include <libexif/exif-data.h>
+#include <libexif/exif-loader.h>
 #endif
 
 
@@ -69,8 +70,11 @@ static gchar  *thunar_sbr_get_time_string           (guint64
                                                      const gchar               *custom_format);
 #ifdef HAVE_EXIF
 static guint64 thunar_sbr_get_time_from_string      (const gchar               *string);
+static guint64 thunar_sbr_get_time_taken            (ThunarSbrDateRenamer      *date_renamer,
+                                                     ThunarxFileInfo           *file);
 #endif
-static guint64 thunar_sbr_get_time                  (ThunarxFileInfo           *file,
+static guint64 thunar_sbr_get_time                  (ThunarSbrDateRenamer      *date_renamer,
+                                                     ThunarxFileInfo           *file,
                                                      ThunarSbrDateMode          mode);
 static gchar  *thunar_sbr_date_renamer_process      (ThunarxRenamer            *renamer,
                                                      ThunarxFileInfo           *file,
@@ -91,8 +95,23 @@ struct _ThunarSbrDateRenamer
   guint               offset;
   ThunarSbrOffsetMode offset_mode;
   gchar              *format;
+
+#ifdef HAVE_EXIF
+  /* uri -> ThunarSbrTakenTime, so the previews do not read the
+   * exif data of every file again whenever a setting changes */
+  GHashTable         *taken_times;
+#endif
 };
 
+#ifdef HAVE_EXIF
+typedef struct
+{
+  guint64 mtime;
+  guint64 taken_time;
+}
+ThunarSbrTakenTime;
+#endif
+
 
 
 THUNARX_DEFINE_TYPE (ThunarSbrDateRenamer, thunar_sbr_date_renamer, THUNARX_TYPE_RENAMER);
@@ -184,6 +203,10 @@ thunar_sbr_date_renamer_init (ThunarSbrDateRenamer *date_renamer)
   GtkAdjustment  *adjustment;
   guint           n;
 
+#ifdef HAVE_EXIF
+  date_renamer->taken_times = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+#endif
+
   grid = gtk_grid_new ();
   gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
   gtk_grid_set_column_spacing (GTK_GRID (grid), 12);
@@ -277,6 +300,11 @@ thunar_sbr_date_renamer_finalize (GObject *object)
   /* release the format */
   g_free (date_renamer->format);
 
+#ifdef HAVE_EXIF
+  /* release the exif times */
+  g_hash_table_destroy (date_renamer->taken_times);
+#endif
+
   (*G_OBJECT_CLASS (thunar_sbr_date_renamer_parent_class)->finalize) (object);
 }
 
@@ -427,19 +455,97 @@ thunar_sbr_get_time_from_string (const gchar *string)
 
 
 
+#ifdef HAVE_EXIF
 static guint64
-thunar_sbr_get_time (ThunarxFileInfo   *file,
-                     ThunarSbrDateMode  mode)
+thunar_sbr_get_time_taken (ThunarSbrDateRenamer *date_renamer,
+                           ThunarxFileInfo      *file)
+{
+  ThunarSbrTakenTime *taken_time;
+  GFileInputStream   *stream;
+  ExifLoader         *exif_loader;
+  ExifEntry          *exif_entry;
+  ExifData           *exif_data;
+  GFileInfo          *file_info;
+  guint64             file_time = 0;
+  guint64             mtime;
+  GFile              *location;
+  gchar               exif_buffer[128];
+  guchar              buffer[4096];
+  gssize              n_read;
+  gchar              *uri;
+
+  /* the cached time is valid as long as the file was not modified */
+  file_info = thunarx_file_info_get_file_info (file);
+  mtime = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  g_object_unref (file_info);
+
+  uri = thunarx_file_info_get_uri (file);
+  taken_time = g_hash_table_lookup (date_renamer->taken_times, uri);
+  if (taken_time != NULL && taken_time->mtime == mtime)
+    {
+      g_free (uri);
+      return taken_time->taken_time;
+    }
+
+  /* read the file only up to the end of the exif data, which is
+   * at the start of the file (the APP1 segment of a jpeg image) */
+  location = thunarx_file_info_get_location (file);
+  stream = g_file_read (location, NULL, NULL);
+  if (G_LIKELY (stream != NULL))
+    {
+      exif_loader = exif_loader_new ();
+      while ((n_read = g_input_stream_read (G_INPUT_STREAM (stream), buffer, sizeof (buffer), NULL, NULL)) > 0)
+        if (!exif_loader_write (exif_loader, buffer, n_read))
+          break;
+      g_object_unref (stream);
+
+      exif_data = exif_loader_get_data (exif_loader);
+      exif_loader_unref (exif_loader);
+
+      if (G_LIKELY (exif_data != NULL))
+        {
+          /* lookup the entry for the tag, fallback on less common ones */
+          exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
+
+          if (exif_entry == NULL)
+            exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
+
+          if (exif_entry == NULL)
+            exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
+
+          if (G_LIKELY (exif_entry != NULL))
+            {
+              /* determine the value */
+              if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
+                file_time = thunar_sbr_get_time_from_string (exif_buffer);
+            }
+
+          /* cleanup */
+          exif_data_unref (exif_data);
+        }
+    }
+  g_object_unref (location);
+
+  /* remember the time, also if there is none */
+  taken_time = g_new (ThunarSbrTakenTime, 1);
+  taken_time->mtime = mtime;
+  taken_time->taken_time = file_time;
+  g_hash_table_replace (date_renamer->taken_times, uri, taken_time);
+
+  return file_time;
+}
+#endif
+
+
+
+static guint64
+thunar_sbr_get_time (ThunarSbrDateRenamer *date_renamer,
+                     ThunarxFileInfo      *file,
+                     ThunarSbrDateMode     mode)
 {
 
   GFileInfo *file_info;
   guint64    file_time = 0;
-#ifdef HAVE_EXIF
-  gchar     *uri, *filename;
-  ExifEntry *exif_entry;
-  ExifData  *exif_data;
-  gchar     exif_buffer[128];
-#endif
 
   switch (mode)
     {
@@ -471,46 +577,8 @@ thunar_sbr_get_time (ThunarxFileInfo   *file,
 
 #ifdef HAVE_EXIF
     case THUNAR_SBR_DATE_MODE_TAKEN:
-      /* get the uri */
-      uri = thunarx_file_info_get_uri (file);
-      if (G_LIKELY (uri != NULL))
-        {
-          /* determine the local path of the file */
-          filename = g_filename_from_uri (uri, NULL, NULL);
-          if (G_LIKELY (filename != NULL))
-            {
-              /* try to load the exif data for the file */
-              exif_data = exif_data_new_from_file (filename);
-              if (G_LIKELY (exif_data != NULL))
-                {
-                  /* lookup the entry for the tag, fallback on less common ones */
-                  exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
-
-                  if (G_LIKELY (exif_entry != NULL))
-                    {
-                      /* determine the value */
-                      if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
-                        file_time = thunar_sbr_get_time_from_string (exif_buffer);
-                    }
-
-                  /* cleanup */
-                  exif_data_free (exif_data);
-                }
-
-              /* cleanup */
-              g_free (filename);
-            }
-
-          /* cleanup */
-          g_free (uri);
-        }
-
+      /* get the time the picture was taken */
+      file_time = thunar_sbr_get_time_taken (date_renamer, file);
       break;
 #endif
     }
@@ -547,7 +615,7 @@ thunar_sbr_date_renamer_process (ThunarxRenamer  *renamer,
     return g_strdup (text);
 
   /* get the file time */
-  file_time = thunar_sbr_get_time (file, date_renamer->mode);
+  file_time = thunar_sbr_get_time (date_renamer, file, date_renamer->mode);
   if (file_time == 0)
     return g_strdup (text);
 
@@ -39,6 +39,17 @@
 
 
 
+/* number of compiled patterns kept around while the pattern is edited */
+#define TSRR_REGEX_CACHE_SIZE (8)
+
+/* number of capture groups whose match offsets fit on the stack */
+#define TSRR_OVEC_STACK_SIZE (3 * 32)
+
+/* upper limit for the number of remembered results */
+#define TSRR_RESULTS_MAX (100000)
+
+
+
 /* Property identifiers */
 enum
 {
@@ -51,6 +62,34 @@ enum
 
 
 
+#ifdef HAVE_PCRE
+typedef struct
+{
+  gint        ref_count;
+  gchar      *pattern;
+  gboolean    case_sensitive;
+  pcre       *code;
+  pcre_extra *extra;
+  gint        capture_count;
+}
+TsrrRegex;
+#endif
+
+/* the settings used from the preview threads */
+typedef struct
+{
+  gchar     *pattern;
+  gchar     *replacement;
+  gboolean   case_sensitive;
+  gboolean   regexp;
+#ifdef HAVE_PCRE
+  TsrrRegex *regex;
+#endif
+}
+TsrrSnapshot;
+
+
+
 static void   thunar_sbr_replace_renamer_finalize     (GObject                      *object);
 static void   thunar_sbr_replace_renamer_get_property (GObject                      *object,
                                                        guint                         prop_id,
@@ -65,8 +104,16 @@ static gchar *thunar_sbr_replace_renamer_process      (ThunarxRenamer
                                                        ThunarxFileInfo              *file,
                                                        const gchar                  *text,
                                                        guint                         idx);
+static gpointer thunar_sbr_replace_renamer_snapshot   (ThunarxRenamer               *renamer);
+static gchar *thunar_sbr_replace_renamer_process_snapshot (gconstpointer            snapshot,
+                                                       ThunarxFileInfo              *file,
+                                                       const gchar                  *text,
+                                                       guint                         idx);
+static void   thunar_sbr_replace_renamer_free_snapshot (gpointer                    snapshot);
+static void   thunar_sbr_replace_renamer_changed      (ThunarSbrReplaceRenamer      *replace_renamer);
 #ifdef HAVE_PCRE
-static gchar *thunar_sbr_replace_renamer_pcre_exec    (ThunarSbrReplaceRenamer      *replace_renamer,
+static gchar *thunar_sbr_replace_renamer_pcre_exec    (TsrrRegex                    *regex,
+                                                       const gchar                  *replacement,
                                                        const gchar                  *text);
 static void   thunar_sbr_replace_renamer_pcre_update  (ThunarSbrReplaceRenamer      *replace_renamer);
 #endif
@@ -90,10 +137,13 @@ struct _ThunarSbrReplaceRenamer
   /* TRUE if PCRE is available and supports UTF-8 */
   gint           regexp_supported;
 
-  /* PCRE compiled pattern */
+  /* the results for the current settings by input text */
+  GHashTable    *results;
+
+  /* PCRE compiled pattern and the recently used patterns */
 #ifdef HAVE_PCRE
-  pcre          *pcre_pattern;
-  gint           pcre_capture_count;
+  TsrrRegex     *regex;
+  GQueue         regex_cache;
 #endif
 };
 
@@ -120,6 +170,9 @@ thunar_sbr_replace_renamer_class_init (ThunarSbrReplaceRenamerClass *klass)
 
   thunarxrenamer_class = THUNARX_RENAMER_CLASS (klass);
   thunarxrenamer_class->process = thunar_sbr_replace_renamer_process;
+  thunarxrenamer_class->snapshot = thunar_sbr_replace_renamer_snapshot;
+  thunarxrenamer_class->process_snapshot = thunar_sbr_replace_renamer_process_snapshot;
+  thunarxrenamer_class->free_snapshot = thunar_sbr_replace_renamer_free_snapshot;
 
   /**
    * ThunarSbrReplaceRenamer:case-sensitive:
@@ -193,6 +246,8 @@ thunar_sbr_replace_renamer_init (ThunarSbrReplaceRenamer *replace_renamer)
     replace_renamer->regexp_supported = FALSE;
 #endif
 
+  replace_renamer->results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
   grid = gtk_grid_new ();
   gtk_grid_set_column_spacing (GTK_GRID (grid), 12);
   gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
@@ -260,17 +315,96 @@ thunar_sbr_replace_renamer_init (ThunarSbrReplaceRenamer *replace_renamer)
 
 
 
+#ifdef HAVE_PCRE
+static TsrrRegex*
+tsrr_regex_new (const gchar  *pattern,
+                gboolean      case_sensitive,
+                const gchar **error_message,
+                gint         *error_offset)
+{
+  const gchar *study_error = NULL;
+  TsrrRegex   *regex;
+  pcre        *code;
+  gint         capture_count;
+  gint         options = 0;
+
+  code = pcre_compile (pattern, (case_sensitive ? 0 : PCRE_CASELESS) | PCRE_UTF8,
+                       error_message, error_offset, 0);
+  if (G_UNLIKELY (code == NULL))
+    return NULL;
+
+  /* determine the subpattern capture count */
+  if (pcre_fullinfo (code, NULL, PCRE_INFO_CAPTURECOUNT, &capture_count) != 0)
+    {
+      /* shouldn't happen, but just to be sure */
+      pcre_free (code);
+      return NULL;
+    }
+
+  regex = g_slice_new0 (TsrrRegex);
+  regex->ref_count = 1;
+  regex->pattern = g_strdup (pattern);
+  regex->case_sensitive = case_sensitive;
+  regex->code = code;
+  regex->capture_count = capture_count;
+
+  /* the pattern is matched against every name, so let PCRE
+   * optimize it, using the JIT compiler if available */
+#ifdef PCRE_STUDY_JIT_COMPILE
+  options |= PCRE_STUDY_JIT_COMPILE;
+#endif
+  regex->extra = pcre_study (code, options, &study_error);
+
+  return regex;
+}
+
+
+
+static TsrrRegex*
+tsrr_regex_ref (TsrrRegex *regex)
+{
+  g_atomic_int_inc (&regex->ref_count);
+  return regex;
+}
+
+
+
+static void
+tsrr_regex_unref (TsrrRegex *regex)
+{
+  if (!g_atomic_int_dec_and_test (&regex->ref_count))
+    return;
+
+  if (regex->extra != NULL)
+    {
+#ifdef PCRE_STUDY_JIT_COMPILE
+      pcre_free_study (regex->extra);
+#else
+      pcre_free (regex->extra);
+#endif
+    }
+
+  pcre_free (regex->code);
+  g_free (regex->pattern);
+  g_slice_free (TsrrRegex, regex);
+}
+#endif
+
+
+
 static void
 thunar_sbr_replace_renamer_finalize (GObject *object)
 {
   ThunarSbrReplaceRenamer *replace_renamer = THUNAR_SBR_REPLACE_RENAMER (object);
 
-  /* release the PCRE pattern (if any) */
+  /* release the PCRE patterns (if any) */
 #ifdef HAVE_PCRE
-  if (G_UNLIKELY (replace_renamer->pcre_pattern != NULL))
-    pcre_free (replace_renamer->pcre_pattern);
+  g_queue_foreach (&replace_renamer->regex_cache, (GFunc) tsrr_regex_unref, NULL);
+  g_queue_clear (&replace_renamer->regex_cache);
 #endif
 
+  g_hash_table_destroy (replace_renamer->results);
+
   /* release the strings */
   g_free (replace_renamer->replacement);
   g_free (replace_renamer->pattern);
@@ -411,43 +545,139 @@ tsrr_replace (const gchar *text,
 
 
 static gchar*
-thunar_sbr_replace_renamer_process (ThunarxRenamer  *renamer,
-                                    ThunarxFileInfo *file,
-                                    const gchar     *text,
-                                    guint            idx)
+tsrr_process (const TsrrSnapshot *settings,
+              const gchar        *text)
 {
-  ThunarSbrReplaceRenamer *replace_renamer = THUNAR_SBR_REPLACE_RENAMER (renamer);
-
   /* nothing to replace if we don't have a pattern */
-  if (G_UNLIKELY (replace_renamer->pattern == NULL || *replace_renamer->pattern == '\0'))
+  if (G_UNLIKELY (settings->pattern == NULL || *settings->pattern == '\0'))
     return g_strdup (text);
 
   /* check if we should use regular expression */
-  if (G_UNLIKELY (replace_renamer->regexp))
+  if (G_UNLIKELY (settings->regexp))
     {
 #ifdef HAVE_PCRE
       /* check if the pattern failed to compile */
-      if (G_UNLIKELY (replace_renamer->pcre_pattern == NULL))
+      if (G_UNLIKELY (settings->regex == NULL))
         return g_strdup (text);
 
       /* just execute the pattern */
-      return thunar_sbr_replace_renamer_pcre_exec (replace_renamer, text);
+      return thunar_sbr_replace_renamer_pcre_exec (settings->regex, settings->replacement, text);
 #endif
     }
 
   /* perform the replace operation */
-  return tsrr_replace (text, replace_renamer->pattern, replace_renamer->replacement, replace_renamer->case_sensitive);
+  return tsrr_replace (text, settings->pattern, settings->replacement, settings->case_sensitive);
+}
+
+
+
+static gchar*
+thunar_sbr_replace_renamer_process (ThunarxRenamer  *renamer,
+                                    ThunarxFileInfo *file,
+                                    const gchar     *text,
+                                    guint            idx)
+{
+  ThunarSbrReplaceRenamer *replace_renamer = THUNAR_SBR_REPLACE_RENAMER (renamer);
+  TsrrSnapshot             settings;
+  const gchar             *result;
+  gchar                   *name;
+
+  /* the result only depends on the text and the settings, so names
+   * that were already processed with these settings are skipped */
+  result = g_hash_table_lookup (replace_renamer->results, text);
+  if (result != NULL)
+    return g_strdup (result);
+
+  settings.pattern = replace_renamer->pattern;
+  settings.replacement = replace_renamer->replacement;
+  settings.case_sensitive = replace_renamer->case_sensitive;
+  settings.regexp = replace_renamer->regexp;
+#ifdef HAVE_PCRE
+  settings.regex = replace_renamer->regex;
+#endif
+
+  name = tsrr_process (&settings, text);
+
+  if (G_UNLIKELY (g_hash_table_size (replace_renamer->results) >= TSRR_RESULTS_MAX))
+    g_hash_table_remove_all (replace_renamer->results);
+  g_hash_table_insert (replace_renamer->results, g_strdup (text), g_strdup (name));
+
+  return name;
+}
+
+
+
+static gpointer
+thunar_sbr_replace_renamer_snapshot (ThunarxRenamer *renamer)
+{
+  ThunarSbrReplaceRenamer *replace_renamer = THUNAR_SBR_REPLACE_RENAMER (renamer);
+  TsrrSnapshot            *snapshot;
+
+  snapshot = g_slice_new0 (TsrrSnapshot);
+  snapshot->pattern = g_strdup (replace_renamer->pattern);
+  snapshot->replacement = g_strdup (replace_renamer->replacement);
+  snapshot->case_sensitive = replace_renamer->case_sensitive;
+  snapshot->regexp = replace_renamer->regexp;
+#ifdef HAVE_PCRE
+  /* compiled patterns are never modified, so the threads can share it */
+  if (replace_renamer->regex != NULL)
+    snapshot->regex = tsrr_regex_ref (replace_renamer->regex);
+#endif
+
+  return snapshot;
+}
+
+
+
+static gchar*
+thunar_sbr_replace_renamer_process_snapshot (gconstpointer    snapshot,
+                                             ThunarxFileInfo *file,
+                                             const gchar     *text,
+                                             guint            idx)
+{
+  return tsrr_process (snapshot, text);
+}
+
+
+
+static void
+thunar_sbr_replace_renamer_free_snapshot (gpointer data)
+{
+  TsrrSnapshot *snapshot = data;
+
+#ifdef HAVE_PCRE
+  if (snapshot->regex != NULL)
+    tsrr_regex_unref (snapshot->regex);
+#endif
+
+  g_free (snapshot->pattern);
+  g_free (snapshot->replacement);
+  g_slice_free (TsrrSnapshot, snapshot);
+}
+
+
+
+static void
+thunar_sbr_replace_renamer_changed (ThunarSbrReplaceRenamer *replace_renamer)
+{
+  /* the remembered results are outdated */
+  g_hash_table_remove_all (replace_renamer->results);
+
+  /* update the renamer */
+  thunarx_renamer_changed (THUNARX_RENAMER (replace_renamer));
 }
 
 
 
 #ifdef HAVE_PCRE
 static gchar*
-thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
-                                      const gchar             *subject)
+thunar_sbr_replace_renamer_pcre_exec (TsrrRegex   *regex,
+                                      const gchar *replacement,
+                                      const gchar *subject)
 {
   const gchar *r;
   GString     *result;
+  gint         ovec_stack[TSRR_OVEC_STACK_SIZE];
   gint         second;
   gint         first;
   gint         idx;
@@ -455,27 +685,26 @@ thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
   gint         olen;
   gint         rc;
 
-  /* guess an initial ovec size */
-  olen = (replace_renamer->pcre_capture_count + 10) * 3;
-  ovec = g_new0 (gint, olen);
+  /* the match offsets of all subpatterns fit into the ovec, so
+   * names are usually matched without allocating anything */
+  olen = (regex->capture_count + 1) * 3;
+  if (G_LIKELY (olen <= TSRR_OVEC_STACK_SIZE))
+    {
+      olen = TSRR_OVEC_STACK_SIZE;
+      ovec = ovec_stack;
+    }
+  else
+    {
+      ovec = g_new0 (gint, olen);
+    }
 
-  /* try to match the subject (increasing ovec on-demand) */
-  for (rc = 0; rc <= 0; )
+  rc = pcre_exec (regex->code, regex->extra, subject, strlen (subject), 0, PCRE_NOTEMPTY, ovec, olen);
+  if (G_UNLIKELY (rc <= 0))
     {
-      /* try to exec, will return 0 if the ovec is too small */
-      rc = pcre_exec (replace_renamer->pcre_pattern, NULL, subject, strlen (subject), 0, PCRE_NOTEMPTY, ovec, olen);
-      if (G_UNLIKELY (rc < 0))
-        {
-          /* no match or error */
-          g_free (ovec);
-          return g_strdup (subject);
-        }
-      else if (rc == 0)
-        {
-          /* ovec too small, try to increase */
-          olen += 18;
-          ovec = g_realloc (ovec, olen * sizeof (gint));
-        }
+      /* no match or error */
+      if (ovec != ovec_stack)
+        g_free (ovec);
+      return g_strdup (subject);
     }
 
   /* allocate a string for the result */
@@ -485,7 +714,7 @@ thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
   g_string_append_len (result, subject, ovec[0]);
 
   /* apply the replacement */
-  for (r = replace_renamer->replacement; *r != '\0'; r = g_utf8_next_char (r))
+  for (r = replacement; *r != '\0'; r = g_utf8_next_char (r))
     {
       if (G_UNLIKELY ((r[0] == '\\' || r[0] == '$') && r[1] != '\0'))
         {
@@ -557,7 +786,8 @@ thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
   g_string_append (result, subject + ovec[1]);
 
   /* release the output vector */
-  g_free (ovec);
+  if (ovec != ovec_stack)
+    g_free (ovec);
 
   /* return the new name */
   return g_string_free (result, FALSE);
@@ -565,6 +795,43 @@ thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
 
 
 
+static TsrrRegex*
+thunar_sbr_replace_renamer_pcre_lookup (ThunarSbrReplaceRenamer *replace_renamer,
+                                        const gchar             *pattern,
+                                        const gchar            **error_message,
+                                        gint                    *error_offset)
+{
+  TsrrRegex *regex;
+  GList     *lp;
+
+  /* editing the pattern often returns to a previous one */
+  for (lp = replace_renamer->regex_cache.head; lp != NULL; lp = lp->next)
+    {
+      regex = lp->data;
+      if (regex->case_sensitive == replace_renamer->case_sensitive
+          && strcmp (regex->pattern, pattern) == 0)
+        {
+          /* move it to the front */
+          g_queue_unlink (&replace_renamer->regex_cache, lp);
+          g_queue_push_head_link (&replace_renamer->regex_cache, lp);
+          return regex;
+        }
+    }
+
+  /* try to compile the new pattern */
+  regex = tsrr_regex_new (pattern, replace_renamer->case_sensitive, error_message, error_offset);
+  if (G_UNLIKELY (regex == NULL))
+    return NULL;
+
+  g_queue_push_head (&replace_renamer->regex_cache, regex);
+  if (g_queue_get_length (&replace_renamer->regex_cache) > TSRR_REGEX_CACHE_SIZE)
+    tsrr_regex_unref (g_queue_pop_tail (&replace_renamer->regex_cache));
+
+  return regex;
+}
+
+
+
 static void
 thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer)
 {
@@ -574,26 +841,14 @@ thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer
   glong        offset;
   gint         error_offset = -1;
 
-  /* pre-compile the pattern if regexp is enabled */
+  /* pre-compile the pattern if regexp is enabled, the
+   * cache holds a reference on the current pattern */
+  replace_renamer->regex = NULL;
   if (G_UNLIKELY (replace_renamer->regexp))
     {
-      /* release the previous pattern (if any) */
-      if (G_LIKELY (replace_renamer->pcre_pattern != NULL))
-        pcre_free (replace_renamer->pcre_pattern);
-
-      /* try to compile the new pattern */
-      replace_renamer->pcre_pattern = pcre_compile (replace_renamer->pattern, (replace_renamer->case_sensitive ? 0 : PCRE_CASELESS) | PCRE_UTF8,
-                                                    &error_message, &error_offset, 0);
-      if (G_LIKELY (replace_renamer->pcre_pattern != NULL))
-        {
-          /* determine the subpattern capture count */
-          if (pcre_fullinfo (replace_renamer->pcre_pattern, NULL, PCRE_INFO_CAPTURECOUNT, &replace_renamer->pcre_capture_count) != 0)
-            {
-              /* shouldn't happen, but just to be sure */
-              pcre_free (replace_renamer->pcre_pattern);
-              replace_renamer->pcre_pattern = NULL;
-            }
-        }
+      replace_renamer->regex = thunar_sbr_replace_renamer_pcre_lookup (replace_renamer,
+                                                                       replace_renamer->pattern != NULL ? replace_renamer->pattern : "",
+                                                                       &error_message, &error_offset);
     }
 
   /* check if there was an error compiling the pattern */
@@ -701,7 +956,7 @@ thunar_sbr_replace_renamer_set_case_sensitive (ThunarSbrReplaceRenamer *replace_
 #endif
 
       /* update the renamer */
-      thunarx_renamer_changed (THUNARX_RENAMER (replace_renamer));
+      thunar_sbr_replace_renamer_changed (replace_renamer);
 
       /* notify listeners */
       g_object_notify (G_OBJECT (replace_renamer), "case-sensitive");
@@ -754,7 +1009,7 @@ thunar_sbr_replace_renamer_set_pattern (ThunarSbrReplaceRenamer *replace_renamer
 #endif
 
       /* update the renamer */
-      thunarx_renamer_changed (THUNARX_RENAMER (replace_renamer));
+      thunar_sbr_replace_renamer_changed (replace_renamer);
 
       /* notify listeners */
       g_object_notify (G_OBJECT (replace_renamer), "pattern");
@@ -810,7 +1065,7 @@ thunar_sbr_replace_renamer_set_regexp (ThunarSbrReplaceRenamer *replace_renamer,
 #endif
 
       /* update the renamer */
-      thunarx_renamer_changed (THUNARX_RENAMER (replace_renamer));
+      thunar_sbr_replace_renamer_changed (replace_renamer);
 
       /* notify listeners */
       g_object_notify (G_OBJECT (replace_renamer), "regexp");
@@ -858,7 +1113,7 @@ thunar_sbr_replace_renamer_set_replacement (ThunarSbrReplaceRenamer *replace_ren
       replace_renamer->replacement = g_strdup (replacement);
 
       /* update the renamer */
-      thunarx_renamer_changed (THUNARX_RENAMER (replace_renamer));
+      thunar_sbr_replace_renamer_changed (replace_renamer);
 
       /* notify listeners */
       g_object_notify (G_OBJECT (replace_renamer), "replacement");
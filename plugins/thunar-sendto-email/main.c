@@ -64,7 +64,14 @@
 
 
 
-typedef struct _TseData TseData;
+/* the uncompressed size above which the user is asked before compressing,
+ * many mail servers reject attachments larger than this */
+#define TSE_SIZE_LIMIT (25 * 1024 * 1024)
+
+
+
+typedef struct _TseData     TseData;
+typedef struct _TseProgress TseProgress;
 
 struct _TseData
 {
@@ -72,6 +79,17 @@ struct _TseData
   GFile     *file;
 };
 
+struct _TseProgress
+{
+  GtkWidget    *dialog;
+  const gchar  *working_directory;
+  gchar       **argv;
+  GError       *error;
+  GPid          pid;
+  guint         watch_id;
+  gint          status;
+};
+
 
 
 /* well known archive types */
@@ -119,6 +137,7 @@ enum
 {
   TSE_RESPONSE_COMPRESS,
   TSE_RESPONSE_PLAIN,
+  TSE_RESPONSE_TOO_LARGE,
 };
 
 
@@ -259,8 +278,12 @@ tse_child_watch (GPid     pid,
                  gint     status,
                  gpointer user_data)
 {
-  g_object_set_data (G_OBJECT (user_data), I_("tse-child-status"), GINT_TO_POINTER (status));
-  gtk_dialog_response (GTK_DIALOG (user_data), GTK_RESPONSE_YES);
+  TseProgress *progress = user_data;
+
+  /* the child watch source is destroyed by glib afterwards */
+  progress->status = status;
+  progress->watch_id = 0;
+  gtk_dialog_response (GTK_DIALOG (progress->dialog), GTK_RESPONSE_YES);
 }
 
 
@@ -274,40 +297,194 @@ tse_progress_cb(gpointer user_data)
   return TRUE;
 }
 
+
+
+static gboolean
+tse_progress_spawn (TseProgress *progress)
+{
+  /* try to run the command */
+  if (!g_spawn_async (progress->working_directory, progress->argv, NULL,
+                      G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_SEARCH_PATH,
+                      NULL, NULL, &progress->pid, &progress->error))
+    return FALSE;
+
+  /* start the child watch */
+  progress->watch_id = g_child_watch_add (progress->pid, tse_child_watch, progress);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+tse_count_size (GFile        *file,
+                guint64      *size,
+                GCancellable *cancellable)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *info;
+  GFile           *child;
+  gboolean         within_limit = TRUE;
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+  if (G_UNLIKELY (info == NULL))
+    return !g_cancellable_is_cancelled (cancellable);
+
+  *size += g_file_info_get_size (info);
+
+  /* symlinks inside folders are not followed, so there are no loops */
+  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+    {
+      enumerator = g_file_enumerate_children (file, G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
+      if (G_LIKELY (enumerator != NULL))
+        {
+          while (within_limit)
+            {
+              g_object_unref (info);
+              info = g_file_enumerator_next_file (enumerator, cancellable, NULL);
+              if (info == NULL)
+                break;
+
+              if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+                {
+                  child = g_file_enumerator_get_child (enumerator, info);
+                  within_limit = tse_count_size (child, size, cancellable);
+                  g_object_unref (child);
+                }
+              else
+                {
+                  *size += g_file_info_get_size (info);
+                }
+
+              /* stop as soon as the limit is exceeded */
+              within_limit = within_limit && *size <= TSE_SIZE_LIMIT;
+            }
+
+          g_object_unref (enumerator);
+        }
+    }
+
+  if (info != NULL)
+    g_object_unref (info);
+
+  return within_limit && *size <= TSE_SIZE_LIMIT && !g_cancellable_is_cancelled (cancellable);
+}
+
+
+
+static void
+tse_file_list_free (gpointer data)
+{
+  g_list_free_full (data, g_object_unref);
+}
+
+
+
+static void
+tse_size_thread (GTask        *task,
+                 gpointer      source_object,
+                 gpointer      task_data,
+                 GCancellable *cancellable)
+{
+  gboolean  within_limit = TRUE;
+  guint64   size = 0;
+  GList    *lp;
+
+  for (lp = task_data; lp != NULL && within_limit; lp = lp->next)
+    within_limit = tse_count_size (lp->data, &size, cancellable);
+
+  if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, within_limit);
+}
+
+
+
+static void
+tse_size_ready (GObject      *object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  TseProgress *progress = user_data;
+  gboolean     within_limit;
+  GError      *error = NULL;
+
+  /* if the count was cancelled, the progress is gone already */
+  within_limit = g_task_propagate_boolean (G_TASK (result), &error);
+  if (G_UNLIKELY (error != NULL))
+    {
+      g_error_free (error);
+      return;
+    }
+
+  if (!within_limit)
+    gtk_dialog_response (GTK_DIALOG (progress->dialog), TSE_RESPONSE_TOO_LARGE);
+  else if (!tse_progress_spawn (progress))
+    gtk_dialog_response (GTK_DIALOG (progress->dialog), GTK_RESPONSE_REJECT);
+}
+
+
+
+static gboolean
+tse_ask_too_large (GtkWidget *parent)
+{
+  GtkWidget *message;
+  gchar     *limit;
+  gint       response;
+
+  limit = g_format_size (TSE_SIZE_LIMIT);
+  message = gtk_message_dialog_new (GTK_WINDOW (parent), GTK_DIALOG_MODAL, GTK_MESSAGE_QUESTION, GTK_BUTTONS_NONE,
+                                    _("The files are larger than %s"), limit);
+  gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
+  gtk_dialog_add_button (GTK_DIALOG (message), _("Compress _anyway"), TSE_RESPONSE_COMPRESS);
+  gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_CANCEL);
+  gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message), _("Many mail servers reject attachments larger than %s, "
+                                                                            "the archive may still be too large after compressing."), limit);
+  response = gtk_dialog_run (GTK_DIALOG (message));
+  gtk_widget_destroy (message);
+  g_free (limit);
+
+  return (response == TSE_RESPONSE_COMPRESS);
+}
+
+
+
 static gboolean
 tse_progress (const gchar *working_directory,
               gchar      **argv,
+              GList       *infos,
               GError     **error)
 {
-  GtkWidget *progress;
-  GtkWidget *dialog;
-  GtkWidget *image;
-  GtkWidget *label;
-  GtkWidget *hbox;
-  GtkWidget *vbox;
-  gboolean   succeed = FALSE;
-  GPid       pid;
-  guint      pulse_timer_id;
-  gint       watch_id;
-  gint       response;
-  gint       status;
-
-  /* try to run the command */
-  if (!g_spawn_async (working_directory, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_SEARCH_PATH, NULL, NULL, &pid, error))
-    return FALSE;
+  TseProgress   progress = { NULL, };
+  GCancellable *cancellable;
+  GtkWidget    *bar;
+  GtkWidget    *image;
+  GtkWidget    *label;
+  GtkWidget    *hbox;
+  GtkWidget    *vbox;
+  gboolean      succeed = FALSE;
+  GList        *files = NULL;
+  GList        *lp;
+  GTask        *task;
+  guint         pulse_timer_id;
+  gint          response;
+
+  progress.working_directory = working_directory;
+  progress.argv = argv;
 
   /* allocate the progress dialog */
-  dialog = gtk_dialog_new_with_buttons (_("Compressing files..."),
-                                        NULL, 0,
-                                        _("_Cancel"), GTK_RESPONSE_CANCEL,
-                                        NULL);
-  gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_CANCEL);
-  gtk_window_set_default_size (GTK_WINDOW (dialog), 300, -1);
+  progress.dialog = gtk_dialog_new_with_buttons (_("Compressing files..."),
+                                                 NULL, 0,
+                                                 _("_Cancel"), GTK_RESPONSE_CANCEL,
+                                                 NULL);
+  gtk_dialog_set_default_response (GTK_DIALOG (progress.dialog), GTK_RESPONSE_CANCEL);
+  gtk_window_set_default_size (GTK_WINDOW (progress.dialog), 300, -1);
 
   /* setup the hbox */
   hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
   gtk_container_set_border_width (GTK_CONTAINER (hbox), 8);
-  gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (dialog))), hbox, TRUE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (progress.dialog))), hbox, TRUE, TRUE, 0);
   gtk_widget_show (hbox);
 
   /* setup the image */
@@ -329,26 +506,47 @@ tse_progress (const gchar *working_directory,
   gtk_widget_show (label);
 
   /* setup the progress bar */
-  progress = gtk_progress_bar_new ();
-  gtk_box_pack_start (GTK_BOX (vbox), progress, FALSE, FALSE, 0);
-  gtk_widget_show (progress);
+  bar = gtk_progress_bar_new ();
+  gtk_box_pack_start (GTK_BOX (vbox), bar, FALSE, FALSE, 0);
+  gtk_widget_show (bar);
 
-  /* start the child watch */
-  watch_id = g_child_watch_add (pid, tse_child_watch, dialog);
+  /* determine the size in a thread before anything is written, the
+   * ZIP command is started once the files are known to be small enough */
+  for (lp = infos; lp != NULL; lp = lp->next)
+    files = g_list_prepend (files, g_object_ref (((TseData *) lp->data)->file));
+  cancellable = g_cancellable_new ();
+  task = g_task_new (NULL, cancellable, tse_size_ready, &progress);
+  g_task_set_task_data (task, files, tse_file_list_free);
+  g_task_run_in_thread (task, tse_size_thread);
+  g_object_unref (task);
 
   /* start the pulse timer */
-  pulse_timer_id = g_timeout_add (125, tse_progress_cb, progress);
+  pulse_timer_id = g_timeout_add (125, tse_progress_cb, bar);
+
+  /* run the dialog, ask the user if the files are too large */
+  for (;;)
+    {
+      response = gtk_dialog_run (GTK_DIALOG (progress.dialog));
+      if (response != TSE_RESPONSE_TOO_LARGE)
+        break;
+
+      if (!tse_ask_too_large (progress.dialog))
+        response = GTK_RESPONSE_CANCEL;
+      else if (!tse_progress_spawn (&progress))
+        response = GTK_RESPONSE_REJECT;
+      else
+        continue;
+
+      break;
+    }
 
-  /* run the dialog */
-  response = gtk_dialog_run (GTK_DIALOG (dialog));
   if (response == GTK_RESPONSE_YES)
     {
       /* check if the command failed */
-      status = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (dialog), I_("tse-child-status")));
-      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+      if (!WIFEXITED (progress.status) || WEXITSTATUS (progress.status) != 0)
         {
           /* tell the user that the command failed */
-          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, _("ZIP command terminated with error %d"), status);
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, _("ZIP command terminated with error %d"), progress.status);
         }
       else
         {
@@ -356,61 +554,31 @@ tse_progress (const gchar *working_directory,
           succeed = TRUE;
         }
     }
+  else if (response == GTK_RESPONSE_REJECT)
+    {
+      /* failed to run the ZIP command */
+      g_propagate_error (error, progress.error);
+    }
   else
     {
-      /* terminate the ZIP command */
-      kill (pid, SIGQUIT);
+      /* stop counting, or terminate the ZIP command */
+      g_cancellable_cancel (cancellable);
+      if (progress.watch_id != 0)
+        kill (progress.pid, SIGQUIT);
     }
 
   /* cleanup */
   g_source_remove (pulse_timer_id);
-  gtk_widget_destroy (dialog);
-  g_source_remove (watch_id);
+  if (progress.watch_id != 0)
+    g_source_remove (progress.watch_id);
+  gtk_widget_destroy (progress.dialog);
+  g_object_unref (cancellable);
 
   return succeed;
 }
 
 
 
-#ifndef HAVE_MKDTEMP
-static gchar*
-mkdtemp (gchar *tmpl)
-{
-  static const gchar LETTERS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-  static guint64     value;
-  guint64            v;
-  gint               len;
-  gint               i, j;
-
-  len = strlen (tmpl);
-  if (len < 6 || strcmp (&tmpl[len - 6], "XXXXXX") != 0)
-    {
-      errno = EINVAL;
-      return NULL;
-    }
-
-  value += ((guint64) time (NULL)) ^ getpid ();
-
-  for (i = 0; i < TMP_MAX; ++i, value += 7777)
-    {
-      /* fill in the random bits */
-      for (j = 0, v = value; j < 6; ++j)
-        tmpl[(len - 6) + j] = LETTERS[v % 62]; v /= 62;
-
-      /* try to create the directory */
-      if (g_mkdir (tmpl, 0700) == 0)
-        return tmpl;
-      else if (errno != EEXIST)
-        return NULL;
-    }
-
-  errno = EEXIST;
-  return NULL;
-}
-#endif
-
-
-
 static gboolean
 tse_compress (GList  *infos,
               gchar **zipfile_return)
@@ -431,11 +599,10 @@ tse_compress (GList  *infos,
   gint           n;
 
   /* create a temporary directory */
-  tmpdir = g_strdup ("/tmp/thunar-sendto-email.XXXXXX");
-  if (G_UNLIKELY (mkdtemp (tmpdir) == NULL))
+  tmpdir = g_dir_make_tmp ("thunar-sendto-email.XXXXXX", &error);
+  if (G_UNLIKELY (tmpdir == NULL))
     {
       /* tell the user that we failed to create a temporary directory */
-      error = g_error_new_literal (G_FILE_ERROR, g_file_error_from_errno (errno), g_strerror (errno));
       tse_error (error, _("Failed to create temporary directory"));
       g_error_free (error);
       return FALSE;
@@ -526,7 +693,7 @@ tse_compress (GList  *infos,
   if (G_LIKELY (succeed))
     {
       /* try to run the ZIP command */
-      succeed = tse_progress (tmpdir, argv, &error);
+      succeed = tse_progress (tmpdir, argv, infos, &error);
       if (G_UNLIKELY (!succeed))
         {
           /* check if we failed or the user cancelled */
@@ -540,13 +707,22 @@ tse_compress (GList  *infos,
               g_error_free (error);
             }
 
-          /* delete the temporary directory */
+          /* delete the temporary directory in the background, a
+           * terminated ZIP command may have left a partial archive */
           dot = g_strdup_printf ("rm -rf '%s'", tmpdir);
-          g_spawn_command_line_sync (dot, NULL, NULL, NULL, NULL);
+          g_spawn_command_line_async (dot, NULL);
           g_free (dot);
         }
       else
         {
+          /* the symlinks are not needed for the mail anymore */
+          for (n = 4; argv[n] != NULL; ++n)
+            {
+              tmppath = g_build_filename (tmpdir, argv[n], NULL);
+              g_unlink (tmppath);
+              g_free (tmppath);
+            }
+
           /* return the path to the compressed file */
           *zipfile_return = zipfile;
           zipfile = NULL;
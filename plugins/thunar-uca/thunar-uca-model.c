@@ -35,6 +35,9 @@
 #ifdef HAVE_PATHS_H
 #include <paths.h>
 #endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
@@ -62,9 +65,22 @@
 #define _PATH_BSHELL "/bin/sh"
 #endif
 
+/* The cache of a uca.xml is a header, the locale the names were chosen
+ * for and a record per action, followed by the nul-terminated strings
+ * of the action. Every block is aligned to 8 bytes.
+ */
+#define CACHE_MAGIC    "UCACACH2"
+#define CACHE_ALIGN(n) (((n) + 7) & ~((gsize) 7))
+#define CACHE_N_FIELDS (7)
+
+/* the command line is passed to the shell as a single argument, and
+ * Linux limits every argument to 32 pages, whatever ARG_MAX says */
+#define BATCH_MAX_ARG_LEN (32 * 4096)
+
 
 
-typedef struct _ThunarUcaModelItem ThunarUcaModelItem;
+typedef struct _ThunarUcaModelItem  ThunarUcaModelItem;
+typedef struct _ThunarUcaModelIndex ThunarUcaModelIndex;
 
 
 
@@ -79,6 +95,7 @@ typedef enum
   PARSER_UNIQUE_ID,
   PARSER_COMMAND,
   PARSER_STARTUP_NOTIFY,
+  PARSER_BATCH,
   PARSER_PATTERNS,
   PARSER_DESCRIPTION,
   PARSER_DIRECTORIES,
@@ -94,6 +111,7 @@ typedef enum
 
 static void               thunar_uca_model_tree_model_init  (GtkTreeModelIface    *iface);
 static void               thunar_uca_model_finalize         (GObject              *object);
+static void               thunar_uca_model_invalidate       (ThunarUcaModel       *uca_model);
 static GtkTreeModelFlags  thunar_uca_model_get_flags        (GtkTreeModel         *tree_model);
 static gint               thunar_uca_model_get_n_columns    (GtkTreeModel         *tree_model);
 static GType              thunar_uca_model_get_column_type  (GtkTreeModel         *tree_model,
@@ -126,6 +144,14 @@ static gboolean           thunar_uca_model_iter_parent      (GtkTreeModel
 static gboolean           thunar_uca_model_load_from_file   (ThunarUcaModel       *uca_model,
                                                              const gchar          *filename,
                                                              GError              **error);
+static gboolean           thunar_uca_model_load_from_cache  (ThunarUcaModel       *uca_model,
+                                                             const gchar          *filename,
+                                                             const GStatBuf       *statb,
+                                                             const gchar          *locale);
+static void               thunar_uca_model_save_cache       (ThunarUcaModel       *uca_model,
+                                                             const gchar          *filename,
+                                                             const GStatBuf       *statb,
+                                                             const gchar          *locale);
 static void               thunar_uca_model_item_reset       (ThunarUcaModelItem   *item);
 static void               thunar_uca_model_item_free        (gpointer              data);
 static void               start_element_handler             (GMarkupParseContext  *context,
@@ -155,8 +181,11 @@ struct _ThunarUcaModel
 {
   GObject __parent__;
 
-  GList          *items;
-  gint            stamp;
+  GList               *items;
+  gint                 stamp;
+
+  /* lazily built index for thunar_uca_model_match() */
+  ThunarUcaModelIndex *index;
 };
 
 struct _ThunarUcaModelItem
@@ -172,10 +201,56 @@ struct _ThunarUcaModelItem
   gchar        **patterns;
   ThunarUcaTypes types;
 
+  /* split large selections into several invocations, see
+   * thunar_uca_model_split_files() */
+  guint          batch_size;
+  guint          batch_parallel;
+
   /* derived attributes */
   guint          multiple_selection : 1;
 };
 
+/* The match index knows for every literal suffix of the "*<suffix>"
+ * patterns (e.g. "*.jpg") the items using it, so these patterns are
+ * looked up by the suffixes of a file name, instead of matched one by
+ * one. The remaining patterns are compiled once.
+ */
+typedef struct
+{
+  ThunarUcaModelItem *item;
+  GPatternSpec      **specs;
+  gboolean            matches_all;
+} ThunarUcaIndexEntry;
+
+struct _ThunarUcaModelIndex
+{
+  ThunarUcaIndexEntry *entries;
+  guint                n_entries;
+  GHashTable          *suffixes;
+  gsize                max_suffix_len;
+};
+
+typedef struct
+{
+  gchar   magic[8];
+  guint64 mtime;
+  guint64 size;
+  guint32 n_items;
+  guint32 locale_len;
+}
+CacheHeader;
+
+typedef struct
+{
+  guint32 types;
+  guint32 startup_notify;
+  guint32 lengths[CACHE_N_FIELDS];
+  guint32 batch_size;
+  guint32 batch_parallel;
+  guint32 reserved;
+}
+CacheRecord;
+
 typedef XFCE_GENERIC_STACK(ParserState) ParserStack;
 
 typedef struct
@@ -193,6 +268,8 @@ typedef struct
   GString        *patterns;
   GString        *description;
   gboolean        startup_notify;
+  guint           batch_size;
+  guint           batch_parallel;
   gboolean        description_use;
   guint           description_match;
   gboolean        unique_id_generated;
@@ -283,6 +360,7 @@ thunar_uca_model_finalize (GObject *object)
   ThunarUcaModel *uca_model = THUNAR_UCA_MODEL (object);
 
   /* release all items */
+  thunar_uca_model_invalidate (uca_model);
   g_list_free_full (uca_model->items, thunar_uca_model_item_free);
 
   (*G_OBJECT_CLASS (thunar_uca_model_parent_class)->finalize) (object);
@@ -556,6 +634,203 @@ thunar_uca_model_iter_parent (GtkTreeModel *tree_model,
 
 
 
+static gchar*
+thunar_uca_model_get_cache_path (const gchar *filename)
+{
+  gchar *checksum;
+  gchar *basename;
+  gchar *path;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, filename, -1);
+  basename = g_strconcat ("uca-", checksum, ".cache", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "Thunar", basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  return path;
+}
+
+
+
+static gboolean
+thunar_uca_model_load_from_cache (ThunarUcaModel *uca_model,
+                                  const gchar    *filename,
+                                  const GStatBuf *statb,
+                                  const gchar    *locale)
+{
+  CacheHeader   header;
+  CacheRecord   record;
+  GMappedFile  *mapped;
+  GtkTreeIter   iter;
+  const gchar  *data;
+  const gchar  *fields[CACHE_N_FIELDS];
+  gboolean      succeed = FALSE;
+  gsize         length;
+  gsize         offset;
+  gsize         end;
+  gchar        *path;
+  guint         n, m;
+
+  path = thunar_uca_model_get_cache_path (filename);
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+  if (G_UNLIKELY (mapped == NULL))
+    return FALSE;
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+
+  /* check if the cache belongs to this version of the file */
+  if (length < sizeof (CacheHeader))
+    goto out;
+  memcpy (&header, data, sizeof (CacheHeader));
+  if (memcmp (header.magic, CACHE_MAGIC, sizeof (header.magic)) != 0
+      || header.mtime != (guint64) statb->st_mtime
+      || header.size != (guint64) statb->st_size
+      || header.locale_len != strlen (locale)
+      || sizeof (CacheHeader) + header.locale_len >= length
+      || memcmp (data + sizeof (CacheHeader), locale, header.locale_len) != 0)
+    goto out;
+
+  /* verify all records before adding anything to the model */
+  offset = CACHE_ALIGN (sizeof (CacheHeader) + header.locale_len + 1);
+  for (n = 0, end = offset; n < header.n_items; ++n)
+    {
+      if (end + sizeof (CacheRecord) > length)
+        goto out;
+
+      memcpy (&record, data + end, sizeof (CacheRecord));
+      end += sizeof (CacheRecord);
+
+      for (m = 0; m < CACHE_N_FIELDS; ++m)
+        {
+          if (record.lengths[m] >= length - end || data[end + record.lengths[m]] != '\0')
+            goto out;
+          end += record.lengths[m] + 1;
+        }
+
+      end = CACHE_ALIGN (end);
+    }
+
+  for (n = 0; n < header.n_items; ++n)
+    {
+      memcpy (&record, data + offset, sizeof (CacheRecord));
+      offset += sizeof (CacheRecord);
+
+      for (m = 0; m < CACHE_N_FIELDS; ++m)
+        {
+          fields[m] = data + offset;
+          offset += record.lengths[m] + 1;
+        }
+      offset = CACHE_ALIGN (offset);
+
+      thunar_uca_model_append (uca_model, &iter);
+      thunar_uca_model_update (uca_model, &iter,
+                               fields[0], fields[1], fields[2], fields[3],
+                               fields[4], fields[5], record.startup_notify,
+                               fields[6], record.types, 0, 0);
+      thunar_uca_model_set_batch (uca_model, &iter, record.batch_size, record.batch_parallel);
+    }
+
+  succeed = TRUE;
+
+out:
+  g_mapped_file_unref (mapped);
+
+  return succeed;
+}
+
+
+
+static void
+thunar_uca_model_cache_pad (GByteArray *array)
+{
+  static const guint8 zeros[8] = { 0, };
+
+  g_byte_array_append (array, zeros, CACHE_ALIGN (array->len) - array->len);
+}
+
+
+
+static void
+thunar_uca_model_save_cache (ThunarUcaModel *uca_model,
+                             const gchar    *filename,
+                             const GStatBuf *statb,
+                             const gchar    *locale)
+{
+  ThunarUcaModelItem *item;
+  CacheHeader         header;
+  CacheRecord         record;
+  const gchar        *fields[CACHE_N_FIELDS];
+  GByteArray         *array;
+  GError             *error = NULL;
+  gchar              *patterns;
+  gchar              *path;
+  gchar              *dirname;
+  GList              *lp;
+  guint               m;
+
+  memset (&header, 0, sizeof (CacheHeader));
+  memcpy (header.magic, CACHE_MAGIC, sizeof (header.magic));
+  header.mtime = statb->st_mtime;
+  header.size = statb->st_size;
+  header.n_items = g_list_length (uca_model->items);
+  header.locale_len = strlen (locale);
+
+  array = g_byte_array_new ();
+  g_byte_array_append (array, (const guint8 *) &header, sizeof (CacheHeader));
+  g_byte_array_append (array, (const guint8 *) locale, header.locale_len + 1);
+  thunar_uca_model_cache_pad (array);
+
+  for (lp = uca_model->items; lp != NULL; lp = lp->next)
+    {
+      item = lp->data;
+      patterns = g_strjoinv (";", item->patterns);
+
+      fields[0] = item->name;
+      fields[1] = item->submenu;
+      fields[2] = item->unique_id;
+      fields[3] = item->description;
+      fields[4] = item->icon_name;
+      fields[5] = item->command;
+      fields[6] = patterns;
+
+      memset (&record, 0, sizeof (CacheRecord));
+      record.types = item->types;
+      record.startup_notify = item->startup_notify;
+      record.batch_size = item->batch_size;
+      record.batch_parallel = item->batch_parallel;
+      for (m = 0; m < CACHE_N_FIELDS; ++m)
+        {
+          if (fields[m] == NULL)
+            fields[m] = "";
+          record.lengths[m] = strlen (fields[m]);
+        }
+
+      g_byte_array_append (array, (const guint8 *) &record, sizeof (CacheRecord));
+      for (m = 0; m < CACHE_N_FIELDS; ++m)
+        g_byte_array_append (array, (const guint8 *) fields[m], record.lengths[m] + 1);
+      thunar_uca_model_cache_pad (array);
+
+      g_free (patterns);
+    }
+
+  path = thunar_uca_model_get_cache_path (filename);
+  dirname = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dirname, 0700) != 0
+      || !g_file_set_contents (path, (const gchar *) array->data, array->len, &error))
+    {
+      g_debug ("Failed to write cache for `%s': %s", filename, (error != NULL) ? error->message : g_strerror (errno));
+      g_clear_error (&error);
+    }
+
+  g_byte_array_free (array, TRUE);
+  g_free (dirname);
+  g_free (path);
+}
+
+
+
 static gboolean
 thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
                                  const gchar    *filename,
@@ -563,22 +838,39 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
 {
   GMarkupParseContext *context;
   gboolean             succeed;
+  gboolean             has_statb;
+  GStatBuf             statb;
   Parser               parser;
   gchar               *content;
+  gchar               *locale;
   gsize                content_len;
 
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
   g_return_val_if_fail (g_path_is_absolute (filename), FALSE);
 
+  /* the names depend on the locale, so the cache does too */
+  locale = g_strdup (setlocale (LC_MESSAGES, NULL));
+
+  /* try the cache of this version of the file first */
+  has_statb = (g_stat (filename, &statb) == 0);
+  if (has_statb && thunar_uca_model_load_from_cache (uca_model, filename, &statb, (locale != NULL) ? locale : ""))
+    {
+      g_free (locale);
+      return TRUE;
+    }
+
   /* read the file info memory */
   if (!g_file_get_contents (filename, &content, &content_len, error))
-    return FALSE;
+    {
+      g_free (locale);
+      return FALSE;
+    }
 
   /* initialize the parser */
   parser.stack = xfce_stack_new (ParserStack);
   parser.model = uca_model;
-  parser.locale = g_strdup (setlocale (LC_MESSAGES, NULL));
+  parser.locale = locale;
   parser.name = g_string_new (NULL);
   parser.submenu = g_string_new (NULL);
   parser.unique_id = g_string_new (NULL);
@@ -604,7 +896,6 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
   g_string_free (parser.unique_id, TRUE);
   g_string_free (parser.submenu, TRUE);
   g_string_free (parser.name, TRUE);
-  g_free (parser.locale);
   xfce_stack_free (parser.stack);
   g_free (content);
 
@@ -612,6 +903,10 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
   if (succeed
       && parser.unique_id_generated)
     succeed = thunar_uca_model_save (uca_model, error);
+  else if (succeed && has_statb)
+    thunar_uca_model_save_cache (uca_model, filename, &statb, (locale != NULL) ? locale : "");
+
+  g_free (locale);
 
   return succeed;
 }
@@ -676,6 +971,8 @@ start_element_handler (GMarkupParseContext *context,
           parser->description_match = XFCE_LOCALE_NO_MATCH;
           parser->types = 0;
           parser->startup_notify = FALSE;
+          parser->batch_size = 0;
+          parser->batch_parallel = 0;
           g_string_truncate (parser->icon_name, 0);
           g_string_truncate (parser->name, 0);
           g_string_truncate (parser->submenu, 0);
@@ -778,6 +1075,20 @@ start_element_handler (GMarkupParseContext *context,
           parser->startup_notify = TRUE;
           xfce_stack_push (parser->stack, PARSER_STARTUP_NOTIFY);
         }
+      else if (strcmp (element_name, "batch") == 0)
+        {
+          /* without a size the selection is only split to fit on the command line */
+          parser->batch_size = THUNAR_UCA_BATCH_AUTO;
+          parser->batch_parallel = 1;
+          for (n = 0; attribute_names[n] != NULL; ++n)
+            {
+              if (strcmp (attribute_names[n], "size") == 0)
+                parser->batch_size = CLAMP (strtoul (attribute_values[n], NULL, 10), 1, THUNAR_UCA_BATCH_AUTO);
+              else if (strcmp (attribute_names[n], "parallel") == 0)
+                parser->batch_parallel = CLAMP (strtoul (attribute_values[n], NULL, 10), 1, 64);
+            }
+          xfce_stack_push (parser->stack, PARSER_BATCH);
+        }
       else if (strcmp (element_name, "directories") == 0)
         {
           parser->types |= THUNAR_UCA_TYPE_DIRECTORIES;
@@ -855,6 +1166,7 @@ end_element_handler (GMarkupParseContext *context,
                                    parser->patterns->str,
                                    parser->types,
                                    0, 0);
+          thunar_uca_model_set_batch (parser->model, &iter, parser->batch_size, parser->batch_parallel);
 
           /* check if a new id should've been generated */
           if (exo_str_is_empty (parser->unique_id->str))
@@ -904,6 +1216,11 @@ end_element_handler (GMarkupParseContext *context,
         goto unknown_element;
       break;
 
+    case PARSER_BATCH:
+      if (strcmp (element_name, "batch") != 0)
+        goto unknown_element;
+      break;
+
     case PARSER_DIRECTORIES:
       if (strcmp (element_name, "directories") != 0)
         goto unknown_element;
@@ -1080,6 +1397,96 @@ types_from_mime_type (const gchar *mime_type)
 
 
 
+static ThunarUcaModelIndex*
+thunar_uca_model_index_new (ThunarUcaModel *uca_model)
+{
+  ThunarUcaModelIndex *index;
+  ThunarUcaIndexEntry *entry;
+  const gchar         *pattern;
+  GPtrArray           *specs;
+  GSList              *positions;
+  GList               *lp;
+  gsize                len;
+  guint                i, m;
+
+  index = g_slice_new0 (ThunarUcaModelIndex);
+  index->n_entries = g_list_length (uca_model->items);
+  index->entries = g_new0 (ThunarUcaIndexEntry, index->n_entries);
+  index->suffixes = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_slist_free);
+
+  for (i = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
+    {
+      entry = &index->entries[i];
+      entry->item = lp->data;
+
+      specs = g_ptr_array_new ();
+      for (m = 0; entry->item->patterns != NULL && entry->item->patterns[m] != NULL; ++m)
+        {
+          pattern = entry->item->patterns[m];
+          if (strcmp (pattern, "*") == 0)
+            {
+              entry->matches_all = TRUE;
+            }
+          else if (pattern[0] == '*' && pattern[1] != '\0' && strpbrk (pattern + 1, "*?") == NULL)
+            {
+              /* the pattern only matches names ending with the literal suffix */
+              positions = g_hash_table_lookup (index->suffixes, pattern + 1);
+              if (positions == NULL || GPOINTER_TO_UINT (positions->data) != i)
+                {
+                  g_hash_table_steal (index->suffixes, pattern + 1);
+                  g_hash_table_insert (index->suffixes, (gpointer) (pattern + 1),
+                                       g_slist_prepend (positions, GUINT_TO_POINTER (i)));
+                }
+
+              len = strlen (pattern + 1);
+              index->max_suffix_len = MAX (index->max_suffix_len, len);
+            }
+          else
+            {
+              g_ptr_array_add (specs, g_pattern_spec_new (pattern));
+            }
+        }
+      g_ptr_array_add (specs, NULL);
+      entry->specs = (GPatternSpec **) g_ptr_array_free (specs, FALSE);
+    }
+
+  return index;
+}
+
+
+
+static void
+thunar_uca_model_index_free (ThunarUcaModelIndex *index)
+{
+  guint i, m;
+
+  for (i = 0; i < index->n_entries; ++i)
+    {
+      for (m = 0; index->entries[i].specs[m] != NULL; ++m)
+        g_pattern_spec_free (index->entries[i].specs[m]);
+      g_free (index->entries[i].specs);
+    }
+
+  g_hash_table_destroy (index->suffixes);
+  g_free (index->entries);
+  g_slice_free (ThunarUcaModelIndex, index);
+}
+
+
+
+static void
+thunar_uca_model_invalidate (ThunarUcaModel *uca_model)
+{
+  /* the index is rebuilt on the next match */
+  if (uca_model->index != NULL)
+    {
+      thunar_uca_model_index_free (uca_model->index);
+      uca_model->index = NULL;
+    }
+}
+
+
+
 /**
  * thunar_uca_model_match:
  * @uca_model  : a #ThunarUcaModel.
@@ -1101,22 +1508,26 @@ GList*
 thunar_uca_model_match (ThunarUcaModel *uca_model,
                         GList          *file_infos)
 {
-  typedef struct
-  {
-    gchar          *name;
-    ThunarUcaTypes  types;
-  } ThunarUcaFile;
-
-  ThunarUcaModelItem *item;
-  ThunarUcaFile      *files;
-  GFile              *location;
-  gchar              *mime_type;
-  gboolean            matches;
-  GList              *paths = NULL;
-  GList              *lp;
-  gint                n_files;
-  gint                i, m, n;
-  gchar              *path_test;
+  ThunarUcaModelIndex *index;
+  ThunarUcaIndexEntry *entry;
+  ThunarUcaTypes       types;
+  GHashTable          *mime_types;
+  gpointer             value;
+  gboolean            *alive;
+  GFile               *location;
+  gchar               *mime_type;
+  gchar               *name;
+  gboolean             matches;
+  GSList              *positions;
+  GList               *paths = NULL;
+  GList               *lp;
+  guint               *hits;
+  guint                n_alive;
+  guint                n_files;
+  gsize                name_len;
+  gsize                pos;
+  guint                i, m, n;
+  gchar               *path_test;
 
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), NULL);
   g_return_val_if_fail (file_infos != NULL, NULL);
@@ -1125,10 +1536,27 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
   if (G_UNLIKELY (uca_model->items == NULL))
     return NULL;
 
-  /* determine the ThunarUcaFile's for the given file_infos */
+  /* compile the patterns once */
+  if (G_UNLIKELY (uca_model->index == NULL))
+    uca_model->index = thunar_uca_model_index_new (uca_model);
+  index = uca_model->index;
+
+  /* check which items we can ignore right away */
   n_files = g_list_length (file_infos);
-  files = g_new (ThunarUcaFile, n_files);
-  for (lp = file_infos, n = 0; lp != NULL; lp = lp->next, ++n)
+  alive = g_new (gboolean, index->n_entries);
+  for (i = 0, n_alive = 0; i < index->n_entries; ++i)
+    {
+      alive[i] = (index->entries[i].item->multiple_selection || index->entries[i].item->batch_size > 0 || n_files <= 1);
+      if (alive[i])
+        n_alive++;
+    }
+
+  /* the file type class only depends on the mime type */
+  mime_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  hits = g_new0 (guint, index->n_entries);
+
+  /* match the specified files, as long as any item is left */
+  for (lp = file_infos, n = 1; lp != NULL; lp = lp->next, ++n)
     {
       location = thunarx_file_info_get_location (lp->data);
 
@@ -1137,57 +1565,78 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
         {
           /* cannot handle non-local files */
           g_object_unref (location);
-          g_free (files);
-          return NULL;
+          n_alive = 0;
+          break;
         }
       g_free (path_test);
 
       g_object_unref (location);
 
-      mime_type = thunarx_file_info_get_mime_type (lp->data);
+      /* no need to look at the names once nothing matches */
+      if (n_alive == 0)
+        continue;
 
-      files[n].name = thunarx_file_info_get_name (lp->data);
-      files[n].types = types_from_mime_type (mime_type);
+      mime_type = thunarx_file_info_get_mime_type (lp->data);
+      if (mime_type != NULL && g_hash_table_lookup_extended (mime_types, mime_type, NULL, &value))
+        {
+          types = GPOINTER_TO_UINT (value);
+          g_free (mime_type);
+        }
+      else
+        {
+          types = types_from_mime_type (mime_type);
+          if (G_UNLIKELY (types == 0))
+            types = THUNAR_UCA_TYPE_OTHER_FILES;
 
-      if (G_UNLIKELY (files[n].types == 0))
-        files[n].types = THUNAR_UCA_TYPE_OTHER_FILES;
+          if (mime_type != NULL)
+            g_hash_table_insert (mime_types, mime_type, GUINT_TO_POINTER (types));
+        }
 
-      g_free (mime_type);
-    }
+      /* mark the items with a pattern matching a suffix of the name */
+      name = thunarx_file_info_get_name (lp->data);
+      name_len = strlen (name);
+      for (pos = name_len > index->max_suffix_len ? name_len - index->max_suffix_len : 0; pos < name_len; ++pos)
+        for (positions = g_hash_table_lookup (index->suffixes, name + pos); positions != NULL; positions = positions->next)
+          hits[GPOINTER_TO_UINT (positions->data)] = n;
 
-  /* lookup the matching items */
-  for (i = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
-    {
-      /* check if we can just ignore this item */
-      item = (ThunarUcaModelItem *) lp->data;
-      if (!item->multiple_selection && n_files > 1)
-        continue;
-
-      /* match the specified files */
-      for (n = 0; n < n_files; ++n)
+      for (i = 0; i < index->n_entries; ++i)
         {
-          /* verify that we support this type of file */
-          if ((files[n].types & item->types) == 0)
-            break;
+          if (!alive[i])
+            continue;
 
-          /* atleast on pattern must match the file name */
-          for (m = 0, matches = FALSE; item->patterns[m] != NULL && !matches; ++m)
-            matches = g_pattern_match_simple (item->patterns[m], files[n].name);
+          /* verify that we support this type of file */
+          entry = &index->entries[i];
+          if ((types & entry->item->types) == 0)
+            {
+              matches = FALSE;
+            }
+          else
+            {
+              /* atleast one pattern must match the file name */
+              matches = (entry->matches_all || hits[i] == n);
+              for (m = 0; entry->specs[m] != NULL && !matches; ++m)
+                matches = g_pattern_match (entry->specs[m], name_len, name, NULL);
+            }
 
-          /* no need to continue if none of the patterns match */
           if (!matches)
-            break;
+            {
+              alive[i] = FALSE;
+              n_alive--;
+            }
         }
 
-      /* add the path if all files match one of the patterns */
-      if (G_UNLIKELY (n == n_files))
-        paths = g_list_append (paths, gtk_tree_path_new_from_indices (i, -1));
+      g_free (name);
     }
 
+  /* add the paths of the items all files matched */
+  for (i = index->n_entries; n_alive > 0 && i-- > 0; )
+    if (alive[i])
+      paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
+
   /* cleanup */
-  for (n = 0; n < n_files; ++n)
-    g_free (files[n].name);
-  g_free (files);
+  g_hash_table_destroy (mime_types);
+  g_free (alive);
+  g_free (hits);
 
   return paths;
 }
@@ -1215,6 +1664,7 @@ thunar_uca_model_append (ThunarUcaModel *uca_model,
   /* append the new item */
   item = g_new0 (ThunarUcaModelItem, 1);
   uca_model->items = g_list_append (uca_model->items, item);
+  thunar_uca_model_invalidate (uca_model);
 
   /* determine the tree iter of the new item */
   iter->stamp = uca_model->stamp;
@@ -1265,6 +1715,7 @@ thunar_uca_model_exchange (ThunarUcaModel *uca_model,
   new_order[g_list_position (uca_model->items, list_b)] = g_list_position (uca_model->items, list_a);
 
   /* perform the exchange */
+  thunar_uca_model_invalidate (uca_model);
   item = list_a->data;
   list_a->data = list_b->data;
   list_b->data = item;
@@ -1315,6 +1766,7 @@ thunar_uca_model_remove (ThunarUcaModel *uca_model,
   /* remove the node from the list */
   item = ((GList *) iter->user_data)->data;
   uca_model->items = g_list_delete_link (uca_model->items, iter->user_data);
+  thunar_uca_model_invalidate (uca_model);
   thunar_uca_model_item_free (item);
 
   /* notify listeners */
@@ -1359,14 +1811,22 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
   ThunarUcaModelItem *item;
   GtkTreePath        *path;
   guint               n, m;
+  guint               batch_size;
+  guint               batch_parallel;
   gchar              *accel_path;
 
   g_return_if_fail (THUNAR_UCA_IS_MODEL (uca_model));
   g_return_if_fail (iter->stamp == uca_model->stamp);
 
-  /* reset the previous item values */
+  /* reset the previous item values, the editor does
+   * not know about batches, so they are kept */
   item = ((GList *) iter->user_data)->data;
+  batch_size = item->batch_size;
+  batch_parallel = item->batch_parallel;
+  thunar_uca_model_invalidate (uca_model);
   thunar_uca_model_item_reset (item);
+  item->batch_size = batch_size;
+  item->batch_parallel = batch_parallel;
 
   /* setup the new item values */
   if (G_LIKELY (name != NULL && *name != '\0'))
@@ -1424,6 +1884,163 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
 
 
 
+/**
+ * thunar_uca_model_set_batch:
+ * @uca_model      : a #ThunarUcaModel.
+ * @iter           : the #GtkTreeIter of the item to update.
+ * @batch_size     : the maximum number of files per invocation, %THUNAR_UCA_BATCH_AUTO
+ *                   to only split where the command line gets too long, or 0 to
+ *                   pass the whole selection to one invocation.
+ * @batch_parallel : the number of invocations to run at the same time.
+ *
+ * Sets the batching policy of the @uca_model item at @iter, see
+ * thunar_uca_model_split_files().
+ **/
+void
+thunar_uca_model_set_batch (ThunarUcaModel *uca_model,
+                            GtkTreeIter    *iter,
+                            guint           batch_size,
+                            guint           batch_parallel)
+{
+  ThunarUcaModelItem *item;
+
+  g_return_if_fail (THUNAR_UCA_IS_MODEL (uca_model));
+  g_return_if_fail (iter->stamp == uca_model->stamp);
+
+  item = ((GList *) iter->user_data)->data;
+  if (item->batch_size == batch_size && item->batch_parallel == MAX (batch_parallel, 1))
+    return;
+
+  /* the batch size decides whether the item matches multiple files */
+  thunar_uca_model_invalidate (uca_model);
+
+  item->batch_size = batch_size;
+  item->batch_parallel = MAX (batch_parallel, 1);
+}
+
+
+
+static gsize
+thunar_uca_model_get_max_arg_len (void)
+{
+  glong arg_max;
+
+  /* leave half of the space to the environment, like xargs */
+  arg_max = sysconf (_SC_ARG_MAX);
+  if (G_UNLIKELY (arg_max <= 0))
+    arg_max = 4096; /* _POSIX_ARG_MAX */
+
+  return MIN ((gsize) arg_max / 2, BATCH_MAX_ARG_LEN);
+}
+
+
+
+/**
+ * thunar_uca_model_split_files:
+ * @uca_model  : a #ThunarUcaModel.
+ * @iter       : the #GtkTreeIter of the item.
+ * @file_infos : the #GList of #ThunarxFileInfo<!---->s to pass to the item.
+ * @n_parallel : return location for the number of batches to run at the same time.
+ *
+ * Splits @file_infos into the batches the item at @iter is run for,
+ * every batch to be passed to thunar_uca_model_parse_argv(). Items
+ * without a batching policy get all files in one batch. Otherwise
+ * every batch is small enough for the command line, and a command
+ * that takes only a single file (%f, %u, %d or %n) is run once per
+ * file.
+ *
+ * The caller is responsible to free the returned list using:
+ * <informalexample><programlisting>
+ * g_list_free_full (list, (GDestroyNotify) g_list_free);
+ * </programlisting></informalexample>
+ *
+ * Return value: the #GList of batches, every one a #GList of the
+ *               #ThunarxFileInfo<!---->s from @file_infos.
+ **/
+GList*
+thunar_uca_model_split_files (ThunarUcaModel *uca_model,
+                              GtkTreeIter    *iter,
+                              GList          *file_infos,
+                              guint          *n_parallel)
+{
+  ThunarUcaModelItem *item;
+  const gchar        *p;
+  GList              *batches = NULL;
+  GList              *batch = NULL;
+  GList              *lp;
+  gchar              *uri;
+  gsize               max_len;
+  gsize               len;
+  gsize               cost;
+  guint               n_codes = 0;
+  guint               n_files = 0;
+
+  g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), NULL);
+  g_return_val_if_fail (iter->stamp == uca_model->stamp, NULL);
+  g_return_val_if_fail (n_parallel != NULL, NULL);
+
+  item = ((GList *) iter->user_data)->data;
+  *n_parallel = MAX (item->batch_parallel, 1);
+
+  /* the whole selection goes to a single invocation */
+  if (item->batch_size == 0 || item->command == NULL)
+    return g_list_prepend (NULL, g_list_copy (file_infos));
+
+  /* count the field codes that expand to all files of the batch */
+  for (p = item->command; *p != '\0'; ++p)
+    if (p[0] == '%' && p[1] != '\0')
+      {
+        ++p;
+        if (*p == 'F' || *p == 'U' || *p == 'D' || *p == 'N')
+          ++n_codes;
+      }
+
+  max_len = thunar_uca_model_get_max_arg_len ();
+  len = strlen (item->command);
+
+  for (lp = file_infos; lp != NULL; lp = lp->next)
+    {
+      /* an upper bound of what the file adds to the command line: the
+       * uri is at least as long as the path, quoting may turn every
+       * character into four and adds the quotes and the separator */
+      if (n_codes > 0)
+        {
+          uri = thunarx_file_info_get_uri (lp->data);
+          cost = n_codes * (4 * strlen (uri) + 3);
+          g_free (uri);
+        }
+      else
+        {
+          cost = 0;
+        }
+
+      /* start a new batch if the file does not fit anymore */
+      if (batch != NULL
+          && (n_codes == 0 || n_files >= item->batch_size || len + cost > max_len))
+        {
+          batches = g_list_prepend (batches, g_list_reverse (batch));
+          batch = NULL;
+          len = strlen (item->command);
+          n_files = 0;
+        }
+
+      batch = g_list_prepend (batch, lp->data);
+      len += cost;
+      n_files++;
+    }
+
+  if (batch != NULL)
+    batches = g_list_prepend (batches, g_list_reverse (batch));
+
+  /* an empty selection is a single empty batch */
+  if (G_UNLIKELY (batches == NULL))
+    return g_list_prepend (NULL, NULL);
+
+  return g_list_reverse (batches);
+}
+
+
+
 /**
  * thunar_uca_model_save:
  * @uca_model : a #ThunarUcaModel.
@@ -1440,6 +2057,7 @@ thunar_uca_model_save (ThunarUcaModel *uca_model,
 {
   ThunarUcaModelItem *item;
   gboolean            result = FALSE;
+  gchar              *cache_path;
   gchar              *tmp_path;
   gchar              *patterns;
   gchar              *escaped;
@@ -1459,6 +2077,11 @@ thunar_uca_model_save (ThunarUcaModel *uca_model,
       return FALSE;
     }
 
+  /* the cache of the previous version is outdated now */
+  cache_path = thunar_uca_model_get_cache_path (path);
+  g_unlink (cache_path);
+  g_free (cache_path);
+
   /* try to open a temporary file */
   tmp_path = g_strconcat (path, ".XXXXXX", NULL);
   fd = g_mkstemp (tmp_path);
@@ -1499,6 +2122,10 @@ thunar_uca_model_save (ThunarUcaModel *uca_model,
       g_free (escaped);
       if (item->startup_notify)
         fprintf (fp, "\t<startup-notify/>\n");
+      if (item->batch_size == THUNAR_UCA_BATCH_AUTO)
+        fprintf (fp, "\t<batch parallel=\"%u\"/>\n", item->batch_parallel);
+      else if (item->batch_size > 0)
+        fprintf (fp, "\t<batch size=\"%u\" parallel=\"%u\"/>\n", item->batch_size, item->batch_parallel);
       if ((item->types & THUNAR_UCA_TYPE_DIRECTORIES) != 0)
         fprintf (fp, "\t<directories/>\n");
       if ((item->types & THUNAR_UCA_TYPE_AUDIO_FILES) != 0)
@@ -70,6 +70,9 @@ typedef enum /*< flags >*/
   THUNAR_UCA_TYPE_VIDEO_FILES = 1 << 5,
 } ThunarUcaTypes;
 
+/* the batch size of items which are only split to fit on the command line */
+#define THUNAR_UCA_BATCH_AUTO (G_MAXINT)
+
 GType           thunar_uca_model_get_type       (void) G_GNUC_CONST;
 void            thunar_uca_model_register_type  (ThunarxProviderPlugin  *plugin);
 
@@ -102,6 +105,16 @@ void            thunar_uca_model_update         (ThunarUcaModel         *uca_mod
                                                  guint                   accel_key,
                                                  GdkModifierType         accel_mods);
 
+void            thunar_uca_model_set_batch      (ThunarUcaModel         *uca_model,
+                                                 GtkTreeIter            *iter,
+                                                 guint                   batch_size,
+                                                 guint                   batch_parallel);
+
+GList          *thunar_uca_model_split_files    (ThunarUcaModel         *uca_model,
+                                                 GtkTreeIter            *iter,
+                                                 GList                  *file_infos,
+                                                 guint                  *n_parallel) G_GNUC_MALLOC;
+
 gboolean        thunar_uca_model_save           (ThunarUcaModel         *uca_model,
                                                  GError                **error);
 
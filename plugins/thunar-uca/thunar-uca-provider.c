@@ -36,23 +36,72 @@
 
 
 
-static void   thunar_uca_provider_menu_provider_init        (ThunarxMenuProviderIface         *iface);
-static void   thunar_uca_provider_preferences_provider_init (ThunarxPreferencesProviderIface  *iface);
-static void   thunar_uca_provider_finalize                  (GObject                          *object);
-static GList *thunar_uca_provider_get_menu_items            (ThunarxPreferencesProvider       *preferences_provider,
-                                                             GtkWidget                        *window);
-static GList *thunar_uca_provider_get_file_menu_items       (ThunarxMenuProvider              *menu_provider,
-                                                             GtkWidget                        *window,
-                                                             GList                            *files);
-static GList *thunar_uca_provider_get_folder_menu_items     (ThunarxMenuProvider              *menu_provider,
-                                                             GtkWidget                        *window,
-                                                             ThunarxFileInfo                  *folder);
-static void   thunar_uca_provider_activated                 (ThunarUcaProvider                *uca_provider,
-                                                             ThunarxMenuItem                  *item);
-static void   thunar_uca_provider_child_watch               (ThunarUcaProvider                *uca_provider,
-                                                             gint                              exit_status);
-static void   thunar_uca_provider_child_watch_destroy       (gpointer                          user_data,
-                                                             GClosure                         *closure);
+/* a custom action run for a large selection in several invocations,
+ * see thunar_uca_model_split_files() */
+typedef struct
+{
+  ThunarUcaProvider *uca_provider;
+  GdkScreen         *screen;
+  GtkWidget         *window;
+  GtkWidget         *dialog;
+  GtkWidget         *progress;
+  gchar             *label;
+  gchar             *icon_name;
+  gboolean           startup_notify;
+
+  /* the invocations not started yet */
+  GQueue             pending;
+
+  /* the working directories to refresh once all invocations are done */
+  GHashTable        *directories;
+
+  guint              n_parallel;
+  guint              n_total;
+  guint              n_running;
+  guint              n_done;
+  guint              n_failed;
+  gboolean           cancelled;
+  GError            *error;
+} ThunarUcaBatch;
+
+typedef struct
+{
+  ThunarUcaBatch  *batch;
+  gchar          **argv;
+  gchar           *working_directory;
+} ThunarUcaBatchRun;
+
+
+
+static void     thunar_uca_provider_menu_provider_init        (ThunarxMenuProviderIface         *iface);
+static void     thunar_uca_provider_preferences_provider_init (ThunarxPreferencesProviderIface  *iface);
+static void     thunar_uca_provider_finalize                  (GObject                          *object);
+static GList   *thunar_uca_provider_get_menu_items            (ThunarxPreferencesProvider       *preferences_provider,
+                                                               GtkWidget                        *window);
+static GList   *thunar_uca_provider_get_file_menu_items       (ThunarxMenuProvider              *menu_provider,
+                                                               GtkWidget                        *window,
+                                                               GList                            *files);
+static GList   *thunar_uca_provider_get_folder_menu_items     (ThunarxMenuProvider              *menu_provider,
+                                                               GtkWidget                        *window,
+                                                               ThunarxFileInfo                  *folder);
+static void     thunar_uca_provider_activated                 (ThunarUcaProvider                *uca_provider,
+                                                               ThunarxMenuItem                  *item);
+static void     thunar_uca_provider_child_watch               (ThunarUcaProvider                *uca_provider,
+                                                               gint                              exit_status);
+static void     thunar_uca_provider_child_watch_destroy       (gpointer                          user_data,
+                                                               GClosure                         *closure);
+static gchar   *thunar_uca_provider_get_working_directory     (ThunarxMenuItem                  *item,
+                                                               GList                            *files);
+static gboolean thunar_uca_provider_batch_start               (ThunarUcaProvider                *uca_provider,
+                                                               ThunarxMenuItem                  *item,
+                                                               GtkTreeIter                      *iter,
+                                                               GtkWidget                        *window,
+                                                               GList                            *batches,
+                                                               guint                             n_parallel,
+                                                               GError                          **error);
+static void     thunar_uca_provider_batch_spawn               (ThunarUcaBatch                   *batch);
+static void     thunar_uca_provider_batch_finish              (ThunarUcaBatch                   *batch);
+static void     thunar_uca_provider_notify_changed            (const gchar                      *directory);
 
 
 
@@ -415,14 +464,14 @@ thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
   GError              *error = NULL;
   GList               *files;
   gchar              **argv;
-  gchar               *working_directory = NULL;
-  gchar               *filename;
+  gchar               *working_directory;
   gchar               *label;
-  GFile               *location;
   gint                 argc;
   gchar               *icon_name = NULL;
   gboolean             startup_notify;
   GClosure            *child_watch;
+  GList               *batches;
+  guint                n_parallel;
 
   g_return_if_fail (THUNAR_UCA_IS_PROVIDER (uca_provider));
   g_return_if_fail (THUNARX_IS_MENU_ITEM (item));
@@ -442,79 +491,69 @@ thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
   window = thunar_uca_context_get_window (uca_context);
   files = thunar_uca_context_get_files (uca_context);
 
-  /* determine the argc/argv for the item */
-  succeed = thunar_uca_model_parse_argv (uca_provider->model, &iter, files, &argc, &argv, &error);
-  if (G_LIKELY (succeed))
+  /* large selections may be split into several invocations */
+  batches = thunar_uca_model_split_files (uca_provider->model, &iter, files, &n_parallel);
+  if (G_UNLIKELY (batches->next != NULL))
     {
-      /* get the icon name and whether startup notification is active */
-      gtk_tree_model_get (GTK_TREE_MODEL (uca_provider->model), &iter,
-                          THUNAR_UCA_MODEL_COLUMN_ICON_NAME, &icon_name,
-                          THUNAR_UCA_MODEL_COLUMN_STARTUP_NOTIFY, &startup_notify,
-                          -1);
-
-      /* determine the working from the first file */
-      if (G_LIKELY (files != NULL))
+      succeed = thunar_uca_provider_batch_start (uca_provider, item, &iter, window, batches, n_parallel, &error);
+    }
+  else
+    {
+      /* determine the argc/argv for the item */
+      succeed = thunar_uca_model_parse_argv (uca_provider->model, &iter, files, &argc, &argv, &error);
+      if (G_LIKELY (succeed))
         {
-          /* determine the filename of the first selected file */
-          location = thunarx_file_info_get_location (files->data);
-          filename = g_file_get_path (location);
-          if (G_LIKELY (filename != NULL))
-            {
-              /* if this is a folder menu item, we just use the filename as working directory */
-              if (g_object_get_qdata (G_OBJECT (item), thunar_uca_folder_quark) != NULL)
-                {
-                  working_directory = filename;
-                  filename = NULL;
-                }
-              else
-                {
-                  working_directory = g_path_get_dirname (filename);
-                }
-            }
-          g_free (filename);
-          g_object_unref (location);
-        }
-
-      /* build closre for child watch */
-      child_watch = g_cclosure_new_swap (G_CALLBACK (thunar_uca_provider_child_watch),
-                                         uca_provider, thunar_uca_provider_child_watch_destroy);
-      g_closure_ref (child_watch);
-      g_closure_sink (child_watch);
+          /* get the icon name and whether startup notification is active */
+          gtk_tree_model_get (GTK_TREE_MODEL (uca_provider->model), &iter,
+                              THUNAR_UCA_MODEL_COLUMN_ICON_NAME, &icon_name,
+                              THUNAR_UCA_MODEL_COLUMN_STARTUP_NOTIFY, &startup_notify,
+                              -1);
 
-      /* spawn the command on the window's screen */
-      succeed = xfce_spawn_on_screen_with_child_watch (gtk_widget_get_screen (GTK_WIDGET (window)),
-                                                       working_directory, argv, NULL,
-                                                       G_SPAWN_SEARCH_PATH,
-                                                       startup_notify,
-                                                       gtk_get_current_event_time (),
-                                                       icon_name,
-                                                       child_watch,
-                                                       &error);
+          /* determine the working from the first file */
+          working_directory = thunar_uca_provider_get_working_directory (item, files);
+
+          /* build closre for child watch */
+          child_watch = g_cclosure_new_swap (G_CALLBACK (thunar_uca_provider_child_watch),
+                                             uca_provider, thunar_uca_provider_child_watch_destroy);
+          g_closure_ref (child_watch);
+          g_closure_sink (child_watch);
+
+          /* spawn the command on the window's screen */
+          succeed = xfce_spawn_on_screen_with_child_watch (gtk_widget_get_screen (GTK_WIDGET (window)),
+                                                           working_directory, argv, NULL,
+                                                           G_SPAWN_SEARCH_PATH,
+                                                           startup_notify,
+                                                           gtk_get_current_event_time (),
+                                                           icon_name,
+                                                           child_watch,
+                                                           &error);
+
+          /* check if we succeed */
+          if (G_LIKELY (succeed))
+            {
+              /* release existing child watch */
+              thunar_uca_provider_child_watch_destroy (uca_provider, NULL);
 
-      /* check if we succeed */
-      if (G_LIKELY (succeed))
-        {
-          /* release existing child watch */
-          thunar_uca_provider_child_watch_destroy (uca_provider, NULL);
+              /* set new closure */
+              uca_provider->child_watch = child_watch;
 
-          /* set new closure */
-          uca_provider->child_watch = child_watch;
+              /* take over ownership of the working directory as child watch path */
+              uca_provider->child_watch_path = working_directory;
+              working_directory = NULL;
+            }
+          else
+            {
+              /* spawn failed, release watch */
+              g_closure_unref (child_watch);
+            }
 
-          /* take over ownership of the working directory as child watch path */
-          uca_provider->child_watch_path = working_directory;
-          working_directory = NULL;
-        }
-      else
-        {
-          /* spawn failed, release watch */
-          g_closure_unref (child_watch);
+          /* cleanup */
+          g_free (working_directory);
+          g_strfreev (argv);
+          g_free (icon_name);
         }
-
-      /* cleanup */
-      g_free (working_directory);
-      g_strfreev (argv);
-      g_free (icon_name);
     }
+  g_list_free_full (batches, (GDestroyNotify) g_list_free);
 
   /* present error message to the user */
   if (G_UNLIKELY (!succeed))
@@ -541,29 +580,11 @@ thunar_uca_provider_child_watch (ThunarUcaProvider *uca_provider,
                                  gint               exit_status)
 
 {
-  GFileMonitor *monitor;
-  GFile        *file;
-
   g_return_if_fail (THUNAR_UCA_IS_PROVIDER (uca_provider));
 
   /* verify that we still have a valid child_watch_path */
   if (G_LIKELY (uca_provider->child_watch_path != NULL))
-    {
-      /* determine the corresponding file */
-      file = g_file_new_for_path (uca_provider->child_watch_path);
-
-      /* schedule a changed notification on the path */
-      monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, NULL);
-
-      if (monitor != NULL)
-        {
-          g_file_monitor_emit_event (monitor, file, file, G_FILE_MONITOR_EVENT_CHANGED);
-          g_object_unref (monitor);
-        }
-
-      /* release the file */
-      g_object_unref (file);
-    }
+    thunar_uca_provider_notify_changed (uca_provider->child_watch_path);
 
   thunar_uca_provider_child_watch_destroy (uca_provider, NULL);
 }
@@ -595,3 +616,330 @@ thunar_uca_provider_child_watch_destroy (gpointer  user_data,
       uca_provider->child_watch_path = NULL;
     }
 }
+
+
+
+static gchar*
+thunar_uca_provider_get_working_directory (ThunarxMenuItem *item,
+                                           GList           *files)
+{
+  gchar *working_directory = NULL;
+  gchar *filename;
+  GFile *location;
+
+  if (G_UNLIKELY (files == NULL))
+    return NULL;
+
+  /* determine the filename of the first selected file */
+  location = thunarx_file_info_get_location (files->data);
+  filename = g_file_get_path (location);
+  if (G_LIKELY (filename != NULL))
+    {
+      /* if this is a folder menu item, we just use the filename as working directory */
+      if (g_object_get_qdata (G_OBJECT (item), thunar_uca_folder_quark) != NULL)
+        {
+          working_directory = filename;
+          filename = NULL;
+        }
+      else
+        {
+          working_directory = g_path_get_dirname (filename);
+        }
+    }
+  g_free (filename);
+  g_object_unref (location);
+
+  return working_directory;
+}
+
+
+
+static void
+thunar_uca_provider_notify_changed (const gchar *directory)
+{
+  GFileMonitor *monitor;
+  GFile        *file;
+
+  /* determine the corresponding file */
+  file = g_file_new_for_path (directory);
+
+  /* schedule a changed notification on the path */
+  monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, NULL);
+
+  if (monitor != NULL)
+    {
+      g_file_monitor_emit_event (monitor, file, file, G_FILE_MONITOR_EVENT_CHANGED);
+      g_object_unref (monitor);
+    }
+
+  /* release the file */
+  g_object_unref (file);
+}
+
+
+
+static void
+thunar_uca_provider_batch_run_free (gpointer data)
+{
+  ThunarUcaBatchRun *run = data;
+
+  g_strfreev (run->argv);
+  g_free (run->working_directory);
+  g_slice_free (ThunarUcaBatchRun, run);
+}
+
+
+
+static void
+thunar_uca_provider_batch_update (ThunarUcaBatch *batch)
+{
+  gchar *text;
+
+  if (batch->progress == NULL)
+    return;
+
+  /* TRANSLATORS: the number of finished and the number of all
+   * invocations of a custom action run for a large selection */
+  text = g_strdup_printf (_("%u of %u"), batch->n_done, batch->n_total);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (batch->progress), text);
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (batch->progress), (gdouble) batch->n_done / batch->n_total);
+  g_free (text);
+}
+
+
+
+static void
+thunar_uca_provider_batch_finish (ThunarUcaBatch *batch)
+{
+  GHashTableIter  iter;
+  GtkWidget      *dialog;
+  gpointer        directory;
+
+  /* the folders of all invocations may have changed */
+  g_hash_table_iter_init (&iter, batch->directories);
+  while (g_hash_table_iter_next (&iter, &directory, NULL))
+    thunar_uca_provider_notify_changed (directory);
+
+  if (batch->dialog != NULL)
+    gtk_widget_destroy (batch->dialog);
+
+  /* tell the user about the invocations that did not succeed */
+  if (G_UNLIKELY (batch->error != NULL || batch->n_failed > 0))
+    {
+      dialog = gtk_message_dialog_new ((GtkWindow *) batch->window,
+                                       GTK_DIALOG_DESTROY_WITH_PARENT,
+                                       GTK_MESSAGE_ERROR,
+                                       GTK_BUTTONS_CLOSE,
+                                       (batch->error != NULL)
+                                       ? _("Failed to launch action \"%s\".")
+                                       : _("Action \"%s\" failed for some files."),
+                                       batch->label);
+      if (batch->error != NULL)
+        gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s.", batch->error->message);
+      else
+        gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+                                                  ngettext ("%u of %u invocations exited with an error.",
+                                                            "%u of %u invocations exited with an error.",
+                                                            batch->n_total),
+                                                  batch->n_failed, batch->n_total);
+      g_signal_connect (dialog, "response", G_CALLBACK (gtk_widget_destroy), NULL);
+      gtk_widget_show (dialog);
+    }
+
+  if (batch->window != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (batch->window), (gpointer) &batch->window);
+
+  g_queue_foreach (&batch->pending, (GFunc) (void (*)(void)) thunar_uca_provider_batch_run_free, NULL);
+  g_queue_clear (&batch->pending);
+  g_hash_table_destroy (batch->directories);
+  g_clear_error (&batch->error);
+  g_object_unref (batch->screen);
+  g_object_unref (batch->uca_provider);
+  g_free (batch->icon_name);
+  g_free (batch->label);
+  g_slice_free (ThunarUcaBatch, batch);
+}
+
+
+
+static void
+thunar_uca_provider_batch_child_watch (ThunarUcaBatchRun *run,
+                                       gint               exit_status)
+{
+  ThunarUcaBatch *batch = run->batch;
+
+  /* the closure is invoked once, when the child is gone */
+  batch->n_running--;
+  batch->n_done++;
+  if (!g_spawn_check_exit_status (exit_status, NULL))
+    batch->n_failed++;
+
+  thunar_uca_provider_batch_run_free (run);
+  thunar_uca_provider_batch_update (batch);
+
+  /* start the next invocation or finish the batch */
+  thunar_uca_provider_batch_spawn (batch);
+}
+
+
+
+static void
+thunar_uca_provider_batch_spawn (ThunarUcaBatch *batch)
+{
+  ThunarUcaBatchRun *run;
+  GClosure          *child_watch;
+  gboolean           succeed;
+
+  while (!batch->cancelled && batch->n_running < batch->n_parallel
+         && !g_queue_is_empty (&batch->pending))
+    {
+      run = g_queue_pop_head (&batch->pending);
+
+      /* the spawn keeps its own reference until the child exits */
+      child_watch = g_cclosure_new_swap (G_CALLBACK (thunar_uca_provider_batch_child_watch), run, NULL);
+      g_closure_ref (child_watch);
+      g_closure_sink (child_watch);
+
+      /* only the first invocation is announced with startup notification */
+      succeed = xfce_spawn_on_screen_with_child_watch (batch->screen,
+                                                       run->working_directory, run->argv, NULL,
+                                                       G_SPAWN_SEARCH_PATH,
+                                                       batch->startup_notify && batch->n_done + batch->n_running == 0,
+                                                       GDK_CURRENT_TIME,
+                                                       batch->icon_name,
+                                                       child_watch,
+                                                       &batch->error);
+      g_closure_unref (child_watch);
+
+      if (G_UNLIKELY (!succeed))
+        {
+          /* do not start any further invocations */
+          thunar_uca_provider_batch_run_free (run);
+          batch->cancelled = TRUE;
+          break;
+        }
+
+      if (run->working_directory != NULL)
+        g_hash_table_add (batch->directories, g_strdup (run->working_directory));
+      batch->n_running++;
+    }
+
+  /* the batch is done once nothing is running anymore */
+  if (batch->n_running == 0 && (batch->cancelled || g_queue_is_empty (&batch->pending)))
+    thunar_uca_provider_batch_finish (batch);
+}
+
+
+
+static void
+thunar_uca_provider_batch_response (GtkWidget      *dialog,
+                                    gint            response,
+                                    ThunarUcaBatch *batch)
+{
+  /* the running invocations are left alone, but no new ones are started */
+  batch->cancelled = TRUE;
+  gtk_widget_destroy (dialog);
+}
+
+
+
+static void
+thunar_uca_provider_batch_dialog_destroy (GtkWidget      *dialog,
+                                          ThunarUcaBatch *batch)
+{
+  batch->dialog = NULL;
+  batch->progress = NULL;
+}
+
+
+
+static gboolean
+thunar_uca_provider_batch_start (ThunarUcaProvider *uca_provider,
+                                 ThunarxMenuItem   *item,
+                                 GtkTreeIter       *iter,
+                                 GtkWidget         *window,
+                                 GList             *batches,
+                                 guint              n_parallel,
+                                 GError           **error)
+{
+  ThunarUcaBatchRun *run;
+  ThunarUcaBatch    *batch;
+  GtkWidget         *content;
+  GtkWidget         *label;
+  GList             *lp;
+  gchar             *text;
+  guint              n_files = 0;
+  gint               argc;
+
+  batch = g_slice_new0 (ThunarUcaBatch);
+  g_queue_init (&batch->pending);
+
+  /* expand the command lines of all invocations before the first one
+   * is started, so the model may change while the batch is running */
+  for (lp = batches; lp != NULL; lp = lp->next)
+    {
+      run = g_slice_new0 (ThunarUcaBatchRun);
+      run->batch = batch;
+      if (!thunar_uca_model_parse_argv (uca_provider->model, iter, lp->data, &argc, &run->argv, error))
+        {
+          g_slice_free (ThunarUcaBatchRun, run);
+          g_queue_foreach (&batch->pending, (GFunc) (void (*)(void)) thunar_uca_provider_batch_run_free, NULL);
+          g_queue_clear (&batch->pending);
+          g_slice_free (ThunarUcaBatch, batch);
+          return FALSE;
+        }
+
+      run->working_directory = thunar_uca_provider_get_working_directory (item, lp->data);
+      g_queue_push_tail (&batch->pending, run);
+      n_files += g_list_length (lp->data);
+    }
+
+  gtk_tree_model_get (GTK_TREE_MODEL (uca_provider->model), iter,
+                      THUNAR_UCA_MODEL_COLUMN_ICON_NAME, &batch->icon_name,
+                      THUNAR_UCA_MODEL_COLUMN_STARTUP_NOTIFY, &batch->startup_notify,
+                      -1);
+  g_object_get (G_OBJECT (item), "label", &batch->label, NULL);
+
+  batch->uca_provider = g_object_ref (uca_provider);
+  batch->screen = g_object_ref (gtk_widget_get_screen (window));
+  batch->window = window;
+  g_object_add_weak_pointer (G_OBJECT (window), (gpointer) &batch->window);
+  batch->directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  batch->n_parallel = n_parallel;
+  batch->n_total = g_queue_get_length (&batch->pending);
+
+  /* show the progress of the batch, closing the dialog stops it */
+  batch->dialog = gtk_dialog_new_with_buttons (batch->label, GTK_WINDOW (window),
+                                               GTK_DIALOG_DESTROY_WITH_PARENT,
+                                               _("_Cancel"), GTK_RESPONSE_CANCEL,
+                                               NULL);
+  gtk_window_set_default_size (GTK_WINDOW (batch->dialog), 350, -1);
+  g_signal_connect (batch->dialog, "response", G_CALLBACK (thunar_uca_provider_batch_response), batch);
+  g_signal_connect (batch->dialog, "destroy", G_CALLBACK (thunar_uca_provider_batch_dialog_destroy), batch);
+
+  content = gtk_dialog_get_content_area (GTK_DIALOG (batch->dialog));
+  gtk_container_set_border_width (GTK_CONTAINER (content), 12);
+  gtk_box_set_spacing (GTK_BOX (content), 6);
+
+  text = g_strdup_printf (ngettext ("Running the action for %u file in %u invocations.",
+                                    "Running the action for %u files in %u invocations.",
+                                    n_files),
+                          n_files, batch->n_total);
+  label = gtk_label_new (text);
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0f);
+  gtk_box_pack_start (GTK_BOX (content), label, FALSE, FALSE, 0);
+  g_free (text);
+
+  batch->progress = gtk_progress_bar_new ();
+  gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (batch->progress), TRUE);
+  gtk_box_pack_start (GTK_BOX (content), batch->progress, FALSE, FALSE, 0);
+
+  thunar_uca_provider_batch_update (batch);
+  gtk_widget_show_all (batch->dialog);
+
+  /* start the first invocations, spawn errors are reported when the batch is done */
+  thunar_uca_provider_batch_spawn (batch);
+
+  return TRUE;
+}
+
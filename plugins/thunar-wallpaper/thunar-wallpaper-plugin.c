@@ -58,6 +58,10 @@ thunar_extension_initialize (ThunarxProviderPlugin *plugin)
   bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
 #endif
 
+  /* the wallpaper settings are read in a thread, so the code has
+   * to stay around */
+  thunarx_provider_plugin_set_resident (plugin, TRUE);
+
   /* register the types provided by this plugin */
   twp_provider_register_type (plugin);
 
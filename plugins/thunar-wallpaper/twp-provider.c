@@ -51,7 +51,15 @@ static void   twp_action_set_wallpaper          (ThunarxMenuItem          *item,
 static gint   twp_get_active_workspace_number   (GdkScreen *screen);
 
 static gboolean    _has_gsettings = FALSE;
-static GtkWidget   *main_window = NULL;
+
+typedef struct
+{
+  gchar     *file_name;
+  gint       workspace;
+
+  /* the model names of the monitors, %NULL if unknown */
+  GPtrArray *monitor_names;
+} TwpWallpaper;
 
 struct _TwpProviderClass
 {
@@ -122,8 +130,6 @@ twp_provider_get_file_menu_items (ThunarxMenuProvider *menu_provider,
   GList           *items = NULL;
   gchar           *mime_type;
 
-  main_window = window;
-
   /* we can only set a single wallpaper */
   if (files->next == NULL)
     {
@@ -163,30 +169,149 @@ twp_provider_get_file_menu_items (ThunarxMenuProvider *menu_provider,
   return items;
 }
 
+static void
+twp_wallpaper_free (TwpWallpaper *wallpaper)
+{
+  g_ptr_array_free (wallpaper->monitor_names, TRUE);
+  g_free (wallpaper->file_name);
+  g_slice_free (TwpWallpaper, wallpaper);
+}
+
+
+
+static void
+twp_wallpaper_properties_thread (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  GHashTable *properties;
+
+  /* fetch all backdrop settings in a single round trip */
+  properties = xfconf_channel_get_properties (XFCONF_CHANNEL (source_object), "/backdrop");
+  g_task_return_pointer (task, properties, properties != NULL ? (GDestroyNotify) g_hash_table_destroy : NULL);
+}
+
+
+
+static void
+twp_wallpaper_set_style (XfconfChannel *channel,
+                         GHashTable    *properties,
+                         const gchar   *image_style_prop,
+                         gint           image_style)
+{
+  /* If there isn't a wallpaper style set, then set one */
+  if (properties == NULL || !g_hash_table_contains (properties, image_style_prop))
+    xfconf_channel_set_int (channel, image_style_prop, image_style);
+}
+
+
+
+static void
+twp_wallpaper_properties_ready (GObject      *object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  XfconfChannel *channel = XFCONF_CHANNEL (object);
+  TwpWallpaper  *wallpaper = user_data;
+  GHashTable    *properties;
+  const GValue  *value;
+  const gchar   *monitor_name;
+  gboolean       is_single_workspace = TRUE;
+  gchar         *image_path_prop;
+  gchar         *image_show_prop;
+  gchar         *image_style_prop;
+  gint           screen_nr = 0;
+  gint           workspace = wallpaper->workspace;
+  guint          monitor_nr;
+
+  properties = g_task_propagate_pointer (G_TASK (result), NULL);
+
+  /* Xfdesktop 4.11+ has a concept of a single-workspace-mode where
+   * the same workspace is used for everything but additionally allows
+   * the user to use any current workspace as the single active
+   * workspace, we'll need to check if it is enabled (which by default
+   * it is) and use that. */
+  if (properties != NULL)
+    {
+      value = g_hash_table_lookup (properties, "/backdrop/single-workspace-mode");
+      if (value != NULL && G_VALUE_HOLDS_BOOLEAN (value))
+        is_single_workspace = g_value_get_boolean (value);
+    }
+  if (is_single_workspace)
+    {
+      workspace = 0;
+      value = (properties != NULL) ? g_hash_table_lookup (properties, "/backdrop/single-workspace-number") : NULL;
+      if (value != NULL && G_VALUE_HOLDS_INT (value))
+        workspace = g_value_get_int (value);
+    }
+
+  /* apply the wallpaper to every monitor, the settings were all read
+   * at once above, so no further round trips are needed here */
+  for (monitor_nr = 0; monitor_nr < wallpaper->monitor_names->len; ++monitor_nr)
+    {
+      /* This is the format for xfdesktop before 4.11 */
+      image_path_prop = g_strdup_printf("/backdrop/screen%d/monitor%u/image-path", screen_nr, monitor_nr);
+      image_show_prop = g_strdup_printf("/backdrop/screen%d/monitor%u/image-show", screen_nr, monitor_nr);
+      image_style_prop = g_strdup_printf("/backdrop/screen%d/monitor%u/image-style", screen_nr, monitor_nr);
+
+      /* Set the wallpaper and ensure that it's set to show */
+      xfconf_channel_set_string (channel, image_path_prop, wallpaper->file_name);
+      xfconf_channel_set_bool (channel, image_show_prop, TRUE);
+      twp_wallpaper_set_style (channel, properties, image_style_prop, 0);
+
+      g_free(image_path_prop);
+      g_free(image_show_prop);
+      g_free(image_style_prop);
+
+      /* This is the format for xfdesktop post 4.11. A workspace number is
+       * added and the monitor is referred to name. We set both formats so
+       * that it works as the user expects. */
+      monitor_name = g_ptr_array_index (wallpaper->monitor_names, monitor_nr);
+      if (monitor_name)
+        {
+          image_path_prop = g_strdup_printf("/backdrop/screen%d/monitor%s/workspace%d/last-image", screen_nr, monitor_name, workspace);
+          image_style_prop = g_strdup_printf("/backdrop/screen%d/monitor%s/workspace%d/image-style", screen_nr, monitor_name, workspace);
+        }
+      else
+        {
+          /* gdk_monitor_get_model can return NULL, in those instances
+           * we fallback to monitor number but still include the
+           * workspace number */
+          image_path_prop = g_strdup_printf("/backdrop/screen%d/monitor%u/workspace%d/last-image", screen_nr, monitor_nr, workspace);
+          image_style_prop = g_strdup_printf("/backdrop/screen%d/monitor%u/workspace%d/image-style", screen_nr, monitor_nr, workspace);
+        }
+
+      xfconf_channel_set_string (channel, image_path_prop, wallpaper->file_name);
+      twp_wallpaper_set_style (channel, properties, image_style_prop, 5);
+
+      g_free(image_path_prop);
+      g_free(image_style_prop);
+    }
+
+  if (properties != NULL)
+    g_hash_table_destroy (properties);
+  twp_wallpaper_free (wallpaper);
+}
+
+
+
 static void
 twp_action_set_wallpaper (ThunarxMenuItem *item,
                           gpointer         user_data)
 {
   ThunarxFileInfo *file_info = user_data;
   GdkDisplay      *display = gdk_display_get_default();
-  gint             screen_nr = 0;
   gint             n_monitors;
-  gint             monitor_nr = 0;
-  gint             workspace;
+  gint             monitor_nr;
   GdkScreen       *screen;
   GdkMonitor      *monitor;
-  gchar           *image_path_prop;
-  gchar           *image_show_prop;
-  gchar           *image_style_prop;
-  const char      *monitor_name;
+  TwpWallpaper    *wallpaper;
   gchar           *file_uri;
-  gchar           *escaped_file_name;
   gchar           *file_name = NULL;
   gchar           *hostname = NULL;
   gchar           *command;
-  XfconfChannel   *channel;
-  gboolean         is_single_workspace;
-  gint             current_image_style;
+  GTask           *task;
   const gchar     *desktop_type = NULL;
 
   screen = gdk_display_get_default_screen (display);
@@ -209,87 +334,28 @@ twp_action_set_wallpaper (ThunarxMenuItem *item,
       return;
     }
 
-  workspace = twp_get_active_workspace_number (screen);
-  n_monitors = gdk_display_get_n_monitors (display);
-
-  if (n_monitors > 1 && main_window)
-    {
-      monitor = gdk_display_get_monitor_at_window (display, gtk_widget_get_window (main_window));
-    }
-  else
-    {
-      monitor = gdk_display_get_monitor (display, monitor_nr);
-    }
-
-  monitor_name = gdk_monitor_get_model (monitor);
-  escaped_file_name = g_shell_quote (file_name);
-
   if (g_strcmp0 (desktop_type, "XFCE") == 0)
     {
       g_debug ("set on xfce");
 
-      channel = xfconf_channel_get ("xfce4-desktop");
+      wallpaper = g_slice_new0 (TwpWallpaper);
+      wallpaper->file_name = file_name;
+      wallpaper->workspace = twp_get_active_workspace_number (screen);
+      file_name = NULL;
 
-      /* This is the format for xfdesktop before 4.11 */
-      image_path_prop = g_strdup_printf("/backdrop/screen%d/monitor%d/image-path", screen_nr, monitor_nr);
-      image_show_prop = g_strdup_printf("/backdrop/screen%d/monitor%d/image-show", screen_nr, monitor_nr);
-      image_style_prop = g_strdup_printf("/backdrop/screen%d/monitor%d/image-style", screen_nr, monitor_nr);
-
-      /* Set the wallpaper and ensure that it's set to show */
-      xfconf_channel_set_string (channel, image_path_prop, file_name);
-      xfconf_channel_set_bool (channel, image_show_prop, TRUE);
-
-      /* If there isn't a wallpaper style set, then set one */
-      current_image_style = xfconf_channel_get_int (channel, image_style_prop, -1);
-      if (current_image_style == -1)
+      /* remember the monitors now, they may change until the settings are read */
+      n_monitors = gdk_display_get_n_monitors (display);
+      wallpaper->monitor_names = g_ptr_array_new_full (n_monitors, g_free);
+      for (monitor_nr = 0; monitor_nr < n_monitors; ++monitor_nr)
         {
-          xfconf_channel_set_int (channel, image_style_prop, 0);
+          monitor = gdk_display_get_monitor (display, monitor_nr);
+          g_ptr_array_add (wallpaper->monitor_names, g_strdup (gdk_monitor_get_model (monitor)));
         }
 
-      g_free(image_path_prop);
-      g_free(image_show_prop);
-      g_free(image_style_prop);
-
-
-      /* Xfdesktop 4.11+ has a concept of a single-workspace-mode where
-       * the same workspace is used for everything but additionally allows
-       * the user to use any current workspace as the single active
-       * workspace, we'll need to check if it is enabled (which by default
-       * it is) and use that. */
-      is_single_workspace = xfconf_channel_get_bool (channel, "/backdrop/single-workspace-mode", TRUE);
-      if (is_single_workspace)
-        {
-          workspace = xfconf_channel_get_int (channel, "/backdrop/single-workspace-number", 0);
-        }
-
-      /* This is the format for xfdesktop post 4.11. A workspace number is
-       * added and the monitor is referred to name. We set both formats so
-       * that it works as the user expects. */
-      if (monitor_name)
-        {
-          image_path_prop = g_strdup_printf("/backdrop/screen%d/monitor%s/workspace%d/last-image", screen_nr, monitor_name, workspace);
-          image_style_prop = g_strdup_printf("/backdrop/screen%d/monitor%s/workspace%d/image-style", screen_nr, monitor_name, workspace);
-        }
-      else
-        {
-          /* gdk_screen_get_monitor_plug_name can return NULL, in those
-           * instances we fallback to monitor number but still include the
-           * workspace number */
-          image_path_prop = g_strdup_printf("/backdrop/screen%d/monitor%d/workspace%d/last-image", screen_nr, monitor_nr, workspace);
-          image_style_prop = g_strdup_printf("/backdrop/screen%d/monitor%d/workspace%d/image-style", screen_nr, monitor_nr, workspace);
-        }
-
-      xfconf_channel_set_string (channel, image_path_prop, file_name);
-
-      /* If there isn't a wallpaper style set, then set one */
-      current_image_style = xfconf_channel_get_int (channel, image_style_prop, -1);
-      if (current_image_style == -1)
-        {
-          xfconf_channel_set_int (channel, image_style_prop, 5);
-        }
-
-      g_free(image_path_prop);
-      g_free(image_style_prop);
+      /* read the current settings without blocking the file manager */
+      task = g_task_new (xfconf_channel_get ("xfce4-desktop"), NULL, twp_wallpaper_properties_ready, wallpaper);
+      g_task_run_in_thread (task, twp_wallpaper_properties_thread);
+      g_object_unref (task);
     }
   else if (g_strcmp0 (desktop_type, "GNOME") == 0)
     {
@@ -313,7 +379,6 @@ twp_action_set_wallpaper (ThunarxMenuItem *item,
       g_warning (("Failed to set wallpaper: $XDG_CURRENT_DESKTOP Desktop type '%s' not supported by thunar wallpaper plugin."), desktop_type);
     }
 
-  g_free (escaped_file_name);
   g_free (file_name);
   g_free (file_uri);
 }
@@ -36,11 +36,18 @@
 #include <xfconf/xfconf.h>
 
 #include <thunar/thunar-application.h>
+#include <thunar/thunar-counters.h>
 #include <thunar/thunar-gobject-extensions.h>
+#include <thunar/thunar-headless.h>
+#include <thunar/thunar-memory.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-notify.h>
+#include <thunar/thunar-recorder.h>
 #include <thunar/thunar-session-client.h>
+#include <thunar/thunar-trace.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-util.h>
+#include <thunar/thunar-watchdog.h>
 
 
 
@@ -49,6 +56,25 @@ main (int argc, char **argv)
 {
   ThunarApplication   *application;
   GError              *error = NULL;
+  gint                 status;
+
+  /* start the clock of the startup trace */
+  thunar_util_startup_trace ("main");
+
+  /* write trace events to $THUNAR_TRACE, if set */
+  thunar_trace_init ();
+
+  /* record the file system operations to $THUNAR_RECORD, if set */
+  thunar_recorder_init ();
+
+  /* keep a histogram of main loop stalls for org.xfce.Thunar.Debug */
+  thunar_counters_watch_main_loop ();
+
+  /* print the memory held by the caches on SIGUSR2 */
+  thunar_memory_watch_signal ();
+
+  /* report main loop stalls if $THUNAR_WATCHDOG is set */
+  thunar_watchdog_init ();
 
   /* setup translation domain */
   xfce_textdomain (GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR, "UTF-8");
@@ -76,6 +102,17 @@ main (int argc, char **argv)
   /* register additional transformation functions */
   thunar_g_initialize_transformations ();
 
+  thunar_util_startup_trace ("xfconf");
+
+  /* run the file operations only, without GTK+ and a display */
+  if (thunar_headless_requested (argc, argv))
+    {
+      status = thunar_headless_run (argc, argv);
+      thunar_recorder_shutdown ();
+      thunar_trace_shutdown ();
+      return status;
+    }
+
   /* acquire a reference on the global application */
   application = thunar_application_get ();
 
@@ -92,5 +129,8 @@ main (int argc, char **argv)
   thunar_notify_uninit ();
 #endif
 
+  thunar_recorder_shutdown ();
+  thunar_trace_shutdown ();
+
   return EXIT_SUCCESS;
 }
@@ -33,9 +33,33 @@
 
 
 
+/* the width of the names in cells beside the icons in fixed cells mode */
+#define FIXED_CELLS_TEXT_CHARS (24)
+
+
+
+/* Property identifiers */
+enum
+{
+  PROP_0,
+  PROP_FIXED_CELLS,
+};
+
+
+
+static void         thunar_abstract_icon_view_finalize                (GObject                      *object);
+static void         thunar_abstract_icon_view_get_property            (GObject                      *object,
+                                                                       guint                         prop_id,
+                                                                       GValue                       *value,
+                                                                       GParamSpec                   *pspec);
+static void         thunar_abstract_icon_view_set_property            (GObject                      *object,
+                                                                       guint                         prop_id,
+                                                                       const GValue                 *value,
+                                                                       GParamSpec                   *pspec);
 static void         thunar_abstract_icon_view_style_set               (GtkWidget                    *widget,
                                                                        GtkStyle                     *previous_style);
 static GList       *thunar_abstract_icon_view_get_selected_items      (ThunarStandardView           *standard_view);
+static GArray      *thunar_abstract_icon_view_get_selected_ranges     (ThunarStandardView           *standard_view);
 static void         thunar_abstract_icon_view_select_all              (ThunarStandardView           *standard_view);
 static void         thunar_abstract_icon_view_unselect_all            (ThunarStandardView           *standard_view);
 static void         thunar_abstract_icon_view_selection_invert        (ThunarStandardView           *standard_view);
@@ -79,6 +103,8 @@ static void         thunar_abstract_icon_view_item_activated          (ExoIconVi
                                                                        GtkTreePath                  *path,
                                                                        ThunarAbstractIconView       *abstract_icon_view);
 static void         thunar_abstract_icon_view_zoom_level_changed      (ThunarAbstractIconView       *abstract_icon_view);
+static void         thunar_abstract_icon_view_update_fixed_cells      (ThunarAbstractIconView       *abstract_icon_view);
+static void         thunar_abstract_icon_view_invalidate_hit          (ThunarAbstractIconView       *abstract_icon_view);
 
 
 
@@ -94,6 +120,17 @@ struct _ThunarAbstractIconViewPrivate
   gulong gesture_release_id;
 
   gboolean button_pressed;
+
+  /* whether all items use cells of the same size */
+  gboolean fixed_cells;
+
+  /* result of the last hit test, valid until the layout changes */
+  gboolean     hit_valid;
+  gint         hit_x;
+  gint         hit_y;
+  gdouble      hit_hvalue;
+  gdouble      hit_vvalue;
+  GtkTreePath *hit_path;
 };
 
 
@@ -106,12 +143,19 @@ thunar_abstract_icon_view_class_init (ThunarAbstractIconViewClass *klass)
 {
   ThunarStandardViewClass *thunarstandard_view_class;
   GtkWidgetClass          *gtkwidget_class;
+  GObjectClass            *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_abstract_icon_view_finalize;
+  gobject_class->get_property = thunar_abstract_icon_view_get_property;
+  gobject_class->set_property = thunar_abstract_icon_view_set_property;
 
   gtkwidget_class = GTK_WIDGET_CLASS (klass);
   gtkwidget_class->style_set = thunar_abstract_icon_view_style_set;
 
   thunarstandard_view_class = THUNAR_STANDARD_VIEW_CLASS (klass);
   thunarstandard_view_class->get_selected_items = thunar_abstract_icon_view_get_selected_items;
+  thunarstandard_view_class->get_selected_ranges = thunar_abstract_icon_view_get_selected_ranges;
   thunarstandard_view_class->select_all = thunar_abstract_icon_view_select_all;
   thunarstandard_view_class->unselect_all = thunar_abstract_icon_view_unselect_all;
   thunarstandard_view_class->selection_invert = thunar_abstract_icon_view_selection_invert;
@@ -122,6 +166,21 @@ thunar_abstract_icon_view_class_init (ThunarAbstractIconViewClass *klass)
   thunarstandard_view_class->get_visible_range = thunar_abstract_icon_view_get_visible_range;
   thunarstandard_view_class->highlight_path = thunar_abstract_icon_view_highlight_path;
 
+  /**
+   * ThunarAbstractIconView:fixed-cells:
+   *
+   * %TRUE to give all items cells of the same size, computed from the
+   * zoom level and the font instead of measuring every name. Names that
+   * do not fit are ellipsized.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_FIXED_CELLS,
+                                   g_param_spec_boolean ("fixed-cells",
+                                                         "fixed-cells",
+                                                         "fixed-cells",
+                                                         FALSE,
+                                                         EXO_PARAM_READWRITE));
+
   /**
    * ThunarAbstractIconView:column-spacing:
    *
@@ -174,26 +233,113 @@ thunar_abstract_icon_view_init (ThunarAbstractIconView *abstract_icon_view)
 
   /* initialize the abstract icon view properties */
   exo_icon_view_set_enable_search (EXO_ICON_VIEW (view), TRUE);
+  exo_icon_view_set_search_equal_func (EXO_ICON_VIEW (view), thunar_list_model_search_equal, NULL, NULL);
   exo_icon_view_set_selection_mode (EXO_ICON_VIEW (view), GTK_SELECTION_MULTIPLE);
 
   /* add the abstract icon renderer */
   g_object_set (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->icon_renderer), "follow-state", TRUE, NULL);
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (view), THUNAR_STANDARD_VIEW (abstract_icon_view)->icon_renderer, FALSE);
-  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (view), THUNAR_STANDARD_VIEW (abstract_icon_view)->icon_renderer,
-                                 "file", THUNAR_COLUMN_FILE);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (view), THUNAR_STANDARD_VIEW (abstract_icon_view)->icon_renderer,
+                                      thunar_standard_view_file_cell_data, NULL, NULL);
 
   /* add the name renderer */
   /*FIXME text prelit*/
   /*g_object_set (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->name_renderer), "follow-state", TRUE, NULL);*/
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (view), THUNAR_STANDARD_VIEW (abstract_icon_view)->name_renderer, TRUE);
-  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (view), THUNAR_STANDARD_VIEW (abstract_icon_view)->name_renderer,
-                                 "text", THUNAR_COLUMN_NAME);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (view), THUNAR_STANDARD_VIEW (abstract_icon_view)->name_renderer,
+                                      thunar_standard_view_text_cell_data, GINT_TO_POINTER (THUNAR_COLUMN_NAME), NULL);
 
   /* update the icon view on size-allocate events */
   /* TODO: issue not reproducible anymore as of gtk 3.24.18
    * we can probably remove this in the future. */
   g_signal_connect_swapped (G_OBJECT (abstract_icon_view), "size-allocate",
                             G_CALLBACK (gtk_widget_queue_resize), view);
+
+  /* forget the last hit test whenever the items may have moved */
+  g_signal_connect_swapped (G_OBJECT (view), "size-allocate",
+                            G_CALLBACK (thunar_abstract_icon_view_invalidate_hit), abstract_icon_view);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->model), "row-inserted",
+                           G_CALLBACK (thunar_abstract_icon_view_invalidate_hit), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->model), "row-deleted",
+                           G_CALLBACK (thunar_abstract_icon_view_invalidate_hit), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->model), "row-changed",
+                           G_CALLBACK (thunar_abstract_icon_view_invalidate_hit), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->model), "rows-reordered",
+                           G_CALLBACK (thunar_abstract_icon_view_invalidate_hit), abstract_icon_view, G_CONNECT_SWAPPED);
+
+  /* the fixed cell sizes follow the icon size and the wrap width */
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->icon_renderer), "notify::size",
+                           G_CALLBACK (thunar_abstract_icon_view_update_fixed_cells), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->name_renderer), "notify::wrap-width",
+                           G_CALLBACK (thunar_abstract_icon_view_update_fixed_cells), abstract_icon_view, G_CONNECT_SWAPPED);
+
+  /* synchronize the "fixed-cells" property with the global preference */
+  g_object_bind_property (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->preferences),
+                          "misc-fixed-icon-view-cells",
+                          G_OBJECT (abstract_icon_view),
+                          "fixed-cells",
+                          G_BINDING_SYNC_CREATE);
+}
+
+
+
+static void
+thunar_abstract_icon_view_finalize (GObject *object)
+{
+  ThunarAbstractIconView *abstract_icon_view = THUNAR_ABSTRACT_ICON_VIEW (object);
+
+  /* release the cached hit test */
+  thunar_abstract_icon_view_invalidate_hit (abstract_icon_view);
+
+  (*G_OBJECT_CLASS (thunar_abstract_icon_view_parent_class)->finalize) (object);
+}
+
+
+
+static void
+thunar_abstract_icon_view_get_property (GObject    *object,
+                                        guint       prop_id,
+                                        GValue     *value,
+                                        GParamSpec *pspec)
+{
+  ThunarAbstractIconView *abstract_icon_view = THUNAR_ABSTRACT_ICON_VIEW (object);
+
+  switch (prop_id)
+    {
+    case PROP_FIXED_CELLS:
+      g_value_set_boolean (value, abstract_icon_view->priv->fixed_cells);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+thunar_abstract_icon_view_set_property (GObject      *object,
+                                        guint         prop_id,
+                                        const GValue *value,
+                                        GParamSpec   *pspec)
+{
+  ThunarAbstractIconView *abstract_icon_view = THUNAR_ABSTRACT_ICON_VIEW (object);
+
+  switch (prop_id)
+    {
+    case PROP_FIXED_CELLS:
+      if (abstract_icon_view->priv->fixed_cells != g_value_get_boolean (value))
+        {
+          abstract_icon_view->priv->fixed_cells = g_value_get_boolean (value);
+          thunar_abstract_icon_view_update_fixed_cells (abstract_icon_view);
+        }
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
 }
 
 
@@ -214,6 +360,10 @@ thunar_abstract_icon_view_style_set (GtkWidget *widget,
 
   /* call the parent handler */
   (*GTK_WIDGET_CLASS (thunar_abstract_icon_view_parent_class)->style_set) (widget, previous_style);
+
+  /* the text height of the fixed cells depends on the font */
+  if (THUNAR_ABSTRACT_ICON_VIEW (widget)->priv->fixed_cells)
+    thunar_abstract_icon_view_update_fixed_cells (THUNAR_ABSTRACT_ICON_VIEW (widget));
 }
 
 
@@ -226,6 +376,35 @@ thunar_abstract_icon_view_get_selected_items (ThunarStandardView *standard_view)
 
 
 
+static void
+thunar_abstract_icon_view_selected_ranges_foreach (ExoIconView *view,
+                                                   GtkTreePath *path,
+                                                   gpointer     data)
+{
+  thunar_selection_ranges_add_path (data, path);
+}
+
+
+
+static GArray*
+thunar_abstract_icon_view_get_selected_ranges (ThunarStandardView *standard_view)
+{
+  GArray *ranges;
+
+  _thunar_return_val_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (standard_view), NULL);
+
+  ranges = thunar_selection_ranges_new ();
+  exo_icon_view_selected_foreach (EXO_ICON_VIEW (gtk_bin_get_child (GTK_BIN (standard_view))),
+                                  thunar_abstract_icon_view_selected_ranges_foreach, ranges);
+
+  /* the items are visited in the order of the model, but don't rely on it */
+  thunar_selection_ranges_normalize (ranges);
+
+  return ranges;
+}
+
+
+
 static void
 thunar_abstract_icon_view_select_all (ThunarStandardView *standard_view)
 {
@@ -303,8 +482,55 @@ thunar_abstract_icon_view_get_path_at_pos (ThunarStandardView *standard_view,
                                            gint                x,
                                            gint                y)
 {
+  ThunarAbstractIconView *abstract_icon_view = THUNAR_ABSTRACT_ICON_VIEW (standard_view);
+  GtkWidget              *view;
+  gdouble                 hvalue;
+  gdouble                 vvalue;
+
   _thunar_return_val_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (standard_view), NULL);
-  return exo_icon_view_get_path_at_pos (EXO_ICON_VIEW (gtk_bin_get_child (GTK_BIN (standard_view))), x, y);
+
+  view = gtk_bin_get_child (GTK_BIN (standard_view));
+  hvalue = gtk_adjustment_get_value (gtk_scrollable_get_hadjustment (GTK_SCROLLABLE (view)));
+  vvalue = gtk_adjustment_get_value (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)));
+
+  /* ExoIconView scans all items for every hit test, but the drag and
+   * drop code asks for the same position over and over (every motion
+   * event of a resting pointer, and again on drop), so remember the
+   * last answer until the items move or the view scrolls */
+  if (abstract_icon_view->priv->hit_valid
+      && abstract_icon_view->priv->hit_x == x
+      && abstract_icon_view->priv->hit_y == y
+      && abstract_icon_view->priv->hit_hvalue == hvalue
+      && abstract_icon_view->priv->hit_vvalue == vvalue)
+    {
+      return (abstract_icon_view->priv->hit_path != NULL) ? gtk_tree_path_copy (abstract_icon_view->priv->hit_path) : NULL;
+    }
+
+  thunar_abstract_icon_view_invalidate_hit (abstract_icon_view);
+
+  abstract_icon_view->priv->hit_path = exo_icon_view_get_path_at_pos (EXO_ICON_VIEW (view), x, y);
+  abstract_icon_view->priv->hit_valid = TRUE;
+  abstract_icon_view->priv->hit_x = x;
+  abstract_icon_view->priv->hit_y = y;
+  abstract_icon_view->priv->hit_hvalue = hvalue;
+  abstract_icon_view->priv->hit_vvalue = vvalue;
+
+  return (abstract_icon_view->priv->hit_path != NULL) ? gtk_tree_path_copy (abstract_icon_view->priv->hit_path) : NULL;
+}
+
+
+
+static void
+thunar_abstract_icon_view_invalidate_hit (ThunarAbstractIconView *abstract_icon_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (abstract_icon_view));
+
+  abstract_icon_view->priv->hit_valid = FALSE;
+  if (abstract_icon_view->priv->hit_path != NULL)
+    {
+      gtk_tree_path_free (abstract_icon_view->priv->hit_path);
+      abstract_icon_view->priv->hit_path = NULL;
+    }
 }
 
 
@@ -641,8 +867,66 @@ thunar_abstract_icon_view_zoom_level_changed (ThunarAbstractIconView *abstract_i
 {
   _thunar_return_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (abstract_icon_view));
 
-  /* we use the same trick as with ThunarDetailsView here, simply because its simple :-) */
+  /* setting the cell data function again invalidates the cached sizes of the
+   * icon view, we use the same trick as with ThunarDetailsView here, simply
+   * because its simple :-) */
   gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (gtk_bin_get_child (GTK_BIN (abstract_icon_view))),
                                       THUNAR_STANDARD_VIEW (abstract_icon_view)->icon_renderer,
-                                      NULL, NULL, NULL);
+                                      thunar_standard_view_file_cell_data, NULL, NULL);
+}
+
+
+
+static void
+thunar_abstract_icon_view_update_fixed_cells (ThunarAbstractIconView *abstract_icon_view)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (abstract_icon_view);
+  PangoFontMetrics   *metrics;
+  PangoContext       *context;
+  ThunarIconSize      icon_size;
+  GtkWidget          *view = gtk_bin_get_child (GTK_BIN (abstract_icon_view));
+  gint                wrap_width;
+  gint                text_width;
+  gint                text_height;
+  gint                xpad, ypad;
+
+  _thunar_return_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (abstract_icon_view));
+
+  if (!abstract_icon_view->priv->fixed_cells)
+    {
+      /* let the renderers measure every item again */
+      gtk_cell_renderer_set_fixed_size (standard_view->icon_renderer, -1, -1);
+      gtk_cell_renderer_set_fixed_size (standard_view->name_renderer, -1, -1);
+      g_object_set (G_OBJECT (standard_view->name_renderer), "ellipsize", PANGO_ELLIPSIZE_NONE, NULL);
+    }
+  else
+    {
+      /* the icon cell only depends on the zoom level */
+      g_object_get (G_OBJECT (standard_view->icon_renderer), "size", &icon_size, NULL);
+      gtk_cell_renderer_get_padding (standard_view->icon_renderer, &xpad, &ypad);
+      gtk_cell_renderer_set_fixed_size (standard_view->icon_renderer, icon_size + 2 * xpad, icon_size + 2 * ypad);
+
+      /* one line of text, without laying out any name */
+      context = gtk_widget_get_pango_context (view);
+      metrics = pango_context_get_metrics (context, pango_context_get_font_description (context),
+                                           pango_context_get_language (context));
+      text_height = PANGO_PIXELS (pango_font_metrics_get_ascent (metrics) + pango_font_metrics_get_descent (metrics));
+      text_width = FIXED_CELLS_TEXT_CHARS * PANGO_PIXELS (pango_font_metrics_get_approximate_char_width (metrics));
+      pango_font_metrics_unref (metrics);
+
+      /* names below the icons are as wide as they would wrap, names
+       * beside the icons get a fixed number of characters at most */
+      g_object_get (G_OBJECT (standard_view->name_renderer), "wrap-width", &wrap_width, NULL);
+      if (exo_icon_view_get_orientation (EXO_ICON_VIEW (view)) == GTK_ORIENTATION_VERTICAL && wrap_width > 0)
+        text_width = wrap_width;
+      else if (wrap_width > 0)
+        text_width = MIN (text_width, wrap_width);
+
+      gtk_cell_renderer_get_padding (standard_view->name_renderer, &xpad, &ypad);
+      gtk_cell_renderer_set_fixed_size (standard_view->name_renderer, text_width + 2 * xpad, text_height + 2 * ypad);
+      g_object_set (G_OBJECT (standard_view->name_renderer), "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+    }
+
+  /* relayout all items with the new cell sizes */
+  thunar_abstract_icon_view_zoom_level_changed (abstract_icon_view);
 }
@@ -0,0 +1,356 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunarx/thunarx.h>
+
+#include <thunar/thunar-app-index.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* GIO scans the desktop files again for every query of the installed
+ * applications, which takes a while on systems with many of them. So the
+ * answers are kept here until GAppInfoMonitor reports a change, and the
+ * list of all applications is built in the background after startup.
+ */
+typedef struct
+{
+  GAppInfo *default_app;
+
+  /* the applications for the type, with the default first */
+  GList    *apps;
+}
+AppIndexType;
+
+
+
+static void          thunar_app_index_changed    (GAppInfoMonitor *monitor);
+static AppIndexType *thunar_app_index_lookup     (const gchar     *content_type);
+
+
+
+static GHashTable *app_index_types = NULL;
+static GList      *app_index_all = NULL;
+static gboolean    app_index_all_valid = FALSE;
+static gboolean    app_index_preloading = FALSE;
+
+/* bumped whenever the index is invalidated, so a preload that was
+ * started before does not store outdated results */
+static guint       app_index_generation = 0;
+
+
+
+static gint
+thunar_app_index_compare (gconstpointer a,
+                          gconstpointer b)
+{
+  return g_app_info_equal (G_APP_INFO (a), G_APP_INFO (b)) ? 0 : 1;
+}
+
+
+
+static void
+thunar_app_index_type_free (gpointer data)
+{
+  AppIndexType *type = data;
+
+  if (type->default_app != NULL)
+    g_object_unref (type->default_app);
+  g_list_free_full (type->apps, g_object_unref);
+  g_slice_free (AppIndexType, type);
+}
+
+
+
+static void
+thunar_app_index_init (void)
+{
+  if (G_LIKELY (app_index_types != NULL))
+    return;
+
+  app_index_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, thunar_app_index_type_free);
+
+  /* the monitor lives as long as the process */
+  g_signal_connect (g_app_info_monitor_get (), "changed",
+                    G_CALLBACK (thunar_app_index_changed), NULL);
+}
+
+
+
+static void
+thunar_app_index_changed (GAppInfoMonitor *monitor)
+{
+  thunar_app_index_invalidate ();
+
+  /* rebuild the list in the background again, which also keeps
+   * the monitor armed */
+  thunar_app_index_preload ();
+}
+
+
+
+static void
+thunar_app_index_preload_thread (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  /* querying the applications is thread-safe */
+  g_task_return_pointer (task, g_app_info_get_all (), (GDestroyNotify) thunar_g_list_free_full);
+}
+
+
+
+static void
+thunar_app_index_preload_ready (GObject      *source_object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  GList *all;
+
+  app_index_preloading = FALSE;
+
+  all = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (GPOINTER_TO_UINT (user_data) == app_index_generation && !app_index_all_valid)
+    {
+      app_index_all = all;
+      app_index_all_valid = TRUE;
+    }
+  else
+    {
+      thunar_g_list_free_full (all);
+    }
+}
+
+
+
+/**
+ * thunar_app_index_preload:
+ *
+ * Builds the list of all installed applications in the background, so
+ * the first context menu or "Open With" dialog does not wait for it.
+ **/
+void
+thunar_app_index_preload (void)
+{
+  GTask *task;
+
+  thunar_app_index_init ();
+
+  if (app_index_all_valid || app_index_preloading)
+    return;
+
+  app_index_preloading = TRUE;
+
+  task = g_task_new (NULL, NULL, thunar_app_index_preload_ready, GUINT_TO_POINTER (app_index_generation));
+  g_task_run_in_thread (task, thunar_app_index_preload_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * thunar_app_index_invalidate:
+ *
+ * Forgets all answers, because the applications or their associations
+ * changed. This is done automatically when GAppInfoMonitor reports
+ * a change, but that is delayed, so callers changing the associations
+ * themselves should call this right away.
+ **/
+void
+thunar_app_index_invalidate (void)
+{
+  app_index_generation++;
+
+  if (app_index_types != NULL)
+    g_hash_table_remove_all (app_index_types);
+
+  thunar_g_list_free_full (app_index_all);
+  app_index_all = NULL;
+  app_index_all_valid = FALSE;
+}
+
+
+
+static AppIndexType *
+thunar_app_index_lookup (const gchar *content_type)
+{
+  AppIndexType *type;
+  GList        *lp;
+
+  thunar_app_index_init ();
+
+  type = g_hash_table_lookup (app_index_types, content_type);
+  if (G_LIKELY (type != NULL))
+    return type;
+
+  type = g_slice_new0 (AppIndexType);
+  type->default_app = g_app_info_get_default_for_type (content_type, FALSE);
+  type->apps = g_app_info_get_all_for_type (content_type);
+
+  /* move the default application in front of the list */
+  if (G_LIKELY (type->default_app != NULL))
+    {
+      for (lp = type->apps; lp != NULL; lp = lp->next)
+        {
+          if (g_app_info_equal (lp->data, type->default_app))
+            {
+              g_object_unref (lp->data);
+              type->apps = g_list_delete_link (type->apps, lp);
+              break;
+            }
+        }
+      type->apps = g_list_prepend (type->apps, g_object_ref (type->default_app));
+    }
+
+  g_hash_table_insert (app_index_types, g_strdup (content_type), type);
+
+  return type;
+}
+
+
+
+/**
+ * thunar_app_index_get_all:
+ *
+ * Like g_app_info_get_all(), but answered from memory.
+ *
+ * The caller is responsible to free the returned list using
+ * thunar_g_list_free_full() when no longer needed.
+ *
+ * Return value: the list of all installed applications.
+ **/
+GList*
+thunar_app_index_get_all (void)
+{
+  thunar_app_index_init ();
+
+  /* the preload did not finish yet, so don't wait for it */
+  if (G_UNLIKELY (!app_index_all_valid))
+    {
+      app_index_all = g_app_info_get_all ();
+      app_index_all_valid = TRUE;
+    }
+
+  return thunar_g_list_copy_deep (app_index_all);
+}
+
+
+
+/**
+ * thunar_app_index_get_for_type:
+ * @content_type : a content type.
+ *
+ * Like g_app_info_get_all_for_type(), but answered from memory, and
+ * with the default application for @content_type first.
+ *
+ * The caller is responsible to free the returned list using
+ * thunar_g_list_free_full() when no longer needed.
+ *
+ * Return value: the applications for @content_type.
+ **/
+GList*
+thunar_app_index_get_for_type (const gchar *content_type)
+{
+  _thunar_return_val_if_fail (content_type != NULL, NULL);
+  return thunar_g_list_copy_deep (thunar_app_index_lookup (content_type)->apps);
+}
+
+
+
+/**
+ * thunar_app_index_get_for_types:
+ * @content_types : a #GList of content types.
+ *
+ * Returns the applications that can open all of the @content_types,
+ * in the order of thunar_app_index_get_for_type() for the first type.
+ *
+ * The caller is responsible to free the returned list using
+ * thunar_g_list_free_full() when no longer needed.
+ *
+ * Return value: the applications for all of @content_types.
+ **/
+GList*
+thunar_app_index_get_for_types (GList *content_types)
+{
+  AppIndexType *type;
+  GList        *applications = NULL;
+  GList        *next;
+  GList        *ap;
+  GList        *lp;
+
+  for (lp = content_types; lp != NULL; lp = lp->next)
+    {
+      type = thunar_app_index_lookup (lp->data);
+      if (lp == content_types)
+        {
+          /* first type, so just use its applications */
+          applications = thunar_g_list_copy_deep (type->apps);
+        }
+      else
+        {
+          /* keep only the applications that are also present for this type */
+          for (ap = applications; ap != NULL; ap = next)
+            {
+              next = ap->next;
+              if (g_list_find_custom (type->apps, ap->data, thunar_app_index_compare) == NULL)
+                {
+                  g_object_unref (ap->data);
+                  applications = g_list_delete_link (applications, ap);
+                }
+            }
+        }
+
+      /* check if the set is still not empty */
+      if (applications == NULL)
+        break;
+    }
+
+  return applications;
+}
+
+
+
+/**
+ * thunar_app_index_get_default_for_type:
+ * @content_type : a content type.
+ *
+ * Like g_app_info_get_default_for_type(), but answered from memory.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the default application for @content_type or %NULL.
+ **/
+GAppInfo*
+thunar_app_index_get_default_for_type (const gchar *content_type)
+{
+  AppIndexType *type;
+
+  _thunar_return_val_if_fail (content_type != NULL, NULL);
+
+  type = thunar_app_index_lookup (content_type);
+  return (type->default_app != NULL) ? g_object_ref (type->default_app) : NULL;
+}
@@ -0,0 +1,38 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_APP_INDEX_H__
+#define __THUNAR_APP_INDEX_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+void      thunar_app_index_preload              (void);
+void      thunar_app_index_invalidate           (void);
+
+GList    *thunar_app_index_get_all              (void) G_GNUC_WARN_UNUSED_RESULT;
+GList    *thunar_app_index_get_for_type         (const gchar *content_type) G_GNUC_WARN_UNUSED_RESULT;
+GList    *thunar_app_index_get_for_types        (GList       *content_types) G_GNUC_WARN_UNUSED_RESULT;
+GAppInfo *thunar_app_index_get_default_for_type (const gchar *content_type) G_GNUC_WARN_UNUSED_RESULT;
+
+G_END_DECLS
+
+#endif /* !__THUNAR_APP_INDEX_H__ */
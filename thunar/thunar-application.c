@@ -45,17 +45,26 @@
 
 #include <libxfce4ui/libxfce4ui.h>
 
+#include <thunar/thunar-app-index.h>
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-browser.h>
+#include <thunar/thunar-desktop-entry-cache.h>
 #include <thunar/thunar-dialogs.h>
+#include <thunar/thunar-folder.h>
 #include <thunar/thunar-gdk-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
+#include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-progress-dialog.h>
 #include <thunar/thunar-renamer-dialog.h>
+#include <thunar/thunar-sendto-model.h>
+#include <thunar/thunar-shortcuts-model.h>
+#include <thunar/thunar-size-cache.h>
+#include <thunar/thunar-state-writer.h>
 #include <thunar/thunar-thumbnail-cache.h>
+#include <thunar/thunar-thumbnail-index.h>
 #include <thunar/thunar-thumbnailer.h>
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-view.h>
@@ -64,6 +73,9 @@
 
 #define ACCEL_MAP_PATH "Thunar/accels.scm"
 
+/* seconds before the deferred initialization runs, if no window is drawn */
+#define THUNAR_APPLICATION_DEFERRED_INIT_TIMEOUT (2)
+
 
 
 /* option values */
@@ -77,6 +89,7 @@ static const GOptionEntry option_entries[] =
 {
   { "bulk-rename", 'B', 0, G_OPTION_ARG_NONE, NULL, N_ ("Open the bulk rename dialog"), NULL, },
   { "daemon", 0, 0, G_OPTION_ARG_NONE, NULL, N_ ("Run in daemon mode"), NULL, },
+  { "headless", 0, 0, G_OPTION_ARG_NONE, NULL, N_ ("Run the file operations without a display (see --headless --help)"), NULL, },
   { "sm-client-id", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_STRING, &opt_sm_client_id, NULL, NULL, },
   { "quit", 'q', 0, G_OPTION_ARG_NONE, NULL, N_ ("Quit a running Thunar instance"), NULL, },
   { "version", 'V', 0, G_OPTION_ARG_NONE, &opt_version, N_ ("Print version information and exit"), NULL, },
@@ -131,8 +144,15 @@ static gboolean       thunar_application_dbus_register          (GApplication
                                                                  GDBusConnection        *connection,
                                                                  const gchar            *object_path,
                                                                  GError                **error);
+static void           thunar_application_window_removed         (GtkApplication         *gtk_application,
+                                                                 GtkWindow              *window);
 static void           thunar_application_load_css               (void);
 static void           thunar_application_accel_map_changed      (ThunarApplication      *application);
+static void           thunar_application_accel_map_print        (gpointer                data,
+                                                                 const gchar            *accel_path,
+                                                                 guint                   accel_key,
+                                                                 GdkModifierType         accel_mods,
+                                                                 gboolean                changed);
 static gboolean       thunar_application_accel_map_save         (gpointer                user_data);
 static void           thunar_application_collect_and_launch     (ThunarApplication      *application,
                                                                  gpointer                parent,
@@ -146,6 +166,10 @@ static void           thunar_application_collect_and_launch     (ThunarApplicati
                                                                  GClosure               *new_files_closure);
 static void           thunar_application_launch_finished        (ThunarJob              *job,
                                                                  GList                  *containing_folders);
+static void           thunar_application_job_finished           (ThunarJob              *job,
+                                                                 ThunarApplication      *application);
+static void           thunar_application_job_destroyed          (gpointer                user_data,
+                                                                 GObject                *where_the_job_was);
 static void           thunar_application_launch                 (ThunarApplication      *application,
                                                                  gpointer                parent,
                                                                  const gchar            *icon_name,
@@ -170,6 +194,20 @@ static void           thunar_application_volman_watch_destroy   (gpointer
 #endif
 static gboolean       thunar_application_show_dialogs           (gpointer                user_data);
 static void           thunar_application_show_dialogs_destroy   (gpointer                user_data);
+static gboolean       thunar_application_trim_memory            (gpointer                user_data);
+static gboolean       thunar_application_deferred_init          (gpointer                user_data);
+static GtkWidget     *thunar_application_new_window             (GdkScreen              *screen);
+static void           thunar_application_window_pool_schedule   (ThunarApplication      *application);
+static gboolean       thunar_application_window_pool_fill       (gpointer                user_data);
+static void           thunar_application_window_pool_clear      (ThunarApplication      *application);
+static gboolean       thunar_application_window_drawn           (GtkWidget              *window,
+                                                                 cairo_t                *cr,
+                                                                 ThunarApplication      *application);
+#if GLIB_CHECK_VERSION (2, 64, 0)
+static void           thunar_application_low_memory_warning     (GMemoryMonitor         *monitor,
+                                                                 GMemoryMonitorWarningLevel level,
+                                                                 ThunarApplication      *application);
+#endif
 static GtkWidget     *thunar_application_get_progress_dialog    (ThunarApplication      *application);
 static void           thunar_application_process_files          (ThunarApplication      *application);
 
@@ -201,6 +239,26 @@ struct _ThunarApplication
 
   guint                           show_dialogs_timer_id;
 
+  guint                           trim_memory_idle_id;
+
+  /* work that is not needed to show the first window */
+  guint                           deferred_init_id;
+  gboolean                        deferred_init_done;
+  ThunarSendtoModel              *sendto_model;
+  ThunarShortcutsModel           *shortcuts_model;
+  ThunarxProviderFactory         *provider_factory;
+
+  /* hidden windows kept ready in daemon mode */
+  GList                          *window_pool;
+  guint                           window_pool_idle_id;
+
+  /* the jobs shown in the progress dialog, without a reference */
+  GList                          *jobs;
+  guint                           last_job_id;
+#if GLIB_CHECK_VERSION (2, 64, 0)
+  GMemoryMonitor                 *memory_monitor;
+#endif
+
 #ifdef HAVE_GUDEV
   GUdevClient                    *udev_client;
 
@@ -221,6 +279,8 @@ struct _ThunarApplication
 static GQuark thunar_application_screen_quark;
 static GQuark thunar_application_startup_id_quark;
 static GQuark thunar_application_file_quark;
+static GQuark thunar_application_job_id_quark;
+static GQuark thunar_application_job_title_quark;
 
 
 
@@ -234,6 +294,7 @@ thunar_application_class_init (ThunarApplicationClass *klass)
 {
   GObjectClass        *gobject_class = G_OBJECT_CLASS (klass);
   GApplicationClass   *gapplication_class = G_APPLICATION_CLASS (klass);
+  GtkApplicationClass *gtkapplication_class = GTK_APPLICATION_CLASS (klass);
 
   /* pre-allocate the required quarks */
   thunar_application_screen_quark =
@@ -242,6 +303,10 @@ thunar_application_class_init (ThunarApplicationClass *klass)
     g_quark_from_static_string ("thunar-application-startup-id");
   thunar_application_file_quark =
     g_quark_from_static_string ("thunar-application-file");
+  thunar_application_job_id_quark =
+    g_quark_from_static_string ("thunar-application-job-id");
+  thunar_application_job_title_quark =
+    g_quark_from_static_string ("thunar-application-job-title");
 
   gobject_class->finalize = thunar_application_finalize;
   gobject_class->get_property = thunar_application_get_property;
@@ -254,6 +319,8 @@ thunar_application_class_init (ThunarApplicationClass *klass)
   gapplication_class->command_line         = thunar_application_command_line;
   gapplication_class->dbus_register        = thunar_application_dbus_register;
 
+  gtkapplication_class->window_removed = thunar_application_window_removed;
+
   /**
    * ThunarApplication:daemon:
    *
@@ -349,31 +416,28 @@ static void
 thunar_application_startup (GApplication *gapp)
 {
   ThunarApplication *application = THUNAR_APPLICATION (gapp);
+  gboolean           remember_sizes;
+  gchar             *path;
 
-#ifdef HAVE_GUDEV
-  static const gchar *subsystems[] = { "block", "input", "usb", NULL };
-#endif
-  gchar              *path;
+  thunar_util_startup_trace ("application startup");
 
   /* initialize the application */
   application->preferences = thunar_preferences_get ();
-
-#ifdef HAVE_GUDEV
-  /* establish connection with udev */
-  application->udev_client = g_udev_client_new (subsystems);
-
-  /* connect to the client in order to be notified when devices are plugged in
-   * or disconnected from the computer */
-  g_signal_connect (application->udev_client, "uevent",
-                    G_CALLBACK (thunar_application_uevent), application);
-#endif
+  g_signal_connect_swapped (G_OBJECT (application->preferences), "notify::misc-daemon-window-pool",
+                            G_CALLBACK (thunar_application_window_pool_schedule), application);
+  g_object_get (G_OBJECT (application->preferences), "misc-remember-directory-sizes", &remember_sizes, NULL);
+  thunar_size_cache_set_persistent (remember_sizes);
+  thunar_util_startup_trace ("preferences");
 
   thunar_application_dbus_init (application);
+  thunar_util_startup_trace ("dbus");
 
   G_APPLICATION_CLASS (thunar_application_parent_class)->startup (gapp);
+  thunar_util_startup_trace ("gtk application startup");
 
   /* connect to the session manager */
   application->session_client = thunar_session_client_new (opt_sm_client_id);
+  thunar_util_startup_trace ("session client");
 
   /* check if we have a saved accel map */
   path = xfce_resource_lookup (XFCE_RESOURCE_CONFIG, ACCEL_MAP_PATH);
@@ -384,12 +448,105 @@ thunar_application_startup (GApplication *gapp)
       g_free (path);
     }
 
-  /* watch for changes */
+  /* changes are watched once the first window is drawn */
   application->accel_map = gtk_accel_map_get ();
+  thunar_util_startup_trace ("accel map");
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+  /* release caches when the system runs low on memory */
+  application->memory_monitor = g_memory_monitor_dup_default ();
+  g_signal_connect (application->memory_monitor, "low-memory-warning",
+                    G_CALLBACK (thunar_application_low_memory_warning), application);
+#endif
+
+  thunar_application_load_css ();
+  thunar_util_startup_trace ("css");
+
+  /* the rest is initialized after the first window has been drawn, or
+   * after a short while if no window is opened (i.e. in daemon mode) */
+  application->deferred_init_id =
+    g_timeout_add_seconds (THUNAR_APPLICATION_DEFERRED_INIT_TIMEOUT, thunar_application_deferred_init, application);
+}
+
+
+
+static gboolean
+thunar_application_deferred_init (gpointer user_data)
+{
+  ThunarApplication *application = THUNAR_APPLICATION (user_data);
+#ifdef HAVE_GUDEV
+  static const gchar *subsystems[] = { "block", "input", "usb", NULL };
+#endif
+  GList             *providers;
+
+  THUNAR_THREADS_ENTER
+
+  application->deferred_init_id = 0;
+  application->deferred_init_done = TRUE;
+
+#ifdef HAVE_GUDEV
+  /* establish connection with udev */
+  application->udev_client = g_udev_client_new (subsystems);
+
+  /* connect to the client in order to be notified when devices are plugged in
+   * or disconnected from the computer */
+  g_signal_connect (application->udev_client, "uevent",
+                    G_CALLBACK (thunar_application_uevent), application);
+  thunar_util_startup_trace ("udev client");
+#endif
+
+  /* watch for changes of the accel map */
   g_signal_connect_swapped (G_OBJECT (application->accel_map), "changed",
       G_CALLBACK (thunar_application_accel_map_changed), application);
 
-  thunar_application_load_css ();
+  /* load the "Send To" targets before the first context menu */
+  application->sendto_model = thunar_sendto_model_get_default ();
+  thunar_sendto_model_preload (application->sendto_model);
+  thunar_util_startup_trace ("sendto model");
+
+  /* index the installed applications before the first context menu */
+  thunar_app_index_preload ();
+  thunar_util_startup_trace ("application index");
+
+  /* keep the resolved shortcuts around when all windows are closed,
+   * so the side pane of the next window is filled right away */
+  application->shortcuts_model = thunar_shortcuts_model_get_default ();
+  thunar_util_startup_trace ("shortcuts model");
+
+  /* load the extensions providing context menu items */
+  application->provider_factory = thunarx_provider_factory_get_default ();
+  providers = thunarx_provider_factory_list_providers (application->provider_factory, THUNARX_TYPE_MENU_PROVIDER);
+  g_list_free_full (providers, g_object_unref);
+  thunar_util_startup_trace ("menu providers");
+
+  THUNAR_THREADS_LEAVE
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_application_window_drawn (GtkWidget         *window,
+                                 cairo_t           *cr,
+                                 ThunarApplication *application)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), FALSE);
+
+  g_signal_handlers_disconnect_by_func (window, thunar_application_window_drawn, application);
+
+  /* run the deferred initialization as soon as the first frame is done */
+  if (!application->deferred_init_done)
+    {
+      thunar_util_startup_trace ("first frame");
+
+      if (application->deferred_init_id != 0)
+        g_source_remove (application->deferred_init_id);
+      application->deferred_init_id =
+        g_idle_add_full (G_PRIORITY_LOW, thunar_application_deferred_init, application, NULL);
+    }
+
+  return FALSE;
 }
 
 
@@ -398,6 +555,7 @@ static void
 thunar_application_shutdown (GApplication *gapp)
 {
   ThunarApplication *application = THUNAR_APPLICATION (gapp);
+  GList             *lp;
 
   /* unqueue all files waiting to be processed */
   thunar_g_list_free_full (application->files_to_launch);
@@ -425,13 +583,60 @@ thunar_application_shutdown (GApplication *gapp)
   g_slist_free_full (application->volman_udis, g_free);
 
   /* disconnect from the udev client */
-  g_object_unref (application->udev_client);
+  if (application->udev_client != NULL)
+    g_object_unref (application->udev_client);
 #endif
 
+  /* drop the pending deferred initialization */
+  if (G_UNLIKELY (application->deferred_init_id != 0))
+    g_source_remove (application->deferred_init_id);
+
+  if (application->sendto_model != NULL)
+    g_object_unref (application->sendto_model);
+
+  if (application->shortcuts_model != NULL)
+    g_object_unref (application->shortcuts_model);
+
+  if (application->provider_factory != NULL)
+    g_object_unref (application->provider_factory);
+
+  /* forget about the running jobs */
+  for (lp = application->jobs; lp != NULL; lp = lp->next)
+    {
+      g_signal_handlers_disconnect_by_func (lp->data, thunar_application_job_finished, application);
+      g_object_weak_unref (lp->data, thunar_application_job_destroyed, application);
+    }
+  g_list_free (application->jobs);
+  application->jobs = NULL;
+
+  /* destroy the hidden windows */
+  if (G_UNLIKELY (application->window_pool_idle_id != 0))
+    g_source_remove (application->window_pool_idle_id);
+  thunar_application_window_pool_clear (application);
+
   /* drop any running "show dialogs" timer */
   if (G_UNLIKELY (application->show_dialogs_timer_id != 0))
     g_source_remove (application->show_dialogs_timer_id);
 
+  /* release the recently closed folders */
+  thunar_folder_release_retained ();
+
+  /* keep the counted folder sizes for the next session */
+  thunar_size_cache_save ();
+
+  /* wait for the configuration files written in the background */
+  thunar_state_writer_flush ();
+
+  /* drop any pending memory trim */
+  if (G_UNLIKELY (application->trim_memory_idle_id != 0))
+    g_source_remove (application->trim_memory_idle_id);
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+  /* stop watching the memory pressure */
+  g_signal_handlers_disconnect_by_func (application->memory_monitor, thunar_application_low_memory_warning, application);
+  g_object_unref (application->memory_monitor);
+#endif
+
   /* drop ref on the thumbnailer */
   if (application->thumbnailer != NULL)
     g_object_unref (application->thumbnailer);
@@ -441,6 +646,7 @@ thunar_application_shutdown (GApplication *gapp)
     g_object_unref (G_OBJECT (application->thumbnail_cache));
 
   /* disconnect from the preferences */
+  g_signal_handlers_disconnect_by_func (application->preferences, thunar_application_window_pool_schedule, application);
   g_object_unref (G_OBJECT (application->preferences));
 
   /* disconnect from the session manager */
@@ -465,6 +671,27 @@ thunar_application_finalize (GObject *object)
 
 
 
+static void
+thunar_application_window_removed (GtkApplication *gtk_application,
+                                   GtkWindow      *window)
+{
+  ThunarApplication *application = THUNAR_APPLICATION (gtk_application);
+
+  (*GTK_APPLICATION_CLASS (thunar_application_parent_class)->window_removed) (gtk_application, window);
+
+  /* a daemon without windows does not need the caches until the next
+   * window is opened, trim them once the window released its folders */
+  if (application->daemon
+      && gtk_application_get_windows (gtk_application) == NULL
+      && application->trim_memory_idle_id == 0)
+    {
+      application->trim_memory_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_application_trim_memory,
+                                                          application, NULL);
+    }
+}
+
+
+
 static int
 thunar_application_handle_local_options (GApplication *gapp,
                                          GVariantDict *options)
@@ -660,22 +887,57 @@ thunar_application_set_property (GObject      *object,
 
 
 
+static void
+thunar_application_accel_map_print (gpointer        data,
+                                    const gchar    *accel_path,
+                                    guint           accel_key,
+                                    GdkModifierType accel_mods,
+                                    gboolean        changed)
+{
+  GString *contents = data;
+  gchar   *escaped_path;
+  gchar   *escaped_name;
+  gchar   *name;
+
+  /* the same format as gtk_accel_map_save() */
+  name = gtk_accelerator_name (accel_key, accel_mods);
+  escaped_path = g_strescape (accel_path, NULL);
+  escaped_name = g_strescape (name, NULL);
+  g_string_append_printf (contents, "%s(gtk_accel_path \"%s\" \"%s\")\n",
+                          changed ? "" : "; ", escaped_path, escaped_name);
+  g_free (escaped_name);
+  g_free (escaped_path);
+  g_free (name);
+}
+
+
+
 static gboolean
 thunar_application_accel_map_save (gpointer user_data)
 {
   ThunarApplication *application = THUNAR_APPLICATION (user_data);
+  GString           *contents;
+  GBytes            *bytes;
   gchar             *path;
 
   _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), FALSE);
 
   application->accel_map_save_id = 0;
 
-  /* save the current accel map */
+  /* save the current accel map, the file is written in the background */
   path = xfce_resource_save_location (XFCE_RESOURCE_CONFIG, ACCEL_MAP_PATH, TRUE);
   if (G_LIKELY (path != NULL))
     {
-      /* save the accel map */
-      gtk_accel_map_save (path);
+      contents = g_string_new (NULL);
+      g_string_append_printf (contents, "; %s GtkAccelMap rc-file         -*- scheme -*-\n"
+                                        "; this file is an automated accelerator map dump\n"
+                                        ";\n", g_get_prgname () != NULL ? g_get_prgname () : "");
+      gtk_accel_map_foreach (contents, thunar_application_accel_map_print);
+
+      bytes = g_bytes_new_take (contents->str, contents->len);
+      g_string_free (contents, FALSE);
+      thunar_state_writer_schedule (path, bytes, 0, NULL, NULL);
+      g_bytes_unref (bytes);
       g_free (path);
     }
 
@@ -793,7 +1055,7 @@ thunar_application_launch_finished (ThunarJob  *job,
                   /* If the folder is connected to a folder monitor, we dont need to trigger the reload manually */
                   if (!thunar_folder_has_folder_monitor (folder))
                   {
-                    thunar_folder_reload (folder, FALSE);
+                    thunar_folder_refresh (folder);
                   }
                   g_object_unref (folder);
                 }
@@ -819,67 +1081,54 @@ thunar_application_launch (ThunarApplication *application,
                            gboolean           update_target_folders,
                            GClosure          *new_files_closure)
 {
-  GtkWidget *dialog;
-  GdkScreen *screen;
   ThunarJob *job;
-  GList     *parent_folder_list = NULL;
-  gboolean   has_jobs;
+  GList     *changed_file_list = NULL;
 
   _thunar_return_if_fail (parent == NULL || GDK_IS_SCREEN (parent) || GTK_IS_WIDGET (parent));
 
-  /* parse the parent pointer */
-  screen = thunar_util_parse_parent (parent, NULL);
-
   /* try to allocate a new job for the operation */
   job = (*launcher) (source_file_list, target_file_list);
 
   if (update_source_folders)
-    parent_folder_list = g_list_concat (parent_folder_list, thunar_g_file_list_get_parents (source_file_list));
+    changed_file_list = g_list_concat (changed_file_list, g_list_copy (source_file_list));
   if (update_target_folders)
-    parent_folder_list = g_list_concat (parent_folder_list, thunar_g_file_list_get_parents (target_file_list));
-
-  /* connect a callback to instantly refresh the parent folders after the operation finished */
-  g_signal_connect (G_OBJECT (job), "finished",
-                    G_CALLBACK (thunar_application_launch_finished),
-                    parent_folder_list);
+    changed_file_list = g_list_concat (changed_file_list, g_list_copy (target_file_list));
 
   /* connect the "new-files" closure (if any) */
   if (G_LIKELY (new_files_closure != NULL))
     g_signal_connect_closure (job, "new-files", new_files_closure, FALSE);
 
-  /* get the shared progress dialog */
-  dialog = thunar_application_get_progress_dialog (application);
+  /* show the job in the progress dialog */
+  thunar_application_launch_job (application, parent, job, icon_name, title, changed_file_list);
 
-  /* place the dialog on the given screen */
-  if (screen != NULL)
-    gtk_window_set_screen (GTK_WINDOW (dialog), screen);
+  /* drop our reference on the job */
+  g_list_free (changed_file_list);
+  g_object_unref (job);
+}
 
-  has_jobs = thunar_progress_dialog_has_jobs (THUNAR_PROGRESS_DIALOG (dialog));
 
-  /* add the job to the dialog */
-  thunar_progress_dialog_add_job (THUNAR_PROGRESS_DIALOG (dialog),
-                                  job, icon_name, title);
 
-  if (has_jobs)
-    {
-      /* show the dialog immediately */
-      thunar_application_show_dialogs (application);
-    }
-  else
-    {
-      /* Set up a timer to show the dialog, to make sure we don't
-       * just popup and destroy a dialog for a very short job.
-       */
-      if (G_LIKELY (application->show_dialogs_timer_id == 0))
-        {
-          application->show_dialogs_timer_id =
-            gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT, 750, thunar_application_show_dialogs,
-                                          application, thunar_application_show_dialogs_destroy);
-        }
-    }
+static void
+thunar_application_job_finished (ThunarJob         *job,
+                                 ThunarApplication *application)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
 
-  /* drop our reference on the job */
-  g_object_unref (job);
+  g_signal_handlers_disconnect_by_func (job, thunar_application_job_finished, application);
+  g_object_weak_unref (G_OBJECT (job), thunar_application_job_destroyed, application);
+  application->jobs = g_list_remove (application->jobs, job);
+}
+
+
+
+static void
+thunar_application_job_destroyed (gpointer  user_data,
+                                  GObject  *where_the_job_was)
+{
+  ThunarApplication *application = THUNAR_APPLICATION (user_data);
+
+  application->jobs = g_list_remove (application->jobs, where_the_job_was);
 }
 
 
@@ -1058,6 +1307,48 @@ thunar_application_volman_watch_destroy (gpointer user_data)
 
 
 
+static gboolean
+thunar_application_trim_memory (gpointer user_data)
+{
+  ThunarApplication *application = THUNAR_APPLICATION (user_data);
+  ThunarIconFactory *icon_factory;
+
+  application->trim_memory_idle_id = 0;
+
+  /* folders in use stay loaded, only the caches kept around to speed
+   * up the next visit are dropped */
+  thunar_folder_release_retained ();
+
+  icon_factory = thunar_icon_factory_get_default ();
+  thunar_icon_factory_trim (icon_factory);
+  g_object_unref (icon_factory);
+
+  thunar_thumbnail_index_clear ();
+  thunar_desktop_entry_cache_clear ();
+  thunar_size_cache_clear ();
+  thunar_file_cache_trim ();
+
+  return FALSE;
+}
+
+
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+static void
+thunar_application_low_memory_warning (GMemoryMonitor             *monitor,
+                                       GMemoryMonitorWarningLevel  level,
+                                       ThunarApplication          *application)
+{
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+
+  /* trim from an idle, the warning may arrive in the middle of a sort */
+  if (application->trim_memory_idle_id == 0)
+    application->trim_memory_idle_id = g_idle_add (thunar_application_trim_memory, application);
+}
+#endif
+
+
+
 static gboolean
 thunar_application_show_dialogs (gpointer user_data)
 {
@@ -1164,6 +1455,9 @@ thunar_application_set_daemon (ThunarApplication *application,
         g_application_hold (G_APPLICATION (application));
       else
         g_application_release (G_APPLICATION (application));
+
+      /* keep windows ready while in daemon mode */
+      thunar_application_window_pool_schedule (application);
     }
 }
 
@@ -1237,6 +1531,104 @@ thunar_application_has_windows (ThunarApplication *application)
 
 
 
+static GtkWidget *
+thunar_application_new_window (GdkScreen *screen)
+{
+  GtkWidget *window;
+  gchar     *role;
+
+  /* generate a unique role for the new window (for session management) */
+  role = g_strdup_printf ("Thunar-%u-%u", (guint) time (NULL), (guint) g_random_int ());
+
+  /* allocate the window */
+  window = g_object_new (THUNAR_TYPE_WINDOW,
+                         "role", role,
+                         "screen", screen,
+                         NULL);
+
+  /* cleanup */
+  g_free (role);
+
+  return window;
+}
+
+
+
+static void
+thunar_application_window_pool_schedule (ThunarApplication *application)
+{
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+
+  /* the pool is filled or trimmed when there is nothing else to do */
+  if (application->window_pool_idle_id == 0)
+    {
+      application->window_pool_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_application_window_pool_fill,
+                                                          application, NULL);
+    }
+}
+
+
+
+static gboolean
+thunar_application_window_pool_fill (gpointer user_data)
+{
+  ThunarApplication *application = THUNAR_APPLICATION (user_data);
+  GtkWidget         *window;
+  guint              n_windows = 0;
+  guint              length;
+
+  THUNAR_THREADS_ENTER
+
+  /* outside daemon mode there are no hidden windows */
+  if (application->daemon && application->preferences != NULL)
+    g_object_get (G_OBJECT (application->preferences), "misc-daemon-window-pool", &n_windows, NULL);
+
+  /* drop the windows that are too many */
+  length = g_list_length (application->window_pool);
+  while (length > n_windows)
+    {
+      window = application->window_pool->data;
+      application->window_pool = g_list_delete_link (application->window_pool, application->window_pool);
+      gtk_widget_destroy (window);
+      length--;
+    }
+
+  /* build one window per iteration, so the main loop stays responsive */
+  if (length < n_windows)
+    {
+      window = thunar_application_new_window (gdk_screen_get_default ());
+      gtk_widget_realize (window);
+      application->window_pool = g_list_append (application->window_pool, window);
+      length++;
+    }
+
+  THUNAR_THREADS_LEAVE
+
+  if (length < n_windows)
+    return TRUE;
+
+  application->window_pool_idle_id = 0;
+  return FALSE;
+}
+
+
+
+static void
+thunar_application_window_pool_clear (ThunarApplication *application)
+{
+  GList *windows;
+  GList *lp;
+
+  windows = application->window_pool;
+  application->window_pool = NULL;
+
+  for (lp = windows; lp != NULL; lp = lp->next)
+    gtk_widget_destroy (lp->data);
+  g_list_free (windows);
+}
+
+
+
 /**
  * thunar_application_take_window:
  * @application : a #ThunarApplication.
@@ -1269,6 +1661,10 @@ thunar_application_take_window (ThunarApplication *application,
 
   /* add the ourselves to the window */
   gtk_window_set_application (window, GTK_APPLICATION (application));
+
+  /* finish the initialization once the first window is drawn */
+  if (G_UNLIKELY (!application->deferred_init_done))
+    g_signal_connect_after (G_OBJECT (window), "draw", G_CALLBACK (thunar_application_window_drawn), application);
 }
 
 
@@ -1326,17 +1722,27 @@ thunar_application_open_window (ThunarApplication *application,
         }
     }
 
-  /* generate a unique role for the new window (for session management) */
-  role = g_strdup_printf ("Thunar-%u-%u", (guint) time (NULL), (guint) g_random_int ());
+  /* use a window from the pool, which only has to be shown */
+  window = NULL;
+  for (list = application->window_pool; list != NULL; list = list->next)
+    if (gtk_window_get_screen (list->data) == screen)
+      {
+        window = list->data;
+        application->window_pool = g_list_delete_link (application->window_pool, list);
+
+        /* generate a unique role for the new window (for session management) */
+        role = g_strdup_printf ("Thunar-%u-%u", (guint) time (NULL), (guint) g_random_int ());
+        gtk_window_set_role (GTK_WINDOW (window), role);
+        g_free (role);
+
+        /* replace it once the window is up */
+        thunar_application_window_pool_schedule (application);
+        break;
+      }
 
   /* allocate the window */
-  window = g_object_new (THUNAR_TYPE_WINDOW,
-                         "role", role,
-                         "screen", screen,
-                         NULL);
-
-  /* cleanup */
-  g_free (role);
+  if (G_LIKELY (window == NULL))
+    window = thunar_application_new_window (screen);
 
   /* set the startup id */
   if (startup_id != NULL)
@@ -1345,8 +1751,11 @@ thunar_application_open_window (ThunarApplication *application,
   /* hook up the window */
   thunar_application_take_window (application, GTK_WINDOW (window));
 
+  thunar_util_startup_trace ("window created");
+
   /* show the new window */
   gtk_widget_show (window);
+  thunar_util_startup_trace ("window shown");
 
   /* change the directory */
   if (directory != NULL)
@@ -1926,6 +2335,142 @@ thunar_application_create_file_from_template (ThunarApplication *application,
 
 
 
+/**
+ * thunar_application_launch_job:
+ * @application       : a #ThunarApplication.
+ * @parent            : a #GdkScreen, a #GtkWidget or %NULL.
+ * @job               : the #ThunarJob to show.
+ * @icon_name         : the name of the icon for the progress dialog.
+ * @title             : the title for the progress dialog.
+ * @changed_file_list : the #GFile<!---->s changed by @job, whose parent
+ *                      folders are reloaded once @job is finished, or %NULL.
+ *
+ * Adds @job, which was created by one of the thunar_io_jobs functions, to
+ * the shared progress dialog of @application, just like the operations
+ * launched by @application itself. The caller keeps its reference on @job.
+ **/
+void
+thunar_application_launch_job (ThunarApplication *application,
+                               gpointer           parent,
+                               ThunarJob         *job,
+                               const gchar       *icon_name,
+                               const gchar       *title,
+                               GList             *changed_file_list)
+{
+  GtkWidget *dialog;
+  GdkScreen *screen;
+  gboolean   has_jobs;
+
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+  _thunar_return_if_fail (parent == NULL || GDK_IS_SCREEN (parent) || GTK_IS_WIDGET (parent));
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  /* parse the parent pointer */
+  screen = thunar_util_parse_parent (parent, NULL);
+
+  /* connect a callback to instantly refresh the parent folders after the operation finished */
+  g_signal_connect (G_OBJECT (job), "finished",
+                    G_CALLBACK (thunar_application_launch_finished),
+                    thunar_g_file_list_get_parents (changed_file_list));
+
+  /* remember the job until it is finished, see thunar_application_get_jobs() */
+  if (G_UNLIKELY (++application->last_job_id == 0))
+    ++application->last_job_id;
+  g_object_set_qdata (G_OBJECT (job), thunar_application_job_id_quark, GUINT_TO_POINTER (application->last_job_id));
+  g_object_set_qdata_full (G_OBJECT (job), thunar_application_job_title_quark, g_strdup (title), g_free);
+  g_object_weak_ref (G_OBJECT (job), thunar_application_job_destroyed, application);
+  g_signal_connect (G_OBJECT (job), "finished", G_CALLBACK (thunar_application_job_finished), application);
+  application->jobs = g_list_prepend (application->jobs, job);
+
+  /* get the shared progress dialog */
+  dialog = thunar_application_get_progress_dialog (application);
+
+  /* place the dialog on the given screen */
+  if (screen != NULL)
+    gtk_window_set_screen (GTK_WINDOW (dialog), screen);
+
+  has_jobs = thunar_progress_dialog_has_jobs (THUNAR_PROGRESS_DIALOG (dialog));
+
+  /* add the job to the dialog */
+  thunar_progress_dialog_add_job (THUNAR_PROGRESS_DIALOG (dialog),
+                                  job, icon_name, title);
+
+  if (has_jobs)
+    {
+      /* show the dialog immediately */
+      thunar_application_show_dialogs (application);
+    }
+  else
+    {
+      /* Set up a timer to show the dialog, to make sure we don't
+       * just popup and destroy a dialog for a very short job.
+       */
+      if (G_LIKELY (application->show_dialogs_timer_id == 0))
+        {
+          application->show_dialogs_timer_id =
+            gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT, 750, thunar_application_show_dialogs,
+                                          application, thunar_application_show_dialogs_destroy);
+        }
+    }
+}
+
+
+
+/**
+ * thunar_application_get_jobs:
+ * @application : a #ThunarApplication.
+ *
+ * Returns the #ThunarJob<!---->s added with thunar_application_launch_job()
+ * that did not finish yet. The list is owned by @application and holds
+ * no references on the jobs.
+ *
+ * Return value: the list of running #ThunarJob<!---->s.
+ **/
+GList *
+thunar_application_get_jobs (ThunarApplication *application)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), NULL);
+  return application->jobs;
+}
+
+
+
+/**
+ * thunar_application_get_job_id:
+ * @application : a #ThunarApplication.
+ * @job         : a #ThunarJob from thunar_application_get_jobs().
+ *
+ * Return value: the unique id @application assigned to @job.
+ **/
+guint
+thunar_application_get_job_id (ThunarApplication *application,
+                               ThunarJob         *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), 0);
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), 0);
+  return GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (job), thunar_application_job_id_quark));
+}
+
+
+
+/**
+ * thunar_application_get_job_title:
+ * @application : a #ThunarApplication.
+ * @job         : a #ThunarJob from thunar_application_get_jobs().
+ *
+ * Return value: the title of @job in the progress dialog.
+ **/
+const gchar *
+thunar_application_get_job_title (ThunarApplication *application,
+                                  ThunarJob         *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), NULL);
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
+  return g_object_get_qdata (G_OBJECT (job), thunar_application_job_title_quark);
+}
+
+
+
 /**
  * thunar_application_copy_to:
  * @application       : a #ThunarApplication.
@@ -2028,6 +2573,53 @@ thunar_application_copy_into (ThunarApplication *application,
 
 
 
+/**
+ * thunar_application_update_into:
+ * @application       : a #ThunarApplication.
+ * @parent            : a #GdkScreen, a #GtkWidget or %NULL.
+ * @source_file_list  : the list of #GFile<!---->s that should be copied.
+ * @target_file       : the #GFile to the target directory.
+ * @new_files_closure : a #GClosure to connect to the job's "new-files" signal,
+ *                      which will be emitted when the job finishes with the
+ *                      list of #GFile<!---->s created by the job, or
+ *                      %NULL if you're not interested in the signal.
+ *
+ * Copies all files referenced by the @source_file_list to the directory
+ * referenced by @target_file, like thunar_application_copy_into(), but
+ * files which already exist there with the same size and modification
+ * time are skipped and other existing files are replaced without asking.
+ **/
+void
+thunar_application_update_into (ThunarApplication *application,
+                                gpointer           parent,
+                                GList             *source_file_list,
+                                GFile             *target_file,
+                                GClosure          *new_files_closure)
+{
+  gchar *display_name;
+  gchar *title;
+
+  _thunar_return_if_fail (parent == NULL || GDK_IS_SCREEN (parent) || GTK_IS_WIDGET (parent));
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+  _thunar_return_if_fail (G_IS_FILE (target_file));
+
+  /* generate a title for the progress dialog */
+  display_name = thunar_file_cached_display_name (target_file);
+  title = g_strdup_printf (_("Updating files in \"%s\"..."), display_name);
+  g_free (display_name);
+
+  /* collect the target files and launch the job */
+  thunar_application_collect_and_launch (application, parent, "edit-copy",
+                                         title, thunar_io_jobs_update_files,
+                                         source_file_list, target_file,
+                                         FALSE, TRUE,
+                                         new_files_closure);
+
+  g_free (title);
+}
+
+
+
 /**
  * thunar_application_link_into:
  * @application       : a #ThunarApplication.
@@ -2140,6 +2732,15 @@ unlink_stub (GList *source_path_list,
 
 
 
+static ThunarJob *
+empty_trash_stub (GList *source_path_list,
+                  GList *target_path_list)
+{
+  return thunar_io_jobs_empty_trash (source_path_list->data);
+}
+
+
+
 /**
  * thunar_application_unlink_files:
  * @application : a #ThunarApplication.
@@ -2418,7 +3019,7 @@ thunar_application_empty_trash (ThunarApplication *application,
       /* launch the operation */
       thunar_application_launch (application, parent, "user-trash",
                                  _("Emptying the Trash..."),
-                                 unlink_stub, &file_list, NULL, TRUE, FALSE, NULL);
+                                 empty_trash_stub, &file_list, NULL, TRUE, FALSE, NULL);
 
       /* cleanup */
       g_object_unref (file_list.data);
@@ -2471,12 +3072,14 @@ thunar_application_restore_files (ThunarApplication *application,
       /* TODO we might have to distinguish between URIs and paths here */
       target_path = g_file_new_for_commandline_arg (original_uri);
 
-      source_path_list = thunar_g_list_append_deep (source_path_list, thunar_file_get_file (lp->data));
-      target_path_list = thunar_g_list_append_deep (target_path_list, target_path);
-
-      g_object_unref (target_path);
+      /* prepend, appending gets slow when restoring many files */
+      source_path_list = g_list_prepend (source_path_list, g_object_ref (thunar_file_get_file (lp->data)));
+      target_path_list = g_list_prepend (target_path_list, target_path);
     }
 
+  source_path_list = g_list_reverse (source_path_list);
+  target_path_list = g_list_reverse (target_path_list);
+
   if (G_UNLIKELY (err != NULL))
     {
       /* display an error dialog */
@@ -2499,6 +3102,36 @@ thunar_application_restore_files (ThunarApplication *application,
 
 
 
+/**
+ * thunar_application_make_thumbnails:
+ * @application : a #ThunarApplication.
+ * @parent      : a #GdkScreen, a #GtkWidget or %NULL.
+ * @folder_list : the #GFile<!---->s of the folders.
+ * @recursive   : whether to include the subfolders.
+ *
+ * Generates the thumbnails of the files in @folder_list in the
+ * background, see thunar_io_jobs_make_thumbnails().
+ **/
+void
+thunar_application_make_thumbnails (ThunarApplication *application,
+                                    gpointer           parent,
+                                    GList             *folder_list,
+                                    gboolean           recursive)
+{
+  ThunarJob *job;
+
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+  _thunar_return_if_fail (parent == NULL || GDK_IS_SCREEN (parent) || GTK_IS_WIDGET (parent));
+  _thunar_return_if_fail (folder_list != NULL);
+
+  job = thunar_io_jobs_make_thumbnails (folder_list, recursive);
+  thunar_application_launch_job (application, parent, job, "image-x-generic",
+                                 _("Generating thumbnails..."), NULL);
+  g_object_unref (job);
+}
+
+
+
 ThunarThumbnailCache *
 thunar_application_get_thumbnail_cache (ThunarApplication *application)
 {
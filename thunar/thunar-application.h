@@ -23,6 +23,7 @@
 #ifndef __THUNAR_APPLICATION_H__
 #define __THUNAR_APPLICATION_H__
 
+#include <thunar/thunar-job.h>
 #include <thunar/thunar-window.h>
 #include <thunar/thunar-thumbnail-cache.h>
 
@@ -97,6 +98,21 @@ void                  thunar_application_create_file_from_template (ThunarApplic
                                                                     ThunarFile        *template_file,
                                                                     GdkScreen         *screen,
                                                                     const gchar       *startup_id);
+void                  thunar_application_launch_job                (ThunarApplication *application,
+                                                                    gpointer           parent,
+                                                                    ThunarJob         *job,
+                                                                    const gchar       *icon_name,
+                                                                    const gchar       *title,
+                                                                    GList             *changed_file_list);
+
+GList                *thunar_application_get_jobs                  (ThunarApplication *application);
+
+guint                 thunar_application_get_job_id                (ThunarApplication *application,
+                                                                    ThunarJob         *job);
+
+const gchar          *thunar_application_get_job_title             (ThunarApplication *application,
+                                                                    ThunarJob         *job);
+
 void                  thunar_application_copy_to                   (ThunarApplication *application,
                                                                     gpointer           parent,
                                                                     GList             *source_file_list,
@@ -109,6 +125,12 @@ void                  thunar_application_copy_into                 (ThunarApplic
                                                                     GFile             *target_file,
                                                                     GClosure          *new_files_closure);
 
+void                  thunar_application_update_into               (ThunarApplication *application,
+                                                                    gpointer           parent,
+                                                                    GList             *source_file_list,
+                                                                    GFile             *target_file,
+                                                                    GClosure          *new_files_closure);
+
 void                  thunar_application_link_into                 (ThunarApplication *application,
                                                                     gpointer           parent,
                                                                     GList             *source_file_list,
@@ -150,6 +172,11 @@ void                  thunar_application_restore_files             (ThunarApplic
                                                                     GList             *trash_file_list,
                                                                     GClosure          *new_files_closure);
 
+void                  thunar_application_make_thumbnails           (ThunarApplication *application,
+                                                                    gpointer           parent,
+                                                                    GList             *folder_list,
+                                                                    gboolean           recursive);
+
 ThunarThumbnailCache *thunar_application_get_thumbnail_cache       (ThunarApplication *application);
 
 G_END_DECLS;
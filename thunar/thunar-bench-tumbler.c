@@ -0,0 +1,615 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A mock of the thumbnailer and thumbnail cache services of tumbler,
+ * to measure the share of Thunar in the thumbnail pipeline without
+ * depending on the thumbnailers installed. It renders one URI per
+ * latency period, foreground requests before background ones, and
+ * fails a fixed share of them, deterministically for the same calls.
+ * No thumbnail is written, so the files just get their ready state.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-bench-tumbler.h>
+#include <thunar/thunar-thumbnail-cache-proxy.h>
+#include <thunar/thunar-thumbnailer-proxy.h>
+
+
+
+#define BENCH_TUMBLER_SEED (0x7468756e)
+
+
+
+typedef struct
+{
+  guint    handle;
+  gchar  **uris;
+  guint    n_done;
+  gint64   queue_time;
+  gboolean started;
+}
+BenchTumblerRequest;
+
+struct _BenchTumbler
+{
+  GDBusConnection          *connection;
+  ThunarThumbnailerDBus    *thumbnailer;
+  ThunarThumbnailCacheDBus *cache;
+  guint                     thumbnailer_owner_id;
+  guint                     cache_owner_id;
+  guint                     filter_id;
+  guint                     n_names;
+  gboolean                  name_lost;
+  gboolean                  ready;
+
+  gchar                   **mime_types;
+  guint                     latency_ms;
+  guint                     failure_percent;
+  GRand                    *rand;
+
+  /* requests of the foreground and background schedulers */
+  GQueue                    foreground;
+  GQueue                    background;
+  guint                     next_handle;
+  guint                     render_id;
+
+  BenchTumblerRenderFunc    render_func;
+  gpointer                  render_data;
+
+  BenchTumblerStats         stats;
+  gint                      messages;
+  GHashTable               *rendered;
+};
+
+
+
+static void
+bench_tumbler_request_free (BenchTumblerRequest *request)
+{
+  g_strfreev (request->uris);
+  g_slice_free (BenchTumblerRequest, request);
+}
+
+
+
+static BenchTumblerRequest *
+bench_tumbler_steal_request (BenchTumbler *tumbler,
+                             guint         handle)
+{
+  BenchTumblerRequest *request;
+  GQueue              *queues[2] = { &tumbler->foreground, &tumbler->background };
+  GList               *lp;
+  guint                n;
+
+  for (n = 0; n < G_N_ELEMENTS (queues); ++n)
+    for (lp = queues[n]->head; lp != NULL; lp = lp->next)
+      {
+        request = lp->data;
+        if (request->handle == handle)
+          {
+            g_queue_delete_link (queues[n], lp);
+            return request;
+          }
+      }
+
+  return NULL;
+}
+
+
+
+static void
+bench_tumbler_dequeue (BenchTumbler *tumbler,
+                       guint         handle)
+{
+  BenchTumblerRequest *request;
+
+  request = bench_tumbler_steal_request (tumbler, handle);
+  if (request == NULL)
+    return;
+
+  tumbler->stats.dequeued_uris += g_strv_length (request->uris) - request->n_done;
+
+  /* tumbler finishes dequeued requests as well */
+  thunar_thumbnailer_dbus_emit_finished (tumbler->thumbnailer, request->handle);
+  bench_tumbler_request_free (request);
+}
+
+
+
+static gboolean
+bench_tumbler_render (gpointer user_data)
+{
+  BenchTumbler        *tumbler = user_data;
+  BenchTumblerRequest *request;
+  const gchar         *uris[2] = { NULL, NULL };
+  gint64               latency;
+  GQueue              *queue;
+
+  queue = !g_queue_is_empty (&tumbler->foreground) ? &tumbler->foreground : &tumbler->background;
+  request = g_queue_peek_head (queue);
+  if (request == NULL)
+    {
+      tumbler->render_id = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  if (!request->started)
+    {
+      request->started = TRUE;
+      thunar_thumbnailer_dbus_emit_started (tumbler->thumbnailer, request->handle);
+    }
+
+  uris[0] = request->uris[request->n_done++];
+
+  latency = g_get_monotonic_time () - request->queue_time;
+  g_array_append_val (tumbler->stats.latencies, latency);
+
+  /* rendering the same file twice is wasted work of Thunar */
+  if (g_hash_table_contains (tumbler->rendered, uris[0]))
+    tumbler->stats.duplicate_renders++;
+  else
+    g_hash_table_add (tumbler->rendered, g_strdup (uris[0]));
+
+  tumbler->stats.renders++;
+  if (tumbler->render_func != NULL)
+    (*tumbler->render_func) (uris[0], tumbler->render_data);
+
+  if ((guint) g_rand_int_range (tumbler->rand, 0, 100) < tumbler->failure_percent)
+    {
+      tumbler->stats.failures++;
+      thunar_thumbnailer_dbus_emit_error (tumbler->thumbnailer, request->handle, uris,
+                                          1, "Mock thumbnailer failure");
+    }
+  else
+    {
+      thunar_thumbnailer_dbus_emit_ready (tumbler->thumbnailer, request->handle, uris);
+    }
+
+  if (request->uris[request->n_done] == NULL)
+    {
+      g_queue_pop_head (queue);
+      thunar_thumbnailer_dbus_emit_finished (tumbler->thumbnailer, request->handle);
+      bench_tumbler_request_free (request);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_queue (ThunarThumbnailerDBus *skeleton,
+                            GDBusMethodInvocation *invocation,
+                            const gchar *const    *uris,
+                            const gchar *const    *mime_hints,
+                            const gchar           *flavor,
+                            const gchar           *scheduler,
+                            guint                  handle_to_unqueue,
+                            BenchTumbler          *tumbler)
+{
+  BenchTumblerRequest *request;
+
+  tumbler->stats.queue_calls++;
+
+  if (handle_to_unqueue != 0)
+    bench_tumbler_dequeue (tumbler, handle_to_unqueue);
+
+  request = g_slice_new0 (BenchTumblerRequest);
+  request->handle = ++tumbler->next_handle;
+  request->uris = g_strdupv ((gchar **) uris);
+  request->queue_time = g_get_monotonic_time ();
+
+  thunar_thumbnailer_dbus_complete_queue (skeleton, invocation, request->handle);
+
+  if (request->uris[0] == NULL)
+    {
+      thunar_thumbnailer_dbus_emit_finished (tumbler->thumbnailer, request->handle);
+      bench_tumbler_request_free (request);
+      return TRUE;
+    }
+
+  if (g_strcmp0 (scheduler, "background") == 0)
+    g_queue_push_tail (&tumbler->background, request);
+  else
+    g_queue_push_tail (&tumbler->foreground, request);
+
+  if (tumbler->render_id == 0)
+    {
+      if (tumbler->latency_ms > 0)
+        tumbler->render_id = g_timeout_add (tumbler->latency_ms, bench_tumbler_render, tumbler);
+      else
+        tumbler->render_id = g_idle_add (bench_tumbler_render, tumbler);
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_dequeue (ThunarThumbnailerDBus *skeleton,
+                              GDBusMethodInvocation *invocation,
+                              guint                  handle,
+                              BenchTumbler          *tumbler)
+{
+  tumbler->stats.dequeue_calls++;
+  bench_tumbler_dequeue (tumbler, handle);
+  thunar_thumbnailer_dbus_complete_dequeue (skeleton, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_get_supported (ThunarThumbnailerDBus *skeleton,
+                                    GDBusMethodInvocation *invocation,
+                                    BenchTumbler          *tumbler)
+{
+  gchar **schemes;
+  guint   n;
+
+  /* the schemes and types are pairs */
+  schemes = g_new0 (gchar *, g_strv_length (tumbler->mime_types) + 1);
+  for (n = 0; tumbler->mime_types[n] != NULL; ++n)
+    schemes[n] = (gchar *) "file";
+
+  thunar_thumbnailer_dbus_complete_get_supported (skeleton, invocation,
+                                                  (const gchar *const *) schemes,
+                                                  (const gchar *const *) tumbler->mime_types);
+  g_free (schemes);
+
+  tumbler->ready = TRUE;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_get_schedulers (ThunarThumbnailerDBus *skeleton,
+                                     GDBusMethodInvocation *invocation,
+                                     BenchTumbler          *tumbler)
+{
+  const gchar *schedulers[] = { "foreground", "background", NULL };
+
+  thunar_thumbnailer_dbus_complete_get_schedulers (skeleton, invocation, schedulers);
+
+  return TRUE;
+}
+
+
+
+static void
+bench_tumbler_cache_call (BenchTumbler       *tumbler,
+                          const gchar *const *uris)
+{
+  tumbler->stats.cache_calls++;
+  tumbler->stats.cache_uris += g_strv_length ((gchar **) uris);
+  tumbler->stats.last_cache_time = g_get_monotonic_time ();
+}
+
+
+
+static gboolean
+bench_tumbler_handle_move (ThunarThumbnailCacheDBus *skeleton,
+                           GDBusMethodInvocation    *invocation,
+                           const gchar *const       *from_uris,
+                           const gchar *const       *to_uris,
+                           BenchTumbler             *tumbler)
+{
+  bench_tumbler_cache_call (tumbler, from_uris);
+  thunar_thumbnail_cache_dbus_complete_move (skeleton, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_copy (ThunarThumbnailCacheDBus *skeleton,
+                           GDBusMethodInvocation    *invocation,
+                           const gchar *const       *from_uris,
+                           const gchar *const       *to_uris,
+                           BenchTumbler             *tumbler)
+{
+  bench_tumbler_cache_call (tumbler, from_uris);
+  thunar_thumbnail_cache_dbus_complete_copy (skeleton, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_delete (ThunarThumbnailCacheDBus *skeleton,
+                             GDBusMethodInvocation    *invocation,
+                             const gchar *const       *uris,
+                             BenchTumbler             *tumbler)
+{
+  bench_tumbler_cache_call (tumbler, uris);
+  thunar_thumbnail_cache_dbus_complete_delete (skeleton, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_tumbler_handle_cleanup (ThunarThumbnailCacheDBus *skeleton,
+                              GDBusMethodInvocation    *invocation,
+                              const gchar *const       *base_uris,
+                              guint                     since,
+                              BenchTumbler             *tumbler)
+{
+  bench_tumbler_cache_call (tumbler, base_uris);
+  thunar_thumbnail_cache_dbus_complete_cleanup (skeleton, invocation);
+
+  return TRUE;
+}
+
+
+
+static GDBusMessage *
+bench_tumbler_filter (GDBusConnection *connection,
+                      GDBusMessage    *message,
+                      gboolean         incoming,
+                      gpointer         user_data)
+{
+  BenchTumbler *tumbler = user_data;
+
+  /* every call and signal is received once, by the service or by Thunar */
+  if (incoming)
+    g_atomic_int_inc (&tumbler->messages);
+
+  return message;
+}
+
+
+
+static void
+bench_tumbler_name_acquired (GDBusConnection *connection,
+                             const gchar     *name,
+                             gpointer         user_data)
+{
+  BenchTumbler *tumbler = user_data;
+
+  tumbler->n_names++;
+}
+
+
+
+static void
+bench_tumbler_name_lost (GDBusConnection *connection,
+                         const gchar     *name,
+                         gpointer         user_data)
+{
+  BenchTumbler *tumbler = user_data;
+
+  tumbler->name_lost = TRUE;
+}
+
+
+
+/**
+ * bench_tumbler_new:
+ * @mime_types      : the content types the service claims to support.
+ * @latency_ms      : the time to render one thumbnail.
+ * @failure_percent : the share of thumbnails that fail.
+ * @error           : return location for errors or %NULL.
+ *
+ * Exports the mock services on the session bus and waits until they
+ * own the names of tumbler. Start a private bus first, for example
+ * with #GTestDBus, so a running tumbler does not get in the way.
+ *
+ * Return value: the mock services, or %NULL on @error.
+ **/
+BenchTumbler *
+bench_tumbler_new (const gchar *const *mime_types,
+                   guint               latency_ms,
+                   guint               failure_percent,
+                   GError            **error)
+{
+  BenchTumbler *tumbler;
+
+  tumbler = g_slice_new0 (BenchTumbler);
+  tumbler->mime_types = g_strdupv ((gchar **) mime_types);
+  tumbler->latency_ms = latency_ms;
+  tumbler->failure_percent = failure_percent;
+  tumbler->rand = g_rand_new_with_seed (BENCH_TUMBLER_SEED);
+  tumbler->stats.latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+  tumbler->rendered = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_queue_init (&tumbler->foreground);
+  g_queue_init (&tumbler->background);
+
+  tumbler->connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, error);
+  if (G_UNLIKELY (tumbler->connection == NULL))
+    {
+      bench_tumbler_free (tumbler);
+      return NULL;
+    }
+
+  tumbler->filter_id = g_dbus_connection_add_filter (tumbler->connection, bench_tumbler_filter, tumbler, NULL);
+
+  tumbler->thumbnailer = thunar_thumbnailer_dbus_skeleton_new ();
+  g_signal_connect (tumbler->thumbnailer, "handle-queue", G_CALLBACK (bench_tumbler_handle_queue), tumbler);
+  g_signal_connect (tumbler->thumbnailer, "handle-dequeue", G_CALLBACK (bench_tumbler_handle_dequeue), tumbler);
+  g_signal_connect (tumbler->thumbnailer, "handle-get-supported", G_CALLBACK (bench_tumbler_handle_get_supported), tumbler);
+  g_signal_connect (tumbler->thumbnailer, "handle-get-schedulers", G_CALLBACK (bench_tumbler_handle_get_schedulers), tumbler);
+
+  tumbler->cache = thunar_thumbnail_cache_dbus_skeleton_new ();
+  g_signal_connect (tumbler->cache, "handle-move", G_CALLBACK (bench_tumbler_handle_move), tumbler);
+  g_signal_connect (tumbler->cache, "handle-copy", G_CALLBACK (bench_tumbler_handle_copy), tumbler);
+  g_signal_connect (tumbler->cache, "handle-delete", G_CALLBACK (bench_tumbler_handle_delete), tumbler);
+  g_signal_connect (tumbler->cache, "handle-cleanup", G_CALLBACK (bench_tumbler_handle_cleanup), tumbler);
+
+  if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (tumbler->thumbnailer), tumbler->connection,
+                                         "/org/freedesktop/thumbnails/Thumbnailer1", error)
+      || !g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (tumbler->cache), tumbler->connection,
+                                            "/org/freedesktop/thumbnails/Cache1", error))
+    {
+      bench_tumbler_free (tumbler);
+      return NULL;
+    }
+
+  tumbler->thumbnailer_owner_id = g_bus_own_name_on_connection (tumbler->connection, "org.freedesktop.thumbnails.Thumbnailer1",
+                                                                G_BUS_NAME_OWNER_FLAGS_DO_NOT_QUEUE,
+                                                                bench_tumbler_name_acquired, bench_tumbler_name_lost,
+                                                                tumbler, NULL);
+  tumbler->cache_owner_id = g_bus_own_name_on_connection (tumbler->connection, "org.freedesktop.thumbnails.Cache1",
+                                                          G_BUS_NAME_OWNER_FLAGS_DO_NOT_QUEUE,
+                                                          bench_tumbler_name_acquired, bench_tumbler_name_lost,
+                                                          tumbler, NULL);
+
+  while (tumbler->n_names < 2 && !tumbler->name_lost)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (tumbler->name_lost)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_EXISTS,
+                           "The thumbnailer service names are owned by another process");
+      bench_tumbler_free (tumbler);
+      return NULL;
+    }
+
+  return tumbler;
+}
+
+
+
+void
+bench_tumbler_free (BenchTumbler *tumbler)
+{
+  if (tumbler->render_id != 0)
+    g_source_remove (tumbler->render_id);
+
+  g_queue_foreach (&tumbler->foreground, (GFunc) (void (*)(void)) bench_tumbler_request_free, NULL);
+  g_queue_clear (&tumbler->foreground);
+  g_queue_foreach (&tumbler->background, (GFunc) (void (*)(void)) bench_tumbler_request_free, NULL);
+  g_queue_clear (&tumbler->background);
+
+  if (tumbler->thumbnailer_owner_id != 0)
+    g_bus_unown_name (tumbler->thumbnailer_owner_id);
+  if (tumbler->cache_owner_id != 0)
+    g_bus_unown_name (tumbler->cache_owner_id);
+
+  if (tumbler->thumbnailer != NULL)
+    {
+      g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (tumbler->thumbnailer));
+      g_object_unref (tumbler->thumbnailer);
+    }
+  if (tumbler->cache != NULL)
+    {
+      g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (tumbler->cache));
+      g_object_unref (tumbler->cache);
+    }
+
+  if (tumbler->connection != NULL)
+    {
+      g_dbus_connection_remove_filter (tumbler->connection, tumbler->filter_id);
+      g_object_unref (tumbler->connection);
+    }
+
+  g_hash_table_destroy (tumbler->rendered);
+  g_array_free (tumbler->stats.latencies, TRUE);
+  g_rand_free (tumbler->rand);
+  g_strfreev (tumbler->mime_types);
+  g_slice_free (BenchTumbler, tumbler);
+}
+
+
+
+void
+bench_tumbler_set_render_func (BenchTumbler           *tumbler,
+                               BenchTumblerRenderFunc  func,
+                               gpointer                user_data)
+{
+  tumbler->render_func = func;
+  tumbler->render_data = user_data;
+}
+
+
+
+/**
+ * bench_tumbler_get_ready:
+ * @tumbler : a #BenchTumbler.
+ *
+ * Return value: %TRUE once a client asked for the supported types,
+ *               which ThunarThumbnailer does before it queues files.
+ **/
+gboolean
+bench_tumbler_get_ready (BenchTumbler *tumbler)
+{
+  return tumbler->ready;
+}
+
+
+
+/**
+ * bench_tumbler_get_idle:
+ * @tumbler : a #BenchTumbler.
+ *
+ * Return value: %TRUE if no request is waiting to be rendered.
+ **/
+gboolean
+bench_tumbler_get_idle (BenchTumbler *tumbler)
+{
+  return g_queue_is_empty (&tumbler->foreground) && g_queue_is_empty (&tumbler->background);
+}
+
+
+
+const BenchTumblerStats *
+bench_tumbler_get_stats (BenchTumbler *tumbler)
+{
+  tumbler->stats.messages = g_atomic_int_get (&tumbler->messages);
+
+  return &tumbler->stats;
+}
+
+
+
+/**
+ * bench_tumbler_reset:
+ * @tumbler : a #BenchTumbler.
+ *
+ * Clears the statistics and the rendered files, and restarts the
+ * failures, so the next run sees the same service as the last one.
+ **/
+void
+bench_tumbler_reset (BenchTumbler *tumbler)
+{
+  GArray *latencies = tumbler->stats.latencies;
+
+  g_array_set_size (latencies, 0);
+  memset (&tumbler->stats, 0, sizeof (tumbler->stats));
+  tumbler->stats.latencies = latencies;
+  g_atomic_int_set (&tumbler->messages, 0);
+
+  g_hash_table_remove_all (tumbler->rendered);
+  g_rand_set_seed (tumbler->rand, BENCH_TUMBLER_SEED);
+}
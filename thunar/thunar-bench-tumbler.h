@@ -0,0 +1,66 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_BENCH_TUMBLER_H__
+#define __THUNAR_BENCH_TUMBLER_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _BenchTumbler BenchTumbler;
+
+/* called for every thumbnail the service renders */
+typedef void (*BenchTumblerRenderFunc) (const gchar *uri,
+                                        gpointer     user_data);
+
+typedef struct
+{
+  guint   messages;        /* D-Bus messages received by the process */
+  guint   queue_calls;
+  guint   dequeue_calls;
+  guint   renders;
+  guint   failures;
+  guint   duplicate_renders;
+  guint   dequeued_uris;
+  guint   cache_calls;
+  guint   cache_uris;
+  gint64  last_cache_time; /* monotonic time of the last cache call */
+  GArray *latencies;       /* gint64 µs from Queue to Ready or Error */
+}
+BenchTumblerStats;
+
+BenchTumbler *bench_tumbler_new             (const gchar *const     *mime_types,
+                                             guint                   latency_ms,
+                                             guint                   failure_percent,
+                                             GError                **error);
+void          bench_tumbler_free            (BenchTumbler           *tumbler);
+void          bench_tumbler_set_render_func (BenchTumbler           *tumbler,
+                                             BenchTumblerRenderFunc  func,
+                                             gpointer                user_data);
+gboolean      bench_tumbler_get_ready       (BenchTumbler           *tumbler);
+gboolean      bench_tumbler_get_idle        (BenchTumbler           *tumbler);
+const BenchTumblerStats
+             *bench_tumbler_get_stats       (BenchTumbler           *tumbler);
+void          bench_tumbler_reset           (BenchTumbler           *tumbler);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_BENCH_TUMBLER_H__ */
@@ -0,0 +1,1777 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* thunar-bench generates synthetic folders and measures the hot paths
+ * of Thunar on them without opening any window. Every measurement is
+ * printed as one line of JSON on stdout, so the results of two builds
+ * can be compared by scripts:
+ *
+ *   {"suite":"listing","benchmark":"folder-load","workload":"flat-10000",
+ *    "items":10000,"run":0,"wall_ms":12.345,"heap_bytes":123456,
+ *    "peak_rss_kb":45678}
+ *
+ * The heap bytes are the growth of the allocated heap over the
+ * measurement, if the C library can tell, otherwise -1. The user
+ * preferences are never read, so all runs use the default settings.
+ *
+ * The transfer suite runs the copy, move, delete and trash jobs the
+ * way the file manager does, answering all their questions with yes,
+ * and adds the throughput and the time until the job changed the
+ * target folder first to every line.
+ *
+ * The views suite opens the details, icon and compact views in a
+ * window and scrolls them at a fixed speed, and adds the intervals
+ * of the frame clock and the time spent in thunar_standard_view_draw()
+ * per frame, as 50th and 99th percentiles, to every line. It needs a
+ * display, and a thumbnailer service for the thumbnails; the generated
+ * images are empty, so their thumbnails fail, but they are requested.
+ *
+ * The thumbnails suite runs ThunarThumbnailer and ThunarThumbnailCache
+ * against the mock services of thunar-bench-tumbler.c on a private bus,
+ * with a fixed render latency and failure rate. It scrolls a virtual
+ * view over the files in three patterns and requests the thumbnails
+ * like the views do, and adds the D-Bus messages, the calls, the queue
+ * latency of the thumbnails and the renders wasted on files rendered
+ * twice or scrolled away to every line.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_MALLOC_H
+#include <malloc.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-bench-tumbler.h>
+#include <thunar/thunar-compact-view.h>
+#include <thunar/thunar-details-view.h>
+#include <thunar/thunar-folder.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-gobject-extensions.h>
+#include <thunar/thunar-icon-view.h>
+#include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-job.h>
+#include <thunar/thunar-list-model.h>
+#include <thunar/thunar-navigator.h>
+#include <thunar/thunar-preferences.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-standard-view.h>
+#include <thunar/thunar-thumbnail-cache.h>
+#include <thunar/thunar-thumbnailer.h>
+
+
+
+typedef struct
+{
+  const gchar *suite;
+  const gchar *workload;
+  guint        run;
+  gint64       start_time;
+  gint64       start_heap;
+}
+BenchClock;
+
+typedef struct
+{
+  GMainLoop *loop;
+  gint64     first_change_time;
+  gboolean   failed;
+}
+BenchTransfer;
+
+typedef struct
+{
+  GMainLoop     *loop;
+  GtkAdjustment *adjustment;
+  GArray        *frame_times;
+  GArray        *draw_times;
+  gint64         start_frame_time;
+  gint64         last_frame_time;
+  gint64         refresh_interval;
+  gint64         draw_start_time;
+}
+BenchScroll;
+
+typedef enum
+{
+  BENCH_SCROLL_STEADY,
+  BENCH_SCROLL_FLING,
+  BENCH_SCROLL_JUMPS,
+  BENCH_SCROLL_N_TYPES,
+}
+BenchScrollType;
+
+typedef struct
+{
+  BenchTumbler      *tumbler;
+  ThunarThumbnailer *thumbnailer;
+  GMainLoop         *loop;
+  GRand             *rand;
+
+  /* the files in the order of the view, and their rows plus one */
+  ThunarFile       **files;
+  guint              n_files;
+  GHashTable        *rows;
+
+  /* the virtual view scrolled over the files */
+  BenchScrollType    pattern;
+  gdouble            position;
+  gdouble            velocity;
+  guint              n_ticks;
+  guint              top;
+  guint              visible_request;
+  guint              prefetch_request;
+  guint              offscreen_renders;
+}
+BenchThumbnails;
+
+
+
+/* file name extensions of the generated files, so the type column
+ * has something to sort and the patterns something to match */
+static const gchar *bench_extensions[] =
+{
+  ".txt", ".jpg", ".png", ".c", ".h", ".pdf", ".tar.gz", ".odt", ".mp3", "",
+};
+
+
+
+static gchar    *opt_entries = NULL;
+static gchar    *opt_directory = NULL;
+static gint      opt_runs = 3;
+static gint      opt_depth = 32;
+static gboolean  opt_keep = FALSE;
+static gint      opt_small_files = 10000;
+static gint      opt_huge_files = 4;
+static gint      opt_huge_size = 64;
+static gchar    *opt_cross_directory = NULL;
+static gboolean  opt_trash = FALSE;
+static gint      opt_scroll_speed = 4000;
+static gint      opt_scroll_seconds = 5;
+static gint      opt_window_width = 1024;
+static gint      opt_window_height = 768;
+static gint      opt_visible = 60;
+static gint      opt_thumbnail_latency = 8;
+static gint      opt_thumbnail_failures = 5;
+
+static GOptionEntry option_entries[] =
+{
+  { "entries", 'n', 0, G_OPTION_ARG_STRING, &opt_entries, "Comma separated sizes of the generated folders (default: 10000,100000)", "N,..." },
+  { "depth", 0, 0, G_OPTION_ARG_INT, &opt_depth, "Depth of the generated tree (default: 32)", "N" },
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &opt_runs, "Number of runs of each benchmark (default: 3)", "N" },
+  { "directory", 'd', 0, G_OPTION_ARG_FILENAME, &opt_directory, "Where to generate the folders (default: /dev/shm)", "DIR" },
+  { "keep", 'k', 0, G_OPTION_ARG_NONE, &opt_keep, "Do not remove the generated folders", NULL },
+  { "small-files", 0, 0, G_OPTION_ARG_INT, &opt_small_files, "Number of small files to transfer (default: 10000)", "N" },
+  { "huge-files", 0, 0, G_OPTION_ARG_INT, &opt_huge_files, "Number of huge files to transfer (default: 4)", "N" },
+  { "huge-size", 0, 0, G_OPTION_ARG_INT, &opt_huge_size, "Size of the huge files in MiB (default: 64)", "MIB" },
+  { "cross-directory", 'x', 0, G_OPTION_ARG_FILENAME, &opt_cross_directory, "Folder on another filesystem for cross-device transfers", "DIR" },
+  { "trash", 0, 0, G_OPTION_ARG_NONE, &opt_trash, "Also measure trashing, which leaves the files in the trash", NULL },
+  { "scroll-speed", 0, 0, G_OPTION_ARG_INT, &opt_scroll_speed, "Scroll speed of the views in pixels per second (default: 4000)", "PX" },
+  { "scroll-seconds", 0, 0, G_OPTION_ARG_INT, &opt_scroll_seconds, "Maximum time to scroll each view (default: 5)", "S" },
+  { "width", 0, 0, G_OPTION_ARG_INT, &opt_window_width, "Width of the window of the views (default: 1024)", "PX" },
+  { "height", 0, 0, G_OPTION_ARG_INT, &opt_window_height, "Height of the window of the views (default: 768)", "PX" },
+  { "visible", 0, 0, G_OPTION_ARG_INT, &opt_visible, "Files visible at once when requesting thumbnails (default: 60)", "N" },
+  { "thumbnail-latency", 0, 0, G_OPTION_ARG_INT, &opt_thumbnail_latency, "Time the mock thumbnailer takes per file in ms (default: 8)", "MS" },
+  { "thumbnail-failures", 0, 0, G_OPTION_ARG_INT, &opt_thumbnail_failures, "Share of thumbnails the mock fails in percent (default: 5)", "PERCENT" },
+  { NULL, },
+};
+
+
+
+static gint64
+bench_get_heap (void)
+{
+#ifdef HAVE_MALLINFO
+  struct mallinfo info;
+
+  info = mallinfo ();
+  return (gint64) (guint) info.uordblks + (gint64) (guint) info.hblkhd;
+#else
+  return -1;
+#endif
+}
+
+
+
+static glong
+bench_get_peak_rss (void)
+{
+#if defined(HAVE_GETRUSAGE) && defined(HAVE_SYS_RESOURCE_H)
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+  return -1;
+}
+
+
+
+static void
+bench_start (BenchClock  *clock,
+             const gchar *suite,
+             const gchar *workload,
+             guint        run)
+{
+  clock->suite = suite;
+  clock->workload = workload;
+  clock->run = run;
+  clock->start_heap = bench_get_heap ();
+  clock->start_time = g_get_monotonic_time ();
+}
+
+
+
+static void
+bench_report (BenchClock  *clock,
+              const gchar *benchmark,
+              guint        n_items)
+{
+  gint64 end_time;
+  gint64 heap;
+
+  end_time = g_get_monotonic_time ();
+  heap = bench_get_heap ();
+
+  g_print ("{\"suite\":\"%s\",\"benchmark\":\"%s\",\"workload\":\"%s\","
+           "\"items\":%u,\"run\":%u,\"wall_ms\":%.3f,"
+           "\"heap_bytes\":%" G_GINT64_FORMAT ",\"peak_rss_kb\":%ld}\n",
+           clock->suite, benchmark, clock->workload, n_items, clock->run,
+           (end_time - clock->start_time) / 1000.0,
+           (heap >= 0 && clock->start_heap >= 0) ? heap - clock->start_heap : -1,
+           bench_get_peak_rss ());
+
+  /* the next measurement of the same run starts now */
+  clock->start_heap = bench_get_heap ();
+  clock->start_time = g_get_monotonic_time ();
+}
+
+
+
+static gboolean
+bench_write_file (const gchar *path,
+                  gsize        size)
+{
+  static const gchar block[4096] = { 0, };
+  gsize              n;
+  gint               fd;
+
+  fd = g_open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (G_UNLIKELY (fd < 0))
+    return FALSE;
+
+  for (n = 0; n < size; n += sizeof (block))
+    if (write (fd, block, MIN (sizeof (block), size - n)) < 0)
+      break;
+
+  return (close (fd) == 0 && n >= size);
+}
+
+
+
+static gboolean
+bench_generate_folder (const gchar *path,
+                       guint        n_entries)
+{
+  gboolean created;
+  gchar   *name;
+  gchar   *child;
+  guint    n;
+  guint    number;
+  guint    kind;
+
+  if (g_mkdir_with_parents (path, 0755) != 0)
+    return FALSE;
+
+  for (n = 0; n < n_entries; ++n)
+    {
+      /* shuffle the numbers, so the names are not created sorted */
+      number = (guint) (((guint64) n * 7919) % n_entries);
+      kind = n % 100;
+
+      /* 5% folders, 10% hidden files, 2% symlinks, the rest files */
+      if (kind < 5)
+        name = g_strdup_printf ("Folder %07u", number);
+      else if (kind < 15)
+        name = g_strdup_printf (".hidden-%07u%s", number, bench_extensions[n % G_N_ELEMENTS (bench_extensions)]);
+      else if (kind < 17)
+        name = g_strdup_printf ("link-%07u", number);
+      else
+        name = g_strdup_printf ("%s-%07u%s", (n % 3 == 0) ? "Document" : "file", number,
+                                bench_extensions[n % G_N_ELEMENTS (bench_extensions)]);
+
+      child = g_build_filename (path, name, NULL);
+
+      if (kind < 5)
+        created = (g_mkdir (child, 0755) == 0);
+      else if (kind < 15 || kind >= 17)
+        created = bench_write_file (child, (n % 8 == 0) ? (n * 37) % 65536 : 0);
+      else
+        created = (symlink ("..", child) == 0);
+
+      if (G_UNLIKELY (!created))
+        {
+          g_printerr ("thunar-bench: Failed to create \"%s\": %s\n", child, g_strerror (errno));
+          g_free (child);
+          g_free (name);
+          return FALSE;
+        }
+
+      g_free (child);
+      g_free (name);
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_generate_tree (const gchar *path,
+                     guint        depth,
+                     guint        n_entries)
+{
+  gboolean succeed = TRUE;
+  gchar   *level;
+  gchar   *child;
+  guint    n;
+
+  /* a chain of nested folders with some files in each of them */
+  level = g_strdup (path);
+  for (n = 0; succeed && n < depth; ++n)
+    {
+      succeed = bench_generate_folder (level, n_entries);
+
+      child = g_strdup_printf ("%s%clevel-%02u", level, G_DIR_SEPARATOR, n);
+      g_free (level);
+      level = child;
+    }
+  g_free (level);
+
+  return succeed;
+}
+
+
+
+static void
+bench_remove_tree (const gchar *path)
+{
+  const gchar *name;
+  GDir        *dir;
+  gchar       *child;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          child = g_build_filename (path, name, NULL);
+          if (g_file_test (child, G_FILE_TEST_IS_DIR) && !g_file_test (child, G_FILE_TEST_IS_SYMLINK))
+            bench_remove_tree (child);
+          else
+            g_unlink (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_rmdir (path);
+}
+
+
+
+static ThunarFolder *
+bench_load_folder (const gchar *path)
+{
+  ThunarFolder *folder;
+  ThunarFile   *file;
+  GFile        *gfile;
+
+  gfile = g_file_new_for_path (path);
+  file = thunar_file_get (gfile, NULL);
+  g_object_unref (gfile);
+  if (G_UNLIKELY (file == NULL))
+    return NULL;
+
+  folder = thunar_folder_get_for_file (file);
+  g_object_unref (file);
+  if (G_UNLIKELY (folder == NULL))
+    return NULL;
+
+  /* the files are collected by a job reporting to the main loop */
+  while (thunar_folder_get_loading (folder))
+    g_main_context_iteration (NULL, TRUE);
+
+  return folder;
+}
+
+
+
+static void
+bench_drain_main_loop (void)
+{
+  /* release the files of the previous run before measuring again */
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+}
+
+
+
+static void
+bench_listing_folder (const gchar *path,
+                      const gchar *workload,
+                      guint        run)
+{
+  ThunarListModel *model;
+  ThunarFolder    *folder;
+  BenchClock       clock;
+  GEnumClass      *klass;
+  GEnumValue      *value;
+  GList           *paths;
+  gchar           *benchmark;
+  guint            n_files;
+  gint             column;
+
+  bench_drain_main_loop ();
+  bench_start (&clock, "listing", workload, run);
+
+  folder = bench_load_folder (path);
+  if (G_UNLIKELY (folder == NULL))
+    {
+      g_printerr ("thunar-bench: Failed to load \"%s\"\n", path);
+      return;
+    }
+
+  n_files = g_list_length (thunar_folder_get_files (folder));
+  bench_report (&clock, "folder-load", n_files);
+
+  model = thunar_list_model_new ();
+  thunar_list_model_set_folder (model, folder);
+  bench_report (&clock, "model-insert", n_files);
+
+  /* sort by every column the views can show */
+  klass = g_type_class_ref (THUNAR_TYPE_COLUMN);
+  for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+    {
+      value = g_enum_get_value (klass, column);
+      benchmark = g_strdup_printf ("sort-%s", value != NULL ? value->value_nick : "unknown");
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model), column,
+                                            (column % 2 == 0) ? GTK_SORT_DESCENDING : GTK_SORT_ASCENDING);
+      bench_report (&clock, benchmark, n_files);
+      g_free (benchmark);
+    }
+  g_type_class_unref (klass);
+
+  thunar_list_model_set_show_hidden (model, TRUE);
+  bench_report (&clock, "show-hidden", n_files);
+
+  thunar_list_model_set_show_hidden (model, FALSE);
+  bench_report (&clock, "hide-hidden", n_files);
+
+  paths = thunar_list_model_get_paths_for_pattern (model, "*.txt", FALSE);
+  bench_report (&clock, "select-pattern", n_files);
+  g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
+
+  thunar_list_model_set_folder (model, NULL);
+  g_object_unref (model);
+  g_object_unref (folder);
+  bench_report (&clock, "release", n_files);
+}
+
+
+
+static void
+bench_listing_tree (const gchar *path,
+                    const gchar *workload,
+                    guint        depth,
+                    guint        run)
+{
+  ThunarListModel *model;
+  ThunarFolder    *folder;
+  BenchClock       clock;
+  GList           *folders = NULL;
+  gchar           *level;
+  gchar           *child;
+  guint            n_files = 0;
+  guint            n;
+
+  bench_drain_main_loop ();
+  bench_start (&clock, "listing", workload, run);
+
+  /* open the nested folders one after another, like a user does */
+  model = thunar_list_model_new ();
+  level = g_strdup (path);
+  for (n = 0; n < depth; ++n)
+    {
+      folder = bench_load_folder (level);
+      if (G_UNLIKELY (folder == NULL))
+        break;
+
+      thunar_list_model_set_folder (model, folder);
+      n_files += g_list_length (thunar_folder_get_files (folder));
+      folders = g_list_prepend (folders, folder);
+
+      child = g_strdup_printf ("%s%clevel-%02u", level, G_DIR_SEPARATOR, n);
+      g_free (level);
+      level = child;
+    }
+  g_free (level);
+
+  bench_report (&clock, "folder-chain", n_files);
+
+  thunar_list_model_set_folder (model, NULL);
+  g_object_unref (model);
+  g_list_free_full (folders, g_object_unref);
+}
+
+
+
+static gboolean
+bench_listing (const gchar *base)
+{
+  gchar **sizes;
+  gchar  *workload;
+  gchar  *path;
+  guint   n_entries;
+  guint   run;
+  guint   n;
+
+  sizes = g_strsplit (opt_entries != NULL ? opt_entries : "10000,100000", ",", -1);
+  for (n = 0; sizes[n] != NULL; ++n)
+    {
+      n_entries = strtoul (sizes[n], NULL, 10);
+      if (n_entries == 0)
+        continue;
+
+      workload = g_strdup_printf ("flat-%u", n_entries);
+      path = g_build_filename (base, workload, NULL);
+      if (!bench_generate_folder (path, n_entries))
+        {
+          g_free (path);
+          g_free (workload);
+          g_strfreev (sizes);
+          return FALSE;
+        }
+
+      for (run = 0; run < (guint) opt_runs; ++run)
+        bench_listing_folder (path, workload, run);
+
+      if (!opt_keep)
+        bench_remove_tree (path);
+      g_free (path);
+      g_free (workload);
+    }
+  g_strfreev (sizes);
+
+  if (opt_depth > 0)
+    {
+      workload = g_strdup_printf ("deep-%d", opt_depth);
+      path = g_build_filename (base, workload, NULL);
+      if (!bench_generate_tree (path, opt_depth, 100))
+        {
+          g_free (path);
+          g_free (workload);
+          return FALSE;
+        }
+
+      for (run = 0; run < (guint) opt_runs; ++run)
+        bench_listing_tree (path, workload, opt_depth, run);
+
+      if (!opt_keep)
+        bench_remove_tree (path);
+      g_free (path);
+      g_free (workload);
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_generate_files (const gchar *path,
+                      guint        n_files,
+                      gsize        size)
+{
+  gchar *child;
+  gchar *name;
+  guint  n;
+
+  if (g_mkdir_with_parents (path, 0755) != 0)
+    return FALSE;
+
+  for (n = 0; n < n_files; ++n)
+    {
+      name = g_strdup_printf ("file-%07u.bin", n);
+      child = g_build_filename (path, name, NULL);
+      g_free (name);
+
+      if (!bench_write_file (child, size))
+        {
+          g_printerr ("thunar-bench: Failed to create \"%s\": %s\n", child, g_strerror (errno));
+          g_free (child);
+          return FALSE;
+        }
+      g_free (child);
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+bench_count_tree (const gchar *path,
+                  guint       *n_files_return,
+                  guint64     *n_bytes_return)
+{
+  const gchar *name;
+  GStatBuf     statb;
+  GDir        *dir;
+  gchar       *child;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (G_UNLIKELY (dir == NULL))
+    return;
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      child = g_build_filename (path, name, NULL);
+      if (g_lstat (child, &statb) == 0)
+        {
+          *n_files_return += 1;
+          if (S_ISDIR (statb.st_mode))
+            bench_count_tree (child, n_files_return, n_bytes_return);
+          else if (S_ISREG (statb.st_mode))
+            *n_bytes_return += statb.st_size;
+        }
+      g_free (child);
+    }
+
+  g_dir_close (dir);
+}
+
+
+
+static ThunarJobResponse
+bench_job_ask (ThunarJob         *job,
+               const gchar       *message,
+               ThunarJobResponse  choices,
+               BenchTransfer     *transfer)
+{
+  /* answer like a user who wants everything to go through */
+  if ((choices & THUNAR_JOB_RESPONSE_YES_ALL) != 0)
+    return THUNAR_JOB_RESPONSE_YES_ALL;
+  if ((choices & THUNAR_JOB_RESPONSE_YES) != 0)
+    return THUNAR_JOB_RESPONSE_YES;
+  if ((choices & THUNAR_JOB_RESPONSE_FORCE) != 0)
+    return THUNAR_JOB_RESPONSE_FORCE;
+
+  g_printerr ("thunar-bench: Cancelled on question \"%s\"\n", message);
+  transfer->failed = TRUE;
+
+  return THUNAR_JOB_RESPONSE_CANCEL;
+}
+
+
+
+static ThunarJobResponse
+bench_job_ask_replace (ThunarJob     *job,
+                       ThunarFile    *source_file,
+                       ThunarFile    *target_file,
+                       BenchTransfer *transfer)
+{
+  return THUNAR_JOB_RESPONSE_REPLACE_ALL;
+}
+
+
+
+static void
+bench_job_error (ThunarJob     *job,
+                 GError        *error,
+                 BenchTransfer *transfer)
+{
+  g_printerr ("thunar-bench: %s\n", error->message);
+  transfer->failed = TRUE;
+}
+
+
+
+static void
+bench_job_finished (ThunarJob     *job,
+                    BenchTransfer *transfer)
+{
+  g_main_loop_quit (transfer->loop);
+}
+
+
+
+static void
+bench_monitor_changed (GFileMonitor      *monitor,
+                       GFile             *file,
+                       GFile             *other_file,
+                       GFileMonitorEvent  event_type,
+                       BenchTransfer     *transfer)
+{
+  /* the first change the job makes in the watched folder */
+  if (transfer->first_change_time == 0)
+    transfer->first_change_time = g_get_monotonic_time ();
+}
+
+
+
+static gboolean
+bench_run_job (ThunarJob   *job,
+               BenchClock  *clock,
+               const gchar *benchmark,
+               const gchar *watched_path,
+               guint        n_files,
+               guint64      n_bytes)
+{
+  BenchTransfer transfer = { 0, };
+  GFileMonitor *monitor;
+  GFile        *watched;
+  gdouble       seconds;
+  gint64        end_time;
+  gint64        heap;
+
+  transfer.loop = g_main_loop_new (NULL, FALSE);
+
+  /* the first change in the watched folder gives the time to first byte */
+  watched = g_file_new_for_path (watched_path);
+  monitor = g_file_monitor_directory (watched, G_FILE_MONITOR_NONE, NULL, NULL);
+  g_object_unref (watched);
+  if (G_LIKELY (monitor != NULL))
+    g_signal_connect (monitor, "changed", G_CALLBACK (bench_monitor_changed), &transfer);
+
+  g_signal_connect (job, "ask", G_CALLBACK (bench_job_ask), &transfer);
+  g_signal_connect (job, "ask-replace", G_CALLBACK (bench_job_ask_replace), &transfer);
+  g_signal_connect (job, "error", G_CALLBACK (bench_job_error), &transfer);
+  g_signal_connect (job, "finished", G_CALLBACK (bench_job_finished), &transfer);
+
+  clock->start_heap = bench_get_heap ();
+  clock->start_time = g_get_monotonic_time ();
+
+  exo_job_launch (EXO_JOB (job));
+  g_main_loop_run (transfer.loop);
+
+  end_time = g_get_monotonic_time ();
+  heap = bench_get_heap ();
+
+  /* monitor events of the last files may still be queued */
+  if (monitor != NULL)
+    {
+      g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, &transfer);
+      g_file_monitor_cancel (monitor);
+      g_object_unref (monitor);
+    }
+
+  g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, &transfer);
+  g_object_unref (job);
+  g_main_loop_unref (transfer.loop);
+
+  seconds = MAX (end_time - clock->start_time, 1) / (gdouble) G_USEC_PER_SEC;
+
+  g_print ("{\"suite\":\"%s\",\"benchmark\":\"%s\",\"workload\":\"%s\","
+           "\"items\":%u,\"run\":%u,\"wall_ms\":%.3f,"
+           "\"heap_bytes\":%" G_GINT64_FORMAT ",\"peak_rss_kb\":%ld,"
+           "\"bytes\":%" G_GUINT64_FORMAT ",\"files_per_s\":%.1f,\"mb_per_s\":%.3f,"
+           "\"ttfb_ms\":%.3f,\"failed\":%s}\n",
+           clock->suite, benchmark, clock->workload, n_files, clock->run,
+           (end_time - clock->start_time) / 1000.0,
+           (heap >= 0 && clock->start_heap >= 0) ? heap - clock->start_heap : -1,
+           bench_get_peak_rss (), n_bytes,
+           n_files / seconds, n_bytes / seconds / 1e6,
+           (transfer.first_change_time > 0) ? (transfer.first_change_time - clock->start_time) / 1000.0 : -1.0,
+           transfer.failed ? "true" : "false");
+
+  return !transfer.failed;
+}
+
+
+
+static GList *
+bench_file_list (const gchar *path)
+{
+  return g_list_prepend (NULL, g_file_new_for_path (path));
+}
+
+
+
+static gboolean
+bench_transfer_workload (const gchar *source,
+                         const gchar *workload,
+                         const gchar *target_base,
+                         const gchar *target_name)
+{
+  BenchClock clock;
+  gboolean   succeed = TRUE;
+  guint64    n_bytes = 0;
+  GList     *source_list;
+  GList     *target_list;
+  gchar     *copied;
+  gchar     *moved;
+  gchar     *name;
+  gchar     *source_base;
+  guint      n_files = 0;
+  guint      run;
+
+  /* the generated folder itself is transferred, like a user would */
+  bench_count_tree (source, &n_files, &n_bytes);
+  n_files += 1;
+
+  name = g_strdup_printf ("%s-%s", workload, target_name);
+  source_base = g_path_get_dirname (source);
+  copied = g_build_filename (target_base, name, NULL);
+  moved = g_strconcat (source, "-moved", NULL);
+
+  for (run = 0; succeed && run < (guint) opt_runs; ++run)
+    {
+      bench_drain_main_loop ();
+      bench_start (&clock, "transfer", name, run);
+
+      /* copy to the target, move it back as a new folder, delete that */
+      source_list = bench_file_list (source);
+      target_list = bench_file_list (copied);
+      succeed = bench_run_job (thunar_io_jobs_copy_files (source_list, target_list),
+                               &clock, "copy", target_base, n_files, n_bytes);
+      thunar_g_list_free_full (source_list);
+      thunar_g_list_free_full (target_list);
+
+      if (succeed)
+        {
+          source_list = bench_file_list (copied);
+          target_list = bench_file_list (moved);
+          succeed = bench_run_job (thunar_io_jobs_move_files (source_list, target_list),
+                                   &clock, "move", source_base, n_files, n_bytes);
+          thunar_g_list_free_full (source_list);
+          thunar_g_list_free_full (target_list);
+        }
+
+      if (succeed)
+        {
+          source_list = bench_file_list (moved);
+          succeed = bench_run_job (thunar_io_jobs_unlink_files (source_list),
+                                   &clock, "unlink", moved, n_files, n_bytes);
+          thunar_g_list_free_full (source_list);
+        }
+
+      /* the trash is only touched on request, it keeps the files */
+      if (succeed && opt_trash)
+        {
+          source_list = bench_file_list (source);
+          target_list = bench_file_list (copied);
+          succeed = bench_run_job (thunar_io_jobs_copy_files (source_list, target_list),
+                                   &clock, "copy", target_base, n_files, n_bytes);
+          thunar_g_list_free_full (source_list);
+          thunar_g_list_free_full (target_list);
+
+          if (succeed)
+            {
+              source_list = bench_file_list (copied);
+              succeed = bench_run_job (thunar_io_jobs_trash_files (source_list),
+                                       &clock, "trash", copied, n_files, n_bytes);
+              thunar_g_list_free_full (source_list);
+            }
+        }
+
+      /* leave nothing behind for the next run */
+      bench_remove_tree (copied);
+      bench_remove_tree (moved);
+    }
+
+  g_free (moved);
+  g_free (copied);
+  g_free (source_base);
+  g_free (name);
+
+  return succeed;
+}
+
+
+
+static gchar *
+bench_cross_directory (const gchar *base)
+{
+  GStatBuf base_statb;
+  GStatBuf statb;
+  gchar   *path;
+
+  /* use the temporary directory if it is on another filesystem */
+  if (opt_cross_directory == NULL)
+    {
+      if (g_stat (base, &base_statb) != 0
+          || g_stat (g_get_tmp_dir (), &statb) != 0
+          || base_statb.st_dev == statb.st_dev)
+        return NULL;
+    }
+
+  path = g_build_filename (opt_cross_directory != NULL ? opt_cross_directory : g_get_tmp_dir (),
+                           "thunar-bench-XXXXXX", NULL);
+  if (g_mkdtemp (path) == NULL)
+    {
+      g_printerr ("thunar-bench: Failed to create a folder for cross-device transfers: %s\n", g_strerror (errno));
+      g_free (path);
+      return NULL;
+    }
+
+  return path;
+}
+
+
+
+static gboolean
+bench_transfer (const gchar *base)
+{
+  const gchar *workloads[3];
+  gboolean     succeed;
+  gchar       *same;
+  gchar       *cross;
+  gchar       *path;
+  guint        n;
+
+  workloads[0] = "small-files";
+  workloads[1] = "huge-files";
+  workloads[2] = "deep-tree";
+
+  /* many small files, few huge files and a deep tree of mixed files */
+  path = g_build_filename (base, workloads[0], NULL);
+  succeed = bench_generate_files (path, opt_small_files, 4096);
+  g_free (path);
+
+  path = g_build_filename (base, workloads[1], NULL);
+  succeed = succeed && bench_generate_files (path, opt_huge_files, (gsize) opt_huge_size * 1024 * 1024);
+  g_free (path);
+
+  path = g_build_filename (base, workloads[2], NULL);
+  succeed = succeed && bench_generate_tree (path, MAX (opt_depth, 1), 100);
+  g_free (path);
+
+  if (!succeed)
+    return FALSE;
+
+  same = g_build_filename (base, "targets", NULL);
+  g_mkdir (same, 0755);
+  cross = bench_cross_directory (base);
+  if (cross == NULL)
+    g_printerr ("thunar-bench: No other filesystem found, skipping cross-device transfers, use --cross-directory\n");
+
+  for (n = 0; succeed && n < G_N_ELEMENTS (workloads); ++n)
+    {
+      path = g_build_filename (base, workloads[n], NULL);
+
+      succeed = bench_transfer_workload (path, workloads[n], same, "same-device");
+      if (succeed && cross != NULL)
+        succeed = bench_transfer_workload (path, workloads[n], cross, "cross-device");
+
+      g_free (path);
+    }
+
+  if (cross != NULL)
+    {
+      bench_remove_tree (cross);
+      g_free (cross);
+    }
+  g_free (same);
+
+  return succeed;
+}
+
+
+
+static gint
+bench_compare_times (gconstpointer a,
+                     gconstpointer b)
+{
+  gint64 time_a = *(const gint64 *) a;
+  gint64 time_b = *(const gint64 *) b;
+
+  return (time_a > time_b) - (time_a < time_b);
+}
+
+
+
+static gdouble
+bench_percentile_ms (GArray *times,
+                     guint   percentile)
+{
+  /* the times are sorted by bench_views_report() */
+  if (G_UNLIKELY (times->len == 0))
+    return -1.0;
+
+  return g_array_index (times, gint64, (times->len - 1) * percentile / 100) / 1000.0;
+}
+
+
+
+static gboolean
+bench_views_draw (GtkWidget   *view,
+                  cairo_t     *cr,
+                  BenchScroll *scroll)
+{
+  /* connected before thunar_standard_view_draw() */
+  scroll->draw_start_time = g_get_monotonic_time ();
+
+  return FALSE;
+}
+
+
+
+static gboolean
+bench_views_draw_after (GtkWidget   *view,
+                        cairo_t     *cr,
+                        BenchScroll *scroll)
+{
+  gint64 draw_time;
+
+  if (G_LIKELY (scroll->draw_start_time > 0))
+    {
+      draw_time = g_get_monotonic_time () - scroll->draw_start_time;
+      g_array_append_val (scroll->draw_times, draw_time);
+      scroll->draw_start_time = 0;
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+bench_views_tick (GtkWidget     *widget,
+                  GdkFrameClock *frame_clock,
+                  gpointer       user_data)
+{
+  BenchScroll *scroll = user_data;
+  gint64       frame_time;
+  gint64       interval;
+  gdouble      end_value;
+  gdouble      value;
+
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  if (G_UNLIKELY (scroll->start_frame_time == 0))
+    {
+      scroll->start_frame_time = frame_time;
+      gdk_frame_clock_get_refresh_info (frame_clock, frame_time, &scroll->refresh_interval, NULL);
+    }
+  else
+    {
+      interval = frame_time - scroll->last_frame_time;
+      g_array_append_val (scroll->frame_times, interval);
+    }
+  scroll->last_frame_time = frame_time;
+
+  /* scroll at a fixed speed, independent of the frames we get */
+  end_value = gtk_adjustment_get_upper (scroll->adjustment) - gtk_adjustment_get_page_size (scroll->adjustment);
+  value = (frame_time - scroll->start_frame_time) * (gdouble) opt_scroll_speed / G_USEC_PER_SEC;
+  gtk_adjustment_set_value (scroll->adjustment, MIN (value, end_value));
+
+  if (value >= end_value || frame_time - scroll->start_frame_time >= (gint64) opt_scroll_seconds * G_USEC_PER_SEC)
+    {
+      g_main_loop_quit (scroll->loop);
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static void
+bench_views_report (BenchScroll *scroll,
+                    BenchClock  *clock,
+                    const gchar *benchmark,
+                    guint        n_items)
+{
+  gint64 end_time;
+  guint  n_long_frames = 0;
+  guint  n;
+
+  end_time = g_get_monotonic_time ();
+
+  /* frames taking longer than one and a half refresh intervals were missed */
+  for (n = 0; n < scroll->frame_times->len; ++n)
+    if (g_array_index (scroll->frame_times, gint64, n) * 2 > scroll->refresh_interval * 3)
+      ++n_long_frames;
+
+  g_array_sort (scroll->frame_times, bench_compare_times);
+  g_array_sort (scroll->draw_times, bench_compare_times);
+
+  g_print ("{\"suite\":\"%s\",\"benchmark\":\"%s\",\"workload\":\"%s\","
+           "\"items\":%u,\"run\":%u,\"wall_ms\":%.3f,\"peak_rss_kb\":%ld,"
+           "\"frames\":%u,\"long_frames\":%u,\"refresh_ms\":%.3f,"
+           "\"frame_p50_ms\":%.3f,\"frame_p99_ms\":%.3f,"
+           "\"draw_p50_ms\":%.3f,\"draw_p99_ms\":%.3f}\n",
+           clock->suite, benchmark, clock->workload, n_items, clock->run,
+           (end_time - clock->start_time) / 1000.0, bench_get_peak_rss (),
+           scroll->frame_times->len, n_long_frames, scroll->refresh_interval / 1000.0,
+           bench_percentile_ms (scroll->frame_times, 50),
+           bench_percentile_ms (scroll->frame_times, 99),
+           bench_percentile_ms (scroll->draw_times, 50),
+           bench_percentile_ms (scroll->draw_times, 99));
+}
+
+
+
+static void
+bench_views_scroll (const gchar *path,
+                    GType        view_type,
+                    const gchar *view_name,
+                    gboolean     decorated,
+                    const gchar *workload,
+                    guint        run)
+{
+  ThunarPreferences *preferences;
+  BenchScroll        scroll = { 0, };
+  BenchClock         clock;
+  GtkWidget         *window;
+  GtkWidget         *view;
+  ThunarFile        *directory;
+  GFile             *gfile;
+  gchar             *benchmark;
+  guint              n_items;
+
+  gfile = g_file_new_for_path (path);
+  directory = thunar_file_get (gfile, NULL);
+  g_object_unref (gfile);
+  if (G_UNLIKELY (directory == NULL))
+    return;
+
+  /* the thumbnails are requested from the thumbnailer service, if any */
+  preferences = thunar_preferences_get ();
+  g_object_set (G_OBJECT (preferences), "misc-thumbnail-mode",
+                decorated ? THUNAR_THUMBNAIL_MODE_ALWAYS : THUNAR_THUMBNAIL_MODE_NEVER, NULL);
+  g_object_unref (preferences);
+
+  bench_drain_main_loop ();
+  bench_start (&clock, "views", workload, run);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), opt_window_width, opt_window_height);
+
+  view = g_object_new (view_type, NULL);
+  g_object_set (G_OBJECT (THUNAR_STANDARD_VIEW (view)->icon_renderer), "emblems", decorated, NULL);
+  thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (view), directory);
+  gtk_container_add (GTK_CONTAINER (window), view);
+  gtk_widget_show_all (window);
+  g_object_unref (directory);
+
+  /* wait until the folder is shown */
+  while (thunar_view_get_loading (THUNAR_VIEW (view)) || !gtk_widget_get_mapped (view))
+    g_main_context_iteration (NULL, TRUE);
+  bench_drain_main_loop ();
+
+  n_items = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (THUNAR_STANDARD_VIEW (view)->model), NULL);
+  benchmark = g_strdup_printf ("open-%s", view_name);
+  bench_report (&clock, benchmark, n_items);
+  g_free (benchmark);
+
+  /* the compact view scrolls horizontally */
+  if (THUNAR_IS_COMPACT_VIEW (view))
+    scroll.adjustment = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (view));
+  else
+    scroll.adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (view));
+  scroll.frame_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+  scroll.draw_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+  scroll.loop = g_main_loop_new (NULL, FALSE);
+
+  g_signal_connect (G_OBJECT (view), "draw", G_CALLBACK (bench_views_draw), &scroll);
+  g_signal_connect_after (G_OBJECT (view), "draw", G_CALLBACK (bench_views_draw_after), &scroll);
+  gtk_widget_add_tick_callback (view, bench_views_tick, &scroll, NULL);
+
+  clock.start_time = g_get_monotonic_time ();
+  g_main_loop_run (scroll.loop);
+
+  benchmark = g_strdup_printf ("scroll-%s", view_name);
+  bench_views_report (&scroll, &clock, benchmark, n_items);
+  g_free (benchmark);
+
+  g_signal_handlers_disconnect_matched (G_OBJECT (view), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, &scroll);
+  gtk_widget_destroy (window);
+
+  g_main_loop_unref (scroll.loop);
+  g_array_free (scroll.draw_times, TRUE);
+  g_array_free (scroll.frame_times, TRUE);
+}
+
+
+
+static gboolean
+bench_views (const gchar *base)
+{
+  gchar      **sizes;
+  gchar       *workload;
+  gchar       *path;
+  const gchar *view_names[3];
+  GType        view_types[3];
+  guint        n_entries;
+  guint        decorated;
+  guint        run;
+  guint        n;
+  guint        i;
+
+  view_types[0] = THUNAR_TYPE_DETAILS_VIEW;
+  view_types[1] = THUNAR_TYPE_ICON_VIEW;
+  view_types[2] = THUNAR_TYPE_COMPACT_VIEW;
+  view_names[0] = "details";
+  view_names[1] = "icons";
+  view_names[2] = "compact";
+
+  sizes = g_strsplit (opt_entries != NULL ? opt_entries : "10000", ",", -1);
+  for (n = 0; sizes[n] != NULL; ++n)
+    {
+      n_entries = strtoul (sizes[n], NULL, 10);
+      if (n_entries == 0)
+        continue;
+
+      path = g_strdup_printf ("%s%cflat-%u", base, G_DIR_SEPARATOR, n_entries);
+      if (!bench_generate_folder (path, n_entries))
+        {
+          g_free (path);
+          g_strfreev (sizes);
+          return FALSE;
+        }
+
+      /* without, and with thumbnails and emblems */
+      for (decorated = 0; decorated < 2; ++decorated)
+        {
+          workload = g_strdup_printf ("flat-%u-%s", n_entries, decorated ? "decorated" : "plain");
+          for (i = 0; i < G_N_ELEMENTS (view_types); ++i)
+            for (run = 0; run < (guint) opt_runs; ++run)
+              bench_views_scroll (path, view_types[i], view_names[i], decorated, workload, run);
+          g_free (workload);
+        }
+
+      if (!opt_keep)
+        bench_remove_tree (path);
+      g_free (path);
+    }
+  g_strfreev (sizes);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bench_generate_images (const gchar *path,
+                       guint        n_files)
+{
+  static const gchar *extensions[] = { ".png", ".jpg", ".pdf", ".svg", ".txt" };
+  gchar              *child;
+  gchar              *name;
+  guint               n;
+
+  if (g_mkdir_with_parents (path, 0755) != 0)
+    return FALSE;
+
+  for (n = 0; n < n_files; ++n)
+    {
+      name = g_strdup_printf ("image-%07u%s", n, extensions[n % G_N_ELEMENTS (extensions)]);
+      child = g_build_filename (path, name, NULL);
+      g_free (name);
+
+      if (!bench_write_file (child, 4096))
+        {
+          g_printerr ("thunar-bench: Failed to create \"%s\": %s\n", child, g_strerror (errno));
+          g_free (child);
+          return FALSE;
+        }
+      g_free (child);
+    }
+
+  return TRUE;
+}
+
+
+
+static GList *
+bench_thumbnails_range (BenchThumbnails *bench,
+                        guint            start,
+                        guint            end)
+{
+  GList *files = NULL;
+  guint  n;
+
+  for (n = MIN (end, bench->n_files); n > start; --n)
+    files = g_list_prepend (files, bench->files[n - 1]);
+
+  return files;
+}
+
+
+
+static void
+bench_thumbnails_show (BenchThumbnails *bench,
+                       guint            top)
+{
+  GList *files;
+
+  top = MIN (top, bench->n_files - MIN (bench->n_files, (guint) opt_visible));
+  if (top == bench->top && bench->visible_request != 0)
+    return;
+  bench->top = top;
+
+  /* like thunar_standard_view_cancel_thumbnailing() and
+   * thunar_standard_view_request_thumbnails() on every scroll */
+  if (bench->visible_request != 0)
+    thunar_thumbnailer_dequeue (bench->thumbnailer, bench->visible_request);
+  if (bench->prefetch_request != 0)
+    thunar_thumbnailer_dequeue (bench->thumbnailer, bench->prefetch_request);
+  bench->visible_request = 0;
+  bench->prefetch_request = 0;
+
+  files = bench_thumbnails_range (bench, top, top + opt_visible);
+  if (files != NULL)
+    thunar_thumbnailer_queue_files (bench->thumbnailer, TRUE, files, &bench->visible_request);
+  g_list_free (files);
+
+  files = bench_thumbnails_range (bench, top + opt_visible, top + 2 * opt_visible);
+  if (files != NULL)
+    thunar_thumbnailer_prefetch_files (bench->thumbnailer, files, &bench->prefetch_request);
+  g_list_free (files);
+}
+
+
+
+static void
+bench_thumbnails_rendered (const gchar *uri,
+                           gpointer     user_data)
+{
+  BenchThumbnails *bench = user_data;
+  guint            row;
+
+  /* a thumbnail for a file that is neither shown nor prefetched anymore */
+  row = GPOINTER_TO_UINT (g_hash_table_lookup (bench->rows, uri));
+  if (row == 0 || row - 1 < bench->top || row - 1 >= bench->top + 2 * opt_visible)
+    bench->offscreen_renders++;
+}
+
+
+
+static gboolean
+bench_thumbnails_tick (gpointer user_data)
+{
+  BenchThumbnails *bench = user_data;
+  gboolean         done = FALSE;
+
+  bench->n_ticks++;
+
+  switch (bench->pattern)
+    {
+    case BENCH_SCROLL_STEADY:
+      /* an eighth of a screen per frame, until the end of the folder */
+      bench->position += opt_visible / 8.0;
+      done = (bench->position + opt_visible >= bench->n_files);
+      break;
+
+    case BENCH_SCROLL_FLING:
+      /* two screens per frame, slowing down like kinetic scrolling */
+      if (bench->n_ticks == 1)
+        bench->velocity = opt_visible * 2.0;
+      bench->position += bench->velocity;
+      bench->velocity *= 0.95;
+      done = (bench->velocity < 0.5 || bench->position + opt_visible >= bench->n_files);
+      break;
+
+    case BENCH_SCROLL_JUMPS:
+      /* jump to another place every quarter of a second */
+      if (bench->n_ticks % 15 == 1)
+        bench->position = g_rand_int_range (bench->rand, 0, MAX (bench->n_files, 1));
+      done = (bench->n_ticks >= 20 * 15);
+      break;
+
+    default:
+      done = TRUE;
+      break;
+    }
+
+  bench_thumbnails_show (bench, (guint) bench->position);
+
+  if (done)
+    {
+      g_main_loop_quit (bench->loop);
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static void
+bench_thumbnails_scroll (BenchThumbnails *bench,
+                         BenchScrollType  pattern,
+                         const gchar     *workload,
+                         guint            run)
+{
+  const BenchTumblerStats *stats;
+  static const gchar      *names[] = { "scroll-steady", "scroll-fling", "scroll-jumps" };
+  BenchClock               clock;
+  gint64                   deadline;
+  guint                    n;
+
+  /* every run starts without thumbnails */
+  bench_drain_main_loop ();
+  for (n = 0; n < bench->n_files; ++n)
+    thunar_file_set_thumb_state (bench->files[n], THUNAR_FILE_THUMB_STATE_UNKNOWN);
+  bench_tumbler_reset (bench->tumbler);
+
+  bench->pattern = pattern;
+  bench->position = 0.0;
+  bench->velocity = 0.0;
+  bench->n_ticks = 0;
+  bench->top = 0;
+  bench->offscreen_renders = 0;
+  g_rand_set_seed (bench->rand, run);
+
+  bench_start (&clock, "thumbnails", workload, run);
+
+  bench_thumbnails_show (bench, 0);
+  g_timeout_add (16, bench_thumbnails_tick, bench);
+  g_main_loop_run (bench->loop);
+
+  /* let the service finish what is still queued */
+  deadline = g_get_monotonic_time () + 60 * G_USEC_PER_SEC;
+  while (!bench_tumbler_get_idle (bench->tumbler) && g_get_monotonic_time () < deadline)
+    g_main_context_iteration (NULL, TRUE);
+  bench_drain_main_loop ();
+
+  stats = bench_tumbler_get_stats (bench->tumbler);
+  g_array_sort (stats->latencies, bench_compare_times);
+
+  g_print ("{\"suite\":\"%s\",\"benchmark\":\"%s\",\"workload\":\"%s\","
+           "\"items\":%u,\"run\":%u,\"wall_ms\":%.3f,\"peak_rss_kb\":%ld,"
+           "\"latency_ms\":%d,\"failure_percent\":%d,\"dbus_messages\":%u,"
+           "\"queue_calls\":%u,\"dequeue_calls\":%u,\"dequeued_uris\":%u,"
+           "\"renders\":%u,\"failures\":%u,\"wasted_renders\":%u,"
+           "\"duplicate_renders\":%u,\"offscreen_renders\":%u,"
+           "\"queue_p50_ms\":%.3f,\"queue_p99_ms\":%.3f}\n",
+           clock.suite, names[pattern], clock.workload, bench->n_files, clock.run,
+           (g_get_monotonic_time () - clock.start_time) / 1000.0, bench_get_peak_rss (),
+           opt_thumbnail_latency, opt_thumbnail_failures, stats->messages,
+           stats->queue_calls, stats->dequeue_calls, stats->dequeued_uris,
+           stats->renders, stats->failures, stats->duplicate_renders + bench->offscreen_renders,
+           stats->duplicate_renders, bench->offscreen_renders,
+           bench_percentile_ms (stats->latencies, 50),
+           bench_percentile_ms (stats->latencies, 99));
+
+  /* nothing of this run is shown anymore */
+  if (bench->visible_request != 0)
+    thunar_thumbnailer_dequeue (bench->thumbnailer, bench->visible_request);
+  if (bench->prefetch_request != 0)
+    thunar_thumbnailer_dequeue (bench->thumbnailer, bench->prefetch_request);
+  bench->visible_request = 0;
+  bench->prefetch_request = 0;
+}
+
+
+
+static void
+bench_thumbnails_cache (BenchThumbnails *bench,
+                        const gchar     *base,
+                        const gchar     *workload,
+                        guint            run)
+{
+  const BenchTumblerStats *stats;
+  static const gchar      *names[] = { "cache-move", "cache-copy", "cache-delete" };
+  ThunarThumbnailCache    *cache;
+  BenchClock               clock;
+  GFile                   *target;
+  gchar                   *path;
+  gint64                   deadline;
+  guint                    operation;
+  guint                    n;
+
+  cache = thunar_thumbnail_cache_new ();
+
+  for (operation = 0; operation < G_N_ELEMENTS (names); ++operation)
+    {
+      bench_drain_main_loop ();
+      bench_tumbler_reset (bench->tumbler);
+      bench_start (&clock, "thumbnails", workload, run);
+
+      /* the file operations report every file on its own */
+      for (n = 0; n < bench->n_files; ++n)
+        {
+          if (operation == 2)
+            {
+              thunar_thumbnail_cache_delete_file (cache, thunar_file_get_file (bench->files[n]));
+              continue;
+            }
+
+          path = g_strdup_printf ("%s%cmoved-%07u", base, G_DIR_SEPARATOR, n);
+          target = g_file_new_for_path (path);
+          if (operation == 0)
+            thunar_thumbnail_cache_move_file (cache, thunar_file_get_file (bench->files[n]), target);
+          else
+            thunar_thumbnail_cache_copy_file (cache, thunar_file_get_file (bench->files[n]), target);
+          g_object_unref (target);
+          g_free (path);
+        }
+
+      /* wait until the service got all files */
+      stats = bench_tumbler_get_stats (bench->tumbler);
+      deadline = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+      while (stats->cache_uris < bench->n_files && g_get_monotonic_time () < deadline)
+        g_main_context_iteration (NULL, TRUE);
+      stats = bench_tumbler_get_stats (bench->tumbler);
+
+      g_print ("{\"suite\":\"%s\",\"benchmark\":\"%s\",\"workload\":\"%s\","
+               "\"items\":%u,\"run\":%u,\"wall_ms\":%.3f,\"peak_rss_kb\":%ld,"
+               "\"dbus_messages\":%u,\"cache_calls\":%u,\"cache_uris\":%u}\n",
+               clock.suite, names[operation], clock.workload, bench->n_files, clock.run,
+               (MAX (stats->last_cache_time, clock.start_time) - clock.start_time) / 1000.0,
+               bench_get_peak_rss (), stats->messages, stats->cache_calls, stats->cache_uris);
+    }
+
+  g_object_unref (cache);
+}
+
+
+
+static gboolean
+bench_thumbnails (const gchar *base)
+{
+  BenchThumbnails  bench = { 0, };
+  ThunarListModel *model;
+  ThunarFolder    *folder;
+  GtkTreeIter      iter;
+  GHashTable      *types;
+  GTestDBus       *bus;
+  GError          *error = NULL;
+  gboolean         succeed;
+  gchar          **mime_types;
+  gchar           *workload;
+  gchar           *path;
+  guint            n_entries;
+  guint            pattern;
+  guint            run;
+  guint            n;
+
+  n_entries = (opt_entries != NULL) ? strtoul (opt_entries, NULL, 10) : 2000;
+  if (n_entries == 0)
+    n_entries = 2000;
+
+  workload = g_strdup_printf ("images-%u", n_entries);
+  path = g_build_filename (base, workload, NULL);
+  if (!bench_generate_images (path, n_entries))
+    {
+      g_free (path);
+      g_free (workload);
+      return FALSE;
+    }
+
+  folder = bench_load_folder (path);
+  g_free (path);
+  if (G_UNLIKELY (folder == NULL))
+    {
+      g_free (workload);
+      return FALSE;
+    }
+
+  /* the rows in the order of the views */
+  model = thunar_list_model_new ();
+  thunar_list_model_set_folder (model, folder);
+  bench.n_files = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL);
+  bench.files = g_new0 (ThunarFile *, MAX (bench.n_files, 1));
+  bench.rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  types = g_hash_table_new (g_str_hash, g_str_equal);
+  if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &iter))
+    {
+      n = 0;
+      do
+        {
+          bench.files[n] = thunar_list_model_get_file (model, &iter);
+          g_hash_table_insert (bench.rows, thunar_file_dup_uri (bench.files[n]), GUINT_TO_POINTER (n + 1));
+          if (thunar_file_get_content_type (bench.files[n]) != NULL)
+            g_hash_table_add (types, (gpointer) thunar_file_get_content_type (bench.files[n]));
+          ++n;
+        }
+      while (n < bench.n_files && gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter));
+    }
+
+  /* the mock claims to support every type in the folder */
+  mime_types = (gchar **) g_hash_table_get_keys_as_array (types, NULL);
+
+  /* run the mock on a bus of its own, a running tumbler keeps its names */
+  bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (bus);
+
+  bench.tumbler = bench_tumbler_new ((const gchar *const *) mime_types,
+                                     MAX (opt_thumbnail_latency, 0),
+                                     CLAMP (opt_thumbnail_failures, 0, 100),
+                                     &error);
+  g_free (mime_types);
+  g_hash_table_destroy (types);
+
+  succeed = (bench.tumbler != NULL);
+  if (G_LIKELY (succeed))
+    {
+      bench_tumbler_set_render_func (bench.tumbler, bench_thumbnails_rendered, &bench);
+
+      bench.thumbnailer = thunar_thumbnailer_get ();
+      while (!bench_tumbler_get_ready (bench.tumbler))
+        g_main_context_iteration (NULL, TRUE);
+      bench_drain_main_loop ();
+
+      bench.loop = g_main_loop_new (NULL, FALSE);
+      bench.rand = g_rand_new ();
+
+      for (pattern = 0; pattern < BENCH_SCROLL_N_TYPES; ++pattern)
+        for (run = 0; run < (guint) opt_runs; ++run)
+          bench_thumbnails_scroll (&bench, pattern, workload, run);
+
+      for (run = 0; run < (guint) opt_runs; ++run)
+        bench_thumbnails_cache (&bench, base, workload, run);
+
+      g_object_unref (bench.thumbnailer);
+      bench_drain_main_loop ();
+
+      g_rand_free (bench.rand);
+      g_main_loop_unref (bench.loop);
+      bench_tumbler_free (bench.tumbler);
+    }
+  else
+    {
+      g_printerr ("thunar-bench: Failed to start the thumbnailer mock: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  g_test_dbus_down (bus);
+  g_object_unref (bus);
+
+  for (n = 0; n < bench.n_files; ++n)
+    if (bench.files[n] != NULL)
+      g_object_unref (bench.files[n]);
+  g_free (bench.files);
+  g_hash_table_destroy (bench.rows);
+
+  thunar_list_model_set_folder (model, NULL);
+  g_object_unref (model);
+  g_object_unref (folder);
+  g_free (workload);
+
+  return succeed;
+}
+
+
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  const gchar    *suite;
+  gboolean        succeed;
+  GError         *error = NULL;
+  gchar          *base;
+
+  context = g_option_context_new ("[listing|transfer|views|thumbnails]");
+  g_option_context_set_summary (context, "Measures the hot paths of Thunar on generated folders.");
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("thunar-bench: %s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (context);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (context);
+
+  suite = (argc > 1) ? argv[1] : "listing";
+  if (strcmp (suite, "listing") != 0 && strcmp (suite, "transfer") != 0
+      && strcmp (suite, "views") != 0 && strcmp (suite, "thumbnails") != 0)
+    {
+      g_printerr ("thunar-bench: Unknown suite \"%s\"\n", suite);
+      return EXIT_FAILURE;
+    }
+
+  /* only the views need a display */
+  if (strcmp (suite, "views") == 0 && !gtk_init_check (&argc, &argv))
+    {
+      g_printerr ("thunar-bench: Failed to open a display for the views\n");
+      return EXIT_FAILURE;
+    }
+
+  /* use the default preferences, so results of different users compare */
+  thunar_preferences_xfconf_init_failed ();
+  thunar_g_initialize_transformations ();
+
+  /* generate the folders in memory unless asked otherwise */
+  if (opt_directory == NULL)
+    opt_directory = g_strdup (g_file_test ("/dev/shm", G_FILE_TEST_IS_DIR) ? "/dev/shm" : g_get_tmp_dir ());
+
+  base = g_build_filename (opt_directory, "thunar-bench-XXXXXX", NULL);
+  if (g_mkdtemp (base) == NULL)
+    {
+      g_printerr ("thunar-bench: Failed to create a folder in \"%s\": %s\n", opt_directory, g_strerror (errno));
+      g_free (base);
+      return EXIT_FAILURE;
+    }
+
+  if (strcmp (suite, "transfer") == 0)
+    succeed = bench_transfer (base);
+  else if (strcmp (suite, "views") == 0)
+    succeed = bench_views (base);
+  else if (strcmp (suite, "thumbnails") == 0)
+    succeed = bench_thumbnails (base);
+  else
+    succeed = bench_listing (base);
+
+  if (!opt_keep)
+    bench_remove_tree (base);
+  else
+    g_printerr ("thunar-bench: The generated folders are kept in \"%s\"\n", base);
+
+  g_free (base);
+  g_free (opt_cross_directory);
+  g_free (opt_directory);
+  g_free (opt_entries);
+
+  return succeed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -24,6 +24,7 @@
 #include <config.h>
 #endif
 
+#include <thunar/thunar-app-index.h>
 #include <thunar/thunar-chooser-button.h>
 #include <thunar/thunar-chooser-dialog.h>
 #include <thunar/thunar-dialogs.h>
@@ -302,6 +303,7 @@ thunar_chooser_button_changed (GtkComboBox *combo_box)
       content_type = thunar_file_get_content_type (chooser_button->file);
 
       /* try to set application as default for these kind of file */
+      thunar_app_index_invalidate ();
       if (!g_app_info_set_as_default_for_type (app_info, content_type, &error))
         {
           /* tell the user that it didn't work */
@@ -445,11 +447,11 @@ thunar_chooser_button_file_changed (ThunarChooserButton *chooser_button,
       g_free (description);
 
       /* determine the default application for that content type */
-      app_info = g_app_info_get_default_for_type (content_type, FALSE);
+      app_info = thunar_app_index_get_default_for_type (content_type);
       if (G_LIKELY (app_info != NULL))
         {
           /* determine all applications that claim to be able to handle the file */
-          app_infos = g_app_info_get_all_for_type (content_type);
+          app_infos = thunar_app_index_get_for_type (content_type);
           app_infos = g_list_sort (app_infos, thunar_chooser_button_sort_applications);
 
           /* add all possible applications */
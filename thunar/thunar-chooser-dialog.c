@@ -30,6 +30,7 @@
 #endif
 
 #include <thunar/thunar-abstract-dialog.h>
+#include <thunar/thunar-app-index.h>
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-chooser-dialog.h>
 #include <thunar/thunar-chooser-model.h>
@@ -442,8 +443,10 @@ thunar_chooser_dialog_response (GtkDialog *widget,
           return;
         }
 
-      /* Check if that application already exists in our list */
-      all_apps = g_app_info_get_all ();
+      /* Check if that application already exists in our list, the
+       * new application may have added a desktop file */
+      thunar_app_index_invalidate ();
+      all_apps = thunar_app_index_get_all ();
       for (lp = all_apps; lp != NULL; lp = lp->next)
         {
           if( g_strcmp0 (g_app_info_get_name (lp->data), g_app_info_get_name (app_info)) == 0 &&
@@ -462,7 +465,10 @@ thunar_chooser_dialog_response (GtkDialog *widget,
   if (G_UNLIKELY (app_info == NULL))
     return;
 
-  default_app = g_app_info_get_default_for_type (content_type, FALSE);
+  default_app = thunar_app_index_get_default_for_type (content_type);
+
+  /* the associations are changed below */
+  thunar_app_index_invalidate ();
 
   /* check if we should also set the application as default or
    * if application is opened first time, set it as default application */
@@ -33,6 +33,7 @@
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-clipboard-manager.h>
 #include <thunar/thunar-dialogs.h>
+#include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-private.h>
 
@@ -55,6 +56,7 @@ enum
   TARGET_TEXT_URI_LIST,
   TARGET_GNOME_COPIED_FILES,
   TARGET_UTF8_STRING,
+  N_TARGETS,
 };
 
 
@@ -65,7 +67,11 @@ static void thunar_clipboard_manager_get_property       (GObject
                                                          guint                        prop_id,
                                                          GValue                      *value,
                                                          GParamSpec                  *pspec);
-static void thunar_clipboard_manager_file_destroyed     (ThunarFile                  *file,
+static void thunar_clipboard_manager_file_changed       (ThunarFileMonitor           *file_monitor,
+                                                         ThunarFile                  *file,
+                                                         ThunarClipboardManager      *manager);
+static void thunar_clipboard_manager_file_destroyed     (ThunarFileMonitor           *file_monitor,
+                                                         ThunarFile                  *file,
                                                          ThunarClipboardManager      *manager);
 static void thunar_clipboard_manager_owner_changed      (GtkClipboard                *clipboard,
                                                          GdkEventOwnerChange         *event,
@@ -85,6 +91,8 @@ static void thunar_clipboard_manager_clear_callback     (GtkClipboard
 static void thunar_clipboard_manager_transfer_files     (ThunarClipboardManager      *manager,
                                                          gboolean                     copy,
                                                          GList                       *files);
+static void thunar_clipboard_manager_release_files      (ThunarClipboardManager      *manager);
+static void thunar_clipboard_manager_drop_contents      (ThunarClipboardManager      *manager);
 
 
 
@@ -103,8 +111,17 @@ struct _ThunarClipboardManager
   gboolean      can_paste;
   GdkAtom       x_special_gnome_copied_files;
 
-  gboolean      files_cutted;
-  GList        *files;
+  gboolean           files_cutted;
+  GList             *files;
+
+  /* maps the files on the clipboard to their links in the list,
+   * so the views can look up cut files quickly */
+  GHashTable        *files_table;
+  ThunarFileMonitor *file_monitor;
+
+  /* the clipboard contents for each target, built on demand */
+  gchar             *contents[N_TARGETS];
+  gsize              contents_length[N_TARGETS];
 };
 
 typedef struct
@@ -113,6 +130,7 @@ typedef struct
   GFile                  *target_file;
   GtkWidget              *widget;
   GClosure               *new_files_closure;
+  gboolean                path_copy;
 } ThunarClipboardPasteRequest;
 
 
@@ -179,6 +197,14 @@ static void
 thunar_clipboard_manager_init (ThunarClipboardManager *manager)
 {
   manager->x_special_gnome_copied_files = gdk_atom_intern_static_string ("x-special/gnome-copied-files");
+  manager->files_table = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* drop files from the clipboard once deleted and rebuild the contents on changes */
+  manager->file_monitor = thunar_file_monitor_get_default ();
+  g_signal_connect (G_OBJECT (manager->file_monitor), "file-changed",
+                    G_CALLBACK (thunar_clipboard_manager_file_changed), manager);
+  g_signal_connect (G_OBJECT (manager->file_monitor), "file-destroyed",
+                    G_CALLBACK (thunar_clipboard_manager_file_destroyed), manager);
 }
 
 
@@ -208,15 +234,14 @@ static void
 thunar_clipboard_manager_finalize (GObject *object)
 {
   ThunarClipboardManager *manager = THUNAR_CLIPBOARD_MANAGER (object);
-  GList                  *lp;
 
   /* release any pending files */
-  for (lp = manager->files; lp != NULL; lp = lp->next)
-    {
-      g_signal_handlers_disconnect_by_func (G_OBJECT (lp->data), thunar_clipboard_manager_file_destroyed, manager);
-      g_object_unref (G_OBJECT (lp->data));
-    }
-  g_list_free (manager->files);
+  thunar_clipboard_manager_release_files (manager);
+  g_hash_table_destroy (manager->files_table);
+
+  /* disconnect from the file monitor */
+  g_signal_handlers_disconnect_by_data (G_OBJECT (manager->file_monitor), manager);
+  g_object_unref (G_OBJECT (manager->file_monitor));
 
   /* disconnect from the clipboard */
   g_signal_handlers_disconnect_by_func (G_OBJECT (manager->clipboard), thunar_clipboard_manager_owner_changed, manager);
@@ -251,18 +276,64 @@ thunar_clipboard_manager_get_property (GObject    *object,
 
 
 static void
-thunar_clipboard_manager_file_destroyed (ThunarFile             *file,
+thunar_clipboard_manager_file_changed (ThunarFileMonitor      *file_monitor,
+                                       ThunarFile             *file,
+                                       ThunarClipboardManager *manager)
+{
+  _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
+
+  /* a renamed file changes the contents */
+  if (G_UNLIKELY (g_hash_table_contains (manager->files_table, file)))
+    thunar_clipboard_manager_drop_contents (manager);
+}
+
+
+
+static void
+thunar_clipboard_manager_file_destroyed (ThunarFileMonitor      *file_monitor,
+                                         ThunarFile             *file,
                                          ThunarClipboardManager *manager)
 {
+  GList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
-  _thunar_return_if_fail (g_list_find (manager->files, file) != NULL);
 
-  /* remove the file from our list */
-  manager->files = g_list_remove (manager->files, file);
+  lp = g_hash_table_lookup (manager->files_table, file);
+  if (G_LIKELY (lp == NULL))
+    return;
 
-  /* disconnect from the file */
-  g_signal_handlers_disconnect_by_func (G_OBJECT (file), thunar_clipboard_manager_file_destroyed, manager);
+  /* remove the file from our list */
+  g_hash_table_remove (manager->files_table, file);
+  manager->files = g_list_delete_link (manager->files, lp);
   g_object_unref (G_OBJECT (file));
+
+  thunar_clipboard_manager_drop_contents (manager);
+}
+
+
+
+static void
+thunar_clipboard_manager_release_files (ThunarClipboardManager *manager)
+{
+  g_hash_table_remove_all (manager->files_table);
+  thunar_g_list_free_full (manager->files);
+  manager->files = NULL;
+
+  thunar_clipboard_manager_drop_contents (manager);
+}
+
+
+
+static void
+thunar_clipboard_manager_drop_contents (ThunarClipboardManager *manager)
+{
+  guint n;
+
+  for (n = 0; n < N_TARGETS; ++n)
+    {
+      g_free (manager->contents[n]);
+      manager->contents[n] = NULL;
+    }
 }
 
 
@@ -289,45 +360,47 @@ thunar_clipboard_manager_owner_changed (GtkClipboard           *clipboard,
 
 
 static void
-thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
-                                            GtkSelectionData *selection_data,
-                                            gpointer          user_data)
+thunar_clipboard_manager_paste_request_free (ThunarClipboardPasteRequest *request)
 {
-  ThunarClipboardPasteRequest *request = user_data;
-  ThunarClipboardManager      *manager = THUNAR_CLIPBOARD_MANAGER (request->manager);
-  ThunarApplication           *application;
-  gboolean                     path_copy = TRUE;
-  GList                       *file_list = NULL;
-  gchar                       *data;
+  if (G_LIKELY (request->widget != NULL))
+    g_object_remove_weak_pointer (G_OBJECT (request->widget), (gpointer) &request->widget);
+  if (G_LIKELY (request->new_files_closure != NULL))
+    g_closure_unref (request->new_files_closure);
+  g_object_unref (G_OBJECT (request->manager));
+  g_object_unref (request->target_file);
+  g_slice_free (ThunarClipboardPasteRequest, request);
+}
 
-  /* check whether the retrieval worked */
-  if (G_LIKELY (gtk_selection_data_get_length (selection_data) > 0))
-    {
-      /* be sure the selection data is zero-terminated */
-      data = (gchar *) gtk_selection_data_get_data (selection_data);
-      data[gtk_selection_data_get_length (selection_data)] = '\0';
 
-      /* check whether to copy or move */
-      if (g_ascii_strncasecmp (data, "copy\n", 5) == 0)
-        {
-          path_copy = TRUE;
-          data += 5;
-        }
-      else if (g_ascii_strncasecmp (data, "cut\n", 4) == 0)
-        {
-          path_copy = FALSE;
-          data += 4;
-        }
 
-      /* determine the path list stored with the selection */
-      file_list = thunar_g_file_list_new_from_string (data);
-    }
+static void
+thunar_clipboard_manager_parse_thread (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable)
+{
+  g_task_return_pointer (task, thunar_g_file_list_new_from_string (task_data), (GDestroyNotify) thunar_g_list_free_full);
+}
+
+
+
+static void
+thunar_clipboard_manager_contents_parsed (GObject      *object,
+                                          GAsyncResult *result,
+                                          gpointer      user_data)
+{
+  ThunarClipboardPasteRequest *request = user_data;
+  ThunarClipboardManager      *manager = THUNAR_CLIPBOARD_MANAGER (object);
+  ThunarApplication           *application;
+  GList                       *file_list;
+
+  file_list = g_task_propagate_pointer (G_TASK (result), NULL);
 
   /* perform the action if possible */
   if (G_LIKELY (file_list != NULL))
     {
       application = thunar_application_get ();
-      if (G_LIKELY (path_copy))
+      if (G_LIKELY (request->path_copy))
         thunar_application_copy_into (application, request->widget, file_list, request->target_file, request->new_files_closure);
       else
         thunar_application_move_into (application, request->widget, file_list, request->target_file, request->new_files_closure);
@@ -338,7 +411,7 @@ thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
        * (gtk_clipboard_clear takes care of not clearing
        * the selection if we don't own it)
        */
-      if (G_UNLIKELY (!path_copy))
+      if (G_UNLIKELY (!request->path_copy))
         gtk_clipboard_clear (manager->clipboard);
 
       /* check the contents of the clipboard again if either the Xserver or
@@ -354,14 +427,51 @@ thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
       thunar_dialogs_show_error (request->widget, NULL, _("There is nothing on the clipboard to paste"));
     }
 
-  /* free the request */
-  if (G_LIKELY (request->widget != NULL))
-    g_object_remove_weak_pointer (G_OBJECT (request->widget), (gpointer) &request->widget);
-  if (G_LIKELY (request->new_files_closure != NULL))
-    g_closure_unref (request->new_files_closure);
-  g_object_unref (G_OBJECT (request->manager));
-  g_object_unref (request->target_file);
-  g_slice_free (ThunarClipboardPasteRequest, request);
+  thunar_clipboard_manager_paste_request_free (request);
+}
+
+
+
+static void
+thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
+                                            GtkSelectionData *selection_data,
+                                            gpointer          user_data)
+{
+  ThunarClipboardPasteRequest *request = user_data;
+  const gchar                 *data;
+  GTask                       *task;
+  gint                         length;
+
+  /* check whether the retrieval worked */
+  length = gtk_selection_data_get_length (selection_data);
+  if (G_UNLIKELY (length <= 0))
+    {
+      /* tell the user that we cannot paste */
+      thunar_dialogs_show_error (request->widget, NULL, _("There is nothing on the clipboard to paste"));
+      thunar_clipboard_manager_paste_request_free (request);
+      return;
+    }
+
+  /* check whether to copy or move */
+  data = (const gchar *) gtk_selection_data_get_data (selection_data);
+  request->path_copy = TRUE;
+  if (length >= 5 && g_ascii_strncasecmp (data, "copy\n", 5) == 0)
+    {
+      data += 5;
+      length -= 5;
+    }
+  else if (length >= 4 && g_ascii_strncasecmp (data, "cut\n", 4) == 0)
+    {
+      request->path_copy = FALSE;
+      data += 4;
+      length -= 4;
+    }
+
+  /* the path list can be huge, so parse it in a thread */
+  task = g_task_new (request->manager, NULL, thunar_clipboard_manager_contents_parsed, request);
+  g_task_set_task_data (task, g_strndup (data, length), g_free);
+  g_task_run_in_thread (task, thunar_clipboard_manager_parse_thread);
+  g_object_unref (task);
 }
 
 
@@ -407,24 +517,30 @@ thunar_clipboard_manager_targets_received (GtkClipboard     *clipboard,
 
 
 static gchar *
-thunar_clipboard_manager_g_file_list_to_string (GList       *list,
-                                                const gchar *prefix,
-                                                gboolean     format_for_text,
-                                                gsize       *len)
+thunar_clipboard_manager_build_contents (ThunarClipboardManager *manager,
+                                         guint                   target_info,
+                                         gsize                  *len)
 {
   GString *string;
   gchar   *tmp;
   GList   *lp;
 
-  /* allocate initial string */
-  string = g_string_new (prefix);
+  /* the same uri list as for dragging the files */
+  if (target_info == TARGET_TEXT_URI_LIST)
+    return thunar_file_list_to_uri_list (manager->files, len);
+
+  /* allocate the string once for the usual length of an uri */
+  string = g_string_sized_new (g_hash_table_size (manager->files_table) * 64);
+
+  if (target_info == TARGET_GNOME_COPIED_FILES)
+    string = g_string_append (string, manager->files_cutted ? "cut\n" : "copy\n");
 
-  for (lp = list; lp != NULL; lp = lp->next)
+  for (lp = manager->files; lp != NULL; lp = lp->next)
     {
-      if (format_for_text)
-        tmp = g_file_get_parse_name (G_FILE (lp->data));
+      if (target_info == TARGET_UTF8_STRING)
+        tmp = g_file_get_parse_name (thunar_file_get_file (lp->data));
       else
-        tmp = g_file_get_uri (G_FILE (lp->data));
+        tmp = g_file_get_uri (thunar_file_get_file (lp->data));
 
       string = g_string_append (string, tmp);
       g_free (tmp);
@@ -433,8 +549,7 @@ thunar_clipboard_manager_g_file_list_to_string (GList       *list,
         string = g_string_append_c (string, '\n');
     }
 
-  if (len != NULL)
-    *len = string->len;
+  *len = string->len;
 
   return g_string_free (string, FALSE);
 }
@@ -447,47 +562,33 @@ thunar_clipboard_manager_get_callback (GtkClipboard     *clipboard,
                                        guint             target_info,
                                        gpointer          user_data)
 {
-  ThunarClipboardManager  *manager = THUNAR_CLIPBOARD_MANAGER (user_data);
-  GList                   *file_list;
-  gchar                   *str;
-  gchar                  **uris;
-  const gchar             *prefix;
-  gsize                    len;
+  ThunarClipboardManager *manager = THUNAR_CLIPBOARD_MANAGER (user_data);
 
   _thunar_return_if_fail (GTK_IS_CLIPBOARD (clipboard));
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
   _thunar_return_if_fail (manager->clipboard == clipboard);
+  _thunar_return_if_fail (target_info < N_TARGETS);
 
-  /* determine the path list from the file list */
-  file_list = thunar_file_list_to_thunar_g_file_list (manager->files);
+  /* clipboard managers and pasting applications often ask for the
+   * same contents several times, so build them only once */
+  if (manager->contents[target_info] == NULL)
+    manager->contents[target_info] = thunar_clipboard_manager_build_contents (manager, target_info, &manager->contents_length[target_info]);
 
   switch (target_info)
     {
     case TARGET_TEXT_URI_LIST:
-      uris = thunar_g_file_list_to_stringv (file_list);
-      gtk_selection_data_set_uris (selection_data, uris);
-      g_strfreev (uris);
-      break;
-
     case TARGET_GNOME_COPIED_FILES:
-      prefix = manager->files_cutted ? "cut\n" : "copy\n";
-      str = thunar_clipboard_manager_g_file_list_to_string (file_list, prefix, FALSE, &len);
-      gtk_selection_data_set (selection_data, gtk_selection_data_get_target (selection_data), 8, (guchar *) str, len);
-      g_free (str);
+      gtk_selection_data_set (selection_data, gtk_selection_data_get_target (selection_data), 8,
+                              (const guchar *) manager->contents[target_info], manager->contents_length[target_info]);
       break;
 
     case TARGET_UTF8_STRING:
-      str = thunar_clipboard_manager_g_file_list_to_string (file_list, NULL, TRUE, &len);
-      gtk_selection_data_set_text (selection_data, str, len);
-      g_free (str);
+      gtk_selection_data_set_text (selection_data, manager->contents[target_info], manager->contents_length[target_info]);
       break;
 
     default:
       _thunar_assert_not_reached ();
     }
-
-  /* cleanup */
-  thunar_g_list_free_full (file_list);
 }
 
 
@@ -497,20 +598,13 @@ thunar_clipboard_manager_clear_callback (GtkClipboard *clipboard,
                                          gpointer      user_data)
 {
   ThunarClipboardManager *manager = THUNAR_CLIPBOARD_MANAGER (user_data);
-  GList                  *lp;
 
   _thunar_return_if_fail (GTK_IS_CLIPBOARD (clipboard));
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
   _thunar_return_if_fail (manager->clipboard == clipboard);
 
   /* release the pending files */
-  for (lp = manager->files; lp != NULL; lp = lp->next)
-    {
-      g_signal_handlers_disconnect_by_func (G_OBJECT (lp->data), thunar_clipboard_manager_file_destroyed, manager);
-      g_object_unref (G_OBJECT (lp->data));
-    }
-  g_list_free (manager->files);
-  manager->files = NULL;
+  thunar_clipboard_manager_release_files (manager);
 }
 
 
@@ -520,26 +614,23 @@ thunar_clipboard_manager_transfer_files (ThunarClipboardManager *manager,
                                          gboolean                copy,
                                          GList                  *files)
 {
-  ThunarFile *file;
-  GList      *lp;
+  GList *lp;
 
   /* release any pending files */
-  for (lp = manager->files; lp != NULL; lp = lp->next)
-    {
-      g_signal_handlers_disconnect_by_func (G_OBJECT (lp->data), thunar_clipboard_manager_file_destroyed, manager);
-      g_object_unref (G_OBJECT (lp->data));
-    }
-  g_list_free (manager->files);
+  thunar_clipboard_manager_release_files (manager);
 
   /* remember the transfer operation */
   manager->files_cutted = !copy;
 
   /* setup the new file list */
-  for (lp = g_list_last (files), manager->files = NULL; lp != NULL; lp = lp->prev)
+  for (lp = g_list_last (files); lp != NULL; lp = lp->prev)
     {
-      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
-      manager->files = g_list_prepend (manager->files, file);
-      g_signal_connect (G_OBJECT (file), "destroy", G_CALLBACK (thunar_clipboard_manager_file_destroyed), manager);
+      /* a file selected twice is only put on the clipboard once */
+      if (G_UNLIKELY (g_hash_table_contains (manager->files_table, lp->data)))
+        continue;
+
+      manager->files = g_list_prepend (manager->files, g_object_ref (G_OBJECT (lp->data)));
+      g_hash_table_insert (manager->files_table, lp->data, manager->files);
     }
 
   /* acquire the CLIPBOARD ownership */
@@ -644,7 +735,7 @@ thunar_clipboard_manager_has_cutted_file (ThunarClipboardManager *manager,
   _thunar_return_val_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
 
-  return (manager->files_cutted && g_list_find (manager->files, file) != NULL);
+  return (manager->files_cutted && g_hash_table_contains (manager->files_table, file));
 }
 
 
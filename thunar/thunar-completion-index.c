@@ -0,0 +1,438 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-completion-index.h>
+#include <thunar/thunar-file-monitor.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The completion index keeps the casefolded display names of the files
+ * in a folder in a sorted array, so the files starting with a prefix are
+ * found with a binary search instead of checking every file.
+ *
+ * The index follows the "files-added" and "files-removed" signals of the
+ * folder, so it grows while the folder is still being loaded. New files
+ * are appended and merged into the sorted part on the next lookup, and
+ * removed files stay behind as tombstones until then.
+ */
+
+
+
+typedef struct
+{
+  gchar      *key;
+  gchar      *name;
+  ThunarFile *file;
+}
+CompletionEntry;
+
+struct _ThunarCompletionIndex
+{
+  ThunarFileMonitor *file_monitor;
+  ThunarFile        *directory;
+
+  /* the first n_sorted entries are sorted by key */
+  GPtrArray         *entries;
+  guint              n_sorted;
+  guint              n_removed;
+
+  /* maps the files to their entries */
+  GHashTable        *files;
+};
+
+
+
+static GQuark thunar_completion_index_quark = 0;
+
+
+
+static void
+thunar_completion_index_free_entry (CompletionEntry *entry)
+{
+  if (G_LIKELY (entry->file != NULL))
+    g_object_unref (G_OBJECT (entry->file));
+  g_free (entry->name);
+  g_free (entry->key);
+  g_slice_free (CompletionEntry, entry);
+}
+
+
+
+static void
+thunar_completion_index_forget (ThunarCompletionIndex *completion_index,
+                                CompletionEntry       *entry)
+{
+  /* leave a tombstone, which is dropped on the next merge */
+  g_hash_table_remove (completion_index->files, entry->file);
+  g_object_unref (G_OBJECT (entry->file));
+  entry->file = NULL;
+  completion_index->n_removed++;
+}
+
+
+
+static void
+thunar_completion_index_add (ThunarCompletionIndex *completion_index,
+                             ThunarFile            *file)
+{
+  CompletionEntry *entry;
+
+  /* a file that is indexed already was renamed */
+  entry = g_hash_table_lookup (completion_index->files, file);
+  if (G_UNLIKELY (entry != NULL))
+    thunar_completion_index_forget (completion_index, entry);
+
+  entry = g_slice_new (CompletionEntry);
+  entry->name = g_strdup (thunar_file_get_display_name (file));
+  entry->key = thunar_completion_index_make_key (entry->name);
+  entry->file = g_object_ref (G_OBJECT (file));
+
+  g_ptr_array_add (completion_index->entries, entry);
+  g_hash_table_insert (completion_index->files, file, entry);
+}
+
+
+
+static void
+thunar_completion_index_files_added (ThunarFolder          *folder,
+                                     GList                 *files,
+                                     ThunarCompletionIndex *completion_index)
+{
+  GList *lp;
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    thunar_completion_index_add (completion_index, lp->data);
+}
+
+
+
+static void
+thunar_completion_index_files_removed (ThunarFolder          *folder,
+                                       GList                 *files,
+                                       ThunarCompletionIndex *completion_index)
+{
+  CompletionEntry *entry;
+  GList           *lp;
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      entry = g_hash_table_lookup (completion_index->files, lp->data);
+      if (G_LIKELY (entry != NULL))
+        thunar_completion_index_forget (completion_index, entry);
+    }
+}
+
+
+
+static void
+thunar_completion_index_file_changed (ThunarFileMonitor     *file_monitor,
+                                      ThunarFile            *file,
+                                      ThunarCompletionIndex *completion_index)
+{
+  CompletionEntry *entry;
+
+  /* re-index the file if its display name changed */
+  entry = g_hash_table_lookup (completion_index->files, file);
+  if (G_UNLIKELY (entry != NULL && strcmp (entry->name, thunar_file_get_display_name (file)) != 0))
+    thunar_completion_index_add (completion_index, file);
+}
+
+
+
+static gint
+thunar_completion_index_compare (gconstpointer a,
+                                 gconstpointer b,
+                                 gpointer      user_data)
+{
+  const CompletionEntry *entry_a = *((const CompletionEntry **) a);
+  const CompletionEntry *entry_b = *((const CompletionEntry **) b);
+
+  return strcmp (entry_a->key, entry_b->key);
+}
+
+
+
+static void
+thunar_completion_index_merge (ThunarCompletionIndex *completion_index)
+{
+  CompletionEntry **entries = (CompletionEntry **) completion_index->entries->pdata;
+  CompletionEntry  *entry;
+  GPtrArray        *merged;
+  guint             n_entries = completion_index->entries->len;
+  guint             i, j;
+
+  /* nothing new and only a few tombstones, which do not hurt a lookup */
+  if (G_LIKELY (completion_index->n_sorted == n_entries
+                && completion_index->n_removed <= n_entries / 4))
+    return;
+
+  /* sort the entries added since the last merge */
+  g_qsort_with_data (entries + completion_index->n_sorted,
+                     n_entries - completion_index->n_sorted,
+                     sizeof (CompletionEntry *),
+                     thunar_completion_index_compare, NULL);
+
+  /* merge both sorted parts and drop the tombstones */
+  merged = g_ptr_array_sized_new (n_entries - completion_index->n_removed);
+  for (i = 0, j = completion_index->n_sorted; i < completion_index->n_sorted || j < n_entries;)
+    {
+      if (j >= n_entries || (i < completion_index->n_sorted && strcmp (entries[i]->key, entries[j]->key) <= 0))
+        entry = entries[i++];
+      else
+        entry = entries[j++];
+
+      if (G_UNLIKELY (entry->file == NULL))
+        thunar_completion_index_free_entry (entry);
+      else
+        g_ptr_array_add (merged, entry);
+    }
+
+  g_ptr_array_free (completion_index->entries, TRUE);
+  completion_index->entries = merged;
+  completion_index->n_sorted = merged->len;
+  completion_index->n_removed = 0;
+}
+
+
+
+static void
+thunar_completion_index_free (gpointer data)
+{
+  ThunarCompletionIndex *completion_index = data;
+  guint                  n;
+
+  thunar_file_monitor_unwatch (completion_index->file_monitor, completion_index->directory, completion_index);
+  g_object_unref (G_OBJECT (completion_index->file_monitor));
+  g_object_unref (G_OBJECT (completion_index->directory));
+
+  g_hash_table_destroy (completion_index->files);
+  for (n = 0; n < completion_index->entries->len; ++n)
+    thunar_completion_index_free_entry (g_ptr_array_index (completion_index->entries, n));
+  g_ptr_array_free (completion_index->entries, TRUE);
+  g_slice_free (ThunarCompletionIndex, completion_index);
+}
+
+
+
+/**
+ * thunar_completion_index_get_for_folder:
+ * @folder : a #ThunarFolder.
+ *
+ * Returns the completion index for the files in @folder, which is
+ * created the first time it is requested and kept up to date until
+ * @folder is finalized.
+ *
+ * Return value: the #ThunarCompletionIndex owned by @folder.
+ **/
+ThunarCompletionIndex*
+thunar_completion_index_get_for_folder (ThunarFolder *folder)
+{
+  ThunarCompletionIndex *completion_index;
+  GList                 *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), NULL);
+
+  if (G_UNLIKELY (thunar_completion_index_quark == 0))
+    thunar_completion_index_quark = g_quark_from_static_string ("thunar-completion-index");
+
+  completion_index = g_object_get_qdata (G_OBJECT (folder), thunar_completion_index_quark);
+  if (G_LIKELY (completion_index != NULL))
+    return completion_index;
+
+  completion_index = g_slice_new0 (ThunarCompletionIndex);
+  completion_index->entries = g_ptr_array_new ();
+  completion_index->files = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* index the files loaded so far, the rest follows with "files-added" */
+  for (lp = thunar_folder_get_files (folder); lp != NULL; lp = lp->next)
+    thunar_completion_index_add (completion_index, lp->data);
+
+  g_signal_connect (G_OBJECT (folder), "files-added", G_CALLBACK (thunar_completion_index_files_added), completion_index);
+  g_signal_connect (G_OBJECT (folder), "files-removed", G_CALLBACK (thunar_completion_index_files_removed), completion_index);
+
+  /* watch for renamed files */
+  completion_index->file_monitor = thunar_file_monitor_get_default ();
+  completion_index->directory = g_object_ref (thunar_folder_get_corresponding_file (folder));
+  thunar_file_monitor_watch (completion_index->file_monitor, completion_index->directory,
+                             THUNAR_FILE_MONITOR_WATCH_CHILDREN,
+                             (ThunarFileMonitorFunc) thunar_completion_index_file_changed,
+                             NULL, completion_index);
+
+  /* the signal handlers of the folder are gone before the qdata is freed */
+  g_object_set_qdata_full (G_OBJECT (folder), thunar_completion_index_quark, completion_index, thunar_completion_index_free);
+
+  return completion_index;
+}
+
+
+
+/**
+ * thunar_completion_index_make_key:
+ * @text : a file name or the part of one typed by the user.
+ *
+ * Returns the normalized and casefolded form of @text, which is
+ * used to compare names in the completion index.
+ *
+ * The caller is responsible to free the returned string using
+ * g_free() when no longer needed.
+ *
+ * Return value: the key for @text.
+ **/
+gchar*
+thunar_completion_index_make_key (const gchar *text)
+{
+  gchar *normalized;
+  gchar *key;
+
+  _thunar_return_val_if_fail (text != NULL, NULL);
+
+  /* invalid UTF-8 is compared as is */
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  if (G_UNLIKELY (normalized == NULL))
+    return g_strdup (text);
+
+  key = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return key;
+}
+
+
+
+/**
+ * thunar_completion_index_has_prefix:
+ * @completion_index : a #ThunarCompletionIndex.
+ * @file             : a #ThunarFile.
+ * @key              : a key from thunar_completion_index_make_key().
+ *
+ * Checks whether the name of @file starts with @key, without
+ * casefolding the name again.
+ *
+ * Return value: %TRUE if @file is indexed and matches @key.
+ **/
+gboolean
+thunar_completion_index_has_prefix (ThunarCompletionIndex *completion_index,
+                                    ThunarFile            *file,
+                                    const gchar           *key)
+{
+  CompletionEntry *entry;
+
+  _thunar_return_val_if_fail (completion_index != NULL, FALSE);
+  _thunar_return_val_if_fail (key != NULL, FALSE);
+
+  entry = g_hash_table_lookup (completion_index->files, file);
+  return (entry != NULL && g_str_has_prefix (entry->key, key));
+}
+
+
+
+/**
+ * thunar_completion_index_lookup:
+ * @completion_index : a #ThunarCompletionIndex.
+ * @key              : a key from thunar_completion_index_make_key().
+ * @prefix_return    : return location for the common prefix.
+ *
+ * Looks up the files whose names start with @key and stores the longest
+ * common prefix of their names in @prefix_return, or %NULL if no name
+ * matches. The caller is responsible to free the prefix using g_free().
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the matching #ThunarFile if exactly one name matches,
+ *               %NULL otherwise.
+ **/
+ThunarFile*
+thunar_completion_index_lookup (ThunarCompletionIndex *completion_index,
+                                const gchar           *key,
+                                gchar                **prefix_return)
+{
+  CompletionEntry *entry;
+  ThunarFile      *file = NULL;
+  const gchar     *s;
+  gchar           *t;
+  guint            lower;
+  guint            upper;
+  guint            middle;
+  guint            n;
+
+  _thunar_return_val_if_fail (completion_index != NULL, NULL);
+  _thunar_return_val_if_fail (key != NULL, NULL);
+  _thunar_return_val_if_fail (prefix_return != NULL, NULL);
+
+  *prefix_return = NULL;
+
+  thunar_completion_index_merge (completion_index);
+
+  /* find the first entry not sorted before the key */
+  for (lower = 0, upper = completion_index->entries->len; lower < upper;)
+    {
+      middle = lower + (upper - lower) / 2;
+      entry = g_ptr_array_index (completion_index->entries, middle);
+      if (strcmp (entry->key, key) < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  /* all matching entries follow each other */
+  for (n = lower; n < completion_index->entries->len; ++n)
+    {
+      entry = g_ptr_array_index (completion_index->entries, n);
+      if (!g_str_has_prefix (entry->key, key))
+        break;
+
+      /* skip removed files */
+      if (G_UNLIKELY (entry->file == NULL))
+        continue;
+
+      if (*prefix_return == NULL)
+        {
+          /* remember the first match */
+          *prefix_return = g_strdup (entry->name);
+          file = g_object_ref (G_OBJECT (entry->file));
+        }
+      else
+        {
+          /* we already have another prefix, so determine the common part */
+          for (s = entry->name, t = *prefix_return; *s != '\0' && *s == *t; ++s, ++t)
+            ;
+          *t = '\0';
+
+          /* release the file, since it's not a unique match */
+          if (G_LIKELY (file != NULL))
+            {
+              g_object_unref (G_OBJECT (file));
+              file = NULL;
+            }
+        }
+    }
+
+  return file;
+}
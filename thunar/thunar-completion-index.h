@@ -0,0 +1,44 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_COMPLETION_INDEX_H__
+#define __THUNAR_COMPLETION_INDEX_H__
+
+#include <thunar/thunar-folder.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarCompletionIndex ThunarCompletionIndex;
+
+ThunarCompletionIndex *thunar_completion_index_get_for_folder (ThunarFolder          *folder);
+
+gchar                 *thunar_completion_index_make_key       (const gchar           *text);
+
+gboolean               thunar_completion_index_has_prefix     (ThunarCompletionIndex *completion_index,
+                                                               ThunarFile            *file,
+                                                               const gchar           *key);
+
+ThunarFile            *thunar_completion_index_lookup         (ThunarCompletionIndex *completion_index,
+                                                               const gchar           *key,
+                                                               gchar                **prefix_return);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_COMPLETION_INDEX_H__ */
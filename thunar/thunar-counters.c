@@ -0,0 +1,151 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-counters.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* Counters of the objects that are expensive to keep around, and a
+ * histogram of how long the main loop was busy between two polls.
+ * They are always on and read through the org.xfce.Thunar.Debug
+ * interface of the ThunarDBusService.
+ */
+
+
+
+gint thunar_counters[THUNAR_N_COUNTERS];
+
+/* the upper limits of the stall bins in milliseconds, the last
+ * bin takes everything above the previous limit */
+static const guint stall_limits[] = { 16, 50, 100, 250, 500, 1000, 5000, G_MAXUINT };
+
+static guint64   stall_bins[G_N_ELEMENTS (stall_limits)];
+static gint64    stall_poll_return = 0;
+static GPollFunc stall_poll_func = NULL;
+
+/* bumped before and after every poll, so it is odd while dispatching */
+static gint      loop_iteration = 0;
+
+
+
+static gint
+thunar_counters_poll (GPollFD *ufds,
+                      guint    nfds,
+                      gint     timeout)
+{
+  gint64 stall_ms;
+  guint  n;
+  gint   result;
+
+  /* the time since the last poll returned was spent dispatching */
+  if (G_LIKELY (stall_poll_return != 0))
+    {
+      stall_ms = (g_get_monotonic_time () - stall_poll_return) / 1000;
+      for (n = 0; n < G_N_ELEMENTS (stall_limits) - 1 && stall_ms >= (gint64) stall_limits[n]; ++n)
+        ;
+      stall_bins[n]++;
+    }
+
+  g_atomic_int_inc (&loop_iteration);
+  result = (*stall_poll_func) (ufds, nfds, timeout);
+  g_atomic_int_inc (&loop_iteration);
+
+  stall_poll_return = g_get_monotonic_time ();
+
+  return result;
+}
+
+
+
+/**
+ * thunar_counters_watch_main_loop:
+ *
+ * Starts recording how long the default main loop is busy between
+ * two polls. Must be called from the main thread and only once.
+ **/
+void
+thunar_counters_watch_main_loop (void)
+{
+  GMainContext *context = g_main_context_default ();
+
+  _thunar_return_if_fail (stall_poll_func == NULL);
+
+  stall_poll_func = g_main_context_get_poll_func (context);
+  g_main_context_set_poll_func (context, thunar_counters_poll);
+}
+
+
+
+/**
+ * thunar_counters_get_main_loop_iteration:
+ *
+ * Returns a number that changes whenever the main loop starts or stops
+ * polling. It is odd while the main loop dispatches sources, so another
+ * thread can tell from two equal odd values that the main loop is busy.
+ * May be called from any thread.
+ *
+ * Return value: the current main loop iteration.
+ **/
+guint
+thunar_counters_get_main_loop_iteration (void)
+{
+  return g_atomic_int_get (&loop_iteration);
+}
+
+
+
+/**
+ * thunar_counters_get_n_stall_bins:
+ *
+ * Return value: the number of bins of the main loop stall histogram.
+ **/
+guint
+thunar_counters_get_n_stall_bins (void)
+{
+  return G_N_ELEMENTS (stall_limits);
+}
+
+
+
+/**
+ * thunar_counters_get_stall_bin:
+ * @n        : the index of the bin, smaller than thunar_counters_get_n_stall_bins().
+ * @limit_ms : return location for the upper limit of the bin in
+ *             milliseconds, %G_MAXUINT for the last bin.
+ *
+ * Return value: the number of main loop iterations that took less than
+ *               @limit_ms, but at least the limit of the previous bin.
+ **/
+guint64
+thunar_counters_get_stall_bin (guint  n,
+                               guint *limit_ms)
+{
+  _thunar_return_val_if_fail (n < G_N_ELEMENTS (stall_limits), 0);
+
+  if (limit_ms != NULL)
+    *limit_ms = stall_limits[n];
+
+  return stall_bins[n];
+}
@@ -0,0 +1,52 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_COUNTERS_H__
+#define __THUNAR_COUNTERS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* live objects, counted where they are created and released */
+typedef enum
+{
+  THUNAR_COUNTER_FOLDERS,
+  THUNAR_COUNTER_MONITORS,
+  THUNAR_COUNTER_THUMBNAIL_REQUESTS,
+  THUNAR_N_COUNTERS
+} ThunarCounter;
+
+extern gint thunar_counters[THUNAR_N_COUNTERS];
+
+#define thunar_counters_inc(counter) (g_atomic_int_inc (&thunar_counters[(counter)]))
+#define thunar_counters_dec(counter) (g_atomic_int_add (&thunar_counters[(counter)], -1))
+#define thunar_counters_get(counter) (g_atomic_int_get (&thunar_counters[(counter)]))
+
+void     thunar_counters_watch_main_loop          (void);
+guint    thunar_counters_get_main_loop_iteration  (void);
+
+guint    thunar_counters_get_n_stall_bins         (void);
+guint64  thunar_counters_get_stall_bin            (guint  n,
+                                                   guint *limit_ms);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_COUNTERS_H__ */
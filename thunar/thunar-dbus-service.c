@@ -23,6 +23,9 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
 #ifdef HAVE_MEMORY_H
 #include <memory.h>
 #endif
@@ -36,13 +39,21 @@
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-chooser-dialog.h>
+#include <thunar/thunar-counters.h>
 #include <thunar/thunar-dbus-service.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-gdk-extensions.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-icon-factory.h>
+#include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-memory.h>
+#include <thunar/thunar-monitor-pool.h>
 #include <thunar/thunar-preferences-dialog.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-properties-dialog.h>
+#include <thunar/thunar-transfer-job.h>
 #include <thunar/thunar-util.h>
+#include <thunar/thunar-watchdog.h>
 
 
 
@@ -52,14 +63,70 @@
 
 
 
+/* changes of the trash bin are collected this long before "trash-changed" is emitted */
+#define THUNAR_DBUS_SERVICE_TRASH_CHANGED_DELAY (250)
+
+/* the shortest interval in milliseconds between two "job-progress" signals */
+#define THUNAR_DBUS_SERVICE_PROGRESS_MIN_INTERVAL (100)
+
+
+
 typedef enum
 {
   THUNAR_DBUS_TRANSFER_MODE_COPY_TO,
   THUNAR_DBUS_TRANSFER_MODE_COPY_INTO,
+  THUNAR_DBUS_TRANSFER_MODE_UPDATE_INTO,
   THUNAR_DBUS_TRANSFER_MODE_MOVE_INTO,
   THUNAR_DBUS_TRANSFER_MODE_LINK_INTO,
 } ThunarDBusTransferMode;
 
+typedef enum
+{
+  THUNAR_DBUS_BATCH_COPY,
+  THUNAR_DBUS_BATCH_MOVE,
+  THUNAR_DBUS_BATCH_LINK,
+  THUNAR_DBUS_BATCH_TRASH,
+  THUNAR_DBUS_BATCH_UNLINK,
+} ThunarDBusBatchKind;
+
+typedef struct
+{
+  ThunarDBusBatchKind kind;
+  GList              *source_file_list;
+  GList              *target_file_list;
+} ThunarDBusBatchJob;
+
+typedef struct
+{
+  ThunarDBusService *dbus_service;
+  guint              id;
+  GdkScreen         *screen;
+
+  /* the jobs that still have to run */
+  GQueue             jobs;
+  guint              n_jobs;
+  guint              n_finished;
+
+  /* the running job and its first error */
+  ThunarJob         *job;
+  gchar             *error_message;
+  guint              next_idle_id;
+} ThunarDBusBatch;
+
+typedef struct
+{
+  guint interval;
+  guint watch_id;
+} ThunarDBusProgressSubscriber;
+
+typedef struct
+{
+  gint64  time;
+  guint   n_files_done;
+  gdouble files_per_second;
+  guint   generation;
+} ThunarDBusJobSample;
+
 
 static void     thunar_dbus_service_finalize                    (GObject                *object);
 static gboolean thunar_dbus_service_connect_trash_bin           (ThunarDBusService      *dbus_service,
@@ -79,6 +146,8 @@ static gboolean thunar_dbus_service_transfer_files              (ThunarDBusTrans
                                                                  GError                **error);
 static void     thunar_dbus_service_trash_bin_changed           (ThunarDBusService      *dbus_service,
                                                                  ThunarFile             *trash_bin);
+static gboolean thunar_dbus_service_trash_changed_timer         (gpointer                user_data);
+static gboolean thunar_dbus_service_trash_idle                  (gpointer                user_data);
 static gboolean thunar_dbus_service_display_chooser_dialog      (ThunarDBusFileManager  *object,
                                                                  GDBusMethodInvocation  *invocation,
                                                                  const gchar            *uri,
@@ -194,6 +263,14 @@ static gboolean thunar_dbus_service_copy_into                   (ThunarDBusFileM
                                                                  const gchar            *display,
                                                                  const gchar            *startup_id,
                                                                  ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_update_into                 (ThunarDBusFileManager  *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 const gchar            *working_directory,
+                                                                 gchar                 **source_filenames,
+                                                                 const gchar            *target_filename,
+                                                                 const gchar            *display,
+                                                                 const gchar            *startup_id,
+                                                                 ThunarDBusService      *dbus_service);
 static gboolean thunar_dbus_service_move_into                   (ThunarDBusFileManager  *object,
                                                                  GDBusMethodInvocation  *invocation,
                                                                  const gchar            *working_directory,
@@ -217,9 +294,45 @@ static gboolean thunar_dbus_service_unlink_files                (ThunarDBusFileM
                                                                  const gchar            *display,
                                                                  const gchar            *startup_id,
                                                                  ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_execute_batch               (ThunarDBusFileManager  *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 const gchar            *working_directory,
+                                                                 GVariant               *operations,
+                                                                 const gchar            *display,
+                                                                 const gchar            *startup_id,
+                                                                 ThunarDBusService      *dbus_service);
+static void     thunar_dbus_service_batch_free                  (ThunarDBusBatch        *batch);
+static void     thunar_dbus_service_batch_finished              (ThunarDBusBatch        *batch);
+static gboolean thunar_dbus_service_list_jobs                   (ThunarDBusThunar       *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_subscribe_job_progress      (ThunarDBusThunar       *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 guint                   interval,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_unsubscribe_job_progress    (ThunarDBusThunar       *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static void     thunar_dbus_service_progress_subscriber_free    (gpointer                data);
 static gboolean thunar_dbus_service_terminate                   (ThunarDBusThunar       *object,
                                                                  GDBusMethodInvocation  *invocation,
                                                                  ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_make_thumbnails             (ThunarDBusThunar       *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 const gchar            *uri,
+                                                                 gboolean                recursive,
+                                                                 const gchar            *display,
+                                                                 const gchar            *startup_id,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_get_counters                (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_get_stalls                  (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_get_memory                  (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
 
 static gboolean thunar_dbus_freedesktop_show_folders            (ThunarOrgFreedesktopFileManager1 *object,
                                                                  GDBusMethodInvocation            *invocation,
@@ -250,9 +363,30 @@ struct _ThunarDBusService
   ThunarDBusFileManager            *file_manager;
   ThunarDBusTrash                  *trash;
   ThunarDBusThunar                 *thunar;
+  ThunarDBusDebug                  *debug;
   ThunarOrgFreedesktopFileManager1 *file_manager_fdo;
 
   ThunarFile      *trash_bin;
+
+  /* coalesces the "trash-changed" emissions while files are trashed */
+  guint            trash_changed_timer_id;
+
+  /* connects to the trash bin once the startup is done */
+  guint            trash_idle_id;
+
+  /* the running batches of ExecuteBatch */
+  GList           *batches;
+  guint            last_batch_id;
+
+  /* the subscribers of "job-progress" by their bus names */
+  GHashTable      *progress_subscribers;
+  guint            progress_timer_id;
+  guint            progress_interval;
+  gboolean         progress_had_jobs;
+
+  /* the previous progress of the jobs, to compute their rates */
+  GHashTable      *job_samples;
+  guint            job_samples_generation;
 };
 
 
@@ -301,6 +435,7 @@ thunar_dbus_service_init (ThunarDBusService *dbus_service)
   dbus_service->file_manager      = thunar_dbus_file_manager_skeleton_new ();
   dbus_service->trash             = thunar_dbus_trash_skeleton_new ();
   dbus_service->thunar            = thunar_dbus_thunar_skeleton_new ();
+  dbus_service->debug             = thunar_dbus_debug_skeleton_new ();
   dbus_service->file_manager_fdo  = thunar_org_freedesktop_file_manager1_skeleton_new ();
 
   connect_signals_multiple (dbus_service->file_manager, dbus_service,
@@ -313,6 +448,7 @@ thunar_dbus_service_init (ThunarDBusService *dbus_service)
                             "handle-display-preferences-dialog", thunar_dbus_service_display_preferences_dialog,
                             "handle-copy-to", thunar_dbus_service_copy_to,
                             "handle-copy-into", thunar_dbus_service_copy_into,
+                            "handle-update-into", thunar_dbus_service_update_into,
                             "handle-move-into", thunar_dbus_service_move_into,
                             "handle-link-into", thunar_dbus_service_link_into,
                             "handle-unlink-files", thunar_dbus_service_unlink_files,
@@ -320,6 +456,7 @@ thunar_dbus_service_init (ThunarDBusService *dbus_service)
                             "handle-rename-file", thunar_dbus_service_rename_file,
                             "handle-create-file", thunar_dbus_service_create_file,
                             "handle-create-file-from-template", thunar_dbus_service_create_file_from_template,
+                            "handle-execute-batch", thunar_dbus_service_execute_batch,
                             NULL);
 
   connect_signals_multiple (dbus_service->trash, dbus_service,
@@ -332,8 +469,26 @@ thunar_dbus_service_init (ThunarDBusService *dbus_service)
   connect_signals_multiple (dbus_service->thunar, dbus_service,
                             "handle-bulk-rename", thunar_dbus_service_bulk_rename,
                             "handle-terminate", thunar_dbus_service_terminate,
+                            "handle-list-jobs", thunar_dbus_service_list_jobs,
+                            "handle-subscribe-job-progress", thunar_dbus_service_subscribe_job_progress,
+                            "handle-unsubscribe-job-progress", thunar_dbus_service_unsubscribe_job_progress,
+                            "handle-make-thumbnails", thunar_dbus_service_make_thumbnails,
                             NULL);
 
+  connect_signals_multiple (dbus_service->debug, dbus_service,
+                            "handle-get-counters", thunar_dbus_service_get_counters,
+                            "handle-get-stalls", thunar_dbus_service_get_stalls,
+                            "handle-get-memory", thunar_dbus_service_get_memory,
+                            NULL);
+
+  /* the "Full" property is kept up to date, so the trash bin is watched
+   * from the start instead of when the first client asks */
+  dbus_service->trash_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_dbus_service_trash_idle, dbus_service, NULL);
+
+  dbus_service->progress_subscribers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                              thunar_dbus_service_progress_subscriber_free);
+  dbus_service->job_samples = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
   connect_signals_multiple (dbus_service->file_manager_fdo, dbus_service,
                             "handle-show-folders", thunar_dbus_freedesktop_show_folders,
                             "handle-show-items", thunar_dbus_freedesktop_show_items,
@@ -351,11 +506,26 @@ thunar_dbus_service_finalize (GObject *object)
   g_object_unref (dbus_service->file_manager);
   g_object_unref (dbus_service->trash);
   g_object_unref (dbus_service->thunar);
+  g_object_unref (dbus_service->debug);
   g_object_unref (dbus_service->file_manager_fdo);
 
+  if (dbus_service->trash_changed_timer_id != 0)
+    g_source_remove (dbus_service->trash_changed_timer_id);
+
+  if (dbus_service->trash_idle_id != 0)
+    g_source_remove (dbus_service->trash_idle_id);
+
   if (dbus_service->trash_bin)
     g_object_unref (dbus_service->trash_bin);
 
+  /* the jobs keep running, but nobody is told about them anymore */
+  g_list_free_full (dbus_service->batches, (GDestroyNotify) thunar_dbus_service_batch_free);
+
+  if (dbus_service->progress_timer_id != 0)
+    g_source_remove (dbus_service->progress_timer_id);
+  g_hash_table_destroy (dbus_service->progress_subscribers);
+  g_hash_table_destroy (dbus_service->job_samples);
+
   (*G_OBJECT_CLASS (thunar_dbus_service_parent_class)->finalize) (object);
 }
 
@@ -426,8 +596,47 @@ thunar_dbus_service_trash_bin_changed (ThunarDBusService *dbus_service,
   _thunar_return_if_fail (dbus_service->trash_bin == trash_bin);
   _thunar_return_if_fail (THUNAR_IS_FILE (trash_bin));
 
+  /* trashing many files changes the trash bin for every file, so
+   * only emit a single "trash-changed" signal for a burst of changes */
+  if (dbus_service->trash_changed_timer_id == 0)
+    {
+      dbus_service->trash_changed_timer_id =
+          g_timeout_add (THUNAR_DBUS_SERVICE_TRASH_CHANGED_DELAY,
+                         thunar_dbus_service_trash_changed_timer, dbus_service);
+    }
+}
+
+
+
+static gboolean
+thunar_dbus_service_trash_changed_timer (gpointer user_data)
+{
+  ThunarDBusService *dbus_service = THUNAR_DBUS_SERVICE (user_data);
+
+  dbus_service->trash_changed_timer_id = 0;
+
+  /* update the property, which notifies the clients if it changed */
+  thunar_dbus_trash_set_full (dbus_service->trash, thunar_file_get_item_count (dbus_service->trash_bin) > 0);
+
   /* emit the "trash-changed" signal with the new state */
   thunar_dbus_trash_emit_trash_changed (dbus_service->trash);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_trash_idle (gpointer user_data)
+{
+  ThunarDBusService *dbus_service = THUNAR_DBUS_SERVICE (user_data);
+
+  dbus_service->trash_idle_id = 0;
+
+  /* the property is set once the trash bin was loaded */
+  thunar_dbus_service_connect_trash_bin (dbus_service, NULL);
+
+  return FALSE;
 }
 
 
@@ -1238,6 +1447,11 @@ thunar_dbus_service_transfer_files (ThunarDBusTransferMode transfer_mode,
                                             source_file_list, target_file_list->data,
                                             NULL);
               break;
+            case THUNAR_DBUS_TRANSFER_MODE_UPDATE_INTO:
+              thunar_application_update_into (application, screen,
+                                              source_file_list, target_file_list->data,
+                                              NULL);
+              break;
             case THUNAR_DBUS_TRANSFER_MODE_MOVE_INTO:
               thunar_application_move_into (application, screen,
                                             source_file_list, target_file_list->data,
@@ -1332,6 +1546,37 @@ thunar_dbus_service_copy_into (ThunarDBusFileManager  *object,
 
 
 
+static gboolean
+thunar_dbus_service_update_into (ThunarDBusFileManager  *object,
+                                 GDBusMethodInvocation  *invocation,
+                                 const gchar            *working_directory,
+                                 gchar                 **source_filenames,
+                                 const gchar            *target_filename,
+                                 const gchar            *display,
+                                 const gchar            *startup_id,
+                                 ThunarDBusService      *dbus_service)
+{
+  const gchar *target_filenames[2] = { target_filename, NULL };
+  GError *error = NULL;
+
+  thunar_dbus_service_transfer_files (THUNAR_DBUS_TRANSFER_MODE_UPDATE_INTO,
+                                      working_directory,
+                                      (const gchar * const *)source_filenames,
+                                      target_filenames,
+                                      display,
+                                      startup_id,
+                                      &error);
+
+  if (error)
+    g_dbus_method_invocation_take_error (invocation, error);
+  else
+    thunar_dbus_file_manager_complete_update_into (object, invocation);
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_dbus_service_move_into (ThunarDBusFileManager  *object,
                                GDBusMethodInvocation  *invocation,
@@ -1482,6 +1727,680 @@ out:
 
 
 
+static void
+thunar_dbus_service_batch_job_free (gpointer data)
+{
+  ThunarDBusBatchJob *batch_job = data;
+
+  thunar_g_list_free_full (batch_job->source_file_list);
+  thunar_g_list_free_full (batch_job->target_file_list);
+  g_slice_free (ThunarDBusBatchJob, batch_job);
+}
+
+
+
+static void
+thunar_dbus_service_batch_free (ThunarDBusBatch *batch)
+{
+  if (batch->next_idle_id != 0)
+    g_source_remove (batch->next_idle_id);
+
+  if (batch->job != NULL)
+    {
+      g_signal_handlers_disconnect_matched (batch->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, batch);
+      g_object_unref (batch->job);
+    }
+
+  g_queue_foreach (&batch->jobs, (GFunc) (void (*)(void)) thunar_dbus_service_batch_job_free, NULL);
+  g_queue_clear (&batch->jobs);
+
+  g_object_unref (batch->screen);
+  g_free (batch->error_message);
+  g_slice_free (ThunarDBusBatch, batch);
+}
+
+
+
+static gboolean
+thunar_dbus_service_batch_depends (ThunarDBusBatchJob *batch_job,
+                                   GList              *source_file_list)
+{
+  GList *lp;
+  GList *tp;
+
+  /* check if a source is created or removed by the previous operations */
+  for (lp = source_file_list; lp != NULL; lp = lp->next)
+    {
+      for (tp = batch_job->target_file_list; tp != NULL; tp = tp->next)
+        if (g_file_equal (lp->data, tp->data) || g_file_has_prefix (lp->data, tp->data))
+          return TRUE;
+
+      for (tp = batch_job->source_file_list; tp != NULL; tp = tp->next)
+        if (g_file_equal (lp->data, tp->data) || g_file_has_prefix (lp->data, tp->data))
+          return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_batch_add (ThunarDBusBatch *batch,
+                               const gchar     *kind_name,
+                               GList           *source_file_list,
+                               GList           *target_file_list,
+                               GError         **error)
+{
+  ThunarDBusBatchKind  kind;
+  ThunarDBusBatchJob  *batch_job;
+  GFile               *target_dir;
+  GFile               *file;
+  GList               *lp;
+  gchar               *base_name;
+  guint                n_targets;
+
+  n_targets = g_list_length (target_file_list);
+
+  if (source_file_list == NULL)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   _("At least one source filename must be specified"));
+      return FALSE;
+    }
+
+  if (g_strcmp0 (kind_name, "copy-to") == 0)
+    {
+      if (g_list_length (source_file_list) != n_targets)
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       _("The number of source and target filenames must be the same"));
+          return FALSE;
+        }
+
+      kind = THUNAR_DBUS_BATCH_COPY;
+      target_file_list = thunar_g_list_copy_deep (target_file_list);
+    }
+  else if (g_strcmp0 (kind_name, "copy-into") == 0
+           || g_strcmp0 (kind_name, "move-into") == 0
+           || g_strcmp0 (kind_name, "link-into") == 0)
+    {
+      if (n_targets != 1)
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       _("A destination directory must be specified"));
+          return FALSE;
+        }
+
+      if (*kind_name == 'c')
+        kind = THUNAR_DBUS_BATCH_COPY;
+      else if (*kind_name == 'm')
+        kind = THUNAR_DBUS_BATCH_MOVE;
+      else
+        kind = THUNAR_DBUS_BATCH_LINK;
+
+      /* generate the target path list */
+      target_dir = target_file_list->data;
+      target_file_list = NULL;
+      for (lp = g_list_last (source_file_list); lp != NULL; lp = lp->prev)
+        {
+          if (G_UNLIKELY (thunar_g_file_is_root (lp->data)))
+            {
+              thunar_g_list_free_full (target_file_list);
+              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s", g_strerror (EINVAL));
+              return FALSE;
+            }
+
+          base_name = g_file_get_basename (lp->data);
+          file = g_file_resolve_relative_path (target_dir, base_name);
+          target_file_list = g_list_prepend (target_file_list, file);
+          g_free (base_name);
+        }
+    }
+  else if (g_strcmp0 (kind_name, "trash") == 0
+           || g_strcmp0 (kind_name, "unlink") == 0)
+    {
+      kind = (*kind_name == 't') ? THUNAR_DBUS_BATCH_TRASH : THUNAR_DBUS_BATCH_UNLINK;
+      target_file_list = NULL;
+    }
+  else
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   _("Unknown operation \"%s\""), kind_name);
+      return FALSE;
+    }
+
+  /* merge with the previous operation, if it is independent of it */
+  batch_job = g_queue_peek_tail (&batch->jobs);
+  if (batch_job != NULL
+      && batch_job->kind == kind
+      && !thunar_dbus_service_batch_depends (batch_job, source_file_list))
+    {
+      batch_job->source_file_list = g_list_concat (batch_job->source_file_list, thunar_g_list_copy_deep (source_file_list));
+      batch_job->target_file_list = g_list_concat (batch_job->target_file_list, target_file_list);
+      return TRUE;
+    }
+
+  batch_job = g_slice_new0 (ThunarDBusBatchJob);
+  batch_job->kind = kind;
+  batch_job->source_file_list = thunar_g_list_copy_deep (source_file_list);
+  batch_job->target_file_list = target_file_list;
+  g_queue_push_tail (&batch->jobs, batch_job);
+  batch->n_jobs++;
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_dbus_service_batch_finish (ThunarDBusBatch *batch)
+{
+  ThunarDBusService *dbus_service = batch->dbus_service;
+
+  thunar_dbus_file_manager_emit_batch_finished (dbus_service->file_manager, batch->id,
+                                                batch->error_message == NULL,
+                                                batch->error_message != NULL ? batch->error_message : "");
+
+  dbus_service->batches = g_list_remove (dbus_service->batches, batch);
+  thunar_dbus_service_batch_free (batch);
+}
+
+
+
+static void
+thunar_dbus_service_batch_error (ThunarJob       *job,
+                                 GError          *error,
+                                 ThunarDBusBatch *batch)
+{
+  _thunar_return_if_fail (batch->job == job);
+
+  /* remember the first error, it stops the batch */
+  if (batch->error_message == NULL)
+    batch->error_message = g_strdup (error->message);
+}
+
+
+
+static gboolean
+thunar_dbus_service_batch_next (gpointer user_data)
+{
+  ThunarDBusBatch    *batch = user_data;
+  ThunarDBusBatchJob *batch_job;
+  ThunarApplication  *application;
+  const gchar        *icon_name;
+  const gchar        *title;
+  GList              *changed_file_list;
+
+  batch->next_idle_id = 0;
+
+  /* release the previous job */
+  if (batch->job != NULL)
+    {
+      g_signal_handlers_disconnect_matched (batch->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, batch);
+      g_object_unref (batch->job);
+      batch->job = NULL;
+    }
+
+  batch_job = g_queue_pop_head (&batch->jobs);
+  if (batch->error_message != NULL || batch_job == NULL)
+    {
+      if (batch_job != NULL)
+        thunar_dbus_service_batch_job_free (batch_job);
+      thunar_dbus_service_batch_finish (batch);
+      return FALSE;
+    }
+
+  switch (batch_job->kind)
+    {
+    case THUNAR_DBUS_BATCH_COPY:
+      batch->job = thunar_io_jobs_copy_files (batch_job->source_file_list, batch_job->target_file_list);
+      icon_name = "edit-copy";
+      title = _("Copying files...");
+      break;
+
+    case THUNAR_DBUS_BATCH_MOVE:
+      batch->job = thunar_io_jobs_move_files (batch_job->source_file_list, batch_job->target_file_list);
+      icon_name = "stock_folder-move";
+      title = _("Moving files...");
+      break;
+
+    case THUNAR_DBUS_BATCH_LINK:
+      batch->job = thunar_io_jobs_link_files (batch_job->source_file_list, batch_job->target_file_list);
+      icon_name = "insert-link";
+      title = _("Creating symbolic links...");
+      break;
+
+    case THUNAR_DBUS_BATCH_TRASH:
+      batch->job = thunar_io_jobs_trash_files (batch_job->source_file_list);
+      icon_name = "user-trash-full";
+      title = _("Moving files into the trash...");
+      break;
+
+    default:
+      batch->job = thunar_io_jobs_unlink_files (batch_job->source_file_list);
+      icon_name = "edit-delete";
+      title = _("Deleting files...");
+      break;
+    }
+
+  g_signal_connect (batch->job, "error", G_CALLBACK (thunar_dbus_service_batch_error), batch);
+  g_signal_connect_swapped (batch->job, "finished", G_CALLBACK (thunar_dbus_service_batch_finished), batch);
+
+  /* the sources and the targets may be in folders without a monitor */
+  changed_file_list = g_list_concat (g_list_copy (batch_job->source_file_list),
+                                     g_list_copy (batch_job->target_file_list));
+
+  application = thunar_application_get ();
+  thunar_application_launch_job (application, batch->screen, batch->job, icon_name, title, changed_file_list);
+  g_object_unref (application);
+
+  g_list_free (changed_file_list);
+  thunar_dbus_service_batch_job_free (batch_job);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_dbus_service_batch_finished (ThunarDBusBatch *batch)
+{
+  /* a cancelled job stops the batch as well */
+  if (batch->error_message == NULL && exo_job_is_cancelled (EXO_JOB (batch->job)))
+    batch->error_message = g_strdup (_("Operation cancelled"));
+
+  if (batch->error_message == NULL)
+    {
+      batch->n_finished++;
+      thunar_dbus_file_manager_emit_batch_progress (batch->dbus_service->file_manager, batch->id,
+                                                    batch->n_finished, batch->n_jobs);
+    }
+
+  /* start the next job once the job is fully finished */
+  if (batch->next_idle_id == 0)
+    batch->next_idle_id = g_idle_add (thunar_dbus_service_batch_next, batch);
+}
+
+
+
+static gboolean
+thunar_dbus_service_execute_batch (ThunarDBusFileManager  *object,
+                                   GDBusMethodInvocation  *invocation,
+                                   const gchar            *working_directory,
+                                   GVariant               *operations,
+                                   const gchar            *display,
+                                   const gchar            *startup_id,
+                                   ThunarDBusService      *dbus_service)
+{
+  ThunarDBusBatch  *batch;
+  GVariantIter      iter;
+  const gchar      *kind_name;
+  const gchar     **source_filenames;
+  const gchar     **target_filenames;
+  GdkScreen        *screen;
+  GError           *error = NULL;
+  GFile            *file;
+  GList            *source_file_list;
+  GList            *target_file_list;
+  gchar            *filename;
+  gchar            *new_working_dir = NULL;
+  gchar            *old_working_dir = NULL;
+  guint             n;
+
+  /* try to open the screen for the display name */
+  screen = thunar_gdk_screen_open (display, &error);
+  if (screen == NULL)
+    {
+      g_dbus_method_invocation_take_error (invocation, error);
+      return TRUE;
+    }
+
+  batch = g_slice_new0 (ThunarDBusBatch);
+  batch->dbus_service = dbus_service;
+  batch->screen = screen;
+  g_queue_init (&batch->jobs);
+
+  /* change the working directory if necessary */
+  if (!exo_str_is_empty (working_directory))
+    old_working_dir = thunar_util_change_working_directory (working_directory);
+
+  /* transform the operations into jobs */
+  g_variant_iter_init (&iter, operations);
+  while (error == NULL && g_variant_iter_next (&iter, "(&s^a&s^a&s)", &kind_name, &source_filenames, &target_filenames))
+    {
+      source_file_list = NULL;
+      target_file_list = NULL;
+
+      for (n = 0; error == NULL && source_filenames[n] != NULL; ++n)
+        {
+          filename = g_filename_from_utf8 (source_filenames[n], -1, NULL, NULL, &error);
+          if (filename != NULL)
+            {
+              file = g_file_new_for_commandline_arg (filename);
+              source_file_list = g_list_prepend (source_file_list, file);
+              g_free (filename);
+            }
+        }
+
+      for (n = 0; error == NULL && target_filenames[n] != NULL; ++n)
+        {
+          filename = g_filename_from_utf8 (target_filenames[n], -1, NULL, NULL, &error);
+          if (filename != NULL)
+            {
+              file = g_file_new_for_commandline_arg (filename);
+              target_file_list = g_list_prepend (target_file_list, file);
+              g_free (filename);
+            }
+        }
+
+      source_file_list = g_list_reverse (source_file_list);
+      target_file_list = g_list_reverse (target_file_list);
+
+      if (error == NULL)
+        thunar_dbus_service_batch_add (batch, kind_name, source_file_list, target_file_list, &error);
+
+      thunar_g_list_free_full (source_file_list);
+      thunar_g_list_free_full (target_file_list);
+      g_free (source_filenames);
+      g_free (target_filenames);
+    }
+
+  /* switch back to the previous working directory */
+  if (!exo_str_is_empty (working_directory))
+    {
+      new_working_dir = thunar_util_change_working_directory (old_working_dir);
+      g_free (old_working_dir);
+      g_free (new_working_dir);
+    }
+
+  if (error == NULL && batch->n_jobs == 0)
+    {
+      g_set_error (&error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   _("At least one operation must be specified"));
+    }
+
+  if (error != NULL)
+    {
+      thunar_dbus_service_batch_free (batch);
+      g_dbus_method_invocation_take_error (invocation, error);
+      return TRUE;
+    }
+
+  /* a zero id is never handed out */
+  if (G_UNLIKELY (++dbus_service->last_batch_id == 0))
+    ++dbus_service->last_batch_id;
+  batch->id = dbus_service->last_batch_id;
+  dbus_service->batches = g_list_prepend (dbus_service->batches, batch);
+
+  thunar_dbus_file_manager_complete_execute_batch (object, invocation, batch->id);
+
+  /* start the first job, after the reply was sent */
+  batch->next_idle_id = g_idle_add (thunar_dbus_service_batch_next, batch);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_job_sample_expired (gpointer key,
+                                        gpointer value,
+                                        gpointer user_data)
+{
+  ThunarDBusJobSample *sample = value;
+
+  return sample->generation != GPOINTER_TO_UINT (user_data);
+}
+
+
+
+static GVariant *
+thunar_dbus_service_collect_jobs (ThunarDBusService *dbus_service)
+{
+  ThunarDBusJobSample *sample;
+  ThunarApplication   *application;
+  GVariantBuilder      builder;
+  const gchar         *title;
+  ThunarJob           *job;
+  GList               *lp;
+  gint64               now;
+  gint64               eta;
+  gdouble              elapsed;
+  gdouble              bytes_per_second;
+  guint64              total_size;
+  guint64              total_progress;
+  guint64              transfer_rate;
+  guint                n_files_total;
+  guint                n_files_done;
+  guint                id;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(usttduudxbb)"));
+
+  now = g_get_monotonic_time ();
+  dbus_service->job_samples_generation++;
+
+  application = thunar_application_get ();
+  for (lp = thunar_application_get_jobs (application); lp != NULL; lp = lp->next)
+    {
+      job = THUNAR_JOB (lp->data);
+      id = thunar_application_get_job_id (application, job);
+      title = thunar_application_get_job_title (application, job);
+
+      if (THUNAR_IS_TRANSFER_JOB (job))
+        {
+          thunar_transfer_job_get_progress (THUNAR_TRANSFER_JOB (job), &total_size, &total_progress,
+                                            &transfer_rate, &n_files_total, &n_files_done);
+        }
+      else
+        {
+          total_size = total_progress = transfer_rate = 0;
+          n_files_total = thunar_job_get_n_total_files (job);
+          n_files_done = thunar_job_get_n_processed (job);
+        }
+      bytes_per_second = transfer_rate;
+
+      /* the files per second since the previous sample, the short
+       * intervals are smoothed like the transfer rate of the job */
+      sample = g_hash_table_lookup (dbus_service->job_samples, GUINT_TO_POINTER (id));
+      if (G_UNLIKELY (sample == NULL))
+        {
+          sample = g_new0 (ThunarDBusJobSample, 1);
+          sample->time = now;
+          sample->n_files_done = n_files_done;
+          g_hash_table_insert (dbus_service->job_samples, GUINT_TO_POINTER (id), sample);
+        }
+      else if (now - sample->time >= THUNAR_DBUS_SERVICE_PROGRESS_MIN_INTERVAL * 1000)
+        {
+          elapsed = (gdouble) (now - sample->time) / G_USEC_PER_SEC;
+          if (sample->files_per_second > 0)
+            sample->files_per_second = (sample->files_per_second * 3 + (n_files_done - sample->n_files_done) / elapsed) / 4;
+          else
+            sample->files_per_second = (n_files_done - sample->n_files_done) / elapsed;
+          sample->time = now;
+          sample->n_files_done = n_files_done;
+        }
+      sample->generation = dbus_service->job_samples_generation;
+
+      /* estimate the remaining time from the bytes, or the files otherwise */
+      if (total_size > 0 && transfer_rate > 0)
+        eta = (total_size - total_progress) / transfer_rate;
+      else if (n_files_total > n_files_done && sample->files_per_second > 0)
+        eta = (n_files_total - n_files_done) / sample->files_per_second;
+      else
+        eta = -1;
+
+      g_variant_builder_add (&builder, "(usttduudxbb)",
+                             id, title != NULL ? title : "",
+                             total_size, total_progress, bytes_per_second,
+                             n_files_total, n_files_done, sample->files_per_second,
+                             eta, thunar_job_is_paused (job), thunar_job_is_frozen (job));
+    }
+  g_object_unref (application);
+
+  /* forget the finished jobs */
+  g_hash_table_foreach_remove (dbus_service->job_samples, thunar_dbus_service_job_sample_expired,
+                               GUINT_TO_POINTER (dbus_service->job_samples_generation));
+
+  return g_variant_builder_end (&builder);
+}
+
+
+
+static gboolean
+thunar_dbus_service_progress_timer (gpointer user_data)
+{
+  ThunarDBusService *dbus_service = THUNAR_DBUS_SERVICE (user_data);
+  ThunarApplication *application;
+  gboolean           has_jobs;
+
+  application = thunar_application_get ();
+  has_jobs = (thunar_application_get_jobs (application) != NULL);
+  g_object_unref (application);
+
+  /* an empty list is only sent once, when the last job finished */
+  if (has_jobs || dbus_service->progress_had_jobs)
+    thunar_dbus_thunar_emit_job_progress (dbus_service->thunar, thunar_dbus_service_collect_jobs (dbus_service));
+
+  dbus_service->progress_had_jobs = has_jobs;
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_dbus_service_update_progress_timer (ThunarDBusService *dbus_service)
+{
+  ThunarDBusProgressSubscriber *subscriber;
+  GHashTableIter                iter;
+  guint                         interval = 0;
+
+  /* the shortest interval of all subscribers wins */
+  g_hash_table_iter_init (&iter, dbus_service->progress_subscribers);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &subscriber))
+    if (interval == 0 || subscriber->interval < interval)
+      interval = subscriber->interval;
+
+  if (interval == dbus_service->progress_interval)
+    return;
+
+  if (dbus_service->progress_timer_id != 0)
+    {
+      g_source_remove (dbus_service->progress_timer_id);
+      dbus_service->progress_timer_id = 0;
+    }
+
+  dbus_service->progress_interval = interval;
+
+  if (interval > 0)
+    {
+      dbus_service->progress_timer_id = g_timeout_add (interval, thunar_dbus_service_progress_timer, dbus_service);
+    }
+  else
+    {
+      /* without subscribers the jobs are not sampled anymore */
+      dbus_service->progress_had_jobs = FALSE;
+      g_hash_table_remove_all (dbus_service->job_samples);
+    }
+}
+
+
+
+static void
+thunar_dbus_service_progress_subscriber_free (gpointer data)
+{
+  ThunarDBusProgressSubscriber *subscriber = data;
+
+  if (subscriber->watch_id != 0)
+    g_bus_unwatch_name (subscriber->watch_id);
+  g_slice_free (ThunarDBusProgressSubscriber, subscriber);
+}
+
+
+
+static void
+thunar_dbus_service_progress_subscriber_vanished (GDBusConnection *connection,
+                                                  const gchar     *name,
+                                                  gpointer         user_data)
+{
+  ThunarDBusService *dbus_service = THUNAR_DBUS_SERVICE (user_data);
+
+  /* the subscriber left the bus without unsubscribing */
+  g_hash_table_remove (dbus_service->progress_subscribers, name);
+  thunar_dbus_service_update_progress_timer (dbus_service);
+}
+
+
+
+static gboolean
+thunar_dbus_service_list_jobs (ThunarDBusThunar      *object,
+                               GDBusMethodInvocation *invocation,
+                               ThunarDBusService     *dbus_service)
+{
+  thunar_dbus_thunar_complete_list_jobs (object, invocation, thunar_dbus_service_collect_jobs (dbus_service));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_subscribe_job_progress (ThunarDBusThunar      *object,
+                                            GDBusMethodInvocation *invocation,
+                                            guint                  interval,
+                                            ThunarDBusService     *dbus_service)
+{
+  ThunarDBusProgressSubscriber *subscriber;
+  const gchar                  *sender;
+
+  /* peer to peer connections have no sender */
+  sender = g_dbus_method_invocation_get_sender (invocation);
+  if (sender == NULL)
+    sender = "";
+
+  subscriber = g_hash_table_lookup (dbus_service->progress_subscribers, sender);
+  if (subscriber == NULL)
+    {
+      subscriber = g_slice_new0 (ThunarDBusProgressSubscriber);
+      if (*sender != '\0')
+        {
+          subscriber->watch_id = g_bus_watch_name_on_connection (g_dbus_method_invocation_get_connection (invocation),
+                                                                 sender, G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                                 NULL, thunar_dbus_service_progress_subscriber_vanished,
+                                                                 dbus_service, NULL);
+        }
+      g_hash_table_insert (dbus_service->progress_subscribers, g_strdup (sender), subscriber);
+    }
+
+  subscriber->interval = MAX (interval, THUNAR_DBUS_SERVICE_PROGRESS_MIN_INTERVAL);
+  thunar_dbus_service_update_progress_timer (dbus_service);
+
+  thunar_dbus_thunar_complete_subscribe_job_progress (object, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_unsubscribe_job_progress (ThunarDBusThunar      *object,
+                                              GDBusMethodInvocation *invocation,
+                                              ThunarDBusService     *dbus_service)
+{
+  const gchar *sender;
+
+  sender = g_dbus_method_invocation_get_sender (invocation);
+  g_hash_table_remove (dbus_service->progress_subscribers, sender != NULL ? sender : "");
+  thunar_dbus_service_update_progress_timer (dbus_service);
+
+  thunar_dbus_thunar_complete_unsubscribe_job_progress (object, invocation);
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_dbus_service_terminate (ThunarDBusThunar       *object,
                                GDBusMethodInvocation  *invocation,
@@ -1500,6 +2419,161 @@ thunar_dbus_service_terminate (ThunarDBusThunar       *object,
 
 
 
+static gboolean
+thunar_dbus_service_make_thumbnails (ThunarDBusThunar       *object,
+                                     GDBusMethodInvocation  *invocation,
+                                     const gchar            *uri,
+                                     gboolean                recursive,
+                                     const gchar            *display,
+                                     const gchar            *startup_id,
+                                     ThunarDBusService      *dbus_service)
+{
+  ThunarApplication *application;
+  ThunarFile        *file;
+  GdkScreen         *screen;
+  GError            *error = NULL;
+  GList              folder_list;
+
+  /* parse uri and display parameters */
+  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
+    goto out;
+
+  if (G_UNLIKELY (!thunar_file_is_directory (file)))
+    {
+      g_set_error (&error, G_FILE_ERROR, G_FILE_ERROR_NOTDIR, _("\"%s\" is not a folder"), uri);
+    }
+  else
+    {
+      /* fake a file list */
+      folder_list.data = thunar_file_get_file (file);
+      folder_list.next = NULL;
+      folder_list.prev = NULL;
+
+      application = thunar_application_get ();
+      thunar_application_make_thumbnails (application, screen, &folder_list, recursive);
+      g_object_unref (G_OBJECT (application));
+    }
+
+  /* cleanup */
+  g_object_unref (G_OBJECT (screen));
+  g_object_unref (G_OBJECT (file));
+
+out:
+  if (error)
+    g_dbus_method_invocation_take_error (invocation, error);
+  else
+    thunar_dbus_thunar_complete_make_thumbnails (object, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_get_counters (ThunarDBusDebug        *object,
+                                  GDBusMethodInvocation  *invocation,
+                                  ThunarDBusService      *dbus_service)
+{
+  ThunarIconFactory *icon_factory;
+  ThunarApplication *application;
+  GVariantBuilder    builder;
+  GVariantBuilder    stalls;
+  GList             *lp;
+  guint64            lookups;
+  guint64            hits;
+  guint64            misses;
+  guint64            contended;
+  guint64            count;
+  gsize              n_bytes;
+  guint              n_files;
+  guint              n_entries;
+  guint              n_running = 0;
+  guint              n_frozen = 0;
+  guint              n_monitored;
+  guint              n_polled;
+  guint              n_subscriptions;
+  guint              limit_ms;
+  guint              n;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+  thunar_file_cache_get_stats (&n_files, NULL, &contended, &lookups, &hits);
+  g_variant_builder_add (&builder, "{sv}", "file-cache-size", g_variant_new_uint32 (n_files));
+  g_variant_builder_add (&builder, "{sv}", "file-cache-lookups", g_variant_new_uint64 (lookups));
+  g_variant_builder_add (&builder, "{sv}", "file-cache-hits", g_variant_new_uint64 (hits));
+  g_variant_builder_add (&builder, "{sv}", "file-cache-contended", g_variant_new_uint64 (contended));
+
+  icon_factory = thunar_icon_factory_get_default ();
+  thunar_icon_factory_get_cache_stats (icon_factory, &hits, &misses, NULL, &n_entries, &n_bytes);
+  g_object_unref (icon_factory);
+  g_variant_builder_add (&builder, "{sv}", "icon-cache-entries", g_variant_new_uint32 (n_entries));
+  g_variant_builder_add (&builder, "{sv}", "icon-cache-bytes", g_variant_new_uint64 (n_bytes));
+  g_variant_builder_add (&builder, "{sv}", "icon-cache-hits", g_variant_new_uint64 (hits));
+  g_variant_builder_add (&builder, "{sv}", "icon-cache-misses", g_variant_new_uint64 (misses));
+
+  g_variant_builder_add (&builder, "{sv}", "thumbnail-requests",
+                         g_variant_new_int32 (thunar_counters_get (THUNAR_COUNTER_THUMBNAIL_REQUESTS)));
+  g_variant_builder_add (&builder, "{sv}", "folders",
+                         g_variant_new_int32 (thunar_counters_get (THUNAR_COUNTER_FOLDERS)));
+  g_variant_builder_add (&builder, "{sv}", "monitors",
+                         g_variant_new_int32 (thunar_counters_get (THUNAR_COUNTER_MONITORS)));
+
+  thunar_monitor_pool_get_stats (&n_monitored, &n_polled, &n_subscriptions);
+  g_variant_builder_add (&builder, "{sv}", "monitored-directories", g_variant_new_uint32 (n_monitored));
+  g_variant_builder_add (&builder, "{sv}", "polled-directories", g_variant_new_uint32 (n_polled));
+  g_variant_builder_add (&builder, "{sv}", "monitor-subscriptions", g_variant_new_uint32 (n_subscriptions));
+
+  application = thunar_application_get ();
+  for (lp = thunar_application_get_jobs (application); lp != NULL; lp = lp->next)
+    {
+      if (thunar_job_is_frozen (lp->data))
+        n_frozen++;
+      else
+        n_running++;
+    }
+  g_object_unref (application);
+  g_variant_builder_add (&builder, "{sv}", "jobs-running", g_variant_new_uint32 (n_running));
+  g_variant_builder_add (&builder, "{sv}", "jobs-frozen", g_variant_new_uint32 (n_frozen));
+
+  g_variant_builder_init (&stalls, G_VARIANT_TYPE ("a(ut)"));
+  for (n = 0; n < thunar_counters_get_n_stall_bins (); ++n)
+    {
+      count = thunar_counters_get_stall_bin (n, &limit_ms);
+      g_variant_builder_add (&stalls, "(ut)", limit_ms, count);
+    }
+  g_variant_builder_add (&builder, "{sv}", "main-loop-stalls", g_variant_builder_end (&stalls));
+
+  thunar_dbus_debug_complete_get_counters (object, invocation, g_variant_builder_end (&builder));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_get_stalls (ThunarDBusDebug        *object,
+                                GDBusMethodInvocation  *invocation,
+                                ThunarDBusService      *dbus_service)
+{
+  thunar_dbus_debug_complete_get_stalls (object, invocation, thunar_watchdog_get_stalls ());
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_get_memory (ThunarDBusDebug        *object,
+                                GDBusMethodInvocation  *invocation,
+                                ThunarDBusService      *dbus_service)
+{
+  thunar_dbus_debug_complete_get_memory (object, invocation, thunar_memory_get_report ());
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_dbus_freedesktop_show_folders (ThunarOrgFreedesktopFileManager1 *object,
                                       GDBusMethodInvocation            *invocation,
@@ -1661,6 +2735,12 @@ gboolean thunar_dbus_service_export_on_connection (ThunarDBusService *service,
                                          error))
     goto fail;
 
+  if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (service->debug),
+                                         connection,
+                                         "/org/xfce/FileManager",
+                                         error))
+    goto fail;
+
   if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (service->file_manager_fdo),
                                          connection,
                                          "/org/freedesktop/FileManager1",
@@ -1674,6 +2754,7 @@ fail:
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->file_manager), connection);
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->trash), connection);
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->thunar), connection);
+  g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->debug), connection);
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->file_manager_fdo), connection);
   return FALSE;
 }
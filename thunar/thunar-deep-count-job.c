@@ -28,10 +28,15 @@
 #include <gio/gio.h>
 
 #include <thunar/thunar-deep-count-job.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-scan-rules.h>
+#include <thunar/thunar-size-cache.h>
+#include <thunar/thunar-trace.h>
 
 
 
@@ -46,8 +51,23 @@ enum
 #define DEEP_COUNT_FILE_INFO_NAMESPACE \
   G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
   G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
   G_FILE_ATTRIBUTE_ID_FILESYSTEM
 
+/* modification time of directories that must be queried first */
+#define DEEP_COUNT_MTIME_UNKNOWN (G_MAXUINT64)
+
+/* upper limit for the number of threads counting a single filesystem */
+#define DEEP_COUNT_MAX_THREADS (8)
+
+
+
+typedef struct _DeepCountContext DeepCountContext;
+typedef struct _DeepCountItem    DeepCountItem;
+
+
+
 static void     thunar_deep_count_job_finalize   (GObject                 *object);
 static gboolean thunar_deep_count_job_execute    (ExoJob                  *job,
                                                   GError                 **error);
@@ -73,14 +93,52 @@ struct _ThunarDeepCountJob
   GList              *files;
   GFileQueryInfoFlags query_flags;
 
-  /* the time of the last "status-update" emission */
-  gint64              last_time;
+  /* the subdirectories that are not entered */
+  ThunarScanRules    *rules;
 
-  /* status information */
+  /* status information, protected by the mutex */
+  GMutex              mutex;
   guint64             total_size;
   guint               file_count;
   guint               directory_count;
   guint               unreadable_directory_count;
+  guint               excluded_directory_count;
+
+  /* whether a status update is queued, atomic */
+  gint                status_pending;
+};
+
+struct _DeepCountContext
+{
+  ThunarDeepCountJob *job;
+  GThreadPool        *pool;
+
+  /* set once a job file failed, the other threads stop then */
+  gint                failed;
+
+  /* whether unchanged directories are taken from the size cache */
+  gboolean            use_cache;
+
+  /* whether the children are queried in inode order, on rotating disks */
+  gboolean            inode_order;
+
+  /* protected by the mutex */
+  GMutex              mutex;
+  GCond               cond;
+  guint               n_pending;
+  GError             *error;
+};
+
+struct _DeepCountItem
+{
+  GFile              *file;
+
+  /* the interned filesystem of the job file the directory belongs
+   * to, or %NULL if this is a job file itself */
+  const gchar        *fs_id;
+
+  /* the modification time of the directory in microseconds */
+  guint64             mtime;
 };
 
 
@@ -136,6 +194,7 @@ static void
 thunar_deep_count_job_init (ThunarDeepCountJob *job)
 {
   job->query_flags = G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS;
+  g_mutex_init (&job->mutex);
 }
 
 
@@ -146,192 +205,437 @@ thunar_deep_count_job_finalize (GObject *object)
   ThunarDeepCountJob *job = THUNAR_DEEP_COUNT_JOB (object);
 
   g_list_free_full (job->files, g_object_unref);
+  thunar_scan_rules_unref (job->rules);
+  g_mutex_clear (&job->mutex);
 
   (*G_OBJECT_CLASS (thunar_deep_count_job_parent_class)->finalize) (object);
 }
 
 
 
+static void
+thunar_deep_count_job_status_update_post (ThunarJob *thunar_job,
+                                          gpointer   data)
+{
+  ThunarDeepCountJob *job = THUNAR_DEEP_COUNT_JOB (thunar_job);
+  guint64             total_size;
+  guint               file_count;
+  guint               directory_count;
+  guint               unreadable_directory_count;
+
+  /* allow the next update to be queued, then publish the
+   * counters as they are now, not as they were when queued */
+  g_atomic_int_set (&job->status_pending, 0);
+
+  /* take a consistent copy of the counters */
+  g_mutex_lock (&job->mutex);
+  total_size = job->total_size;
+  file_count = job->file_count;
+  directory_count = job->directory_count;
+  unreadable_directory_count = job->unreadable_directory_count;
+  g_mutex_unlock (&job->mutex);
+
+  g_signal_emit (job,
+                 deep_count_signals[STATUS_UPDATE],
+                 0,
+                 total_size,
+                 file_count,
+                 directory_count,
+                 unreadable_directory_count);
+}
+
+
+
 static void
 thunar_deep_count_job_status_update (ThunarDeepCountJob *job)
 {
   _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
 
-  exo_job_emit (EXO_JOB (job),
-                deep_count_signals[STATUS_UPDATE],
-                0,
-                job->total_size,
-                job->file_count,
-                job->directory_count,
-                job->unreadable_directory_count);
+  /* a queued update reads the latest counters, so one is enough */
+  if (g_atomic_int_compare_and_exchange (&job->status_pending, 0, 1))
+    thunar_job_post (THUNAR_JOB (job), thunar_deep_count_job_status_update_post, NULL, NULL);
 }
 
 
 
 static gboolean
-thunar_deep_count_job_process (ExoJob       *job,
-                               GFile        *file,
-                               GFileInfo    *file_info,
-                               const gchar  *toplevel_fs_id,
-                               GError      **error)
+thunar_deep_count_job_stopped (DeepCountContext *context)
 {
-  ThunarDeepCountJob *count_job = THUNAR_DEEP_COUNT_JOB (job);
-  GFileEnumerator    *enumerator;
+  return exo_job_is_cancelled (EXO_JOB (context->job))
+      || g_atomic_int_get (&context->failed);
+}
+
+
+
+static guint64
+thunar_deep_count_job_get_mtime (GFileInfo *info)
+{
+  guint64 mtime;
+
+  if (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    return 0;
+
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC;
+  return mtime + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
+
+
+
+static void
+thunar_deep_count_job_push (DeepCountContext *context,
+                            GFile            *file,
+                            const gchar      *fs_id,
+                            guint64           mtime)
+{
+  DeepCountItem *item;
+
+  item = g_slice_new (DeepCountItem);
+  item->file = file;
+  item->fs_id = fs_id;
+  item->mtime = mtime;
+
+  g_mutex_lock (&context->mutex);
+  context->n_pending++;
+  g_mutex_unlock (&context->mutex);
+
+  g_thread_pool_push (context->pool, item, NULL);
+}
+
+
+
+static gboolean
+thunar_deep_count_job_excludes (ThunarDeepCountJob *job,
+                                const gchar        *name)
+{
+  if (!thunar_scan_rules_excludes (job->rules, name))
+    return FALSE;
+
+  g_mutex_lock (&job->mutex);
+  job->excluded_directory_count++;
+  g_mutex_unlock (&job->mutex);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_deep_count_job_fail (DeepCountContext *context,
+                            GError           *error)
+{
+  /* only remember the first error */
+  g_mutex_lock (&context->mutex);
+  if (context->error == NULL)
+    context->error = error;
+  else
+    g_error_free (error);
+  g_mutex_unlock (&context->mutex);
+
+  g_atomic_int_set (&context->failed, TRUE);
+}
+
+
+
+static gboolean
+thunar_deep_count_job_scan (DeepCountContext *context,
+                            GFile            *directory,
+                            const gchar      *directory_fs_id,
+                            guint64           mtime,
+                            GError          **error)
+{
+  ThunarDeepCountJob *job = context->job;
+  GFileEnumerator    *enumerator = NULL;
   GFileInfo          *child_info;
-  GFileInfo          *info;
-  gboolean            success = TRUE;
-  GFile              *child;
-  gint64              real_time;
+  GPtrArray          *directories;
+  GList              *child_infos = NULL;
+  gboolean            readable;
   const gchar        *fs_id;
-  gboolean            toplevel_file = (toplevel_fs_id == NULL);
+  guint64             total_size = 0;
+  guint               file_count = 0;
+  gboolean            complete = FALSE;
+  GError             *err = NULL;
+  gchar             **names;
+  guint               n;
 
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
-  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
-  _thunar_return_val_if_fail (file_info == NULL || G_IS_FILE_INFO (file_info), FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  /* unchanged directories are walked by their cached subdirectories */
+  if (context->use_cache
+      && thunar_size_cache_lookup (directory, mtime, &total_size, &file_count, &names))
+    {
+      for (n = 0; names[n] != NULL; ++n)
+        {
+          if (thunar_deep_count_job_excludes (job, names[n]))
+            continue;
 
-  /* abort if job was already cancelled */
-  if (exo_job_is_cancelled (job))
-    return FALSE;
+          thunar_deep_count_job_push (context, g_file_get_child (directory, names[n]),
+                                      directory_fs_id, DEEP_COUNT_MTIME_UNKNOWN);
+        }
+      g_strfreev (names);
 
-  if (file_info != NULL)
+      goto done;
+    }
+
+  /* try to read from the directory */
+  if (context->inode_order)
     {
-      /* use the enumerator info */
-      info = g_object_ref (file_info);
+      child_infos = thunar_io_jobs_util_query_children_by_inode (directory,
+                                                                 DEEP_COUNT_FILE_INFO_NAMESPACE ","
+                                                                 G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                                                 job->query_flags,
+                                                                 exo_job_get_cancellable (EXO_JOB (job)),
+                                                                 &err);
+
+      /* a directory that cannot be opened is unreadable, a child
+       * that cannot be queried ends the enumeration */
+      readable = (child_infos != NULL || err == NULL);
+      if (!readable)
+        {
+          g_propagate_error (error, err);
+          err = NULL;
+        }
     }
   else
     {
-      /* query size and type of the current file */
-      info = g_file_query_info (file,
-                                DEEP_COUNT_FILE_INFO_NAMESPACE,
-                                count_job->query_flags,
-                                exo_job_get_cancellable (job),
-                                error);
+      enumerator = g_file_enumerate_children (directory,
+                                              DEEP_COUNT_FILE_INFO_NAMESPACE ","
+                                              G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                              job->query_flags,
+                                              exo_job_get_cancellable (EXO_JOB (job)),
+                                              error);
+      readable = (enumerator != NULL);
     }
 
-  /* abort on invalid info or cancellation */
-  if (info == NULL)
-    return FALSE;
-
-  /* abort on cancellation */
-  if (exo_job_is_cancelled (job))
+  if (exo_job_is_cancelled (EXO_JOB (job)))
     {
-      g_object_unref (info);
-      return FALSE;
+      if (enumerator != NULL)
+        g_object_unref (enumerator);
+      thunar_g_list_free_full (child_infos);
+      g_clear_error (&err);
+      return TRUE;
     }
 
-  /* only check files on the same filesystem so no remote mounts or
-   * dummy filesystems are counted */
-  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
-  if (fs_id == NULL)
-    fs_id = "";
-
-  if (toplevel_fs_id == NULL)
+  if (!readable)
     {
-      /* first toplevel, so use this id */
-      toplevel_fs_id = fs_id;
-    }
-  else if (strcmp (fs_id, toplevel_fs_id) != 0)
-    {
-      /* release the file info */
-      g_object_unref (info);
+      /* directory was unreadable */
+      g_mutex_lock (&job->mutex);
+      job->unreadable_directory_count++;
+      g_mutex_unlock (&job->mutex);
 
-      /* other filesystem, continue */
-      return TRUE;
+      return FALSE;
     }
 
-  /* recurse if we have a directory */
-  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+  /* the names of the subdirectories for the size cache */
+  directories = g_ptr_array_new_with_free_func (g_free);
+
+  while (!thunar_deep_count_job_stopped (context))
     {
-      /* try to read from the directory */
-      enumerator = g_file_enumerate_children (file,
-                                              DEEP_COUNT_FILE_INFO_NAMESPACE ","
-                                              G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                              count_job->query_flags,
-                                              exo_job_get_cancellable (job),
-                                              error);
+      /* query next child info */
+      if (enumerator != NULL)
+        {
+          child_info = g_file_enumerator_next_file (enumerator,
+                                                    exo_job_get_cancellable (EXO_JOB (job)),
+                                                    &err);
+        }
+      else if (child_infos != NULL)
+        {
+          child_info = child_infos->data;
+          child_infos = g_list_delete_link (child_infos, child_infos);
+        }
+      else
+        {
+          child_info = NULL;
+        }
 
-      if (!exo_job_is_cancelled (job))
+      /* abort on invalid child info (iteration ends) */
+      if (child_info == NULL)
         {
-          if (enumerator == NULL)
-            {
-              /* directory was unreadable */
-              count_job->unreadable_directory_count++;
+          complete = (err == NULL);
+          g_clear_error (&err);
+          break;
+        }
 
-              if (toplevel_file
-                  && g_list_length (count_job->files) < 2)
-                {
-                  /* we only bail out if the job file is unreadable */
-                  success = FALSE;
-                }
-              else
+      /* only check files on the same filesystem so no remote mounts or
+       * dummy filesystems are counted */
+      fs_id = g_file_info_get_attribute_string (child_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+      if (g_strcmp0 (fs_id != NULL ? fs_id : "", directory_fs_id) == 0)
+        {
+          if (g_file_info_get_file_type (child_info) == G_FILE_TYPE_DIRECTORY)
+            {
+              /* let the pool count the subdirectory, the cache keeps the
+               * excluded ones too so it does not depend on the rules */
+              if (!thunar_deep_count_job_excludes (job, g_file_info_get_name (child_info)))
                 {
-                  /* ignore errors from files other than the job file */
-                  g_clear_error (error);
+                  thunar_deep_count_job_push (context,
+                                              g_file_get_child (directory, g_file_info_get_name (child_info)),
+                                              directory_fs_id,
+                                              thunar_deep_count_job_get_mtime (child_info));
                 }
+              g_ptr_array_add (directories, g_strdup (g_file_info_get_name (child_info)));
             }
           else
             {
-              /* directory was readable */
-              count_job->directory_count++;
+              /* we have a regular file or at least not a directory */
+              file_count++;
+              total_size += g_file_info_get_size (child_info);
+            }
+        }
 
-              while (!exo_job_is_cancelled (job))
-                {
-                  /* query next child info */
-                  child_info = g_file_enumerator_next_file (enumerator,
-                                                            exo_job_get_cancellable (job),
-                                                            error);
+      g_object_unref (child_info);
+    }
 
-                  /* abort on invalid child info (iteration ends) or cancellation */
-                  if (child_info == NULL)
-                    break;
+  if (enumerator != NULL)
+    g_object_unref (enumerator);
+  thunar_g_list_free_full (child_infos);
+  g_clear_error (&err);
 
-                  if (!exo_job_is_cancelled (job))
-                    {
-                      /* generate a GFile for the child */
-                      child = g_file_resolve_relative_path (file, g_file_info_get_name (child_info));
+  /* only fully read directories can answer the next count */
+  if (complete && context->use_cache)
+    {
+      g_ptr_array_add (directories, NULL);
+      thunar_size_cache_insert (directory, mtime, total_size, file_count,
+                                (gchar **) directories->pdata);
+    }
+  g_ptr_array_free (directories, TRUE);
 
-                      /* recurse unless the job was cancelled before */
-                      thunar_deep_count_job_process (job, child, child_info, toplevel_fs_id, error);
+done:
+  /* add the results of this directory to the totals */
+  g_mutex_lock (&job->mutex);
+  job->directory_count++;
+  job->file_count += file_count;
+  job->total_size += total_size;
+  g_mutex_unlock (&job->mutex);
 
-                      /* free resources */
-                      g_object_unref (child);
-                    }
+  return TRUE;
+}
 
-                  g_object_unref (child_info);
-                }
-            }
-        }
 
-      /* destroy the enumerator */
-      if (enumerator != NULL)
-        g_object_unref (enumerator);
 
-      /* emit status update whenever we've finished a directory,
-       * but not more than four times per second */
-      real_time = g_get_real_time ();
-      if (real_time >= count_job->last_time)
-        {
-          if (count_job->last_time != 0)
-            thunar_deep_count_job_status_update (count_job);
-          count_job->last_time = real_time + (G_USEC_PER_SEC / 4);
-        }
+static void
+thunar_deep_count_job_process (DeepCountContext *context,
+                               GFile            *file)
+{
+  ThunarDeepCountJob *job = context->job;
+  GFileInfo          *info;
+  const gchar        *fs_id;
+  guint64             mtime;
+  GError             *error = NULL;
+
+  /* query size and type of the job file */
+  info = g_file_query_info (file,
+                            DEEP_COUNT_FILE_INFO_NAMESPACE,
+                            job->query_flags,
+                            exo_job_get_cancellable (EXO_JOB (job)),
+                            &error);
+
+  /* abort on invalid info */
+  if (info == NULL)
+    {
+      thunar_deep_count_job_fail (context, error);
+      return;
     }
-  else
+
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
     {
       /* we have a regular file or at least not a directory */
-      count_job->file_count++;
+      g_mutex_lock (&job->mutex);
+      job->file_count++;
+      job->total_size += g_file_info_get_size (info);
+      g_mutex_unlock (&job->mutex);
 
-      /* add size of the file to the total size */
-      count_job->total_size += g_file_info_get_size (info);
+      g_object_unref (info);
+      return;
     }
 
-  /* destroy the file info */
+  /* the subdirectories share the filesystem id of the job file */
+  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+  fs_id = g_intern_string (fs_id != NULL ? fs_id : "");
+  mtime = thunar_deep_count_job_get_mtime (info);
   g_object_unref (info);
 
-  /* we've succeeded if there was no error when loading information
-   * about the job file itself and the job was not cancelled */
-  return !exo_job_is_cancelled (job) && success;
+  /* count the job file, its subdirectories are handed over to the
+   * pool while we go */
+  if (!thunar_deep_count_job_scan (context, file, fs_id, mtime, &error))
+    {
+      if (job->files->next == NULL)
+        {
+          /* we only bail out if the only job file is unreadable */
+          thunar_deep_count_job_fail (context, error);
+        }
+      else
+        {
+          /* ignore errors from files other than the job file */
+          g_clear_error (&error);
+        }
+    }
+}
+
+
+
+static void
+thunar_deep_count_job_query (DeepCountContext *context,
+                             GFile            *directory,
+                             const gchar      *directory_fs_id)
+{
+  ThunarDeepCountJob *job = context->job;
+  GFileInfo          *info;
+  const gchar        *fs_id;
+  guint64             mtime = 0;
+
+  /* subdirectories of cached directories were not enumerated, so
+   * their modification time is not known yet */
+  info = g_file_query_info (directory,
+                            DEEP_COUNT_FILE_INFO_NAMESPACE,
+                            job->query_flags,
+                            exo_job_get_cancellable (EXO_JOB (job)),
+                            NULL);
+
+  if (G_LIKELY (info != NULL))
+    {
+      /* skip filesystems mounted since the parent was counted */
+      fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+      if (g_strcmp0 (fs_id != NULL ? fs_id : "", directory_fs_id) != 0)
+        {
+          g_object_unref (info);
+          return;
+        }
+
+      mtime = thunar_deep_count_job_get_mtime (info);
+      g_object_unref (info);
+    }
+
+  /* errors from files other than the job files are ignored */
+  thunar_deep_count_job_scan (context, directory, directory_fs_id, mtime, NULL);
+}
+
+
+
+static void
+thunar_deep_count_job_worker (gpointer data,
+                              gpointer user_data)
+{
+  DeepCountContext *context = user_data;
+  DeepCountItem    *item = data;
+
+  if (!thunar_deep_count_job_stopped (context))
+    {
+      if (item->fs_id == NULL)
+        thunar_deep_count_job_process (context, item->file);
+      else if (item->mtime == DEEP_COUNT_MTIME_UNKNOWN)
+        thunar_deep_count_job_query (context, item->file, item->fs_id);
+      else
+        {
+          /* errors from files other than the job files are ignored */
+          thunar_deep_count_job_scan (context, item->file, item->fs_id, item->mtime, NULL);
+        }
+    }
+
+  g_object_unref (item->file);
+  g_slice_free (DeepCountItem, item);
+
+  /* wake up the job when this was the last directory */
+  g_mutex_lock (&context->mutex);
+  if (--context->n_pending == 0)
+    g_cond_signal (&context->cond);
+  g_mutex_unlock (&context->mutex);
 }
 
 
@@ -341,10 +645,13 @@ thunar_deep_count_job_execute (ExoJob  *job,
                                GError **error)
 {
   ThunarDeepCountJob *count_job = THUNAR_DEEP_COUNT_JOB (job);
+  DeepCountContext    context = { 0, };
   gboolean            success = TRUE;
-  GError             *err = NULL;
   GList              *lp;
   GFile              *gfile;
+  gint64              end_time;
+  gint64              trace_time;
+  guint               n_threads;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -353,45 +660,85 @@ thunar_deep_count_job_execute (ExoJob  *job,
   if (exo_job_set_error_if_cancelled (job, error))
     return FALSE;
 
+  /* wait until the job may run in its priority class */
+  if (!thunar_job_enter (THUNAR_JOB (job)))
+    {
+      exo_job_set_error_if_cancelled (job, error);
+      return FALSE;
+    }
+
   /* reset counters */
   count_job->total_size = 0;
   count_job->file_count = 0;
   count_job->directory_count = 0;
   count_job->unreadable_directory_count = 0;
-  count_job->last_time = 0;
-
-  /* count files, directories and compute size of the job files */
+  count_job->excluded_directory_count = 0;
+
+  trace_time = thunar_trace_begin ();
+
+  /* the job files are usually selected in one folder, so the
+   * concurrency is determined once for the first of them */
+  gfile = thunar_file_get_file (THUNAR_FILE (count_job->files->data));
+  n_threads = thunar_io_jobs_util_get_max_threads (gfile, NULL, DEEP_COUNT_MAX_THREADS,
+                                                   exo_job_get_cancellable (job));
+
+  /* followed symlinks would count other trees for the same directories */
+  context.job = count_job;
+  context.use_cache = (count_job->query_flags == G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS);
+  context.inode_order = (n_threads == 1
+                         && thunar_io_jobs_util_is_rotating (gfile, NULL, exo_job_get_cancellable (job)));
+  g_mutex_init (&context.mutex);
+  g_cond_init (&context.cond);
+  context.pool = g_thread_pool_new (thunar_deep_count_job_worker, &context,
+                                    n_threads, FALSE, NULL);
+
+  /* count all job files concurrently, the totals converge while the
+   * directories of all of them are counted */
   for (lp = count_job->files; lp != NULL; lp = lp->next)
-    {
-      gfile = thunar_file_get_file (THUNAR_FILE (lp->data));
-      success = thunar_deep_count_job_process (job, gfile, NULL, NULL, &err);
-      if (G_UNLIKELY (!success))
-        break;
-    }
+    thunar_deep_count_job_push (&context, g_object_ref (thunar_file_get_file (THUNAR_FILE (lp->data))), NULL, 0);
 
-  if (!success)
+  /* wait for the pool, but emit a status update four times per second */
+  g_mutex_lock (&context.mutex);
+  while (context.n_pending > 0)
     {
-      g_assert (err != NULL || exo_job_is_cancelled (job));
-
-      /* set error if the job was cancelled. otherwise just propagate
-       * the results of the processing function */
-      if (exo_job_set_error_if_cancelled (job, error))
-        {
-          if (err != NULL)
-            g_error_free (err);
-        }
-      else
+      end_time = g_get_monotonic_time () + (G_USEC_PER_SEC / 4);
+      if (!g_cond_wait_until (&context.cond, &context.mutex, end_time)
+          && context.n_pending > 0)
         {
-          if (err != NULL)
-            g_propagate_error (error, err);
+          g_mutex_unlock (&context.mutex);
+          thunar_deep_count_job_status_update (count_job);
+          g_mutex_lock (&context.mutex);
         }
     }
-  else if (!exo_job_is_cancelled (job))
+  g_mutex_unlock (&context.mutex);
+
+  g_thread_pool_free (context.pool, FALSE, TRUE);
+  g_mutex_clear (&context.mutex);
+  g_cond_clear (&context.cond);
+
+  if (exo_job_set_error_if_cancelled (job, error))
+    {
+      /* set error if the job was cancelled */
+      success = FALSE;
+      if (context.error != NULL)
+        g_error_free (context.error);
+    }
+  else if (context.error != NULL)
+    {
+      /* propagate the error of the job file */
+      success = FALSE;
+      g_propagate_error (error, context.error);
+    }
+  else
     {
       /* emit final status update at the very end of the computation */
       thunar_deep_count_job_status_update (count_job);
     }
 
+  thunar_trace_end (trace_time, "job", "deep count", NULL);
+
+  thunar_job_leave (THUNAR_JOB (job));
+
   return success;
 }
 
@@ -408,8 +755,35 @@ thunar_deep_count_job_new (GList               *files,
   job = g_object_new (THUNAR_TYPE_DEEP_COUNT_JOB, NULL);
   job->files = g_list_copy (files);
   job->query_flags = flags;
+  job->rules = thunar_scan_rules_get ();
 
   g_list_foreach (job->files, (GFunc) (void (*)(void)) g_object_ref, NULL);
 
   return job;
 }
+
+
+
+/**
+ * thunar_deep_count_job_get_excluded_count:
+ * @job : a #ThunarDeepCountJob.
+ *
+ * Returns the number of folders counted so far that were skipped
+ * because of #ThunarPreferences:misc-scan-exclusions. Their contents
+ * are missing from the totals of the status updates.
+ *
+ * Return value: the number of excluded folders.
+ **/
+guint
+thunar_deep_count_job_get_excluded_count (ThunarDeepCountJob *job)
+{
+  guint count;
+
+  _thunar_return_val_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job), 0);
+
+  g_mutex_lock (&job->mutex);
+  count = job->excluded_directory_count;
+  g_mutex_unlock (&job->mutex);
+
+  return count;
+}
@@ -0,0 +1,257 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-desktop-entry-cache.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The desktop entry cache keeps the parsed .desktop files, so a file is
+ * only read once per change, no matter whether it is opened in a folder,
+ * launched or offered in the "Send To" menu. Entries are keyed by the file
+ * and only returned for the modification time they were parsed for.
+ *
+ * The returned key files are shared and must not be modified.
+ */
+#define DESKTOP_ENTRY_CACHE_MAX_ENTRIES (4096)
+
+
+
+typedef struct
+{
+  guint64   mtime;
+  GKeyFile *key_file;
+}
+DesktopEntry;
+
+
+
+/* the cached entries, protected by the lock below */
+static GHashTable *desktop_entries = NULL;
+G_LOCK_DEFINE_STATIC (desktop_entries);
+
+
+
+static void
+thunar_desktop_entry_free (gpointer data)
+{
+  DesktopEntry *entry = data;
+
+  g_key_file_unref (entry->key_file);
+  g_slice_free (DesktopEntry, entry);
+}
+
+
+
+static void
+thunar_desktop_entry_cache_load_thread (GTask        *task,
+                                        gpointer      source_object,
+                                        gpointer      task_data,
+                                        GCancellable *cancellable)
+{
+  GKeyFile *key_file;
+  GError   *error = NULL;
+
+  key_file = thunar_desktop_entry_cache_load (G_FILE (source_object), *((guint64 *) task_data),
+                                              cancellable, &error);
+  if (G_LIKELY (key_file != NULL))
+    g_task_return_pointer (task, key_file, (GDestroyNotify) g_key_file_unref);
+  else
+    g_task_return_error (task, error);
+}
+
+
+
+/**
+ * thunar_desktop_entry_cache_lookup:
+ * @file  : the #GFile of a .desktop file.
+ * @mtime : the modification time of @file.
+ *
+ * Returns the key file parsed from @file, if it was parsed before and
+ * @file was not modified since. This never does any I/O and may be used
+ * from any thread.
+ *
+ * The caller is responsible to free the returned key file using
+ * g_key_file_unref() when no longer needed.
+ *
+ * Return value: the cached #GKeyFile for @file or %NULL.
+ **/
+GKeyFile *
+thunar_desktop_entry_cache_lookup (GFile   *file,
+                                   guint64  mtime)
+{
+  DesktopEntry *entry;
+  GKeyFile     *key_file = NULL;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  G_LOCK (desktop_entries);
+  if (G_LIKELY (desktop_entries != NULL))
+    {
+      entry = g_hash_table_lookup (desktop_entries, file);
+      if (entry != NULL && entry->mtime == mtime)
+        key_file = g_key_file_ref (entry->key_file);
+    }
+  G_UNLOCK (desktop_entries);
+
+  return key_file;
+}
+
+
+
+/**
+ * thunar_desktop_entry_cache_load:
+ * @file        : the #GFile of a .desktop file.
+ * @mtime       : the modification time of @file.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Like thunar_desktop_entry_cache_lookup(), but parses @file if it is
+ * not cached yet and remembers the result. May be used from any thread.
+ *
+ * The caller is responsible to free the returned key file using
+ * g_key_file_unref() when no longer needed.
+ *
+ * Return value: the #GKeyFile for @file or %NULL on error.
+ **/
+GKeyFile *
+thunar_desktop_entry_cache_load (GFile        *file,
+                                 guint64       mtime,
+                                 GCancellable *cancellable,
+                                 GError      **error)
+{
+  DesktopEntry *entry;
+  GKeyFile     *key_file;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  key_file = thunar_desktop_entry_cache_lookup (file, mtime);
+  if (key_file != NULL)
+    return key_file;
+
+  /* parse the file without holding the lock */
+  key_file = thunar_g_file_query_key_file (file, cancellable, error);
+  if (G_UNLIKELY (key_file == NULL))
+    return NULL;
+
+  entry = g_slice_new (DesktopEntry);
+  entry->mtime = mtime;
+  entry->key_file = g_key_file_ref (key_file);
+
+  G_LOCK (desktop_entries);
+  if (G_UNLIKELY (desktop_entries == NULL))
+    {
+      desktop_entries = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                               g_object_unref, thunar_desktop_entry_free);
+    }
+
+  /* start over instead of tracking the use of every entry */
+  if (G_UNLIKELY (g_hash_table_size (desktop_entries) >= DESKTOP_ENTRY_CACHE_MAX_ENTRIES))
+    g_hash_table_remove_all (desktop_entries);
+
+  g_hash_table_replace (desktop_entries, g_object_ref (file), entry);
+  G_UNLOCK (desktop_entries);
+
+  return key_file;
+}
+
+
+
+/**
+ * thunar_desktop_entry_cache_load_async:
+ * @file        : the #GFile of a .desktop file.
+ * @mtime       : the modification time of @file.
+ * @cancellable : a #GCancellable or %NULL.
+ * @callback    : the function to call once @file is parsed.
+ * @user_data   : data to pass to @callback.
+ *
+ * Asynchronous version of thunar_desktop_entry_cache_load(), which
+ * parses @file on a worker thread. Use
+ * thunar_desktop_entry_cache_load_finish() in @callback to get the result.
+ **/
+void
+thunar_desktop_entry_cache_load_async (GFile               *file,
+                                       guint64              mtime,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  GTask   *task;
+  guint64 *task_mtime;
+
+  _thunar_return_if_fail (G_IS_FILE (file));
+
+  task_mtime = g_new (guint64, 1);
+  *task_mtime = mtime;
+
+  task = g_task_new (file, cancellable, callback, user_data);
+  g_task_set_task_data (task, task_mtime, g_free);
+  g_task_run_in_thread (task, thunar_desktop_entry_cache_load_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * thunar_desktop_entry_cache_load_finish:
+ * @file   : the #GFile passed to thunar_desktop_entry_cache_load_async().
+ * @result : the #GAsyncResult passed to the callback.
+ * @error  : return location for errors or %NULL.
+ *
+ * Finishes an operation started with thunar_desktop_entry_cache_load_async().
+ *
+ * The caller is responsible to free the returned key file using
+ * g_key_file_unref() when no longer needed.
+ *
+ * Return value: the #GKeyFile for @file or %NULL on error.
+ **/
+GKeyFile *
+thunar_desktop_entry_cache_load_finish (GFile         *file,
+                                        GAsyncResult  *result,
+                                        GError       **error)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (g_task_is_valid (result, file), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+
+
+/**
+ * thunar_desktop_entry_cache_clear:
+ *
+ * Drops all parsed desktop entries from the cache to release memory.
+ * Key files still used by a #ThunarFile stay alive until released.
+ **/
+void
+thunar_desktop_entry_cache_clear (void)
+{
+  G_LOCK (desktop_entries);
+  if (desktop_entries != NULL)
+    g_hash_table_remove_all (desktop_entries);
+  G_UNLOCK (desktop_entries);
+}
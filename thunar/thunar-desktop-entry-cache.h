@@ -0,0 +1,50 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_DESKTOP_ENTRY_CACHE_H__
+#define __THUNAR_DESKTOP_ENTRY_CACHE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+GKeyFile *thunar_desktop_entry_cache_lookup      (GFile               *file,
+                                                  guint64              mtime);
+
+GKeyFile *thunar_desktop_entry_cache_load        (GFile               *file,
+                                                  guint64              mtime,
+                                                  GCancellable        *cancellable,
+                                                  GError             **error);
+
+void      thunar_desktop_entry_cache_load_async  (GFile               *file,
+                                                  guint64              mtime,
+                                                  GCancellable        *cancellable,
+                                                  GAsyncReadyCallback  callback,
+                                                  gpointer             user_data);
+
+GKeyFile *thunar_desktop_entry_cache_load_finish (GFile               *file,
+                                                  GAsyncResult        *result,
+                                                  GError             **error);
+
+void      thunar_desktop_entry_cache_clear       (void);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_DESKTOP_ENTRY_CACHE_H__ */
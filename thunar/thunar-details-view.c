@@ -29,10 +29,17 @@
 #include <thunar/thunar-gtk-extensions.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-scheduler.h>
+#include <thunar/thunar-user.h>
 #include <thunar/thunar-window.h>
 
 
 
+/* maximum number of visible rows measured by the column autosizing */
+#define THUNAR_DETAILS_VIEW_AUTOSIZE_N_ROWS (200)
+
+
+
 /* Property identifiers */
 enum
 {
@@ -53,6 +60,7 @@ static void         thunar_details_view_set_property            (GObject
                                                                  GParamSpec             *pspec);
 static AtkObject   *thunar_details_view_get_accessible          (GtkWidget              *widget);
 static GList       *thunar_details_view_get_selected_items      (ThunarStandardView     *standard_view);
+static GArray      *thunar_details_view_get_selected_ranges     (ThunarStandardView     *standard_view);
 static void         thunar_details_view_select_all              (ThunarStandardView     *standard_view);
 static void         thunar_details_view_unselect_all            (ThunarStandardView     *standard_view);
 static void         thunar_details_view_selection_invert        (ThunarStandardView     *standard_view);
@@ -100,6 +108,10 @@ static void         thunar_details_view_row_changed             (GtkTreeView
 static void         thunar_details_view_columns_changed         (ThunarColumnModel      *column_model,
                                                                  ThunarDetailsView      *details_view);
 static void         thunar_details_view_zoom_level_changed      (ThunarDetailsView      *details_view);
+static void         thunar_details_view_autosize_queue          (ThunarDetailsView      *details_view);
+static gboolean     thunar_details_view_autosize_idle           (gpointer                user_data);
+static void         thunar_details_view_autosize_idle_destroy   (gpointer                user_data);
+static void         thunar_details_view_autosize_columns        (ThunarDetailsView      *details_view);
 static gboolean     thunar_details_view_get_fixed_columns       (ThunarDetailsView      *details_view);
 static void         thunar_details_view_set_fixed_columns       (ThunarDetailsView      *details_view,
                                                                  gboolean                fixed_columns);
@@ -126,6 +138,9 @@ struct _ThunarDetailsView
   /* the column model */
   ThunarColumnModel *column_model;
 
+  /* resolves the owners and groups shown in the columns */
+  ThunarUserManager *user_manager;
+
   /* the tree view columns */
   GtkTreeViewColumn *columns[THUNAR_N_VISIBLE_COLUMNS];
 
@@ -138,6 +153,11 @@ struct _ThunarDetailsView
   /* event source id for thunar_details_view_zoom_level_changed_reload_fixed_columns */
   guint idle_id;
 
+  /* the widths measured while the columns are sized automatically,
+   * see thunar_details_view_autosize_columns() */
+  gint               autosize_widths[THUNAR_N_VISIBLE_COLUMNS];
+  guint              autosize_idle_id;
+
 };
 
 
@@ -172,6 +192,7 @@ thunar_details_view_class_init (ThunarDetailsViewClass *klass)
 
   thunarstandard_view_class = THUNAR_STANDARD_VIEW_CLASS (klass);
   thunarstandard_view_class->get_selected_items = thunar_details_view_get_selected_items;
+  thunarstandard_view_class->get_selected_ranges = thunar_details_view_get_selected_ranges;
   thunarstandard_view_class->select_all = thunar_details_view_select_all;
   thunarstandard_view_class->unselect_all = thunar_details_view_unselect_all;
   thunarstandard_view_class->selection_invert = thunar_details_view_selection_invert;
@@ -234,8 +255,15 @@ thunar_details_view_init (ThunarDetailsView *details_view)
   gtk_container_add (GTK_CONTAINER (details_view), tree_view);
   gtk_widget_show (tree_view);
 
+  /* the owner and group columns show the ids until the names are
+   * looked up in the background, so redraw once they are known */
+  details_view->user_manager = thunar_user_manager_get_default ();
+  g_signal_connect_object (G_OBJECT (details_view->user_manager), "changed",
+                           G_CALLBACK (gtk_widget_queue_draw), tree_view, G_CONNECT_SWAPPED);
+
   /* configure general aspects of the details view */
   gtk_tree_view_set_enable_search (GTK_TREE_VIEW (tree_view), TRUE);
+  gtk_tree_view_set_search_equal_func (GTK_TREE_VIEW (tree_view), thunar_list_model_search_equal, NULL, NULL);
 
   /* enable rubberbanding (if supported) */
   gtk_tree_view_set_rubber_banding (GTK_TREE_VIEW (tree_view), TRUE);
@@ -246,6 +274,15 @@ thunar_details_view_init (ThunarDetailsView *details_view)
   g_signal_connect_after (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model), "row-changed",
                           G_CALLBACK (thunar_details_view_row_changed), details_view);
 
+  /* while the columns are sized automatically, the new and changed rows
+   * and the rows scrolled into view are measured in an idle */
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model), "row-inserted",
+                           G_CALLBACK (thunar_details_view_autosize_queue), details_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model), "row-changed",
+                           G_CALLBACK (thunar_details_view_autosize_queue), details_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (details_view))), "value-changed",
+                           G_CALLBACK (thunar_details_view_autosize_queue), details_view, G_CONNECT_SWAPPED);
+
   /* allocate the shared right-aligned text renderer */
   right_aligned_renderer = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT, "xalign", 1.0f, NULL);
   g_object_ref_sink (G_OBJECT (right_aligned_renderer));
@@ -273,17 +310,15 @@ thunar_details_view_init (ThunarDetailsView *details_view)
         {
           /* add the icon renderer */
           gtk_tree_view_column_pack_start (details_view->columns[column], THUNAR_STANDARD_VIEW (details_view)->icon_renderer, FALSE);
-          gtk_tree_view_column_set_attributes (details_view->columns[column], THUNAR_STANDARD_VIEW (details_view)->icon_renderer,
-                                               "file", THUNAR_COLUMN_FILE,
-                                               NULL);
+          gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (details_view->columns[column]), THUNAR_STANDARD_VIEW (details_view)->icon_renderer,
+                                              thunar_standard_view_file_cell_data, NULL, NULL);
 
           /* add the name renderer */
           g_object_set (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->name_renderer),
                         "xalign", 0.0, "ellipsize", PANGO_ELLIPSIZE_END, "width-chars", 30, NULL);
           gtk_tree_view_column_pack_start (details_view->columns[column], THUNAR_STANDARD_VIEW (details_view)->name_renderer, TRUE);
-          gtk_tree_view_column_set_attributes (details_view->columns[column], THUNAR_STANDARD_VIEW (details_view)->name_renderer,
-                                               "text", THUNAR_COLUMN_NAME,
-                                               NULL);
+          gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (details_view->columns[column]), THUNAR_STANDARD_VIEW (details_view)->name_renderer,
+                                              thunar_standard_view_text_cell_data, GINT_TO_POINTER (THUNAR_COLUMN_NAME), NULL);
 
           /* add some spacing between the icon and the name */
           gtk_tree_view_column_set_spacing (details_view->columns[column], 2);
@@ -296,7 +331,8 @@ thunar_details_view_init (ThunarDetailsView *details_view)
 
           /* add the renderer */
           gtk_tree_view_column_pack_start (details_view->columns[column], renderer, TRUE);
-          gtk_tree_view_column_set_attributes (details_view->columns[column], renderer, "text", column, NULL);
+          gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (details_view->columns[column]), renderer,
+                                              thunar_standard_view_text_cell_data, GINT_TO_POINTER (column), NULL);
         }
 
       /* append the tree view column to the tree view */
@@ -326,6 +362,13 @@ thunar_details_view_init (ThunarDetailsView *details_view)
       for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
         gtk_tree_view_column_set_fixed_width (details_view->columns[column], thunar_column_model_get_column_width (details_view->column_model, column));
     }
+  else
+    {
+      /* otherwise the widths are measured on a sample of the rows */
+      for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+        gtk_tree_view_column_set_sizing (details_view->columns[column], GTK_TREE_VIEW_COLUMN_FIXED);
+      thunar_details_view_autosize_queue (details_view);
+    }
 
   /* release the shared text renderers */
   g_object_unref (G_OBJECT (right_aligned_renderer));
@@ -392,9 +435,14 @@ thunar_details_view_finalize (GObject *object)
   g_signal_handlers_disconnect_by_func (G_OBJECT (details_view->column_model), thunar_details_view_columns_changed, details_view);
   g_object_unref (G_OBJECT (details_view->column_model));
 
+  g_object_unref (G_OBJECT (details_view->user_manager));
+
   if (details_view->idle_id)
     g_source_remove (details_view->idle_id);
 
+  if (details_view->autosize_idle_id != 0)
+    thunar_scheduler_remove (details_view->autosize_idle_id);
+
   (*G_OBJECT_CLASS (thunar_details_view_parent_class)->finalize) (object);
 }
 
@@ -461,14 +509,30 @@ thunar_details_view_unselect_all (ThunarStandardView *standard_view)
 
 
 static void
-thunar_details_view_selection_invert_foreach (GtkTreeModel *model,
-                                              GtkTreePath  *path,
-                                              GtkTreeIter  *iter,
-                                              gpointer      data)
+thunar_details_view_selected_ranges_foreach (GtkTreeModel *model,
+                                             GtkTreePath  *path,
+                                             GtkTreeIter  *iter,
+                                             gpointer      data)
 {
-  GList      **list = data;
+  /* the rows are visited in ascending order */
+  thunar_selection_ranges_add_path (data, path);
+}
+
+
+
+static GArray*
+thunar_details_view_get_selected_ranges (ThunarStandardView *standard_view)
+{
+  GtkTreeSelection *selection;
+  GArray           *ranges;
 
-  *list = g_list_prepend (*list, gtk_tree_path_copy (path));
+  _thunar_return_val_if_fail (THUNAR_IS_DETAILS_VIEW (standard_view), NULL);
+
+  ranges = thunar_selection_ranges_new ();
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (standard_view))));
+  gtk_tree_selection_selected_foreach (selection, thunar_details_view_selected_ranges_foreach, ranges);
+
+  return ranges;
 }
 
 
@@ -476,36 +540,40 @@ thunar_details_view_selection_invert_foreach (GtkTreeModel *model,
 static void
 thunar_details_view_selection_invert (ThunarStandardView *standard_view)
 {
-  GtkTreeSelection *selection;
-  GList            *selected_paths = NULL;
-  GList            *lp;
-  GtkTreePath      *path;
+  GtkTreeSelection     *selection;
+  ThunarSelectionRange *range;
+  GtkTreePath          *first;
+  GtkTreePath          *last;
+  GArray               *selected;
+  GArray               *inverted;
+  guint                 n;
 
   _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (standard_view));
 
   selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (standard_view))));
 
-  /* block updates */
-  g_signal_handlers_block_by_func (selection, thunar_standard_view_selection_changed, standard_view);
+  /* select the gaps between the selected ranges, a range at a time */
+  selected = thunar_details_view_get_selected_ranges (standard_view);
+  inverted = thunar_selection_ranges_invert (selected, gtk_tree_model_iter_n_children (GTK_TREE_MODEL (standard_view->model), NULL));
 
-  /* get paths of selected files */
-  gtk_tree_selection_selected_foreach (selection, thunar_details_view_selection_invert_foreach, &selected_paths);
+  thunar_standard_view_freeze_selection (standard_view);
 
-  gtk_tree_selection_select_all (selection);
+  gtk_tree_selection_unselect_all (selection);
 
-  for (lp = selected_paths; lp != NULL; lp = lp->next)
+  for (n = 0; n < inverted->len; ++n)
     {
-      path = lp->data;
-      gtk_tree_selection_unselect_path (selection, path);
-      gtk_tree_path_free (path);
+      range = &g_array_index (inverted, ThunarSelectionRange, n);
+      first = gtk_tree_path_new_from_indices (range->first, -1);
+      last = gtk_tree_path_new_from_indices (range->last, -1);
+      gtk_tree_selection_select_range (selection, first, last);
+      gtk_tree_path_free (first);
+      gtk_tree_path_free (last);
     }
 
-  g_list_free (selected_paths);
-
-  /* unblock updates */
-  g_signal_handlers_unblock_by_func (selection, thunar_standard_view_selection_changed, standard_view);
+  thunar_standard_view_thaw_selection (standard_view);
 
-  thunar_standard_view_selection_changed (THUNAR_STANDARD_VIEW (standard_view));
+  g_array_unref (selected);
+  g_array_unref (inverted);
 }
 
 
@@ -871,6 +939,9 @@ thunar_details_view_columns_changed (ThunarColumnModel *column_model,
                                            details_view->columns[column_order[column - 1]]);
         }
     }
+
+  /* measure the columns that became visible */
+  thunar_details_view_autosize_queue (details_view);
 }
 
 
@@ -899,6 +970,17 @@ thunar_details_view_zoom_level_changed (ThunarDetailsView *details_view)
   if (details_view->fixed_columns == TRUE)
     fixed_columns_used = TRUE;
 
+  /* measure the sample again for the new icon size, the tree view
+   * determines the new row height once fixed height mode is enabled */
+  if (!fixed_columns_used)
+    {
+      for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+        details_view->autosize_widths[column] = 0;
+      gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (details_view))), FALSE);
+      thunar_details_view_autosize_queue (details_view);
+      return;
+    }
+
   /* Disable fixed column mode during resize, since it can generate graphical glitches */
   if (fixed_columns_used)
       thunar_details_view_set_fixed_columns (details_view, FALSE);
@@ -919,6 +1001,140 @@ thunar_details_view_zoom_level_changed (ThunarDetailsView *details_view)
 
 
 
+static void
+thunar_details_view_autosize_queue (ThunarDetailsView *details_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (details_view));
+
+  /* the columns are only measured while they are sized automatically */
+  if (details_view->fixed_columns || details_view->autosize_idle_id != 0)
+    return;
+
+  /* run before the tree view allocates the columns */
+  details_view->autosize_idle_id = thunar_scheduler_add_idle (G_PRIORITY_HIGH_IDLE, thunar_details_view_autosize_idle,
+                                                              details_view, thunar_details_view_autosize_idle_destroy);
+}
+
+
+
+static gboolean
+thunar_details_view_autosize_idle (gpointer user_data)
+{
+  thunar_details_view_autosize_columns (THUNAR_DETAILS_VIEW (user_data));
+  return FALSE;
+}
+
+
+
+static void
+thunar_details_view_autosize_idle_destroy (gpointer user_data)
+{
+  THUNAR_DETAILS_VIEW (user_data)->autosize_idle_id = 0;
+}
+
+
+
+/**
+ * thunar_details_view_autosize_columns:
+ * @details_view : a #ThunarDetailsView.
+ *
+ * Sizes the columns of @details_view to fit their contents, without
+ * letting the #GtkTreeView measure every row. Only a sample is measured:
+ * the visible rows and the rows with the longest names, which the model
+ * keeps track of. The columns only grow, like %GTK_TREE_VIEW_COLUMN_GROW_ONLY,
+ * but keep a fixed width, so fixed height mode can be used.
+ **/
+static void
+thunar_details_view_autosize_columns (ThunarDetailsView *details_view)
+{
+  GtkTreeViewColumn *tree_column;
+  GtkTreeModel      *model;
+  GtkTreePath       *start_path;
+  GtkTreePath       *end_path;
+  GtkTreePath       *path;
+  GtkTreeIter        iter;
+  ThunarColumn       column;
+  GtkWidget         *tree_view;
+  GtkWidget         *button;
+  GList             *paths;
+  GList             *lp;
+  gint               separator;
+  gint               width;
+  gint               cell_width;
+  gint               n_rows;
+  gint               n;
+
+  _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (details_view));
+
+  tree_view = gtk_bin_get_child (GTK_BIN (details_view));
+  if (G_UNLIKELY (tree_view == NULL || details_view->fixed_columns))
+    return;
+
+  /* the rows with the longest names... */
+  model = GTK_TREE_MODEL (THUNAR_STANDARD_VIEW (details_view)->model);
+  paths = thunar_list_model_get_longest_paths (THUNAR_STANDARD_VIEW (details_view)->model);
+
+  /* ...and the visible rows, or the first rows if nothing is visible yet */
+  if (gtk_tree_view_get_visible_range (GTK_TREE_VIEW (tree_view), &start_path, &end_path))
+    {
+      path = start_path;
+      for (n = 0; n < THUNAR_DETAILS_VIEW_AUTOSIZE_N_ROWS && gtk_tree_path_compare (path, end_path) <= 0; ++n)
+        {
+          paths = g_list_prepend (paths, gtk_tree_path_copy (path));
+          gtk_tree_path_next (path);
+        }
+      gtk_tree_path_free (start_path);
+      gtk_tree_path_free (end_path);
+    }
+  else
+    {
+      n_rows = MIN (gtk_tree_model_iter_n_children (model, NULL), THUNAR_DETAILS_VIEW_AUTOSIZE_N_ROWS);
+      for (n = 0; n < n_rows; ++n)
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (n, -1));
+    }
+
+  /* the tree view adds the separator to the width of every cell */
+  gtk_widget_style_get (tree_view, "horizontal-separator", &separator, NULL);
+
+  for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+    {
+      tree_column = details_view->columns[column];
+      if (!gtk_tree_view_column_get_visible (tree_column))
+        continue;
+
+      width = details_view->autosize_widths[column];
+      for (lp = paths; lp != NULL; lp = lp->next)
+        if (gtk_tree_model_get_iter (model, &iter, lp->data))
+          {
+            gtk_tree_view_column_cell_set_cell_data (tree_column, model, &iter, FALSE, FALSE);
+            gtk_tree_view_column_cell_get_size (tree_column, NULL, NULL, NULL, &cell_width, NULL);
+            width = MAX (width, cell_width + separator);
+          }
+
+      /* the column header must fit as well */
+      button = gtk_tree_view_column_get_button (tree_column);
+      if (G_LIKELY (button != NULL))
+        {
+          gtk_widget_get_preferred_width (button, NULL, &cell_width);
+          width = MAX (width, cell_width);
+        }
+
+      if (details_view->autosize_widths[column] != width)
+        {
+          details_view->autosize_widths[column] = width;
+          gtk_tree_view_column_set_fixed_width (tree_column, MAX (width, 1));
+        }
+    }
+
+  g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
+
+  /* all columns have a fixed width, so fixed height mode can be used */
+  if (!gtk_tree_view_get_fixed_height_mode (GTK_TREE_VIEW (tree_view)))
+    gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (tree_view), TRUE);
+}
+
+
+
 /**
  * thunar_details_view_connect_accelerators:
  * @standard_view : a #ThunarStandardView.
@@ -1047,15 +1263,19 @@ thunar_details_view_set_fixed_columns (ThunarDetailsView *details_view,
             }
           else
             {
-              /* reset column to grow-only mode */
-              gtk_tree_view_column_set_sizing (details_view->columns[column], GTK_TREE_VIEW_COLUMN_GROW_ONLY);
+              /* the autosizing grows the columns from their current width */
+              details_view->autosize_widths[column] = gtk_tree_view_column_get_width (details_view->columns[column]);
+              gtk_tree_view_column_set_sizing (details_view->columns[column], GTK_TREE_VIEW_COLUMN_FIXED);
             }
         }
 
       /* for fixed columns mode, we can enable the fixed height
-       * mode to improve the performance of the GtkTreeVeiw. */
+       * mode to improve the performance of the GtkTreeVeiw. The
+       * autosizing enables it once the columns are measured. */
       if (fixed_columns)
         gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (details_view))), TRUE);
+      else
+        thunar_details_view_autosize_columns (details_view);
 
       /* notify listeners */
       g_object_notify (G_OBJECT (details_view), "fixed-columns");
@@ -28,9 +28,11 @@
 #endif
 
 #include <thunar/thunar-device-monitor.h>
+#include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-util.h>
 
 
 
@@ -50,6 +52,19 @@ enum
   PROP_HIDDEN_DEVICES
 };
 
+/* pending notifications of a device */
+enum
+{
+  DEVICE_PENDING_ADDED   = 1 << 0,
+  DEVICE_PENDING_CHANGED = 1 << 1,
+};
+
+
+
+/* milliseconds to collect device events before they are emitted, a hub
+ * or docking station reports dozens of volumes and mounts in a row */
+#define THUNAR_DEVICE_MONITOR_EVENT_DELAY (100)
+
 
 
 static void           thunar_device_monitor_finalize               (GObject                *object);
@@ -85,6 +100,10 @@ static void           thunar_device_monitor_mount_changed          (GVolumeMonit
 static void           thunar_device_monitor_mount_pre_unmount      (GVolumeMonitor         *volume_monitor,
                                                                     GMount                 *mount,
                                                                     ThunarDeviceMonitor    *monitor);
+static void           thunar_device_monitor_queue                  (ThunarDeviceMonitor    *monitor,
+                                                                    ThunarDevice           *device,
+                                                                    guint                   pending);
+static void           thunar_device_monitor_flush                  (ThunarDeviceMonitor    *monitor);
 
 
 
@@ -119,6 +138,14 @@ struct _ThunarDeviceMonitor
   /* user defined hidden volumes */
   ThunarPreferences  *preferences;
   gchar             **hidden_devices;
+
+  /* ThunarDevice -> pending notifications, in order of the first event */
+  GHashTable         *pending;
+  GList              *pending_order;
+  guint               pending_timeout_id;
+
+  /* the visible devices shared by all consumers, rebuilt on demand */
+  GList              *snapshot;
 };
 
 
@@ -224,6 +251,10 @@ thunar_device_monitor_init (ThunarDeviceMonitor *monitor)
     }
   g_list_free (list);
 
+  /* the devices found so far are known to everybody right away,
+   * only the events from now on are collected */
+  monitor->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   /* watch changes */
   g_signal_connect (monitor->volume_monitor, "volume-added", G_CALLBACK (thunar_device_monitor_volume_added), monitor);
   g_signal_connect (monitor->volume_monitor, "volume-removed", G_CALLBACK (thunar_device_monitor_volume_removed), monitor);
@@ -245,6 +276,13 @@ thunar_device_monitor_finalize (GObject *object)
   g_object_unref (monitor->preferences);
   g_strfreev (monitor->hidden_devices);
 
+  /* drop pending notifications */
+  if (monitor->pending_timeout_id != 0)
+    g_source_remove (monitor->pending_timeout_id);
+  g_list_free_full (monitor->pending_order, g_object_unref);
+  g_hash_table_destroy (monitor->pending);
+  g_list_free_full (monitor->snapshot, g_object_unref);
+
   /* detatch from the monitor */
   g_signal_handlers_disconnect_matched (monitor->volume_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, monitor);
   g_object_unref (monitor->volume_monitor);
@@ -347,7 +385,7 @@ thunar_device_monitor_update_hidden (gpointer key,
   if (thunar_device_get_hidden (device) != hidden)
     {
       g_object_set (G_OBJECT (device), "hidden", hidden, NULL);
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+      thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_CHANGED);
     }
 }
 
@@ -414,10 +452,13 @@ thunar_device_monitor_volume_removed (GVolumeMonitor      *volume_monitor,
         return;
 
       /* the device is not visble for the user */
+      thunar_device_monitor_flush (monitor);
       g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_REMOVED], 0, device);
 
       /* drop it */
       g_hash_table_remove (monitor->devices, volume);
+      g_list_free_full (monitor->snapshot, g_object_unref);
+      monitor->snapshot = NULL;
     }
 }
 
@@ -460,7 +501,7 @@ thunar_device_monitor_volume_changed (GVolumeMonitor      *volume_monitor,
       g_hash_table_insert (monitor->devices, volume, device);
 
       /* notify */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_ADDED], 0, device);
+      thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_ADDED);
     }
   else
     {
@@ -473,7 +514,7 @@ thunar_device_monitor_volume_changed (GVolumeMonitor      *volume_monitor,
         return;
 
       /* the device changed */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+      thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_CHANGED);
     }
 }
 
@@ -545,7 +586,7 @@ thunar_device_monitor_mount_added (GVolumeMonitor      *volume_monitor,
       g_hash_table_insert (monitor->devices, g_object_ref (mount), device);
 
       /* notify */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_ADDED], 0, device);
+      thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_ADDED);
     }
   else
     {
@@ -557,7 +598,7 @@ thunar_device_monitor_mount_added (GVolumeMonitor      *volume_monitor,
           thunar_device_reload_file (device);
 
           /* notify */
-          g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+          thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_CHANGED);
         }
 
       g_object_unref (volume);
@@ -585,10 +626,13 @@ thunar_device_monitor_mount_removed (GVolumeMonitor      *volume_monitor,
   if (device != NULL)
     {
       /* notify */
+      thunar_device_monitor_flush (monitor);
       g_signal_emit (G_OBJECT (monitor),device_monitor_signals[DEVICE_REMOVED], 0, device);
 
       /* drop it */
       g_hash_table_remove (monitor->devices, mount);
+      g_list_free_full (monitor->snapshot, g_object_unref);
+      monitor->snapshot = NULL;
     }
   else
     {
@@ -600,6 +644,7 @@ thunar_device_monitor_mount_removed (GVolumeMonitor      *volume_monitor,
           if (device != NULL)
             {
               /* we can't get the file from the volume at this point so provide it */
+              thunar_device_monitor_flush (monitor);
               root_file = g_mount_get_root (mount);
               g_signal_emit (G_OBJECT (monitor),
                              device_monitor_signals[DEVICE_PRE_UNMOUNT], 0,
@@ -631,7 +676,7 @@ thunar_device_monitor_mount_changed (GVolumeMonitor      *volume_monitor,
   if (device != NULL)
     {
       /* notify */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+      thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_CHANGED);
     }
 }
 
@@ -667,6 +712,7 @@ thunar_device_monitor_mount_pre_unmount (GVolumeMonitor      *volume_monitor,
   if (device != NULL)
     {
       /* notify */
+      thunar_device_monitor_flush (monitor);
       root_file = g_mount_get_root (mount);
       g_signal_emit (G_OBJECT (monitor),
                      device_monitor_signals[DEVICE_PRE_UNMOUNT],
@@ -682,10 +728,117 @@ thunar_device_monitor_list_prepend (gpointer key,
                                     gpointer value,
                                     gpointer user_data)
 {
-  GList **list = user_data;
+  ThunarDeviceMonitor *monitor = THUNAR_DEVICE_MONITOR (user_data);
+  guint                pending;
 
   _thunar_return_if_fail (THUNAR_IS_DEVICE (value));
-  *list = g_list_prepend (*list, g_object_ref (value));
+
+  /* devices that were not announced yet follow with "device-added" */
+  pending = (monitor->pending != NULL) ? GPOINTER_TO_UINT (g_hash_table_lookup (monitor->pending, value)) : 0;
+  if ((pending & DEVICE_PENDING_ADDED) == 0)
+    monitor->snapshot = g_list_prepend (monitor->snapshot, g_object_ref (value));
+}
+
+
+
+static gboolean
+thunar_device_monitor_pending_timeout (gpointer user_data)
+{
+  ThunarDeviceMonitor *monitor = THUNAR_DEVICE_MONITOR (user_data);
+
+THUNAR_THREADS_ENTER
+
+  monitor->pending_timeout_id = 0;
+  thunar_device_monitor_flush (monitor);
+
+THUNAR_THREADS_LEAVE
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_device_monitor_queue (ThunarDeviceMonitor *monitor,
+                             ThunarDevice        *device,
+                             guint                pending)
+{
+  guint old_pending;
+
+  _thunar_return_if_fail (THUNAR_IS_DEVICE_MONITOR (monitor));
+  _thunar_return_if_fail (THUNAR_IS_DEVICE (device));
+
+  /* whatever was derived from the device is outdated now */
+  thunar_device_invalidate (device);
+
+  /* nobody listens while the initial devices are loaded */
+  if (G_UNLIKELY (monitor->pending == NULL))
+    return;
+
+  old_pending = GPOINTER_TO_UINT (g_hash_table_lookup (monitor->pending, device));
+  if (old_pending == 0)
+    monitor->pending_order = g_list_prepend (monitor->pending_order, g_object_ref (device));
+  g_hash_table_insert (monitor->pending, device, GUINT_TO_POINTER (old_pending | pending));
+
+  /* a device that is not announced yet is not in the snapshot */
+  if ((pending & DEVICE_PENDING_ADDED) != 0)
+    {
+      g_list_free_full (monitor->snapshot, g_object_unref);
+      monitor->snapshot = NULL;
+    }
+
+  if (monitor->pending_timeout_id == 0)
+    {
+      monitor->pending_timeout_id = g_timeout_add (THUNAR_DEVICE_MONITOR_EVENT_DELAY,
+                                                   thunar_device_monitor_pending_timeout,
+                                                   monitor);
+    }
+}
+
+
+
+static void
+thunar_device_monitor_flush (ThunarDeviceMonitor *monitor)
+{
+  ThunarDevice *device;
+  GList        *order;
+  GList        *lp;
+  guint         pending;
+
+  _thunar_return_if_fail (THUNAR_IS_DEVICE_MONITOR (monitor));
+
+  if (monitor->pending_order == NULL)
+    return;
+
+  if (monitor->pending_timeout_id != 0)
+    {
+      g_source_remove (monitor->pending_timeout_id);
+      monitor->pending_timeout_id = 0;
+    }
+
+  /* the new devices become part of the snapshot */
+  g_list_free_full (monitor->snapshot, g_object_unref);
+  monitor->snapshot = NULL;
+
+  /* handlers may queue new events while we emit these */
+  order = g_list_reverse (monitor->pending_order);
+  monitor->pending_order = NULL;
+
+  for (lp = order; lp != NULL; lp = lp->next)
+    {
+      device = THUNAR_DEVICE (lp->data);
+
+      pending = GPOINTER_TO_UINT (g_hash_table_lookup (monitor->pending, device));
+      g_hash_table_remove (monitor->pending, device);
+
+      /* an added device is announced with its latest state */
+      if ((pending & DEVICE_PENDING_ADDED) != 0)
+        g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_ADDED], 0, device);
+      else if ((pending & DEVICE_PENDING_CHANGED) != 0)
+        g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+    }
+
+  g_list_free_full (order, g_object_unref);
 }
 
 
@@ -713,13 +866,13 @@ static ThunarDeviceMonitor *monitor = NULL;
 GList *
 thunar_device_monitor_get_devices (ThunarDeviceMonitor *monitor)
 {
-  GList *list = NULL;
-
   _thunar_return_val_if_fail (THUNAR_IS_DEVICE_MONITOR (monitor), NULL);
 
-  g_hash_table_foreach (monitor->devices, thunar_device_monitor_list_prepend, &list);
+  /* the snapshot is only rebuilt after devices came or went */
+  if (monitor->snapshot == NULL)
+    g_hash_table_foreach (monitor->devices, thunar_device_monitor_list_prepend, monitor);
 
-  return list;
+  return thunar_g_list_copy_deep (monitor->snapshot);
 }
 
 
@@ -742,9 +895,10 @@ thunar_device_monitor_set_hidden (ThunarDeviceMonitor *monitor,
   if (id == NULL)
     return;
 
-  /* update device */
+  /* update device, the user expects to see this right away */
   g_object_set (G_OBJECT (device), "hidden", hidden, NULL);
-  g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+  thunar_device_monitor_queue (monitor, device, DEVICE_PENDING_CHANGED);
+  thunar_device_monitor_flush (monitor);
 
   /* update the device list */
   length = monitor->hidden_devices != NULL ? g_strv_length (monitor->hidden_devices) : 0;
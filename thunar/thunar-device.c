@@ -21,11 +21,13 @@
 #include <config.h>
 #endif
 
+#include <thunar/thunar-application.h>
 #include <thunar/thunar-device.h>
 #include <thunar/thunar-device-monitor.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-notify.h>
+#include <thunar/thunar-transfer-job.h>
 
 
 
@@ -76,6 +78,10 @@ struct _ThunarDevice
 
   /* added time for sorting */
   gint64            stamp;
+
+  /* derived from the device until it changes */
+  gchar            *name;
+  GIcon            *icon;
 };
 
 typedef struct
@@ -162,6 +168,8 @@ thunar_device_finalize (GObject *object)
   if (device->device != NULL)
     g_object_unref (G_OBJECT (device->device));
 
+  thunar_device_invalidate (device);
+
   (*G_OBJECT_CLASS (thunar_device_parent_class)->finalize) (object);
 }
 
@@ -235,8 +243,74 @@ show_unmount_progress_cb (GMountOperation *mount_operation,
                           gint64           bytes_left,
                           ThunarDevice    *device)
 {
-  if (message_to_show != NULL)
-    thunar_notify_progress (device, message_to_show);
+  gchar *size_string;
+  gchar *message;
+
+  if (message_to_show == NULL)
+    return;
+
+  /* tell how much is still to be written, so users wait for it */
+  if (bytes_left > 0)
+    {
+      size_string = g_format_size (bytes_left);
+      message = g_strdup_printf (_("%s\n%s left to write"), message_to_show, size_string);
+      thunar_notify_progress (device, message);
+      g_free (message);
+      g_free (size_string);
+    }
+  else
+    {
+      thunar_notify_progress (device, message_to_show);
+    }
+}
+
+
+
+/* refuses to remove a device while files are transferred from or to it,
+ * the data would be lost or only partially written */
+static gboolean
+thunar_device_check_busy (ThunarDevice *device,
+                          GError      **error)
+{
+  ThunarApplication *application;
+  GFileInfo         *info;
+  const gchar       *fs_id;
+  gboolean           busy = FALSE;
+  GFile             *root;
+  GList             *lp;
+  gchar             *name;
+
+  root = thunar_device_get_root (device);
+  if (root == NULL)
+    return FALSE;
+
+  info = g_file_query_info (root, G_FILE_ATTRIBUTE_ID_FILESYSTEM, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  g_object_unref (root);
+  if (info == NULL)
+    return FALSE;
+
+  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+
+  application = thunar_application_get ();
+  for (lp = thunar_application_get_jobs (application); lp != NULL && !busy; lp = lp->next)
+    if (THUNAR_IS_TRANSFER_JOB (lp->data)
+        && !exo_job_is_cancelled (EXO_JOB (lp->data))
+        && thunar_transfer_job_uses_device (lp->data, fs_id))
+      busy = TRUE;
+  g_object_unref (application);
+  g_object_unref (info);
+
+  if (busy)
+    {
+      name = thunar_device_get_name (device);
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_BUSY,
+                   _("Files are still being transferred from or to \"%s\". "
+                     "Wait until the transfer finished or cancel it first."),
+                   name);
+      g_free (name);
+    }
+
+  return busy;
 }
 
 
@@ -328,17 +402,65 @@ thunar_device_emit_pre_unmount (ThunarDevice *device,
 
 
 
+/**
+ * thunar_device_invalidate:
+ * @device : a #ThunarDevice.
+ *
+ * Drops the name and icon remembered for @device, so they are determined
+ * again the next time they are requested. This is called by the
+ * #ThunarDeviceMonitor whenever the underlying volume or mount changed.
+ **/
+void
+thunar_device_invalidate (ThunarDevice *device)
+{
+  _thunar_return_if_fail (THUNAR_IS_DEVICE (device));
+
+  g_free (device->name);
+  device->name = NULL;
+
+  if (device->icon != NULL)
+    {
+      g_object_unref (device->icon);
+      device->icon = NULL;
+    }
+}
+
+
+
 gchar *
 thunar_device_get_name (const ThunarDevice *device)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_DEVICE (device), NULL);
+  return g_strdup (thunar_device_peek_name (device));
+}
+
+
+
+/**
+ * thunar_device_peek_name:
+ * @device : a #ThunarDevice.
+ *
+ * Returns the display name of @device, like thunar_device_get_name(),
+ * without allocating a copy. The name is determined once and remembered
+ * until the #ThunarDeviceMonitor invalidates @device, so it can be used
+ * on every redraw of the side pane.
+ *
+ * Return value: the display name of @device, owned by @device.
+ **/
+const gchar *
+thunar_device_peek_name (const ThunarDevice *device)
 {
   GFile *mount_point;
   gchar *display_name = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_DEVICE (device), NULL);
 
+  if (G_LIKELY (device->name != NULL))
+    return device->name;
+
   if (G_IS_VOLUME (device->device))
     {
-      return g_volume_get_name (device->device);
+      display_name = g_volume_get_name (device->device);
     }
   else if (G_IS_MOUNT (device->device))
     {
@@ -352,13 +474,17 @@ thunar_device_get_name (const ThunarDevice *device)
 
       if (display_name == NULL)
         display_name = g_mount_get_name (device->device);
-
-      return display_name;
     }
   else
     _thunar_assert_not_reached ();
 
-  return NULL;
+  /* the name is never NULL, so it is not determined again */
+  if (G_UNLIKELY (display_name == NULL))
+    display_name = g_strdup ("");
+
+  ((ThunarDevice *) device)->name = display_name;
+
+  return display_name;
 }
 
 
@@ -366,16 +492,24 @@ thunar_device_get_name (const ThunarDevice *device)
 GIcon *
 thunar_device_get_icon (const ThunarDevice *device)
 {
+  GIcon *icon = NULL;
+
   _thunar_return_val_if_fail (THUNAR_IS_DEVICE (device), NULL);
 
+  if (G_LIKELY (device->icon != NULL))
+    return g_object_ref (device->icon);
+
   if (G_IS_VOLUME (device->device))
-    return g_volume_get_icon (device->device);
+    icon = g_volume_get_icon (device->device);
   else if (G_IS_MOUNT (device->device))
-   return g_mount_get_icon (device->device);
+    icon = g_mount_get_icon (device->device);
   else
     _thunar_assert_not_reached ();
 
-  return NULL;
+  if (icon != NULL)
+    ((ThunarDevice *) device)->icon = g_object_ref (icon);
+
+  return icon;
 }
 
 
@@ -723,12 +857,21 @@ thunar_device_unmount (ThunarDevice         *device,
 {
   ThunarDeviceOperation *op;
   GMount                *mount;
+  GError                *error = NULL;
 
   _thunar_return_if_fail (THUNAR_IS_DEVICE (device));
   _thunar_return_if_fail (G_IS_MOUNT_OPERATION (mount_operation));
   _thunar_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
   _thunar_return_if_fail (callback != NULL);
 
+  /* don't remove the device under a running transfer */
+  if (thunar_device_check_busy (device, &error))
+    {
+      (callback) (device, error, user_data);
+      g_error_free (error);
+      return;
+    }
+
   /* get the mount from the volume or use existing mount */
   if (G_IS_VOLUME (device->device))
     mount = g_volume_get_mount (device->device);
@@ -779,12 +922,21 @@ thunar_device_eject (ThunarDevice         *device,
   GMount                *mount = NULL;
   GVolume               *volume;
   GDrive                *drive;
+  GError                *error = NULL;
 
   _thunar_return_if_fail (THUNAR_IS_DEVICE (device));
   _thunar_return_if_fail (G_IS_MOUNT_OPERATION (mount_operation));
   _thunar_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
   _thunar_return_if_fail (callback != NULL);
 
+  /* don't remove the device under a running transfer */
+  if (thunar_device_check_busy (device, &error))
+    {
+      (callback) (device, error, user_data);
+      g_error_free (error);
+      return;
+    }
+
   if (G_IS_VOLUME (device->device))
     {
       volume = device->device;
@@ -48,10 +48,14 @@ enum _ThunarDeviceKind
 
 GType                thunar_device_get_type         (void) G_GNUC_CONST;
 
+void                 thunar_device_invalidate       (ThunarDevice         *device);
+
 const gchar         *thunar_device_get_eject_label  (const ThunarDevice   *device);
 
 gchar               *thunar_device_get_name         (const ThunarDevice   *device) G_GNUC_MALLOC;
 
+const gchar         *thunar_device_peek_name        (const ThunarDevice   *device);
+
 GIcon               *thunar_device_get_icon         (const ThunarDevice   *device);
 
 ThunarDeviceKind     thunar_device_get_kind         (const ThunarDevice   *device) G_GNUC_PURE;
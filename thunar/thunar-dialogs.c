@@ -595,6 +595,10 @@ thunar_dialogs_show_job_ask (GtkWindow        *parent,
           mnemonic = _("Replace _All");
           break;
 
+        case THUNAR_JOB_RESPONSE_UPDATE_ALL:
+          mnemonic = _("_Update All");
+          break;
+
         case THUNAR_JOB_RESPONSE_SKIP:
           mnemonic = _("_Skip");
           break;
@@ -627,6 +631,10 @@ thunar_dialogs_show_job_ask (GtkWindow        *parent,
           mnemonic = _("Copy _Anyway");
           break;
 
+        case THUNAR_JOB_RESPONSE_RESUME:
+          mnemonic = _("Res_ume");
+          break;
+
         case THUNAR_JOB_RESPONSE_CANCEL:
           /* cancel is always the last option */
           has_cancel = TRUE;
@@ -716,6 +724,7 @@ thunar_dialogs_show_job_ask_replace (GtkWindow  *parent,
   GtkWidget         *skip_button;
   GtkWidget         *replaceall_button;
   GtkWidget         *replace_button;
+  GtkWidget         *updateall_button;
   GtkWidget         *renameall_button;
   GtkWidget         *rename_button;
   GdkPixbuf         *icon;
@@ -765,6 +774,9 @@ thunar_dialogs_show_job_ask_replace (GtkWindow  *parent,
   skip_button       = gtk_button_new_with_mnemonic (_("_Skip"));
   replaceall_button = gtk_button_new_with_mnemonic (_("Replace _All"));
   replace_button    = gtk_button_new_with_mnemonic (_("_Replace"));
+  updateall_button  = gtk_button_new_with_mnemonic (_("_Update All"));
+
+  gtk_widget_set_tooltip_text (updateall_button, _("Replace only the files which differ in size or modification time"));
   renameall_button  = gtk_button_new_with_mnemonic (_("Rena_me All"));
   rename_button     = gtk_button_new_with_mnemonic (_("Re_name"));
 
@@ -773,6 +785,7 @@ thunar_dialogs_show_job_ask_replace (GtkWindow  *parent,
   g_signal_connect (skip_button,        "clicked", G_CALLBACK (thunar_dialogs_show_job_ask_replace_callback), dialog);
   g_signal_connect (replaceall_button,  "clicked", G_CALLBACK (thunar_dialogs_show_job_ask_replace_callback), dialog);
   g_signal_connect (replace_button,     "clicked", G_CALLBACK (thunar_dialogs_show_job_ask_replace_callback), dialog);
+  g_signal_connect (updateall_button,   "clicked", G_CALLBACK (thunar_dialogs_show_job_ask_replace_callback), dialog);
   g_signal_connect (renameall_button,   "clicked", G_CALLBACK (thunar_dialogs_show_job_ask_replace_callback), dialog);
   g_signal_connect (rename_button,      "clicked", G_CALLBACK (thunar_dialogs_show_job_ask_replace_callback), dialog);
 
@@ -781,6 +794,7 @@ thunar_dialogs_show_job_ask_replace (GtkWindow  *parent,
   g_object_set_data (G_OBJECT (skip_button),       "response-id", GINT_TO_POINTER (THUNAR_JOB_RESPONSE_SKIP));
   g_object_set_data (G_OBJECT (replaceall_button), "response-id", GINT_TO_POINTER (THUNAR_JOB_RESPONSE_REPLACE_ALL));
   g_object_set_data (G_OBJECT (replace_button),    "response-id", GINT_TO_POINTER (THUNAR_JOB_RESPONSE_REPLACE));
+  g_object_set_data (G_OBJECT (updateall_button),  "response-id", GINT_TO_POINTER (THUNAR_JOB_RESPONSE_UPDATE_ALL));
   g_object_set_data (G_OBJECT (renameall_button),  "response-id", GINT_TO_POINTER (THUNAR_JOB_RESPONSE_RENAME_ALL));
   g_object_set_data (G_OBJECT (rename_button),     "response-id", GINT_TO_POINTER (THUNAR_JOB_RESPONSE_RENAME));
 
@@ -789,6 +803,7 @@ thunar_dialogs_show_job_ask_replace (GtkWindow  *parent,
   gtk_container_add (GTK_CONTAINER (button_box), skip_button);
   gtk_container_add (GTK_CONTAINER (button_box), replaceall_button);
   gtk_container_add (GTK_CONTAINER (button_box), replace_button);
+  gtk_container_add (GTK_CONTAINER (button_box), updateall_button);
   gtk_container_add (GTK_CONTAINER (button_box), renameall_button);
   gtk_container_add (GTK_CONTAINER (button_box), rename_button);
   gtk_container_add (GTK_CONTAINER (content_area), button_box);
@@ -33,7 +33,6 @@ static void                thunar_icon_size_from_zoom_level     (const GValue
 static void                thunar_thumbnail_size_from_icon_size (const GValue   *src_value,
                                                                  GValue         *dst_value);
 static ThunarIconSize      thunar_zoom_level_to_icon_size       (ThunarZoomLevel zoom_level);
-static ThunarThumbnailSize thunar_icon_size_to_thumbnail_size   (ThunarIconSize  icon_size);
 
 
 
@@ -276,10 +275,11 @@ thunar_zoom_level_get_type (void)
 
 
 ThunarThumbnailSize
-thunar_zoom_level_to_thumbnail_size (ThunarZoomLevel zoom_level)
+thunar_zoom_level_to_thumbnail_size (ThunarZoomLevel zoom_level,
+                                     gint            scale_factor)
 {
   ThunarIconSize icon_size = thunar_zoom_level_to_icon_size (zoom_level);
-  return thunar_icon_size_to_thumbnail_size (icon_size);
+  return thunar_icon_size_to_thumbnail_size (icon_size, scale_factor);
 }
 
 
@@ -296,6 +296,7 @@ thunar_thumbnail_mode_get_type (void)
         { THUNAR_THUMBNAIL_MODE_NEVER,      "THUNAR_THUMBNAIL_MODE_NEVER",      "never",      },
         { THUNAR_THUMBNAIL_MODE_ONLY_LOCAL, "THUNAR_THUMBNAIL_MODE_ONLY_LOCAL", "only-local", },
         { THUNAR_THUMBNAIL_MODE_ALWAYS,     "THUNAR_THUMBNAIL_MODE_ALWAYS",     "always",     },
+        { THUNAR_THUMBNAIL_MODE_BUDGETED,   "THUNAR_THUMBNAIL_MODE_BUDGETED",   "budgeted",   },
         { 0,                                NULL,                               NULL,         },
       };
 
@@ -316,9 +317,11 @@ thunar_thumbnail_size_get_type (void)
     {
       static const GEnumValue values[] =
       {
-        { THUNAR_THUMBNAIL_SIZE_NORMAL,  "THUNAR_THUMBNAIL_SIZE_NORMAL", "normal", },
-        { THUNAR_THUMBNAIL_SIZE_LARGE,   "THUNAR_THUMBNAIL_SIZE_LARGE",  "large",  },
-        { 0,                             NULL,                           NULL,     },
+        { THUNAR_THUMBNAIL_SIZE_NORMAL,   "THUNAR_THUMBNAIL_SIZE_NORMAL",   "normal",   },
+        { THUNAR_THUMBNAIL_SIZE_LARGE,    "THUNAR_THUMBNAIL_SIZE_LARGE",    "large",    },
+        { THUNAR_THUMBNAIL_SIZE_X_LARGE,  "THUNAR_THUMBNAIL_SIZE_X_LARGE",  "x-large",  },
+        { THUNAR_THUMBNAIL_SIZE_XX_LARGE, "THUNAR_THUMBNAIL_SIZE_XX_LARGE", "xx-large", },
+        { 0,                              NULL,                             NULL,       },
       };
 
       type = g_enum_register_static (I_("ThunarThumbnailSize"), values);
@@ -390,10 +393,28 @@ thunar_zoom_level_to_icon_size (ThunarZoomLevel zoom_level)
 
 
 
-static ThunarThumbnailSize
-thunar_icon_size_to_thumbnail_size (ThunarIconSize icon_size)
+/**
+ * thunar_icon_size_to_thumbnail_size:
+ * @icon_size    : a #ThunarIconSize.
+ * @scale_factor : the scale factor of the widget showing the icons.
+ *
+ * Determines the smallest thumbnail flavor that covers icons of
+ * @icon_size on a display with @scale_factor, so the thumbnails
+ * never have to be scaled up and only a little down.
+ *
+ * Return value: the #ThunarThumbnailSize for @icon_size.
+ **/
+ThunarThumbnailSize
+thunar_icon_size_to_thumbnail_size (ThunarIconSize icon_size,
+                                    gint           scale_factor)
 {
-  if (icon_size > THUNAR_ICON_SIZE_128)
+  gint pixels = icon_size * MAX (scale_factor, 1);
+
+  if (pixels > 512)
+    return THUNAR_THUMBNAIL_SIZE_XX_LARGE;
+  if (pixels > 256)
+    return THUNAR_THUMBNAIL_SIZE_X_LARGE;
+  if (pixels > 128)
     return THUNAR_THUMBNAIL_SIZE_LARGE;
 
   return THUNAR_THUMBNAIL_SIZE_NORMAL;
@@ -414,7 +435,7 @@ static void
 thunar_thumbnail_size_from_icon_size (const GValue *src_value,
                                       GValue       *dst_value)
 {
-  g_value_set_enum (dst_value, thunar_icon_size_to_thumbnail_size (g_value_get_enum (src_value)));
+  g_value_set_enum (dst_value, thunar_icon_size_to_thumbnail_size (g_value_get_enum (src_value), 1));
 }
 
 
@@ -441,6 +462,8 @@ thunar_job_response_get_type (void)
         { THUNAR_JOB_RESPONSE_SKIP_ALL,    "THUNAR_JOB_RESPONSE_SKIP_ALL",    "skip-all"    },
         { THUNAR_JOB_RESPONSE_RENAME,      "THUNAR_JOB_RESPONSE_RENAME",      "rename"      },
         { THUNAR_JOB_RESPONSE_RENAME_ALL,  "THUNAR_JOB_RESPONSE_RENAME_ALL",  "rename-all " },
+        { THUNAR_JOB_RESPONSE_RESUME,      "THUNAR_JOB_RESPONSE_RESUME",      "resume"      },
+        { THUNAR_JOB_RESPONSE_UPDATE_ALL,  "THUNAR_JOB_RESPONSE_UPDATE_ALL",  "update-all"  },
         { 0,                               NULL,                              NULL          }
       };
 
@@ -157,12 +157,15 @@ GType thunar_icon_size_get_type (void) G_GNUC_CONST;
  * @THUNAR_THUMBNAIL_MODE_NEVER      : never show thumbnails.
  * @THUNAR_THUMBNAIL_MODE_ONLY_LOCAL : only show thumbnails on local filesystems.
  * @THUNAR_THUMBNAIL_MODE_ALWAYS     : always show thumbnails (everywhere).
+ * @THUNAR_THUMBNAIL_MODE_BUDGETED   : show thumbnails everywhere, but limit the
+ *                                     data read from remote filesystems.
  **/
 typedef enum
 {
   THUNAR_THUMBNAIL_MODE_NEVER,
   THUNAR_THUMBNAIL_MODE_ONLY_LOCAL,
-  THUNAR_THUMBNAIL_MODE_ALWAYS
+  THUNAR_THUMBNAIL_MODE_ALWAYS,
+  THUNAR_THUMBNAIL_MODE_BUDGETED
 } ThunarThumbnailMode;
 
 GType thunar_thumbnail_mode_get_type (void) G_GNUC_CONST;
@@ -174,11 +177,15 @@ GType thunar_thumbnail_mode_get_type (void) G_GNUC_CONST;
  * ThunarThumbnailSize:
  * @THUNAR_THUMBNAIL_NORMAL      : max 128px x 128px
  * @THUNAR_THUMBNAIL_LARGE       : max 256px x 256px
+ * @THUNAR_THUMBNAIL_X_LARGE     : max 512px x 512px
+ * @THUNAR_THUMBNAIL_XX_LARGE    : max 1024px x 1024px
  **/
 typedef enum
 {
   THUNAR_THUMBNAIL_SIZE_NORMAL,
-  THUNAR_THUMBNAIL_SIZE_LARGE
+  THUNAR_THUMBNAIL_SIZE_LARGE,
+  THUNAR_THUMBNAIL_SIZE_X_LARGE,
+  THUNAR_THUMBNAIL_SIZE_XX_LARGE
 } ThunarThumbnailSize;
 
 GType       thunar_thumbnail_size_get_type (void)                               G_GNUC_CONST;
@@ -250,7 +257,10 @@ typedef enum
 } ThunarZoomLevel;
 
 GType               thunar_zoom_level_get_type            (void)                       G_GNUC_CONST;
-ThunarThumbnailSize thunar_zoom_level_to_thumbnail_size   (ThunarZoomLevel zoom_level) G_GNUC_CONST;
+ThunarThumbnailSize thunar_zoom_level_to_thumbnail_size   (ThunarZoomLevel zoom_level,
+                                                           gint            scale_factor) G_GNUC_CONST;
+ThunarThumbnailSize thunar_icon_size_to_thumbnail_size    (ThunarIconSize  icon_size,
+                                                           gint            scale_factor) G_GNUC_CONST;
 
 
 #define THUNAR_TYPE_JOB_RESPONSE (thunar_job_response_get_type ())
@@ -270,6 +280,9 @@ ThunarThumbnailSize thunar_zoom_level_to_thumbnail_size   (ThunarZoomLevel zoom_
  * @THUNAR_JOB_RESPONSE_SKIP_ALL    :
  * @THUNAR_JOB_RESPONSE_RENAME      :
  * @THUNAR_JOB_RESPONSE_RENAME_ALL  :
+ * @THUNAR_JOB_RESPONSE_RESUME      :
+ * @THUNAR_JOB_RESPONSE_UPDATE_ALL  : replace only the existing files that differ
+ *                                    from the source in size or modification time.
  *
  * Possible responses for the ThunarJob::ask signal.
  **/
@@ -288,8 +301,10 @@ typedef enum /*< flags >*/
   THUNAR_JOB_RESPONSE_SKIP_ALL    = 1 << 10,
   THUNAR_JOB_RESPONSE_RENAME      = 1 << 11,
   THUNAR_JOB_RESPONSE_RENAME_ALL  = 1 << 12,
+  THUNAR_JOB_RESPONSE_RESUME      = 1 << 13,
+  THUNAR_JOB_RESPONSE_UPDATE_ALL  = 1 << 14,
 } ThunarJobResponse;
-#define THUNAR_JOB_RESPONSE_MAX_INT 12
+#define THUNAR_JOB_RESPONSE_MAX_INT 14
 
 GType thunar_job_response_get_type (void) G_GNUC_CONST;
 
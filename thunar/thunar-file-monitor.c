@@ -23,6 +23,14 @@
 
 #include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-util.h>
+
+
+
+/* changes are collected and delivered at most once per frame (60 Hz),
+ * ahead of the redraw of the views */
+#define FILE_MONITOR_CHANGED_INTERVAL (1000 / 60)
+#define FILE_MONITOR_CHANGED_PRIORITY (G_PRIORITY_HIGH_IDLE + 10)
 
 
 
@@ -43,9 +51,35 @@ struct _ThunarFileMonitorClass
 
 struct _ThunarFileMonitor
 {
-  GObject __parent__;
+  GObject     __parent__;
+
+  /* the watches added with thunar_file_monitor_watch(), a queue of
+   * FileMonitorWatch<!---->es for each watched file */
+  GHashTable *watches;
+
+  /* the changed files not delivered yet, in the order they changed */
+  GQueue      changed_queue;
+  GHashTable *changed_files;
+  guint       changed_timer_id;
 };
 
+typedef struct
+{
+  ThunarFileMonitorWatchFlags flags;
+  ThunarFileMonitorFunc       changed_func;
+  ThunarFileMonitorFunc       destroyed_func;
+  gpointer                    user_data;
+
+  /* watches may be removed while they are notified */
+  gint                        ref_count;
+  gboolean                    removed;
+}
+FileMonitorWatch;
+
+
+
+static void thunar_file_monitor_finalize (GObject *object);
+
 
 
 static ThunarFileMonitor *file_monitor_default;
@@ -60,6 +94,11 @@ G_DEFINE_TYPE (ThunarFileMonitor, thunar_file_monitor, G_TYPE_OBJECT)
 static void
 thunar_file_monitor_class_init (ThunarFileMonitorClass *klass)
 {
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_file_monitor_finalize;
+
   /**
    * ThunarFileMonitor::file-changed:
    * @file_monitor : the default #ThunarFileMonitor.
@@ -68,6 +107,12 @@ thunar_file_monitor_class_init (ThunarFileMonitorClass *klass)
    * This signal is emitted on @file_monitor whenever any of the currently
    * existing #ThunarFile instances changes. @file identifies the instance
    * that changed.
+   *
+   * Changes are collected and emitted at most once per file and frame, so
+   * a file changing many times in a row is only reported once.
+   *
+   * Objects only interested in a few files or folders should use
+   * thunar_file_monitor_watch() instead.
    **/
   file_monitor_signals[FILE_CHANGED] =
     g_signal_new (I_("file-changed"),
@@ -101,9 +146,169 @@ thunar_file_monitor_class_init (ThunarFileMonitorClass *klass)
 
 
 
+static void
+thunar_file_monitor_watch_unref (FileMonitorWatch *watch)
+{
+  if (--watch->ref_count == 0)
+    g_slice_free (FileMonitorWatch, watch);
+}
+
+
+
+static void
+thunar_file_monitor_watches_free (gpointer data)
+{
+  GQueue *watches = data;
+  GList  *lp;
+
+  for (lp = watches->head; lp != NULL; lp = lp->next)
+    {
+      ((FileMonitorWatch *) lp->data)->removed = TRUE;
+      thunar_file_monitor_watch_unref (lp->data);
+    }
+  g_queue_free (watches);
+}
+
+
+
 static void
 thunar_file_monitor_init (ThunarFileMonitor *monitor)
 {
+  monitor->watches = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            g_object_unref, thunar_file_monitor_watches_free);
+
+  /* maps the changed files to their links in the queue */
+  g_queue_init (&monitor->changed_queue);
+  monitor->changed_files = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+
+
+static void
+thunar_file_monitor_finalize (GObject *object)
+{
+  ThunarFileMonitor *monitor = THUNAR_FILE_MONITOR (object);
+
+  /* nobody is left to tell about the pending changes */
+  if (monitor->changed_timer_id != 0)
+    g_source_remove (monitor->changed_timer_id);
+  g_hash_table_destroy (monitor->changed_files);
+  g_queue_foreach (&monitor->changed_queue, (GFunc) (void (*)(void)) g_object_unref, NULL);
+  g_queue_clear (&monitor->changed_queue);
+
+  g_hash_table_destroy (monitor->watches);
+
+  (*G_OBJECT_CLASS (thunar_file_monitor_parent_class)->finalize) (object);
+}
+
+
+
+static GList *
+thunar_file_monitor_collect (ThunarFileMonitor           *monitor,
+                             ThunarFile                  *file,
+                             ThunarFileMonitorWatchFlags  flags,
+                             GList                       *watches)
+{
+  FileMonitorWatch *watch;
+  GQueue           *queue;
+  GList            *lp;
+
+  queue = g_hash_table_lookup (monitor->watches, file);
+  if (G_LIKELY (queue == NULL))
+    return watches;
+
+  for (lp = queue->head; lp != NULL; lp = lp->next)
+    {
+      watch = lp->data;
+      if ((watch->flags & flags) != 0)
+        {
+          watch->ref_count++;
+          watches = g_list_prepend (watches, watch);
+        }
+    }
+
+  return watches;
+}
+
+
+
+static void
+thunar_file_monitor_dispatch (ThunarFileMonitor *monitor,
+                              ThunarFile        *file,
+                              gboolean           destroyed)
+{
+  FileMonitorWatch *watch;
+  ThunarFile       *parent_file;
+  GFile            *parent;
+  GList            *watches;
+  GList            *lp;
+
+  if (g_hash_table_size (monitor->watches) == 0)
+    return;
+
+  /* collect the interested watches first, the functions may add or remove watches */
+  watches = thunar_file_monitor_collect (monitor, file, THUNAR_FILE_MONITOR_WATCH_FILE, NULL);
+
+  /* a watched folder is alive, so it is found in the file cache */
+  parent = g_file_get_parent (thunar_file_get_file (file));
+  if (G_LIKELY (parent != NULL))
+    {
+      parent_file = thunar_file_cache_lookup (parent);
+      if (parent_file != NULL)
+        {
+          watches = thunar_file_monitor_collect (monitor, parent_file, THUNAR_FILE_MONITOR_WATCH_CHILDREN, watches);
+          g_object_unref (parent_file);
+        }
+      g_object_unref (parent);
+    }
+
+  /* notify them in the order they were added */
+  watches = g_list_reverse (watches);
+  for (lp = watches; lp != NULL; lp = lp->next)
+    {
+      watch = lp->data;
+      if (G_LIKELY (!watch->removed))
+        {
+          if (destroyed && watch->destroyed_func != NULL)
+            (*watch->destroyed_func) (monitor, file, watch->user_data);
+          else if (!destroyed && watch->changed_func != NULL)
+            (*watch->changed_func) (monitor, file, watch->user_data);
+        }
+      thunar_file_monitor_watch_unref (watch);
+    }
+  g_list_free (watches);
+}
+
+
+
+static gboolean
+thunar_file_monitor_changed_timer (gpointer user_data)
+{
+  ThunarFileMonitor *monitor = THUNAR_FILE_MONITOR (user_data);
+  ThunarFile        *file;
+  GQueue             changed_queue;
+
+  THUNAR_THREADS_ENTER
+
+  /* files changing while we deliver are reported with the next frame */
+  changed_queue = monitor->changed_queue;
+  g_queue_init (&monitor->changed_queue);
+  g_hash_table_remove_all (monitor->changed_files);
+  monitor->changed_timer_id = 0;
+
+  /* keep the monitor alive, a handler might drop the last reference */
+  g_object_ref (G_OBJECT (monitor));
+  while ((file = g_queue_pop_head (&changed_queue)) != NULL)
+    {
+      thunar_file_monitor_dispatch (monitor, file, FALSE);
+      g_signal_emit (G_OBJECT (monitor), file_monitor_signals[FILE_CHANGED], 0, file);
+      g_object_unref (G_OBJECT (file));
+    }
+  g_object_unref (G_OBJECT (monitor));
+
+  THUNAR_THREADS_LEAVE
+
+  return FALSE;
 }
 
 
@@ -144,21 +349,130 @@ thunar_file_monitor_get_default (void)
 
 
 
+/**
+ * thunar_file_monitor_watch:
+ * @file_monitor   : the default #ThunarFileMonitor.
+ * @file           : the #ThunarFile to watch.
+ * @flags          : whether to watch @file, the files in it or both.
+ * @changed_func   : the function to call when a watched file changed or %NULL.
+ * @destroyed_func : the function to call when a watched file is destroyed or %NULL.
+ * @user_data      : data to pass to the functions.
+ *
+ * Calls @changed_func or @destroyed_func whenever @file or a #ThunarFile
+ * in the folder @file changes or is destroyed, depending on @flags. Unlike
+ * the ::file-changed and ::file-destroyed signals, only the watches for
+ * the file and its folder are notified. The watch follows @file when it
+ * is renamed.
+ *
+ * Use thunar_file_monitor_unwatch() to remove the watch again, @file is
+ * kept alive until then.
+ **/
+void
+thunar_file_monitor_watch (ThunarFileMonitor           *file_monitor,
+                           ThunarFile                  *file,
+                           ThunarFileMonitorWatchFlags  flags,
+                           ThunarFileMonitorFunc        changed_func,
+                           ThunarFileMonitorFunc        destroyed_func,
+                           gpointer                     user_data)
+{
+  FileMonitorWatch *watch;
+  GQueue           *watches;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  watch = g_slice_new0 (FileMonitorWatch);
+  watch->flags = flags;
+  watch->changed_func = changed_func;
+  watch->destroyed_func = destroyed_func;
+  watch->user_data = user_data;
+  watch->ref_count = 1;
+
+  watches = g_hash_table_lookup (file_monitor->watches, file);
+  if (watches == NULL)
+    {
+      watches = g_queue_new ();
+      g_hash_table_insert (file_monitor->watches, g_object_ref (file), watches);
+    }
+  g_queue_push_tail (watches, watch);
+}
+
+
+
+/**
+ * thunar_file_monitor_unwatch:
+ * @file_monitor : the default #ThunarFileMonitor.
+ * @file         : the #ThunarFile passed to thunar_file_monitor_watch().
+ * @user_data    : the data passed to thunar_file_monitor_watch().
+ *
+ * Removes the watches for @file added with @user_data.
+ **/
+void
+thunar_file_monitor_unwatch (ThunarFileMonitor *file_monitor,
+                             ThunarFile        *file,
+                             gpointer           user_data)
+{
+  FileMonitorWatch *watch;
+  GQueue           *watches;
+  GList            *lp;
+  GList            *next;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  watches = g_hash_table_lookup (file_monitor->watches, file);
+  if (G_UNLIKELY (watches == NULL))
+    return;
+
+  for (lp = watches->head; lp != NULL; lp = next)
+    {
+      next = lp->next;
+      watch = lp->data;
+      if (watch->user_data == user_data)
+        {
+          g_queue_delete_link (watches, lp);
+          watch->removed = TRUE;
+          thunar_file_monitor_watch_unref (watch);
+        }
+    }
+
+  if (g_queue_is_empty (watches))
+    g_hash_table_remove (file_monitor->watches, file);
+}
+
+
+
 /**
  * thunar_file_monitor_file_changed:
  * @file : a #ThunarFile.
  *
  * Emits the ::file-changed signal on the default
- * #ThunarFileMonitor (if any). This method should
- * only be used by #ThunarFile.
+ * #ThunarFileMonitor (if any) with the next frame,
+ * once no matter how often @file changes until then.
+ * This method should only be used by #ThunarFile.
  **/
 void
 thunar_file_monitor_file_changed (ThunarFile *file)
 {
+  ThunarFileMonitor *monitor = file_monitor_default;
+
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  if (G_LIKELY (file_monitor_default != NULL))
-    g_signal_emit (G_OBJECT (file_monitor_default), file_monitor_signals[FILE_CHANGED], 0, file);
+  if (G_UNLIKELY (monitor == NULL))
+    return;
+
+  /* the file is already reported with the next frame */
+  if (g_hash_table_contains (monitor->changed_files, file))
+    return;
+
+  g_queue_push_tail (&monitor->changed_queue, g_object_ref (G_OBJECT (file)));
+  g_hash_table_insert (monitor->changed_files, file, monitor->changed_queue.tail);
+
+  if (monitor->changed_timer_id == 0)
+    {
+      monitor->changed_timer_id = g_timeout_add_full (FILE_MONITOR_CHANGED_PRIORITY, FILE_MONITOR_CHANGED_INTERVAL,
+                                                      thunar_file_monitor_changed_timer, monitor, NULL);
+    }
 }
 
 
@@ -174,10 +488,24 @@ thunar_file_monitor_file_changed (ThunarFile *file)
 void
 thunar_file_monitor_file_destroyed (ThunarFile *file)
 {
+  GList *link;
+
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   if (G_LIKELY (file_monitor_default != NULL))
-    g_signal_emit (G_OBJECT (file_monitor_default), file_monitor_signals[FILE_DESTROYED], 0, file);
+    {
+      /* a destroyed file needs no pending change anymore */
+      link = g_hash_table_lookup (file_monitor_default->changed_files, file);
+      if (G_UNLIKELY (link != NULL))
+        {
+          g_hash_table_remove (file_monitor_default->changed_files, file);
+          g_queue_delete_link (&file_monitor_default->changed_queue, link);
+          g_object_unref (G_OBJECT (file));
+        }
+
+      thunar_file_monitor_dispatch (file_monitor_default, file, TRUE);
+      g_signal_emit (G_OBJECT (file_monitor_default), file_monitor_signals[FILE_DESTROYED], 0, file);
+    }
 }
 
 
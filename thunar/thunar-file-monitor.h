@@ -34,12 +34,45 @@ typedef struct _ThunarFileMonitor      ThunarFileMonitor;
 #define THUNAR_IS_FILE_MONITOR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_FILE_MONITOR))
 #define THUNAR_FILE_MONITOR_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_FILE_MONITOR, ThunarFileMonitorClass))
 
+/**
+ * ThunarFileMonitorWatchFlags:
+ * @THUNAR_FILE_MONITOR_WATCH_FILE     : report changes of the file itself.
+ * @THUNAR_FILE_MONITOR_WATCH_CHILDREN : report changes of the files in the folder.
+ *
+ * Which files a watch added with thunar_file_monitor_watch() is interested in.
+ **/
+typedef enum
+{
+  THUNAR_FILE_MONITOR_WATCH_FILE     = 1 << 0,
+  THUNAR_FILE_MONITOR_WATCH_CHILDREN = 1 << 1,
+} ThunarFileMonitorWatchFlags;
+
+/**
+ * ThunarFileMonitorFunc:
+ * @file_monitor : the default #ThunarFileMonitor.
+ * @file         : the #ThunarFile that changed or is about to be destroyed.
+ * @user_data    : the data passed to thunar_file_monitor_watch().
+ **/
+typedef void (*ThunarFileMonitorFunc) (ThunarFileMonitor *file_monitor,
+                                       ThunarFile        *file,
+                                       gpointer           user_data);
+
 GType              thunar_file_monitor_get_type       (void) G_GNUC_CONST;
 
 ThunarFileMonitor *thunar_file_monitor_get_default    (void);
 
-void               thunar_file_monitor_file_changed   (ThunarFile *file);
-void               thunar_file_monitor_file_destroyed (ThunarFile *file);
+void               thunar_file_monitor_watch          (ThunarFileMonitor           *file_monitor,
+                                                       ThunarFile                  *file,
+                                                       ThunarFileMonitorWatchFlags  flags,
+                                                       ThunarFileMonitorFunc        changed_func,
+                                                       ThunarFileMonitorFunc        destroyed_func,
+                                                       gpointer                     user_data);
+void               thunar_file_monitor_unwatch        (ThunarFileMonitor           *file_monitor,
+                                                       ThunarFile                  *file,
+                                                       gpointer                     user_data);
+
+void               thunar_file_monitor_file_changed   (ThunarFile                  *file);
+void               thunar_file_monitor_file_destroyed (ThunarFile                  *file);
 
 G_END_DECLS;
 
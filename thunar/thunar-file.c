@@ -55,16 +55,26 @@
 
 #include <thunarx/thunarx.h>
 
+#include <thunar/thunar-app-index.h>
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-chooser-dialog.h>
+#include <thunar/thunar-counters.h>
+#include <thunar/thunar-desktop-entry-cache.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
+#include <thunar/thunar-monitor-pool.h>
+#include <thunar/thunar-mount-health.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-scheduler.h>
+#include <thunar/thunar-state-writer.h>
+#include <thunar/thunar-thumbnail-index.h>
+#include <thunar/thunar-trash-count.h>
 #include <thunar/thunar-user.h>
 #include <thunar/thunar-util.h>
+#include <thunar/thunar-watchdog.h>
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-icon-factory.h>
 
@@ -98,7 +108,14 @@ static gboolean           thunar_file_info_is_directory        (ThunarxFileInfo
 static GFileInfo         *thunar_file_info_get_file_info       (ThunarxFileInfo        *file_info);
 static GFileInfo         *thunar_file_info_get_filesystem_info (ThunarxFileInfo        *file_info);
 static GFile             *thunar_file_info_get_location        (ThunarxFileInfo        *file_info);
+static const gchar       *thunar_file_info_peek_name           (ThunarxFileInfo        *file_info);
+static const gchar       *thunar_file_info_peek_mime_type      (ThunarxFileInfo        *file_info);
+static GFileInfo         *thunar_file_info_peek_file_info      (ThunarxFileInfo        *file_info);
+static GFile             *thunar_file_info_peek_location       (ThunarxFileInfo        *file_info);
+static void               thunar_file_info_prepare             (ThunarxFileInfo        *file_info,
+                                                                GCancellable           *cancellable);
 static void               thunar_file_info_changed             (ThunarxFileInfo        *file_info);
+static void               thunar_file_info_update_free         (gpointer                user_data);
 static gboolean           thunar_file_denies_access_permission (const ThunarFile       *file,
                                                                 ThunarFileMode          usr_permissions,
                                                                 ThunarFileMode          grp_permissions,
@@ -108,27 +125,55 @@ static void               thunar_file_monitor                  (GFileMonitor
                                                                 GFile                  *other_path,
                                                                 GFileMonitorEvent       event_type,
                                                                 gpointer                user_data);
+static void               thunar_file_monitor_event            (ThunarFile             *file,
+                                                                GFile                  *event_path,
+                                                                GFile                  *other_path,
+                                                                GFileMonitorEvent       event_type);
+static void               thunar_file_watch_parent_changed     (GFile                  *event_path,
+                                                                GFile                  *other_path,
+                                                                GFileMonitorEvent       event_type,
+                                                                gpointer                user_data);
 static void               thunar_file_watch_reconnect          (ThunarFile             *file);
 static gboolean           thunar_file_load                     (ThunarFile             *file,
                                                                 GCancellable           *cancellable,
                                                                 GError                **error);
+static void               thunar_file_load_info                (ThunarFile             *file,
+                                                                GFileInfo              *info);
+static void               thunar_file_ensure_deferred_info     (const ThunarFile       *file);
+static void               thunar_file_emblems_clear            (ThunarFile             *file);
 static gboolean           thunar_file_is_readable              (const ThunarFile       *file);
-static gboolean           thunar_file_same_filesystem          (const ThunarFile       *file_a,
-                                                                const ThunarFile       *file_b);
+static gboolean           thunar_file_name_is_ascii            (const gchar            *name,
+                                                                gsize                   length,
+                                                                gboolean               *has_upper);
+static void               thunar_file_custom_icon_written      (const gchar            *path,
+                                                                const GError           *error,
+                                                                gpointer                user_data);
 
 
 
-G_LOCK_DEFINE_STATIC (file_cache_mutex);
 G_LOCK_DEFINE_STATIC (file_content_type_mutex);
 G_LOCK_DEFINE_STATIC (file_rename_mutex);
 
 
 
-static ThunarUserManager *user_manager;
-static GHashTable        *file_cache;
-static guint32            effective_user_id;
-static GQuark             thunar_file_watch_quark;
-static guint              file_signals[LAST_SIGNAL];
+static ThunarUserManager    *user_manager;
+static ThunarFileCacheShard  file_cache[THUNAR_FILE_CACHE_N_SHARDS];
+static guint32               effective_user_id;
+static GQuark                thunar_file_watch_quark;
+static guint                 file_signals[LAST_SIGNAL];
+
+/* the interned folder icon names, see thunar_file_get_icon_name_for_state() */
+static const gchar          *icon_name_folder;
+static const gchar          *icon_name_inode_directory;
+
+/* the loads of thunar_file_get_async(), only used on the main thread */
+static GHashTable           *file_get_requests = NULL;
+static GList                *file_get_scheduled = NULL;
+static guint                 file_get_idle_id = 0;
+
+/* maps the GFile of a folder to its ThunarFileParentWatch, only used on
+ * the main thread */
+static GHashTable           *file_parent_watches = NULL;
 
 
 
@@ -137,9 +182,24 @@ static guint              file_signals[LAST_SIGNAL];
 #define FLAG_SET(file,flag)                  G_STMT_START{ ((file)->flags |= (flag)); }G_STMT_END
 #define FLAG_UNSET(file,flag)                G_STMT_START{ ((file)->flags &= ~(flag)); }G_STMT_END
 #define FLAG_IS_SET(file,flag)               (((file)->flags & (flag)) != 0)
+#define FLAG_SET_THUMB_SIZE(file,size)       G_STMT_START{ (file)->flags = ((file)->flags & ~THUNAR_FILE_FLAG_THUMB_SIZE) | ((size) << 8); }G_STMT_END
+#define FLAG_GET_THUMB_SIZE(file)            (((file)->flags & THUNAR_FILE_FLAG_THUMB_SIZE) >> 8)
 
 #define DEFAULT_CONTENT_TYPE "application/octet-stream"
 
+/* the file cache is split by the hash of the GFile, so threads looking
+ * up different files rarely wait for each other */
+#define THUNAR_FILE_CACHE_N_SHARDS (16)
+
+/* the metadata attributes of the settings of thunar_file_get_metadata_setting() */
+#define THUNAR_FILE_METADATA_SETTING_PREFIX "metadata::thunar-"
+#define THUNAR_FILE_METADATA_SETTING_MAX    (64)
+
+/* loads of this many siblings are answered by enumerating their folder,
+ * reading at most THUNAR_FILE_GET_BATCH_MAX_READ entries of it */
+#define THUNAR_FILE_GET_BATCH_MIN      (8)
+#define THUNAR_FILE_GET_BATCH_MAX_READ (2000)
+
 
 
 typedef enum
@@ -147,6 +207,12 @@ typedef enum
   THUNAR_FILE_FLAG_THUMB_MASK     = 0x03,   /* storage for ThunarFileThumbState */
   THUNAR_FILE_FLAG_IN_DESTRUCTION = 1 << 2, /* for avoiding recursion during destroy */
   THUNAR_FILE_FLAG_IS_MOUNTED     = 1 << 3, /* whether this file is mounted */
+  THUNAR_FILE_FLAG_IS_SNAPSHOT    = 1 << 4, /* info was restored from a folder snapshot */
+  THUNAR_FILE_FLAG_DEFERRED_INFO  = 1 << 5, /* info lacks THUNAR_FILE_INFO_NAMESPACE_DEFERRED */
+  THUNAR_FILE_FLAG_THUMB_FOUND    = 1 << 6, /* the thumbnail location below is known */
+  THUNAR_FILE_FLAG_THUMB_LEGACY   = 1 << 7, /* the thumbnail is in ~/.thumbnails */
+  THUNAR_FILE_FLAG_THUMB_SIZE     = 0x300,  /* storage for the ThunarThumbnailSize of the thumbnail */
+  THUNAR_FILE_FLAG_EMBLEMS        = 1 << 10, /* the emblem names below are up to date */
 }
 ThunarFileFlags;
 
@@ -166,41 +232,114 @@ struct _ThunarFile
   GFileInfo            *info;
   GFileType             kind;
   GFile                *gfile;
-  gchar                *content_type;
-  gchar                *icon_name;
+
+  /* interned strings, shared by all files */
+  const gchar          *content_type;
+  const gchar          *icon_name;
 
   gchar                *custom_icon_name;
-  gchar                *display_name;
+  gchar                *display_name; /* may point to basename */
   gchar                *basename;
   const gchar          *device_type;
-  gchar                *thumbnail_path;
 
   /* sorting */
   gchar                *collate_key;
   gchar                *collate_key_nocase;
 
+  /* type-ahead find, may point to display_name */
+  gchar                *casefold_name;
+
   /* flags for thumbnail state etc */
   ThunarFileFlags       flags;
 
   /* tells whether the file watch is not set */
   gboolean              no_file_watch;
+
+  /* the emblems drawn for the file, the names are interned or
+   * owned by the info, see thunar_file_peek_emblem_names() */
+  GList                *emblem_names;
+
+  /* metadata settings which were changed since they were last
+   * written back, see thunar_file_set_metadata_setting() */
+  GFileInfo            *metadata_changes;
 };
 
+/* a folder with watched files, whose monitor is shared by all of them */
+typedef struct
+{
+  ThunarMonitorSubscription *subscription;
+  GFile                     *gfile;
+
+  /* maps the GFile of a watched child to its ThunarFile */
+  GHashTable                *children;
+}
+ThunarFileParentWatch;
+
 typedef struct
 {
-  GFileMonitor  *monitor;
-  guint          watch_count;
+  /* the watch of the parent folder and the location the file is
+   * watched at, or a monitor of its own if the parent cannot be
+   * watched */
+  ThunarFileParentWatch *parent_watch;
+  GFile                 *gfile;
+  GFileMonitor          *monitor;
+  guint                  watch_count;
 }
 ThunarFileWatch;
 
 typedef struct
 {
-  ThunarFileGetFunc  func;
-  gpointer           user_data;
-  GCancellable      *cancellable;
+  ThunarFile *file;
+  GFileInfo  *info;
+  gboolean    deferred;
+}
+ThunarFileInfoUpdate;
+
+typedef struct
+{
+  GMutex      mutex;
+  GHashTable *files;
+
+  /* statistics, only changed while the mutex is held */
+  guint64     n_locks;
+  guint64     n_contended;
+  guint64     n_lookups;
+  guint64     n_hits;
+}
+ThunarFileCacheShard;
+
+typedef struct _ThunarFileGetRequest ThunarFileGetRequest;
+
+typedef struct
+{
+  ThunarFileGetFunc     func;
+  gpointer              user_data;
+  GCancellable         *cancellable;
+  gulong                cancelled_id;
+  ThunarFileGetRequest *request;
 }
 ThunarFileGetData;
 
+/* a load of a location, shared by all thunar_file_get_async() callers */
+struct _ThunarFileGetRequest
+{
+  GFile        *location;
+  GList        *waiters;     /* ThunarFileGetData, oldest first */
+  guint         n_cancelled;
+
+  /* cancelled once all waiters are */
+  GCancellable *cancellable;
+};
+
+typedef struct
+{
+  GFile           *parent;
+  GHashTable      *requests; /* basename -> ThunarFileGetRequest */
+  GFileEnumerator *enumerator;
+  guint            n_read;
+}
+ThunarFileGetBatch;
+
 static struct
 {
   GUserDirectory  type;
@@ -241,6 +380,92 @@ weak_ref_free (GWeakRef *ref)
 }
 
 
+
+static ThunarFileCacheShard *
+thunar_file_cache_lock (const GFile *gfile)
+{
+  static gsize          initialized = 0;
+  ThunarFileCacheShard *shard;
+  guint                 n;
+
+  /* allocate the ThunarFile cache on-demand */
+  if (g_once_init_enter (&initialized))
+    {
+      for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+        {
+          g_mutex_init (&file_cache[n].mutex);
+          file_cache[n].files = g_hash_table_new_full (g_file_hash,
+                                                       (GEqualFunc) g_file_equal,
+                                                       (GDestroyNotify) g_object_unref,
+                                                       (GDestroyNotify) weak_ref_free);
+        }
+      g_once_init_leave (&initialized, 1);
+    }
+
+  shard = &file_cache[g_file_hash (gfile) % THUNAR_FILE_CACHE_N_SHARDS];
+
+  /* count how often other threads got in the way */
+  if (!g_mutex_trylock (&shard->mutex))
+    {
+      g_mutex_lock (&shard->mutex);
+      shard->n_contended++;
+    }
+  shard->n_locks++;
+
+  return shard;
+}
+
+
+
+static void
+thunar_file_cache_unlock (ThunarFileCacheShard *shard)
+{
+  g_mutex_unlock (&shard->mutex);
+}
+
+
+
+static void
+thunar_file_cache_insert (ThunarFile *file)
+{
+  ThunarFileCacheShard *shard;
+
+  shard = thunar_file_cache_lock (file->gfile);
+  g_hash_table_insert (shard->files,
+                       g_object_ref (file->gfile),
+                       weak_ref_new (G_OBJECT (file)));
+  thunar_file_cache_unlock (shard);
+}
+
+
+
+static void
+thunar_file_cache_remove (GFile *gfile)
+{
+  ThunarFileCacheShard *shard;
+
+  shard = thunar_file_cache_lock (gfile);
+  g_hash_table_remove (shard->files, gfile);
+  thunar_file_cache_unlock (shard);
+}
+
+
+
+#if DUMP_FILE_CACHE || (defined (G_ENABLE_DEBUG) && defined (HAVE_ATEXIT))
+static void
+thunar_file_cache_foreach (GHFunc   func,
+                           gpointer user_data)
+{
+  guint n;
+
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    if (file_cache[n].files != NULL)
+      g_hash_table_foreach (file_cache[n].files, func, user_data);
+}
+#endif
+
+
+
 #ifdef G_ENABLE_DEBUG
 #ifdef HAVE_ATEXIT
 static gboolean thunar_file_atexit_registered = FALSE;
@@ -266,22 +491,18 @@ thunar_file_atexit_foreach (gpointer key,
 static void
 thunar_file_atexit (void)
 {
-  G_LOCK (file_cache_mutex);
+  guint n_files;
 
-  if (file_cache == NULL || g_hash_table_size (file_cache) == 0)
-    {
-      G_UNLOCK (file_cache_mutex);
-      return;
-    }
+  /* no other threads are running at exit */
+  thunar_file_cache_get_stats (&n_files, NULL, NULL);
+  if (n_files == 0)
+    return;
 
-  g_print ("--- Leaked a total of %u ThunarFile objects:\n",
-           g_hash_table_size (file_cache));
+  g_print ("--- Leaked a total of %u ThunarFile objects:\n", n_files);
 
-  g_hash_table_foreach (file_cache, thunar_file_atexit_foreach, NULL);
+  thunar_file_cache_foreach (thunar_file_atexit_foreach, NULL);
 
   g_print ("\n");
-
-  G_UNLOCK (file_cache_mutex);
 }
 #endif
 #endif
@@ -306,19 +527,18 @@ thunar_file_cache_dump_foreach (gpointer gfile,
 static gboolean
 thunar_file_cache_dump (gpointer user_data)
 {
-  G_LOCK (file_cache_mutex);
+  guint64 n_locks;
+  guint64 n_contended;
+  guint   n_files;
 
-  if (file_cache != NULL)
-    {
-      g_print ("--- %d ThunarFile objects in cache:\n",
-               g_hash_table_size (file_cache));
-
-      g_hash_table_foreach (file_cache, thunar_file_cache_dump_foreach, NULL);
+  /* only used for debugging from the main loop, so the shards are not locked */
+  thunar_file_cache_get_stats (&n_files, &n_locks, &n_contended);
+  g_print ("--- %u ThunarFile objects in cache (%" G_GUINT64_FORMAT " locks, %"
+           G_GUINT64_FORMAT " contended):\n", n_files, n_locks, n_contended);
 
-      g_print ("\n");
-    }
+  thunar_file_cache_foreach (thunar_file_cache_dump_foreach, NULL);
 
-  G_UNLOCK (file_cache_mutex);
+  g_print ("\n");
 
   return TRUE;
 }
@@ -347,6 +567,8 @@ thunar_file_class_init (ThunarFileClass *klass)
 
   /* pre-allocate the required quarks */
   thunar_file_watch_quark = g_quark_from_static_string ("thunar-file-watch");
+  icon_name_folder = g_intern_static_string ("folder");
+  icon_name_inode_directory = g_intern_static_string ("inode-directory");
 
   /* grab a reference on the user manager */
   user_manager = thunar_user_manager_get_default ();
@@ -397,6 +619,11 @@ thunar_file_info_init (ThunarxFileInfoIface *iface)
   iface->get_file_info = thunar_file_info_get_file_info;
   iface->get_filesystem_info = thunar_file_info_get_filesystem_info;
   iface->get_location = thunar_file_info_get_location;
+  iface->peek_name = thunar_file_info_peek_name;
+  iface->peek_mime_type = thunar_file_info_peek_mime_type;
+  iface->peek_file_info = thunar_file_info_peek_file_info;
+  iface->peek_location = thunar_file_info_peek_location;
+  iface->prepare = thunar_file_info_prepare;
   iface->changed = thunar_file_info_changed;
 }
 
@@ -437,23 +664,23 @@ thunar_file_finalize (GObject *object)
 #endif
 
   /* drop the entry from the cache */
-  G_LOCK (file_cache_mutex);
-  g_hash_table_remove (file_cache, file->gfile);
-  G_UNLOCK (file_cache_mutex);
+  thunar_file_cache_remove (file->gfile);
 
   /* release file info */
   if (file->info != NULL)
     g_object_unref (file->info);
 
+  /* free the emblem names */
+  g_list_free (file->emblem_names);
+
   /* free the custom icon name */
   g_free (file->custom_icon_name);
 
-  /* content type info */
-  g_free (file->content_type);
-  g_free (file->icon_name);
-
   /* free display name and basename */
-  g_free (file->display_name);
+  if (file->casefold_name != file->display_name)
+    g_free (file->casefold_name);
+  if (file->display_name != file->basename)
+    g_free (file->display_name);
   g_free (file->basename);
 
   /* free collate keys */
@@ -461,9 +688,6 @@ thunar_file_finalize (GObject *object)
     g_free (file->collate_key_nocase);
   g_free (file->collate_key);
 
-  /* free the thumbnail path */
-  g_free (file->thumbnail_path);
-
   /* release file */
   g_object_unref (file->gfile);
 
@@ -547,6 +771,9 @@ thunar_file_info_get_file_info (ThunarxFileInfo *file_info)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_info), NULL);
 
+  /* extensions expect the complete information */
+  thunar_file_ensure_deferred_info (THUNAR_FILE (file_info));
+
   if (THUNAR_FILE (file_info)->info != NULL)
     return g_object_ref (THUNAR_FILE (file_info)->info);
   else
@@ -560,9 +787,9 @@ thunar_file_info_get_filesystem_info (ThunarxFileInfo *file_info)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_info), NULL);
 
-  return g_file_query_filesystem_info (THUNAR_FILE (file_info)->gfile,
-                                       THUNARX_FILESYSTEM_INFO_NAMESPACE,
-                                       NULL, NULL);
+  return thunar_mount_health_query_filesystem_info (THUNAR_FILE (file_info)->gfile,
+                                                    THUNARX_FILESYSTEM_INFO_NAMESPACE,
+                                                    NULL, NULL);
 }
 
 
@@ -576,6 +803,88 @@ thunar_file_info_get_location (ThunarxFileInfo *file_info)
 
 
 
+static const gchar *
+thunar_file_info_peek_name (ThunarxFileInfo *file_info)
+{
+  return thunar_file_get_basename (THUNAR_FILE (file_info));
+}
+
+
+
+static const gchar *
+thunar_file_info_peek_mime_type (ThunarxFileInfo *file_info)
+{
+  return thunar_file_get_content_type (THUNAR_FILE (file_info));
+}
+
+
+
+static GFileInfo *
+thunar_file_info_peek_file_info (ThunarxFileInfo *file_info)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file_info), NULL);
+
+  /* extensions expect the complete information */
+  thunar_file_ensure_deferred_info (THUNAR_FILE (file_info));
+
+  return THUNAR_FILE (file_info)->info;
+}
+
+
+
+static GFile *
+thunar_file_info_peek_location (ThunarxFileInfo *file_info)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file_info), NULL);
+  return THUNAR_FILE (file_info)->gfile;
+}
+
+
+
+static gboolean
+thunar_file_info_prepare_idle (gpointer user_data)
+{
+  ThunarFileInfoUpdate *update = user_data;
+
+  thunar_file_set_deferred_info (update->file, update->info);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_file_info_prepare (ThunarxFileInfo *file_info,
+                          GCancellable    *cancellable)
+{
+  ThunarFileInfoUpdate *update;
+  ThunarFile           *file = THUNAR_FILE (file_info);
+  GFileInfo            *info;
+
+  /* the content type is loaded under its own lock */
+  thunar_file_load_content_type (file);
+
+  if (!FLAG_IS_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO) || file->info == NULL)
+    return;
+
+  /* query the deferred attributes here, but merge them in the main loop;
+   * the high priority makes sure this happens before the caller of
+   * thunarx_file_info_list_prepare_async() gets its result */
+  info = g_file_query_info (file->gfile, THUNAR_FILE_INFO_NAMESPACE_DEFERRED,
+                            G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+  if (G_LIKELY (info != NULL))
+    {
+      update = g_slice_new (ThunarFileInfoUpdate);
+      update->file = g_object_ref (file);
+      update->info = info;
+      update->deferred = TRUE;
+      g_idle_add_full (G_PRIORITY_HIGH, thunar_file_info_prepare_idle,
+                       update, thunar_file_info_update_free);
+    }
+}
+
+
+
 static void
 thunar_file_info_changed (ThunarxFileInfo *file_info)
 {
@@ -587,6 +896,9 @@ thunar_file_info_changed (ThunarxFileInfo *file_info)
    * changed once */
   FLAG_SET_THUMB_STATE (file, THUNAR_FILE_THUMB_STATE_UNKNOWN);
 
+  /* the emblems depend on the metadata and the permissions */
+  thunar_file_emblems_clear (file);
+
   /* tell the file monitor that this file changed */
   thunar_file_monitor_file_changed (file);
 }
@@ -720,7 +1032,8 @@ thunar_file_move_thumbnail_cache_file (GFile *old_file,
 
 static void
 thunar_file_monitor_moved (ThunarFile *file,
-                           GFile      *renamed_file)
+                           GFile      *renamed_file,
+                           GFileInfo  *info)
 {
   GFile *previous_file;
 
@@ -733,26 +1046,23 @@ thunar_file_monitor_moved (ThunarFile *file,
   /* set the new file */
   file->gfile = G_FILE (g_object_ref (G_OBJECT (renamed_file)));
 
-  /* reload file information */
-  thunar_file_load (file, NULL, NULL);
+  /* reload file information, unless the caller already has it */
+  if (info != NULL)
+    thunar_file_load_info (file, info);
+  else
+    thunar_file_load (file, NULL, NULL);
 
   /* need to re-register the monitor handle for the new uri */
   thunar_file_watch_reconnect (file);
 
-  G_LOCK (file_cache_mutex);
-
   /* drop the previous entry from the cache */
-  g_hash_table_remove (file_cache, previous_file);
+  thunar_file_cache_remove (previous_file);
 
   /* drop the reference on the previous file */
   g_object_unref (previous_file);
 
   /* insert the new entry */
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-
-  G_UNLOCK (file_cache_mutex);
+  thunar_file_cache_insert (file);
 }
 
 
@@ -790,11 +1100,22 @@ thunar_file_monitor (GFileMonitor     *monitor,
                      GFileMonitorEvent event_type,
                      gpointer          user_data)
 {
-  ThunarFile *file = THUNAR_FILE (user_data);
+  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
+
+  thunar_file_monitor_event (THUNAR_FILE (user_data), event_path, other_path, event_type);
+}
+
+
+
+static void
+thunar_file_monitor_event (ThunarFile       *file,
+                           GFile            *event_path,
+                           GFile            *other_path,
+                           GFileMonitorEvent event_type)
+{
   ThunarFile *other_file;
   gboolean    reload_ok = TRUE;
 
-  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
   _thunar_return_if_fail (G_IS_FILE (event_path));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
@@ -806,7 +1127,7 @@ thunar_file_monitor (GFileMonitor     *monitor,
           event_type == G_FILE_MONITOR_EVENT_MOVED_OUT)
         {
           G_LOCK (file_rename_mutex);
-          thunar_file_monitor_moved (file, other_path);
+          thunar_file_monitor_moved (file, other_path, NULL);
           G_UNLOCK (file_rename_mutex);
           return;
         }
@@ -854,44 +1175,165 @@ thunar_file_monitor (GFileMonitor     *monitor,
 
 
 static void
-thunar_file_watch_destroyed (gpointer data)
+thunar_file_watch_parent_changed (GFile            *event_path,
+                                  GFile            *other_path,
+                                  GFileMonitorEvent event_type,
+                                  gpointer          user_data)
 {
-  ThunarFileWatch *file_watch = data;
+  ThunarFileParentWatch *parent_watch = user_data;
+  ThunarFile            *file;
+
+  /* the folder a watched file was moved out of reports the move */
+  if (event_type == G_FILE_MONITOR_EVENT_MOVED_IN)
+    {
+      event_type = G_FILE_MONITOR_EVENT_CREATED;
+      other_path = NULL;
+    }
+
+  /* the handler may release the parent watch */
+  file = g_hash_table_lookup (parent_watch->children, event_path);
+  if (file != NULL)
+    thunar_file_monitor_event (file, event_path, other_path, event_type);
+}
+
+
+
+static void
+thunar_file_parent_watch_free (ThunarFileParentWatch *parent_watch)
+{
+  g_hash_table_remove (file_parent_watches, parent_watch->gfile);
+  thunar_monitor_pool_unsubscribe (parent_watch->subscription);
+  g_hash_table_destroy (parent_watch->children);
+  g_object_unref (parent_watch->gfile);
+  g_slice_free (ThunarFileParentWatch, parent_watch);
+}
+
+
+
+static gboolean
+thunar_file_watch_attach (ThunarFile      *file,
+                          ThunarFileWatch *file_watch)
+{
+  ThunarFileParentWatch *parent_watch;
+  GFile                 *parent;
+  GError                *error = NULL;
+
+  /* the files are watched through the monitor of their parent folder,
+   * which the views of the folder and the other watched files in it
+   * share, instead of a monitor for every file */
+  parent = g_file_get_parent (file->gfile);
+  if (G_LIKELY (parent != NULL))
+    {
+      if (G_UNLIKELY (file_parent_watches == NULL))
+        file_parent_watches = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+      parent_watch = g_hash_table_lookup (file_parent_watches, parent);
+      if (parent_watch == NULL)
+        {
+          parent_watch = g_slice_new (ThunarFileParentWatch);
+          parent_watch->gfile = g_object_ref (parent);
+          parent_watch->children = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+          parent_watch->subscription = thunar_monitor_pool_subscribe (parent, thunar_file_watch_parent_changed,
+                                                                      NULL, parent_watch);
+          g_hash_table_insert (file_parent_watches, parent_watch->gfile, parent_watch);
+        }
+      g_object_unref (parent);
+
+      if (G_LIKELY (thunar_monitor_pool_is_supported (parent_watch->subscription)))
+        {
+          file_watch->parent_watch = parent_watch;
+          file_watch->gfile = g_object_ref (file->gfile);
+          g_hash_table_insert (parent_watch->children, file_watch->gfile, file);
+          return TRUE;
+        }
+
+      if (g_hash_table_size (parent_watch->children) == 0)
+        thunar_file_parent_watch_free (parent_watch);
+    }
+
+  /* fall back to a monitor of the file itself, e.g. for the roots of
+   * locations like trash:/// */
+  file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS |
+                                        G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+  if (G_UNLIKELY (file_watch->monitor == NULL))
+    {
+      g_debug ("Failed to create file monitor: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  /* watch monitor for file changes */
+  g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
+  thunar_counters_inc (THUNAR_COUNTER_MONITORS);
+
+  return TRUE;
+}
 
-  if (G_LIKELY (file_watch->monitor != NULL))
+
+
+static void
+thunar_file_watch_detach (ThunarFileWatch *file_watch)
+{
+  if (file_watch->parent_watch != NULL)
+    {
+      g_hash_table_remove (file_watch->parent_watch->children, file_watch->gfile);
+      if (g_hash_table_size (file_watch->parent_watch->children) == 0)
+        thunar_file_parent_watch_free (file_watch->parent_watch);
+      g_object_unref (file_watch->gfile);
+      file_watch->parent_watch = NULL;
+      file_watch->gfile = NULL;
+    }
+
+  if (file_watch->monitor != NULL)
     {
       g_file_monitor_cancel (file_watch->monitor);
       g_object_unref (file_watch->monitor);
+      file_watch->monitor = NULL;
+      thunar_counters_dec (THUNAR_COUNTER_MONITORS);
     }
+}
 
+
+
+static void
+thunar_file_watch_destroyed (gpointer data)
+{
+  ThunarFileWatch *file_watch = data;
+
+  thunar_file_watch_detach (file_watch);
   g_slice_free (ThunarFileWatch, file_watch);
 }
 
 
 
+static gboolean
+thunar_file_watch_reconnect_idle (gpointer user_data)
+{
+  thunar_file_watch_reconnect (THUNAR_FILE (user_data));
+  return FALSE;
+}
+
+
+
 static void
 thunar_file_watch_reconnect (ThunarFile *file)
 {
   ThunarFileWatch *file_watch;
 
-  /* recreate the monitor without changing the watch_count for file renames */
+  /* the watches belong to the main thread, renames may be done by jobs */
+  if (!g_main_context_is_owner (g_main_context_default ()))
+    {
+      g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT, thunar_file_watch_reconnect_idle,
+                                  g_object_ref (file), g_object_unref);
+      return;
+    }
+
+  /* move the watch to the new location without changing the watch_count for file renames */
   file_watch = g_object_get_qdata (G_OBJECT (file), thunar_file_watch_quark);
   if (file_watch != NULL)
     {
-      /* reset the old monitor */
-      if (G_LIKELY (file_watch->monitor != NULL))
-        {
-          g_file_monitor_cancel (file_watch->monitor);
-          g_object_unref (file_watch->monitor);
-        }
-
-      /* create a file or directory monitor */
-      file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS | G_FILE_MONITOR_SEND_MOVED, NULL, NULL);
-      if (G_LIKELY (file_watch->monitor != NULL))
-        {
-          /* watch monitor for file changes */
-          g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
-        }
+      thunar_file_watch_detach (file_watch);
+      thunar_file_watch_attach (file, file_watch);
     }
 }
 
@@ -910,6 +1352,7 @@ thunar_file_set_emblem_names_ready (GObject      *source_object,
       g_warning ("Failed to set metadata: %s", error->message);
       g_error_free (error);
 
+      thunar_file_emblems_clear (file);
       g_file_info_remove_attribute (file->info, "metadata::emblems");
     }
 
@@ -923,6 +1366,9 @@ thunar_file_info_clear (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
+  /* the emblem names point into the info */
+  thunar_file_emblems_clear (file);
+
   /* release the current file info */
   if (file->info != NULL)
     {
@@ -938,16 +1384,18 @@ thunar_file_info_clear (ThunarFile *file)
   file->custom_icon_name = NULL;
 
   /* free display name and basename */
-  g_free (file->display_name);
+  if (file->casefold_name != file->display_name)
+    g_free (file->casefold_name);
+  file->casefold_name = NULL;
+  if (file->display_name != file->basename)
+    g_free (file->display_name);
   file->display_name = NULL;
 
   g_free (file->basename);
   file->basename = NULL;
 
   /* content type */
-  g_free (file->content_type);
   file->content_type = NULL;
-  g_free (file->icon_name);
   file->icon_name = NULL;
 
   /* device type */
@@ -961,9 +1409,11 @@ thunar_file_info_clear (ThunarFile *file)
   g_free (file->collate_key);
   file->collate_key = NULL;
 
-  /* free thumbnail path */
-  g_free (file->thumbnail_path);
-  file->thumbnail_path = NULL;
+  /* forget the thumbnail location */
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_THUMB_FOUND);
+
+  /* the deferred attributes belong to the old info */
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_DEFERRED_INFO);
 
   /* assume the file is mounted by default */
   FLAG_SET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
@@ -975,26 +1425,89 @@ thunar_file_info_clear (ThunarFile *file)
 
 
 static void
-thunar_file_info_reload (ThunarFile   *file,
-                         GCancellable *cancellable)
+thunar_file_set_desktop_entry (ThunarFile *file,
+                               GKeyFile   *key_file)
 {
-  const gchar *target_uri;
-  GKeyFile    *key_file;
-  gchar       *p;
-  const gchar *display_name;
-  gboolean     is_secure = FALSE;
-  gchar       *casefold;
-  gchar       *path;
+  gchar *p;
 
-  _thunar_return_if_fail (THUNAR_IS_FILE (file));
-  _thunar_return_if_fail (file->info == NULL || G_IS_FILE_INFO (file->info));
+  /* read the icon name from the .desktop file */
+  g_free (file->custom_icon_name);
+  file->custom_icon_name = g_key_file_get_string (key_file,
+                                                  G_KEY_FILE_DESKTOP_GROUP,
+                                                  G_KEY_FILE_DESKTOP_KEY_ICON,
+                                                  NULL);
 
-  if (G_LIKELY (file->info != NULL))
+  if (G_UNLIKELY (exo_str_is_empty (file->custom_icon_name)))
     {
-      /* this is requested so often, cache it */
-      file->kind = g_file_info_get_file_type (file->info);
-
-      if (file->kind == G_FILE_TYPE_MOUNTABLE)
+      /* make sure we set null if the string is empty else the assertion in
+       * thunar_icon_factory_lookup_icon() will fail */
+      g_free (file->custom_icon_name);
+      file->custom_icon_name = NULL;
+    }
+  else
+    {
+      /* drop any suffix (e.g. '.png') from themed icons */
+      if (!g_path_is_absolute (file->custom_icon_name))
+        {
+          p = strrchr (file->custom_icon_name, '.');
+          if (p != NULL)
+            *p = '\0';
+        }
+    }
+}
+
+
+
+static void
+thunar_file_desktop_entry_loaded (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  ThunarFile *file = THUNAR_FILE (user_data);
+  GKeyFile   *key_file;
+  GKeyFile   *current;
+
+  key_file = thunar_desktop_entry_cache_load_finish (G_FILE (object), result, NULL);
+  if (key_file != NULL)
+    {
+      /* only use the entry if the file did not change in the meantime */
+      current = thunar_desktop_entry_cache_lookup (file->gfile, thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED));
+      if (current == key_file)
+        {
+          thunar_file_set_desktop_entry (file, key_file);
+          thunar_file_changed (file);
+        }
+
+      if (current != NULL)
+        g_key_file_unref (current);
+      g_key_file_unref (key_file);
+    }
+
+  g_object_unref (file);
+}
+
+
+
+static void
+thunar_file_info_reload (ThunarFile   *file,
+                         GCancellable *cancellable)
+{
+  const gchar *target_uri;
+  GKeyFile    *key_file;
+  guint64      mtime;
+  const gchar *display_name;
+  gboolean     is_secure = FALSE;
+  gchar       *path;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (file->info == NULL || G_IS_FILE_INFO (file->info));
+
+  if (G_LIKELY (file->info != NULL))
+    {
+      /* this is requested so often, cache it */
+      file->kind = g_file_info_get_file_type (file->info);
+
+      if (file->kind == G_FILE_TYPE_MOUNTABLE)
         {
           target_uri = g_file_info_get_attribute_string (file->info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
           if (target_uri != NULL
@@ -1003,6 +1516,11 @@ thunar_file_info_reload (ThunarFile   *file,
           else
              FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
         }
+
+      /* the real item count of the trash replaces the cached one */
+      if (g_file_info_has_attribute (file->info, G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT)
+          && thunar_g_file_is_trash (file->gfile))
+        thunar_trash_count_set (g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT));
     }
 
   /* determine the basename */
@@ -1015,44 +1533,27 @@ thunar_file_info_reload (ThunarFile   *file,
     {
       path = g_file_get_path (file->gfile);
       if (g_strcmp0 (path, "/proc/kmsg") == 0)
-        file->content_type = g_strdup (DEFAULT_CONTENT_TYPE);
+        file->content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
       g_free (path);
     }
 
   /* check if this file is a desktop entry */
   if (thunar_file_is_desktop_file (file, &is_secure) && is_secure)
     {
-      /* determine the custom icon and display name for .desktop files */
-
-      /* query a key file for the .desktop file */
-      key_file = thunar_g_file_query_key_file (file->gfile, cancellable, NULL);
+      /* determine the custom icon for .desktop files */
+      mtime = thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED);
+      key_file = thunar_desktop_entry_cache_lookup (file->gfile, mtime);
       if (key_file != NULL)
         {
-          /* read the icon name from the .desktop file */
-          file->custom_icon_name = g_key_file_get_string (key_file,
-                                                          G_KEY_FILE_DESKTOP_GROUP,
-                                                          G_KEY_FILE_DESKTOP_KEY_ICON,
-                                                          NULL);
-
-          if (G_UNLIKELY (exo_str_is_empty (file->custom_icon_name)))
-            {
-              /* make sure we set null if the string is empty else the assertion in
-               * thunar_icon_factory_lookup_icon() will fail */
-              g_free (file->custom_icon_name);
-              file->custom_icon_name = NULL;
-            }
-          else
-            {
-              /* drop any suffix (e.g. '.png') from themed icons */
-              if (!g_path_is_absolute (file->custom_icon_name))
-                {
-                  p = strrchr (file->custom_icon_name, '.');
-                  if (p != NULL)
-                    *p = '\0';
-                }
-            }
-          /* free the key file */
-          g_key_file_free (key_file);
+          thunar_file_set_desktop_entry (file, key_file);
+          g_key_file_unref (key_file);
+        }
+      else
+        {
+          /* parse the file on a worker thread, the icon is updated once it is known */
+          thunar_desktop_entry_cache_load_async (file->gfile, mtime, cancellable,
+                                                 thunar_file_desktop_entry_loaded,
+                                                 g_object_ref (file));
         }
     }
 
@@ -1068,6 +1569,8 @@ thunar_file_info_reload (ThunarFile   *file,
             {
               if (strcmp (display_name, "/") == 0)
                 file->display_name = g_strdup (_("File System"));
+              else if (strcmp (display_name, file->basename) == 0)
+                file->display_name = file->basename;
               else
                 file->display_name = g_strdup (display_name);
             }
@@ -1078,20 +1581,91 @@ thunar_file_info_reload (ThunarFile   *file,
         file->display_name = thunar_g_file_get_display_name (file->gfile);
     }
 
-  /* create case sensitive collation key */
-  file->collate_key = g_utf8_collate_key_for_filename (file->display_name, -1);
+  /* the collation keys are created once the file is compared by name */
+}
 
-  /* lowercase the display name */
-  casefold = g_utf8_casefold (file->display_name, -1);
 
-  /* if the lowercase name is equal, only peek the already hash key */
-  if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
-    file->collate_key_nocase = g_utf8_collate_key_for_filename (casefold, -1);
+
+static void
+thunar_file_get_request_complete (ThunarFileGetRequest *request,
+                                  GFileInfo            *file_info,
+                                  GError               *error)
+{
+  ThunarFileGetData *data;
+  ThunarFile        *file;
+  GError            *cancelled;
+  GList             *lp;
+
+  /* new callers start a new load from now on */
+  if (g_hash_table_lookup (file_get_requests, request->location) == request)
+    g_hash_table_remove (file_get_requests, request->location);
+
+  /* another caller may have loaded the file synchronously meanwhile */
+  file = thunar_file_cache_lookup (request->location);
+  if (G_UNLIKELY (file != NULL))
+    {
+      if (file_info != NULL)
+        g_object_unref (file_info);
+    }
   else
-    file->collate_key_nocase = file->collate_key;
+    {
+      /* allocate a new file object */
+      file = g_object_new (THUNAR_TYPE_FILE, NULL);
+      file->gfile = g_object_ref (request->location);
 
-  /* cleanup */
-  g_free (casefold);
+      /* reset the file */
+      thunar_file_info_clear (file);
+
+      /* set the file information */
+      file->info = file_info;
+
+      /* update the file from the information */
+      thunar_file_info_reload (file, NULL);
+
+      /* update the mounted info */
+      if (error != NULL
+          && error->domain == G_IO_ERROR
+          && error->code == G_IO_ERROR_NOT_MOUNTED)
+        {
+          FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+          error = NULL;
+        }
+
+      /* insert the file into the cache */
+      thunar_file_cache_insert (file);
+    }
+
+  for (lp = request->waiters; lp != NULL; lp = lp->next)
+    {
+      data = lp->data;
+
+      if (data->cancellable != NULL)
+        g_cancellable_disconnect (data->cancellable, data->cancelled_id);
+
+      /* callers that cancelled learn about it, even if others did not */
+      cancelled = NULL;
+      if (data->cancellable != NULL)
+        g_cancellable_set_error_if_cancelled (data->cancellable, &cancelled);
+
+      /* pass the loaded file and possible errors to the return function */
+      (data->func) (request->location, file, cancelled != NULL ? cancelled : error, data->user_data);
+
+      if (cancelled != NULL)
+        g_error_free (cancelled);
+
+      /* release the get data */
+      if (data->cancellable != NULL)
+        g_object_unref (data->cancellable);
+      g_slice_free (ThunarFileGetData, data);
+    }
+
+  /* release the file, see description in ThunarFileGetFunc */
+  g_object_unref (file);
+
+  g_list_free (request->waiters);
+  g_object_unref (request->cancellable);
+  g_object_unref (request->location);
+  g_slice_free (ThunarFileGetRequest, request);
 }
 
 
@@ -1101,61 +1675,197 @@ thunar_file_get_async_finish (GObject      *object,
                               GAsyncResult *result,
                               gpointer      user_data)
 {
-  ThunarFileGetData *data = user_data;
-  ThunarFile        *file;
-  GFileInfo         *file_info;
-  GError            *error = NULL;
-  GFile             *location = G_FILE (object);
+  ThunarFileGetRequest *request = user_data;
+  GFileInfo            *file_info;
+  GError               *error = NULL;
 
-  _thunar_return_if_fail (G_IS_FILE (location));
+  _thunar_return_if_fail (G_IS_FILE (object));
   _thunar_return_if_fail (G_IS_ASYNC_RESULT (result));
 
   /* finish querying the file information */
-  file_info = g_file_query_info_finish (location, result, &error);
+  file_info = g_file_query_info_finish (G_FILE (object), result, &error);
 
-  /* allocate a new file object */
-  file = g_object_new (THUNAR_TYPE_FILE, NULL);
-  file->gfile = g_object_ref (location);
+  thunar_file_get_request_complete (request, file_info, error);
 
-  /* reset the file */
-  thunar_file_info_clear (file);
+  /* free the error, if there is any */
+  if (error != NULL)
+    g_error_free (error);
+}
 
-  /* set the file information */
-  file->info = file_info;
 
-  /* update the file from the information */
-  thunar_file_info_reload (file, data->cancellable);
 
-  /* update the mounted info */
-  if (error != NULL
-      && error->domain == G_IO_ERROR
-      && error->code == G_IO_ERROR_NOT_MOUNTED)
-   {
-      FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-      g_clear_error (&error);
-   }
+static void
+thunar_file_get_request_start (gpointer data,
+                               gpointer user_data)
+{
+  ThunarFileGetRequest *request = data;
 
-  /* insert the file into the cache */
-  G_LOCK (file_cache_mutex);
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-  G_UNLOCK (file_cache_mutex);
+  /* load the file information asynchronously */
+  g_file_query_info_async (request->location,
+                           THUNARX_FILE_INFO_NAMESPACE,
+                           G_FILE_QUERY_INFO_NONE,
+                           G_PRIORITY_DEFAULT,
+                           request->cancellable,
+                           thunar_file_get_async_finish,
+                           request);
+}
 
-  /* pass the loaded file and possible errors to the return function */
-  (data->func) (location, file, error, data->user_data);
 
-  /* release the file, see description in ThunarFileGetFunc */
-  g_object_unref (file);
 
-  /* free the error, if there is any */
-  if (error != NULL)
-    g_error_free (error);
+static void
+thunar_file_get_batch_finish (ThunarFileGetBatch *batch)
+{
+  GList *requests;
+
+  /* load the files the enumeration did not return one by one, which
+   * also reports the right error for files that do not exist */
+  requests = g_hash_table_get_values (batch->requests);
+  g_list_foreach (requests, thunar_file_get_request_start, NULL);
+  g_list_free (requests);
+
+  if (batch->enumerator != NULL)
+    {
+      g_file_enumerator_close_async (batch->enumerator, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+      g_object_unref (batch->enumerator);
+    }
+
+  g_hash_table_destroy (batch->requests);
+  g_object_unref (batch->parent);
+  g_slice_free (ThunarFileGetBatch, batch);
+}
+
+
+
+static void
+thunar_file_get_batch_next (GObject      *object,
+                            GAsyncResult *result,
+                            gpointer      user_data)
+{
+  ThunarFileGetRequest *request;
+  ThunarFileGetBatch   *batch = user_data;
+  GList                *infos;
+  GList                *lp;
+
+  infos = g_file_enumerator_next_files_finish (G_FILE_ENUMERATOR (object), result, NULL);
+  for (lp = infos; lp != NULL; lp = lp->next)
+    {
+      request = g_hash_table_lookup (batch->requests, g_file_info_get_name (lp->data));
+      if (request != NULL)
+        {
+          g_hash_table_remove (batch->requests, g_file_info_get_name (lp->data));
+          thunar_file_get_request_complete (request, g_object_ref (lp->data), NULL);
+        }
+      batch->n_read++;
+    }
+
+  /* stop at the end, once all files are found or in very large folders */
+  if (infos == NULL
+      || g_hash_table_size (batch->requests) == 0
+      || batch->n_read >= THUNAR_FILE_GET_BATCH_MAX_READ)
+    thunar_file_get_batch_finish (batch);
+  else
+    g_file_enumerator_next_files_async (batch->enumerator, 100, G_PRIORITY_DEFAULT, NULL,
+                                        thunar_file_get_batch_next, batch);
+
+  g_list_free_full (infos, g_object_unref);
+}
+
+
+
+static void
+thunar_file_get_batch_enumerated (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  ThunarFileGetBatch *batch = user_data;
+
+  batch->enumerator = g_file_enumerate_children_finish (G_FILE (object), result, NULL);
+  if (G_UNLIKELY (batch->enumerator == NULL))
+    thunar_file_get_batch_finish (batch);
+  else
+    g_file_enumerator_next_files_async (batch->enumerator, 100, G_PRIORITY_DEFAULT, NULL,
+                                        thunar_file_get_batch_next, batch);
+}
+
+
+
+static gboolean
+thunar_file_get_idle (gpointer user_data)
+{
+  ThunarFileGetRequest *request;
+  ThunarFileGetBatch   *batch;
+  GHashTableIter        iter;
+  GHashTable           *siblings;
+  GFile                *parent;
+  GList                *requests;
+  GList                *lp;
+
+  file_get_idle_id = 0;
+
+  /* group the scheduled loads of local files by their folder */
+  siblings = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+  for (lp = file_get_scheduled; lp != NULL; lp = lp->next)
+    {
+      request = lp->data;
+      parent = g_file_is_native (request->location) ? g_file_get_parent (request->location) : NULL;
+      if (parent == NULL)
+        {
+          thunar_file_get_request_start (request, NULL);
+          continue;
+        }
+
+      requests = g_hash_table_lookup (siblings, parent);
+      g_hash_table_replace (siblings, parent, g_list_prepend (requests, request));
+    }
+  g_list_free (file_get_scheduled);
+  file_get_scheduled = NULL;
+
+  g_hash_table_iter_init (&iter, siblings);
+  while (g_hash_table_iter_next (&iter, (gpointer) &parent, (gpointer) &requests))
+    {
+      if (g_list_length (requests) < THUNAR_FILE_GET_BATCH_MIN)
+        {
+          g_list_foreach (requests, thunar_file_get_request_start, NULL);
+        }
+      else
+        {
+          /* one enumeration of the folder is cheaper than many queries */
+          batch = g_slice_new0 (ThunarFileGetBatch);
+          batch->parent = g_object_ref (parent);
+          batch->requests = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+          for (lp = requests; lp != NULL; lp = lp->next)
+            {
+              request = lp->data;
+              g_hash_table_insert (batch->requests, g_file_get_basename (request->location), request);
+            }
 
-  /* release the get data */
-  if (data->cancellable != NULL)
-    g_object_unref (data->cancellable);
-  g_slice_free (ThunarFileGetData, data);
+          g_file_enumerate_children_async (parent,
+                                           THUNARX_FILE_INFO_NAMESPACE,
+                                           G_FILE_QUERY_INFO_NONE,
+                                           G_PRIORITY_DEFAULT,
+                                           NULL,
+                                           thunar_file_get_batch_enumerated,
+                                           batch);
+        }
+
+      g_list_free (requests);
+    }
+  g_hash_table_destroy (siblings);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_file_get_cancelled (GCancellable      *cancellable,
+                           ThunarFileGetData *data)
+{
+  ThunarFileGetRequest *request = data->request;
+
+  /* stop the load once nobody waits for it anymore */
+  if (++request->n_cancelled == g_list_length (request->waiters))
+    g_cancellable_cancel (request->cancellable);
 }
 
 
@@ -1187,22 +1897,22 @@ thunar_file_load (ThunarFile   *file,
   _thunar_return_val_if_fail (G_IS_FILE (file->gfile), FALSE);
 
   /* remove the file from cache */
-  G_LOCK (file_cache_mutex);
-  if (g_hash_table_lookup (file_cache, file->gfile) != NULL)
-    g_hash_table_remove (file_cache, file->gfile);
-  G_UNLOCK (file_cache_mutex);
+  thunar_file_cache_remove (file->gfile);
 
   /* reset the file */
   thunar_file_info_clear (file);
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_SNAPSHOT);
 
   /* query a new file info */
-  file->info = g_file_query_info (file->gfile,
-                                  THUNARX_FILE_INFO_NAMESPACE,
-                                  G_FILE_QUERY_INFO_NONE,
-                                  cancellable, &err);
+  thunar_watchdog_push_operation ("file load", file->gfile);
+  file->info = thunar_mount_health_query_info (file->gfile,
+                                               THUNARX_FILE_INFO_NAMESPACE,
+                                               G_FILE_QUERY_INFO_NONE,
+                                               cancellable, &err);
 
   /* update the file from the information */
   thunar_file_info_reload (file, cancellable);
+  thunar_watchdog_pop_operation ();
 
   /* update the mounted info */
   if (err != NULL
@@ -1221,18 +1931,45 @@ thunar_file_load (ThunarFile   *file,
 
   /* (re)insert the file into the cache */
   if (file != NULL && file->kind != G_FILE_TYPE_UNKNOWN)
-    {
-      G_LOCK (file_cache_mutex);
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
-      G_UNLOCK (file_cache_mutex);
-    }
+    thunar_file_cache_insert (file);
   return TRUE;
 }
 
 
 
+/**
+ * thunar_file_load_info:
+ * @file : a #ThunarFile.
+ * @info : the #GFileInfo of @file.
+ *
+ * Same as thunar_file_load() for callers that already queried
+ * the information about the file, e.g. from a worker thread.
+ **/
+static void
+thunar_file_load_info (ThunarFile *file,
+                       GFileInfo  *info)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (G_IS_FILE_INFO (info));
+
+  /* remove the file from cache */
+  thunar_file_cache_remove (file->gfile);
+
+  /* reset the file */
+  thunar_file_info_clear (file);
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_SNAPSHOT);
+
+  /* update the file from the information */
+  file->info = g_object_ref (info);
+  thunar_file_info_reload (file, NULL);
+
+  /* (re)insert the file into the cache */
+  if (file->kind != G_FILE_TYPE_UNKNOWN)
+    thunar_file_cache_insert (file);
+}
+
+
+
 /**
  * thunar_file_get:
  * @file  : a #GFile.
@@ -1270,16 +2007,8 @@ thunar_file_get (GFile   *gfile,
 
       if (thunar_file_load (file, NULL, error))
         {
-          /* setup lock until the file is inserted */
-          G_LOCK (file_cache_mutex);
-
           /* insert the file into the cache */
-          g_hash_table_insert (file_cache,
-                               g_object_ref (file->gfile),
-                               weak_ref_new (G_OBJECT (file)));
-
-          /* done inserting in the cache */
-          G_UNLOCK (file_cache_mutex);
+          thunar_file_cache_insert (file);
         }
       else
         {
@@ -1295,6 +2024,109 @@ thunar_file_get (GFile   *gfile,
 }
 
 
+static gboolean
+thunar_file_info_update_idle (gpointer user_data)
+{
+  ThunarFileInfoUpdate *update = user_data;
+  ThunarFile           *file = update->file;
+
+  /* check if the file was not reloaded in the meantime */
+  if (FLAG_IS_SET (file, THUNAR_FILE_FLAG_IS_SNAPSHOT))
+    {
+      FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_SNAPSHOT);
+
+      /* clear file pxmap cache */
+      thunar_icon_factory_clear_pixmap_cache (file);
+
+      /* replace the snapshot information with the real one */
+      thunar_file_info_clear (file);
+      file->info = g_object_ref (update->info);
+      thunar_file_info_reload (file, NULL);
+
+      if (update->deferred)
+        FLAG_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO);
+
+      /* ... and tell others */
+      thunar_file_changed (file);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_file_info_update_free (gpointer user_data)
+{
+  ThunarFileInfoUpdate *update = user_data;
+
+  g_object_unref (update->file);
+  g_object_unref (update->info);
+  g_slice_free (ThunarFileInfoUpdate, update);
+}
+
+
+
+static ThunarFile *
+thunar_file_get_with_info_real (GFile     *gfile,
+                                GFileInfo *info,
+                                gboolean   not_mounted,
+                                gboolean   deferred)
+{
+  ThunarFileInfoUpdate *update;
+  ThunarFile           *file;
+
+  /* check if we already have a cached version of that file */
+  file = thunar_file_cache_lookup (gfile);
+  if (G_UNLIKELY (file != NULL))
+    {
+      /* return the file, it already has an additional ref set
+       * in thunar_file_cache_lookup */
+
+      /* the file was restored from a folder snapshot, so replace its
+       * partial information with @info in the main loop */
+      if (G_UNLIKELY (FLAG_IS_SET (file, THUNAR_FILE_FLAG_IS_SNAPSHOT)))
+        {
+          update = g_slice_new (ThunarFileInfoUpdate);
+          update->file = g_object_ref (file);
+          update->info = g_object_ref (info);
+          update->deferred = deferred;
+          g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, thunar_file_info_update_idle,
+                           update, thunar_file_info_update_free);
+        }
+    }
+  else
+    {
+      /* allocate a new object */
+      file = g_object_new (THUNAR_TYPE_FILE, NULL);
+      file->gfile = g_object_ref (gfile);
+
+      /* reset the file */
+      thunar_file_info_clear (file);
+
+      /* set the passed info */
+      file->info = g_object_ref (info);
+
+      /* update the file from the information */
+      thunar_file_info_reload (file, NULL);
+
+      /* update the mounted info */
+      if (not_mounted)
+        FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+
+      /* set before the file is visible to other threads */
+      if (deferred)
+        FLAG_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO);
+
+      /* insert the file into the cache */
+      thunar_file_cache_insert (file);
+    }
+
+  return file;
+}
+
+
+
 /**
  * thunar_file_get_with_info:
  * @uri         : an URI or an absolute filename.
@@ -1318,47 +2150,72 @@ thunar_file_get_with_info (GFile     *gfile,
                            GFileInfo *info,
                            gboolean   not_mounted)
 {
-  ThunarFile *file;
+  _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
+  return thunar_file_get_with_info_real (gfile, info, not_mounted, FALSE);
+}
+
+
+
+/**
+ * thunar_file_get_with_fast_info:
+ * @gfile : a #GFile.
+ * @info  : #GFileInfo with the attributes of THUNAR_FILE_INFO_NAMESPACE_FAST.
+ *
+ * Like thunar_file_get_with_info(), but the attributes of
+ * THUNAR_FILE_INFO_NAMESPACE_DEFERRED are missing from @info. They are
+ * queried once they are asked for, unless thunar_file_set_deferred_info()
+ * provided them before.
+ *
+ * The caller is responsible to call g_object_unref()
+ * when done with the returned object.
+ *
+ * Return value: the #ThunarFile for @gfile.
+ **/
+ThunarFile *
+thunar_file_get_with_fast_info (GFile     *gfile,
+                                GFileInfo *info)
+{
   _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
   _thunar_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  /* check if we already have a cached version of that file */
-  file = thunar_file_cache_lookup (gfile);
-  if (G_UNLIKELY (file != NULL))
-    {
-      /* return the file, it already has an additional ref set
-       * in thunar_file_cache_lookup */
-    }
-  else
-    {
-      /* allocate a new object */
-      file = g_object_new (THUNAR_TYPE_FILE, NULL);
-      file->gfile = g_object_ref (gfile);
+  return thunar_file_get_with_info_real (gfile, info, FALSE, TRUE);
+}
 
-      /* reset the file */
-      thunar_file_info_clear (file);
 
-      /* set the passed info */
-      file->info = g_object_ref (info);
 
-      /* update the file from the information */
-      thunar_file_info_reload (file, NULL);
 
-      /* update the mounted info */
-      if (not_mounted)
-        FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
 
-      /* setup lock until the file is inserted */
-      G_LOCK (file_cache_mutex);
+/**
+ * thunar_file_get_with_snapshot_info:
+ * @gfile : a #GFile.
+ * @info  : partial #GFileInfo restored from a folder snapshot.
+ *
+ * Like thunar_file_get_with_info(), but the @info is only used if the
+ * file is not already cached, and is replaced by the complete information
+ * as soon as the file is reported again by thunar_file_get_with_info().
+ *
+ * The caller is responsible to call g_object_unref()
+ * when done with the returned object.
+ *
+ * Return value: the #ThunarFile for @gfile.
+ **/
+ThunarFile *
+thunar_file_get_with_snapshot_info (GFile     *gfile,
+                                    GFileInfo *info)
+{
+  ThunarFile *file;
 
-      /* insert the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
+  _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-      /* done inserting in the cache */
-      G_UNLOCK (file_cache_mutex);
+  /* prefer the real information if we have it */
+  file = thunar_file_cache_lookup (gfile);
+  if (G_LIKELY (file == NULL))
+    {
+      file = thunar_file_get_with_info (gfile, info, FALSE);
+      FLAG_SET (file, THUNAR_FILE_FLAG_IS_SNAPSHOT);
     }
 
   return file;
@@ -1366,8 +2223,6 @@ thunar_file_get_with_info (GFile     *gfile,
 
 
 
-
-
 /**
  * thunar_file_get_for_uri:
  * @uri   : an URI or an absolute filename.
@@ -1403,6 +2258,19 @@ thunar_file_get_for_uri (const gchar *uri,
 
 /**
  * thunar_file_get_async:
+ * @location    : a #GFile.
+ * @cancellable : a #GCancellable or %NULL.
+ * @func        : the function to call with the loaded #ThunarFile.
+ * @user_data   : data to pass to @func.
+ *
+ * Calls @func with the #ThunarFile for @location, right away if it is
+ * cached and once its information is loaded otherwise. All callers
+ * waiting for the same @location share one load, and the loads of many
+ * local files in one folder are answered by a single enumeration of
+ * that folder. The load is only cancelled once the @cancellable<!---->s
+ * of all its callers are.
+ *
+ * This function may only be used from the main thread.
  **/
 void
 thunar_file_get_async (GFile            *location,
@@ -1410,8 +2278,9 @@ thunar_file_get_async (GFile            *location,
                        ThunarFileGetFunc func,
                        gpointer          user_data)
 {
-  ThunarFile        *file;
-  ThunarFileGetData *data;
+  ThunarFileGetRequest *request;
+  ThunarFile           *file;
+  ThunarFileGetData    *data;
 
   _thunar_return_if_fail (G_IS_FILE (location));
   _thunar_return_if_fail (func != NULL);
@@ -1426,21 +2295,36 @@ thunar_file_get_async (GFile            *location,
     }
   else
     {
+      if (G_UNLIKELY (file_get_requests == NULL))
+        file_get_requests = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+      /* join the load of the location, unless it is being cancelled */
+      request = g_hash_table_lookup (file_get_requests, location);
+      if (request == NULL || g_cancellable_is_cancelled (request->cancellable))
+        {
+          request = g_slice_new0 (ThunarFileGetRequest);
+          request->location = g_object_ref (location);
+          request->cancellable = g_cancellable_new ();
+          g_hash_table_replace (file_get_requests, request->location, request);
+
+          /* start the loads requested in this main loop iteration together */
+          file_get_scheduled = g_list_prepend (file_get_scheduled, request);
+          if (file_get_idle_id == 0)
+            file_get_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_file_get_idle, NULL, NULL);
+        }
+
       /* allocate get data */
       data = g_slice_new0 (ThunarFileGetData);
       data->user_data = user_data;
       data->func = func;
-      if (cancellable != NULL)
-        data->cancellable = g_object_ref (cancellable);
+      data->request = request;
+      request->waiters = g_list_append (request->waiters, data);
 
-      /* load the file information asynchronously */
-      g_file_query_info_async (location,
-                               THUNARX_FILE_INFO_NAMESPACE,
-                               G_FILE_QUERY_INFO_NONE,
-                               G_PRIORITY_DEFAULT,
-                               cancellable,
-                               thunar_file_get_async_finish,
-                               data);
+      if (cancellable != NULL)
+        {
+          data->cancellable = g_object_ref (cancellable);
+          data->cancelled_id = g_cancellable_connect (cancellable, G_CALLBACK (thunar_file_get_cancelled), data, NULL);
+        }
     }
 }
 
@@ -1490,6 +2374,113 @@ thunar_file_get_info (const ThunarFile *file)
 
 
 
+/**
+ * thunar_file_has_deferred_info:
+ * @file : a #ThunarFile instance.
+ *
+ * Checks whether the attributes of THUNAR_FILE_INFO_NAMESPACE_DEFERRED
+ * were not queried for @file yet, see thunar_file_get_with_fast_info().
+ *
+ * Return value: %TRUE if the deferred attributes of @file are missing.
+ **/
+gboolean
+thunar_file_has_deferred_info (const ThunarFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+  return FLAG_IS_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO);
+}
+
+
+
+static void
+thunar_file_merge_deferred_info (ThunarFile *file,
+                                 GFileInfo  *info)
+{
+  GFileAttributeType   type;
+  gpointer             value_p;
+  gchar              **attributes;
+  guint                n;
+
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_DEFERRED_INFO);
+
+  /* the emblems may be replaced or complete now */
+  thunar_file_emblems_clear (file);
+
+  attributes = g_file_info_list_attributes (info, NULL);
+  for (n = 0; attributes[n] != NULL; n++)
+    if (g_file_info_get_attribute_data (info, attributes[n], &type, &value_p, NULL))
+      g_file_info_set_attribute (file->info, attributes[n], type, value_p);
+  g_strfreev (attributes);
+}
+
+
+
+/**
+ * thunar_file_set_deferred_info:
+ * @file : a #ThunarFile instance.
+ * @info : #GFileInfo queried with THUNAR_FILE_INFO_NAMESPACE_DEFERRED.
+ *
+ * Completes the information of @file with the deferred attributes in
+ * @info, unless they were loaded in the meantime, and emits ::changed.
+ * This must be called from the main loop.
+ **/
+void
+thunar_file_set_deferred_info (ThunarFile *file,
+                               GFileInfo  *info)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (G_IS_FILE_INFO (info));
+
+  if (!FLAG_IS_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO) || file->info == NULL)
+    return;
+
+  thunar_file_merge_deferred_info (file, info);
+
+  /* the emblems and the preview icon may have changed */
+  thunar_file_changed (file);
+}
+
+
+
+static void
+thunar_file_ensure_deferred_info (const ThunarFile *file)
+{
+  GFileInfo *info;
+
+  if (G_LIKELY (!FLAG_IS_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO)) || file->info == NULL)
+    return;
+
+  /* the background query did not finish yet, but the caller cannot wait */
+  info = thunar_mount_health_query_info (file->gfile, THUNAR_FILE_INFO_NAMESPACE_DEFERRED,
+                                         G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (G_LIKELY (info != NULL))
+    {
+      thunar_file_merge_deferred_info (THUNAR_FILE (file), info);
+      g_object_unref (info);
+    }
+  else
+    {
+      /* don't try again, the attributes are missing like for any other
+       * file whose backend does not provide them */
+      FLAG_UNSET (THUNAR_FILE (file), THUNAR_FILE_FLAG_DEFERRED_INFO);
+    }
+}
+
+
+
+static void
+thunar_file_emblems_clear (ThunarFile *file)
+{
+  if (!FLAG_IS_SET (file, THUNAR_FILE_FLAG_EMBLEMS))
+    return;
+
+  g_list_free (file->emblem_names);
+  file->emblem_names = NULL;
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_EMBLEMS);
+}
+
+
+
 /**
  * thunar_file_get_parent:
  * @file  : a #ThunarFile instance.
@@ -1610,7 +2601,8 @@ thunar_file_execute (ThunarFile  *file,
   if (thunar_file_is_desktop_file (file, &is_secure))
     {
       /* parse file first, even if it is insecure */
-      key_file = thunar_g_file_query_key_file (file->gfile, NULL, &err);
+      key_file = thunar_desktop_entry_cache_load (file->gfile, thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED),
+                                                  NULL, &err);
       if (key_file == NULL)
         {
           g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
@@ -1688,7 +2680,7 @@ thunar_file_execute (ThunarFile  *file,
         }
 
       g_free (type);
-      g_key_file_free (key_file);
+      g_key_file_unref (key_file);
     }
   else
     {
@@ -1909,7 +2901,7 @@ thunar_file_rename (ThunarFile   *file,
   if (renamed_file != NULL)
     {
       /* notify the file is renamed */
-      thunar_file_monitor_moved (file, renamed_file);
+      thunar_file_monitor_moved (file, renamed_file, NULL);
 
       g_object_unref (G_OBJECT (renamed_file));
 
@@ -1930,6 +2922,40 @@ thunar_file_rename (ThunarFile   *file,
 
 
 
+/**
+ * thunar_file_finish_rename:
+ * @file         : a #ThunarFile instance.
+ * @renamed_file : the new location of @file.
+ * @info         : the #GFileInfo for @renamed_file or %NULL.
+ *
+ * Updates @file after it was renamed to @renamed_file without using
+ * thunar_file_rename(), e.g. from a worker thread. If @info is %NULL,
+ * the information about @renamed_file is queried again.
+ *
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_file_finish_rename (ThunarFile *file,
+                           GFile      *renamed_file,
+                           GFileInfo  *info)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (G_IS_FILE (renamed_file));
+  _thunar_return_if_fail (info == NULL || G_IS_FILE_INFO (info));
+
+  G_LOCK (file_rename_mutex);
+
+  /* notify the file is renamed */
+  thunar_file_monitor_moved (file, renamed_file, info);
+
+  /* emit the file changed signal */
+  thunar_file_changed (file);
+
+  G_UNLOCK (file_rename_mutex);
+}
+
+
+
 /**
  * thunar_file_accepts_drop:
  * @file                    : a #ThunarFile instance.
@@ -2419,9 +3445,7 @@ thunar_file_get_user (const ThunarFile *file)
 const gchar *
 thunar_file_get_content_type (ThunarFile *file)
 {
-  GFileInfo   *info;
-  GError      *err = NULL;
-  const gchar *content_type = NULL;
+  GError *err = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
@@ -2440,29 +3464,13 @@ thunar_file_get_content_type (ThunarFile *file)
       if (G_UNLIKELY (file->kind == G_FILE_TYPE_DIRECTORY))
         {
           /* this we known for sure */
-          file->content_type = g_strdup ("inode/directory");
+          file->content_type = g_intern_static_string ("inode/directory");
         }
       else
         {
-          /* async load the content-type */
-          info = g_file_query_info (file->gfile,
-                                    G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
-                                    G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE,
-                                    G_FILE_QUERY_INFO_NONE,
-                                    NULL, &err);
-
-          if (G_LIKELY (info != NULL))
-            {
-              /* store the new content type */
-              content_type = g_file_info_get_content_type (info);
-              if (G_UNLIKELY (content_type == NULL))
-                content_type = g_file_info_get_attribute_string (info,
-                                                                 G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
-              if (G_LIKELY (content_type != NULL))
-                file->content_type = g_strdup (content_type);
-              g_object_unref (G_OBJECT (info));
-            }
-          else
+          /* load the content-type */
+          file->content_type = thunar_file_query_content_type (file->gfile, NULL, &err);
+          if (G_UNLIKELY (err != NULL))
             {
               g_warning ("Content type loading failed for %s: %s",
                          thunar_file_get_display_name (file),
@@ -2472,7 +3480,7 @@ thunar_file_get_content_type (ThunarFile *file)
 
           /* always provide a fallback */
           if (file->content_type == NULL)
-            file->content_type = g_strdup (DEFAULT_CONTENT_TYPE);
+            file->content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
         }
 
       bailout:
@@ -2490,12 +3498,96 @@ thunar_file_load_content_type (ThunarFile *file)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), TRUE);
 
-  if (file->content_type != NULL)
-    return FALSE;
+  if (file->content_type != NULL)
+    return FALSE;
+
+  thunar_file_get_content_type (file);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_file_has_content_type:
+ * @file : a #ThunarFile.
+ *
+ * Tells whether the content type of @file is already known, so
+ * thunar_file_get_content_type() returns without doing any I/O.
+ *
+ * Return value: %TRUE if the content type of @file is known.
+ **/
+gboolean
+thunar_file_has_content_type (const ThunarFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), TRUE);
+  return file->content_type != NULL;
+}
+
+
+
+/**
+ * thunar_file_query_content_type:
+ * @gfile       : a #GFile.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Determines the content type of @gfile, sniffing its contents if
+ * necessary. Unlike thunar_file_get_content_type() this does not
+ * need a #ThunarFile and may be used from any thread.
+ *
+ * Return value: the interned content type of @gfile or %NULL.
+ **/
+const gchar *
+thunar_file_query_content_type (GFile        *gfile,
+                                GCancellable *cancellable,
+                                GError      **error)
+{
+  GFileInfo   *info;
+  const gchar *content_type = NULL;
+
+  _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
+
+  info = g_file_query_info (gfile,
+                            G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+                            G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE,
+                            G_FILE_QUERY_INFO_NONE,
+                            cancellable, error);
+  if (G_UNLIKELY (info == NULL))
+    return NULL;
+
+  content_type = g_file_info_get_content_type (info);
+  if (G_UNLIKELY (content_type == NULL))
+    content_type = g_file_info_get_attribute_string (info,
+                                                     G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+  if (G_LIKELY (content_type != NULL))
+    content_type = g_intern_string (content_type);
+  g_object_unref (G_OBJECT (info));
+
+  return content_type;
+}
+
+
 
-  thunar_file_get_content_type (file);
+/**
+ * thunar_file_set_content_type:
+ * @file         : a #ThunarFile.
+ * @content_type : an interned content type.
+ *
+ * Stores the @content_type determined by thunar_file_query_content_type()
+ * for @file, unless the content type of @file is already known.
+ **/
+void
+thunar_file_set_content_type (ThunarFile  *file,
+                              const gchar *content_type)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (content_type != NULL);
 
-  return TRUE;
+  G_LOCK (file_content_type_mutex);
+  if (G_LIKELY (file->content_type == NULL))
+    file->content_type = content_type;
+  G_UNLOCK (file_content_type_mutex);
 }
 
 
@@ -2692,8 +3784,25 @@ thunar_file_is_mounted (const ThunarFile *file)
 gboolean
 thunar_file_exists (const ThunarFile *file)
 {
+  GFileInfo *info;
+  GError    *error = NULL;
+  gboolean   exists;
+
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
-  return g_file_query_exists (file->gfile, NULL);
+
+  info = thunar_mount_health_query_info (file->gfile, G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                         G_FILE_QUERY_INFO_NONE, NULL, &error);
+  if (G_LIKELY (info != NULL))
+    {
+      g_object_unref (info);
+      return TRUE;
+    }
+
+  /* files on a stalled mount are not gone */
+  exists = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+  g_error_free (error);
+
+  return exists;
 }
 
 
@@ -2935,6 +4044,8 @@ thunar_file_is_readable (const ThunarFile *file)
   if (file->info == NULL)
     return FALSE;
 
+  thunar_file_ensure_deferred_info (file);
+
   if (!g_file_info_has_attribute (file->info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ))
     return TRUE;
 
@@ -2961,6 +4072,8 @@ thunar_file_is_writable (const ThunarFile *file)
   if (file->info == NULL)
     return FALSE;
 
+  thunar_file_ensure_deferred_info (file);
+
   if (!g_file_info_has_attribute (file->info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE))
     return TRUE;
 
@@ -3220,7 +4333,8 @@ thunar_file_get_original_path (const ThunarFile *file)
  * @file : a #ThunarFile instance.
  *
  * Returns the number of items in the trash, if @file refers to the
- * trash root directory. Otherwise returns 0.
+ * trash root directory. Otherwise returns 0. The count is kept up to
+ * date by the jobs changing the trash, see thunar_trash_count_add().
  *
  * Return value: number of files in the trash if @file is the trash
  *               root dir, 0 otherwise.
@@ -3228,11 +4342,20 @@ thunar_file_get_original_path (const ThunarFile *file)
 guint32
 thunar_file_get_item_count (const ThunarFile *file)
 {
+  gint count;
+
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
 
   if (file->info == NULL)
     return 0;
 
+  if (thunar_g_file_is_trash (file->gfile))
+    {
+      count = thunar_trash_count_get ();
+      if (count >= 0)
+        return count;
+    }
+
   return g_file_info_get_attribute_uint32 (file->info,
                                            G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT);
 }
@@ -3293,6 +4416,8 @@ thunar_file_is_renameable (const ThunarFile *file)
   if (file->info == NULL)
     return FALSE;
 
+  thunar_file_ensure_deferred_info (file);
+
   return g_file_info_get_attribute_boolean (file->info,
                                             G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME);
 }
@@ -3307,6 +4432,8 @@ thunar_file_can_be_trashed (const ThunarFile *file)
   if (file->info == NULL)
     return FALSE;
 
+  thunar_file_ensure_deferred_info (file);
+
   return g_file_info_get_attribute_boolean (file->info,
                                             G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH);
 }
@@ -3314,23 +4441,21 @@ thunar_file_can_be_trashed (const ThunarFile *file)
 
 
 /**
- * thunar_file_get_emblem_names:
+ * thunar_file_peek_emblem_names:
  * @file : a #ThunarFile instance.
  *
  * Determines the names of the emblems that should be displayed for
- * @file. The returned list is owned by the caller, but the list
- * items - the name strings - are owned by @file. So the caller
- * must call g_list_free(), but don't g_free() the list items.
+ * @file. The list is computed once and kept until the info of @file
+ * changes, so this is cheap enough to call for every drawn cell.
  *
- * Note that the strings contained in the returned list are
- * not garantied to exist over the next iteration of the main
- * loop. So in case you need the list of emblem names for
- * a longer time, you'll need to take a copy of the strings.
+ * The returned list and its strings are owned by @file and are
+ * only valid until @file emits ::changed. Use
+ * thunar_file_get_emblem_names() to get a list for longer.
  *
  * Return value: the names of the emblems for @file.
  **/
-GList*
-thunar_file_get_emblem_names (ThunarFile *file)
+const GList*
+thunar_file_peek_emblem_names (ThunarFile *file)
 {
   guint32   uid;
   gchar   **emblem_names;
@@ -3342,12 +4467,17 @@ thunar_file_get_emblem_names (ThunarFile *file)
   if (file->info == NULL)
     return NULL;
 
+  /* return the cached emblems */
+  if (G_LIKELY (FLAG_IS_SET (file, THUNAR_FILE_FLAG_EMBLEMS)))
+    return file->emblem_names;
+
   /* determine the custom emblems */
   emblem_names = g_file_info_get_attribute_stringv (file->info, "metadata::emblems");
   if (G_UNLIKELY (emblem_names != NULL))
     {
       for (; *emblem_names != NULL; ++emblem_names)
-        emblems = g_list_append (emblems, *emblem_names);
+        emblems = g_list_prepend (emblems, *emblem_names);
+      emblems = g_list_reverse (emblems);
     }
 
   if (thunar_file_is_symlink (file))
@@ -3355,9 +4485,12 @@ thunar_file_get_emblem_names (ThunarFile *file)
 
   /* determine the user ID of the file owner */
   /* TODO what are we going to do here on non-UNIX systems? */
-  uid = file->info != NULL
-        ? g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_UNIX_UID)
-        : 0;
+  uid = g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_UNIX_UID);
+
+  /* the emblems are asked for while drawing, so wait for the access
+   * attributes of the background query, which emits ::changed */
+  if (FLAG_IS_SET (file, THUNAR_FILE_FLAG_DEFERRED_INFO))
+    goto done;
 
   /* we add "cant-read" if either (a) the file is not readable or (b) a directory, that lacks the
    * x-bit, see https://bugzilla.xfce.org/show_bug.cgi?id=1408 for the details about this change.
@@ -3378,11 +4511,40 @@ thunar_file_get_emblem_names (ThunarFile *file)
       emblems = g_list_prepend (emblems, THUNAR_FILE_EMBLEM_NAME_CANT_WRITE);
     }
 
+done:
+  /* remember the emblems until the info changes */
+  file->emblem_names = emblems;
+  FLAG_SET (file, THUNAR_FILE_FLAG_EMBLEMS);
+
   return emblems;
 }
 
 
 
+/**
+ * thunar_file_get_emblem_names:
+ * @file : a #ThunarFile instance.
+ *
+ * Determines the names of the emblems that should be displayed for
+ * @file. The returned list is owned by the caller, but the list
+ * items - the name strings - are owned by @file. So the caller
+ * must call g_list_free(), but don't g_free() the list items.
+ *
+ * Note that the strings contained in the returned list are
+ * not garantied to exist over the next iteration of the main
+ * loop. So in case you need the list of emblem names for
+ * a longer time, you'll need to take a copy of the strings.
+ *
+ * Return value: the names of the emblems for @file.
+ **/
+GList*
+thunar_file_get_emblem_names (ThunarFile *file)
+{
+  return g_list_copy ((GList *) thunar_file_peek_emblem_names (file));
+}
+
+
+
 /**
  * thunar_file_set_emblem_names:
  * @file         : a #ThunarFile instance.
@@ -3403,6 +4565,9 @@ thunar_file_set_emblem_names (ThunarFile *file,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (G_IS_FILE_INFO (file->info));
 
+  /* don't let the background query override the new emblems */
+  thunar_file_ensure_deferred_info (file);
+
   /* allocate a zero-terminated array for the emblem names */
   emblems = g_new0 (gchar *, g_list_length (emblem_names) + 1);
 
@@ -3422,6 +4587,7 @@ thunar_file_set_emblem_names (ThunarFile *file,
 
   /* set the value in the current info. this call is needed to update the in-memory
    * GFileInfo structure to ensure that the new attribute value is available immediately */
+  thunar_file_emblems_clear (file);
   if (n == 0)
     g_file_info_remove_attribute (file->info, "metadata::emblems");
   else
@@ -3452,7 +4618,9 @@ thunar_file_set_emblem_names (ThunarFile *file,
  *
  * Tries to change the custom icon of the .desktop file referred
  * to by @file. If that fails, %FALSE is returned and the
- * @error is set accordingly.
+ * @error is set accordingly. Local files, except symlinks, are
+ * written in the background, so only a failure to read @file is reported here
+ * and "changed" is emitted once the file was written.
  *
  * Return value: %TRUE if the icon of @file was changed, %FALSE otherwise.
  **/
@@ -3462,6 +4630,10 @@ thunar_file_set_custom_icon (ThunarFile  *file,
                              GError     **error)
 {
   GKeyFile *key_file;
+  GBytes   *bytes;
+  gchar    *contents;
+  gchar    *path;
+  gsize     length;
 
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
@@ -3475,6 +4647,20 @@ thunar_file_set_custom_icon (ThunarFile  *file,
   g_key_file_set_string (key_file, G_KEY_FILE_DESKTOP_GROUP,
                          G_KEY_FILE_DESKTOP_KEY_ICON, custom_icon);
 
+  /* g_file_set_contents() would replace a symlink instead of its target */
+  path = thunar_file_is_symlink (file) ? NULL : g_file_get_path (file->gfile);
+  if (G_LIKELY (path != NULL))
+    {
+      contents = g_key_file_to_data (key_file, &length, NULL);
+      bytes = g_bytes_new_take (contents, length);
+      thunar_state_writer_schedule (path, bytes, 0, thunar_file_custom_icon_written, g_object_ref (file));
+      g_bytes_unref (bytes);
+      g_free (path);
+
+      g_key_file_free (key_file);
+      return TRUE;
+    }
+
   if (thunar_g_file_write_key_file (file->gfile, key_file, NULL, error))
     {
       /* tell everybody that we have changed */
@@ -3491,6 +4677,22 @@ thunar_file_set_custom_icon (ThunarFile  *file,
 }
 
 
+static void
+thunar_file_custom_icon_written (const gchar  *path,
+                                 const GError *error,
+                                 gpointer      user_data)
+{
+  ThunarFile *file = THUNAR_FILE (user_data);
+
+  /* tell everybody that we have changed */
+  if (G_LIKELY (error == NULL))
+    thunar_file_changed (file);
+
+  g_object_unref (file);
+}
+
+
+
 /**
  * thunar_file_is_desktop:
  * @file : a #ThunarFile.
@@ -3514,66 +4716,128 @@ thunar_file_is_desktop (const ThunarFile *file)
 
 
 
-const gchar *
-thunar_file_get_thumbnail_path (ThunarFile *file, ThunarThumbnailSize thumbnail_size)
+static gboolean
+thunar_file_thumbnail_exists (ThunarFile  *file,
+                              const gchar *thumbnail_path)
+{
+  if (thunar_thumbnail_index_contains (thumbnail_path))
+    return TRUE;
+
+  /* the thumbnailer may report a new thumbnail before the index
+   * is notified about it, so check the file system in that case */
+  return thunar_file_get_thumb_state (file) == THUNAR_FILE_THUMB_STATE_READY
+         && g_file_test (thumbnail_path, G_FILE_TEST_EXISTS);
+}
+
+
+
+static gchar *
+thunar_file_build_thumbnail_path (ThunarFile          *file,
+                                  ThunarThumbnailSize  thumbnail_size,
+                                  gboolean             legacy)
 {
   GChecksum *checksum;
   gchar     *filename;
+  gchar     *path;
   gchar     *uri;
 
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+  uri = thunar_file_dup_uri (file);
+  g_checksum_update (checksum, (const guchar *) uri, strlen (uri));
+  g_free (uri);
+
+  filename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
+  g_checksum_free (checksum);
+
+  /* The thumbnail is in the format/location
+   * $XDG_CACHE_HOME/thumbnails/(normal|large|x-large|xx-large)/MD5_Hash_Of_URI.png
+   * for version 0.8.0 if XDG_CACHE_HOME is defined, otherwise
+   * /homedir/.thumbnails/(normal|large)/MD5_Hash_Of_URI.png
+   * will be used, which is also always used for versions prior
+   * to 0.7.0.
+   */
+  if (G_LIKELY (!legacy))
+    {
+      path = g_build_path ("/", g_get_user_cache_dir(),
+                           "thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
+                           filename, NULL);
+    }
+  else
+    {
+      path = g_build_filename (xfce_get_homedir (),
+                               ".thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
+                               filename, NULL);
+    }
+
+  g_free (filename);
+
+  return path;
+}
+
+
+
+/**
+ * thunar_file_dup_thumbnail_path:
+ * @file           : a #ThunarFile.
+ * @thumbnail_size : the #ThunarThumbnailSize of the thumbnail.
+ *
+ * Returns the path of the thumbnail of @file, or %NULL if there
+ * is no thumbnail of that size. Only the location of the thumbnail
+ * is remembered in @file, so the path is built again on every call.
+ *
+ * The caller is responsible to free the returned string using g_free().
+ *
+ * Return value: the path of the thumbnail or %NULL.
+ **/
+gchar *
+thunar_file_dup_thumbnail_path (ThunarFile          *file,
+                                ThunarThumbnailSize  thumbnail_size)
+{
+  gchar *path;
+
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
   /* if the thumbstate is known to be not there, return null */
   if (thunar_file_get_thumb_state (file) == THUNAR_FILE_THUMB_STATE_NONE)
     return NULL;
 
-  if (G_UNLIKELY (file->thumbnail_path == NULL))
+  /* use the location we found before */
+  if (FLAG_IS_SET (file, THUNAR_FILE_FLAG_THUMB_FOUND)
+      && FLAG_GET_THUMB_SIZE (file) == (guint) thumbnail_size)
     {
-      checksum = g_checksum_new (G_CHECKSUM_MD5);
-      if (G_LIKELY (checksum != NULL))
-        {
-          uri = thunar_file_dup_uri (file);
-          g_checksum_update (checksum, (const guchar *) uri, strlen (uri));
-          g_free (uri);
-
-          filename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
-          g_checksum_free (checksum);
-
-          /* The thumbnail is in the format/location
-           * $XDG_CACHE_HOME/thumbnails/(nromal|large)/MD5_Hash_Of_URI.png
-           * for version 0.8.0 if XDG_CACHE_HOME is defined, otherwise
-           * /homedir/.thumbnails/(normal|large)/MD5_Hash_Of_URI.png
-           * will be used, which is also always used for versions prior
-           * to 0.7.0.
-           */
-
-          /* build and check if the thumbnail is in the new location */
-          file->thumbnail_path = g_build_path ("/", g_get_user_cache_dir(),
-                                               "thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
-                                               filename, NULL);
-
-          if (!g_file_test(file->thumbnail_path, G_FILE_TEST_EXISTS))
-            {
-              /* Fallback to old version */
-              g_free(file->thumbnail_path);
-
-              file->thumbnail_path = g_build_filename (xfce_get_homedir (),
-                                                       ".thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
-                                                       filename, NULL);
-
-              if(!g_file_test(file->thumbnail_path, G_FILE_TEST_EXISTS))
-              {
-                /* Thumbnail doesn't exist in either spot */
-                g_free(file->thumbnail_path);
-                file->thumbnail_path = NULL;
-              }
-            }
+      return thunar_file_build_thumbnail_path (file, thumbnail_size,
+                                               FLAG_IS_SET (file, THUNAR_FILE_FLAG_THUMB_LEGACY));
+    }
+
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_THUMB_FOUND);
+
+  /* check if the thumbnail is in the new location */
+  path = thunar_file_build_thumbnail_path (file, thumbnail_size, FALSE);
+  if (thunar_file_thumbnail_exists (file, path))
+    {
+      FLAG_UNSET (file, THUNAR_FILE_FLAG_THUMB_LEGACY);
+    }
+  else
+    {
+      /* Fallback to old version */
+      g_free (path);
+      path = thunar_file_build_thumbnail_path (file, thumbnail_size, TRUE);
 
-          g_free (filename);
+      if (!thunar_file_thumbnail_exists (file, path))
+        {
+          /* Thumbnail doesn't exist in either spot */
+          g_free (path);
+          return NULL;
         }
+
+      FLAG_SET (file, THUNAR_FILE_FLAG_THUMB_LEGACY);
     }
 
-  return file->thumbnail_path;
+  /* remember where the thumbnail is */
+  FLAG_SET_THUMB_SIZE (file, thumbnail_size);
+  FLAG_SET (file, THUNAR_FILE_FLAG_THUMB_FOUND);
+
+  return path;
 }
 
 
@@ -3618,13 +4882,9 @@ thunar_file_set_thumb_state (ThunarFile          *file,
   /* set the new thumbnail state */
   FLAG_SET_THUMB_STATE (file, state);
 
-  /* remove path if the type is not supported */
-  if (state == THUNAR_FILE_THUMB_STATE_NONE
-      && file->thumbnail_path != NULL)
-    {
-      g_free (file->thumbnail_path);
-      file->thumbnail_path = NULL;
-    }
+  /* forget the location if the type is not supported */
+  if (state == THUNAR_FILE_THUMB_STATE_NONE)
+    FLAG_UNSET (file, THUNAR_FILE_FLAG_THUMB_FOUND);
 
   /* if the file has a thumbnail, reload it */
   if (state == THUNAR_FILE_THUMB_STATE_READY)
@@ -3687,7 +4947,7 @@ thunar_file_get_preview_type (const ThunarFile *file)
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), G_FILESYSTEM_PREVIEW_TYPE_NEVER);
   _thunar_return_val_if_fail (G_IS_FILE (file->gfile), G_FILESYSTEM_PREVIEW_TYPE_NEVER);
 
-  info = g_file_query_filesystem_info (file->gfile, G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW, NULL, NULL);
+  info = thunar_mount_health_query_filesystem_info (file->gfile, G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW, NULL, NULL);
   if (G_LIKELY (info != NULL))
     {
       preview = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW);
@@ -3711,10 +4971,11 @@ thunar_file_get_icon_name_for_state (const gchar         *icon_name,
   if (exo_str_is_empty (icon_name))
     return NULL;
 
-  /* check if we have an accept icon for the icon we found */
+  /* check if we have an accept icon for the icon we found, the
+   * name is interned so comparing the pointers is enough */
   if (icon_state != THUNAR_FILE_ICON_STATE_DEFAULT
-      && (strcmp (icon_name, "inode-directory") == 0
-          || strcmp (icon_name, "folder") == 0))
+      && (icon_name == icon_name_inode_directory
+          || icon_name == icon_name_folder))
     {
       if (icon_state == THUNAR_FILE_ICON_STATE_DROP)
         return "folder-drag-accept";
@@ -3746,7 +5007,7 @@ thunar_file_get_icon_name (ThunarFile          *file,
   GFile               *icon_file;
   GIcon               *icon = NULL;
   const gchar * const *names;
-  gchar               *icon_name = NULL;
+  const gchar         *icon_name = NULL;
   gchar               *path;
   const gchar         *special_names[] = { NULL, "folder", NULL };
   guint                i;
@@ -3820,9 +5081,9 @@ thunar_file_get_icon_name (ThunarFile          *file,
            || g_file_has_uri_scheme (file->gfile, "network"))
     {
       /* query the icon (computer:// and network:// backend) */
-      fileinfo = g_file_query_info (file->gfile,
-                                    G_FILE_ATTRIBUTE_STANDARD_ICON,
-                                    G_FILE_QUERY_INFO_NONE, NULL, NULL);
+      fileinfo = thunar_mount_health_query_info (file->gfile,
+                                                 G_FILE_ATTRIBUTE_STANDARD_ICON,
+                                                 G_FILE_QUERY_INFO_NONE, NULL, NULL);
       if (G_LIKELY (fileinfo != NULL))
         {
           /* take the icon from the info */
@@ -3859,7 +5120,7 @@ thunar_file_get_icon_name (ThunarFile          *file,
                 if (*names[i] != '(' /* see gnome bug 688042 */
                     && gtk_icon_theme_has_icon (icon_theme, names[i]))
                   {
-                    icon_name = g_strdup (names[i]);
+                    icon_name = g_intern_string (names[i]);
                     break;
                   }
             }
@@ -3868,7 +5129,11 @@ thunar_file_get_icon_name (ThunarFile          *file,
         {
           icon_file = g_file_icon_get_file (G_FILE_ICON (icon));
           if (icon_file != NULL)
-            icon_name = g_file_get_path (icon_file);
+            {
+              path = g_file_get_path (icon_file);
+              icon_name = g_intern_string (path);
+              g_free (path);
+            }
         }
 
       if (G_LIKELY (icon != NULL))
@@ -3876,14 +5141,13 @@ thunar_file_get_icon_name (ThunarFile          *file,
     }
 
   /* store new name, fallback to legacy names, or empty string to avoid recursion */
-  g_free (file->icon_name);
   if (G_LIKELY (icon_name != NULL))
     file->icon_name = icon_name;
   else if (file->kind == G_FILE_TYPE_DIRECTORY
            && gtk_icon_theme_has_icon (icon_theme, "folder"))
-    file->icon_name = g_strdup ("folder");
+    file->icon_name = g_intern_static_string ("folder");
   else
-    file->icon_name = g_strdup ("");
+    file->icon_name = g_intern_static_string ("");
 
   return thunar_file_get_icon_name_for_state (file->icon_name, icon_state);
 }
@@ -3928,36 +5192,28 @@ thunar_file_get_device_type (ThunarFile *file)
  * once. This also means that you MUST call thunar_file_unwatch()
  * for every thunar_file_watch() invokation, else the application
  * will abort.
+ *
+ * The file is watched through the shared monitor of its parent folder,
+ * see thunar_monitor_pool_subscribe(), so watching many files of the
+ * same folder only costs a single monitor. Only files whose parent
+ * cannot be monitored get a monitor of their own.
  **/
 void
 thunar_file_watch (ThunarFile *file)
 {
   ThunarFileWatch *file_watch;
-  GError          *error = NULL;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   file_watch = g_object_get_qdata (G_OBJECT (file), thunar_file_watch_quark);
   if (file_watch == NULL)
     {
-      file_watch = g_slice_new (ThunarFileWatch);
+      file_watch = g_slice_new0 (ThunarFileWatch);
       file_watch->watch_count = 1;
 
-      /* create a file or directory monitor */
-      file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS |
-                                            G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
-
-      if (G_UNLIKELY (file_watch->monitor == NULL))
-        {
-          g_debug ("Failed to create file monitor: %s", error->message);
-          g_error_free (error);
-          file->no_file_watch = TRUE;
-        }
-      else
-        {
-          /* watch monitor for file changes */
-          g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
-        }
+      /* watch the parent folder or the file itself */
+      if (!thunar_file_watch_attach (file, file_watch))
+        file->no_file_watch = TRUE;
 
       /* attach to file */
       g_object_set_qdata_full (G_OBJECT (file), thunar_file_watch_quark, file_watch, thunar_file_watch_destroyed);
@@ -3965,7 +5221,7 @@ thunar_file_watch (ThunarFile *file)
   else if (G_LIKELY (!file->no_file_watch))
     {
       /* increase watch count */
-      _thunar_return_if_fail (G_IS_FILE_MONITOR (file_watch->monitor));
+      _thunar_return_if_fail (file_watch->parent_watch != NULL || G_IS_FILE_MONITOR (file_watch->monitor));
       file_watch->watch_count++;
     }
 }
@@ -4065,7 +5321,8 @@ thunar_file_reload_idle (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  g_idle_add (thunar_file_reload_cb_once, file);
+  /* many files are reloaded at once, so they share the scheduler's source */
+  thunar_scheduler_add_idle (G_PRIORITY_DEFAULT_IDLE, thunar_file_reload_cb_once, file, NULL);
 }
 
 
@@ -4084,10 +5341,10 @@ thunar_file_reload_idle_unref (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
-                   thunar_file_reload_cb_once,
-                   file,
-                   (GDestroyNotify) g_object_unref);
+  thunar_scheduler_add_idle (G_PRIORITY_DEFAULT_IDLE,
+                             thunar_file_reload_cb_once,
+                             file,
+                             (GDestroyNotify) g_object_unref);
 }
 
 
@@ -4132,65 +5389,214 @@ thunar_file_destroy (ThunarFile *file)
  * @a : the first #ThunarFile.
  * @b : the second #ThunarFile.
  *
- * Compares items so that directories come before files and ancestors come
- * before descendants.
+ * Compares items so that directories come before files and ancestors come
+ * before descendants.
+ *
+ * Return value: -1 if @file_a should be sorted before @file_b, 1 if
+ *               @file_b should be sorted before @file_a, 0 if equal.
+ **/
+gint
+thunar_file_compare_by_type (ThunarFile *a,
+                             ThunarFile *b)
+{
+  GFile *file_a;
+  GFile *file_b;
+  GFile *parent_a;
+  GFile *parent_b;
+  gint   ret = 0;
+
+  file_a = thunar_file_get_file (a);
+  file_b = thunar_file_get_file (b);
+
+  /* check whether the files are equal */
+  if (g_file_equal (file_a, file_b))
+    return 0;
+
+  /* directories always come first */
+  if (a->kind == G_FILE_TYPE_DIRECTORY
+      && b->kind != G_FILE_TYPE_DIRECTORY)
+    {
+      return -1;
+    }
+  if (a->kind != G_FILE_TYPE_DIRECTORY
+      && b->kind == G_FILE_TYPE_DIRECTORY)
+    {
+      return 1;
+    }
+
+  /* ancestors come first */
+  if (g_file_has_prefix (file_b, file_a))
+    return -1;
+  if (g_file_has_prefix (file_a, file_b))
+    return 1;
+
+  parent_a = g_file_get_parent (file_a);
+  parent_b = g_file_get_parent (file_b);
+
+  if (g_file_equal (parent_a, parent_b))
+    {
+      /* compare siblings by their display name */
+      ret = g_utf8_collate (a->display_name,
+                            b->display_name);
+    }
+  /* again, ancestors come first */
+  else if (g_file_has_prefix (file_b, parent_a))
+      ret = -1;
+  else if (g_file_has_prefix (file_a, parent_b))
+      ret = 1;
+
+  g_object_unref (parent_a);
+  g_object_unref (parent_b);
+  return ret;
+}
+
+
+
+/* checks whether @name is plain ASCII and, if so, whether it contains
+ * uppercase letters. For ASCII, casefolding and NFKC normalization only
+ * map 'A'-'Z' to 'a'-'z', so both can be done without the Unicode tables.
+ * The check is done a word at a time, most names are checked in a few steps */
+static gboolean
+thunar_file_name_is_ascii (const gchar *name,
+                           gsize        length,
+                           gboolean    *has_upper)
+{
+  const guint64 ones = G_GUINT64_CONSTANT (0x0101010101010101);
+  const guint64 high = G_GUINT64_CONSTANT (0x8080808080808080);
+  guint64       upper = 0;
+  guint64       word;
+  gsize         n;
+
+  for (n = 0; n + sizeof (word) <= length; n += sizeof (word))
+    {
+      memcpy (&word, name + n, sizeof (word));
+      if ((word & high) != 0)
+        return FALSE;
+
+      /* with all high bits clear, adding cannot carry into the next byte:
+       * the high bit of a byte in 'A'-'Z' is set after adding 0x80 - 'A',
+       * but not after adding 0x80 - 'Z' - 1 */
+      upper |= (word + ones * (0x80 - 'A')) & ~(word + ones * (0x80 - 'Z' - 1)) & high;
+    }
+
+  for (; n < length; ++n)
+    {
+      if ((guchar) name[n] >= 0x80)
+        return FALSE;
+      if (name[n] >= 'A' && name[n] <= 'Z')
+        upper = 1;
+    }
+
+  *has_upper = (upper != 0);
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_file_prepare_collate_keys:
+ * @file : a #ThunarFile.
+ *
+ * Creates the collation keys thunar_file_compare_by_name() uses for
+ * @file. They are otherwise created on the first comparison, so this
+ * must be called before files are compared from another thread.
+ **/
+void
+thunar_file_prepare_collate_keys (ThunarFile *file)
+{
+  gboolean has_upper;
+  gchar   *casefold;
+  gsize    length;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  if (G_LIKELY (file->collate_key != NULL))
+    return;
+
+  /* create case sensitive collation key */
+  length = strlen (file->display_name);
+  file->collate_key = g_utf8_collate_key_for_filename (file->display_name, length);
+
+  /* lowercase the display name, most names are ASCII and
+   * casefolding those is the same as lowering them */
+  if (thunar_file_name_is_ascii (file->display_name, length, &has_upper))
+    {
+      if (!has_upper)
+        {
+          /* nothing to fold, so the keys are equal */
+          file->collate_key_nocase = file->collate_key;
+          return;
+        }
+
+      casefold = g_ascii_strdown (file->display_name, length);
+    }
+  else
+    {
+      casefold = g_utf8_casefold (file->display_name, length);
+    }
+
+  /* if the lowercase name is equal, only peek the already hash key */
+  if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
+    file->collate_key_nocase = g_utf8_collate_key_for_filename (casefold, -1);
+  else
+    file->collate_key_nocase = file->collate_key;
+
+  /* cleanup */
+  g_free (casefold);
+}
+
+
+
+/**
+ * thunar_file_get_casefold_name:
+ * @file : a #ThunarFile.
+ *
+ * Returns the display name of @file normalized and casefolded the way
+ * the interactive search of the views compares names. The name is
+ * created once and kept until the file information is reloaded.
  *
- * Return value: -1 if @file_a should be sorted before @file_b, 1 if
- *               @file_b should be sorted before @file_a, 0 if equal.
+ * This function may only be used from the main thread.
+ *
+ * Return value: the casefolded display name of @file.
  **/
-gint
-thunar_file_compare_by_type (ThunarFile *a,
-                             ThunarFile *b)
+const gchar *
+thunar_file_get_casefold_name (ThunarFile *file)
 {
-  GFile *file_a;
-  GFile *file_b;
-  GFile *parent_a;
-  GFile *parent_b;
-  gint   ret = 0;
+  gboolean has_upper;
+  gchar   *normalized;
+  gsize    length;
 
-  file_a = thunar_file_get_file (a);
-  file_b = thunar_file_get_file (b);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
-  /* check whether the files are equal */
-  if (g_file_equal (file_a, file_b))
-    return 0;
+  if (G_LIKELY (file->casefold_name != NULL))
+    return file->casefold_name;
 
-  /* directories always come first */
-  if (a->kind == G_FILE_TYPE_DIRECTORY
-      && b->kind != G_FILE_TYPE_DIRECTORY)
+  /* ASCII names need neither normalization nor Unicode casefolding */
+  length = strlen (file->display_name);
+  if (thunar_file_name_is_ascii (file->display_name, length, &has_upper))
     {
-      return -1;
+      if (has_upper)
+        file->casefold_name = g_ascii_strdown (file->display_name, length);
+      else
+        file->casefold_name = file->display_name;
+      return file->casefold_name;
     }
-  if (a->kind != G_FILE_TYPE_DIRECTORY
-      && b->kind == G_FILE_TYPE_DIRECTORY)
+
+  normalized = g_utf8_normalize (file->display_name, length, G_NORMALIZE_ALL);
+  if (G_LIKELY (normalized != NULL))
     {
-      return 1;
+      file->casefold_name = g_utf8_casefold (normalized, -1);
+      g_free (normalized);
     }
 
-  /* ancestors come first */
-  if (g_file_has_prefix (file_b, file_a))
-    return -1;
-  if (g_file_has_prefix (file_a, file_b))
-    return 1;
-
-  parent_a = g_file_get_parent (file_a);
-  parent_b = g_file_get_parent (file_b);
-
-  if (g_file_equal (parent_a, parent_b))
+  /* only keep a copy if the name changed */
+  if (file->casefold_name == NULL || strcmp (file->casefold_name, file->display_name) == 0)
     {
-      /* compare siblings by their display name */
-      ret = g_utf8_collate (a->display_name,
-                            b->display_name);
+      g_free (file->casefold_name);
+      file->casefold_name = file->display_name;
     }
-  /* again, ancestors come first */
-  else if (g_file_has_prefix (file_b, parent_a))
-      ret = -1;
-  else if (g_file_has_prefix (file_a, parent_b))
-      ret = 1;
 
-  g_object_unref (parent_a);
-  g_object_unref (parent_b);
-  return ret;
+  return file->casefold_name;
 }
 
 
@@ -4222,6 +5628,12 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_b), 0);
 #endif
 
+  /* the keys are created on demand, most files are never compared by name */
+  if (G_UNLIKELY (file_a->collate_key == NULL))
+    thunar_file_prepare_collate_keys ((ThunarFile *) file_a);
+  if (G_UNLIKELY (file_b->collate_key == NULL))
+    thunar_file_prepare_collate_keys ((ThunarFile *) file_b);
+
   /* case insensitive checking */
   if (G_LIKELY (!case_sensitive))
     result = g_strcmp0 (file_a->collate_key_nocase, file_b->collate_key_nocase);
@@ -4242,7 +5654,17 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
 
 
 
-static gboolean
+/**
+ * thunar_file_same_filesystem:
+ * @file_a : a #ThunarFile instance.
+ * @file_b : another #ThunarFile instance.
+ *
+ * Checks whether @file_a and @file_b are on the same filesystem,
+ * using only the information already loaded for both files.
+ *
+ * Return value: %TRUE if both files are on the same filesystem.
+ **/
+gboolean
 thunar_file_same_filesystem (const ThunarFile *file_a,
                              const ThunarFile *file_b)
 {
@@ -4289,36 +5711,231 @@ thunar_file_same_filesystem (const ThunarFile *file_a,
 ThunarFile *
 thunar_file_cache_lookup (const GFile *file)
 {
-  GWeakRef   *ref;
-  ThunarFile *cached_file;
+  ThunarFileCacheShard *shard;
+  GWeakRef             *ref;
+  ThunarFile           *cached_file;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
 
-  G_LOCK (file_cache_mutex);
-
-  /* allocate the ThunarFile cache on-demand */
-  if (G_UNLIKELY (file_cache == NULL))
-    {
-      file_cache = g_hash_table_new_full (g_file_hash,
-                                          (GEqualFunc) g_file_equal,
-                                          (GDestroyNotify) g_object_unref,
-                                          (GDestroyNotify) weak_ref_free);
-    }
+  shard = thunar_file_cache_lock (file);
 
-  ref = g_hash_table_lookup (file_cache, file);
+  ref = g_hash_table_lookup (shard->files, file);
 
   if (ref == NULL)
     cached_file = NULL;
   else
     cached_file = g_weak_ref_get (ref);
 
-  G_UNLOCK (file_cache_mutex);
+  shard->n_lookups++;
+  if (cached_file != NULL)
+    shard->n_hits++;
+
+  thunar_file_cache_unlock (shard);
 
   return cached_file;
 }
 
 
 
+/**
+ * thunar_file_cache_get_stats:
+ * @n_files     : return location for the number of cached files or %NULL.
+ * @n_locks     : return location for the number of cache accesses or %NULL.
+ * @n_contended : return location for the number of accesses that had to
+ *                wait for another thread or %NULL.
+ * @n_lookups   : return location for the number of thunar_file_cache_lookup()
+ *                calls or %NULL.
+ * @n_hits      : return location for the number of those lookups that found
+ *                a file or %NULL.
+ *
+ * Reports how the #ThunarFile cache is used, to tell whether threads
+ * creating files get in each other's way. The numbers are read without
+ * locking, so they are only approximate while other threads use the cache.
+ **/
+void
+thunar_file_cache_get_stats (guint   *n_files,
+                             guint64 *n_locks,
+                             guint64 *n_contended,
+                             guint64 *n_lookups,
+                             guint64 *n_hits)
+{
+  guint64 locks = 0;
+  guint64 contended = 0;
+  guint64 lookups = 0;
+  guint64 hits = 0;
+  guint   files = 0;
+  guint   n;
+
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      if (file_cache[n].files != NULL)
+        files += g_hash_table_size (file_cache[n].files);
+      locks += file_cache[n].n_locks;
+      contended += file_cache[n].n_contended;
+      lookups += file_cache[n].n_lookups;
+      hits += file_cache[n].n_hits;
+    }
+
+  if (n_files != NULL)
+    *n_files = files;
+  if (n_locks != NULL)
+    *n_locks = locks;
+  if (n_contended != NULL)
+    *n_contended = contended;
+  if (n_lookups != NULL)
+    *n_lookups = lookups;
+  if (n_hits != NULL)
+    *n_hits = hits;
+}
+
+
+
+/**
+ * thunar_file_cache_get_memory:
+ * @n_files      : return location for the number of cached files.
+ * @n_attributes : return location for the number of attributes of their infos.
+ * @n_bytes      : return location for the estimated memory of the files.
+ *
+ * Estimates the memory held by the cached #ThunarFile<!---->s, their
+ * #GFileInfo<!---->s and their strings. The interned strings and the
+ * #GFile<!---->s, which are shared with the rest of the application,
+ * are not included.
+ *
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_file_cache_get_memory (guint   *n_files,
+                              guint64 *n_attributes,
+                              guint64 *n_bytes)
+{
+  ThunarFileCacheShard *shard;
+  GHashTableIter        iter;
+  ThunarFile           *file;
+  GWeakRef             *ref;
+  GList                *files = NULL;
+  GList                *lp;
+  guint64               attributes = 0;
+  guint64               bytes = 0;
+  guint                 count = 0;
+  guint                 n_info_attributes;
+  guint                 n;
+
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      shard = &file_cache[n];
+      if (shard->files == NULL)
+        continue;
+
+      /* collect the files still alive, measuring them happens unlocked */
+      g_mutex_lock (&shard->mutex);
+      g_hash_table_iter_init (&iter, shard->files);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer) &ref))
+        {
+          file = g_weak_ref_get (ref);
+          if (G_LIKELY (file != NULL))
+            files = g_list_prepend (files, file);
+
+          /* the table entry and the weak reference */
+          bytes += 3 * sizeof (gpointer) + sizeof (guint) + sizeof (GWeakRef);
+        }
+      g_mutex_unlock (&shard->mutex);
+    }
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      file = THUNAR_FILE (lp->data);
+      count++;
+
+      bytes += sizeof (ThunarFile);
+      if (file->info != NULL)
+        {
+          bytes += thunar_g_file_info_get_memory (file->info, &n_info_attributes);
+          attributes += n_info_attributes;
+        }
+      if (file->metadata_changes != NULL)
+        bytes += thunar_g_file_info_get_memory (file->metadata_changes, NULL);
+
+      if (file->basename != NULL)
+        bytes += strlen (file->basename) + 1;
+      if (file->display_name != NULL && file->display_name != file->basename)
+        bytes += strlen (file->display_name) + 1;
+      if (file->custom_icon_name != NULL)
+        bytes += strlen (file->custom_icon_name) + 1;
+      if (file->collate_key != NULL)
+        bytes += strlen (file->collate_key) + 1;
+      if (file->collate_key_nocase != NULL && file->collate_key_nocase != file->collate_key)
+        bytes += strlen (file->collate_key_nocase) + 1;
+      if (file->casefold_name != NULL && file->casefold_name != file->display_name)
+        bytes += strlen (file->casefold_name) + 1;
+    }
+
+  thunar_g_list_free_full (files);
+
+  if (n_files != NULL)
+    *n_files = count;
+  if (n_attributes != NULL)
+    *n_attributes = attributes;
+  if (n_bytes != NULL)
+    *n_bytes = bytes;
+}
+
+
+
+/**
+ * thunar_file_cache_trim:
+ *
+ * Releases the data of all cached #ThunarFile<!---->s that is only kept
+ * to speed things up and is recomputed when needed again, like the
+ * collate keys used for sorting by name.
+ *
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_file_cache_trim (void)
+{
+  ThunarFileCacheShard *shard;
+  GHashTableIter        iter;
+  ThunarFile           *file;
+  GWeakRef             *ref;
+  GList                *files = NULL;
+  GList                *lp;
+  guint                 n;
+
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      shard = &file_cache[n];
+      if (shard->files == NULL)
+        continue;
+
+      /* collect the files still alive, releasing them happens unlocked */
+      g_mutex_lock (&shard->mutex);
+      g_hash_table_iter_init (&iter, shard->files);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer) &ref))
+        {
+          file = g_weak_ref_get (ref);
+          if (G_LIKELY (file != NULL))
+            files = g_list_prepend (files, file);
+        }
+      g_mutex_unlock (&shard->mutex);
+    }
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      file = THUNAR_FILE (lp->data);
+
+      if (file->collate_key_nocase != file->collate_key)
+        g_free (file->collate_key_nocase);
+      file->collate_key_nocase = NULL;
+
+      g_free (file->collate_key);
+      file->collate_key = NULL;
+    }
+
+  thunar_g_list_free_full (files);
+}
+
+
+
 gchar *
 thunar_file_cached_display_name (const GFile *file)
 {
@@ -4344,11 +5961,57 @@ thunar_file_cached_display_name (const GFile *file)
 
 
 
-static gint
-compare_app_infos (gconstpointer a,
-                   gconstpointer b)
+/**
+ * thunar_file_list_get_content_types_key:
+ * @file_list : a #GList of #ThunarFile<!---->s.
+ *
+ * Returns a string that is the same for all lists with the same set of
+ * content types, no matter how many files they contain and in which
+ * order. This can be used to remember results that only depend on the
+ * content types of the files.
+ *
+ * The caller is responsible to free the returned string using g_free().
+ *
+ * Return value: the key for @file_list or %NULL if the content type of
+ *               any file is unknown.
+ **/
+gchar*
+thunar_file_list_get_content_types_key (GList *file_list)
 {
-  return g_app_info_equal (G_APP_INFO (a), G_APP_INFO (b)) ? 0 : 1;
+  GHashTable  *content_types;
+  const gchar *previous_type = NULL;
+  const gchar *current_type;
+  GString     *key;
+  GList       *types;
+  GList       *lp;
+
+  content_types = g_hash_table_new (g_str_hash, g_str_equal);
+  for (lp = file_list; lp != NULL; lp = lp->next)
+    {
+      current_type = thunar_file_get_content_type (lp->data);
+      if (G_UNLIKELY (current_type == NULL))
+        {
+          g_hash_table_destroy (content_types);
+          return NULL;
+        }
+
+      /* selections usually contain runs of the same type */
+      if (current_type != previous_type)
+        g_hash_table_add (content_types, (gpointer) current_type);
+      previous_type = current_type;
+    }
+
+  types = g_list_sort (g_hash_table_get_keys (content_types), (GCompareFunc) strcmp);
+  key = g_string_new (NULL);
+  for (lp = types; lp != NULL; lp = lp->next)
+    {
+      g_string_append (key, lp->data);
+      g_string_append_c (key, '\n');
+    }
+  g_list_free (types);
+  g_hash_table_destroy (content_types);
+
+  return g_string_free (key, FALSE);
 }
 
 
@@ -4360,6 +6023,9 @@ compare_app_infos (gconstpointer a,
  * Returns the #GList of #GAppInfo<!---->s that can be used to open
  * all #ThunarFile<!---->s in the given @file_list.
  *
+ * The applications for each content type are answered from the
+ * index of thunar_app_index_get_for_type().
+ *
  * The caller is responsible to free the returned list using something like:
  * <informalexample><programlisting>
  * g_list_free_full (list, g_object_unref);
@@ -4371,85 +6037,40 @@ compare_app_infos (gconstpointer a,
 GList*
 thunar_file_list_get_applications (GList *file_list)
 {
-  GList       *applications = NULL;
-  GList       *list;
+  GList       *applications;
+  GList       *content_types = NULL;
   GList       *next;
   GList       *ap;
   GList       *lp;
-  GAppInfo    *default_application;
   const gchar *previous_type = NULL;
   const gchar *current_type;
 
-  /* determine the set of applications that can open all files */
+  /* collect the content types of the files */
   for (lp = file_list; lp != NULL; lp = lp->next)
     {
       current_type = thunar_file_get_content_type (lp->data);
 
-      /* no need to check anything if this file has the same mimetype as the previous file */
-      if (current_type != NULL && previous_type != NULL)
-        if (G_LIKELY (g_content_type_equals (previous_type, current_type)))
-          continue;
-
-      /* store the previous type */
-      previous_type = current_type;
-
-      /* determine the list of applications that can open this file */
-      if (G_UNLIKELY (current_type != NULL))
-        {
-          list = g_app_info_get_all_for_type (current_type);
-
-          /* move any default application in front of the list */
-          default_application = g_app_info_get_default_for_type (current_type, FALSE);
-          if (G_LIKELY (default_application != NULL))
-            {
-              for (ap = list; ap != NULL; ap = ap->next)
-                {
-                  if (g_app_info_equal (ap->data, default_application))
-                    {
-                      g_object_unref (ap->data);
-                      list = g_list_delete_link (list, ap);
-                      break;
-                    }
-                }
-              list = g_list_prepend (list, default_application);
-            }
-        }
-      else
-        list = NULL;
-
-      if (G_UNLIKELY (applications == NULL))
+      /* no application can open a file of unknown type */
+      if (G_UNLIKELY (current_type == NULL))
         {
-          /* first file, so just use the applications list */
-          applications = list;
+          g_list_free (content_types);
+          return NULL;
         }
-      else
-        {
-          /* keep only the applications that are also present in list */
-          for (ap = applications; ap != NULL; ap = next)
-            {
-              /* grab a pointer on the next application */
-              next = ap->next;
-
-              /* check if the application is present in list */
-              if (g_list_find_custom (list, ap->data, compare_app_infos) == NULL)
-                {
-                  /* drop our reference on the application */
-                  g_object_unref (G_OBJECT (ap->data));
-
-                  /* drop this application from the list */
-                  applications = g_list_delete_link (applications, ap);
-                }
-            }
 
-          /* release the list of applications for this file */
-          g_list_free_full (list, g_object_unref);
-        }
+      /* no need to check anything if this file has the same mimetype as the previous file */
+      if (previous_type != NULL && g_content_type_equals (previous_type, current_type))
+        continue;
 
-      /* check if the set is still not empty */
-      if (G_LIKELY (applications == NULL))
-        break;
+      /* store the previous type */
+      previous_type = current_type;
+      content_types = g_list_prepend (content_types, (gpointer) current_type);
     }
 
+  /* determine the set of applications that can open all files */
+  content_types = g_list_reverse (content_types);
+  applications = thunar_app_index_get_for_types (content_types);
+  g_list_free (content_types);
+
   /* remove hidden applications */
   for (ap = applications; ap != NULL; ap = next)
     {
@@ -4497,6 +6118,68 @@ thunar_file_list_to_thunar_g_file_list (GList *file_list)
 
 
 
+/**
+ * thunar_file_list_to_uri_list:
+ * @file_list     : a #GList of #ThunarFile<!---->s.
+ * @length_return : return location for the length of the result.
+ *
+ * Serializes the @file_list to a text/uri-list, with every URI
+ * terminated by a CRLF, ready to be handed to a #GtkSelectionData.
+ * The string is allocated once, so this is cheap even for huge
+ * lists.
+ *
+ * The caller is responsible to free the returned string using
+ * g_free() when no longer needed.
+ *
+ * Return value: the text/uri-list for @file_list.
+ **/
+gchar*
+thunar_file_list_to_uri_list (GList *file_list,
+                              gsize *length_return)
+{
+  GString *string;
+  gchar   *uri;
+  GList   *lp;
+
+  _thunar_return_val_if_fail (length_return != NULL, NULL);
+
+  /* allocate the string once for the usual length of an uri */
+  string = g_string_sized_new (g_list_length (file_list) * 64);
+
+  for (lp = file_list; lp != NULL; lp = lp->next)
+    {
+      uri = g_file_get_uri (THUNAR_FILE (lp->data)->gfile);
+      string = g_string_append (string, uri);
+      string = g_string_append (string, "\r\n");
+      g_free (uri);
+    }
+
+  *length_return = string->len;
+
+  return g_string_free (string, FALSE);
+}
+
+
+
+static gboolean
+thunar_file_metadata_setting_attribute (const gchar *setting_name,
+                                        gchar       *attr_name)
+{
+  gsize length = strlen (setting_name);
+
+  if (G_UNLIKELY (sizeof (THUNAR_FILE_METADATA_SETTING_PREFIX) + length > THUNAR_FILE_METADATA_SETTING_MAX))
+    return FALSE;
+
+  /* the settings are looked up whenever a folder is shown, so don't
+   * allocate the attribute name */
+  memcpy (attr_name, THUNAR_FILE_METADATA_SETTING_PREFIX, sizeof (THUNAR_FILE_METADATA_SETTING_PREFIX) - 1);
+  memcpy (attr_name + sizeof (THUNAR_FILE_METADATA_SETTING_PREFIX) - 1, setting_name, length + 1);
+
+  return TRUE;
+}
+
+
+
 /**
  * thunar_file_get_metadata_setting:
  * @file         : a #ThunarFile instance.
@@ -4505,14 +6188,16 @@ thunar_file_list_to_thunar_g_file_list (GList *file_list)
  * Gets the stored value of the metadata setting @setting_name for @file. Returns %NULL
  * if there is no stored setting.
  *
+ * The settings are part of the #GFileInfo of @file, so this does not
+ * ask the metadata store.
+ *
  * Return value: (transfer none): the stored value of the setting for @file, or %NULL
  **/
 const gchar*
 thunar_file_get_metadata_setting (ThunarFile  *file,
                                   const gchar *setting_name)
 {
-  gchar       *attr_name;
-  const gchar *attr_value;
+  gchar attr_name[THUNAR_FILE_METADATA_SETTING_MAX];
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
@@ -4520,26 +6205,23 @@ thunar_file_get_metadata_setting (ThunarFile  *file,
     return NULL;
 
   /* convert the setting name to an attribute name */
-  attr_name = g_strdup_printf ("metadata::thunar-%s", setting_name);
+  if (!thunar_file_metadata_setting_attribute (setting_name, attr_name))
+    return NULL;
 
-  if (!g_file_info_has_attribute (file->info, attr_name))
-    {
-      g_free (attr_name);
-      return NULL;
-    }
+  thunar_file_ensure_deferred_info (file);
 
-  attr_value = g_file_info_get_attribute_string (file->info, attr_name);
-  g_free (attr_name);
+  if (!g_file_info_has_attribute (file->info, attr_name))
+    return NULL;
 
-  return attr_value;
+  return g_file_info_get_attribute_string (file->info, attr_name);
 }
 
 
 
 static void
-thunar_file_set_metadata_setting_finish (GObject      *source_object,
-                                         GAsyncResult *result,
-                                         gpointer      user_data)
+thunar_file_metadata_finish (GObject      *source_object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
 {
   ThunarFile *file = THUNAR_FILE (user_data);
   GError     *error = NULL;
@@ -4551,6 +6233,51 @@ thunar_file_set_metadata_setting_finish (GObject      *source_object,
     }
 
   thunar_file_changed (file);
+  g_object_unref (file);
+}
+
+
+
+static gboolean
+thunar_file_metadata_flush (gpointer user_data)
+{
+  ThunarFile *file = THUNAR_FILE (user_data);
+
+  /* write all changed settings back in one call, instead of asking
+   * the metadata store once for every setting */
+  g_file_set_attributes_async (file->gfile, file->metadata_changes,
+                               G_FILE_QUERY_INFO_NONE,
+                               G_PRIORITY_DEFAULT,
+                               NULL,
+                               thunar_file_metadata_finish,
+                               g_object_ref (file));
+
+  g_clear_object (&file->metadata_changes);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_file_metadata_queue (ThunarFile  *file,
+                            const gchar *attr_name,
+                            const gchar *attr_value)
+{
+  /* settings are often changed together, e.g. the sort column and
+   * order, so they are written back once the main loop is idle */
+  if (file->metadata_changes == NULL)
+    {
+      file->metadata_changes = g_file_info_new ();
+      g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, thunar_file_metadata_flush,
+                       g_object_ref (file), g_object_unref);
+    }
+
+  /* an invalid attribute removes the setting */
+  if (attr_value != NULL)
+    g_file_info_set_attribute_string (file->metadata_changes, attr_name, attr_value);
+  else
+    g_file_info_set_attribute (file->metadata_changes, attr_name, G_FILE_ATTRIBUTE_TYPE_INVALID, NULL);
 }
 
 
@@ -4562,21 +6289,24 @@ thunar_file_set_metadata_setting_finish (GObject      *source_object,
  * @setting_value : the value to set
  *
  * Sets the setting @setting_name of @file to @setting_value and stores it in
- * the @file<!---->s metadata.
+ * the @file<!---->s metadata. Settings changed at the same time are stored
+ * together.
  **/
 void
 thunar_file_set_metadata_setting (ThunarFile  *file,
                                   const gchar *setting_name,
                                   const gchar *setting_value)
 {
-  GFileInfo *info;
-  gchar     *attr_name;
+  gchar attr_name[THUNAR_FILE_METADATA_SETTING_MAX];
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (G_IS_FILE_INFO (file->info));
 
   /* convert the setting name to an attribute name */
-  attr_name = g_strdup_printf ("metadata::thunar-%s", setting_name);
+  if (!thunar_file_metadata_setting_attribute (setting_name, attr_name))
+    return;
+
+  thunar_file_ensure_deferred_info (file);
 
   /* set the value in the current info. this call is needed to update the in-memory
    * GFileInfo structure to ensure that the new attribute value is available immediately */
@@ -4584,16 +6314,7 @@ thunar_file_set_metadata_setting (ThunarFile  *file,
 
   /* send meta data to the daemon. this call is needed to store the new value of
    * the attribute in the file system */
-  info = g_file_info_new ();
-  g_file_info_set_attribute_string (info, attr_name, setting_value);
-  g_file_set_attributes_async (file->gfile, info,
-                               G_FILE_QUERY_INFO_NONE,
-                               G_PRIORITY_DEFAULT,
-                               NULL,
-                               thunar_file_set_metadata_setting_finish,
-                               file);
-  g_free (attr_name);
-  g_object_unref (G_OBJECT (info));
+  thunar_file_metadata_queue (file, attr_name, setting_value);
 }
 
 
@@ -4612,16 +6333,15 @@ thunar_file_clear_directory_specific_settings (ThunarFile *file)
   if (file->info == NULL)
     return;
 
+  thunar_file_ensure_deferred_info (file);
+
   g_file_info_remove_attribute (file->info, "metadata::thunar-view-type");
   g_file_info_remove_attribute (file->info, "metadata::thunar-sort-column");
   g_file_info_remove_attribute (file->info, "metadata::thunar-sort-order");
 
-  g_file_set_attribute (file->gfile, "metadata::thunar-view-type", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  g_file_set_attribute (file->gfile, "metadata::thunar-sort-column", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  g_file_set_attribute (file->gfile, "metadata::thunar-sort-order", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  thunar_file_metadata_queue (file, "metadata::thunar-view-type", NULL);
+  thunar_file_metadata_queue (file, "metadata::thunar-sort-column", NULL);
+  thunar_file_metadata_queue (file, "metadata::thunar-sort-order", NULL);
 
   thunar_file_changed (file);
 }
@@ -4644,6 +6364,8 @@ thunar_file_has_directory_specific_settings (ThunarFile *file)
   if (file->info == NULL)
     return FALSE;
 
+  thunar_file_ensure_deferred_info (file);
+
   if (g_file_info_has_attribute (file->info, "metadata::thunar-view-type"))
     return TRUE;
   if (g_file_info_has_attribute (file->info, "metadata::thunar-sort-column"))
@@ -102,6 +102,32 @@ typedef enum /*< flags >*/
 #define THUNAR_FILE_EMBLEM_NAME_CANT_WRITE    "emblem-nowrite"
 #define THUNAR_FILE_EMBLEM_NAME_DESKTOP       "emblem-desktop"
 
+/*
+ * The attributes of THUNARX_FILE_INFO_NAMESPACE that are not needed to
+ * show a file in a folder listing. Folders are enumerated with
+ * THUNAR_FILE_INFO_NAMESPACE_FAST, and the deferred attributes are
+ * queried in the background or once they are asked for. The execute
+ * permission is needed to load the name and icon of desktop files.
+ */
+#define THUNAR_FILE_INFO_NAMESPACE_DEFERRED \
+  "access::can-read,access::can-write,access::can-delete," \
+  "access::can-rename,access::can-trash," \
+  "preview::*," \
+  "metadata::emblems," \
+  "metadata::thunar-view-type," \
+  "metadata::thunar-sort-column,metadata::thunar-sort-order"
+
+#define THUNAR_FILE_INFO_NAMESPACE_FAST \
+  "access::can-execute," \
+  "id::filesystem," \
+  "mountable::can-mount,standard::target-uri," \
+  "standard::type,standard::is-hidden,standard::is-backup," \
+  "standard::is-symlink,standard::name,standard::display-name," \
+  "standard::size,standard::symlink-target," \
+  "time::*," \
+  "trash::*," \
+  "unix::gid,unix::uid,unix::mode"
+
 
 
 /**
@@ -125,6 +151,10 @@ ThunarFile       *thunar_file_get                        (GFile
 ThunarFile       *thunar_file_get_with_info              (GFile                  *file,
                                                           GFileInfo              *info,
                                                           gboolean                not_mounted);
+ThunarFile       *thunar_file_get_with_snapshot_info     (GFile                  *file,
+                                                          GFileInfo              *info);
+ThunarFile       *thunar_file_get_with_fast_info         (GFile                  *file,
+                                                          GFileInfo              *info);
 ThunarFile       *thunar_file_get_for_uri                (const gchar            *uri,
                                                           GError                **error);
 void              thunar_file_get_async                  (GFile                  *location,
@@ -136,6 +166,10 @@ GFile            *thunar_file_get_file                   (const ThunarFile
 
 GFileInfo        *thunar_file_get_info                   (const ThunarFile       *file) G_GNUC_PURE;
 
+gboolean          thunar_file_has_deferred_info          (const ThunarFile       *file);
+void              thunar_file_set_deferred_info          (ThunarFile             *file,
+                                                          GFileInfo              *info);
+
 ThunarFile       *thunar_file_get_parent                 (const ThunarFile       *file,
                                                           GError                **error);
 
@@ -159,6 +193,10 @@ gboolean          thunar_file_rename                     (ThunarFile
                                                           gboolean                called_from_job,
                                                           GError                **error);
 
+void              thunar_file_finish_rename              (ThunarFile             *file,
+                                                          GFile                  *renamed_file,
+                                                          GFileInfo              *info);
+
 GdkDragAction     thunar_file_accepts_drop               (ThunarFile             *file,
                                                           GList                  *path_list,
                                                           GdkDragContext         *context,
@@ -186,6 +224,12 @@ ThunarUser       *thunar_file_get_user                   (const ThunarFile
 
 const gchar      *thunar_file_get_content_type           (ThunarFile             *file);
 gboolean          thunar_file_load_content_type          (ThunarFile             *file);
+gboolean          thunar_file_has_content_type           (const ThunarFile       *file);
+const gchar      *thunar_file_query_content_type         (GFile                  *gfile,
+                                                          GCancellable           *cancellable,
+                                                          GError                **error);
+void              thunar_file_set_content_type           (ThunarFile             *file,
+                                                          const gchar            *content_type);
 const gchar      *thunar_file_get_symlink_target         (const ThunarFile       *file);
 const gchar      *thunar_file_get_basename               (const ThunarFile       *file) G_GNUC_CONST;
 gboolean          thunar_file_is_symlink                 (const ThunarFile       *file);
@@ -215,6 +259,8 @@ gboolean          thunar_file_is_trash                   (const ThunarFile
 gboolean          thunar_file_is_trashed                 (const ThunarFile       *file);
 gboolean          thunar_file_is_desktop_file            (const ThunarFile       *file,
                                                           gboolean               *is_secure);
+gboolean          thunar_file_same_filesystem            (const ThunarFile       *file_a,
+                                                          const ThunarFile       *file_b);
 const gchar      *thunar_file_get_display_name           (const ThunarFile       *file) G_GNUC_CONST;
 
 gchar            *thunar_file_get_deletion_date          (const ThunarFile       *file,
@@ -227,6 +273,7 @@ gboolean          thunar_file_is_chmodable               (const ThunarFile
 gboolean          thunar_file_is_renameable              (const ThunarFile       *file);
 gboolean          thunar_file_can_be_trashed             (const ThunarFile       *file);
 
+const GList      *thunar_file_peek_emblem_names          (ThunarFile              *file);
 GList            *thunar_file_get_emblem_names           (ThunarFile              *file);
 void              thunar_file_set_emblem_names           (ThunarFile              *file,
                                                           GList                   *emblem_names);
@@ -236,7 +283,7 @@ gboolean          thunar_file_set_custom_icon            (ThunarFile
                                                           const gchar             *custom_icon,
                                                           GError                 **error);
 
-const gchar     *thunar_file_get_thumbnail_path          (ThunarFile              *file,
+gchar           *thunar_file_dup_thumbnail_path          (ThunarFile              *file,
                                                           ThunarThumbnailSize      thumbnail_size);
 ThunarFileThumbState thunar_file_get_thumb_state         (const ThunarFile        *file);
 void             thunar_file_set_thumb_state             (ThunarFile              *file,
@@ -260,16 +307,30 @@ void              thunar_file_destroy                    (ThunarFile
 
 gint              thunar_file_compare_by_type            (ThunarFile              *file_a,
                                                           ThunarFile              *file_b);
+void              thunar_file_prepare_collate_keys       (ThunarFile              *file);
+const gchar      *thunar_file_get_casefold_name          (ThunarFile              *file);
 gint              thunar_file_compare_by_name            (const ThunarFile        *file_a,
                                                           const ThunarFile        *file_b,
-                                                          gboolean                 case_sensitive) G_GNUC_PURE;
+                                                          gboolean                 case_sensitive);
 
 ThunarFile       *thunar_file_cache_lookup               (const GFile             *file);
+void              thunar_file_cache_get_stats            (guint                   *n_files,
+                                                          guint64                 *n_locks,
+                                                          guint64                 *n_contended,
+                                                          guint64                 *n_lookups,
+                                                          guint64                 *n_hits);
+void              thunar_file_cache_get_memory           (guint                   *n_files,
+                                                          guint64                 *n_attributes,
+                                                          guint64                 *n_bytes);
+void              thunar_file_cache_trim                 (void);
 gchar            *thunar_file_cached_display_name        (const GFile             *file);
 
 
+gchar            *thunar_file_list_get_content_types_key (GList                  *file_list) G_GNUC_MALLOC;
 GList            *thunar_file_list_get_applications      (GList                  *file_list);
 GList            *thunar_file_list_to_thunar_g_file_list (GList                  *file_list);
+gchar            *thunar_file_list_to_uri_list           (GList                  *file_list,
+                                                          gsize                  *length_return) G_GNUC_MALLOC;
 
 gboolean          thunar_file_is_desktop                 (const ThunarFile *file);
 
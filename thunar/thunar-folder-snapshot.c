@@ -0,0 +1,364 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-folder-snapshot.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The snapshot of a folder is a header, the folder uri and a record
+ * per file, followed by the nul-terminated name, display name and
+ * content type of the file. Every block is aligned to 8 bytes.
+ */
+#define SNAPSHOT_MAGIC    "THSNAP01"
+#define SNAPSHOT_ALIGN(n) (((n) + 7) & ~((gsize) 7))
+
+
+
+typedef struct
+{
+  gchar   magic[8];
+  guint64 mtime;
+  guint32 n_files;
+  guint32 uri_len;
+}
+SnapshotHeader;
+
+typedef struct
+{
+  guint64 size;
+  guint64 mtime;
+  guint32 mode;
+  guint16 kind;
+  guint16 flags;
+  guint16 name_len;
+  guint16 display_name_len;
+  guint16 content_type_len;
+  guint16 reserved;
+}
+SnapshotRecord;
+
+enum
+{
+  SNAPSHOT_FLAG_HIDDEN = 1 << 0,
+  SNAPSHOT_FLAG_BACKUP = 1 << 1,
+};
+
+
+
+static gchar *
+thunar_folder_snapshot_get_path (const gchar *uri)
+{
+  gchar *checksum;
+  gchar *filename;
+  gchar *path;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  filename = g_strconcat (checksum, ".snapshot", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "Thunar", "snapshots", filename, NULL);
+  g_free (filename);
+  g_free (checksum);
+
+  return path;
+}
+
+
+
+static void
+thunar_folder_snapshot_pad (GByteArray *array)
+{
+  static const guint8 zeros[8] = { 0, };
+
+  g_byte_array_append (array, zeros, SNAPSHOT_ALIGN (array->len) - array->len);
+}
+
+
+
+static void
+thunar_folder_snapshot_save_finished (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  GError *error = NULL;
+
+  if (!g_file_replace_contents_finish (G_FILE (object), result, NULL, &error))
+    {
+      g_debug ("Failed to write folder snapshot: %s", error->message);
+      g_error_free (error);
+    }
+}
+
+
+
+/**
+ * thunar_folder_snapshot_load:
+ * @folder_file : the #ThunarFile of a folder.
+ *
+ * Restores the files of @folder_file from the snapshot written by
+ * thunar_folder_snapshot_save(). The snapshot is only used if the
+ * modification time of the folder did not change since it was written.
+ *
+ * The returned files only carry the information stored in the snapshot,
+ * until they are reported by a directory listing again.
+ *
+ * The caller is responsible to free the returned list using
+ * thunar_g_list_free_full() when no longer needed.
+ *
+ * Return value: the list of restored #ThunarFile<!---->s or %NULL.
+ **/
+GList *
+thunar_folder_snapshot_load (ThunarFile *folder_file)
+{
+  SnapshotHeader  header;
+  SnapshotRecord  record;
+  GMappedFile    *mapped;
+  const gchar    *data;
+  const gchar    *name;
+  const gchar    *display_name;
+  const gchar    *content_type;
+  ThunarFile     *file;
+  GFileInfo      *info;
+  GFile          *directory;
+  GFile          *child;
+  GList          *files = NULL;
+  gsize           length;
+  gsize           offset;
+  gsize           strings_len;
+  gchar          *uri;
+  gchar          *path;
+  guint64         mtime;
+  guint           n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (folder_file), NULL);
+
+  /* without a modification time we cannot tell if the snapshot is valid */
+  mtime = thunar_file_get_date (folder_file, THUNAR_FILE_DATE_MODIFIED);
+  if (G_UNLIKELY (mtime == 0))
+    return NULL;
+
+  directory = thunar_file_get_file (folder_file);
+  uri = g_file_get_uri (directory);
+  path = thunar_folder_snapshot_get_path (uri);
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+  if (G_LIKELY (mapped == NULL))
+    {
+      g_free (uri);
+      return NULL;
+    }
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+
+  if (length < sizeof (SnapshotHeader))
+    goto out;
+
+  /* check if the snapshot belongs to this version of the folder */
+  memcpy (&header, data, sizeof (SnapshotHeader));
+  if (memcmp (header.magic, SNAPSHOT_MAGIC, sizeof (header.magic)) != 0
+      || header.mtime != mtime
+      || header.uri_len != strlen (uri)
+      || sizeof (SnapshotHeader) + header.uri_len >= length
+      || memcmp (data + sizeof (SnapshotHeader), uri, header.uri_len) != 0)
+    goto out;
+
+  offset = SNAPSHOT_ALIGN (sizeof (SnapshotHeader) + header.uri_len + 1);
+
+  for (n = 0; n < header.n_files; ++n)
+    {
+      if (offset + sizeof (SnapshotRecord) > length)
+        break;
+
+      memcpy (&record, data + offset, sizeof (SnapshotRecord));
+      offset += sizeof (SnapshotRecord);
+
+      /* make sure the strings are complete */
+      strings_len = record.name_len + record.display_name_len + record.content_type_len + 3;
+      if (offset + strings_len > length)
+        break;
+
+      name = data + offset;
+      display_name = name + record.name_len + 1;
+      content_type = display_name + record.display_name_len + 1;
+      if (record.name_len == 0
+          || name[record.name_len] != '\0'
+          || display_name[record.display_name_len] != '\0'
+          || content_type[record.content_type_len] != '\0')
+        break;
+
+      offset = SNAPSHOT_ALIGN (offset + strings_len);
+
+      /* rebuild the information we stored */
+      info = g_file_info_new ();
+      g_file_info_set_name (info, name);
+      g_file_info_set_display_name (info, display_name);
+      g_file_info_set_file_type (info, record.kind);
+      g_file_info_set_size (info, record.size);
+      g_file_info_set_is_hidden (info, (record.flags & SNAPSHOT_FLAG_HIDDEN) != 0);
+      g_file_info_set_is_backup (info, (record.flags & SNAPSHOT_FLAG_BACKUP) != 0);
+      g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED, record.mtime);
+      g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE, record.mode);
+      if (record.content_type_len > 0)
+        g_file_info_set_content_type (info, content_type);
+
+      child = g_file_get_child (directory, name);
+      file = thunar_file_get_with_snapshot_info (child, info);
+      files = g_list_prepend (files, file);
+      g_object_unref (child);
+      g_object_unref (info);
+    }
+
+  /* drop incomplete snapshots */
+  if (G_UNLIKELY (n < header.n_files))
+    {
+      thunar_g_list_free_full (files);
+      files = NULL;
+    }
+
+out:
+  g_mapped_file_unref (mapped);
+  g_free (uri);
+
+  return files;
+}
+
+
+
+/**
+ * thunar_folder_snapshot_save:
+ * @folder_file : the #ThunarFile of a folder.
+ * @files       : the list of #ThunarFile<!---->s in the folder.
+ *
+ * Writes a snapshot of the @files in @folder_file to the user's cache
+ * directory, so thunar_folder_snapshot_load() can restore them the next
+ * time the folder is opened. The snapshot is written asynchronously.
+ **/
+void
+thunar_folder_snapshot_save (ThunarFile *folder_file,
+                             GList      *files)
+{
+  SnapshotHeader  header;
+  SnapshotRecord  record;
+  const gchar    *name;
+  const gchar    *display_name;
+  const gchar    *content_type;
+  GByteArray     *array;
+  GFileInfo      *info;
+  GBytes         *bytes;
+  GFile          *snapshot;
+  GList          *lp;
+  gchar          *uri;
+  gchar          *path;
+  gchar          *dirname;
+  guint64         mtime;
+  gsize           name_len;
+  gsize           display_name_len;
+  gsize           content_type_len;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (folder_file));
+
+  mtime = thunar_file_get_date (folder_file, THUNAR_FILE_DATE_MODIFIED);
+  if (G_UNLIKELY (mtime == 0))
+    return;
+
+  uri = g_file_get_uri (thunar_file_get_file (folder_file));
+
+  memset (&header, 0, sizeof (SnapshotHeader));
+  memcpy (header.magic, SNAPSHOT_MAGIC, sizeof (header.magic));
+  header.mtime = mtime;
+  header.uri_len = strlen (uri);
+
+  array = g_byte_array_new ();
+  g_byte_array_append (array, (const guint8 *) &header, sizeof (SnapshotHeader));
+  g_byte_array_append (array, (const guint8 *) uri, header.uri_len + 1);
+  thunar_folder_snapshot_pad (array);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      info = thunar_file_get_info (lp->data);
+      if (G_UNLIKELY (info == NULL))
+        continue;
+
+      name = thunar_file_get_basename (lp->data);
+      display_name = thunar_file_get_display_name (lp->data);
+      content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+      if (content_type == NULL)
+        content_type = "";
+
+      name_len = strlen (name);
+      display_name_len = strlen (display_name);
+      content_type_len = strlen (content_type);
+      if (G_UNLIKELY (name_len > G_MAXUINT16 || display_name_len > G_MAXUINT16 || content_type_len > G_MAXUINT16))
+        continue;
+
+      memset (&record, 0, sizeof (SnapshotRecord));
+      record.size = g_file_info_get_size (info);
+      record.mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      record.mode = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE);
+      record.kind = g_file_info_get_file_type (info);
+      record.name_len = name_len;
+      record.display_name_len = display_name_len;
+      record.content_type_len = content_type_len;
+      if (g_file_info_get_is_hidden (info))
+        record.flags |= SNAPSHOT_FLAG_HIDDEN;
+      if (g_file_info_get_is_backup (info))
+        record.flags |= SNAPSHOT_FLAG_BACKUP;
+
+      g_byte_array_append (array, (const guint8 *) &record, sizeof (SnapshotRecord));
+      g_byte_array_append (array, (const guint8 *) name, name_len + 1);
+      g_byte_array_append (array, (const guint8 *) display_name, display_name_len + 1);
+      g_byte_array_append (array, (const guint8 *) content_type, content_type_len + 1);
+      thunar_folder_snapshot_pad (array);
+
+      header.n_files++;
+    }
+
+  /* update the number of files in the header */
+  memcpy (array->data, &header, sizeof (SnapshotHeader));
+  bytes = g_byte_array_free_to_bytes (array);
+
+  path = thunar_folder_snapshot_get_path (uri);
+  dirname = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dirname, 0700) == 0)
+    {
+      snapshot = g_file_new_for_path (path);
+      g_file_replace_contents_bytes_async (snapshot, bytes, NULL, FALSE,
+                                           G_FILE_CREATE_PRIVATE | G_FILE_CREATE_REPLACE_DESTINATION,
+                                           NULL, thunar_folder_snapshot_save_finished, NULL);
+      g_object_unref (snapshot);
+    }
+
+  g_bytes_unref (bytes);
+  g_free (dirname);
+  g_free (path);
+  g_free (uri);
+}
@@ -0,0 +1,38 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_FOLDER_SNAPSHOT_H__
+#define __THUNAR_FOLDER_SNAPSHOT_H__
+
+#include <thunar/thunar-file.h>
+
+G_BEGIN_DECLS
+
+/* folders with less files are not worth a snapshot */
+#define THUNAR_FOLDER_SNAPSHOT_MIN_FILES (1000)
+
+GList *thunar_folder_snapshot_load (ThunarFile *folder_file);
+
+void   thunar_folder_snapshot_save (ThunarFile *folder_file,
+                                    GList      *files);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_FOLDER_SNAPSHOT_H__ */
@@ -22,17 +22,45 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-counters.h>
 #include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-folder.h>
+#include <thunar/thunar-folder-snapshot.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-monitor-pool.h>
+#include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-recorder.h>
+#include <thunar/thunar-scheduler.h>
+#include <thunar/thunar-search-index.h>
+#include <thunar/thunar-size-cache.h>
+#include <thunar/thunar-trace.h>
+#include <thunar/thunar-watchdog.h>
 
 #define DEBUG_FILE_CHANGES FALSE
 
 
 
+/* number of pending monitor events after which the folder is read again */
+#define THUNAR_FOLDER_EVENTS_MAX (1000)
+
+
+
+/* the maximum number of threads sniffing content types */
+#define THUNAR_FOLDER_CONTENT_TYPE_THREADS (8)
+
+/* the limits of the recently closed folders kept alive */
+#define THUNAR_FOLDER_RETAINED_MAX_FOLDERS (8)
+#define THUNAR_FOLDER_RETAINED_MAX_FILES   (20000)
+
+
+
 /* property identifiers */
 enum
 {
@@ -78,11 +106,20 @@ static void     thunar_folder_file_changed                (ThunarFileMonitor
 static void     thunar_folder_file_destroyed              (ThunarFileMonitor      *file_monitor,
                                                            ThunarFile             *file,
                                                            ThunarFolder           *folder);
-static void     thunar_folder_monitor                     (GFileMonitor           *monitor,
-                                                           GFile                  *file,
+static void     thunar_folder_monitor                     (GFile                  *file,
                                                            GFile                  *other_file,
                                                            GFileMonitorEvent       event_type,
                                                            gpointer                user_data);
+static void     thunar_folder_content_type_loader_cancel  (ThunarFolder           *folder);
+static void     thunar_folder_content_type_loader_remove  (ThunarFolder           *folder,
+                                                           ThunarFile             *file);
+static void     thunar_folder_events_clear                (ThunarFolder           *folder);
+static void     thunar_folder_files_index                 (ThunarFolder           *folder,
+                                                           GList                  *files);
+static GList   *thunar_folder_files_lookup                (ThunarFolder           *folder,
+                                                           ThunarFile             *file);
+static void     thunar_folder_files_delete_link           (ThunarFolder           *folder,
+                                                           GList                  *lp);
 
 
 
@@ -100,6 +137,57 @@ struct _ThunarFolderClass
                          GList        *files);
 };
 
+typedef struct
+{
+  ThunarFile  *file;
+  GFile       *gfile;
+  const gchar *content_type;
+  GFileInfo   *info;
+
+  /* what the worker has to query for the file */
+  guint        needs_content_type : 1;
+  guint        needs_info : 1;
+
+  /* whether the contents may be read if the name is not enough */
+  guint        sniff : 1;
+}
+ContentTypeItem;
+
+typedef struct
+{
+  volatile gint  ref_count;
+  GCancellable  *cancellable;
+  GMutex         mutex;
+
+  /* the items waiting for a worker, in the order they are sniffed */
+  GQueue         pending;
+  GHashTable    *index;
+
+  /* the items sniffed by the workers, applied in the main loop */
+  GList         *results;
+  guint          results_idle_id;
+
+  guint          n_workers;
+  gboolean       cancelled;
+
+  /* on slow filesystems the content types are guessed from the names,
+   * and only the visible files are sniffed if that is not enough */
+  gboolean       guess;
+  gboolean       sniff_visible;
+}
+ContentTypeLoader;
+
+typedef struct
+{
+  GFile            *file;
+  GFile            *other_file;
+  GFileMonitorEvent event_type;
+
+  /* the file taken off the files list for this event */
+  ThunarFile       *removed;
+}
+ThunarFolderEvent;
+
 struct _ThunarFolder
 {
   GObject __parent__;
@@ -111,14 +199,52 @@ struct _ThunarFolder
   GList             *files;
   gboolean           reload_info;
 
-  GList             *content_type_ptr;
-  guint              content_type_idle_id;
+  /* maps the files to their link in the files list */
+  GHashTable        *files_index;
+
+  /* determines the content types and the deferred info
+   * of the files in the background */
+  ContentTypeLoader *content_types;
 
   guint              in_destruction : 1;
 
+  /* set while the files of the initial load are added as they arrive */
+  guint              stream_files : 1;
+  guint              stream_dups : 1;
+
+  /* whether the files are restored from and saved to a snapshot */
+  guint              use_snapshot : 1;
+  guint              from_snapshot : 1;
+
+  /* whether the directory is on a network or FUSE filesystem */
+  guint              slow_filesystem : 1;
+
+  /* whether a view shows the hidden files, until then they keep the
+   * info of the listing, see thunar_folder_load_hidden() */
+  guint              load_hidden : 1;
+
   ThunarFileMonitor *file_monitor;
 
-  GFileMonitor      *monitor;
+  ThunarMonitorSubscription *monitor;
+
+  /* monitor events collected during the event window */
+  GHashTable        *events;
+  GQueue             events_queue;
+  guint              events_timeout_id;
+  guint              events_window;
+  guint              events_overflow : 1;
+
+  /* files changed while too many events arrived */
+  GHashTable        *events_changed;
+
+  /* new files of the events that are still loaded */
+  GList             *events_loaded;
+  guint              events_n_loading;
+
+  /* the state of the directory when it was last read completely,
+   * see thunar_g_file_info_get_stamp() */
+  gchar             *stamp;
+  GCancellable      *refresh_cancellable;
 };
 
 
@@ -126,6 +252,12 @@ struct _ThunarFolder
 static guint  folder_signals[LAST_SIGNAL];
 static GQuark thunar_folder_quark;
 
+/* recently closed folders, most recent first, only used from the main thread */
+static GQueue retained_folders = G_QUEUE_INIT;
+
+/* all live folders, for thunar_folder_get_memory() */
+static GList *live_folders = NULL;
+
 
 
 G_DEFINE_TYPE (ThunarFolder, thunar_folder, G_TYPE_OBJECT)
@@ -135,19 +267,27 @@ G_DEFINE_TYPE (ThunarFolder, thunar_folder, G_TYPE_OBJECT)
 static void
 thunar_folder_constructed (GObject *object)
 {
-  ThunarFolder *folder = THUNAR_FOLDER (object);
-  GError       *error  = NULL;
-
-  folder->monitor = g_file_monitor_directory (thunar_file_get_file (folder->corresponding_file),
-                                              G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
-
-  if (G_LIKELY (folder->monitor != NULL))
-      g_signal_connect (folder->monitor, "changed", G_CALLBACK (thunar_folder_monitor), folder);
-  else
-    {
-      g_debug ("Could not create folder monitor: %s", error->message);
-      g_error_free (error);
-    }
+  ThunarFolder      *folder = THUNAR_FOLDER (object);
+  ThunarPreferences *preferences;
+
+  /* determine how long monitor events are collected */
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-monitor-event-window", &folder->events_window, NULL);
+  g_object_unref (G_OBJECT (preferences));
+
+  /* share the directory monitor, if it has to be polled the folder is
+   * only read again if it changed */
+  folder->monitor = thunar_monitor_pool_subscribe (thunar_file_get_file (folder->corresponding_file),
+                                                   thunar_folder_monitor,
+                                                   (ThunarMonitorPoolPollFunc) thunar_folder_refresh,
+                                                   folder);
+
+  /* only hear about the folder itself and the files in it */
+  thunar_file_monitor_watch (folder->file_monitor, folder->corresponding_file,
+                             THUNAR_FILE_MONITOR_WATCH_FILE | THUNAR_FILE_MONITOR_WATCH_CHILDREN,
+                             (ThunarFileMonitorFunc) thunar_folder_file_changed,
+                             (ThunarFileMonitorFunc) thunar_folder_file_destroyed,
+                             folder);
 
   G_OBJECT_CLASS (thunar_folder_parent_class)->constructed (object);
 }
@@ -266,13 +406,17 @@ thunar_folder_class_init (ThunarFolderClass *klass)
 static void
 thunar_folder_init (ThunarFolder *folder)
 {
-  /* connect to the ThunarFileMonitor instance */
+  /* the folder watches its files once the corresponding file is known */
   folder->file_monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (G_OBJECT (folder->file_monitor), "file-changed", G_CALLBACK (thunar_folder_file_changed), folder);
-  g_signal_connect (G_OBJECT (folder->file_monitor), "file-destroyed", G_CALLBACK (thunar_folder_file_destroyed), folder);
 
   folder->monitor = NULL;
   folder->reload_info = FALSE;
+  folder->files_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+  folder->events = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  folder->events_changed = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+  thunar_counters_inc (THUNAR_COUNTER_FOLDERS);
+  live_folders = g_list_prepend (live_folders, folder);
 }
 
 
@@ -303,16 +447,13 @@ thunar_folder_finalize (GObject *object)
     thunar_file_unwatch (folder->corresponding_file);
 
   /* disconnect from the ThunarFileMonitor instance */
-  g_signal_handlers_disconnect_matched (folder->file_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+  if (folder->corresponding_file)
+    thunar_file_monitor_unwatch (folder->file_monitor, folder->corresponding_file, folder);
   g_object_unref (folder->file_monitor);
 
-  /* disconnect from the file alteration monitor */
+  /* release the directory monitor */
   if (G_LIKELY (folder->monitor != NULL))
-    {
-      g_signal_handlers_disconnect_matched (folder->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
-      g_file_monitor_cancel (folder->monitor);
-      g_object_unref (folder->monitor);
-    }
+    thunar_monitor_pool_unsubscribe (folder->monitor);
 
   /* cancel the pending job (if any) */
   if (G_UNLIKELY (folder->job != NULL))
@@ -331,15 +472,27 @@ thunar_folder_finalize (GObject *object)
     }
 
   /* stop metadata collector */
-  if (folder->content_type_idle_id != 0)
-    g_source_remove (folder->content_type_idle_id);
+  thunar_folder_content_type_loader_cancel (folder);
+
+  g_free (folder->stamp);
+
+  /* drop the pending monitor events */
+  if (folder->events_timeout_id != 0)
+    g_source_remove (folder->events_timeout_id);
+  thunar_folder_events_clear (folder);
+  g_hash_table_destroy (folder->events);
+  g_hash_table_destroy (folder->events_changed);
 
   /* release references to the new files */
   thunar_g_list_free_full (folder->new_files);
 
   /* release references to the current files */
+  g_hash_table_destroy (folder->files_index);
   thunar_g_list_free_full (folder->files);
 
+  thunar_counters_dec (THUNAR_COUNTER_FOLDERS);
+  live_folders = g_list_remove (live_folders, folder);
+
   (*G_OBJECT_CLASS (thunar_folder_parent_class)->finalize) (object);
 }
 
@@ -415,6 +568,9 @@ thunar_folder_error (ExoJob       *job,
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
 
+  /* the directory was not read completely, so its stamp is useless */
+  g_object_set_data (G_OBJECT (job), I_("thunar-folder-stamp"), NULL);
+
   /* tell the consumer about the problem */
   g_signal_emit (G_OBJECT (folder), folder_signals[ERROR], 0, error);
 }
@@ -426,11 +582,45 @@ thunar_folder_files_ready (ThunarJob    *job,
                            GList        *files,
                            ThunarFolder *folder)
 {
+  GList *lp;
+  GList *next;
+
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
 
-  /* merge the list with the existing list of new files */
-  folder->new_files = g_list_concat (folder->new_files, files);
+  thunar_watchdog_push_operation ("folder load", thunar_file_get_file (folder->corresponding_file));
+
+  if (folder->stream_files)
+    {
+      /* drop files the folder monitor already added during loading */
+      if (G_UNLIKELY (folder->stream_dups))
+        {
+          for (lp = files; lp != NULL; lp = next)
+            {
+              next = lp->next;
+              if (thunar_folder_files_lookup (folder, lp->data) != NULL)
+                {
+                  g_object_unref (G_OBJECT (lp->data));
+                  files = g_list_delete_link (files, lp);
+                }
+            }
+        }
+
+      if (files != NULL)
+        {
+          /* there is nothing to merge with, so show the files right away */
+          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, files);
+          thunar_folder_files_index (folder, files);
+          folder->files = g_list_concat (files, folder->files);
+        }
+    }
+  else
+    {
+      /* merge the list with the existing list of new files */
+      folder->new_files = g_list_concat (folder->new_files, files);
+    }
+
+  thunar_watchdog_pop_operation ();
 
   /* indicate that we took over ownership of the file list */
   return TRUE;
@@ -438,58 +628,303 @@ thunar_folder_files_ready (ThunarJob    *job,
 
 
 
+static ContentTypeLoader *
+thunar_folder_content_type_loader_ref (ContentTypeLoader *loader)
+{
+  g_atomic_int_inc (&loader->ref_count);
+  return loader;
+}
+
+
+
+static void
+thunar_folder_content_type_loader_unref (gpointer data)
+{
+  ContentTypeLoader *loader = data;
+
+  if (g_atomic_int_dec_and_test (&loader->ref_count))
+    {
+      /* the items are released on the main thread before */
+      _thunar_assert (g_queue_is_empty (&loader->pending));
+      _thunar_assert (loader->results == NULL);
+
+      g_object_unref (loader->cancellable);
+      g_hash_table_destroy (loader->index);
+      g_mutex_clear (&loader->mutex);
+      g_slice_free (ContentTypeLoader, loader);
+    }
+}
+
+
+
+static void
+thunar_folder_content_type_item_free (ContentTypeItem *item)
+{
+  g_object_unref (item->file);
+  g_object_unref (item->gfile);
+  if (item->info != NULL)
+    g_object_unref (item->info);
+  g_slice_free (ContentTypeItem, item);
+}
+
+
+
 static gboolean
-thunar_folder_content_type_loader_idle (gpointer data)
+thunar_folder_content_type_results (gpointer data,
+                                    gint64   deadline)
 {
-  ThunarFolder *folder;
-  GList        *lp;
+  ContentTypeLoader *loader = data;
+  ContentTypeItem   *item;
+  gboolean           cancelled;
+  gboolean           more;
+  GList             *results;
+
+  /* take all content types determined so far */
+  g_mutex_lock (&loader->mutex);
+  results = loader->results;
+  loader->results = NULL;
+  cancelled = loader->cancelled;
+  g_mutex_unlock (&loader->mutex);
+
+  /* every result emits "changed" on its file, so apply only as many
+   * as fit into this slice and keep the rest for the next one */
+  while (results != NULL)
+    {
+      item = results->data;
+      results = g_list_delete_link (results, results);
 
-  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (data), FALSE);
+      if (!cancelled && item->content_type != NULL)
+        thunar_file_set_content_type (item->file, item->content_type);
+      if (!cancelled && item->info != NULL)
+        thunar_file_set_deferred_info (item->file, item->info);
+      thunar_folder_content_type_item_free (item);
 
-  folder = THUNAR_FOLDER (data);
+      if (g_get_monotonic_time () >= deadline)
+        break;
+    }
 
-  /* load another files content type */
-  for (lp = folder->content_type_ptr; lp != NULL; lp = lp->next)
-    if (thunar_file_load_content_type (lp->data))
-      {
-        /* if this was the last file, abort */
-        if (G_UNLIKELY (lp->next == NULL))
-          break;
+  /* the workers may have added results in the meantime */
+  g_mutex_lock (&loader->mutex);
+  loader->results = g_list_concat (results, loader->results);
+  more = (loader->results != NULL);
+  if (!more)
+    loader->results_idle_id = 0;
+  g_mutex_unlock (&loader->mutex);
 
-        /* set pointer to next file for the next iteration */
-        folder->content_type_ptr = lp->next;
+  return more;
+}
 
-        return TRUE;
-      }
 
-  /* all content types loaded */
-  return FALSE;
+
+static const gchar *
+thunar_folder_content_type_guess (ContentTypeItem *item)
+{
+  const gchar *content_type;
+  gboolean     uncertain;
+  gchar       *basename;
+  gchar       *guess;
+
+  /* guess from the name only, which needs no I/O */
+  basename = g_file_get_basename (item->gfile);
+  guess = g_content_type_guess (basename, NULL, 0, &uncertain);
+  g_free (basename);
+
+  /* leave it to sniffing if allowed and the name is not enough */
+  if (uncertain && item->sniff)
+    content_type = NULL;
+  else
+    content_type = g_intern_string (guess);
+
+  g_free (guess);
+
+  return content_type;
 }
 
 
 
 static void
-thunar_folder_content_type_loader_idle_destroyed (gpointer data)
+thunar_folder_content_type_worker (gpointer data,
+                                   gpointer user_data)
 {
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (data));
+  ContentTypeLoader *loader = data;
+  ContentTypeItem   *item;
+
+  g_mutex_lock (&loader->mutex);
+  while (!loader->cancelled && (item = g_queue_pop_head (&loader->pending)) != NULL)
+    {
+      g_hash_table_remove (loader->index, item->file);
+      g_mutex_unlock (&loader->mutex);
+
+      /* failures are reported once the content type is asked for */
+      if (item->needs_content_type)
+        {
+          if (loader->guess)
+            item->content_type = thunar_folder_content_type_guess (item);
+          if (item->content_type == NULL)
+            item->content_type = thunar_file_query_content_type (item->gfile, loader->cancellable, NULL);
+        }
+
+      /* the attributes left out by the folder listing, which are
+       * queried again by the file if this fails */
+      if (item->needs_info)
+        {
+          item->info = g_file_query_info (item->gfile, THUNAR_FILE_INFO_NAMESPACE_DEFERRED,
+                                          G_FILE_QUERY_INFO_NONE, loader->cancellable, NULL);
+        }
+
+      /* hand the item back to the main loop, which owns the files */
+      g_mutex_lock (&loader->mutex);
+      loader->results = g_list_prepend (loader->results, item);
+      if (loader->results_idle_id == 0)
+        {
+          loader->results_idle_id = thunar_scheduler_add_work (G_PRIORITY_LOW, thunar_folder_content_type_results,
+                                                               thunar_folder_content_type_loader_ref (loader),
+                                                               thunar_folder_content_type_loader_unref);
+        }
+    }
+  loader->n_workers--;
+  g_mutex_unlock (&loader->mutex);
 
-  THUNAR_FOLDER (data)->content_type_idle_id = 0;
+  thunar_folder_content_type_loader_unref (loader);
 }
 
 
 
 static void
-thunar_folder_content_type_loader (ThunarFolder *folder)
+thunar_folder_content_type_loader (ThunarFolder *folder,
+                                   GList        *files)
 {
+  static GThreadPool *pool = NULL;
+  ContentTypeLoader  *loader;
+  ContentTypeItem    *item;
+  ThunarFile         *file;
+  ThunarPreferences  *preferences;
+  GList              *lp;
+  guint               n_workers;
+  gboolean            needs_info;
+
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (folder->content_type_idle_id == 0);
 
-  /* set the pointer to the start of the list */
-  folder->content_type_ptr = folder->files;
+  /* content types are sniffed by a pool shared by all folders */
+  if (G_UNLIKELY (pool == NULL))
+    {
+      pool = g_thread_pool_new (thunar_folder_content_type_worker, NULL,
+                                CLAMP (g_get_num_processors (), 2, THUNAR_FOLDER_CONTENT_TYPE_THREADS),
+                                FALSE, NULL);
+    }
+
+  loader = folder->content_types;
+  if (loader == NULL)
+    {
+      loader = g_slice_new0 (ContentTypeLoader);
+      loader->ref_count = 1;
+      loader->cancellable = g_cancellable_new ();
+      loader->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_mutex_init (&loader->mutex);
+      folder->content_types = loader;
+
+      if (folder->slow_filesystem)
+        {
+          preferences = thunar_preferences_get ();
+          g_object_get (G_OBJECT (preferences), "misc-sniff-visible-remote-files", &loader->sniff_visible, NULL);
+          g_object_unref (G_OBJECT (preferences));
+          loader->guess = TRUE;
+        }
+    }
+
+  g_mutex_lock (&loader->mutex);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      file = THUNAR_FILE (lp->data);
+
+      /* nobody sees the hidden files yet */
+      if (!folder->load_hidden && thunar_file_is_hidden (file))
+        continue;
+
+      needs_info = thunar_file_has_deferred_info (file);
+      if ((thunar_file_has_content_type (file) && !needs_info)
+          || g_hash_table_contains (loader->index, file))
+        continue;
+
+      /* the content type of folders is known without any I/O */
+      if (thunar_file_is_directory (file))
+        {
+          thunar_file_load_content_type (file);
+          if (!needs_info)
+            continue;
+        }
+
+      item = g_slice_new0 (ContentTypeItem);
+      item->file = g_object_ref (file);
+      item->gfile = g_object_ref (thunar_file_get_file (file));
+      item->needs_content_type = !thunar_file_has_content_type (file);
+      item->needs_info = needs_info;
+      item->sniff = !loader->guess;
+      g_queue_push_tail (&loader->pending, item);
+      g_hash_table_insert (loader->index, file, g_queue_peek_tail_link (&loader->pending));
+    }
+
+  /* start enough workers for the pending files */
+  n_workers = MIN (g_queue_get_length (&loader->pending), (guint) g_thread_pool_get_max_threads (pool));
+  for (; loader->n_workers < n_workers; loader->n_workers++)
+    g_thread_pool_push (pool, thunar_folder_content_type_loader_ref (loader), NULL);
+
+  g_mutex_unlock (&loader->mutex);
+}
+
+
+
+static void
+thunar_folder_content_type_loader_cancel (ThunarFolder *folder)
+{
+  ContentTypeLoader *loader = folder->content_types;
+  GList             *items;
+
+  if (loader == NULL)
+    return;
+
+  folder->content_types = NULL;
+
+  /* stop the workers after the file they are working on */
+  g_cancellable_cancel (loader->cancellable);
+  g_mutex_lock (&loader->mutex);
+  loader->cancelled = TRUE;
+  items = loader->pending.head;
+  g_queue_init (&loader->pending);
+  g_hash_table_remove_all (loader->index);
+  g_mutex_unlock (&loader->mutex);
+
+  g_list_free_full (items, (GDestroyNotify) thunar_folder_content_type_item_free);
+  thunar_folder_content_type_loader_unref (loader);
+}
+
+
+
+static void
+thunar_folder_content_type_loader_remove (ThunarFolder *folder,
+                                          ThunarFile   *file)
+{
+  ContentTypeLoader *loader = folder->content_types;
+  GList             *link;
+
+  if (loader == NULL)
+    return;
+
+  g_mutex_lock (&loader->mutex);
+  link = g_hash_table_lookup (loader->index, file);
+  if (link != NULL)
+    {
+      g_hash_table_remove (loader->index, file);
+      g_queue_unlink (&loader->pending, link);
+    }
+  g_mutex_unlock (&loader->mutex);
 
-  /* schedule idle */
-  folder->content_type_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_folder_content_type_loader_idle,
-                                                  folder, thunar_folder_content_type_loader_idle_destroyed);
+  if (link != NULL)
+    {
+      thunar_folder_content_type_item_free (link->data);
+      g_list_free_1 (link);
+    }
 }
 
 
@@ -499,26 +934,48 @@ thunar_folder_finished (ExoJob       *job,
                         ThunarFolder *folder)
 {
   ThunarFile *file;
+  GHashTable *new_files;
   GList      *files;
   GList      *lp;
+  GList      *next;
+  gboolean    changed = !folder->from_snapshot;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (THUNAR_IS_FILE (folder->corresponding_file));
-  _thunar_return_if_fail (folder->content_type_idle_id == 0);
+  _thunar_return_if_fail (folder->content_types == NULL);
+
+  thunar_watchdog_push_operation ("folder load", thunar_file_get_file (folder->corresponding_file));
+
+  /* remember the state of the directory that was read */
+  g_free (folder->stamp);
+  folder->stamp = g_strdup (g_object_get_data (G_OBJECT (job), I_("thunar-folder-stamp")));
+  folder->slow_filesystem = (g_object_get_data (G_OBJECT (job), I_("thunar-folder-slow")) != NULL);
 
   /* check if we need to merge new files with existing files */
-  if (G_UNLIKELY (folder->files != NULL))
+  if (folder->stream_files)
+    {
+      /* the files were already added while they were read */
+      folder->stream_files = FALSE;
+      folder->stream_dups = FALSE;
+    }
+  else if (G_UNLIKELY (folder->files != NULL))
     {
+      /* index the new files, so the comparison below is linear */
+      new_files = g_hash_table_new (g_direct_hash, g_direct_equal);
+      for (lp = folder->new_files; lp != NULL; lp = lp->next)
+        g_hash_table_add (new_files, lp->data);
+
       /* determine all added files (files on new_files, but not on files) */
       for (files = NULL, lp = folder->new_files; lp != NULL; lp = lp->next)
-        if (g_list_find (folder->files, lp->data) == NULL)
+        if (thunar_folder_files_lookup (folder, lp->data) == NULL)
           {
             /* put the file on the added list */
             files = g_list_prepend (files, lp->data);
 
             /* add to the internal files list */
             folder->files = g_list_prepend (folder->files, lp->data);
+            g_hash_table_insert (folder->files_index, lp->data, folder->files);
             g_object_ref (G_OBJECT (lp->data));
           }
 
@@ -530,31 +987,36 @@ thunar_folder_finished (ExoJob       *job,
 
           /* release the added files list */
           g_list_free (files);
+          changed = TRUE;
         }
 
       /* determine all removed files (files on files, but not on new_files) */
-      for (files = NULL, lp = folder->files; lp != NULL; )
+      for (files = NULL, lp = folder->files; lp != NULL; lp = next)
         {
           /* determine the file */
           file = THUNAR_FILE (lp->data);
 
           /* determine the next list item */
-          lp = lp->next;
+          next = lp->next;
 
           /* check if the file is not on new_files */
-          if (g_list_find (folder->new_files, file) == NULL)
+          if (!g_hash_table_contains (new_files, file))
             {
               /* put the file on the removed list (owns the reference now) */
               files = g_list_prepend (files, file);
 
               /* remove from the internal files list */
-              folder->files = g_list_remove (folder->files, file);
+              thunar_folder_files_delete_link (folder, lp);
             }
         }
 
+      g_hash_table_destroy (new_files);
+
       /* check if any files were removed */
       if (G_UNLIKELY (files != NULL))
         {
+          changed = TRUE;
+
           /* emit a "files-removed" signal for the removed files */
           g_signal_emit (G_OBJECT (folder), folder_signals[FILES_REMOVED], 0, files);
 
@@ -571,6 +1033,7 @@ thunar_folder_finished (ExoJob       *job,
       /* just use the new files for the files list */
       folder->files = folder->new_files;
       folder->new_files = NULL;
+      thunar_folder_files_index (folder, folder->files);
 
       if (folder->files != NULL)
         {
@@ -588,23 +1051,37 @@ thunar_folder_finished (ExoJob       *job,
 
       /* reload folder information too */
       if (thunar_file_reload (folder->corresponding_file))
-        return;
+        {
+          thunar_watchdog_pop_operation ();
+          return;
+        }
 
     }
 
+  /* remember large folders, so they show up instantly next time */
+  if (folder->use_snapshot && changed
+      && g_list_length (folder->files) >= THUNAR_FOLDER_SNAPSHOT_MIN_FILES)
+    thunar_folder_snapshot_save (folder->corresponding_file, folder->files);
+  folder->from_snapshot = FALSE;
+
   /* we did it, the folder is loaded */
   if (G_LIKELY (folder->job != NULL))
     {
+      thunar_trace_async_end ("folder", "folder load", folder);
+      if (THUNAR_RECORDER_ENABLED ())
+        thunar_recorder_folder_loaded (thunar_file_get_file (folder->corresponding_file), folder->files);
       g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
       g_object_unref (folder->job);
       folder->job = NULL;
     }
 
-  /* restart the content type idle loader */
-  thunar_folder_content_type_loader (folder);
+  /* determine the content types of the files in the background */
+  thunar_folder_content_type_loader (folder, folder->files);
 
   /* tell the consumers that we have loaded the directory */
   g_object_notify (G_OBJECT (folder), "loading");
+
+  thunar_watchdog_pop_operation ();
 }
 
 
@@ -633,9 +1110,8 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
                               ThunarFile        *file,
                               ThunarFolder      *folder)
 {
-  GList     files;
-  GList    *lp;
-  gboolean  restart = FALSE;
+  GList  files;
+  GList *lp;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
@@ -651,14 +1127,11 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
   else
     {
       /* check if we have that file */
-      lp = g_list_find (folder->files, file);
+      lp = thunar_folder_files_lookup (folder, file);
       if (G_LIKELY (lp != NULL))
         {
-          if (folder->content_type_idle_id != 0)
-            restart = g_source_remove (folder->content_type_idle_id);
-
           /* remove the file from our list */
-          folder->files = g_list_delete_link (folder->files, lp);
+          thunar_folder_files_delete_link (folder, lp);
 
           /* tell everybody that the file is gone */
           files.data = file; files.next = files.prev = NULL;
@@ -666,10 +1139,6 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
 
           /* drop our reference to the file */
           g_object_unref (G_OBJECT (file));
-
-          /* continue collecting the metadata */
-          if (restart)
-            thunar_folder_content_type_loader (folder);
         }
     }
 }
@@ -733,118 +1202,391 @@ thunar_file_infos_equal (ThunarFile *file,
 
 
 
+static gboolean
+thunar_folder_event_is_change (GFileMonitorEvent event_type)
+{
+  return event_type != G_FILE_MONITOR_EVENT_CREATED
+      && event_type != G_FILE_MONITOR_EVENT_DELETED
+      && event_type != G_FILE_MONITOR_EVENT_RENAMED
+      && event_type != G_FILE_MONITOR_EVENT_MOVED_IN
+      && event_type != G_FILE_MONITOR_EVENT_MOVED_OUT;
+}
+
+
+
 static void
-thunar_folder_monitor (GFileMonitor     *monitor,
-                       GFile            *event_file,
-                       GFile            *other_file,
-                       GFileMonitorEvent event_type,
-                       gpointer          user_data)
+thunar_folder_event_free (ThunarFolderEvent *event)
 {
-  ThunarFolder *folder = THUNAR_FOLDER (user_data);
-  ThunarFile   *file;
-  ThunarFile   *other_parent;
-  GList        *lp;
-  GList         list;
-  gboolean      restart = FALSE;
+  g_object_unref (event->file);
+  if (event->other_file != NULL)
+    g_object_unref (event->other_file);
+  if (event->removed != NULL)
+    g_object_unref (event->removed);
+  g_slice_free (ThunarFolderEvent, event);
+}
 
-  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (folder->monitor == monitor);
-  _thunar_return_if_fail (THUNAR_IS_FILE (folder->corresponding_file));
-  _thunar_return_if_fail (G_IS_FILE (event_file));
 
-  /* check on which file the event occurred */
-  if (!g_file_equal (event_file, thunar_file_get_file (folder->corresponding_file)))
+
+static void
+thunar_folder_events_clear (ThunarFolder *folder)
+{
+  ThunarFolderEvent *event;
+
+  g_hash_table_remove_all (folder->events);
+  while ((event = g_queue_pop_head (&folder->events_queue)) != NULL)
+    thunar_folder_event_free (event);
+}
+
+
+
+static void
+thunar_folder_events_changed (ThunarFolder *folder,
+                              GFile        *event_file)
+{
+  ThunarFile *file;
+
+  /* only changes of files we ship are not seen by a reload */
+  file = thunar_file_cache_lookup (event_file);
+  if (file != NULL)
     {
-      /* check if we already ship the file */
-      for (lp = folder->files; lp != NULL; lp = lp->next)
-        if (g_file_equal (event_file, thunar_file_get_file (lp->data)))
-          break;
+      if (thunar_folder_files_lookup (folder, file) != NULL)
+        g_hash_table_add (folder->events_changed, file);
+      else
+        g_object_unref (file);
+    }
+}
 
-      /* stop the content type collector */
-      if (folder->content_type_idle_id != 0)
-        restart = g_source_remove (folder->content_type_idle_id);
 
-      /* if we don't have it, add it if the event is not an "deleted" event */
-      if (G_UNLIKELY (lp == NULL && event_type != G_FILE_MONITOR_EVENT_DELETED))
-        {
-          /* allocate a file for the path */
-          file = thunar_file_get (event_file, NULL);
-          if (G_UNLIKELY (file != NULL))
-            {
-              /* prepend it to our internal list */
-              folder->files = g_list_prepend (folder->files, file);
 
-              /* tell others about the new file */
-              list.data = file; list.next = list.prev = NULL;
-              g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, &list);
+static void
+thunar_folder_events_queue (ThunarFolder     *folder,
+                            GFile            *event_file,
+                            GFile            *other_file,
+                            GFileMonitorEvent event_type)
+{
+  ThunarFolderEvent *event;
 
-              /* load the new file */
-              thunar_file_reload (file);
-            }
+  /* the folder is read again, which finds all added and removed files */
+  if (G_UNLIKELY (folder->events_overflow))
+    {
+      if (thunar_folder_event_is_change (event_type))
+        thunar_folder_events_changed (folder, event_file);
+      return;
+    }
+
+  event = g_hash_table_lookup (folder->events, event_file);
+  if (event != NULL)
+    {
+      /* a change adds nothing to a pending creation, deletion or move,
+       * otherwise the last event wins, so a file created and deleted
+       * again within the window is never shown */
+      if (!thunar_folder_event_is_change (event_type))
+        {
+          event->event_type = event_type;
+          if (event->other_file != NULL)
+            g_object_unref (event->other_file);
+          event->other_file = (other_file != NULL) ? g_object_ref (other_file) : NULL;
         }
-      else if (lp != NULL)
+      return;
+    }
+
+  if (G_UNLIKELY (g_hash_table_size (folder->events) >= THUNAR_FOLDER_EVENTS_MAX))
+    {
+      /* too many files changed, forget the events and read the folder again */
+      while ((event = g_queue_pop_head (&folder->events_queue)) != NULL)
         {
-          if (event_type == G_FILE_MONITOR_EVENT_DELETED)
-            {
-              ThunarFile *destroyed;
+          if (thunar_folder_event_is_change (event->event_type))
+            thunar_folder_events_changed (folder, event->file);
+          thunar_folder_event_free (event);
+        }
+      g_hash_table_remove_all (folder->events);
+      folder->events_overflow = TRUE;
 
-              /* destroy the file */
-              thunar_file_destroy (lp->data);
+      if (thunar_folder_event_is_change (event_type))
+        thunar_folder_events_changed (folder, event_file);
+      return;
+    }
 
-              /* if the file has not been destroyed by now, reload it to invalidate it */
-              destroyed = thunar_file_cache_lookup (event_file);
-              if (destroyed != NULL)
-                {
-                  thunar_file_reload (destroyed);
-                  g_object_unref (destroyed);
-                }
-            }
-          else if (event_type == G_FILE_MONITOR_EVENT_RENAMED ||
-                   event_type == G_FILE_MONITOR_EVENT_MOVED_IN ||
-                   event_type == G_FILE_MONITOR_EVENT_MOVED_OUT)
+  event = g_slice_new0 (ThunarFolderEvent);
+  event->file = g_object_ref (event_file);
+  event->other_file = (other_file != NULL) ? g_object_ref (other_file) : NULL;
+  event->event_type = event_type;
+  g_hash_table_insert (folder->events, event->file, event);
+  g_queue_push_tail (&folder->events_queue, event);
+}
+
+
+
+static void
+thunar_folder_events_finish (ThunarFolder      *folder,
+                             ThunarFolderEvent *event)
+{
+  ThunarFile *file;
+  ThunarFile *destroyed;
+  ThunarFile *other_parent;
+
+  /* destroy the old file */
+  thunar_file_destroy (event->removed);
+
+  if (event->event_type == G_FILE_MONITOR_EVENT_DELETED)
+    {
+      /* if the file has not been destroyed by now, reload it to invalidate it */
+      destroyed = thunar_file_cache_lookup (event->file);
+      if (destroyed != NULL)
+        {
+          thunar_file_reload (destroyed);
+          g_object_unref (destroyed);
+        }
+    }
+  else if (event->other_file != NULL)
+    {
+      /* update the new file */
+      file = thunar_file_get (event->other_file, NULL);
+      if (file != NULL && THUNAR_IS_FILE (file))
+        {
+          if (thunar_file_reload (file))
             {
-              /* destroy the old file and update the new one */
-              thunar_file_destroy (lp->data);
-              if (other_file != NULL)
+              /* if source and target folders are different, also tell
+                 the target folder to reload for the changes */
+              if (thunar_file_has_parent (file))
                 {
-                  file = thunar_file_get(other_file, NULL);
-                  if (file != NULL && THUNAR_IS_FILE (file))
+                  other_parent = thunar_file_get_parent (file, NULL);
+                  if (other_parent &&
+                      !g_file_equal (thunar_file_get_file(folder->corresponding_file),
+                                     thunar_file_get_file(other_parent)))
                     {
-                      if (thunar_file_reload (file))
-                        {
-                          /* if source and target folders are different, also tell
-                             the target folder to reload for the changes */
-                          if (thunar_file_has_parent (file))
-                            {
-                              other_parent = thunar_file_get_parent (file, NULL);
-                              if (other_parent &&
-                                  !g_file_equal (thunar_file_get_file(folder->corresponding_file),
-                                                 thunar_file_get_file(other_parent)))
-                                {
-                                  thunar_file_reload (other_parent);
-                                  g_object_unref (other_parent);
-                                }
-                            }
-                        }
-
-                      /* drop reference on the other file */
-                      g_object_unref (file);
+                      thunar_file_reload (other_parent);
+                      g_object_unref (other_parent);
                     }
                 }
             }
-          else
+
+          /* drop reference on the other file */
+          g_object_unref (file);
+        }
+    }
+}
+
+
+
+static void
+thunar_folder_events_add (ThunarFolder *folder,
+                          GList        *added,
+                          gboolean      reload)
+{
+  GList *lp;
+
+  for (lp = added; lp != NULL; lp = lp->next)
+    {
+      /* prepend it to our internal list */
+      folder->files = g_list_prepend (folder->files, lp->data);
+      g_hash_table_insert (folder->files_index, lp->data, folder->files);
+    }
+
+  /* the listing job may report these files again */
+  if (folder->stream_files)
+    folder->stream_dups = TRUE;
+
+  /* tell others about the new files at once and refresh cached ones */
+  g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, added);
+  if (reload)
+    {
+      for (lp = added; lp != NULL; lp = lp->next)
+        thunar_file_reload (lp->data);
+    }
+
+  /* sniff the new files too, if the folder is already loaded */
+  if (folder->content_types != NULL)
+    thunar_folder_content_type_loader (folder, added);
+}
+
+
+
+static void
+thunar_folder_events_loaded (GFile      *location,
+                             ThunarFile *file,
+                             GError     *error,
+                             gpointer    user_data)
+{
+  ThunarFolder *folder = THUNAR_FOLDER (user_data);
+  GList        *added;
+
+  /* files deleted again before they were loaded are skipped */
+  if (error == NULL
+      && !folder->in_destruction
+      && thunar_folder_files_lookup (folder, file) == NULL
+      && g_list_find (folder->events_loaded, file) == NULL)
+    folder->events_loaded = g_list_prepend (folder->events_loaded, g_object_ref (file));
+
+  /* the loads of one flush usually finish together, add them at once */
+  if (--folder->events_n_loading == 0 && folder->events_loaded != NULL)
+    {
+      added = g_list_reverse (folder->events_loaded);
+      folder->events_loaded = NULL;
+      thunar_folder_events_add (folder, added, FALSE);
+      g_list_free (added);
+    }
+
+  g_object_unref (folder);
+}
+
+
+
+static gboolean
+thunar_folder_events_flush (gpointer user_data)
+{
+  ThunarFolderEvent *event;
+  GHashTableIter     iter;
+  ThunarFolder      *folder = THUNAR_FOLDER (user_data);
+  ThunarFile        *file;
+  gpointer           key;
+  GList             *added = NULL;
+  GList             *removed = NULL;
+  GList             *moved = NULL;
+  GList             *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
+
+  folder->events_timeout_id = 0;
+
+  /* fall back to a single reload if there were too many events */
+  if (G_UNLIKELY (folder->events_overflow))
+    {
+      folder->events_overflow = FALSE;
+      thunar_folder_reload (folder, FALSE);
+
+      g_hash_table_iter_init (&iter, folder->events_changed);
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        thunar_file_reload (key);
+      g_hash_table_remove_all (folder->events_changed);
+
+      return FALSE;
+    }
+
+  /* the queue owns the events */
+  g_hash_table_remove_all (folder->events);
+
+  while ((event = g_queue_pop_head (&folder->events_queue)) != NULL)
+    {
+      /* check if we already ship the file, files we ship are always cached */
+      lp = NULL;
+      file = thunar_file_cache_lookup (event->file);
+      if (G_LIKELY (file != NULL))
+        lp = thunar_folder_files_lookup (folder, file);
+
+      if (lp == NULL)
+        {
+          /* if we don't have it, add it if the event is not an "deleted" event */
+          if (event->event_type != G_FILE_MONITOR_EVENT_DELETED)
             {
+              if (file != NULL)
+                {
+                  /* a cached file may be outdated, it is reloaded once added */
+                  added = g_list_prepend (added, g_object_ref (file));
+                }
+              else
+                {
+                  /* load the file without blocking, the loads of siblings
+                   * are combined into one enumeration of the folder */
+                  folder->events_n_loading++;
+                  thunar_file_get_async (event->file, NULL, thunar_folder_events_loaded, g_object_ref (folder));
+                }
+            }
+
+          thunar_folder_event_free (event);
+        }
+      else if (!thunar_folder_event_is_change (event->event_type))
+        {
+          /* take the file off our list, it is destroyed once the
+           * consumers know it is gone */
+          event->removed = lp->data;
+          thunar_folder_files_delete_link (folder, lp);
+          removed = g_list_prepend (removed, event->removed);
+          moved = g_list_prepend (moved, event);
+        }
+      else
+        {
 #if DEBUG_FILE_CHANGES
-              thunar_file_infos_equal (lp->data, event_file);
+          thunar_file_infos_equal (lp->data, event->file);
 #endif
-              thunar_file_reload (lp->data);
-            }
+          thunar_file_reload (lp->data);
+          thunar_folder_event_free (event);
         }
 
-      /* check if we need to restart the collector */
-      if (restart)
-        thunar_folder_content_type_loader (folder);
+      if (file != NULL)
+        g_object_unref (file);
+    }
+
+  /* tell everybody about the removed files at once */
+  if (removed != NULL)
+    {
+      g_signal_emit (G_OBJECT (folder), folder_signals[FILES_REMOVED], 0, removed);
+      g_list_free (removed);
+    }
+
+  if (added != NULL)
+    {
+      added = g_list_reverse (added);
+      thunar_folder_events_add (folder, added, TRUE);
+      g_list_free (added);
+    }
+
+  /* destroy the removed files and update their new locations */
+  for (lp = g_list_reverse (moved); lp != NULL; lp = lp->next)
+    {
+      thunar_folder_events_finish (folder, lp->data);
+      thunar_folder_event_free (lp->data);
+    }
+  g_list_free (moved);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_folder_monitor (GFile            *event_file,
+                       GFile            *other_file,
+                       GFileMonitorEvent event_type,
+                       gpointer          user_data)
+{
+  ThunarFolder *folder = THUNAR_FOLDER (user_data);
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (THUNAR_IS_FILE (folder->corresponding_file));
+  _thunar_return_if_fail (G_IS_FILE (event_file));
+
+  if (THUNAR_RECORDER_ENABLED ())
+    thunar_recorder_monitor_event (event_file, other_file, event_type);
+
+  /* check on which file the event occurred */
+  if (!g_file_equal (event_file, thunar_file_get_file (folder->corresponding_file)))
+    {
+      /* searches find new files before the mount is indexed again */
+      if (event_type == G_FILE_MONITOR_EVENT_CREATED || event_type == G_FILE_MONITOR_EVENT_MOVED_IN)
+        thunar_search_index_file_created (event_file);
+      else if (event_type == G_FILE_MONITOR_EVENT_RENAMED && other_file != NULL)
+        thunar_search_index_file_created (other_file);
+
+      /* rewritten files change the size of the folder, but not its
+       * modification time, so the counted size is not valid anymore */
+      if (event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT || event_type == G_FILE_MONITOR_EVENT_CHANGED)
+        thunar_size_cache_invalidate (thunar_file_get_file (folder->corresponding_file));
+
+      /* collect the event, so events for the same file are merged */
+      thunar_folder_events_queue (folder, event_file, other_file, event_type);
+
+      if (folder->events_window == 0)
+        {
+          /* handle the event right away */
+          if (folder->events_timeout_id != 0)
+            g_source_remove (folder->events_timeout_id);
+          thunar_folder_events_flush (folder);
+        }
+      else if (folder->events_timeout_id == 0)
+        {
+          folder->events_timeout_id = g_timeout_add (folder->events_window, thunar_folder_events_flush, folder);
+        }
     }
   else
     {
@@ -863,6 +1605,41 @@ thunar_folder_monitor (GFileMonitor     *monitor,
 
 
 
+static void
+thunar_folder_files_index (ThunarFolder *folder,
+                           GList        *files)
+{
+  GList *lp;
+
+  /* remember the links of files added to the files list */
+  for (lp = files; lp != NULL; lp = lp->next)
+    g_hash_table_insert (folder->files_index, lp->data, lp);
+}
+
+
+
+static GList *
+thunar_folder_files_lookup (ThunarFolder *folder,
+                            ThunarFile   *file)
+{
+  return g_hash_table_lookup (folder->files_index, file);
+}
+
+
+
+static void
+thunar_folder_files_delete_link (ThunarFolder *folder,
+                                 GList        *lp)
+{
+  /* no need to sniff a removed file */
+  thunar_folder_content_type_loader_remove (folder, lp->data);
+
+  g_hash_table_remove (folder->files_index, lp->data);
+  folder->files = g_list_delete_link (folder->files, lp);
+}
+
+
+
 /**
  * thunar_folder_get_for_file:
  * @file : a #ThunarFile.
@@ -903,6 +1680,10 @@ thunar_folder_get_for_file (ThunarFile *file)
   if (G_UNLIKELY (folder != NULL))
     {
       g_object_ref (G_OBJECT (folder));
+
+      /* the folder is used again, so it should be monitored */
+      if (G_LIKELY (folder->monitor != NULL))
+        thunar_monitor_pool_touch (folder->monitor);
     }
   else
     {
@@ -990,7 +1771,7 @@ gboolean
 thunar_folder_has_folder_monitor (const ThunarFolder *folder)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
-  return (folder->monitor != NULL);
+  return (folder->monitor != NULL && thunar_monitor_pool_is_monitored (folder->monitor));
 }
 
 
@@ -1007,18 +1788,30 @@ void
 thunar_folder_reload (ThunarFolder *folder,
                       gboolean      reload_info)
 {
+  ThunarPreferences *preferences;
+  gboolean           use_snapshot;
+  gchar             *uri;
+
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
 
   /* reload file info too? */
   folder->reload_info = reload_info;
 
+  /* a pending refresh is superseded by this reload */
+  if (G_UNLIKELY (folder->refresh_cancellable != NULL))
+    {
+      g_cancellable_cancel (folder->refresh_cancellable);
+      g_clear_object (&folder->refresh_cancellable);
+    }
+
   /* stop metadata collector */
-  if (folder->content_type_idle_id != 0)
-    g_source_remove (folder->content_type_idle_id);
+  thunar_folder_content_type_loader_cancel (folder);
 
   /* check if we are currently connect to a job */
   if (G_UNLIKELY (folder->job != NULL))
     {
+      thunar_trace_async_end ("folder", "folder load", folder);
+
       /* disconnect from the job */
       g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
       g_object_unref (folder->job);
@@ -1029,6 +1822,38 @@ thunar_folder_reload (ThunarFolder *folder,
   thunar_g_list_free_full (folder->new_files);
   folder->new_files = NULL;
 
+  /* show the files of the last visit while the folder is read */
+  if (folder->files == NULL)
+    {
+      preferences = thunar_preferences_get ();
+      g_object_get (G_OBJECT (preferences), "misc-folder-snapshots", &use_snapshot, NULL);
+      g_object_unref (G_OBJECT (preferences));
+      folder->use_snapshot = use_snapshot;
+
+      if (use_snapshot)
+        {
+          folder->files = thunar_folder_snapshot_load (folder->corresponding_file);
+          if (folder->files != NULL)
+            {
+              thunar_folder_files_index (folder, folder->files);
+              folder->from_snapshot = TRUE;
+              g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, folder->files);
+            }
+        }
+    }
+
+  /* without files there is nothing to merge, so the files can be
+   * added while they are read from the directory */
+  folder->stream_files = (folder->files == NULL);
+  folder->stream_dups = FALSE;
+
+  if (THUNAR_TRACE_ENABLED ())
+    {
+      uri = thunar_file_dup_uri (folder->corresponding_file);
+      thunar_trace_async_begin ("folder", "folder load", folder, uri);
+      g_free (uri);
+    }
+
   /* start a new job */
   folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
   exo_job_launch (EXO_JOB (folder->job));
@@ -1039,3 +1864,291 @@ thunar_folder_reload (ThunarFolder *folder,
   /* tell all consumers that we're loading */
   g_object_notify (G_OBJECT (folder), "loading");
 }
+
+
+
+static void
+thunar_folder_refresh_ready (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
+{
+  ThunarFolder *folder = THUNAR_FOLDER (user_data);
+  GFileInfo    *info;
+  GError       *error = NULL;
+  gchar        *stamp = NULL;
+
+  info = g_file_query_info_finish (G_FILE (object), result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* superseded by a reload */
+      g_error_free (error);
+      g_object_unref (folder);
+      return;
+    }
+
+  g_clear_object (&folder->refresh_cancellable);
+
+  if (G_LIKELY (info != NULL))
+    {
+      stamp = thunar_g_file_info_get_stamp (info);
+      g_object_unref (info);
+    }
+  else
+    {
+      g_error_free (error);
+    }
+
+  /* only read the directory again if it changed since the last time,
+   * the reload merges the files with the ones already known */
+  if (stamp == NULL || g_strcmp0 (stamp, folder->stamp) != 0)
+    thunar_folder_reload (folder, FALSE);
+
+  g_free (stamp);
+  g_object_unref (folder);
+}
+
+
+
+/**
+ * thunar_folder_refresh:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Like thunar_folder_reload(), but only rereads the directory if
+ * it changed since it was last read. This only costs a single query
+ * when nothing changed, which matters for large folders on slow
+ * remote mounts. Use thunar_folder_reload() to read it in any case.
+ **/
+void
+thunar_folder_refresh (ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  /* the folder is being read already or a check is pending */
+  if (folder->job != NULL || folder->refresh_cancellable != NULL)
+    return;
+
+  /* without a stamp there is nothing to compare with */
+  if (folder->stamp == NULL)
+    {
+      thunar_folder_reload (folder, FALSE);
+      return;
+    }
+
+  folder->refresh_cancellable = g_cancellable_new ();
+  g_file_query_info_async (thunar_file_get_file (folder->corresponding_file),
+                           THUNAR_G_FILE_STAMP_ATTRIBUTES,
+                           G_FILE_QUERY_INFO_NONE,
+                           G_PRIORITY_DEFAULT,
+                           folder->refresh_cancellable,
+                           thunar_folder_refresh_ready,
+                           g_object_ref (folder));
+}
+
+
+
+/**
+ * thunar_folder_prioritize_files:
+ * @folder : a #ThunarFolder instance.
+ * @files  : a list of #ThunarFile<!---->s in @folder.
+ *
+ * Tells the @folder to determine the content types of @files before
+ * those of all other files, e.g. because they are visible in a view.
+ **/
+void
+thunar_folder_prioritize_files (ThunarFolder *folder,
+                                GList        *files)
+{
+  ContentTypeLoader *loader;
+  GList             *link;
+  GList             *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  loader = folder->content_types;
+  if (loader == NULL)
+    return;
+
+  /* move the files to the front of the queue, keeping their order */
+  g_mutex_lock (&loader->mutex);
+  for (lp = g_list_last (files); lp != NULL; lp = lp->prev)
+    {
+      link = g_hash_table_lookup (loader->index, lp->data);
+      if (link != NULL)
+        {
+          g_queue_unlink (&loader->pending, link);
+          g_queue_push_head_link (&loader->pending, link);
+
+          /* visible files are worth a round trip on slow filesystems */
+          if (loader->sniff_visible)
+            ((ContentTypeItem *) link->data)->sniff = TRUE;
+        }
+    }
+  g_mutex_unlock (&loader->mutex);
+}
+
+
+
+/**
+ * thunar_folder_load_hidden:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Tells the @folder that its hidden files are shown in a view. Until
+ * then, the content types and the deferred info of the hidden files
+ * are not determined, which saves the I/O for the many dotfiles in
+ * home folders. The hidden files of a loaded folder are added to the
+ * content type loader right away.
+ **/
+void
+thunar_folder_load_hidden (ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  if (folder->load_hidden)
+    return;
+
+  folder->load_hidden = TRUE;
+
+  /* otherwise they are loaded with the others once the folder is loaded */
+  if (folder->content_types != NULL)
+    thunar_folder_content_type_loader (folder, folder->files);
+}
+
+
+
+static void
+thunar_folder_retained_destroyed (ThunarFolder *folder)
+{
+  /* a folder whose directory is gone cannot be reused */
+  if (g_queue_remove (&retained_folders, folder))
+    {
+      g_signal_handlers_disconnect_by_func (folder, thunar_folder_retained_destroyed, NULL);
+      g_object_unref (folder);
+    }
+}
+
+
+
+static void
+thunar_folder_retained_drop (ThunarFolder *folder)
+{
+  g_signal_handlers_disconnect_by_func (folder, thunar_folder_retained_destroyed, NULL);
+  g_object_unref (folder);
+}
+
+
+
+/**
+ * thunar_folder_retain:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Keeps @folder alive after its last user released it, together with
+ * its file monitor, so going back to the folder shows an up-to-date
+ * listing right away. Only the most recently retained folders are kept,
+ * bounded by their number and the number of files they contain.
+ **/
+void
+thunar_folder_retain (ThunarFolder *folder)
+{
+  ThunarFolder *oldest;
+  GList        *lp;
+  guint         n_files = 0;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  if (G_UNLIKELY (folder->in_destruction))
+    return;
+
+  /* move the folder to the front of the pool */
+  lp = g_queue_find (&retained_folders, folder);
+  if (lp != NULL)
+    {
+      g_queue_unlink (&retained_folders, lp);
+      g_queue_push_head_link (&retained_folders, lp);
+    }
+  else
+    {
+      g_queue_push_head (&retained_folders, g_object_ref (folder));
+      g_signal_connect (folder, "destroy", G_CALLBACK (thunar_folder_retained_destroyed), NULL);
+    }
+
+  /* drop the least recently closed folders beyond the limits */
+  for (lp = retained_folders.head; lp != NULL; lp = lp->next)
+    n_files += g_hash_table_size (THUNAR_FOLDER (lp->data)->files_index);
+
+  while (retained_folders.length > 1
+         && (retained_folders.length > THUNAR_FOLDER_RETAINED_MAX_FOLDERS
+             || n_files > THUNAR_FOLDER_RETAINED_MAX_FILES))
+    {
+      oldest = g_queue_pop_tail (&retained_folders);
+      n_files -= MIN (n_files, g_hash_table_size (oldest->files_index));
+      thunar_folder_retained_drop (oldest);
+    }
+}
+
+
+
+/**
+ * thunar_folder_release_retained:
+ *
+ * Releases all folders kept alive by thunar_folder_retain().
+ **/
+void
+thunar_folder_release_retained (void)
+{
+  ThunarFolder *folder;
+
+  while ((folder = g_queue_pop_head (&retained_folders)) != NULL)
+    thunar_folder_retained_drop (folder);
+}
+
+
+
+/**
+ * thunar_folder_get_memory:
+ * @n_folders : return location for the number of live folders.
+ * @n_files   : return location for the number of files in their lists.
+ * @n_bytes   : return location for the estimated memory of the folders.
+ *
+ * Estimates the memory held by all live #ThunarFolder<!---->s for their
+ * file lists, indexes and pending events, without the files themselves,
+ * see thunar_file_cache_get_memory().
+ *
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_folder_get_memory (guint   *n_folders,
+                          guint64 *n_files,
+                          guint64 *n_bytes)
+{
+  ThunarFolder *folder;
+  GList        *lp;
+  guint64       files = 0;
+  guint64       bytes = 0;
+  guint64       n_links;
+  guint64       n_entries;
+
+  for (lp = live_folders; lp != NULL; lp = lp->next)
+    {
+      folder = THUNAR_FOLDER (lp->data);
+
+      n_links = g_list_length (folder->files) + g_list_length (folder->new_files)
+                + g_list_length (folder->events_loaded) + folder->events_queue.length;
+      n_entries = g_hash_table_size (folder->files_index) + g_hash_table_size (folder->events)
+                  + g_hash_table_size (folder->events_changed);
+
+      files += g_list_length (folder->files);
+
+      /* a list link is three pointers, a table entry two and a hash */
+      bytes += sizeof (ThunarFolder) + n_links * 3 * sizeof (gpointer)
+               + n_entries * (2 * sizeof (gpointer) + sizeof (guint));
+      if (folder->stamp != NULL)
+        bytes += strlen (folder->stamp) + 1;
+    }
+
+  if (n_folders != NULL)
+    *n_folders = g_list_length (live_folders);
+  if (n_files != NULL)
+    *n_files = files;
+  if (n_bytes != NULL)
+    *n_bytes = bytes;
+}
@@ -45,6 +45,18 @@ gboolean      thunar_folder_has_folder_monitor     (const ThunarFolder *folder);
 
 void          thunar_folder_reload                 (ThunarFolder       *folder,
                                                     gboolean            reload_info);
+void          thunar_folder_refresh                (ThunarFolder       *folder);
+
+void          thunar_folder_prioritize_files       (ThunarFolder       *folder,
+                                                    GList              *files);
+void          thunar_folder_load_hidden            (ThunarFolder       *folder);
+
+void          thunar_folder_retain                 (ThunarFolder       *folder);
+void          thunar_folder_release_retained       (void);
+
+void          thunar_folder_get_memory             (guint              *n_folders,
+                                                    guint64            *n_files,
+                                                    guint64            *n_bytes);
 
 G_END_DECLS;
 
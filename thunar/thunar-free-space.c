@@ -0,0 +1,494 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunar/thunar-free-space.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The free space of a volume is asked once per mount and interval, no
+ * matter how many views, dialogs and jobs want to know it. Requests for
+ * a mount that is already being queried wait for the running query.
+ *
+ * A query that does not return in time fails its requests. Until the
+ * stalled query returns, no other query is started for the mount and
+ * requests fail right away, so a hanging network mount only ever takes
+ * one thread of the I/O pool.
+ */
+#define FREE_SPACE_TTL        (5 * G_USEC_PER_SEC)
+#define FREE_SPACE_TIMEOUT    (5)
+#define FREE_SPACE_ATTRIBUTES G_FILE_ATTRIBUTE_FILESYSTEM_FREE "," G_FILE_ATTRIBUTE_FILESYSTEM_SIZE
+
+
+
+typedef struct _FreeSpaceMount FreeSpaceMount;
+typedef struct _FreeSpaceQuery FreeSpaceQuery;
+
+struct _FreeSpaceMount
+{
+  /* the last answer and when it was received, 0 if never */
+  guint64         fs_free;
+  guint64         fs_size;
+  gboolean        valid;
+  gint64          time;
+
+  /* the running query and the requests waiting for it */
+  FreeSpaceQuery *query;
+  GList          *tasks;
+  guint           timeout_id;
+};
+
+struct _FreeSpaceQuery
+{
+  FreeSpaceMount *mount;
+  gboolean        timed_out;
+};
+
+typedef struct
+{
+  guint64 fs_free;
+  guint64 fs_size;
+}
+FreeSpaceResult;
+
+typedef struct
+{
+  GMutex        mutex;
+  GCond         cond;
+  gboolean      done;
+  GFile        *file;
+  GCancellable *cancellable;
+  guint64       fs_free;
+  guint64       fs_size;
+  gboolean      succeed;
+  GError       *error;
+}
+FreeSpaceSync;
+
+
+
+/* the known mounts by their mount point or root uri, only used from the
+ * main thread. Mounts are never removed, there are only a few of them */
+static GHashTable *free_space_mounts = NULL;
+
+
+
+static FreeSpaceMount *
+thunar_free_space_get_mount (GFile *file)
+{
+  FreeSpaceMount *mount;
+  gchar          *key;
+
+  if (G_UNLIKELY (free_space_mounts == NULL))
+    free_space_mounts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  key = thunar_g_file_get_mount_key (file, NULL);
+  mount = g_hash_table_lookup (free_space_mounts, key);
+  if (G_LIKELY (mount != NULL))
+    {
+      g_free (key);
+      return mount;
+    }
+
+  mount = g_slice_new0 (FreeSpaceMount);
+  g_hash_table_insert (free_space_mounts, key, mount);
+
+  return mount;
+}
+
+
+
+static void
+thunar_free_space_return (GTask          *task,
+                          FreeSpaceMount *mount)
+{
+  FreeSpaceResult *result;
+
+  if (mount->valid)
+    {
+      result = g_slice_new (FreeSpaceResult);
+      result->fs_free = mount->fs_free;
+      result->fs_size = mount->fs_size;
+      g_task_return_pointer (task, result, NULL);
+    }
+  else
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               "Failed to query the free space");
+    }
+}
+
+
+
+static void
+thunar_free_space_return_all (FreeSpaceMount *mount)
+{
+  GList *tasks;
+  GList *lp;
+
+  /* the callbacks may queue new requests for the mount */
+  tasks = mount->tasks;
+  mount->tasks = NULL;
+
+  for (lp = tasks; lp != NULL; lp = lp->next)
+    {
+      thunar_free_space_return (lp->data, mount);
+      g_object_unref (lp->data);
+    }
+  g_list_free (tasks);
+}
+
+
+
+static void
+thunar_free_space_query_ready (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  FreeSpaceQuery *query = user_data;
+  FreeSpaceMount *mount = query->mount;
+  GFileInfo      *info;
+
+  info = g_file_query_filesystem_info_finish (G_FILE (object), result, NULL);
+
+  mount->valid = (info != NULL && g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE));
+  if (mount->valid)
+    {
+      mount->fs_free = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+      mount->fs_size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+    }
+  mount->time = g_get_monotonic_time ();
+  mount->query = NULL;
+
+  if (info != NULL)
+    g_object_unref (info);
+
+  /* the requests already failed if the query took too long */
+  if (G_LIKELY (!query->timed_out))
+    {
+      g_source_remove (mount->timeout_id);
+      mount->timeout_id = 0;
+      thunar_free_space_return_all (mount);
+    }
+
+  g_slice_free (FreeSpaceQuery, query);
+}
+
+
+
+static gboolean
+thunar_free_space_query_timeout (gpointer user_data)
+{
+  FreeSpaceMount *mount = user_data;
+  GList          *tasks;
+  GList          *lp;
+
+  mount->query->timed_out = TRUE;
+  mount->timeout_id = 0;
+
+  tasks = mount->tasks;
+  mount->tasks = NULL;
+
+  for (lp = tasks; lp != NULL; lp = lp->next)
+    {
+      g_task_return_new_error (lp->data, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                               "Timeout while querying the free space");
+      g_object_unref (lp->data);
+    }
+  g_list_free (tasks);
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_free_space_query_async:
+ * @file        : a #GFile.
+ * @cancellable : a #GCancellable or %NULL.
+ * @callback    : the function to call once the free space is known.
+ * @user_data   : data to pass to @callback.
+ *
+ * Asks for the free space of the volume containing @file. Answers are
+ * shared for a few seconds between all requests for the same mount. The
+ * request fails if the volume does not answer in time.
+ *
+ * Use thunar_free_space_query_finish() in @callback to get the result.
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_free_space_query_async (GFile               *file,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  FreeSpaceMount *mount;
+  FreeSpaceQuery *query;
+  GTask          *task;
+
+  _thunar_return_if_fail (G_IS_FILE (file));
+  _thunar_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (file, cancellable, callback, user_data);
+  mount = thunar_free_space_get_mount (file);
+
+  if (mount->time != 0 && g_get_monotonic_time () - mount->time < FREE_SPACE_TTL)
+    {
+      /* the last answer is recent enough */
+      thunar_free_space_return (task, mount);
+      g_object_unref (task);
+    }
+  else if (G_UNLIKELY (mount->query != NULL && mount->query->timed_out))
+    {
+      /* do not pile up queries on a stalled volume */
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                               "Timeout while querying the free space");
+      g_object_unref (task);
+    }
+  else
+    {
+      mount->tasks = g_list_prepend (mount->tasks, task);
+
+      /* start a query unless one is already running */
+      if (mount->query == NULL)
+        {
+          query = g_slice_new0 (FreeSpaceQuery);
+          query->mount = mount;
+          mount->query = query;
+          mount->timeout_id = g_timeout_add_seconds (FREE_SPACE_TIMEOUT, thunar_free_space_query_timeout, mount);
+
+          /* the query is shared, so it must not be cancelled with a single request */
+          g_file_query_filesystem_info_async (file, FREE_SPACE_ATTRIBUTES, G_PRIORITY_LOW, NULL,
+                                              thunar_free_space_query_ready, query);
+        }
+    }
+}
+
+
+
+/**
+ * thunar_free_space_query_finish:
+ * @file           : the #GFile passed to thunar_free_space_query_async().
+ * @result         : the #GAsyncResult passed to the callback.
+ * @fs_free_return : return location for the amount of free space or %NULL.
+ * @fs_size_return : return location for the size of the volume or %NULL.
+ * @error          : return location for errors or %NULL.
+ *
+ * Finishes an operation started with thunar_free_space_query_async().
+ *
+ * Return value: %TRUE if the free space of the volume is known.
+ **/
+gboolean
+thunar_free_space_query_finish (GFile         *file,
+                                GAsyncResult  *result,
+                                guint64       *fs_free_return,
+                                guint64       *fs_size_return,
+                                GError       **error)
+{
+  FreeSpaceResult *free_space;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (g_task_is_valid (result, file), FALSE);
+
+  free_space = g_task_propagate_pointer (G_TASK (result), error);
+  if (G_UNLIKELY (free_space == NULL))
+    return FALSE;
+
+  if (fs_free_return != NULL)
+    *fs_free_return = free_space->fs_free;
+  if (fs_size_return != NULL)
+    *fs_size_return = free_space->fs_size;
+  g_slice_free (FreeSpaceResult, free_space);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_free_space_lookup:
+ * @file           : a #GFile.
+ * @fs_free_return : return location for the amount of free space or %NULL.
+ * @fs_size_return : return location for the size of the volume or %NULL.
+ *
+ * Returns the last known free space of the volume containing @file
+ * without waiting for the volume. If the answer is outdated, the free
+ * space is queried again in the background. Use
+ * thunar_free_space_query_async() to be notified about the answer.
+ *
+ * This function may only be used from the main thread.
+ *
+ * Return value: %TRUE if the free space of the volume is known.
+ **/
+gboolean
+thunar_free_space_lookup (GFile   *file,
+                          guint64 *fs_free_return,
+                          guint64 *fs_size_return)
+{
+  FreeSpaceMount *mount;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+  mount = thunar_free_space_get_mount (file);
+  if (mount->time == 0 || g_get_monotonic_time () - mount->time >= FREE_SPACE_TTL)
+    thunar_free_space_query_async (file, NULL, NULL, NULL);
+
+  if (fs_free_return != NULL)
+    *fs_free_return = mount->fs_free;
+  if (fs_size_return != NULL)
+    *fs_size_return = mount->fs_size;
+
+  return mount->valid;
+}
+
+
+
+static void
+thunar_free_space_sync_ready (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  FreeSpaceSync *sync = user_data;
+
+  g_mutex_lock (&sync->mutex);
+  sync->succeed = thunar_free_space_query_finish (G_FILE (object), result, &sync->fs_free,
+                                                  &sync->fs_size, &sync->error);
+  sync->done = TRUE;
+  g_cond_signal (&sync->cond);
+  g_mutex_unlock (&sync->mutex);
+}
+
+
+
+static gboolean
+thunar_free_space_sync_start (gpointer user_data)
+{
+  FreeSpaceSync *sync = user_data;
+
+  thunar_free_space_query_async (sync->file, sync->cancellable,
+                                 thunar_free_space_sync_ready, sync);
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_free_space_query:
+ * @file           : a #GFile.
+ * @cancellable    : a #GCancellable or %NULL.
+ * @fs_free_return : return location for the amount of free space or %NULL.
+ * @fs_size_return : return location for the size of the volume or %NULL.
+ * @error          : return location for errors or %NULL.
+ *
+ * Blocking version of thunar_free_space_query_async() for jobs, which
+ * shares the answers of the main thread and gives up after a few seconds.
+ * This function must not be used from the main thread.
+ *
+ * Return value: %TRUE if the free space of the volume is known.
+ **/
+gboolean
+thunar_free_space_query (GFile         *file,
+                         GCancellable  *cancellable,
+                         guint64       *fs_free_return,
+                         guint64       *fs_size_return,
+                         GError       **error)
+{
+  FreeSpaceSync sync = { 0, };
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  _thunar_return_val_if_fail (!g_main_context_is_owner (g_main_context_default ()), FALSE);
+
+  g_mutex_init (&sync.mutex);
+  g_cond_init (&sync.cond);
+  sync.file = file;
+  sync.cancellable = cancellable;
+
+  /* the request always finishes, at the latest when it times out */
+  g_main_context_invoke (NULL, thunar_free_space_sync_start, &sync);
+
+  g_mutex_lock (&sync.mutex);
+  while (!sync.done)
+    g_cond_wait (&sync.cond, &sync.mutex);
+  g_mutex_unlock (&sync.mutex);
+
+  g_cond_clear (&sync.cond);
+  g_mutex_clear (&sync.mutex);
+
+  if (sync.error != NULL)
+    g_propagate_error (error, sync.error);
+
+  if (sync.succeed)
+    {
+      if (fs_free_return != NULL)
+        *fs_free_return = sync.fs_free;
+      if (fs_size_return != NULL)
+        *fs_size_return = sync.fs_size;
+    }
+
+  return sync.succeed;
+}
+
+
+
+/**
+ * thunar_free_space_format:
+ * @fs_free          : the amount of free space.
+ * @fs_size          : the size of the volume.
+ * @file_size_binary : whether to show sizes in binary units.
+ *
+ * Formats the free space of a volume for display.
+ *
+ * The caller is responsible to free the returned string using
+ * g_free() when no longer needed.
+ *
+ * Return value: the free space string or %NULL if @fs_size is 0.
+ **/
+gchar *
+thunar_free_space_format (guint64  fs_free,
+                          guint64  fs_size,
+                          gboolean file_size_binary)
+{
+  gchar *fs_free_str;
+  gchar *fs_size_str;
+  gchar *fs_string;
+
+  if (G_UNLIKELY (fs_size == 0))
+    return NULL;
+
+  fs_free_str = g_format_size_full (fs_free, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+  fs_size_str = g_format_size_full (fs_size, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+  /* free disk space string */
+  fs_string = g_strdup_printf (_("%s of %s free (%d%% used)"),
+                               fs_free_str, fs_size_str,
+                               (gint) ((fs_size - fs_free) * 100 / fs_size));
+  g_free (fs_free_str);
+  g_free (fs_size_str);
+
+  return fs_string;
+}
@@ -0,0 +1,55 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_FREE_SPACE_H__
+#define __THUNAR_FREE_SPACE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+gboolean thunar_free_space_lookup       (GFile               *file,
+                                         guint64             *fs_free_return,
+                                         guint64             *fs_size_return);
+
+void     thunar_free_space_query_async  (GFile               *file,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data);
+
+gboolean thunar_free_space_query_finish (GFile               *file,
+                                         GAsyncResult        *result,
+                                         guint64             *fs_free_return,
+                                         guint64             *fs_size_return,
+                                         GError             **error);
+
+gboolean thunar_free_space_query        (GFile               *file,
+                                         GCancellable        *cancellable,
+                                         guint64             *fs_free_return,
+                                         guint64             *fs_size_return,
+                                         GError             **error);
+
+gchar   *thunar_free_space_format       (guint64              fs_free,
+                                         guint64              fs_size,
+                                         gboolean             file_size_binary);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_FREE_SPACE_H__ */
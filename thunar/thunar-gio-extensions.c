@@ -22,6 +22,10 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <gio/gio.h>
 
 #ifdef HAVE_GIO_UNIX
@@ -32,11 +36,13 @@
 #include <exo/exo.h>
 #include <libxfce4util/libxfce4util.h>
 
+#include <thunar/thunar-app-index.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-util.h>
+#include <thunar/thunar-watchdog.h>
 
 
 
@@ -234,8 +240,13 @@ thunar_g_file_query_key_file (GFile              *file,
   _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
   /* try to load the entire file into memory */
+  thunar_watchdog_push_operation ("key file read", file);
   if (!g_file_load_contents (file, cancellable, &contents, &length, NULL, error))
-    return NULL;
+    {
+      thunar_watchdog_pop_operation ();
+      return NULL;
+    }
+  thunar_watchdog_pop_operation ();
 
   /* allocate a new key file */
   key_file = g_key_file_new ();
@@ -500,80 +511,283 @@ thunar_g_vfs_is_uri_scheme_supported (const gchar *scheme)
 
 
 /**
- * thunar_g_file_get_free_space:
- * @file           : a #GFile instance.
- * @fs_free_return : return location for the amount of
- *                   free space or %NULL.
- * @fs_size_return : return location for the total volume size.
+ * thunar_g_file_info_get_memory:
+ * @info         : a #GFileInfo.
+ * @n_attributes : return location for the number of attributes or %NULL.
  *
- * Determines the amount of free space of the volume on
- * which @file resides. Returns %TRUE if the amount of
- * free space was determined successfully and placed into
- * @free_space_return, else %FALSE will be returned.
+ * Estimates the memory held by @info: the object, an entry per
+ * attribute and the strings of the attributes. The objects of the
+ * attributes, like icons, are usually shared and not included.
  *
- * Return value: %TRUE if successfull, else %FALSE.
+ * Return value: the estimated number of bytes.
  **/
-gboolean
-thunar_g_file_get_free_space (GFile   *file,
-                              guint64 *fs_free_return,
-                              guint64 *fs_size_return)
+gsize
+thunar_g_file_info_get_memory (GFileInfo *info,
+                               guint     *n_attributes)
 {
-  GFileInfo *filesystem_info;
-  gboolean   success = FALSE;
+  const gchar *const *strv;
+  const gchar        *value;
+  gchar             **attributes;
+  gsize               n_bytes;
+  guint               n;
+  guint               i;
 
-  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), 0);
 
-  filesystem_info = g_file_query_filesystem_info (file,
-                                                  THUNARX_FILESYSTEM_INFO_NAMESPACE,
-                                                  NULL, NULL);
+  /* the object and the array of attributes, every attribute is an
+   * id and a value of two words in GIO */
+  n_bytes = 64;
 
-  if (filesystem_info != NULL)
+  attributes = g_file_info_list_attributes (info, NULL);
+  for (n = 0; attributes != NULL && attributes[n] != NULL; ++n)
     {
-      if (fs_free_return != NULL)
-        {
-          *fs_free_return = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
-          success = g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
-        }
+      n_bytes += sizeof (guint32) + 2 * sizeof (gpointer);
 
-      if (fs_size_return != NULL)
+      switch (g_file_info_get_attribute_type (info, attributes[n]))
         {
-          *fs_size_return = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-          success = g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-        }
+        case G_FILE_ATTRIBUTE_TYPE_STRING:
+          value = g_file_info_get_attribute_string (info, attributes[n]);
+          n_bytes += (value != NULL) ? strlen (value) + 1 : 0;
+          break;
 
-      g_object_unref (filesystem_info);
+        case G_FILE_ATTRIBUTE_TYPE_BYTE_STRING:
+          value = g_file_info_get_attribute_byte_string (info, attributes[n]);
+          n_bytes += (value != NULL) ? strlen (value) + 1 : 0;
+          break;
+
+        case G_FILE_ATTRIBUTE_TYPE_STRINGV:
+          strv = (const gchar *const *) g_file_info_get_attribute_stringv (info, attributes[n]);
+          for (i = 0; strv != NULL && strv[i] != NULL; ++i)
+            n_bytes += strlen (strv[i]) + 1 + sizeof (gpointer);
+          break;
+
+        default:
+          break;
+        }
     }
 
-  return success;
+  if (n_attributes != NULL)
+    *n_attributes = n;
+
+  g_strfreev (attributes);
+
+  return n_bytes;
 }
 
 
 
+/**
+ * thunar_g_file_info_get_stamp:
+ * @info : a #GFileInfo queried with %THUNAR_G_FILE_STAMP_ATTRIBUTES.
+ *
+ * Builds a string that changes whenever the contents of the directory
+ * described by @info change, from its entity tag and its modification
+ * and change times.
+ *
+ * A directory modified in the last two seconds has no reliable stamp,
+ * because filesystems with a coarse timestamp resolution wouldn't
+ * notice another change in the same interval.
+ *
+ * Return value: the stamp or %NULL if there is no reliable stamp.
+ *               The caller is responsible to free it.
+ **/
 gchar *
-thunar_g_file_get_free_space_string (GFile *file, gboolean file_size_binary)
+thunar_g_file_info_get_stamp (GFileInfo *info)
+{
+  const gchar *etag;
+  guint64      modified;
+  guint64      changed;
+  gint64       now;
+
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
+
+  etag = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ETAG_VALUE);
+  if (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    return g_strdup (etag);
+
+  modified = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  changed = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_CHANGED);
+
+  /* too recent to tell apart from a change in the same interval */
+  now = g_get_real_time () / G_USEC_PER_SEC;
+  if (now < 0 || MAX (modified, changed) + 2 >= (guint64) now)
+    return NULL;
+
+  return g_strdup_printf ("%" G_GUINT64_FORMAT ".%u:%" G_GUINT64_FORMAT ".%u:%s",
+                          modified,
+                          g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC),
+                          changed,
+                          g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_CHANGED_USEC),
+                          etag != NULL ? etag : "");
+}
+
+
+
+/**
+ * thunar_g_file_is_on_slow_filesystem:
+ * @file        : a #GFile.
+ * @cancellable : a #GCancellable or %NULL.
+ *
+ * Checks whether @file is on a network or FUSE filesystem, where every
+ * file that is read costs a round trip, e.g. to sniff its content type.
+ * This does blocking I/O, so it should not be called from the main thread.
+ *
+ * Return value: %TRUE if @file is on a slow filesystem.
+ **/
+gboolean
+thunar_g_file_is_on_slow_filesystem (GFile        *file,
+                                     GCancellable *cancellable)
 {
-  gchar             *fs_free_str;
-  gchar             *fs_size_str;
-  guint64            fs_free;
-  guint64            fs_size;
-  gchar             *fs_string = NULL;
+  GFileInfo   *info;
+  const gchar *type;
+  gboolean     slow = FALSE;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+  info = g_file_query_filesystem_info (file,
+                                       G_FILE_ATTRIBUTE_FILESYSTEM_TYPE ","
+                                       G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE,
+                                       cancellable, NULL);
+  if (G_UNLIKELY (info == NULL))
+    return FALSE;
+
+  type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE);
+  if (g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE))
+    slow = TRUE;
+  else if (type != NULL && (g_strcmp0 (type, "fuse") == 0 || g_str_has_prefix (type, "fuse.")))
+    slow = TRUE;
+
+  g_object_unref (info);
+
+  return slow;
+}
+
+
+
+#ifdef HAVE_GIO_UNIX
+static gboolean
+thunar_g_file_is_remote_fs_type (const gchar *fs_type)
+{
+  static const gchar *remote_fs_types[] =
+  {
+    "9p", "afs", "ceph", "cifs", "davfs", "glusterfs", "lustre",
+    "ncpfs", "nfs", "nfs4", "smb3", "smbfs", "fuse",
+  };
+  guint n;
+
+  if (g_str_has_prefix (fs_type, "fuse."))
+    return TRUE;
+
+  for (n = 0; n < G_N_ELEMENTS (remote_fs_types); ++n)
+    if (strcmp (fs_type, remote_fs_types[n]) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+#endif
+
+
+
+/**
+ * thunar_g_file_get_mount_key:
+ * @file          : a #GFile.
+ * @remote_return : return location for whether the mount is remote or %NULL.
+ *
+ * Returns a key for the mount containing @file, which is the innermost
+ * mount point for local files and the root of the uri otherwise. Mounts
+ * of network and FUSE filesystems and locations of remote backends are
+ * reported as remote in @remote_return.
+ *
+ * This only reads the mount table, never the mount itself, so it does not
+ * block on stalled mounts. It may only be used from the main thread.
+ *
+ * The caller is responsible to free the returned string using g_free()
+ * when no longer needed.
+ *
+ * Return value: the key of the mount containing @file.
+ **/
+gchar *
+thunar_g_file_get_mount_key (GFile    *file,
+                             gboolean *remote_return)
+{
+  static const gchar *local_schemes[] = { "trash", "recent", "computer", "burn", "applications" };
+  GFile              *root;
+  GFile              *parent;
+  gchar              *key = NULL;
+  guint               n;
+#ifdef HAVE_GIO_UNIX
+  static GList       *unix_mounts = NULL;
+  static guint64      unix_mounts_time = 0;
+  const gchar        *mount_path;
+  const gchar        *fs_type = NULL;
+  GList              *lp;
+  gchar              *path;
+  gsize               mount_len;
+  gsize               key_len = 0;
+#endif
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
 
-  if (thunar_g_file_get_free_space (file, &fs_free, &fs_size)
-      && fs_size > 0)
+  if (remote_return != NULL)
+    *remote_return = FALSE;
+
+#ifdef HAVE_GIO_UNIX
+  if (g_file_is_native (file))
     {
-      fs_free_str = g_format_size_full (fs_free, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-      fs_size_str = g_format_size_full (fs_size, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-      /* free disk space string */
-      fs_string = g_strdup_printf (_("%s of %s free (%d%% used)"),
-                                   fs_free_str, fs_size_str,
-                                   (gint) ((fs_size - fs_free) * 100 / fs_size));
-      g_free (fs_free_str);
-      g_free (fs_size_str);
+      /* the mount table is cheap to read, but only reread it when it changed */
+      if (unix_mounts == NULL || g_unix_mounts_changed_since (unix_mounts_time))
+        {
+          g_list_free_full (unix_mounts, (GDestroyNotify) g_unix_mount_free);
+          unix_mounts = g_unix_mounts_get (&unix_mounts_time);
+        }
+
+      /* find the innermost mount point containing the file */
+      path = g_file_get_path (file);
+      for (lp = unix_mounts; path != NULL && lp != NULL; lp = lp->next)
+        {
+          mount_path = g_unix_mount_get_mount_path (lp->data);
+          mount_len = strlen (mount_path);
+          if (mount_len >= key_len
+              && strncmp (path, mount_path, mount_len) == 0
+              && (path[mount_len] == G_DIR_SEPARATOR || path[mount_len] == '\0'
+                  || (mount_len == 1 && mount_path[0] == G_DIR_SEPARATOR)))
+            {
+              g_free (key);
+              key = g_strdup (mount_path);
+              key_len = mount_len;
+              fs_type = g_unix_mount_get_fs_type (lp->data);
+            }
+        }
+      g_free (path);
+
+      if (key != NULL)
+        {
+          if (remote_return != NULL)
+            *remote_return = (fs_type != NULL && thunar_g_file_is_remote_fs_type (fs_type));
+          return key;
+        }
     }
+#endif
 
-  return fs_string;
+  /* remote locations share the mount of the root of their uri */
+  root = g_object_ref (file);
+  while ((parent = g_file_get_parent (root)) != NULL)
+    {
+      g_object_unref (root);
+      root = parent;
+    }
+  key = g_file_get_uri (root);
+  g_object_unref (root);
+
+  if (remote_return != NULL && !g_file_is_native (file))
+    {
+      *remote_return = TRUE;
+      for (n = 0; n < G_N_ELEMENTS (local_schemes); ++n)
+        if (g_file_has_uri_scheme (file, local_schemes[n]))
+          *remote_return = FALSE;
+    }
+
+  return key;
 }
 
 
@@ -619,11 +833,11 @@ thunar_g_file_list_new_from_string (const gchar *string)
   uris = g_uri_list_extract_uris (string);
 
   for (n = 0; uris != NULL && uris[n] != NULL; ++n)
-    list = g_list_append (list, g_file_new_for_uri (uris[n]));
+    list = g_list_prepend (list, g_file_new_for_uri (uris[n]));
 
   g_strfreev (uris);
 
-  return list;
+  return g_list_reverse (list);
 }
 
 
@@ -723,6 +937,7 @@ thunar_g_app_info_launch (GAppInfo          *info,
 {
   ThunarFile   *file;
   GAppInfo     *default_app_info;
+  GHashTable   *content_types;
   GList        *recommended_app_infos;
   GList        *lp;
   const gchar  *content_type;
@@ -760,6 +975,9 @@ thunar_g_app_info_launch (GAppInfo          *info,
   /* if successful, remember the application as last used for the file types */
   if (result == TRUE)
     {
+      /* each content type only needs to be updated once */
+      content_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
       for (lp = path_list; lp != NULL; lp = lp->next)
         {
           gboolean update_app_info = !skip_app_info_update;
@@ -769,6 +987,12 @@ thunar_g_app_info_launch (GAppInfo          *info,
             continue;
 
           content_type = thunar_file_get_content_type (file);
+          if (content_type == NULL
+              || !g_hash_table_add (content_types, g_strdup (content_type)))
+            {
+              g_object_unref (file);
+              continue;
+            }
 
           /* determine default application */
           default_app_info = thunar_file_get_default_handler (file);
@@ -797,10 +1021,15 @@ thunar_g_app_info_launch (GAppInfo          *info,
 
           /* emit "changed" on the file if we successfully changed the last used application */
           if (update_app_info && g_app_info_set_as_last_used_for_type (info, content_type, NULL))
-            thunar_file_changed (file);
+            {
+              thunar_app_index_invalidate ();
+              thunar_file_changed (file);
+            }
 
           g_object_unref (file);
         }
+
+      g_hash_table_destroy (content_types);
     }
 
   /* check if we need to reset the working directory to the one Thunar was
@@ -820,6 +1049,38 @@ thunar_g_app_info_launch (GAppInfo          *info,
 
 
 
+/**
+ * thunar_g_app_info_takes_multiple_files:
+ * @info : a #GAppInfo.
+ *
+ * Checks whether a single launch of @info opens all the files passed
+ * to g_app_info_launch(). That is the case for D-Bus activatable
+ * applications, which get all the files with one "Open" call, and for
+ * command lines with %F or %U. Otherwise GIO spawns one process per
+ * file.
+ *
+ * Return value: %TRUE if @info opens many files with one launch.
+ **/
+gboolean
+thunar_g_app_info_takes_multiple_files (GAppInfo *info)
+{
+  const gchar *commandline;
+
+  _thunar_return_val_if_fail (G_IS_APP_INFO (info), FALSE);
+
+#ifdef HAVE_GIO_UNIX
+  if (G_IS_DESKTOP_APP_INFO (info)
+      && g_desktop_app_info_get_boolean (G_DESKTOP_APP_INFO (info), G_KEY_FILE_DESKTOP_KEY_DBUS_ACTIVATABLE))
+    return TRUE;
+#endif
+
+  commandline = g_app_info_get_commandline (info);
+  return commandline != NULL
+         && (strstr (commandline, "%F") != NULL || strstr (commandline, "%U") != NULL);
+}
+
+
+
 gboolean
 thunar_g_app_info_should_show (GAppInfo *info)
 {
@@ -25,6 +25,12 @@
 
 G_BEGIN_DECLS
 
+/* the attributes needed by thunar_g_file_info_get_stamp() */
+#define THUNAR_G_FILE_STAMP_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_ETAG_VALUE "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
+  G_FILE_ATTRIBUTE_TIME_CHANGED "," G_FILE_ATTRIBUTE_TIME_CHANGED_USEC
+
 GFile       *thunar_g_file_new_for_home             (void);
 GFile       *thunar_g_file_new_for_root             (void);
 GFile       *thunar_g_file_new_for_trash            (void);
@@ -56,12 +62,15 @@ gchar       *thunar_g_file_get_display_name_remote  (GFile                *file)
 
 gboolean     thunar_g_vfs_is_uri_scheme_supported   (const gchar          *scheme);
 
-gboolean     thunar_g_file_get_free_space           (GFile                *file,
-                                                     guint64              *fs_free_return,
-                                                     guint64              *fs_size_return);
+gchar       *thunar_g_file_info_get_stamp           (GFileInfo            *info);
+gsize        thunar_g_file_info_get_memory          (GFileInfo            *info,
+                                                     guint                *n_attributes);
+
+gboolean     thunar_g_file_is_on_slow_filesystem    (GFile                *file,
+                                                     GCancellable         *cancellable);
 
-gchar       *thunar_g_file_get_free_space_string    (GFile                *file,
-                                                     gboolean              file_size_binary);
+gchar       *thunar_g_file_get_mount_key            (GFile                *file,
+                                                     gboolean             *remote_return);
 
 /**
  * THUNAR_TYPE_G_FILE_LIST:
@@ -89,6 +98,8 @@ gboolean     thunar_g_app_info_launch                  (GAppInfo          *info,
                                                         GAppLaunchContext *context,
                                                         GError           **error);
 
+gboolean     thunar_g_app_info_takes_multiple_files    (GAppInfo          *info);
+
 gboolean     thunar_g_app_info_should_show             (GAppInfo          *info);
 
 gboolean     thunar_g_vfs_metadata_is_supported        (void);
@@ -0,0 +1,779 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#include <signal.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib-unix.h>
+
+#include <exo/exo.h>
+
+#include <thunar/thunar-application.h>
+#include <thunar/thunar-file.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-headless.h>
+#include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-private.h>
+
+/* include generate dbus infos */
+#include <thunar/thunar-dbus-service-infos.h>
+
+
+
+/* The headless mode runs the file operations of org.xfce.FileManager
+ * (CopyTo, CopyInto, UpdateInto, MoveInto, LinkInto, UnlinkFiles and
+ * org.xfce.Trash.MoveToTrash) without initializing GTK+, so it works
+ * on machines without a display, e.g. on build servers. The jobs are
+ * the same ThunarJobs the file manager uses, only the questions
+ * they ask are answered by a fixed policy instead of a dialog and the
+ * errors are written to stderr. The methods that need a window are
+ * not handled and fail with an "unknown method" error.
+ */
+
+
+
+typedef struct _ThunarHeadless ThunarHeadless;
+
+struct _ThunarHeadless
+{
+  GMainLoop             *loop;
+  gint                   exit_status;
+
+  /* only kept for the thumbnail cache of the jobs, it is never registered */
+  ThunarApplication     *application;
+
+  ThunarDBusFileManager *file_manager;
+  ThunarDBusTrash       *trash;
+  guint                  owner_id;
+
+  /* the running jobs */
+  GList                 *jobs;
+
+  /* the answer to "ask-replace" */
+  ThunarJobResponse      replace_response;
+
+  /* quit after this many seconds without jobs, 0 to never quit */
+  guint                  idle_timeout;
+  guint                  idle_timer_id;
+};
+
+
+
+static gboolean          thunar_headless_collect_files   (const gchar            *working_directory,
+                                                          const gchar * const    *filenames,
+                                                          GList                 **file_list,
+                                                          GError                **error);
+static gboolean          thunar_headless_idle_timer      (gpointer                user_data);
+static void              thunar_headless_schedule_quit   (ThunarHeadless         *headless);
+static ThunarJobResponse thunar_headless_job_ask         (ThunarJob              *job,
+                                                          const gchar            *message,
+                                                          ThunarJobResponse       choices,
+                                                          ThunarHeadless         *headless);
+static ThunarJobResponse thunar_headless_job_ask_replace (ThunarJob              *job,
+                                                          ThunarFile             *src_file,
+                                                          ThunarFile             *dst_file,
+                                                          ThunarHeadless         *headless);
+static void              thunar_headless_job_error       (ThunarJob              *job,
+                                                          GError                 *error,
+                                                          ThunarHeadless         *headless);
+static void              thunar_headless_job_finished    (ThunarJob              *job,
+                                                          ThunarHeadless         *headless);
+static void              thunar_headless_launch          (ThunarHeadless         *headless,
+                                                          ThunarJob              *job);
+static gboolean          thunar_headless_transfer_files  (ThunarHeadless         *headless,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *method,
+                                                          const gchar            *working_directory,
+                                                          const gchar * const    *source_filenames,
+                                                          const gchar * const    *target_filenames);
+static gboolean          thunar_headless_copy_to         (ThunarDBusFileManager  *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *working_directory,
+                                                          gchar                 **source_filenames,
+                                                          gchar                 **target_filenames,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static gboolean          thunar_headless_copy_into       (ThunarDBusFileManager  *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *working_directory,
+                                                          gchar                 **source_filenames,
+                                                          const gchar            *target_filename,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static gboolean          thunar_headless_update_into     (ThunarDBusFileManager  *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *working_directory,
+                                                          gchar                 **source_filenames,
+                                                          const gchar            *target_filename,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static gboolean          thunar_headless_move_into       (ThunarDBusFileManager  *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *working_directory,
+                                                          gchar                 **source_filenames,
+                                                          const gchar            *target_filename,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static gboolean          thunar_headless_link_into       (ThunarDBusFileManager  *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *working_directory,
+                                                          gchar                 **source_filenames,
+                                                          const gchar            *target_filename,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static gboolean          thunar_headless_unlink_files    (ThunarDBusFileManager  *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          const gchar            *working_directory,
+                                                          gchar                 **filenames,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static gboolean          thunar_headless_move_to_trash   (ThunarDBusTrash        *object,
+                                                          GDBusMethodInvocation  *invocation,
+                                                          gchar                 **filenames,
+                                                          const gchar            *display,
+                                                          const gchar            *startup_id,
+                                                          ThunarHeadless         *headless);
+static void              thunar_headless_bus_acquired    (GDBusConnection        *connection,
+                                                          const gchar            *name,
+                                                          gpointer                user_data);
+static void              thunar_headless_name_acquired   (GDBusConnection        *connection,
+                                                          const gchar            *name,
+                                                          gpointer                user_data);
+static void              thunar_headless_name_lost       (GDBusConnection        *connection,
+                                                          const gchar            *name,
+                                                          gpointer                user_data);
+static gboolean          thunar_headless_terminate       (gpointer                user_data);
+
+
+
+static gboolean
+thunar_headless_collect_files (const gchar         *working_directory,
+                               const gchar * const *filenames,
+                               GList              **file_list,
+                               GError             **error)
+{
+  GFile *file;
+  gchar *filename;
+  gchar *cwd;
+  guint  n;
+
+  /* relative filenames are relative to the caller, not to us */
+  if (exo_str_is_empty (working_directory))
+    cwd = g_get_current_dir ();
+  else
+    cwd = g_strdup (working_directory);
+
+  for (n = 0; filenames[n] != NULL; ++n)
+    {
+      /* decode the filename (D-BUS uses UTF-8) */
+      filename = g_filename_from_utf8 (filenames[n], -1, NULL, NULL, error);
+      if (G_UNLIKELY (filename == NULL))
+        {
+          thunar_g_list_free_full (*file_list);
+          *file_list = NULL;
+          g_free (cwd);
+          return FALSE;
+        }
+
+      file = g_file_new_for_commandline_arg_and_cwd (filename, cwd);
+      *file_list = g_list_prepend (*file_list, file);
+      g_free (filename);
+    }
+
+  *file_list = g_list_reverse (*file_list);
+  g_free (cwd);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_headless_idle_timer (gpointer user_data)
+{
+  ThunarHeadless *headless = user_data;
+
+  headless->idle_timer_id = 0;
+  g_main_loop_quit (headless->loop);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_headless_schedule_quit (ThunarHeadless *headless)
+{
+  if (headless->idle_timeout == 0 || headless->jobs != NULL)
+    return;
+
+  if (headless->idle_timer_id != 0)
+    g_source_remove (headless->idle_timer_id);
+
+  headless->idle_timer_id = g_timeout_add_seconds (headless->idle_timeout, thunar_headless_idle_timer, headless);
+}
+
+
+
+static ThunarJobResponse
+thunar_headless_job_ask (ThunarJob         *job,
+                         const gchar       *message,
+                         ThunarJobResponse  choices,
+                         ThunarHeadless    *headless)
+{
+  ThunarJobResponse response;
+
+  /* nobody is there to answer, so skip what can be skipped and stop otherwise */
+  if ((choices & THUNAR_JOB_RESPONSE_SKIP_ALL) != 0)
+    response = THUNAR_JOB_RESPONSE_SKIP_ALL;
+  else if ((choices & THUNAR_JOB_RESPONSE_SKIP) != 0)
+    response = THUNAR_JOB_RESPONSE_SKIP;
+  else if ((choices & THUNAR_JOB_RESPONSE_NO_ALL) != 0)
+    response = THUNAR_JOB_RESPONSE_NO_ALL;
+  else if ((choices & THUNAR_JOB_RESPONSE_NO) != 0)
+    response = THUNAR_JOB_RESPONSE_NO;
+  else
+    response = THUNAR_JOB_RESPONSE_CANCEL;
+
+  g_printerr ("Thunar: %s (%s)\n", message,
+              response == THUNAR_JOB_RESPONSE_CANCEL ? "cancelled" : "skipped");
+
+  return response;
+}
+
+
+
+static ThunarJobResponse
+thunar_headless_job_ask_replace (ThunarJob      *job,
+                                 ThunarFile     *src_file,
+                                 ThunarFile     *dst_file,
+                                 ThunarHeadless *headless)
+{
+  return headless->replace_response;
+}
+
+
+
+static void
+thunar_headless_job_error (ThunarJob      *job,
+                           GError         *error,
+                           ThunarHeadless *headless)
+{
+  g_printerr ("Thunar: %s\n", error->message);
+}
+
+
+
+static void
+thunar_headless_job_finished (ThunarJob      *job,
+                              ThunarHeadless *headless)
+{
+  g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, headless);
+  headless->jobs = g_list_remove (headless->jobs, job);
+  g_object_unref (job);
+
+  thunar_headless_schedule_quit (headless);
+}
+
+
+
+static void
+thunar_headless_launch (ThunarHeadless *headless,
+                        ThunarJob      *job)
+{
+  if (headless->idle_timer_id != 0)
+    {
+      g_source_remove (headless->idle_timer_id);
+      headless->idle_timer_id = 0;
+    }
+
+  g_signal_connect (job, "ask", G_CALLBACK (thunar_headless_job_ask), headless);
+  g_signal_connect (job, "ask-replace", G_CALLBACK (thunar_headless_job_ask_replace), headless);
+  g_signal_connect (job, "error", G_CALLBACK (thunar_headless_job_error), headless);
+  g_signal_connect (job, "finished", G_CALLBACK (thunar_headless_job_finished), headless);
+
+  /* the reference is released when the job is finished */
+  headless->jobs = g_list_prepend (headless->jobs, job);
+  exo_job_launch (EXO_JOB (job));
+}
+
+
+
+static gboolean
+thunar_headless_transfer_files (ThunarHeadless        *headless,
+                                GDBusMethodInvocation *invocation,
+                                const gchar           *method,
+                                const gchar           *working_directory,
+                                const gchar * const   *source_filenames,
+                                const gchar * const   *target_filenames)
+{
+  ThunarJob *job;
+  GError    *err = NULL;
+  GFile     *file;
+  GList     *source_file_list = NULL;
+  GList     *target_file_list = NULL;
+  GList     *lp;
+  gchar     *base_name;
+
+  if (source_filenames == NULL || *source_filenames == NULL)
+    {
+      g_set_error (&err, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   _("At least one source filename must be specified"));
+      goto out;
+    }
+
+  if (!thunar_headless_collect_files (working_directory, source_filenames, &source_file_list, &err)
+      || !thunar_headless_collect_files (working_directory, target_filenames, &target_file_list, &err))
+    goto out;
+
+  if (strcmp (method, "CopyTo") == 0)
+    {
+      if (g_list_length (source_file_list) != g_list_length (target_file_list))
+        {
+          g_set_error (&err, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       _("The number of source and target filenames must be the same"));
+          goto out;
+        }
+    }
+  else
+    {
+      if (target_file_list == NULL)
+        {
+          g_set_error (&err, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       _("A destination directory must be specified"));
+          goto out;
+        }
+
+      /* generate the target path list, like thunar_application_copy_into() */
+      file = target_file_list->data;
+      target_file_list->data = NULL;
+      thunar_g_list_free_full (target_file_list);
+      target_file_list = NULL;
+
+      for (lp = g_list_last (source_file_list); lp != NULL; lp = lp->prev)
+        {
+          if (G_UNLIKELY (thunar_g_file_is_root (lp->data)))
+            {
+              g_set_error (&err, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s", g_strerror (EINVAL));
+              g_object_unref (file);
+              goto out;
+            }
+
+          base_name = g_file_get_basename (lp->data);
+          target_file_list = g_list_prepend (target_file_list, g_file_resolve_relative_path (file, base_name));
+          g_free (base_name);
+        }
+
+      g_object_unref (file);
+    }
+
+  if (strcmp (method, "CopyTo") == 0 || strcmp (method, "CopyInto") == 0)
+    job = thunar_io_jobs_copy_files (source_file_list, target_file_list);
+  else if (strcmp (method, "UpdateInto") == 0)
+    job = thunar_io_jobs_update_files (source_file_list, target_file_list);
+  else if (strcmp (method, "MoveInto") == 0)
+    job = thunar_io_jobs_move_files (source_file_list, target_file_list);
+  else
+    job = thunar_io_jobs_link_files (source_file_list, target_file_list);
+
+  thunar_headless_launch (headless, job);
+
+out:
+  thunar_g_list_free_full (source_file_list);
+  thunar_g_list_free_full (target_file_list);
+
+  /* the method returns once the job is started, like in the file manager */
+  if (err != NULL)
+    g_dbus_method_invocation_take_error (invocation, err);
+  else
+    g_dbus_method_invocation_return_value (invocation, NULL);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_headless_copy_to (ThunarDBusFileManager  *object,
+                         GDBusMethodInvocation  *invocation,
+                         const gchar            *working_directory,
+                         gchar                 **source_filenames,
+                         gchar                 **target_filenames,
+                         const gchar            *display,
+                         const gchar            *startup_id,
+                         ThunarHeadless         *headless)
+{
+  return thunar_headless_transfer_files (headless, invocation, "CopyTo", working_directory,
+                                         (const gchar * const *) source_filenames,
+                                         (const gchar * const *) target_filenames);
+}
+
+
+
+static gboolean
+thunar_headless_copy_into (ThunarDBusFileManager  *object,
+                           GDBusMethodInvocation  *invocation,
+                           const gchar            *working_directory,
+                           gchar                 **source_filenames,
+                           const gchar            *target_filename,
+                           const gchar            *display,
+                           const gchar            *startup_id,
+                           ThunarHeadless         *headless)
+{
+  const gchar *target_filenames[2] = { target_filename, NULL };
+
+  return thunar_headless_transfer_files (headless, invocation, "CopyInto", working_directory,
+                                         (const gchar * const *) source_filenames, target_filenames);
+}
+
+
+
+static gboolean
+thunar_headless_update_into (ThunarDBusFileManager  *object,
+                             GDBusMethodInvocation  *invocation,
+                             const gchar            *working_directory,
+                             gchar                 **source_filenames,
+                             const gchar            *target_filename,
+                             const gchar            *display,
+                             const gchar            *startup_id,
+                             ThunarHeadless         *headless)
+{
+  const gchar *target_filenames[2] = { target_filename, NULL };
+
+  return thunar_headless_transfer_files (headless, invocation, "UpdateInto", working_directory,
+                                         (const gchar * const *) source_filenames, target_filenames);
+}
+
+
+
+static gboolean
+thunar_headless_move_into (ThunarDBusFileManager  *object,
+                           GDBusMethodInvocation  *invocation,
+                           const gchar            *working_directory,
+                           gchar                 **source_filenames,
+                           const gchar            *target_filename,
+                           const gchar            *display,
+                           const gchar            *startup_id,
+                           ThunarHeadless         *headless)
+{
+  const gchar *target_filenames[2] = { target_filename, NULL };
+
+  return thunar_headless_transfer_files (headless, invocation, "MoveInto", working_directory,
+                                         (const gchar * const *) source_filenames, target_filenames);
+}
+
+
+
+static gboolean
+thunar_headless_link_into (ThunarDBusFileManager  *object,
+                           GDBusMethodInvocation  *invocation,
+                           const gchar            *working_directory,
+                           gchar                 **source_filenames,
+                           const gchar            *target_filename,
+                           const gchar            *display,
+                           const gchar            *startup_id,
+                           ThunarHeadless         *headless)
+{
+  const gchar *target_filenames[2] = { target_filename, NULL };
+
+  return thunar_headless_transfer_files (headless, invocation, "LinkInto", working_directory,
+                                         (const gchar * const *) source_filenames, target_filenames);
+}
+
+
+
+static gboolean
+thunar_headless_unlink_files (ThunarDBusFileManager  *object,
+                              GDBusMethodInvocation  *invocation,
+                              const gchar            *working_directory,
+                              gchar                 **filenames,
+                              const gchar            *display,
+                              const gchar            *startup_id,
+                              ThunarHeadless         *headless)
+{
+  GError *err = NULL;
+  GList  *file_list = NULL;
+
+  /* there is no confirmation, the caller asked for exactly this */
+  if (filenames == NULL || *filenames == NULL)
+    g_set_error (&err, G_FILE_ERROR, G_FILE_ERROR_INVAL, _("At least one filename must be specified"));
+  else if (thunar_headless_collect_files (working_directory, (const gchar * const *) filenames, &file_list, &err))
+    thunar_headless_launch (headless, thunar_io_jobs_unlink_files (file_list));
+
+  thunar_g_list_free_full (file_list);
+
+  if (err != NULL)
+    g_dbus_method_invocation_take_error (invocation, err);
+  else
+    thunar_dbus_file_manager_complete_unlink_files (object, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_headless_move_to_trash (ThunarDBusTrash        *object,
+                               GDBusMethodInvocation  *invocation,
+                               gchar                 **filenames,
+                               const gchar            *display,
+                               const gchar            *startup_id,
+                               ThunarHeadless         *headless)
+{
+  GError *err = NULL;
+  GList  *file_list = NULL;
+
+  if (filenames != NULL && *filenames != NULL
+      && thunar_headless_collect_files (NULL, (const gchar * const *) filenames, &file_list, &err))
+    thunar_headless_launch (headless, thunar_io_jobs_trash_files (file_list));
+
+  thunar_g_list_free_full (file_list);
+
+  if (err != NULL)
+    g_dbus_method_invocation_take_error (invocation, err);
+  else
+    thunar_dbus_trash_complete_move_to_trash (object, invocation);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_headless_bus_acquired (GDBusConnection *connection,
+                              const gchar     *name,
+                              gpointer         user_data)
+{
+  ThunarHeadless *headless = user_data;
+  GError         *error = NULL;
+
+  if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (headless->file_manager),
+                                         connection, "/org/xfce/FileManager", &error)
+      || !g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (headless->trash),
+                                            connection, "/org/xfce/FileManager", &error))
+    {
+      g_printerr ("Thunar: Failed to export the file operations: %s\n", error->message);
+      g_error_free (error);
+
+      headless->exit_status = EXIT_FAILURE;
+      g_main_loop_quit (headless->loop);
+    }
+}
+
+
+
+static void
+thunar_headless_name_acquired (GDBusConnection *connection,
+                               const gchar     *name,
+                               gpointer         user_data)
+{
+  ThunarHeadless *headless = user_data;
+
+  g_debug ("Acquired the name '%s' on the session message bus", name);
+
+  /* quit if nobody asks for anything */
+  thunar_headless_schedule_quit (headless);
+}
+
+
+
+static void
+thunar_headless_name_lost (GDBusConnection *connection,
+                           const gchar     *name,
+                           gpointer         user_data)
+{
+  ThunarHeadless *headless = user_data;
+
+  /* usually the file manager is already running on this bus */
+  g_printerr ("Thunar: Failed to acquire the name '%s' on the session message bus\n", name);
+
+  headless->exit_status = EXIT_FAILURE;
+  g_main_loop_quit (headless->loop);
+}
+
+
+
+static gboolean
+thunar_headless_terminate (gpointer user_data)
+{
+  ThunarHeadless *headless = user_data;
+
+  g_main_loop_quit (headless->loop);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_headless_requested:
+ * @argc : the number of arguments in @argv.
+ * @argv : the command line arguments.
+ *
+ * Checks whether Thunar was started with --headless, before the command line
+ * is parsed by the #ThunarApplication.
+ *
+ * Return value: %TRUE if the headless mode should be run.
+ **/
+gboolean
+thunar_headless_requested (gint    argc,
+                           gchar **argv)
+{
+  gint n;
+
+  for (n = 1; n < argc; ++n)
+    {
+      /* everything after -- is a filename */
+      if (strcmp (argv[n], "--") == 0)
+        break;
+
+      if (strcmp (argv[n], "--headless") == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_headless_run:
+ * @argc : the number of arguments in @argv.
+ * @argv : the command line arguments.
+ *
+ * Runs the file operations of the org.xfce.FileManager D-BUS interface
+ * without a display until Thunar receives SIGTERM or SIGINT, or until it
+ * was idle for the time given with --idle-timeout. GTK+ is never
+ * initialized. The conflicts with existing files are resolved by the
+ * --conflicts policy, "skip" by default.
+ *
+ * Return value: the exit status of the process.
+ **/
+gint
+thunar_headless_run (gint    argc,
+                     gchar **argv)
+{
+  ThunarHeadless  headless = { NULL, };
+  GOptionContext *context;
+  GError         *error = NULL;
+  gboolean        opt_headless = FALSE;
+  gchar          *opt_conflicts = NULL;
+  gint            opt_idle_timeout = 0;
+  GList          *lp;
+  GOptionEntry    entries[] =
+  {
+    { "headless", 0, 0, G_OPTION_ARG_NONE, &opt_headless, N_ ("Run the file operations without a display"), NULL, },
+    { "conflicts", 0, 0, G_OPTION_ARG_STRING, &opt_conflicts, N_ ("Resolve existing files with skip, replace or cancel"), N_ ("POLICY"), },
+    { "idle-timeout", 0, 0, G_OPTION_ARG_INT, &opt_idle_timeout, N_ ("Quit after SECONDS without file operations"), N_ ("SECONDS"), },
+    { NULL, },
+  };
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Thunar: %s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (context);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (context);
+
+  if (opt_conflicts == NULL || strcmp (opt_conflicts, "skip") == 0)
+    headless.replace_response = THUNAR_JOB_RESPONSE_SKIP_ALL;
+  else if (strcmp (opt_conflicts, "replace") == 0)
+    headless.replace_response = THUNAR_JOB_RESPONSE_REPLACE_ALL;
+  else if (strcmp (opt_conflicts, "cancel") == 0)
+    headless.replace_response = THUNAR_JOB_RESPONSE_CANCEL;
+  else
+    {
+      g_printerr ("Thunar: Unknown conflict policy \"%s\"\n", opt_conflicts);
+      g_free (opt_conflicts);
+      return EXIT_FAILURE;
+    }
+  g_free (opt_conflicts);
+
+  headless.loop = g_main_loop_new (NULL, FALSE);
+  headless.exit_status = EXIT_SUCCESS;
+  headless.idle_timeout = MAX (opt_idle_timeout, 0);
+  headless.application = thunar_application_get ();
+
+  headless.file_manager = thunar_dbus_file_manager_skeleton_new ();
+  g_signal_connect (headless.file_manager, "handle-copy-to", G_CALLBACK (thunar_headless_copy_to), &headless);
+  g_signal_connect (headless.file_manager, "handle-copy-into", G_CALLBACK (thunar_headless_copy_into), &headless);
+  g_signal_connect (headless.file_manager, "handle-update-into", G_CALLBACK (thunar_headless_update_into), &headless);
+  g_signal_connect (headless.file_manager, "handle-move-into", G_CALLBACK (thunar_headless_move_into), &headless);
+  g_signal_connect (headless.file_manager, "handle-link-into", G_CALLBACK (thunar_headless_link_into), &headless);
+  g_signal_connect (headless.file_manager, "handle-unlink-files", G_CALLBACK (thunar_headless_unlink_files), &headless);
+
+  headless.trash = thunar_dbus_trash_skeleton_new ();
+  g_signal_connect (headless.trash, "handle-move-to-trash", G_CALLBACK (thunar_headless_move_to_trash), &headless);
+
+  headless.owner_id = g_bus_own_name (G_BUS_TYPE_SESSION, "org.xfce.FileManager",
+                                      G_BUS_NAME_OWNER_FLAGS_NONE,
+                                      thunar_headless_bus_acquired,
+                                      thunar_headless_name_acquired,
+                                      thunar_headless_name_lost,
+                                      &headless, NULL);
+
+  g_unix_signal_add (SIGTERM, thunar_headless_terminate, &headless);
+  g_unix_signal_add (SIGINT, thunar_headless_terminate, &headless);
+
+  g_main_loop_run (headless.loop);
+
+  g_bus_unown_name (headless.owner_id);
+
+  if (headless.idle_timer_id != 0)
+    g_source_remove (headless.idle_timer_id);
+
+  /* the jobs still running are stopped, they must not outlive the process */
+  for (lp = headless.jobs; lp != NULL; lp = lp->next)
+    {
+      g_signal_handlers_disconnect_matched (lp->data, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, &headless);
+      exo_job_cancel (EXO_JOB (lp->data));
+      g_object_unref (lp->data);
+    }
+  g_list_free (headless.jobs);
+
+  g_object_unref (headless.file_manager);
+  g_object_unref (headless.trash);
+  g_object_unref (headless.application);
+  g_main_loop_unref (headless.loop);
+
+  return headless.exit_status;
+}
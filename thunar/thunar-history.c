@@ -21,11 +21,16 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
 #include <thunar/thunar-history.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-navigator.h>
+#include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-dialogs.h>
 
@@ -49,6 +54,10 @@ enum
 
 
 
+typedef struct _ThunarHistoryEntry ThunarHistoryEntry;
+
+
+
 static void            thunar_history_navigator_init         (ThunarNavigatorIface *iface);
 static void            thunar_history_finalize               (GObject              *object);
 static void            thunar_history_get_property           (GObject              *object,
@@ -62,10 +71,16 @@ static void            thunar_history_set_property           (GObject
 static ThunarFile     *thunar_history_get_current_directory  (ThunarNavigator      *navigator);
 static void            thunar_history_set_current_directory  (ThunarNavigator      *navigator,
                                                               ThunarFile           *current_directory);
+static ThunarHistoryEntry *thunar_history_entry_get          (ThunarFile           *file);
+static ThunarHistoryEntry *thunar_history_entry_ref          (ThunarHistoryEntry   *entry);
+static void            thunar_history_entry_unref            (ThunarHistoryEntry   *entry);
+static void            thunar_history_push                   (ThunarHistory        *history,
+                                                              GSList              **list,
+                                                              ThunarFile           *directory);
 static void            thunar_history_go_back                (ThunarHistory        *history,
-                                                              GFile                *goto_file);
+                                                              ThunarHistoryEntry   *goto_entry);
 static void            thunar_history_go_forward             (ThunarHistory        *history,
-                                                              GFile                *goto_file);
+                                                              ThunarHistoryEntry   *goto_entry);
 static void            thunar_history_action_back_nth        (GtkWidget            *item,
                                                               ThunarHistory        *history);
 static void            thunar_history_action_forward_nth     (GtkWidget            *item,
@@ -79,10 +94,21 @@ struct _ThunarHistory
 
   ThunarFile     *current_directory;
 
+  /* lists of ThunarHistoryEntry's, most recent first */
   GSList         *back_list;
   GSList         *forward_list;
 };
 
+/* a visited location, shared by all histories (and their copies)
+ * that contain it, so opening tabs or browsing back and forth only
+ * touches reference counts */
+struct _ThunarHistoryEntry
+{
+  gint   ref_count;
+  GFile *file;
+  gchar *display_name;
+};
+
 static guint history_signals[LAST_SIGNAL];
 
 G_DEFINE_TYPE_WITH_CODE (ThunarHistory, thunar_history, G_TYPE_OBJECT,
@@ -90,8 +116,11 @@ G_DEFINE_TYPE_WITH_CODE (ThunarHistory, thunar_history, G_TYPE_OBJECT,
 
 
 
-static GQuark thunar_history_display_name_quark;
-static GQuark thunar_history_gfile_quark;
+static GQuark      thunar_history_entry_quark;
+static GHashTable *thunar_history_entries = NULL;
+
+/* all live histories, for thunar_history_get_memory() */
+static GList      *thunar_history_live = NULL;
 
 
 
@@ -105,8 +134,10 @@ thunar_history_class_init (ThunarHistoryClass *klass)
   gobject_class->get_property = thunar_history_get_property;
   gobject_class->set_property = thunar_history_set_property;
 
-  thunar_history_display_name_quark = g_quark_from_static_string ("thunar-history-display-name");
-  thunar_history_gfile_quark = g_quark_from_static_string ("thunar-history-gfile");
+  thunar_history_entry_quark = g_quark_from_static_string ("thunar-history-entry");
+
+  /* the table of history entries, indexed by their location */
+  thunar_history_entries = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
 
   /**
    * ThunarHistory::current-directory:
@@ -141,7 +172,7 @@ thunar_history_navigator_init (ThunarNavigatorIface *iface)
 static void
 thunar_history_init (ThunarHistory *history)
 {
-
+  thunar_history_live = g_list_prepend (thunar_history_live, history);
 }
 
 
@@ -152,8 +183,14 @@ thunar_history_finalize (GObject *object)
   ThunarHistory *history = THUNAR_HISTORY (object);
 
   /* release the "forward" and "back" lists */
-  g_slist_free_full (history->forward_list, g_object_unref);
-  g_slist_free_full (history->back_list, g_object_unref);
+  g_slist_free_full (history->forward_list, (GDestroyNotify) thunar_history_entry_unref);
+  g_slist_free_full (history->back_list, (GDestroyNotify) thunar_history_entry_unref);
+
+  /* release the current directory */
+  if (G_LIKELY (history->current_directory != NULL))
+    g_object_unref (history->current_directory);
+
+  thunar_history_live = g_list_remove (thunar_history_live, history);
 
   (*G_OBJECT_CLASS (thunar_history_parent_class)->finalize) (object);
 }
@@ -212,21 +249,96 @@ thunar_history_get_current_directory (ThunarNavigator *navigator)
 
 
 
-static GFile *
-thunar_history_get_gfile (ThunarFile *file)
+static ThunarHistoryEntry *
+thunar_history_entry_get (ThunarFile *file)
 {
-  GFile       *gfile;
-  const gchar *display_name;
+  ThunarHistoryEntry *entry;
+  const gchar        *display_name;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
-  gfile = thunar_file_get_file (file);
-
   display_name = thunar_file_get_display_name (file);
-  g_object_set_qdata_full (G_OBJECT (gfile), thunar_history_display_name_quark,
-                           g_strdup (display_name), g_free);
 
-  return g_object_ref (gfile);
+  /* check if the location is already known */
+  entry = g_hash_table_lookup (thunar_history_entries, thunar_file_get_file (file));
+  if (G_LIKELY (entry != NULL))
+    {
+      /* the folder may have been renamed in the meantime */
+      if (g_strcmp0 (entry->display_name, display_name) != 0)
+        {
+          g_free (entry->display_name);
+          entry->display_name = g_strdup (display_name);
+        }
+
+      return thunar_history_entry_ref (entry);
+    }
+
+  entry = g_slice_new (ThunarHistoryEntry);
+  entry->ref_count = 1;
+  entry->file = g_object_ref (thunar_file_get_file (file));
+  entry->display_name = g_strdup (display_name);
+  g_hash_table_insert (thunar_history_entries, entry->file, entry);
+
+  return entry;
+}
+
+
+
+static ThunarHistoryEntry *
+thunar_history_entry_ref (ThunarHistoryEntry *entry)
+{
+  _thunar_return_val_if_fail (entry->ref_count > 0, NULL);
+
+  entry->ref_count += 1;
+  return entry;
+}
+
+
+
+static void
+thunar_history_entry_unref (ThunarHistoryEntry *entry)
+{
+  _thunar_return_if_fail (entry->ref_count > 0);
+
+  if (--entry->ref_count == 0)
+    {
+      g_hash_table_remove (thunar_history_entries, entry->file);
+      g_object_unref (entry->file);
+      g_free (entry->display_name);
+      g_slice_free (ThunarHistoryEntry, entry);
+    }
+}
+
+
+
+static void
+thunar_history_push (ThunarHistory  *history,
+                     GSList        **list,
+                     ThunarFile     *directory)
+{
+  ThunarPreferences *preferences;
+  GSList            *lp;
+  guint              depth;
+
+  _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
+  _thunar_return_if_fail (THUNAR_IS_FILE (directory));
+
+  *list = g_slist_prepend (*list, thunar_history_entry_get (directory));
+
+  /* drop the oldest entries beyond the configured depth */
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-history-depth", &depth, NULL);
+  g_object_unref (G_OBJECT (preferences));
+
+  if (depth > 0)
+    {
+      lp = g_slist_nth (*list, depth - 1);
+      if (lp != NULL && lp->next != NULL)
+        {
+          g_slist_free_full (lp->next, (GDestroyNotify) thunar_history_entry_unref);
+          lp->next = NULL;
+        }
+    }
 }
 
 
@@ -236,7 +348,6 @@ thunar_history_set_current_directory (ThunarNavigator *navigator,
                                       ThunarFile      *current_directory)
 {
   ThunarHistory *history = THUNAR_HISTORY (navigator);
-  GFile         *gfile;
 
   /* verify that we don't already use that directory */
   if (G_UNLIKELY (current_directory == history->current_directory))
@@ -247,22 +358,20 @@ thunar_history_set_current_directory (ThunarNavigator *navigator,
    * history */
   if (current_directory != NULL
       && history->forward_list != NULL
-      && g_file_equal (thunar_file_get_file (current_directory), history->forward_list->data))
+      && g_file_equal (thunar_file_get_file (current_directory), ((ThunarHistoryEntry *) history->forward_list->data)->file))
     {
       thunar_history_go_forward (history, history->forward_list->data);
     }
   else
     {
       /* clear the "forward" list */
-      g_slist_free_full (history->forward_list, g_object_unref);
+      g_slist_free_full (history->forward_list, (GDestroyNotify) thunar_history_entry_unref);
       history->forward_list = NULL;
 
       /* prepend the previous current directory to the "back" list */
       if (G_LIKELY (history->current_directory != NULL))
         {
-          gfile = thunar_history_get_gfile (history->current_directory);
-          history->back_list = g_slist_prepend (history->back_list, gfile);
-
+          thunar_history_push (history, &history->back_list, history->current_directory);
           g_object_unref (history->current_directory);
         }
 
@@ -314,29 +423,32 @@ thunar_history_error_not_found (GFile    *goto_file,
 
 
 static void
-thunar_history_go_back (ThunarHistory  *history,
-                        GFile          *goto_file)
+thunar_history_go_back (ThunarHistory      *history,
+                        ThunarHistoryEntry *goto_entry)
 {
-  GFile      *gfile;
   GSList     *lp;
   GSList     *lnext;
   ThunarFile *directory;
 
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
-  _thunar_return_if_fail (G_IS_FILE (goto_file));
+  _thunar_return_if_fail (goto_entry != NULL);
 
   /* check if the directory still exists */
-  directory = thunar_file_get (goto_file, NULL);
+  directory = thunar_file_get (goto_entry->file, NULL);
   if (directory == NULL || ! thunar_file_is_mounted (directory))
     {
-      thunar_history_error_not_found (goto_file, NULL);
+      thunar_history_error_not_found (goto_entry->file, NULL);
+
+      if (directory != NULL)
+        g_object_unref (directory);
 
       /* delete item from the history */
-      lp = g_slist_find (history->back_list, goto_file);
+      lp = g_slist_find (history->back_list, goto_entry);
       if (lp != NULL)
         {
-          g_object_unref (lp->data);
-          history->back_list = g_slist_delete_link (history->back_list, lp);
+          history->back_list = g_slist_remove_link (history->back_list, lp);
+          thunar_history_entry_unref (lp->data);
+          g_slist_free_1 (lp);
         }
       return;
     }
@@ -344,8 +456,7 @@ thunar_history_go_back (ThunarHistory  *history,
   /* prepend the previous current directory to the "forward" list */
   if (G_LIKELY (history->current_directory != NULL))
     {
-      gfile = thunar_history_get_gfile (history->current_directory);
-      history->forward_list = g_slist_prepend (history->forward_list, gfile);
+      thunar_history_push (history, &history->forward_list, history->current_directory);
 
       g_object_unref (history->current_directory);
       history->current_directory = NULL;
@@ -357,14 +468,15 @@ thunar_history_go_back (ThunarHistory  *history,
     {
       lnext = lp->next;
 
-      if (g_file_equal (goto_file, G_FILE (lp->data)))
+      if (lp->data == goto_entry)
         {
           if (directory != NULL)
             history->current_directory = g_object_ref (directory);
 
           /* remove the new directory from the list */
-          g_object_unref (lp->data);
-          history->back_list = g_slist_delete_link (history->back_list, lp);
+          history->back_list = g_slist_remove_link (history->back_list, lp);
+          thunar_history_entry_unref (lp->data);
+          g_slist_free_1 (lp);
 
           break;
         }
@@ -388,29 +500,32 @@ thunar_history_go_back (ThunarHistory  *history,
 
 
 static void
-thunar_history_go_forward (ThunarHistory  *history,
-                           GFile          *goto_file)
+thunar_history_go_forward (ThunarHistory      *history,
+                           ThunarHistoryEntry *goto_entry)
 {
-  GFile      *gfile;
   GSList     *lnext;
   GSList     *lp;
   ThunarFile *directory;
 
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
-  _thunar_return_if_fail (G_IS_FILE (goto_file));
+  _thunar_return_if_fail (goto_entry != NULL);
 
   /* check if the directory still exists */
-  directory = thunar_file_get (goto_file, NULL);
+  directory = thunar_file_get (goto_entry->file, NULL);
   if (directory == NULL || ! thunar_file_is_mounted (directory))
     {
-      thunar_history_error_not_found (goto_file, NULL);
+      thunar_history_error_not_found (goto_entry->file, NULL);
+
+      if (directory != NULL)
+        g_object_unref (directory);
 
       /* delete item from the history */
-      lp = g_slist_find (history->forward_list, goto_file);
+      lp = g_slist_find (history->forward_list, goto_entry);
       if (lp != NULL)
         {
-          g_object_unref (lp->data);
-          history->forward_list = g_slist_delete_link (history->forward_list, lp);
+          history->forward_list = g_slist_remove_link (history->forward_list, lp);
+          thunar_history_entry_unref (lp->data);
+          g_slist_free_1 (lp);
         }
       return;
     }
@@ -418,8 +533,7 @@ thunar_history_go_forward (ThunarHistory  *history,
   /* prepend the previous current directory to the "back" list */
   if (G_LIKELY (history->current_directory != NULL))
     {
-      gfile = thunar_history_get_gfile (history->current_directory);
-      history->back_list = g_slist_prepend (history->back_list, gfile);
+      thunar_history_push (history, &history->back_list, history->current_directory);
 
       g_object_unref (history->current_directory);
       history->current_directory = NULL;
@@ -429,14 +543,15 @@ thunar_history_go_forward (ThunarHistory  *history,
     {
       lnext = lp->next;
 
-      if (g_file_equal (goto_file, G_FILE (lp->data)))
+      if (lp->data == goto_entry)
         {
           if (directory != NULL)
             history->current_directory = g_object_ref (directory);
 
           /* remove the new dirctory from the list */
-          g_object_unref (lp->data);
-          history->forward_list = g_slist_delete_link (history->forward_list, lp);
+          history->forward_list = g_slist_remove_link (history->forward_list, lp);
+          thunar_history_entry_unref (lp->data);
+          g_slist_free_1 (lp);
 
           break;
         }
@@ -475,14 +590,14 @@ static void
 thunar_history_action_back_nth (GtkWidget     *item,
                                 ThunarHistory *history)
 {
-  GFile *file;
+  ThunarHistoryEntry *entry;
 
   _thunar_return_if_fail (GTK_IS_MENU_ITEM (item));
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
 
-  file = g_object_get_qdata (G_OBJECT (item), thunar_history_gfile_quark);
-  if (G_LIKELY (file != NULL))
-    thunar_history_go_back (history, file);
+  entry = g_object_get_qdata (G_OBJECT (item), thunar_history_entry_quark);
+  if (G_LIKELY (entry != NULL))
+    thunar_history_go_back (history, entry);
 }
 
 
@@ -503,14 +618,14 @@ static void
 thunar_history_action_forward_nth (GtkWidget     *item,
                                    ThunarHistory *history)
 {
-  GFile *file;
+  ThunarHistoryEntry *entry;
 
   _thunar_return_if_fail (GTK_IS_MENU_ITEM (item));
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
 
-  file = g_object_get_qdata (G_OBJECT (item), thunar_history_gfile_quark);
-  if (G_LIKELY (file != NULL))
-    thunar_history_go_forward (history, file);
+  entry = g_object_get_qdata (G_OBJECT (item), thunar_history_entry_quark);
+  if (G_LIKELY (entry != NULL))
+    thunar_history_go_forward (history, entry);
 }
 
 
@@ -520,18 +635,18 @@ thunar_history_show_menu (ThunarHistory         *history,
                           ThunarHistoryMenuType  type,
                           GtkWidget             *parent)
 {
-  ThunarIconFactory *icon_factory;
-  GtkIconTheme      *icon_theme;
-  GCallback          handler;
-  GtkWidget         *image;
-  GtkWidget         *menu;
-  GtkWidget         *item;
-  GdkPixbuf         *icon;
-  GSList            *lp;
-  ThunarFile        *file;
-  const gchar       *display_name;
-  const gchar       *icon_name;
-  gchar             *parse_name;
+  ThunarIconFactory  *icon_factory;
+  GtkIconTheme       *icon_theme;
+  GCallback           handler;
+  GtkWidget          *image;
+  GtkWidget          *menu;
+  GtkWidget          *item;
+  GdkPixbuf          *icon;
+  GSList             *lp;
+  ThunarFile         *file;
+  ThunarHistoryEntry *entry;
+  const gchar        *icon_name;
+  gchar              *parse_name;
 
   _thunar_return_if_fail (GTK_IS_WIDGET (parent));
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
@@ -559,8 +674,9 @@ thunar_history_show_menu (ThunarHistory         *history,
   /* add menu items for all list items */
   for (;lp != NULL; lp = lp->next)
     {
-      parse_name = g_file_get_parse_name (lp->data);
-      file = thunar_file_cache_lookup (lp->data);
+      entry = lp->data;
+      parse_name = g_file_get_parse_name (entry->file);
+      file = thunar_file_cache_lookup (entry->file);
       image = NULL;
       if (file != NULL)
         {
@@ -579,11 +695,11 @@ thunar_history_show_menu (ThunarHistory         *history,
       if (image == NULL)
         {
           /* some custom likely alternatives */
-          if (thunar_g_file_is_home (lp->data))
+          if (thunar_g_file_is_home (entry->file))
             icon_name = "user-home";
-          else if (!g_file_has_uri_scheme (lp->data, "file"))
+          else if (!g_file_has_uri_scheme (entry->file, "file"))
             icon_name = "folder-remote";
-          else if (thunar_g_file_is_root (lp->data))
+          else if (thunar_g_file_is_root (entry->file))
             icon_name = "drive-harddisk";
           else
             icon_name = "folder";
@@ -592,10 +708,10 @@ thunar_history_show_menu (ThunarHistory         *history,
         }
 
       /* add an item for this file */
-      display_name = g_object_get_qdata (G_OBJECT (lp->data), thunar_history_display_name_quark);
-      item = xfce_gtk_image_menu_item_new (display_name, parse_name, NULL,
+      item = xfce_gtk_image_menu_item_new (entry->display_name, parse_name, NULL,
                                            NULL, NULL, image, GTK_MENU_SHELL (menu));
-      g_object_set_qdata (G_OBJECT (item), thunar_history_gfile_quark, lp->data);
+      g_object_set_qdata_full (G_OBJECT (item), thunar_history_entry_quark,
+                               thunar_history_entry_ref (entry), (GDestroyNotify) thunar_history_entry_unref);
       g_signal_connect (G_OBJECT (item), "activate", handler, history);
 
       g_free (parse_name);
@@ -615,7 +731,6 @@ ThunarHistory *
 thunar_history_copy (ThunarHistory *history)
 {
   ThunarHistory *copy;
-  GSList        *lp;
 
   _thunar_return_val_if_fail (history == NULL || THUNAR_IS_HISTORY (history), NULL);
 
@@ -627,13 +742,9 @@ thunar_history_copy (ThunarHistory *history)
   /* take a ref on the current directory */
   copy->current_directory = g_object_ref (history->current_directory);
 
-  /* copy the back list */
-  for (lp = history->back_list; lp != NULL; lp = lp->next)
-      copy->back_list = g_slist_append (copy->back_list, g_object_ref (G_OBJECT (lp->data)));
-
-  /* copy the forward list */
-  for (lp = history->forward_list; lp != NULL; lp = lp->next)
-      copy->forward_list = g_slist_append (copy->forward_list, g_object_ref (G_OBJECT (lp->data)));
+  /* share the entries of the back and forward lists */
+  copy->back_list = g_slist_copy_deep (history->back_list, (GCopyFunc) thunar_history_entry_ref, NULL);
+  copy->forward_list = g_slist_copy_deep (history->forward_list, (GCopyFunc) thunar_history_entry_ref, NULL);
 
   return copy;
 }
@@ -692,7 +803,7 @@ thunar_history_peek_back (ThunarHistory *history)
 
   /* pick the first (conceptually the last) file in the back list, if there are any */
   if (history->back_list != NULL)
-    result = thunar_file_get (history->back_list->data, NULL);
+    result = thunar_file_get (((ThunarHistoryEntry *) history->back_list->data)->file, NULL);
 
   return result;
 }
@@ -719,7 +830,7 @@ thunar_history_peek_forward (ThunarHistory *history)
 
   /* pick the first file in the forward list, if there are any */
   if (history->forward_list != NULL)
-    result = thunar_file_get (history->forward_list->data, NULL);
+    result = thunar_file_get (((ThunarHistoryEntry *) history->forward_list->data)->file, NULL);
 
   return result;
 }
@@ -740,3 +851,54 @@ thunar_history_add (ThunarHistory *history,
   thunar_history_set_current_directory (THUNAR_NAVIGATOR (history), directory);
 }
 
+
+
+/**
+ * thunar_history_get_memory:
+ * @n_histories : return location for the number of live histories.
+ * @n_entries   : return location for the number of entries in their stacks.
+ * @n_bytes     : return location for the estimated memory of the histories.
+ *
+ * Estimates the memory held by the back and forward stacks of all
+ * live #ThunarHistory<!---->s and by the entries they share.
+ **/
+void
+thunar_history_get_memory (guint   *n_histories,
+                           guint64 *n_entries,
+                           guint64 *n_bytes)
+{
+  ThunarHistoryEntry *entry;
+  ThunarHistory      *history;
+  GHashTableIter      iter;
+  GList              *lp;
+  guint64             entries = 0;
+  guint64             bytes = 0;
+
+  for (lp = thunar_history_live; lp != NULL; lp = lp->next)
+    {
+      history = THUNAR_HISTORY (lp->data);
+      entries += g_slist_length (history->back_list) + g_slist_length (history->forward_list);
+      bytes += sizeof (ThunarHistory);
+    }
+
+  /* a list link is two pointers */
+  bytes += entries * 2 * sizeof (gpointer);
+
+  if (thunar_history_entries != NULL)
+    {
+      g_hash_table_iter_init (&iter, thunar_history_entries);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer) &entry))
+        {
+          bytes += sizeof (ThunarHistoryEntry) + 2 * sizeof (gpointer) + sizeof (guint);
+          if (entry->display_name != NULL)
+            bytes += strlen (entry->display_name) + 1;
+        }
+    }
+
+  if (n_histories != NULL)
+    *n_histories = g_list_length (thunar_history_live);
+  if (n_entries != NULL)
+    *n_entries = entries;
+  if (n_bytes != NULL)
+    *n_bytes = bytes;
+}
@@ -66,6 +66,10 @@ void            thunar_history_show_menu        (ThunarHistory         *history,
 void            thunar_history_add              (ThunarHistory         *history,
                                                  ThunarFile            *directory);
 
+void            thunar_history_get_memory       (guint                 *n_histories,
+                                                 guint64               *n_entries,
+                                                 guint64               *n_bytes);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_HISTORY_H__ */
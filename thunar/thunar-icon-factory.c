@@ -30,10 +30,12 @@
 #include <string.h>
 #endif
 
+#include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-scheduler.h>
 #include <thunar/thunar-util.h>
 
 
@@ -41,6 +43,15 @@
 /* the timeout until the sweeper is run (in seconds) */
 #define THUNAR_ICON_FACTORY_SWEEP_TIMEOUT (30)
 
+/* default memory ceiling of the icon cache (in MiB) */
+#define THUNAR_ICON_FACTORY_CACHE_SIZE (128)
+
+/* maximum number of threads used to decode thumbnails */
+#define THUNAR_ICON_FACTORY_DECODE_THREADS (4)
+
+/* number of icon sizes remembered per file */
+#define THUNAR_ICON_STORE_N_SLOTS (3)
+
 
 
 /* Property identifiers */
@@ -51,11 +62,15 @@ enum
   PROP_THUMBNAIL_MODE,
   PROP_THUMBNAIL_DRAW_FRAMES,
   PROP_THUMBNAIL_SIZE,
+  PROP_CACHE_SIZE,
 };
 
 
 
-typedef struct _ThunarIconKey ThunarIconKey;
+typedef struct _ThunarIconKey     ThunarIconKey;
+typedef struct _ThunarIconEntry   ThunarIconEntry;
+typedef struct _ThunarIconDecode  ThunarIconDecode;
+typedef struct _ThunarIconRefresh ThunarIconRefresh;
 
 
 
@@ -86,8 +101,17 @@ static guint      thunar_icon_key_hash                      (gconstpointer
 static gboolean   thunar_icon_key_equal                     (gconstpointer             a,
                                                              gconstpointer             b);
 static void       thunar_icon_key_free                      (gpointer                  data);
+static void       thunar_icon_entry_free                    (gpointer                  data);
+static void       thunar_icon_refresh_free                  (ThunarIconRefresh        *refresh);
+static void       thunar_icon_decode_worker                 (gpointer                  data,
+                                                             gpointer                  user_data);
 static GdkPixbuf *thunar_icon_factory_load_fallback         (ThunarIconFactory        *factory,
                                                              gint                      size);
+static GdkPixbuf *thunar_icon_factory_load_file_icon_real   (ThunarIconFactory        *factory,
+                                                             ThunarFile               *file,
+                                                             ThunarFileIconState       icon_state,
+                                                             gint                      icon_size,
+                                                             gboolean                  deferred);
 
 
 
@@ -102,7 +126,17 @@ struct _ThunarIconFactory
 
   ThunarPreferences   *preferences;
 
+  /* ThunarIconKey -> ThunarIconEntry, the lru queue has the most
+   * recently used entry at its head */
   GHashTable          *icon_cache;
+  GQueue               icon_lru;
+  gsize                icon_cache_bytes;
+  guint                cache_size;
+
+  /* cache statistics */
+  guint64              cache_hits;
+  guint64              cache_misses;
+  guint64              cache_evictions;
 
   GtkIconTheme        *icon_theme;
 
@@ -118,6 +152,16 @@ struct _ThunarIconFactory
 
   /* stamp that gets bumped when the theme changes */
   guint                theme_stamp;
+
+  /* thumbnails being decoded in the background, ThunarFile -> ThunarIconDecode */
+  GThreadPool         *decode_pool;
+  GHashTable          *decode_pending;
+
+  /* files whose themed icon is looked up again after a theme change,
+   * ThunarFile -> ThunarIconRefresh, in the order they were drawn */
+  GQueue               refresh_queue;
+  GHashTable          *refresh_pending;
+  guint                refresh_id;
 };
 
 struct _ThunarIconKey
@@ -126,14 +170,59 @@ struct _ThunarIconKey
   gint   size;
 };
 
+struct _ThunarIconEntry
+{
+  ThunarIconFactory *factory;
+  ThunarIconKey     *key;
+  GdkPixbuf         *pixbuf;
+  gsize              n_bytes;
+  GList              lru_link;
+};
+
+struct _ThunarIconDecode
+{
+  ThunarIconFactory    *factory;
+  ThunarFile           *file;
+  gchar                *path;
+  gint                  icon_size;
+  ThunarFileIconState   icon_state;
+  ThunarFileThumbState  thumb_state;
+  gboolean              draw_frames;
+
+  /* a larger thumbnail to scale down instead of decoding path */
+  GdkPixbuf            *source;
+
+  /* result of the worker thread */
+  GdkPixbuf            *icon;
+};
+
+struct _ThunarIconRefresh
+{
+  ThunarFile           *file;
+  ThunarFileIconState   icon_state;
+  gint                  icon_size;
+};
+
 typedef struct
 {
   ThunarFileIconState   icon_state;
   ThunarFileThumbState  thumb_state;
   gint                  icon_size;
   guint                 stamp;
+  guint                 age;
+  gboolean              thumbnail;
   GdkPixbuf            *icon;
 }
+ThunarIconStoreSlot;
+
+/* the icons of a file for the last few sizes it was shown at, so
+ * zooming or showing the file in the tree pane and the view at the
+ * same time does not resolve the icon over and over again */
+typedef struct
+{
+  ThunarIconStoreSlot slots[THUNAR_ICON_STORE_N_SLOTS];
+  guint               clock;
+}
 ThunarIconStore;
 
 
@@ -141,6 +230,13 @@ ThunarIconStore;
 static GQuark thunar_icon_factory_quark = 0;
 static GQuark thunar_icon_factory_store_quark = 0;
 
+/* bytes of all icons kept in the file stores, which share the
+ * memory ceiling of the icon cache */
+static gsize  thunar_icon_store_bytes = 0;
+
+/* number of file stores alive, for the memory report */
+static gint   thunar_icon_store_count = 0;
+
 
 
 G_DEFINE_TYPE (ThunarIconFactory, thunar_icon_factory, G_TYPE_OBJECT)
@@ -217,6 +313,20 @@ thunar_icon_factory_class_init (ThunarIconFactoryClass *klass)
                                                       THUNAR_TYPE_THUMBNAIL_SIZE,
                                                       THUNAR_THUMBNAIL_SIZE_NORMAL,
                                                       EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarIconFactory:cache-size:
+   *
+   * The size of the icon cache in MiB. The least recently used icons
+   * are dropped when the cache grows beyond this size.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_CACHE_SIZE,
+                                   g_param_spec_uint ("cache-size",
+                                                      "cache-size",
+                                                      "cache-size",
+                                                      1, G_MAXUINT, THUNAR_ICON_FACTORY_CACHE_SIZE,
+                                                      EXO_PARAM_READWRITE));
 }
 
 
@@ -226,6 +336,7 @@ thunar_icon_factory_init (ThunarIconFactory *factory)
 {
   factory->thumbnail_mode = THUNAR_THUMBNAIL_MODE_ONLY_LOCAL;
   factory->thumbnail_size = THUNAR_THUMBNAIL_SIZE_NORMAL;
+  factory->cache_size = THUNAR_ICON_FACTORY_CACHE_SIZE;
 
   /* connect emission hook for the "changed" signal on the GtkIconTheme class. We use the emission
    * hook way here, because that way we can make sure that the icon cache is definetly cleared
@@ -236,7 +347,14 @@ thunar_icon_factory_init (ThunarIconFactory *factory)
 
   /* allocate the hash table for the icon cache */
   factory->icon_cache = g_hash_table_new_full (thunar_icon_key_hash, thunar_icon_key_equal,
-                                               thunar_icon_key_free, g_object_unref);
+                                               thunar_icon_key_free, thunar_icon_entry_free);
+  g_queue_init (&factory->icon_lru);
+
+  /* the decode pool is allocated on demand */
+  factory->decode_pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  g_queue_init (&factory->refresh_queue);
+  factory->refresh_pending = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 
@@ -245,11 +363,22 @@ static void
 thunar_icon_factory_dispose (GObject *object)
 {
   ThunarIconFactory *factory = THUNAR_ICON_FACTORY (object);
+  ThunarIconRefresh *refresh;
 
   _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
 
   if (G_UNLIKELY (factory->sweep_timer_id != 0))
-    g_source_remove (factory->sweep_timer_id);
+    thunar_scheduler_remove (factory->sweep_timer_id);
+
+  /* forget the icons which were not refreshed yet */
+  if (G_UNLIKELY (factory->refresh_id != 0))
+    {
+      thunar_scheduler_remove (factory->refresh_id);
+      factory->refresh_id = 0;
+    }
+  while ((refresh = g_queue_pop_head (&factory->refresh_queue)) != NULL)
+    thunar_icon_refresh_free (refresh);
+  g_hash_table_remove_all (factory->refresh_pending);
 
   (*G_OBJECT_CLASS (thunar_icon_factory_parent_class)->dispose) (object);
 }
@@ -266,6 +395,13 @@ thunar_icon_factory_finalize (GObject *object)
   /* clear the icon cache hash table */
   g_hash_table_destroy (factory->icon_cache);
 
+  /* every pending decode holds a reference on the factory */
+  _thunar_assert (g_hash_table_size (factory->decode_pending) == 0);
+  g_hash_table_destroy (factory->decode_pending);
+  g_hash_table_destroy (factory->refresh_pending);
+  if (factory->decode_pool != NULL)
+    g_thread_pool_free (factory->decode_pool, FALSE, TRUE);
+
   /* remove the "changed" emission hook from the GtkIconTheme class */
   g_signal_remove_emission_hook (g_signal_lookup ("changed", GTK_TYPE_ICON_THEME), factory->changed_hook_id);
 
@@ -310,6 +446,10 @@ thunar_icon_factory_get_property (GObject    *object,
       g_value_set_enum (value, factory->thumbnail_size);
       break;
 
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, factory->cache_size);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -340,6 +480,10 @@ thunar_icon_factory_set_property (GObject      *object,
       factory->thumbnail_size = g_value_get_enum (value);
       break;
 
+    case PROP_CACHE_SIZE:
+      factory->cache_size = g_value_get_uint (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -359,7 +503,8 @@ thunar_icon_factory_changed (GSignalInvocationHint *ihint,
   /* drop all items from the icon cache */
   g_hash_table_remove_all (factory->icon_cache);
 
-  /* bump the stamp so all file icons are reloaded */
+  /* bump the stamp so the themed icons of all files are looked up
+   * again, the stored thumbnails do not depend on the theme */
   factory->theme_stamp++;
 
   /* keep the emission hook alive */
@@ -369,10 +514,10 @@ thunar_icon_factory_changed (GSignalInvocationHint *ihint,
 
 
 static gboolean
-thunar_icon_check_sweep (ThunarIconKey *key,
-                         GdkPixbuf     *pixbuf)
+thunar_icon_check_sweep (ThunarIconKey   *key,
+                         ThunarIconEntry *entry)
 {
-  return (G_OBJECT (pixbuf)->ref_count == 1);
+  return (G_OBJECT (entry->pixbuf)->ref_count == 1);
 }
 
 
@@ -459,27 +604,33 @@ thumbnail_needs_frame (const GdkPixbuf *thumbnail,
 static GdkPixbuf*
 thunar_icon_factory_get_thumbnail_frame (void)
 {
-  GInputStream *stream;
+  GInputStream     *stream;
   static GdkPixbuf *frame = NULL;
+  static gsize      frame_initialized = 0;
 
-  if (G_LIKELY (frame != NULL))
-     return frame;
+  /* thumbnails are also framed in the decode threads */
+  if (g_once_init_enter (&frame_initialized))
+    {
+      stream = g_resources_open_stream ("/org/xfce/thunar/thumbnail-frame.png", 0, NULL);
+      if (G_UNLIKELY (stream != NULL)) {
+        frame = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
+        g_object_unref (stream);
+      }
 
-  stream = g_resources_open_stream ("/org/xfce/thunar/thumbnail-frame.png", 0, NULL);
-  if (G_UNLIKELY (stream != NULL)) {
-    frame = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
-    g_object_unref (stream);
-  }
+      g_once_init_leave (&frame_initialized, 1);
+    }
 
   return frame;
 }
 
 
 
+/* loads, scales and frames the image at path, this does not touch
+ * any shared state, so it is safe to call from a worker thread */
 static GdkPixbuf*
-thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
-                                    const gchar       *path,
-                                    gint               size)
+thunar_icon_factory_decode_file (const gchar *path,
+                                 gint         size,
+                                 gboolean     draw_frames)
 {
   GdkPixbuf *pixbuf;
   GdkPixbuf *frame;
@@ -490,8 +641,6 @@ thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
   gint       width;
   gint       height;
 
-  _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
-
   /* try to load the image from the file */
   pixbuf = gdk_pixbuf_new_from_file (path, NULL);
   if (G_LIKELY (pixbuf != NULL))
@@ -501,7 +650,7 @@ thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
       height = gdk_pixbuf_get_height (pixbuf);
 
       needs_frame = FALSE;
-      if (factory->thumbnail_draw_frames)
+      if (draw_frames)
         {
           /* check if we want to add a frame to the image (we really don't
            * want to do this for icons displayed in the details view).
@@ -547,16 +696,65 @@ thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
 
 
 
+static GdkPixbuf*
+thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
+                                    const gchar       *path,
+                                    gint               size)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
+
+  return thunar_icon_factory_decode_file (path, size, factory->thumbnail_draw_frames);
+}
+
+
+
+static void
+thunar_icon_factory_cache_insert (ThunarIconFactory *factory,
+                                  const gchar       *name,
+                                  gint               size,
+                                  GdkPixbuf         *pixbuf)
+{
+  ThunarIconEntry *entry;
+  ThunarIconEntry *last;
+  gsize            max_bytes;
+
+  /* allocate a new entry, taking over the reference on the pixbuf */
+  entry = g_slice_new0 (ThunarIconEntry);
+  entry->factory = factory;
+  entry->key = g_slice_new (ThunarIconKey);
+  entry->key->size = size;
+  entry->key->name = g_strdup (name);
+  entry->pixbuf = pixbuf;
+  entry->n_bytes = gdk_pixbuf_get_byte_length (pixbuf) + strlen (name) + 1;
+  entry->lru_link.data = entry;
+
+  /* insert the new icon into the cache */
+  g_hash_table_insert (factory->icon_cache, entry->key, entry);
+  g_queue_push_head_link (&factory->icon_lru, &entry->lru_link);
+  factory->icon_cache_bytes += entry->n_bytes;
+
+  /* drop the least recently used icons until the cache fits again */
+  max_bytes = (gsize) factory->cache_size * 1024 * 1024;
+  while (factory->icon_cache_bytes > max_bytes && factory->icon_lru.length > 1)
+    {
+      last = g_queue_peek_tail (&factory->icon_lru);
+      g_hash_table_remove (factory->icon_cache, last->key);
+      factory->cache_evictions++;
+    }
+}
+
+
+
 static GdkPixbuf*
 thunar_icon_factory_lookup_icon (ThunarIconFactory *factory,
                                  const gchar       *name,
                                  gint               size,
                                  gboolean           wants_default)
 {
-  ThunarIconKey  lookup_key;
-  ThunarIconKey *key;
-  GtkIconInfo   *icon_info;
-  GdkPixbuf     *pixbuf = NULL;
+  ThunarIconKey    lookup_key;
+  ThunarIconEntry *entry;
+  GtkIconInfo     *icon_info;
+  GdkPixbuf       *pixbuf = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
   _thunar_return_val_if_fail (name != NULL && *name != '\0', NULL);
@@ -567,8 +765,20 @@ thunar_icon_factory_lookup_icon (ThunarIconFactory *factory,
   lookup_key.size = size;
 
   /* check if we already have a cached version of the icon */
-  if (!g_hash_table_lookup_extended (factory->icon_cache, &lookup_key, NULL, (gpointer) &pixbuf))
+  entry = g_hash_table_lookup (factory->icon_cache, &lookup_key);
+  if (G_LIKELY (entry != NULL))
+    {
+      /* move the icon to the front of the lru queue */
+      g_queue_unlink (&factory->icon_lru, &entry->lru_link);
+      g_queue_push_head_link (&factory->icon_lru, &entry->lru_link);
+      factory->cache_hits++;
+
+      pixbuf = entry->pixbuf;
+    }
+  else
     {
+      factory->cache_misses++;
+
       /* check if we have to load a file instead of a themed icon */
       if (G_UNLIKELY (g_path_is_absolute (name)))
         {
@@ -603,21 +813,16 @@ thunar_icon_factory_lookup_icon (ThunarIconFactory *factory,
             return thunar_icon_factory_load_fallback (factory, size);
         }
 
-      /* generate a key for the new cached icon */
-      key = g_slice_new (ThunarIconKey);
-      key->size = size;
-      key->name = g_strdup (name);
-
       /* insert the new icon into the cache */
-      g_hash_table_insert (factory->icon_cache, key, pixbuf);
+      thunar_icon_factory_cache_insert (factory, name, size, pixbuf);
     }
 
   /* schedule the sweeper */
   if (G_UNLIKELY (factory->sweep_timer_id == 0))
     {
-      factory->sweep_timer_id = g_timeout_add_seconds_full (G_PRIORITY_LOW, THUNAR_ICON_FACTORY_SWEEP_TIMEOUT,
-                                                            thunar_icon_factory_sweep_timer, factory,
-                                                            thunar_icon_factory_sweep_timer_destroy);
+      factory->sweep_timer_id = thunar_scheduler_add_timeout (G_PRIORITY_LOW, THUNAR_ICON_FACTORY_SWEEP_TIMEOUT * 1000,
+                                                              thunar_icon_factory_sweep_timer, factory,
+                                                              thunar_icon_factory_sweep_timer_destroy);
     }
 
   return GDK_PIXBUF (g_object_ref (G_OBJECT (pixbuf)));
@@ -670,14 +875,391 @@ thunar_icon_key_free (gpointer data)
 
 
 
+static void
+thunar_icon_entry_free (gpointer data)
+{
+  ThunarIconEntry   *entry = data;
+  ThunarIconFactory *factory = entry->factory;
+
+  /* the key is released by the hash table */
+  g_queue_unlink (&factory->icon_lru, &entry->lru_link);
+  factory->icon_cache_bytes -= entry->n_bytes;
+
+  g_object_unref (entry->pixbuf);
+  g_slice_free (ThunarIconEntry, entry);
+}
+
+
+
+static void
+thunar_icon_store_slot_clear (ThunarIconStoreSlot *slot)
+{
+  if (slot->icon != NULL)
+    {
+      g_atomic_pointer_add (&thunar_icon_store_bytes, -(gssize) gdk_pixbuf_get_byte_length (slot->icon));
+      g_object_unref (slot->icon);
+      slot->icon = NULL;
+    }
+}
+
+
+
 static void
 thunar_icon_store_free (gpointer data)
 {
   ThunarIconStore *store = data;
+  guint            n;
 
-  if (store->icon != NULL)
-    g_object_unref (store->icon);
+  /* files may be released from any thread */
+  for (n = 0; n < THUNAR_ICON_STORE_N_SLOTS; ++n)
+    thunar_icon_store_slot_clear (&store->slots[n]);
   g_slice_free (ThunarIconStore, store);
+  g_atomic_int_add (&thunar_icon_store_count, -1);
+}
+
+
+
+static ThunarIconStoreSlot*
+thunar_icon_store_lookup (ThunarIconFactory   *factory,
+                          ThunarFile          *file,
+                          ThunarFileIconState  icon_state,
+                          gint                 icon_size,
+                          gboolean             thumbnail)
+{
+  ThunarIconStoreSlot *slot;
+  ThunarIconStoreSlot *best = NULL;
+  ThunarIconStore     *store;
+  guint                n;
+
+  store = g_object_get_qdata (G_OBJECT (file), thunar_icon_factory_store_quark);
+  if (store == NULL)
+    return NULL;
+
+  for (n = 0; n < THUNAR_ICON_STORE_N_SLOTS; ++n)
+    {
+      slot = &store->slots[n];
+      if (slot->icon == NULL
+          || slot->icon_state != icon_state
+          || (slot->stamp != factory->theme_stamp && !slot->thumbnail)
+          || slot->thumb_state != thunar_file_get_thumb_state (file))
+        continue;
+
+      if (!thumbnail)
+        {
+          /* exactly the requested size */
+          if (slot->icon_size == icon_size)
+            best = slot;
+        }
+      else if (slot->thumbnail && slot->icon_size > icon_size)
+        {
+          /* the smallest thumbnail which is larger than requested */
+          if (best == NULL || slot->icon_size < best->icon_size)
+            best = slot;
+        }
+    }
+
+  if (best != NULL)
+    best->age = ++store->clock;
+
+  return best;
+}
+
+
+
+static void
+thunar_icon_factory_store_icon (ThunarIconFactory    *factory,
+                                ThunarFile           *file,
+                                GdkPixbuf            *icon,
+                                ThunarFileIconState   icon_state,
+                                ThunarFileThumbState  thumb_state,
+                                gint                  icon_size,
+                                gboolean              thumbnail)
+{
+  ThunarIconStoreSlot *slot = NULL;
+  ThunarIconStore     *store;
+  gsize                max_bytes;
+  guint                n;
+
+  store = g_object_get_qdata (G_OBJECT (file), thunar_icon_factory_store_quark);
+  if (store == NULL)
+    {
+      store = g_slice_new0 (ThunarIconStore);
+      g_atomic_int_inc (&thunar_icon_store_count);
+      g_object_set_qdata_full (G_OBJECT (file), thunar_icon_factory_store_quark,
+                               store, thunar_icon_store_free);
+    }
+
+  /* reuse the slot of the same size, an empty one or the least recently used */
+  for (n = 0; n < THUNAR_ICON_STORE_N_SLOTS; ++n)
+    {
+      if (store->slots[n].icon != NULL && store->slots[n].icon_size == icon_size)
+        {
+          slot = &store->slots[n];
+          break;
+        }
+
+      if (slot == NULL
+          || (slot->icon != NULL && (store->slots[n].icon == NULL || store->slots[n].age < slot->age)))
+        slot = &store->slots[n];
+    }
+
+  thunar_icon_store_slot_clear (slot);
+
+  /* only remember other sizes too while the icons fit into the cache size */
+  max_bytes = (gsize) factory->cache_size * 1024 * 1024;
+  if (factory->icon_cache_bytes + (gsize) g_atomic_pointer_get (&thunar_icon_store_bytes) > max_bytes)
+    {
+      for (n = 0; n < THUNAR_ICON_STORE_N_SLOTS; ++n)
+        thunar_icon_store_slot_clear (&store->slots[n]);
+    }
+
+  slot->icon_size = icon_size;
+  slot->icon_state = icon_state;
+  slot->stamp = factory->theme_stamp;
+  slot->thumb_state = thumb_state;
+  slot->thumbnail = thumbnail;
+  slot->age = ++store->clock;
+  slot->icon = g_object_ref (icon);
+  g_atomic_pointer_add (&thunar_icon_store_bytes, gdk_pixbuf_get_byte_length (icon));
+}
+
+
+
+/* scales a thumbnail that was decoded for a larger size down to size,
+ * this does not touch any shared state, so it is safe to call from a
+ * worker thread */
+static GdkPixbuf*
+thunar_icon_factory_scale_thumbnail (GdkPixbuf     *source,
+                                     gint           size,
+                                     GdkInterpType  interp_type)
+{
+  gint width;
+  gint height;
+  gint max;
+
+  width = gdk_pixbuf_get_width (source);
+  height = gdk_pixbuf_get_height (source);
+  max = MAX (width, height);
+
+  if (max <= size)
+    return g_object_ref (source);
+
+  width = MAX (1, width * size / max);
+  height = MAX (1, height * size / max);
+
+  return gdk_pixbuf_scale_simple (source, width, height, interp_type);
+}
+
+
+
+static void
+thunar_icon_decode_free (ThunarIconDecode *decode)
+{
+  if (decode->icon != NULL)
+    g_object_unref (decode->icon);
+  if (decode->source != NULL)
+    g_object_unref (decode->source);
+  g_object_unref (decode->file);
+  g_object_unref (decode->factory);
+  g_free (decode->path);
+  g_slice_free (ThunarIconDecode, decode);
+}
+
+
+
+static gboolean
+thunar_icon_decode_finished (gpointer user_data)
+{
+  ThunarIconDecode  *decode = user_data;
+  ThunarIconFactory *factory = decode->factory;
+
+THUNAR_THREADS_ENTER
+
+  g_hash_table_remove (factory->decode_pending, decode->file);
+
+  /* only use the thumbnail if it is still the one the file wants */
+  if (G_LIKELY (decode->icon != NULL
+                && decode->thumb_state == thunar_file_get_thumb_state (decode->file)))
+    {
+      thunar_icon_factory_store_icon (factory, decode->file, decode->icon,
+                                      decode->icon_state, decode->thumb_state,
+                                      decode->icon_size, TRUE);
+
+      /* let the views redraw the file with its thumbnail */
+      thunar_file_monitor_file_changed (decode->file);
+    }
+
+  thunar_icon_decode_free (decode);
+
+THUNAR_THREADS_LEAVE
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_icon_decode_worker (gpointer data,
+                           gpointer user_data)
+{
+  ThunarIconDecode *decode = data;
+
+  if (decode->source != NULL)
+    decode->icon = thunar_icon_factory_scale_thumbnail (decode->source, decode->icon_size, GDK_INTERP_BILINEAR);
+  else
+    decode->icon = thunar_icon_factory_decode_file (decode->path, decode->icon_size, decode->draw_frames);
+
+  /* hand the result back to the main thread */
+  g_idle_add (thunar_icon_decode_finished, decode);
+}
+
+
+
+static void
+thunar_icon_factory_queue_decode (ThunarIconFactory   *factory,
+                                  ThunarFile          *file,
+                                  const gchar         *thumbnail_path,
+                                  GdkPixbuf           *source,
+                                  ThunarFileIconState  icon_state,
+                                  gint                 icon_size)
+{
+  ThunarIconDecode *decode;
+
+  /* the thumbnail of this file is already being decoded */
+  if (g_hash_table_contains (factory->decode_pending, file))
+    return;
+
+  if (G_UNLIKELY (factory->decode_pool == NULL))
+    {
+      factory->decode_pool = g_thread_pool_new (thunar_icon_decode_worker, NULL,
+                                                CLAMP (g_get_num_processors (), 2, THUNAR_ICON_FACTORY_DECODE_THREADS),
+                                                FALSE, NULL);
+    }
+
+  decode = g_slice_new0 (ThunarIconDecode);
+  decode->factory = g_object_ref (factory);
+  decode->file = g_object_ref (file);
+  decode->path = g_strdup (thumbnail_path);
+  decode->source = (source != NULL) ? g_object_ref (source) : NULL;
+  decode->icon_size = icon_size;
+  decode->icon_state = icon_state;
+  decode->thumb_state = thunar_file_get_thumb_state (file);
+  decode->draw_frames = factory->thumbnail_draw_frames;
+
+  g_hash_table_insert (factory->decode_pending, file, decode);
+  g_thread_pool_push (factory->decode_pool, decode, NULL);
+}
+
+
+
+static ThunarIconStoreSlot*
+thunar_icon_store_lookup_stale (ThunarIconFactory   *factory,
+                                ThunarFile          *file,
+                                ThunarFileIconState  icon_state,
+                                gint                 icon_size)
+{
+  ThunarIconStoreSlot *slot;
+  ThunarIconStore     *store;
+  guint                n;
+
+  store = g_object_get_qdata (G_OBJECT (file), thunar_icon_factory_store_quark);
+  if (store == NULL)
+    return NULL;
+
+  /* the themed icon of the requested size from before a theme change */
+  for (n = 0; n < THUNAR_ICON_STORE_N_SLOTS; ++n)
+    {
+      slot = &store->slots[n];
+      if (slot->icon != NULL
+          && !slot->thumbnail
+          && slot->icon_size == icon_size
+          && slot->icon_state == icon_state
+          && slot->stamp != factory->theme_stamp
+          && slot->thumb_state == thunar_file_get_thumb_state (file))
+        return slot;
+    }
+
+  return NULL;
+}
+
+
+
+static void
+thunar_icon_refresh_free (ThunarIconRefresh *refresh)
+{
+  g_object_unref (refresh->file);
+  g_slice_free (ThunarIconRefresh, refresh);
+}
+
+
+
+static gboolean
+thunar_icon_factory_refresh (gpointer data,
+                             gint64   deadline)
+{
+  ThunarIconFactory   *factory = THUNAR_ICON_FACTORY (data);
+  ThunarIconRefresh   *refresh;
+  ThunarIconStoreSlot *slot;
+  GdkPixbuf           *icon;
+
+  while ((refresh = g_queue_pop_head (&factory->refresh_queue)) != NULL)
+    {
+      g_hash_table_remove (factory->refresh_pending, refresh->file);
+
+      /* drop the outdated icon and look it up in the new theme */
+      slot = thunar_icon_store_lookup_stale (factory, refresh->file, refresh->icon_state, refresh->icon_size);
+      if (G_LIKELY (slot != NULL))
+        {
+          thunar_icon_store_slot_clear (slot);
+
+          icon = thunar_icon_factory_load_file_icon_real (factory, refresh->file, refresh->icon_state, refresh->icon_size, TRUE);
+          if (G_LIKELY (icon != NULL))
+            g_object_unref (icon);
+
+          /* let the views redraw the file with its new icon */
+          thunar_file_monitor_file_changed (refresh->file);
+        }
+
+      thunar_icon_refresh_free (refresh);
+
+      if (g_get_monotonic_time () >= deadline)
+        break;
+    }
+
+  if (g_queue_is_empty (&factory->refresh_queue))
+    {
+      factory->refresh_id = 0;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_icon_factory_queue_refresh (ThunarIconFactory   *factory,
+                                   ThunarFile          *file,
+                                   ThunarFileIconState  icon_state,
+                                   gint                 icon_size)
+{
+  ThunarIconRefresh *refresh;
+
+  /* the file is refreshed already, possibly at another size, which
+   * is then picked up when the file is drawn again */
+  if (g_hash_table_contains (factory->refresh_pending, file))
+    return;
+
+  refresh = g_slice_new (ThunarIconRefresh);
+  refresh->file = g_object_ref (file);
+  refresh->icon_state = icon_state;
+  refresh->icon_size = icon_size;
+
+  g_queue_push_tail (&factory->refresh_queue, refresh);
+  g_hash_table_insert (factory->refresh_pending, file, refresh);
+
+  if (factory->refresh_id == 0)
+    factory->refresh_id = thunar_scheduler_add_work (G_PRIORITY_LOW, thunar_icon_factory_refresh, factory, NULL);
 }
 
 
@@ -760,6 +1342,9 @@ thunar_icon_factory_get_for_icon_theme (GtkIconTheme *icon_theme)
       g_object_bind_property (G_OBJECT (factory->preferences), "misc-thumbnail-mode",
                               G_OBJECT (factory),              "thumbnail-mode",
                               G_BINDING_SYNC_CREATE);
+      g_object_bind_property (G_OBJECT (factory->preferences), "misc-icon-cache-size",
+                              G_OBJECT (factory),              "cache-size",
+                              G_BINDING_SYNC_CREATE);
     }
   else
     {
@@ -805,7 +1390,8 @@ thunar_icon_factory_get_show_thumbnail (const ThunarIconFactory *factory,
   if (factory->thumbnail_mode == THUNAR_THUMBNAIL_MODE_ONLY_LOCAL)
     return preview == G_FILESYSTEM_PREVIEW_TYPE_IF_LOCAL;
 
-  /* THUNAR_THUMBNAIL_MODE_ALWAYS */
+  /* THUNAR_THUMBNAIL_MODE_ALWAYS, the thumbnailer enforces the budget
+   * of THUNAR_THUMBNAIL_MODE_BUDGETED when the files are queued */
   return TRUE;
 }
 
@@ -856,46 +1442,43 @@ thunar_icon_factory_load_icon (ThunarIconFactory        *factory,
 
 
 
-/**
- * thunar_icon_factory_load_file_icon:
- * @factory    : a #ThunarIconFactory instance.
- * @file       : a #ThunarFile.
- * @icon_state : the desired icon state.
- * @icon_size  : the desired icon size.
- *
- * The caller is responsible to free the returned object using
- * g_object_unref() when no longer needed.
- *
- * Return value: the #GdkPixbuf icon.
- **/
-GdkPixbuf*
-thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
-                                    ThunarFile         *file,
-                                    ThunarFileIconState icon_state,
-                                    gint                icon_size)
+static GdkPixbuf*
+thunar_icon_factory_load_file_icon_real (ThunarIconFactory  *factory,
+                                         ThunarFile         *file,
+                                         ThunarFileIconState icon_state,
+                                         gint                icon_size,
+                                         gboolean            deferred)
 {
-  GInputStream    *stream;
-  GtkIconInfo     *icon_info;
-  const gchar     *thumbnail_path;
-  GdkPixbuf       *icon = NULL;
-  GIcon           *gicon;
-  const gchar     *icon_name;
-  const gchar     *custom_icon;
-  ThunarIconStore *store;
+  GInputStream        *stream;
+  GtkIconInfo         *icon_info;
+  gchar               *thumbnail_path;
+  GdkPixbuf           *icon = NULL;
+  GIcon               *gicon;
+  const gchar         *icon_name;
+  const gchar         *custom_icon;
+  ThunarIconStoreSlot *slot;
+  gboolean             decoding = FALSE;
+  gboolean             thumbnail = FALSE;
 
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
   _thunar_return_val_if_fail (icon_size > 0, NULL);
 
   /* check if we have a stored icon on the file and it is still valid */
-  store = g_object_get_qdata (G_OBJECT (file), thunar_icon_factory_store_quark);
-  if (store != NULL
-      && store->icon_state == icon_state
-      && store->icon_size == icon_size
-      && store->stamp == factory->theme_stamp
-      && store->thumb_state == thunar_file_get_thumb_state (file))
+  slot = thunar_icon_store_lookup (factory, file, icon_state, icon_size, FALSE);
+  if (slot != NULL)
+    return g_object_ref (slot->icon);
+
+  /* after a theme change, keep drawing the previous icon and look up
+   * the new one in slices, starting with the files drawn first */
+  if (deferred)
     {
-      return g_object_ref (store->icon);
+      slot = thunar_icon_store_lookup_stale (factory, file, icon_state, icon_size);
+      if (slot != NULL)
+        {
+          thunar_icon_factory_queue_refresh (factory, file, icon_state, icon_size);
+          return g_object_ref (slot->icon);
+        }
     }
 
   /* check if we have a custom icon for this file */
@@ -960,15 +1543,50 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
         }
       else
         {
-          /* we have no preview icon but the thumbnail should be ready. determine
-           * the filename of the thumbnail */
-          thumbnail_path = thunar_file_get_thumbnail_path (file, factory->thumbnail_size);
-
-          /* check if we have a valid path */
-          if (thumbnail_path != NULL)
+          /* check if the file has a larger thumbnail already, which can be
+           * scaled down instead of decoding the thumbnail again (unless it
+           * has a frame, which should not shrink with the image) */
+          slot = factory->thumbnail_draw_frames ? NULL : thunar_icon_store_lookup (factory, file, icon_state, icon_size, TRUE);
+          if (slot != NULL)
             {
-              /* try to load the thumbnail */
-              icon = thunar_icon_factory_load_from_file (factory, thumbnail_path, icon_size);
+              if (deferred)
+                {
+                  /* scale it properly in the background, and roughly for now */
+                  thunar_icon_factory_queue_decode (factory, file, NULL, slot->icon, icon_state, icon_size);
+                  icon = thunar_icon_factory_scale_thumbnail (slot->icon, icon_size, GDK_INTERP_NEAREST);
+                  decoding = TRUE;
+                }
+              else
+                {
+                  icon = thunar_icon_factory_scale_thumbnail (slot->icon, icon_size, GDK_INTERP_BILINEAR);
+                  thumbnail = TRUE;
+                }
+            }
+          else
+            {
+              /* we have no preview icon but the thumbnail should be ready. determine
+               * the filename of the thumbnail */
+              thumbnail_path = thunar_file_dup_thumbnail_path (file, factory->thumbnail_size);
+
+              /* check if we have a valid path */
+              if (thumbnail_path != NULL)
+                {
+                  if (deferred)
+                    {
+                      /* decode the thumbnail in the background and use the
+                       * themed icon until it is ready */
+                      thunar_icon_factory_queue_decode (factory, file, thumbnail_path, NULL, icon_state, icon_size);
+                      decoding = TRUE;
+                    }
+                  else
+                    {
+                      /* try to load the thumbnail */
+                      icon = thunar_icon_factory_load_from_file (factory, thumbnail_path, icon_size);
+                      thumbnail = (icon != NULL);
+                    }
+
+                  g_free (thumbnail_path);
+                }
             }
         }
     }
@@ -980,17 +1598,12 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
       icon = thunar_icon_factory_load_icon (factory, icon_name, icon_size, TRUE);
     }
 
-  if (G_LIKELY (icon != NULL))
+  /* don't store the placeholder of a thumbnail being decoded */
+  if (G_LIKELY (icon != NULL && !decoding))
     {
-      store = g_slice_new (ThunarIconStore);
-      store->icon_size = icon_size;
-      store->icon_state = icon_state;
-      store->stamp = factory->theme_stamp;
-      store->thumb_state = thunar_file_get_thumb_state (file);
-      store->icon = g_object_ref (icon);
-
-      g_object_set_qdata_full (G_OBJECT (file), thunar_icon_factory_store_quark,
-                               store, thunar_icon_store_free);
+      thunar_icon_factory_store_icon (factory, file, icon, icon_state,
+                                      thunar_file_get_thumb_state (file), icon_size,
+                                      thumbnail);
     }
 
   return icon;
@@ -998,6 +1611,58 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
 
 
 
+/**
+ * thunar_icon_factory_load_file_icon:
+ * @factory    : a #ThunarIconFactory instance.
+ * @file       : a #ThunarFile.
+ * @icon_state : the desired icon state.
+ * @icon_size  : the desired icon size.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the #GdkPixbuf icon.
+ **/
+GdkPixbuf*
+thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
+                                    ThunarFile         *file,
+                                    ThunarFileIconState icon_state,
+                                    gint                icon_size)
+{
+  return thunar_icon_factory_load_file_icon_real (factory, file, icon_state, icon_size, FALSE);
+}
+
+
+
+/**
+ * thunar_icon_factory_load_file_icon_deferred:
+ * @factory    : a #ThunarIconFactory instance.
+ * @file       : a #ThunarFile.
+ * @icon_state : the desired icon state.
+ * @icon_size  : the desired icon size.
+ *
+ * Like thunar_icon_factory_load_file_icon(), but thumbnails are never
+ * decoded on the calling thread. If the thumbnail of @file is not loaded
+ * yet, it is decoded, scaled and framed in a worker thread and the themed
+ * icon of @file is returned as a placeholder. Once the thumbnail is ready,
+ * @file emits "changed", so the views can redraw it.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the #GdkPixbuf icon.
+ **/
+GdkPixbuf*
+thunar_icon_factory_load_file_icon_deferred (ThunarIconFactory  *factory,
+                                             ThunarFile         *file,
+                                             ThunarFileIconState icon_state,
+                                             gint                icon_size)
+{
+  return thunar_icon_factory_load_file_icon_real (factory, file, icon_state, icon_size, TRUE);
+}
+
+
+
 /**
  * thunar_icon_factory_clear_pixmap_cache:
  * @file : a #ThunarFile.
@@ -1013,3 +1678,84 @@ thunar_icon_factory_clear_pixmap_cache (ThunarFile *file)
   if (thunar_icon_factory_store_quark != 0)
     g_object_set_qdata (G_OBJECT (file), thunar_icon_factory_store_quark, NULL);
 }
+
+
+
+/**
+ * thunar_icon_factory_get_cache_stats:
+ * @factory   : a #ThunarIconFactory instance.
+ * @hits      : return location for the number of cache hits or %NULL.
+ * @misses    : return location for the number of cache misses or %NULL.
+ * @evictions : return location for the number of dropped icons or %NULL.
+ * @n_entries : return location for the number of cached icons or %NULL.
+ * @n_bytes   : return location for the memory used by the cache or %NULL.
+ *
+ * Returns the statistics of the icon cache of @factory.
+ **/
+void
+thunar_icon_factory_get_cache_stats (const ThunarIconFactory *factory,
+                                     guint64                 *hits,
+                                     guint64                 *misses,
+                                     guint64                 *evictions,
+                                     guint                   *n_entries,
+                                     gsize                   *n_bytes)
+{
+  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
+
+  if (hits != NULL)
+    *hits = factory->cache_hits;
+  if (misses != NULL)
+    *misses = factory->cache_misses;
+  if (evictions != NULL)
+    *evictions = factory->cache_evictions;
+  if (n_entries != NULL)
+    *n_entries = g_hash_table_size (factory->icon_cache);
+  if (n_bytes != NULL)
+    *n_bytes = factory->icon_cache_bytes;
+}
+
+
+
+/**
+ * thunar_icon_factory_get_store_stats:
+ * @n_stores : return location for the number of files with stored icons or %NULL.
+ * @n_bytes  : return location for the memory used by the stores or %NULL.
+ *
+ * Returns the statistics of the icons kept with the files, which
+ * are shared by all icon factories.
+ **/
+void
+thunar_icon_factory_get_store_stats (guint   *n_stores,
+                                     guint64 *n_bytes)
+{
+  guint count;
+
+  count = g_atomic_int_get (&thunar_icon_store_count);
+
+  if (n_stores != NULL)
+    *n_stores = count;
+  if (n_bytes != NULL)
+    *n_bytes = (gsize) g_atomic_pointer_get (&thunar_icon_store_bytes) + count * sizeof (ThunarIconStore);
+}
+
+
+
+/**
+ * thunar_icon_factory_trim:
+ * @factory : a #ThunarIconFactory instance.
+ *
+ * Drops all icons from the cache of @factory, that are not used
+ * anywhere else, to release memory.
+ **/
+void
+thunar_icon_factory_trim (ThunarIconFactory *factory)
+{
+  guint n_removed;
+
+  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
+
+  n_removed = g_hash_table_foreach_remove (factory->icon_cache,
+                                           (GHRFunc) (void (*)(void)) thunar_icon_check_sweep,
+                                           factory);
+  factory->cache_evictions += n_removed;
+}
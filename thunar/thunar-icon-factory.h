@@ -54,8 +54,25 @@ GdkPixbuf             *thunar_icon_factory_load_file_icon     (ThunarIconFactory
                                                                ThunarFileIconState       icon_state,
                                                                gint                      icon_size);
 
+GdkPixbuf             *thunar_icon_factory_load_file_icon_deferred (ThunarIconFactory   *factory,
+                                                                    ThunarFile          *file,
+                                                                    ThunarFileIconState  icon_state,
+                                                                    gint                 icon_size);
+
 void                   thunar_icon_factory_clear_pixmap_cache (ThunarFile               *file);
 
+void                   thunar_icon_factory_get_cache_stats    (const ThunarIconFactory  *factory,
+                                                               guint64                  *hits,
+                                                               guint64                  *misses,
+                                                               guint64                  *evictions,
+                                                               guint                    *n_entries,
+                                                               gsize                    *n_bytes);
+
+void                   thunar_icon_factory_get_store_stats    (guint                    *n_stores,
+                                                               guint64                  *n_bytes);
+
+void                   thunar_icon_factory_trim               (ThunarIconFactory        *factory);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_ICON_FACTORY_H__ */
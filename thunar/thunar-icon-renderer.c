@@ -30,6 +30,27 @@
 
 
 
+/* the number of icons with emblems kept composited */
+#define ICON_RENDERER_CACHE_SIZE (256)
+
+
+
+typedef struct
+{
+  gchar           *key;
+  GdkPixbuf       *icon;
+  cairo_surface_t *surface;
+
+  /* the area of the surface relative to the icon */
+  gint             x;
+  gint             y;
+  gint             width;
+  gint             height;
+}
+IconRendererComposite;
+
+
+
 enum
 {
   PROP_0,
@@ -65,6 +86,7 @@ static void thunar_icon_renderer_render        (GtkCellRenderer         *rendere
                                                 const GdkRectangle      *background_area,
                                                 const GdkRectangle      *cell_area,
                                                 GtkCellRendererState     flags);
+static void thunar_icon_renderer_composite_free (IconRendererComposite  *composite);
 
 
 
@@ -163,6 +185,10 @@ thunar_icon_renderer_init (ThunarIconRenderer *icon_renderer)
 {
   /* use 1px padding */
   gtk_cell_renderer_set_padding (GTK_CELL_RENDERER (icon_renderer), 1, 1);
+
+  /* the icons with emblems, most recently drawn first */
+  g_queue_init (&icon_renderer->composites);
+  icon_renderer->composites_table = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 
@@ -178,6 +204,11 @@ thunar_icon_renderer_finalize (GObject *object)
   if (G_LIKELY (icon_renderer->file != NULL))
     g_object_unref (G_OBJECT (icon_renderer->file));
 
+  /* release the composited icons */
+  g_hash_table_destroy (icon_renderer->composites_table);
+  g_queue_foreach (&icon_renderer->composites, (GFunc) (void (*)(void)) thunar_icon_renderer_composite_free, NULL);
+  g_queue_clear (&icon_renderer->composites);
+
   (*G_OBJECT_CLASS (thunar_icon_renderer_parent_class)->finalize) (object);
 }
 
@@ -238,9 +269,7 @@ thunar_icon_renderer_set_property (GObject      *object,
       break;
 
     case PROP_FILE:
-      if (G_LIKELY (icon_renderer->file != NULL))
-        g_object_unref (G_OBJECT (icon_renderer->file));
-      icon_renderer->file = (gpointer) g_value_dup_object (value);
+      thunar_icon_renderer_set_file (icon_renderer, g_value_get_object (value));
       break;
 
     case PROP_EMBLEMS:
@@ -368,6 +397,219 @@ thunar_icon_renderer_color_lighten (cairo_t   *cr,
 
 
 
+static gboolean
+thunar_icon_renderer_get_emblem_area (ThunarIconRenderer *icon_renderer,
+                                      ThunarIconFactory  *icon_factory,
+                                      const gchar        *emblem_name,
+                                      gint                position,
+                                      const GdkRectangle *cell_area,
+                                      const GdkRectangle *icon_area,
+                                      GdkPixbuf         **emblem_return,
+                                      GdkRectangle       *emblem_area)
+{
+  GdkPixbuf *emblem;
+  GdkPixbuf *temp;
+  gint       emblem_size;
+
+  /* calculate the emblem size */
+  emblem_size = MIN ((2 * icon_renderer->size) / 3, 32);
+
+  /* check if we have the emblem in the icon theme */
+  emblem = thunar_icon_factory_load_icon (icon_factory, emblem_name, emblem_size, FALSE);
+  if (G_UNLIKELY (emblem == NULL))
+    return FALSE;
+
+  /* determine the dimensions of the emblem */
+  emblem_area->width = gdk_pixbuf_get_width (emblem);
+  emblem_area->height = gdk_pixbuf_get_height (emblem);
+
+  /* shrink insane emblems */
+  if (G_UNLIKELY (MAX (emblem_area->width, emblem_area->height) > emblem_size))
+    {
+      /* scale down the emblem */
+      temp = exo_gdk_pixbuf_scale_ratio (emblem, emblem_size);
+      g_object_unref (G_OBJECT (emblem));
+      emblem = temp;
+
+      /* determine the size again */
+      emblem_area->width = gdk_pixbuf_get_width (emblem);
+      emblem_area->height = gdk_pixbuf_get_height (emblem);
+    }
+
+  /* determine a good position for the emblem, depending on the position index */
+  switch (position)
+    {
+    case 0: /* right/bottom */
+      emblem_area->x = MIN (icon_area->x + icon_area->width - emblem_area->width / 2,
+                            cell_area->x + cell_area->width - emblem_area->width);
+      emblem_area->y = MIN (icon_area->y + icon_area->height - emblem_area->height / 2,
+                            cell_area->y + cell_area->height -emblem_area->height);
+      break;
+
+    case 1: /* left/bottom */
+      emblem_area->x = MAX (icon_area->x - emblem_area->width / 2,
+                            cell_area->x);
+      emblem_area->y = MIN (icon_area->y + icon_area->height - emblem_area->height / 2,
+                            cell_area->y + cell_area->height -emblem_area->height);
+      break;
+
+    case 2: /* left/top */
+      emblem_area->x = MAX (icon_area->x - emblem_area->width / 2,
+                            cell_area->x);
+      emblem_area->y = MAX (icon_area->y - emblem_area->height / 2,
+                            cell_area->y);
+      break;
+
+    case 3: /* right/top */
+      emblem_area->x = MIN (icon_area->x + icon_area->width - emblem_area->width / 2,
+                            cell_area->x + cell_area->width - emblem_area->width);
+      emblem_area->y = MAX (icon_area->y - emblem_area->height / 2,
+                            cell_area->y);
+      break;
+
+    default:
+      _thunar_assert_not_reached ();
+    }
+
+  *emblem_return = emblem;
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_icon_renderer_composite_free (IconRendererComposite *composite)
+{
+  cairo_surface_destroy (composite->surface);
+  g_object_unref (G_OBJECT (composite->icon));
+  g_free (composite->key);
+  g_slice_free (IconRendererComposite, composite);
+}
+
+
+
+static IconRendererComposite *
+thunar_icon_renderer_get_composite (ThunarIconRenderer *icon_renderer,
+                                    GtkWidget          *widget,
+                                    ThunarIconFactory  *icon_factory,
+                                    GdkPixbuf          *source,
+                                    GdkPixbuf          *icon,
+                                    const GList        *emblems,
+                                    const GdkRectangle *cell_area,
+                                    const GdkRectangle *icon_area,
+                                    gdouble             alpha,
+                                    gboolean            insensitive)
+{
+  IconRendererComposite *composite;
+  GdkRectangle           emblem_areas[4];
+  GdkRectangle           area;
+  GdkPixbuf             *emblem_pixbufs[4];
+  GString               *key;
+  cairo_t               *cr;
+  const GList           *li;
+  GList                 *lp;
+  gint                   max_emblems;
+  gint                   n_emblems;
+  gint                   half_size;
+  gint                   scale_factor;
+  gint                   n;
+
+  scale_factor = gtk_widget_get_scale_factor (widget);
+
+  /* the emblems only depend on the cell where it is too small to hold
+   * half an emblem around the icon, so the margins are part of the key */
+  half_size = MIN ((2 * icon_renderer->size) / 3, 32) / 2;
+  key = g_string_new (NULL);
+  g_string_append_printf (key, "%p:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d",
+                          (gpointer) source, icon_area->width, icon_area->height, icon_renderer->size, scale_factor,
+                          MIN (icon_area->x - cell_area->x, half_size),
+                          MIN (icon_area->y - cell_area->y, half_size),
+                          MIN (cell_area->x + cell_area->width - icon_area->x - icon_area->width, half_size),
+                          MIN (cell_area->y + cell_area->height - icon_area->y - icon_area->height, half_size),
+                          (gint) (alpha * 100), insensitive);
+  for (li = emblems; li != NULL; li = li->next)
+    g_string_append_printf (key, ":%s", (const gchar *) li->data);
+
+  lp = g_hash_table_lookup (icon_renderer->composites_table, key->str);
+  if (G_LIKELY (lp != NULL))
+    {
+      g_string_free (key, TRUE);
+
+      /* move the composite to the front of the queue */
+      g_queue_unlink (&icon_renderer->composites, lp);
+      g_queue_push_head_link (&icon_renderer->composites, lp);
+
+      return lp->data;
+    }
+
+  /* render up to four emblems for sizes from 48 onwards, else up to 2 emblems */
+  max_emblems = (icon_renderer->size < 48) ? 2 : 4;
+
+  /* determine the emblems and the area covered with the icon */
+  area = *icon_area;
+  for (li = emblems, n_emblems = 0; li != NULL && n_emblems < max_emblems; li = li->next)
+    {
+      if (thunar_icon_renderer_get_emblem_area (icon_renderer, icon_factory, li->data, n_emblems,
+                                                cell_area, icon_area, &emblem_pixbufs[n_emblems],
+                                                &emblem_areas[n_emblems]))
+        {
+          gdk_rectangle_union (&area, &emblem_areas[n_emblems], &area);
+          ++n_emblems;
+        }
+    }
+
+  composite = g_slice_new (IconRendererComposite);
+  composite->key = g_string_free (key, FALSE);
+  composite->icon = g_object_ref (G_OBJECT (source));
+  composite->x = area.x - icon_area->x;
+  composite->y = area.y - icon_area->y;
+  composite->width = area.width;
+  composite->height = area.height;
+
+  /* compose at the scale of the window, so the blit needs no scaling */
+  if (G_LIKELY (gtk_widget_get_window (widget) != NULL))
+    composite->surface = gdk_window_create_similar_image_surface (gtk_widget_get_window (widget), CAIRO_FORMAT_ARGB32,
+                                                                  area.width, area.height, scale_factor);
+  else
+    composite->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, area.width, area.height);
+
+  cr = cairo_create (composite->surface);
+
+  /* use a translucent icon to represent cutted and hidden files to the user */
+  thunar_gdk_cairo_set_source_pixbuf (cr, icon, icon_area->x - area.x, icon_area->y - area.y);
+  cairo_paint_with_alpha (cr, alpha);
+
+  /* check if we should render an insensitive icon */
+  if (G_UNLIKELY (insensitive))
+    thunar_icon_renderer_color_insensitive (cr, widget);
+
+  /* render the emblems */
+  for (n = 0; n < n_emblems; ++n)
+    {
+      thunar_gdk_cairo_set_source_pixbuf (cr, emblem_pixbufs[n], emblem_areas[n].x - area.x, emblem_areas[n].y - area.y);
+      cairo_paint (cr);
+      g_object_unref (G_OBJECT (emblem_pixbufs[n]));
+    }
+
+  cairo_destroy (cr);
+
+  g_queue_push_head (&icon_renderer->composites, composite);
+  g_hash_table_insert (icon_renderer->composites_table, composite->key, icon_renderer->composites.head);
+
+  /* drop the least recently used composites */
+  while (icon_renderer->composites.length > ICON_RENDERER_CACHE_SIZE)
+    {
+      composite = g_queue_pop_tail (&icon_renderer->composites);
+      g_hash_table_remove (icon_renderer->composites_table, composite->key);
+      thunar_icon_renderer_composite_free (composite);
+    }
+
+  return icon_renderer->composites.head->data;
+}
+
+
+
 static void
 thunar_icon_renderer_render (GtkCellRenderer     *renderer,
                              cairo_t             *cr,
@@ -376,25 +618,23 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
                              const GdkRectangle  *cell_area,
                              GtkCellRendererState flags)
 {
+  IconRendererComposite  *composite;
   ThunarClipboardManager *clipboard;
   ThunarFileIconState     icon_state;
   ThunarIconRenderer     *icon_renderer = THUNAR_ICON_RENDERER (renderer);
   ThunarIconFactory      *icon_factory;
   GtkIconTheme           *icon_theme;
-  GdkRectangle            emblem_area;
+  GdkRectangle            composite_area;
   GdkRectangle            icon_area;
   GdkRectangle            clip_area;
-  GdkPixbuf              *emblem;
+  GdkPixbuf              *source;
   GdkPixbuf              *icon;
   GdkPixbuf              *temp;
-  GList                  *emblems;
-  GList                  *lp;
-  gint                    max_emblems;
-  gint                    position;
+  const GList            *emblems;
   gdouble                 alpha;
-  gint                    emblem_size;
   gboolean                color_selected;
   gboolean                color_lighten;
+  gboolean                insensitive;
   gboolean                is_expanded;
 
   if (G_UNLIKELY (icon_renderer->file == NULL))
@@ -415,7 +655,7 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
   /* load the main icon */
   icon_theme = gtk_icon_theme_get_for_screen (gtk_widget_get_screen (widget));
   icon_factory = thunar_icon_factory_get_for_icon_theme (icon_theme);
-  icon = thunar_icon_factory_load_file_icon (icon_factory, icon_renderer->file, icon_state, icon_renderer->size);
+  icon = thunar_icon_factory_load_file_icon_deferred (icon_factory, icon_renderer->file, icon_state, icon_renderer->size);
   if (G_UNLIKELY (icon == NULL))
     {
       g_object_unref (G_OBJECT (icon_factory));
@@ -430,6 +670,9 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
   icon_area.width = gdk_pixbuf_get_width (icon);
   icon_area.height = gdk_pixbuf_get_height (icon);
 
+  /* the composites are looked up by the icon of the factory */
+  source = g_object_ref (G_OBJECT (icon));
+
   /* scale down the icon on-demand */
   if (G_UNLIKELY (icon_area.width > cell_area->width || icon_area.height > cell_area->height))
     {
@@ -449,9 +692,14 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
   /* bools for cairo transformations */
   color_selected = (flags & GTK_CELL_RENDERER_SELECTED) != 0 && icon_renderer->follow_state;
   color_lighten = (flags & GTK_CELL_RENDERER_PRELIT) != 0 && icon_renderer->follow_state;
+  insensitive = gtk_widget_get_state_flags (widget) == GTK_STATE_FLAG_INSENSITIVE || !gtk_cell_renderer_get_sensitive (renderer);
 
-  /* check whether the icon is affected by the expose event */
-  if (gdk_rectangle_intersect (&clip_area, &icon_area, NULL))
+  /* display the emblems as well (if any) */
+  emblems = G_LIKELY (icon_renderer->emblems) ? thunar_file_peek_emblem_names (icon_renderer->file) : NULL;
+
+  /* check whether the icon is affected by the expose event, the
+   * emblems may stick out of the icon area */
+  if (emblems != NULL || gdk_rectangle_intersect (&clip_area, &icon_area, NULL))
     {
       /* use a translucent icon to represent cutted and hidden files to the user */
       clipboard = thunar_clipboard_manager_get_for_display (gtk_widget_get_display (widget));
@@ -471,127 +719,54 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
         }
       g_object_unref (G_OBJECT (clipboard));
 
-      /* render the invalid parts of the icon */
-      thunar_gdk_cairo_set_source_pixbuf (cr, icon, icon_area.x, icon_area.y);
-      cairo_paint_with_alpha (cr, alpha);
-
-      /* check if we should render an insensitive icon */
-      if (G_UNLIKELY (gtk_widget_get_state_flags (widget) == GTK_STATE_FLAG_INSENSITIVE || !gtk_cell_renderer_get_sensitive (renderer)))
-        thunar_icon_renderer_color_insensitive(cr,widget);
-
-      /* paint the lighten mask */
-      if (color_lighten)
-        thunar_icon_renderer_color_lighten (cr, widget);
-
-      /* paint the selected mask */
-      if (color_selected)
-        thunar_icon_renderer_color_selected (cr, widget);
-    }
-
-  /* release the file's icon */
-  g_object_unref (G_OBJECT (icon));
-
-  /* check if we should render emblems as well */
-  if (G_LIKELY (icon_renderer->emblems))
-    {
-      /* display the primary emblem as well (if any) */
-      emblems = thunar_file_get_emblem_names (icon_renderer->file);
       if (G_UNLIKELY (emblems != NULL))
         {
-          /* render up to four emblems for sizes from 48 onwards, else up to 2 emblems */
-          max_emblems = (icon_renderer->size < 48) ? 2 : 4;
-
-          /* render the emblems */
-          for (lp = emblems, position = 0; lp != NULL && position < max_emblems; lp = lp->next)
+          /* draw the icon and its emblems composited in advance */
+          composite = thunar_icon_renderer_get_composite (icon_renderer, widget, icon_factory, source, icon, emblems,
+                                                          cell_area, &icon_area, alpha, insensitive);
+          composite_area.x = icon_area.x + composite->x;
+          composite_area.y = icon_area.y + composite->y;
+          composite_area.width = composite->width;
+          composite_area.height = composite->height;
+
+          if (gdk_rectangle_intersect (&clip_area, &composite_area, NULL))
             {
-              /* calculate the emblem size */
-              emblem_size = MIN ((2 * icon_renderer->size) / 3, 32);
-
-              /* check if we have the emblem in the icon theme */
-              emblem = thunar_icon_factory_load_icon (icon_factory, lp->data, emblem_size, FALSE);
-              if (G_UNLIKELY (emblem == NULL))
-                continue;
-
-              /* determine the dimensions of the emblem */
-              emblem_area.width = gdk_pixbuf_get_width (emblem);
-              emblem_area.height = gdk_pixbuf_get_height (emblem);
-
-              /* shrink insane emblems */
-              if (G_UNLIKELY (MAX (emblem_area.width, emblem_area.height) > emblem_size))
-                {
-                  /* scale down the emblem */
-                  temp = exo_gdk_pixbuf_scale_ratio (emblem, emblem_size);
-                  g_object_unref (G_OBJECT (emblem));
-                  emblem = temp;
-
-                  /* determine the size again */
-                  emblem_area.width = gdk_pixbuf_get_width (emblem);
-                  emblem_area.height = gdk_pixbuf_get_height (emblem);
-                }
-
-              /* determine a good position for the emblem, depending on the position index */
-              switch (position)
-                {
-                case 0: /* right/bottom */
-                  emblem_area.x = MIN (icon_area.x + icon_area.width - emblem_area.width / 2,
-                                       cell_area->x + cell_area->width - emblem_area.width);
-                  emblem_area.y = MIN (icon_area.y + icon_area.height - emblem_area.height / 2,
-                                       cell_area->y + cell_area->height -emblem_area.height);
-                  break;
-
-                case 1: /* left/bottom */
-                  emblem_area.x = MAX (icon_area.x - emblem_area.width / 2,
-                                       cell_area->x);
-                  emblem_area.y = MIN (icon_area.y + icon_area.height - emblem_area.height / 2,
-                                       cell_area->y + cell_area->height -emblem_area.height);
-                  break;
-
-                case 2: /* left/top */
-                  emblem_area.x = MAX (icon_area.x - emblem_area.width / 2,
-                                       cell_area->x);
-                  emblem_area.y = MAX (icon_area.y - emblem_area.height / 2,
-                                       cell_area->y);
-                  break;
-
-                case 3: /* right/top */
-                  emblem_area.x = MIN (icon_area.x + icon_area.width - emblem_area.width / 2,
-                                       cell_area->x + cell_area->width - emblem_area.width);
-                  emblem_area.y = MAX (icon_area.y - emblem_area.height / 2,
-                                       cell_area->y);
-                  break;
-
-                default:
-                  _thunar_assert_not_reached ();
-                }
-
-              /* render the emblem */
-              if (gdk_rectangle_intersect (&clip_area, &emblem_area, NULL))
-                {
-                  /* render the invalid parts of the icon */
-                  thunar_gdk_cairo_set_source_pixbuf (cr, emblem, emblem_area.x, emblem_area.y);
-                  cairo_paint (cr);
-
-                  /* paint the lighten mask */
-                  if (color_lighten)
-                    thunar_icon_renderer_color_lighten (cr, widget);
-
-                  /* paint the selected mask */
-                  if (color_selected)
-                    thunar_icon_renderer_color_selected (cr, widget);
-                }
-
-              /* release the emblem */
-              g_object_unref (G_OBJECT (emblem));
-
-              /* advance the position index */
-              ++position;
+              cairo_set_source_surface (cr, composite->surface, composite_area.x, composite_area.y);
+              cairo_paint (cr);
+
+              /* paint the lighten mask */
+              if (color_lighten)
+                thunar_icon_renderer_color_lighten (cr, widget);
+
+              /* paint the selected mask */
+              if (color_selected)
+                thunar_icon_renderer_color_selected (cr, widget);
             }
+        }
+      else
+        {
+          /* render the invalid parts of the icon */
+          thunar_gdk_cairo_set_source_pixbuf (cr, icon, icon_area.x, icon_area.y);
+          cairo_paint_with_alpha (cr, alpha);
+
+          /* check if we should render an insensitive icon */
+          if (G_UNLIKELY (insensitive))
+            thunar_icon_renderer_color_insensitive (cr, widget);
+
+          /* paint the lighten mask */
+          if (color_lighten)
+            thunar_icon_renderer_color_lighten (cr, widget);
 
-          /* release the emblem name list */
-          g_list_free (emblems);
+          /* paint the selected mask */
+          if (color_selected)
+            thunar_icon_renderer_color_selected (cr, widget);
         }
     }
 
+  /* release the file's icon */
+  g_object_unref (G_OBJECT (source));
+  g_object_unref (G_OBJECT (icon));
+
   /* release our reference on the icon factory */
   g_object_unref (G_OBJECT (icon_factory));
 }
@@ -615,3 +790,31 @@ thunar_icon_renderer_new (void)
 }
 
 
+
+
+/**
+ * thunar_icon_renderer_set_file:
+ * @icon_renderer : a #ThunarIconRenderer.
+ * @file          : a #ThunarFile or %NULL.
+ *
+ * Sets the file rendered by @icon_renderer, like the "file"
+ * property, but without going through #GValue and without
+ * emitting a notification. Meant for the cell data functions
+ * of the views, which run for every cell on every redraw.
+ **/
+void
+thunar_icon_renderer_set_file (ThunarIconRenderer *icon_renderer,
+                               ThunarFile         *file)
+{
+  _thunar_return_if_fail (THUNAR_IS_ICON_RENDERER (icon_renderer));
+  _thunar_return_if_fail (file == NULL || THUNAR_IS_FILE (file));
+
+  if (G_UNLIKELY (icon_renderer->file == file))
+    return;
+
+  if (G_LIKELY (file != NULL))
+    g_object_ref (G_OBJECT (file));
+  if (G_LIKELY (icon_renderer->file != NULL))
+    g_object_unref (G_OBJECT (icon_renderer->file));
+  icon_renderer->file = file;
+}
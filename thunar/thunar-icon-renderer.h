@@ -49,12 +49,19 @@ struct _ThunarIconRenderer
   gboolean       emblems;
   gboolean       follow_state;
   ThunarIconSize size;
+
+  /* the icons with emblems composited in advance */
+  GQueue         composites;
+  GHashTable    *composites_table;
 };
 
 GType            thunar_icon_renderer_get_type (void) G_GNUC_CONST;
 
 GtkCellRenderer *thunar_icon_renderer_new      (void) G_GNUC_MALLOC;
 
+void             thunar_icon_renderer_set_file (ThunarIconRenderer *icon_renderer,
+                                                ThunarFile         *file);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_ICON_RENDERER_H__ */
@@ -108,8 +108,6 @@ thunar_image_init (ThunarImage *image)
   image->priv->file = NULL;
 
   image->priv->monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (image->priv->monitor, "file-changed",
-                    G_CALLBACK (thunar_image_file_changed), image);
 }
 
 
@@ -119,12 +117,11 @@ thunar_image_finalize (GObject *object)
 {
   ThunarImage *image = THUNAR_IMAGE (object);
 
-  g_signal_handlers_disconnect_by_func (image->priv->monitor,
-                                        thunar_image_file_changed, image);
-  g_object_unref (image->priv->monitor);
-
+  /* drop the file before the monitor watching it */
   thunar_image_set_file (image, NULL);
 
+  g_object_unref (image->priv->monitor);
+
   (*G_OBJECT_CLASS (thunar_image_parent_class)->finalize) (object);
 }
 
@@ -233,11 +230,17 @@ thunar_image_set_file (ThunarImage *image,
       if (image->priv->file == file)
         return;
 
+      thunar_file_monitor_unwatch (image->priv->monitor, image->priv->file, image);
       g_object_unref (image->priv->file);
     }
 
   if (file != NULL)
-    image->priv->file = g_object_ref (file);
+    {
+      image->priv->file = g_object_ref (file);
+      thunar_file_monitor_watch (image->priv->monitor, file, THUNAR_FILE_MONITOR_WATCH_FILE,
+                                 (ThunarFileMonitorFunc) thunar_image_file_changed,
+                                 NULL, image);
+    }
   else
     image->priv->file = NULL;
 
@@ -37,6 +37,21 @@ GFile *thunar_io_jobs_util_next_renamed_file (ThunarJob *job,
                                               guint      n,
                                               GError   **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+guint  thunar_io_jobs_util_get_max_threads (GFile        *file,
+                                            GFileInfo    *info,
+                                            guint         max_threads,
+                                            GCancellable *cancellable);
+
+gboolean thunar_io_jobs_util_is_rotating     (GFile               *file,
+                                              GFileInfo           *info,
+                                              GCancellable        *cancellable);
+
+GList   *thunar_io_jobs_util_query_children_by_inode (GFile               *directory,
+                                                      const gchar         *attributes,
+                                                      GFileQueryInfoFlags  flags,
+                                                      GCancellable        *cancellable,
+                                                      GError             **error) G_GNUC_WARN_UNUSED_RESULT;
+
 G_END_DECLS
 
 #endif /* !__THUNAR_IO_JOBS_UITL_H__ */
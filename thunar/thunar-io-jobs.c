@@ -22,11 +22,29 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <gio/gio.h>
+#ifdef HAVE_GIO_UNIX
+#include <gio/gunixmounts.h>
+#endif
 #include <glib/gstdio.h>
 
 #include <thunar/thunar-application.h>
@@ -37,9 +55,167 @@
 #include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-scan-rules.h>
+#include <thunar/thunar-search-index.h>
 #include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-thumbnail-cache.h>
+#include <thunar/thunar-thumbnail-index.h>
+#include <thunar/thunar-thumbnailer.h>
 #include <thunar/thunar-transfer-job.h>
+#include <thunar/thunar-trash-count.h>
+
+
+
+/* number of files handed over to the folder per "files-ready" emission */
+#define THUNAR_IO_JOBS_LS_BATCH_SIZE (256)
+
+/* number of files per thumbnail request while generating thumbnails, the
+ * next request is only queued once the previous one was finished */
+#define THUNAR_IO_JOBS_THUMBNAILS_BATCH_SIZE (64)
+
+/* interval in which the thumbnail job checks the power supply */
+#define THUNAR_IO_JOBS_POWER_INTERVAL (5 * G_USEC_PER_SEC)
+
+/* local directory trees are removed relative to directory fds by a pool
+ * of threads, without collecting the files first */
+#if defined (HAVE_DIRENT_H) && defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) \
+ && defined (HAVE_OPENAT) && defined (HAVE_UNLINKAT) && defined (O_DIRECTORY) \
+ && defined (O_NOFOLLOW) && defined (O_CLOEXEC)
+#define THUNAR_IO_JOBS_UNLINK_AT
+
+/* upper limit for the number of threads removing a single tree */
+#define THUNAR_IO_JOBS_UNLINK_MAX_THREADS (8)
+
+/* deeper trees are left to the regular code path */
+#define THUNAR_IO_JOBS_UNLINK_MAX_DEPTH (128)
+
+/* number of removals after which a thread updates the shared counter */
+#define THUNAR_IO_JOBS_UNLINK_BATCH_SIZE (256)
+
+/* the trash directories are emptied by moving their contents aside,
+ * the name of the directory they are moved to while they are removed */
+#define THUNAR_IO_JOBS_EXPUNGE_PREFIX "expunged."
+#endif
+
+/* recursive permission and ownership changes are applied while the
+ * trees are walked, relative to directory fds */
+#if defined (HAVE_DIRENT_H) && defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) \
+ && defined (HAVE_OPENAT) && defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT) \
+ && defined (O_DIRECTORY) && defined (O_NOFOLLOW) && defined (O_CLOEXEC)
+#define THUNAR_IO_JOBS_CHANGE_AT
+
+/* upper limit for the number of threads changing a single tree */
+#define THUNAR_IO_JOBS_CHANGE_MAX_THREADS (8)
+
+/* deeper trees are left to the regular code path */
+#define THUNAR_IO_JOBS_CHANGE_MAX_DEPTH (128)
+
+/* number of changes after which a thread updates the shared counter */
+#define THUNAR_IO_JOBS_CHANGE_BATCH_SIZE (256)
+#endif
+
+/* interval in which paused permission and ownership changes check
+ * whether they were resumed or cancelled */
+#define THUNAR_IO_JOBS_PAUSE_INTERVAL (250 * 1000)
+
+/* new local files, directories and links are created relative to an fd
+ * of their parent directory, which is opened once for all its files */
+#if defined (HAVE_OPENAT) && defined (HAVE_MKDIRAT) && defined (HAVE_SYMLINKAT) \
+ && defined (O_DIRECTORY) && defined (O_CLOEXEC)
+#define THUNAR_IO_JOBS_CREATE_AT
+#endif
+
+/* files on the filesystem of the home trash are moved there directly,
+ * without resolving the trash directory again for every file */
+#if defined (HAVE_FCNTL_H) && defined (HAVE_SYS_STAT_H) && defined (HAVE_UNISTD_H)
+#define THUNAR_IO_JOBS_TRASH_BATCH
+
+/* upper limit for the number of tries to find a free name in the trash */
+#define THUNAR_IO_JOBS_TRASH_MAX_NAMES (1000)
+#endif
+
+
+
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
+typedef struct
+{
+  GThreadPool  *pool;
+  GCancellable *cancellable;
+  gint          fd;
+
+  /* the first errno, other threads stop once it is set */
+  gint          error_code;
+
+  /* protected by the mutex */
+  GMutex        mutex;
+  GCond         cond;
+  guint         n_pending;
+  guint         n_deleted;
+}
+UnlinkAtContext;
+#endif
+
+
+#ifdef THUNAR_IO_JOBS_CHANGE_AT
+typedef struct
+{
+  /* the change, either the mode or the owner (-1 to keep it) */
+  gboolean        chmod;
+  ThunarFileMode  dir_mask;
+  ThunarFileMode  dir_mode;
+  ThunarFileMode  file_mask;
+  ThunarFileMode  file_mode;
+  gint            uid;
+  gint            gid;
+
+  ThunarJob      *job;
+  GThreadPool    *pool;
+  GCancellable   *cancellable;
+  gint            fd;
+
+  /* only used by the job thread, the time spent paused is not
+   * counted for the throughput */
+  gint64          start_time;
+  gint64          pause_time;
+
+  /* the first errno, other threads stop once it is set */
+  gint            error_code;
+
+  /* protected by the mutex */
+  GMutex          mutex;
+  GCond           cond;
+  guint           n_pending;
+  guint           n_changed;
+}
+ChangeAtContext;
+#endif
+
+
+
+/* the last parent directory of a job creating files, see
+ * _tij_create_at_parent(), the fd is -1 if it cannot be used */
+typedef struct
+{
+  GFile *file;
+  gint   fd;
+}
+CreateAtParent;
+
+#define CREATE_AT_PARENT_INIT { NULL, -1 }
+
+
+
+#ifdef THUNAR_IO_JOBS_TRASH_BATCH
+typedef struct
+{
+  gchar *trash_dir;
+  gchar *files_dir;
+  gchar *info_dir;
+  gchar *deletion_date;
+  dev_t  device;
+}
+TrashBatch;
+#endif
 
 
 
@@ -116,229 +292,578 @@ _tij_delete_file (GFile        *file,
 
 
 
-static gboolean
-_thunar_io_jobs_create (ThunarJob  *job,
-                        GArray     *param_values,
-                        GError    **error)
+#ifdef THUNAR_IO_JOBS_CREATE_AT
+static gint
+_tij_create_at_parent (CreateAtParent *parent,
+                       GFile          *file,
+                       gchar         **name_return)
 {
-  GFileOutputStream *stream;
-  ThunarJobResponse  response = THUNAR_JOB_RESPONSE_CANCEL;
-  GFileInfo         *info;
-  GError            *err = NULL;
-  GList             *file_list;
-  GList             *lp;
-  gchar             *base_name;
-  gchar             *display_name;
-  guint              n_processed = 0;
-  GFile             *template_file;
-  GFileInputStream  *template_stream = NULL;
-
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
-  _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  GFile *file_parent;
+  gchar *path;
 
-  /* get the file list */
-  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
-  template_file = g_value_get_object (&g_array_index (param_values, GValue, 1));
+  if (!g_file_is_native (file))
+    return -1;
 
-  /* we know the total amount of files to be processed */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  file_parent = g_file_get_parent (file);
+  if (G_UNLIKELY (file_parent == NULL))
+    return -1;
 
-  /* check if we need to open the template */
-  if (template_file != NULL)
+  /* the files of a job are usually created in the same directory */
+  if (parent->file == NULL || !g_file_equal (parent->file, file_parent))
     {
-      /* open read stream to feed in the new files */
-      template_stream = g_file_read (template_file, exo_job_get_cancellable (EXO_JOB (job)), &err);
-      if (G_UNLIKELY (template_stream == NULL))
-        {
-          g_propagate_error (error, err);
-          return FALSE;
-        }
+      if (parent->fd >= 0)
+        close (parent->fd);
+      if (parent->file != NULL)
+        g_object_unref (parent->file);
+
+      /* if the directory cannot be opened, gio reports the error */
+      path = g_file_get_path (file_parent);
+      parent->fd = (path != NULL) ? open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC) : -1;
+      parent->file = g_object_ref (file_parent);
+      g_free (path);
     }
 
-  /* iterate over all files in the list */
-  for (lp = file_list;
-       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
-       lp = lp->next, n_processed++)
-    {
-      g_assert (G_IS_FILE (lp->data));
-
-      /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp, n_processed);
+  g_object_unref (file_parent);
 
-    again:
-      /* try to create the file */
-      stream = g_file_create (lp->data,
-                              G_FILE_CREATE_NONE,
-                              exo_job_get_cancellable (EXO_JOB (job)),
-                              &err);
+  if (parent->fd >= 0)
+    *name_return = g_file_get_basename (file);
 
-      /* abort if the job was cancelled */
-      if (exo_job_is_cancelled (EXO_JOB (job)))
-        break;
+  return parent->fd;
+}
+#endif
 
-      /* check if creating failed */
-      if (stream == NULL)
-        {
-          if (err->code == G_IO_ERROR_EXISTS)
-            {
-              g_clear_error (&err);
 
-              /* the file already exists, query its display name */
-              info = g_file_query_info (lp->data,
-                                        G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        exo_job_get_cancellable (EXO_JOB (job)),
-                                        NULL);
 
-              /* abort if the job was cancelled */
-              if (exo_job_is_cancelled (EXO_JOB (job)))
-                break;
+static void
+_tij_create_at_parent_clear (CreateAtParent *parent)
+{
+#ifdef THUNAR_IO_JOBS_CREATE_AT
+  if (parent->fd >= 0)
+    close (parent->fd);
+#endif
+  if (parent->file != NULL)
+    g_object_unref (parent->file);
 
-              /* determine the display name, using the basename as a fallback */
-              if (info != NULL)
-                {
-                  display_name = g_strdup (g_file_info_get_display_name (info));
-                  g_object_unref (info);
-                }
-              else
-                {
-                  base_name = g_file_get_basename (lp->data);
-                  display_name = g_filename_display_name (base_name);
-                  g_free (base_name);
-                }
+  parent->file = NULL;
+  parent->fd = -1;
+}
 
-              /* ask the user whether he wants to overwrite the existing file */
-              response = thunar_job_ask_overwrite (THUNAR_JOB (job),
-                                                   _("The file \"%s\" already exists"),
-                                                   display_name);
 
-              /* check if we should overwrite */
-              if (response == THUNAR_JOB_RESPONSE_REPLACE)
-                {
-                  /* try to remove the file. fail if not possible */
-                  if (_tij_delete_file (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
-                    goto again;
-                }
 
-              /* clean up */
-              g_free (display_name);
-            }
-          else
-            {
-              /* determine display name of the file */
-              base_name = g_file_get_basename (lp->data);
-              display_name = g_filename_display_basename (base_name);
-              g_free (base_name);
+static gboolean
+_tij_make_directory (CreateAtParent *parent,
+                     GFile          *file,
+                     GCancellable   *cancellable,
+                     GError        **error)
+{
+#ifdef THUNAR_IO_JOBS_CREATE_AT
+  gchar *name;
+  gint   errsv;
+  gint   fd;
 
-              /* ask the user whether to skip/retry this path (cancels the job if not) */
-              response = thunar_job_ask_skip (THUNAR_JOB (job),
-                                              _("Failed to create empty file \"%s\": %s"),
-                                              display_name, err->message);
-              g_free (display_name);
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
 
-              g_clear_error (&err);
+  fd = _tij_create_at_parent (parent, file, &name);
+  if (fd >= 0)
+    {
+      errsv = (mkdirat (fd, name, 0777) == 0) ? 0 : errno;
+      g_free (name);
 
-              /* go back to the beginning if the user wants to retry */
-              if (response == THUNAR_JOB_RESPONSE_RETRY)
-                goto again;
-            }
-        }
-      else
-        {
-          if (template_stream != NULL)
-            {
-              /* write the template into the new file */
-              g_output_stream_splice (G_OUTPUT_STREAM (stream),
-                                      G_INPUT_STREAM (template_stream),
-                                      G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
-                                      exo_job_get_cancellable (EXO_JOB (job)),
-                                      NULL);
-            }
+      if (G_LIKELY (errsv == 0))
+        return TRUE;
 
-          g_object_unref (stream);
-        }
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                   _("Error creating directory: %s"), g_strerror (errsv));
+      return FALSE;
     }
+#endif
 
-  if (template_stream != NULL)
-    g_object_unref (template_stream);
+  return g_file_make_directory (file, cancellable, error);
+}
 
-  /* check if we have failed */
-  if (err != NULL)
+
+
+static gboolean
+_tij_create_file (CreateAtParent *parent,
+                  GFile          *file,
+                  GCancellable   *cancellable,
+                  GError        **error)
+{
+  GFileOutputStream *stream;
+#ifdef THUNAR_IO_JOBS_CREATE_AT
+  gchar             *name;
+  gint               errsv;
+  gint               fd;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
+
+  fd = _tij_create_at_parent (parent, file, &name);
+  if (fd >= 0)
     {
-      g_propagate_error (error, err);
+      fd = openat (fd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+      errsv = (fd >= 0) ? 0 : errno;
+      g_free (name);
+
+      if (G_LIKELY (errsv == 0))
+        {
+          close (fd);
+          return TRUE;
+        }
+
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                   _("Error creating file: %s"), g_strerror (errsv));
       return FALSE;
     }
+#endif
 
-  /* check if the job was cancelled */
-  if (exo_job_is_cancelled (EXO_JOB (job)))
+  stream = g_file_create (file, G_FILE_CREATE_NONE, cancellable, error);
+  if (G_UNLIKELY (stream == NULL))
     return FALSE;
 
-  /* emit the "new-files" signal with the given file list */
-  thunar_job_new_files (THUNAR_JOB (job), file_list);
-
+  g_object_unref (stream);
   return TRUE;
 }
 
 
 
-ThunarJob *
-thunar_io_jobs_create_files (GList *file_list,
-                             GFile *template_file)
+static gboolean
+_tij_make_symbolic_link (CreateAtParent *parent,
+                         GFile          *file,
+                         const gchar    *target_path,
+                         GCancellable   *cancellable,
+                         GError        **error)
 {
-  return thunar_simple_job_new (_thunar_io_jobs_create, 2,
-                                THUNAR_TYPE_G_FILE_LIST, file_list,
-                                G_TYPE_FILE, template_file);
+#ifdef THUNAR_IO_JOBS_CREATE_AT
+  gchar *name;
+  gint   errsv;
+  gint   fd;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
+
+  fd = _tij_create_at_parent (parent, file, &name);
+  if (fd >= 0)
+    {
+      errsv = (symlinkat (target_path, fd, name) == 0) ? 0 : errno;
+      g_free (name);
+
+      if (G_LIKELY (errsv == 0))
+        return TRUE;
+
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                   _("Error making symbolic link: %s"), g_strerror (errsv));
+      return FALSE;
+    }
+#endif
+
+  return g_file_make_symbolic_link (file, target_path, cancellable, error);
 }
 
 
 
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
 static gboolean
-_thunar_io_jobs_mkdir (ThunarJob  *job,
-                       GArray     *param_values,
-                       GError    **error)
+_tij_unlink_at_failed (UnlinkAtContext *context,
+                       gint             error_code)
 {
-  ThunarJobResponse response;
-  GFileInfo        *info;
-  GError           *err = NULL;
-  GList            *file_list;
-  GList            *lp;
-  gchar            *base_name;
-  gchar            *display_name;
-  guint             n_processed = 0;
+  /* only remember the first failure */
+  g_atomic_int_compare_and_exchange (&context->error_code, 0, error_code);
+  return FALSE;
+}
 
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
-  _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
-  /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+static void
+_tij_unlink_at_deleted (UnlinkAtContext *context,
+                        guint           *n_deleted)
+{
+  g_mutex_lock (&context->mutex);
+  context->n_deleted += *n_deleted;
+  g_mutex_unlock (&context->mutex);
 
-  for (lp = file_list;
-       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
-       lp = lp->next,  n_processed++)
-    {
-      g_assert (G_IS_FILE (lp->data));
+  *n_deleted = 0;
+}
 
-      /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp, n_processed);
 
-    again:
-      /* try to create the directory */
-      if (!g_file_make_directory (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
-        {
-          if (err->code == G_IO_ERROR_EXISTS)
-            {
-              g_error_free (err);
-              err = NULL;
 
-              /* abort if the job was cancelled */
-              if (exo_job_is_cancelled (EXO_JOB (job)))
-                break;
+static gboolean
+_tij_unlink_at (UnlinkAtContext *context,
+                gint             parent_fd,
+                const gchar     *name,
+                guint            depth)
+{
+  struct dirent *entry;
+  struct stat    statb;
+  gboolean       is_dir;
+  gboolean       succeed = TRUE;
+  guint          n_deleted = 0;
+  DIR           *dp;
+  gint           fd;
+
+  if (G_UNLIKELY (depth > THUNAR_IO_JOBS_UNLINK_MAX_DEPTH))
+    return _tij_unlink_at_failed (context, ENAMETOOLONG);
+
+  /* never leave the tree through a symlink that replaced a directory */
+  fd = openat (parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (G_UNLIKELY (fd < 0))
+    return _tij_unlink_at_failed (context, errno);
+
+  dp = fdopendir (fd);
+  if (G_UNLIKELY (dp == NULL))
+    {
+      close (fd);
+      return _tij_unlink_at_failed (context, errno);
+    }
+
+  for (;;)
+    {
+      /* stop if the job was cancelled or another thread failed */
+      if (g_cancellable_is_cancelled (context->cancellable)
+          || g_atomic_int_get (&context->error_code) != 0)
+        {
+          succeed = FALSE;
+          break;
+        }
+
+      errno = 0;
+      entry = readdir (dp);
+      if (entry == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            succeed = _tij_unlink_at_failed (context, errno);
+          break;
+        }
+
+      if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        continue;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (entry->d_type != DT_UNKNOWN)
+        is_dir = (entry->d_type == DT_DIR);
+      else
+#endif
+        {
+          if (fstatat (fd, entry->d_name, &statb, AT_SYMLINK_NOFOLLOW) != 0)
+            {
+              succeed = _tij_unlink_at_failed (context, errno);
+              break;
+            }
+          is_dir = S_ISDIR (statb.st_mode);
+        }
+
+      if (is_dir)
+        {
+          if (!_tij_unlink_at (context, fd, entry->d_name, depth + 1))
+            {
+              succeed = FALSE;
+              break;
+            }
+        }
+      else if (unlinkat (fd, entry->d_name, 0) == 0)
+        {
+          if (++n_deleted >= THUNAR_IO_JOBS_UNLINK_BATCH_SIZE)
+            _tij_unlink_at_deleted (context, &n_deleted);
+        }
+      else
+        {
+          succeed = _tij_unlink_at_failed (context, errno);
+          break;
+        }
+    }
+
+  /* this also closes the fd */
+  closedir (dp);
+
+  if (succeed)
+    {
+      if (unlinkat (parent_fd, name, AT_REMOVEDIR) == 0)
+        ++n_deleted;
+      else
+        succeed = _tij_unlink_at_failed (context, errno);
+    }
+
+  _tij_unlink_at_deleted (context, &n_deleted);
+
+  return succeed;
+}
+
+
+
+static void
+_tij_unlink_at_worker (gpointer data,
+                       gpointer user_data)
+{
+  UnlinkAtContext *context = user_data;
+  gchar           *name = data;
+
+  _tij_unlink_at (context, context->fd, name, 1);
+  g_free (name);
+
+  g_mutex_lock (&context->mutex);
+  context->n_pending--;
+  g_cond_signal (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+static void
+_tij_unlink_at_progress (ThunarJob       *job,
+                         UnlinkAtContext *context)
+{
+  guint n_deleted;
+
+  g_mutex_lock (&context->mutex);
+  n_deleted = context->n_deleted;
+  g_mutex_unlock (&context->mutex);
+
+  exo_job_info_message (EXO_JOB (job), ngettext ("%u file deleted", "%u files deleted", n_deleted), n_deleted);
+}
+
+
+
+/**
+ * _tij_unlink_tree:
+ * @job  : a #ThunarJob.
+ * @file : the #GFile of a directory.
+ *
+ * Removes the local directory tree @file without collecting its files
+ * first. The toplevel directory is read by the job thread, which hands
+ * the subdirectories over to a pool of threads and reports the number
+ * of removed files while the pool works.
+ *
+ * Nothing is reported to the user if this fails, the remaining files
+ * are expected to be removed per file, so the user can skip or retry.
+ *
+ * Return value: %TRUE if @file was removed.
+ **/
+static gboolean
+_tij_unlink_tree (ThunarJob *job,
+                  GFile     *file)
+{
+  UnlinkAtContext  context;
+  struct dirent   *entry;
+  struct stat      statb;
+  gboolean         is_dir;
+  gboolean         succeed;
+  gint64           end_time;
+  guint            n_threads;
+  guint            n_deleted = 0;
+  gchar           *path;
+  DIR             *dp;
+
+  /* the regular code path takes care of everything else */
+  if (!g_file_is_native (file) || thunar_g_file_is_root (file))
+    return FALSE;
+
+  path = g_file_get_path (file);
+  if (G_UNLIKELY (path == NULL))
+    return FALSE;
+
+  /* symlinks and files are not opened as a directory */
+  context.fd = open (path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (context.fd < 0)
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  /* fdopendir takes over the fd, so the pool uses a copy */
+  dp = fdopendir (dup (context.fd));
+  if (G_UNLIKELY (dp == NULL))
+    {
+      close (context.fd);
+      g_free (path);
+      return FALSE;
+    }
+
+  context.cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  context.error_code = 0;
+  context.n_pending = 0;
+  context.n_deleted = 0;
+  g_mutex_init (&context.mutex);
+  g_cond_init (&context.cond);
+
+  n_threads = thunar_io_jobs_util_get_max_threads (file, NULL, THUNAR_IO_JOBS_UNLINK_MAX_THREADS,
+                                                   context.cancellable);
+  context.pool = g_thread_pool_new (_tij_unlink_at_worker, &context, n_threads, FALSE, NULL);
+
+  /* remove the files of the toplevel directory here and hand over
+   * the subdirectories to the pool */
+  for (;;)
+    {
+      if (g_cancellable_is_cancelled (context.cancellable)
+          || g_atomic_int_get (&context.error_code) != 0)
+        break;
+
+      errno = 0;
+      entry = readdir (dp);
+      if (entry == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            _tij_unlink_at_failed (&context, errno);
+          break;
+        }
+
+      if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        continue;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (entry->d_type != DT_UNKNOWN)
+        is_dir = (entry->d_type == DT_DIR);
+      else
+#endif
+        {
+          if (fstatat (context.fd, entry->d_name, &statb, AT_SYMLINK_NOFOLLOW) != 0)
+            {
+              _tij_unlink_at_failed (&context, errno);
+              break;
+            }
+          is_dir = S_ISDIR (statb.st_mode);
+        }
+
+      if (is_dir)
+        {
+          g_mutex_lock (&context.mutex);
+          context.n_pending++;
+          g_mutex_unlock (&context.mutex);
+
+          g_thread_pool_push (context.pool, g_strdup (entry->d_name), NULL);
+        }
+      else if (unlinkat (context.fd, entry->d_name, 0) == 0)
+        {
+          if (++n_deleted >= THUNAR_IO_JOBS_UNLINK_BATCH_SIZE)
+            {
+              _tij_unlink_at_deleted (&context, &n_deleted);
+              _tij_unlink_at_progress (job, &context);
+            }
+        }
+      else
+        {
+          _tij_unlink_at_failed (&context, errno);
+          break;
+        }
+    }
+
+  _tij_unlink_at_deleted (&context, &n_deleted);
+  closedir (dp);
+
+  /* wait for the pool, but report the progress four times per second */
+  g_mutex_lock (&context.mutex);
+  while (context.n_pending > 0)
+    {
+      end_time = g_get_monotonic_time () + (G_USEC_PER_SEC / 4);
+      if (!g_cond_wait_until (&context.cond, &context.mutex, end_time)
+          && context.n_pending > 0)
+        {
+          g_mutex_unlock (&context.mutex);
+          _tij_unlink_at_progress (job, &context);
+          g_mutex_lock (&context.mutex);
+        }
+    }
+  g_mutex_unlock (&context.mutex);
+
+  g_thread_pool_free (context.pool, FALSE, TRUE);
+  g_mutex_clear (&context.mutex);
+  g_cond_clear (&context.cond);
+  close (context.fd);
+
+  /* remove the toplevel directory once it is empty */
+  succeed = (context.error_code == 0
+             && !g_cancellable_is_cancelled (context.cancellable)
+             && g_rmdir (path) == 0);
+
+  g_free (path);
+
+  return succeed;
+}
+#endif
+
+
+
+static gboolean
+_thunar_io_jobs_create (ThunarJob  *job,
+                        GArray     *param_values,
+                        GError    **error)
+{
+  GFileOutputStream *stream;
+  ThunarJobResponse  response = THUNAR_JOB_RESPONSE_CANCEL;
+  CreateAtParent     parent = CREATE_AT_PARENT_INIT;
+  GFileInfo         *info;
+  GError            *err = NULL;
+  GList             *file_list;
+  GList             *lp;
+  gchar             *base_name;
+  gchar             *display_name;
+  guint              n_processed = 0;
+  GFile             *template_file;
+  GFileInputStream  *template_stream = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* get the file list */
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  template_file = g_value_get_object (&g_array_index (param_values, GValue, 1));
+
+  /* we know the total amount of files to be processed */
+  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+
+  /* check if we need to open the template */
+  if (template_file != NULL)
+    {
+      /* open read stream to feed in the new files */
+      template_stream = g_file_read (template_file, exo_job_get_cancellable (EXO_JOB (job)), &err);
+      if (G_UNLIKELY (template_stream == NULL))
+        {
+          g_propagate_error (error, err);
+          return FALSE;
+        }
+    }
+
+  /* iterate over all files in the list */
+  for (lp = file_list;
+       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       lp = lp->next, n_processed++)
+    {
+      g_assert (G_IS_FILE (lp->data));
+
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp, n_processed);
+
+    again:
+      /* try to create the file, empty files don't need a stream */
+      stream = NULL;
+      if (template_stream != NULL)
+        {
+          stream = g_file_create (lp->data,
+                                  G_FILE_CREATE_NONE,
+                                  exo_job_get_cancellable (EXO_JOB (job)),
+                                  &err);
+        }
+      else
+        {
+          _tij_create_file (&parent, lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
+        }
+
+      /* abort if the job was cancelled */
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          if (stream != NULL)
+            g_object_unref (stream);
+          break;
+        }
+
+      /* check if creating failed */
+      if (err != NULL)
+        {
+          if (err->code == G_IO_ERROR_EXISTS)
+            {
+              g_clear_error (&err);
 
               /* the file already exists, query its display name */
               info = g_file_query_info (lp->data,
@@ -369,10 +894,10 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
                                                    _("The file \"%s\" already exists"),
                                                    display_name);
 
-              /* check if we should overwrite it */
+              /* check if we should overwrite */
               if (response == THUNAR_JOB_RESPONSE_REPLACE)
                 {
-                  /* try to remove the file, fail if not possible */
+                  /* try to remove the file. fail if not possible */
                   if (_tij_delete_file (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
                     goto again;
                 }
@@ -382,27 +907,42 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
             }
           else
             {
-              /* determine the display name of the file */
+              /* determine display name of the file */
               base_name = g_file_get_basename (lp->data);
               display_name = g_filename_display_basename (base_name);
               g_free (base_name);
 
               /* ask the user whether to skip/retry this path (cancels the job if not) */
               response = thunar_job_ask_skip (THUNAR_JOB (job),
-                                              _("Failed to create directory \"%s\": %s"),
+                                              _("Failed to create empty file \"%s\": %s"),
                                               display_name, err->message);
               g_free (display_name);
 
-              g_error_free (err);
-              err = NULL;
+              g_clear_error (&err);
 
               /* go back to the beginning if the user wants to retry */
               if (response == THUNAR_JOB_RESPONSE_RETRY)
                 goto again;
             }
         }
+      else if (stream != NULL)
+        {
+          /* write the template into the new file */
+          g_output_stream_splice (G_OUTPUT_STREAM (stream),
+                                  G_INPUT_STREAM (template_stream),
+                                  G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                  exo_job_get_cancellable (EXO_JOB (job)),
+                                  NULL);
+
+          g_object_unref (stream);
+        }
     }
 
+  _tij_create_at_parent_clear (&parent);
+
+  if (template_stream != NULL)
+    g_object_unref (template_stream);
+
   /* check if we have failed */
   if (err != NULL)
     {
@@ -423,64 +963,247 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
 
 
 ThunarJob *
-thunar_io_jobs_make_directories (GList *file_list)
+thunar_io_jobs_create_files (GList *file_list,
+                             GFile *template_file)
 {
-  return thunar_simple_job_new (_thunar_io_jobs_mkdir, 1,
-                                THUNAR_TYPE_G_FILE_LIST, file_list);
+  ThunarJob *job;
+
+  job = thunar_simple_job_new (_thunar_io_jobs_create, 2,
+                               THUNAR_TYPE_G_FILE_LIST, file_list,
+                               G_TYPE_FILE, template_file);
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
 }
 
 
 
 static gboolean
-_thunar_io_jobs_unlink (ThunarJob  *job,
-                        GArray     *param_values,
-                        GError    **error)
+_thunar_io_jobs_mkdir (ThunarJob  *job,
+                       GArray     *param_values,
+                       GError    **error)
 {
-  ThunarThumbnailCache *thumbnail_cache;
-  ThunarApplication    *application;
-  ThunarJobResponse     response;
-  GFileInfo            *info;
-  GError               *err = NULL;
-  GList                *file_list;
-  GList                *lp;
-  gchar                *base_name;
-  gchar                *display_name;
-  guint                 n_processed = 0;
+  ThunarJobResponse response;
+  CreateAtParent    parent = CREATE_AT_PARENT_INIT;
+  GFileInfo        *info;
+  GError           *err = NULL;
+  GList            *file_list;
+  GList            *lp;
+  gchar            *base_name;
+  gchar            *display_name;
+  guint             n_processed = 0;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
   _thunar_return_val_if_fail (param_values->len == 1, FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  /* get the file list */
   file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
-  /* tell the user that we're preparing to unlink the files */
-  exo_job_info_message (EXO_JOB (job), _("Preparing..."));
-
-  /* recursively collect files for removal, not following any symlinks */
-  file_list = _tij_collect_nofollow (job, file_list, TRUE, &err);
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
 
-  /* free the file list and fail if there was an error or the job was cancelled */
-  if (err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
+  for (lp = file_list;
+       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       lp = lp->next,  n_processed++)
     {
-      if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-        g_error_free (err);
-      else
-        g_propagate_error (error, err);
+      g_assert (G_IS_FILE (lp->data));
 
-      thunar_g_list_free_full (file_list);
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp, n_processed);
+
+    again:
+      /* try to create the directory */
+      if (!_tij_make_directory (&parent, lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
+        {
+          if (err->code == G_IO_ERROR_EXISTS)
+            {
+              g_error_free (err);
+              err = NULL;
+
+              /* abort if the job was cancelled */
+              if (exo_job_is_cancelled (EXO_JOB (job)))
+                break;
+
+              /* the file already exists, query its display name */
+              info = g_file_query_info (lp->data,
+                                        G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        exo_job_get_cancellable (EXO_JOB (job)),
+                                        NULL);
+
+              /* abort if the job was cancelled */
+              if (exo_job_is_cancelled (EXO_JOB (job)))
+                break;
+
+              /* determine the display name, using the basename as a fallback */
+              if (info != NULL)
+                {
+                  display_name = g_strdup (g_file_info_get_display_name (info));
+                  g_object_unref (info);
+                }
+              else
+                {
+                  base_name = g_file_get_basename (lp->data);
+                  display_name = g_filename_display_name (base_name);
+                  g_free (base_name);
+                }
+
+              /* ask the user whether he wants to overwrite the existing file */
+              response = thunar_job_ask_overwrite (THUNAR_JOB (job),
+                                                   _("The file \"%s\" already exists"),
+                                                   display_name);
+
+              /* check if we should overwrite it */
+              if (response == THUNAR_JOB_RESPONSE_REPLACE)
+                {
+                  /* try to remove the file, fail if not possible */
+                  if (_tij_delete_file (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
+                    goto again;
+                }
+
+              /* clean up */
+              g_free (display_name);
+            }
+          else
+            {
+              /* determine the display name of the file */
+              base_name = g_file_get_basename (lp->data);
+              display_name = g_filename_display_basename (base_name);
+              g_free (base_name);
+
+              /* ask the user whether to skip/retry this path (cancels the job if not) */
+              response = thunar_job_ask_skip (THUNAR_JOB (job),
+                                              _("Failed to create directory \"%s\": %s"),
+                                              display_name, err->message);
+              g_free (display_name);
+
+              g_error_free (err);
+              err = NULL;
+
+              /* go back to the beginning if the user wants to retry */
+              if (response == THUNAR_JOB_RESPONSE_RETRY)
+                goto again;
+            }
+        }
+    }
+
+  _tij_create_at_parent_clear (&parent);
+
+  /* check if we have failed */
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
       return FALSE;
     }
 
-  /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  /* check if the job was cancelled */
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    return FALSE;
+
+  /* emit the "new-files" signal with the given file list */
+  thunar_job_new_files (THUNAR_JOB (job), file_list);
+
+  return TRUE;
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_make_directories (GList *file_list)
+{
+  ThunarJob *job;
+
+  job = thunar_simple_job_new (_thunar_io_jobs_mkdir, 1,
+                               THUNAR_TYPE_G_FILE_LIST, file_list);
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_unlink (ThunarJob  *job,
+                        GArray     *param_values,
+                        GError    **error)
+{
+  ThunarThumbnailCache *thumbnail_cache;
+  ThunarApplication    *application;
+  ThunarJobResponse     response;
+  GFileInfo            *info;
+  GError               *err = NULL;
+  GList                *file_list;
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
+  GList                *remaining = NULL;
+#endif
+  GList                *lp;
+  gchar                *base_name;
+  gchar                *display_name;
+  guint                 n_processed = 0;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* get the file list */
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
   /* take a reference on the thumbnail cache */
   application = thunar_application_get ();
   thumbnail_cache = thunar_application_get_thumbnail_cache (application);
   g_object_unref (application);
 
+  /* tell the user that we're preparing to unlink the files */
+  exo_job_info_message (EXO_JOB (job), _("Preparing..."));
+
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
+  /* remove local directory trees in one go, everything that is left is
+   * collected and removed per file below */
+  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    {
+      if (_tij_unlink_tree (job, lp->data))
+        {
+          /* the thumbnails of all files below the directory can go */
+          thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
+          thunar_thumbnail_cache_delete_file (thumbnail_cache, lp->data);
+        }
+      else
+        {
+          remaining = thunar_g_list_prepend_deep (remaining, lp->data);
+        }
+    }
+  remaining = g_list_reverse (remaining);
+
+  /* recursively collect files for removal, not following any symlinks */
+  if (!exo_job_is_cancelled (EXO_JOB (job)))
+    file_list = _tij_collect_nofollow (job, remaining, TRUE, &err);
+  else
+    file_list = NULL;
+
+  thunar_g_list_free_full (remaining);
+#else
+  /* recursively collect files for removal, not following any symlinks */
+  file_list = _tij_collect_nofollow (job, file_list, TRUE, &err);
+#endif
+
+  /* free the file list and fail if there was an error or the job was cancelled */
+  if (err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+        g_error_free (err);
+      else
+        g_propagate_error (error, err);
+
+      g_object_unref (thumbnail_cache);
+      thunar_g_list_free_full (file_list);
+      return FALSE;
+    }
+
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+
   /* remove all the files */
   for (lp = file_list;
        lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
@@ -502,6 +1225,9 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
           /* notify the thumbnail cache that the corresponding thumbnail can also
            * be deleted now */
           thunar_thumbnail_cache_delete_file (thumbnail_cache, lp->data);
+
+          /* files removed from the trash leave it */
+          thunar_trash_count_remove_file (lp->data);
         }
       else
         {
@@ -570,98 +1296,394 @@ thunar_io_jobs_unlink_files (GList *file_list)
 
 
 
-ThunarJob *
-thunar_io_jobs_move_files (GList *source_file_list,
-                           GList *target_file_list)
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
+static gboolean
+_tij_trash_dir_is_valid (const gchar *path)
 {
-  ThunarJob *job;
-
-  _thunar_return_val_if_fail (source_file_list != NULL, NULL);
-  _thunar_return_val_if_fail (target_file_list != NULL, NULL);
-  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
-
-  job = thunar_transfer_job_new (source_file_list, target_file_list,
-                                 THUNAR_TRANSFER_JOB_MOVE);
-  thunar_job_set_pausable (job, TRUE);
+  struct stat statb;
 
-  return job;
+  return g_lstat (path, &statb) == 0
+      && S_ISDIR (statb.st_mode)
+      && statb.st_uid == getuid ();
 }
 
 
 
-ThunarJob *
-thunar_io_jobs_copy_files (GList *source_file_list,
-                           GList *target_file_list)
+/**
+ * _tij_trash_dirs:
+ *
+ * Looks up the trash directories of the user as described by the trash
+ * specification, the home trash and the .Trash/$uid and .Trash-$uid
+ * directories at the top of the mounted filesystems.
+ *
+ * Return value: the list of the paths of the existing trash directories.
+ **/
+static GList *
+_tij_trash_dirs (void)
 {
-  ThunarJob *job;
+  GList       *trash_dirs = NULL;
+  gchar       *path;
+#ifdef HAVE_GIO_UNIX
+  struct stat  statb;
+  const gchar *mount_path;
+  GList       *mounts;
+  GList       *lp;
+  gchar       *shared_dir;
+  gchar        uid[16];
+#endif
 
-  _thunar_return_val_if_fail (source_file_list != NULL, NULL);
-  _thunar_return_val_if_fail (target_file_list != NULL, NULL);
-  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
+  path = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+  if (_tij_trash_dir_is_valid (path))
+    trash_dirs = g_list_prepend (trash_dirs, path);
+  else
+    g_free (path);
 
-  job = thunar_transfer_job_new (source_file_list, target_file_list,
-                                 THUNAR_TRANSFER_JOB_COPY);
-  thunar_job_set_pausable (job, TRUE);
+#ifdef HAVE_GIO_UNIX
+  g_snprintf (uid, sizeof (uid), "%u", (guint) getuid ());
 
-  return job;
-}
+  mounts = g_unix_mounts_get (NULL);
+  for (lp = mounts; lp != NULL; lp = lp->next)
+    {
+      if (g_unix_mount_is_system_internal (lp->data))
+        continue;
 
+      mount_path = g_unix_mount_get_mount_path (lp->data);
 
+      /* the shared .Trash directory has to be sticky and no symlink */
+      shared_dir = g_build_filename (mount_path, ".Trash", NULL);
+      if (g_lstat (shared_dir, &statb) == 0 && S_ISDIR (statb.st_mode) && (statb.st_mode & S_ISVTX) != 0)
+        {
+          path = g_build_filename (shared_dir, uid, NULL);
+          if (_tij_trash_dir_is_valid (path))
+            trash_dirs = g_list_prepend (trash_dirs, path);
+          else
+            g_free (path);
+        }
+      g_free (shared_dir);
 
-static GFile *
-_thunar_io_jobs_link_file (ThunarJob *job,
-                           GFile     *source_file,
-                           GFile     *target_file,
-                           GError   **error)
-{
-  ThunarJobResponse response;
-  GError           *err = NULL;
-  gchar            *base_name;
-  gchar            *display_name;
-  gchar            *source_path;
-  gint              n;
+      path = g_strconcat (mount_path, G_DIR_SEPARATOR_S ".Trash-", uid, NULL);
+      if (_tij_trash_dir_is_valid (path))
+        trash_dirs = g_list_prepend (trash_dirs, path);
+      else
+        g_free (path);
+    }
+  g_list_free_full (mounts, (GDestroyNotify) g_unix_mount_free);
+#endif
 
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
-  _thunar_return_val_if_fail (G_IS_FILE (source_file), NULL);
-  _thunar_return_val_if_fail (G_IS_FILE (target_file), NULL);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+  return g_list_reverse (trash_dirs);
+}
 
-  /* abort on cancellation */
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return NULL;
 
-  /* try to determine the source path */
-  source_path = g_file_get_path (source_file);
-  if (source_path == NULL)
+
+/**
+ * _tij_trash_dir_expunge:
+ * @trash_dir : the path of a trash directory.
+ * @expunged  : return location for the directories to remove.
+ *
+ * Empties @trash_dir at once by renaming its files and info directories
+ * into a new directory next to them and creating empty ones. The new
+ * directory and the ones left over by earlier jobs are prepended to
+ * @expunged as #GFile<!---->s.
+ *
+ * Return value: %TRUE if @trash_dir is empty now.
+ **/
+static gboolean
+_tij_trash_dir_expunge (const gchar  *trash_dir,
+                        GList       **expunged)
+{
+  static const gchar *names[] = { "files", "info" };
+  const gchar        *name;
+  gboolean            succeed = TRUE;
+  gchar              *expunge_dir;
+  gchar              *source;
+  gchar              *target;
+  GDir               *dir;
+  guint               n;
+
+  /* leftovers of jobs that were interrupted */
+  dir = g_dir_open (trash_dir, 0, NULL);
+  if (G_LIKELY (dir != NULL))
     {
-      base_name = g_file_get_basename (source_file);
-      display_name = g_filename_display_name (base_name);
-      g_set_error (&err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
-                   _("Could not create symbolic link to \"%s\" "
-                     "because it is not a local file"), display_name);
-      g_free (display_name);
-      g_free (base_name);
+      while ((name = g_dir_read_name (dir)) != NULL)
+        if (g_str_has_prefix (name, THUNAR_IO_JOBS_EXPUNGE_PREFIX))
+          {
+            source = g_build_filename (trash_dir, name, NULL);
+            *expunged = g_list_prepend (*expunged, g_file_new_for_path (source));
+            g_free (source);
+          }
+      g_dir_close (dir);
     }
 
-  /* various attempts to create the symbolic link */
-  while (err == NULL)
+  expunge_dir = g_build_filename (trash_dir, THUNAR_IO_JOBS_EXPUNGE_PREFIX "XXXXXX", NULL);
+  if (g_mkdtemp_full (expunge_dir, 0700) == NULL)
     {
-      if (!g_file_equal (source_file, target_file))
-        {
-          /* try to create the symlink */
-          if (g_file_make_symbolic_link (target_file, source_path,
-                                         exo_job_get_cancellable (EXO_JOB (job)),
-                                         &err))
-            {
-              /* release the source path */
-              g_free (source_path);
+      g_free (expunge_dir);
+      return FALSE;
+    }
 
-              /* return the real target file */
-              return g_object_ref (target_file);
-            }
-        }
+  /* the files go first, so the trash appears empty right away, orphaned
+   * info files are ignored by the trash implementations */
+  for (n = 0; n < G_N_ELEMENTS (names) && succeed; ++n)
+    {
+      source = g_build_filename (trash_dir, names[n], NULL);
+      target = g_build_filename (expunge_dir, names[n], NULL);
+
+      if (g_rename (source, target) == 0)
+        succeed = (g_mkdir (source, 0700) == 0);
       else
-        {
+        succeed = (errno == ENOENT);
+
+      g_free (source);
+      g_free (target);
+    }
+
+  *expunged = g_list_prepend (*expunged, g_file_new_for_path (expunge_dir));
+  g_free (expunge_dir);
+
+  return succeed;
+}
+
+
+
+static gboolean
+_tij_trash_changed (gpointer user_data)
+{
+  ThunarFile *trash_bin = user_data;
+
+  /* update the item count and the icon of the trash bin */
+  thunar_file_reload_idle (trash_bin);
+
+  return FALSE;
+}
+#endif
+
+
+
+static gboolean
+_thunar_io_jobs_empty_trash (ThunarJob  *job,
+                             GArray     *param_values,
+                             GError    **error)
+{
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
+  ThunarFile *trash_bin;
+  gboolean    succeed = TRUE;
+  GArray     *values;
+  GList      *file_list;
+  GList      *trash_dirs;
+  GList      *expunged = NULL;
+  GList      *remaining = NULL;
+  GList      *lp;
+#endif
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+#ifdef THUNAR_IO_JOBS_UNLINK_AT
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+
+  /* move the contents of all trash directories aside */
+  trash_dirs = _tij_trash_dirs ();
+  for (lp = trash_dirs; lp != NULL; lp = lp->next)
+    if (!_tij_trash_dir_expunge (lp->data, &expunged))
+      succeed = FALSE;
+  g_list_free_full (trash_dirs, g_free);
+
+  /* the trash is empty for the user now */
+  if (succeed)
+    thunar_trash_count_reset ();
+  trash_bin = thunar_file_cache_lookup (file_list->data);
+  if (trash_bin != NULL)
+    exo_job_send_to_mainloop (EXO_JOB (job), _tij_trash_changed, trash_bin, g_object_unref);
+
+  /* remove everything that was moved aside in parallel */
+  for (lp = expunged; lp != NULL; lp = lp->next)
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)) || !_tij_unlink_tree (job, lp->data))
+        remaining = g_list_prepend (remaining, g_object_ref (lp->data));
+    }
+  thunar_g_list_free_full (expunged);
+
+  /* a cancelled job leaves the rest to the next one */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      thunar_g_list_free_full (remaining);
+      return FALSE;
+    }
+
+  /* trashes that could not be moved aside are emptied through gio */
+  if (!succeed)
+    remaining = thunar_g_list_prepend_deep (remaining, file_list->data);
+
+  if (remaining == NULL)
+    return TRUE;
+
+  /* everything left is removed per file, so the user can skip or retry */
+  values = g_array_sized_new (FALSE, TRUE, sizeof (GValue), 1);
+  g_array_set_size (values, 1);
+  g_value_init (&g_array_index (values, GValue, 0), THUNAR_TYPE_G_FILE_LIST);
+  g_value_take_boxed (&g_array_index (values, GValue, 0), remaining);
+  succeed = _thunar_io_jobs_unlink (job, values, error);
+  g_value_unset (&g_array_index (values, GValue, 0));
+  g_array_free (values, TRUE);
+
+  return succeed;
+#else
+  return _thunar_io_jobs_unlink (job, param_values, error);
+#endif
+}
+
+
+
+/**
+ * thunar_io_jobs_empty_trash:
+ * @trash_bin : the #GFile of the root of the trash.
+ *
+ * Removes all files and folders in the trash. Unlike unlinking the
+ * contents of @trash_bin, the local trash directories are emptied at
+ * once by moving their contents aside, which are removed afterwards
+ * without looking at the files one by one.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_empty_trash (GFile *trash_bin)
+{
+  GList file_list;
+
+  _thunar_return_val_if_fail (G_IS_FILE (trash_bin), NULL);
+
+  /* fake a file list */
+  file_list.data = trash_bin;
+  file_list.next = NULL;
+  file_list.prev = NULL;
+
+  return thunar_simple_job_new (_thunar_io_jobs_empty_trash, 1,
+                                THUNAR_TYPE_G_FILE_LIST, &file_list);
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_move_files (GList *source_file_list,
+                           GList *target_file_list)
+{
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (source_file_list != NULL, NULL);
+  _thunar_return_val_if_fail (target_file_list != NULL, NULL);
+  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
+
+  job = thunar_transfer_job_new (source_file_list, target_file_list,
+                                 THUNAR_TRANSFER_JOB_MOVE);
+  thunar_job_set_pausable (job, TRUE);
+
+  return job;
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_copy_files (GList *source_file_list,
+                           GList *target_file_list)
+{
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (source_file_list != NULL, NULL);
+  _thunar_return_val_if_fail (target_file_list != NULL, NULL);
+  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
+
+  job = thunar_transfer_job_new (source_file_list, target_file_list,
+                                 THUNAR_TRANSFER_JOB_COPY);
+  thunar_job_set_pausable (job, TRUE);
+
+  return job;
+}
+
+
+
+/**
+ * thunar_io_jobs_update_files:
+ * @source_file_list : the list of #GFile<!---->s to copy.
+ * @target_file_list : the list of target #GFile<!---->s.
+ *
+ * Like thunar_io_jobs_copy_files(), but existing target files are only
+ * replaced if their size or modification time differs from the source,
+ * without asking the user. Unchanged files are skipped without reading
+ * their data, so copying a folder again only transfers what changed.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_update_files (GList *source_file_list,
+                             GList *target_file_list)
+{
+  ThunarJob *job;
+
+  job = thunar_io_jobs_copy_files (source_file_list, target_file_list);
+  thunar_job_set_replace_response (job, THUNAR_JOB_RESPONSE_UPDATE_ALL);
+
+  return job;
+}
+
+
+
+static GFile *
+_thunar_io_jobs_link_file (ThunarJob      *job,
+                           CreateAtParent *parent,
+                           GFile          *source_file,
+                           GFile          *target_file,
+                           GError        **error)
+{
+  ThunarJobResponse response;
+  GError           *err = NULL;
+  gchar            *base_name;
+  gchar            *display_name;
+  gchar            *source_path;
+  gint              n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE (source_file), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE (target_file), NULL);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  /* abort on cancellation */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return NULL;
+
+  /* try to determine the source path */
+  source_path = g_file_get_path (source_file);
+  if (source_path == NULL)
+    {
+      base_name = g_file_get_basename (source_file);
+      display_name = g_filename_display_name (base_name);
+      g_set_error (&err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   _("Could not create symbolic link to \"%s\" "
+                     "because it is not a local file"), display_name);
+      g_free (display_name);
+      g_free (base_name);
+    }
+
+  /* various attempts to create the symbolic link */
+  while (err == NULL)
+    {
+      if (!g_file_equal (source_file, target_file))
+        {
+          /* try to create the symlink */
+          if (_tij_make_symbolic_link (parent, target_file, source_path,
+                                       exo_job_get_cancellable (EXO_JOB (job)),
+                                       &err))
+            {
+              /* release the source path */
+              g_free (source_path);
+
+              /* return the real target file */
+              return g_object_ref (target_file);
+            }
+        }
+      else
+        {
           for (n = 1; err == NULL; ++n)
             {
               GFile *duplicate_file = thunar_io_jobs_util_next_duplicate_file (job,
@@ -672,9 +1694,9 @@ _thunar_io_jobs_link_file (ThunarJob *job,
               if (err == NULL)
                 {
                   /* try to create the symlink */
-                  if (g_file_make_symbolic_link (duplicate_file, source_path,
-                                                 exo_job_get_cancellable (EXO_JOB (job)),
-                                                 &err))
+                  if (_tij_make_symbolic_link (parent, duplicate_file, source_path,
+                                               exo_job_get_cancellable (EXO_JOB (job)),
+                                               &err))
                     {
                       /* release the source path */
                       g_free (source_path);
@@ -741,6 +1763,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarApplication    *application;
+  CreateAtParent        parent = CREATE_AT_PARENT_INIT;
   GError               *err = NULL;
   GFile                *real_target_file;
   GList                *new_files_list = NULL;
@@ -778,7 +1801,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
       thunar_job_processing_file (THUNAR_JOB (job), sp, n_processed);
 
       /* try to create the symbolic link */
-      real_target_file = _thunar_io_jobs_link_file (job, sp->data, tp->data, &err);
+      real_target_file = _thunar_io_jobs_link_file (job, &parent, sp->data, tp->data, &err);
       if (real_target_file != NULL)
         {
           /* queue the file for the folder update unless it was skipped */
@@ -799,6 +1822,8 @@ _thunar_io_jobs_link (ThunarJob  *job,
         }
     }
 
+  _tij_create_at_parent_clear (&parent);
+
   /* release the thumbnail cache */
   g_object_unref (thumbnail_cache);
 
@@ -833,6 +1858,183 @@ thunar_io_jobs_link_files (GList *source_file_list,
 
 
 
+#ifdef THUNAR_IO_JOBS_TRASH_BATCH
+static gboolean
+_tij_trash_batch_init (TrashBatch *batch)
+{
+  struct stat  statb;
+  GDateTime   *now;
+
+  /* the home trash of the trash specification */
+  batch->trash_dir = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+  batch->files_dir = g_build_filename (batch->trash_dir, "files", NULL);
+  batch->info_dir = g_build_filename (batch->trash_dir, "info", NULL);
+
+  if (g_mkdir_with_parents (batch->files_dir, 0700) != 0
+      || g_mkdir_with_parents (batch->info_dir, 0700) != 0
+      || g_lstat (batch->trash_dir, &statb) != 0)
+    {
+      g_free (batch->trash_dir);
+      g_free (batch->files_dir);
+      g_free (batch->info_dir);
+      return FALSE;
+    }
+
+  batch->device = statb.st_dev;
+
+  /* all files of the job share the deletion date */
+  now = g_date_time_new_now_local ();
+  batch->deletion_date = g_date_time_format (now, "%Y-%m-%dT%H:%M:%S");
+  g_date_time_unref (now);
+
+  return TRUE;
+}
+
+
+
+static void
+_tij_trash_batch_clear (TrashBatch *batch)
+{
+  g_free (batch->trash_dir);
+  g_free (batch->files_dir);
+  g_free (batch->info_dir);
+  g_free (batch->deletion_date);
+}
+
+
+
+static gboolean
+_tij_trash_batch_write_info (gint         fd,
+                             const gchar *contents)
+{
+  gsize   length = strlen (contents);
+  gssize  n;
+
+  while (length > 0)
+    {
+      n = write (fd, contents, length);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return FALSE;
+        }
+
+      contents += n;
+      length -= n;
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * _tij_trash_batch_file:
+ * @batch : a #TrashBatch.
+ * @file  : the #GFile to trash.
+ *
+ * Moves @file to the home trash if it lives on the same filesystem,
+ * writing the trash info file the way g_file_trash() does.
+ *
+ * Return value: %TRUE if @file was trashed, %FALSE if it has to be
+ *               trashed with g_file_trash().
+ **/
+static gboolean
+_tij_trash_batch_file (TrashBatch *batch,
+                       GFile      *file)
+{
+  struct stat  statb;
+  gboolean     succeed = FALSE;
+  gchar       *path;
+  gchar       *basename;
+  gchar       *name = NULL;
+  gchar       *info_name;
+  gchar       *info_path = NULL;
+  gchar       *trashed_path;
+  gchar       *escaped;
+  gchar       *contents;
+  guint        n;
+  gint         fd = -1;
+
+  path = g_file_get_path (file);
+  if (G_UNLIKELY (path == NULL))
+    return FALSE;
+
+  /* files on other filesystems and in the trash itself are left to gio */
+  if (g_lstat (path, &statb) != 0
+      || statb.st_dev != batch->device
+      || (g_str_has_prefix (path, batch->trash_dir)
+          && (path[strlen (batch->trash_dir)] == G_DIR_SEPARATOR
+              || path[strlen (batch->trash_dir)] == '\0')))
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  /* reserve a name in the trash by creating its info file */
+  basename = g_path_get_basename (path);
+  for (n = 0; n < THUNAR_IO_JOBS_TRASH_MAX_NAMES; ++n)
+    {
+      if (n == 0)
+        name = g_strdup (basename);
+      else
+        name = g_strdup_printf ("%s.%u", basename, n);
+
+      info_name = g_strconcat (name, ".trashinfo", NULL);
+      info_path = g_build_filename (batch->info_dir, info_name, NULL);
+      g_free (info_name);
+
+      fd = g_open (info_path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+      if (fd >= 0 || errno != EEXIST)
+        break;
+
+      g_free (info_path);
+      g_free (name);
+      info_path = NULL;
+      name = NULL;
+    }
+  g_free (basename);
+
+  if (fd < 0)
+    {
+      g_free (info_path);
+      g_free (name);
+      g_free (path);
+      return FALSE;
+    }
+
+  escaped = g_uri_escape_string (path, "/", TRUE);
+  contents = g_strdup_printf ("[Trash Info]\nPath=%s\nDeletionDate=%s\n",
+                              escaped, batch->deletion_date);
+  succeed = _tij_trash_batch_write_info (fd, contents);
+  g_free (contents);
+  g_free (escaped);
+
+  if (close (fd) != 0)
+    succeed = FALSE;
+
+  if (succeed)
+    {
+      trashed_path = g_build_filename (batch->files_dir, name, NULL);
+      succeed = (g_rename (path, trashed_path) == 0);
+      g_free (trashed_path);
+    }
+
+  /* release the name again if the file stays where it is */
+  if (!succeed)
+    g_unlink (info_path);
+
+  g_free (info_path);
+  g_free (name);
+  g_free (path);
+
+  return succeed;
+}
+#endif
+
+
+
 static gboolean
 _thunar_io_jobs_trash (ThunarJob  *job,
                        GArray     *param_values,
@@ -844,6 +2046,11 @@ _thunar_io_jobs_trash (ThunarJob  *job,
   GError               *err = NULL;
   GList                *file_list;
   GList                *lp;
+#ifdef THUNAR_IO_JOBS_TRASH_BATCH
+  TrashBatch            batch;
+  gboolean              batched;
+#endif
+  gint                  n_trashed = 0;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -860,14 +2067,26 @@ _thunar_io_jobs_trash (ThunarJob  *job,
   thumbnail_cache = thunar_application_get_thumbnail_cache (application);
   g_object_unref (application);
 
-  for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+#ifdef THUNAR_IO_JOBS_TRASH_BATCH
+  /* resolve the home trash once for all files */
+  batched = _tij_trash_batch_init (&batch);
+#endif
+
+  for (lp = file_list;
+       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       lp = lp->next)
     {
       _thunar_assert (G_IS_FILE (lp->data));
 
       /* trash the file or folder */
-      g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
+#ifdef THUNAR_IO_JOBS_TRASH_BATCH
+      if (!batched || !_tij_trash_batch_file (&batch, lp->data))
+#endif
+        g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
 
-      if (err != NULL)
+      if (err == NULL)
+        n_trashed++;
+      else
         {
           response = thunar_job_ask_delete (job, "%s", err->message);
 
@@ -880,52 +2099,529 @@ _thunar_io_jobs_trash (ThunarJob  *job,
             _tij_delete_file (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
         }
 
-      /* update the thumbnail cache */
-      thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
+      /* update the thumbnail cache */
+      thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
+    }
+
+#ifdef THUNAR_IO_JOBS_TRASH_BATCH
+  if (batched)
+    _tij_trash_batch_clear (&batch);
+#endif
+
+  /* every trashed file is a new toplevel item in the trash */
+  thunar_trash_count_add (n_trashed);
+
+  /* release the thumbnail cache */
+  g_object_unref (thumbnail_cache);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+  else
+    {
+      return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+    }
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_trash_files (GList *file_list)
+{
+  _thunar_return_val_if_fail (file_list != NULL, NULL);
+
+  return thunar_simple_job_new (_thunar_io_jobs_trash, 1,
+                                THUNAR_TYPE_G_FILE_LIST, file_list);
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_restore_files (GList *source_file_list,
+                              GList *target_file_list)
+{
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (source_file_list != NULL, NULL);
+  _thunar_return_val_if_fail (target_file_list != NULL, NULL);
+  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
+
+  job = thunar_transfer_job_new (source_file_list, target_file_list,
+                                 THUNAR_TRANSFER_JOB_MOVE);
+
+  return job;
+}
+
+
+
+static void
+_tij_check_pause (ThunarJob *job)
+{
+  while (thunar_job_is_paused (job) && !exo_job_is_cancelled (EXO_JOB (job)))
+    g_usleep (THUNAR_IO_JOBS_PAUSE_INTERVAL);
+}
+
+
+
+#ifdef THUNAR_IO_JOBS_CHANGE_AT
+static gboolean
+_tij_change_at_failed (ChangeAtContext *context,
+                       gint             error_code)
+{
+  /* only remember the first failure */
+  g_atomic_int_compare_and_exchange (&context->error_code, 0, error_code);
+  return FALSE;
+}
+
+
+
+static void
+_tij_change_at_changed (ChangeAtContext *context,
+                        guint           *n_changed)
+{
+  g_mutex_lock (&context->mutex);
+  context->n_changed += *n_changed;
+  g_mutex_unlock (&context->mutex);
+
+  *n_changed = 0;
+}
+
+
+
+static gboolean
+_tij_change_at_stopped (ChangeAtContext *context)
+{
+  /* all threads hold while the job is paused */
+  _tij_check_pause (context->job);
+
+  return g_cancellable_is_cancelled (context->cancellable)
+      || g_atomic_int_get (&context->error_code) != 0;
+}
+
+
+
+static gboolean
+_tij_change_at_before (ChangeAtContext   *context,
+                       const struct stat *statb)
+{
+  ThunarFileMode new_mode;
+
+  if (!context->chmod)
+    return TRUE;
+
+  /* a directory we are about to lock ourselves out of is changed
+   * after its content, otherwise before it is read */
+  new_mode = ((statb->st_mode & ~context->dir_mask) | context->dir_mode) & 07777;
+  return (new_mode & (S_IRUSR | S_IXUSR)) == (S_IRUSR | S_IXUSR);
+}
+
+
+
+static gboolean
+_tij_change_at_apply (ChangeAtContext   *context,
+                      gint               dir_fd,
+                      const gchar       *name,
+                      const struct stat *statb)
+{
+  ThunarFileMode mask;
+  ThunarFileMode mode;
+  ThunarFileMode new_mode;
+
+  if (!context->chmod)
+    {
+      /* only files with a different owner or group are changed */
+      if ((context->uid < 0 || statb->st_uid == (uid_t) context->uid)
+          && (context->gid < 0 || statb->st_gid == (gid_t) context->gid))
+        return TRUE;
+
+      if (fchownat (dir_fd, name, context->uid, context->gid, AT_SYMLINK_NOFOLLOW) != 0)
+        return _tij_change_at_failed (context, errno);
+      return TRUE;
+    }
+
+  /* the permissions of symlinks are never used */
+  if (S_ISLNK (statb->st_mode))
+    return TRUE;
+
+  if (S_ISDIR (statb->st_mode))
+    {
+      mask = context->dir_mask;
+      mode = context->dir_mode;
+    }
+  else
+    {
+      mask = context->file_mask;
+      mode = context->file_mode;
+    }
+
+  new_mode = ((statb->st_mode & ~mask) | mode) & 07777;
+  if ((statb->st_mode & 07777) != new_mode
+      && fchmodat (dir_fd, name, new_mode, 0) != 0)
+    return _tij_change_at_failed (context, errno);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+_tij_change_at (ChangeAtContext   *context,
+                gint               parent_fd,
+                const gchar       *name,
+                const struct stat *statb,
+                guint              depth)
+{
+  struct dirent *entry;
+  struct stat    child_statb;
+  gboolean       before;
+  gboolean       succeed = TRUE;
+  guint          n_changed = 0;
+  DIR           *dp;
+  gint           fd;
+
+  if (G_UNLIKELY (depth > THUNAR_IO_JOBS_CHANGE_MAX_DEPTH))
+    return _tij_change_at_failed (context, ENAMETOOLONG);
+
+  before = _tij_change_at_before (context, statb);
+  if (before && !_tij_change_at_apply (context, parent_fd, name, statb))
+    return FALSE;
+
+  /* never leave the tree through a symlink that replaced a directory */
+  fd = openat (parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (G_UNLIKELY (fd < 0))
+    return _tij_change_at_failed (context, errno);
+
+  dp = fdopendir (fd);
+  if (G_UNLIKELY (dp == NULL))
+    {
+      close (fd);
+      return _tij_change_at_failed (context, errno);
+    }
+
+  for (;;)
+    {
+      if (_tij_change_at_stopped (context))
+        {
+          succeed = FALSE;
+          break;
+        }
+
+      errno = 0;
+      entry = readdir (dp);
+      if (entry == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            succeed = _tij_change_at_failed (context, errno);
+          break;
+        }
+
+      if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        continue;
+
+      if (fstatat (fd, entry->d_name, &child_statb, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+          succeed = _tij_change_at_failed (context, errno);
+          break;
+        }
+
+      if (S_ISDIR (child_statb.st_mode))
+        succeed = _tij_change_at (context, fd, entry->d_name, &child_statb, depth + 1);
+      else if ((succeed = _tij_change_at_apply (context, fd, entry->d_name, &child_statb))
+               && ++n_changed >= THUNAR_IO_JOBS_CHANGE_BATCH_SIZE)
+        _tij_change_at_changed (context, &n_changed);
+
+      if (!succeed)
+        break;
+    }
+
+  /* this also closes the fd */
+  closedir (dp);
+
+  if (succeed && !before)
+    succeed = _tij_change_at_apply (context, parent_fd, name, statb);
+
+  if (succeed)
+    ++n_changed;
+
+  _tij_change_at_changed (context, &n_changed);
+
+  return succeed;
+}
+
+
+
+static void
+_tij_change_at_worker (gpointer data,
+                       gpointer user_data)
+{
+  ChangeAtContext *context = user_data;
+  struct stat      statb;
+  gchar           *name = data;
+
+  if (!_tij_change_at_stopped (context))
+    {
+      if (fstatat (context->fd, name, &statb, AT_SYMLINK_NOFOLLOW) == 0)
+        _tij_change_at (context, context->fd, name, &statb, 1);
+      else
+        _tij_change_at_failed (context, errno);
+    }
+  g_free (name);
+
+  g_mutex_lock (&context->mutex);
+  context->n_pending--;
+  g_cond_signal (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+static void
+_tij_change_at_progress (ThunarJob       *job,
+                         ChangeAtContext *context)
+{
+  gint64  elapsed;
+  gint64  now;
+  guint   n_changed;
+  guint   rate = 0;
+  gchar  *message;
+
+  now = g_get_monotonic_time ();
+  if (thunar_job_is_paused (job))
+    {
+      if (context->pause_time == 0)
+        {
+          context->pause_time = now;
+          exo_job_info_message (EXO_JOB (job), _("Paused"));
+        }
+      return;
+    }
+  else if (context->pause_time != 0)
+    {
+      /* leave the pause out of the throughput */
+      context->start_time += now - context->pause_time;
+      context->pause_time = 0;
+    }
+
+  g_mutex_lock (&context->mutex);
+  n_changed = context->n_changed;
+  g_mutex_unlock (&context->mutex);
+
+  elapsed = now - context->start_time;
+  if (G_LIKELY (elapsed > 0))
+    rate = (guint) (((gdouble) n_changed * G_USEC_PER_SEC) / elapsed);
+
+  message = g_strdup_printf (ngettext ("%u file changed", "%u files changed", n_changed), n_changed);
+  exo_job_info_message (EXO_JOB (job), ngettext ("%s (%u file per second)", "%s (%u files per second)", rate), message, rate);
+  g_free (message);
+}
+
+
+
+/**
+ * _tij_change_tree:
+ * @job     : a #ThunarJob.
+ * @file    : the #GFile of a directory.
+ * @context : a #ChangeAtContext with the change to apply.
+ *
+ * Applies the change in @context to the local directory tree @file
+ * while walking it. The toplevel directory is read by the job thread,
+ * which hands the subdirectories over to a pool of threads and reports
+ * the throughput while the pool works.
+ *
+ * Nothing is reported to the user if this fails, the tree is expected
+ * to be changed per file afterwards, so the user can skip or retry.
+ *
+ * Return value: %TRUE if the whole tree was changed.
+ **/
+static gboolean
+_tij_change_tree (ThunarJob       *job,
+                  GFile           *file,
+                  ChangeAtContext *context)
+{
+  struct dirent  *entry;
+  struct stat     statb;
+  struct stat     child_statb;
+  gboolean        before;
+  gboolean        succeed;
+  gint64          end_time;
+  guint           n_threads;
+  guint           n_changed = 0;
+  gchar          *path;
+  DIR            *dp;
+
+  if (!g_file_is_native (file))
+    return FALSE;
+
+  path = g_file_get_path (file);
+  if (G_UNLIKELY (path == NULL))
+    return FALSE;
+
+  /* files and symlinks are left to the regular code path */
+  if (g_lstat (path, &statb) != 0 || !S_ISDIR (statb.st_mode))
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  context->job = job;
+  context->cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  context->start_time = g_get_monotonic_time ();
+  context->pause_time = 0;
+  context->error_code = 0;
+  context->n_pending = 0;
+  context->n_changed = 0;
+
+  before = _tij_change_at_before (context, &statb);
+  if (before && !_tij_change_at_apply (context, AT_FDCWD, path, &statb))
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  context->fd = open (path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (context->fd < 0)
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  /* fdopendir takes over the fd, so the pool uses a copy */
+  dp = fdopendir (dup (context->fd));
+  if (G_UNLIKELY (dp == NULL))
+    {
+      close (context->fd);
+      g_free (path);
+      return FALSE;
+    }
+
+  g_mutex_init (&context->mutex);
+  g_cond_init (&context->cond);
+
+  n_threads = thunar_io_jobs_util_get_max_threads (file, NULL, THUNAR_IO_JOBS_CHANGE_MAX_THREADS,
+                                                   context->cancellable);
+  context->pool = g_thread_pool_new (_tij_change_at_worker, context, n_threads, FALSE, NULL);
+
+  /* change the files of the toplevel directory here and hand over
+   * the subdirectories to the pool */
+  for (;;)
+    {
+      /* show the pause before this thread holds too */
+      if (thunar_job_is_paused (job))
+        _tij_change_at_progress (job, context);
+
+      if (_tij_change_at_stopped (context))
+        break;
+
+      errno = 0;
+      entry = readdir (dp);
+      if (entry == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            _tij_change_at_failed (context, errno);
+          break;
+        }
+
+      if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        continue;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (entry->d_type == DT_DIR)
+        {
+          g_mutex_lock (&context->mutex);
+          context->n_pending++;
+          g_mutex_unlock (&context->mutex);
+
+          g_thread_pool_push (context->pool, g_strdup (entry->d_name), NULL);
+          continue;
+        }
+#endif
+
+      if (fstatat (context->fd, entry->d_name, &child_statb, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+          _tij_change_at_failed (context, errno);
+          break;
+        }
+
+      if (S_ISDIR (child_statb.st_mode))
+        {
+          g_mutex_lock (&context->mutex);
+          context->n_pending++;
+          g_mutex_unlock (&context->mutex);
+
+          g_thread_pool_push (context->pool, g_strdup (entry->d_name), NULL);
+        }
+      else if (!_tij_change_at_apply (context, context->fd, entry->d_name, &child_statb))
+        {
+          break;
+        }
+      else if (++n_changed >= THUNAR_IO_JOBS_CHANGE_BATCH_SIZE)
+        {
+          _tij_change_at_changed (context, &n_changed);
+          _tij_change_at_progress (job, context);
+        }
     }
 
-  /* release the thumbnail cache */
-  g_object_unref (thumbnail_cache);
+  _tij_change_at_changed (context, &n_changed);
+  closedir (dp);
 
-  if (err != NULL)
-    {
-      g_propagate_error (error, err);
-      return FALSE;
-    }
-  else
+  /* wait for the pool, but report the progress four times per second */
+  g_mutex_lock (&context->mutex);
+  while (context->n_pending > 0)
     {
-      return TRUE;
+      end_time = g_get_monotonic_time () + (G_USEC_PER_SEC / 4);
+      if (!g_cond_wait_until (&context->cond, &context->mutex, end_time)
+          && context->n_pending > 0)
+        {
+          g_mutex_unlock (&context->mutex);
+          _tij_change_at_progress (job, context);
+          g_mutex_lock (&context->mutex);
+        }
     }
-}
+  g_mutex_unlock (&context->mutex);
 
+  g_thread_pool_free (context->pool, FALSE, TRUE);
+  g_mutex_clear (&context->mutex);
+  g_cond_clear (&context->cond);
+  close (context->fd);
 
+  succeed = (context->error_code == 0 && !g_cancellable_is_cancelled (context->cancellable));
 
-ThunarJob *
-thunar_io_jobs_trash_files (GList *file_list)
-{
-  _thunar_return_val_if_fail (file_list != NULL, NULL);
+  /* the toplevel directory is changed last if it locks us out */
+  if (succeed && !before)
+    succeed = _tij_change_at_apply (context, AT_FDCWD, path, &statb);
 
-  return thunar_simple_job_new (_thunar_io_jobs_trash, 1,
-                                THUNAR_TYPE_G_FILE_LIST, file_list);
+  g_free (path);
+
+  return succeed;
 }
 
 
 
-ThunarJob *
-thunar_io_jobs_restore_files (GList *source_file_list,
-                              GList *target_file_list)
+static GList *
+_tij_change_trees (ThunarJob       *job,
+                   GList           *base_file_list,
+                   ChangeAtContext *context,
+                   GError         **error)
 {
-  ThunarJob *job;
+  GList *remaining = NULL;
+  GList *file_list;
+  GList *lp;
 
-  _thunar_return_val_if_fail (source_file_list != NULL, NULL);
-  _thunar_return_val_if_fail (target_file_list != NULL, NULL);
-  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
+  /* change local directory trees in one go */
+  for (lp = base_file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    if (!_tij_change_tree (job, lp->data, context))
+      remaining = thunar_g_list_prepend_deep (remaining, lp->data);
+  remaining = g_list_reverse (remaining);
 
-  job = thunar_transfer_job_new (source_file_list, target_file_list,
-                                 THUNAR_TRANSFER_JOB_MOVE);
+  /* everything that is left is collected and changed per file */
+  file_list = _tij_collect_nofollow (job, remaining, FALSE, error);
+  thunar_g_list_free_full (remaining);
 
-  return job;
+  return file_list;
 }
+#endif
 
 
 
@@ -944,6 +2640,9 @@ _thunar_io_jobs_chown (ThunarJob  *job,
   gint              uid;
   gint              gid;
   guint             n_processed = 0;
+#ifdef THUNAR_IO_JOBS_CHANGE_AT
+  ChangeAtContext   context = { 0, };
+#endif
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -959,7 +2658,15 @@ _thunar_io_jobs_chown (ThunarJob  *job,
 
   /* collect the files for the chown operation */
   if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
+    {
+#ifdef THUNAR_IO_JOBS_CHANGE_AT
+      context.uid = uid;
+      context.gid = gid;
+      file_list = _tij_change_trees (job, file_list, &context, &err);
+#else
+      file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
+#endif
+    }
   else
     file_list = thunar_g_list_copy_deep (file_list);
 
@@ -975,12 +2682,17 @@ _thunar_io_jobs_chown (ThunarJob  *job,
   /* change the ownership of all files */
   for (lp = file_list; lp != NULL && err == NULL; lp = lp->next, n_processed++)
     {
+      /* hold while the job is paused */
+      _tij_check_pause (job);
+
       /* update progress information */
       thunar_job_processing_file (THUNAR_JOB (job), lp, n_processed);
 
       /* try to query information about the file */
       info = g_file_query_info (lp->data,
-                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                                G_FILE_ATTRIBUTE_UNIX_UID ","
+                                G_FILE_ATTRIBUTE_UNIX_GID,
                                 G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                 exo_job_get_cancellable (EXO_JOB (job)),
                                 &err);
@@ -989,7 +2701,7 @@ _thunar_io_jobs_chown (ThunarJob  *job,
         break;
 
     retry_chown:
-      if (uid >= 0)
+      if (uid >= 0 && (guint32) uid != g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID))
         {
           /* try to change the owner UID */
           g_file_set_attribute_uint32 (lp->data,
@@ -998,7 +2710,7 @@ _thunar_io_jobs_chown (ThunarJob  *job,
                                        exo_job_get_cancellable (EXO_JOB (job)),
                                        &err);
         }
-      else if (gid >= 0)
+      else if (gid >= 0 && (guint32) gid != g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_GID))
         {
           /* try to change the owner GID */
           g_file_set_attribute_uint32 (lp->data,
@@ -1087,6 +2799,9 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   ThunarFileMode    mode;
   ThunarFileMode    old_mode;
   ThunarFileMode    new_mode;
+#ifdef THUNAR_IO_JOBS_CHANGE_AT
+  ChangeAtContext   context = { 0, };
+#endif
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -1102,7 +2817,18 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
 
   /* collect the files for the chown operation */
   if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
+    {
+#ifdef THUNAR_IO_JOBS_CHANGE_AT
+      context.chmod = TRUE;
+      context.dir_mask = dir_mask;
+      context.dir_mode = dir_mode;
+      context.file_mask = file_mask;
+      context.file_mode = file_mode;
+      file_list = _tij_change_trees (job, file_list, &context, &err);
+#else
+      file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
+#endif
+    }
   else
     file_list = thunar_g_list_copy_deep (file_list);
 
@@ -1118,6 +2844,9 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   /* change the ownership of all files */
   for (lp = file_list; lp != NULL && err == NULL; lp = lp->next, n_processed++)
     {
+      /* hold while the job is paused */
+      _tij_check_pause (job);
+
       /* update progress information */
       thunar_job_processing_file (THUNAR_JOB (job), lp, n_processed);
 
@@ -1230,9 +2959,16 @@ _thunar_io_jobs_ls (ThunarJob  *job,
                     GArray     *param_values,
                     GError    **error)
 {
-  GError *err = NULL;
-  GFile  *directory;
-  GList  *file_list = NULL;
+  GFileEnumerator *enumerator;
+  GCancellable    *cancellable;
+  ThunarFile      *file;
+  GFileInfo       *info;
+  GError          *err = NULL;
+  GFile           *directory;
+  GFile           *child;
+  GList           *infos;
+  GList           *lp;
+  GList           *file_list;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -1248,40 +2984,73 @@ _thunar_io_jobs_ls (ThunarJob  *job,
   /* make sure the object is valid */
   _thunar_assert (G_IS_FILE (directory));
 
-  /* collect directory contents (non-recursively) */
-  file_list = thunar_io_scan_directory (job, directory,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        FALSE, FALSE, TRUE, &err);
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
 
-  /* abort on errors or cancellation */
-  if (err != NULL)
+  /* remember the state of the directory before it is read, so the
+   * folder can tell later whether it changed since (see thunar_folder_refresh()) */
+  info = g_file_query_info (directory, THUNAR_G_FILE_STAMP_ATTRIBUTES,
+                            G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+  if (G_LIKELY (info != NULL))
     {
-      g_propagate_error (error, err);
-      return FALSE;
+      g_object_set_data_full (G_OBJECT (job), I_("thunar-folder-stamp"),
+                              thunar_g_file_info_get_stamp (info), g_free);
+      g_object_unref (info);
     }
-  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+
+  /* tell the folder whether sniffing the content types is expensive */
+  if (thunar_g_file_is_on_slow_filesystem (directory, cancellable))
+    g_object_set_data (G_OBJECT (job), I_("thunar-folder-slow"), GINT_TO_POINTER (TRUE));
+
+  /* try to read from the directory, the attributes that are not needed
+   * to show the files are queried by the folder in the background */
+  enumerator = g_file_enumerate_children (directory, THUNAR_FILE_INFO_NAMESPACE_FAST,
+                                          G_FILE_QUERY_INFO_NONE, cancellable, &err);
+  if (G_UNLIKELY (enumerator == NULL))
     {
+      /* not a directory (anymore), so there is nothing to list */
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_DIRECTORY))
+        {
+          g_error_free (err);
+          return TRUE;
+        }
+
       g_propagate_error (error, err);
       return FALSE;
     }
 
-  /* check if we have any files to report */
-  if (G_LIKELY (file_list != NULL))
+  /* collect directory contents (non-recursively) in batches and hand
+   * every batch over to the consumer as soon as it is read, so slow
+   * mounts can show the first files before the listing is complete */
+  while (!exo_job_is_cancelled (EXO_JOB (job)))
     {
-      /* emit the "files-ready" signal */
-      if (!thunar_job_files_ready (THUNAR_JOB (job), file_list))
+      infos = g_file_enumerator_next_files (enumerator, THUNAR_IO_JOBS_LS_BATCH_SIZE, cancellable, &err);
+      if (infos == NULL)
+        break;
+
+      for (lp = infos, file_list = NULL; lp != NULL; lp = lp->next)
         {
-          /* none of the handlers took over the file list, so it's up to us
-           * to destroy it */
-          thunar_g_list_free_full (file_list);
+          info = G_FILE_INFO (lp->data);
+          child = g_file_get_child (directory, g_file_info_get_name (info));
+          file = thunar_file_get_with_fast_info (child, info);
+          file_list = g_list_prepend (file_list, file);
+          g_object_unref (child);
         }
+      g_list_free_full (infos, g_object_unref);
+
+      /* queue the "files-ready" signal, the job takes over the list */
+      thunar_job_files_ready (THUNAR_JOB (job), file_list);
     }
 
-  /* there should be no errors here */
-  _thunar_assert (err == NULL);
+  /* release the enumerator */
+  g_object_unref (enumerator);
 
-  /* propagate cancellation error */
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+  /* abort on errors or cancellation */
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
     {
       g_propagate_error (error, err);
       return FALSE;
@@ -1295,9 +3064,115 @@ _thunar_io_jobs_ls (ThunarJob  *job,
 ThunarJob *
 thunar_io_jobs_list_directory (GFile *directory)
 {
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+  /* the user waits for the folder to show up */
+  job = thunar_simple_job_new (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_search (ThunarJob  *job,
+                        GArray     *param_values,
+                        GError    **error)
+{
+  ThunarScanRules *rules;
+  ThunarPattern   *pattern;
+  const gchar     *query;
+  gboolean         show_hidden;
+  gboolean         use_index;
+  gboolean         succeed;
+  GFile           *directory;
+  gchar           *glob;
+  guint            n_excluded = 0;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 5, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  query = g_value_get_string (&g_array_index (param_values, GValue, 1));
+  show_hidden = g_value_get_boolean (&g_array_index (param_values, GValue, 2));
+  use_index = g_value_get_boolean (&g_array_index (param_values, GValue, 3));
+  rules = g_value_get_boxed (&g_array_index (param_values, GValue, 4));
+
+  /* a query without wildcards matches anywhere in the name */
+  if (strpbrk (query, "*?") == NULL)
+    glob = g_strdup_printf ("*%s*", query);
+  else
+    glob = g_strdup (query);
+
+  /* compile the pattern once for all names, which are matched ignoring case */
+  pattern = thunar_pattern_new (glob, FALSE);
+  g_free (glob);
+
+  /* the index of a mount answers without walking the tree */
+  if (use_index && thunar_search_index_search (job, directory, pattern, show_hidden, rules, &n_excluded))
+    succeed = !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+  else
+    succeed = thunar_io_scan_directory_search (job, directory, pattern, show_hidden, rules, &n_excluded, error);
+
+  thunar_pattern_free (pattern);
+
+  /* tell the view that the results may be incomplete */
+  if (succeed && n_excluded > 0)
+    exo_job_info_message (EXO_JOB (job), ngettext ("%u folder skipped", "%u folders skipped", n_excluded), n_excluded);
+
+  return succeed;
+}
+
+
+
+/**
+ * thunar_io_jobs_search_directory:
+ * @directory   : the folder to search in.
+ * @query       : the text or glob pattern to search for.
+ * @show_hidden : whether to search hidden files as well.
+ * @use_index   : whether to use the index of the mount of @directory.
+ *
+ * Searches @directory and its subfolders for files whose name contains
+ * @query, ignoring case. If @query contains wildcards, the whole name
+ * has to match it instead. The matches are emitted in batches through
+ * the "files-ready" signal while the search runs.
+ *
+ * The folders excluded by the current #ThunarScanRules are not entered,
+ * their number is reported through the "info-message" signal at the end.
+ *
+ * If @use_index is %TRUE and the mount was indexed already, the index
+ * is searched instead of the tree, see thunar_search_index_search().
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_search_directory (GFile       *directory,
+                                 const gchar *query,
+                                 gboolean     show_hidden,
+                                 gboolean     use_index)
+{
+  ThunarScanRules *rules;
+  ThunarJob       *job;
+
   _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+  _thunar_return_val_if_fail (query != NULL && *query != '\0', NULL);
+
+  rules = thunar_scan_rules_get ();
+  job = thunar_simple_job_new (_thunar_io_jobs_search, 5,
+                               G_TYPE_FILE, directory,
+                               G_TYPE_STRING, query,
+                               G_TYPE_BOOLEAN, show_hidden,
+                               G_TYPE_BOOLEAN, use_index,
+                               THUNAR_TYPE_SCAN_RULES, rules);
+  thunar_scan_rules_unref (rules);
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
 
-  return thunar_simple_job_new (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+  return job;
 }
 
 
@@ -1365,10 +3240,322 @@ ThunarJob *
 thunar_io_jobs_rename_file (ThunarFile  *file,
                             const gchar *display_name)
 {
+  ThunarJob *job;
+
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
   _thunar_return_val_if_fail (g_utf8_validate (display_name, -1, NULL), NULL);
 
-  return thunar_simple_job_new (_thunar_io_jobs_rename, 2,
-                                THUNAR_TYPE_FILE, file,
-                                G_TYPE_STRING, display_name);
+  job = thunar_simple_job_new (_thunar_io_jobs_rename, 2,
+                               THUNAR_TYPE_FILE, file,
+                               G_TYPE_STRING, display_name);
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
+}
+
+
+
+typedef struct
+{
+  ThunarThumbnailer *thumbnailer;
+  gulong             finished_id;
+
+  /* the files of the next request and the pending request */
+  GList             *files;
+  guint              request;
+  gint               pending;
+} ThumbnailsContext;
+
+
+
+static void
+_tij_thumbnails_finished (ThunarThumbnailer *thumbnailer,
+                          guint              request,
+                          ThumbnailsContext *context)
+{
+  if (request == context->request)
+    g_atomic_int_set (&context->pending, 0);
+}
+
+
+
+static gboolean
+_tij_thumbnails_queue (gpointer user_data)
+{
+  ThunarThumbnailSize thumbnail_size;
+  ThumbnailsContext  *context = user_data;
+  gchar              *thumbnail_path;
+  GList              *files = NULL;
+  GList              *lp;
+
+  /* generate the size the views currently use */
+  g_object_get (context->thumbnailer, "thumbnail-size", &thumbnail_size, NULL);
+
+  /* skip the files which have a thumbnail already */
+  for (lp = context->files; lp != NULL; lp = lp->next)
+    {
+      thumbnail_path = thunar_file_dup_thumbnail_path (lp->data, thumbnail_size);
+      if (thumbnail_path == NULL || !thunar_thumbnail_index_contains (thumbnail_path))
+        files = g_list_prepend (files, lp->data);
+      g_free (thumbnail_path);
+    }
+
+  /* the request uses the background scheduler of the thumbnailer */
+  context->request = 0;
+  if (files != NULL
+      && thunar_thumbnailer_prefetch_files (context->thumbnailer, files, &context->request)
+      && context->request != 0)
+    g_atomic_int_set (&context->pending, 1);
+  else
+    g_atomic_int_set (&context->pending, 0);
+
+  g_list_free (files);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+_tij_thumbnails_cleanup (gpointer user_data)
+{
+  ThumbnailsContext *context = user_data;
+
+  g_signal_handler_disconnect (context->thumbnailer, context->finished_id);
+
+  /* drop the request of a cancelled job */
+  if (g_atomic_int_get (&context->pending))
+    thunar_thumbnailer_dequeue (context->thumbnailer, context->request);
+
+  g_object_unref (context->thumbnailer);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+_tij_on_battery (void)
+{
+  GDBusConnection *connection;
+  GVariant        *result;
+  GVariant        *value;
+  gboolean         on_battery = FALSE;
+
+  connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, NULL);
+  if (G_UNLIKELY (connection == NULL))
+    return FALSE;
+
+  /* without UPower the machine is assumed to run on AC power */
+  result = g_dbus_connection_call_sync (connection, "org.freedesktop.UPower", "/org/freedesktop/UPower",
+                                        "org.freedesktop.DBus.Properties", "Get",
+                                        g_variant_new ("(ss)", "org.freedesktop.UPower", "OnBattery"),
+                                        G_VARIANT_TYPE ("(v)"), G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                        1000, NULL, NULL);
+  if (result != NULL)
+    {
+      g_variant_get (result, "(v)", &value);
+      if (g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN))
+        on_battery = g_variant_get_boolean (value);
+      g_variant_unref (value);
+      g_variant_unref (result);
+    }
+
+  g_object_unref (connection);
+
+  return on_battery;
+}
+
+
+
+static void
+_tij_thumbnails_wait_for_power (ThunarJob *job,
+                                gint64    *power_time)
+{
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+  if (now - *power_time < THUNAR_IO_JOBS_POWER_INTERVAL)
+    return;
+
+  /* wait until the machine is connected to AC power again */
+  while (_tij_on_battery () && !exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      exo_job_info_message (EXO_JOB (job), _("Waiting for AC power..."));
+      for (now = 0; now < THUNAR_IO_JOBS_POWER_INTERVAL && !exo_job_is_cancelled (EXO_JOB (job));
+           now += THUNAR_IO_JOBS_PAUSE_INTERVAL)
+        g_usleep (THUNAR_IO_JOBS_PAUSE_INTERVAL);
+    }
+
+  *power_time = g_get_monotonic_time ();
+}
+
+
+
+static gboolean
+_thunar_io_jobs_thumbnails (ThunarJob  *job,
+                            GArray     *param_values,
+                            GError    **error)
+{
+  ThumbnailsContext context;
+  gboolean          recursive;
+  GQueue            directories = G_QUEUE_INIT;
+  GFile            *directory;
+  GList            *files;
+  GList            *lp;
+  GList            *batch;
+  GError           *err = NULL;
+  gchar            *display_name;
+  gint64            power_time = 0;
+  guint             n_toplevel = 0;
+  guint             n_files;
+  guint             n_processed;
+  guint             n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  files = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 1));
+
+  context.thumbnailer = thunar_thumbnailer_get ();
+  context.files = NULL;
+  context.request = 0;
+  context.pending = 0;
+  context.finished_id = g_signal_connect (context.thumbnailer, "request-finished",
+                                          G_CALLBACK (_tij_thumbnails_finished), &context);
+
+  for (lp = files; lp != NULL; lp = lp->next, ++n_toplevel)
+    g_queue_push_tail (&directories, g_object_ref (lp->data));
+
+  while (err == NULL && (directory = g_queue_pop_head (&directories)) != NULL)
+    {
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+        {
+          g_object_unref (directory);
+          break;
+        }
+
+      files = thunar_io_scan_directory (job, directory, G_FILE_QUERY_INFO_NONE,
+                                        FALSE, FALSE, TRUE, &err);
+
+      /* collect the files of the folder and remember the subfolders */
+      batch = NULL;
+      for (lp = files, n_files = 0; lp != NULL; lp = lp->next)
+        {
+          if (thunar_file_is_directory (lp->data))
+            {
+              if (recursive && !thunar_file_is_symlink (lp->data))
+                g_queue_push_tail (&directories, g_object_ref (thunar_file_get_file (lp->data)));
+            }
+          else if (thunar_file_is_regular (lp->data))
+            {
+              batch = g_list_prepend (batch, lp->data);
+              n_files++;
+            }
+        }
+      batch = g_list_reverse (batch);
+
+      display_name = thunar_g_file_get_display_name (directory);
+      exo_job_info_message (EXO_JOB (job), _("Generating thumbnails in %s"), display_name);
+
+      for (lp = batch, n_processed = 0; lp != NULL && err == NULL; )
+        {
+          _tij_check_pause (job);
+          _tij_thumbnails_wait_for_power (job, &power_time);
+          if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+            break;
+
+          /* split off the next request */
+          context.files = lp;
+          for (n = 1; lp->next != NULL && n < THUNAR_IO_JOBS_THUMBNAILS_BATCH_SIZE; ++n)
+            lp = lp->next;
+          if (lp->next != NULL)
+            {
+              lp = lp->next;
+              lp->prev->next = NULL;
+            }
+          else
+            {
+              lp = NULL;
+            }
+
+          exo_job_send_to_mainloop (EXO_JOB (job), _tij_thumbnails_queue, &context, NULL);
+
+          /* do not queue more than one request at a time, so the
+           * thumbnailer stays available for the folders being viewed */
+          while (g_atomic_int_get (&context.pending) && !exo_job_is_cancelled (EXO_JOB (job)))
+            g_usleep (THUNAR_IO_JOBS_PAUSE_INTERVAL / 2);
+
+          /* rejoin the list so it can be freed as a whole */
+          if (lp != NULL)
+            g_list_last (context.files)->next = lp;
+
+          n_processed += n;
+          exo_job_info_message (EXO_JOB (job), _("Generating thumbnails in %s"), display_name);
+          exo_job_percent (EXO_JOB (job), (n_processed * 100.0) / n_files);
+        }
+
+      g_free (display_name);
+      g_list_free (batch);
+      thunar_g_list_free_full (files);
+      g_object_unref (directory);
+
+      /* unreadable subfolders do not stop the job */
+      if (n_toplevel > 0)
+        n_toplevel--;
+      else if (err != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
+        g_clear_error (&err);
+    }
+
+  while ((directory = g_queue_pop_head (&directories)) != NULL)
+    g_object_unref (directory);
+
+  exo_job_send_to_mainloop (EXO_JOB (job), _tij_thumbnails_cleanup, &context, NULL);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_jobs_make_thumbnails:
+ * @folders   : the #GFile<!---->s of the folders.
+ * @recursive : whether to descend into the subfolders as well.
+ *
+ * Generates the missing thumbnails of the files in @folders in the size
+ * the views currently use, so they are shown right away once the folders
+ * are opened. The requests are queued one after another with the
+ * background scheduler of the #ThunarThumbnailer, the folders are read
+ * with idle I/O priority and the job waits while the machine runs on
+ * battery.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_make_thumbnails (GList    *folders,
+                                gboolean  recursive)
+{
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (folders != NULL, NULL);
+
+  job = thunar_simple_job_new (_thunar_io_jobs_thumbnails, 2,
+                               THUNAR_TYPE_G_FILE_LIST, folders,
+                               G_TYPE_BOOLEAN, recursive);
+  thunar_job_set_pausable (job, TRUE);
+
+  /* the thumbnails are only prepared for later, so the job
+   * yields the disk to everything else */
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_BACKGROUND);
+
+  return job;
 }
@@ -27,12 +27,326 @@
 #include <exo/exo.h>
 
 #include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-pattern.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-io-scan-directory.h>
 
 
 
+/* upper limit for the number of threads of a recursive scan */
+#define THUNAR_IO_SCAN_MAX_THREADS (8)
+
+/* interval in which the matches of a search are handed over, in usec */
+#define THUNAR_IO_SCAN_SEARCH_INTERVAL (G_USEC_PER_SEC / 5)
+
+/* the attributes a search needs to walk the tree and match names */
+#define THUNAR_IO_SCAN_SEARCH_NAMESPACE \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+  G_FILE_ATTRIBUTE_ID_FILESYSTEM
+
+
+
+typedef struct _ScanDirectory ScanDirectory;
+typedef struct _ScanChild     ScanChild;
+typedef struct _ScanContext   ScanContext;
+
+struct _ScanDirectory
+{
+  GFile *file;
+  GList *children; /* ScanChild's in reversed enumeration order */
+};
+
+struct _ScanChild
+{
+  gpointer       item;      /* GFile or ThunarFile */
+  ScanDirectory *directory; /* set if the child was scanned too */
+};
+
+struct _ScanContext
+{
+  GThreadPool        *pool;
+  GCancellable       *cancellable;
+  GFileQueryInfoFlags flags;
+  const gchar        *namespace;
+  gboolean            unlinking;
+  gboolean            return_thunar_files;
+
+  /* whether the children are queried in inode order, on rotating disks */
+  gboolean            inode_order;
+
+  /* only used by searches */
+  ThunarPattern      *pattern;
+  gboolean            show_hidden;
+  ThunarScanRules    *rules;
+  gchar              *fs_id; /* set to stay on the filesystem of the folder */
+
+  /* protected by the mutex */
+  GMutex              mutex;
+  GCond               cond;
+  guint               n_pending;
+  GError             *error;
+  GList              *matches;
+  guint               n_excluded;
+};
+
+
+
+static ScanDirectory *
+thunar_io_scan_directory_new (GFile *file)
+{
+  ScanDirectory *directory;
+
+  directory = g_slice_new0 (ScanDirectory);
+  directory->file = g_object_ref (file);
+
+  return directory;
+}
+
+
+
+static void
+thunar_io_scan_directory_free (ScanDirectory *directory)
+{
+  ScanChild *child;
+  GList     *lp;
+
+  for (lp = directory->children; lp != NULL; lp = lp->next)
+    {
+      child = lp->data;
+      if (child->item != NULL)
+        g_object_unref (child->item);
+      if (child->directory != NULL)
+        thunar_io_scan_directory_free (child->directory);
+      g_slice_free (ScanChild, child);
+    }
+
+  g_list_free (directory->children);
+  g_object_unref (directory->file);
+  g_slice_free (ScanDirectory, directory);
+}
+
+
+
+static gboolean
+thunar_io_scan_directory_should_stop (ScanContext *context)
+{
+  gboolean stop;
+
+  if (context->cancellable != NULL && g_cancellable_is_cancelled (context->cancellable))
+    return TRUE;
+
+  g_mutex_lock (&context->mutex);
+  stop = (context->error != NULL);
+  g_mutex_unlock (&context->mutex);
+
+  return stop;
+}
+
+
+
+static void
+thunar_io_scan_directory_worker (gpointer data,
+                                 gpointer user_data)
+{
+  ScanDirectory   *directory = data;
+  ScanContext     *context = user_data;
+  GFileEnumerator *enumerator = NULL;
+  GFileInfo       *info;
+  ScanChild       *child;
+  GError          *err = NULL;
+  GFile           *child_file;
+  GList           *infos = NULL;
+
+  if (thunar_io_scan_directory_should_stop (context))
+    goto done;
+
+  if (context->inode_order)
+    {
+      /* the error of a child stops the scan after the others were read */
+      infos = thunar_io_jobs_util_query_children_by_inode (directory->file, context->namespace,
+                                                           context->flags, context->cancellable, &err);
+      if (G_UNLIKELY (infos == NULL))
+        goto done;
+    }
+  else
+    {
+      enumerator = g_file_enumerate_children (directory->file, context->namespace,
+                                              context->flags, context->cancellable, &err);
+      if (G_UNLIKELY (enumerator == NULL))
+        goto done;
+    }
+
+  while (!thunar_io_scan_directory_should_stop (context))
+    {
+      /* query info of the child */
+      if (enumerator != NULL)
+        {
+          info = g_file_enumerator_next_file (enumerator, context->cancellable, &err);
+        }
+      else if (infos != NULL)
+        {
+          info = infos->data;
+          infos = g_list_delete_link (infos, infos);
+        }
+      else
+        {
+          info = NULL;
+        }
+
+      if (G_UNLIKELY (info == NULL))
+        break;
+
+      child_file = g_file_get_child (directory->file, g_file_info_get_name (info));
+
+      child = g_slice_new0 (ScanChild);
+      if (context->return_thunar_files)
+        child->item = thunar_file_get_with_info (child_file, info, FALSE);
+      else
+        child->item = g_object_ref (child_file);
+
+      /* hand subdirectories over to the pool, but don't recurse into
+       * the trash when unlinking, see thunar_io_scan_directory() */
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY
+          && !(context->unlinking && thunar_g_file_is_trashed (child_file)))
+        {
+          child->directory = thunar_io_scan_directory_new (child_file);
+
+          g_mutex_lock (&context->mutex);
+          context->n_pending++;
+          g_mutex_unlock (&context->mutex);
+
+          g_thread_pool_push (context->pool, child->directory, NULL);
+        }
+
+      directory->children = g_list_prepend (directory->children, child);
+
+      g_object_unref (child_file);
+      g_object_unref (info);
+    }
+
+  /* release the enumerator */
+  if (enumerator != NULL)
+    g_object_unref (enumerator);
+  thunar_g_list_free_full (infos);
+
+done:
+  g_mutex_lock (&context->mutex);
+
+  /* remember the first error, this stops the other workers */
+  if (G_UNLIKELY (err != NULL))
+    {
+      if (context->error == NULL)
+        context->error = err;
+      else
+        g_error_free (err);
+    }
+
+  /* wake up the scan when this was the last directory */
+  if (--context->n_pending == 0)
+    g_cond_signal (&context->cond);
+
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+static GList *
+thunar_io_scan_directory_collect (ScanDirectory *directory)
+{
+  ScanChild *child;
+  GList     *files = NULL;
+  GList     *lp;
+
+  /* build the same list as a depth-first scan would: every directory
+   * is preceded by its children, which is required for unlinking */
+  for (lp = g_list_last (directory->children); lp != NULL; lp = lp->prev)
+    {
+      child = lp->data;
+
+      /* transfer the reference to the list */
+      files = g_list_prepend (files, child->item);
+      child->item = NULL;
+
+      if (child->directory != NULL)
+        files = g_list_concat (thunar_io_scan_directory_collect (child->directory), files);
+    }
+
+  return files;
+}
+
+
+
+static GList *
+thunar_io_scan_directory_parallel (ThunarJob          *job,
+                                   GFile              *file,
+                                   GFileQueryInfoFlags flags,
+                                   gboolean            unlinking,
+                                   gboolean            return_thunar_files,
+                                   const gchar        *namespace,
+                                   GError            **error)
+{
+  ScanDirectory *root;
+  ScanContext    context = { 0, };
+  GList         *files = NULL;
+  GError        *err = NULL;
+  guint          n_threads;
+
+  context.cancellable = (job != NULL) ? exo_job_get_cancellable (EXO_JOB (job)) : NULL;
+  context.flags = flags;
+  context.namespace = namespace;
+  context.unlinking = unlinking;
+  context.return_thunar_files = return_thunar_files;
+  g_mutex_init (&context.mutex);
+  g_cond_init (&context.cond);
+
+  /* on a rotating disk a single thread sweeps over the inodes of every
+   * directory, parallel threads would only seek between them */
+  context.inode_order = thunar_io_jobs_util_is_rotating (file, NULL, context.cancellable);
+
+  /* the scan is mostly waiting for i/o, so use a couple of threads
+   * even on machines with few processors */
+  if (context.inode_order)
+    n_threads = 1;
+  else
+    n_threads = CLAMP (g_get_num_processors (), 2, THUNAR_IO_SCAN_MAX_THREADS);
+  context.pool = g_thread_pool_new (thunar_io_scan_directory_worker, &context,
+                                    n_threads, FALSE, NULL);
+
+  /* start with the top-level directory */
+  root = thunar_io_scan_directory_new (file);
+  context.n_pending = 1;
+  g_thread_pool_push (context.pool, root, NULL);
+
+  /* wait until all directories are scanned */
+  g_mutex_lock (&context.mutex);
+  while (context.n_pending > 0)
+    g_cond_wait (&context.cond, &context.mutex);
+  g_mutex_unlock (&context.mutex);
+
+  g_thread_pool_free (context.pool, FALSE, TRUE);
+
+  if (G_UNLIKELY (context.error != NULL))
+    g_propagate_error (error, context.error);
+  else if (job != NULL && exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+    g_propagate_error (error, err);
+  else
+    files = thunar_io_scan_directory_collect (root);
+
+  thunar_io_scan_directory_free (root);
+  g_mutex_clear (&context.mutex);
+  g_cond_clear (&context.cond);
+
+  return files;
+}
+
+
+
 GList *
 thunar_io_scan_directory (ThunarJob          *job,
                           GFile              *file,
@@ -47,7 +361,6 @@ thunar_io_scan_directory (ThunarJob          *job,
   GFileType        type;
   GError          *err = NULL;
   GFile           *child_file;
-  GList           *child_files = NULL;
   GList           *files = NULL;
   const gchar     *namespace;
   ThunarFile      *thunar_file;
@@ -94,6 +407,13 @@ thunar_io_scan_directory (ThunarJob          *job,
     namespace = G_FILE_ATTRIBUTE_STANDARD_TYPE ","
                 G_FILE_ATTRIBUTE_STANDARD_NAME;
 
+  /* spread recursive scans over a pool of threads */
+  if (recursively)
+    {
+      return thunar_io_scan_directory_parallel (job, file, flags, unlinking,
+                                                return_thunar_files, namespace, error);
+    }
+
   /* try to read from the direectory */
   enumerator = g_file_enumerate_children (file, namespace,
                                           flags, cancellable, &err);
@@ -145,19 +465,6 @@ thunar_io_scan_directory (ThunarJob          *job,
           files = thunar_g_list_prepend_deep (files, child_file);
         }
 
-      /* if the child is a directory and we need to recurse ... just do so */
-      if (recursively
-          && is_mounted
-          && g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
-        {
-          child_files = thunar_io_scan_directory (job, child_file, flags, recursively,
-                                                  unlinking, return_thunar_files, &err);
-
-          /* prepend children to the file list to make sure they're
-           * processed first (required for unlinking) */
-          files = g_list_concat (child_files, files);
-        }
-
       g_object_unref (child_file);
       g_object_unref (info);
     }
@@ -180,3 +487,212 @@ thunar_io_scan_directory (ThunarJob          *job,
 
   return files;
 }
+
+
+
+static void
+thunar_io_scan_directory_search_worker (gpointer data,
+                                        gpointer user_data)
+{
+  GFileEnumerator *enumerator;
+  ScanContext     *context = user_data;
+  ThunarFile      *file;
+  GFileInfo       *info;
+  gboolean         matches;
+  const gchar     *fs_id;
+  GFile           *directory = data;
+  GFile           *child_file;
+  gchar           *casefold;
+
+  if (thunar_io_scan_directory_should_stop (context))
+    goto done;
+
+  /* folders that cannot be read are skipped, like find does */
+  enumerator = g_file_enumerate_children (directory, THUNAR_IO_SCAN_SEARCH_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          context->cancellable, NULL);
+  if (G_UNLIKELY (enumerator == NULL))
+    goto done;
+
+  while (!thunar_io_scan_directory_should_stop (context))
+    {
+      info = g_file_enumerator_next_file (enumerator, context->cancellable, NULL);
+      if (G_UNLIKELY (info == NULL))
+        break;
+
+      /* neither match nor enter hidden files unless they are shown */
+      if (!context->show_hidden
+          && (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info)))
+        {
+          g_object_unref (info);
+          continue;
+        }
+
+      /* match the name the way it is displayed, ignoring case */
+      matches = FALSE;
+      casefold = thunar_pattern_casefold (g_file_info_get_display_name (info));
+      if (G_LIKELY (casefold != NULL))
+        {
+          matches = thunar_pattern_match (context->pattern, casefold);
+          g_free (casefold);
+        }
+
+      child_file = g_file_get_child (directory, g_file_info_get_name (info));
+
+      /* only matches need the full file information */
+      if (matches)
+        {
+          file = thunar_file_get (child_file, NULL);
+          if (G_LIKELY (file != NULL))
+            {
+              g_mutex_lock (&context->mutex);
+              context->matches = g_list_prepend (context->matches, file);
+              g_mutex_unlock (&context->mutex);
+            }
+        }
+
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        {
+          /* excluded folders and other filesystems may match, but are not entered */
+          fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+          if (thunar_scan_rules_excludes (context->rules, g_file_info_get_name (info))
+              || (context->fs_id != NULL && g_strcmp0 (fs_id != NULL ? fs_id : "", context->fs_id) != 0))
+            {
+              g_mutex_lock (&context->mutex);
+              context->n_excluded++;
+              g_mutex_unlock (&context->mutex);
+            }
+          else
+            {
+              g_mutex_lock (&context->mutex);
+              context->n_pending++;
+              g_mutex_unlock (&context->mutex);
+
+              g_thread_pool_push (context->pool, g_object_ref (child_file), NULL);
+            }
+        }
+
+      g_object_unref (child_file);
+      g_object_unref (info);
+    }
+
+  g_object_unref (enumerator);
+
+done:
+  g_object_unref (directory);
+
+  g_mutex_lock (&context->mutex);
+  if (--context->n_pending == 0)
+    g_cond_signal (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+/**
+ * thunar_io_scan_directory_search:
+ * @job         : the #ThunarJob of the search.
+ * @file        : the folder to search in.
+ * @pattern     : the case insensitive pattern to match the display names with.
+ * @show_hidden : whether to search hidden files and folders as well.
+ * @rules       : the #ThunarScanRules of the folders not to enter.
+ * @n_excluded  : return location for the number of folders not entered.
+ * @error       : return location for errors or %NULL.
+ *
+ * Searches @file and all its subfolders for files whose name matches
+ * @pattern, using the thread pool of the recursive scan. The pool gets
+ * as many threads as thunar_io_jobs_util_get_max_threads() allows for
+ * the filesystem of @file, so network shares are not hammered.
+ *
+ * While the search runs, the matches are handed over in batches through
+ * the "files-ready" signal of @job. Symbolic links are not followed and
+ * folders that cannot be read are skipped. So are the folders excluded
+ * by @rules, and the other filesystems if @rules say so; they are
+ * counted in @n_excluded.
+ *
+ * Return value: %FALSE if the search was cancelled.
+ **/
+gboolean
+thunar_io_scan_directory_search (ThunarJob       *job,
+                                 GFile           *file,
+                                 ThunarPattern   *pattern,
+                                 gboolean         show_hidden,
+                                 ThunarScanRules *rules,
+                                 guint           *n_excluded,
+                                 GError         **error)
+{
+  ScanContext context = { 0, };
+  GFileInfo  *info;
+  GList      *matches;
+  gint64      end_time;
+  guint       n_threads;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (pattern != NULL, FALSE);
+  _thunar_return_val_if_fail (rules != NULL, FALSE);
+  _thunar_return_val_if_fail (n_excluded != NULL, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  *n_excluded = 0;
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  context.cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  context.pattern = pattern;
+  context.show_hidden = show_hidden;
+  context.rules = rules;
+  if (thunar_scan_rules_get_same_filesystem (rules))
+    {
+      info = g_file_query_info (file, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, context.cancellable, NULL);
+      if (G_LIKELY (info != NULL))
+        {
+          context.fs_id = g_strdup (g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM));
+          g_object_unref (info);
+        }
+    }
+  g_mutex_init (&context.mutex);
+  g_cond_init (&context.cond);
+
+  n_threads = thunar_io_jobs_util_get_max_threads (file, NULL, THUNAR_IO_SCAN_MAX_THREADS, context.cancellable);
+  context.pool = g_thread_pool_new (thunar_io_scan_directory_search_worker, &context,
+                                    n_threads, FALSE, NULL);
+
+  context.n_pending = 1;
+  g_thread_pool_push (context.pool, g_object_ref (file), NULL);
+
+  /* hand the matches over until all folders are searched */
+  g_mutex_lock (&context.mutex);
+  while (context.n_pending > 0 || context.matches != NULL)
+    {
+      if (context.matches != NULL)
+        {
+          matches = g_list_reverse (context.matches);
+          context.matches = NULL;
+          g_mutex_unlock (&context.mutex);
+
+          if (exo_job_is_cancelled (EXO_JOB (job)))
+            thunar_g_list_free_full (matches);
+          else
+            thunar_job_files_ready (job, matches);
+
+          g_mutex_lock (&context.mutex);
+          continue;
+        }
+
+      end_time = g_get_monotonic_time () + THUNAR_IO_SCAN_SEARCH_INTERVAL;
+      g_cond_wait_until (&context.cond, &context.mutex, end_time);
+    }
+  g_mutex_unlock (&context.mutex);
+
+  g_thread_pool_free (context.pool, FALSE, TRUE);
+  g_mutex_clear (&context.mutex);
+  g_cond_clear (&context.cond);
+  g_free (context.fs_id);
+
+  *n_excluded = context.n_excluded;
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+}
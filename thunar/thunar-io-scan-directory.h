@@ -24,7 +24,9 @@
 #include <exo/exo.h>
 
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-pattern.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-scan-rules.h>
 
 G_BEGIN_DECLS
 
@@ -36,6 +38,14 @@ GList *thunar_io_scan_directory (ThunarJob          *job,
                                  gboolean            return_thunar_files,
                                  GError            **error);
 
+gboolean thunar_io_scan_directory_search (ThunarJob       *job,
+                                          GFile           *file,
+                                          ThunarPattern   *pattern,
+                                          gboolean         show_hidden,
+                                          ThunarScanRules *rules,
+                                          guint           *n_excluded,
+                                          GError         **error);
+
 G_END_DECLS
 
 #endif /* !__THUNAR_IO_SCAN_DIRECTORY_H__ */
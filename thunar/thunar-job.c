@@ -25,16 +25,50 @@
 #ifdef HAVE_MEMORY_H
 #include <memory.h>
 #endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_SCHED_H
+#include <sched.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <exo/exo.h>
 
 #include <thunar/thunar-enum-types.h>
+#include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-recorder.h>
+
+
+
+#define THUNAR_JOB_N_PRIORITIES (THUNAR_JOB_PRIORITY_BACKGROUND + 1)
+
+/* interval in which waiting jobs check whether they were cancelled */
+#define THUNAR_JOB_WAIT_INTERVAL (200 * 1000) /* 200 ms */
+
+/* background jobs lower the I/O priority of their thread on Linux */
+#if defined (SYS_ioprio_get) && defined (SYS_ioprio_set)
+#define THUNAR_JOB_IOPRIO
+#define THUNAR_JOB_IOPRIO_WHO_PROCESS (1)
+#define THUNAR_JOB_IOPRIO_CLASS_IDLE  (3)
+#define THUNAR_JOB_IOPRIO_CLASS_SHIFT (13)
+#endif
+
+/* and run it with the batch scheduling policy */
+#if defined (HAVE_PTHREAD_H) && defined (SCHED_BATCH)
+#define THUNAR_JOB_SCHED_BATCH
+#endif
 
 
 
@@ -53,12 +87,20 @@ enum
 
 
 static void              thunar_job_finalize            (GObject            *object);
+static void              thunar_job_finished            (ThunarJob          *job);
+static void              thunar_job_error               (ThunarJob          *job,
+                                                         const GError       *error);
+static void              thunar_job_message_free        (gpointer            data);
+static void              thunar_job_drain               (ThunarJob          *job);
 static ThunarJobResponse thunar_job_real_ask            (ThunarJob          *job,
                                                          const gchar        *message,
                                                          ThunarJobResponse   choices);
 static ThunarJobResponse thunar_job_real_ask_replace    (ThunarJob          *job,
                                                          ThunarFile         *source_file,
                                                          ThunarFile         *target_file);
+static gboolean          thunar_job_file_unchanged      (ThunarJob          *job,
+                                                         GFile              *source_path,
+                                                         GFile              *target_path);
 
 
 
@@ -70,15 +112,61 @@ struct _ThunarJobPrivate
   ThunarJobResponse earlier_ask_skip_response;
   GList            *total_files;
   guint             n_total_files;
+
+  /* the priority class, and the one the job runs in */
+  ThunarJobPriority priority;
+  ThunarJobPriority running_priority;
+  gboolean          running;
+#ifdef THUNAR_JOB_IOPRIO
+  gint              saved_ioprio;
+#endif
+#ifdef THUNAR_JOB_SCHED_BATCH
+  gint              saved_policy;
+  struct sched_param saved_param;
+#endif
+
+  gint              n_processed; /* atomic, the job runs in its own thread */
   gboolean          pausable;
   gboolean          paused; /* the job has been manually paused using the UI */
   gboolean          frozen; /* the job has been automaticaly paused regarding some parallel copy behavior */
+
+  /* messages posted by the job thread, drained in the main loop */
+  GAsyncQueue      *messages;
+  gint              drain_scheduled; /* atomic */
+
+  /* latest progress, coalesced until the next drain */
+  GMutex            progress_mutex;
+  gchar            *progress_message;
+  gdouble           progress_percent;
+  gboolean          progress_pending;
 };
 
 
 
+typedef struct
+{
+  ThunarJobPostFunc func;
+  gpointer          data;
+  GDestroyNotify    notify;
+} ThunarJobMessage;
+
+
+
 static guint job_signals[LAST_SIGNAL];
 
+/* the number of jobs of each priority class which may run at the same
+ * time, the others wait in thunar_job_enter() until a slot is free */
+static const guint job_priority_limits[THUNAR_JOB_N_PRIORITIES] =
+{
+  G_MAXUINT, /* THUNAR_JOB_PRIORITY_INTERACTIVE */
+  8,         /* THUNAR_JOB_PRIORITY_NORMAL */
+  2,         /* THUNAR_JOB_PRIORITY_BACKGROUND */
+};
+
+static GMutex job_priority_mutex;
+static GCond  job_priority_cond;
+static guint  job_priority_running[THUNAR_JOB_N_PRIORITIES];
+
 
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (ThunarJob, thunar_job, EXO_TYPE_JOB)
@@ -243,9 +331,21 @@ thunar_job_init (ThunarJob *job)
   job->priv->earlier_ask_delete_response = 0;
   job->priv->earlier_ask_skip_response = 0;
   job->priv->n_total_files = 0;
+  job->priv->priority = THUNAR_JOB_PRIORITY_NORMAL;
+  job->priv->running = FALSE;
   job->priv->pausable = FALSE;
   job->priv->paused = FALSE;
   job->priv->frozen = FALSE;
+  job->priv->messages = g_async_queue_new_full (thunar_job_message_free);
+  job->priv->drain_scheduled = 0;
+  g_mutex_init (&job->priv->progress_mutex);
+  job->priv->progress_message = NULL;
+  job->priv->progress_pending = FALSE;
+
+  /* connected before any other handler, so everything posted by
+   * the job is delivered before the "finished" and "error" handlers run */
+  g_signal_connect (job, "error", G_CALLBACK (thunar_job_error), NULL);
+  g_signal_connect (job, "finished", G_CALLBACK (thunar_job_finished), NULL);
 }
 
 
@@ -253,11 +353,147 @@ thunar_job_init (ThunarJob *job)
 static void
 thunar_job_finalize (GObject *object)
 {
+  ThunarJob *job = THUNAR_JOB (object);
+
+  /* drop undelivered messages */
+  g_async_queue_unref (job->priv->messages);
+  g_mutex_clear (&job->priv->progress_mutex);
+  g_free (job->priv->progress_message);
+
   (*G_OBJECT_CLASS (thunar_job_parent_class)->finalize) (object);
 }
 
 
 
+static void
+thunar_job_finished (ThunarJob *job)
+{
+  thunar_job_drain (job);
+}
+
+
+
+static void
+thunar_job_error (ThunarJob    *job,
+                  const GError *error)
+{
+  thunar_job_drain (job);
+}
+
+
+
+static void
+thunar_job_message_free (gpointer data)
+{
+  ThunarJobMessage *message = data;
+
+  if (message->notify != NULL)
+    (*message->notify) (message->data);
+  g_slice_free (ThunarJobMessage, message);
+}
+
+
+
+static void
+thunar_job_drain (ThunarJob *job)
+{
+  ThunarJobMessage *message;
+  gchar            *progress_message;
+  gdouble           progress_percent;
+  gboolean          progress_pending;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  /* reset first: a message pushed while draining schedules a new drain */
+  g_atomic_int_set (&job->priv->drain_scheduled, 0);
+
+  while ((message = g_async_queue_try_pop (job->priv->messages)) != NULL)
+    {
+      (*message->func) (job, message->data);
+      thunar_job_message_free (message);
+    }
+
+  /* publish the latest progress only */
+  g_mutex_lock (&job->priv->progress_mutex);
+  progress_pending = job->priv->progress_pending;
+  progress_message = job->priv->progress_message;
+  progress_percent = job->priv->progress_percent;
+  job->priv->progress_pending = FALSE;
+  job->priv->progress_message = NULL;
+  g_mutex_unlock (&job->priv->progress_mutex);
+
+  if (progress_pending)
+    {
+      if (progress_message != NULL)
+        g_signal_emit_by_name (job, "info-message", progress_message);
+      if (progress_percent >= 0.0)
+        g_signal_emit_by_name (job, "percent", progress_percent);
+      g_free (progress_message);
+    }
+}
+
+
+
+static gboolean
+thunar_job_drain_idle (gpointer user_data)
+{
+  thunar_job_drain (THUNAR_JOB (user_data));
+  return FALSE;
+}
+
+
+
+static void
+thunar_job_schedule_drain (ThunarJob *job)
+{
+  /* one drain per main loop iteration handles everything queued so far */
+  if (g_atomic_int_compare_and_exchange (&job->priv->drain_scheduled, 0, 1))
+    {
+      g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, thunar_job_drain_idle,
+                       g_object_ref (job), g_object_unref);
+    }
+}
+
+
+
+/**
+ * thunar_job_post:
+ * @job    : a #ThunarJob.
+ * @func   : the function to call in the main loop.
+ * @data   : user data for @func.
+ * @notify : destroy notify for @data, or %NULL.
+ *
+ * Queues @func to be called from the main loop without waiting
+ * for it, unlike exo_job_emit(), so the job thread does not stall
+ * on a busy UI. Posted functions run in order and are all
+ * delivered before the "error" and "finished" handlers of @job.
+ * If @job is destroyed first, @func is not called but @notify is.
+ *
+ * Use exo_job_emit() instead for anything the job has to wait for,
+ * such as questions to the user.
+ **/
+void
+thunar_job_post (ThunarJob        *job,
+                 ThunarJobPostFunc func,
+                 gpointer          data,
+                 GDestroyNotify    notify)
+{
+  ThunarJobMessage *message;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (func != NULL);
+
+  message = g_slice_new (ThunarJobMessage);
+  message->func = func;
+  message->data = data;
+  message->notify = notify;
+  g_async_queue_push (job->priv->messages, message);
+
+  thunar_job_schedule_drain (job);
+}
+
+
+
 static ThunarJobResponse
 thunar_job_real_ask (ThunarJob        *job,
                      const gchar      *message,
@@ -291,6 +527,7 @@ thunar_job_real_ask_replace (ThunarJob  *job,
   g_signal_emit (job, job_signals[ASK], 0, message,
                  THUNAR_JOB_RESPONSE_REPLACE
                  | THUNAR_JOB_RESPONSE_REPLACE_ALL
+                 | THUNAR_JOB_RESPONSE_UPDATE_ALL
                  | THUNAR_JOB_RESPONSE_RENAME
                  | THUNAR_JOB_RESPONSE_RENAME_ALL
                  | THUNAR_JOB_RESPONSE_SKIP
@@ -526,6 +763,14 @@ thunar_job_ask_replace (ThunarJob *job,
   if (G_UNLIKELY (job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_SKIP_ALL))
     return THUNAR_JOB_RESPONSE_SKIP;
 
+  /* check if the user said "Update All" earlier */
+  if (G_UNLIKELY (job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_UPDATE_ALL))
+    {
+      if (thunar_job_file_unchanged (job, source_path, target_path))
+        return THUNAR_JOB_RESPONSE_SKIP;
+      return THUNAR_JOB_RESPONSE_REPLACE;
+    }
+
   source_file = thunar_file_get (source_path, error);
 
   if (G_UNLIKELY (source_file == NULL))
@@ -555,6 +800,9 @@ thunar_job_ask_replace (ThunarJob *job,
     response = THUNAR_JOB_RESPONSE_RENAME;
   else if (response == THUNAR_JOB_RESPONSE_SKIP_ALL)
     response = THUNAR_JOB_RESPONSE_SKIP;
+  else if (response == THUNAR_JOB_RESPONSE_UPDATE_ALL)
+    response = thunar_job_file_unchanged (job, source_path, target_path)
+               ? THUNAR_JOB_RESPONSE_SKIP : THUNAR_JOB_RESPONSE_REPLACE;
   else if (response == THUNAR_JOB_RESPONSE_CANCEL)
     exo_job_cancel (EXO_JOB (job));
 
@@ -563,6 +811,146 @@ thunar_job_ask_replace (ThunarJob *job,
 
 
 
+/**
+ * thunar_job_file_unchanged:
+ * @job         : a #ThunarJob.
+ * @source_path : the file to transfer.
+ * @target_path : the existing file at the target.
+ *
+ * Compares the size and modification time of the two files, without
+ * reading their data. Copies keep the modification time of the source,
+ * so equal files were most likely copied by an earlier transfer. The
+ * times may differ by up to two seconds, which is the resolution of
+ * FAT filesystems on removable drives.
+ *
+ * Return value: %TRUE if @target_path does not need to be replaced.
+ **/
+static gboolean
+thunar_job_file_unchanged (ThunarJob *job,
+                           GFile     *source_path,
+                           GFile     *target_path)
+{
+  GFileInfo *source_info;
+  GFileInfo *target_info = NULL;
+  gboolean   unchanged = FALSE;
+  guint64    source_time;
+  guint64    target_time;
+
+  source_info = g_file_query_info (source_path,
+                                   G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                   G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                   G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)),
+                                   NULL);
+  if (source_info != NULL)
+    {
+      target_info = g_file_query_info (target_path,
+                                       G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                       G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                       G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                       exo_job_get_cancellable (EXO_JOB (job)),
+                                       NULL);
+    }
+
+  if (source_info != NULL && target_info != NULL
+      && g_file_info_get_file_type (source_info) == g_file_info_get_file_type (target_info)
+      && g_file_info_get_size (source_info) == g_file_info_get_size (target_info)
+      && g_file_info_has_attribute (source_info, G_FILE_ATTRIBUTE_TIME_MODIFIED)
+      && g_file_info_has_attribute (target_info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    {
+      source_time = g_file_info_get_attribute_uint64 (source_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      target_time = g_file_info_get_attribute_uint64 (target_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      unchanged = (MAX (source_time, target_time) - MIN (source_time, target_time) <= 2);
+    }
+
+  if (source_info != NULL)
+    g_object_unref (source_info);
+  if (target_info != NULL)
+    g_object_unref (target_info);
+
+  return unchanged;
+}
+
+
+
+/**
+ * thunar_job_set_replace_response:
+ * @job      : a #ThunarJob.
+ * @response : %THUNAR_JOB_RESPONSE_REPLACE_ALL, %THUNAR_JOB_RESPONSE_SKIP_ALL,
+ *             %THUNAR_JOB_RESPONSE_RENAME_ALL or %THUNAR_JOB_RESPONSE_UPDATE_ALL.
+ *
+ * Decides up front how existing target files are treated, as if the user
+ * picked @response in the first replace dialog of the @job. Must be called
+ * before the @job is launched.
+ **/
+void
+thunar_job_set_replace_response (ThunarJob         *job,
+                                 ThunarJobResponse  response)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  job->priv->earlier_ask_overwrite_response = response;
+}
+
+
+
+/**
+ * thunar_job_ask_replace_many:
+ * @job    : a #ThunarJob.
+ * @format : a printf-style format for the message.
+ * @...    : the arguments for @format.
+ *
+ * Asks once how to handle a known number of existing target files. When
+ * the user picks one of the "All" choices, the answer is remembered and
+ * later calls to thunar_job_ask_replace() don't show a dialog anymore.
+ * %THUNAR_JOB_RESPONSE_NO means the user wants to decide for each file.
+ *
+ * Return value: the #ThunarJobResponse of the user.
+ **/
+ThunarJobResponse
+thunar_job_ask_replace_many (ThunarJob   *job,
+                             const gchar *format,
+                             ...)
+{
+  ThunarJobResponse response;
+  va_list           var_args;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), THUNAR_JOB_RESPONSE_CANCEL);
+  _thunar_return_val_if_fail (format != NULL, THUNAR_JOB_RESPONSE_CANCEL);
+
+  if (G_UNLIKELY (exo_job_is_cancelled (EXO_JOB (job))))
+    return THUNAR_JOB_RESPONSE_CANCEL;
+
+  /* nothing to ask if the user already decided for all files */
+  if (job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_REPLACE_ALL
+      || job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_RENAME_ALL
+      || job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_SKIP_ALL
+      || job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_UPDATE_ALL)
+    return job->priv->earlier_ask_overwrite_response;
+
+  va_start (var_args, format);
+  response = _thunar_job_ask_valist (job, format, var_args,
+                                     _("Do you want to replace, update, rename or skip all of them? "
+                                       "Choose \"No\" to decide for each file."),
+                                     THUNAR_JOB_RESPONSE_REPLACE_ALL
+                                     | THUNAR_JOB_RESPONSE_UPDATE_ALL
+                                     | THUNAR_JOB_RESPONSE_RENAME_ALL
+                                     | THUNAR_JOB_RESPONSE_SKIP_ALL
+                                     | THUNAR_JOB_RESPONSE_NO
+                                     | THUNAR_JOB_RESPONSE_CANCEL);
+  va_end (var_args);
+
+  /* remember the choice for thunar_job_ask_replace() */
+  if (response != THUNAR_JOB_RESPONSE_NO && response != THUNAR_JOB_RESPONSE_CANCEL)
+    job->priv->earlier_ask_overwrite_response = response;
+
+  return response;
+}
+
+
+
 ThunarJobResponse
 thunar_job_ask_skip (ThunarJob   *job,
                      const gchar *format,
@@ -616,6 +1004,42 @@ thunar_job_ask_skip (ThunarJob   *job,
 
 
 
+ThunarJobResponse
+thunar_job_ask_resume (ThunarJob   *job,
+                       const gchar *format,
+                       ...)
+{
+  ThunarJobResponse response;
+  va_list           var_args;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), THUNAR_JOB_RESPONSE_CANCEL);
+  _thunar_return_val_if_fail (format != NULL, THUNAR_JOB_RESPONSE_CANCEL);
+
+  /* check if the user already cancelled the job */
+  if (G_UNLIKELY (exo_job_is_cancelled (EXO_JOB (job))))
+    return THUNAR_JOB_RESPONSE_CANCEL;
+
+  /* the answers for existing files apply to partial files too */
+  if (G_UNLIKELY (job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_REPLACE_ALL))
+    return THUNAR_JOB_RESPONSE_REPLACE;
+  if (G_UNLIKELY (job->priv->earlier_ask_overwrite_response == THUNAR_JOB_RESPONSE_SKIP_ALL))
+    return THUNAR_JOB_RESPONSE_SKIP;
+
+  /* ask the user what he wants to do */
+  va_start (var_args, format);
+  response = _thunar_job_ask_valist (job, format, var_args,
+                                     _("Do you want to resume the transfer?"),
+                                     THUNAR_JOB_RESPONSE_RESUME
+                                     | THUNAR_JOB_RESPONSE_REPLACE
+                                     | THUNAR_JOB_RESPONSE_SKIP
+                                     | THUNAR_JOB_RESPONSE_CANCEL);
+  va_end (var_args);
+
+  return response;
+}
+
+
+
 gboolean
 thunar_job_ask_no_size (ThunarJob   *job,
                         const gchar *format,
@@ -644,16 +1068,61 @@ thunar_job_ask_no_size (ThunarJob   *job,
 
 
 
-gboolean
+static void
+thunar_job_files_ready_post (ThunarJob *job,
+                             gpointer   data)
+{
+  GList    **file_list = data;
+  gboolean   handled = FALSE;
+
+  g_signal_emit (job, job_signals[FILES_READY], 0, *file_list, &handled);
+
+  /* a handler took over the list, so it must not be freed */
+  if (G_LIKELY (handled))
+    *file_list = NULL;
+}
+
+
+
+static void
+thunar_job_files_ready_free (gpointer data)
+{
+  GList **file_list = data;
+
+  thunar_g_list_free_full (*file_list);
+  g_slice_free (GList *, file_list);
+}
+
+
+
+/**
+ * thunar_job_files_ready:
+ * @job       : a #ThunarJob.
+ * @file_list : (transfer full): a list of #ThunarFile<!---->s.
+ *
+ * Queues the "files-ready" signal for @file_list. The job takes
+ * over @file_list and frees it unless a handler takes it over.
+ **/
+void
 thunar_job_files_ready (ThunarJob *job,
                         GList     *file_list)
 {
-  gboolean handled = FALSE;
+  GList **data;
 
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
 
-  exo_job_emit (EXO_JOB (job), job_signals[FILES_READY], 0, file_list, &handled);
-  return handled;
+  data = g_slice_new (GList *);
+  *data = file_list;
+  thunar_job_post (job, thunar_job_files_ready_post, data, thunar_job_files_ready_free);
+}
+
+
+
+static void
+thunar_job_new_files_post (ThunarJob *job,
+                           gpointer   data)
+{
+  g_signal_emit (job, job_signals[NEW_FILES], 0, data);
 }
 
 
@@ -680,8 +1149,10 @@ thunar_job_new_files (ThunarJob   *job,
             }
         }
 
-      /* emit the "new-files" signal */
-      exo_job_emit (EXO_JOB (job), job_signals[NEW_FILES], 0, file_list);
+      /* queue the "new-files" signal with a copy of the list */
+      thunar_job_post (job, thunar_job_new_files_post,
+                       thunar_g_list_copy_deep ((GList *) file_list),
+                       (GDestroyNotify) thunar_g_list_free_full);
     }
 }
 
@@ -701,6 +1172,148 @@ thunar_job_set_total_files (ThunarJob *job,
 
 
 
+/**
+ * thunar_job_set_priority:
+ * @job      : a #ThunarJob.
+ * @priority : the #ThunarJobPriority of the @job.
+ *
+ * Sets the class in which the @job competes with other jobs for the
+ * disk, which is %THUNAR_JOB_PRIORITY_NORMAL by default. Must be called
+ * before the @job is launched.
+ **/
+void
+thunar_job_set_priority (ThunarJob         *job,
+                         ThunarJobPriority  priority)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (priority < THUNAR_JOB_N_PRIORITIES);
+  job->priv->priority = priority;
+}
+
+
+
+ThunarJobPriority
+thunar_job_get_priority (ThunarJob *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), THUNAR_JOB_PRIORITY_NORMAL);
+  return job->priv->priority;
+}
+
+
+
+/**
+ * thunar_job_enter:
+ * @job : a #ThunarJob.
+ *
+ * Called by the execute function of the @job in its thread before it
+ * does any I/O. Waits until fewer jobs of the priority class of the
+ * @job are running than allowed. Background jobs also wait for all
+ * interactive jobs to finish, and then run with the idle I/O priority
+ * and the batch scheduling policy until thunar_job_leave().
+ *
+ * Return value: %FALSE if the @job was cancelled while waiting, in
+ *               which case thunar_job_leave() must not be called.
+ **/
+gboolean
+thunar_job_enter (ThunarJob *job)
+{
+  ThunarJobPriority priority;
+  gint64            start_time = 0;
+#ifdef THUNAR_JOB_SCHED_BATCH
+  struct sched_param param = { 0, };
+#endif
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (!job->priv->running, FALSE);
+
+  priority = job->priv->priority;
+  if (THUNAR_RECORDER_ENABLED ())
+    start_time = g_get_monotonic_time ();
+
+  g_mutex_lock (&job_priority_mutex);
+  while (job_priority_running[priority] >= job_priority_limits[priority]
+         || (priority == THUNAR_JOB_PRIORITY_BACKGROUND
+             && job_priority_running[THUNAR_JOB_PRIORITY_INTERACTIVE] > 0))
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          g_mutex_unlock (&job_priority_mutex);
+          return FALSE;
+        }
+
+      g_cond_wait_until (&job_priority_cond, &job_priority_mutex,
+                         g_get_monotonic_time () + THUNAR_JOB_WAIT_INTERVAL);
+    }
+  job_priority_running[priority]++;
+  g_mutex_unlock (&job_priority_mutex);
+
+  if (THUNAR_RECORDER_ENABLED ())
+    thunar_recorder_job (G_OBJECT_TYPE_NAME (job), priority, g_get_monotonic_time () - start_time);
+
+  job->priv->running_priority = priority;
+  job->priv->running = TRUE;
+
+  if (priority == THUNAR_JOB_PRIORITY_BACKGROUND)
+    {
+      /* the thread is shared with other jobs, so the previous
+       * priorities are restored in thunar_job_leave() */
+#ifdef THUNAR_JOB_IOPRIO
+      job->priv->saved_ioprio = syscall (SYS_ioprio_get, THUNAR_JOB_IOPRIO_WHO_PROCESS, 0);
+      syscall (SYS_ioprio_set, THUNAR_JOB_IOPRIO_WHO_PROCESS, 0,
+               THUNAR_JOB_IOPRIO_CLASS_IDLE << THUNAR_JOB_IOPRIO_CLASS_SHIFT);
+#endif
+#ifdef THUNAR_JOB_SCHED_BATCH
+      /* unlike the nice level, the policy can be reset without privileges */
+      if (pthread_getschedparam (pthread_self (), &job->priv->saved_policy, &job->priv->saved_param) != 0)
+        job->priv->saved_policy = -1;
+      else if (job->priv->saved_policy == SCHED_OTHER)
+        pthread_setschedparam (pthread_self (), SCHED_BATCH, &param);
+#endif
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_job_leave:
+ * @job : a #ThunarJob.
+ *
+ * Releases the slot taken by thunar_job_enter() and restores the
+ * priorities of the thread, from the same thread.
+ **/
+void
+thunar_job_leave (ThunarJob *job)
+{
+  ThunarJobPriority priority;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (job->priv->running);
+
+  priority = job->priv->running_priority;
+  job->priv->running = FALSE;
+
+  if (priority == THUNAR_JOB_PRIORITY_BACKGROUND)
+    {
+#ifdef THUNAR_JOB_IOPRIO
+      if (job->priv->saved_ioprio >= 0)
+        syscall (SYS_ioprio_set, THUNAR_JOB_IOPRIO_WHO_PROCESS, 0, job->priv->saved_ioprio);
+#endif
+#ifdef THUNAR_JOB_SCHED_BATCH
+      if (job->priv->saved_policy == SCHED_OTHER)
+        pthread_setschedparam (pthread_self (), SCHED_OTHER, &job->priv->saved_param);
+#endif
+    }
+
+  g_mutex_lock (&job_priority_mutex);
+  job_priority_running[priority]--;
+  g_cond_broadcast (&job_priority_cond);
+  g_mutex_unlock (&job_priority_mutex);
+}
+
+
+
 void
 thunar_job_set_pausable (ThunarJob *job,
                          gboolean   pausable)
@@ -787,6 +1400,8 @@ thunar_job_processing_file (ThunarJob *job,
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (current_file != NULL);
 
+  g_atomic_int_set (&job->priv->n_processed, n_processed);
+
   /* emit only if n_processed is a multiple of 8 */
   if ((n_processed % 8) != 0)
     return;
@@ -795,10 +1410,54 @@ thunar_job_processing_file (ThunarJob *job,
   display_name = g_filename_display_name (base_name);
   g_free (base_name);
 
-  exo_job_info_message (EXO_JOB (job), "%s", display_name);
-  g_free (display_name);
+  /* replace the pending progress, only the latest is shown */
+  g_mutex_lock (&job->priv->progress_mutex);
+  g_free (job->priv->progress_message);
+  job->priv->progress_message = display_name;
 
   /* verify that we have total files set */
   if (G_LIKELY (job->priv->n_total_files > 0))
-    exo_job_percent (EXO_JOB (job), (n_processed * 100.0) / job->priv->n_total_files);
+    job->priv->progress_percent = (n_processed * 100.0) / job->priv->n_total_files;
+  else
+    job->priv->progress_percent = -1.0;
+  job->priv->progress_pending = TRUE;
+  g_mutex_unlock (&job->priv->progress_mutex);
+
+  thunar_job_schedule_drain (job);
+}
+
+
+
+/**
+ * thunar_job_get_n_processed:
+ * @job : a #ThunarJob.
+ *
+ * Returns the number of files @job reported with
+ * thunar_job_processing_file() so far. This may be called
+ * from any thread.
+ *
+ * Return value: the number of processed files.
+ **/
+guint
+thunar_job_get_n_processed (ThunarJob *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), 0);
+  return g_atomic_int_get (&job->priv->n_processed);
+}
+
+
+
+/**
+ * thunar_job_get_n_total_files:
+ * @job : a #ThunarJob.
+ *
+ * Returns the number of files set with thunar_job_set_total_files().
+ *
+ * Return value: the total number of files or 0 if unknown.
+ **/
+guint
+thunar_job_get_n_total_files (ThunarJob *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), 0);
+  return job->priv->n_total_files;
 }
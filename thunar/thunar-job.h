@@ -35,6 +35,24 @@ typedef struct _ThunarJobPrivate ThunarJobPrivate;
 typedef struct _ThunarJobClass   ThunarJobClass;
 typedef struct _ThunarJob        ThunarJob;
 
+typedef void (*ThunarJobPostFunc) (ThunarJob *job,
+                                   gpointer   data);
+
+/**
+ * ThunarJobPriority:
+ * @THUNAR_JOB_PRIORITY_INTERACTIVE : jobs the user waits for, like folder listings.
+ * @THUNAR_JOB_PRIORITY_NORMAL      : file operations like transfers, the default.
+ * @THUNAR_JOB_PRIORITY_BACKGROUND  : scans nobody waits for, which yield the disk.
+ *
+ * The priority classes in which jobs compete for the disk.
+ **/
+typedef enum
+{
+  THUNAR_JOB_PRIORITY_INTERACTIVE,
+  THUNAR_JOB_PRIORITY_NORMAL,
+  THUNAR_JOB_PRIORITY_BACKGROUND,
+} ThunarJobPriority;
+
 #define THUNAR_TYPE_JOB            (thunar_job_get_type ())
 #define THUNAR_JOB(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_JOB, ThunarJob))
 #define THUNAR_JOB_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_JOB, ThunarJobClass))
@@ -68,6 +86,11 @@ struct _ThunarJob
 GType             thunar_job_get_type               (void) G_GNUC_CONST;
 void              thunar_job_set_total_files        (ThunarJob       *job,
                                                      GList           *total_files);
+void              thunar_job_set_priority           (ThunarJob       *job,
+                                                     ThunarJobPriority priority);
+ThunarJobPriority thunar_job_get_priority           (ThunarJob       *job);
+gboolean          thunar_job_enter                  (ThunarJob       *job);
+void              thunar_job_leave                  (ThunarJob       *job);
 void              thunar_job_set_pausable           (ThunarJob       *job,
                                                      gboolean         pausable);
 gboolean          thunar_job_is_pausable            (ThunarJob       *job);
@@ -80,6 +103,8 @@ gboolean          thunar_job_is_frozen              (ThunarJob       *job);
 void              thunar_job_processing_file        (ThunarJob       *job,
                                                      GList           *current_file,
                                                      guint            n_processed);
+guint             thunar_job_get_n_processed        (ThunarJob       *job);
+guint             thunar_job_get_n_total_files      (ThunarJob       *job);
 
 ThunarJobResponse thunar_job_ask_create             (ThunarJob       *job,
                                                      const gchar     *format,
@@ -94,13 +119,25 @@ ThunarJobResponse thunar_job_ask_replace            (ThunarJob       *job,
                                                      GFile           *source_path,
                                                      GFile           *target_path,
                                                      GError         **error);
+void              thunar_job_set_replace_response   (ThunarJob       *job,
+                                                     ThunarJobResponse response);
+ThunarJobResponse thunar_job_ask_replace_many       (ThunarJob       *job,
+                                                     const gchar     *format,
+                                                     ...);
 ThunarJobResponse thunar_job_ask_skip               (ThunarJob       *job,
                                                      const gchar     *format,
                                                      ...);
+ThunarJobResponse thunar_job_ask_resume             (ThunarJob       *job,
+                                                     const gchar     *format,
+                                                     ...);
 gboolean          thunar_job_ask_no_size            (ThunarJob       *job,
                                                      const gchar     *format,
                                                      ...);
-gboolean          thunar_job_files_ready            (ThunarJob       *job,
+void              thunar_job_post                   (ThunarJob       *job,
+                                                     ThunarJobPostFunc func,
+                                                     gpointer         data,
+                                                     GDestroyNotify   notify);
+void              thunar_job_files_ready            (ThunarJob       *job,
                                                      GList           *file_list);
 void              thunar_job_new_files              (ThunarJob       *job,
                                                      const GList     *file_list);
@@ -85,6 +85,16 @@
 
 
 typedef struct _ThunarLauncherPokeData ThunarLauncherPokeData;
+typedef struct _ThunarLauncherMenuRequest ThunarLauncherMenuRequest;
+typedef struct _ThunarLauncherSpawn ThunarLauncherSpawn;
+
+
+
+/* the number of processes spawned at once for applications that open one file per process */
+#define THUNAR_LAUNCHER_SPAWN_BATCH_SIZE (8)
+
+/* the interval in milliseconds between those batches */
+#define THUNAR_LAUNCHER_SPAWN_INTERVAL (200)
 
 
 
@@ -128,6 +138,7 @@ static void                    thunar_launcher_set_current_directory      (Thuna
                                                                            ThunarFile                     *current_directory);
 static void                    thunar_launcher_set_selected_files         (ThunarComponent                *component,
                                                                            GList                          *selected_files);
+static void                    thunar_launcher_update_selection_state     (ThunarLauncher                 *launcher);
 static void                    thunar_launcher_execute_files              (ThunarLauncher                 *launcher,
                                                                            GList                          *files);
 static void                    thunar_launcher_open_file                  (ThunarLauncher                 *launcher,
@@ -139,6 +150,12 @@ static void                    thunar_launcher_open_files                 (Thuna
 static void                    thunar_launcher_open_paths                 (GAppInfo                       *app_info,
                                                                            GList                          *file_list,
                                                                            ThunarLauncher                 *launcher);
+static void                    thunar_launcher_open_paths_failed          (ThunarLauncher                 *launcher,
+                                                                           const GError                   *error,
+                                                                           GFile                          *path,
+                                                                           guint                           n_paths);
+static gboolean                thunar_launcher_spawn_timer                (gpointer                        user_data);
+static void                    thunar_launcher_spawn_free                 (gpointer                        user_data);
 static void                    thunar_launcher_open_windows               (ThunarLauncher                 *launcher,
                                                                            GList                          *directories);
 static void                    thunar_launcher_poke                       (ThunarLauncher                 *launcher,
@@ -189,6 +206,8 @@ static void                    thunar_launcher_action_cut                 (Thuna
 static void                    thunar_launcher_action_copy                (ThunarLauncher                 *launcher);
 static void                    thunar_launcher_action_paste               (ThunarLauncher                 *launcher);
 static void                    thunar_launcher_action_paste_into_folder   (ThunarLauncher                 *launcher);
+static void                    thunar_launcher_action_make_thumbnails     (ThunarLauncher                 *launcher);
+static void                    thunar_launcher_action_make_thumbnails_recursive (ThunarLauncher           *launcher);
 static void                    thunar_launcher_sendto_device              (ThunarLauncher                 *launcher,
                                                                            ThunarDevice                   *device);
 static void                    thunar_launcher_sendto_mount_finish        (ThunarDevice                   *device,
@@ -203,6 +222,11 @@ static void                    thunar_launcher_action_create_document     (Thuna
 static GtkWidget              *thunar_launcher_create_document_submenu_new(ThunarLauncher                 *launcher);
 static void                    thunar_launcher_new_files_created          (ThunarLauncher                 *launcher,
                                                                            GList                          *new_thunar_files);
+static void                    thunar_launcher_menu_request_cancel        (ThunarLauncherMenuRequest      *request);
+static gboolean                thunar_launcher_menu_request_timeout       (gpointer                        user_data);
+static void                    thunar_launcher_menu_request_ready         (GObject                        *object,
+                                                                           GAsyncResult                   *result,
+                                                                           gpointer                        user_data);
 
 
 
@@ -232,6 +256,9 @@ struct _ThunarLauncher
   ThunarFile             *single_folder;
   ThunarFile             *parent_folder;
 
+  /* whether the fields above match the files_to_process */
+  gboolean                selection_state_valid;
+
   /* closure invoked whenever launcher creates new files (create, paste, rename, etc) */
   GClosure               *new_files_created_closure;
 
@@ -257,6 +284,37 @@ struct _ThunarLauncherPokeData
   ThunarLauncherFolderOpenAction  folder_open_action;
 };
 
+/* files opened with an application that takes one file per process */
+struct _ThunarLauncherSpawn
+{
+  ThunarLauncher    *launcher;
+  GAppInfo          *app_info;
+  GAppLaunchContext *context;
+  gboolean           notified; /* whether the startup notification was sent */
+  GFile             *working_directory;
+  GList             *path_list;
+
+  /* the first failure and the number of failed files */
+  GError            *error;
+  GFile             *failed_path;
+  guint              n_failed;
+};
+
+/* menu items of a provider which are added to an open menu once known */
+struct _ThunarLauncherMenuRequest
+{
+  ThunarxMenuProvider *provider;
+  GCancellable        *cancellable;
+  gint64               start_time;
+  guint                timeout_id;
+
+  /* hidden separator before which the items are inserted,
+   * shown if the menu did not get any other custom actions */
+  GtkWidget           *anchor;
+  gulong               anchor_destroy_id;
+  gboolean             show_anchor;
+};
+
 static GParamSpec *launcher_props[N_PROPERTIES] = { NULL, };
 
 static XfceGtkActionEntry thunar_launcher_action_entries[] =
@@ -296,6 +354,9 @@ static XfceGtkActionEntry thunar_launcher_action_entries[] =
     { THUNAR_LAUNCHER_ACTION_MOUNT,            NULL,                                               "",                  XFCE_GTK_MENU_ITEM,       N_ ("_Mount"),                          N_ ("Mount the selected device"),                                                                NULL,                   G_CALLBACK (thunar_launcher_action_open),                },
     { THUNAR_LAUNCHER_ACTION_UNMOUNT,          NULL,                                               "",                  XFCE_GTK_MENU_ITEM,       N_ ("_Unmount"),                        N_ ("Unmount the selected device"),                                                              NULL,                   G_CALLBACK (thunar_launcher_action_unmount),             },
     { THUNAR_LAUNCHER_ACTION_EJECT,            NULL,                                               "",                  XFCE_GTK_MENU_ITEM,       N_ ("_Eject"),                          N_ ("Eject the selected device"),                                                                NULL,                   G_CALLBACK (thunar_launcher_action_eject),               },
+
+    { THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS,  "<Actions>/ThunarLauncher/make-thumbnails",         "",                  XFCE_GTK_IMAGE_MENU_ITEM, N_ ("Generate _Thumbnails"),            N_ ("Generate the thumbnails of the files in the selected folder in the background"),            "image-x-generic",      G_CALLBACK (thunar_launcher_action_make_thumbnails),     },
+    { THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS_RECURSIVE, "<Actions>/ThunarLauncher/make-thumbnails-recursive", "",   XFCE_GTK_MENU_ITEM,       N_ ("Generate Thumbnails Including Su_bfolders"), N_ ("Generate the thumbnails of the files in the selected folder and all its subfolders in the background"), NULL, G_CALLBACK (thunar_launcher_action_make_thumbnails_recursive), },
 };
 
 #define get_action_entry(id) xfce_gtk_get_action_entry_by_id(thunar_launcher_action_entries,G_N_ELEMENTS(thunar_launcher_action_entries),id)
@@ -612,7 +673,6 @@ thunar_launcher_set_selected_files (ThunarComponent *component,
                                     GList           *selected_files)
 {
   ThunarLauncher *launcher = THUNAR_LAUNCHER (component);
-  GList          *lp;
 
   /* That happens at startup for some reason */
   if (launcher->current_directory == NULL)
@@ -631,9 +691,32 @@ thunar_launcher_set_selected_files (ThunarComponent *component,
     g_object_unref (launcher->parent_folder);
   launcher->parent_folder = NULL;
 
-  launcher->files_are_selected = TRUE;
-  if (selected_files == NULL || g_list_length (selected_files) == 0)
-    launcher->files_are_selected = FALSE;
+  launcher->files_are_selected = (selected_files != NULL);
+
+  /* if nothing is selected, the current directory is the folder to use for all menus */
+  if (launcher->files_are_selected)
+    launcher->files_to_process = thunar_g_list_copy_deep (selected_files);
+  else
+    launcher->files_to_process = g_list_append (launcher->files_to_process, g_object_ref (launcher->current_directory));
+
+  /* the selection changes all the time while the user is selecting, the
+   * file types and the parent folder are only looked at when needed */
+  launcher->selection_state_valid = FALSE;
+}
+
+
+
+/* determines the state derived from the files to process, it only has
+ * to be called by functions that use one of the fields it sets */
+static void
+thunar_launcher_update_selection_state (ThunarLauncher *launcher)
+{
+  GList *lp;
+
+  if (G_LIKELY (launcher->selection_state_valid))
+    return;
+
+  launcher->selection_state_valid = TRUE;
 
   launcher->files_to_process_trashable = TRUE;
   launcher->n_files_to_process         = 0;
@@ -643,12 +726,6 @@ thunar_launcher_set_selected_files (ThunarComponent *component,
   launcher->single_directory_to_process = FALSE;
   launcher->single_folder = NULL;
 
-  /* if nothing is selected, the current directory is the folder to use for all menus */
-  if (launcher->files_are_selected)
-    launcher->files_to_process = thunar_g_list_copy_deep (selected_files);
-  else
-    launcher->files_to_process = g_list_append (launcher->files_to_process, g_object_ref (launcher->current_directory));
-
   /* determine the number of files/directories/executables */
   for (lp = launcher->files_to_process; lp != NULL; lp = lp->next, ++launcher->n_files_to_process)
     {
@@ -677,7 +754,7 @@ thunar_launcher_set_selected_files (ThunarComponent *component,
       launcher->single_folder = THUNAR_FILE (launcher->files_to_process->data);
     }
 
-  if (launcher->files_to_process != NULL)
+  if (launcher->parent_folder == NULL && launcher->files_to_process != NULL)
     {
       /* just grab the folder of the first selected item */
       launcher->parent_folder = thunar_file_get_parent (THUNAR_FILE (launcher->files_to_process->data), NULL);
@@ -814,6 +891,7 @@ thunar_launcher_open_files (ThunarLauncher *launcher,
 {
   GHashTable *applications;
   GAppInfo   *app_info;
+  gpointer    key;
   GList      *file_list;
   GList      *lp;
 
@@ -847,16 +925,17 @@ thunar_launcher_open_files (ThunarLauncher *launcher,
       /* check if we have an application here */
       if (G_LIKELY (app_info != NULL))
         {
-          /* check if we have that application already */
-          file_list = g_hash_table_lookup (applications, app_info);
-          if (G_LIKELY (file_list != NULL))
+          /* check if we have that application already, then take over its list */
+          file_list = NULL;
+          if (g_hash_table_lookup_extended (applications, app_info, &key, (gpointer *) &file_list))
             {
-              /* take a copy of the list as the old one will be dropped by the insert */
-              file_list = thunar_g_list_copy_deep (file_list);
+              g_hash_table_steal (applications, key);
+              g_object_unref (app_info);
+              app_info = key;
             }
 
-          /* append our new URI to the list */
-          file_list = thunar_g_list_append_deep (file_list, thunar_file_get_file (lp->data));
+          /* prepend our new URI to the list, it is reversed when launched */
+          file_list = thunar_g_list_prepend_deep (file_list, thunar_file_get_file (lp->data));
 
           /* (re)insert the URI list for the application */
           g_hash_table_insert (applications, app_info, file_list);
@@ -884,12 +963,11 @@ thunar_launcher_open_paths (GAppInfo       *app_info,
                             ThunarLauncher *launcher)
 {
   GdkAppLaunchContext *context;
+  ThunarLauncherSpawn *spawn;
   GdkScreen           *screen;
   GError              *error = NULL;
   GFile               *working_directory = NULL;
-  gchar               *message;
-  gchar               *name;
-  guint                n;
+  GList               *paths;
 
   /* determine the screen on which to launch the application */
   screen = gtk_widget_get_screen (launcher->widget);
@@ -904,32 +982,147 @@ thunar_launcher_open_paths (GAppInfo       *app_info,
   if (launcher->current_directory != NULL)
     working_directory = thunar_file_get_file (launcher->current_directory);
 
-  /* try to execute the application with the given URIs */
-  if (!thunar_g_app_info_launch (app_info, working_directory, path_list, G_APP_LAUNCH_CONTEXT (context), &error))
+  /* the paths were collected in reverse order */
+  paths = g_list_reverse (thunar_g_list_copy_deep (path_list));
+
+  if (paths->next == NULL || thunar_g_app_info_takes_multiple_files (app_info))
     {
-      /* figure out the appropriate error message */
-      n = g_list_length (path_list);
-      if (G_LIKELY (n == 1))
+      /* try to execute the application with the given URIs at once */
+      if (!thunar_g_app_info_launch (app_info, working_directory, paths, G_APP_LAUNCH_CONTEXT (context), &error))
         {
-          /* we can give a precise error message here */
-          name = g_filename_display_name (g_file_get_basename (path_list->data));
-          message = g_strdup_printf (_("Failed to open file \"%s\""), name);
-          g_free (name);
+          thunar_launcher_open_paths_failed (launcher, error, paths->data, g_list_length (paths));
+          g_error_free (error);
         }
-      else
+
+      thunar_g_list_free_full (paths);
+      g_object_unref (context);
+      return;
+    }
+
+  /* GIO would spawn one process per file right away, so spawn them
+   * in batches from the main loop, with a single startup notification */
+  spawn = g_slice_new0 (ThunarLauncherSpawn);
+  spawn->launcher = g_object_ref (launcher);
+  spawn->app_info = g_object_ref (app_info);
+  spawn->context = G_APP_LAUNCH_CONTEXT (context);
+  spawn->path_list = paths;
+  if (working_directory != NULL)
+    spawn->working_directory = g_object_ref (working_directory);
+
+  if (thunar_launcher_spawn_timer (spawn))
+    {
+      g_timeout_add_full (G_PRIORITY_DEFAULT, THUNAR_LAUNCHER_SPAWN_INTERVAL,
+                          thunar_launcher_spawn_timer, spawn,
+                          thunar_launcher_spawn_free);
+    }
+  else
+    {
+      thunar_launcher_spawn_free (spawn);
+    }
+}
+
+
+
+static void
+thunar_launcher_open_paths_failed (ThunarLauncher *launcher,
+                                   const GError   *error,
+                                   GFile          *path,
+                                   guint           n_paths)
+{
+  gchar *basename;
+  gchar *message;
+  gchar *name;
+
+  /* figure out the appropriate error message */
+  if (G_LIKELY (n_paths == 1))
+    {
+      /* we can give a precise error message here */
+      basename = g_file_get_basename (path);
+      name = g_filename_display_name (basename);
+      message = g_strdup_printf (_("Failed to open file \"%s\""), name);
+      g_free (basename);
+      g_free (name);
+    }
+  else
+    {
+      /* we can just tell that n files failed to open */
+      message = g_strdup_printf (ngettext ("Failed to open %d file", "Failed to open %d files", n_paths), n_paths);
+    }
+
+  /* display an error dialog to the user */
+  thunar_dialogs_show_error (launcher->widget, error, "%s", message);
+  g_free (message);
+}
+
+
+
+static gboolean
+thunar_launcher_spawn_timer (gpointer user_data)
+{
+  ThunarLauncherSpawn *spawn = user_data;
+  GError              *error = NULL;
+  GList               *lp;
+  guint                n;
+
+  for (n = 0; n < THUNAR_LAUNCHER_SPAWN_BATCH_SIZE && spawn->path_list != NULL; ++n)
+    {
+      lp = spawn->path_list;
+      spawn->path_list = g_list_remove_link (spawn->path_list, lp);
+
+      if (!thunar_g_app_info_launch (spawn->app_info, spawn->working_directory, lp, spawn->context, &error))
         {
-          /* we can just tell that n files failed to open */
-          message = g_strdup_printf (ngettext ("Failed to open %d file", "Failed to open %d files", n), n);
+          /* only the first error is shown, once all files were tried */
+          if (spawn->error == NULL)
+            {
+              spawn->error = error;
+              spawn->failed_path = g_object_ref (lp->data);
+            }
+          else
+            {
+              g_error_free (error);
+            }
+          error = NULL;
+          spawn->n_failed++;
         }
 
-      /* display an error dialog to the user */
-      thunar_dialogs_show_error (launcher->widget, error, "%s", message);
-      g_error_free (error);
-      g_free (message);
+      thunar_g_list_free_full (lp);
+
+      /* only the first process gets a startup notification */
+      if (!spawn->notified)
+        {
+          g_object_unref (spawn->context);
+          spawn->context = g_app_launch_context_new ();
+          spawn->notified = TRUE;
+        }
     }
 
-  /* destroy the launch context */
-  g_object_unref (context);
+  if (spawn->path_list != NULL)
+    return TRUE;
+
+  if (spawn->n_failed > 0)
+    thunar_launcher_open_paths_failed (spawn->launcher, spawn->error, spawn->failed_path, spawn->n_failed);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_launcher_spawn_free (gpointer user_data)
+{
+  ThunarLauncherSpawn *spawn = user_data;
+
+  if (spawn->working_directory != NULL)
+    g_object_unref (spawn->working_directory);
+  if (spawn->failed_path != NULL)
+    g_object_unref (spawn->failed_path);
+  if (spawn->error != NULL)
+    g_error_free (spawn->error);
+  thunar_g_list_free_full (spawn->path_list);
+  g_object_unref (spawn->context);
+  g_object_unref (spawn->app_info);
+  g_object_unref (spawn->launcher);
+  g_slice_free (ThunarLauncherSpawn, spawn);
 }
 
 
@@ -1378,6 +1571,8 @@ thunar_launcher_action_open_with_other (ThunarLauncher *launcher)
 {
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (launcher->n_files_to_process == 1)
     thunar_show_chooser_dialog (launcher->widget, launcher->files_to_process->data, TRUE, FALSE);
 }
@@ -1395,6 +1590,8 @@ thunar_launcher_action_set_default_app (ThunarLauncher *launcher)
 {
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (launcher->n_files_to_process == 1)
     thunar_show_chooser_dialog (launcher->widget, launcher->files_to_process->data, TRUE, TRUE);
 }
@@ -1425,6 +1622,8 @@ void thunar_launcher_append_accelerators (ThunarLauncher *launcher,
 static gboolean
 thunar_launcher_show_trash (ThunarLauncher *launcher)
 {
+  thunar_launcher_update_selection_state (launcher);
+
   if (launcher->parent_folder == NULL)
     return FALSE;
 
@@ -1464,10 +1663,13 @@ thunar_launcher_append_menu_item (ThunarLauncher       *launcher,
   ThunarFile               *parent;
   gint                      n;
   const gchar              *eject_label;
+  ThunarThumbnailMode       thumbnail_mode;
 
   _thunar_return_val_if_fail (THUNAR_IS_LAUNCHER (launcher), NULL);
   _thunar_return_val_if_fail (action_entry != NULL, NULL);
 
+  thunar_launcher_update_selection_state (launcher);
+
   /* This may occur when the thunar-window is build */
   if (G_UNLIKELY (launcher->files_to_process == NULL) && launcher->device_to_process == NULL)
     return NULL;
@@ -1725,6 +1927,16 @@ thunar_launcher_append_menu_item (ThunarLauncher       *launcher,
           }
         return item;
 
+      case THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS:
+      case THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS_RECURSIVE:
+        if (!launcher->single_directory_to_process || thunar_file_is_trashed (launcher->single_folder))
+          return NULL;
+        g_object_get (G_OBJECT (launcher->preferences), "misc-thumbnail-mode", &thumbnail_mode, NULL);
+        if (thumbnail_mode == THUNAR_THUMBNAIL_MODE_NEVER
+            || (thumbnail_mode == THUNAR_THUMBNAIL_MODE_ONLY_LOCAL && !thunar_file_is_local (launcher->single_folder)))
+          return NULL;
+        return xfce_gtk_menu_item_new_from_action_entry (action_entry, G_OBJECT (launcher), GTK_MENU_SHELL (menu));
+
       case THUNAR_LAUNCHER_ACTION_MOUNT:
         if (launcher->device_to_process == NULL || thunar_device_is_mounted (launcher->device_to_process) == TRUE)
           return NULL;
@@ -1928,6 +2140,8 @@ thunar_launcher_build_sendto_submenu (ThunarLauncher *launcher)
 
   _thunar_return_val_if_fail (THUNAR_IS_LAUNCHER (launcher), NULL);
 
+  thunar_launcher_update_selection_state (launcher);
+
   submenu = gtk_menu_new();
 
   /* show "sent to shortcut" if only directories are selected */
@@ -2140,6 +2354,95 @@ thunar_launcher_action_duplicate (ThunarLauncher *launcher)
 
 
 
+static void
+thunar_launcher_menu_request_cancel (ThunarLauncherMenuRequest *request)
+{
+  /* the menu is gone, the ready callback frees the request */
+  g_cancellable_cancel (request->cancellable);
+}
+
+
+
+static gboolean
+thunar_launcher_menu_request_timeout (gpointer user_data)
+{
+  ThunarLauncherMenuRequest *request = user_data;
+
+  g_debug ("Dropping the menu items of %s, it did not answer within %" G_GINT64_FORMAT " ms",
+           G_OBJECT_TYPE_NAME (request->provider),
+           (g_get_monotonic_time () - request->start_time) / 1000);
+
+  request->timeout_id = 0;
+  g_cancellable_cancel (request->cancellable);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_launcher_menu_request_ready (GObject      *object,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  ThunarLauncherMenuRequest *request = user_data;
+  GtkWidget                 *gtk_menu_item;
+  GtkWidget                 *menu;
+  GList                     *thunarx_menu_items;
+  GList                     *children;
+  GList                     *lp;
+  gint                       position;
+
+  thunarx_menu_items = thunarx_menu_provider_get_file_menu_items_finish (request->provider, result, NULL);
+
+  if (request->timeout_id != 0)
+    g_source_remove (request->timeout_id);
+
+  if (request->anchor != NULL)
+    {
+      g_signal_handler_disconnect (request->anchor, request->anchor_destroy_id);
+      g_object_remove_weak_pointer (G_OBJECT (request->anchor), (gpointer) &request->anchor);
+    }
+
+  /* drop results of cancelled requests, the menu may be gone */
+  if (request->anchor != NULL && !g_cancellable_is_cancelled (request->cancellable) && thunarx_menu_items != NULL)
+    {
+      menu = gtk_widget_get_parent (request->anchor);
+      children = gtk_container_get_children (GTK_CONTAINER (menu));
+      position = g_list_index (children, request->anchor);
+      g_list_free (children);
+
+      for (lp = thunarx_menu_items; lp != NULL; lp = lp->next)
+        {
+          gtk_menu_item = thunar_gtk_menu_thunarx_menu_item_new (lp->data, NULL);
+          if (G_UNLIKELY (gtk_menu_item == NULL))
+            {
+              g_object_unref (lp->data);
+              continue;
+            }
+
+          /* Each thunarx_menu_item will be destroyed together with its related gtk_menu_item*/
+          g_signal_connect_swapped (G_OBJECT (gtk_menu_item), "destroy", G_CALLBACK (g_object_unref), lp->data);
+          gtk_menu_shell_insert (GTK_MENU_SHELL (menu), gtk_menu_item, position++);
+          gtk_widget_show_all (gtk_menu_item);
+        }
+      g_list_free (thunarx_menu_items);
+
+      if (request->show_anchor)
+        gtk_widget_show (request->anchor);
+    }
+  else
+    {
+      g_list_free_full (thunarx_menu_items, g_object_unref);
+    }
+
+  g_object_unref (request->cancellable);
+  g_object_unref (request->provider);
+  g_slice_free (ThunarLauncherMenuRequest, request);
+}
+
+
+
 /**
  * thunar_launcher_append_custom_actions:
  * @launcher : a #ThunarLauncher instance
@@ -2147,20 +2450,30 @@ thunar_launcher_action_duplicate (ThunarLauncher *launcher)
  *
  * Will append all custom actions which match the file-type to the provided #GtkMenuShell
  *
+ * Menu providers implementing the asynchronous interface do not delay the menu,
+ * their items are inserted once known, unless this takes longer than
+ * the "misc-menu-provider-budget".
+ *
  * Return value: TRUE if any custom action was added
  **/
 gboolean
 thunar_launcher_append_custom_actions (ThunarLauncher *launcher,
                                        GtkMenuShell   *menu)
 {
-  gboolean                uca_added = FALSE;
-  GtkWidget              *window;
-  GtkWidget              *gtk_menu_item;
-  ThunarxProviderFactory *provider_factory;
-  GList                  *providers;
-  GList                  *thunarx_menu_items = NULL;
-  GList                  *lp_provider;
-  GList                  *lp_item;
+  gboolean                   uca_added = FALSE;
+  GtkWidget                 *window;
+  GtkWidget                 *gtk_menu_item;
+  ThunarxProviderFactory    *provider_factory;
+  GList                     *providers;
+  GList                     *thunarx_menu_items = NULL;
+  GList                     *lp_provider;
+  GList                     *lp_item;
+  GList                     *requests = NULL;
+  GtkWidget                 *anchor;
+  ThunarLauncherMenuRequest *request;
+  ThunarxMenuProviderIface  *iface;
+  guint                      budget;
+  gint64                     start_time;
 
   _thunar_return_val_if_fail (THUNAR_IS_LAUNCHER (launcher), FALSE);
   _thunar_return_val_if_fail (GTK_IS_MENU (menu), FALSE);
@@ -2180,14 +2493,34 @@ thunar_launcher_append_custom_actions (ThunarLauncher *launcher,
   if (G_UNLIKELY (launcher->files_to_process == NULL))
     return FALSE;
 
+  g_object_get (G_OBJECT (launcher->preferences), "misc-menu-provider-budget", &budget, NULL);
+
   /* load the menu items offered by the menu providers */
   for (lp_provider = providers; lp_provider != NULL; lp_provider = lp_provider->next)
     {
+      /* don't wait for providers which can answer later */
+      iface = THUNARX_MENU_PROVIDER_GET_IFACE (lp_provider->data);
+      if (launcher->files_are_selected && iface->get_file_menu_items_async != NULL && iface->get_file_menu_items_finish != NULL)
+        {
+          request = g_slice_new0 (ThunarLauncherMenuRequest);
+          request->provider = g_object_ref (lp_provider->data);
+          request->cancellable = g_cancellable_new ();
+          requests = g_list_prepend (requests, request);
+          continue;
+        }
+
+      start_time = g_get_monotonic_time ();
+
       if (launcher->files_are_selected == FALSE)
         thunarx_menu_items = thunarx_menu_provider_get_folder_menu_items (lp_provider->data, window, THUNARX_FILE_INFO (launcher->current_directory));
       else
         thunarx_menu_items = thunarx_menu_provider_get_file_menu_items (lp_provider->data, window, launcher->files_to_process);
 
+      if (G_UNLIKELY (budget > 0 && g_get_monotonic_time () - start_time > (gint64) budget * 1000))
+        g_debug ("%s took %" G_GINT64_FORMAT " ms to provide its menu items",
+                 G_OBJECT_TYPE_NAME (lp_provider->data),
+                 (g_get_monotonic_time () - start_time) / 1000);
+
       for (lp_item = thunarx_menu_items; lp_item != NULL; lp_item = lp_item->next)
         {
           gtk_menu_item = thunar_gtk_menu_thunarx_menu_item_new (lp_item->data, menu);
@@ -2199,6 +2532,33 @@ thunar_launcher_append_custom_actions (ThunarLauncher *launcher,
       g_list_free (thunarx_menu_items);
     }
   g_list_free_full (providers, g_object_unref);
+
+  if (requests != NULL)
+    {
+      /* the late items are inserted before this separator */
+      anchor = gtk_separator_menu_item_new ();
+      gtk_widget_set_no_show_all (anchor, TRUE);
+      gtk_menu_shell_append (menu, anchor);
+
+      requests = g_list_reverse (requests);
+      for (lp_item = requests; lp_item != NULL; lp_item = lp_item->next)
+        {
+          request = lp_item->data;
+          request->start_time = g_get_monotonic_time ();
+          request->show_anchor = !uca_added;
+          request->anchor = anchor;
+          g_object_add_weak_pointer (G_OBJECT (anchor), (gpointer) &request->anchor);
+          request->anchor_destroy_id = g_signal_connect_swapped (G_OBJECT (anchor), "destroy",
+                                                                 G_CALLBACK (thunar_launcher_menu_request_cancel), request);
+          if (budget > 0)
+            request->timeout_id = g_timeout_add (budget, thunar_launcher_menu_request_timeout, request);
+
+          thunarx_menu_provider_get_file_menu_items_async (request->provider, window, launcher->files_to_process,
+                                                           request->cancellable, thunar_launcher_menu_request_ready, request);
+        }
+      g_list_free (requests);
+    }
+
   return uca_added;
 }
 
@@ -2358,6 +2718,8 @@ thunar_launcher_action_move_to_trash (ThunarLauncher *launcher)
 
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (launcher->parent_folder == NULL || launcher->files_are_selected == FALSE)
     return;
 
@@ -2375,6 +2737,8 @@ thunar_launcher_action_delete (ThunarLauncher *launcher)
 
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (launcher->parent_folder == NULL || launcher->files_are_selected == FALSE)
     return;
 
@@ -2403,6 +2767,48 @@ thunar_launcher_action_trash_delete (ThunarLauncher *launcher)
 
 
 
+static void
+thunar_launcher_make_thumbnails (ThunarLauncher *launcher,
+                                 gboolean        recursive)
+{
+  ThunarApplication *application;
+  GList              folder_list;
+
+  _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
+
+  thunar_launcher_update_selection_state (launcher);
+
+  if (G_UNLIKELY (!launcher->single_directory_to_process))
+    return;
+
+  /* fake a file list */
+  folder_list.data = thunar_file_get_file (launcher->single_folder);
+  folder_list.next = NULL;
+  folder_list.prev = NULL;
+
+  application = thunar_application_get ();
+  thunar_application_make_thumbnails (application, launcher->widget, &folder_list, recursive);
+  g_object_unref (G_OBJECT (application));
+}
+
+
+
+static void
+thunar_launcher_action_make_thumbnails (ThunarLauncher *launcher)
+{
+  thunar_launcher_make_thumbnails (launcher, FALSE);
+}
+
+
+
+static void
+thunar_launcher_action_make_thumbnails_recursive (ThunarLauncher *launcher)
+{
+  thunar_launcher_make_thumbnails (launcher, TRUE);
+}
+
+
+
 void
 thunar_launcher_action_empty_trash (ThunarLauncher *launcher)
 {
@@ -2426,6 +2832,8 @@ thunar_launcher_action_create_folder (ThunarLauncher *launcher)
 
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (thunar_file_is_trashed (launcher->current_directory))
     return;
 
@@ -2470,6 +2878,8 @@ thunar_launcher_action_create_document (ThunarLauncher *launcher,
 
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (thunar_file_is_trashed (launcher->current_directory))
     return;
 
@@ -2726,6 +3136,8 @@ thunar_launcher_action_cut (ThunarLauncher *launcher)
 
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (launcher->files_are_selected == FALSE || launcher->parent_folder == NULL)
     return;
 
@@ -2774,6 +3186,8 @@ thunar_launcher_action_paste_into_folder (ThunarLauncher *launcher)
 
   _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
 
+  thunar_launcher_update_selection_state (launcher);
+
   if (!launcher->single_directory_to_process)
     return;
 
@@ -2929,6 +3343,8 @@ thunar_launcher_build_application_submenu (ThunarLauncher *launcher,
 
   _thunar_return_val_if_fail (THUNAR_IS_LAUNCHER (launcher), NULL);
 
+  thunar_launcher_update_selection_state (launcher);
+
   submenu =  gtk_menu_new();
   /* add open with subitem per application */
   for (lp = applications; lp != NULL; lp = lp->next)
@@ -2985,6 +3401,8 @@ thunar_launcher_append_open_section (ThunarLauncher *launcher,
 
   _thunar_return_val_if_fail (THUNAR_IS_LAUNCHER (launcher), FALSE);
 
+  thunar_launcher_update_selection_state (launcher);
+
   /* Usually it is not required to open the current directory */
   if (launcher->files_are_selected == FALSE && !force)
     return FALSE;
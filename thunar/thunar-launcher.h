@@ -66,6 +66,8 @@ typedef enum
   THUNAR_LAUNCHER_ACTION_MOUNT,
   THUNAR_LAUNCHER_ACTION_UNMOUNT,
   THUNAR_LAUNCHER_ACTION_EJECT,
+  THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS,
+  THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS_RECURSIVE,
 } ThunarLauncherAction;
 
 typedef enum
@@ -32,11 +32,15 @@
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-file-monitor.h>
+#include <thunar/thunar-free-space.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-list-model.h>
+#include <thunar/thunar-pattern.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-trace.h>
 #include <thunar/thunar-user.h>
+#include <thunar/thunar-util.h>
 
 
 
@@ -52,6 +56,7 @@ enum
   PROP_NUM_FILES,
   PROP_SHOW_HIDDEN,
   PROP_FILE_SIZE_BINARY,
+  PROP_FREE_SPACE,
   N_PROPERTIES
 };
 
@@ -64,10 +69,128 @@ enum
 
 
 
+/* batches with less files than 1/ratio of the rows are inserted
+ * using a binary search, larger batches are merged in one pass */
+#define THUNAR_LIST_MODEL_MERGE_RATIO (64)
+
+/* if more rows than this changed their sort position since the last
+ * resort, the whole model is sorted again instead of moving each row */
+#define THUNAR_LIST_MODEL_RESORT_THRESHOLD (32)
+
+/* models with at least this many rows are sorted in a flat array, using
+ * a radix sort for numeric columns and a parallel merge sort otherwise */
+#define THUNAR_LIST_MODEL_ARRAY_SORT_MIN (10000)
+#define THUNAR_LIST_MODEL_SORT_THREADS   (8)
+
+/* models with at least this many rows are filtered in parallel */
+#define THUNAR_LIST_MODEL_FILTER_MIN (2000)
+
+/* number of lookups in the sequence after a change, before the flat
+ * copy of the rows is rebuilt, so a model that is being filled does
+ * not rebuild it for every batch */
+#define THUNAR_LIST_MODEL_ROW_ARRAY_MISSES (64)
+
+/* maximum number of formatted texts kept per column kind, the
+ * texts are dropped all at once when this is reached */
+#define THUNAR_LIST_MODEL_MAX_TEXTS (4096)
+
+/* number of the longest names tracked for the column autosizing */
+#define THUNAR_LIST_MODEL_N_LONGEST (8)
+
+
+
 typedef gint (*ThunarSortFunc) (const ThunarFile *a,
                                 const ThunarFile *b,
                                 gboolean          case_sensitive);
 
+/* the parts of a file that are expensive to determine for sorting,
+ * computed when they are first compared and dropped when the file
+ * changes. The strings are interned, so equal keys compare by pointer */
+typedef enum
+{
+  SORT_KEY_TYPE  = 1 << 0,
+  SORT_KEY_OWNER = 1 << 1,
+  SORT_KEY_GROUP = 1 << 2,
+} SortKeyFlags;
+
+typedef struct _SortEntry   SortEntry;
+typedef struct _SortContext SortContext;
+
+typedef enum
+{
+  FILTER_HIDDEN,
+  FILTER_PATTERN,
+} FilterKind;
+
+typedef struct
+{
+  SortKeyFlags  flags;
+  const gchar  *description;
+  gchar        *link_description;
+  const gchar  *owner;
+  guint32       uid;
+  const gchar  *group;
+  guint32       gid;
+}
+SortKey;
+
+/* a row in the flat array used to sort large models */
+struct _SortEntry
+{
+  ThunarFile    *file;
+  GSequenceIter *row;
+  guint64        value;
+  gint           position;
+  gboolean       is_dir;
+};
+
+struct _SortContext
+{
+  ThunarListModel *store;
+  SortEntry       *entries;
+  SortEntry       *scratch;
+
+  GMutex           mutex;
+  GCond            cond;
+  guint            n_pending;
+};
+
+typedef struct
+{
+  SortContext *context;
+  guint        begin;
+  guint        middle;
+  guint        end;
+}
+SortTask;
+
+/* a snapshot of the rows and the predicate evaluated on them */
+typedef struct
+{
+  FilterKind      kind;
+  ThunarPattern  *pattern;
+  gboolean        case_sensitive;
+
+  GSequenceIter **rows;
+  ThunarFile    **files;
+  const gchar   **names;    /* the names matched with the pattern */
+  gboolean       *matches;
+  guint           length;
+
+  GMutex          mutex;
+  GCond           cond;
+  guint           n_pending;
+}
+FilterContext;
+
+typedef struct
+{
+  FilterContext *context;
+  guint          begin;
+  guint          end;
+}
+FilterTask;
+
 
 
 static void               thunar_list_model_tree_model_init       (GtkTreeModelIface      *iface);
@@ -137,10 +260,21 @@ static gboolean           thunar_list_model_has_default_sort_func (GtkTreeSortab
 static gint               thunar_list_model_cmp_func              (gconstpointer           a,
                                                                    gconstpointer           b,
                                                                    gpointer                user_data);
+static gint               thunar_list_model_cmp_array             (gconstpointer           a,
+                                                                   gconstpointer           b,
+                                                                   gpointer                user_data);
+static gint               thunar_list_model_cmp_positions         (gconstpointer           a,
+                                                                   gconstpointer           b);
 static void               thunar_list_model_sort                  (ThunarListModel        *store);
+static void               thunar_list_model_resort                (ThunarListModel        *store);
+static void               thunar_list_model_insert_files          (ThunarListModel        *store,
+                                                                   GPtrArray              *files);
 static void               thunar_list_model_file_changed          (ThunarFileMonitor      *file_monitor,
                                                                    ThunarFile             *file,
                                                                    ThunarListModel        *store);
+static void               thunar_list_model_added_file_destroyed  (ThunarFileMonitor      *file_monitor,
+                                                                   ThunarFile             *file,
+                                                                   ThunarListModel        *store);
 static void               thunar_list_model_folder_destroy        (ThunarFolder           *folder,
                                                                    ThunarListModel        *store);
 static void               thunar_list_model_folder_error          (ThunarFolder           *folder,
@@ -182,6 +316,9 @@ static gint               sort_by_size                            (const ThunarF
 static gint               sort_by_size_in_bytes                   (const ThunarFile       *a,
                                                                    const ThunarFile       *b,
                                                                    gboolean                case_sensitive);
+static SortKeyFlags       sort_key_flags_for_func                 (ThunarSortFunc          sort_func);
+static SortKey           *sort_key_get                            (const ThunarFile       *file,
+                                                                   SortKeyFlags            flags);
 static gint               sort_by_type                            (const ThunarFile       *a,
                                                                    const ThunarFile       *b,
                                                                    gboolean                case_sensitive);
@@ -196,7 +333,25 @@ static const char*        thunar_list_model_get_date_custom_style (ThunarListMod
 static void               thunar_list_model_set_date_custom_style (ThunarListModel        *store,
                                                                    const char             *date_custom_style);
 static gint               thunar_list_model_get_num_files         (ThunarListModel        *store);
+static void               thunar_list_model_siblings_add          (ThunarListModel        *store);
+static void               thunar_list_model_siblings_remove       (ThunarListModel        *store);
+static gboolean           thunar_list_model_copy_rows             (ThunarListModel        *store);
 static gboolean           thunar_list_model_get_folders_first     (ThunarListModel        *store);
+static const gchar       *thunar_list_model_insert_text           (GHashTable             *texts,
+                                                                   guint64                 key,
+                                                                   gchar                  *text);
+static const gchar       *thunar_list_model_get_date_text         (ThunarListModel        *store,
+                                                                   ThunarFile             *file,
+                                                                   ThunarFileDateType      date_type);
+static const gchar       *thunar_list_model_get_mode_text         (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static const gchar       *thunar_list_model_get_size_text         (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static const gchar       *thunar_list_model_get_type_text         (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static const gchar       *thunar_list_model_get_text              (ThunarListModel        *store,
+                                                                   ThunarFile             *file,
+                                                                   gint                    column);
 
 
 
@@ -223,12 +378,40 @@ struct _ThunarListModel
 
   GSequence      *rows;
   GSList         *hidden;
+
+  /* maps the visible files to their row, and the files that may
+   * have to move to another position to a reference on them */
+  GHashTable     *rows_index;
+  GHashTable     *resort_files;
+  guint           resort_idle_id;
+
+  /* flat copy of the rows, so the views can map between rows and
+   * positions in constant time while the model does not change */
+  GSequenceIter **row_array;
+  gint            row_array_length;
+  GHashTable     *row_positions;
+  gboolean        row_array_valid : 1;
+  guint           row_array_misses;
+
   ThunarFolder   *folder;
   gboolean        show_hidden : 1;
   gboolean        file_size_binary : 1;
   ThunarDateStyle date_style;
   char           *date_custom_style;
 
+  /* the texts of the date, size and permissions columns, keyed by the
+   * value they are formatted from, since the views ask for them on every
+   * redraw; the date texts expire at midnight for "Today" and "Yesterday" */
+  GHashTable     *date_texts;
+  GHashTable     *size_texts;
+  GHashTable     *mode_texts;
+  gint64          date_texts_expire;
+
+  /* descriptions of the content types, and the last text formatted
+   * for a single call, see thunar_list_model_peek_text() */
+  GHashTable     *type_texts;
+  gchar          *scratch_text;
+
   /* Use the shared ThunarFileMonitor instance, so we
    * do not need to connect "changed" handler to every
    * file in the model.
@@ -245,12 +428,40 @@ struct _ThunarListModel
   gboolean       sort_folders_first : 1;
   gint           sort_sign;   /* 1 = ascending, -1 descending */
   ThunarSortFunc sort_func;
+
+  /* running totals of the visible rows for the statusbar, updated
+   * as rows come and go and recalculated after files changed */
+  gint           totals_n_folders;
+  gint           totals_n_files;
+  guint64        totals_size;
+  gboolean       totals_valid : 1;
+
+  /* the visible files with the longest display names (by bytes) and
+   * the lengths of their names, kept along with the totals for the
+   * column autosizing of the details view, not referenced */
+  ThunarFile    *totals_longest[THUNAR_LIST_MODEL_N_LONGEST];
+  gsize          totals_longest_length[THUNAR_LIST_MODEL_N_LONGEST];
+
+  /* free space of the volume, queried in the background */
+  guint64        free_space;
+  GCancellable  *free_space_cancellable;
+
+  /* the last type-ahead key, see thunar_list_model_search_equal() */
+  gchar         *search_key;
+  gchar         *search_key_casefold;
 };
 
 
 
 static guint       list_model_signals[LAST_SIGNAL];
 static GParamSpec *list_model_props[N_PROPERTIES] = { NULL, };
+static GQuark      thunar_list_model_sort_key_quark;
+
+/* all live models, for thunar_list_model_get_memory() */
+static GList      *live_models = NULL;
+
+/* the models showing each #ThunarFolder, see thunar_list_model_copy_rows() */
+static GHashTable *list_model_siblings = NULL;
 
 
 
@@ -266,6 +477,8 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
 {
   GObjectClass *gobject_class;
 
+  thunar_list_model_sort_key_quark = g_quark_from_static_string ("thunar-list-model-sort-key");
+
   gobject_class               = G_OBJECT_CLASS (klass);
   gobject_class->dispose      = thunar_list_model_dispose;
   gobject_class->finalize     = thunar_list_model_finalize;
@@ -369,6 +582,19 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
                             TRUE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarListModel::free-space:
+   *
+   * The amount of free space on the volume of the folder, or zero
+   * until it is known.
+   **/
+  list_model_props[PROP_FREE_SPACE] =
+      g_param_spec_uint64 ("free-space",
+                           "free-space",
+                           "free-space",
+                           0, G_MAXUINT64, 0,
+                           EXO_PARAM_READABLE);
+
   /* install properties */
   g_object_class_install_properties (gobject_class, N_PROPERTIES, list_model_props);
 
@@ -448,13 +674,23 @@ thunar_list_model_init (ThunarListModel *store)
   store->sort_sign = 1;
   store->sort_func = thunar_file_compare_by_name;
   store->rows = g_sequence_new (g_object_unref);
-
-  /* connect to the shared ThunarFileMonitor, so we don't need to
-   * connect "changed" to every single ThunarFile we own.
+  store->rows_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+  store->resort_files = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+  store->row_positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  store->totals_valid = TRUE;
+
+  store->date_texts = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, g_free);
+  store->size_texts = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, g_free);
+  store->mode_texts = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, g_free);
+  store->type_texts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  /* use the shared ThunarFileMonitor, so we don't need to connect
+   * "changed" to every single ThunarFile we own. The files of the
+   * folder are watched in thunar_list_model_set_folder().
    */
   store->file_monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (G_OBJECT (store->file_monitor), "file-changed",
-                    G_CALLBACK (thunar_list_model_file_changed), store);
+
+  live_models = g_list_prepend (live_models, store);
 }
 
 
@@ -475,12 +711,36 @@ thunar_list_model_finalize (GObject *object)
 {
   ThunarListModel *store = THUNAR_LIST_MODEL (object);
 
+  if (G_UNLIKELY (store->resort_idle_id != 0))
+    g_source_remove (store->resort_idle_id);
+  g_hash_table_destroy (store->resort_files);
+  g_hash_table_destroy (store->rows_index);
+  g_hash_table_destroy (store->row_positions);
+  g_free (store->row_array);
+
   g_sequence_free (store->rows);
 
-  /* disconnect from the file monitor */
-  g_signal_handlers_disconnect_by_func (G_OBJECT (store->file_monitor), thunar_list_model_file_changed, store);
+  /* a pending free space query returns to a cancelled store */
+  if (store->free_space_cancellable != NULL)
+    {
+      g_cancellable_cancel (store->free_space_cancellable);
+      g_object_unref (store->free_space_cancellable);
+    }
+
+  /* release the file monitor, the folder is unwatched in dispose */
   g_object_unref (G_OBJECT (store->file_monitor));
 
+  g_free (store->search_key);
+  g_free (store->search_key_casefold);
+
+  g_hash_table_destroy (store->date_texts);
+  g_hash_table_destroy (store->size_texts);
+  g_hash_table_destroy (store->mode_texts);
+  g_hash_table_destroy (store->type_texts);
+  g_free (store->scratch_text);
+
+  live_models = g_list_remove (live_models, store);
+
   (*G_OBJECT_CLASS (thunar_list_model_parent_class)->finalize) (object);
 }
 
@@ -528,6 +788,10 @@ thunar_list_model_get_property (GObject    *object,
       g_value_set_boolean (value, thunar_list_model_get_file_size_binary (store));
       break;
 
+    case PROP_FREE_SPACE:
+      g_value_set_uint64 (value, store->free_space);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -582,6 +846,186 @@ thunar_list_model_set_property (GObject      *object,
 
 
 
+static inline void
+thunar_list_model_rows_changed (ThunarListModel *store)
+{
+  store->row_array_valid = FALSE;
+  store->row_array_misses = 0;
+}
+
+
+
+static void
+thunar_list_model_totals_update (ThunarListModel *store,
+                                 ThunarFile      *file,
+                                 gint             sign)
+{
+  guint64 size;
+  gsize   length;
+  guint   shortest;
+  guint   n;
+
+  if (!store->totals_valid)
+    return;
+
+  if (sign > 0)
+    {
+      /* replace the shortest of the longest names, if this one is longer */
+      length = strlen (thunar_file_get_display_name (file));
+      for (n = 1, shortest = 0; n < THUNAR_LIST_MODEL_N_LONGEST; ++n)
+        if (store->totals_longest_length[n] < store->totals_longest_length[shortest])
+          shortest = n;
+      if (store->totals_longest[shortest] == NULL || length > store->totals_longest_length[shortest])
+        {
+          store->totals_longest[shortest] = file;
+          store->totals_longest_length[shortest] = length;
+        }
+    }
+  else
+    {
+      /* the next longest name is unknown, recalculate on demand */
+      for (n = 0; n < THUNAR_LIST_MODEL_N_LONGEST; ++n)
+        if (G_UNLIKELY (store->totals_longest[n] == file))
+          store->totals_valid = FALSE;
+    }
+
+  if (thunar_file_is_directory (file))
+    {
+      store->totals_n_folders += sign;
+    }
+  else
+    {
+      store->totals_n_files += sign;
+      if (thunar_file_is_regular (file))
+        {
+          size = thunar_file_get_size (file);
+          if (sign < 0 && size > store->totals_size)
+            store->totals_valid = FALSE;
+          else if (sign < 0)
+            store->totals_size -= size;
+          else
+            store->totals_size += size;
+        }
+    }
+
+  /* the file changed since it was counted, recalculate on demand */
+  if (G_UNLIKELY (store->totals_n_folders < 0 || store->totals_n_files < 0))
+    store->totals_valid = FALSE;
+}
+
+
+
+static void
+thunar_list_model_totals_reset (ThunarListModel *store)
+{
+  store->totals_n_folders = 0;
+  store->totals_n_files = 0;
+  store->totals_size = 0;
+  store->totals_valid = TRUE;
+
+  memset (store->totals_longest, 0, sizeof (store->totals_longest));
+  memset (store->totals_longest_length, 0, sizeof (store->totals_longest_length));
+}
+
+
+
+static void
+thunar_list_model_totals_validate (ThunarListModel *store)
+{
+  GSequenceIter *row;
+  GSequenceIter *end;
+
+  if (G_UNLIKELY (!store->totals_valid))
+    {
+      thunar_list_model_totals_reset (store);
+
+      end = g_sequence_get_end_iter (store->rows);
+      for (row = g_sequence_get_begin_iter (store->rows); row != end; row = g_sequence_iter_next (row))
+        thunar_list_model_totals_update (store, g_sequence_get (row), 1);
+    }
+}
+
+
+
+static void
+thunar_list_model_get_totals (ThunarListModel *store,
+                              gint            *n_folders,
+                              gint            *n_files,
+                              guint64         *size)
+{
+  thunar_list_model_totals_validate (store);
+
+  *n_folders = store->totals_n_folders;
+  *n_files = store->totals_n_files;
+  *size = store->totals_size;
+}
+
+
+
+static gboolean
+thunar_list_model_use_row_array (ThunarListModel *store)
+{
+  GSequenceIter *row;
+  gint           length;
+  gint           n;
+
+  if (G_LIKELY (store->row_array_valid))
+    return TRUE;
+
+  /* use the sequence until the model settled down */
+  if (++store->row_array_misses < THUNAR_LIST_MODEL_ROW_ARRAY_MISSES)
+    return FALSE;
+
+  length = g_sequence_get_length (store->rows);
+  store->row_array = g_renew (GSequenceIter *, store->row_array, length + 1);
+  g_hash_table_remove_all (store->row_positions);
+
+  row = g_sequence_get_begin_iter (store->rows);
+  for (n = 0; n < length; ++n, row = g_sequence_iter_next (row))
+    {
+      store->row_array[n] = row;
+      g_hash_table_insert (store->row_positions, row, GINT_TO_POINTER (n));
+    }
+  store->row_array[length] = NULL;
+
+  store->row_array_length = length;
+  store->row_array_valid = TRUE;
+
+  return TRUE;
+}
+
+
+
+static GSequenceIter *
+thunar_list_model_row_at (ThunarListModel *store,
+                          gint             position)
+{
+  GSequenceIter *row;
+
+  if (G_UNLIKELY (position < 0))
+    return NULL;
+
+  if (thunar_list_model_use_row_array (store))
+    return (position < store->row_array_length) ? store->row_array[position] : NULL;
+
+  row = g_sequence_get_iter_at_pos (store->rows, position);
+  return g_sequence_iter_is_end (row) ? NULL : row;
+}
+
+
+
+static gint
+thunar_list_model_row_position (ThunarListModel *store,
+                                GSequenceIter   *row)
+{
+  if (thunar_list_model_use_row_array (store))
+    return GPOINTER_TO_INT (g_hash_table_lookup (store->row_positions, row));
+
+  return g_sequence_iter_get_position (row);
+}
+
+
+
 static GtkTreeModelFlags
 thunar_list_model_get_flags (GtkTreeModel *model)
 {
@@ -667,9 +1111,9 @@ thunar_list_model_get_iter (GtkTreeModel *model,
 
   /* determine the row for the path */
   offset = gtk_tree_path_get_indices (path)[0];
-  row = g_sequence_get_iter_at_pos (store->rows, offset);
+  row = thunar_list_model_row_at (store, offset);
 
-  if (!g_sequence_iter_is_end (row))
+  if (row != NULL)
     {
       GTK_TREE_ITER_INIT (*iter, store->stamp, row);
       return TRUE;
@@ -689,7 +1133,7 @@ thunar_list_model_get_path (GtkTreeModel *model,
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (model), NULL);
   _thunar_return_val_if_fail (iter->stamp == THUNAR_LIST_MODEL (model)->stamp, NULL);
 
-  idx = g_sequence_iter_get_position (iter->user_data);
+  idx = thunar_list_model_row_position (THUNAR_LIST_MODEL (model), iter->user_data);
   if (G_LIKELY (idx >= 0))
     return gtk_tree_path_new_from_indices (idx, -1);
 
@@ -699,162 +1143,292 @@ thunar_list_model_get_path (GtkTreeModel *model,
 
 
 static void
-thunar_list_model_get_value (GtkTreeModel *model,
-                             GtkTreeIter  *iter,
-                             gint          column,
-                             GValue       *value)
+thunar_list_model_mountable_space_ready (GObject      *object,
+                                         GAsyncResult *result,
+                                         gpointer      user_data)
+{
+  ThunarFile *file = THUNAR_FILE (user_data);
+
+  /* redraw the size column of the mountable once its free space is known */
+  if (thunar_free_space_query_finish (G_FILE (object), result, NULL, NULL, NULL))
+    thunar_file_changed (file);
+
+  g_object_unref (file);
+}
+
+
+
+static const gchar *
+thunar_list_model_insert_text (GHashTable *texts,
+                               guint64     key,
+                               gchar      *text)
+{
+  guint64 *stored_key;
+
+  /* don't let the texts of large folders pile up */
+  if (G_UNLIKELY (g_hash_table_size (texts) >= THUNAR_LIST_MODEL_MAX_TEXTS))
+    g_hash_table_remove_all (texts);
+
+  stored_key = g_new (guint64, 1);
+  *stored_key = key;
+  g_hash_table_insert (texts, stored_key, text);
+
+  return text;
+}
+
+
+
+static const gchar *
+thunar_list_model_get_date_text (ThunarListModel   *store,
+                                 ThunarFile        *file,
+                                 ThunarFileDateType date_type)
+{
+  const gchar *text;
+  GDateTime   *now;
+  GDateTime   *midnight;
+  GDateTime   *expire;
+  guint64      date;
+
+  /* the texts relative to the current day are wrong after midnight */
+  if (G_UNLIKELY (g_get_real_time () / G_USEC_PER_SEC >= store->date_texts_expire))
+    {
+      g_hash_table_remove_all (store->date_texts);
+
+      now = g_date_time_new_now_local ();
+      midnight = g_date_time_new_local (g_date_time_get_year (now), g_date_time_get_month (now),
+                                        g_date_time_get_day_of_month (now), 0, 0, 0);
+      expire = g_date_time_add_days (midnight, 1);
+      store->date_texts_expire = g_date_time_to_unix (expire);
+      g_date_time_unref (expire);
+      g_date_time_unref (midnight);
+      g_date_time_unref (now);
+    }
+
+  date = thunar_file_get_date (file, date_type);
+  text = g_hash_table_lookup (store->date_texts, &date);
+  if (G_UNLIKELY (text == NULL))
+    {
+      text = thunar_list_model_insert_text (store->date_texts, date,
+                                            thunar_util_humanize_file_time (date, store->date_style,
+                                                                            store->date_custom_style));
+    }
+
+  return text;
+}
+
+
+
+static const gchar *
+thunar_list_model_get_mode_text (ThunarListModel *store,
+                                 ThunarFile      *file)
+{
+  const gchar *text;
+  guint64      key;
+
+  /* the text depends on the kind of the file as well */
+  key = ((guint64) thunar_file_get_kind (file) << 32) | thunar_file_get_mode (file);
+  text = g_hash_table_lookup (store->mode_texts, &key);
+  if (G_UNLIKELY (text == NULL))
+    text = thunar_list_model_insert_text (store->mode_texts, key, thunar_file_get_mode_string (file));
+
+  return text;
+}
+
+
+
+static const gchar *
+thunar_list_model_get_size_text (ThunarListModel *store,
+                                 ThunarFile      *file)
+{
+  const gchar *text;
+  guint64      size;
+
+  size = thunar_file_get_size (file);
+  text = g_hash_table_lookup (store->size_texts, &size);
+  if (G_UNLIKELY (text == NULL))
+    {
+      text = thunar_list_model_insert_text (store->size_texts, size,
+                                            thunar_file_get_size_string_formatted (file, store->file_size_binary));
+    }
+
+  return text;
+}
+
+
+
+static const gchar *
+thunar_list_model_get_type_text (ThunarListModel *store,
+                                 ThunarFile      *file)
 {
-  ThunarGroup *group;
   const gchar *content_type;
   const gchar *device_type;
+  gchar       *text;
+
+  if (G_UNLIKELY (thunar_file_is_symlink (file)))
+    {
+      g_free (store->scratch_text);
+      store->scratch_text = g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file));
+      return store->scratch_text;
+    }
+
+  device_type = thunar_file_get_device_type (file);
+  if (device_type != NULL)
+    return device_type;
+
+  content_type = thunar_file_get_content_type (file);
+  if (content_type == NULL)
+    return NULL;
+
+  /* looking up the description in the mime database is expensive,
+   * and a folder usually holds only a handful of different types */
+  text = g_hash_table_lookup (store->type_texts, content_type);
+  if (G_UNLIKELY (text == NULL))
+    {
+      text = g_content_type_get_description (content_type);
+      g_hash_table_insert (store->type_texts, g_strdup (content_type), text);
+    }
+
+  return text;
+}
+
+
+
+static const gchar *
+thunar_list_model_get_text (ThunarListModel *store,
+                            ThunarFile      *file,
+                            gint             column)
+{
+  ThunarGroup *group;
   const gchar *name;
   const gchar *real_name;
   ThunarUser  *user;
-  ThunarFile  *file;
   GFile       *g_file;
-  gchar       *str;
-
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
-  _thunar_return_if_fail (iter->stamp == (THUNAR_LIST_MODEL (model))->stamp);
-
-  file = g_sequence_get (iter->user_data);
-  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  guint64      fs_free;
+  guint64      fs_size;
 
   switch (column)
     {
     case THUNAR_COLUMN_DATE_CREATED:
-      g_value_init (value, G_TYPE_STRING);
-      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_CREATED, THUNAR_LIST_MODEL (model)->date_style, THUNAR_LIST_MODEL (model)->date_custom_style);
-      g_value_take_string (value, str);
-      break;
+      return thunar_list_model_get_date_text (store, file, THUNAR_FILE_DATE_CREATED);
 
     case THUNAR_COLUMN_DATE_ACCESSED:
-      g_value_init (value, G_TYPE_STRING);
-      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_ACCESSED, THUNAR_LIST_MODEL (model)->date_style, THUNAR_LIST_MODEL (model)->date_custom_style);
-      g_value_take_string (value, str);
-      break;
+      return thunar_list_model_get_date_text (store, file, THUNAR_FILE_DATE_ACCESSED);
 
     case THUNAR_COLUMN_DATE_MODIFIED:
-      g_value_init (value, G_TYPE_STRING);
-      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_MODIFIED, THUNAR_LIST_MODEL (model)->date_style, THUNAR_LIST_MODEL (model)->date_custom_style);
-      g_value_take_string (value, str);
-      break;
+      return thunar_list_model_get_date_text (store, file, THUNAR_FILE_DATE_MODIFIED);
 
     case THUNAR_COLUMN_DATE_DELETED:
-      g_value_init (value, G_TYPE_STRING);
-      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_DELETED, THUNAR_LIST_MODEL (model)->date_style, THUNAR_LIST_MODEL (model)->date_custom_style);
-      g_value_take_string (value, str);
-      break;
+      return thunar_list_model_get_date_text (store, file, THUNAR_FILE_DATE_DELETED);
 
     case THUNAR_COLUMN_GROUP:
-      g_value_init (value, G_TYPE_STRING);
       group = thunar_file_get_group (file);
-      if (G_LIKELY (group != NULL))
-        {
-          g_value_set_string (value, thunar_group_get_name (group));
-          g_object_unref (G_OBJECT (group));
-        }
-      else
-        {
-          g_value_set_static_string (value, _("Unknown"));
-        }
-      break;
+      if (G_UNLIKELY (group == NULL))
+        return _("Unknown");
+      g_free (store->scratch_text);
+      store->scratch_text = g_strdup (thunar_group_peek_name (group));
+      g_object_unref (G_OBJECT (group));
+      return store->scratch_text;
 
     case THUNAR_COLUMN_MIME_TYPE:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_set_static_string (value, thunar_file_get_content_type (file));
-      break;
+      return thunar_file_get_content_type (file);
 
     case THUNAR_COLUMN_NAME:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_set_static_string (value, thunar_file_get_display_name (file));
-      break;
+    case THUNAR_COLUMN_FILE_NAME:
+      return thunar_file_get_display_name (file);
 
     case THUNAR_COLUMN_OWNER:
-      g_value_init (value, G_TYPE_STRING);
       user = thunar_file_get_user (file);
-      if (G_LIKELY (user != NULL))
-        {
-          /* determine sane display name for the owner */
-          name = thunar_user_get_name (user);
-          real_name = thunar_user_get_real_name (user);
-          if(G_LIKELY (real_name != NULL))
-            {
-              if(strcmp (name, real_name) == 0)
-                str = g_strdup (name);
-              else
-                str = g_strdup_printf ("%s (%s)", real_name, name);
-            }
-          else
-            str = g_strdup (name);
-          g_value_take_string (value, str);
-          g_object_unref (G_OBJECT (user));
-        }
+      if (G_UNLIKELY (user == NULL))
+        return _("Unknown");
+
+      /* determine sane display name for the owner */
+      g_free (store->scratch_text);
+      name = thunar_user_peek_name (user);
+      real_name = thunar_user_peek_real_name (user);
+      if (G_LIKELY (real_name != NULL) && strcmp (name, real_name) != 0)
+        store->scratch_text = g_strdup_printf ("%s (%s)", real_name, name);
       else
-        {
-          g_value_set_static_string (value, _("Unknown"));
-        }
-      break;
+        store->scratch_text = g_strdup (name);
+      g_object_unref (G_OBJECT (user));
+      return store->scratch_text;
 
     case THUNAR_COLUMN_PERMISSIONS:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_take_string (value, thunar_file_get_mode_string (file));
-      break;
+      return thunar_list_model_get_mode_text (store, file);
 
     case THUNAR_COLUMN_SIZE:
-      g_value_init (value, G_TYPE_STRING);
       if (thunar_file_is_mountable (file))
         {
           g_file = thunar_file_get_target_location (file);
           if (g_file == NULL)
-            break;
-          g_value_take_string (value, thunar_g_file_get_free_space_string (g_file, THUNAR_LIST_MODEL (model)->file_size_binary));
-          g_object_unref (g_file);
-          break;
+            return NULL;
+          name = NULL;
+          if (thunar_free_space_lookup (g_file, &fs_free, &fs_size))
+            {
+              g_free (store->scratch_text);
+              store->scratch_text = thunar_free_space_format (fs_free, fs_size, store->file_size_binary);
+              name = store->scratch_text;
+            }
+          else
+            thunar_free_space_query_async (g_file, NULL, thunar_list_model_mountable_space_ready, g_object_ref (file));
+          g_object_unref (g_file);
+          return name;
         }
       if (!thunar_file_is_directory (file))
-        g_value_take_string (value, thunar_file_get_size_string_formatted (file, THUNAR_LIST_MODEL (model)->file_size_binary));
-      break;
+        return thunar_list_model_get_size_text (store, file);
+      return NULL;
 
     case THUNAR_COLUMN_SIZE_IN_BYTES:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_take_string (value, thunar_file_get_size_in_bytes_string (file));
-      break;
+      g_free (store->scratch_text);
+      store->scratch_text = thunar_file_get_size_in_bytes_string (file);
+      return store->scratch_text;
 
     case THUNAR_COLUMN_TYPE:
-      g_value_init (value, G_TYPE_STRING);
-      if (G_UNLIKELY (thunar_file_is_symlink (file)))
-        {
-          g_value_take_string (value, g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file)));
-          break;
-        }
-      device_type = thunar_file_get_device_type (file);
-      if (device_type != NULL)
-        {
-          g_value_take_string (value, g_strdup (device_type));
-          break;
-        }
-      content_type = thunar_file_get_content_type (file);
-      if (content_type != NULL)
-        {
-          g_value_take_string (value, g_content_type_get_description (content_type));
-          break;
-        }
-      break;
+      return thunar_list_model_get_type_text (store, file);
 
-    case THUNAR_COLUMN_FILE:
+    default:
+      _thunar_assert_not_reached ();
+      return NULL;
+    }
+}
+
+
+
+static void
+thunar_list_model_get_value (GtkTreeModel *model,
+                             GtkTreeIter  *iter,
+                             gint          column,
+                             GValue       *value)
+{
+  ThunarListModel *store = THUNAR_LIST_MODEL (model);
+  const gchar     *text;
+  ThunarFile      *file;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
+  _thunar_return_if_fail (iter->stamp == (THUNAR_LIST_MODEL (model))->stamp);
+
+  file = g_sequence_get (iter->user_data);
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  if (column == THUNAR_COLUMN_FILE)
+    {
       g_value_init (value, THUNAR_TYPE_FILE);
       g_value_set_object (value, file);
-      break;
+      return;
+    }
 
-    case THUNAR_COLUMN_FILE_NAME:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_set_static_string (value, thunar_file_get_display_name (file));
-      break;
+  g_value_init (value, G_TYPE_STRING);
+  text = thunar_list_model_get_text (store, file, column);
 
-    default:
-      _thunar_assert_not_reached ();
-      break;
+  /* the texts formatted for this call can be handed over to the value,
+   * all others stay alive as long as the file or the model */
+  if (text != NULL && text == store->scratch_text)
+    {
+      g_value_take_string (value, store->scratch_text);
+      store->scratch_text = NULL;
+    }
+  else
+    {
+      g_value_set_static_string (value, text);
     }
 }
 
@@ -929,8 +1503,8 @@ thunar_list_model_iter_nth_child (GtkTreeModel *model,
 
   if (G_LIKELY (parent == NULL))
     {
-      row = g_sequence_get_iter_at_pos (store->rows, n);
-      if (g_sequence_iter_is_end (row))
+      row = thunar_list_model_row_at (store, n);
+      if (row == NULL)
         return FALSE;
 
       GTK_TREE_ITER_INIT (*iter, store->stamp, row);
@@ -1153,8 +1727,453 @@ thunar_list_model_cmp_func (gconstpointer a,
 
 
 
+static gint
+thunar_list_model_cmp_entry (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  const SortEntry *entry_a = a;
+  const SortEntry *entry_b = b;
+  ThunarListModel *store = THUNAR_LIST_MODEL (user_data);
+
+  if (G_LIKELY (store->sort_folders_first) && entry_a->is_dir != entry_b->is_dir)
+    return entry_a->is_dir ? -1 : 1;
+
+  return (*store->sort_func) (entry_a->file, entry_b->file, store->sort_case_sensitive) * store->sort_sign;
+}
+
+
+
+static gboolean
+thunar_list_model_get_sort_value (ThunarListModel *store,
+                                  ThunarFile      *file,
+                                  guint64         *value)
+{
+  if (store->sort_func == sort_by_size || store->sort_func == sort_by_size_in_bytes)
+    *value = thunar_file_get_size (file);
+  else if (store->sort_func == sort_by_date_modified)
+    *value = thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED);
+  else if (store->sort_func == sort_by_date_accessed)
+    *value = thunar_file_get_date (file, THUNAR_FILE_DATE_ACCESSED);
+  else if (store->sort_func == sort_by_date_created)
+    *value = thunar_file_get_date (file, THUNAR_FILE_DATE_CREATED);
+  else if (store->sort_func == sort_by_date_deleted)
+    *value = thunar_file_get_date (file, THUNAR_FILE_DATE_DELETED);
+  else
+    return FALSE;
+
+  /* descending order is ascending order of the complement */
+  if (store->sort_sign < 0)
+    *value = ~*value;
+
+  return TRUE;
+}
+
+
+
+static SortEntry *
+thunar_list_model_radix_sort (ThunarListModel *store,
+                              SortEntry       *entries,
+                              SortEntry       *scratch,
+                              guint            length)
+{
+  guint      counts[8][256];
+  guint      offsets[256];
+  guint      byte;
+  guint      n, i;
+  guint      start;
+  guint      n_dirs;
+  guint      sum;
+  SortEntry *tmp;
+
+  /* determine the histograms of all bytes in one pass */
+  memset (counts, 0, sizeof (counts));
+  for (n = 0; n < length; ++n)
+    for (byte = 0; byte < 8; ++byte)
+      counts[byte][(entries[n].value >> (byte * 8)) & 0xff]++;
+
+  /* stable least significant byte first sort, skipping the bytes
+   * that are the same for all rows (i.e. the top bytes of dates) */
+  for (byte = 0; byte < 8; ++byte)
+    {
+      if (counts[byte][(entries[0].value >> (byte * 8)) & 0xff] == length)
+        continue;
+
+      for (i = 0, sum = 0; i < 256; ++i)
+        {
+          offsets[i] = sum;
+          sum += counts[byte][i];
+        }
+
+      for (n = 0; n < length; ++n)
+        scratch[offsets[(entries[n].value >> (byte * 8)) & 0xff]++] = entries[n];
+
+      tmp = entries;
+      entries = scratch;
+      scratch = tmp;
+    }
+
+  /* stable partition of the folders to the front */
+  if (store->sort_folders_first)
+    {
+      for (n = 0, n_dirs = 0; n < length; ++n)
+        if (entries[n].is_dir)
+          n_dirs++;
+
+      for (n = 0, i = 0, start = n_dirs; n < length; ++n)
+        {
+          if (entries[n].is_dir)
+            scratch[i++] = entries[n];
+          else
+            scratch[start++] = entries[n];
+        }
+
+      tmp = entries;
+      entries = scratch;
+      scratch = tmp;
+    }
+
+  /* rows with the same value are sorted by name */
+  for (start = 0; start < length; start = n)
+    {
+      for (n = start + 1; n < length; ++n)
+        if (entries[n].value != entries[start].value || entries[n].is_dir != entries[start].is_dir)
+          break;
+
+      if (n - start > 1)
+        g_qsort_with_data (entries + start, n - start, sizeof (SortEntry), thunar_list_model_cmp_entry, store);
+    }
+
+  /* the buffers are swapped after every pass */
+  return entries;
+}
+
+
+
 static void
-thunar_list_model_sort (ThunarListModel *store)
+thunar_list_model_sort_worker (gpointer data,
+                               gpointer user_data)
+{
+  SortTask    *task = data;
+  SortContext *context = task->context;
+  SortEntry   *entries = context->entries;
+  SortEntry   *scratch = context->scratch;
+  guint        i, j, n;
+
+  if (task->middle == task->begin)
+    {
+      /* sort a chunk of the array */
+      g_qsort_with_data (entries + task->begin, task->end - task->begin,
+                         sizeof (SortEntry), thunar_list_model_cmp_entry, context->store);
+    }
+  else
+    {
+      /* merge two sorted chunks, preferring the first on ties to keep it stable */
+      for (i = task->begin, j = task->middle, n = task->begin; i < task->middle && j < task->end; ++n)
+        {
+          if (thunar_list_model_cmp_entry (&entries[j], &entries[i], context->store) < 0)
+            scratch[n] = entries[j++];
+          else
+            scratch[n] = entries[i++];
+        }
+      while (i < task->middle)
+        scratch[n++] = entries[i++];
+      while (j < task->end)
+        scratch[n++] = entries[j++];
+
+      memcpy (entries + task->begin, scratch + task->begin, (task->end - task->begin) * sizeof (SortEntry));
+    }
+
+  g_slice_free (SortTask, task);
+
+  g_mutex_lock (&context->mutex);
+  if (--context->n_pending == 0)
+    g_cond_signal (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+static void
+thunar_list_model_sort_push (GThreadPool *pool,
+                             SortContext *context,
+                             guint        begin,
+                             guint        middle,
+                             guint        end)
+{
+  SortTask *task;
+
+  task = g_slice_new (SortTask);
+  task->context = context;
+  task->begin = begin;
+  task->middle = middle;
+  task->end = end;
+
+  g_mutex_lock (&context->mutex);
+  context->n_pending++;
+  g_mutex_unlock (&context->mutex);
+
+  g_thread_pool_push (pool, task, NULL);
+}
+
+
+
+static void
+thunar_list_model_sort_wait (SortContext *context)
+{
+  g_mutex_lock (&context->mutex);
+  while (context->n_pending > 0)
+    g_cond_wait (&context->cond, &context->mutex);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+static void
+thunar_list_model_merge_sort (ThunarListModel *store,
+                              SortEntry       *entries,
+                              SortEntry       *scratch,
+                              guint            length)
+{
+  static GThreadPool *pool = NULL;
+  SortContext         context;
+  guint               bounds[THUNAR_LIST_MODEL_SORT_THREADS + 1];
+  guint               n_chunks;
+  guint               n, i;
+
+  n_chunks = CLAMP (g_get_num_processors (), 1, THUNAR_LIST_MODEL_SORT_THREADS);
+  if (n_chunks == 1)
+    {
+      g_qsort_with_data (entries, length, sizeof (SortEntry), thunar_list_model_cmp_entry, store);
+      return;
+    }
+
+  /* the pool is shared by all models and only used from the main thread */
+  if (G_UNLIKELY (pool == NULL))
+    pool = g_thread_pool_new (thunar_list_model_sort_worker, NULL, THUNAR_LIST_MODEL_SORT_THREADS, FALSE, NULL);
+
+  context.store = store;
+  context.entries = entries;
+  context.scratch = scratch;
+  context.n_pending = 0;
+  g_mutex_init (&context.mutex);
+  g_cond_init (&context.cond);
+
+  /* sort the chunks in parallel */
+  for (n = 0; n <= n_chunks; ++n)
+    bounds[n] = (guint) (((guint64) length * n) / n_chunks);
+  for (n = 0; n < n_chunks; ++n)
+    thunar_list_model_sort_push (pool, &context, bounds[n], bounds[n], bounds[n + 1]);
+  thunar_list_model_sort_wait (&context);
+
+  /* merge neighbouring chunks until one is left */
+  while (n_chunks > 1)
+    {
+      for (n = 0; n + 1 < n_chunks; n += 2)
+        thunar_list_model_sort_push (pool, &context, bounds[n], bounds[n + 1], bounds[n + 2]);
+      thunar_list_model_sort_wait (&context);
+
+      /* drop the merged boundaries */
+      for (n = 0, i = 0; n <= n_chunks; n += 2)
+        bounds[i++] = bounds[n];
+      if (bounds[i - 1] != length)
+        bounds[i++] = length;
+      n_chunks = i - 1;
+    }
+
+  g_mutex_clear (&context.mutex);
+  g_cond_clear (&context.cond);
+}
+
+
+
+/* sorts large models in a flat array and moves the rows into place,
+ * the iterators of the rows stay valid */
+static void
+thunar_list_model_sort_array (ThunarListModel *store,
+                              gint            *new_order,
+                              gint             length)
+{
+  SortEntry     *entries;
+  SortEntry     *scratch;
+  SortEntry     *sorted;
+  SortKeyFlags   flags;
+  GSequenceIter *row;
+  GSequenceIter *end;
+  gboolean       numeric = TRUE;
+  gint           n;
+
+  entries = g_new (SortEntry, length);
+  scratch = g_new (SortEntry, length);
+
+  /* extract the rows and everything the comparisons need, the
+   * workers must not compute anything that is stored on the files */
+  flags = sort_key_flags_for_func (store->sort_func);
+  row = g_sequence_get_begin_iter (store->rows);
+  for (n = 0; n < length; ++n, row = g_sequence_iter_next (row))
+    {
+      entries[n].file = g_sequence_get (row);
+      entries[n].row = row;
+      entries[n].position = n;
+      entries[n].is_dir = thunar_file_is_directory (entries[n].file);
+      entries[n].value = 0;
+
+      if (numeric)
+        numeric = thunar_list_model_get_sort_value (store, entries[n].file, &entries[n].value);
+      if (flags != 0)
+        sort_key_get (entries[n].file, flags);
+      else if (store->sort_func == sort_by_mime_type)
+        thunar_file_get_content_type (entries[n].file);
+    }
+
+  if (numeric)
+    {
+      sorted = thunar_list_model_radix_sort (store, entries, scratch, length);
+    }
+  else
+    {
+      /* every comparison may fall back to the names, create their
+       * collation keys in one pass before the workers need them */
+      for (n = 0; n < length; ++n)
+        thunar_file_prepare_collate_keys (entries[n].file);
+
+      thunar_list_model_merge_sort (store, entries, scratch, length);
+      sorted = entries;
+    }
+
+  /* move the rows into the new order, new_order[newpos] = oldpos */
+  end = g_sequence_get_end_iter (store->rows);
+  for (n = 0; n < length; ++n)
+    {
+      new_order[n] = sorted[n].position;
+      g_sequence_move (sorted[n].row, end);
+    }
+
+  g_free (scratch);
+  g_free (entries);
+}
+
+
+
+static void
+thunar_list_model_filter_range (FilterContext *context,
+                                guint          begin,
+                                guint          end)
+{
+  guint n;
+
+  for (n = begin; n < end; ++n)
+    {
+      if (context->kind == FILTER_HIDDEN)
+        context->matches[n] = thunar_file_is_hidden (context->files[n]);
+      else
+        context->matches[n] = thunar_pattern_match (context->pattern, context->names[n]);
+    }
+}
+
+
+
+static void
+thunar_list_model_filter_worker (gpointer data,
+                                 gpointer user_data)
+{
+  FilterTask    *task = data;
+  FilterContext *context = task->context;
+
+  thunar_list_model_filter_range (context, task->begin, task->end);
+  g_slice_free (FilterTask, task);
+
+  g_mutex_lock (&context->mutex);
+  if (--context->n_pending == 0)
+    g_cond_signal (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+/* takes a snapshot of the rows and evaluates the predicate of the
+ * context on each of them, large models are split over a worker pool.
+ * The main loop is blocked meanwhile, so the files cannot change */
+static void
+thunar_list_model_filter (ThunarListModel *store,
+                          FilterContext   *context)
+{
+  static GThreadPool *pool = NULL;
+  FilterTask         *task;
+  GSequenceIter      *row;
+  guint               n_chunks;
+  guint               n;
+
+  context->length = g_sequence_get_length (store->rows);
+  context->rows = g_new (GSequenceIter *, context->length);
+  context->files = g_new (ThunarFile *, context->length);
+  context->matches = g_new0 (gboolean, context->length);
+  if (context->kind == FILTER_PATTERN)
+    context->names = g_new (const gchar *, context->length);
+
+  row = g_sequence_get_begin_iter (store->rows);
+  for (n = 0; n < context->length; ++n, row = g_sequence_iter_next (row))
+    {
+      context->rows[n] = row;
+      context->files[n] = g_sequence_get (row);
+
+      /* the casefolded names are kept by the files, so they are only
+       * created once and the workers don't allocate anything */
+      if (context->kind != FILTER_PATTERN)
+        continue;
+      if (context->case_sensitive)
+        context->names[n] = thunar_file_get_display_name (context->files[n]);
+      else
+        context->names[n] = thunar_file_get_casefold_name (context->files[n]);
+    }
+
+  n_chunks = CLAMP (g_get_num_processors (), 1, THUNAR_LIST_MODEL_SORT_THREADS);
+  if (context->length < THUNAR_LIST_MODEL_FILTER_MIN || n_chunks == 1)
+    {
+      thunar_list_model_filter_range (context, 0, context->length);
+      return;
+    }
+
+  if (G_UNLIKELY (pool == NULL))
+    pool = g_thread_pool_new (thunar_list_model_filter_worker, NULL, THUNAR_LIST_MODEL_SORT_THREADS, FALSE, NULL);
+
+  g_mutex_init (&context->mutex);
+  g_cond_init (&context->cond);
+  context->n_pending = n_chunks;
+
+  for (n = 0; n < n_chunks; ++n)
+    {
+      task = g_slice_new (FilterTask);
+      task->context = context;
+      task->begin = (guint) (((guint64) context->length * n) / n_chunks);
+      task->end = (guint) (((guint64) context->length * (n + 1)) / n_chunks);
+      g_thread_pool_push (pool, task, NULL);
+    }
+
+  g_mutex_lock (&context->mutex);
+  while (context->n_pending > 0)
+    g_cond_wait (&context->cond, &context->mutex);
+  g_mutex_unlock (&context->mutex);
+
+  g_mutex_clear (&context->mutex);
+  g_cond_clear (&context->cond);
+}
+
+
+
+static void
+thunar_list_model_filter_free (FilterContext *context)
+{
+  g_free (context->rows);
+  g_free (context->files);
+  g_free (context->names);
+  g_free (context->matches);
+}
+
+
+
+static void
+thunar_list_model_sort_rows (ThunarListModel *store)
 {
   GtkTreePath    *path;
   GSequenceIter **old_order;
@@ -1165,10 +2184,28 @@ thunar_list_model_sort (ThunarListModel *store)
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
+  /* a full sort also puts the changed rows in place */
+  g_hash_table_remove_all (store->resort_files);
+  thunar_list_model_rows_changed (store);
+
   length = g_sequence_get_length (store->rows);
   if (G_UNLIKELY (length <= 1))
     return;
 
+  /* large models are sorted in an array, without touching the sequence */
+  if (length >= THUNAR_LIST_MODEL_ARRAY_SORT_MIN)
+    {
+      new_order = g_new (gint, length);
+      thunar_list_model_sort_array (store, new_order, length);
+
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+      gtk_tree_path_free (path);
+
+      g_free (new_order);
+      return;
+    }
+
   /* be sure to not overuse the stack */
   if (G_LIKELY (length < 2000))
     {
@@ -1201,12 +2238,164 @@ thunar_list_model_sort (ThunarListModel *store)
   gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
   gtk_tree_path_free (path);
 
-  /* clean up if we used the heap */
-  if (G_UNLIKELY (length >= 2000))
-    {
-      g_free (old_order);
-      g_free (new_order);
-    }
+  /* clean up if we used the heap */
+  if (G_UNLIKELY (length >= 2000))
+    {
+      g_free (old_order);
+      g_free (new_order);
+    }
+}
+
+
+
+static void
+thunar_list_model_sort (ThunarListModel *store)
+{
+  gint64  trace_time;
+  gchar  *detail;
+
+  trace_time = thunar_trace_begin ();
+  thunar_list_model_sort_rows (store);
+
+  if (THUNAR_TRACE_ENABLED ())
+    {
+      detail = g_strdup_printf ("%d rows", g_sequence_get_length (store->rows));
+      thunar_trace_end (trace_time, "model", "sort", detail);
+      g_free (detail);
+    }
+}
+
+
+
+static gboolean
+thunar_list_model_row_in_order (ThunarListModel *store,
+                                GSequenceIter   *row)
+{
+  GSequenceIter *prev;
+  GSequenceIter *next;
+  ThunarFile    *file = g_sequence_get (row);
+
+  if (!g_sequence_iter_is_begin (row))
+    {
+      prev = g_sequence_iter_prev (row);
+      if (thunar_list_model_cmp_func (g_sequence_get (prev), file, store) > 0)
+        return FALSE;
+    }
+
+  next = g_sequence_iter_next (row);
+  if (!g_sequence_iter_is_end (next)
+      && thunar_list_model_cmp_func (file, g_sequence_get (next), store) > 0)
+    return FALSE;
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_list_model_reposition (ThunarListModel *store,
+                              GSequenceIter   *row)
+{
+  GtkTreePath *path;
+  gint         pos_before;
+  gint         pos_after;
+  gint        *new_order;
+  gint         length;
+  gint         i, j;
+
+  /* move the row to its new position */
+  pos_before = g_sequence_iter_get_position (row);
+  g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
+  pos_after = g_sequence_iter_get_position (row);
+  if (pos_after == pos_before)
+    return;
+
+  thunar_list_model_rows_changed (store);
+
+  /* do swap sorting here since its much faster than a complete sort */
+  length = g_sequence_get_length (store->rows);
+  if (G_LIKELY (length < 2000))
+    new_order = g_newa (gint, length);
+  else
+    new_order = g_new (gint, length);
+
+  /* new_order[newpos] = oldpos */
+  for (i = 0, j = 0; i < length; ++i)
+    {
+      if (G_UNLIKELY (i == pos_after))
+        {
+          new_order[i] = pos_before;
+        }
+      else
+        {
+          if (G_UNLIKELY (j == pos_before))
+            j++;
+          new_order[i] = j++;
+        }
+    }
+
+  /* tell the view about the new item order */
+  path = gtk_tree_path_new_first ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+  gtk_tree_path_free (path);
+
+  /* clean up if we used the heap */
+  if (G_UNLIKELY (length >= 2000))
+    g_free (new_order);
+}
+
+
+
+static void
+thunar_list_model_resort (ThunarListModel *store)
+{
+  GHashTableIter  hash_iter;
+  GSequenceIter  *row;
+  gpointer        file;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  if (store->resort_idle_id != 0)
+    g_source_remove (store->resort_idle_id);
+
+  if (g_hash_table_size (store->resort_files) == 0)
+    return;
+
+  /* after bulk changes a single sort is cheaper than moving every row */
+  if (g_hash_table_size (store->resort_files) > THUNAR_LIST_MODEL_RESORT_THRESHOLD)
+    {
+      thunar_list_model_sort (store);
+      return;
+    }
+
+  g_hash_table_iter_init (&hash_iter, store->resort_files);
+  while (g_hash_table_iter_next (&hash_iter, &file, NULL))
+    {
+      /* the file may have been removed in the meantime */
+      row = g_hash_table_lookup (store->rows_index, file);
+      if (G_LIKELY (row != NULL))
+        thunar_list_model_reposition (store, row);
+    }
+
+  g_hash_table_remove_all (store->resort_files);
+}
+
+
+
+static gboolean
+thunar_list_model_resort_idle (gpointer user_data)
+{
+  thunar_list_model_resort (THUNAR_LIST_MODEL (user_data));
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_list_model_resort_idle_destroy (gpointer user_data)
+{
+  THUNAR_LIST_MODEL (user_data)->resort_idle_id = 0;
 }
 
 
@@ -1217,12 +2406,6 @@ thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
                                 ThunarListModel   *store)
 {
   GSequenceIter *row;
-  GSequenceIter *end;
-  gint           pos_after;
-  gint           pos_before = 0;
-  gint          *new_order;
-  gint           length;
-  gint           i, j;
   GtkTreePath   *path;
   GtkTreeIter    iter;
 
@@ -1230,65 +2413,35 @@ thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
-
-  while (row != end)
-    {
-      if (G_UNLIKELY (g_sequence_get (row) == file))
-        {
-          /* generate the iterator for this row */
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
-
-          _thunar_assert (pos_before == g_sequence_iter_get_position (row));
-
-          /* check if the sorting changed */
-          g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
-          pos_after = g_sequence_iter_get_position (row);
-          if (pos_after != pos_before)
-            {
-              /* do swap sorting here since its much faster than a complete sort */
-              length = g_sequence_get_length (store->rows);
-              if (G_LIKELY (length < 2000))
-                new_order = g_newa (gint, length);
-              else
-                new_order = g_new (gint, length);
-
-              /* new_order[newpos] = oldpos */
-              for (i = 0, j = 0; i < length; ++i)
-                {
-                  if (G_UNLIKELY (i == pos_after))
-                    {
-                      new_order[i] = pos_before;
-                    }
-                  else
-                    {
-                      if (G_UNLIKELY (j == pos_before))
-                        j++;
-                      new_order[i] = j++;
-                    }
-                }
+  row = g_hash_table_lookup (store->rows_index, file);
+  if (G_UNLIKELY (row == NULL))
+    return;
 
-              /* tell the view about the new item order */
-              path = gtk_tree_path_new_first ();
-              gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
-              gtk_tree_path_free (path);
+  /* the sort keys of the file are outdated now */
+  g_object_set_qdata (G_OBJECT (file), thunar_list_model_sort_key_quark, NULL);
 
-              /* clean up if we used the heap */
-              if (G_UNLIKELY (length >= 2000))
-                g_free (new_order);
-            }
+  /* so is what the file added to the totals */
+  store->totals_valid = FALSE;
 
-          /* notify the view that it has to redraw the file */
-          path = gtk_tree_path_new_from_indices (pos_before, -1);
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
-          break;
+  /* a row that is still sorted between its neighbours stays in place,
+   * others are moved in an idle, so a burst of changes can be merged
+   * into a single sort */
+  if (!thunar_list_model_row_in_order (store, row)
+      && !g_hash_table_contains (store->resort_files, file))
+    {
+      g_hash_table_add (store->resort_files, g_object_ref (file));
+      if (store->resort_idle_id == 0)
+        {
+          store->resort_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_list_model_resort_idle,
+                                                   store, thunar_list_model_resort_idle_destroy);
         }
-
-      row = g_sequence_iter_next (row);
-      pos_before++;
     }
+
+  /* notify the view that it has to redraw the file */
+  GTK_TREE_ITER_INIT (iter, store->stamp, row);
+  path = gtk_tree_path_new_from_indices (thunar_list_model_row_position (store, row), -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+  gtk_tree_path_free (path);
 }
 
 
@@ -1325,18 +2478,41 @@ thunar_list_model_folder_error (ThunarFolder    *folder,
 
 
 
+static gint
+thunar_list_model_cmp_array (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  return thunar_list_model_cmp_func (*(ThunarFile **) a, *(ThunarFile **) b, user_data);
+}
+
+
+
 static void
-thunar_list_model_files_added (ThunarFolder    *folder,
-                               GList           *files,
-                               ThunarListModel *store)
+thunar_list_model_insert_files (ThunarListModel *store,
+                                GPtrArray       *files)
 {
   GtkTreePath   *path;
   GtkTreeIter    iter;
   ThunarFile    *file;
   gint          *indices;
   GSequenceIter *row;
-  GList         *lp;
+  GSequenceIter *new_row;
   gboolean       has_handler;
+  gint           position;
+  gint           length;
+  guint          n;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  if (G_UNLIKELY (files->len == 0))
+    return;
+
+  /* the rows must be sorted to find the insert positions */
+  thunar_list_model_resort (store);
+
+  /* sort the batch once, so it can be merged in a single pass */
+  g_ptr_array_sort_with_data (files, thunar_list_model_cmp_array, store);
 
   /* we use a simple trick here to avoid allocating
    * GtkTreePath's again and again, by simply accessing
@@ -1349,37 +2525,96 @@ thunar_list_model_files_added (ThunarFolder    *folder,
   /* check if we have any handlers connected for "row-inserted" */
   has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
 
-  /* process all added files */
-  for (lp = files; lp != NULL; lp = lp->next)
+  length = g_sequence_get_length (store->rows);
+  if (files->len * THUNAR_LIST_MODEL_MERGE_RATIO < (guint) length)
     {
-      /* take a reference on that file */
-      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
-      _thunar_return_if_fail (THUNAR_IS_FILE (file));
-
-      /* check if the file should be hidden */
-      if (!store->show_hidden && thunar_file_is_hidden (file))
-        {
-          store->hidden = g_slist_prepend (store->hidden, file);
-        }
-      else
+      /* only a few files compared to the rows in the model (i.e. a
+       * monitor event), a binary search per file is cheaper than
+       * walking the entire sequence */
+      for (n = 0; n < files->len; ++n)
         {
-          /* insert the file */
-          row = g_sequence_insert_sorted (store->rows, file,
-                                          thunar_list_model_cmp_func, store);
+          file = g_ptr_array_index (files, n);
+          row = g_sequence_insert_sorted (store->rows, file, thunar_list_model_cmp_func, store);
+          g_hash_table_insert (store->rows_index, file, row);
+          thunar_list_model_rows_changed (store);
+          thunar_list_model_totals_update (store, file, 1);
 
           if (has_handler)
             {
-              /* generate an iterator for the new item */
               GTK_TREE_ITER_INIT (iter, store->stamp, row);
-
               indices[0] = g_sequence_iter_get_position (row);
               gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
             }
         }
     }
+  else
+    {
+      /* merge the sorted batch into the rows, the positions are tracked
+       * while walking, so no lookups in the sequence are required. The
+       * rows are announced in ascending order, which keeps the views in
+       * sync with the model, because all rows before the inserted one are
+       * already known to them */
+      row = g_sequence_get_begin_iter (store->rows);
+      for (n = 0, position = 0; n < files->len; ++n, ++position)
+        {
+          file = g_ptr_array_index (files, n);
+
+          /* skip the existing rows that are sorted before the file */
+          while (!g_sequence_iter_is_end (row)
+                 && thunar_list_model_cmp_func (g_sequence_get (row), file, store) <= 0)
+            {
+              row = g_sequence_iter_next (row);
+              position++;
+            }
+
+          new_row = g_sequence_insert_before (row, file);
+          g_hash_table_insert (store->rows_index, file, new_row);
+          thunar_list_model_rows_changed (store);
+          thunar_list_model_totals_update (store, file, 1);
+
+          if (has_handler)
+            {
+              GTK_TREE_ITER_INIT (iter, store->stamp, new_row);
+              indices[0] = position;
+              gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+            }
+        }
+    }
 
   /* release the path */
   gtk_tree_path_free (path);
+}
+
+
+
+static void
+thunar_list_model_files_added (ThunarFolder    *folder,
+                               GList           *files,
+                               ThunarListModel *store)
+{
+  ThunarFile *file;
+  GPtrArray  *visible;
+  GList      *lp;
+
+  visible = g_ptr_array_sized_new (g_list_length (files));
+
+  /* process all added files */
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* take a reference on that file */
+      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
+      _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+      /* check if the file should be hidden */
+      if (!store->show_hidden && thunar_file_is_hidden (file))
+        store->hidden = g_slist_prepend (store->hidden, file);
+      else
+        g_ptr_array_add (visible, file);
+    }
+
+  /* insert the visible files in one go */
+  thunar_list_model_insert_files (store, visible);
+  g_ptr_array_free (visible, TRUE);
 
   /* number of visible files may have changed */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
@@ -1394,46 +2629,28 @@ thunar_list_model_files_removed (ThunarFolder    *folder,
 {
   GList         *lp;
   GSequenceIter *row;
-  GSequenceIter *end;
-  GSequenceIter *next;
   GtkTreePath   *path;
-  gboolean       found;
 
   /* drop all the referenced files from the model */
   for (lp = files; lp != NULL; lp = lp->next)
     {
-      row = g_sequence_get_begin_iter (store->rows);
-      end = g_sequence_get_end_iter (store->rows);
-
-      found = FALSE;
-
-      while (row != end)
+      row = g_hash_table_lookup (store->rows_index, lp->data);
+      if (G_LIKELY (row != NULL))
         {
-          next = g_sequence_iter_next (row);
-
-          if (g_sequence_get (row) == lp->data)
-            {
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-
-              /* remove file from the model */
-              g_sequence_remove (row);
+          /* setup path for "row-deleted" */
+          path = gtk_tree_path_new_from_indices (thunar_list_model_row_position (store, row), -1);
 
-              /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
-
-              /* no need to look in the hidden files */
-              found = TRUE;
-
-              break;
-            }
+          /* remove file from the model */
+          thunar_list_model_totals_update (store, lp->data, -1);
+          g_hash_table_remove (store->rows_index, lp->data);
+          g_sequence_remove (row);
+          thunar_list_model_rows_changed (store);
 
-          row = next;
+          /* notify the view(s) */
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+          gtk_tree_path_free (path);
         }
-
-      /* check if the file was found */
-      if (!found)
+      else
         {
           /* file is hidden */
           _thunar_assert (g_slist_find (store->hidden, lp->data) != NULL);
@@ -1532,50 +2749,141 @@ sort_by_date_deleted (const ThunarFile *a,
 
 
 
-static gint
-sort_by_group (const ThunarFile *a,
-               const ThunarFile *b,
-               gboolean          case_sensitive)
+static void
+sort_key_free (gpointer data)
 {
-  ThunarGroup *group_a;
-  ThunarGroup *group_b;
-  guint32      gid_a;
-  guint32      gid_b;
-  gint         result;
-  const gchar *name_a;
-  const gchar *name_b;
+  SortKey *key = data;
+
+  g_free (key->link_description);
+  g_slice_free (SortKey, key);
+}
+
+
+
+static SortKeyFlags
+sort_key_flags_for_func (ThunarSortFunc sort_func)
+{
+  if (sort_func == sort_by_type)
+    return SORT_KEY_TYPE;
+  else if (sort_func == sort_by_owner)
+    return SORT_KEY_OWNER;
+  else if (sort_func == sort_by_group)
+    return SORT_KEY_GROUP;
+
+  return 0;
+}
+
 
-  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
 
-  group_a = thunar_file_get_group (a);
-  group_b = thunar_file_get_group (b);
+static SortKey *
+sort_key_get (const ThunarFile *file,
+              SortKeyFlags      flags)
+{
+  SortKey     *key;
+  ThunarUser  *user;
+  ThunarGroup *group;
+  const gchar *content_type;
+  gchar       *description;
+  GFileInfo   *info;
 
-  if (group_a != NULL && group_b != NULL)
+  key = g_object_get_qdata (G_OBJECT (file), thunar_list_model_sort_key_quark);
+  if (G_UNLIKELY (key == NULL))
     {
-      name_a = thunar_group_get_name (group_a);
-      name_b = thunar_group_get_name (group_b);
+      key = g_slice_new0 (SortKey);
+      g_object_set_qdata_full (G_OBJECT (file), thunar_list_model_sort_key_quark, key, sort_key_free);
+    }
 
-      if (!case_sensitive)
-        result = strcasecmp (name_a, name_b);
+  if ((flags & SORT_KEY_TYPE) != 0 && (key->flags & SORT_KEY_TYPE) == 0)
+    {
+      /* we alter the description of symlinks here because they are
+       * displayed as "link to ..." in the detailed list view as well */
+      if (thunar_file_is_symlink (file))
+        {
+          key->link_description = g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file));
+          key->description = key->link_description;
+        }
       else
-        result = strcmp (name_a, name_b);
+        {
+          content_type = thunar_file_get_content_type (THUNAR_FILE (file));
+          description = g_content_type_get_description (content_type);
+          key->description = g_intern_string (description);
+          g_free (description);
+        }
+
+      key->flags |= SORT_KEY_TYPE;
     }
-  else
+
+  info = thunar_file_get_info (file);
+
+  if ((flags & SORT_KEY_OWNER) != 0 && (key->flags & SORT_KEY_OWNER) == 0)
     {
-      gid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
-                                                G_FILE_ATTRIBUTE_UNIX_GID);
-      gid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
-                                                G_FILE_ATTRIBUTE_UNIX_GID);
+      user = thunar_file_get_user (file);
+      if (user != NULL)
+        {
+          key->owner = g_intern_string (thunar_user_get_name (user));
+          g_object_unref (user);
+        }
+      if (info != NULL)
+        key->uid = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID);
+
+      key->flags |= SORT_KEY_OWNER;
+    }
+
+  if ((flags & SORT_KEY_GROUP) != 0 && (key->flags & SORT_KEY_GROUP) == 0)
+    {
+      group = thunar_file_get_group (file);
+      if (group != NULL)
+        {
+          key->group = g_intern_string (thunar_group_get_name (group));
+          g_object_unref (group);
+        }
+      if (info != NULL)
+        key->gid = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_GID);
 
-      result = CLAMP ((gint) gid_a - (gint) gid_b, -1, 1);
+      key->flags |= SORT_KEY_GROUP;
     }
 
-  if (group_a != NULL)
-    g_object_unref (group_a);
+  return key;
+}
+
+
+
+static inline gint
+sort_key_compare_names (const gchar *name_a,
+                        const gchar *name_b,
+                        gboolean     case_sensitive)
+{
+  /* interned strings are equal if they are the same */
+  if (name_a == name_b)
+    return 0;
+
+  if (!case_sensitive)
+    return strcasecmp (name_a, name_b);
+  else
+    return strcmp (name_a, name_b);
+}
+
+
+
+static gint
+sort_by_group (const ThunarFile *a,
+               const ThunarFile *b,
+               gboolean          case_sensitive)
+{
+  SortKey *key_a;
+  SortKey *key_b;
+  gint     result;
+
+  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
+    return thunar_file_compare_by_name (a, b, case_sensitive);
 
-  if (group_b != NULL)
-    g_object_unref (group_b);
+  key_a = sort_key_get (a, SORT_KEY_GROUP);
+  key_b = sort_key_get (b, SORT_KEY_GROUP);
+
+  if (key_a->group != NULL && key_b->group != NULL)
+    result = sort_key_compare_names (key_a->group, key_b->group, case_sensitive);
+  else
+    result = CLAMP ((gint) key_a->gid - (gint) key_b->gid, -1, 1);
 
   if (result == 0)
     return thunar_file_compare_by_name (a, b, case_sensitive);
@@ -1602,7 +2910,11 @@ sort_by_mime_type (const ThunarFile *a,
   if (content_type_b == NULL)
     content_type_b = "";
 
-  result = strcasecmp (content_type_a, content_type_b);
+  /* content types are interned, so most equal types are the same string */
+  if (content_type_a == content_type_b)
+    result = 0;
+  else
+    result = strcasecmp (content_type_a, content_type_b);
 
   if (result == 0)
     result = thunar_file_compare_by_name (a, b, case_sensitive);
@@ -1617,40 +2929,21 @@ sort_by_owner (const ThunarFile *a,
                const ThunarFile *b,
                gboolean          case_sensitive)
 {
-  const gchar *name_a;
-  const gchar *name_b;
-  ThunarUser  *user_a;
-  ThunarUser  *user_b;
-  guint32      uid_a;
-  guint32      uid_b;
-  gint         result;
+  SortKey *key_a;
+  SortKey *key_b;
+  gint     result;
 
   if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
     return thunar_file_compare_by_name (a, b, case_sensitive);
 
-  user_a = thunar_file_get_user (a);
-  user_b = thunar_file_get_user (b);
-
-  if (user_a != NULL && user_b != NULL)
-    {
-      /* compare the system names */
-      name_a = thunar_user_get_name (user_a);
-      name_b = thunar_user_get_name (user_b);
+  key_a = sort_key_get (a, SORT_KEY_OWNER);
+  key_b = sort_key_get (b, SORT_KEY_OWNER);
 
-      if (!case_sensitive)
-        result = strcasecmp (name_a, name_b);
-      else
-        result = strcmp (name_a, name_b);
-    }
+  /* compare the system names */
+  if (key_a->owner != NULL && key_b->owner != NULL)
+    result = sort_key_compare_names (key_a->owner, key_b->owner, case_sensitive);
   else
-    {
-      uid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
-                                                G_FILE_ATTRIBUTE_UNIX_UID);
-      uid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
-                                                G_FILE_ATTRIBUTE_UNIX_UID);
-
-      result = CLAMP ((gint) uid_a - (gint) uid_b, -1, 1);
-    }
+    result = CLAMP ((gint) key_a->uid - (gint) key_b->uid, -1, 1);
 
   if (result == 0)
     return thunar_file_compare_by_name (a, b, case_sensitive);
@@ -1717,53 +3010,18 @@ sort_by_type (const ThunarFile *a,
               const ThunarFile *b,
               gboolean          case_sensitive)
 {
-  const gchar *content_type_a;
-  const gchar *content_type_b;
-  gchar       *description_a = NULL;
-  gchar       *description_b = NULL;
-  gint         result;
-
-  /* we alter the description of symlinks here because they are
-   * displayed as "link to ..." in the detailed list view as well */
-
-  if (thunar_file_is_symlink (a))
-    {
-      description_a = g_strdup_printf (_("link to %s"),
-                                       thunar_file_get_symlink_target (a));
-    }
-  else
-    {
-      content_type_a = thunar_file_get_content_type (THUNAR_FILE (a));
-      description_a = g_content_type_get_description (content_type_a);
-    }
+  SortKey *key_a;
+  SortKey *key_b;
+  gint     result;
 
-  if (thunar_file_is_symlink (b))
-    {
-      description_b = g_strdup_printf (_("link to %s"),
-                                       thunar_file_get_symlink_target (b));
-    }
-  else
-    {
-      content_type_b = thunar_file_get_content_type (THUNAR_FILE (b));
-      description_b = g_content_type_get_description (content_type_b);
-    }
+  key_a = sort_key_get (a, SORT_KEY_TYPE);
+  key_b = sort_key_get (b, SORT_KEY_TYPE);
 
   /* avoid calling strcasecmp with NULL parameters */
-  if (description_a == NULL || description_b == NULL)
-    {
-      g_free (description_a);
-      g_free (description_b);
-
-      return 0;
-    }
-
-  if (!case_sensitive)
-    result = strcasecmp (description_a, description_b);
-  else
-    result = strcmp (description_a, description_b);
+  if (key_a->description == NULL || key_b->description == NULL)
+    return 0;
 
-  g_free (description_a);
-  g_free (description_b);
+  result = sort_key_compare_names (key_a->description, key_b->description, case_sensitive);
 
   if (result == 0)
     return thunar_file_compare_by_name (a, b, case_sensitive);
@@ -1882,6 +3140,7 @@ thunar_list_model_set_date_style (ThunarListModel *store,
     {
       /* apply the new setting */
       store->date_style = date_style;
+      g_hash_table_remove_all (store->date_texts);
 
       /* notify listeners */
       g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_STYLE]);
@@ -1929,6 +3188,7 @@ thunar_list_model_set_date_custom_style (ThunarListModel *store,
     {
       /* apply the new setting */
       store->date_custom_style = g_strdup (date_custom_style);
+      g_hash_table_remove_all (store->date_texts);
 
       /* notify listeners */
       g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_CUSTOM_STYLE]);
@@ -1958,10 +3218,119 @@ thunar_list_model_get_folder (ThunarListModel *store)
 
 
 
+static void
+thunar_list_model_siblings_add (ThunarListModel *store)
+{
+  GSList *models;
+
+  if (G_UNLIKELY (list_model_siblings == NULL))
+    list_model_siblings = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  models = g_hash_table_lookup (list_model_siblings, store->folder);
+  g_hash_table_insert (list_model_siblings, store->folder, g_slist_prepend (models, store));
+}
+
+
+
+static void
+thunar_list_model_siblings_remove (ThunarListModel *store)
+{
+  GSList *models;
+
+  models = g_hash_table_lookup (list_model_siblings, store->folder);
+  models = g_slist_remove (models, store);
+  if (models != NULL)
+    g_hash_table_insert (list_model_siblings, store->folder, models);
+  else
+    g_hash_table_remove (list_model_siblings, store->folder);
+}
+
+
+
+/**
+ * thunar_list_model_copy_rows:
+ * @store : a #ThunarListModel whose folder was just set.
+ *
+ * Tabs and panes often show the same folder. If another model shows the
+ * folder of @store with the same order and filter, and all its rows are
+ * in place, its rows are copied into @store. That is a single pass over
+ * the rows, instead of sorting all the files of the folder again.
+ *
+ * Return value: %TRUE if the rows were copied, %FALSE if the files of the
+ *               folder have to be inserted.
+ **/
+static gboolean
+thunar_list_model_copy_rows (ThunarListModel *store)
+{
+  ThunarListModel *sibling = NULL;
+  GtkTreePath     *path;
+  GtkTreeIter      iter;
+  ThunarFile      *file;
+  GSequenceIter   *row;
+  GSequenceIter   *new_row;
+  gboolean         has_handler;
+  GSList          *lp;
+  gint            *indices;
+
+  if (list_model_siblings == NULL)
+    return FALSE;
+
+  for (lp = g_hash_table_lookup (list_model_siblings, store->folder); lp != NULL; lp = lp->next)
+    {
+      sibling = lp->data;
+      if (sibling->sort_func == store->sort_func
+          && sibling->sort_sign == store->sort_sign
+          && sibling->sort_folders_first == store->sort_folders_first
+          && sibling->sort_case_sensitive == store->sort_case_sensitive
+          && sibling->show_hidden == store->show_hidden
+          && g_hash_table_size (sibling->resort_files) == 0)
+        break;
+    }
+
+  if (lp == NULL)
+    return FALSE;
+
+  has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
+
+  /* see thunar_list_model_insert_files() for the path trick */
+  path = gtk_tree_path_new_first ();
+  indices = gtk_tree_path_get_indices (path);
+
+  for (row = g_sequence_get_begin_iter (sibling->rows);
+       !g_sequence_iter_is_end (row);
+       row = g_sequence_iter_next (row))
+    {
+      file = g_object_ref (g_sequence_get (row));
+      new_row = g_sequence_append (store->rows, file);
+      g_hash_table_insert (store->rows_index, file, new_row);
+      thunar_list_model_rows_changed (store);
+      thunar_list_model_totals_update (store, file, 1);
+
+      if (has_handler)
+        {
+          GTK_TREE_ITER_INIT (iter, store->stamp, new_row);
+          indices[0] = g_sequence_iter_get_position (new_row);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+        }
+    }
+
+  gtk_tree_path_free (path);
+
+  for (lp = sibling->hidden; lp != NULL; lp = lp->next)
+    store->hidden = g_slist_prepend (store->hidden, g_object_ref (lp->data));
+
+  return TRUE;
+}
+
+
+
 /**
  * thunar_list_model_set_folder:
  * @store  : a valid #ThunarListModel.
  * @folder : a #ThunarFolder or %NULL.
+ *
+ * Shows the files of @folder in @store. This also removes the files
+ * added with thunar_list_model_add_files().
  **/
 void
 thunar_list_model_set_folder (ThunarListModel *store,
@@ -1973,16 +3342,32 @@ thunar_list_model_set_folder (ThunarListModel *store,
   GSequenceIter *row;
   GSequenceIter *end;
   GSequenceIter *next;
+  GSList        *lp;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (folder == NULL || THUNAR_IS_FOLDER (folder));
 
   /* check if we're not already using that folder */
   if (G_UNLIKELY (store->folder == folder))
-    return;
+    {
+      /* without a folder, the model may still show added files */
+      if (folder != NULL || (g_sequence_is_empty (store->rows) && store->hidden == NULL))
+        return;
+    }
 
-  /* unlink from the previously active folder (if any) */
-  if (G_LIKELY (store->folder != NULL))
+  /* the added files are watched one by one */
+  if (store->folder == NULL)
+    {
+      for (row = g_sequence_get_begin_iter (store->rows);
+           !g_sequence_iter_is_end (row);
+           row = g_sequence_iter_next (row))
+        thunar_file_monitor_unwatch (store->file_monitor, g_sequence_get (row), store);
+      for (lp = store->hidden; lp != NULL; lp = lp->next)
+        thunar_file_monitor_unwatch (store->file_monitor, lp->data, store);
+    }
+
+  /* drop the rows of the previous folder or the added files */
+  if (G_LIKELY (store->folder != NULL || !g_sequence_is_empty (store->rows) || store->hidden != NULL))
     {
       /* check if we have any handlers connected for "row-deleted" */
       has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_deleted_id, 0, FALSE);
@@ -1990,6 +3375,12 @@ thunar_list_model_set_folder (ThunarListModel *store,
       row = g_sequence_get_begin_iter (store->rows);
       end = g_sequence_get_end_iter (store->rows);
 
+      /* forget about the rows and pending moves */
+      g_hash_table_remove_all (store->rows_index);
+      g_hash_table_remove_all (store->resort_files);
+      if (store->resort_idle_id != 0)
+        g_source_remove (store->resort_idle_id);
+
       /* remove existing entries */
       path = gtk_tree_path_new_first ();
       while (row != end)
@@ -1997,6 +3388,7 @@ thunar_list_model_set_folder (ThunarListModel *store,
           /* remove the row from the list */
           next = g_sequence_iter_next (row);
           g_sequence_remove (row);
+          thunar_list_model_rows_changed (store);
           row = next;
 
           /* notify the view(s) if they're actually
@@ -2010,15 +3402,34 @@ thunar_list_model_set_folder (ThunarListModel *store,
       /* remove hidden entries */
       g_slist_free_full (store->hidden, g_object_unref);
       store->hidden = NULL;
+    }
 
-      /* unregister signals and drop the reference */
+  /* unlink from the previously active folder (if any) */
+  if (G_LIKELY (store->folder != NULL))
+    {
+      /* unregister signals and drop the reference, keeping the
+       * folder around for a while in case the user returns */
+      thunar_list_model_siblings_remove (store);
+      thunar_file_monitor_unwatch (store->file_monitor, thunar_folder_get_corresponding_file (store->folder), store);
       g_signal_handlers_disconnect_matched (G_OBJECT (store->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, store);
+      thunar_folder_retain (store->folder);
       g_object_unref (G_OBJECT (store->folder));
     }
 
   /* ... just to be sure! */
   _thunar_assert (g_sequence_get_length (store->rows) == 0);
 
+  /* start counting from scratch */
+  thunar_list_model_totals_reset (store);
+
+  /* forget the free space of the previous folder */
+  if (store->free_space_cancellable != NULL)
+    {
+      g_cancellable_cancel (store->free_space_cancellable);
+      g_clear_object (&store->free_space_cancellable);
+    }
+  store->free_space = 0;
+
 #ifndef NDEBUG
   /* new stamp since the model changed */
   store->stamp = g_random_int ();
@@ -2035,23 +3446,36 @@ thunar_list_model_set_folder (ThunarListModel *store,
     {
       g_object_ref (G_OBJECT (folder));
 
-      /* get the already loaded files */
-      files = thunar_folder_get_files (folder);
+      if (store->show_hidden)
+        thunar_folder_load_hidden (folder);
 
-      /* insert the files */
-      if (files != NULL)
-        thunar_list_model_files_added (folder, files, store);
+      /* insert the already loaded files, unless another model shows
+       * them in the same order already */
+      if (!thunar_list_model_copy_rows (store))
+        {
+          files = thunar_folder_get_files (folder);
+          if (files != NULL)
+            thunar_list_model_files_added (folder, files, store);
+        }
+      thunar_list_model_siblings_add (store);
 
       /* connect signals to the new folder */
       g_signal_connect (G_OBJECT (store->folder), "destroy", G_CALLBACK (thunar_list_model_folder_destroy), store);
       g_signal_connect (G_OBJECT (store->folder), "error", G_CALLBACK (thunar_list_model_folder_error), store);
       g_signal_connect (G_OBJECT (store->folder), "files-added", G_CALLBACK (thunar_list_model_files_added), store);
       g_signal_connect (G_OBJECT (store->folder), "files-removed", G_CALLBACK (thunar_list_model_files_removed), store);
+
+      /* only hear about changes of the files in the folder */
+      thunar_file_monitor_watch (store->file_monitor, thunar_folder_get_corresponding_file (folder),
+                                 THUNAR_FILE_MONITOR_WATCH_CHILDREN,
+                                 (ThunarFileMonitorFunc) thunar_list_model_file_changed,
+                                 NULL, store);
     }
 
   /* notify listeners that we have a new folder */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FOLDER]);
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FREE_SPACE]);
   g_object_thaw_notify (G_OBJECT (store));
 }
 
@@ -2128,13 +3552,13 @@ void
 thunar_list_model_set_show_hidden (ThunarListModel *store,
                                    gboolean         show_hidden)
 {
+  FilterContext  context;
   GtkTreePath   *path;
-  GtkTreeIter    iter;
   ThunarFile    *file;
+  GPtrArray     *files;
   GSList        *lp;
-  GSequenceIter *row;
-  GSequenceIter *next;
-  GSequenceIter *end;
+  gint          *indices;
+  guint          n;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
@@ -2146,21 +3570,17 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
 
   if (store->show_hidden)
     {
-      for (lp = store->hidden; lp != NULL; lp = lp->next)
-        {
-          file = THUNAR_FILE (lp->data);
-
-          /* insert file in the sorted position */
-          row = g_sequence_insert_sorted (store->rows, file,
-                                          thunar_list_model_cmp_func, store);
+      /* the folder did not bother with the hidden files so far */
+      if (store->folder != NULL)
+        thunar_folder_load_hidden (store->folder);
 
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
+      /* merge the hidden files into the rows in one pass */
+      files = g_ptr_array_sized_new (g_slist_length (store->hidden));
+      for (lp = store->hidden; lp != NULL; lp = lp->next)
+        g_ptr_array_add (files, lp->data);
+      thunar_list_model_insert_files (store, files);
+      g_ptr_array_free (files, TRUE);
 
-          /* tell the view about the new row */
-          path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
-        }
       g_slist_free (store->hidden);
       store->hidden = NULL;
     }
@@ -2168,34 +3588,38 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
     {
       _thunar_assert (store->hidden == NULL);
 
-      /* remove all hidden files */
-      row = g_sequence_get_begin_iter (store->rows);
-      end = g_sequence_get_end_iter (store->rows);
+      /* find the hidden files */
+      memset (&context, 0, sizeof (context));
+      context.kind = FILTER_HIDDEN;
+      thunar_list_model_filter (store, &context);
 
-      while (row != end)
+      /* remove them back to front, so the positions of the
+       * rows before are still valid */
+      path = gtk_tree_path_new_first ();
+      indices = gtk_tree_path_get_indices (path);
+      for (n = context.length; n-- > 0;)
         {
-          next = g_sequence_iter_next (row);
-
-          file = g_sequence_get (row);
-          if (thunar_file_is_hidden (file))
-            {
-              /* store file in the list */
-              store->hidden = g_slist_prepend (store->hidden, g_object_ref (file));
+          if (!context.matches[n])
+            continue;
 
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+          file = context.files[n];
 
-              /* remove file from the model */
-              g_sequence_remove (row);
+          /* store file in the list */
+          store->hidden = g_slist_prepend (store->hidden, g_object_ref (file));
 
-              /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
-            }
+          /* remove file from the model */
+          thunar_list_model_totals_update (store, file, -1);
+          g_hash_table_remove (store->rows_index, file);
+          g_sequence_remove (context.rows[n]);
+          thunar_list_model_rows_changed (store);
 
-          row = next;
-          _thunar_assert (end == g_sequence_get_end_iter (store->rows));
+          /* notify the view(s) */
+          indices[0] = n;
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
         }
+      gtk_tree_path_free (path);
+
+      thunar_list_model_filter_free (&context);
     }
 
   /* notify listeners about the new setting */
@@ -2247,6 +3671,7 @@ thunar_list_model_set_file_size_binary (ThunarListModel *store,
     {
       /* apply the new setting */
       store->file_size_binary = file_size_binary;
+      g_hash_table_remove_all (store->size_texts);
 
       /* resort the model with the new setting */
       thunar_list_model_sort (store);
@@ -2287,6 +3712,159 @@ thunar_list_model_get_file (ThunarListModel *store,
 
 
 
+/**
+ * thunar_list_model_peek_file:
+ * @store : a #ThunarListModel.
+ * @iter  : a valid #GtkTreeIter for @store.
+ *
+ * Returns the #ThunarFile referred to by @iter without
+ * taking a reference, for the cell data functions of the
+ * views, which run for every visible cell on every redraw.
+ *
+ * Return value: the #ThunarFile, owned by @store.
+ **/
+ThunarFile*
+thunar_list_model_peek_file (ThunarListModel *store,
+                             GtkTreeIter     *iter)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
+  _thunar_return_val_if_fail (iter->stamp == store->stamp, NULL);
+
+  return g_sequence_get (iter->user_data);
+}
+
+
+
+/**
+ * thunar_list_model_peek_text:
+ * @store  : a #ThunarListModel.
+ * @iter   : a valid #GtkTreeIter for @store.
+ * @column : a text #ThunarColumn.
+ *
+ * Returns the text of @column for the row @iter, like
+ * gtk_tree_model_get() would, but without copying it
+ * into a #GValue first.
+ *
+ * Return value: the text, owned by @store and only valid
+ *               until the next call into @store, or %NULL.
+ **/
+const gchar*
+thunar_list_model_peek_text (ThunarListModel *store,
+                             GtkTreeIter     *iter,
+                             ThunarColumn     column)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
+  _thunar_return_val_if_fail (iter->stamp == store->stamp, NULL);
+  _thunar_return_val_if_fail (column != THUNAR_COLUMN_FILE, NULL);
+
+  return thunar_list_model_get_text (store, g_sequence_get (iter->user_data), column);
+}
+
+
+
+static void
+thunar_list_model_added_file_destroyed (ThunarFileMonitor *file_monitor,
+                                        ThunarFile        *file,
+                                        ThunarListModel   *store)
+{
+  GList files = { file, NULL, NULL };
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  thunar_file_monitor_unwatch (store->file_monitor, file, store);
+  thunar_list_model_files_removed (NULL, &files, store);
+}
+
+
+
+/**
+ * thunar_list_model_add_files:
+ * @store : a #ThunarListModel without folder.
+ * @files : a list of #ThunarFile<!---->s.
+ *
+ * Inserts @files into @store, which shows no folder. This is how the
+ * results of a search are shown. Each file is watched, so it is updated
+ * when it changes and removed when it is deleted. The files are dropped
+ * again by thunar_list_model_set_folder().
+ **/
+void
+thunar_list_model_add_files (ThunarListModel *store,
+                             GList           *files)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (store->folder == NULL);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    thunar_file_monitor_watch (store->file_monitor, lp->data, THUNAR_FILE_MONITOR_WATCH_FILE,
+                               (ThunarFileMonitorFunc) thunar_list_model_file_changed,
+                               (ThunarFileMonitorFunc) thunar_list_model_added_file_destroyed,
+                               store);
+
+  thunar_list_model_files_added (NULL, files, store);
+}
+
+
+
+/**
+ * thunar_list_model_search_equal:
+ * @model       : a #ThunarListModel.
+ * @column      : the search column, ignored.
+ * @key         : the text typed by the user.
+ * @iter        : the row to check.
+ * @search_data : unused.
+ *
+ * The search equal function for the interactive search of the views.
+ * It matches the same rows as the default function of #GtkTreeView on
+ * #THUNAR_COLUMN_NAME, but it uses the casefolded name cached by each
+ * #ThunarFile and only casefolds @key when it changes. So checking a row
+ * allocates nothing, which matters as the row by row search runs for
+ * every key press.
+ *
+ * Return value: %FALSE if the row matches @key, %TRUE otherwise.
+ **/
+gboolean
+thunar_list_model_search_equal (GtkTreeModel *model,
+                                gint          column,
+                                const gchar  *key,
+                                GtkTreeIter  *iter,
+                                gpointer      search_data)
+{
+  ThunarListModel *store = THUNAR_LIST_MODEL (model);
+  gchar           *normalized;
+
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), TRUE);
+  _thunar_return_val_if_fail (iter->stamp == store->stamp, TRUE);
+
+  if (G_UNLIKELY (key == NULL))
+    return TRUE;
+
+  if (store->search_key == NULL || strcmp (store->search_key, key) != 0)
+    {
+      g_free (store->search_key);
+      g_free (store->search_key_casefold);
+      store->search_key = g_strdup (key);
+      store->search_key_casefold = NULL;
+
+      normalized = g_utf8_normalize (key, -1, G_NORMALIZE_ALL);
+      if (G_LIKELY (normalized != NULL))
+        {
+          store->search_key_casefold = g_utf8_casefold (normalized, -1);
+          g_free (normalized);
+        }
+    }
+
+  if (G_UNLIKELY (store->search_key_casefold == NULL))
+    return TRUE;
+
+  return !g_str_has_prefix (thunar_file_get_casefold_name (g_sequence_get (iter->user_data)),
+                            store->search_key_casefold);
+}
+
+
+
 /**
  * thunar_list_model_get_num_files:
  * @store : a #ThunarListModel.
@@ -2327,29 +3905,88 @@ GList*
 thunar_list_model_get_paths_for_files (ThunarListModel *store,
                                        GList           *files)
 {
-  GList         *paths = NULL;
   GSequenceIter *row;
-  GSequenceIter *end;
-  gint           i = 0;
+  GArray        *positions;
+  GList         *paths = NULL;
+  GList         *lp;
+  gint           position;
+  guint          n;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
-
-  /* find the rows for the given files */
-  while (row != end)
+  /* look up the rows of the given files in the index, instead of
+   * searching the list for every row of the model */
+  positions = g_array_new (FALSE, FALSE, sizeof (gint));
+  for (lp = files; lp != NULL; lp = lp->next)
     {
-      if (g_list_find (files, g_sequence_get (row)) != NULL)
+      row = g_hash_table_lookup (store->rows_index, lp->data);
+      if (G_LIKELY (row != NULL))
         {
-          _thunar_assert (i == g_sequence_iter_get_position (row));
-          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
+          position = thunar_list_model_row_position (store, row);
+          g_array_append_val (positions, position);
         }
+    }
 
-      row = g_sequence_iter_next (row);
-      i++;
+  /* return the paths in the order of the rows, like before, and
+   * only once for files mentioned more than once */
+  g_array_sort (positions, thunar_list_model_cmp_positions);
+  for (n = 0; n < positions->len; ++n)
+    {
+      position = g_array_index (positions, gint, n);
+      if (n == 0 || position != g_array_index (positions, gint, n - 1))
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (position, -1));
     }
 
+  g_array_free (positions, TRUE);
+
+  return paths;
+}
+
+
+
+static gint
+thunar_list_model_cmp_positions (gconstpointer a,
+                                 gconstpointer b)
+{
+  return *(const gint *) a - *(const gint *) b;
+}
+
+
+
+/**
+ * thunar_list_model_get_longest_paths:
+ * @store : a #ThunarListModel instance.
+ *
+ * Determines the #GtkTreePath<!---->s of the few rows in @store whose display
+ * names are the longest in bytes. The model keeps track of these rows as
+ * they are inserted, so the details view can measure them to size its
+ * columns, instead of measuring all the rows.
+ *
+ * The caller is responsible to free the returned list using:
+ * <informalexample><programlisting>
+ * g_list_free_full (list, (GDestroyNotify) gtk_tree_path_free);
+ * </programlisting></informalexample>
+ *
+ * Return value: the list of #GtkTreePath<!---->s of the longest names.
+ **/
+GList*
+thunar_list_model_get_longest_paths (ThunarListModel *store)
+{
+  GList *files = NULL;
+  GList *paths;
+  guint  n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
+
+  thunar_list_model_totals_validate (store);
+
+  for (n = 0; n < THUNAR_LIST_MODEL_N_LONGEST; ++n)
+    if (store->totals_longest[n] != NULL)
+      files = g_list_prepend (files, store->totals_longest[n]);
+
+  paths = thunar_list_model_get_paths_for_files (store, files);
+  g_list_free (files);
+
   return paths;
 }
 
@@ -2376,60 +4013,29 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
                                          const gchar     *pattern,
                                          gboolean         case_sensitive)
 {
-  GPatternSpec  *pspec;
-  gchar         *case_folded_pattern;
+  FilterContext  context;
   GList         *paths = NULL;
-  GSequenceIter *row;
-  GSequenceIter *end;
-  ThunarFile    *file;
-  const gchar   *display_name;
-  gchar         *case_folded_display_name;
-  gboolean       name_matched;
-  gint           i = 0;
+  guint          n;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
   _thunar_return_val_if_fail (g_utf8_validate (pattern, -1, NULL), NULL);
 
-  /* compile the pattern */
-  if (case_sensitive)
-    pspec = g_pattern_spec_new (pattern);
-  else
-    {
-      case_folded_pattern = g_utf8_casefold (pattern, strlen (pattern));
-      pspec = g_pattern_spec_new (case_folded_pattern);
-      g_free (case_folded_pattern);
-    }
+  memset (&context, 0, sizeof (context));
+  context.kind = FILTER_PATTERN;
+  context.case_sensitive = case_sensitive;
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
+  /* compile the pattern, literal patterns like "*.log" don't need globbing */
+  context.pattern = thunar_pattern_new (pattern, case_sensitive);
 
   /* find all rows that match the given pattern */
-  while (row != end)
-    {
-      file = g_sequence_get (row);
-      display_name = thunar_file_get_display_name (file);
-
-      if (case_sensitive)
-        name_matched = g_pattern_match_string (pspec, display_name);
-      else
-        {
-          case_folded_display_name = g_utf8_casefold (display_name, strlen (display_name));
-          name_matched = g_pattern_match_string (pspec, case_folded_display_name);
-          g_free (case_folded_display_name);
-        }
-
-      if (name_matched)
-        {
-          _thunar_assert (i == g_sequence_iter_get_position (row));
-          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
-        }
-
-      row = g_sequence_iter_next (row);
-      i++;
-    }
+  thunar_list_model_filter (store, &context);
+  for (n = 0; n < context.length; ++n)
+    if (context.matches[n])
+      paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (n, -1));
 
   /* release the pattern */
-  g_pattern_spec_free (pspec);
+  thunar_pattern_free (context.pattern);
+  thunar_list_model_filter_free (&context);
 
   return paths;
 }
@@ -2437,45 +4043,30 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
 
 
 /**
- * thunar_list_model_get_statusbar_text_for_files:
- * @files                        : list of files for which a text is requested
+ * thunar_list_model_get_statusbar_text_for_totals:
+ * @folder_count                 : the number of folders.
+ * @non_folder_count             : the number of other files.
+ * @size_summary                 : the size of the regular files.
  * @show_file_size_binary_format : weather the file size should be displayed in binary format
  *
- * Generates the statusbar text for the given @files.
+ * Generates the statusbar text for the given totals.
  *
  * The caller is reponsible to free the returned text using
  * g_free() when it's no longer needed.
  *
- * Return value: the statusbar text for @store with the given @files.
+ * Return value: the statusbar text for the given totals.
  **/
 static gchar*
-thunar_list_model_get_statusbar_text_for_files (GList    *files,
-                                                gboolean  show_file_size_binary_format)
+thunar_list_model_get_statusbar_text_for_totals (gint     folder_count,
+                                                 gint     non_folder_count,
+                                                 guint64  size_summary,
+                                                 gboolean show_file_size_binary_format)
 {
-  guint64  size_summary = 0;
-  gint     folder_count = 0;
-  gint     non_folder_count = 0;
-  GList   *lp;
   gchar   *size_string;
   gchar   *text;
   gchar   *folder_text = NULL;
   gchar   *non_folder_text = NULL;
 
-  /* analyze files */
-  for (lp = files; lp != NULL; lp = lp->next)
-    {
-      if (thunar_file_is_directory (lp->data))
-        {
-          folder_count++;
-        }
-      else
-        {
-          non_folder_count++;
-          if (thunar_file_is_regular (lp->data))
-            size_summary += thunar_file_get_size (lp->data);
-        }
-    }
-
   if (non_folder_count > 0)
     {
       size_string = g_format_size_full (size_summary, G_FORMAT_SIZE_LONG_FORMAT | (show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT));
@@ -2514,6 +4105,63 @@ thunar_list_model_get_statusbar_text_for_files (GList    *files,
 
 
 
+static void
+thunar_list_model_free_space_ready (GObject      *object,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  ThunarListModel *store;
+  GError          *error = NULL;
+  guint64          free_space;
+
+  if (!thunar_free_space_query_finish (G_FILE (object), result, &free_space, NULL, &error))
+    {
+      /* the store dropped the query for another folder or is gone */
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_error_free (error);
+          return;
+        }
+
+      g_error_free (error);
+      free_space = 0;
+    }
+
+  store = THUNAR_LIST_MODEL (user_data);
+  g_clear_object (&store->free_space_cancellable);
+
+  if (free_space != store->free_space)
+    {
+      store->free_space = free_space;
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FREE_SPACE]);
+    }
+}
+
+
+
+static void
+thunar_list_model_query_free_space (ThunarListModel *store)
+{
+  ThunarFile *file;
+
+  /* the previous query is still running */
+  if (store->free_space_cancellable != NULL)
+    return;
+
+  file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
+  if (G_UNLIKELY (file == NULL))
+    return;
+
+  /* recent answers are shared by all views on the volume */
+  store->free_space_cancellable = g_cancellable_new ();
+  thunar_free_space_query_async (thunar_file_get_file (file),
+                                 store->free_space_cancellable,
+                                 thunar_list_model_free_space_ready,
+                                 store);
+}
+
+
+
 /**
  * thunar_list_model_get_statusbar_text:
  * @store          : a #ThunarListModel instance.
@@ -2541,7 +4189,9 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
   const gchar       *original_path;
   GtkTreeIter        iter;
   ThunarFile        *file;
-  guint64            size;
+  guint64            size_summary;
+  gint               n_folders;
+  gint               n_files;
   GList             *lp;
   gchar             *absolute_path;
   gchar             *fspace_string;
@@ -2552,12 +4202,9 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
   gint               height;
   gint               width;
   gchar             *description;
-  GSequenceIter     *row;
-  GSequenceIter     *end;
   ThunarPreferences *preferences;
   gboolean           show_image_size;
   gboolean           show_file_size_binary_format;
-  GList             *relevant_files = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
@@ -2565,24 +4212,20 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
 
   if (selected_items == NULL) /* nothing selected */
     {
-      /* build a GList of all files */
-      end = g_sequence_get_end_iter (store->rows);
-      for (row = g_sequence_get_begin_iter (store->rows); row != end; row = g_sequence_iter_next (row))
-        {
-          relevant_files = g_list_append (relevant_files, g_sequence_get (row));
-        }
+      /* the totals of all rows are kept up to date by the model */
+      thunar_list_model_get_totals (store, &n_folders, &n_files, &size_summary);
 
-      /* try to determine a file for the current folder */
-      file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
+      /* refresh the free space in the background, "free-space" is
+       * notified once the volume answered */
+      thunar_list_model_query_free_space (store);
 
-      /* check if we can determine the amount of free space for the volume */
-      if (G_LIKELY (file != NULL
-          && thunar_g_file_get_free_space (thunar_file_get_file (file), &size, NULL)))
+      /* check if we know the amount of free space for the volume */
+      if (G_LIKELY (store->free_space != 0))
         {
-          size_string = thunar_list_model_get_statusbar_text_for_files (relevant_files, show_file_size_binary_format);
+          size_string = thunar_list_model_get_statusbar_text_for_totals (n_folders, n_files, size_summary, show_file_size_binary_format);
 
           /* humanize the free space */
-          fspace_string = g_format_size_full (size, show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+          fspace_string = g_format_size_full (store->free_space, show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
 
           text = g_strdup_printf (_("%s, Free space: %s"), size_string, fspace_string);
 
@@ -2592,9 +4235,8 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
         }
       else
         {
-          text = thunar_list_model_get_statusbar_text_for_files (relevant_files, show_file_size_binary_format);
+          text = thunar_list_model_get_statusbar_text_for_totals (n_folders, n_files, size_summary, show_file_size_binary_format);
         }
-      g_list_free (relevant_files);
     }
   else if (selected_items->next == NULL) /* only one item selected */
     {
@@ -2683,18 +4325,109 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
     }
   else /* more than one item selected */
     {
-      /* build GList of files from selection */
-      for (lp = selected_items; lp != NULL; lp = lp->next)
+      if (g_list_length (selected_items) == (guint) g_sequence_get_length (store->rows))
+        {
+          /* everything is selected, use the totals of all rows */
+          thunar_list_model_get_totals (store, &n_folders, &n_files, &size_summary);
+        }
+      else
         {
-          gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, lp->data);
-          relevant_files = g_list_append (relevant_files, g_sequence_get (iter.user_data));
+          /* sum up the selected files */
+          n_folders = n_files = 0;
+          size_summary = 0;
+          for (lp = selected_items; lp != NULL; lp = lp->next)
+            {
+              gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, lp->data);
+              file = g_sequence_get (iter.user_data);
+              if (thunar_file_is_directory (file))
+                {
+                  ++n_folders;
+                }
+              else
+                {
+                  ++n_files;
+                  if (thunar_file_is_regular (file))
+                    size_summary += thunar_file_get_size (file);
+                }
+            }
         }
 
-      size_string = thunar_list_model_get_statusbar_text_for_files (relevant_files, show_file_size_binary_format);
+      size_string = thunar_list_model_get_statusbar_text_for_totals (n_folders, n_files, size_summary, show_file_size_binary_format);
       text = g_strdup_printf (_("Selection: %s"), size_string);
       g_free (size_string);
-      g_list_free (relevant_files);
     }
 
   return text;
 }
+
+
+
+static guint64
+thunar_list_model_get_texts_memory (GHashTable *texts)
+{
+  GHashTableIter iter;
+  const gchar   *text;
+  guint64        n_bytes = 0;
+
+  g_hash_table_iter_init (&iter, texts);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &text))
+    n_bytes += sizeof (guint64) + 3 * sizeof (gpointer) + strlen (text) + 1;
+
+  return n_bytes;
+}
+
+
+
+/**
+ * thunar_list_model_get_memory:
+ * @n_models : return location for the number of live models.
+ * @n_rows   : return location for the number of their visible and hidden rows.
+ * @n_bytes  : return location for the estimated memory of the models.
+ *
+ * Estimates the memory held by all live #ThunarListModel<!---->s for
+ * their rows, the hidden files, the row indexes and the cached column
+ * texts, without the files themselves.
+ *
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_list_model_get_memory (guint   *n_models,
+                              guint64 *n_rows,
+                              guint64 *n_bytes)
+{
+  ThunarListModel *store;
+  GList           *lp;
+  guint64          rows = 0;
+  guint64          bytes = 0;
+  guint64          n_visible;
+  guint64          n_hidden;
+
+  for (lp = live_models; lp != NULL; lp = lp->next)
+    {
+      store = THUNAR_LIST_MODEL (lp->data);
+
+      n_visible = g_sequence_get_length (store->rows);
+      n_hidden = g_slist_length (store->hidden);
+      rows += n_visible + n_hidden;
+
+      /* a sequence node is five words, a list link two, a table entry two
+       * and a hash, and every row has a slot in the flat row array */
+      bytes += sizeof (ThunarListModel)
+               + n_visible * 5 * sizeof (gpointer)
+               + n_hidden * 2 * sizeof (gpointer)
+               + (g_hash_table_size (store->rows_index) + g_hash_table_size (store->row_positions)
+                  + g_hash_table_size (store->resort_files)) * (2 * sizeof (gpointer) + sizeof (guint))
+               + store->row_array_length * sizeof (gpointer);
+
+      bytes += thunar_list_model_get_texts_memory (store->date_texts);
+      bytes += thunar_list_model_get_texts_memory (store->size_texts);
+      bytes += thunar_list_model_get_texts_memory (store->mode_texts);
+    }
+
+  if (n_models != NULL)
+    *n_models = g_list_length (live_models);
+  if (n_rows != NULL)
+    *n_rows = rows;
+  if (n_bytes != NULL)
+    *n_bytes = bytes;
+}
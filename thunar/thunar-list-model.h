@@ -55,10 +55,23 @@ void             thunar_list_model_set_file_size_binary   (ThunarListModel  *sto
 
 ThunarFile      *thunar_list_model_get_file               (ThunarListModel  *store,
                                                            GtkTreeIter      *iter);
+ThunarFile      *thunar_list_model_peek_file              (ThunarListModel  *store,
+                                                           GtkTreeIter      *iter);
+const gchar     *thunar_list_model_peek_text              (ThunarListModel  *store,
+                                                           GtkTreeIter      *iter,
+                                                           ThunarColumn      column);
+void             thunar_list_model_add_files              (ThunarListModel  *store,
+                                                           GList            *files);
+gboolean         thunar_list_model_search_equal           (GtkTreeModel     *model,
+                                                           gint              column,
+                                                           const gchar      *key,
+                                                           GtkTreeIter      *iter,
+                                                           gpointer          search_data);
 
 
 GList           *thunar_list_model_get_paths_for_files    (ThunarListModel  *store,
                                                            GList            *files);
+GList           *thunar_list_model_get_longest_paths      (ThunarListModel  *store);
 GList           *thunar_list_model_get_paths_for_pattern  (ThunarListModel  *store,
                                                            const gchar      *pattern,
                                                            gboolean          case_sensitive);
@@ -66,6 +79,10 @@ GList           *thunar_list_model_get_paths_for_pattern  (ThunarListModel  *sto
 gchar           *thunar_list_model_get_statusbar_text     (ThunarListModel  *store,
                                                            GList            *selected_items);
 
+void             thunar_list_model_get_memory             (guint            *n_models,
+                                                           guint64          *n_rows,
+                                                           guint64          *n_bytes);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_LIST_MODEL_H__ */
@@ -100,6 +100,12 @@ static GtkWidget     *thunar_location_buttons_make_button                 (Thuna
                                                                            ThunarFile                 *file);
 static void           thunar_location_buttons_remove_1                    (GtkContainer               *container,
                                                                            GtkWidget                  *widget);
+static void           thunar_location_buttons_add_parents                 (ThunarLocationButtons      *buttons,
+                                                                           GList                      *lp);
+static void           thunar_location_buttons_parent_loaded               (GFile                      *location,
+                                                                           ThunarFile                 *file,
+                                                                           GError                     *error,
+                                                                           gpointer                    user_data);
 static gboolean       thunar_location_buttons_draw                        (GtkWidget                  *buttons,
                                                                            cairo_t                    *cr);
 static gboolean       thunar_location_buttons_scroll_timeout              (gpointer                    user_data);
@@ -152,6 +158,9 @@ struct _ThunarLocationButtons
   GList             *first_visible_button;
   GList             *last_visible_button;
 
+  /* the pending lookup of a parent folder, see thunar_location_buttons_add_parents() */
+  GCancellable      *parent_cancellable;
+
   guint              scroll_timeout_id;
 };
 
@@ -306,6 +315,13 @@ thunar_location_buttons_finalize (GObject *object)
   /* release from the current_directory */
   thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (buttons), NULL);
 
+  /* stop looking up a parent folder */
+  if (G_UNLIKELY (buttons->parent_cancellable != NULL))
+    {
+      g_cancellable_cancel (buttons->parent_cancellable);
+      g_object_unref (buttons->parent_cancellable);
+    }
+
   (*G_OBJECT_CLASS (thunar_location_buttons_parent_class)->finalize) (object);
 }
 
@@ -375,9 +391,10 @@ thunar_location_buttons_set_current_directory (ThunarNavigator *navigator,
                                                ThunarFile      *current_directory)
 {
   ThunarLocationButtons *buttons = THUNAR_LOCATION_BUTTONS (navigator);
-  ThunarFile            *file_parent;
-  ThunarFile            *file;
   GtkWidget             *button;
+  GFile                 *gfile;
+  GFile                 *gfile_parent;
+  GList                 *keep;
   GList                 *lp;
 
   _thunar_return_if_fail (current_directory == NULL || THUNAR_IS_FILE (current_directory));
@@ -397,12 +414,40 @@ thunar_location_buttons_set_current_directory (ThunarNavigator *navigator,
         }
     }
 
+  /* stop looking up a parent folder of the previous directory */
+  if (G_UNLIKELY (buttons->parent_cancellable != NULL))
+    {
+      g_cancellable_cancel (buttons->parent_cancellable);
+      g_object_unref (buttons->parent_cancellable);
+      buttons->parent_cancellable = NULL;
+    }
+
+  /* find the deepest button which is an ancestor of the new directory, the
+   * buttons up to the root are kept, so only the new folders are resolved */
+  keep = NULL;
+  if (G_LIKELY (current_directory != NULL))
+    {
+      for (gfile = g_file_get_parent (thunar_file_get_file (current_directory));
+           gfile != NULL && keep == NULL;
+           gfile = gfile_parent)
+        {
+          for (lp = buttons->list; lp != NULL && keep == NULL; lp = lp->next)
+            if (g_file_equal (gfile, thunar_file_get_file (thunar_location_button_get_file (lp->data))))
+              keep = lp;
+
+          gfile_parent = g_file_get_parent (gfile);
+          g_object_unref (gfile);
+        }
+      if (gfile != NULL)
+        g_object_unref (gfile);
+    }
+
   if (G_LIKELY (buttons->current_directory != NULL))
     {
-      /* remove all buttons */
+      /* remove the buttons below the common ancestor */
       g_object_unref (G_OBJECT (buttons->current_directory));
 
-      while (buttons->list != NULL)
+      while (buttons->list != keep)
         gtk_container_remove (GTK_CONTAINER (buttons), buttons->list->data);
 
       /* clear scroll positions and fake root button */
@@ -413,29 +458,25 @@ thunar_location_buttons_set_current_directory (ThunarNavigator *navigator,
 
   buttons->current_directory = current_directory;
 
-  /* regenerate the button list */
+  /* add the buttons for the new folders */
   if (G_LIKELY (current_directory != NULL))
     {
       g_object_ref (G_OBJECT (current_directory));
 
-      /* add the new buttons */
-      for (file = current_directory; file != NULL; file = file_parent)
+      /* the kept buttons are no longer active */
+      for (lp = buttons->list; lp != NULL; lp = lp->next)
         {
-          button = thunar_location_buttons_make_button (buttons, file);
-          buttons->list = g_list_append (buttons->list, button);
-          gtk_container_add (GTK_CONTAINER (buttons), button);
-          gtk_widget_show (button);
-
-          /* use 'Home' as fake root button */
-          if (!buttons->fake_root_button && eglible_for_fake_root (file))
-            buttons->fake_root_button = g_list_last (buttons->list);
+          g_signal_handlers_block_by_func (G_OBJECT (lp->data), thunar_location_buttons_clicked, buttons);
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (lp->data), FALSE);
+          g_signal_handlers_unblock_by_func (G_OBJECT (lp->data), thunar_location_buttons_clicked, buttons);
+        }
 
-          /* continue with the parent (if any) */
-          file_parent = thunar_file_get_parent (file, NULL);
+      button = thunar_location_buttons_make_button (buttons, current_directory);
+      buttons->list = g_list_prepend (buttons->list, button);
+      gtk_container_add (GTK_CONTAINER (buttons), button);
+      gtk_widget_show (button);
 
-          if (G_LIKELY (file != current_directory))
-            g_object_unref (G_OBJECT (file));
-        }
+      thunar_location_buttons_add_parents (buttons, buttons->list);
     }
 
   g_object_notify (G_OBJECT (buttons), "current-directory");
@@ -937,6 +978,111 @@ thunar_location_buttons_make_button (ThunarLocationButtons *buttons,
 
 
 
+/**
+ * thunar_location_buttons_add_parents:
+ * @buttons : a #ThunarLocationButtons.
+ * @lp      : the link of a button in the list of @buttons.
+ *
+ * Adds the buttons for the parent folders of the button at @lp, up to the
+ * next button in the list or the root folder. Folders that are not in the
+ * file cache are looked up asynchronously one after the other, so setting
+ * a new directory never waits for a slow file system.
+ **/
+static void
+thunar_location_buttons_add_parents (ThunarLocationButtons *buttons,
+                                     GList                 *lp)
+{
+  ThunarFile *parent;
+  GtkWidget  *button;
+  GFile      *gfile;
+
+  for (; lp != NULL; lp = lp->next)
+    {
+      gfile = g_file_get_parent (thunar_file_get_file (thunar_location_button_get_file (lp->data)));
+      if (gfile == NULL)
+        break;
+
+      /* stop once the button chain is complete */
+      if (lp->next != NULL
+          && g_file_equal (gfile, thunar_file_get_file (thunar_location_button_get_file (lp->next->data))))
+        {
+          g_object_unref (gfile);
+          break;
+        }
+
+      parent = thunar_file_cache_lookup (gfile);
+      if (parent == NULL)
+        {
+          /* continue once the folder is loaded */
+          buttons->parent_cancellable = g_cancellable_new ();
+          thunar_file_get_async (gfile, buttons->parent_cancellable,
+                                 thunar_location_buttons_parent_loaded, buttons);
+          g_object_unref (gfile);
+          break;
+        }
+      g_object_unref (gfile);
+
+      button = thunar_location_buttons_make_button (buttons, parent);
+      buttons->list = g_list_insert_before (buttons->list, lp->next, button);
+      gtk_container_add (GTK_CONTAINER (buttons), button);
+      gtk_widget_show (button);
+      g_object_unref (parent);
+    }
+
+  /* use 'Home' as fake root button */
+  buttons->fake_root_button = NULL;
+  for (lp = buttons->list; lp != NULL && buttons->fake_root_button == NULL; lp = lp->next)
+    if (eglible_for_fake_root (thunar_location_button_get_file (lp->data)))
+      buttons->fake_root_button = lp;
+}
+
+
+
+static void
+thunar_location_buttons_parent_loaded (GFile      *location,
+                                       ThunarFile *file,
+                                       GError     *error,
+                                       gpointer    user_data)
+{
+  ThunarLocationButtons *buttons = THUNAR_LOCATION_BUTTONS (user_data);
+  GtkWidget             *button;
+  GFile                 *gfile;
+  GList                 *lp;
+
+  /* the buttons may be gone already */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  g_clear_object (&buttons->parent_cancellable);
+
+  /* the button chain ends at a folder that cannot be read */
+  if (error != NULL)
+    return;
+
+  /* insert the button above its child folder */
+  for (lp = buttons->list; lp != NULL; lp = lp->next)
+    {
+      gfile = g_file_get_parent (thunar_file_get_file (thunar_location_button_get_file (lp->data)));
+      if (gfile != NULL && g_file_equal (gfile, location))
+        {
+          g_object_unref (gfile);
+
+          button = thunar_location_buttons_make_button (buttons, file);
+          buttons->list = g_list_insert_before (buttons->list, lp->next, button);
+          gtk_container_add (GTK_CONTAINER (buttons), button);
+          gtk_widget_show (button);
+
+          thunar_location_buttons_add_parents (buttons, lp->next);
+          return;
+        }
+
+      if (gfile != NULL)
+        g_object_unref (gfile);
+    }
+}
+
+
+
 static void
 thunar_location_buttons_remove_1 (GtkContainer *container,
                                   GtkWidget    *widget)
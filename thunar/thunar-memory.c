@@ -0,0 +1,177 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <signal.h>
+
+#include <glib-unix.h>
+
+#include <thunarx/thunarx.h>
+
+#include <thunar/thunar-file.h>
+#include <thunar/thunar-folder.h>
+#include <thunar/thunar-history.h>
+#include <thunar/thunar-icon-factory.h>
+#include <thunar/thunar-list-model.h>
+#include <thunar/thunar-memory.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-user.h>
+
+
+
+/* Estimates of the memory held by the long-lived caches, meant to
+ * find the cache responsible when an instance keeps growing. Every
+ * subsystem is reported as the number of objects, the number of items
+ * they hold and the estimated bytes. The numbers count the structures
+ * and strings Thunar allocates itself, not the allocator overhead, so
+ * they are a lower bound of the real usage.
+ */
+
+
+
+static gboolean thunar_memory_signal (gpointer user_data);
+
+
+
+/**
+ * thunar_memory_get_report:
+ *
+ * Collects the memory estimates of all subsystems as a dictionary of
+ * type a{s(utt)}, which maps the name of a subsystem to its number of
+ * objects, its number of items and its estimated bytes. Must be called
+ * from the main thread.
+ *
+ * Return value: a floating #GVariant with the report.
+ **/
+GVariant*
+thunar_memory_get_report (void)
+{
+  ThunarxProviderFactory *provider_factory;
+  ThunarIconFactory      *icon_factory;
+  ThunarUserManager      *user_manager;
+  GVariantBuilder         builder;
+  guint64                 n_items;
+  guint64                 n_bytes;
+  gsize                   n_icon_bytes;
+  guint                   n_objects;
+  guint                   n_groups;
+  guint                   n_types;
+  guint                   n_modules;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(utt)}"));
+
+  thunar_file_cache_get_memory (&n_objects, &n_items, &n_bytes);
+  g_variant_builder_add (&builder, "{s(utt)}", "files", n_objects, n_items, n_bytes);
+
+  thunar_folder_get_memory (&n_objects, &n_items, &n_bytes);
+  g_variant_builder_add (&builder, "{s(utt)}", "folders", n_objects, n_items, n_bytes);
+
+  thunar_list_model_get_memory (&n_objects, &n_items, &n_bytes);
+  g_variant_builder_add (&builder, "{s(utt)}", "list-models", n_objects, n_items, n_bytes);
+
+  icon_factory = thunar_icon_factory_get_default ();
+  thunar_icon_factory_get_cache_stats (icon_factory, NULL, NULL, NULL, &n_objects, &n_icon_bytes);
+  g_object_unref (icon_factory);
+  g_variant_builder_add (&builder, "{s(utt)}", "icon-cache", 1, (guint64) n_objects, (guint64) n_icon_bytes);
+
+  thunar_icon_factory_get_store_stats (&n_objects, &n_bytes);
+  g_variant_builder_add (&builder, "{s(utt)}", "icon-stores", n_objects, (guint64) n_objects, n_bytes);
+
+  user_manager = thunar_user_manager_get_default ();
+  thunar_user_manager_get_memory (user_manager, &n_objects, &n_groups, &n_bytes);
+  g_object_unref (user_manager);
+  g_variant_builder_add (&builder, "{s(utt)}", "users", n_objects, (guint64) n_groups, n_bytes);
+
+  thunar_history_get_memory (&n_objects, &n_items, &n_bytes);
+  g_variant_builder_add (&builder, "{s(utt)}", "histories", n_objects, n_items, n_bytes);
+
+  /* the providers live in the extension modules, so only their
+   * bookkeeping in the factory is known here */
+  provider_factory = thunarx_provider_factory_get_default ();
+  thunarx_provider_factory_get_stats (provider_factory, &n_types, &n_objects, &n_modules);
+  g_object_unref (provider_factory);
+  g_variant_builder_add (&builder, "{s(utt)}", "providers", n_modules, (guint64) n_objects,
+                         (guint64) n_types * 2 * sizeof (gpointer));
+
+  return g_variant_builder_end (&builder);
+}
+
+
+
+/**
+ * thunar_memory_dump:
+ *
+ * Prints the report of thunar_memory_get_report() to stdout.
+ **/
+void
+thunar_memory_dump (void)
+{
+  GVariantIter  iter;
+  const gchar  *name;
+  GVariant     *report;
+  guint64       n_items;
+  guint64       n_bytes;
+  guint64       total = 0;
+  guint         n_objects;
+
+  report = g_variant_ref_sink (thunar_memory_get_report ());
+
+  g_print ("--- Estimated memory of the Thunar caches:\n");
+
+  g_variant_iter_init (&iter, report);
+  while (g_variant_iter_next (&iter, "{&s(utt)}", &name, &n_objects, &n_items, &n_bytes))
+    {
+      g_print ("    %-12s %8u objects %10" G_GUINT64_FORMAT " items %12" G_GUINT64_FORMAT " bytes\n",
+               name, n_objects, n_items, n_bytes);
+      total += n_bytes;
+    }
+
+  g_print ("    %-12s %40" G_GUINT64_FORMAT " bytes\n\n", "total", total);
+
+  g_variant_unref (report);
+}
+
+
+
+static gboolean
+thunar_memory_signal (gpointer user_data)
+{
+  thunar_memory_dump ();
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+/**
+ * thunar_memory_watch_signal:
+ *
+ * Dumps the memory report with thunar_memory_dump() whenever the
+ * process receives SIGUSR2. Must be called from the main thread and
+ * only once.
+ **/
+void
+thunar_memory_watch_signal (void)
+{
+  g_unix_signal_add (SIGUSR2, thunar_memory_signal, NULL);
+}
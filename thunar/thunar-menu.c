@@ -335,6 +335,15 @@ thunar_menu_add_sections (ThunarMenu         *menu,
          xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (menu));
     }
 
+  if (menu_sections & THUNAR_MENU_SECTION_THUMBNAILS)
+    {
+      item_added = FALSE;
+      item_added |= (thunar_launcher_append_menu_item (menu->launcher, GTK_MENU_SHELL (menu), THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS, FALSE) != NULL);
+      item_added |= (thunar_launcher_append_menu_item (menu->launcher, GTK_MENU_SHELL (menu), THUNAR_LAUNCHER_ACTION_MAKE_THUMBNAILS_RECURSIVE, FALSE) != NULL);
+      if (item_added)
+         xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (menu));
+    }
+
   if (menu_sections & THUNAR_MENU_SECTION_ZOOM)
     {
       window = thunar_launcher_get_widget (menu->launcher);
@@ -0,0 +1,426 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-counters.h>
+#include <thunar/thunar-monitor-pool.h>
+#include <thunar/thunar-preferences.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The directory monitors of the application. Every directory is watched
+ * by a single GFileMonitor that is shared by all its subscribers. Each
+ * monitor costs an inotify watch, and those are limited per user and
+ * shared with all other applications. Beyond the "misc-monitor-budget",
+ * the least recently used directories are polled instead, until they
+ * are used again.
+ *
+ * Everything here may only be used from the main thread.
+ */
+
+
+
+/* the interval in seconds at which directories without a monitor are polled */
+#define THUNAR_MONITOR_POOL_POLL_INTERVAL (10)
+
+
+
+typedef struct
+{
+  GFile        *file;
+
+  /* the shared monitor, %NULL while the directory is polled */
+  GFileMonitor *monitor;
+  guint         poll_id;
+
+  /* the directory cannot be monitored at all */
+  gboolean      unsupported;
+
+  GList        *subscriptions;
+  gint64        last_used;
+}
+ThunarMonitorDirectory;
+
+struct _ThunarMonitorSubscription
+{
+  ThunarMonitorDirectory   *directory;
+  ThunarMonitorPoolFunc     changed_func;
+  ThunarMonitorPoolPollFunc poll_func;
+  gpointer                  user_data;
+};
+
+
+
+static void thunar_monitor_pool_degrade (ThunarMonitorDirectory *directory);
+
+
+
+/* maps a GFile to its ThunarMonitorDirectory */
+static GHashTable *directories = NULL;
+static guint       pool_n_monitored = 0;
+static guint       pool_n_subscriptions = 0;
+static guint       budget = 0;
+
+
+
+static void
+thunar_monitor_pool_budget_changed (ThunarPreferences *preferences)
+{
+  g_object_get (G_OBJECT (preferences), "misc-monitor-budget", &budget, NULL);
+}
+
+
+
+static void
+thunar_monitor_pool_changed (GFileMonitor     *monitor,
+                             GFile            *file,
+                             GFile            *other_file,
+                             GFileMonitorEvent event_type,
+                             gpointer          user_data)
+{
+  ThunarMonitorDirectory    *directory = user_data;
+  ThunarMonitorSubscription *subscription;
+  GList                     *lp;
+  GList                     *next;
+
+  _thunar_return_if_fail (directory->monitor == monitor);
+
+  /* a subscriber may unsubscribe from its callback */
+  for (lp = directory->subscriptions; lp != NULL; lp = next)
+    {
+      next = lp->next;
+      subscription = lp->data;
+      (*subscription->changed_func) (file, other_file, event_type, subscription->user_data);
+    }
+}
+
+
+
+static gboolean
+thunar_monitor_pool_poll (gpointer user_data)
+{
+  ThunarMonitorDirectory    *directory = user_data;
+  ThunarMonitorSubscription *subscription;
+  GList                     *lp;
+  GList                     *next;
+
+  for (lp = directory->subscriptions; lp != NULL; lp = next)
+    {
+      next = lp->next;
+      subscription = lp->data;
+      if (subscription->poll_func != NULL)
+        (*subscription->poll_func) (subscription->user_data);
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_monitor_pool_enforce_budget (ThunarMonitorDirectory *keep)
+{
+  ThunarMonitorDirectory *directory;
+  ThunarMonitorDirectory *oldest;
+  GHashTableIter          iter;
+
+  while (budget > 0 && pool_n_monitored > budget)
+    {
+      /* find the least recently used monitored directory */
+      oldest = NULL;
+      g_hash_table_iter_init (&iter, directories);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer) &directory))
+        if (directory->monitor != NULL && directory != keep
+            && (oldest == NULL || directory->last_used < oldest->last_used))
+          oldest = directory;
+
+      if (G_UNLIKELY (oldest == NULL))
+        break;
+
+      thunar_monitor_pool_degrade (oldest);
+    }
+}
+
+
+
+static void
+thunar_monitor_pool_promote (ThunarMonitorDirectory *directory)
+{
+  GError *error = NULL;
+
+  if (directory->monitor != NULL || directory->unsupported)
+    return;
+
+  directory->monitor = g_file_monitor_directory (directory->file, G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+  if (G_UNLIKELY (directory->monitor == NULL))
+    {
+      g_debug ("Could not create folder monitor: %s", error->message);
+      g_error_free (error);
+
+      /* don't poll what cannot be monitored, like before */
+      directory->unsupported = TRUE;
+      if (directory->poll_id != 0)
+        {
+          g_source_remove (directory->poll_id);
+          directory->poll_id = 0;
+        }
+      return;
+    }
+
+  g_signal_connect (directory->monitor, "changed", G_CALLBACK (thunar_monitor_pool_changed), directory);
+  thunar_counters_inc (THUNAR_COUNTER_MONITORS);
+  pool_n_monitored++;
+
+  if (directory->poll_id != 0)
+    {
+      /* catch up with what changed while the directory was polled */
+      g_source_remove (directory->poll_id);
+      directory->poll_id = 0;
+      thunar_monitor_pool_poll (directory);
+    }
+
+  thunar_monitor_pool_enforce_budget (directory);
+}
+
+
+
+static void
+thunar_monitor_pool_drop_monitor (ThunarMonitorDirectory *directory)
+{
+  if (directory->monitor == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (directory->monitor, thunar_monitor_pool_changed, directory);
+  g_file_monitor_cancel (directory->monitor);
+  g_object_unref (directory->monitor);
+  directory->monitor = NULL;
+  thunar_counters_dec (THUNAR_COUNTER_MONITORS);
+  pool_n_monitored--;
+}
+
+
+
+static void
+thunar_monitor_pool_degrade (ThunarMonitorDirectory *directory)
+{
+  thunar_monitor_pool_drop_monitor (directory);
+
+  if (directory->poll_id == 0)
+    {
+      directory->poll_id = g_timeout_add_seconds (THUNAR_MONITOR_POOL_POLL_INTERVAL,
+                                                  thunar_monitor_pool_poll, directory);
+    }
+}
+
+
+
+static void
+thunar_monitor_pool_directory_free (ThunarMonitorDirectory *directory)
+{
+  thunar_monitor_pool_drop_monitor (directory);
+  if (directory->poll_id != 0)
+    g_source_remove (directory->poll_id);
+
+  g_object_unref (directory->file);
+  g_slice_free (ThunarMonitorDirectory, directory);
+}
+
+
+
+/**
+ * thunar_monitor_pool_subscribe:
+ * @directory    : the #GFile of a directory.
+ * @changed_func : called for the events of the directory monitor.
+ * @poll_func    : called periodically while @directory is polled, or %NULL.
+ * @user_data    : user data for the callbacks.
+ *
+ * Subscribes to the changes of @directory. The directory monitor is
+ * created for the first subscription and shared by all others. If the
+ * monitor budget is exhausted, the least recently used directory is
+ * polled instead: its monitor is released and @poll_func is called
+ * every few seconds, so the subscriber can check for changes itself.
+ *
+ * Return value: the subscription, to be released with
+ *               thunar_monitor_pool_unsubscribe().
+ **/
+ThunarMonitorSubscription *
+thunar_monitor_pool_subscribe (GFile                    *directory,
+                               ThunarMonitorPoolFunc     changed_func,
+                               ThunarMonitorPoolPollFunc poll_func,
+                               gpointer                  user_data)
+{
+  ThunarMonitorSubscription *subscription;
+  ThunarMonitorDirectory    *dir;
+  ThunarPreferences         *preferences;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+  _thunar_return_val_if_fail (changed_func != NULL, NULL);
+
+  if (G_UNLIKELY (directories == NULL))
+    {
+      directories = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+      /* the preferences are kept alive by the application */
+      preferences = thunar_preferences_get ();
+      thunar_monitor_pool_budget_changed (preferences);
+      g_signal_connect (G_OBJECT (preferences), "notify::misc-monitor-budget",
+                        G_CALLBACK (thunar_monitor_pool_budget_changed), NULL);
+      g_object_unref (G_OBJECT (preferences));
+    }
+
+  dir = g_hash_table_lookup (directories, directory);
+  if (dir == NULL)
+    {
+      dir = g_slice_new0 (ThunarMonitorDirectory);
+      dir->file = g_object_ref (directory);
+      g_hash_table_insert (directories, dir->file, dir);
+    }
+
+  subscription = g_slice_new (ThunarMonitorSubscription);
+  subscription->directory = dir;
+  subscription->changed_func = changed_func;
+  subscription->poll_func = poll_func;
+  subscription->user_data = user_data;
+  dir->subscriptions = g_list_prepend (dir->subscriptions, subscription);
+  pool_n_subscriptions++;
+
+  /* a new subscription counts as a use */
+  thunar_monitor_pool_touch (subscription);
+
+  return subscription;
+}
+
+
+
+/**
+ * thunar_monitor_pool_unsubscribe:
+ * @subscription : a #ThunarMonitorSubscription.
+ *
+ * Releases @subscription. The directory monitor is released
+ * with the last subscription of the directory.
+ **/
+void
+thunar_monitor_pool_unsubscribe (ThunarMonitorSubscription *subscription)
+{
+  ThunarMonitorDirectory *directory;
+
+  _thunar_return_if_fail (subscription != NULL);
+
+  directory = subscription->directory;
+  directory->subscriptions = g_list_remove (directory->subscriptions, subscription);
+  g_slice_free (ThunarMonitorSubscription, subscription);
+  pool_n_subscriptions--;
+
+  if (directory->subscriptions == NULL)
+    {
+      g_hash_table_remove (directories, directory->file);
+      thunar_monitor_pool_directory_free (directory);
+    }
+}
+
+
+
+/**
+ * thunar_monitor_pool_touch:
+ * @subscription : a #ThunarMonitorSubscription.
+ *
+ * Marks the directory of @subscription as used, e.g. because it is
+ * shown in a view. A polled directory gets a monitor again, at the
+ * expense of the least recently used directory if necessary.
+ **/
+void
+thunar_monitor_pool_touch (ThunarMonitorSubscription *subscription)
+{
+  _thunar_return_if_fail (subscription != NULL);
+
+  subscription->directory->last_used = g_get_monotonic_time ();
+  thunar_monitor_pool_promote (subscription->directory);
+}
+
+
+
+/**
+ * thunar_monitor_pool_is_monitored:
+ * @subscription : a #ThunarMonitorSubscription.
+ *
+ * Return value: %TRUE if the directory of @subscription has a
+ *               monitor, %FALSE if it is polled or cannot be monitored.
+ **/
+gboolean
+thunar_monitor_pool_is_monitored (ThunarMonitorSubscription *subscription)
+{
+  _thunar_return_val_if_fail (subscription != NULL, FALSE);
+  return (subscription->directory->monitor != NULL);
+}
+
+
+
+/**
+ * thunar_monitor_pool_is_supported:
+ * @subscription : a #ThunarMonitorSubscription.
+ *
+ * Return value: %FALSE if the directory of @subscription cannot be
+ *               monitored at all, %TRUE if it is monitored or polled.
+ **/
+gboolean
+thunar_monitor_pool_is_supported (ThunarMonitorSubscription *subscription)
+{
+  _thunar_return_val_if_fail (subscription != NULL, FALSE);
+  return !subscription->directory->unsupported;
+}
+
+
+
+/**
+ * thunar_monitor_pool_get_stats:
+ * @n_monitored     : return location for the number of monitored directories, or %NULL.
+ * @n_polled        : return location for the number of polled directories, or %NULL.
+ * @n_subscriptions : return location for the number of subscriptions, or %NULL.
+ *
+ * Returns the statistics of the monitor pool for the debug interface.
+ **/
+void
+thunar_monitor_pool_get_stats (guint *n_monitored,
+                               guint *n_polled,
+                               guint *n_subscriptions)
+{
+  ThunarMonitorDirectory *directory;
+  GHashTableIter          iter;
+  guint                   polled = 0;
+
+  if (directories != NULL)
+    {
+      g_hash_table_iter_init (&iter, directories);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer) &directory))
+        if (directory->poll_id != 0)
+          polled++;
+    }
+
+  if (n_monitored != NULL)
+    *n_monitored = pool_n_monitored;
+  if (n_polled != NULL)
+    *n_polled = polled;
+  if (n_subscriptions != NULL)
+    *n_subscriptions = pool_n_subscriptions;
+}
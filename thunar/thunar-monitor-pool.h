@@ -0,0 +1,51 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_MONITOR_POOL_H__
+#define __THUNAR_MONITOR_POOL_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarMonitorSubscription ThunarMonitorSubscription;
+
+typedef void (*ThunarMonitorPoolFunc)     (GFile            *file,
+                                           GFile            *other_file,
+                                           GFileMonitorEvent event_type,
+                                           gpointer          user_data);
+typedef void (*ThunarMonitorPoolPollFunc) (gpointer          user_data);
+
+ThunarMonitorSubscription *thunar_monitor_pool_subscribe    (GFile                     *directory,
+                                                             ThunarMonitorPoolFunc      changed_func,
+                                                             ThunarMonitorPoolPollFunc  poll_func,
+                                                             gpointer                   user_data);
+void                       thunar_monitor_pool_unsubscribe  (ThunarMonitorSubscription *subscription);
+void                       thunar_monitor_pool_touch        (ThunarMonitorSubscription *subscription);
+gboolean                   thunar_monitor_pool_is_monitored (ThunarMonitorSubscription *subscription);
+gboolean                   thunar_monitor_pool_is_supported (ThunarMonitorSubscription *subscription);
+
+void                       thunar_monitor_pool_get_stats    (guint                     *n_monitored,
+                                                             guint                     *n_polled,
+                                                             guint                     *n_subscriptions);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_MONITOR_POOL_H__ */
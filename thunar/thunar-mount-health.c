@@ -0,0 +1,514 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-mount-health.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The mount health keeps the main thread from blocking on network and
+ * FUSE mounts. Queries from the main thread to such a mount run on a
+ * worker thread, while the main thread waits for a limited time only.
+ * Mounts answering late are waited for even shorter.
+ *
+ * A query that does not return in time fails, and the mount is marked
+ * unresponsive. Until the stalled query returns, other queries for the
+ * mount fail right away, so a hanging server only ever takes one thread
+ * and the windows show its locations as unavailable. Queries from other
+ * threads and to local filesystems are not touched.
+ */
+#define MOUNT_HEALTH_SLOW_TIME (G_USEC_PER_SEC)
+#define MOUNT_HEALTH_FAST_TIME (G_USEC_PER_SEC / 10)
+
+
+
+/* Signal identifiers */
+enum
+{
+  CHANGED,
+  LAST_SIGNAL,
+};
+
+
+
+typedef struct _MountHealthMount MountHealthMount;
+typedef struct _MountHealthQuery MountHealthQuery;
+
+
+
+struct _ThunarMountHealthClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarMountHealth
+{
+  GObject     __parent__;
+
+  /* the known mounts by their key, mounts are never removed */
+  GHashTable *mounts;
+};
+
+struct _MountHealthMount
+{
+  ThunarMountState  state;
+
+  /* whether a query did not return in time and is still running */
+  gboolean          stalled;
+};
+
+struct _MountHealthQuery
+{
+  gint                 ref_count;
+
+  /* the request, set before the query starts */
+  GFile               *file;
+  gchar               *attributes;
+  GFileQueryInfoFlags  flags;
+  gboolean             filesystem;
+  GCancellable        *cancellable;
+  gchar               *key;
+
+  /* the result, protected by the mutex */
+  GMutex               mutex;
+  GCond                cond;
+  gboolean             done;
+  GFileInfo           *info;
+  GError              *error;
+
+  /* whether the main thread gave up, only used from the main thread */
+  gboolean             timed_out;
+};
+
+
+
+/* the time the main thread waits, for each state */
+static const gint64 mount_health_timeouts[] =
+{
+  2 * G_USEC_PER_SEC, /* THUNAR_MOUNT_STATE_OK */
+  G_USEC_PER_SEC / 2, /* THUNAR_MOUNT_STATE_SLOW */
+};
+
+static guint              mount_health_signals[LAST_SIGNAL];
+static ThunarMountHealth *mount_health = NULL;
+
+
+
+G_DEFINE_TYPE (ThunarMountHealth, thunar_mount_health, G_TYPE_OBJECT)
+
+
+
+static void
+thunar_mount_health_class_init (ThunarMountHealthClass *klass)
+{
+  /**
+   * ThunarMountHealth::changed:
+   * @health : a #ThunarMountHealth.
+   *
+   * Emitted when the state of a mount changed, so locations
+   * on it may have become (un)available.
+   **/
+  mount_health_signals[CHANGED] =
+    g_signal_new (I_("changed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+}
+
+
+
+static void
+thunar_mount_health_init (ThunarMountHealth *health)
+{
+  health->mounts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+
+
+static ThunarMountHealth *
+thunar_mount_health_get_default (void)
+{
+  /* the states are kept for the lifetime of the process */
+  if (G_UNLIKELY (mount_health == NULL))
+    mount_health = g_object_new (THUNAR_TYPE_MOUNT_HEALTH, NULL);
+
+  return mount_health;
+}
+
+
+
+static MountHealthMount *
+thunar_mount_health_get_mount (GFile    *file,
+                               gboolean  create,
+                               gchar   **key_return)
+{
+  ThunarMountHealth *health = thunar_mount_health_get_default ();
+  MountHealthMount  *mount;
+  gboolean           remote;
+  gchar             *key;
+
+  /* local filesystems are not tracked */
+  key = thunar_g_file_get_mount_key (file, &remote);
+  if (!remote)
+    {
+      g_free (key);
+      return NULL;
+    }
+
+  mount = g_hash_table_lookup (health->mounts, key);
+  if (mount == NULL && create)
+    {
+      mount = g_slice_new0 (MountHealthMount);
+      g_hash_table_insert (health->mounts, g_strdup (key), mount);
+    }
+
+  if (key_return != NULL)
+    *key_return = key;
+  else
+    g_free (key);
+
+  return mount;
+}
+
+
+
+static void
+thunar_mount_health_set_state (MountHealthMount *mount,
+                               ThunarMountState  state)
+{
+  if (mount->state != state)
+    {
+      mount->state = state;
+      g_signal_emit (thunar_mount_health_get_default (), mount_health_signals[CHANGED], 0);
+    }
+}
+
+
+
+static MountHealthQuery *
+thunar_mount_health_query_ref (MountHealthQuery *query)
+{
+  g_atomic_int_inc (&query->ref_count);
+  return query;
+}
+
+
+
+static void
+thunar_mount_health_query_unref (gpointer data)
+{
+  MountHealthQuery *query = data;
+
+  if (g_atomic_int_dec_and_test (&query->ref_count))
+    {
+      g_object_unref (query->file);
+      if (query->cancellable != NULL)
+        g_object_unref (query->cancellable);
+      if (query->info != NULL)
+        g_object_unref (query->info);
+      if (query->error != NULL)
+        g_error_free (query->error);
+      g_free (query->attributes);
+      g_free (query->key);
+      g_mutex_clear (&query->mutex);
+      g_cond_clear (&query->cond);
+      g_slice_free (MountHealthQuery, query);
+    }
+}
+
+
+
+static void
+thunar_mount_health_query_thread (GTask        *task,
+                                  gpointer      source_object,
+                                  gpointer      task_data,
+                                  GCancellable *cancellable)
+{
+  MountHealthQuery *query = task_data;
+  GFileInfo        *info;
+  GError           *error = NULL;
+
+  if (query->filesystem)
+    info = g_file_query_filesystem_info (query->file, query->attributes, query->cancellable, &error);
+  else
+    info = g_file_query_info (query->file, query->attributes, query->flags, query->cancellable, &error);
+
+  /* wake up the main thread if it is still waiting */
+  g_mutex_lock (&query->mutex);
+  query->info = info;
+  query->error = error;
+  query->done = TRUE;
+  g_cond_signal (&query->cond);
+  g_mutex_unlock (&query->mutex);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+
+static void
+thunar_mount_health_query_ready (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  ThunarMountHealth *health = thunar_mount_health_get_default ();
+  MountHealthQuery  *query = user_data;
+  MountHealthMount  *mount;
+
+  /* a stalled query returned, so the mount answers again, but slowly */
+  if (G_UNLIKELY (query->timed_out))
+    {
+      mount = g_hash_table_lookup (health->mounts, query->key);
+      if (G_LIKELY (mount != NULL))
+        {
+          mount->stalled = FALSE;
+          thunar_mount_health_set_state (mount, THUNAR_MOUNT_STATE_SLOW);
+        }
+    }
+
+  thunar_mount_health_query_unref (query);
+}
+
+
+
+static GFileInfo *
+thunar_mount_health_query (GFile               *file,
+                           const gchar         *attributes,
+                           GFileQueryInfoFlags  flags,
+                           gboolean             filesystem,
+                           GCancellable        *cancellable,
+                           GError             **error)
+{
+  MountHealthMount *mount = NULL;
+  MountHealthQuery *query;
+  GFileInfo        *info = NULL;
+  GTask            *task;
+  gint64            start_time;
+  gint64            elapsed;
+  gchar            *key = NULL;
+  gboolean          done;
+
+  /* only the main thread is protected, jobs may block */
+  if (g_main_context_is_owner (g_main_context_default ()))
+    mount = thunar_mount_health_get_mount (file, TRUE, &key);
+
+  if (G_LIKELY (mount == NULL))
+    {
+      if (filesystem)
+        return g_file_query_filesystem_info (file, attributes, cancellable, error);
+      else
+        return g_file_query_info (file, attributes, flags, cancellable, error);
+    }
+
+  /* do not pile up queries on a stalled mount */
+  if (G_UNLIKELY (mount->stalled))
+    {
+      g_free (key);
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                           _("The location is not responding"));
+      return NULL;
+    }
+
+  query = g_slice_new0 (MountHealthQuery);
+  query->ref_count = 1;
+  query->file = g_object_ref (file);
+  query->attributes = g_strdup (attributes);
+  query->flags = flags;
+  query->filesystem = filesystem;
+  query->cancellable = (cancellable != NULL) ? g_object_ref (cancellable) : NULL;
+  query->key = key;
+  g_mutex_init (&query->mutex);
+  g_cond_init (&query->cond);
+
+  /* the ready callback keeps a reference until the query returned */
+  task = g_task_new (NULL, NULL, thunar_mount_health_query_ready, thunar_mount_health_query_ref (query));
+  g_task_set_task_data (task, thunar_mount_health_query_ref (query), thunar_mount_health_query_unref);
+  g_task_run_in_thread (task, thunar_mount_health_query_thread);
+  g_object_unref (task);
+
+  /* wait for the answer, but not longer than the mount deserves */
+  start_time = g_get_monotonic_time ();
+  g_mutex_lock (&query->mutex);
+  while (!query->done)
+    if (!g_cond_wait_until (&query->cond, &query->mutex, start_time + mount_health_timeouts[mount->state]))
+      break;
+  done = query->done;
+  if (done)
+    {
+      info = query->info;
+      query->info = NULL;
+      if (query->error != NULL)
+        {
+          g_propagate_error (error, query->error);
+          query->error = NULL;
+        }
+    }
+  g_mutex_unlock (&query->mutex);
+
+  if (G_LIKELY (done))
+    {
+      /* remember how quickly the mount answered */
+      elapsed = g_get_monotonic_time () - start_time;
+      if (elapsed > MOUNT_HEALTH_SLOW_TIME)
+        thunar_mount_health_set_state (mount, THUNAR_MOUNT_STATE_SLOW);
+      else if (elapsed < MOUNT_HEALTH_FAST_TIME)
+        thunar_mount_health_set_state (mount, THUNAR_MOUNT_STATE_OK);
+    }
+  else
+    {
+      /* the query goes on in the background and revives the mount */
+      query->timed_out = TRUE;
+      mount->stalled = TRUE;
+      thunar_mount_health_set_state (mount, THUNAR_MOUNT_STATE_UNRESPONSIVE);
+
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                           _("The location is not responding"));
+    }
+
+  thunar_mount_health_query_unref (query);
+
+  return info;
+}
+
+
+
+/**
+ * thunar_mount_health_get:
+ *
+ * Returns the #ThunarMountHealth, which emits "changed" whenever
+ * the state of a mount changed.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the #ThunarMountHealth.
+ **/
+ThunarMountHealth *
+thunar_mount_health_get (void)
+{
+  return g_object_ref (thunar_mount_health_get_default ());
+}
+
+
+
+/**
+ * thunar_mount_health_get_state:
+ * @file : a #GFile.
+ *
+ * Returns the state of the mount containing @file, as far as it is
+ * known from previous queries. Local filesystems are always %THUNAR_MOUNT_STATE_OK.
+ * This never blocks and may only be used from the main thread.
+ *
+ * Return value: the #ThunarMountState of the mount of @file.
+ **/
+ThunarMountState
+thunar_mount_health_get_state (GFile *file)
+{
+  MountHealthMount *mount;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), THUNAR_MOUNT_STATE_OK);
+
+  mount = thunar_mount_health_get_mount (file, FALSE, NULL);
+  if (G_LIKELY (mount == NULL))
+    return THUNAR_MOUNT_STATE_OK;
+
+  return mount->state;
+}
+
+
+
+/**
+ * thunar_mount_health_is_available:
+ * @file : a #GFile.
+ *
+ * Returns whether the mount containing @file is not known to be
+ * unresponsive. May only be used from the main thread.
+ *
+ * Return value: %FALSE if the location should be shown as unavailable.
+ **/
+gboolean
+thunar_mount_health_is_available (GFile *file)
+{
+  return thunar_mount_health_get_state (file) != THUNAR_MOUNT_STATE_UNRESPONSIVE;
+}
+
+
+
+/**
+ * thunar_mount_health_query_info:
+ * @file        : a #GFile.
+ * @attributes  : the attributes to query.
+ * @flags       : the #GFileQueryInfoFlags.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Same as g_file_query_info(), but when called from the main thread for
+ * a file on a network or FUSE mount, the query runs on a worker thread
+ * and fails with %G_IO_ERROR_TIMED_OUT if the mount does not answer in
+ * time.
+ *
+ * Return value: the #GFileInfo for @file or %NULL on error.
+ **/
+GFileInfo *
+thunar_mount_health_query_info (GFile               *file,
+                                const gchar         *attributes,
+                                GFileQueryInfoFlags  flags,
+                                GCancellable        *cancellable,
+                                GError             **error)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return thunar_mount_health_query (file, attributes, flags, FALSE, cancellable, error);
+}
+
+
+
+/**
+ * thunar_mount_health_query_filesystem_info:
+ * @file        : a #GFile.
+ * @attributes  : the attributes to query.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Same as thunar_mount_health_query_info() for g_file_query_filesystem_info().
+ *
+ * Return value: the #GFileInfo for the filesystem of @file or %NULL on error.
+ **/
+GFileInfo *
+thunar_mount_health_query_filesystem_info (GFile         *file,
+                                           const gchar   *attributes,
+                                           GCancellable  *cancellable,
+                                           GError       **error)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return thunar_mount_health_query (file, attributes, G_FILE_QUERY_INFO_NONE, TRUE, cancellable, error);
+}
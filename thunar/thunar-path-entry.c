@@ -38,6 +38,7 @@
 
 #include <gdk/gdkkeysyms.h>
 
+#include <thunar/thunar-completion-index.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-icon-renderer.h>
@@ -142,6 +143,14 @@ struct _ThunarPathEntry
   guint              in_change : 1;
   guint              has_completion : 1;
   guint              check_completion_idle_id;
+
+  /* the index of the folder used for completion */
+  ThunarFolder          *completion_folder;
+  ThunarCompletionIndex *completion_index;
+
+  /* the match key for the text the completion was last filtered with */
+  gchar                 *completion_text;
+  gchar                 *completion_key;
 };
 
 
@@ -304,6 +313,12 @@ thunar_path_entry_finalize (GObject *object)
   if (G_UNLIKELY (path_entry->check_completion_idle_id != 0))
     g_source_remove (path_entry->check_completion_idle_id);
 
+  /* release the completion index */
+  if (G_LIKELY (path_entry->completion_folder != NULL))
+    g_object_unref (G_OBJECT (path_entry->completion_folder));
+  g_free (path_entry->completion_text);
+  g_free (path_entry->completion_key);
+
   (*G_OBJECT_CLASS (thunar_path_entry_parent_class)->finalize) (object);
 }
 
@@ -558,6 +573,11 @@ thunar_path_entry_changed (GtkEditable *editable)
   if (G_UNLIKELY (path_entry->in_change))
     return;
 
+  /* a pending completion check was queued for the previous text, a new
+   * one is queued if the user inserted text */
+  if (G_UNLIKELY (path_entry->check_completion_idle_id != 0))
+    g_source_remove (path_entry->check_completion_idle_id);
+
   /* parse the entered string (handling URIs properly) */
   text = gtk_entry_get_text (GTK_ENTRY (path_entry));
   if (G_UNLIKELY (exo_str_looks_like_an_uri (text)))
@@ -623,9 +643,12 @@ thunar_path_entry_changed (GtkEditable *editable)
       gtk_entry_completion_set_model (completion, model);
       g_object_unref (G_OBJECT (model));
 
-      /* cleanup */
-      if (G_LIKELY (folder != NULL))
-        g_object_unref (G_OBJECT (folder));
+      /* use the completion index of the new folder, which keeps
+       * up with the folder while it is still being loaded */
+      if (G_LIKELY (path_entry->completion_folder != NULL))
+        g_object_unref (G_OBJECT (path_entry->completion_folder));
+      path_entry->completion_folder = folder;
+      path_entry->completion_index = (folder != NULL) ? thunar_completion_index_get_for_folder (folder) : NULL;
 
       /* we most likely need a new icon */
       update_icon = TRUE;
@@ -818,45 +841,22 @@ thunar_path_entry_common_prefix_append (ThunarPathEntry *path_entry,
 
 
 
-static gboolean
-thunar_path_entry_has_prefix_casefolded (const gchar *string,
-                                         const gchar *prefix)
-{
-  gchar *string_casefolded;
-  gchar *prefix_casefolded;
-  gboolean has_prefix;
-
-  if (string == NULL || prefix == NULL)
-    return FALSE;
-
-  string_casefolded = g_utf8_casefold (string, -1);
-  prefix_casefolded = g_utf8_casefold (prefix, -1);
-
-  has_prefix = g_str_has_prefix (string_casefolded , prefix_casefolded);
-
-  g_free (string_casefolded);
-  g_free (prefix_casefolded);
-
-  return has_prefix;
-}
-
-
-
 static void
 thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
                                         gchar          **prefix_return,
                                         ThunarFile     **file_return)
 {
-  GtkTreeModel *model;
-  GtkTreeIter   iter;
-  const gchar  *text;
-  const gchar  *s;
-  gchar        *name;
-  gchar        *t;
+  const gchar *text;
+  const gchar *s;
+  gchar       *key;
 
   *prefix_return = NULL;
   *file_return = NULL;
 
+  /* without a folder there is nothing to complete */
+  if (G_UNLIKELY (path_entry->completion_index == NULL))
+    return;
+
   /* lookup the last slash character in the entry text */
   text = gtk_entry_get_text (GTK_ENTRY (path_entry));
   s = strrchr (text, G_DIR_SEPARATOR);
@@ -865,48 +865,10 @@ thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
   else if (G_LIKELY (s != NULL))
     text = s + 1;
 
-  /* check all items in the model */
-  model = gtk_entry_completion_get_model (gtk_entry_get_completion (GTK_ENTRY (path_entry)));
-  if (gtk_tree_model_get_iter_first (model, &iter))
-    {
-      do
-        {
-          /* determine the real file name for the iter */
-          gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
-
-          /* check if we have a valid prefix here */
-          if (thunar_path_entry_has_prefix_casefolded (name, text))
-            {
-              /* check if we're the first to match */
-              if (*prefix_return == NULL)
-                {
-                  /* remember the prefix */
-                  *prefix_return = g_strdup (name);
-
-                  /* determine the file for the iter */
-                  gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE, file_return, -1);
-                }
-              else
-                {
-                  /* we already have another prefix, so determine the common part */
-                  for (s = name, t = *prefix_return; *s != '\0' && *s == *t; ++s, ++t)
-                    ;
-                  *t = '\0';
-
-                  /* release the file, since it's not a unique match */
-                  if (G_LIKELY (*file_return != NULL))
-                    {
-                      g_object_unref (G_OBJECT (*file_return));
-                      *file_return = NULL;
-                    }
-                }
-            }
-
-          /* cleanup */
-          g_free (name);
-        }
-      while (gtk_tree_model_iter_next (model, &iter));
-    }
+  /* find the matching names in the index of the folder */
+  key = thunar_completion_index_make_key (text);
+  *file_return = thunar_completion_index_lookup (path_entry->completion_index, key, prefix_return);
+  g_free (key);
 }
 
 
@@ -920,11 +882,9 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
   GtkTreeModel    *model;
   ThunarPathEntry *path_entry;
   const gchar     *last_slash;
+  const gchar     *text;
   ThunarFile      *file;
   gboolean         matched;
-  gchar           *text_normalized;
-  gchar           *name_normalized;
-  gchar           *name;
 
   /* determine the model from the completion */
   model = gtk_entry_completion_get_model (completion);
@@ -940,45 +900,40 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
   if (G_UNLIKELY (path_entry->has_completion))
     return FALSE;
 
-  /* determine the current text (UTF-8 normalized) */
-  text_normalized = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (user_data)), -1, G_NORMALIZE_ALL);
+  /* this is called for every file in the folder, so the match
+   * key is only determined again if the text changed */
+  text = gtk_entry_get_text (GTK_ENTRY (path_entry));
+  if (g_strcmp0 (text, path_entry->completion_text) != 0)
+    {
+      g_free (path_entry->completion_text);
+      g_free (path_entry->completion_key);
+      path_entry->completion_text = g_strdup (text);
+      path_entry->completion_key = NULL;
+
+      /* lookup the last slash character in the text */
+      last_slash = strrchr (text, G_DIR_SEPARATOR);
+      if (G_LIKELY (last_slash == NULL || last_slash[1] != '\0'))
+        path_entry->completion_key = thunar_completion_index_make_key ((last_slash != NULL) ? last_slash + 1 : text);
+    }
+
+  gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
 
-  /* lookup the last slash character in the key */
-  last_slash = strrchr (text_normalized, G_DIR_SEPARATOR);
-  if (G_UNLIKELY (last_slash != NULL && last_slash[1] == '\0'))
+  if (G_UNLIKELY (path_entry->completion_key == NULL))
     {
       /* check if the file is hidden */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
       matched = !thunar_file_is_hidden (file);
-      g_object_unref (G_OBJECT (file));
     }
-  else
+  else if (G_LIKELY (path_entry->completion_index != NULL))
     {
-      if (G_UNLIKELY (last_slash == NULL))
-        last_slash = text_normalized;
-      else
-        last_slash += 1;
-
-      /* determine the real file name for the iter */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
-      name_normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
-      if (G_LIKELY (name_normalized != NULL))
-        g_free (name);
-      else
-        name_normalized = name;
-
       /* check if we have a match here */
-      if (name_normalized != NULL)
-        matched = thunar_path_entry_has_prefix_casefolded (name_normalized, last_slash);
-      else
-        matched = FALSE;
-
-      /* cleanup */
-      g_free (name_normalized);
+      matched = thunar_completion_index_has_prefix (path_entry->completion_index, file, path_entry->completion_key);
+    }
+  else
+    {
+      matched = FALSE;
     }
 
-  /* cleanup */
-  g_free (text_normalized);
+  g_object_unref (G_OBJECT (file));
 
   return matched;
 }
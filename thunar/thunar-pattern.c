@@ -0,0 +1,267 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-pattern.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* the shape of a compiled pattern, most patterns typed by users are a
+ * literal with wildcards around it, which need no glob matching */
+typedef enum
+{
+  THUNAR_PATTERN_ALL,       /* "*" */
+  THUNAR_PATTERN_EXACT,     /* "name" */
+  THUNAR_PATTERN_PREFIX,    /* "IMG_*" */
+  THUNAR_PATTERN_SUFFIX,    /* "*.log" */
+  THUNAR_PATTERN_SUBSTRING, /* "*name*" */
+  THUNAR_PATTERN_HEAD_TAIL, /* "IMG_*.jpg" */
+  THUNAR_PATTERN_GLOB,      /* anything else */
+} ThunarPatternKind;
+
+struct _ThunarPattern
+{
+  ThunarPatternKind kind;
+
+  /* the literal part, or the head for THUNAR_PATTERN_HEAD_TAIL */
+  gchar            *literal;
+  gsize             literal_len;
+
+  /* the tail for THUNAR_PATTERN_HEAD_TAIL */
+  gchar            *tail;
+  gsize             tail_len;
+
+  /* only for THUNAR_PATTERN_GLOB */
+  GPatternSpec     *spec;
+};
+
+
+
+/**
+ * thunar_pattern_new:
+ * @pattern        : a pattern with the wildcards '*' and '?', like
+ *                   the ones of g_pattern_match_simple().
+ * @case_sensitive : %FALSE to ignore the case.
+ *
+ * Compiles @pattern into a #ThunarPattern. Patterns without '?' and
+ * with at most one '*' between literal text are matched without glob
+ * matching, using the optimized string functions of the C library.
+ *
+ * If @case_sensitive is %FALSE, the strings passed to
+ * thunar_pattern_match() must be casefolded with
+ * thunar_pattern_casefold().
+ *
+ * The caller is responsible to free the returned pattern using
+ * thunar_pattern_free() when no longer needed.
+ *
+ * Return value: the compiled @pattern.
+ **/
+ThunarPattern *
+thunar_pattern_new (const gchar *pattern,
+                    gboolean     case_sensitive)
+{
+  ThunarPattern *compiled;
+  const gchar   *begin;
+  const gchar   *end;
+  const gchar   *star;
+  const gchar   *p;
+  gchar         *folded = NULL;
+  gboolean       leading;
+  gboolean       trailing;
+
+  _thunar_return_val_if_fail (pattern != NULL, NULL);
+
+  if (!case_sensitive)
+    {
+      folded = thunar_pattern_casefold (pattern);
+      if (G_LIKELY (folded != NULL))
+        pattern = folded;
+    }
+
+  compiled = g_slice_new0 (ThunarPattern);
+
+  /* strip the stars at both ends */
+  begin = pattern;
+  end = pattern + strlen (pattern);
+  for (leading = FALSE; *begin == '*'; ++begin)
+    leading = TRUE;
+  for (trailing = FALSE; end > begin && end[-1] == '*'; --end)
+    trailing = TRUE;
+
+  /* find the star in the middle, if there is exactly one run of them */
+  star = memchr (begin, '*', end - begin);
+  if (star != NULL)
+    {
+      for (p = star; *p == '*'; ++p)
+        ;
+      if (memchr (p, '*', end - p) != NULL || leading || trailing)
+        compiled->kind = THUNAR_PATTERN_GLOB;
+      else
+        {
+          compiled->kind = THUNAR_PATTERN_HEAD_TAIL;
+          compiled->literal = g_strndup (begin, star - begin);
+          compiled->literal_len = star - begin;
+          compiled->tail = g_strndup (p, end - p);
+          compiled->tail_len = end - p;
+        }
+    }
+  else if (begin == end)
+    compiled->kind = (leading || trailing) ? THUNAR_PATTERN_ALL : THUNAR_PATTERN_EXACT;
+  else if (leading && trailing)
+    compiled->kind = THUNAR_PATTERN_SUBSTRING;
+  else if (leading)
+    compiled->kind = THUNAR_PATTERN_SUFFIX;
+  else if (trailing)
+    compiled->kind = THUNAR_PATTERN_PREFIX;
+  else
+    compiled->kind = THUNAR_PATTERN_EXACT;
+
+  /* question marks always need the glob matcher */
+  if (memchr (pattern, '?', strlen (pattern)) != NULL)
+    {
+      g_free (compiled->literal);
+      g_free (compiled->tail);
+      compiled->literal = NULL;
+      compiled->tail = NULL;
+      compiled->kind = THUNAR_PATTERN_GLOB;
+    }
+
+  if (compiled->kind == THUNAR_PATTERN_GLOB)
+    compiled->spec = g_pattern_spec_new (pattern);
+  else if (compiled->literal == NULL)
+    {
+      compiled->literal = g_strndup (begin, end - begin);
+      compiled->literal_len = end - begin;
+    }
+
+  g_free (folded);
+
+  return compiled;
+}
+
+
+
+/**
+ * thunar_pattern_free:
+ * @pattern : a #ThunarPattern.
+ *
+ * Frees the resources allocated for @pattern.
+ **/
+void
+thunar_pattern_free (ThunarPattern *pattern)
+{
+  if (G_UNLIKELY (pattern == NULL))
+    return;
+
+  if (pattern->spec != NULL)
+    g_pattern_spec_free (pattern->spec);
+  g_free (pattern->literal);
+  g_free (pattern->tail);
+  g_slice_free (ThunarPattern, pattern);
+}
+
+
+
+/**
+ * thunar_pattern_match:
+ * @pattern : a #ThunarPattern.
+ * @string  : the UTF-8 string to match.
+ *
+ * Checks whether @string matches @pattern. This function does not
+ * change @pattern and may be used from several threads at once.
+ *
+ * Return value: %TRUE if @string matches @pattern.
+ **/
+gboolean
+thunar_pattern_match (const ThunarPattern *pattern,
+                      const gchar         *string)
+{
+  gsize length;
+
+  switch (pattern->kind)
+    {
+    case THUNAR_PATTERN_ALL:
+      return TRUE;
+
+    case THUNAR_PATTERN_EXACT:
+      return strcmp (string, pattern->literal) == 0;
+
+    case THUNAR_PATTERN_PREFIX:
+      return strncmp (string, pattern->literal, pattern->literal_len) == 0;
+
+    case THUNAR_PATTERN_SUFFIX:
+      length = strlen (string);
+      return length >= pattern->literal_len
+          && memcmp (string + length - pattern->literal_len, pattern->literal, pattern->literal_len) == 0;
+
+    case THUNAR_PATTERN_SUBSTRING:
+      return strstr (string, pattern->literal) != NULL;
+
+    case THUNAR_PATTERN_HEAD_TAIL:
+      length = strlen (string);
+      return length >= pattern->literal_len + pattern->tail_len
+          && memcmp (string, pattern->literal, pattern->literal_len) == 0
+          && memcmp (string + length - pattern->tail_len, pattern->tail, pattern->tail_len) == 0;
+
+    case THUNAR_PATTERN_GLOB:
+      return g_pattern_match_string (pattern->spec, string);
+
+    default:
+      _thunar_assert_not_reached ();
+      return FALSE;
+    }
+}
+
+
+
+/**
+ * thunar_pattern_casefold:
+ * @string : a UTF-8 string.
+ *
+ * Normalizes and casefolds @string, the way the names are
+ * compared to case insensitive patterns, and the way
+ * thunar_file_get_casefold_name() folds display names.
+ *
+ * Return value: the folded @string, or %NULL if @string is
+ *               not valid UTF-8. Free with g_free().
+ **/
+gchar *
+thunar_pattern_casefold (const gchar *string)
+{
+  gchar *normalized;
+  gchar *casefold;
+
+  normalized = g_utf8_normalize (string, -1, G_NORMALIZE_ALL);
+  if (G_UNLIKELY (normalized == NULL))
+    return NULL;
+
+  casefold = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return casefold;
+}
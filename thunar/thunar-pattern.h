@@ -0,0 +1,41 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_PATTERN_H__
+#define __THUNAR_PATTERN_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarPattern ThunarPattern;
+
+ThunarPattern *thunar_pattern_new      (const gchar         *pattern,
+                                        gboolean             case_sensitive) G_GNUC_MALLOC;
+void           thunar_pattern_free     (ThunarPattern       *pattern);
+
+gboolean       thunar_pattern_match    (const ThunarPattern *pattern,
+                                        const gchar         *string);
+
+gchar         *thunar_pattern_casefold (const gchar         *string) G_GNUC_MALLOC;
+
+G_END_DECLS
+
+#endif /* !__THUNAR_PATTERN_H__ */
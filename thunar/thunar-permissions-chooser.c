@@ -109,12 +109,17 @@ static void                 thunar_permissions_chooser_job_error        (ThunarP
                                                                          ThunarJob                      *job);
 static void                 thunar_permissions_chooser_job_finished     (ThunarPermissionsChooser       *chooser,
                                                                          ThunarJob                      *job);
+static void                 thunar_permissions_chooser_job_info_message (ThunarPermissionsChooser       *chooser,
+                                                                         const gchar                    *message,
+                                                                         ThunarJob                      *job);
+static void                 thunar_permissions_chooser_job_pause        (ThunarPermissionsChooser       *chooser);
 static void                 thunar_permissions_chooser_job_percent      (ThunarPermissionsChooser       *chooser,
                                                                          gdouble                         percent,
                                                                          ThunarJob                      *job);
 static void                 thunar_permissions_chooser_job_start        (ThunarPermissionsChooser       *chooser,
                                                                          ThunarJob                      *job,
                                                                          gboolean                        recursive);
+static void                 thunar_permissions_chooser_job_unpause      (ThunarPermissionsChooser       *chooser);
 static gboolean             thunar_permissions_chooser_row_separator    (GtkTreeModel                   *model,
                                                                          GtkTreeIter                    *iter,
                                                                          gpointer                        data);
@@ -147,6 +152,8 @@ struct _ThunarPermissionsChooser
   /* job control stuff */
   ThunarJob  *job;
   GtkWidget  *job_progress;
+  GtkWidget  *job_pause_button;
+  GtkWidget  *job_unpause_button;
 };
 
 
@@ -434,11 +441,23 @@ thunar_permissions_chooser_init (ThunarPermissionsChooser *chooser)
 
   chooser->job_progress = gtk_progress_bar_new ();
   gtk_progress_bar_set_text (GTK_PROGRESS_BAR (chooser->job_progress), _("Please wait..."));
+  gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (chooser->job_progress), TRUE);
   g_object_bind_property (G_OBJECT (chooser->job_progress), "visible",
                           G_OBJECT (hbox), "visible",
                           G_BINDING_SYNC_CREATE);
   gtk_box_pack_start (GTK_BOX (hbox), chooser->job_progress, TRUE, TRUE, 0);
 
+  chooser->job_pause_button = gtk_button_new_from_icon_name ("media-playback-pause-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_widget_set_tooltip_text (chooser->job_pause_button, _("Pause applying permissions recursively."));
+  g_signal_connect_swapped (G_OBJECT (chooser->job_pause_button), "clicked", G_CALLBACK (thunar_permissions_chooser_job_pause), chooser);
+  gtk_box_pack_start (GTK_BOX (hbox), chooser->job_pause_button, FALSE, FALSE, 0);
+  gtk_widget_show (chooser->job_pause_button);
+
+  chooser->job_unpause_button = gtk_button_new_from_icon_name ("media-playback-start-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_widget_set_tooltip_text (chooser->job_unpause_button, _("Resume applying permissions recursively."));
+  g_signal_connect_swapped (G_OBJECT (chooser->job_unpause_button), "clicked", G_CALLBACK (thunar_permissions_chooser_job_unpause), chooser);
+  gtk_box_pack_start (GTK_BOX (hbox), chooser->job_unpause_button, FALSE, FALSE, 0);
+
   button = gtk_button_new ();
   gtk_widget_set_tooltip_text (button, _("Stop applying permissions recursively."));
   g_signal_connect_swapped (G_OBJECT (button), "clicked", G_CALLBACK (thunar_permissions_chooser_job_cancel), chooser);
@@ -1254,8 +1273,11 @@ thunar_permissions_chooser_job_cancel (ThunarPermissionsChooser *chooser)
   g_object_unref (G_OBJECT (chooser->job));
   chooser->job = NULL;
 
-  /* hide the progress bar */
+  /* hide the progress bar and reset it for the next job */
   gtk_widget_hide (chooser->job_progress);
+  gtk_widget_hide (chooser->job_unpause_button);
+  gtk_widget_show (chooser->job_pause_button);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (chooser->job_progress), _("Please wait..."));
 
   /* make the remaining widgets sensitive again */
   gtk_widget_set_sensitive (chooser->grid, TRUE);
@@ -1303,6 +1325,54 @@ thunar_permissions_chooser_job_finished (ThunarPermissionsChooser *chooser,
 
 
 
+static void
+thunar_permissions_chooser_job_info_message (ThunarPermissionsChooser *chooser,
+                                             const gchar              *message,
+                                             ThunarJob                *job)
+{
+  _thunar_return_if_fail (THUNAR_IS_PERMISSIONS_CHOOSER (chooser));
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (chooser->job == job);
+
+  /* trees changed while they are walked only report their throughput */
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (chooser->job_progress), message);
+  if (!thunar_job_is_paused (job))
+    gtk_progress_bar_pulse (GTK_PROGRESS_BAR (chooser->job_progress));
+  gtk_widget_show (chooser->job_progress);
+}
+
+
+
+static void
+thunar_permissions_chooser_job_pause (ThunarPermissionsChooser *chooser)
+{
+  _thunar_return_if_fail (THUNAR_IS_PERMISSIONS_CHOOSER (chooser));
+
+  if (G_UNLIKELY (chooser->job == NULL))
+    return;
+
+  thunar_job_pause (chooser->job);
+  gtk_widget_hide (chooser->job_pause_button);
+  gtk_widget_show (chooser->job_unpause_button);
+}
+
+
+
+static void
+thunar_permissions_chooser_job_unpause (ThunarPermissionsChooser *chooser)
+{
+  _thunar_return_if_fail (THUNAR_IS_PERMISSIONS_CHOOSER (chooser));
+
+  if (G_UNLIKELY (chooser->job == NULL))
+    return;
+
+  thunar_job_resume (chooser->job);
+  gtk_widget_hide (chooser->job_unpause_button);
+  gtk_widget_show (chooser->job_pause_button);
+}
+
+
+
 static void
 thunar_permissions_chooser_job_percent (ThunarPermissionsChooser *chooser,
                                         gdouble                   percent,
@@ -1335,7 +1405,10 @@ thunar_permissions_chooser_job_start (ThunarPermissionsChooser *chooser,
 
   /* don't connect percent for single file operations */
   if (G_UNLIKELY (recursive))
-    g_signal_connect_swapped (job, "percent", G_CALLBACK (thunar_permissions_chooser_job_percent), chooser);
+    {
+      g_signal_connect_swapped (job, "info-message", G_CALLBACK (thunar_permissions_chooser_job_info_message), chooser);
+      g_signal_connect_swapped (job, "percent", G_CALLBACK (thunar_permissions_chooser_job_percent), chooser);
+    }
 
   /* setup the progress bar */
   gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (chooser->job_progress), 0.0);
@@ -96,6 +96,9 @@ enum
   PROP_MISC_TEXT_BESIDE_ICONS,
   PROP_MISC_THUMBNAIL_MODE,
   PROP_MISC_THUMBNAIL_DRAW_FRAMES,
+  PROP_MISC_THUMBNAIL_REMOTE_BUDGET,
+  PROP_MISC_THUMBNAIL_REMOTE_MAX_FILE_SIZE,
+  PROP_MISC_THUMBNAIL_REMOTE_PREFER_EMBEDDED,
   PROP_MISC_FILE_SIZE_BINARY,
   PROP_MISC_CONFIRM_CLOSE_MULTIPLE_TABS,
   PROP_MISC_PARALLEL_COPY_MODE,
@@ -105,6 +108,29 @@ enum
   PROP_TREE_ICON_EMBLEMS,
   PROP_TREE_ICON_SIZE,
   PROP_MISC_SWITCH_TO_NEW_TAB,
+  PROP_MISC_FOLDER_SNAPSHOTS,
+  PROP_MISC_TRANSFER_JOBS_PER_DEVICE,
+  PROP_MISC_ICON_CACHE_SIZE,
+  PROP_MISC_MONITOR_EVENT_WINDOW,
+  PROP_MISC_MONITOR_BUDGET,
+  PROP_MISC_SNIFF_VISIBLE_REMOTE_FILES,
+  PROP_MISC_PREFETCH_FOLDERS,
+  PROP_MISC_DAEMON_WINDOW_POOL,
+  PROP_MISC_FIXED_ICON_VIEW_CELLS,
+  PROP_MISC_VERIFY_TRANSFERS,
+  PROP_MISC_TRANSFER_BUFFER_SIZE,
+  PROP_MISC_TRANSFER_PRESERVE_HARD_LINKS,
+  PROP_MISC_TRANSFER_OVERLAP_COLLECTION,
+  PROP_MISC_TRANSFER_RANGE_STREAMS,
+  PROP_MISC_TRANSFER_RANGE_MIN_SIZE,
+  PROP_MISC_TRANSFER_RANGE_MOUNTS,
+  PROP_MISC_TAB_SUSPEND_TIMEOUT,
+  PROP_MISC_SEARCH_INDEX,
+  PROP_MISC_SCAN_EXCLUSIONS,
+  PROP_MISC_SCAN_SAME_FILESYSTEM,
+  PROP_MISC_REMEMBER_DIRECTORY_SIZES,
+  PROP_MISC_HISTORY_DEPTH,
+  PROP_MISC_MENU_PROVIDER_BUDGET,
   N_PROPERTIES,
 };
 
@@ -124,6 +150,10 @@ static void     thunar_preferences_prop_changed       (XfconfChannel          *c
                                                        const GValue           *value,
                                                        ThunarPreferences      *preferences);
 static void     thunar_preferences_load_rc_file       (ThunarPreferences      *preferences);
+static void     thunar_preferences_load_values        (ThunarPreferences      *preferences);
+static gboolean thunar_preferences_store_value        (ThunarPreferences      *preferences,
+                                                       guint                   prop_id,
+                                                       const GValue           *src);
 
 
 
@@ -139,6 +169,11 @@ struct _ThunarPreferences
   XfconfChannel *channel;
 
   gulong         property_changed_id;
+
+  /* the values of all properties, loaded at once from the channel
+   * and kept up to date, protected by the lock */
+  GValue         values[N_PROPERTIES];
+  GMutex         lock;
 };
 
 
@@ -767,6 +802,50 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-thumbnail-remote-budget:
+   *
+   * The number of KiB per second the thumbnailer may read from one
+   * remote share when "misc-thumbnail-mode" is
+   * %THUNAR_THUMBNAIL_MODE_BUDGETED, or 0 for no limit.
+   **/
+  preferences_props[PROP_MISC_THUMBNAIL_REMOTE_BUDGET] =
+      g_param_spec_uint ("misc-thumbnail-remote-budget",
+                         "MiscThumbnailRemoteBudget",
+                         NULL,
+                         0u, G_MAXUINT, 1024u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-thumbnail-remote-max-file-size:
+   *
+   * The size in KiB of the largest remote file that is thumbnailed when
+   * "misc-thumbnail-mode" is %THUNAR_THUMBNAIL_MODE_BUDGETED, or 0 for
+   * no limit. Files with an embedded preview are not limited if
+   * "misc-thumbnail-remote-prefer-embedded" is %TRUE.
+   **/
+  preferences_props[PROP_MISC_THUMBNAIL_REMOTE_MAX_FILE_SIZE] =
+      g_param_spec_uint ("misc-thumbnail-remote-max-file-size",
+                         "MiscThumbnailRemoteMaxFileSize",
+                         NULL,
+                         0u, G_MAXUINT, 16384u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-thumbnail-remote-prefer-embedded:
+   *
+   * Whether remote files that usually carry an embedded preview, like
+   * JPEG and camera raw images with EXIF thumbnails, are thumbnailed
+   * regardless of their size when "misc-thumbnail-mode" is
+   * %THUNAR_THUMBNAIL_MODE_BUDGETED, since only their preview is read.
+   **/
+  preferences_props[PROP_MISC_THUMBNAIL_REMOTE_PREFER_EMBEDDED] =
+      g_param_spec_boolean ("misc-thumbnail-remote-prefer-embedded",
+                            "MiscThumbnailRemotePreferEmbedded",
+                            NULL,
+                            TRUE,
+                            EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-file-size-binary:
    *
@@ -883,6 +962,326 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             TRUE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-folder-snapshots:
+   *
+   * Whether to keep a snapshot of large folders in the cache directory,
+   * so their contents are shown instantly when the folder is opened again,
+   * while the folder is read in the background.
+   **/
+  preferences_props[PROP_MISC_FOLDER_SNAPSHOTS] =
+      g_param_spec_boolean ("misc-folder-snapshots",
+                            "MiscFolderSnapshots",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-jobs-per-device:
+   *
+   * The number of transfer jobs that may run at the same time on a device
+   * which is not copied to in parallel, see misc-parallel-copy-mode.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_JOBS_PER_DEVICE] =
+      g_param_spec_uint ("misc-transfer-jobs-per-device",
+                         "MiscTransferJobsPerDevice",
+                         NULL,
+                         1u, G_MAXUINT, 1u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-icon-cache-size:
+   *
+   * The memory in MiB the icon factory may use for cached icons and
+   * thumbnails before it drops the least recently used ones.
+   **/
+  preferences_props[PROP_MISC_ICON_CACHE_SIZE] =
+      g_param_spec_uint ("misc-icon-cache-size",
+                         "MiscIconCacheSize",
+                         NULL,
+                         1u, G_MAXUINT, 128u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-monitor-event-window:
+   *
+   * The time in milliseconds during which file monitor events of a folder
+   * are collected and merged before they are handled, or 0 to handle
+   * every event right away.
+   **/
+  preferences_props[PROP_MISC_MONITOR_EVENT_WINDOW] =
+      g_param_spec_uint ("misc-monitor-event-window",
+                         "MiscMonitorEventWindow",
+                         NULL,
+                         0u, 10000u, 100u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-monitor-budget:
+   *
+   * The number of directories that are watched with a file monitor at
+   * most, or 0 for no limit. Beyond that, the least recently used
+   * directories are checked for changes every few seconds instead.
+   **/
+  preferences_props[PROP_MISC_MONITOR_BUDGET] =
+      g_param_spec_uint ("misc-monitor-budget",
+                         "MiscMonitorBudget",
+                         NULL,
+                         0u, G_MAXUINT, 1024u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-sniff-visible-remote-files:
+   *
+   * On network and FUSE filesystems, content types are guessed from the
+   * file names. If %TRUE, the contents of the visible files are read
+   * when their names are not enough, else they are never read.
+   **/
+  preferences_props[PROP_MISC_SNIFF_VISIBLE_REMOTE_FILES] =
+      g_param_spec_boolean ("misc-sniff-visible-remote-files",
+                            "MiscSniffVisibleRemoteFiles",
+                            NULL,
+                            TRUE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-prefetch-folders:
+   *
+   * Whether the folders the user is likely to open next, like the
+   * neighbours in the history or a hovered folder, are loaded in
+   * the background.
+   **/
+  preferences_props[PROP_MISC_PREFETCH_FOLDERS] =
+      g_param_spec_boolean ("misc-prefetch-folders",
+                            "MiscPrefetchFolders",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-daemon-window-pool:
+   *
+   * The number of hidden windows that are kept ready in daemon mode,
+   * so opening a folder only has to show one of them.
+   **/
+  preferences_props[PROP_MISC_DAEMON_WINDOW_POOL] =
+      g_param_spec_uint ("misc-daemon-window-pool",
+                         "MiscDaemonWindowPool",
+                         NULL,
+                         0u, 2u, 1u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-fixed-icon-view-cells:
+   *
+   * Whether the icon and compact views give all items cells of the
+   * same size, so large folders are laid out without measuring every
+   * file name. Names that do not fit are ellipsized.
+   **/
+  preferences_props[PROP_MISC_FIXED_ICON_VIEW_CELLS] =
+      g_param_spec_boolean ("misc-fixed-icon-view-cells",
+                            "MiscFixedIconViewCells",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-verify-transfers:
+   *
+   * Whether copied files are read back after copying and compared
+   * with a checksum of the source data, which is computed while the
+   * file is copied.
+   **/
+  preferences_props[PROP_MISC_VERIFY_TRANSFERS] =
+      g_param_spec_boolean ("misc-verify-transfers",
+                            "MiscVerifyTransfers",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-buffer-size:
+   *
+   * The number of MiB which may be read ahead of the target when files
+   * are copied in blocks, for example to removable devices.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_BUFFER_SIZE] =
+      g_param_spec_uint ("misc-transfer-buffer-size",
+                         "MiscTransferBufferSize",
+                         NULL,
+                         2u, 1024u, 16u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-preserve-hard-links:
+   *
+   * Whether files with several hard links inside a copied folder are
+   * copied once and linked again at the target, instead of copying
+   * the data for every link.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_PRESERVE_HARD_LINKS] =
+      g_param_spec_boolean ("misc-transfer-preserve-hard-links",
+                            "MiscTransferPreserveHardLinks",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-overlap-collection:
+   *
+   * Whether copies from remote or FUSE filesystems already start while
+   * the source files are still being collected, instead of counting
+   * all of them first.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_OVERLAP_COLLECTION] =
+      g_param_spec_boolean ("misc-transfer-overlap-collection",
+                            "MiscTransferOverlapCollection",
+                            NULL,
+                            TRUE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-range-streams:
+   *
+   * The number of streams used at the same time to copy a large file
+   * from a remote location, each copying other ranges of the file. 1
+   * copies every file with a single stream.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_RANGE_STREAMS] =
+      g_param_spec_uint ("misc-transfer-range-streams",
+                         "MiscTransferRangeStreams",
+                         NULL,
+                         1u, 16u, 1u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-range-min-size:
+   *
+   * The size in MiB from which remote files are copied with several
+   * streams, see #ThunarPreferences:misc-transfer-range-streams.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_RANGE_MIN_SIZE] =
+      g_param_spec_uint ("misc-transfer-range-min-size",
+                         "MiscTransferRangeMinSize",
+                         NULL,
+                         1u, G_MAXUINT, 256u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-range-mounts:
+   *
+   * List of "URI=STREAMS[,MIN-SIZE]" entries which override the range
+   * streams and their minimum file size for the files below the URI,
+   * e.g. "sftp://server/=8,64". The longest matching URI is used.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_RANGE_MOUNTS] =
+      g_param_spec_boxed ("misc-transfer-range-mounts",
+                          NULL,
+                          NULL,
+                          G_TYPE_STRV,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-tab-suspend-timeout:
+   *
+   * The number of seconds after which the folder of a background tab
+   * is released, or 0 to keep all tabs loaded. Suspended tabs keep
+   * their location, scroll position and selection, and load the
+   * folder again when they are selected.
+   **/
+  preferences_props[PROP_MISC_TAB_SUSPEND_TIMEOUT] =
+      g_param_spec_uint ("misc-tab-suspend-timeout",
+                         "MiscTabSuspendTimeout",
+                         NULL,
+                         0u, G_MAXUINT, 0u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-index:
+   *
+   * Whether searches on mounts, like network shares, use an index of
+   * the file names on the mount, which is kept in the cache directory
+   * and built in the background the first time a mount is searched.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX] =
+      g_param_spec_boolean ("misc-search-index",
+                            "MiscSearchIndex",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-scan-exclusions:
+   *
+   * List of folder name patterns, like "node_modules" or ".snapshot",
+   * which are not entered when searching and when counting the size of
+   * folders. The patterns support the wildcards '*' and '?' and are
+   * case sensitive. Copying, deleting and changing permissions always
+   * include all the files.
+   **/
+  preferences_props[PROP_MISC_SCAN_EXCLUSIONS] =
+      g_param_spec_boxed ("misc-scan-exclusions",
+                          NULL,
+                          NULL,
+                          G_TYPE_STRV,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-scan-same-filesystem:
+   *
+   * Whether searches stay on the filesystem of the folder they start
+   * in and skip the mounts below it. Folder sizes are always counted
+   * on a single filesystem.
+   **/
+  preferences_props[PROP_MISC_SCAN_SAME_FILESYSTEM] =
+      g_param_spec_boolean ("misc-scan-same-filesystem",
+                            "MiscScanSameFilesystem",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-remember-directory-sizes:
+   *
+   * Whether the contents counted for folder sizes are kept in the cache
+   * directory, so unchanged folders are not walked again in the next
+   * session. Files rewritten in place while Thunar is not running are
+   * only noticed once their folder changes. Takes effect on restart.
+   **/
+  preferences_props[PROP_MISC_REMEMBER_DIRECTORY_SIZES] =
+      g_param_spec_boolean ("misc-remember-directory-sizes",
+                            "MiscRememberDirectorySizes",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-history-depth:
+   *
+   * The number of folders each tab remembers for going back and
+   * forward, or 0 to remember all visited folders.
+   **/
+  preferences_props[PROP_MISC_HISTORY_DEPTH] =
+      g_param_spec_uint ("misc-history-depth",
+                         "MiscHistoryDepth",
+                         NULL,
+                         0u, G_MAXUINT, 100u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-menu-provider-budget:
+   *
+   * The time in milliseconds an extension may take to add its items
+   * to an open context menu before they are dropped, or 0 to wait as
+   * long as the menu is shown.
+   **/
+  preferences_props[PROP_MISC_MENU_PROVIDER_BUDGET] =
+      g_param_spec_uint ("misc-menu-provider-budget",
+                         "MiscMenuProviderBudget",
+                         NULL,
+                         0u, G_MAXUINT, 500u,
+                         EXO_PARAM_READWRITE);
+
   /* install all properties */
   g_object_class_install_properties (gobject_class, N_PROPERTIES, preferences_props);
 }
@@ -912,6 +1311,10 @@ thunar_preferences_init (ThunarPreferences *preferences)
         xfconf_channel_set_string (preferences->channel, check_prop, "ThunarIconView");
     }
 
+  /* fetch all the values at once, instead of a query per property */
+  g_mutex_init (&preferences->lock);
+  thunar_preferences_load_values (preferences);
+
   preferences->property_changed_id =
     g_signal_connect (G_OBJECT (preferences->channel), "property-changed",
                       G_CALLBACK (thunar_preferences_prop_changed), preferences);
@@ -923,10 +1326,23 @@ static void
 thunar_preferences_finalize (GObject *object)
 {
   ThunarPreferences *preferences = THUNAR_PREFERENCES (object);
+  guint              prop_id;
+
+  /* nothing was loaded without a channel */
+  if (G_UNLIKELY (preferences->channel == NULL))
+    {
+      (*G_OBJECT_CLASS (thunar_preferences_parent_class)->finalize) (object);
+      return;
+    }
 
   /* disconnect from the updates */
   g_signal_handler_disconnect (preferences->channel, preferences->property_changed_id);
 
+  /* release the values */
+  for (prop_id = 1; prop_id < N_PROPERTIES; prop_id++)
+    g_value_unset (&preferences->values[prop_id]);
+  g_mutex_clear (&preferences->lock);
+
   (*G_OBJECT_CLASS (thunar_preferences_parent_class)->finalize) (object);
 }
 
@@ -938,10 +1354,7 @@ thunar_preferences_get_property (GObject    *object,
                                  GValue     *value,
                                  GParamSpec *pspec)
 {
-  ThunarPreferences  *preferences = THUNAR_PREFERENCES (object);
-  GValue              src = { 0, };
-  gchar               prop_name[64];
-  gchar             **array;
+  ThunarPreferences *preferences = THUNAR_PREFERENCES (object);
 
   /* only set defaults if channel is not set */
   if (G_UNLIKELY (preferences->channel == NULL))
@@ -950,28 +1363,10 @@ thunar_preferences_get_property (GObject    *object,
       return;
     }
 
-  /* build property name */
-  g_snprintf (prop_name, sizeof (prop_name), "/%s", g_param_spec_get_name (pspec));
-
-  if (G_VALUE_TYPE (value) == G_TYPE_STRV)
-    {
-      /* handle arrays directly since we cannot transform those */
-      array = xfconf_channel_get_string_list (preferences->channel, prop_name);
-      g_value_take_boxed (value, array);
-    }
-  else if (xfconf_channel_get_property (preferences->channel, prop_name, &src))
-    {
-      if (G_VALUE_TYPE (value) == G_VALUE_TYPE (&src))
-        g_value_copy (&src, value);
-      else if (!g_value_transform (&src, value))
-        g_printerr ("Thunar: Failed to transform property %s\n", prop_name);
-      g_value_unset (&src);
-    }
-  else
-    {
-      /* value is not found, return default */
-      g_param_value_set_default (pspec, value);
-    }
+  /* the value is always loaded */
+  g_mutex_lock (&preferences->lock);
+  g_value_copy (&preferences->values[prop_id], value);
+  g_mutex_unlock (&preferences->lock);
 }
 
 
@@ -1022,6 +1417,9 @@ thunar_preferences_set_property (GObject      *object,
 
   /* thaw */
   g_signal_handler_unblock (preferences->channel, preferences->property_changed_id);
+
+  /* remember the new value */
+  thunar_preferences_store_value (preferences, prop_id, value);
 }
 
 
@@ -1034,14 +1432,94 @@ thunar_preferences_prop_changed (XfconfChannel     *channel,
 {
   GParamSpec *pspec;
 
-  /* check if the property exists and emit change */
+  /* check if the property exists, a reset property has no value */
   pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (preferences), prop_name + 1);
-  if (G_LIKELY (pspec != NULL))
+  if (G_UNLIKELY (pspec == NULL))
+    return;
+
+  /* only the bindings and handlers connected to this property are
+   * notified, and only if the value really changed */
+  if (thunar_preferences_store_value (preferences, pspec->param_id, G_IS_VALUE (value) ? value : NULL))
     g_object_notify_by_pspec (G_OBJECT (preferences), pspec);
 }
 
 
 
+static void
+thunar_preferences_load_values (ThunarPreferences *preferences)
+{
+  GHashTable   *properties;
+  const GValue *src;
+  gchar         prop_name[64];
+  guint         prop_id;
+
+  /* a single round trip to the settings daemon */
+  properties = xfconf_channel_get_properties (preferences->channel, NULL);
+
+  for (prop_id = 1; prop_id < N_PROPERTIES; prop_id++)
+    {
+      g_snprintf (prop_name, sizeof (prop_name), "/%s", g_param_spec_get_name (preferences_props[prop_id]));
+      src = (properties != NULL) ? g_hash_table_lookup (properties, prop_name) : NULL;
+      thunar_preferences_store_value (preferences, prop_id, src);
+    }
+
+  if (G_LIKELY (properties != NULL))
+    g_hash_table_destroy (properties);
+}
+
+
+
+static gboolean
+thunar_preferences_store_value (ThunarPreferences *preferences,
+                                guint              prop_id,
+                                const GValue      *src)
+{
+  GParamSpec  *pspec = preferences_props[prop_id];
+  GPtrArray   *array;
+  GValue      *cached = &preferences->values[prop_id];
+  GValue       value = G_VALUE_INIT;
+  gchar      **strv;
+  gboolean     changed;
+  guint        n;
+
+  g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+
+  if (src == NULL)
+    {
+      /* value is not found, use the default */
+      g_param_value_set_default (pspec, &value);
+    }
+  else if (G_VALUE_TYPE (&value) == G_TYPE_STRV && G_VALUE_HOLDS (src, XFCONF_TYPE_G_VALUE_ARRAY))
+    {
+      /* xfconf stores string lists as arrays of values */
+      array = g_value_get_boxed (src);
+      strv = g_new0 (gchar *, (array != NULL ? array->len : 0) + 1);
+      for (n = 0; array != NULL && n < array->len; n++)
+        strv[n] = g_value_dup_string (g_ptr_array_index (array, n));
+      g_value_take_boxed (&value, strv);
+    }
+  else if (G_VALUE_TYPE (&value) == G_VALUE_TYPE (src))
+    {
+      g_value_copy (src, &value);
+    }
+  else if (!g_value_transform (src, &value))
+    {
+      g_printerr ("Thunar: Failed to transform property %s\n", g_param_spec_get_name (pspec));
+      g_param_value_set_default (pspec, &value);
+    }
+
+  g_mutex_lock (&preferences->lock);
+  changed = !G_IS_VALUE (cached) || g_param_values_cmp (pspec, &value, cached) != 0;
+  if (G_IS_VALUE (cached))
+    g_value_unset (cached);
+  *cached = value;
+  g_mutex_unlock (&preferences->lock);
+
+  return changed;
+}
+
+
+
 static void
 thunar_preferences_load_rc_file (ThunarPreferences *preferences)
 {
@@ -29,18 +29,25 @@
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-progress-dialog.h>
 #include <thunar/thunar-progress-view.h>
+#include <thunar/thunar-scheduler.h>
 #include <thunar/thunar-transfer-job.h>
 
 
 
 #define SCROLLVIEW_THRESHOLD 5
 
+/* the interval in milliseconds to update the summary of the jobs */
+#define SUMMARY_INTERVAL 1000
+
 
 
 static void     thunar_progress_dialog_dispose            (GObject              *object);
 static void     thunar_progress_dialog_finalize           (GObject              *object);
 static gboolean thunar_progress_dialog_closed             (ThunarProgressDialog *dialog);
 static gint     thunar_progress_dialog_n_views            (ThunarProgressDialog *dialog);
+static void     thunar_progress_dialog_update_queue       (ThunarProgressDialog *dialog);
+static gboolean thunar_progress_dialog_update_summary     (gpointer              user_data);
+static void     thunar_progress_dialog_summary_done       (gpointer              user_data);
 
 
 
@@ -57,6 +64,14 @@ struct _ThunarProgressDialog
   GtkWidget     *vbox;
   GtkWidget     *content_box;
 
+  /* the totals of all jobs, shown once there are many of them */
+  GtkWidget     *summary_label;
+  guint          summary_timer_id;
+
+  /* the views of the waiting jobs, collapsed by default */
+  GtkWidget     *queue_expander;
+  GtkWidget     *queue_box;
+
   /* List of running views, type ThunarProgressView */
   GList         *views;
   /* List of waiting views, type ThunarProgressView */
@@ -107,10 +122,27 @@ thunar_progress_dialog_init (ThunarProgressDialog *dialog)
   gtk_container_add (GTK_CONTAINER (dialog), dialog->vbox);
   gtk_widget_show (dialog->vbox);
 
+  dialog->summary_label = g_object_new (GTK_TYPE_LABEL, "xalign", 0.0f, NULL);
+  gtk_label_set_ellipsize (GTK_LABEL (dialog->summary_label), PANGO_ELLIPSIZE_END);
+  gtk_widget_set_margin_start (dialog->summary_label, 12);
+  gtk_widget_set_margin_end (dialog->summary_label, 12);
+  gtk_widget_set_margin_top (dialog->summary_label, 12);
+  gtk_box_pack_start (GTK_BOX (dialog->vbox), dialog->summary_label, FALSE, FALSE, 0);
+
   dialog->content_box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 12);
   gtk_container_set_border_width (GTK_CONTAINER (dialog->content_box), 12);
   gtk_container_add (GTK_CONTAINER (dialog->vbox), dialog->content_box);
   gtk_widget_show (dialog->content_box);
+
+  /* the views in a collapsed expander are not mapped, so they are
+   * neither drawn nor updated until the user looks at them */
+  dialog->queue_expander = gtk_expander_new (NULL);
+  gtk_box_pack_end (GTK_BOX (dialog->content_box), dialog->queue_expander, FALSE, TRUE, 0);
+
+  dialog->queue_box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 12);
+  gtk_widget_set_margin_top (dialog->queue_box, 12);
+  gtk_container_add (GTK_CONTAINER (dialog->queue_expander), dialog->queue_box);
+  gtk_widget_show (dialog->queue_box);
 }
 
 
@@ -118,6 +150,12 @@ thunar_progress_dialog_init (ThunarProgressDialog *dialog)
 static void
 thunar_progress_dialog_dispose (GObject *object)
 {
+  ThunarProgressDialog *dialog = THUNAR_PROGRESS_DIALOG (object);
+
+  /* stop updating the summary */
+  if (G_UNLIKELY (dialog->summary_timer_id != 0))
+    thunar_scheduler_remove (dialog->summary_timer_id);
+
   (*G_OBJECT_CLASS (thunar_progress_dialog_parent_class)->dispose) (object);
 }
 
@@ -167,6 +205,139 @@ thunar_progress_dialog_n_views (ThunarProgressDialog *dialog)
 
 
 
+static void
+thunar_progress_dialog_update_queue (ThunarProgressDialog *dialog)
+{
+  guint  n_waiting;
+  gchar *text;
+
+  /* tell how many jobs are waiting */
+  n_waiting = g_list_length (dialog->views_waiting);
+  if (n_waiting > 0)
+    {
+      text = g_strdup_printf (ngettext ("%u queued operation", "%u queued operations", n_waiting), n_waiting);
+      gtk_expander_set_label (GTK_EXPANDER (dialog->queue_expander), text);
+      gtk_widget_show (dialog->queue_expander);
+      g_free (text);
+    }
+  else
+    {
+      gtk_widget_hide (dialog->queue_expander);
+    }
+
+  /* summarize the jobs once there are too many to look at each */
+  if (thunar_progress_dialog_n_views (dialog) >= SCROLLVIEW_THRESHOLD)
+    {
+      if (dialog->summary_timer_id == 0)
+        {
+          thunar_progress_dialog_update_summary (dialog);
+          dialog->summary_timer_id = thunar_scheduler_add_timeout (G_PRIORITY_LOW, SUMMARY_INTERVAL,
+                                                                   thunar_progress_dialog_update_summary, dialog,
+                                                                   thunar_progress_dialog_summary_done);
+        }
+      gtk_widget_show (dialog->summary_label);
+    }
+  else
+    {
+      if (dialog->summary_timer_id != 0)
+        thunar_scheduler_remove (dialog->summary_timer_id);
+      gtk_widget_hide (dialog->summary_label);
+    }
+}
+
+
+
+static gboolean
+thunar_progress_dialog_update_summary (gpointer user_data)
+{
+  ThunarProgressDialog *dialog = THUNAR_PROGRESS_DIALOG (user_data);
+  ThunarJob            *job;
+  GList                *lp;
+  guint64               total_rate = 0;
+  guint64               total_size;
+  guint64               total_progress;
+  guint64               transfer_rate;
+  guint                 n_files_total;
+  guint                 n_files_done;
+  guint                 n_running = 0;
+  guint                 n_queued;
+  gchar                *rate_str;
+  gchar                *text;
+
+  /* the frozen jobs wait for their device like the queued ones */
+  n_queued = g_list_length (dialog->views_waiting);
+  for (lp = dialog->views; lp != NULL; lp = lp->next)
+    {
+      job = thunar_progress_view_get_job (THUNAR_PROGRESS_VIEW (lp->data));
+      if (job == NULL || exo_job_is_cancelled (EXO_JOB (job)))
+        continue;
+
+      if (thunar_job_is_frozen (job))
+        {
+          n_queued++;
+          continue;
+        }
+
+      n_running++;
+
+      if (THUNAR_IS_TRANSFER_JOB (job) && !thunar_job_is_paused (job))
+        {
+          thunar_transfer_job_get_progress (THUNAR_TRANSFER_JOB (job), &total_size, &total_progress,
+                                            &transfer_rate, &n_files_total, &n_files_done);
+          total_rate += transfer_rate;
+        }
+    }
+
+  if (total_rate > 0)
+    {
+      rate_str = g_format_size (total_rate);
+      /* TRANSLATORS: the number of running and queued file operations, and their combined speed */
+      text = g_strdup_printf (_("%u running, %u queued, %s/s"), n_running, n_queued, rate_str);
+      g_free (rate_str);
+    }
+  else
+    {
+      /* TRANSLATORS: the number of running and queued file operations */
+      text = g_strdup_printf (_("%u running, %u queued"), n_running, n_queued);
+    }
+
+  gtk_label_set_text (GTK_LABEL (dialog->summary_label), text);
+  g_free (text);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_progress_dialog_summary_done (gpointer user_data)
+{
+  THUNAR_PROGRESS_DIALOG (user_data)->summary_timer_id = 0;
+}
+
+
+
+static void
+thunar_progress_dialog_start_view (ThunarProgressDialog *dialog,
+                                   GList                *view_lp)
+{
+  GtkWidget *view = view_lp->data;
+
+  /* move the view to the running list */
+  dialog->views_waiting = g_list_remove_link (dialog->views_waiting, view_lp);
+  dialog->views         = g_list_concat (view_lp, dialog->views);
+
+  /* show it with the other running views */
+  g_object_ref (view);
+  gtk_container_remove (GTK_CONTAINER (dialog->queue_box), view);
+  gtk_box_pack_start (GTK_BOX (dialog->content_box), view, FALSE, TRUE, 0);
+  g_object_unref (view);
+
+  thunar_progress_view_launch_job (THUNAR_PROGRESS_VIEW (view));
+}
+
+
+
 static void
 thunar_progress_dialog_view_needs_attention (ThunarProgressDialog *dialog,
                                              ThunarProgressView   *view)
@@ -195,9 +366,8 @@ thunar_progress_dialog_launch_view (ThunarProgressDialog *dialog,
   view_lp = g_list_find (dialog->views_waiting, view);
   if (view_lp != NULL)
     {
-      dialog->views_waiting = g_list_remove_link (dialog->views_waiting, view_lp);
-      dialog->views         = g_list_concat (view_lp, dialog->views);
-      thunar_progress_view_launch_job (THUNAR_PROGRESS_VIEW (view_lp->data));
+      thunar_progress_dialog_start_view (dialog, view_lp);
+      thunar_progress_dialog_update_queue (dialog);
     }
   else
     {
@@ -232,11 +402,9 @@ launch_waiting_jobs (ThunarProgressDialog *dialog)
           launched = TRUE;
 
           /* Move the view to the running list, and then launch a job */
-          dialog->views_waiting = g_list_remove_link (dialog->views_waiting, lp);
-          dialog->views         = g_list_concat (lp, dialog->views);
-          thunar_progress_view_launch_job (THUNAR_PROGRESS_VIEW (lp->data));
+          thunar_progress_dialog_start_view (dialog, lp);
 
-          job_list = g_list_prepend (job_list, lp->data);
+          job_list = g_list_prepend (job_list, transfer_job);
         }
       lp = next;
     }
@@ -297,6 +465,10 @@ thunar_progress_dialog_job_finished (ThunarProgressDialog *dialog,
       /* destroy the dialog as there are no views left */
       gtk_widget_destroy (GTK_WIDGET (dialog));
     }
+  else
+    {
+      thunar_progress_dialog_update_queue (dialog);
+    }
 }
 
 
@@ -337,10 +509,10 @@ thunar_progress_dialog_list_jobs (ThunarProgressDialog *dialog)
       job = thunar_progress_view_get_job (view);
       if (job != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
         {
-          jobs = g_list_append (jobs, job);
+          jobs = g_list_prepend (jobs, job);
         }
     }
-  return jobs;
+  return g_list_reverse (jobs);
 }
 
 
@@ -362,7 +534,6 @@ thunar_progress_dialog_add_job (ThunarProgressDialog *dialog,
   view = thunar_progress_view_new_with_job (job);
   thunar_progress_view_set_icon_name (THUNAR_PROGRESS_VIEW (view), icon_name);
   thunar_progress_view_set_title (THUNAR_PROGRESS_VIEW (view), title);
-  gtk_box_pack_start (GTK_BOX (dialog->content_box), view, FALSE, TRUE, 0);
   gtk_widget_show (view);
 
   /* use the first job's icon-name for the dialog */
@@ -375,11 +546,13 @@ thunar_progress_dialog_add_job (ThunarProgressDialog *dialog,
       || thunar_transfer_job_can_start (THUNAR_TRANSFER_JOB (job), job_list))
     {
       dialog->views = g_list_append (dialog->views, view);
+      gtk_box_pack_start (GTK_BOX (dialog->content_box), view, FALSE, TRUE, 0);
       thunar_progress_view_launch_job (THUNAR_PROGRESS_VIEW (view));
     }
   else
     {
       dialog->views_waiting = g_list_append (dialog->views_waiting, view);
+      gtk_box_pack_start (GTK_BOX (dialog->queue_box), view, FALSE, TRUE, 0);
     }
   g_list_free (job_list);
 
@@ -418,6 +591,8 @@ thunar_progress_dialog_add_job (ThunarProgressDialog *dialog,
 
   g_signal_connect_swapped (view, "force-launch",
                             G_CALLBACK (thunar_progress_dialog_launch_view), dialog);
+
+  thunar_progress_dialog_update_queue (dialog);
 }
 
 
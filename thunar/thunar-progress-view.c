@@ -29,12 +29,18 @@
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-pango-extensions.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-scheduler.h>
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-transfer-job.h>
 #include <thunar/thunar-progress-view.h>
 
 
 
+/* the interval in milliseconds to show the job updates */
+#define THUNAR_PROGRESS_VIEW_UPDATE_INTERVAL 250
+
+
+
 enum
 {
   PROP_0,
@@ -47,6 +53,7 @@ enum
 
 static void              thunar_progress_view_finalize     (GObject            *object);
 static void              thunar_progress_view_dispose      (GObject            *object);
+static void              thunar_progress_view_map          (GtkWidget          *widget);
 static void              thunar_progress_view_get_property (GObject            *object,
                                                             guint               prop_id,
                                                             GValue             *value,
@@ -83,6 +90,9 @@ static void              thunar_progress_view_unfrozen     (ThunarProgressView *
                                                             ExoJob             *job);
 static void              thunar_progress_view_set_job      (ThunarProgressView *view,
                                                             ThunarJob          *job);
+static void              thunar_progress_view_queue_update (ThunarProgressView *view);
+static gboolean          thunar_progress_view_update       (gpointer            user_data);
+static void              thunar_progress_view_update_done  (gpointer            user_data);
 
 
 
@@ -107,6 +117,14 @@ struct _ThunarProgressView
 
   gchar     *icon_name;
   gchar     *title;
+
+  /* the latest job updates, shown at most every
+   * THUNAR_PROGRESS_VIEW_UPDATE_INTERVAL while the view is mapped */
+  guint      update_id;
+  gdouble    percent;
+  gchar     *message;
+  guint      percent_changed : 1;
+  guint      message_changed : 1;
 };
 
 
@@ -118,7 +136,8 @@ G_DEFINE_TYPE (ThunarProgressView, thunar_progress_view, GTK_TYPE_BOX)
 static void
 thunar_progress_view_class_init (ThunarProgressViewClass *klass)
 {
-  GObjectClass *gobject_class;
+  GtkWidgetClass *gtkwidget_class;
+  GObjectClass   *gobject_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_progress_view_finalize;
@@ -126,6 +145,9 @@ thunar_progress_view_class_init (ThunarProgressViewClass *klass)
   gobject_class->get_property = thunar_progress_view_get_property;
   gobject_class->set_property = thunar_progress_view_set_property;
 
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->map = thunar_progress_view_map;
+
   /**
    * ThunarProgressView:job:
    *
@@ -287,6 +309,7 @@ thunar_progress_view_finalize (GObject *object)
 
   g_free (view->icon_name);
   g_free (view->title);
+  g_free (view->message);
 
   (*G_OBJECT_CLASS (thunar_progress_view_parent_class)->finalize) (object);
 }
@@ -298,6 +321,10 @@ thunar_progress_view_dispose (GObject *object)
 {
   ThunarProgressView *view = THUNAR_PROGRESS_VIEW (object);
 
+  /* stop the pending update */
+  if (G_UNLIKELY (view->update_id != 0))
+    thunar_scheduler_remove (view->update_id);
+
   /* disconnect from the job (if any) */
   if (view->job != NULL)
     {
@@ -310,6 +337,17 @@ thunar_progress_view_dispose (GObject *object)
 
 
 
+static void
+thunar_progress_view_map (GtkWidget *widget)
+{
+  (*GTK_WIDGET_CLASS (thunar_progress_view_parent_class)->map) (widget);
+
+  /* show the updates received while the view was hidden */
+  thunar_progress_view_queue_update (THUNAR_PROGRESS_VIEW (widget));
+}
+
+
+
 static void
 thunar_progress_view_get_property (GObject    *object,
                                    guint       prop_id,
@@ -443,6 +481,10 @@ thunar_progress_view_cancel_job (ThunarProgressView *view)
       g_signal_handlers_disconnect_matched (view->job, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
                                             thunar_progress_view_info_message, NULL);
 
+      /* drop the updates which were not shown yet */
+      view->percent_changed = FALSE;
+      view->message_changed = FALSE;
+
       /* update the status text */
       gtk_label_set_text (GTK_LABEL (view->progress_label), _("Cancelling..."));
 
@@ -555,7 +597,12 @@ thunar_progress_view_info_message (ThunarProgressView *view,
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (view->job == THUNAR_JOB (job));
 
-  gtk_label_set_text (GTK_LABEL (view->message_label), message);
+  /* remember the latest message */
+  g_free (view->message);
+  view->message = g_strdup (message);
+  view->message_changed = TRUE;
+
+  thunar_progress_view_queue_update (view);
 }
 
 
@@ -565,24 +612,79 @@ thunar_progress_view_percent (ThunarProgressView *view,
                               gdouble             percent,
                               ExoJob             *job)
 {
-  gchar *text;
-
   _thunar_return_if_fail (THUNAR_IS_PROGRESS_VIEW (view));
   _thunar_return_if_fail (percent >= 0.0 && percent <= 100.0);
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (view->job == THUNAR_JOB (job));
 
-  /* update progressbar */
-  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (view->progress_bar), percent / 100.0);
+  /* remember the latest percentage */
+  view->percent = percent;
+  view->percent_changed = TRUE;
 
-  /* set progress text */
-  if (THUNAR_IS_TRANSFER_JOB (job))
-    text = thunar_transfer_job_get_status (THUNAR_TRANSFER_JOB (job));
-  else
-    text = g_strdup_printf ("%.2f%%", percent);
+  thunar_progress_view_queue_update (view);
+}
+
+
+
+static void
+thunar_progress_view_queue_update (ThunarProgressView *view)
+{
+  /* updates of hidden views wait until they are mapped, so the
+   * views of a long list of jobs cost nothing while collapsed */
+  if (view->update_id != 0
+      || !(view->percent_changed || view->message_changed)
+      || !gtk_widget_get_mapped (GTK_WIDGET (view)))
+    return;
 
-  gtk_label_set_text (GTK_LABEL (view->progress_label), text);
-  g_free (text);
+  view->update_id = thunar_scheduler_add_timeout (G_PRIORITY_DEFAULT, THUNAR_PROGRESS_VIEW_UPDATE_INTERVAL,
+                                                  thunar_progress_view_update, view,
+                                                  thunar_progress_view_update_done);
+}
+
+
+
+static gboolean
+thunar_progress_view_update (gpointer user_data)
+{
+  ThunarProgressView *view = THUNAR_PROGRESS_VIEW (user_data);
+  gchar              *text;
+
+  /* try again once the view is mapped */
+  if (!gtk_widget_get_mapped (GTK_WIDGET (view)))
+    return FALSE;
+
+  if (view->message_changed)
+    {
+      gtk_label_set_text (GTK_LABEL (view->message_label), view->message);
+      view->message_changed = FALSE;
+    }
+
+  if (view->percent_changed && view->job != NULL)
+    {
+      /* update progressbar */
+      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (view->progress_bar), view->percent / 100.0);
+
+      /* set progress text */
+      if (THUNAR_IS_TRANSFER_JOB (view->job))
+        text = thunar_transfer_job_get_status (THUNAR_TRANSFER_JOB (view->job));
+      else
+        text = g_strdup_printf ("%.2f%%", view->percent);
+
+      gtk_label_set_text (GTK_LABEL (view->progress_label), text);
+      g_free (text);
+
+      view->percent_changed = FALSE;
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_progress_view_update_done (gpointer user_data)
+{
+  THUNAR_PROGRESS_VIEW (user_data)->update_id = 0;
 }
 
 
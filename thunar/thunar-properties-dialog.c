@@ -41,6 +41,7 @@
 #include <thunar/thunar-chooser-button.h>
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-emblem-chooser.h>
+#include <thunar/thunar-free-space.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
@@ -98,7 +99,23 @@ static gboolean thunar_properties_dialog_name_focus_out_event (GtkWidget
 static void     thunar_properties_dialog_icon_button_clicked  (GtkWidget                   *button,
                                                                ThunarPropertiesDialog      *dialog);
 static void     thunar_properties_dialog_update               (ThunarPropertiesDialog      *dialog);
+static void     thunar_properties_dialog_schedule_update      (ThunarPropertiesDialog      *dialog);
+static gboolean thunar_properties_dialog_update_idle          (gpointer                     user_data);
+static void     thunar_properties_dialog_set_volume           (ThunarPropertiesDialog      *dialog,
+                                                               GVolume                     *volume);
+static void     thunar_properties_dialog_volume_ready         (GObject                     *object,
+                                                               GAsyncResult                *result,
+                                                               gpointer                     user_data);
+static void     thunar_properties_dialog_set_free_space       (ThunarPropertiesDialog      *dialog,
+                                                               guint64                      fs_free,
+                                                               guint64                      fs_size);
+static void     thunar_properties_dialog_free_space_ready     (GObject                     *object,
+                                                               GAsyncResult                *result,
+                                                               gpointer                     user_data);
 static void     thunar_properties_dialog_update_providers     (ThunarPropertiesDialog      *dialog);
+static void     thunar_properties_dialog_providers_ready      (GObject                     *object,
+                                                               GAsyncResult                *result,
+                                                               gpointer                     user_data);
 static GList   *thunar_properties_dialog_get_files            (ThunarPropertiesDialog      *dialog);
 
 
@@ -116,12 +133,16 @@ struct _ThunarPropertiesDialog
 
   ThunarxProviderFactory *provider_factory;
   GList                  *provider_pages;
+  GCancellable           *providers_cancellable;
 
   ThunarPreferences      *preferences;
 
   GList                  *files;
   gboolean                file_size_binary;
 
+  /* changes of the files are coalesced into one update */
+  guint                   update_idle_id;
+
   ThunarThumbnailer      *thumbnailer;
   guint                   thumbnail_request;
 
@@ -145,8 +166,10 @@ struct _ThunarPropertiesDialog
   GtkWidget              *freespace_vbox;
   GtkWidget              *freespace_bar;
   GtkWidget              *freespace_label;
+  GCancellable           *freespace_cancellable;
   GtkWidget              *volume_image;
   GtkWidget              *volume_label;
+  GCancellable           *volume_cancellable;
   GtkWidget              *permissions_chooser;
 };
 
@@ -654,6 +677,33 @@ thunar_properties_dialog_dispose (GObject *object)
   /* reset the file displayed by the dialog */
   thunar_properties_dialog_set_files (dialog, NULL);
 
+  /* a pending free space query must not update the dialog anymore */
+  if (dialog->freespace_cancellable != NULL)
+    {
+      g_cancellable_cancel (dialog->freespace_cancellable);
+      g_clear_object (&dialog->freespace_cancellable);
+    }
+
+  /* same for a pending volume lookup */
+  if (dialog->volume_cancellable != NULL)
+    {
+      g_cancellable_cancel (dialog->volume_cancellable);
+      g_clear_object (&dialog->volume_cancellable);
+    }
+
+  /* and for the provider pages */
+  if (dialog->providers_cancellable != NULL)
+    {
+      g_cancellable_cancel (dialog->providers_cancellable);
+      g_clear_object (&dialog->providers_cancellable);
+    }
+
+  if (dialog->update_idle_id != 0)
+    {
+      g_source_remove (dialog->update_idle_id);
+      dialog->update_idle_id = 0;
+    }
+
   (*G_OBJECT_CLASS (thunar_properties_dialog_parent_class)->dispose) (object);
 }
 
@@ -928,11 +978,43 @@ thunar_properties_dialog_icon_button_clicked (GtkWidget              *button,
 static void
 thunar_properties_dialog_update_providers (ThunarPropertiesDialog *dialog)
 {
-  GtkWidget *label_widget;
-  GList     *providers;
-  GList     *pages = NULL;
-  GList     *tmp;
-  GList     *lp;
+  if (dialog->providers_cancellable != NULL)
+    {
+      g_cancellable_cancel (dialog->providers_cancellable);
+      g_clear_object (&dialog->providers_cancellable);
+    }
+
+  /* let the dialog appear first, and load what the pages are going to
+   * ask for, like the content types, in the background */
+  dialog->providers_cancellable = g_cancellable_new ();
+  thunarx_file_info_list_prepare_async (dialog->files, dialog->providers_cancellable,
+                                        thunar_properties_dialog_providers_ready, dialog);
+}
+
+
+
+static void
+thunar_properties_dialog_providers_ready (GObject      *object,
+                                          GAsyncResult *result,
+                                          gpointer      user_data)
+{
+  ThunarPropertiesDialog *dialog;
+  GtkWidget              *label_widget;
+  GList                  *providers;
+  GList                  *pages = NULL;
+  GList                  *tmp;
+  GList                  *lp;
+  GError                 *error = NULL;
+
+  if (!thunarx_file_info_list_prepare_finish (result, &error))
+    {
+      /* the dialog moved on or is gone */
+      g_error_free (error);
+      return;
+    }
+
+  dialog = THUNAR_PROPERTIES_DIALOG (user_data);
+  g_clear_object (&dialog->providers_cancellable);
 
   /* load the property page providers from the provider factory */
   providers = thunarx_provider_factory_list_providers (dialog->provider_factory, THUNARX_TYPE_PROPERTY_PAGE_PROVIDER);
@@ -969,6 +1051,124 @@ thunar_properties_dialog_update_providers (ThunarPropertiesDialog *dialog)
 
 
 
+static void
+thunar_properties_dialog_set_free_space (ThunarPropertiesDialog *dialog,
+                                         guint64                 fs_free,
+                                         guint64                 fs_size)
+{
+  gchar *fs_string;
+
+  fs_string = thunar_free_space_format (fs_free, fs_size, dialog->file_size_binary);
+  if (fs_string != NULL)
+    {
+      gtk_label_set_text (GTK_LABEL (dialog->freespace_label), fs_string);
+      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (dialog->freespace_bar), (gdouble) (fs_size - fs_free) / fs_size);
+      gtk_widget_show (dialog->freespace_vbox);
+      g_free (fs_string);
+    }
+  else
+    {
+      gtk_widget_hide (dialog->freespace_vbox);
+    }
+}
+
+
+
+static void
+thunar_properties_dialog_free_space_ready (GObject      *object,
+                                           GAsyncResult *result,
+                                           gpointer      user_data)
+{
+  ThunarPropertiesDialog *dialog;
+  GError                 *error = NULL;
+  guint64                 fs_free;
+  guint64                 fs_size;
+
+  if (!thunar_free_space_query_finish (G_FILE (object), result, &fs_free, &fs_size, &error))
+    {
+      /* keep what is shown, unless the dialog moved on or is gone */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_clear_object (&THUNAR_PROPERTIES_DIALOG (user_data)->freespace_cancellable);
+      g_error_free (error);
+      return;
+    }
+
+  dialog = THUNAR_PROPERTIES_DIALOG (user_data);
+  g_clear_object (&dialog->freespace_cancellable);
+  thunar_properties_dialog_set_free_space (dialog, fs_free, fs_size);
+}
+
+
+
+static void
+thunar_properties_dialog_set_volume (ThunarPropertiesDialog *dialog,
+                                     GVolume                *volume)
+{
+  GIcon *gicon;
+  gchar *volume_name;
+  gchar *volume_id;
+  gchar *volume_label;
+
+  if (G_LIKELY (volume != NULL))
+    {
+      gicon = g_volume_get_icon (volume);
+      gtk_image_set_from_gicon (GTK_IMAGE (dialog->volume_image), gicon, GTK_ICON_SIZE_MENU);
+      if (G_LIKELY (gicon != NULL))
+        g_object_unref (gicon);
+
+      volume_name = g_volume_get_name (volume);
+      volume_id = g_volume_get_identifier (volume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
+      volume_label = g_strdup_printf ("%s (%s)", volume_name, volume_id);
+      gtk_label_set_text (GTK_LABEL (dialog->volume_label), volume_label);
+      gtk_widget_show (dialog->volume_label);
+      g_free (volume_name);
+      g_free (volume_id);
+      g_free (volume_label);
+    }
+  else
+    {
+      gtk_widget_hide (dialog->volume_label);
+    }
+}
+
+
+
+static void
+thunar_properties_dialog_volume_ready (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data)
+{
+  ThunarPropertiesDialog *dialog;
+  GVolume                *volume = NULL;
+  GMount                 *mount;
+  GError                 *error = NULL;
+
+  mount = g_file_find_enclosing_mount_finish (G_FILE (object), result, &error);
+  if (mount == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* the dialog moved on or is gone */
+      g_error_free (error);
+      return;
+    }
+  g_clear_error (&error);
+
+  dialog = THUNAR_PROPERTIES_DIALOG (user_data);
+  g_clear_object (&dialog->volume_cancellable);
+
+  if (mount != NULL)
+    {
+      volume = g_mount_get_volume (mount);
+      g_object_unref (mount);
+    }
+
+  thunar_properties_dialog_set_volume (dialog, volume);
+
+  if (volume != NULL)
+    g_object_unref (volume);
+}
+
+
+
 static void
 thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
 {
@@ -979,22 +1179,16 @@ thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
   const gchar       *name;
   const gchar       *path;
   GVolume           *volume;
-  GIcon             *gicon;
   glong              offset;
   gchar             *date_custom_style;
   gchar             *date;
   gchar             *display_name;
-  gchar             *fs_string;
   gchar             *str;
-  gchar             *volume_name;
-  gchar             *volume_id;
-  gchar             *volume_label;
   ThunarFile        *file;
   ThunarFile        *parent_file;
   gboolean           show_chooser;
   guint64            fs_free;
   guint64            fs_size;
-  gdouble            fs_fraction = 0.0;
 
   _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
   _thunar_return_if_fail (g_list_length (dialog->files) == 1);
@@ -1188,27 +1382,22 @@ thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
     }
 
   /* update the free space (only for folders) */
+  if (dialog->freespace_cancellable != NULL)
+    {
+      g_cancellable_cancel (dialog->freespace_cancellable);
+      g_clear_object (&dialog->freespace_cancellable);
+    }
   if (thunar_file_is_directory (file))
     {
-      fs_string = thunar_g_file_get_free_space_string (thunar_file_get_file (file),
-                                                       dialog->file_size_binary);
-      if (thunar_g_file_get_free_space (thunar_file_get_file (file), &fs_free, &fs_size)
-          && fs_size > 0)
-        {
-          /* free disk space fraction */
-          fs_fraction = ((fs_size - fs_free) * 100 / fs_size);
-        }
-      if (fs_string != NULL)
-        {
-          gtk_label_set_text (GTK_LABEL (dialog->freespace_label), fs_string);
-          gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (dialog->freespace_bar), fs_fraction / 100);
-          gtk_widget_show (dialog->freespace_vbox);
-          g_free (fs_string);
-        }
+      /* show what is known and update it once the volume answered */
+      if (thunar_free_space_lookup (thunar_file_get_file (file), &fs_free, &fs_size))
+        thunar_properties_dialog_set_free_space (dialog, fs_free, fs_size);
       else
-        {
-          gtk_widget_hide (dialog->freespace_vbox);
-        }
+        gtk_widget_hide (dialog->freespace_vbox);
+
+      dialog->freespace_cancellable = g_cancellable_new ();
+      thunar_free_space_query_async (thunar_file_get_file (file), dialog->freespace_cancellable,
+                                     thunar_properties_dialog_free_space_ready, dialog);
     }
   else
     {
@@ -1216,29 +1405,15 @@ thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
     }
 
   /* update the volume */
-  volume = thunar_file_get_volume (file);
-  if (G_LIKELY (volume != NULL))
+  if (dialog->volume_cancellable != NULL)
     {
-      gicon = g_volume_get_icon (volume);
-      gtk_image_set_from_gicon (GTK_IMAGE (dialog->volume_image), gicon, GTK_ICON_SIZE_MENU);
-      if (G_LIKELY (gicon != NULL))
-        g_object_unref (gicon);
-
-      volume_name = g_volume_get_name (volume);
-      volume_id = g_volume_get_identifier (volume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-      volume_label= g_strdup_printf ("%s (%s)", volume_name, volume_id);
-      gtk_label_set_text (GTK_LABEL (dialog->volume_label), volume_label);
-      gtk_widget_show (dialog->volume_label);
-      g_free (volume_name);
-      g_free (volume_id);
-      g_free (volume_label);
-
-      g_object_unref (G_OBJECT (volume));
-    }
-  else
-    {
-      gtk_widget_hide (dialog->volume_label);
+      g_cancellable_cancel (dialog->volume_cancellable);
+      g_clear_object (&dialog->volume_cancellable);
     }
+  volume = thunar_file_get_volume (file);
+  thunar_properties_dialog_set_volume (dialog, volume);
+  if (G_LIKELY (volume != NULL))
+    g_object_unref (G_OBJECT (volume));
 
   /* cleanup */
   g_object_unref (G_OBJECT (icon_factory));
@@ -1250,21 +1425,16 @@ static void
 thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
 {
   ThunarFile  *file;
+  ThunarFile  *first_file;
   GString     *names_string;
-  gboolean     first_file = TRUE;
   GList       *lp;
-  const gchar *content_type = NULL;
+  const gchar *content_type;
   const gchar *tmp;
   gchar       *str;
-  GVolume     *volume = NULL;
-  GVolume     *tmp_volume;
-  GIcon       *gicon;
-  gchar       *volume_name;
-  gchar       *volume_id;
-  gchar       *volume_label;
   gchar       *display_name;
-  ThunarFile  *parent_file = NULL;
-  ThunarFile  *tmp_parent;
+  GFile       *parent;
+  GFile       *tmp_parent;
+  gboolean     same_filesystem = TRUE;
   gboolean     has_trashed_files = FALSE;
 
   _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
@@ -1280,77 +1450,62 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
   gtk_widget_hide (dialog->accessed_label);
   gtk_widget_hide (dialog->freespace_vbox);
   gtk_widget_hide (dialog->origin_label);
+  if (dialog->freespace_cancellable != NULL)
+    {
+      g_cancellable_cancel (dialog->freespace_cancellable);
+      g_clear_object (&dialog->freespace_cancellable);
+    }
   gtk_widget_hide (dialog->openwith_chooser);
   gtk_widget_hide (dialog->link_label);
 
   names_string = g_string_new (NULL);
 
-  /* collect data of the selected files */
+  first_file = THUNAR_FILE (dialog->files->data);
+  content_type = thunar_file_get_content_type (first_file);
+  parent = g_file_get_parent (thunar_file_get_file (first_file));
+
+  /* collect data of the selected files, only using what the files
+   * already know, the volume is looked up once for all of them */
   for (lp = dialog->files; lp != NULL; lp = lp->next)
     {
       _thunar_assert (THUNAR_IS_FILE (lp->data));
       file = THUNAR_FILE (lp->data);
 
       /* append the name */
-      if (!first_file)
+      if (lp != dialog->files)
         g_string_append (names_string, ", ");
       g_string_append (names_string, thunar_file_get_display_name (file));
 
-      /* update the content type */
-      if (first_file)
+      if (lp == dialog->files)
         {
-          content_type = thunar_file_get_content_type (file);
+          has_trashed_files = thunar_file_is_trashed (file);
+          continue;
         }
-      else if (content_type != NULL)
+
+      /* check the types match */
+      if (content_type != NULL)
         {
-          /* check the types match */
           tmp = thunar_file_get_content_type (file);
           if (tmp == NULL || !g_content_type_equals (content_type, tmp))
             content_type = NULL;
         }
 
-      /* check if all selected files are on the same volume */
-      tmp_volume = thunar_file_get_volume (file);
-      if (first_file)
-        {
-          volume = tmp_volume;
-        }
-      else if (tmp_volume != NULL)
-        {
-          /* we only display information if the files are on the same volume */
-          if (tmp_volume != volume)
-            {
-              if (volume != NULL)
-                g_object_unref (G_OBJECT (volume));
-              volume = NULL;
-            }
-
-          g_object_unref (G_OBJECT (tmp_volume));
-        }
+      /* files on different filesystems are never on the same volume */
+      if (same_filesystem && !thunar_file_same_filesystem (first_file, file))
+        same_filesystem = FALSE;
 
-      /* check if all files have the same parent */
-      tmp_parent = thunar_file_get_parent (file, NULL);
-      if (first_file)
-        {
-          parent_file = tmp_parent;
-        }
-      else if (tmp_parent != NULL)
+      /* we only display the location if all files have the same parent */
+      if (parent != NULL)
         {
-          /* we only display the location if they are all equal */
-          if (!g_file_equal (thunar_file_get_file (parent_file), thunar_file_get_file (tmp_parent)))
-            {
-              if (parent_file != NULL)
-                g_object_unref (G_OBJECT (parent_file));
-              parent_file = NULL;
-            }
-
-          g_object_unref (G_OBJECT (tmp_parent));
+          tmp_parent = g_file_get_parent (thunar_file_get_file (file));
+          if (tmp_parent != NULL && !g_file_equal (parent, tmp_parent))
+            g_clear_object (&parent);
+          if (tmp_parent != NULL)
+            g_object_unref (tmp_parent);
         }
 
       if (thunar_file_is_trashed (file))
         has_trashed_files = TRUE;
-
-      first_file = FALSE;
     }
 
   /* set the labels string */
@@ -1376,12 +1531,12 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
     }
 
   /* update the file or folder location (parent) */
-  if (G_UNLIKELY (parent_file != NULL))
+  if (G_UNLIKELY (parent != NULL))
     {
-      display_name = g_file_get_parse_name (thunar_file_get_file (parent_file));
+      display_name = g_file_get_parse_name (parent);
       gtk_label_set_text (GTK_LABEL (dialog->location_label), display_name);
       gtk_widget_show (dialog->location_label);
-      g_object_unref (G_OBJECT (parent_file));
+      g_object_unref (G_OBJECT (parent));
       g_free (display_name);
     }
   else
@@ -1389,28 +1544,19 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
       gtk_widget_hide (dialog->location_label);
     }
 
-  /* update the volume */
-  if (G_LIKELY (volume != NULL))
+  /* update the volume once it is known */
+  if (dialog->volume_cancellable != NULL)
     {
-      gicon = g_volume_get_icon (volume);
-      gtk_image_set_from_gicon (GTK_IMAGE (dialog->volume_image), gicon, GTK_ICON_SIZE_MENU);
-      if (G_LIKELY (gicon != NULL))
-        g_object_unref (gicon);
-
-      volume_name = g_volume_get_name (volume);
-      volume_id = g_volume_get_identifier (volume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-      volume_label = g_strdup_printf ("%s (%s)", volume_name, volume_id);
-      gtk_label_set_text (GTK_LABEL (dialog->volume_label), volume_label);
-      gtk_widget_show (dialog->volume_label);
-      g_free (volume_name);
-      g_free (volume_id);
-      g_free (volume_label);
-
-      g_object_unref (G_OBJECT (volume));
+      g_cancellable_cancel (dialog->volume_cancellable);
+      g_clear_object (&dialog->volume_cancellable);
     }
-  else
+  gtk_widget_hide (dialog->volume_label);
+  if (G_LIKELY (same_filesystem))
     {
-      gtk_widget_hide (dialog->volume_label);
+      dialog->volume_cancellable = g_cancellable_new ();
+      g_file_find_enclosing_mount_async (thunar_file_get_file (first_file), G_PRIORITY_DEFAULT,
+                                         dialog->volume_cancellable,
+                                         thunar_properties_dialog_volume_ready, dialog);
     }
 }
 
@@ -1449,6 +1595,33 @@ thunar_properties_dialog_update (ThunarPropertiesDialog *dialog)
 
 
 
+static void
+thunar_properties_dialog_schedule_update (ThunarPropertiesDialog *dialog)
+{
+  _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
+
+  /* with many files a lot of them change at once */
+  if (dialog->update_idle_id == 0)
+    dialog->update_idle_id = g_idle_add (thunar_properties_dialog_update_idle, dialog);
+}
+
+
+
+static gboolean
+thunar_properties_dialog_update_idle (gpointer user_data)
+{
+  ThunarPropertiesDialog *dialog = THUNAR_PROPERTIES_DIALOG (user_data);
+
+  dialog->update_idle_id = 0;
+
+  if (G_LIKELY (dialog->files != NULL))
+    thunar_properties_dialog_update (dialog);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
 /**
  * thunar_properties_dialog_new:
  * @parent: transient window or NULL;
@@ -1512,6 +1685,13 @@ thunar_properties_dialog_set_files (ThunarPropertiesDialog *dialog,
   if (G_UNLIKELY (dialog->files == files))
     return;
 
+  /* the update below covers any pending one */
+  if (dialog->update_idle_id != 0)
+    {
+      g_source_remove (dialog->update_idle_id);
+      dialog->update_idle_id = 0;
+    }
+
   /* disconnect from any previously set files */
   for (lp = dialog->files; lp != NULL; lp = lp->next)
     {
@@ -1521,7 +1701,7 @@ thunar_properties_dialog_set_files (ThunarPropertiesDialog *dialog,
       thunar_file_unwatch (file);
 
       /* unregister handlers */
-      g_signal_handlers_disconnect_by_func (G_OBJECT (file), thunar_properties_dialog_update, dialog);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (file), thunar_properties_dialog_schedule_update, dialog);
       g_signal_handlers_disconnect_by_func (G_OBJECT (file), gtk_widget_destroy, dialog);
 
       g_object_unref (G_OBJECT (file));
@@ -1541,7 +1721,7 @@ thunar_properties_dialog_set_files (ThunarPropertiesDialog *dialog,
       thunar_file_watch (file);
 
       /* install signal handlers */
-      g_signal_connect_swapped (G_OBJECT (file), "changed", G_CALLBACK (thunar_properties_dialog_update), dialog);
+      g_signal_connect_swapped (G_OBJECT (file), "changed", G_CALLBACK (thunar_properties_dialog_schedule_update), dialog);
       g_signal_connect_swapped (G_OBJECT (file), "destroy", G_CALLBACK (gtk_widget_destroy), dialog);
     }
 
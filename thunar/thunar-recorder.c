@@ -0,0 +1,364 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-file.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-recorder.h>
+
+
+
+/* If the THUNAR_RECORD environment variable names a file, the operations
+ * Thunar performs and receives are written to it, so the slowness seen
+ * on another machine can be reproduced with the same directory shapes
+ * and event storms. Every line holds the time in microseconds since the
+ * recording started and the kind of the record, separated by tabs:
+ *
+ *   TIME load      FOLDER  N-FILES
+ *   TIME entry     PATH    d|f  SIZE       (the files of the last load)
+ *   TIME monitor   EVENT   PATH [OTHER]    (the nick of the event)
+ *   TIME thumbnail PATH    SIZE
+ *   TIME job       TYPE    PRIORITY  WAITED
+ *
+ * The paths are anonymized: every component, including the host of
+ * remote locations, is replaced by a keyed hash which is stable within
+ * the recording, so the tree keeps its shape. Short extensions are kept,
+ * since they decide about content types and thumbnailers. The key is
+ * random and never written, so names cannot be guessed from the hashes.
+ *
+ * When recording is disabled, a hook costs the check of a global flag.
+ */
+
+
+
+/* the length of the hashes of the path components */
+#define THUNAR_RECORDER_HASH_LENGTH (12)
+
+/* the longest extension that is kept */
+#define THUNAR_RECORDER_MAX_EXTENSION (8)
+
+
+
+gboolean thunar_recorder_enabled = FALSE;
+
+static GMutex      recorder_mutex;
+static FILE       *recorder_stream = NULL;
+static gint64      recorder_start_time = 0;
+static guchar      recorder_key[32];
+static GEnumClass *recorder_events = NULL;
+
+
+
+static void
+thunar_recorder_append_component (GString     *line,
+                                  const gchar *component,
+                                  gsize        length)
+{
+  const gchar *extension;
+  const gchar *p;
+  gchar       *hash;
+
+  hash = g_compute_hmac_for_data (G_CHECKSUM_SHA256, recorder_key, sizeof (recorder_key),
+                                  (const guchar *) component, length);
+  g_string_append_len (line, hash, THUNAR_RECORDER_HASH_LENGTH);
+  g_free (hash);
+
+  /* keep a short alphanumeric extension, not the dot of hidden files */
+  extension = g_strrstr_len (component, length, ".");
+  if (extension == NULL || extension == component
+      || (gsize) (component + length - extension) > THUNAR_RECORDER_MAX_EXTENSION + 1)
+    return;
+
+  for (p = extension + 1; p < component + length; ++p)
+    if (!g_ascii_isalnum (*p))
+      return;
+
+  if (p > extension + 1)
+    g_string_append_len (line, extension, p - extension);
+}
+
+
+
+static void
+thunar_recorder_append_file (GString *line,
+                             GFile   *file)
+{
+  const gchar *component;
+  const gchar *p;
+  gchar       *uri;
+
+  g_string_append_c (line, '\t');
+
+  /* keep the scheme, it decides about the behavior of the backends */
+  uri = g_file_get_uri (file);
+  p = strstr (uri, "://");
+  if (G_LIKELY (p != NULL))
+    {
+      g_string_append_len (line, uri, p + 3 - uri);
+      p += 3;
+    }
+  else
+    {
+      p = uri;
+    }
+
+  while (*p != '\0')
+    {
+      if (*p == '/')
+        {
+          g_string_append_c (line, *p++);
+          continue;
+        }
+
+      for (component = p; *p != '\0' && *p != '/'; ++p)
+        ;
+      thunar_recorder_append_component (line, component, p - component);
+    }
+
+  g_free (uri);
+}
+
+
+
+static GString *
+thunar_recorder_line_new (const gchar *kind)
+{
+  GString *line;
+
+  line = g_string_sized_new (128);
+  g_string_append_printf (line, "%" G_GINT64_FORMAT "\t%s",
+                          g_get_monotonic_time () - recorder_start_time, kind);
+
+  return line;
+}
+
+
+
+static void
+thunar_recorder_write (GString *line)
+{
+  g_string_append_c (line, '\n');
+
+  g_mutex_lock (&recorder_mutex);
+  if (G_LIKELY (recorder_stream != NULL))
+    fputs (line->str, recorder_stream);
+  g_mutex_unlock (&recorder_mutex);
+
+  g_string_free (line, TRUE);
+}
+
+
+
+/**
+ * thunar_recorder_init:
+ *
+ * Starts recording to the file named by the THUNAR_RECORD environment
+ * variable, if it is set. Must be called from the main thread before
+ * any other thread is started.
+ **/
+void
+thunar_recorder_init (void)
+{
+  const gchar *path;
+  guint32      value;
+  guint        n;
+
+  path = g_getenv ("THUNAR_RECORD");
+  if (G_LIKELY (path == NULL || *path == '\0'))
+    return;
+
+  recorder_stream = g_fopen (path, "w");
+  if (G_UNLIKELY (recorder_stream == NULL))
+    {
+      g_warning ("Failed to open recording file \"%s\": %s", path, g_strerror (errno));
+      return;
+    }
+
+  for (n = 0; n < sizeof (recorder_key); n += sizeof (value))
+    {
+      value = g_random_int ();
+      memcpy (recorder_key + n, &value, sizeof (value));
+    }
+
+  recorder_events = g_type_class_ref (G_TYPE_FILE_MONITOR_EVENT);
+  recorder_start_time = g_get_monotonic_time ();
+  fputs ("# thunar recording 1\n", recorder_stream);
+  thunar_recorder_enabled = TRUE;
+}
+
+
+
+/**
+ * thunar_recorder_shutdown:
+ *
+ * Closes the file opened by thunar_recorder_init(). Operations which
+ * happen afterwards are dropped.
+ **/
+void
+thunar_recorder_shutdown (void)
+{
+  if (recorder_stream == NULL)
+    return;
+
+  g_mutex_lock (&recorder_mutex);
+  fclose (recorder_stream);
+  recorder_stream = NULL;
+  g_mutex_unlock (&recorder_mutex);
+}
+
+
+
+/**
+ * thunar_recorder_folder_loaded:
+ * @directory : the #GFile of the folder.
+ * @files     : the #ThunarFile<!---->s read from @directory.
+ *
+ * Records that @directory was read, with the type and size of
+ * every file in it.
+ **/
+void
+thunar_recorder_folder_loaded (GFile *directory,
+                               GList *files)
+{
+  GString *line;
+  GString *entry;
+  GList   *lp;
+
+  if (G_LIKELY (!thunar_recorder_enabled))
+    return;
+
+  line = thunar_recorder_line_new ("load");
+  thunar_recorder_append_file (line, directory);
+  g_string_append_printf (line, "\t%u", g_list_length (files));
+
+  /* the entries follow the folder in one write */
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      entry = thunar_recorder_line_new ("entry");
+      thunar_recorder_append_file (entry, thunar_file_get_file (lp->data));
+      g_string_append_printf (entry, "\t%c\t%" G_GUINT64_FORMAT,
+                              thunar_file_is_directory (lp->data) ? 'd' : 'f',
+                              thunar_file_get_size (lp->data));
+      g_string_append_c (line, '\n');
+      g_string_append_len (line, entry->str, entry->len);
+      g_string_free (entry, TRUE);
+    }
+
+  thunar_recorder_write (line);
+}
+
+
+
+/**
+ * thunar_recorder_monitor_event:
+ * @file       : the #GFile of the event.
+ * @other_file : the other #GFile of a move or %NULL.
+ * @event_type : the #GFileMonitorEvent.
+ *
+ * Records an event received from a folder monitor.
+ **/
+void
+thunar_recorder_monitor_event (GFile             *file,
+                               GFile             *other_file,
+                               GFileMonitorEvent  event_type)
+{
+  GEnumValue *value;
+  GString    *line;
+
+  if (G_LIKELY (!thunar_recorder_enabled))
+    return;
+
+  line = thunar_recorder_line_new ("monitor");
+  value = g_enum_get_value (recorder_events, event_type);
+  if (G_LIKELY (value != NULL))
+    g_string_append_printf (line, "\t%s", value->value_nick);
+  else
+    g_string_append_printf (line, "\t%d", (gint) event_type);
+  thunar_recorder_append_file (line, file);
+  if (other_file != NULL)
+    thunar_recorder_append_file (line, other_file);
+
+  thunar_recorder_write (line);
+}
+
+
+
+/**
+ * thunar_recorder_thumbnail_request:
+ * @files : the #ThunarFile<!---->s to thumbnail.
+ *
+ * Records a request to the thumbnailer, with the
+ * size of every file in it.
+ **/
+void
+thunar_recorder_thumbnail_request (GList *files)
+{
+  GString *line;
+  GList   *lp;
+
+  if (G_LIKELY (!thunar_recorder_enabled))
+    return;
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      line = thunar_recorder_line_new ("thumbnail");
+      thunar_recorder_append_file (line, thunar_file_get_file (lp->data));
+      g_string_append_printf (line, "\t%" G_GUINT64_FORMAT, thunar_file_get_size (lp->data));
+      thunar_recorder_write (line);
+    }
+}
+
+
+
+/**
+ * thunar_recorder_job:
+ * @name     : the type name of the job.
+ * @priority : the #ThunarJobPriority of the job.
+ * @waited   : the microseconds the job waited for its priority class.
+ *
+ * Records that a job starts its I/O. Can be called on any thread.
+ **/
+void
+thunar_recorder_job (const gchar *name,
+                     guint        priority,
+                     gint64       waited)
+{
+  GString *line;
+
+  if (G_LIKELY (!thunar_recorder_enabled))
+    return;
+
+  line = thunar_recorder_line_new ("job");
+  g_string_append_printf (line, "\t%s\t%u\t%" G_GINT64_FORMAT, name, priority, waited);
+  thunar_recorder_write (line);
+}
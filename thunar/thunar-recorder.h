@@ -0,0 +1,48 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_RECORDER_H__
+#define __THUNAR_RECORDER_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* whether operations are recorded, check this before collecting them */
+#define THUNAR_RECORDER_ENABLED() (G_UNLIKELY (thunar_recorder_enabled))
+
+extern gboolean thunar_recorder_enabled;
+
+void thunar_recorder_init              (void);
+void thunar_recorder_shutdown          (void);
+
+void thunar_recorder_folder_loaded     (GFile             *directory,
+                                        GList             *files);
+void thunar_recorder_monitor_event     (GFile             *file,
+                                        GFile             *other_file,
+                                        GFileMonitorEvent  event_type);
+void thunar_recorder_thumbnail_request (GList             *files);
+void thunar_recorder_job               (const gchar       *name,
+                                        guint              priority,
+                                        gint64             waited);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_RECORDER_H__ */
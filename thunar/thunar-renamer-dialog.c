@@ -44,6 +44,7 @@
 #include <thunar/thunar-renamer-dialog.h>
 #include <thunar/thunar-renamer-model.h>
 #include <thunar/thunar-renamer-progress.h>
+#include <thunar/thunar-state-writer.h>
 
 
 
@@ -977,60 +978,63 @@ thunar_renamer_dialog_help (ThunarRenamerDialog *renamer_dialog)
 
 
 
-static void
-trd_save_foreach (gpointer key,
-                  gpointer value,
-                  gpointer user_data)
-{
-  xfce_rc_write_entry (user_data, key, value);
-}
-
-
-
 static void
 thunar_renamer_dialog_save (ThunarRenamerDialog *renamer_dialog)
 {
+  GHashTableIter  iter;
   ThunarxRenamer *renamer;
   GHashTable     *settings;
   GEnumClass     *klass;
   GEnumValue     *value;
-  XfceRc         *rc;
+  GKeyFile       *key_file;
+  GBytes         *bytes;
+  gpointer        setting_key;
+  gpointer        setting_value;
+  gchar          *contents;
+  gchar          *path;
+  gsize           length;
 
   _thunar_return_if_fail (THUNAR_IS_RENAMER_DIALOG (renamer_dialog));
 
-  /* try to open the config handle for writing */
-  rc = xfce_rc_config_open (XFCE_RESOURCE_CONFIG, "Thunar/renamerrc", FALSE);
-  if (G_UNLIKELY (rc == NULL))
-    return;
-
   /* determine the currently active renamer */
   renamer = thunar_renamer_model_get_renamer (renamer_dialog->model);
-  if (G_LIKELY (renamer != NULL))
-    {
-      /* save general settings first */
-      xfce_rc_set_group (rc, "Configuration");
-
-      /* remember current mode as last active */
-      klass = g_type_class_ref (THUNAR_TYPE_RENAMER_MODE);
-      value = g_enum_get_value (klass, thunar_renamer_model_get_mode (renamer_dialog->model));
-      if (G_LIKELY (value != NULL))
-        xfce_rc_write_entry (rc, "LastActiveMode", value->value_name);
-      g_type_class_unref (klass);
-
-      /* remember renamer as last active */
-      xfce_rc_write_entry (rc, "LastActiveRenamer", G_OBJECT_TYPE_NAME (renamer));
+  if (G_UNLIKELY (renamer == NULL))
+    return;
 
-      /* save the renamer's settings */
-      settings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-      xfce_rc_delete_group (rc, G_OBJECT_TYPE_NAME (renamer), TRUE);
-      xfce_rc_set_group (rc, G_OBJECT_TYPE_NAME (renamer));
-      thunarx_renamer_save (renamer, settings);
-      g_hash_table_foreach (settings, trd_save_foreach, rc);
-      g_hash_table_destroy (settings);
-    }
+  path = xfce_resource_save_location (XFCE_RESOURCE_CONFIG, "Thunar/renamerrc", FALSE);
+  if (G_UNLIKELY (path == NULL))
+    return;
 
-  /* close the config handle */
-  xfce_rc_close (rc);
+  /* keep the settings of the other renamers */
+  key_file = g_key_file_new ();
+  g_key_file_load_from_file (key_file, path, G_KEY_FILE_KEEP_COMMENTS, NULL);
+
+  /* remember current mode as last active */
+  klass = g_type_class_ref (THUNAR_TYPE_RENAMER_MODE);
+  value = g_enum_get_value (klass, thunar_renamer_model_get_mode (renamer_dialog->model));
+  if (G_LIKELY (value != NULL))
+    g_key_file_set_value (key_file, "Configuration", "LastActiveMode", value->value_name);
+  g_type_class_unref (klass);
+
+  /* remember renamer as last active */
+  g_key_file_set_value (key_file, "Configuration", "LastActiveRenamer", G_OBJECT_TYPE_NAME (renamer));
+
+  /* save the renamer's settings */
+  settings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  g_key_file_remove_group (key_file, G_OBJECT_TYPE_NAME (renamer), NULL);
+  thunarx_renamer_save (renamer, settings);
+  g_hash_table_iter_init (&iter, settings);
+  while (g_hash_table_iter_next (&iter, &setting_key, &setting_value))
+    g_key_file_set_value (key_file, G_OBJECT_TYPE_NAME (renamer), setting_key, setting_value);
+  g_hash_table_destroy (settings);
+
+  /* the file is written in the background, the dialog may be closing */
+  contents = g_key_file_to_data (key_file, &length, NULL);
+  bytes = g_bytes_new_take (contents, length);
+  thunar_state_writer_schedule (path, bytes, 0, NULL, NULL);
+  g_bytes_unref (bytes);
+  g_key_file_free (key_file);
+  g_free (path);
 }
 
 
@@ -1063,6 +1067,7 @@ thunar_renamer_dialog_action_add_files (ThunarRenamerDialog *renamer_dialog)
   GtkWidget     *chooser;
   GSList        *uris;
   GSList        *lp;
+  GList         *files = NULL;
   gchar         *uri;
 
   _thunar_return_if_fail (THUNAR_IS_RENAMER_DIALOG (renamer_dialog));
@@ -1117,22 +1122,24 @@ thunar_renamer_dialog_action_add_files (ThunarRenamerDialog *renamer_dialog)
           /* determine the file for the URI */
           file = thunar_file_get_for_uri (lp->data, NULL);
           if (G_LIKELY (file != NULL))
-            {
-              /* append the file to the renamer model */
-              thunar_renamer_model_append (renamer_dialog->model, file);
-
-              /* unset sort order */
-              gtk_tree_view_column_set_sort_indicator (renamer_dialog->name_column, FALSE);
-
-              /* release the file */
-              g_object_unref (G_OBJECT (file));
-            }
+            files = g_list_prepend (files, file);
 
           /* release the URI */
           g_free (lp->data);
         }
       g_slist_free (uris);
 
+      /* append the files to the renamer model in one go */
+      if (G_LIKELY (files != NULL))
+        {
+          files = g_list_reverse (files);
+          thunar_renamer_model_insert_files (renamer_dialog->model, files, -1);
+          g_list_free_full (files, g_object_unref);
+
+          /* unset sort order */
+          gtk_tree_view_column_set_sort_indicator (renamer_dialog->name_column, FALSE);
+        }
+
       /* determine the current folder of the chooser */
       uri = gtk_file_chooser_get_current_folder_uri (GTK_FILE_CHOOSER (chooser));
       if (G_LIKELY (uri != NULL))
@@ -1326,6 +1333,7 @@ thunar_renamer_dialog_drag_data_received (GtkWidget           *tree_view,
 {
   ThunarFile              *file;
   GList                   *file_list;
+  GList                   *files = NULL;
   GList                   *lp;
   GtkTreeModel            *model;
   GtkTreePath             *path;
@@ -1366,25 +1374,23 @@ thunar_renamer_dialog_drag_data_received (GtkWidget           *tree_view,
           /* determine the file for the path */
           file = thunar_file_get (lp->data, NULL);
           if (G_LIKELY (file != NULL))
-            {
-              /* insert the file in the model */
-              thunar_renamer_model_insert (renamer_dialog->model, file, position);
-
-              /* unset sort order */
-              gtk_tree_view_column_set_sort_indicator (renamer_dialog->name_column, FALSE);
-
-              /* advance the offset if we do not append, so the drop order is consistent */
-              if (position != -1)
-                position++;
-
-              /* release the file */
-              g_object_unref (file);
-            }
+            files = g_list_prepend (files, file);
 
           /* release the GFile */
           g_object_unref (lp->data);
         }
 
+      /* insert the files in the model in the drop order */
+      if (G_LIKELY (files != NULL))
+        {
+          files = g_list_reverse (files);
+          thunar_renamer_model_insert_files (renamer_dialog->model, files, position);
+          g_list_free_full (files, g_object_unref);
+
+          /* unset sort order */
+          gtk_tree_view_column_set_sort_indicator (renamer_dialog->name_column, FALSE);
+        }
+
       /* finish the drag */
       gtk_drag_finish (context, (file_list != NULL), FALSE, timestamp);
 
@@ -1888,8 +1894,7 @@ thunar_show_renamer_dialog (gpointer     parent,
     }
 
   /* append all specified files to the dialog's model */
-  for (lp = files; lp != NULL; lp = lp->next)
-    thunar_renamer_model_append (THUNAR_RENAMER_DIALOG (dialog)->model, lp->data);
+  thunar_renamer_model_insert_files (THUNAR_RENAMER_DIALOG (dialog)->model, files, -1);
 
   /* if there are only directories selected change the mode to both */
   directories_only = TRUE;
@@ -33,12 +33,19 @@
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-renamer-model.h>
+#include <thunar/thunar-scheduler.h>
 #include <thunar/thunar-util.h>
 
 
 
 #define THUNAR_RENAMER_MODEL_ITEM(item) ((ThunarRenamerModelItem *) (item))
 
+/* number of items merged back into the model at once by a preview */
+#define THUNAR_RENAMER_MODEL_PREVIEW_CHUNK_SIZE (256)
+
+/* upper limit for the number of threads computing previews */
+#define THUNAR_RENAMER_MODEL_PREVIEW_MAX_THREADS (8)
+
 
 
 /* Property identifiers */
@@ -51,19 +58,17 @@ enum
   PROP_RENAMER,
 };
 
+typedef struct _ThunarRenamerModelItem ThunarRenamerModelItem;
+
 typedef struct
 {
-  gint   offset;
-  gint   position;
-  GList *item;
+  gint                    offset;
+  gint                    position;
+  ThunarRenamerModelItem *item;
 } SortTuple;
 
 
 
-typedef struct _ThunarRenamerModelItem ThunarRenamerModelItem;
-
-
-
 static void                    thunar_renamer_model_tree_model_init     (GtkTreeModelIface       *iface);
 static void                    thunar_renamer_model_finalize            (GObject                 *object);
 static void                    thunar_renamer_model_get_property        (GObject                 *object,
@@ -103,21 +108,30 @@ static gboolean                thunar_renamer_model_iter_nth_child      (GtkTree
 static gboolean                thunar_renamer_model_iter_parent         (GtkTreeModel            *tree_model,
                                                                          GtkTreeIter             *iter,
                                                                          GtkTreeIter             *child);
-static void                    thunar_renamer_model_file_changed        (ThunarRenamerModel      *renamer_model,
+static void                    thunar_renamer_model_file_changed        (ThunarFileMonitor       *file_monitor,
                                                                          ThunarFile              *file,
-                                                                         ThunarFileMonitor       *file_monitor);
-static void                    thunar_renamer_model_file_destroyed      (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModel      *renamer_model);
+static void                    thunar_renamer_model_file_destroyed      (ThunarFileMonitor       *file_monitor,
                                                                          ThunarFile              *file,
-                                                                         ThunarFileMonitor       *file_monitor);
+                                                                         ThunarRenamerModel      *renamer_model);
+static void                    thunar_renamer_model_remove_item         (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_renumber            (ThunarRenamerModel      *renamer_model,
+                                                                         guint                    first);
 static void                    thunar_renamer_model_invalidate_all      (ThunarRenamerModel      *renamer_model);
 static void                    thunar_renamer_model_invalidate_item     (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_conflict_remove     (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
 static gboolean                thunar_renamer_model_conflict_item       (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
 static gchar                  *thunar_renamer_model_process_item        (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item,
                                                                          guint                    idx);
-static gboolean                thunar_renamer_model_update_idle         (gpointer                 user_data);
+static gboolean                thunar_renamer_model_preview_start       (ThunarRenamerModel      *renamer_model);
+static void                    thunar_renamer_model_preview_cancel      (ThunarRenamerModel      *renamer_model);
+static gboolean                thunar_renamer_model_update_idle         (gpointer                 user_data,
+                                                                         gint64                   deadline);
 static void                    thunar_renamer_model_update_idle_destroy (gpointer                 user_data);
 static ThunarRenamerModelItem *thunar_renamer_model_item_new            (ThunarFile              *file) G_GNUC_MALLOC;
 static void                    thunar_renamer_model_item_free           (gpointer                 data);
@@ -133,6 +147,10 @@ static void                    thunar_renamer_model_set_mode            (ThunarR
 
 
 
+typedef struct _ThunarRenamerModelPreview ThunarRenamerModelPreview;
+
+
+
 struct _ThunarRenamerModelClass
 {
   GObjectClass __parent__;
@@ -153,25 +171,77 @@ struct _ThunarRenamerModel
   ThunarRenamerMode  mode;
   ThunarFileMonitor *file_monitor;
   ThunarxRenamer    *renamer;
-  GList             *items;
+
+  /* the items in row order, every item knows its row, so
+   * iterators and paths are converted without walking */
+  GPtrArray         *items;
+
+  /* the items by their ThunarFile */
+  GHashTable        *files;
+
+  /* the up to date items by parent uri and new name, joined
+   * by a newline, used to find conflicting names */
+  GHashTable        *conflicts;
 
   /* TRUE if the model is currently frozen */
   gboolean           frozen;
 
   /* the idle source used to update the model */
   guint              update_idle_id;
+
+  /* the new names computed in the background, if the renamer supports it */
+  ThunarRenamerModelPreview *preview;
 };
 
 struct _ThunarRenamerModelItem
 {
   ThunarFile *file;
+  guint       idx;          /* the row of the item in the model */
   gchar      *name;
+  gchar      *conflict_key; /* the key of the item in the conflicts table */
   guint64     date_changed;
   guint       changed : 1;  /* if the file changed */
   guint       conflict : 1; /* if the item conflicts with another item */
   guint       dirty : 1;    /* if the item must be updated */
 };
 
+/* The preview computes the new names of the dirty items with a snapshot
+ * of the renamer settings in a thread pool. The results are merged back
+ * in chunks from the main thread. Every change to the items or the
+ * settings cancels the preview, so the chunks can keep pointers to the
+ * items and their rows.
+ */
+struct _ThunarRenamerModelPreview
+{
+  ThunarRenamerModel *renamer_model;
+  ThunarxRenamer     *renamer;
+  gpointer            snapshot;
+  ThunarRenamerMode   mode;
+  GCancellable       *cancellable;
+
+  /* main thread only */
+  guint               ref_count;
+  guint               n_pending;
+};
+
+typedef struct
+{
+  ThunarRenamerModelItem *item;
+  ThunarFile             *file;
+  gchar                  *display_name;
+  gchar                  *name;
+  guint                   idx;
+}
+ThunarRenamerModelPreviewEntry;
+
+typedef struct
+{
+  ThunarRenamerModelPreview      *preview;
+  ThunarRenamerModelPreviewEntry *entries;
+  guint                           n_entries;
+}
+ThunarRenamerModelPreviewChunk;
+
 
 
 G_DEFINE_TYPE_WITH_CODE (ThunarRenamerModel, thunar_renamer_model, G_TYPE_OBJECT,
@@ -276,12 +346,12 @@ thunar_renamer_model_init (ThunarRenamerModel *renamer_model)
   renamer_model->stamp = g_random_int ();
 #endif
 
-  /* connect to the file monitor */
+  renamer_model->items = g_ptr_array_new ();
+  renamer_model->files = g_hash_table_new (g_direct_hash, g_direct_equal);
+  renamer_model->conflicts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* the files of the items are watched with the file monitor */
   renamer_model->file_monitor = thunar_file_monitor_get_default ();
-  g_signal_connect_swapped (G_OBJECT (renamer_model->file_monitor), "file-changed",
-                            G_CALLBACK (thunar_renamer_model_file_changed), renamer_model);
-  g_signal_connect_swapped (G_OBJECT (renamer_model->file_monitor), "file-destroyed",
-                            G_CALLBACK (thunar_renamer_model_file_destroyed), renamer_model);
 }
 
 
@@ -289,22 +359,40 @@ thunar_renamer_model_init (ThunarRenamerModel *renamer_model)
 static void
 thunar_renamer_model_finalize (GObject *object)
 {
-  ThunarRenamerModel *renamer_model = THUNAR_RENAMER_MODEL (object);
+  ThunarRenamerModelItem *item;
+  ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (object);
+  GHashTableIter          iter;
+  gpointer                items;
+  guint                   n;
 
   /* reset the renamer property (must be first!) */
   thunar_renamer_model_set_renamer (renamer_model, NULL);
 
-  /* release all items */
-  g_list_free_full (renamer_model->items, thunar_renamer_model_item_free);
+  /* drop a running preview */
+  thunar_renamer_model_preview_cancel (renamer_model);
 
-  /* disconnect from the file monitor */
-  g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->file_monitor), thunar_renamer_model_file_destroyed, renamer_model);
-  g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->file_monitor), thunar_renamer_model_file_changed, renamer_model);
+  /* release the conflicts table, its lists point to the items */
+  g_hash_table_iter_init (&iter, renamer_model->conflicts);
+  while (g_hash_table_iter_next (&iter, NULL, &items))
+    g_slist_free (items);
+  g_hash_table_destroy (renamer_model->conflicts);
+
+  /* stop watching the files and release all items */
+  for (n = 0; n < renamer_model->items->len; ++n)
+    {
+      item = g_ptr_array_index (renamer_model->items, n);
+      thunar_file_monitor_unwatch (renamer_model->file_monitor, item->file, renamer_model);
+      thunar_renamer_model_item_free (item);
+    }
+  g_ptr_array_free (renamer_model->items, TRUE);
+  g_hash_table_destroy (renamer_model->files);
+
+  /* release the file monitor */
   g_object_unref (G_OBJECT (renamer_model->file_monitor));
 
   /* be sure to cancel any pending update idle source (must be last!) */
   if (G_UNLIKELY (renamer_model->update_idle_id != 0))
-    g_source_remove (renamer_model->update_idle_id);
+    thunar_scheduler_remove (renamer_model->update_idle_id);
 
   (*G_OBJECT_CLASS (thunar_renamer_model_parent_class)->finalize) (object);
 }
@@ -426,15 +514,15 @@ thunar_renamer_model_get_iter (GtkTreeModel *tree_model,
                                GtkTreePath  *path)
 {
   ThunarRenamerModel *renamer_model = THUNAR_RENAMER_MODEL (tree_model);
-  GList              *lp;
+  gint                idx;
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), FALSE);
   _thunar_return_val_if_fail (gtk_tree_path_get_depth (path) > 0, FALSE);
 
-  lp = g_list_nth (renamer_model->items, gtk_tree_path_get_indices (path)[0]);
-  if (G_LIKELY (lp != NULL))
+  idx = gtk_tree_path_get_indices (path)[0];
+  if (G_LIKELY (idx >= 0 && (guint) idx < renamer_model->items->len))
     {
-      GTK_TREE_ITER_INIT (*iter, renamer_model->stamp, lp);
+      GTK_TREE_ITER_INIT (*iter, renamer_model->stamp, g_ptr_array_index (renamer_model->items, idx));
       return TRUE;
     }
 
@@ -447,18 +535,18 @@ static GtkTreePath*
 thunar_renamer_model_get_path (GtkTreeModel *tree_model,
                                GtkTreeIter  *iter)
 {
-  ThunarRenamerModel *renamer_model = THUNAR_RENAMER_MODEL (tree_model);
-  gint                idx;
+  ThunarRenamerModelItem *item = iter->user_data;
+  ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (tree_model);
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), NULL);
   _thunar_return_val_if_fail (iter->stamp == renamer_model->stamp, NULL);
 
-  /* determine the idx of the item */
-  idx = g_list_position (renamer_model->items, iter->user_data);
-  if (G_UNLIKELY (idx < 0))
+  /* the item must still be in the model */
+  if (G_UNLIKELY (item->idx >= renamer_model->items->len
+                  || g_ptr_array_index (renamer_model->items, item->idx) != item))
     return NULL;
 
-  return gtk_tree_path_new_from_indices (idx, -1);
+  return gtk_tree_path_new_from_indices (item->idx, -1);
 }
 
 
@@ -474,7 +562,7 @@ thunar_renamer_model_get_value (GtkTreeModel *tree_model,
   _thunar_return_if_fail (iter->stamp == THUNAR_RENAMER_MODEL (tree_model)->stamp);
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (tree_model));
 
-  item = g_list_nth_data (iter->user_data, 0);
+  item = iter->user_data;
 
   switch (column)
     {
@@ -520,10 +608,14 @@ static gboolean
 thunar_renamer_model_iter_next (GtkTreeModel *tree_model,
                                 GtkTreeIter  *iter)
 {
+  ThunarRenamerModel *renamer_model = THUNAR_RENAMER_MODEL (tree_model);
+  guint               idx;
+
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (tree_model), FALSE);
-  _thunar_return_val_if_fail (iter->stamp == THUNAR_RENAMER_MODEL (tree_model)->stamp, FALSE);
+  _thunar_return_val_if_fail (iter->stamp == renamer_model->stamp, FALSE);
 
-  iter->user_data = g_list_next (iter->user_data);
+  idx = THUNAR_RENAMER_MODEL_ITEM (iter->user_data)->idx + 1;
+  iter->user_data = (idx < renamer_model->items->len) ? g_ptr_array_index (renamer_model->items, idx) : NULL;
   return (iter->user_data != NULL);
 }
 
@@ -538,9 +630,9 @@ thunar_renamer_model_iter_children (GtkTreeModel *tree_model,
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), FALSE);
 
-  if (G_LIKELY (parent == NULL && renamer_model->items != NULL))
+  if (G_LIKELY (parent == NULL && renamer_model->items->len > 0))
     {
-      GTK_TREE_ITER_INIT (*iter, renamer_model->stamp, renamer_model->items);
+      GTK_TREE_ITER_INIT (*iter, renamer_model->stamp, g_ptr_array_index (renamer_model->items, 0));
       return TRUE;
     }
 
@@ -562,7 +654,7 @@ static gint
 thunar_renamer_model_iter_n_children (GtkTreeModel *tree_model,
                                       GtkTreeIter  *iter)
 {
-  return (iter == NULL) ? g_list_length (THUNAR_RENAMER_MODEL (tree_model)->items) : 0;
+  return (iter == NULL) ? (gint) THUNAR_RENAMER_MODEL (tree_model)->items->len : 0;
 }
 
 
@@ -577,10 +669,10 @@ thunar_renamer_model_iter_nth_child (GtkTreeModel *tree_model,
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), FALSE);
 
-  if (G_LIKELY (parent == NULL))
+  if (G_LIKELY (parent == NULL && n >= 0 && (guint) n < renamer_model->items->len))
     {
-      GTK_TREE_ITER_INIT (*iter, renamer_model->stamp, g_list_nth (renamer_model->items, n));
-      return (iter->user_data != NULL);
+      GTK_TREE_ITER_INIT (*iter, renamer_model->stamp, g_ptr_array_index (renamer_model->items, n));
+      return TRUE;
     }
 
   return FALSE;
@@ -599,14 +691,13 @@ thunar_renamer_model_iter_parent (GtkTreeModel *tree_model,
 
 
 static void
-thunar_renamer_model_file_changed (ThunarRenamerModel *renamer_model,
+thunar_renamer_model_file_changed (ThunarFileMonitor  *file_monitor,
                                    ThunarFile         *file,
-                                   ThunarFileMonitor  *file_monitor)
+                                   ThunarRenamerModel *renamer_model)
 {
   ThunarRenamerModelItem *item;
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  GList                  *lp;
   guint64                 date_changed;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
@@ -615,53 +706,48 @@ thunar_renamer_model_file_changed (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (renamer_model->file_monitor == file_monitor);
 
   /* check if we have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      {
-        item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-
-        /* check if the file changed on disk, this is done to prevent
-         * excessive looping when some renamers are used
-         * (thunar-media-tags-plugin is an example) */
-        date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
-        if (item->date_changed == date_changed)
-          break;
+  item = g_hash_table_lookup (renamer_model->files, file);
+  if (G_UNLIKELY (item == NULL))
+    return;
+
+  /* check if the file changed on disk, this is done to prevent
+   * excessive looping when some renamers are used
+   * (thunar-media-tags-plugin is an example) */
+  date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
+  if (item->date_changed == date_changed)
+    return;
 
-        /* check if we're frozen */
-        if (G_LIKELY (!renamer_model->frozen))
-          {
-            /* the file changed */
-            item->changed = TRUE;
+  /* check if we're frozen */
+  if (G_LIKELY (!renamer_model->frozen))
+    {
+      /* the file changed */
+      item->changed = TRUE;
 
-            /* set the new mtime */
-            item->date_changed = date_changed;
+      /* set the new mtime */
+      item->date_changed = date_changed;
 
-            /* invalidate the item */
-            thunar_renamer_model_invalidate_item (renamer_model, item);
-            break;
-          }
+      /* invalidate the item */
+      thunar_renamer_model_invalidate_item (renamer_model, item);
+      return;
+    }
 
-        /* determine the iter for the item */
-        GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+  /* determine the iter for the item */
+  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, item);
 
-        /* emit "row-changed" to display up2date file name */
-        path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-        gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-        gtk_tree_path_free (path);
-        break;
-      }
+  /* emit "row-changed" to display up2date file name */
+  path = gtk_tree_path_new_from_indices (item->idx, -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+  gtk_tree_path_free (path);
 }
 
 
 
 static void
-thunar_renamer_model_file_destroyed (ThunarRenamerModel *renamer_model,
+thunar_renamer_model_file_destroyed (ThunarFileMonitor  *file_monitor,
                                      ThunarFile         *file,
-                                     ThunarFileMonitor  *file_monitor)
+                                     ThunarRenamerModel *renamer_model)
 {
-  GtkTreePath *path;
-  GList       *lp;
-  gint         idx;
+  ThunarRenamerModelItem *item;
 
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
   _thunar_return_if_fail (renamer_model->file_monitor == file_monitor);
@@ -669,27 +755,55 @@ thunar_renamer_model_file_destroyed (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   /* check if we have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      {
-        /* determine the idx of the item */
-        idx = g_list_position (renamer_model->items, lp);
+  item = g_hash_table_lookup (renamer_model->files, file);
+  if (G_LIKELY (item != NULL))
+    {
+      /* drop the item */
+      thunar_renamer_model_remove_item (renamer_model, item);
 
-        /* free the item data */
-        thunar_renamer_model_item_free (lp->data);
+      /* invalidate all other items */
+      thunar_renamer_model_invalidate_all (renamer_model);
+    }
+}
 
-        /* drop the item from the list */
-        renamer_model->items = g_list_delete_link (renamer_model->items, lp);
 
-        /* tell the view that the item is gone */
-        path = gtk_tree_path_new_from_indices (idx, -1);
-        gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
-        gtk_tree_path_free (path);
 
-        /* invalidate all other items */
-        thunar_renamer_model_invalidate_all (renamer_model);
-        break;
-      }
+static void
+thunar_renamer_model_remove_item (ThunarRenamerModel     *renamer_model,
+                                  ThunarRenamerModelItem *item)
+{
+  GtkTreePath *path;
+  guint        idx = item->idx;
+
+  _thunar_return_if_fail (g_ptr_array_index (renamer_model->items, idx) == item);
+
+  /* free the item data */
+  thunar_file_monitor_unwatch (renamer_model->file_monitor, item->file, renamer_model);
+  thunar_renamer_model_conflict_remove (renamer_model, item);
+  g_hash_table_remove (renamer_model->files, item->file);
+  thunar_renamer_model_item_free (item);
+
+  /* drop the item from the array and move the following rows up */
+  g_ptr_array_remove_index (renamer_model->items, idx);
+  thunar_renamer_model_renumber (renamer_model, idx);
+
+  /* tell the view that the item is gone */
+  path = gtk_tree_path_new_from_indices (idx, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
+  gtk_tree_path_free (path);
+}
+
+
+
+static void
+thunar_renamer_model_renumber (ThunarRenamerModel *renamer_model,
+                               guint               first)
+{
+  guint n;
+
+  /* update the rows of the items starting at first */
+  for (n = first; n < renamer_model->items->len; ++n)
+    THUNAR_RENAMER_MODEL_ITEM (g_ptr_array_index (renamer_model->items, n))->idx = n;
 }
 
 
@@ -697,11 +811,14 @@ thunar_renamer_model_file_destroyed (ThunarRenamerModel *renamer_model,
 static void
 thunar_renamer_model_invalidate_all (ThunarRenamerModel *renamer_model)
 {
-  GList *lp;
+  guint n;
+
+  /* a running preview is outdated, even without items */
+  thunar_renamer_model_preview_cancel (renamer_model);
 
   /* invalidate all items in the model */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    thunar_renamer_model_invalidate_item (renamer_model, lp->data);
+  for (n = 0; n < renamer_model->items->len; ++n)
+    thunar_renamer_model_invalidate_item (renamer_model, g_ptr_array_index (renamer_model->items, n));
 }
 
 
@@ -710,15 +827,19 @@ static void
 thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
                                       ThunarRenamerModelItem *item)
 {
-  /* mark the item as dirty */
+  /* mark the item as dirty, dirty items never conflict */
   item->dirty = TRUE;
+  thunar_renamer_model_conflict_remove (renamer_model, item);
+
+  /* a running preview may hold the item */
+  thunar_renamer_model_preview_cancel (renamer_model);
 
   /* check if the update idle source is already running and not frozen */
   if (G_UNLIKELY (renamer_model->update_idle_id == 0 && !renamer_model->frozen))
     {
       /* schedule the update idle source */
-      renamer_model->update_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_renamer_model_update_idle,
-                                                       renamer_model, thunar_renamer_model_update_idle_destroy);
+      renamer_model->update_idle_id = thunar_scheduler_add_work (G_PRIORITY_LOW, thunar_renamer_model_update_idle,
+                                                                 renamer_model, thunar_renamer_model_update_idle_destroy);
 
       /* notify listeners that we're updating */
       g_object_notify (G_OBJECT (renamer_model), "can-rename");
@@ -727,27 +848,81 @@ thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
 
 
 
-static gboolean
-trm_same_directory (ThunarFile *a,
-                    ThunarFile *b)
+static gchar*
+thunar_renamer_model_conflict_key (ThunarRenamerModelItem *item)
+{
+  const gchar *name;
+  GFile       *parent;
+  gchar       *uri;
+  gchar       *key;
+
+  /* files without a parent cannot conflict */
+  parent = g_file_get_parent (thunar_file_get_file (item->file));
+  if (G_UNLIKELY (parent == NULL))
+    return NULL;
+
+  /* the uri is escaped, so the first newline separates the name */
+  name = (item->name != NULL) ? item->name : thunar_file_get_display_name (item->file);
+  uri = g_file_get_uri (parent);
+  key = g_strconcat (uri, "\n", name, NULL);
+  g_object_unref (parent);
+  g_free (uri);
+
+  return key;
+}
+
+
+
+static void
+thunar_renamer_model_conflict_changed (ThunarRenamerModel     *renamer_model,
+                                       ThunarRenamerModelItem *item,
+                                       gboolean                conflict)
+{
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+
+  /* apply the new state */
+  item->conflict = conflict;
+
+  /* determine iter for the item */
+  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, item);
+
+  /* emit "row-changed" for the item */
+  path = gtk_tree_path_new_from_indices (item->idx, -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+  gtk_tree_path_free (path);
+}
+
+
+
+static void
+thunar_renamer_model_conflict_remove (ThunarRenamerModel     *renamer_model,
+                                      ThunarRenamerModelItem *item)
 {
-  GFile    *parent_a;
-  GFile    *parent_b;
-  gboolean  result;
+  ThunarRenamerModelItem *oitem;
+  GSList                 *items;
 
-  /* determine the parent paths for both files */
-  parent_a = g_file_get_parent (thunar_file_get_file (a));
-  parent_b = g_file_get_parent (thunar_file_get_file (b));
+  if (item->conflict_key == NULL)
+    return;
 
-  /* check if both files have the same parent */
-  result = (parent_a != NULL && parent_b != NULL && g_file_equal (parent_a, parent_b));
+  items = g_hash_table_lookup (renamer_model->conflicts, item->conflict_key);
+  items = g_slist_remove (items, item);
+  if (items == NULL)
+    {
+      g_hash_table_remove (renamer_model->conflicts, item->conflict_key);
+    }
+  else
+    {
+      g_hash_table_insert (renamer_model->conflicts, g_strdup (item->conflict_key), items);
 
-  if (parent_a != NULL)
-    g_object_unref (parent_a);
-  if (parent_b != NULL)
-    g_object_unref (parent_b);
+      /* the last item with this name no longer conflicts */
+      oitem = THUNAR_RENAMER_MODEL_ITEM (items->data);
+      if (items->next == NULL && oitem->conflict)
+        thunar_renamer_model_conflict_changed (renamer_model, oitem, FALSE);
+    }
 
-  return result;
+  g_free (item->conflict_key);
+  item->conflict_key = NULL;
 }
 
 
@@ -757,80 +932,78 @@ thunar_renamer_model_conflict_item (ThunarRenamerModel     *renamer_model,
                                     ThunarRenamerModelItem *item)
 {
   ThunarRenamerModelItem *oitem;
-  GtkTreePath            *path;
-  GtkTreeIter             iter;
-  gboolean                conflict = FALSE;
-  GList                  *lp;
+  GSList                 *items;
+  GSList                 *lp;
+
+  /* forget the previous name of the item */
+  thunar_renamer_model_conflict_remove (renamer_model, item);
+
+  item->conflict_key = thunar_renamer_model_conflict_key (item);
+  if (G_UNLIKELY (item->conflict_key == NULL))
+    return FALSE;
 
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
+  /* all other up to date items with the same name in the
+   * same directory conflict with this item */
+  items = g_hash_table_lookup (renamer_model->conflicts, item->conflict_key);
+  for (lp = items; lp != NULL; lp = lp->next)
     {
-      /* check if this item is dirty or the item we're about to check */
+      /* check if the other item is already in conflict state */
       oitem = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-      if (G_UNLIKELY (oitem == item || oitem->dirty))
-        continue;
+      if (G_LIKELY (!oitem->conflict))
+        thunar_renamer_model_conflict_changed (renamer_model, oitem, TRUE);
+    }
 
-      /* check if this other item conflicts with the item in question (can only conflict if in same directory) */
-      if (trm_same_directory (item->file, oitem->file)
-          && ((item->name != NULL && oitem->name == NULL && strcmp (item->name, thunar_file_get_display_name (oitem->file)) == 0)
-           || (item->name == NULL && oitem->name != NULL && strcmp (thunar_file_get_display_name (item->file), oitem->name) == 0)
-           || (item->name != NULL && oitem->name != NULL && strcmp (item->name, oitem->name) == 0)))
-        {
-          /* check if the other item is already in conflict state */
-          if (G_LIKELY (!oitem->conflict))
-            {
-              /* set to conflict state */
-              oitem->conflict = TRUE;
+  g_hash_table_insert (renamer_model->conflicts, g_strdup (item->conflict_key),
+                       g_slist_prepend (items, item));
 
-              /* determine iter for other item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+  return (items != NULL);
+}
 
-              /* emit "row-changed" for the other item */
-              path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
 
-          /* this item conflicts */
-          conflict = TRUE;
-        }
-    }
 
-  return conflict;
+static gchar*
+thunar_renamer_model_process_text (ThunarxRenamer *renamer,
+                                   gconstpointer   snapshot,
+                                   ThunarFile     *file,
+                                   const gchar    *text,
+                                   guint           idx)
+{
+  if (snapshot != NULL)
+    return thunarx_renamer_process_snapshot (renamer, snapshot, THUNARX_FILE_INFO (file), text, idx);
+  else
+    return thunarx_renamer_process (renamer, THUNARX_FILE_INFO (file), text, idx);
 }
 
 
 
+/* this is also used from the preview threads, with a snapshot, so
+ * it must not touch the model or the current renamer settings */
 static gchar*
-thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
-                                   ThunarRenamerModelItem *item,
-                                   guint                   idx)
+thunar_renamer_model_process_name (ThunarxRenamer    *renamer,
+                                   gconstpointer      snapshot,
+                                   ThunarRenamerMode  renamer_mode,
+                                   ThunarFile        *file,
+                                   const gchar       *display_name,
+                                   guint              idx)
 {
   ThunarRenamerMode mode;
-  const gchar      *display_name;
   const gchar      *dot;
   gchar            *name = NULL;
   gchar            *prefix;
   gchar            *suffix;
   gchar            *text;
 
-  /* no new name if no renamer is set */
-  if (G_UNLIKELY (renamer_model->renamer == NULL))
-    return NULL;
-
-  /* determine the current display name of the file */
-  display_name = thunar_file_get_display_name (item->file);
-
   /* determine the extension in the filename */
   dot = thunar_util_str_get_extension (display_name);
 
   /* if we don't have a dot, then no "Suffix only" rename can take place */
-  if (G_LIKELY (dot != NULL || renamer_model->mode != THUNAR_RENAMER_MODE_SUFFIX))
+  if (G_LIKELY (dot != NULL || renamer_mode != THUNAR_RENAMER_MODE_SUFFIX))
     {
       /* now, for "Name only", we need a dot, otherwise treat everything as name */
-      if (renamer_model->mode == THUNAR_RENAMER_MODE_NAME && dot == NULL)
+      if (renamer_mode == THUNAR_RENAMER_MODE_NAME && dot == NULL)
         mode = THUNAR_RENAMER_MODE_BOTH;
       else
-        mode = renamer_model->mode;
+        mode = renamer_mode;
 
       /* determine the new name according to the mode */
       switch (mode)
@@ -840,7 +1013,7 @@ thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
           text = g_strndup (display_name, (dot - display_name));
 
           /* determine the new name */
-          prefix = thunarx_renamer_process (renamer_model->renamer, THUNARX_FILE_INFO (item->file), text, idx);
+          prefix = thunar_renamer_model_process_text (renamer, snapshot, file, text, idx);
 
           /* determine the new full name */
           name = g_strconcat (prefix, dot, NULL);
@@ -852,7 +1025,7 @@ thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
 
         case THUNAR_RENAMER_MODE_SUFFIX:
           /* determine the new suffix */
-          suffix = thunarx_renamer_process (renamer_model->renamer, THUNARX_FILE_INFO (item->file), dot + 1, idx);
+          suffix = thunar_renamer_model_process_text (renamer, snapshot, file, dot + 1, idx);
 
           prefix = g_strndup (display_name, (dot - display_name) + 1);
           name = g_strconcat (prefix, suffix, NULL);
@@ -864,7 +1037,7 @@ thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
 
         case THUNAR_RENAMER_MODE_BOTH:
           /* determine the new full name */
-          name = thunarx_renamer_process (renamer_model->renamer, THUNARX_FILE_INFO (item->file), display_name, idx);
+          name = thunar_renamer_model_process_text (renamer, snapshot, file, display_name, idx);
           break;
 
         default:
@@ -886,29 +1059,303 @@ thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
 
 
 
+static gchar*
+thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
+                                   ThunarRenamerModelItem *item,
+                                   guint                   idx)
+{
+  /* no new name if no renamer is set */
+  if (G_UNLIKELY (renamer_model->renamer == NULL))
+    return NULL;
+
+  return thunar_renamer_model_process_name (renamer_model->renamer, NULL, renamer_model->mode,
+                                            item->file, thunar_file_get_display_name (item->file), idx);
+}
+
+
+
+static void
+thunar_renamer_model_preview_unref (ThunarRenamerModelPreview *preview)
+{
+  if (--preview->ref_count > 0)
+    return;
+
+  thunarx_renamer_free_snapshot (preview->renamer, preview->snapshot);
+  g_object_unref (preview->renamer);
+  g_object_unref (preview->cancellable);
+  g_slice_free (ThunarRenamerModelPreview, preview);
+}
+
+
+
+static void
+thunar_renamer_model_preview_chunk_free (ThunarRenamerModelPreviewChunk *chunk)
+{
+  guint n;
+
+  for (n = 0; n < chunk->n_entries; ++n)
+    {
+      g_object_unref (chunk->entries[n].file);
+      g_free (chunk->entries[n].display_name);
+      g_free (chunk->entries[n].name);
+    }
+
+  thunar_renamer_model_preview_unref (chunk->preview);
+  g_free (chunk->entries);
+  g_slice_free (ThunarRenamerModelPreviewChunk, chunk);
+}
+
+
+
+static void
+thunar_renamer_model_preview_merge_chunk (ThunarRenamerModelPreviewChunk *chunk)
+{
+  ThunarRenamerModelPreviewEntry *entry;
+  ThunarRenamerModelPreview      *preview = chunk->preview;
+  ThunarRenamerModelItem         *item;
+  ThunarRenamerModel             *renamer_model = preview->renamer_model;
+  GtkTreePath                    *path;
+  GtkTreeIter                     iter;
+  gboolean                        changed;
+  gboolean                        conflict;
+  guint                           n;
+
+  for (n = 0; n < chunk->n_entries; ++n)
+    {
+      entry = &chunk->entries[n];
+      item = entry->item;
+
+      /* same as in thunar_renamer_model_update_idle() */
+      changed = item->changed;
+      item->changed = FALSE;
+      item->dirty = FALSE;
+
+      if (!exo_str_is_equal (item->name, entry->name))
+        {
+          g_free (item->name);
+          item->name = entry->name;
+          entry->name = NULL;
+          changed = TRUE;
+        }
+
+      conflict = thunar_renamer_model_conflict_item (renamer_model, item);
+      if (item->conflict != conflict)
+        {
+          item->conflict = conflict;
+          changed = TRUE;
+        }
+
+      if (G_LIKELY (changed))
+        {
+          GTK_TREE_ITER_INIT (iter, renamer_model->stamp, item);
+          path = gtk_tree_path_new_from_indices (item->idx, -1);
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+          gtk_tree_path_free (path);
+        }
+    }
+}
+
+
+
 static gboolean
-thunar_renamer_model_update_idle (gpointer user_data)
+thunar_renamer_model_preview_merge (gpointer user_data)
+{
+  ThunarRenamerModelPreviewChunk *chunk = user_data;
+  ThunarRenamerModelPreview      *preview = chunk->preview;
+  ThunarRenamerModel             *renamer_model = preview->renamer_model;
+
+THUNAR_THREADS_ENTER
+
+  /* a cancelled preview no longer belongs to the model */
+  if (!g_cancellable_is_cancelled (preview->cancellable))
+    {
+      thunar_renamer_model_preview_merge_chunk (chunk);
+
+      /* the model is up to date once the last chunk is merged */
+      if (--preview->n_pending == 0)
+        {
+          renamer_model->preview = NULL;
+          thunar_renamer_model_preview_unref (preview);
+          g_object_notify (G_OBJECT (renamer_model), "can-rename");
+        }
+    }
+
+  thunar_renamer_model_preview_chunk_free (chunk);
+
+THUNAR_THREADS_LEAVE
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_renamer_model_preview_worker (gpointer data,
+                                     gpointer user_data)
+{
+  ThunarRenamerModelPreviewEntry *entry;
+  ThunarRenamerModelPreviewChunk *chunk = data;
+  ThunarRenamerModelPreview      *preview = chunk->preview;
+  guint                           n;
+
+  for (n = 0; n < chunk->n_entries; ++n)
+    {
+      /* stale results are dropped anyway */
+      if (g_cancellable_is_cancelled (preview->cancellable))
+        break;
+
+      entry = &chunk->entries[n];
+      entry->name = thunar_renamer_model_process_name (preview->renamer, preview->snapshot, preview->mode,
+                                                       entry->file, entry->display_name, entry->idx);
+    }
+
+  /* hand the chunk back to the main thread */
+  g_idle_add_full (G_PRIORITY_LOW, thunar_renamer_model_preview_merge, chunk, NULL);
+}
+
+
+
+static void
+thunar_renamer_model_preview_push (ThunarRenamerModelPreview      *preview,
+                                   ThunarRenamerModelPreviewChunk *chunk)
+{
+  static GThreadPool *pool = NULL;
+
+  /* the pool is shared by all models */
+  if (G_UNLIKELY (pool == NULL))
+    {
+      pool = g_thread_pool_new (thunar_renamer_model_preview_worker, NULL,
+                                CLAMP (g_get_num_processors (), 1, THUNAR_RENAMER_MODEL_PREVIEW_MAX_THREADS),
+                                FALSE, NULL);
+    }
+
+  chunk->preview = preview;
+  preview->ref_count++;
+  preview->n_pending++;
+
+  g_thread_pool_push (pool, chunk, NULL);
+}
+
+
+
+static gboolean
+thunar_renamer_model_preview_start (ThunarRenamerModel *renamer_model)
+{
+  ThunarRenamerModelPreviewChunk *chunk = NULL;
+  ThunarRenamerModelPreviewEntry *entry;
+  ThunarRenamerModelPreview      *preview;
+  ThunarRenamerModelItem         *item;
+  gpointer                        snapshot;
+  guint                           idx;
+
+  _thunar_return_val_if_fail (renamer_model->preview == NULL, FALSE);
+
+  if (renamer_model->renamer == NULL || !thunarx_renamer_supports_snapshots (renamer_model->renamer))
+    return FALSE;
+
+  /* the renamer may not support its current settings in a snapshot */
+  snapshot = thunarx_renamer_snapshot (renamer_model->renamer);
+  if (G_UNLIKELY (snapshot == NULL))
+    return FALSE;
+
+  preview = g_slice_new0 (ThunarRenamerModelPreview);
+  preview->renamer_model = renamer_model;
+  preview->renamer = g_object_ref (renamer_model->renamer);
+  preview->snapshot = snapshot;
+  preview->mode = renamer_model->mode;
+  preview->cancellable = g_cancellable_new ();
+  preview->ref_count = 1;
+
+  /* copy the dirty items, so the threads never look at the model */
+  for (idx = 0; idx < renamer_model->items->len; ++idx)
+    {
+      item = g_ptr_array_index (renamer_model->items, idx);
+      if (G_LIKELY (!item->dirty))
+        continue;
+
+      if (chunk == NULL)
+        {
+          chunk = g_slice_new0 (ThunarRenamerModelPreviewChunk);
+          chunk->entries = g_new0 (ThunarRenamerModelPreviewEntry, THUNAR_RENAMER_MODEL_PREVIEW_CHUNK_SIZE);
+        }
+
+      entry = &chunk->entries[chunk->n_entries++];
+      entry->item = item;
+      entry->file = g_object_ref (item->file);
+      entry->display_name = g_strdup (thunar_file_get_display_name (item->file));
+      entry->idx = idx;
+
+      if (chunk->n_entries == THUNAR_RENAMER_MODEL_PREVIEW_CHUNK_SIZE)
+        {
+          thunar_renamer_model_preview_push (preview, chunk);
+          chunk = NULL;
+        }
+    }
+
+  if (chunk != NULL)
+    thunar_renamer_model_preview_push (preview, chunk);
+
+  /* nothing to do */
+  if (preview->n_pending == 0)
+    {
+      thunar_renamer_model_preview_unref (preview);
+      return FALSE;
+    }
+
+  renamer_model->preview = preview;
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_renamer_model_preview_cancel (ThunarRenamerModel *renamer_model)
+{
+  if (G_LIKELY (renamer_model->preview == NULL))
+    return;
+
+  /* the pending chunks release their references when they come back */
+  g_cancellable_cancel (renamer_model->preview->cancellable);
+  thunar_renamer_model_preview_unref (renamer_model->preview);
+  renamer_model->preview = NULL;
+}
+
+
+
+static gboolean
+thunar_renamer_model_update_idle (gpointer user_data,
+                                  gint64   deadline)
 {
   ThunarRenamerModelItem *item;
   ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (user_data);
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  gboolean                changed = FALSE;
+  gboolean                more = FALSE;
+  gboolean                changed;
   gboolean                conflict;
   guint                   idx;
   gchar                  *name;
-  GList                  *lp;
 
 THUNAR_THREADS_ENTER
 
-  /* don't do anything if the model is frozen */
-  if (G_LIKELY (!renamer_model->frozen))
+  /* don't do anything if the model is frozen, or the
+   * items are processed in the background */
+  if (G_LIKELY (!renamer_model->frozen && renamer_model->preview == NULL
+                && !thunar_renamer_model_preview_start (renamer_model)))
     {
-      /* process the first dirty item */
-      for (idx = 0, lp = renamer_model->items; !changed && lp != NULL; ++idx, lp = lp->next)
+      /* process the dirty items until the slice is used up, the next
+       * slice starts over because items may become dirty in between */
+      for (idx = 0; idx < renamer_model->items->len; ++idx)
         {
+          if (g_get_monotonic_time () >= deadline)
+            {
+              more = TRUE;
+              break;
+            }
+
           /* check if this item is dirty */
-          item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+          item = g_ptr_array_index (renamer_model->items, idx);
           if (G_LIKELY (!item->dirty))
             continue;
 
@@ -951,7 +1398,7 @@ THUNAR_THREADS_ENTER
           if (G_LIKELY (changed))
             {
               /* generate the iter for the item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, item);
 
               /* emit "row-changed" for this item */
               path = gtk_tree_path_new_from_indices (idx, -1);
@@ -963,8 +1410,8 @@ THUNAR_THREADS_ENTER
 
 THUNAR_THREADS_LEAVE
 
-  /* keep the idle source as long as any item changed */
-  return changed;
+  /* keep the task until all items were processed */
+  return more;
 }
 
 
@@ -1002,6 +1449,7 @@ thunar_renamer_model_item_free (gpointer data)
   ThunarRenamerModelItem *item = data;
 
   g_object_unref (G_OBJECT (item->file));
+  g_free (item->conflict_key);
   g_free (item->name);
   g_slice_free (ThunarRenamerModelItem, item);
 }
@@ -1033,8 +1481,8 @@ thunar_renamer_model_cmp_name (gconstpointer pointer_a,
 {
   const SortTuple              *tuple_a = pointer_a;
   const SortTuple              *tuple_b = pointer_b;
-  const ThunarRenamerModelItem *a = tuple_a->item->data;
-  const ThunarRenamerModelItem *b = tuple_b->item->data;
+  const ThunarRenamerModelItem *a = tuple_a->item;
+  const ThunarRenamerModelItem *b = tuple_b->item;
   GtkSortType                   sort_order = GPOINTER_TO_INT (user_data);
   gint                          result;
 
@@ -1079,22 +1527,26 @@ thunar_renamer_model_new (void)
 static gboolean
 thunar_renamer_model_get_can_rename (ThunarRenamerModel *renamer_model)
 {
-  gboolean can_rename = FALSE;
-  GList   *lp;
+  ThunarRenamerModelItem *item;
+  gboolean                can_rename = FALSE;
+  guint                   n;
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), FALSE);
 
-  if (G_LIKELY (renamer_model->renamer != NULL && !renamer_model->frozen && renamer_model->update_idle_id == 0))
+  if (G_LIKELY (renamer_model->renamer != NULL && !renamer_model->frozen
+                && renamer_model->update_idle_id == 0 && renamer_model->preview == NULL))
     {
       /* check if atleast one item has a new name and no conflicts exist */
-      for (lp = renamer_model->items; lp != NULL; lp = lp->next)
+      for (n = 0; n < renamer_model->items->len; ++n)
         {
+          item = g_ptr_array_index (renamer_model->items, n);
+
           /* check if we have a conflict here */
-          if (G_UNLIKELY (THUNAR_RENAMER_MODEL_ITEM (lp->data)->conflict))
+          if (G_UNLIKELY (item->conflict))
             return FALSE;
 
           /* check if the item has a new name */
-          if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->name != NULL)
+          if (item->name != NULL)
             can_rename = TRUE;
         }
     }
@@ -1152,7 +1604,10 @@ thunar_renamer_model_set_frozen (ThunarRenamerModel *renamer_model,
         {
           /* cancel any pending update idle source */
           if (G_UNLIKELY (renamer_model->update_idle_id != 0))
-            g_source_remove (renamer_model->update_idle_id);
+            thunar_scheduler_remove (renamer_model->update_idle_id);
+
+          /* the items stay dirty until the model is thawed */
+          thunar_renamer_model_preview_cancel (renamer_model);
         }
       else
         {
@@ -1293,36 +1748,107 @@ void
 thunar_renamer_model_insert (ThunarRenamerModel *renamer_model,
                              ThunarFile         *file,
                              gint                position)
+{
+  GList files = { file, NULL, NULL };
+
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  thunar_renamer_model_insert_files (renamer_model, &files, position);
+}
+
+
+
+/**
+ * thunar_renamer_model_insert_files:
+ * @renamer_model : a #ThunarRenamerModel.
+ * @files         : a #GList of #ThunarFile<!---->s.
+ * @position      : the position in the model. 0 is prepend, -1 is append.
+ *
+ * Inserts the @files, which are not in the @renamer_model yet, at
+ * @position in the order of the list. The rows are added in one
+ * go and the names of the items are updated in a single pass
+ * afterwards, so this should be used for many files instead of
+ * calling thunar_renamer_model_insert() for every file.
+ **/
+void
+thunar_renamer_model_insert_files (ThunarRenamerModel *renamer_model,
+                                   GList              *files,
+                                   gint                position)
 {
   ThunarRenamerModelItem *item;
   GtkTreePath            *path;
   GtkTreeIter             iter;
+  GPtrArray              *items;
   GList                  *lp;
+  guint                   n_items;
+  guint                   first;
+  guint                   n;
 
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
-  _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  /* check if we already have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      return;
+  n_items = renamer_model->items->len;
+  first = (position < 0 || (guint) position > n_items) ? n_items : (guint) position;
+
+  /* allocate the items for the files we do not have yet */
+  items = g_ptr_array_new ();
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      _thunar_assert (THUNAR_IS_FILE (lp->data));
 
-  /* allocate a new item for the file */
-  item = thunar_renamer_model_item_new (file);
+      if (g_hash_table_contains (renamer_model->files, lp->data))
+        continue;
 
-  /* append the item to the model */
-  renamer_model->items = g_list_insert (renamer_model->items, item, position);
+      item = thunar_renamer_model_item_new (lp->data);
+      g_hash_table_insert (renamer_model->files, item->file, item);
+      g_ptr_array_add (items, item);
 
-  /* determine the iterator for the new item */
-  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_list_find (renamer_model->items, item));
+      /* only hear about changes of the files we have */
+      thunar_file_monitor_watch (renamer_model->file_monitor, item->file,
+                                 THUNAR_FILE_MONITOR_WATCH_FILE,
+                                 (ThunarFileMonitorFunc) thunar_renamer_model_file_changed,
+                                 (ThunarFileMonitorFunc) thunar_renamer_model_file_destroyed,
+                                 renamer_model);
+    }
+
+  if (G_UNLIKELY (items->len == 0))
+    {
+      g_ptr_array_free (items, TRUE);
+      return;
+    }
 
-  /* emit the "row-inserted" signal */
-  path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (renamer_model), path, &iter);
+  /* move the rows after the position down and put the new items in between */
+  g_ptr_array_set_size (renamer_model->items, n_items + items->len);
+  memmove (renamer_model->items->pdata + first + items->len,
+           renamer_model->items->pdata + first,
+           (n_items - first) * sizeof (gpointer));
+  memcpy (renamer_model->items->pdata + first, items->pdata, items->len * sizeof (gpointer));
+  thunar_renamer_model_renumber (renamer_model, first);
+
+  /* tell the view about the new rows, top to bottom, so every path
+   * is valid for the rows the view knows at that time */
+  path = gtk_tree_path_new_from_indices (first, -1);
+  for (n = 0; n < items->len; ++n)
+    {
+      GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_ptr_array_index (items, n));
+      gtk_tree_model_row_inserted (GTK_TREE_MODEL (renamer_model), path, &iter);
+      gtk_tree_path_next (path);
+    }
   gtk_tree_path_free (path);
 
-  /* invalidate the newly added item */
-  thunar_renamer_model_invalidate_item (renamer_model, item);
+  /* the new items need a name, and all following items if their
+   * position changed, since the renamer may number the files */
+  if (first == n_items)
+    {
+      for (n = 0; n < items->len; ++n)
+        thunar_renamer_model_invalidate_item (renamer_model, g_ptr_array_index (items, n));
+    }
+  else
+    {
+      thunar_renamer_model_invalidate_all (renamer_model);
+    }
+
+  g_ptr_array_free (items, TRUE);
 }
 
 
@@ -1342,7 +1868,7 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
                               GList              *tree_paths,
                               gint                position)
 {
-  GList       *lp, *lprev;
+  GList       *lp;
   gint         n_items;
   gint        *new_order;
   GtkTreePath *path;
@@ -1352,7 +1878,7 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
 
   /* leave when there is nothing to sort */
-  n_items = g_list_length (renamer_model->items);
+  n_items = renamer_model->items->len;
   if (G_UNLIKELY (n_items <= 1))
     return;
 
@@ -1365,12 +1891,18 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
 
   /* be sure to not overuse the stack */
   if (G_LIKELY (n_items < 500))
-    sort_array = g_newa (SortTuple, n_items);
+    {
+      sort_array = g_newa (SortTuple, n_items);
+      new_order = g_newa (gint, n_items);
+    }
   else
-    sort_array = g_new (SortTuple, n_items);
+    {
+      sort_array = g_new (SortTuple, n_items);
+      new_order = g_new (gint, n_items);
+    }
 
   /* generate the sort array of tuples */
-  for (lp = renamer_model->items, m = 0, n = 0; lp != NULL; lp = lp->next, ++n, ++m)
+  for (m = 0, n = 0; n < n_items; ++n, ++m)
     {
       /* leave a hole in the sort position for the drop items */
       if (G_UNLIKELY (tree_paths != NULL
@@ -1378,7 +1910,7 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
         m++;
 
       sort_array[n].offset = n;
-      sort_array[n].item = lp;
+      sort_array[n].item = g_ptr_array_index (renamer_model->items, n);
       sort_array[n].position = m;
     }
 
@@ -1396,25 +1928,14 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
     g_qsort_with_data (sort_array, n_items, sizeof (SortTuple), thunar_renamer_model_cmp_name, GINT_TO_POINTER (position));
 
   /* update our internals and generate the new order */
-  new_order = g_newa (gint, n_items);
-  for (n = 0, lprev = NULL; n < n_items; ++n)
+  for (n = 0; n < n_items; ++n)
     {
       /* set the new order in the sort list */
       new_order[n] = sort_array[n].offset;
 
-      /* reinsert the item in the list */
-      lp = sort_array[n].item;
-      lp->next = NULL;
-      lp->prev = lprev;
-
-      /* hookup the item in the list */
-      if (G_LIKELY (lprev != NULL))
-        lprev->next = lp;
-      else
-        renamer_model->items = lp;
-
-      /* advance the offset */
-      lprev = lp;
+      /* put the item in its new row */
+      g_ptr_array_index (renamer_model->items, n) = sort_array[n].item;
+      sort_array[n].item->idx = n;
     }
 
   /* tell the view about the new item order */
@@ -1427,7 +1948,10 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
 
   /* cleanup if we used the heap */
   if (G_UNLIKELY (n_items >= 500))
-    g_free (sort_array);
+    {
+      g_free (sort_array);
+      g_free (new_order);
+    }
 }
 
 
@@ -1461,6 +1985,9 @@ thunar_renamer_model_sort (ThunarRenamerModel *renamer_model,
 void
 thunar_renamer_model_clear (ThunarRenamerModel *renamer_model)
 {
+  GHashTableIter iter;
+  gpointer       items;
+
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
 
   /* grab an additional reference on the model */
@@ -1469,14 +1996,24 @@ thunar_renamer_model_clear (ThunarRenamerModel *renamer_model)
   /* freeze notifications */
   g_object_freeze_notify (G_OBJECT (renamer_model));
 
-  /* delete all items from the model */
-  while (renamer_model->items != NULL)
+  /* all items go away, so nobody is left to conflict with */
+  g_hash_table_iter_init (&iter, renamer_model->conflicts);
+  while (g_hash_table_iter_next (&iter, NULL, &items))
+    g_slist_free (items);
+  g_hash_table_remove_all (renamer_model->conflicts);
+
+  /* delete all items from the model, starting at the
+   * end, so no rows have to be moved */
+  while (renamer_model->items->len > 0)
     {
-      /* just use the "file-destroyed" handler here to drop the first item */
-      thunar_renamer_model_file_destroyed (renamer_model, THUNAR_RENAMER_MODEL_ITEM (renamer_model->items->data)->file,
-                                           renamer_model->file_monitor);
+      thunar_renamer_model_remove_item (renamer_model,
+                                        g_ptr_array_index (renamer_model->items,
+                                                           renamer_model->items->len - 1));
     }
 
+  /* a running preview is outdated */
+  thunar_renamer_model_invalidate_all (renamer_model);
+
   /* thaw notifications */
   g_object_thaw_notify (G_OBJECT (renamer_model));
 
@@ -1498,26 +2035,19 @@ void
 thunar_renamer_model_remove (ThunarRenamerModel *renamer_model,
                              GtkTreePath        *path)
 {
-  GList *lp;
+  gint idx;
 
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
   _thunar_return_if_fail (gtk_tree_path_get_depth (path) == 1);
 
-  /* determine the list item for the path and verify that its valid */
-  lp = g_list_nth (renamer_model->items, gtk_tree_path_get_indices (path)[0]);
-  if (G_UNLIKELY (lp == NULL))
+  /* determine the item for the path and verify that its valid */
+  idx = gtk_tree_path_get_indices (path)[0];
+  if (G_UNLIKELY (idx < 0 || (guint) idx >= renamer_model->items->len))
     return;
 
-  /* free the item data */
-  thunar_renamer_model_item_free (lp->data);
-
-  /* drop the item from the list */
-  renamer_model->items = g_list_delete_link (renamer_model->items, lp);
-
-  /* tell the view that the item is gone */
-  gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
+  /* drop the item */
+  thunar_renamer_model_remove_item (renamer_model, g_ptr_array_index (renamer_model->items, idx));
 
   /* invalidate all other items */
   thunar_renamer_model_invalidate_all (renamer_model);
 }
-
@@ -68,6 +68,9 @@ void                 thunar_renamer_model_set_renamer    (ThunarRenamerModel *re
 void                 thunar_renamer_model_insert         (ThunarRenamerModel *renamer_model,
                                                           ThunarFile         *file,
                                                           gint                position);
+void                 thunar_renamer_model_insert_files   (ThunarRenamerModel *renamer_model,
+                                                          GList              *files,
+                                                          gint                position);
 void                 thunar_renamer_model_reorder        (ThunarRenamerModel *renamer_model,
                                                           GList              *tree_paths,
                                                           gint                position);
@@ -21,12 +21,24 @@
 #include <config.h>
 #endif
 
+#include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-renamer-progress.h>
 #include <thunar/thunar-util.h>
 
 
 
+/* The renames are executed by a pool of worker threads. Renames that
+ * need the name of another file in the list wait until that file got
+ * out of the way, and cycles are broken by moving one file in each
+ * cycle to a temporary name first. The files are updated in batches from
+ * the main thread, once the workers finished or before asking the user.
+ */
+#define THUNAR_RENAMER_PROGRESS_MAX_THREADS (8)
+#define THUNAR_RENAMER_PROGRESS_INTERVAL    (100) /* ms */
+
+
+
 /* Signal identifiers */
 enum
 {
@@ -36,8 +48,14 @@ enum
 
 
 
+typedef struct _ThunarRenamerNode ThunarRenamerNode;
+
+
+
 static void     thunar_renamer_progress_finalize          (GObject                    *object);
 static void     thunar_renamer_progress_destroy           (GtkWidget                  *object);
+static void     thunar_renamer_progress_worker            (gpointer                    data,
+                                                           gpointer                    user_data);
 static gboolean thunar_renamer_progress_next_idle         (gpointer                    user_data);
 static void     thunar_renamer_progress_next_idle_destroy (gpointer                    user_data);
 
@@ -55,15 +73,50 @@ struct _ThunarRenamerProgress
 
   GList       *pairs_done;
   guint        n_pairs_done;
-  GList       *pairs_todo;
-  guint        n_pairs_todo;
   gboolean     pairs_undo;  /* whether we're undoing previous changes */
 
+  /* the renames of the current run */
+  GPtrArray   *nodes;
+  guint        n_nodes_finished;
+  GList       *nodes_renamed; /* renamed, but the files are not updated yet */
+  GList       *nodes_failed;  /* failed, but not reported to the user yet */
+
+  /* the workers, the lock protects the fields below */
+  GThreadPool  *pool;
+  GCancellable *cancellable;
+  GMutex        lock;
+  GList        *nodes_finished;
+  GList        *nodes_deferred;
+  guint         n_nodes_running;
+  gboolean      paused;
+
   /* internal main loop for the _rename() method */
   guint        next_idle_id;
   GMainLoop   *next_idle_loop;
 };
 
+struct _ThunarRenamerNode
+{
+  /* only used from the main thread */
+  ThunarRenamerPair *pair;
+  ThunarRenamerNode *blocker;
+  guint              mark;
+
+  /* not modified while the node is queued */
+  GFile             *source;
+  gchar             *name;
+  gchar             *oldname;
+  gchar             *temp_name;
+  ThunarRenamerNode *dependent; /* waits for this node to leave its name */
+
+  /* the results, set by the workers */
+  GFile             *temp;
+  GFile             *location;
+  GFileInfo         *info;
+  GError            *error;
+  gboolean           finished;
+};
+
 
 
 G_DEFINE_TYPE (ThunarRenamerProgress, thunar_renamer_progress, GTK_TYPE_BOX)
@@ -94,6 +147,8 @@ thunar_renamer_progress_init (ThunarRenamerProgress *renamer_progress)
   gtk_widget_set_hexpand (renamer_progress->bar, TRUE);
   gtk_container_add (GTK_CONTAINER (renamer_progress), renamer_progress->bar);
   gtk_widget_show (renamer_progress->bar);
+
+  g_mutex_init (&renamer_progress->lock);
 }
 
 
@@ -106,10 +161,12 @@ thunar_renamer_progress_finalize (GObject *object)
   /* make sure we're not finalized while the main loop is active */
   _thunar_assert (renamer_progress->next_idle_id == 0);
   _thunar_assert (renamer_progress->next_idle_loop == NULL);
+  _thunar_assert (renamer_progress->nodes == NULL);
 
   /* release the pairs */
   thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
+
+  g_mutex_clear (&renamer_progress->lock);
 
   (*G_OBJECT_CLASS (thunar_renamer_progress_parent_class)->finalize) (object);
 }
@@ -129,148 +186,474 @@ thunar_renamer_progress_destroy (GtkWidget *object)
 
 
 
-static gboolean
-thunar_renamer_progress_next_idle (gpointer user_data)
+static ThunarRenamerNode*
+thunar_renamer_node_new (ThunarRenamerPair *pair)
+{
+  ThunarRenamerNode *node;
+
+  node = g_slice_new0 (ThunarRenamerNode);
+  node->pair = pair;
+  node->source = g_object_ref (thunar_file_get_file (pair->file));
+  node->name = g_strdup (pair->name);
+  node->oldname = g_strdup (thunar_file_get_display_name (pair->file));
+
+  return node;
+}
+
+
+
+static void
+thunar_renamer_node_free (gpointer data)
+{
+  ThunarRenamerNode *node = data;
+
+  if (node->pair != NULL)
+    thunar_renamer_pair_free (node->pair);
+
+  if (node->temp != NULL)
+    g_object_unref (node->temp);
+  if (node->location != NULL)
+    g_object_unref (node->location);
+  if (node->info != NULL)
+    g_object_unref (node->info);
+  if (node->error != NULL)
+    g_error_free (node->error);
+
+  g_object_unref (node->source);
+  g_free (node->name);
+  g_free (node->oldname);
+  g_free (node->temp_name);
+  g_slice_free (ThunarRenamerNode, node);
+}
+
+
+
+static void
+thunar_renamer_node_move (ThunarRenamerNode *node)
+{
+  /* update the file if it was moved */
+  if (node->location != NULL && !g_file_equal (node->location, thunar_file_get_file (node->pair->file)))
+    thunar_file_finish_rename (node->pair->file, node->location, node->info);
+}
+
+
+
+static void
+thunar_renamer_progress_push_locked (ThunarRenamerProgress *renamer_progress,
+                                     ThunarRenamerNode     *node)
+{
+  if (node == NULL || node->finished)
+    return;
+
+  /* hold back new renames while we're waiting for the user */
+  if (G_UNLIKELY (renamer_progress->paused))
+    {
+      renamer_progress->nodes_deferred = g_list_prepend (renamer_progress->nodes_deferred, node);
+    }
+  else
+    {
+      renamer_progress->n_nodes_running++;
+      g_thread_pool_push (renamer_progress->pool, node, NULL);
+    }
+}
+
+
+
+static void
+thunar_renamer_progress_worker (gpointer data,
+                                gpointer user_data)
 {
   ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (user_data);
-  ThunarRenamerPair     *pair;
-  GtkWindow             *toplevel;
-  GtkWidget             *message;
+  ThunarRenamerNode     *node = data;
+  GFileInfo             *info = NULL;
   GError                *error = NULL;
-  gchar                 *oldname;
-  gchar                  text[128];
-  gint                   response;
-  guint                  n_done;
-  guint                  n_total;
-  GList                 *first;
+  GFile                 *location;
 
-THUNAR_THREADS_ENTER
+  /* nothing to do once the run is over */
+  if (G_UNLIKELY (g_cancellable_is_cancelled (renamer_progress->cancellable)))
+    {
+      g_mutex_lock (&renamer_progress->lock);
+      renamer_progress->n_nodes_running--;
+      g_mutex_unlock (&renamer_progress->lock);
+      return;
+    }
+
+  /* the first file of a cycle leaves its name to the others first */
+  if (node->temp_name != NULL && node->temp == NULL)
+    {
+      location = g_file_set_display_name (node->source, node->temp_name, renamer_progress->cancellable, &error);
 
-  /* check if we have still pairs to go */
-  if (G_LIKELY (renamer_progress->pairs_todo != NULL))
+      g_mutex_lock (&renamer_progress->lock);
+      if (G_LIKELY (location != NULL))
+        {
+          node->temp = location;
+          thunar_renamer_progress_push_locked (renamer_progress, node->dependent);
+        }
+      else
+        {
+          node->error = error;
+          node->finished = TRUE;
+          renamer_progress->nodes_finished = g_list_prepend (renamer_progress->nodes_finished, node);
+        }
+      renamer_progress->n_nodes_running--;
+      g_mutex_unlock (&renamer_progress->lock);
+      return;
+    }
+
+  /* try to rename the file */
+  location = g_file_set_display_name (node->temp != NULL ? node->temp : node->source,
+                                      node->name, renamer_progress->cancellable, &error);
+
+  /* don't leave the temporary name behind */
+  if (G_UNLIKELY (location == NULL && node->temp != NULL))
     {
-      /* pop the first pair from the todo list */
-      first = g_list_first (renamer_progress->pairs_todo);
-      pair = first->data;
-      renamer_progress->pairs_todo = g_list_delete_link (renamer_progress->pairs_todo, first);
+      location = g_file_set_display_name (node->temp, node->oldname, NULL, NULL);
+      if (location == NULL)
+        location = g_object_ref (node->temp);
+    }
+
+  /* query the information here, so the main thread doesn't have to */
+  if (location != NULL)
+    info = g_file_query_info (location, THUNARX_FILE_INFO_NAMESPACE, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+  g_mutex_lock (&renamer_progress->lock);
+  node->location = location;
+  node->info = info;
+  node->error = error;
+  node->finished = TRUE;
+  renamer_progress->nodes_finished = g_list_prepend (renamer_progress->nodes_finished, node);
 
-      /* update item count */
-      renamer_progress->n_pairs_todo--;
-      _thunar_assert (g_list_length (renamer_progress->pairs_todo) == renamer_progress->n_pairs_todo);
+  /* the file waiting for our name can go now, after a
+   * failure it will fail too and tell the user about it */
+  if (node->temp == NULL)
+    thunar_renamer_progress_push_locked (renamer_progress, node->dependent);
 
-      /* determine the done/todo items */
-      n_done = renamer_progress->n_pairs_done + 1;
-      n_total = n_done + renamer_progress->n_pairs_todo;
+  renamer_progress->n_nodes_running--;
+  g_mutex_unlock (&renamer_progress->lock);
+}
 
-      /* update the progress bar text */
-      g_snprintf (text, sizeof (text), "%d/%d", n_done, n_total);
-      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
 
-      /* update the progress bar fraction */
-      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP ((gdouble) n_done / MAX (n_total, 1), 0.0, 1.0));
 
-      /* remember the old file name (for undo) */
-      oldname = g_strdup (thunar_file_get_display_name (pair->file));
+static void
+thunar_renamer_progress_plan (ThunarRenamerProgress *renamer_progress,
+                              GList                 *pairs)
+{
+  ThunarRenamerNode *node;
+  ThunarRenamerNode *blocker;
+  GHashTable        *sources;
+  GFile             *parent;
+  GFile             *target;
+  GList             *lp;
+  guint              n;
+
+  _thunar_return_if_fail (renamer_progress->nodes == NULL);
+
+  renamer_progress->nodes = g_ptr_array_new_with_free_func (thunar_renamer_node_free);
+  renamer_progress->n_nodes_finished = 0;
+
+  /* take over the pairs */
+  sources = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  for (lp = pairs; lp != NULL; lp = lp->next)
+    {
+      node = thunar_renamer_node_new (lp->data);
+      g_ptr_array_add (renamer_progress->nodes, node);
+      g_hash_table_insert (sources, node->source, node);
+    }
+  g_list_free (pairs);
 
-      /* try to rename the file */
-      if (!thunar_file_rename (pair->file, pair->name, NULL, FALSE, &error))
+  /* find the files that currently have the new name of another file */
+  for (n = 0; n < renamer_progress->nodes->len; ++n)
+    {
+      node = g_ptr_array_index (renamer_progress->nodes, n);
+
+      parent = g_file_get_parent (node->source);
+      if (G_UNLIKELY (parent == NULL))
+        continue;
+
+      target = g_file_get_child_for_display_name (parent, node->name, NULL);
+      if (G_LIKELY (target != NULL))
         {
-          /* determine the toplevel widget */
-          toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
-
-          /* tell the user that we failed */
-          message = gtk_message_dialog_new (toplevel,
-                                            GTK_DIALOG_DESTROY_WITH_PARENT
-                                            | GTK_DIALOG_MODAL,
-                                            GTK_MESSAGE_ERROR,
-                                            GTK_BUTTONS_NONE,
-                                            _("Failed to rename \"%s\" to \"%s\"."),
-                                            oldname, pair->name);
-
-          /* check if we should provide undo */
-          if (!renamer_progress->pairs_undo && renamer_progress->pairs_done != NULL)
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
-                                                        _("You can either choose to skip this file and continue to rename the "
-                                                          "remaining files, or revert the previously renamed files to their "
-                                                          "previous names, or cancel the operation without reverting previous "
-                                                          "changes."));
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Revert Changes"), GTK_RESPONSE_REJECT);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
-              gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
-            }
-          else if (renamer_progress->pairs_todo != NULL)
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
-                                                        _("Do you want to skip this file and continue to rename the "
-                                                          "remaining files?"));
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
-              gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
-            }
-          else
+          blocker = g_hash_table_lookup (sources, target);
+          if (blocker != NULL && blocker != node && blocker->dependent == NULL)
             {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message), "%s.", error->message);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Close"), GTK_RESPONSE_CANCEL);
+              node->blocker = blocker;
+              blocker->dependent = node;
             }
+          g_object_unref (target);
+        }
+      g_object_unref (parent);
+    }
+  g_hash_table_destroy (sources);
 
-          /* run the dialog */
-          response = gtk_dialog_run (GTK_DIALOG (message));
-          if (response == GTK_RESPONSE_REJECT)
-            {
-              /* undo previous changes */
-              renamer_progress->pairs_undo = TRUE;
+  /* every file waits for at most one other file, so following the
+   * blockers either ends or runs into a cycle, which is broken by
+   * moving the file where the cycle was found to a temporary name */
+  for (n = 0; n < renamer_progress->nodes->len; ++n)
+    {
+      for (node = g_ptr_array_index (renamer_progress->nodes, n); node != NULL && node->mark == 0; node = node->blocker)
+        node->mark = n + 1;
 
-              /* release the todo pairs and use the done as todo */
-              thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-              renamer_progress->pairs_todo = renamer_progress->pairs_done;
-              renamer_progress->pairs_done = NULL;
+      if (node != NULL && node->mark == n + 1)
+        node->temp_name = g_strdup_printf (".thunar-rename-%08x", g_random_int ());
+    }
+
+  /* start with the files that are not waiting for another file */
+  g_mutex_lock (&renamer_progress->lock);
+  for (n = 0; n < renamer_progress->nodes->len; ++n)
+    {
+      node = g_ptr_array_index (renamer_progress->nodes, n);
+      if (node->blocker == NULL || node->temp_name != NULL)
+        thunar_renamer_progress_push_locked (renamer_progress, node);
+    }
+  g_mutex_unlock (&renamer_progress->lock);
+}
 
-              renamer_progress->n_pairs_done = 0;
-              renamer_progress->n_pairs_todo = g_list_length (renamer_progress->pairs_todo);
-            }
-          else if (response != GTK_RESPONSE_ACCEPT)
-            {
-              /* canceled, just exit the main loop */
-              g_main_loop_quit (renamer_progress->next_idle_loop);
-            }
 
-          /* release the pair */
-          thunar_renamer_pair_free (pair);
 
-          /* destroy the dialog */
-          gtk_widget_destroy (message);
+static void
+thunar_renamer_progress_collect (ThunarRenamerProgress *renamer_progress)
+{
+  ThunarRenamerNode *node;
+  GList             *finished;
+  GList             *lp;
 
-          /* clear the error */
-          g_clear_error (&error);
+  g_mutex_lock (&renamer_progress->lock);
+  finished = g_list_reverse (renamer_progress->nodes_finished);
+  renamer_progress->nodes_finished = NULL;
+  g_mutex_unlock (&renamer_progress->lock);
 
-          /* release old name */
-          g_free (oldname);
-        }
+  for (lp = finished; lp != NULL; lp = lp->next)
+    {
+      node = lp->data;
+      if (G_UNLIKELY (node->error != NULL))
+        renamer_progress->nodes_failed = g_list_prepend (renamer_progress->nodes_failed, node);
       else
+        renamer_progress->nodes_renamed = g_list_prepend (renamer_progress->nodes_renamed, node);
+      renamer_progress->n_nodes_finished++;
+    }
+  renamer_progress->nodes_failed = g_list_reverse (renamer_progress->nodes_failed);
+  g_list_free (finished);
+}
+
+
+
+static void
+thunar_renamer_progress_apply (ThunarRenamerProgress *renamer_progress)
+{
+  ThunarRenamerNode *node;
+  GList             *lp;
+
+  for (lp = g_list_last (renamer_progress->nodes_renamed); lp != NULL; lp = lp->prev)
+    {
+      node = lp->data;
+      thunar_renamer_node_move (node);
+
+      /* replace the newname with the oldname for the pair (-> undo) */
+      g_free (node->pair->name);
+      node->pair->name = node->oldname;
+      node->oldname = NULL;
+
+      /* move the pair to the list of completed pairs */
+      renamer_progress->pairs_done = g_list_prepend (renamer_progress->pairs_done, node->pair);
+      renamer_progress->n_pairs_done++;
+      node->pair = NULL;
+    }
+
+  g_list_free (renamer_progress->nodes_renamed);
+  renamer_progress->nodes_renamed = NULL;
+}
+
+
+
+static void
+thunar_renamer_progress_release (ThunarRenamerProgress *renamer_progress)
+{
+  ThunarRenamerNode *node;
+  GFile             *location;
+  guint              n;
+
+  _thunar_return_if_fail (renamer_progress->n_nodes_running == 0);
+
+  /* files moved out of a cycle that was never completed get their name back */
+  for (n = 0; n < renamer_progress->nodes->len; ++n)
+    {
+      node = g_ptr_array_index (renamer_progress->nodes, n);
+      if (G_UNLIKELY (node->temp != NULL && !node->finished))
         {
-          /* replace the newname with the oldname for the pair (-> undo) */
-          g_free (pair->name);
-          pair->name = oldname;
+          location = g_file_set_display_name (node->temp, node->oldname, NULL, NULL);
+          if (location == NULL)
+            thunar_file_finish_rename (node->pair->file, node->temp, NULL);
+          else
+            g_object_unref (location);
+        }
+    }
+
+  g_list_free (renamer_progress->nodes_failed);
+  renamer_progress->nodes_failed = NULL;
+  g_list_free (renamer_progress->nodes_deferred);
+  renamer_progress->nodes_deferred = NULL;
+  renamer_progress->paused = FALSE;
+
+  g_ptr_array_free (renamer_progress->nodes, TRUE);
+  renamer_progress->nodes = NULL;
+}
 
-          /* move the pair to the list of completed pairs */
-          renamer_progress->pairs_done = g_list_prepend (renamer_progress->pairs_done, pair);
 
-          /* update counter */
-          renamer_progress->n_pairs_done++;
-          _thunar_assert (g_list_length (renamer_progress->pairs_done) == renamer_progress->n_pairs_done);
+
+static void
+thunar_renamer_progress_report (ThunarRenamerProgress *renamer_progress,
+                                ThunarRenamerNode     *node)
+{
+  GtkWindow *toplevel;
+  GtkWidget *message;
+  GList     *lp;
+  gint       response;
+
+  /* the file may have ended up somewhere else */
+  thunar_renamer_node_move (node);
+
+  /* determine the toplevel widget */
+  toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
+
+  /* tell the user that we failed */
+  message = gtk_message_dialog_new (toplevel,
+                                    GTK_DIALOG_DESTROY_WITH_PARENT
+                                    | GTK_DIALOG_MODAL,
+                                    GTK_MESSAGE_ERROR,
+                                    GTK_BUTTONS_NONE,
+                                    _("Failed to rename \"%s\" to \"%s\"."),
+                                    node->oldname, node->name);
+
+  /* check if we should provide undo */
+  if (!renamer_progress->pairs_undo && renamer_progress->pairs_done != NULL)
+    {
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
+                                                _("You can either choose to skip this file and continue to rename the "
+                                                  "remaining files, or revert the previously renamed files to their "
+                                                  "previous names, or cancel the operation without reverting previous "
+                                                  "changes."));
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Revert Changes"), GTK_RESPONSE_REJECT);
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
+      gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
+    }
+  else if (renamer_progress->n_nodes_finished < renamer_progress->nodes->len
+           || renamer_progress->nodes_failed != NULL)
+    {
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
+                                                _("Do you want to skip this file and continue to rename the "
+                                                  "remaining files?"));
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
+      gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
+    }
+  else
+    {
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message), "%s.", node->error->message);
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Close"), GTK_RESPONSE_CANCEL);
+    }
+
+  /* run the dialog */
+  response = gtk_dialog_run (GTK_DIALOG (message));
+  if (response == GTK_RESPONSE_REJECT)
+    {
+      /* undo previous changes */
+      renamer_progress->pairs_undo = TRUE;
+
+      /* drop the remaining renames and use the done pairs instead */
+      thunar_renamer_progress_release (renamer_progress);
+      thunar_renamer_progress_plan (renamer_progress, renamer_progress->pairs_done);
+      renamer_progress->pairs_done = NULL;
+      renamer_progress->n_pairs_done = 0;
+    }
+  else if (response == GTK_RESPONSE_ACCEPT)
+    {
+      /* continue with the held back renames after the last failure */
+      if (renamer_progress->nodes_failed == NULL)
+        {
+          g_mutex_lock (&renamer_progress->lock);
+          renamer_progress->paused = FALSE;
+          for (lp = renamer_progress->nodes_deferred; lp != NULL; lp = lp->next)
+            thunar_renamer_progress_push_locked (renamer_progress, lp->data);
+          g_list_free (renamer_progress->nodes_deferred);
+          renamer_progress->nodes_deferred = NULL;
+          g_mutex_unlock (&renamer_progress->lock);
         }
     }
+  else
+    {
+      /* canceled, just exit the main loop */
+      g_main_loop_quit (renamer_progress->next_idle_loop);
+    }
 
-  /* be sure to cancel the internal loop once we're done */
-  if (G_UNLIKELY (renamer_progress->pairs_todo == NULL))
-    g_main_loop_quit (renamer_progress->next_idle_loop);
+  /* destroy the dialog */
+  gtk_widget_destroy (message);
+}
+
+
+
+static gboolean
+thunar_renamer_progress_next_idle (gpointer user_data)
+{
+  ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (user_data);
+  ThunarRenamerNode     *node;
+  gchar                  text[128];
+  guint                  n_done;
+  guint                  n_total;
+  guint                  n_running;
+
+THUNAR_THREADS_ENTER
+
+  /* once no worker is busy, all results are available below */
+  g_mutex_lock (&renamer_progress->lock);
+  n_running = renamer_progress->n_nodes_running;
+  g_mutex_unlock (&renamer_progress->lock);
+
+  /* pick up the renames finished by the workers */
+  thunar_renamer_progress_collect (renamer_progress);
+
+  /* determine the done/todo items */
+  n_done = renamer_progress->n_nodes_finished;
+  n_total = renamer_progress->nodes->len;
+
+  /* update the progress bar text */
+  g_snprintf (text, sizeof (text), "%d/%d", n_done, n_total);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
+
+  /* update the progress bar fraction */
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP ((gdouble) n_done / MAX (n_total, 1), 0.0, 1.0));
+
+  /* hold back new renames until the user was asked */
+  if (G_UNLIKELY (renamer_progress->nodes_failed != NULL))
+    {
+      g_mutex_lock (&renamer_progress->lock);
+      renamer_progress->paused = TRUE;
+      g_mutex_unlock (&renamer_progress->lock);
+    }
+
+  /* wait for the renames in progress before updating the files */
+  if (n_running == 0)
+    {
+      thunar_renamer_progress_apply (renamer_progress);
+
+      if (renamer_progress->nodes_failed != NULL)
+        {
+          /* ask the user about the first failure */
+          node = renamer_progress->nodes_failed->data;
+          renamer_progress->nodes_failed = g_list_delete_link (renamer_progress->nodes_failed, renamer_progress->nodes_failed);
+          thunar_renamer_progress_report (renamer_progress, node);
+        }
+      else if (renamer_progress->nodes_deferred == NULL)
+        {
+          /* be sure to cancel the internal loop once we're done */
+          g_main_loop_quit (renamer_progress->next_idle_loop);
+        }
+    }
 
 THUNAR_THREADS_LEAVE
 
-  /* keep the idle source alive as long as we have anything to do */
-  return (renamer_progress->pairs_todo != NULL);
+  /* keep the source alive as long as we have anything to do */
+  return g_main_loop_is_running (renamer_progress->next_idle_loop);
 }
 
 
@@ -348,6 +731,9 @@ void
 thunar_renamer_progress_run (ThunarRenamerProgress *renamer_progress,
                              GList                 *pairs)
 {
+  ThunarRenamerPair *pair;
+  guint              max_threads = 1;
+
   _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
 
   /* make sure we're not already renaming */
@@ -362,15 +748,26 @@ thunar_renamer_progress_run (ThunarRenamerProgress *renamer_progress,
   thunar_renamer_pair_list_free (renamer_progress->pairs_done);
   renamer_progress->pairs_done = NULL;
   renamer_progress->n_pairs_done = 0;
+  renamer_progress->pairs_undo = FALSE;
+
+  /* renaming in parallel only pays off on fast storage */
+  if (G_LIKELY (pairs != NULL))
+    {
+      pair = pairs->data;
+      max_threads = thunar_io_jobs_util_get_max_threads (thunar_file_get_file (pair->file), NULL,
+                                                         THUNAR_RENAMER_PROGRESS_MAX_THREADS, NULL);
+    }
 
-  /* set the pairs on the todo list */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-  renamer_progress->pairs_todo = thunar_renamer_pair_list_copy (pairs);
-  renamer_progress->n_pairs_todo = g_list_length (renamer_progress->pairs_todo);
+  /* start the workers on the pairs */
+  renamer_progress->cancellable = g_cancellable_new ();
+  renamer_progress->pool = g_thread_pool_new (thunar_renamer_progress_worker, renamer_progress,
+                                              MAX (max_threads, 1), FALSE, NULL);
+  thunar_renamer_progress_plan (renamer_progress, thunar_renamer_pair_list_copy (pairs));
 
   /* schedule the idle source */
-  renamer_progress->next_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_renamer_progress_next_idle,
-                                                    renamer_progress, thunar_renamer_progress_next_idle_destroy);
+  renamer_progress->next_idle_id = g_timeout_add_full (G_PRIORITY_LOW, THUNAR_RENAMER_PROGRESS_INTERVAL,
+                                                       thunar_renamer_progress_next_idle, renamer_progress,
+                                                       thunar_renamer_progress_next_idle_destroy);
 
   /* run the inner main loop */
   renamer_progress->next_idle_loop = g_main_loop_new (NULL, FALSE);
@@ -382,16 +779,21 @@ thunar_renamer_progress_run (ThunarRenamerProgress *renamer_progress,
   if (G_UNLIKELY (renamer_progress->next_idle_id != 0))
     g_source_remove (renamer_progress->next_idle_id);
 
+  /* stop the workers, and update the files that were renamed in the meantime */
+  g_cancellable_cancel (renamer_progress->cancellable);
+  g_thread_pool_free (renamer_progress->pool, FALSE, TRUE);
+  renamer_progress->pool = NULL;
+  thunar_renamer_progress_collect (renamer_progress);
+  thunar_renamer_progress_apply (renamer_progress);
+  g_list_foreach (renamer_progress->nodes_failed, (GFunc) thunar_renamer_node_move, NULL);
+  thunar_renamer_progress_release (renamer_progress);
+  g_object_unref (renamer_progress->cancellable);
+  renamer_progress->cancellable = NULL;
+
   /* release the list of completed items */
   thunar_renamer_pair_list_free (renamer_progress->pairs_done);
   renamer_progress->pairs_done = NULL;
 
-  /* release the list of todo items */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-  renamer_progress->pairs_todo = NULL;
-
   /* release the additional reference on the progress */
   g_object_unref (G_OBJECT (renamer_progress));
 }
-
-
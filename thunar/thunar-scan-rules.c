@@ -0,0 +1,237 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-pattern.h>
+#include <thunar/thunar-preferences.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-scan-rules.h>
+
+
+
+/* The scan rules name the heavy subtrees, like "node_modules" or the
+ * ".snapshot" folders of a NAS, which searches and folder size counts
+ * do not enter. A set of rules is immutable once created, so the jobs
+ * take a reference on the main thread and match the names of their
+ * folders with it on their worker threads. New rules are created when
+ * the preferences change; running jobs keep the rules they started
+ * with.
+ */
+
+
+
+struct _ThunarScanRules
+{
+  gint            ref_count;
+
+  ThunarPattern **patterns;
+  guint           n_patterns;
+
+  guint           same_filesystem : 1;
+};
+
+
+
+/* the rules for the current preferences, only used in the main thread */
+static ThunarScanRules *scan_rules_current = NULL;
+
+
+
+G_DEFINE_BOXED_TYPE (ThunarScanRules, thunar_scan_rules, thunar_scan_rules_ref, thunar_scan_rules_unref)
+
+
+
+static void
+thunar_scan_rules_changed (ThunarPreferences *preferences)
+{
+  /* created again on the next call to thunar_scan_rules_get() */
+  if (scan_rules_current != NULL)
+    {
+      thunar_scan_rules_unref (scan_rules_current);
+      scan_rules_current = NULL;
+    }
+}
+
+
+
+static ThunarScanRules*
+thunar_scan_rules_new (ThunarPreferences *preferences)
+{
+  ThunarScanRules *rules;
+  gboolean         same_filesystem;
+  gchar          **exclusions;
+  guint            n;
+
+  g_object_get (G_OBJECT (preferences),
+                "misc-scan-exclusions", &exclusions,
+                "misc-scan-same-filesystem", &same_filesystem,
+                NULL);
+
+  rules = g_slice_new0 (ThunarScanRules);
+  rules->ref_count = 1;
+  rules->same_filesystem = same_filesystem;
+
+  if (exclusions != NULL)
+    {
+      rules->patterns = g_new (ThunarPattern *, g_strv_length (exclusions));
+      for (n = 0; exclusions[n] != NULL; ++n)
+        if (*exclusions[n] != '\0')
+          rules->patterns[rules->n_patterns++] = thunar_pattern_new (exclusions[n], TRUE);
+      g_strfreev (exclusions);
+    }
+
+  return rules;
+}
+
+
+
+/**
+ * thunar_scan_rules_get:
+ *
+ * Returns the #ThunarScanRules for the current preferences. Must be
+ * called on the main thread, the returned rules can then be used on
+ * any thread.
+ *
+ * The caller is responsible to free the returned rules using
+ * thunar_scan_rules_unref() when no longer needed.
+ *
+ * Return value: the current #ThunarScanRules.
+ **/
+ThunarScanRules*
+thunar_scan_rules_get (void)
+{
+  ThunarPreferences *preferences;
+  static gboolean    connected = FALSE;
+
+  if (G_UNLIKELY (scan_rules_current == NULL))
+    {
+      /* the preferences are kept alive by the application */
+      preferences = thunar_preferences_get ();
+      if (!connected)
+        {
+          g_signal_connect (G_OBJECT (preferences), "notify::misc-scan-exclusions",
+                            G_CALLBACK (thunar_scan_rules_changed), NULL);
+          g_signal_connect (G_OBJECT (preferences), "notify::misc-scan-same-filesystem",
+                            G_CALLBACK (thunar_scan_rules_changed), NULL);
+          connected = TRUE;
+        }
+      scan_rules_current = thunar_scan_rules_new (preferences);
+      g_object_unref (G_OBJECT (preferences));
+    }
+
+  return thunar_scan_rules_ref (scan_rules_current);
+}
+
+
+
+/**
+ * thunar_scan_rules_ref:
+ * @rules : a #ThunarScanRules.
+ *
+ * Increments the reference count on @rules by 1 and returns
+ * @rules. Can be called on any thread.
+ *
+ * Return value: @rules.
+ **/
+ThunarScanRules*
+thunar_scan_rules_ref (ThunarScanRules *rules)
+{
+  _thunar_return_val_if_fail (rules != NULL, NULL);
+  _thunar_return_val_if_fail (rules->ref_count > 0, NULL);
+
+  g_atomic_int_inc (&rules->ref_count);
+
+  return rules;
+}
+
+
+
+/**
+ * thunar_scan_rules_unref:
+ * @rules : a #ThunarScanRules.
+ *
+ * Decrements the reference count on @rules by 1 and frees @rules
+ * once it drops to zero. Can be called on any thread.
+ **/
+void
+thunar_scan_rules_unref (ThunarScanRules *rules)
+{
+  guint n;
+
+  _thunar_return_if_fail (rules != NULL);
+  _thunar_return_if_fail (rules->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&rules->ref_count))
+    {
+      for (n = 0; n < rules->n_patterns; ++n)
+        thunar_pattern_free (rules->patterns[n]);
+      g_free (rules->patterns);
+      g_slice_free (ThunarScanRules, rules);
+    }
+}
+
+
+
+/**
+ * thunar_scan_rules_excludes:
+ * @rules : a #ThunarScanRules.
+ * @name  : the name of a folder.
+ *
+ * Checks whether the folder @name is excluded by @rules, so its
+ * contents are neither searched nor counted.
+ *
+ * Return value: %TRUE if the folder @name must be skipped.
+ **/
+gboolean
+thunar_scan_rules_excludes (const ThunarScanRules *rules,
+                            const gchar           *name)
+{
+  guint n;
+
+  _thunar_return_val_if_fail (rules != NULL, FALSE);
+  _thunar_return_val_if_fail (name != NULL, FALSE);
+
+  for (n = 0; n < rules->n_patterns; ++n)
+    if (thunar_pattern_match (rules->patterns[n], name))
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_scan_rules_get_same_filesystem:
+ * @rules : a #ThunarScanRules.
+ *
+ * Returns whether searches with @rules stay on the filesystem of
+ * the folder they start in.
+ *
+ * Return value: %TRUE to skip the mounts below the folder.
+ **/
+gboolean
+thunar_scan_rules_get_same_filesystem (const ThunarScanRules *rules)
+{
+  _thunar_return_val_if_fail (rules != NULL, FALSE);
+  return rules->same_filesystem;
+}
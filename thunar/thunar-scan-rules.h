@@ -0,0 +1,44 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SCAN_RULES_H__
+#define __THUNAR_SCAN_RULES_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarScanRules ThunarScanRules;
+
+#define THUNAR_TYPE_SCAN_RULES (thunar_scan_rules_get_type ())
+
+GType            thunar_scan_rules_get_type             (void) G_GNUC_CONST;
+
+ThunarScanRules *thunar_scan_rules_get                  (void);
+ThunarScanRules *thunar_scan_rules_ref                  (ThunarScanRules       *rules);
+void             thunar_scan_rules_unref                (ThunarScanRules       *rules);
+
+gboolean         thunar_scan_rules_excludes             (const ThunarScanRules *rules,
+                                                         const gchar           *name);
+gboolean         thunar_scan_rules_get_same_filesystem  (const ThunarScanRules *rules);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_SCAN_RULES_H__ */
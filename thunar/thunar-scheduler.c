@@ -0,0 +1,696 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-scheduler.h>
+
+
+
+/* Many objects need a timeout or an idle callback of their own: a
+ * reload of every file, the sweep timer of the icon factory, the
+ * thumbnail timer of every view and so on. As GSources they make every
+ * main loop iteration prepare and check all of them. The scheduler
+ * keeps them in two GSources instead:
+ *
+ * - a hierarchical timer wheel with THUNAR_SCHEDULER_LEVELS levels of
+ *   THUNAR_SCHEDULER_SLOTS slots each. A slot of the first level covers
+ *   one tick, a slot of the next level covers all the slots of the
+ *   previous one. Timers are moved down a level when the wheel reaches
+ *   their slot, so adding, removing and expiring a timer is O(1) and the
+ *   wheel only wakes up when something expires or has to move down.
+ *
+ * - a ready queue per priority, holding the idle tasks and the expired
+ *   timers. A queue runs its tasks in order until its budget, by default
+ *   THUNAR_SCHEDULER_BUDGET, is used up and then lets the main loop draw
+ *   a frame, so a burst of tasks doesn't block the user interface.
+ *   Incremental work, such as applying the results of a folder load, is
+ *   added with thunar_scheduler_add_work(). It gets the end of the slice
+ *   and does as much as fits, instead of one item per callback or
+ *   everything at once.
+ *
+ * The functions can be called from any thread, the tasks always run in
+ * the main loop. Like g_source_remove(), thunar_scheduler_remove() calls
+ * the GDestroyNotify right away, or after the callback returned when the
+ * task is running.
+ */
+
+
+
+/* the resolution of the timer wheel in milliseconds */
+#define THUNAR_SCHEDULER_TICK        (16)
+
+/* the number of slots per level of the timer wheel */
+#define THUNAR_SCHEDULER_SLOTS_SHIFT (6)
+#define THUNAR_SCHEDULER_SLOTS       (1 << THUNAR_SCHEDULER_SLOTS_SHIFT)
+#define THUNAR_SCHEDULER_SLOTS_MASK  (THUNAR_SCHEDULER_SLOTS - 1)
+
+/* the number of levels, 3 levels cover about 70 minutes */
+#define THUNAR_SCHEDULER_LEVELS      (3)
+
+/* the default time in microseconds a ready queue may run per main loop iteration */
+#define THUNAR_SCHEDULER_BUDGET      (4 * 1000)
+
+
+
+typedef struct _ThunarSchedulerTask  ThunarSchedulerTask;
+typedef struct _ThunarSchedulerQueue ThunarSchedulerQueue;
+
+
+
+static void     thunar_scheduler_make_ready        (ThunarSchedulerTask *task);
+static gboolean thunar_scheduler_wheel_dispatch    (GSource             *source,
+                                                    GSourceFunc          callback,
+                                                    gpointer             user_data);
+static gboolean thunar_scheduler_queue_dispatch    (GSource             *source,
+                                                    GSourceFunc          callback,
+                                                    gpointer             user_data);
+
+
+
+struct _ThunarSchedulerTask
+{
+  guint                   id;
+  gint                    priority;
+
+  /* the interval in ticks and the tick of the next expiry, for timers */
+  guint                   interval;
+  gint64                  expires;
+
+  /* one of them is set */
+  GSourceFunc             func;
+  ThunarSchedulerWorkFunc work;
+
+  gpointer                data;
+  GDestroyNotify          notify;
+
+  /* the wheel slot or the ready queue the task is linked into */
+  GQueue                 *queue;
+  GList                   link;
+
+  guint                   in_wheel : 1;
+  guint                   running : 1;
+  guint                   removed : 1;
+};
+
+struct _ThunarSchedulerQueue
+{
+  GSource        __parent__;
+  GQueue         tasks;
+  guint          budget;
+};
+
+
+
+static GSourceFuncs thunar_scheduler_wheel_funcs =
+{
+  NULL, NULL, thunar_scheduler_wheel_dispatch, NULL, NULL, NULL
+};
+
+static GSourceFuncs thunar_scheduler_queue_funcs =
+{
+  NULL, NULL, thunar_scheduler_queue_dispatch, NULL, NULL, NULL
+};
+
+
+
+/* protects everything below, the callbacks run unlocked */
+G_LOCK_DEFINE_STATIC (scheduler);
+
+/* maps the ids to the tasks */
+static GHashTable *scheduler_tasks = NULL;
+static guint       scheduler_next_id = 1;
+
+/* maps the priorities to the ready queues */
+static GHashTable *scheduler_queues = NULL;
+
+/* the timer wheel */
+static GSource    *scheduler_wheel_source = NULL;
+static GQueue      scheduler_wheel[THUNAR_SCHEDULER_LEVELS][THUNAR_SCHEDULER_SLOTS];
+static gint64      scheduler_wheel_tick = 0;
+static guint       scheduler_n_timers = 0;
+
+
+
+static inline gint64
+thunar_scheduler_now (void)
+{
+  return g_get_monotonic_time () / (THUNAR_SCHEDULER_TICK * 1000);
+}
+
+
+
+static void
+thunar_scheduler_init_locked (void)
+{
+  guint level;
+  guint slot;
+
+  if (G_LIKELY (scheduler_tasks != NULL))
+    return;
+
+  scheduler_tasks = g_hash_table_new (g_direct_hash, g_direct_equal);
+  scheduler_queues = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  for (level = 0; level < THUNAR_SCHEDULER_LEVELS; ++level)
+    for (slot = 0; slot < THUNAR_SCHEDULER_SLOTS; ++slot)
+      g_queue_init (&scheduler_wheel[level][slot]);
+  scheduler_wheel_tick = thunar_scheduler_now ();
+
+  /* moving the expired timers to the ready queues is cheap, so do it first */
+  scheduler_wheel_source = g_source_new (&thunar_scheduler_wheel_funcs, sizeof (GSource));
+  g_source_set_priority (scheduler_wheel_source, G_PRIORITY_HIGH);
+  g_source_set_name (scheduler_wheel_source, "[thunar] scheduler wheel");
+  g_source_set_ready_time (scheduler_wheel_source, -1);
+  g_source_attach (scheduler_wheel_source, NULL);
+}
+
+
+
+static ThunarSchedulerQueue *
+thunar_scheduler_get_queue (gint priority)
+{
+  ThunarSchedulerQueue *queue;
+
+  queue = g_hash_table_lookup (scheduler_queues, GINT_TO_POINTER (priority));
+  if (G_UNLIKELY (queue == NULL))
+    {
+      /* there is one for every priority in use, they are kept around. The
+       * queue may recurse, tasks that run a dialog must not block the others */
+      queue = (ThunarSchedulerQueue *) g_source_new (&thunar_scheduler_queue_funcs, sizeof (ThunarSchedulerQueue));
+      g_queue_init (&queue->tasks);
+      queue->budget = THUNAR_SCHEDULER_BUDGET;
+      g_source_set_priority (&queue->__parent__, priority);
+      g_source_set_can_recurse (&queue->__parent__, TRUE);
+      g_source_set_name (&queue->__parent__, "[thunar] scheduler queue");
+      g_source_set_ready_time (&queue->__parent__, -1);
+      g_source_attach (&queue->__parent__, NULL);
+      g_hash_table_insert (scheduler_queues, GINT_TO_POINTER (priority), queue);
+    }
+
+  return queue;
+}
+
+
+
+static void
+thunar_scheduler_wheel_insert (ThunarSchedulerTask *task)
+{
+  gint64 delta;
+  gint64 expires = task->expires;
+  guint  level;
+  guint  slot;
+
+  delta = expires - scheduler_wheel_tick;
+  if (delta <= 0)
+    {
+      thunar_scheduler_make_ready (task);
+      return;
+    }
+
+  /* timers beyond the last level are put into its farthest slot and
+   * placed again when they come out of the wheel */
+  if (delta >= ((gint64) 1 << (THUNAR_SCHEDULER_SLOTS_SHIFT * THUNAR_SCHEDULER_LEVELS)))
+    {
+      delta = ((gint64) 1 << (THUNAR_SCHEDULER_SLOTS_SHIFT * THUNAR_SCHEDULER_LEVELS)) - 1;
+      expires = scheduler_wheel_tick + delta;
+    }
+
+  /* find the level whose slots cover the distance */
+  for (level = 0; level < THUNAR_SCHEDULER_LEVELS - 1; ++level)
+    if (delta < ((gint64) 1 << (THUNAR_SCHEDULER_SLOTS_SHIFT * (level + 1))))
+      break;
+
+  slot = (expires >> (THUNAR_SCHEDULER_SLOTS_SHIFT * level)) & THUNAR_SCHEDULER_SLOTS_MASK;
+
+  task->queue = &scheduler_wheel[level][slot];
+  task->in_wheel = TRUE;
+  g_queue_push_tail_link (task->queue, &task->link);
+  scheduler_n_timers++;
+}
+
+
+
+static void
+thunar_scheduler_wheel_unlink (ThunarSchedulerTask *task)
+{
+  _thunar_assert (task->in_wheel);
+
+  g_queue_unlink (task->queue, &task->link);
+  task->queue = NULL;
+  task->in_wheel = FALSE;
+  scheduler_n_timers--;
+}
+
+
+
+static void
+thunar_scheduler_wheel_schedule (void)
+{
+  gint64 tick;
+  gint64 boundary;
+
+  if (scheduler_n_timers == 0)
+    {
+      g_source_set_ready_time (scheduler_wheel_source, -1);
+      return;
+    }
+
+  /* wake up for the next non-empty slot of the first level, or when the
+   * next slot of the second level has to be moved down */
+  boundary = (scheduler_wheel_tick | THUNAR_SCHEDULER_SLOTS_MASK) + 1;
+  for (tick = scheduler_wheel_tick + 1; tick < boundary; ++tick)
+    if (!g_queue_is_empty (&scheduler_wheel[0][tick & THUNAR_SCHEDULER_SLOTS_MASK]))
+      break;
+
+  g_source_set_ready_time (scheduler_wheel_source, tick * THUNAR_SCHEDULER_TICK * 1000);
+}
+
+
+
+static void
+thunar_scheduler_wheel_arm (ThunarSchedulerTask *task)
+{
+  gint64 now = thunar_scheduler_now ();
+
+  /* the wheel doesn't move while it is empty */
+  if (scheduler_n_timers == 0)
+    scheduler_wheel_tick = now;
+
+  task->expires = now + task->interval;
+  thunar_scheduler_wheel_insert (task);
+  thunar_scheduler_wheel_schedule ();
+}
+
+
+
+static void
+thunar_scheduler_wheel_cascade (guint level,
+                                guint slot)
+{
+  ThunarSchedulerTask *task;
+  GList               *link;
+
+  while ((link = g_queue_peek_head_link (&scheduler_wheel[level][slot])) != NULL)
+    {
+      task = link->data;
+      thunar_scheduler_wheel_unlink (task);
+      thunar_scheduler_wheel_insert (task);
+    }
+}
+
+
+
+static gboolean
+thunar_scheduler_wheel_dispatch (GSource    *source,
+                                 GSourceFunc callback,
+                                 gpointer    user_data)
+{
+  gint64 now;
+  guint  level;
+
+  G_LOCK (scheduler);
+
+  now = thunar_scheduler_now ();
+
+  /* nothing to advance, the wheel can jump to the current tick */
+  if (scheduler_n_timers == 0)
+    scheduler_wheel_tick = now;
+
+  while (scheduler_wheel_tick < now && scheduler_n_timers > 0)
+    {
+      scheduler_wheel_tick++;
+
+      /* move the timers of the upper levels down when the wheel enters their slot */
+      for (level = THUNAR_SCHEDULER_LEVELS - 1; level > 0; --level)
+        if ((scheduler_wheel_tick & (((gint64) 1 << (THUNAR_SCHEDULER_SLOTS_SHIFT * level)) - 1)) == 0)
+          thunar_scheduler_wheel_cascade (level, (scheduler_wheel_tick >> (THUNAR_SCHEDULER_SLOTS_SHIFT * level)) & THUNAR_SCHEDULER_SLOTS_MASK);
+
+      /* the timers of this slot expired, unless they were clamped */
+      thunar_scheduler_wheel_cascade (0, scheduler_wheel_tick & THUNAR_SCHEDULER_SLOTS_MASK);
+    }
+
+  scheduler_wheel_tick = MAX (scheduler_wheel_tick, now);
+
+  thunar_scheduler_wheel_schedule ();
+
+  G_UNLOCK (scheduler);
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static void
+thunar_scheduler_make_ready (ThunarSchedulerTask *task)
+{
+  ThunarSchedulerQueue *queue;
+
+  queue = thunar_scheduler_get_queue (task->priority);
+
+  task->queue = &queue->tasks;
+  g_queue_push_tail_link (task->queue, &task->link);
+
+  g_source_set_ready_time (&queue->__parent__, 0);
+}
+
+
+
+static void
+thunar_scheduler_task_free (ThunarSchedulerTask *task)
+{
+  if (task->notify != NULL)
+    (*task->notify) (task->data);
+
+  g_slice_free (ThunarSchedulerTask, task);
+}
+
+
+
+static gboolean
+thunar_scheduler_queue_dispatch (GSource    *source,
+                                 GSourceFunc callback,
+                                 gpointer    user_data)
+{
+  ThunarSchedulerQueue *queue = (ThunarSchedulerQueue *) source;
+  ThunarSchedulerTask  *task;
+  gboolean              again;
+  GList                *link;
+  gint64                deadline;
+
+  G_LOCK (scheduler);
+
+  deadline = g_get_monotonic_time () + queue->budget;
+
+  /* run at least one task, then as many as fit into the budget */
+  do
+    {
+      link = g_queue_pop_head_link (&queue->tasks);
+      if (G_UNLIKELY (link == NULL))
+        break;
+
+      task = link->data;
+      task->queue = NULL;
+      task->running = TRUE;
+
+      G_UNLOCK (scheduler);
+      if (task->work != NULL)
+        again = (*task->work) (task->data, deadline);
+      else
+        again = (*task->func) (task->data);
+      G_LOCK (scheduler);
+
+      task->running = FALSE;
+
+      if (again && !task->removed)
+        {
+          if (task->interval > 0)
+            {
+              /* timers are due again one interval after they ran */
+              thunar_scheduler_wheel_arm (task);
+            }
+          else
+            {
+              /* idle tasks go to the end of the queue */
+              task->queue = &queue->tasks;
+              g_queue_push_tail_link (task->queue, &task->link);
+            }
+        }
+      else
+        {
+          /* thunar_scheduler_remove() already dropped the id */
+          if (!task->removed)
+            g_hash_table_remove (scheduler_tasks, GUINT_TO_POINTER (task->id));
+
+          G_UNLOCK (scheduler);
+          thunar_scheduler_task_free (task);
+          G_LOCK (scheduler);
+        }
+    }
+  while (g_get_monotonic_time () < deadline);
+
+  g_source_set_ready_time (source, g_queue_is_empty (&queue->tasks) ? -1 : 0);
+
+  G_UNLOCK (scheduler);
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static guint
+thunar_scheduler_add_task (ThunarSchedulerTask *task)
+{
+  thunar_scheduler_init_locked ();
+
+  /* skip 0 and ids that are still in use after a wrap-around */
+  do
+    task->id = scheduler_next_id++;
+  while (G_UNLIKELY (task->id == 0 || g_hash_table_contains (scheduler_tasks, GUINT_TO_POINTER (task->id))));
+
+  task->link.data = task;
+  g_hash_table_insert (scheduler_tasks, GUINT_TO_POINTER (task->id), task);
+
+  return task->id;
+}
+
+
+
+/**
+ * thunar_scheduler_add_idle:
+ * @priority : the priority of the task, like %G_PRIORITY_DEFAULT_IDLE.
+ * @func     : the function to call.
+ * @data     : the data to pass to @func.
+ * @notify   : the function to call when the task is removed, or %NULL.
+ *
+ * Works like g_idle_add_full(), but the task shares a single #GSource with
+ * all other tasks of the same @priority. The task is removed when @func
+ * returns %FALSE.
+ *
+ * Return value: the id of the task for thunar_scheduler_remove().
+ **/
+guint
+thunar_scheduler_add_idle (gint           priority,
+                           GSourceFunc    func,
+                           gpointer       data,
+                           GDestroyNotify notify)
+{
+  ThunarSchedulerTask *task;
+  guint                task_id;
+
+  _thunar_return_val_if_fail (func != NULL, 0);
+
+  task = g_slice_new0 (ThunarSchedulerTask);
+  task->priority = priority;
+  task->func = func;
+  task->data = data;
+  task->notify = notify;
+
+  G_LOCK (scheduler);
+  task_id = thunar_scheduler_add_task (task);
+  thunar_scheduler_make_ready (task);
+  G_UNLOCK (scheduler);
+
+  return task_id;
+}
+
+
+
+/**
+ * thunar_scheduler_add_timeout:
+ * @priority : the priority of the task, like %G_PRIORITY_DEFAULT.
+ * @interval : the interval in milliseconds.
+ * @func     : the function to call.
+ * @data     : the data to pass to @func.
+ * @notify   : the function to call when the task is removed, or %NULL.
+ *
+ * Works like g_timeout_add_full(), but the timer is kept in the timer
+ * wheel of the scheduler. The @interval is rounded up to the resolution
+ * of the wheel, which is about one frame. The task is removed when @func
+ * returns %FALSE.
+ *
+ * Return value: the id of the task for thunar_scheduler_remove().
+ **/
+guint
+thunar_scheduler_add_timeout (gint           priority,
+                              guint          interval,
+                              GSourceFunc    func,
+                              gpointer       data,
+                              GDestroyNotify notify)
+{
+  ThunarSchedulerTask *task;
+  guint                task_id;
+
+  _thunar_return_val_if_fail (func != NULL, 0);
+
+  task = g_slice_new0 (ThunarSchedulerTask);
+  task->priority = priority;
+  task->interval = MAX (1, (interval + THUNAR_SCHEDULER_TICK - 1) / THUNAR_SCHEDULER_TICK);
+  task->func = func;
+  task->data = data;
+  task->notify = notify;
+
+  G_LOCK (scheduler);
+  task_id = thunar_scheduler_add_task (task);
+  thunar_scheduler_wheel_arm (task);
+  G_UNLOCK (scheduler);
+
+  return task_id;
+}
+
+
+
+/**
+ * thunar_scheduler_add_work:
+ * @priority : the priority of the task, like %G_PRIORITY_LOW.
+ * @func     : the function doing a part of the work.
+ * @data     : the data to pass to @func.
+ * @notify   : the function to call when the task is removed, or %NULL.
+ *
+ * Adds an incremental task that runs in slices of the budget of its
+ * queue. @func should stop at the deadline it is given, and the task is
+ * removed when @func returns %FALSE.
+ *
+ * Return value: the id of the task for thunar_scheduler_remove().
+ **/
+guint
+thunar_scheduler_add_work (gint                    priority,
+                           ThunarSchedulerWorkFunc func,
+                           gpointer                data,
+                           GDestroyNotify          notify)
+{
+  ThunarSchedulerTask *task;
+  guint                task_id;
+
+  _thunar_return_val_if_fail (func != NULL, 0);
+
+  task = g_slice_new0 (ThunarSchedulerTask);
+  task->priority = priority;
+  task->work = func;
+  task->data = data;
+  task->notify = notify;
+
+  G_LOCK (scheduler);
+  task_id = thunar_scheduler_add_task (task);
+  thunar_scheduler_make_ready (task);
+  G_UNLOCK (scheduler);
+
+  return task_id;
+}
+
+
+
+/**
+ * thunar_scheduler_remove:
+ * @task_id : the id returned by thunar_scheduler_add_idle() or
+ *            thunar_scheduler_add_timeout().
+ *
+ * Removes the task with @task_id, like g_source_remove() does for
+ * a #GSource.
+ **/
+void
+thunar_scheduler_remove (guint task_id)
+{
+  ThunarSchedulerTask *task;
+
+  _thunar_return_if_fail (task_id != 0);
+
+  G_LOCK (scheduler);
+
+  task = (scheduler_tasks != NULL) ? g_hash_table_lookup (scheduler_tasks, GUINT_TO_POINTER (task_id)) : NULL;
+  if (G_UNLIKELY (task == NULL))
+    {
+      G_UNLOCK (scheduler);
+      g_critical ("Scheduler task ID %u was not found", task_id);
+      return;
+    }
+
+  g_hash_table_remove (scheduler_tasks, GUINT_TO_POINTER (task_id));
+
+  /* a running task is released when its callback returned */
+  if (task->running)
+    {
+      task->removed = TRUE;
+      G_UNLOCK (scheduler);
+      return;
+    }
+
+  if (task->in_wheel)
+    thunar_scheduler_wheel_unlink (task);
+  else
+    g_queue_unlink (task->queue, &task->link);
+
+  G_UNLOCK (scheduler);
+
+  thunar_scheduler_task_free (task);
+}
+
+
+
+/**
+ * thunar_scheduler_set_budget:
+ * @priority : a priority.
+ * @budget   : the time in microseconds, 0 to run one task per iteration.
+ *
+ * Sets the time the ready queue of @priority may run per main loop
+ * iteration. Tasks that are already running keep their deadline.
+ **/
+void
+thunar_scheduler_set_budget (gint  priority,
+                             guint budget)
+{
+  G_LOCK (scheduler);
+  thunar_scheduler_init_locked ();
+  thunar_scheduler_get_queue (priority)->budget = budget;
+  G_UNLOCK (scheduler);
+}
+
+
+
+/**
+ * thunar_scheduler_get_depth:
+ * @priority : a priority.
+ *
+ * Returns the number of tasks waiting in the ready queue of @priority,
+ * not counting timers that didn't expire yet. Meant for debugging and
+ * benchmarks.
+ *
+ * Return value: the number of tasks that are ready to run.
+ **/
+guint
+thunar_scheduler_get_depth (gint priority)
+{
+  ThunarSchedulerQueue *queue;
+  guint                 depth = 0;
+
+  G_LOCK (scheduler);
+  if (scheduler_queues != NULL)
+    {
+      queue = g_hash_table_lookup (scheduler_queues, GINT_TO_POINTER (priority));
+      if (queue != NULL)
+        depth = g_queue_get_length (&queue->tasks);
+    }
+  G_UNLOCK (scheduler);
+
+  return depth;
+}
@@ -0,0 +1,65 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SCHEDULER_H__
+#define __THUNAR_SCHEDULER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * ThunarSchedulerWorkFunc:
+ * @data     : the data passed to thunar_scheduler_add_work().
+ * @deadline : the monotonic time in microseconds when the slice ends.
+ *
+ * Does a part of an incremental task, as much as fits before @deadline.
+ *
+ * Return value: %TRUE if there is work left.
+ **/
+typedef gboolean (*ThunarSchedulerWorkFunc) (gpointer data,
+                                             gint64   deadline);
+
+guint thunar_scheduler_add_idle    (gint                    priority,
+                                    GSourceFunc             func,
+                                    gpointer                data,
+                                    GDestroyNotify          notify);
+
+guint thunar_scheduler_add_timeout (gint                    priority,
+                                    guint                   interval,
+                                    GSourceFunc             func,
+                                    gpointer                data,
+                                    GDestroyNotify          notify);
+
+guint thunar_scheduler_add_work    (gint                    priority,
+                                    ThunarSchedulerWorkFunc func,
+                                    gpointer                data,
+                                    GDestroyNotify          notify);
+
+void  thunar_scheduler_remove      (guint                   task_id);
+
+void  thunar_scheduler_set_budget  (gint                    priority,
+                                    guint                   budget);
+
+guint thunar_scheduler_get_depth   (gint                    priority);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_SCHEDULER_H__ */
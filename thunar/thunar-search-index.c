@@ -0,0 +1,1031 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-pattern.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-search-index.h>
+#include <thunar/thunar-simple-job.h>
+
+
+
+/* The search index keeps the names of all files on a mount in a cache
+ * file, so a search does not have to walk the tree, which takes minutes
+ * on large network shares. The file is a header and the root uri,
+ * followed by a record per folder with its path relative to the root,
+ * each followed by a record per child with its name and the casefolded
+ * display name the search matches. Every block is aligned to 8 bytes.
+ *
+ * The index is built by a single low priority job. Rebuilding it only
+ * enumerates the folders whose modification time changed and copies
+ * all other folders from the previous index. Files created since then
+ * are reported by the folder monitors and searched in memory; files
+ * removed since then are dropped when they cannot be loaded.
+ */
+#define SEARCH_INDEX_MAGIC       "THINDX01"
+#define SEARCH_INDEX_ALIGN(n)    (((n) + 7) & ~((gsize) 7))
+
+/* age after which the changed folders are rescanned, in usec */
+#define SEARCH_INDEX_MAX_AGE     (30 * 60 * G_USEC_PER_SEC)
+
+/* number of created files remembered before rescanning instead */
+#define SEARCH_INDEX_MAX_CREATED (1000)
+
+/* number of matches handed over at once */
+#define SEARCH_INDEX_BATCH_SIZE  (100)
+
+/* the attributes needed to index the children of a folder */
+#define SEARCH_INDEX_NAMESPACE \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP
+
+
+
+typedef struct
+{
+  gchar   magic[8];
+  gint64  build_time;
+  guint32 uri_len;
+  guint32 reserved;
+}
+IndexHeader;
+
+typedef struct
+{
+  guint64 mtime;
+  guint32 n_children;
+  guint32 path_len;
+}
+IndexDirectory;
+
+typedef struct
+{
+  guint16 flags;
+  guint16 name_len;
+  guint16 casefold_len;
+  guint16 reserved;
+}
+IndexChild;
+
+enum
+{
+  INDEX_FLAG_HIDDEN    = 1 << 0,
+  INDEX_FLAG_DIRECTORY = 1 << 1,
+};
+
+typedef struct
+{
+  const gchar *data;
+  gsize        length;
+  gsize        offset;
+}
+IndexReader;
+
+typedef struct
+{
+  GFile       *root;
+  gchar       *path;
+  GMappedFile *mapped;
+  gint64       build_time;
+  gboolean     loaded;
+  gboolean     building;
+
+  /* files created since the build started */
+  GList       *created;
+  guint        n_created;
+}
+SearchIndex;
+
+
+
+/* the indexes of all mounts searched so far, protected by the mutex,
+ * as searches run in their own threads */
+static GMutex      search_index_mutex;
+static GHashTable *search_indexes = NULL;
+
+
+
+static gchar *
+thunar_search_index_child_path (const gchar *path,
+                                const gchar *name)
+{
+  if (*path == '\0')
+    return g_strdup (name);
+
+  return g_strconcat (path, "/", name, NULL);
+}
+
+
+
+static void
+thunar_search_index_pad (GByteArray *array)
+{
+  static const guint8 zeros[8] = { 0, };
+
+  g_byte_array_append (array, zeros, SEARCH_INDEX_ALIGN (array->len) - array->len);
+}
+
+
+
+static void
+thunar_search_index_reader_init (IndexReader *reader,
+                                 GMappedFile *mapped,
+                                 gsize        offset)
+{
+  IndexHeader header;
+
+  reader->data = g_mapped_file_get_contents (mapped);
+  reader->length = g_mapped_file_get_length (mapped);
+
+  /* start after the header, which was checked when the index was mapped */
+  if (offset == 0)
+    {
+      memcpy (&header, reader->data, sizeof (IndexHeader));
+      offset = SEARCH_INDEX_ALIGN (sizeof (IndexHeader) + header.uri_len + 1);
+    }
+
+  reader->offset = offset;
+}
+
+
+
+static gboolean
+thunar_search_index_read_directory (IndexReader    *reader,
+                                    IndexDirectory *directory,
+                                    const gchar   **path_return)
+{
+  const gchar *path;
+  gsize        offset;
+
+  offset = reader->offset + sizeof (IndexDirectory);
+  if (offset > reader->length)
+    return FALSE;
+
+  memcpy (directory, reader->data + reader->offset, sizeof (IndexDirectory));
+
+  /* make sure the path is complete */
+  path = reader->data + offset;
+  if (offset + directory->path_len >= reader->length
+      || path[directory->path_len] != '\0')
+    return FALSE;
+
+  reader->offset = SEARCH_INDEX_ALIGN (offset + directory->path_len + 1);
+  *path_return = path;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_search_index_read_child (IndexReader  *reader,
+                                IndexChild   *child,
+                                const gchar **name_return,
+                                const gchar **casefold_return)
+{
+  const gchar *name;
+  const gchar *casefold;
+  gsize        offset;
+
+  offset = reader->offset + sizeof (IndexChild);
+  if (offset > reader->length)
+    return FALSE;
+
+  memcpy (child, reader->data + reader->offset, sizeof (IndexChild));
+
+  /* make sure the strings are complete */
+  name = reader->data + offset;
+  casefold = name + child->name_len + 1;
+  if (child->name_len == 0
+      || offset + child->name_len + child->casefold_len + 2 > reader->length
+      || name[child->name_len] != '\0'
+      || casefold[child->casefold_len] != '\0')
+    return FALSE;
+
+  reader->offset = SEARCH_INDEX_ALIGN (offset + child->name_len + child->casefold_len + 2);
+  *name_return = name;
+  *casefold_return = casefold;
+
+  return TRUE;
+}
+
+
+
+static GMappedFile *
+thunar_search_index_map (SearchIndex *index)
+{
+  IndexHeader  header;
+  GMappedFile *mapped;
+  const gchar *data;
+  gsize        length;
+  gchar       *uri;
+
+  mapped = g_mapped_file_new (index->path, FALSE, NULL);
+  if (mapped == NULL)
+    return NULL;
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+  uri = g_file_get_uri (index->root);
+
+  /* check if the index belongs to the mount */
+  if (length < sizeof (IndexHeader))
+    goto invalid;
+
+  memcpy (&header, data, sizeof (IndexHeader));
+  if (memcmp (header.magic, SEARCH_INDEX_MAGIC, sizeof (header.magic)) != 0
+      || header.uri_len != strlen (uri)
+      || sizeof (IndexHeader) + header.uri_len >= length
+      || memcmp (data + sizeof (IndexHeader), uri, header.uri_len) != 0)
+    goto invalid;
+
+  index->build_time = header.build_time;
+  g_free (uri);
+
+  return mapped;
+
+invalid:
+  g_mapped_file_unref (mapped);
+  g_free (uri);
+
+  return NULL;
+}
+
+
+
+static GMappedFile *
+thunar_search_index_get_mapped (SearchIndex *index)
+{
+  /* map the cache file written by the last build once */
+  if (!index->loaded)
+    {
+      index->loaded = TRUE;
+      index->mapped = thunar_search_index_map (index);
+    }
+
+  return (index->mapped != NULL) ? g_mapped_file_ref (index->mapped) : NULL;
+}
+
+
+
+static SearchIndex *
+thunar_search_index_get (GFile *root)
+{
+  SearchIndex *index;
+  gchar       *checksum;
+  gchar       *filename;
+  gchar       *uri;
+
+  if (G_UNLIKELY (search_indexes == NULL))
+    search_indexes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  uri = g_file_get_uri (root);
+  index = g_hash_table_lookup (search_indexes, uri);
+  if (G_LIKELY (index != NULL))
+    {
+      g_free (uri);
+      return index;
+    }
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  filename = g_strconcat (checksum, ".index", NULL);
+
+  index = g_slice_new0 (SearchIndex);
+  index->root = g_object_ref (root);
+  index->path = g_build_filename (g_get_user_cache_dir (), "Thunar", "search-index", filename, NULL);
+  g_hash_table_insert (search_indexes, uri, index);
+
+  g_free (filename);
+  g_free (checksum);
+
+  return index;
+}
+
+
+
+static GHashTable *
+thunar_search_index_collect_directories (GMappedFile *mapped)
+{
+  IndexDirectory directory;
+  IndexReader    reader;
+  IndexChild     child;
+  const gchar   *path;
+  const gchar   *name;
+  const gchar   *casefold;
+  GHashTable    *directories;
+  gsize          offset;
+  guint32        n;
+
+  directories = g_hash_table_new (g_str_hash, g_str_equal);
+
+  /* remember where the record of each folder starts */
+  thunar_search_index_reader_init (&reader, mapped, 0);
+  for (offset = reader.offset;
+       thunar_search_index_read_directory (&reader, &directory, &path);
+       offset = reader.offset)
+    {
+      for (n = 0; n < directory.n_children; ++n)
+        if (!thunar_search_index_read_child (&reader, &child, &name, &casefold))
+          return directories;
+
+      g_hash_table_insert (directories, (gpointer) path, GSIZE_TO_POINTER (offset));
+    }
+
+  return directories;
+}
+
+
+
+static gboolean
+thunar_search_index_copy_children (GMappedFile *mapped,
+                                   GHashTable  *directories,
+                                   const gchar *path,
+                                   guint64      mtime,
+                                   GByteArray  *block,
+                                   GPtrArray   *subdirs,
+                                   guint32     *n_children_return)
+{
+  IndexDirectory directory;
+  IndexReader    reader;
+  IndexChild     child;
+  const gchar   *old_path;
+  const gchar   *name;
+  const gchar   *casefold;
+  gpointer       offset;
+  gsize          start;
+  guint32        n;
+
+  if (mapped == NULL || !g_hash_table_lookup_extended (directories, path, NULL, &offset))
+    return FALSE;
+
+  /* only folders which did not change since the last build */
+  thunar_search_index_reader_init (&reader, mapped, GPOINTER_TO_SIZE (offset));
+  if (!thunar_search_index_read_directory (&reader, &directory, &old_path)
+      || directory.mtime != mtime)
+    return FALSE;
+
+  start = reader.offset;
+  for (n = 0; n < directory.n_children; ++n)
+    {
+      if (!thunar_search_index_read_child (&reader, &child, &name, &casefold))
+        return FALSE;
+
+      if ((child.flags & INDEX_FLAG_DIRECTORY) != 0)
+        g_ptr_array_add (subdirs, thunar_search_index_child_path (path, name));
+    }
+
+  g_byte_array_append (block, (const guint8 *) reader.data + start, reader.offset - start);
+  *n_children_return = directory.n_children;
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_search_index_enumerate_children (GFile        *file,
+                                        const gchar  *path,
+                                        GByteArray   *block,
+                                        GPtrArray    *subdirs,
+                                        guint32      *n_children_return,
+                                        GCancellable *cancellable)
+{
+  GFileEnumerator *enumerator;
+  IndexChild       child;
+  GFileInfo       *info;
+  const gchar     *name;
+  gchar           *casefold;
+  gsize            name_len;
+  gsize            casefold_len;
+
+  /* folders that cannot be read are indexed empty, like find does */
+  enumerator = g_file_enumerate_children (file, SEARCH_INDEX_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable, NULL);
+  if (G_UNLIKELY (enumerator == NULL))
+    return;
+
+  while ((info = g_file_enumerator_next_file (enumerator, cancellable, NULL)) != NULL)
+    {
+      name = g_file_info_get_name (info);
+      casefold = thunar_pattern_casefold (g_file_info_get_display_name (info));
+
+      name_len = strlen (name);
+      casefold_len = (casefold != NULL) ? strlen (casefold) : 0;
+      if (G_LIKELY (name_len > 0 && name_len <= G_MAXUINT16 && casefold_len <= G_MAXUINT16))
+        {
+          memset (&child, 0, sizeof (IndexChild));
+          child.name_len = name_len;
+          child.casefold_len = casefold_len;
+          if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
+            child.flags |= INDEX_FLAG_HIDDEN;
+          if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+            {
+              child.flags |= INDEX_FLAG_DIRECTORY;
+              g_ptr_array_add (subdirs, thunar_search_index_child_path (path, name));
+            }
+
+          g_byte_array_append (block, (const guint8 *) &child, sizeof (IndexChild));
+          g_byte_array_append (block, (const guint8 *) name, name_len + 1);
+          g_byte_array_append (block, (const guint8 *) (casefold != NULL ? casefold : ""), casefold_len + 1);
+          thunar_search_index_pad (block);
+
+          *n_children_return += 1;
+        }
+
+      g_free (casefold);
+      g_object_unref (info);
+    }
+
+  g_object_unref (enumerator);
+}
+
+
+
+static void
+thunar_search_index_build_directory (GFile        *root,
+                                     const gchar  *path,
+                                     GMappedFile  *mapped,
+                                     GHashTable   *directories,
+                                     GByteArray   *block,
+                                     GQueue       *queue,
+                                     GCancellable *cancellable)
+{
+  IndexDirectory directory;
+  GPtrArray     *subdirs;
+  GFileInfo     *info;
+  GFile         *file;
+  guint          n;
+
+  file = (*path != '\0') ? g_file_resolve_relative_path (root, path) : g_object_ref (root);
+
+  memset (&directory, 0, sizeof (IndexDirectory));
+  directory.path_len = strlen (path);
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
+  if (G_LIKELY (info != NULL))
+    {
+      directory.mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+                        + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+      g_object_unref (info);
+    }
+
+  g_byte_array_append (block, (const guint8 *) &directory, sizeof (IndexDirectory));
+  g_byte_array_append (block, (const guint8 *) path, directory.path_len + 1);
+  thunar_search_index_pad (block);
+
+  subdirs = g_ptr_array_new_with_free_func (g_free);
+
+  /* without a modification time we cannot tell if the old children are valid */
+  if (directory.mtime == 0
+      || !thunar_search_index_copy_children (mapped, directories, path, directory.mtime,
+                                             block, subdirs, &directory.n_children))
+    {
+      thunar_search_index_enumerate_children (file, path, block, subdirs,
+                                              &directory.n_children, cancellable);
+    }
+
+  /* update the number of children in the record */
+  memcpy (block->data, &directory, sizeof (IndexDirectory));
+
+  /* index the subfolders after this one */
+  for (n = 0; n < subdirs->len; ++n)
+    g_queue_push_tail (queue, g_strdup (g_ptr_array_index (subdirs, n)));
+
+  g_ptr_array_free (subdirs, TRUE);
+  g_object_unref (file);
+}
+
+
+
+static gboolean
+thunar_search_index_build (ThunarJob  *job,
+                           GArray     *param_values,
+                           GError    **error)
+{
+  GFileOutputStream *stream;
+  GOutputStream     *output = NULL;
+  SearchIndex       *index;
+  GMappedFile       *mapped;
+  GCancellable      *cancellable;
+  GHashTable        *directories = NULL;
+  IndexHeader        header;
+  GByteArray        *block;
+  GQueue             queue = G_QUEUE_INIT;
+  gboolean           succeed = FALSE;
+  GList             *created;
+  GFile             *root;
+  GFile             *file;
+  gchar             *dirname;
+  gchar             *tmp_path;
+  gchar             *path;
+  gchar             *uri;
+  gint64             start_time;
+  guint              n_created;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  root = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  /* files created from now on may be missed by this build */
+  g_mutex_lock (&search_index_mutex);
+  index = thunar_search_index_get (root);
+  mapped = thunar_search_index_get_mapped (index);
+  created = index->created;
+  n_created = index->n_created;
+  index->created = NULL;
+  index->n_created = 0;
+  path = g_strdup (index->path);
+  g_mutex_unlock (&search_index_mutex);
+
+  start_time = g_get_real_time ();
+
+  /* unchanged folders are copied from the previous index */
+  if (mapped != NULL)
+    directories = thunar_search_index_collect_directories (mapped);
+
+  /* write a new file, so running searches keep the old one */
+  dirname = g_path_get_dirname (path);
+  tmp_path = g_strconcat (path, ".new", NULL);
+  if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "%s", g_strerror (errno));
+      goto out;
+    }
+
+  file = g_file_new_for_path (tmp_path);
+  stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_PRIVATE, cancellable, error);
+  g_object_unref (file);
+  if (G_UNLIKELY (stream == NULL))
+    goto out;
+
+  output = g_buffered_output_stream_new (G_OUTPUT_STREAM (stream));
+  g_object_unref (stream);
+
+  uri = g_file_get_uri (root);
+
+  memset (&header, 0, sizeof (IndexHeader));
+  memcpy (header.magic, SEARCH_INDEX_MAGIC, sizeof (header.magic));
+  header.build_time = start_time;
+  header.uri_len = strlen (uri);
+
+  block = g_byte_array_new ();
+  g_byte_array_append (block, (const guint8 *) &header, sizeof (IndexHeader));
+  g_byte_array_append (block, (const guint8 *) uri, header.uri_len + 1);
+  thunar_search_index_pad (block);
+  g_free (uri);
+
+  succeed = g_output_stream_write_all (output, block->data, block->len, NULL, cancellable, error);
+
+  /* walk the mount one folder at a time, not to slow down the share */
+  g_queue_push_tail (&queue, g_strdup (""));
+  while (succeed && (uri = g_queue_pop_head (&queue)) != NULL)
+    {
+      g_byte_array_set_size (block, 0);
+      thunar_search_index_build_directory (root, uri, mapped, directories, block, &queue, cancellable);
+      g_free (uri);
+
+      succeed = !exo_job_set_error_if_cancelled (EXO_JOB (job), error)
+                && g_output_stream_write_all (output, block->data, block->len, NULL, cancellable, error);
+    }
+
+  while ((uri = g_queue_pop_head (&queue)) != NULL)
+    g_free (uri);
+  g_byte_array_free (block, TRUE);
+
+  if (succeed)
+    succeed = g_output_stream_close (output, cancellable, error);
+
+  if (succeed && g_rename (tmp_path, path) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "%s", g_strerror (errno));
+      succeed = FALSE;
+    }
+
+out:
+  if (output != NULL)
+    g_object_unref (output);
+  if (!succeed)
+    g_unlink (tmp_path);
+
+  g_mutex_lock (&search_index_mutex);
+  index->building = FALSE;
+  if (succeed)
+    {
+      /* the next search maps the new index */
+      if (index->mapped != NULL)
+        g_mapped_file_unref (index->mapped);
+      index->mapped = NULL;
+      index->loaded = FALSE;
+      g_list_free_full (created, g_object_unref);
+    }
+  else
+    {
+      /* keep the created files for the next try */
+      index->created = g_list_concat (index->created, created);
+      index->n_created += n_created;
+    }
+  g_mutex_unlock (&search_index_mutex);
+
+  if (directories != NULL)
+    g_hash_table_destroy (directories);
+  if (mapped != NULL)
+    g_mapped_file_unref (mapped);
+  g_free (tmp_path);
+  g_free (dirname);
+  g_free (path);
+
+  return succeed;
+}
+
+
+
+static void
+thunar_search_index_build_finished (ThunarJob *job)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  g_object_unref (job);
+}
+
+
+
+static gboolean
+thunar_search_index_build_idle (gpointer user_data)
+{
+  ThunarJob *job;
+
+  job = thunar_simple_job_new (thunar_search_index_build, 1, G_TYPE_FILE, user_data);
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_BACKGROUND);
+  g_signal_connect (job, "finished", G_CALLBACK (thunar_search_index_build_finished), NULL);
+  exo_job_launch (EXO_JOB (job));
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_search_index_schedule_build (SearchIndex *index)
+{
+  if (index->building)
+    return;
+
+  /* jobs are launched from the main thread */
+  index->building = TRUE;
+  g_idle_add_full (G_PRIORITY_LOW, thunar_search_index_build_idle,
+                   g_object_ref (index->root), g_object_unref);
+}
+
+
+
+static gboolean
+thunar_search_index_is_hidden (GFile *directory,
+                               GFile *file)
+{
+  gboolean hidden;
+  gchar   *path;
+
+  /* created files are not queried, so guess from the name like ls does */
+  path = g_file_get_relative_path (directory, file);
+  if (G_UNLIKELY (path == NULL))
+    return TRUE;
+
+  hidden = (*path == '.' || strstr (path, "/.") != NULL || g_str_has_suffix (path, "~"));
+  g_free (path);
+
+  return hidden;
+}
+
+
+
+static void
+thunar_search_index_add_match (GHashTable *found,
+                               GList     **matches,
+                               guint      *n_matches,
+                               GFile      *file)
+{
+  ThunarFile *thunar_file;
+
+  if (g_hash_table_contains (found, file))
+    {
+      g_object_unref (file);
+      return;
+    }
+
+  /* files removed since the index was built cannot be loaded */
+  thunar_file = thunar_file_get (file, NULL);
+  if (G_LIKELY (thunar_file != NULL))
+    {
+      *matches = g_list_prepend (*matches, thunar_file);
+      *n_matches += 1;
+    }
+
+  g_hash_table_add (found, file);
+}
+
+
+
+static void
+thunar_search_index_files_ready (ThunarJob *job,
+                                 GList    **matches,
+                                 guint     *n_matches)
+{
+  GList *files;
+
+  if (*matches == NULL)
+    return;
+
+  files = g_list_reverse (*matches);
+  *matches = NULL;
+  *n_matches = 0;
+
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    thunar_g_list_free_full (files);
+  else
+    thunar_job_files_ready (job, files);
+}
+
+
+
+/**
+ * thunar_search_index_search:
+ * @job         : the #ThunarJob of the search.
+ * @directory   : the folder to search in.
+ * @pattern     : the case insensitive pattern to match the display names with.
+ * @show_hidden : whether to search hidden files and folders as well.
+ * @rules       : the #ThunarScanRules of the folders not to enter.
+ * @n_excluded  : return location for the number of folders not entered.
+ *
+ * Searches @directory and its subfolders using the index of the mount
+ * of @directory, like thunar_io_scan_directory_search() does by walking
+ * the tree. The matches are handed over in batches through the
+ * "files-ready" signal of @job. The index covers a single mount, so
+ * only the exclusions of @rules apply.
+ *
+ * If the mount was not indexed yet, or the index is older than half an
+ * hour, a job is started to index it in the background. Folders outside
+ * of mounts, like the local filesystem, are never indexed.
+ *
+ * Return value: %TRUE if the index answered the search, %FALSE if
+ *               the caller has to walk the tree instead.
+ **/
+gboolean
+thunar_search_index_search (ThunarJob       *job,
+                            GFile           *directory,
+                            ThunarPattern   *pattern,
+                            gboolean         show_hidden,
+                            ThunarScanRules *rules,
+                            guint           *n_excluded)
+{
+  IndexDirectory record;
+  GCancellable  *cancellable;
+  SearchIndex   *index;
+  GMappedFile   *mapped;
+  IndexReader    reader;
+  IndexChild     child;
+  GHashTable    *excluded;
+  GHashTable    *found;
+  const gchar   *path;
+  const gchar   *name;
+  const gchar   *casefold;
+  gboolean       inside;
+  gboolean       skip;
+  gboolean       complete = TRUE;
+  GMount        *mount;
+  GList         *matches = NULL;
+  GList         *created;
+  GList         *lp;
+  GFile         *root;
+  gchar         *prefix;
+  gchar         *child_path;
+  gchar         *basename;
+  gchar         *display_name;
+  gchar         *folded;
+  gsize          prefix_len;
+  guint          n_matches = 0;
+  guint32        n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (pattern != NULL, FALSE);
+  _thunar_return_val_if_fail (rules != NULL, FALSE);
+  _thunar_return_val_if_fail (n_excluded != NULL, FALSE);
+
+  *n_excluded = 0;
+
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  /* there is one index per mount */
+  mount = g_file_find_enclosing_mount (directory, cancellable, NULL);
+  if (mount == NULL)
+    return FALSE;
+
+  root = g_mount_get_root (mount);
+  g_object_unref (mount);
+
+  prefix = g_file_equal (root, directory) ? g_strdup ("") : g_file_get_relative_path (root, directory);
+  if (G_UNLIKELY (prefix == NULL))
+    {
+      g_object_unref (root);
+      return FALSE;
+    }
+
+  g_mutex_lock (&search_index_mutex);
+  index = thunar_search_index_get (root);
+  mapped = thunar_search_index_get_mapped (index);
+  if (mapped == NULL || g_get_real_time () - index->build_time > SEARCH_INDEX_MAX_AGE)
+    thunar_search_index_schedule_build (index);
+  created = g_list_copy_deep (index->created, (GCopyFunc) g_object_ref, NULL);
+  g_mutex_unlock (&search_index_mutex);
+
+  if (mapped == NULL)
+    {
+      g_list_free_full (created, g_object_unref);
+      g_object_unref (root);
+      g_free (prefix);
+      return FALSE;
+    }
+
+  prefix_len = strlen (prefix);
+  excluded = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  found = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+
+  thunar_search_index_reader_init (&reader, mapped, 0);
+  while (complete
+         && !exo_job_is_cancelled (EXO_JOB (job))
+         && thunar_search_index_read_directory (&reader, &record, &path))
+    {
+      /* only the folders below the searched one, except hidden ones */
+      inside = (prefix_len == 0
+                || (strncmp (path, prefix, prefix_len) == 0
+                    && (path[prefix_len] == '\0' || path[prefix_len] == '/')));
+      skip = g_hash_table_contains (excluded, path);
+
+      for (n = 0; n < record.n_children; ++n)
+        {
+          if (!thunar_search_index_read_child (&reader, &child, &name, &casefold))
+            {
+              complete = FALSE;
+              break;
+            }
+
+          if (!inside)
+            continue;
+
+          if (skip
+              || (!show_hidden && (child.flags & INDEX_FLAG_HIDDEN) != 0))
+            {
+              /* do not enter the subfolders either */
+              if ((child.flags & INDEX_FLAG_DIRECTORY) != 0)
+                g_hash_table_add (excluded, thunar_search_index_child_path (path, name));
+              continue;
+            }
+
+          /* excluded folders may match, but are not entered */
+          if ((child.flags & INDEX_FLAG_DIRECTORY) != 0
+              && thunar_scan_rules_excludes (rules, name))
+            {
+              g_hash_table_add (excluded, thunar_search_index_child_path (path, name));
+              *n_excluded += 1;
+            }
+
+          if (thunar_pattern_match (pattern, casefold))
+            {
+              child_path = thunar_search_index_child_path (path, name);
+              thunar_search_index_add_match (found, &matches, &n_matches,
+                                             g_file_resolve_relative_path (root, child_path));
+              g_free (child_path);
+            }
+        }
+
+      if (n_matches >= SEARCH_INDEX_BATCH_SIZE)
+        thunar_search_index_files_ready (job, &matches, &n_matches);
+    }
+
+  /* a broken index is rebuilt from scratch */
+  if (G_UNLIKELY (!complete))
+    {
+      g_mutex_lock (&search_index_mutex);
+      if (index->mapped == mapped)
+        {
+          g_unlink (index->path);
+          g_mapped_file_unref (index->mapped);
+          index->mapped = NULL;
+        }
+      thunar_search_index_schedule_build (index);
+      g_mutex_unlock (&search_index_mutex);
+    }
+
+  /* search the files created since the index was built */
+  for (lp = created; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    {
+      if (!g_file_has_prefix (lp->data, directory)
+          || (!show_hidden && thunar_search_index_is_hidden (directory, lp->data)))
+        continue;
+
+      basename = g_file_get_basename (lp->data);
+      display_name = g_filename_display_name (basename);
+      folded = thunar_pattern_casefold (display_name);
+      if (folded != NULL && thunar_pattern_match (pattern, folded))
+        thunar_search_index_add_match (found, &matches, &n_matches, g_object_ref (lp->data));
+      g_free (folded);
+      g_free (display_name);
+      g_free (basename);
+    }
+
+  thunar_search_index_files_ready (job, &matches, &n_matches);
+
+  g_hash_table_destroy (found);
+  g_hash_table_destroy (excluded);
+  g_list_free_full (created, g_object_unref);
+  g_mapped_file_unref (mapped);
+  g_object_unref (root);
+  g_free (prefix);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_search_index_file_created:
+ * @file : a #GFile reported by a folder monitor.
+ *
+ * Remembers that @file was created, so searches find it before the
+ * index of its mount is built again. If too many files were created,
+ * the changed folders are rescanned by the next search instead.
+ **/
+void
+thunar_search_index_file_created (GFile *file)
+{
+  GHashTableIter iter;
+  SearchIndex   *index;
+
+  _thunar_return_if_fail (G_IS_FILE (file));
+
+  g_mutex_lock (&search_index_mutex);
+  if (search_indexes != NULL)
+    {
+      g_hash_table_iter_init (&iter, search_indexes);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer) &index))
+        {
+          /* only mounts which were indexed or are being indexed */
+          if ((index->mapped == NULL && !index->building)
+              || !g_file_has_prefix (file, index->root))
+            continue;
+
+          if (index->n_created < SEARCH_INDEX_MAX_CREATED)
+            {
+              index->created = g_list_prepend (index->created, g_object_ref (file));
+              index->n_created++;
+            }
+          else
+            {
+              index->build_time = 0;
+            }
+        }
+    }
+  g_mutex_unlock (&search_index_mutex);
+}
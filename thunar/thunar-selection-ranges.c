@@ -0,0 +1,268 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-list-model.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-selection-ranges.h>
+
+
+
+/* The selection of a view is kept as a sorted array of row ranges. The
+ * views report their selected rows in ascending order, so a whole
+ * selection is collected without allocating a GtkTreePath per row, and
+ * selecting all files of a huge folder is a single range. The list of
+ * ThunarFiles is only built when somebody asks for it.
+ */
+
+
+
+static gint
+thunar_selection_range_compare (gconstpointer a,
+                                gconstpointer b)
+{
+  const ThunarSelectionRange *range_a = a;
+  const ThunarSelectionRange *range_b = b;
+
+  return (range_a->first > range_b->first) - (range_a->first < range_b->first);
+}
+
+
+
+/**
+ * thunar_selection_ranges_new:
+ *
+ * Allocates an empty array of #ThunarSelectionRange<!---->s, to be released
+ * with g_array_unref().
+ *
+ * Return value: the new array.
+ **/
+GArray*
+thunar_selection_ranges_new (void)
+{
+  return g_array_new (FALSE, FALSE, sizeof (ThunarSelectionRange));
+}
+
+
+
+/**
+ * thunar_selection_ranges_add:
+ * @ranges : an array of #ThunarSelectionRange<!---->s.
+ * @row    : the index of a selected row.
+ *
+ * Adds the @row to the @ranges. Rows added in ascending order are merged
+ * right away, other orders need thunar_selection_ranges_normalize().
+ **/
+void
+thunar_selection_ranges_add (GArray *ranges,
+                             gint    row)
+{
+  ThunarSelectionRange *last;
+  ThunarSelectionRange  range;
+
+  _thunar_return_if_fail (ranges != NULL);
+  _thunar_return_if_fail (row >= 0);
+
+  if (G_LIKELY (ranges->len > 0))
+    {
+      last = &g_array_index (ranges, ThunarSelectionRange, ranges->len - 1);
+      if (row == last->last + 1)
+        {
+          last->last = row;
+          return;
+        }
+    }
+
+  range.first = range.last = row;
+  g_array_append_val (ranges, range);
+}
+
+
+
+/**
+ * thunar_selection_ranges_add_path:
+ * @ranges : an array of #ThunarSelectionRange<!---->s.
+ * @path   : the #GtkTreePath of a selected row.
+ *
+ * Like thunar_selection_ranges_add(), for a toplevel @path.
+ **/
+void
+thunar_selection_ranges_add_path (GArray      *ranges,
+                                  GtkTreePath *path)
+{
+  _thunar_return_if_fail (path != NULL);
+  _thunar_return_if_fail (gtk_tree_path_get_depth (path) > 0);
+
+  thunar_selection_ranges_add (ranges, gtk_tree_path_get_indices (path)[0]);
+}
+
+
+
+/**
+ * thunar_selection_ranges_normalize:
+ * @ranges : an array of #ThunarSelectionRange<!---->s.
+ *
+ * Sorts the @ranges and merges the ones that touch or overlap.
+ **/
+void
+thunar_selection_ranges_normalize (GArray *ranges)
+{
+  ThunarSelectionRange *range;
+  ThunarSelectionRange *merged;
+  guint                 n;
+  guint                 n_merged;
+
+  _thunar_return_if_fail (ranges != NULL);
+
+  if (ranges->len < 2)
+    return;
+
+  g_array_sort (ranges, thunar_selection_range_compare);
+
+  for (n = 1, n_merged = 0; n < ranges->len; ++n)
+    {
+      range = &g_array_index (ranges, ThunarSelectionRange, n);
+      merged = &g_array_index (ranges, ThunarSelectionRange, n_merged);
+      if (range->first <= merged->last + 1)
+        merged->last = MAX (merged->last, range->last);
+      else
+        g_array_index (ranges, ThunarSelectionRange, ++n_merged) = *range;
+    }
+
+  g_array_set_size (ranges, n_merged + 1);
+}
+
+
+
+/**
+ * thunar_selection_ranges_invert:
+ * @ranges : a normalized array of #ThunarSelectionRange<!---->s.
+ * @n_rows : the number of rows in the model.
+ *
+ * Return value: the ranges of all the rows in [0, @n_rows) that are not
+ *               in @ranges, to be released with g_array_unref().
+ **/
+GArray*
+thunar_selection_ranges_invert (GArray *ranges,
+                                gint    n_rows)
+{
+  ThunarSelectionRange *range;
+  ThunarSelectionRange  gap;
+  GArray               *inverted;
+  guint                 n;
+  gint                  next = 0;
+
+  _thunar_return_val_if_fail (ranges != NULL, NULL);
+
+  inverted = thunar_selection_ranges_new ();
+
+  for (n = 0; n < ranges->len && next < n_rows; ++n)
+    {
+      range = &g_array_index (ranges, ThunarSelectionRange, n);
+      if (range->first > next)
+        {
+          gap.first = next;
+          gap.last = MIN (range->first, n_rows) - 1;
+          g_array_append_val (inverted, gap);
+        }
+      next = MAX (next, range->last + 1);
+    }
+
+  if (next < n_rows)
+    {
+      gap.first = next;
+      gap.last = n_rows - 1;
+      g_array_append_val (inverted, gap);
+    }
+
+  return inverted;
+}
+
+
+
+/**
+ * thunar_selection_ranges_count:
+ * @ranges : a normalized array of #ThunarSelectionRange<!---->s.
+ *
+ * Return value: the number of rows in the @ranges.
+ **/
+guint
+thunar_selection_ranges_count (GArray *ranges)
+{
+  ThunarSelectionRange *range;
+  guint                 count = 0;
+  guint                 n;
+
+  _thunar_return_val_if_fail (ranges != NULL, 0);
+
+  for (n = 0; n < ranges->len; ++n)
+    {
+      range = &g_array_index (ranges, ThunarSelectionRange, n);
+      count += range->last - range->first + 1;
+    }
+
+  return count;
+}
+
+
+
+/**
+ * thunar_selection_ranges_get_files:
+ * @ranges : a normalized array of #ThunarSelectionRange<!---->s.
+ * @model  : the #ThunarListModel the @ranges refer to.
+ *
+ * Looks up the #ThunarFile<!---->s of the rows in the @ranges. Each range
+ * costs one lookup in the @model, the rows of a range are walked.
+ *
+ * Return value: the list of #ThunarFile<!---->s in the order of the rows,
+ *               to be released with thunar_g_list_free_full().
+ **/
+GList*
+thunar_selection_ranges_get_files (GArray       *ranges,
+                                   GtkTreeModel *model)
+{
+  ThunarSelectionRange *range;
+  GtkTreeIter           iter;
+  GList                *files = NULL;
+  guint                 n;
+  gint                  row;
+
+  _thunar_return_val_if_fail (ranges != NULL, NULL);
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (model), NULL);
+
+  for (n = 0; n < ranges->len; ++n)
+    {
+      range = &g_array_index (ranges, ThunarSelectionRange, n);
+      if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, range->first))
+        break;
+
+      for (row = range->first; row <= range->last; ++row)
+        {
+          files = g_list_prepend (files, thunar_list_model_get_file (THUNAR_LIST_MODEL (model), &iter));
+          if (!gtk_tree_model_iter_next (model, &iter))
+            break;
+        }
+    }
+
+  return g_list_reverse (files);
+}
@@ -0,0 +1,56 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SELECTION_RANGES_H__
+#define __THUNAR_SELECTION_RANGES_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  /* the first and the last selected row, inclusive */
+  gint first;
+  gint last;
+}
+ThunarSelectionRange;
+
+GArray *thunar_selection_ranges_new        (void) G_GNUC_MALLOC;
+
+void    thunar_selection_ranges_add        (GArray       *ranges,
+                                            gint          row);
+
+void    thunar_selection_ranges_add_path   (GArray       *ranges,
+                                            GtkTreePath  *path);
+
+void    thunar_selection_ranges_normalize  (GArray       *ranges);
+
+GArray *thunar_selection_ranges_invert     (GArray       *ranges,
+                                            gint          n_rows) G_GNUC_MALLOC;
+
+guint   thunar_selection_ranges_count      (GArray       *ranges);
+
+GList  *thunar_selection_ranges_get_files  (GArray       *ranges,
+                                            GtkTreeModel *model);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_SELECTION_RANGES_H__ */
@@ -33,18 +33,30 @@
 #include <gio/gdesktopappinfo.h>
 #endif
 
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-desktop-entry-cache.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-sendto-model.h>
 
 
 
-static void thunar_sendto_model_finalize   (GObject                *object);
-static void thunar_sendto_model_load       (ThunarSendtoModel      *sendto_model);
-static void thunar_sendto_model_event      (GFileMonitor           *monitor,
-                                            GFile                  *file,
-                                            GFile                  *other_file,
-                                            GFileMonitorEvent       event_type,
-                                            gpointer                user_data);
+/* number of selections the matching handlers are remembered for */
+#define THUNAR_SENDTO_MODEL_MATCHING_CACHE_SIZE (64)
+
+
+
+static void thunar_sendto_model_finalize      (GObject                *object);
+static void thunar_sendto_model_index         (ThunarSendtoModel      *sendto_model,
+                                               GAppInfo               *handler,
+                                               gchar                 **mime_types);
+static void thunar_sendto_model_load          (ThunarSendtoModel      *sendto_model);
+static void thunar_sendto_model_ensure_loaded (ThunarSendtoModel      *sendto_model);
+static void thunar_sendto_model_event         (GFileMonitor           *monitor,
+                                               GFile                  *file,
+                                               GFile                  *other_file,
+                                               GFileMonitorEvent       event_type,
+                                               gpointer                user_data);
 
 
 
@@ -55,10 +67,16 @@ struct _ThunarSendtoModelClass
 
 struct _ThunarSendtoModel
 {
-  GObject __parent__;
-  GList  *monitors;
-  GList  *handlers;
-  guint   loaded : 1;
+  GObject     __parent__;
+  GList      *monitors;
+  GList      *handlers;
+  guint       loaded : 1;
+
+  /* the handlers with a MimeType key by their unaliased mime types */
+  GHashTable *mime_handlers;
+
+  /* the matching handlers by content types and locality */
+  GHashTable *matching;
 };
 
 
@@ -82,6 +100,10 @@ static void
 thunar_sendto_model_init (ThunarSendtoModel *sendto_model)
 {
   sendto_model->monitors = NULL;
+  sendto_model->mime_handlers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                       (GDestroyNotify) g_ptr_array_unref);
+  sendto_model->matching = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                  (GDestroyNotify) thunar_g_list_free_full);
 }
 
 
@@ -93,6 +115,8 @@ thunar_sendto_model_finalize (GObject *object)
   GList             *lp;
 
   /* release the handlers */
+  g_hash_table_destroy (sendto_model->matching);
+  g_hash_table_destroy (sendto_model->mime_handlers);
   g_list_free_full (sendto_model->handlers, g_object_unref);
 
   /* disconnect all monitors */
@@ -118,6 +142,41 @@ g_app_info_compare (gpointer a,
 
 
 
+static void
+thunar_sendto_model_index (ThunarSendtoModel *sendto_model,
+                           GAppInfo          *handler,
+                           gchar            **mime_types)
+{
+  GPtrArray *handlers;
+  gchar     *content_type;
+  guint      n;
+
+  /* g_content_type_equals() compares unaliased types, so does the index */
+  for (n = 0; mime_types[n] != NULL; ++n)
+    {
+      content_type = g_content_type_from_mime_type (mime_types[n]);
+      if (G_UNLIKELY (content_type == NULL))
+        continue;
+
+      handlers = g_hash_table_lookup (sendto_model->mime_handlers, content_type);
+      if (handlers == NULL)
+        {
+          handlers = g_ptr_array_new ();
+          g_hash_table_insert (sendto_model->mime_handlers, content_type, handlers);
+        }
+      else
+        {
+          g_free (content_type);
+        }
+
+      /* a type listed twice by the handler is counted once */
+      if (handlers->len == 0 || g_ptr_array_index (handlers, handlers->len - 1) != handler)
+        g_ptr_array_add (handlers, handler);
+    }
+}
+
+
+
 static void
 thunar_sendto_model_load (ThunarSendtoModel *sendto_model)
 {
@@ -128,6 +187,9 @@ thunar_sendto_model_load (ThunarSendtoModel *sendto_model)
   gchar           *path;
   guint            n;
   GKeyFile        *key_file;
+  GStatBuf         statb;
+  GFile           *file;
+  guint64          mtime;
   gchar          **mime_types;
 
   /* lookup all sendto .desktop files */
@@ -138,13 +200,13 @@ thunar_sendto_model_load (ThunarSendtoModel *sendto_model)
       path = xfce_resource_lookup (XFCE_RESOURCE_DATA, specs[n]);
       if (G_LIKELY (path != NULL))
         {
-          /* try to load the .desktop file */
-          key_file = g_key_file_new ();
-          if (!g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
-            {
-              g_key_file_free (key_file);
-              continue;
-            }
+          /* try to load the .desktop file, it is parsed only once per change */
+          mtime = (g_stat (path, &statb) == 0) ? (guint64) statb.st_mtime : 0;
+          file = g_file_new_for_path (path);
+          key_file = thunar_desktop_entry_cache_load (file, mtime, NULL, NULL);
+          g_object_unref (file);
+          if (key_file == NULL)
+            continue;
 
 #ifdef HAVE_GIO_UNIX
           app_info = g_desktop_app_info_new_from_keyfile (key_file);
@@ -162,13 +224,16 @@ thunar_sendto_model_load (ThunarSendtoModel *sendto_model)
                                                        G_KEY_FILE_DESKTOP_KEY_MIME_TYPE,
                                                        NULL, NULL);
               if (mime_types != NULL)
-                g_object_set_data_full (G_OBJECT (app_info), "mime-types", mime_types, (GDestroyNotify) g_strfreev);
+                {
+                  thunar_sendto_model_index (sendto_model, G_APP_INFO (app_info), mime_types);
+                  g_object_set_data_full (G_OBJECT (app_info), "mime-types", mime_types, (GDestroyNotify) g_strfreev);
+                }
             }
 #else
           /* FIXME try to create the app info ourselves in a platform independent way */
 #endif
 
-          g_key_file_free (key_file);
+          g_key_file_unref (key_file);
         }
 
       /* cleanup */
@@ -180,6 +245,45 @@ thunar_sendto_model_load (ThunarSendtoModel *sendto_model)
 
 
 
+static void
+thunar_sendto_model_ensure_loaded (ThunarSendtoModel *sendto_model)
+{
+  GFileMonitor *monitor;
+  GFile        *file;
+  gchar       **datadirs;
+  gchar        *dir;
+  guint         n;
+
+  if (G_UNLIKELY (sendto_model->monitors == NULL))
+    {
+      /* watch all possible sendto directories */
+      datadirs = xfce_resource_dirs (XFCE_RESOURCE_DATA);
+      for (n = 0; datadirs[n] != NULL; ++n)
+        {
+          /* determine the path to the sendto directory */
+          dir = g_build_filename (datadirs[n], "Thunar", "sendto", NULL);
+          file = g_file_new_for_path (dir);
+
+          /* watch the directory for changes */
+          monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, NULL);
+          if (G_LIKELY (monitor != NULL))
+            {
+              g_signal_connect (monitor, "changed", G_CALLBACK (thunar_sendto_model_event), sendto_model);
+              sendto_model->monitors = g_list_prepend (sendto_model->monitors, monitor);
+            }
+
+          g_object_unref (file);
+          g_free (dir);
+        }
+      g_strfreev (datadirs);
+
+      /* load the model */
+      thunar_sendto_model_load (sendto_model);
+    }
+}
+
+
+
 static void
 thunar_sendto_model_event (GFileMonitor     *monitor,
                            GFile            *file,
@@ -190,6 +294,8 @@ thunar_sendto_model_event (GFileMonitor     *monitor,
   ThunarSendtoModel *sendto_model = THUNAR_SENDTO_MODEL (user_data);
 
   /* release the previously loaded handlers */
+  g_hash_table_remove_all (sendto_model->matching);
+  g_hash_table_remove_all (sendto_model->mime_handlers);
   if (G_LIKELY (sendto_model->handlers != NULL))
     {
       g_list_free_full (sendto_model->handlers, g_object_unref);
@@ -231,6 +337,24 @@ thunar_sendto_model_get_default (void)
 
 
 
+/**
+ * thunar_sendto_model_preload:
+ * @sendto_model : a #ThunarSendtoModel.
+ *
+ * Loads the "Send To" targets of @sendto_model and starts watching
+ * the sendto directories, which otherwise happens the first time
+ * thunar_sendto_model_get_matching() is called.
+ **/
+void
+thunar_sendto_model_preload (ThunarSendtoModel *sendto_model)
+{
+  _thunar_return_if_fail (THUNAR_IS_SENDTO_MODEL (sendto_model));
+
+  thunar_sendto_model_ensure_loaded (sendto_model);
+}
+
+
+
 /**
  * thunar_sendto_model_get_matching:
  * @sendto_model : a #ThunarSendtoModel.
@@ -252,16 +376,20 @@ GList*
 thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
                                   GList             *files)
 {
-  GFileMonitor *monitor;
-  GFile        *file;
-  gchar       **datadirs;
-  gchar        *dir;
-  GList        *handlers = NULL;
-  GList        *hp;
-  GList        *fp;
-  guint         n;
-  const gchar **mime_types;
-  const gchar  *content_type;
+  GHashTableIter iter;
+  GHashTable    *content_types;
+  GHashTable    *counts;
+  GPtrArray     *supported;
+  gpointer       handler;
+  gchar         *content_type;
+  gchar         *types_key;
+  gchar         *key = NULL;
+  GList         *handlers = NULL;
+  GList         *hp;
+  GList         *fp;
+  gboolean       all_local = TRUE;
+  guint          n_types;
+  guint          n;
 
   _thunar_return_val_if_fail (THUNAR_IS_SENDTO_MODEL (sendto_model), NULL);
 
@@ -270,31 +398,56 @@ thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
     return NULL;
 
   /* connect to the monitor on-demand */
-  if (G_UNLIKELY (sendto_model->monitors == NULL))
+  thunar_sendto_model_ensure_loaded (sendto_model);
+
+  /* check if we have any non-local files */
+  for (fp = files; fp != NULL; fp = fp->next)
+    if (!thunar_file_is_local (fp->data))
+      {
+        all_local = FALSE;
+        break;
+      }
+
+  /* the handlers only depend on the content types and the locality */
+  types_key = thunar_file_list_get_content_types_key (files);
+  if (G_LIKELY (types_key != NULL))
     {
-      /* watch all possible sendto directories */
-      datadirs = xfce_resource_dirs (XFCE_RESOURCE_DATA);
-      for (n = 0; datadirs[n] != NULL; ++n)
+      key = g_strconcat (all_local ? "local\n" : "remote\n", types_key, NULL);
+      g_free (types_key);
+
+      if (g_hash_table_lookup_extended (sendto_model->matching, key, NULL, (gpointer *) &handlers))
         {
-          /* determine the path to the sendto directory */
-          dir = g_build_filename (datadirs[n], "Thunar", "sendto", NULL);
-          file = g_file_new_for_path (dir);
+          g_free (key);
+          return thunar_g_list_copy_deep (handlers);
+        }
+    }
 
-          /* watch the directory for changes */
-          monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, NULL);
-          if (G_LIKELY (monitor != NULL))
-            {
-              g_signal_connect (monitor, "changed", G_CALLBACK (thunar_sendto_model_event), sendto_model);
-              sendto_model->monitors = g_list_prepend (sendto_model->monitors, monitor);
-            }
+  /* each distinct content type has to be looked up only once */
+  content_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (fp = files; fp != NULL; fp = fp->next)
+    if (G_LIKELY (thunar_file_get_content_type (fp->data) != NULL))
+      {
+        content_type = g_content_type_from_mime_type (thunar_file_get_content_type (fp->data));
+        if (G_UNLIKELY (content_type == NULL))
+          content_type = g_strdup (thunar_file_get_content_type (fp->data));
+        g_hash_table_add (content_types, content_type);
+      }
+  n_types = g_hash_table_size (content_types);
+
+  /* count for every handler the content types of the selection it supports */
+  counts = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_iter_init (&iter, content_types);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &content_type, NULL))
+    {
+      supported = g_hash_table_lookup (sendto_model->mime_handlers, content_type);
+      if (supported == NULL)
+        continue;
 
-          g_object_unref (file);
-          g_free (dir);
+      for (n = 0; n < supported->len; ++n)
+        {
+          handler = g_ptr_array_index (supported, n);
+          g_hash_table_insert (counts, handler, GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (counts, handler)) + 1));
         }
-      g_strfreev (datadirs);
-
-      /* load the model */
-      thunar_sendto_model_load (sendto_model);
     }
 
   /* test all handlers */
@@ -303,47 +456,29 @@ thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
       /* FIXME Ignore GAppInfos which don't support multiple file arguments */
 
       /* ignore the handler if it doesn't support URIs, but we don't have a local file */
-      if (!g_app_info_supports_uris (hp->data))
-        {
-          /* check if we have any non-local files */
-          for (fp = files; fp != NULL; fp = fp->next)
-            if (!thunar_file_is_local (fp->data))
-              break;
-
-          /* check if the test failed */
-          if (G_UNLIKELY (fp != NULL))
-            continue;
-        }
-
-      /* check if we need to test mime types for this handler */
-      mime_types = g_object_get_data (G_OBJECT (hp->data), "mime-types");
-      if (mime_types != NULL)
-        {
-          /* each file must match atleast one of the specified mime types */
-          for (fp = files; fp != NULL; fp = fp->next)
-            {
-              /* each file must be supported by one of the mime types */
-              for (n = 0; mime_types[n] != NULL; ++n)
-                {
-                  content_type = thunar_file_get_content_type (fp->data);
-                  if (g_content_type_equals (content_type, mime_types[n]))
-                    break;
-                }
+      if (!g_app_info_supports_uris (hp->data) && !all_local)
+        continue;
 
-              /* check if all mime types failed */
-              if (mime_types[n] == NULL)
-                break;
-            }
-
-          /* check if the test failed */
-          if (G_UNLIKELY (fp != NULL))
-            continue;
-        }
+      /* handlers with mime types must support every content type */
+      if (g_object_get_data (G_OBJECT (hp->data), "mime-types") != NULL
+          && GPOINTER_TO_UINT (g_hash_table_lookup (counts, hp->data)) != n_types)
+        continue;
 
       /* the handler is supported */
       handlers = g_list_prepend (handlers, g_object_ref (G_OBJECT (hp->data)));
     }
 
+  g_hash_table_destroy (counts);
+  g_hash_table_destroy (content_types);
+
+  /* remember the handlers for similar selections */
+  if (G_LIKELY (key != NULL))
+    {
+      if (g_hash_table_size (sendto_model->matching) >= THUNAR_SENDTO_MODEL_MATCHING_CACHE_SIZE)
+        g_hash_table_remove_all (sendto_model->matching);
+      g_hash_table_insert (sendto_model->matching, key, thunar_g_list_copy_deep (handlers));
+    }
+
   return handlers;
 }
 
@@ -38,6 +38,8 @@ GType              thunar_sendto_model_get_type     (void) G_GNUC_CONST;
 
 ThunarSendtoModel *thunar_sendto_model_get_default  (void) G_GNUC_WARN_UNUSED_RESULT;
 
+void               thunar_sendto_model_preload      (ThunarSendtoModel *sendto_model);
+
 GList             *thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
                                                      GList             *files) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
@@ -42,20 +42,28 @@
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-shortcuts-model.h>
 #include <thunar/thunar-device-monitor.h>
+#include <thunar/thunar-free-space.h>
+#include <thunar/thunar-mount-health.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-state-writer.h>
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-private.h>
 
 #define SPINNER_CYCLE_DURATION 1000
 #define SPINNER_NUM_STEPS      12
 
+/* seconds to wait for a bookmark to be resolved */
+#define RESOLVE_TIMEOUT        5
+
 
 
 #define THUNAR_SHORTCUT(obj) ((ThunarShortcut *) (obj))
 
 
 
-typedef struct _ThunarShortcut ThunarShortcut;
+typedef struct _ThunarShortcut        ThunarShortcut;
+typedef struct _ThunarShortcutResolve ThunarShortcutResolve;
+typedef struct _ThunarShortcutLine    ThunarShortcutLine;
 
 
 
@@ -127,6 +135,9 @@ static void               thunar_shortcuts_model_remove_shortcut    (ThunarShort
                                                                      ThunarShortcut            *shortcut);
 static gboolean           thunar_shortcuts_model_load               (gpointer                   data);
 static void               thunar_shortcuts_model_save               (ThunarShortcutsModel      *model);
+static void               thunar_shortcuts_model_saved              (const gchar               *path,
+                                                                     const GError              *error,
+                                                                     gpointer                   user_data);
 static void               thunar_shortcuts_model_monitor            (GFileMonitor              *monitor,
                                                                      GFile                     *file,
                                                                      GFile                     *other_file,
@@ -141,6 +152,7 @@ static void               thunar_shortcuts_model_device_removed     (ThunarDevic
 static void               thunar_shortcuts_model_device_changed     (ThunarDeviceMonitor       *device_monitor,
                                                                      ThunarDevice              *device,
                                                                      ThunarShortcutsModel      *model);
+static void               thunar_shortcuts_model_mount_health_changed (ThunarShortcutsModel    *model);
 
 static void               thunar_shortcut_free                      (ThunarShortcut            *shortcut,
                                                                      ThunarShortcutsModel      *model);
@@ -171,13 +183,16 @@ struct _ThunarShortcutsModel
   gboolean              file_size_binary;
 
   ThunarDeviceMonitor  *device_monitor;
+  ThunarMountHealth    *mount_health;
 
   gint64                bookmarks_time;
+  guint                 bookmarks_n_writes;
   GFile                *bookmarks_file;
   GFileMonitor         *bookmarks_monitor;
   guint                 bookmarks_idle_id;
 
   guint                 busy_timeout_id;
+  guint                 resolve_timeout_id;
 };
 
 struct _ThunarShortcut
@@ -196,9 +211,31 @@ struct _ThunarShortcut
   ThunarFile          *file;
   ThunarDevice        *device;
 
+  /* the display name of a remote location without a name */
+  gchar               *remote_name;
+
+  /* set while the file is being resolved */
+  GCancellable        *cancellable;
+
   guint                hidden : 1;
 };
 
+struct _ThunarShortcutResolve
+{
+  ThunarShortcutsModel *model;
+  ThunarShortcut       *shortcut;
+  GCancellable         *cancellable;
+};
+
+/* a line of the bookmarks file, while it is reloaded */
+struct _ThunarShortcutLine
+{
+  GFile                *location;
+  gchar                *name;
+  gint                  row_num;
+  gboolean              matched;
+};
+
 
 
 G_DEFINE_TYPE_WITH_CODE (ThunarShortcutsModel, thunar_shortcuts_model, G_TYPE_OBJECT,
@@ -296,6 +333,11 @@ thunar_shortcuts_model_init (ThunarShortcutsModel *model)
 
   /* add bookmarks */
   thunar_shortcuts_model_shortcut_places (model);
+
+  /* show the shortcuts on stalled mounts as unavailable */
+  model->mount_health = thunar_mount_health_get ();
+  g_signal_connect_swapped (model->mount_health, "changed",
+                            G_CALLBACK (thunar_shortcuts_model_mount_health_changed), model);
 }
 
 
@@ -311,6 +353,10 @@ thunar_shortcuts_model_finalize (GObject *object)
   if (model->busy_timeout_id != 0)
     g_source_remove (model->busy_timeout_id);
 
+  /* stop the resolve timeout */
+  if (model->resolve_timeout_id != 0)
+    g_source_remove (model->resolve_timeout_id);
+
   /* stop bookmark load idle */
   if (model->bookmarks_idle_id != 0)
     g_source_remove (model->bookmarks_idle_id);
@@ -339,6 +385,9 @@ thunar_shortcuts_model_finalize (GObject *object)
   g_signal_handlers_disconnect_matched (model->device_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, model);
   g_object_unref (model->device_monitor);
 
+  g_signal_handlers_disconnect_by_func (model->mount_health, thunar_shortcuts_model_mount_health_changed, model);
+  g_object_unref (model->mount_health);
+
   (*G_OBJECT_CLASS (thunar_shortcuts_model_parent_class)->finalize) (object);
 }
 
@@ -496,6 +545,9 @@ thunar_shortcuts_model_get_column_type (GtkTreeModel *tree_model,
 
     case THUNAR_SHORTCUTS_MODEL_COLUMN_HIDDEN:
       return G_TYPE_BOOLEAN;
+
+    case THUNAR_SHORTCUTS_MODEL_COLUMN_AVAILABLE:
+      return G_TYPE_BOOLEAN;
     }
 
   _thunar_assert_not_reached ();
@@ -565,6 +617,8 @@ thunar_shortcuts_model_get_value (GtkTreeModel *tree_model,
   gchar          *tooltip;
   guint32         trash_items;
   gchar          *parse_name;
+  guint64         fs_free;
+  guint64         fs_size;
 
   _thunar_return_if_fail (iter->stamp == THUNAR_SHORTCUTS_MODEL (tree_model)->stamp);
   _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (tree_model));
@@ -594,13 +648,18 @@ thunar_shortcuts_model_get_value (GtkTreeModel *tree_model,
     case THUNAR_SHORTCUTS_MODEL_COLUMN_NAME:
       g_value_init (value, G_TYPE_STRING);
       if (G_UNLIKELY (shortcut->device != NULL))
-        g_value_take_string (value, thunar_device_get_name (shortcut->device));
+        g_value_set_static_string (value, thunar_device_peek_name (shortcut->device));
       else if (shortcut->name != NULL)
         g_value_set_static_string (value, shortcut->name);
       else if (shortcut->file != NULL)
         g_value_set_static_string (value, thunar_file_get_display_name (shortcut->file));
       else if (shortcut->location != NULL)
-        g_value_take_string (value, thunar_g_file_get_display_name_remote (shortcut->location));
+        {
+          /* the name only depends on the location, so it is parsed once */
+          if (G_UNLIKELY (shortcut->remote_name == NULL))
+            shortcut->remote_name = thunar_g_file_get_display_name_remote (shortcut->location);
+          g_value_set_static_string (value, shortcut->remote_name);
+        }
       else
         g_value_set_static_string (value, "");
       break;
@@ -640,8 +699,13 @@ thunar_shortcuts_model_get_value (GtkTreeModel *tree_model,
                   location = tmp;
                 }
 
+              /* the tooltip is asked again while the pointer moves, so
+               * the free space shows up once the volume answered */
               file_size_binary = THUNAR_SHORTCUTS_MODEL (tree_model)->file_size_binary;
-              disk_usage = thunar_g_file_get_free_space_string (file, file_size_binary);
+              if (thunar_free_space_lookup (file, &fs_free, &fs_size))
+                disk_usage = thunar_free_space_format (fs_free, fs_size, file_size_binary);
+              else
+                disk_usage = NULL;
 
               if (disk_usage != NULL)
                 tooltip = g_strdup_printf ("%s\n%s", location, disk_usage);
@@ -775,6 +839,23 @@ thunar_shortcuts_model_get_value (GtkTreeModel *tree_model,
       g_value_set_boolean (value, FALSE);
       break;
 
+    case THUNAR_SHORTCUTS_MODEL_COLUMN_AVAILABLE:
+      if (shortcut->device != NULL)
+        file = thunar_device_get_root (shortcut->device);
+      else if (shortcut->file != NULL)
+        file = g_object_ref (thunar_file_get_file (shortcut->file));
+      else if (shortcut->location != NULL)
+        file = g_object_ref (shortcut->location);
+      else
+        file = NULL;
+
+      g_value_init (value, G_TYPE_BOOLEAN);
+      g_value_set_boolean (value, file == NULL || thunar_mount_health_is_available (file));
+
+      if (file != NULL)
+        g_object_unref (file);
+      break;
+
     default:
       _thunar_assert_not_reached ();
     }
@@ -1308,15 +1389,91 @@ thunar_shortcuts_model_local_file (GFile *gfile)
 
 
 
+static void
+thunar_shortcuts_model_resolved (GFile      *location,
+                                 ThunarFile *file,
+                                 GError     *error,
+                                 gpointer    user_data)
+{
+  ThunarShortcutResolve *resolve = user_data;
+  ThunarShortcut        *shortcut = resolve->shortcut;
+  ThunarShortcutsModel  *model = resolve->model;
+  GtkTreePath           *path;
+  GtkTreeIter            iter;
+  GList                 *lp;
+
+  /* the shortcut may be gone if the lookup was cancelled */
+  if (G_UNLIKELY (g_cancellable_is_cancelled (resolve->cancellable)))
+    goto out;
+
+  g_clear_object (&shortcut->cancellable);
+
+  /* keep the placeholder if the file could not be resolved */
+  if (G_UNLIKELY (error != NULL))
+    goto out;
+
+  shortcut->file = g_object_ref (G_OBJECT (file));
+  g_clear_object (&shortcut->gicon);
+
+  /* tell the views about the resolved file */
+  lp = g_list_find (model->shortcuts, shortcut);
+  if (G_LIKELY (lp != NULL))
+    {
+      GTK_TREE_ITER_INIT (iter, model->stamp, lp);
+      path = gtk_tree_path_new_from_indices (g_list_position (model->shortcuts, lp), -1);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+      gtk_tree_path_free (path);
+    }
+
+out:
+  g_object_unref (resolve->cancellable);
+  g_slice_free (ThunarShortcutResolve, resolve);
+}
+
+
+
+static gboolean
+thunar_shortcuts_model_resolve_timeout (gpointer data)
+{
+  ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (data);
+  ThunarShortcut       *shortcut;
+  GList                *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_SHORTCUTS_MODEL (data), FALSE);
+
+  /* stop waiting for the remaining files, they keep their placeholder */
+  for (lp = model->shortcuts; lp != NULL; lp = lp->next)
+    {
+      shortcut = lp->data;
+      if (shortcut->cancellable != NULL)
+        {
+          g_cancellable_cancel (shortcut->cancellable);
+          g_clear_object (&shortcut->cancellable);
+        }
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_shortcuts_model_resolve_timeout_destroyed (gpointer data)
+{
+  THUNAR_SHORTCUTS_MODEL (data)->resolve_timeout_id = 0;
+}
+
+
+
 static void
 thunar_shortcuts_model_load_line (GFile       *file_path,
                                   const gchar *name,
                                   gint         row_num,
                                   gpointer     user_data)
 {
-  ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (user_data);
-  ThunarShortcut       *shortcut;
-  ThunarFile           *file;
+  ThunarShortcutsModel  *model = THUNAR_SHORTCUTS_MODEL (user_data);
+  ThunarShortcut        *shortcut;
+  ThunarShortcutResolve *resolve;
 
   _thunar_return_if_fail (G_IS_FILE (file_path));
   _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
@@ -1330,12 +1487,10 @@ thunar_shortcuts_model_load_line (GFile       *file_path,
   /* If we dont have a thunar-file, we need to set the gicon manually */
   if (thunar_shortcuts_model_local_file (file_path))
     {
-      /* try to open the file corresponding to the uri */
-      file = thunar_file_get (file_path, NULL);
-      if (G_UNLIKELY (file == NULL))
-          shortcut->gicon = g_themed_icon_new ("folder");
-      else
-          shortcut->file = file;
+      /* show a placeholder until the file is resolved, a bookmark
+       * below an unreachable mount point must not block the model */
+      shortcut->gicon = g_themed_icon_new ("folder");
+      shortcut->cancellable = g_cancellable_new ();
     }
   else
     {
@@ -1348,6 +1503,17 @@ thunar_shortcuts_model_load_line (GFile       *file_path,
 
   /* append the shortcut to the list */
   thunar_shortcuts_model_add_shortcut (model, shortcut);
+
+  /* resolve the file once the row exists, the file may already be cached */
+  if (shortcut->cancellable != NULL)
+    {
+      resolve = g_slice_new (ThunarShortcutResolve);
+      resolve->model = model;
+      resolve->shortcut = shortcut;
+      resolve->cancellable = g_object_ref (shortcut->cancellable);
+      thunar_file_get_async (file_path, shortcut->cancellable,
+                             thunar_shortcuts_model_resolved, resolve);
+    }
 }
 
 
@@ -1366,6 +1532,14 @@ THUNAR_THREADS_ENTER
                               thunar_shortcuts_model_load_line,
                               model);
 
+  /* give up on the bookmarks that are not resolved in time */
+  if (model->resolve_timeout_id != 0)
+    g_source_remove (model->resolve_timeout_id);
+  model->resolve_timeout_id =
+      g_timeout_add_seconds_full (G_PRIORITY_DEFAULT, RESOLVE_TIMEOUT,
+                                  thunar_shortcuts_model_resolve_timeout, model,
+                                  thunar_shortcuts_model_resolve_timeout_destroyed);
+
   /* update the visibility */
   thunar_shortcuts_model_header_visibility (model);
 
@@ -1378,40 +1552,142 @@ THUNAR_THREADS_LEAVE
 
 
 
+static void
+thunar_shortcuts_model_collect_line (GFile       *file_path,
+                                     const gchar *name,
+                                     gint         row_num,
+                                     gpointer     user_data)
+{
+  ThunarShortcutLine *line;
+
+  line = g_slice_new (ThunarShortcutLine);
+  line->location = g_object_ref (file_path);
+  line->name = g_strdup (name);
+  line->row_num = row_num;
+  line->matched = FALSE;
+  g_ptr_array_add (user_data, line);
+}
+
+
+
+static void
+thunar_shortcuts_model_line_free (gpointer data)
+{
+  ThunarShortcutLine *line = data;
+
+  g_object_unref (line->location);
+  g_free (line->name);
+  g_slice_free (ThunarShortcutLine, line);
+}
+
+
+
+static GFile *
+thunar_shortcuts_model_bookmark_location (const ThunarShortcut *shortcut)
+{
+  /* the local bookmarks added in this session only have a file */
+  if (shortcut->location != NULL)
+    return shortcut->location;
+  return thunar_file_get_file (shortcut->file);
+}
+
+
+
 static gboolean
 thunar_shortcuts_model_reload (gpointer data)
 {
   ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (data);
+  ThunarShortcutLine   *line;
   ThunarShortcut       *shortcut;
   GtkTreePath          *path;
+  GtkTreeIter           iter;
+  GHashTable           *by_location;
+  GHashTable           *old_positions;
+  GHashTable           *renamed;
+  GPtrArray            *lines;
+  GSList               *shortcuts;
+  GFile                *location;
+  GList                *first = NULL;
   GList                *lp;
+  gint                 *new_order;
+  gint                  first_idx = 0;
+  gint                  n_shortcuts;
   gint                  idx;
+  guint                 n;
+  gboolean              reordered = FALSE;
+  gboolean              inserted = FALSE;
 
   _thunar_return_val_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model), FALSE);
 
 THUNAR_THREADS_ENTER
 
-  /* drop all existing user-defined shortcuts from the model */
-  for (idx = 0, lp = model->shortcuts; lp != NULL; )
+  /* the bookmarks that are still in the file keep their shortcut, so
+   * only the changed rows are updated and the files are not resolved
+   * again. Parse the new bookmarks first */
+  lines = g_ptr_array_new_with_free_func (thunar_shortcuts_model_line_free);
+  thunar_util_load_bookmarks (model->bookmarks_file,
+                              thunar_shortcuts_model_collect_line,
+                              lines);
+
+  /* the existing bookmarks by their location, in model order */
+  by_location = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, NULL, (GDestroyNotify) g_slist_free);
+  for (lp = g_list_last (model->shortcuts); lp != NULL; lp = lp->prev)
     {
-      /* grab the shortcut */
       shortcut = THUNAR_SHORTCUT (lp->data);
+      if (shortcut->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+        {
+          location = thunar_shortcuts_model_bookmark_location (shortcut);
+          shortcuts = g_hash_table_lookup (by_location, location);
+          g_hash_table_steal (by_location, location);
+          g_hash_table_insert (by_location, location, g_slist_prepend (shortcuts, shortcut));
+        }
+    }
 
-      /* advance to the next list item */
-      lp = g_list_next (lp);
+  /* match every line with an existing bookmark, the unmatched lines are new */
+  old_positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  renamed = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (n = 0; n < lines->len; ++n)
+    {
+      line = g_ptr_array_index (lines, n);
+      shortcuts = g_hash_table_lookup (by_location, line->location);
+      if (shortcuts == NULL)
+        continue;
 
-      /* drop the shortcut if it is user-defined */
-      if (shortcut->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+      shortcut = shortcuts->data;
+      g_hash_table_steal (by_location, line->location);
+      if (shortcuts->next != NULL)
+        g_hash_table_insert (by_location, thunar_shortcuts_model_bookmark_location (shortcuts->next->data), shortcuts->next);
+      g_slist_free_1 (shortcuts);
+
+      g_hash_table_insert (old_positions, shortcut, GINT_TO_POINTER (-1));
+      line->matched = TRUE;
+
+      /* take over the new position and name */
+      shortcut->sort_id = line->row_num;
+      if (g_strcmp0 (shortcut->name, line->name) != 0)
+        {
+          g_free (shortcut->name);
+          shortcut->name = g_strdup (line->name);
+          g_hash_table_add (renamed, shortcut);
+        }
+    }
+  g_hash_table_destroy (by_location);
+
+  /* drop the bookmarks that are gone */
+  for (idx = 0, lp = model->shortcuts; lp != NULL; )
+    {
+      shortcut = THUNAR_SHORTCUT (lp->data);
+      lp = lp->next;
+
+      if (shortcut->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS
+          && !g_hash_table_contains (old_positions, shortcut))
         {
-          /* unlink the shortcut from the model */
           model->shortcuts = g_list_remove (model->shortcuts, shortcut);
 
-          /* tell everybody that we have lost a shortcut */
           path = gtk_tree_path_new_from_indices (idx, -1);
           gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
           gtk_tree_path_free (path);
 
-          /* actually free the shortcut */
           thunar_shortcut_free (shortcut, model);
         }
       else
@@ -1420,10 +1696,110 @@ THUNAR_THREADS_ENTER
         }
     }
 
+  /* remember where the remaining bookmarks are */
+  for (idx = 0, lp = model->shortcuts; lp != NULL; ++idx, lp = lp->next)
+    {
+      shortcut = THUNAR_SHORTCUT (lp->data);
+      if (shortcut->group != THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+        continue;
+
+      if (first == NULL)
+        {
+          first = lp;
+          first_idx = idx;
+        }
+      g_hash_table_insert (old_positions, shortcut, GINT_TO_POINTER (idx));
+
+      /* check whether the file lists them in another order */
+      if (lp->next != NULL && THUNAR_SHORTCUT (lp->next->data)->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS
+          && THUNAR_SHORTCUT (lp->next->data)->sort_id < shortcut->sort_id)
+        reordered = TRUE;
+    }
+
+  /* the bookmarks follow each other, so only their part of the list is sorted */
+  if (G_UNLIKELY (reordered))
+    {
+      for (lp = first; lp != NULL && THUNAR_SHORTCUT (lp->data)->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS; lp = lp->next)
+        ;
+      if (lp != NULL)
+        lp->prev->next = NULL;
+      if (first->prev != NULL)
+        first->prev->next = NULL;
+      else
+        model->shortcuts = NULL;
+
+      first->prev = NULL;
+      first = g_list_sort (first, thunar_shortcuts_model_sort_func);
+      model->shortcuts = g_list_concat (model->shortcuts, g_list_concat (first, lp));
+
+      n_shortcuts = g_list_length (model->shortcuts);
+      new_order = g_new (gint, n_shortcuts);
+      for (idx = 0, lp = model->shortcuts; lp != NULL; ++idx, lp = lp->next)
+        {
+          if (THUNAR_SHORTCUT (lp->data)->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+            new_order[idx] = GPOINTER_TO_INT (g_hash_table_lookup (old_positions, lp->data));
+          else
+            new_order[idx] = idx;
+        }
+
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (model), path, NULL, new_order);
+      gtk_tree_path_free (path);
+      g_free (new_order);
+
+      /* the bookmarks may start at another list item now */
+      first = g_list_nth (model->shortcuts, first_idx);
+    }
+
+  /* tell the views about the renamed bookmarks */
+  for (idx = first_idx, lp = first;
+       lp != NULL && THUNAR_SHORTCUT (lp->data)->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS;
+       ++idx, lp = lp->next)
+    {
+      shortcut = THUNAR_SHORTCUT (lp->data);
+      if (g_hash_table_contains (renamed, shortcut))
+        {
+          GTK_TREE_ITER_INIT (iter, model->stamp, lp);
+          path = gtk_tree_path_new_from_indices (idx, -1);
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+          gtk_tree_path_free (path);
+        }
+    }
+
+  g_hash_table_destroy (old_positions);
+  g_hash_table_destroy (renamed);
+
+  /* add the new bookmarks, at the position of their line */
+  for (n = 0; n < lines->len; ++n)
+    {
+      line = g_ptr_array_index (lines, n);
+      if (!line->matched)
+        {
+          thunar_shortcuts_model_load_line (line->location, line->name, line->row_num, model);
+          inserted = TRUE;
+        }
+    }
+  g_ptr_array_free (lines, TRUE);
+
+  /* give up on the new bookmarks that are not resolved in time */
+  if (inserted)
+    {
+      if (model->resolve_timeout_id != 0)
+        g_source_remove (model->resolve_timeout_id);
+      model->resolve_timeout_id =
+          g_timeout_add_seconds_full (G_PRIORITY_DEFAULT, RESOLVE_TIMEOUT,
+                                      thunar_shortcuts_model_resolve_timeout, model,
+                                      thunar_shortcuts_model_resolve_timeout_destroyed);
+    }
+
+  /* update the visibility */
+  thunar_shortcuts_model_header_visibility (model);
+
 THUNAR_THREADS_LEAVE
 
-  /* load new bookmarks */
-  return thunar_shortcuts_model_load (data);
+  model->bookmarks_idle_id = 0;
+
+  return FALSE;
 }
 
 
@@ -1440,8 +1816,9 @@ thunar_shortcuts_model_monitor (GFileMonitor     *monitor,
   _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
   _thunar_return_if_fail (model->bookmarks_monitor == monitor);
 
-  /* leave if we saved less than 2 seconds ago */
-  if (model->bookmarks_time + 2 * G_USEC_PER_SEC > g_get_real_time ())
+  /* leave if we are saving or saved less than 2 seconds ago */
+  if (model->bookmarks_n_writes > 0
+      || model->bookmarks_time + 2 * G_USEC_PER_SEC > g_get_real_time ())
     return;
 
   /* reload the shortcuts model */
@@ -1456,11 +1833,10 @@ thunar_shortcuts_model_save (ThunarShortcutsModel *model)
 {
   GString        *contents;
   ThunarShortcut *shortcut;
+  GBytes         *bytes;
   gchar          *bookmarks_path;
   gchar          *uri;
   GList          *lp;
-  GError         *err = NULL;
-  GFile          *parent = NULL;
 
   _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
 
@@ -1486,34 +1862,32 @@ thunar_shortcuts_model_save (ThunarShortcutsModel *model)
         }
     }
 
-  /* create folder if it does not exist */
-  parent = g_file_get_parent (model->bookmarks_file);
-  if (!g_file_make_directory_with_parents (parent, NULL, &err))
-    {
-       if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_EXISTS))
-         {
-           g_clear_error (&err);
-         }
-       else
-         {
-           g_warning ("Failed to create bookmarks folder: %s", err->message);
-           g_error_free (err);
-         }
-    }
-  g_clear_object (&parent);
-
-  /* write data to the disk */
+  /* write data to the disk in the background, shortly after the last
+   * change, so reordering the bookmarks writes the file once */
   bookmarks_path = g_file_get_path (model->bookmarks_file);
-  if (!g_file_set_contents (bookmarks_path, contents->str, contents->len, &err))
-    {
-      g_warning ("Failed to write \"%s\": %s", bookmarks_path, err->message);
-      g_error_free (err);
-    }
+  bytes = g_bytes_new_take (contents->str, contents->len);
+  g_string_free (contents, FALSE);
+  model->bookmarks_n_writes++;
+  thunar_state_writer_schedule (bookmarks_path, bytes, 500,
+                                thunar_shortcuts_model_saved, g_object_ref (model));
+  g_bytes_unref (bytes);
   g_free (bookmarks_path);
-  g_string_free (contents, TRUE);
+}
+
+
+
+static void
+thunar_shortcuts_model_saved (const gchar  *path,
+                              const GError *error,
+                              gpointer      user_data)
+{
+  ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (user_data);
 
   /* store the save time */
+  model->bookmarks_n_writes--;
   model->bookmarks_time = g_get_real_time ();
+
+  g_object_unref (model);
 }
 
 
@@ -1646,6 +2020,29 @@ thunar_shortcuts_model_device_changed (ThunarDeviceMonitor  *device_monitor,
 
 
 
+static void
+thunar_shortcuts_model_mount_health_changed (ThunarShortcutsModel *model)
+{
+  GtkTreeIter  iter;
+  GtkTreePath *path;
+  GList       *lp;
+  gint         idx;
+
+  _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
+
+  /* there are only a few shortcuts, so let the views check all of them */
+  for (lp = model->shortcuts, idx = 0; lp != NULL; lp = lp->next, idx++)
+    {
+      GTK_TREE_ITER_INIT (iter, model->stamp, lp);
+
+      path = gtk_tree_path_new_from_indices (idx, -1);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+
+
 static void
 thunar_shortcut_free (ThunarShortcut       *shortcut,
                       ThunarShortcutsModel *model)
@@ -1668,7 +2065,15 @@ thunar_shortcut_free (ThunarShortcut       *shortcut,
   if (G_LIKELY (shortcut->location != NULL))
     g_object_unref (shortcut->location);
 
+  /* the pending file lookup leaves the shortcut alone once cancelled */
+  if (G_UNLIKELY (shortcut->cancellable != NULL))
+    {
+      g_cancellable_cancel (shortcut->cancellable);
+      g_object_unref (shortcut->cancellable);
+    }
+
   g_free (shortcut->name);
+  g_free (shortcut->remote_name);
   g_free (shortcut->tooltip);
 
   /* release the shortcut itself */
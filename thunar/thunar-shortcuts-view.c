@@ -42,6 +42,7 @@
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
 #include <thunar/thunar-menu.h>
+#include <thunar/thunar-mount-health.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-shortcuts-icon-renderer.h>
@@ -341,6 +342,7 @@ thunar_shortcuts_view_init (ThunarShortcutsView *view)
                                        "file", THUNAR_SHORTCUTS_MODEL_COLUMN_FILE,
                                        "device", THUNAR_SHORTCUTS_MODEL_COLUMN_DEVICE,
                                        "visible", THUNAR_SHORTCUTS_MODEL_COLUMN_IS_ITEM,
+                                       "sensitive", THUNAR_SHORTCUTS_MODEL_COLUMN_AVAILABLE,
                                        NULL);
 
   /* sync the "emblems" property of the icon renderer with the "shortcuts-icon-emblems" preference
@@ -358,6 +360,7 @@ thunar_shortcuts_view_init (ThunarShortcutsView *view)
   gtk_tree_view_column_set_attributes (column, renderer,
                                        "text", THUNAR_SHORTCUTS_MODEL_COLUMN_NAME,
                                        "visible", THUNAR_SHORTCUTS_MODEL_COLUMN_IS_ITEM,
+                                       "sensitive", THUNAR_SHORTCUTS_MODEL_COLUMN_AVAILABLE,
                                        NULL);
 
   /* spinner to indicate (un)mount/eject delay */
@@ -1486,10 +1489,10 @@ thunar_shortcuts_view_compute_drop_actions (ThunarShortcutsView     *view,
           GFileInfo *info;
           gboolean   is_directory;
 
-          info = g_file_query_info (lp->data,
-                                    G_FILE_ATTRIBUTE_STANDARD_TYPE,
-                                    G_FILE_QUERY_INFO_NONE,
-                                    NULL, NULL);
+          info = thunar_mount_health_query_info (lp->data,
+                                                 G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                                 G_FILE_QUERY_INFO_NONE,
+                                                 NULL, NULL);
 
           if (G_UNLIKELY (info == NULL))
             return 0;
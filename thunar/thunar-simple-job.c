@@ -38,6 +38,7 @@
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-simple-job.h>
+#include <thunar/thunar-trace.h>
 
 
 
@@ -56,6 +57,7 @@ struct _ThunarSimpleJob
 {
   ThunarJob __parent__;
 
+  const gchar         *name;
   ThunarSimpleJobFunc  func;
   GArray              *param_values;
 };
@@ -111,12 +113,24 @@ thunar_simple_job_execute (ExoJob  *job,
   ThunarSimpleJob *simple_job = THUNAR_SIMPLE_JOB (job);
   gboolean         success = TRUE;
   GError          *err = NULL;
+  gint64           trace_time;
 
   _thunar_return_val_if_fail (THUNAR_IS_SIMPLE_JOB (job), FALSE);
   _thunar_return_val_if_fail (simple_job->func != NULL, FALSE);
 
+  /* wait until the job may run in its priority class */
+  if (!thunar_job_enter (THUNAR_JOB (job)))
+    {
+      exo_job_set_error_if_cancelled (job, error);
+      return FALSE;
+    }
+
   /* try to execute the job using the supplied function */
+  trace_time = thunar_trace_begin ();
   success = (*simple_job->func) (THUNAR_JOB (job), simple_job->param_values, &err);
+  thunar_trace_end (trace_time, "job", simple_job->name, NULL);
+
+  thunar_job_leave (THUNAR_JOB (job));
 
   if (!success)
     {
@@ -143,7 +157,8 @@ thunar_simple_job_execute (ExoJob  *job,
 
 
 /**
- * thunar_simple_job_new:
+ * thunar_simple_job_new_named:
+ * @name           : the name of the job in traces.
  * @func           : the #ThunarSimpleJobFunc to execute the job.
  * @n_param_values : the number of parameters to pass to the @func.
  * @...            : a list of #GType and parameter pairs (exactly
@@ -154,6 +169,9 @@ thunar_simple_job_execute (ExoJob  *job,
  *
  * Use exo_job_launch() to launch the returned job..
  *
+ * This is usually called through the thunar_simple_job_new() macro,
+ * which uses the name of @func as @name.
+ *
  * For example the listdir @func expects a #ThunarPath for the
  * folder to list, so the call to thunar_simple_job_new()
  * would look like this:
@@ -170,9 +188,10 @@ thunar_simple_job_execute (ExoJob  *job,
  * Return value: a #ThunarJob.
  **/
 ThunarJob *
-thunar_simple_job_new (ThunarSimpleJobFunc func,
-                       guint               n_param_values,
-                       ...)
+thunar_simple_job_new_named (const gchar        *name,
+                             ThunarSimpleJobFunc func,
+                             guint               n_param_values,
+                             ...)
 {
   ThunarSimpleJob *simple_job;
   va_list          var_args;
@@ -182,6 +201,7 @@ thunar_simple_job_new (ThunarSimpleJobFunc func,
 
   /* allocate and initialize the simple job */
   simple_job = g_object_new (THUNAR_TYPE_SIMPLE_JOB, NULL);
+  simple_job->name = name;
   simple_job->func = func;
   simple_job->param_values = g_array_sized_new (FALSE, TRUE, sizeof (GValue), n_param_values);
 
@@ -54,11 +54,15 @@ typedef struct _ThunarSimpleJob      ThunarSimpleJob;
 
 GType      thunar_simple_job_get_type           (void) G_GNUC_CONST;
 
-ThunarJob *thunar_simple_job_new                (ThunarSimpleJobFunc func,
+ThunarJob *thunar_simple_job_new_named          (const gchar        *name,
+                                                 ThunarSimpleJobFunc func,
                                                  guint               n_param_values,
                                                  ...) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 GArray    *thunar_simple_job_get_param_values   (ThunarSimpleJob    *job);
 
+/* jobs are named after their function, so traces can tell them apart */
+#define thunar_simple_job_new(func, ...) thunar_simple_job_new_named (G_STRINGIFY (func), func, __VA_ARGS__)
+
 G_END_DECLS
 
 #endif /* !__THUNAR_SIMPLE_JOB_H__ */
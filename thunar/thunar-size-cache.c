@@ -0,0 +1,488 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-size-cache.h>
+
+
+
+/* The size cache remembers what the deep count found directly inside a
+ * directory: the number and total size of its files and the names of its
+ * subdirectories. An entry is only used for the modification time it was
+ * counted for, so a deep count only enumerates the directories that
+ * changed since and walks the unchanged ones by their cached names.
+ *
+ * Rewriting a file does not change the modification time of its
+ * directory, so the folder monitors invalidate the directories in which
+ * files change. The cache file is a header followed by a record per
+ * directory, each followed by the nul-terminated uri and subdirectory
+ * names. Every record is aligned to 8 bytes.
+ */
+#define SIZE_CACHE_MAGIC       "THSIZE01"
+#define SIZE_CACHE_ALIGN(n)    (((n) + 7) & ~((gsize) 7))
+#define SIZE_CACHE_MAX_ENTRIES (262144)
+
+
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 n_entries;
+  guint32 reserved;
+}
+SizeCacheHeader;
+
+typedef struct
+{
+  guint64 mtime;
+  guint64 size;
+  guint32 file_count;
+  guint32 n_directories;
+  guint32 uri_len;
+  guint32 names_len;
+}
+SizeCacheRecord;
+
+typedef struct
+{
+  guint64  mtime;
+  guint64  size;
+  guint    file_count;
+  gchar  **directories;
+}
+SizeCacheEntry;
+
+
+
+/* the cached directories and their state, protected by the lock below */
+static GHashTable *size_cache = NULL;
+static gboolean    size_cache_persistent = FALSE;
+static gboolean    size_cache_loaded = FALSE;
+static gboolean    size_cache_dirty = FALSE;
+G_LOCK_DEFINE_STATIC (size_cache);
+
+
+
+static gchar *
+thunar_size_cache_get_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "Thunar", "directory-sizes", NULL);
+}
+
+
+
+static void
+thunar_size_cache_entry_free (gpointer data)
+{
+  SizeCacheEntry *entry = data;
+
+  g_strfreev (entry->directories);
+  g_slice_free (SizeCacheEntry, entry);
+}
+
+
+
+static void
+thunar_size_cache_load (GHashTable *table)
+{
+  SizeCacheHeader  header;
+  SizeCacheRecord  record;
+  SizeCacheEntry  *entry;
+  GMappedFile     *mapped;
+  const gchar     *data;
+  const gchar     *uri;
+  const gchar     *names;
+  const gchar     *name;
+  gsize            length;
+  gsize            offset;
+  gchar           *path;
+  guint            n;
+  guint            i;
+
+  path = thunar_size_cache_get_path ();
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+  if (G_UNLIKELY (mapped == NULL))
+    return;
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+
+  if (length < sizeof (SizeCacheHeader))
+    goto out;
+
+  memcpy (&header, data, sizeof (SizeCacheHeader));
+  if (memcmp (header.magic, SIZE_CACHE_MAGIC, sizeof (header.magic)) != 0)
+    goto out;
+
+  offset = sizeof (SizeCacheHeader);
+
+  for (n = 0; n < header.n_entries && n < SIZE_CACHE_MAX_ENTRIES; ++n)
+    {
+      if (offset + sizeof (SizeCacheRecord) > length)
+        break;
+
+      memcpy (&record, data + offset, sizeof (SizeCacheRecord));
+      offset += sizeof (SizeCacheRecord);
+
+      /* make sure the strings are complete */
+      uri = data + offset;
+      names = uri + record.uri_len + 1;
+      if (record.uri_len == 0
+          || (guint64) offset + record.uri_len + 1 + record.names_len > length
+          || uri[record.uri_len] != '\0'
+          || (record.names_len > 0 && names[record.names_len - 1] != '\0'))
+        break;
+
+      offset = SIZE_CACHE_ALIGN (offset + record.uri_len + 1 + record.names_len);
+
+      /* entries counted since the cache was enabled are newer */
+      if (g_hash_table_contains (table, uri))
+        continue;
+
+      entry = g_slice_new (SizeCacheEntry);
+      entry->mtime = record.mtime;
+      entry->size = record.size;
+      entry->file_count = record.file_count;
+      entry->directories = g_new (gchar *, record.n_directories + 1);
+
+      for (i = 0, name = names; i < record.n_directories && name < names + record.names_len; ++i)
+        {
+          entry->directories[i] = g_strdup (name);
+          name += strlen (name) + 1;
+        }
+      entry->directories[i] = NULL;
+
+      if (G_UNLIKELY (i < record.n_directories))
+        {
+          thunar_size_cache_entry_free (entry);
+          break;
+        }
+
+      g_hash_table_insert (table, g_strdup (uri), entry);
+    }
+
+out:
+  g_mapped_file_unref (mapped);
+}
+
+
+
+static GHashTable *
+thunar_size_cache_get_table (void)
+{
+  /* the lock must be held */
+  if (G_UNLIKELY (size_cache == NULL))
+    size_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, thunar_size_cache_entry_free);
+
+  /* read the cache file on first use, which is usually from a job */
+  if (size_cache_persistent && !size_cache_loaded)
+    {
+      size_cache_loaded = TRUE;
+      thunar_size_cache_load (size_cache);
+    }
+
+  return size_cache;
+}
+
+
+
+/**
+ * thunar_size_cache_lookup:
+ * @directory          : the #GFile of a directory.
+ * @mtime              : the modification time of @directory in microseconds.
+ * @size_return        : return location for the total size of the files.
+ * @file_count_return  : return location for the number of files.
+ * @directories_return : return location for the names of the subdirectories.
+ *
+ * Looks up what was counted directly inside @directory, if it was counted
+ * before and @directory did not change since. Only the files are included
+ * in the totals, the subdirectories must be counted by their names. May be
+ * used from any thread.
+ *
+ * The caller is responsible to free the returned names using g_strfreev()
+ * when no longer needed.
+ *
+ * Return value: %TRUE if @directory was found in the cache.
+ **/
+gboolean
+thunar_size_cache_lookup (GFile     *directory,
+                          guint64    mtime,
+                          guint64   *size_return,
+                          guint     *file_count_return,
+                          gchar   ***directories_return)
+{
+  SizeCacheEntry *entry;
+  gboolean        found = FALSE;
+  gchar          *uri;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+
+  /* without a modification time we cannot tell if an entry is valid */
+  if (G_UNLIKELY (mtime == 0))
+    return FALSE;
+
+  uri = g_file_get_uri (directory);
+
+  G_LOCK (size_cache);
+  entry = g_hash_table_lookup (thunar_size_cache_get_table (), uri);
+  if (entry != NULL && entry->mtime == mtime)
+    {
+      *size_return = entry->size;
+      *file_count_return = entry->file_count;
+      *directories_return = g_strdupv (entry->directories);
+      found = TRUE;
+    }
+  G_UNLOCK (size_cache);
+
+  g_free (uri);
+
+  return found;
+}
+
+
+
+/**
+ * thunar_size_cache_insert:
+ * @directory   : the #GFile of a directory.
+ * @mtime       : the modification time of @directory in microseconds.
+ * @size        : the total size of the files in @directory.
+ * @file_count  : the number of files in @directory.
+ * @directories : the %NULL-terminated names of the subdirectories.
+ *
+ * Remembers what was counted directly inside @directory for
+ * thunar_size_cache_lookup(). May be used from any thread.
+ **/
+void
+thunar_size_cache_insert (GFile    *directory,
+                          guint64   mtime,
+                          guint64   size,
+                          guint     file_count,
+                          gchar   **directories)
+{
+  SizeCacheEntry *entry;
+  GHashTable     *table;
+
+  _thunar_return_if_fail (G_IS_FILE (directory));
+  _thunar_return_if_fail (directories != NULL);
+
+  if (G_UNLIKELY (mtime == 0))
+    return;
+
+  entry = g_slice_new (SizeCacheEntry);
+  entry->mtime = mtime;
+  entry->size = size;
+  entry->file_count = file_count;
+  entry->directories = g_strdupv (directories);
+
+  G_LOCK (size_cache);
+  table = thunar_size_cache_get_table ();
+
+  /* start over instead of tracking the use of every entry */
+  if (G_UNLIKELY (g_hash_table_size (table) >= SIZE_CACHE_MAX_ENTRIES))
+    g_hash_table_remove_all (table);
+
+  g_hash_table_replace (table, g_file_get_uri (directory), entry);
+  size_cache_dirty = TRUE;
+  G_UNLOCK (size_cache);
+}
+
+
+
+/**
+ * thunar_size_cache_invalidate:
+ * @directory : the #GFile of a directory.
+ *
+ * Forgets the entry of @directory, which must be called when a file
+ * inside @directory changed without changing the directory.
+ **/
+void
+thunar_size_cache_invalidate (GFile *directory)
+{
+  gchar *uri;
+
+  _thunar_return_if_fail (G_IS_FILE (directory));
+
+  G_LOCK (size_cache);
+
+  /* nothing to forget before the first count */
+  if (size_cache != NULL)
+    {
+      uri = g_file_get_uri (directory);
+      if (g_hash_table_remove (size_cache, uri))
+        size_cache_dirty = TRUE;
+      g_free (uri);
+    }
+
+  G_UNLOCK (size_cache);
+}
+
+
+
+/**
+ * thunar_size_cache_set_persistent:
+ * @persistent : whether the cache is kept in the cache directory.
+ *
+ * Enables or disables keeping the size cache across sessions. When
+ * enabled, the cache file is read on first use and written by
+ * thunar_size_cache_save(), otherwise the cache file is removed.
+ **/
+void
+thunar_size_cache_set_persistent (gboolean persistent)
+{
+  gchar *path;
+
+  G_LOCK (size_cache);
+  size_cache_persistent = persistent;
+  G_UNLOCK (size_cache);
+
+  /* don't leave sizes of previous sessions behind */
+  if (!persistent)
+    {
+      path = thunar_size_cache_get_path ();
+      g_unlink (path);
+      g_free (path);
+    }
+}
+
+
+
+/**
+ * thunar_size_cache_save:
+ *
+ * Writes the size cache to the cache directory, if it is persistent
+ * and changed since it was read.
+ **/
+void
+thunar_size_cache_save (void)
+{
+  SizeCacheHeader  header;
+  SizeCacheRecord  record;
+  SizeCacheEntry  *entry;
+  GHashTableIter   iter;
+  GByteArray      *array;
+  gpointer         key;
+  gpointer         value;
+  gchar           *path;
+  gchar           *dirname;
+  GError          *error = NULL;
+  gsize            uri_len;
+  gsize            name_len;
+  guint            n;
+  static const guint8 zeros[8] = { 0, };
+
+  G_LOCK (size_cache);
+  if (!size_cache_persistent || !size_cache_dirty || size_cache == NULL)
+    {
+      G_UNLOCK (size_cache);
+      return;
+    }
+
+  /* entries not read yet are written with the others */
+  thunar_size_cache_get_table ();
+
+  memset (&header, 0, sizeof (SizeCacheHeader));
+  memcpy (header.magic, SIZE_CACHE_MAGIC, sizeof (header.magic));
+
+  array = g_byte_array_new ();
+  g_byte_array_append (array, (const guint8 *) &header, sizeof (SizeCacheHeader));
+
+  g_hash_table_iter_init (&iter, size_cache);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      entry = value;
+      uri_len = strlen (key);
+
+      memset (&record, 0, sizeof (SizeCacheRecord));
+      record.mtime = entry->mtime;
+      record.size = entry->size;
+      record.file_count = entry->file_count;
+      record.uri_len = uri_len;
+      for (n = 0; entry->directories[n] != NULL; ++n)
+        record.names_len += strlen (entry->directories[n]) + 1;
+      record.n_directories = n;
+
+      g_byte_array_append (array, (const guint8 *) &record, sizeof (SizeCacheRecord));
+      g_byte_array_append (array, key, uri_len + 1);
+      for (n = 0; entry->directories[n] != NULL; ++n)
+        {
+          name_len = strlen (entry->directories[n]);
+          g_byte_array_append (array, (const guint8 *) entry->directories[n], name_len + 1);
+        }
+      g_byte_array_append (array, zeros, SIZE_CACHE_ALIGN (array->len) - array->len);
+
+      header.n_entries++;
+    }
+
+  size_cache_dirty = FALSE;
+  G_UNLOCK (size_cache);
+
+  /* update the number of entries in the header */
+  memcpy (array->data, &header, sizeof (SizeCacheHeader));
+
+  path = thunar_size_cache_get_path ();
+  dirname = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dirname, 0700) != 0
+      || !g_file_set_contents (path, (const gchar *) array->data, array->len, &error))
+    {
+      g_debug ("Failed to write the size cache: %s", error != NULL ? error->message : g_strerror (errno));
+      g_clear_error (&error);
+    }
+
+  g_byte_array_free (array, TRUE);
+  g_free (dirname);
+  g_free (path);
+}
+
+
+
+/**
+ * thunar_size_cache_clear:
+ *
+ * Writes the size cache if it is persistent and releases all
+ * entries. A persistent cache is read again on next use.
+ **/
+void
+thunar_size_cache_clear (void)
+{
+  thunar_size_cache_save ();
+
+  G_LOCK (size_cache);
+  if (size_cache != NULL)
+    {
+      g_hash_table_destroy (size_cache);
+      size_cache = NULL;
+    }
+  size_cache_loaded = FALSE;
+  G_UNLOCK (size_cache);
+}
@@ -323,6 +323,7 @@ thunar_size_label_files_changed (ThunarSizeLabel *size_label)
     {
       /* schedule a new job to determine the total size of the directory (not following symlinks) */
       size_label->job = thunar_deep_count_job_new (size_label->files, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS);
+      thunar_job_set_priority (THUNAR_JOB (size_label->job), THUNAR_JOB_PRIORITY_INTERACTIVE);
       g_signal_connect (size_label->job, "error", G_CALLBACK (thunar_size_label_error), size_label);
       g_signal_connect (size_label->job, "finished", G_CALLBACK (thunar_size_label_finished), size_label);
       g_signal_connect (size_label->job, "status-update", G_CALLBACK (thunar_size_label_status_update), size_label);
@@ -400,6 +401,8 @@ thunar_size_label_status_update (ThunarDeepCountJob *job,
   gchar             *text;
   guint              n;
   gchar             *unreable_text;
+  gchar             *excluded_text;
+  guint              n_excluded;
 
   _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
   _thunar_return_if_fail (THUNAR_IS_SIZE_LABEL (size_label));
@@ -424,6 +427,18 @@ thunar_size_label_status_update (ThunarDeepCountJob *job,
           text = unreable_text;
         }
 
+      n_excluded = thunar_deep_count_job_get_excluded_count (job);
+      if (n_excluded > 0)
+        {
+          /* TRANSLATORS: this is shown if folders were skipped during the
+           * deep count because they match the scan exclusions */
+          excluded_text = g_strdup_printf (ngettext ("(%u folder not counted)", "(%u folders not counted)", n_excluded), n_excluded);
+          unreable_text = g_strconcat (text, "\n", excluded_text, NULL);
+          g_free (excluded_text);
+          g_free (text);
+          text = unreable_text;
+        }
+
       gtk_label_set_text (GTK_LABEL (size_label->label), text);
       g_free (text);
     }
@@ -42,15 +42,19 @@
 #include <thunar/thunar-gtk-extensions.h>
 #include <thunar/thunar-history.h>
 #include <thunar/thunar-icon-renderer.h>
+#include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-launcher.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-pango-extensions.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-properties-dialog.h>
 #include <thunar/thunar-renamer-dialog.h>
+#include <thunar/thunar-scheduler.h>
 #include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-standard-view.h>
+#include <thunar/thunar-text-renderer.h>
 #include <thunar/thunar-thumbnailer.h>
+#include <thunar/thunar-trace.h>
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-details-view.h>
 
@@ -60,6 +64,14 @@
 
 
 
+/* the number of folders kept loaded in advance */
+#define THUNAR_STANDARD_VIEW_PREFETCH_MAX         (4)
+
+/* the time in milliseconds a folder must be hovered before it is prefetched */
+#define THUNAR_STANDARD_VIEW_PREFETCH_HOVER_DELAY (500)
+
+
+
 /* Property identifiers */
 enum
 {
@@ -133,6 +145,11 @@ static ThunarZoomLevel      thunar_standard_view_get_zoom_level             (Thu
 static void                 thunar_standard_view_set_zoom_level             (ThunarView               *view,
                                                                              ThunarZoomLevel           zoom_level);
 static void                 thunar_standard_view_reset_zoom_level           (ThunarView               *view);
+static gboolean             thunar_standard_view_transform_thumbnail_size   (GBinding                 *binding,
+                                                                             const GValue             *src_value,
+                                                                             GValue                   *dst_value,
+                                                                             gpointer                  user_data);
+static void                 thunar_standard_view_scale_factor_changed       (ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_apply_directory_specific_settings    (ThunarStandardView   *standard_view,
                                                                                        ThunarFile           *directory);
 static void                 thunar_standard_view_set_directory_specific_settings      (ThunarStandardView   *standard_view,
@@ -154,6 +171,11 @@ static GdkDragAction        thunar_standard_view_get_dest_actions           (Thu
                                                                              gint                      y,
                                                                              guint                     timestamp,
                                                                              ThunarFile              **file_return);
+static void                 thunar_standard_view_drop_actions_free          (gpointer                  data);
+static GdkDragAction        thunar_standard_view_accepts_drop               (ThunarStandardView       *standard_view,
+                                                                             ThunarFile               *file,
+                                                                             GdkDragContext           *context,
+                                                                             GdkDragAction            *action_return);
 static ThunarFile          *thunar_standard_view_get_drop_file              (ThunarStandardView       *standard_view,
                                                                              gint                      x,
                                                                              gint                      y,
@@ -259,10 +281,30 @@ static gboolean             thunar_standard_view_request_thumbnails_lazy    (gpo
 static void                 thunar_standard_view_thumbnail_mode_toggled     (ThunarStandardView       *standard_view,
                                                                              GParamSpec               *pspec,
                                                                              ThunarIconFactory        *icon_factory);
+static void                 thunar_standard_view_prefetch_changed           (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_prefetch_cancel            (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_prefetch_folder            (ThunarStandardView       *standard_view,
+                                                                             ThunarFile               *file);
+static void                 thunar_standard_view_prefetch_neighbours        (ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_prefetch_idle              (gpointer                  user_data);
+static gboolean             thunar_standard_view_prefetch_hover_timer       (gpointer                  user_data);
+static void                 thunar_standard_view_load_folder                (ThunarStandardView       *standard_view,
+                                                                             ThunarFile               *directory);
+static void                 thunar_standard_view_suspended_clear            (ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_suspend_timer              (gpointer                  user_data);
+static void                 thunar_standard_view_release_folder             (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_search_cancel              (ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_hover_motion_notify_event  (GtkWidget                *view,
+                                                                             GdkEventMotion           *event,
+                                                                             ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_scrolled                   (GtkAdjustment            *adjustment,
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_size_allocate              (ThunarStandardView       *standard_view,
                                                                              GtkAllocation            *allocation);
+static gboolean             thunar_standard_view_trace_draw_begin           (ThunarStandardView       *standard_view,
+                                                                             cairo_t                  *cr);
+static gboolean             thunar_standard_view_trace_draw_end             (ThunarStandardView       *standard_view,
+                                                                             cairo_t                  *cr);
 static void                 thunar_standard_view_connect_accelerators       (ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_disconnect_accelerators    (ThunarStandardView       *standard_view);
 
@@ -278,6 +320,17 @@ static void                 thunar_standard_view_set_sort_column
 static void                 thunar_standard_view_toggle_sort_order                 (ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_store_sort_column                 (ThunarStandardView       *standard_view);
 
+typedef struct
+{
+  /* the drag offer the answer was determined for */
+  GdkDragAction context_actions;
+  GdkDragAction context_suggested_action;
+
+  /* the answer of thunar_file_accepts_drop() */
+  GdkDragAction actions;
+  GdkDragAction action;
+} StandardViewDropActions;
+
 struct _ThunarStandardViewPrivate
 {
   /* current directory of the view */
@@ -300,7 +353,9 @@ struct _ThunarStandardViewPrivate
   guint                   statusbar_text_idle_id;
 
   /* right-click drag/popup support */
-  GList                  *drag_g_file_list;
+  GList                  *drag_file_list;      /* the dragged ThunarFiles */
+  gchar                  *drag_uri_list;       /* their text/uri-list, built on demand */
+  gsize                   drag_uri_list_length;
   guint                   drag_scroll_timer_id;
   guint                   drag_timer_id;
   GdkEvent               *drag_timer_event;
@@ -312,6 +367,7 @@ struct _ThunarStandardViewPrivate
   guint                   drop_highlight : 1;
   guint                   drop_occurred : 1;   /* whether the data was dropped */
   GList                  *drop_file_list;      /* the list of URIs that are contained in the drop data */
+  GHashTable             *drop_actions;        /* the StandardViewDropActions for the hovered files */
 
   /* the "new-files" closure, which is used to select files whenever
    * new files are created by a ThunarJob associated with this view
@@ -333,16 +389,50 @@ struct _ThunarStandardViewPrivate
   gfloat                  scroll_to_row_align;
   gfloat                  scroll_to_col_align;
 
-  /* #GList of currently selected #ThunarFile<!---->s */
+  /* the selected rows, the #GList of selected #ThunarFile<!---->s is
+   * only built from them when requested */
+  GArray                 *selection_ranges;
   GList                  *selected_files;
+  guint                   selected_files_valid : 1;
+  guint                   selection_pending : 1;
+  gint                    selection_frozen;
   guint                   restore_selection_idle_id;
 
   /* support for generating thumbnails */
   ThunarThumbnailer      *thumbnailer;
   guint                   thumbnail_request;
+  guint                   thumbnail_prefetch_request;
   guint                   thumbnail_source_id;
   gboolean                thumbnailing_scheduled;
 
+  /* last scroll position, to prefetch thumbnails in the scroll direction */
+  gdouble                 thumbnail_hvalue;
+  gdouble                 thumbnail_vvalue;
+  gboolean                thumbnail_scroll_backward;
+
+  /* prefetching of the folders the user is likely to open next */
+  gboolean                prefetch_enabled;
+  GQueue                  prefetch_pending;    /* #ThunarFile<!---->s to prefetch, newest last */
+  GQueue                  prefetch_folders;    /* prefetched #ThunarFolder<!---->s, newest first */
+  guint                   prefetch_idle_id;
+  guint                   prefetch_hover_timer_id;
+  ThunarFile             *prefetch_hover_file;
+
+  /* suspension of views in background tabs, see thunar_standard_view_schedule_suspend() */
+  guint                   suspend_timer_id;
+  gboolean                suspended;
+  GList                  *suspended_selection;
+  ThunarFile             *suspended_scroll_file;
+  gboolean                load_deferred;
+
+  /* recursive search in the current directory, see thunar_standard_view_set_search_query() */
+  gchar                  *search_query;
+  ThunarJob              *search_job;
+  gchar                  *search_message;
+
+  /* start of the current draw, only used with THUNAR_TRACE */
+  gint64                  trace_draw_time;
+
   /* file insert signal */
   gulong                  row_changed_id;
 
@@ -653,12 +743,31 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
 {
   standard_view->priv = thunar_standard_view_get_instance_private (standard_view);
 
+  /* nothing is selected yet */
+  standard_view->priv->selection_ranges = thunar_selection_ranges_new ();
+  standard_view->priv->selected_files_valid = TRUE;
+
   /* allocate the scroll_to_files mapping (directory GFile -> first visible child GFile) */
   standard_view->priv->scroll_to_files = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, g_object_unref);
 
+  /* allocate the drop actions cache (ThunarFile -> StandardViewDropActions) */
+  standard_view->priv->drop_actions = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, thunar_standard_view_drop_actions_free);
+
   /* grab a reference on the preferences */
   standard_view->preferences = thunar_preferences_get ();
 
+  /* prefetch the folders the user may open next, if enabled */
+  g_signal_connect_swapped (G_OBJECT (standard_view->preferences), "notify::misc-prefetch-folders",
+                            G_CALLBACK (thunar_standard_view_prefetch_changed), standard_view);
+  thunar_standard_view_prefetch_changed (standard_view);
+
+  /* time the drawing of the view, if tracing */
+  if (THUNAR_TRACE_ENABLED ())
+    {
+      g_signal_connect (G_OBJECT (standard_view), "draw", G_CALLBACK (thunar_standard_view_trace_draw_begin), NULL);
+      g_signal_connect_after (G_OBJECT (standard_view), "draw", G_CALLBACK (thunar_standard_view_trace_draw_end), NULL);
+    }
+
   /* create a thumbnailer */
   standard_view->priv->thumbnailer = thunar_thumbnailer_get ();
   g_signal_connect (G_OBJECT (standard_view->priv->thumbnailer), "request-finished", G_CALLBACK (thunar_standard_view_finished_thumbnailing), standard_view);
@@ -692,10 +801,12 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   standard_view->icon_renderer = thunar_icon_renderer_new ();
   g_object_ref_sink (G_OBJECT (standard_view->icon_renderer));
   g_object_bind_property (G_OBJECT (standard_view), "zoom-level", G_OBJECT (standard_view->icon_renderer), "size", G_BINDING_SYNC_CREATE);
-  g_object_bind_property (G_OBJECT (standard_view->icon_renderer), "size", G_OBJECT (standard_view->priv->thumbnailer), "thumbnail-size", G_BINDING_SYNC_CREATE);
+  g_object_bind_property_full (G_OBJECT (standard_view->icon_renderer), "size", G_OBJECT (standard_view->priv->thumbnailer), "thumbnail-size", G_BINDING_SYNC_CREATE,
+                               thunar_standard_view_transform_thumbnail_size, NULL, standard_view, NULL);
+  g_signal_connect (G_OBJECT (standard_view), "notify::scale-factor", G_CALLBACK (thunar_standard_view_scale_factor_changed), NULL);
 
   /* setup the name renderer */
-  standard_view->name_renderer = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
+  standard_view->name_renderer = g_object_new (THUNAR_TYPE_TEXT_RENDERER,
 #if PANGO_VERSION_CHECK (1, 44, 0)
                                                "attributes", thunar_pango_attr_disable_hyphens (),
 #endif
@@ -718,6 +829,9 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   /* be sure to update the statusbar text whenever the file-size-binary property changes */
   g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::file-size-binary", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
 
+  /* the free space of the volume is looked up in the background */
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::free-space", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
+
   /* connect to size allocation signals for generating thumbnail requests */
   g_signal_connect_after (G_OBJECT (standard_view), "size-allocate",
                           G_CALLBACK (thunar_standard_view_size_allocate), NULL);
@@ -794,6 +908,10 @@ thunar_standard_view_constructor (GType                  type,
   /* need to catch certain keys for the internal view widget */
   g_signal_connect (G_OBJECT (view), "key-press-event", G_CALLBACK (thunar_standard_view_key_press_event), object);
 
+  /* watch which folder is hovered to prefetch it */
+  gtk_widget_add_events (view, GDK_POINTER_MOTION_MASK);
+  g_signal_connect (G_OBJECT (view), "motion-notify-event", G_CALLBACK (thunar_standard_view_hover_motion_notify_event), object);
+
   /* setup the real view as drop site */
   gtk_drag_dest_set (view, 0, drop_targets, G_N_ELEMENTS (drop_targets), GDK_ACTION_ASK | GDK_ACTION_COPY | GDK_ACTION_LINK | GDK_ACTION_MOVE);
   g_signal_connect (G_OBJECT (view), "drag-drop", G_CALLBACK (thunar_standard_view_drag_drop), object);
@@ -835,6 +953,24 @@ thunar_standard_view_dispose (GObject *object)
   /* cancel pending thumbnail sources and requests */
   thunar_standard_view_cancel_thumbnailing (standard_view);
 
+  /* release the prefetched folders */
+  thunar_standard_view_prefetch_cancel (standard_view);
+
+  /* forget a pending or active suspension */
+  if (standard_view->priv->suspend_timer_id != 0)
+    {
+      g_source_remove (standard_view->priv->suspend_timer_id);
+      standard_view->priv->suspend_timer_id = 0;
+    }
+  thunar_standard_view_suspended_clear (standard_view);
+
+  /* stop a running search */
+  thunar_standard_view_search_cancel (standard_view);
+  g_free (standard_view->priv->search_query);
+  standard_view->priv->search_query = NULL;
+  g_free (standard_view->priv->search_message);
+  standard_view->priv->search_message = NULL;
+
   /* unregister the "loading" binding */
   if (G_UNLIKELY (standard_view->loading_binding != NULL))
     {
@@ -893,12 +1029,15 @@ thunar_standard_view_finalize (GObject *object)
 
   /* release the selected_files list (if any) */
   thunar_g_list_free_full (standard_view->priv->selected_files);
+  g_array_unref (standard_view->priv->selection_ranges);
 
-  /* release the drag path list (just in case the drag-end wasn't fired before) */
-  thunar_g_list_free_full (standard_view->priv->drag_g_file_list);
+  /* release the drag file list (just in case the drag-end wasn't fired before) */
+  thunar_g_list_free_full (standard_view->priv->drag_file_list);
+  g_free (standard_view->priv->drag_uri_list);
 
   /* release the drop path list (just in case the drag-leave wasn't fired before) */
   thunar_g_list_free_full (standard_view->priv->drop_file_list);
+  g_hash_table_destroy (standard_view->priv->drop_actions);
 
   /* release the history */
   g_object_unref (standard_view->priv->history);
@@ -921,6 +1060,7 @@ thunar_standard_view_finalize (GObject *object)
   thunar_g_list_free_full (standard_view->priv->new_files_path_list);
 
   /* release our reference on the preferences */
+  g_signal_handlers_disconnect_by_func (G_OBJECT (standard_view->preferences), thunar_standard_view_prefetch_changed, standard_view);
   g_object_unref (G_OBJECT (standard_view->preferences));
 
   /* disconnect from the list model */
@@ -929,7 +1069,7 @@ thunar_standard_view_finalize (GObject *object)
 
   /* remove selection restore timeout */
   if (standard_view->priv->restore_selection_idle_id != 0)
-    g_source_remove (standard_view->priv->restore_selection_idle_id);
+    thunar_scheduler_remove (standard_view->priv->restore_selection_idle_id);
 
   /* free the statusbar text (if any) */
   if (standard_view->priv->statusbar_text_idle_id != 0)
@@ -1069,7 +1209,8 @@ thunar_standard_view_realize (GtkWidget *widget)
   /* determine the icon factory for the screen on which we are realized */
   icon_theme = gtk_icon_theme_get_for_screen (gtk_widget_get_screen (widget));
   standard_view->icon_factory = thunar_icon_factory_get_for_icon_theme (icon_theme);
-  g_object_bind_property (G_OBJECT (standard_view->icon_renderer), "size", G_OBJECT (standard_view->icon_factory), "thumbnail-size", G_BINDING_SYNC_CREATE);
+  g_object_bind_property_full (G_OBJECT (standard_view->icon_renderer), "size", G_OBJECT (standard_view->icon_factory), "thumbnail-size", G_BINDING_SYNC_CREATE,
+                               thunar_standard_view_transform_thumbnail_size, NULL, standard_view, NULL);
 
   /* we need to redraw whenever the "thumbnail_mode" property is toggled */
   g_signal_connect_swapped (standard_view->icon_factory,
@@ -1142,10 +1283,30 @@ thunar_standard_view_draw (GtkWidget      *widget,
 
 
 
+static GList*
+thunar_standard_view_get_selected_files_list (ThunarStandardView *standard_view)
+{
+  /* a selection change in progress takes effect now */
+  if (G_UNLIKELY (standard_view->priv->selection_pending && standard_view->priv->selection_frozen == 0))
+    thunar_standard_view_selection_changed (standard_view);
+
+  /* look up the files of the selected rows on first use */
+  if (!standard_view->priv->selected_files_valid)
+    {
+      standard_view->priv->selected_files = thunar_selection_ranges_get_files (standard_view->priv->selection_ranges,
+                                                                               GTK_TREE_MODEL (standard_view->model));
+      standard_view->priv->selected_files_valid = TRUE;
+    }
+
+  return standard_view->priv->selected_files;
+}
+
+
+
 static GList*
 thunar_standard_view_get_selected_files_component (ThunarComponent *component)
 {
-  return THUNAR_STANDARD_VIEW (component)->priv->selected_files;
+  return thunar_standard_view_get_selected_files_list (THUNAR_STANDARD_VIEW (component));
 }
 
 
@@ -1153,7 +1314,7 @@ thunar_standard_view_get_selected_files_component (ThunarComponent *component)
 static GList*
 thunar_standard_view_get_selected_files_view (ThunarView *view)
 {
-  return THUNAR_STANDARD_VIEW (view)->priv->selected_files;
+  return thunar_standard_view_get_selected_files_list (THUNAR_STANDARD_VIEW (view));
 }
 
 
@@ -1173,6 +1334,7 @@ thunar_standard_view_set_selected_files_component (ThunarComponent *component,
       thunar_g_list_free_full (standard_view->priv->selected_files);
       standard_view->priv->selected_files = NULL;
     }
+  standard_view->priv->selected_files_valid = TRUE;
 
   /* check if we're still loading */
   if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
@@ -1186,6 +1348,9 @@ thunar_standard_view_set_selected_files_component (ThunarComponent *component,
       if (G_UNLIKELY (standard_view->model == NULL))
         return;
 
+      /* every selected path emits a selection change, handle them once */
+      thunar_standard_view_freeze_selection (standard_view);
+
       /* unselect all previously selected files */
       (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->unselect_all) (standard_view);
 
@@ -1217,6 +1382,8 @@ thunar_standard_view_set_selected_files_component (ThunarComponent *component,
           /* release the tree paths */
           g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
         }
+
+      thunar_standard_view_thaw_selection (standard_view);
     }
 }
 
@@ -1319,12 +1486,44 @@ thunar_standard_view_restore_selection_from_history (ThunarStandardView *standar
 
 
 
+static void
+thunar_standard_view_load_folder (ThunarStandardView *standard_view,
+                                  ThunarFile         *directory)
+{
+  ThunarFolder *folder;
+
+  /* We drop the model from the view as a simple optimization to speed up
+   * the process of disconnecting the model data from the view.
+   */
+  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
+
+  /* open the directory as folder */
+  folder = thunar_folder_get_for_file (directory);
+
+  /* connect the "loading" binding */
+  standard_view->loading_binding =
+    g_object_bind_property_full (folder,        "loading",
+                                 standard_view, "loading",
+                                 G_BINDING_SYNC_CREATE,
+                                 NULL, NULL,
+                                 standard_view,
+                                 thunar_standard_view_loading_unbound);
+
+  /* apply the new folder */
+  thunar_list_model_set_folder (standard_view->model, folder);
+  g_object_unref (G_OBJECT (folder));
+
+  /* reconnect our model to the view */
+  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
+}
+
+
+
 static void
 thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
                                             ThunarFile      *current_directory)
 {
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (navigator);
-  ThunarFolder       *folder;
 
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
   _thunar_return_if_fail (current_directory == NULL || THUNAR_IS_FILE (current_directory));
@@ -1333,9 +1532,28 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   if (standard_view->priv->current_directory == current_directory)
     return;
 
+  /* a suspended view is reloaded anyway */
+  thunar_standard_view_suspended_clear (standard_view);
+
+  /* a search only covers the directory it was started in */
+  thunar_standard_view_search_cancel (standard_view);
+  g_free (standard_view->priv->search_query);
+  standard_view->priv->search_query = NULL;
+  g_free (standard_view->priv->search_message);
+  standard_view->priv->search_message = NULL;
+
   /* cancel any pending thumbnail sources and requests */
   thunar_standard_view_cancel_thumbnailing (standard_view);
 
+  /* forget the prefetch requests for the previous directory */
+  if (standard_view->priv->prefetch_idle_id != 0)
+    {
+      g_source_remove (standard_view->priv->prefetch_idle_id);
+      standard_view->priv->prefetch_idle_id = 0;
+    }
+  g_queue_foreach (&standard_view->priv->prefetch_pending, (GFunc) (void (*)(void)) g_object_unref, NULL);
+  g_queue_clear (&standard_view->priv->prefetch_pending);
+
   /* disconnect any previous "loading" binding */
   if (G_LIKELY (standard_view->loading_binding != NULL))
     {
@@ -1393,29 +1611,11 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   if (standard_view->priv->directory_specific_settings)
     thunar_standard_view_apply_directory_specific_settings (standard_view, current_directory);
 
-  /* We drop the model from the view as a simple optimization to speed up
-   * the process of disconnecting the model data from the view.
-   */
-  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
-
-  /* open the new directory as folder */
-  folder = thunar_folder_get_for_file (current_directory);
-
-  /* connect the "loading" binding */
-  standard_view->loading_binding =
-    g_object_bind_property_full (folder,        "loading",
-                                 standard_view, "loading",
-                                 G_BINDING_SYNC_CREATE,
-                                 NULL, NULL,
-                                 standard_view,
-                                 thunar_standard_view_loading_unbound);
-
-  /* apply the new folder */
-  thunar_list_model_set_folder (standard_view->model, folder);
-  g_object_unref (G_OBJECT (folder));
-
-  /* reconnect our model to the view */
-  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
+  /* open the new directory as folder, unless the view waits to be resumed */
+  if (G_UNLIKELY (standard_view->priv->load_deferred))
+    standard_view->priv->suspended = TRUE;
+  else
+    thunar_standard_view_load_folder (standard_view, current_directory);
 
   /* schedule a thumbnail timeout */
   /* NOTE: quickly after this we always trigger a size allocate wich will handle this */
@@ -1484,7 +1684,7 @@ thunar_standard_view_set_loading (ThunarStandardView *standard_view,
   if (!loading)
     {
       /* remember and reset the file list */
-      selected_files = standard_view->priv->selected_files;
+      selected_files = thunar_standard_view_get_selected_files_list (standard_view);
       standard_view->priv->selected_files = NULL;
 
       /* and try setting the selected files again */
@@ -1548,6 +1748,10 @@ thunar_standard_view_set_loading (ThunarStandardView *standard_view,
       standard_view->priv->thumbnailing_scheduled = FALSE;
     }
 
+  /* the folders of the history are likely to be opened next */
+  if (!loading)
+    thunar_standard_view_prefetch_neighbours (standard_view);
+
   /* notify listeners */
   g_object_freeze_notify (G_OBJECT (standard_view));
   g_object_notify_by_pspec (G_OBJECT (standard_view), standard_view_props[PROP_LOADING]);
@@ -1562,6 +1766,7 @@ thunar_standard_view_get_statusbar_text (ThunarView *view)
 {
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (view);
   GList              *items;
+  gchar              *text;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), NULL);
 
@@ -1579,6 +1784,14 @@ thunar_standard_view_get_statusbar_text (ThunarView *view)
 
       standard_view->priv->statusbar_text = thunar_list_model_get_statusbar_text (standard_view->model, items);
       g_list_free_full (items, (GDestroyNotify) gtk_tree_path_free);
+
+      /* tell that the search results may be incomplete */
+      if (standard_view->priv->search_message != NULL)
+        {
+          text = g_strdup_printf ("%s (%s)", standard_view->priv->statusbar_text, standard_view->priv->search_message);
+          g_free (standard_view->priv->statusbar_text);
+          standard_view->priv->statusbar_text = text;
+        }
     }
 
   return standard_view->priv->statusbar_text;
@@ -1617,11 +1830,13 @@ thunar_standard_view_set_zoom_level (ThunarView     *view,
 {
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (view);
   gboolean newThumbnailSize = FALSE;
+  gint     scale_factor = gtk_widget_get_scale_factor (GTK_WIDGET (view));
 
   /* check if we have a new zoom-level here */
   if (G_LIKELY (standard_view->priv->zoom_level != zoom_level))
     {
-      if (thunar_zoom_level_to_thumbnail_size (zoom_level) != thunar_zoom_level_to_thumbnail_size (standard_view->priv->zoom_level))
+      if (thunar_zoom_level_to_thumbnail_size (zoom_level, scale_factor)
+          != thunar_zoom_level_to_thumbnail_size (standard_view->priv->zoom_level, scale_factor))
         newThumbnailSize = TRUE;
 
       standard_view->priv->zoom_level = zoom_level;
@@ -1654,6 +1869,39 @@ thunar_standard_view_reset_zoom_level (ThunarView *view)
 
 
 
+static gboolean
+thunar_standard_view_transform_thumbnail_size (GBinding     *binding,
+                                               const GValue *src_value,
+                                               GValue       *dst_value,
+                                               gpointer      user_data)
+{
+  /* the thumbnails are picked by the pixel size of the icons */
+  g_value_set_enum (dst_value, thunar_icon_size_to_thumbnail_size (g_value_get_enum (src_value),
+                                                                   gtk_widget_get_scale_factor (GTK_WIDGET (user_data))));
+  return TRUE;
+}
+
+
+
+static void
+thunar_standard_view_scale_factor_changed (ThunarStandardView *standard_view)
+{
+  ThunarThumbnailSize thumbnail_size;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  g_object_get (G_OBJECT (standard_view->priv->thumbnailer), "thumbnail-size", &thumbnail_size, NULL);
+  if (thumbnail_size != thunar_zoom_level_to_thumbnail_size (standard_view->priv->zoom_level,
+                                                             gtk_widget_get_scale_factor (GTK_WIDGET (standard_view))))
+    {
+      /* update the bindings and load the thumbnails of the new flavor */
+      g_object_notify (G_OBJECT (standard_view->icon_renderer), "size");
+      thunar_standard_view_reload (THUNAR_VIEW (standard_view), TRUE);
+    }
+}
+
+
+
 static void
 thunar_standard_view_apply_directory_specific_settings (ThunarStandardView *standard_view,
                                                         ThunarFile         *directory)
@@ -1748,10 +1996,13 @@ thunar_standard_view_reload (ThunarView *view,
     {
       file = thunar_folder_get_corresponding_file (folder);
 
-      if (thunar_file_exists (file))
-          thunar_folder_reload (folder, reload_info);
-      else
+      /* only a full reload reads an unchanged folder again */
+      if (!thunar_file_exists (file))
           thunar_standard_view_current_directory_destroy (file, standard_view);
+      else if (reload_info)
+          thunar_folder_reload (folder, TRUE);
+      else
+          thunar_folder_refresh (folder);
     }
 
   /* if directory specific settings are enabled, apply them. the reload might have been triggered */
@@ -1884,7 +2135,7 @@ thunar_standard_view_get_dest_actions (ThunarStandardView *standard_view,
   if (G_LIKELY (file != NULL))
     {
       /* determine the possible drop actions for the file (and the suggested action if any) */
-      actions = thunar_file_accepts_drop (file, standard_view->priv->drop_file_list, context, &action);
+      actions = thunar_standard_view_accepts_drop (standard_view, file, context, &action);
       if (G_LIKELY (actions != 0))
         {
           /* tell the caller about the file (if it's interested) */
@@ -1929,6 +2180,50 @@ thunar_standard_view_get_dest_actions (ThunarStandardView *standard_view,
 
 
 
+static void
+thunar_standard_view_drop_actions_free (gpointer data)
+{
+  g_slice_free (StandardViewDropActions, data);
+}
+
+
+
+static GdkDragAction
+thunar_standard_view_accepts_drop (ThunarStandardView *standard_view,
+                                   ThunarFile         *file,
+                                   GdkDragContext     *context,
+                                   GdkDragAction      *action_return)
+{
+  StandardViewDropActions *drop_actions;
+
+  /* checking the dropped files is expensive for large drags, so the
+   * answer for each hovered file is kept until the drag leaves the
+   * view, unless the source offers other actions (e.g. a modifier
+   * key was pressed) */
+  drop_actions = g_hash_table_lookup (standard_view->priv->drop_actions, file);
+  if (drop_actions == NULL)
+    {
+      drop_actions = g_slice_new0 (StandardViewDropActions);
+      g_hash_table_insert (standard_view->priv->drop_actions, g_object_ref (G_OBJECT (file)), drop_actions);
+    }
+  else if (drop_actions->context_actions == gdk_drag_context_get_actions (context)
+           && drop_actions->context_suggested_action == gdk_drag_context_get_suggested_action (context))
+    {
+      *action_return = drop_actions->action;
+      return drop_actions->actions;
+    }
+
+  drop_actions->context_actions = gdk_drag_context_get_actions (context);
+  drop_actions->context_suggested_action = gdk_drag_context_get_suggested_action (context);
+  drop_actions->action = 0;
+  drop_actions->actions = thunar_file_accepts_drop (file, standard_view->priv->drop_file_list, context, &drop_actions->action);
+
+  *action_return = drop_actions->action;
+  return drop_actions->actions;
+}
+
+
+
 static ThunarFile*
 thunar_standard_view_get_drop_file (ThunarStandardView *standard_view,
                                     gint                x,
@@ -2233,6 +2528,7 @@ thunar_standard_view_select_by_pattern (ThunarView *view)
 
       /* select all files that match pattern */
       paths = thunar_list_model_get_paths_for_pattern (standard_view->model, pattern, case_sensitive);
+      thunar_standard_view_freeze_selection (standard_view);
       THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->unselect_all (standard_view);
 
       /* set the cursor and scroll to the first selected item */
@@ -2244,6 +2540,7 @@ thunar_standard_view_select_by_pattern (ThunarView *view)
           THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->select_path (standard_view, lp->data);
           gtk_tree_path_free (lp->data);
         }
+      thunar_standard_view_thaw_selection (standard_view);
       g_list_free (paths);
       g_free (pattern_extended);
     }
@@ -2701,7 +2998,7 @@ thunar_standard_view_drag_data_received (GtkWidget          *view,
                     {
                       /* reload the folder corresponding to the file */
                       folder = thunar_folder_get_for_file (file);
-                      thunar_folder_reload (folder, FALSE);
+                      thunar_folder_refresh (folder);
                       g_object_unref (G_OBJECT (folder));
                     }
 
@@ -2860,6 +3157,7 @@ thunar_standard_view_drag_leave (GtkWidget          *widget,
       thunar_g_list_free_full (standard_view->priv->drop_file_list);
       standard_view->priv->drop_file_list = NULL;
       standard_view->priv->drop_data_ready = FALSE;
+      g_hash_table_remove_all (standard_view->priv->drop_actions);
     }
 
   /* disable the highlighting of the items in the view */
@@ -2961,30 +3259,24 @@ thunar_standard_view_drag_begin (GtkWidget          *view,
                                  GdkDragContext     *context,
                                  ThunarStandardView *standard_view)
 {
-  ThunarFile *file;
-  GdkPixbuf  *icon;
-  gint        size;
+  GdkPixbuf *icon;
+  gint       size;
 
-  /* release the drag path list (just in case the drag-end wasn't fired before) */
-  thunar_g_list_free_full (standard_view->priv->drag_g_file_list);
+  /* release the drag file list (just in case the drag-end wasn't fired before) */
+  thunar_g_list_free_full (standard_view->priv->drag_file_list);
+  g_free (standard_view->priv->drag_uri_list);
+  standard_view->priv->drag_uri_list = NULL;
 
-  /* query the list of selected URIs */
-  standard_view->priv->drag_g_file_list = thunar_file_list_to_thunar_g_file_list (standard_view->priv->selected_files);
-  if (G_LIKELY (standard_view->priv->drag_g_file_list != NULL))
+  /* remember the selected files, their URIs are only generated once requested */
+  standard_view->priv->drag_file_list = thunar_g_list_copy_deep (thunar_standard_view_get_selected_files_list (standard_view));
+  if (G_LIKELY (standard_view->priv->drag_file_list != NULL))
     {
-      /* determine the first selected file */
-      file = thunar_file_get (standard_view->priv->drag_g_file_list->data, NULL);
-      if (G_LIKELY (file != NULL))
-        {
-          /* generate an icon based on that file */
-          g_object_get (G_OBJECT (standard_view->icon_renderer), "size", &size, NULL);
-          icon = thunar_icon_factory_load_file_icon (standard_view->icon_factory, file, THUNAR_FILE_ICON_STATE_DEFAULT, size);
-          gtk_drag_set_icon_pixbuf (context, icon, 0, 0);
-          g_object_unref (G_OBJECT (icon));
-
-          /* release the file */
-          g_object_unref (G_OBJECT (file));
-        }
+      /* generate an icon based on the first selected file */
+      g_object_get (G_OBJECT (standard_view->icon_renderer), "size", &size, NULL);
+      icon = thunar_icon_factory_load_file_icon (standard_view->icon_factory, standard_view->priv->drag_file_list->data,
+                                                 THUNAR_FILE_ICON_STATE_DEFAULT, size);
+      gtk_drag_set_icon_pixbuf (context, icon, 0, 0);
+      g_object_unref (G_OBJECT (icon));
     }
 }
 
@@ -2998,14 +3290,17 @@ thunar_standard_view_drag_data_get (GtkWidget          *view,
                                     guint               timestamp,
                                     ThunarStandardView *standard_view)
 {
-  gchar **uris;
-
-  /* set the URI list for the drag selection */
-  if (standard_view->priv->drag_g_file_list != NULL)
+  /* set the URI list for the drag selection, every view the drag passes
+   * asks for it, so it is generated once for the whole drag */
+  if (standard_view->priv->drag_file_list != NULL)
     {
-      uris = thunar_g_file_list_to_stringv (standard_view->priv->drag_g_file_list);
-      gtk_selection_data_set_uris (selection_data, uris);
-      g_strfreev (uris);
+      if (standard_view->priv->drag_uri_list == NULL)
+        standard_view->priv->drag_uri_list = thunar_file_list_to_uri_list (standard_view->priv->drag_file_list,
+                                                                            &standard_view->priv->drag_uri_list_length);
+
+      gtk_selection_data_set (selection_data, gtk_selection_data_get_target (selection_data), 8,
+                              (const guchar *) standard_view->priv->drag_uri_list,
+                              standard_view->priv->drag_uri_list_length);
     }
 }
 
@@ -3031,9 +3326,11 @@ thunar_standard_view_drag_end (GtkWidget          *view,
   if (G_UNLIKELY (standard_view->priv->drag_scroll_timer_id != 0))
     g_source_remove (standard_view->priv->drag_scroll_timer_id);
 
-  /* release the list of dragged URIs */
-  thunar_g_list_free_full (standard_view->priv->drag_g_file_list);
-  standard_view->priv->drag_g_file_list = NULL;
+  /* release the list of dragged files */
+  thunar_g_list_free_full (standard_view->priv->drag_file_list);
+  standard_view->priv->drag_file_list = NULL;
+  g_free (standard_view->priv->drag_uri_list);
+  standard_view->priv->drag_uri_list = NULL;
 }
 
 
@@ -3087,7 +3384,7 @@ thunar_standard_view_rows_reordered (ThunarListModel    *model,
    * after letting row changes accumulate a bit */
   if (standard_view->priv->restore_selection_idle_id == 0)
     standard_view->priv->restore_selection_idle_id =
-      g_timeout_add (50, thunar_standard_view_restore_selection_idle, standard_view);
+      thunar_scheduler_add_timeout (G_PRIORITY_DEFAULT, 50, thunar_standard_view_restore_selection_idle, standard_view, NULL);
 }
 
 
@@ -3349,6 +3646,8 @@ thunar_standard_view_finished_thumbnailing (ThunarThumbnailer  *thumbnailer,
 
   if (standard_view->priv->thumbnail_request == request)
     standard_view->priv->thumbnail_request = 0;
+  else if (standard_view->priv->thumbnail_prefetch_request == request)
+    standard_view->priv->thumbnail_prefetch_request = 0;
 }
 
 
@@ -3372,7 +3671,7 @@ thunar_standard_view_cancel_thumbnailing (ThunarStandardView *standard_view)
 
   /* check if we have a pending thumbnail timeout/idle handler */
   if (standard_view->priv->thumbnail_source_id > 0)
-    g_source_remove (standard_view->priv->thumbnail_source_id);
+    thunar_scheduler_remove (standard_view->priv->thumbnail_source_id);
 
   /* check if we have a pending thumbnail request */
   if (standard_view->priv->thumbnail_request > 0)
@@ -3382,6 +3681,14 @@ thunar_standard_view_cancel_thumbnailing (ThunarStandardView *standard_view)
                                   standard_view->priv->thumbnail_request);
       standard_view->priv->thumbnail_request = 0;
     }
+
+  /* files that are not close to the visible range anymore */
+  if (standard_view->priv->thumbnail_prefetch_request > 0)
+    {
+      thunar_thumbnailer_dequeue (standard_view->priv->thumbnailer,
+                                  standard_view->priv->thumbnail_prefetch_request);
+      standard_view->priv->thumbnail_prefetch_request = 0;
+    }
 }
 
 
@@ -3407,8 +3714,8 @@ thunar_standard_view_schedule_thumbnail_timeout (ThunarStandardView *standard_vi
   /* schedule the timeout handler */
   g_assert (standard_view->priv->thumbnail_source_id == 0);
   standard_view->priv->thumbnail_source_id =
-    g_timeout_add_full (G_PRIORITY_DEFAULT, 175, thunar_standard_view_request_thumbnails_lazy,
-                        standard_view, thunar_standard_view_thumbnailing_destroyed);
+    thunar_scheduler_add_timeout (G_PRIORITY_DEFAULT, 175, thunar_standard_view_request_thumbnails_lazy,
+                                  standard_view, thunar_standard_view_thumbnailing_destroyed);
 }
 
 
@@ -3434,168 +3741,496 @@ thunar_standard_view_schedule_thumbnail_idle (ThunarStandardView *standard_view)
   /* schedule the timeout or idle handler */
   g_assert (standard_view->priv->thumbnail_source_id == 0);
   standard_view->priv->thumbnail_source_id =
-    g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, thunar_standard_view_request_thumbnails,
-                     standard_view, thunar_standard_view_thumbnailing_destroyed);
+    thunar_scheduler_add_idle (G_PRIORITY_DEFAULT_IDLE, thunar_standard_view_request_thumbnails,
+                               standard_view, thunar_standard_view_thumbnailing_destroyed);
 }
 
 
 
-static gboolean
-thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
-                                              gboolean            lazy_request)
+static GList *
+thunar_standard_view_get_files_in_range (ThunarStandardView *standard_view,
+                                         gint                first,
+                                         gint                last,
+                                         gboolean            backward)
 {
-  GtkTreePath *start_path;
-  GtkTreePath *end_path;
-  GtkTreePath *path;
-  GtkTreeIter  iter;
-  ThunarFile  *file;
-  gboolean     valid_iter;
-  GList       *visible_files = NULL;
-
-  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
-  _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (standard_view->icon_factory), FALSE);
-
-  /* do nothing if we are not supposed to show thumbnails at all */
-  if (!thunar_icon_factory_get_show_thumbnail (standard_view->icon_factory,
-                                               standard_view->priv->current_directory))
-    return FALSE;
-
-  /* reschedule the source if we're still loading the folder */
-  if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
-    return TRUE;
+  GtkTreeIter iter;
+  GList      *files = NULL;
+  gint        n;
 
-  /* compute visible item range */
-  if ((*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_visible_range) (standard_view,
-                                                                            &start_path,
-                                                                            &end_path))
+  /* build the list so the files closest to the visible range come first */
+  for (n = first; n <= last; ++n)
     {
-      /* iterate over the range to collect all files */
-      valid_iter = gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model),
-                                            &iter, start_path);
-
-      while (valid_iter)
-        {
-          /* prepend the file to the visible items list */
-          file = thunar_list_model_get_file (standard_view->model, &iter);
-          visible_files = g_list_prepend (visible_files, file);
-
-          /* check if we've reached the end of the visible range */
-          path = gtk_tree_model_get_path (GTK_TREE_MODEL (standard_view->model), &iter);
-          if (gtk_tree_path_compare (path, end_path) != 0)
-            {
-              /* try to compute the next visible item */
-              valid_iter =
-                gtk_tree_model_iter_next (GTK_TREE_MODEL (standard_view->model), &iter);
-            }
-          else
-            {
-              /* we have reached the end, terminate the loop */
-              valid_iter = FALSE;
-            }
-
-          /* release the tree path */
-          gtk_tree_path_free (path);
-        }
-
-      /* queue a thumbnail request */
-      thunar_thumbnailer_queue_files (standard_view->priv->thumbnailer,
-                                      lazy_request, visible_files,
-                                      &standard_view->priv->thumbnail_request);
-
-      /* release the file list */
-      g_list_free_full (visible_files, g_object_unref);
-
-      /* release the start and end path */
-      gtk_tree_path_free (start_path);
-      gtk_tree_path_free (end_path);
+      if (!gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (standard_view->model), &iter, NULL, n))
+        break;
+      files = g_list_prepend (files, thunar_list_model_get_file (standard_view->model, &iter));
     }
 
-  return FALSE;
+  return backward ? files : g_list_reverse (files);
 }
 
 
 
-static gboolean
-thunar_standard_view_request_thumbnails (gpointer data)
+static void
+thunar_standard_view_prefetch_changed (ThunarStandardView *standard_view)
 {
-  return thunar_standard_view_request_thumbnails_real (data, FALSE);
-}
+  gboolean enabled;
 
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
+  g_object_get (G_OBJECT (standard_view->preferences), "misc-prefetch-folders", &enabled, NULL);
+  standard_view->priv->prefetch_enabled = enabled;
 
-static gboolean
-thunar_standard_view_request_thumbnails_lazy (gpointer data)
-{
-  return thunar_standard_view_request_thumbnails_real (data, TRUE);
+  if (!enabled)
+    thunar_standard_view_prefetch_cancel (standard_view);
+  else if (standard_view->priv->current_directory != NULL && !standard_view->loading)
+    thunar_standard_view_prefetch_neighbours (standard_view);
 }
 
 
 
 static void
-thunar_standard_view_thumbnail_mode_toggled (ThunarStandardView *standard_view,
-                                             GParamSpec         *pspec,
-                                             ThunarIconFactory  *icon_factory)
+thunar_standard_view_prefetch_cancel (ThunarStandardView *standard_view)
 {
-  GtkAdjustment *vadjustment;
-
-  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
-  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (icon_factory));
-  _thunar_return_if_fail (standard_view->icon_factory == icon_factory);
-
-  /* check whether the user wants us to generate thumbnails */
-  if (thunar_icon_factory_get_show_thumbnail (icon_factory,
-                                              standard_view->priv->current_directory))
+  if (standard_view->priv->prefetch_idle_id != 0)
     {
-      /* get the vertical adjustment of the view */
-      vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view));
+      g_source_remove (standard_view->priv->prefetch_idle_id);
+      standard_view->priv->prefetch_idle_id = 0;
+    }
 
-      /* fake a scroll event to generate thumbnail requests */
-      thunar_standard_view_scrolled (vadjustment, standard_view);
+  if (standard_view->priv->prefetch_hover_timer_id != 0)
+    {
+      g_source_remove (standard_view->priv->prefetch_hover_timer_id);
+      standard_view->priv->prefetch_hover_timer_id = 0;
     }
-  else
+
+  if (standard_view->priv->prefetch_hover_file != NULL)
     {
-      /* cancel any pending thumbnail requests */
-      thunar_standard_view_cancel_thumbnailing (standard_view);
+      g_object_unref (standard_view->priv->prefetch_hover_file);
+      standard_view->priv->prefetch_hover_file = NULL;
     }
+
+  g_queue_foreach (&standard_view->priv->prefetch_pending, (GFunc) (void (*)(void)) g_object_unref, NULL);
+  g_queue_clear (&standard_view->priv->prefetch_pending);
+
+  g_queue_foreach (&standard_view->priv->prefetch_folders, (GFunc) (void (*)(void)) g_object_unref, NULL);
+  g_queue_clear (&standard_view->priv->prefetch_folders);
 }
 
 
 
 static void
-thunar_standard_view_scrolled (GtkAdjustment      *adjustment,
-                               ThunarStandardView *standard_view)
+thunar_standard_view_prefetch_folder (ThunarStandardView *standard_view,
+                                      ThunarFile         *file)
 {
-  _thunar_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+  GList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (file == NULL || THUNAR_IS_FILE (file));
 
-  /* ignore adjustment changes when the view is still loading */
-  if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
+  if (!standard_view->priv->prefetch_enabled
+      || file == NULL
+      || file == standard_view->priv->current_directory
+      || !thunar_file_is_directory (file))
     return;
 
-  /* reschedule a thumbnail request timeout */
-  thunar_standard_view_schedule_thumbnail_timeout (standard_view);
+  /* check if the folder is already known */
+  if (g_queue_find (&standard_view->priv->prefetch_pending, file) != NULL)
+    return;
+  for (lp = standard_view->priv->prefetch_folders.head; lp != NULL; lp = lp->next)
+    if (thunar_folder_get_corresponding_file (lp->data) == file)
+      return;
+
+  /* newer requests are more relevant, drop the oldest ones */
+  g_queue_push_tail (&standard_view->priv->prefetch_pending, g_object_ref (file));
+  while (standard_view->priv->prefetch_pending.length > THUNAR_STANDARD_VIEW_PREFETCH_MAX)
+    g_object_unref (g_queue_pop_head (&standard_view->priv->prefetch_pending));
+
+  /* load the folders when nothing else is to be done */
+  if (standard_view->priv->prefetch_idle_id == 0)
+    {
+      standard_view->priv->prefetch_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_standard_view_prefetch_idle,
+                                                               standard_view, NULL);
+    }
 }
 
 
 
 static void
-thunar_standard_view_size_allocate (ThunarStandardView *standard_view,
-                                    GtkAllocation      *allocation)
+thunar_standard_view_prefetch_neighbours (ThunarStandardView *standard_view)
 {
-  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  ThunarFile *file;
 
-  /* ignore size changes when the view is still loading */
-  if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
+  if (!standard_view->priv->prefetch_enabled
+      || standard_view->priv->current_directory == NULL)
     return;
 
-  /* to avoid a flow of updates, don't update if there is already a request pending */
-  if (standard_view->priv->thumbnail_source_id == 0)
+  /* queue the most likely target last, it is loaded first */
+  file = thunar_file_get_parent (standard_view->priv->current_directory, NULL);
+  if (file != NULL)
     {
-      /* reschedule a thumbnail request timeout */
-      thunar_standard_view_schedule_thumbnail_timeout (standard_view);
+      thunar_standard_view_prefetch_folder (standard_view, file);
+      g_object_unref (file);
     }
-}
-
+
+  file = thunar_history_peek_forward (standard_view->priv->history);
+  if (file != NULL)
+    {
+      thunar_standard_view_prefetch_folder (standard_view, file);
+      g_object_unref (file);
+    }
+
+  file = thunar_history_peek_back (standard_view->priv->history);
+  if (file != NULL)
+    {
+      thunar_standard_view_prefetch_folder (standard_view, file);
+      g_object_unref (file);
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_prefetch_idle (gpointer user_data)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (user_data);
+  ThunarFolder       *folder;
+  ThunarFile         *file;
+
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+
+  /* start loading one folder per iteration, the listing itself is asynchronous */
+  file = g_queue_pop_tail (&standard_view->priv->prefetch_pending);
+  if (G_LIKELY (file != NULL))
+    {
+      folder = thunar_folder_get_for_file (file);
+      if (G_LIKELY (folder != NULL))
+        {
+          g_queue_push_head (&standard_view->priv->prefetch_folders, folder);
+          while (standard_view->priv->prefetch_folders.length > THUNAR_STANDARD_VIEW_PREFETCH_MAX)
+            g_object_unref (g_queue_pop_tail (&standard_view->priv->prefetch_folders));
+        }
+      g_object_unref (file);
+    }
+
+  if (g_queue_is_empty (&standard_view->priv->prefetch_pending))
+    {
+      standard_view->priv->prefetch_idle_id = 0;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_standard_view_prefetch_hover_timer (gpointer user_data)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (user_data);
+
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+
+  standard_view->priv->prefetch_hover_timer_id = 0;
+  thunar_standard_view_prefetch_folder (standard_view, standard_view->priv->prefetch_hover_file);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_standard_view_hover_motion_notify_event (GtkWidget          *view,
+                                                GdkEventMotion     *event,
+                                                ThunarStandardView *standard_view)
+{
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+  ThunarFile  *file = NULL;
+  GdkWindow   *window;
+  gdouble      x = event->x;
+  gdouble      y = event->y;
+
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+
+  if (!standard_view->priv->prefetch_enabled)
+    return FALSE;
+
+  /* translate the coordinates from the (bin) window to the view */
+  for (window = event->window; window != NULL && window != gtk_widget_get_window (view); window = gdk_window_get_parent (window))
+    gdk_window_coords_to_parent (window, x, y, &x, &y);
+
+  path = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_path_at_pos) (standard_view, x, y);
+  if (path != NULL)
+    {
+      gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model), &iter, path);
+      file = thunar_list_model_get_file (standard_view->model, &iter);
+      gtk_tree_path_free (path);
+    }
+
+  /* restart the timer whenever another item is hovered */
+  if (file != standard_view->priv->prefetch_hover_file)
+    {
+      if (standard_view->priv->prefetch_hover_timer_id != 0)
+        {
+          g_source_remove (standard_view->priv->prefetch_hover_timer_id);
+          standard_view->priv->prefetch_hover_timer_id = 0;
+        }
+
+      if (standard_view->priv->prefetch_hover_file != NULL)
+        g_object_unref (standard_view->priv->prefetch_hover_file);
+      standard_view->priv->prefetch_hover_file = NULL;
+
+      if (file != NULL && thunar_file_is_directory (file))
+        {
+          standard_view->priv->prefetch_hover_file = g_object_ref (file);
+          standard_view->priv->prefetch_hover_timer_id = g_timeout_add_full (G_PRIORITY_LOW, THUNAR_STANDARD_VIEW_PREFETCH_HOVER_DELAY,
+                                                                             thunar_standard_view_prefetch_hover_timer,
+                                                                             standard_view, NULL);
+        }
+    }
+
+  if (file != NULL)
+    g_object_unref (file);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_standard_view_prioritize_files (ThunarStandardView *standard_view,
+                                       GList              *files)
+{
+  ThunarFolder *folder;
+
+  /* let the folder sniff the content types of these files first */
+  folder = thunar_list_model_get_folder (standard_view->model);
+  if (G_LIKELY (folder != NULL))
+    thunar_folder_prioritize_files (folder, files);
+}
+
+
+
+static void
+thunar_standard_view_prioritize_visible_files (ThunarStandardView *standard_view)
+{
+  GtkTreePath *start_path;
+  GtkTreePath *end_path;
+  GList       *visible_files;
+
+  if ((*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_visible_range) (standard_view,
+                                                                            &start_path,
+                                                                            &end_path))
+    {
+      visible_files = thunar_standard_view_get_files_in_range (standard_view,
+                                                               gtk_tree_path_get_indices (start_path)[0],
+                                                               gtk_tree_path_get_indices (end_path)[0],
+                                                               FALSE);
+      thunar_standard_view_prioritize_files (standard_view, visible_files);
+      g_list_free_full (visible_files, g_object_unref);
+
+      gtk_tree_path_free (start_path);
+      gtk_tree_path_free (end_path);
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
+                                              gboolean            lazy_request)
+{
+  GtkTreePath *start_path;
+  GtkTreePath *end_path;
+  GList       *visible_files;
+  GList       *prefetch_files;
+  gboolean     backward;
+  gint         n_rows;
+  gint         start;
+  gint         end;
+
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (standard_view->icon_factory), FALSE);
+
+  /* do nothing if we are not supposed to show thumbnails at all */
+  if (!thunar_icon_factory_get_show_thumbnail (standard_view->icon_factory,
+                                               standard_view->priv->current_directory))
+    {
+      /* but still determine the content types of the visible files first */
+      if (!thunar_view_get_loading (THUNAR_VIEW (standard_view)))
+        thunar_standard_view_prioritize_visible_files (standard_view);
+      return FALSE;
+    }
+
+  /* reschedule the source if we're still loading the folder */
+  if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
+    return TRUE;
+
+  /* compute visible item range */
+  if ((*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_visible_range) (standard_view,
+                                                                            &start_path,
+                                                                            &end_path))
+    {
+      /* the model is a flat list, so the paths are row numbers */
+      start = gtk_tree_path_get_indices (start_path)[0];
+      end = gtk_tree_path_get_indices (end_path)[0];
+      n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (standard_view->model), NULL);
+      backward = standard_view->priv->thumbnail_scroll_backward;
+
+      /* queue a thumbnail request for the visible files */
+      visible_files = thunar_standard_view_get_files_in_range (standard_view, start, end, FALSE);
+      if (visible_files != NULL)
+        {
+          thunar_standard_view_prioritize_files (standard_view, visible_files);
+          thunar_thumbnailer_queue_files (standard_view->priv->thumbnailer,
+                                          lazy_request, visible_files,
+                                          &standard_view->priv->thumbnail_request);
+        }
+
+      /* prefetch the next screen in the scroll direction with a lower priority */
+      if (backward)
+        prefetch_files = thunar_standard_view_get_files_in_range (standard_view, MAX (start - (end - start) - 1, 0), start - 1, TRUE);
+      else
+        prefetch_files = thunar_standard_view_get_files_in_range (standard_view, end + 1, MIN (end + (end - start) + 1, n_rows - 1), FALSE);
+      if (prefetch_files != NULL)
+        {
+          thunar_thumbnailer_prefetch_files (standard_view->priv->thumbnailer,
+                                             prefetch_files,
+                                             &standard_view->priv->thumbnail_prefetch_request);
+        }
+
+      /* release the file lists */
+      g_list_free_full (visible_files, g_object_unref);
+      g_list_free_full (prefetch_files, g_object_unref);
+
+      /* release the start and end path */
+      gtk_tree_path_free (start_path);
+      gtk_tree_path_free (end_path);
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_standard_view_request_thumbnails (gpointer data)
+{
+  return thunar_standard_view_request_thumbnails_real (data, FALSE);
+}
+
+
+
+static gboolean
+thunar_standard_view_request_thumbnails_lazy (gpointer data)
+{
+  return thunar_standard_view_request_thumbnails_real (data, TRUE);
+}
+
+
+
+static void
+thunar_standard_view_thumbnail_mode_toggled (ThunarStandardView *standard_view,
+                                             GParamSpec         *pspec,
+                                             ThunarIconFactory  *icon_factory)
+{
+  GtkAdjustment *vadjustment;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (icon_factory));
+  _thunar_return_if_fail (standard_view->icon_factory == icon_factory);
+
+  /* check whether the user wants us to generate thumbnails */
+  if (thunar_icon_factory_get_show_thumbnail (icon_factory,
+                                              standard_view->priv->current_directory))
+    {
+      /* get the vertical adjustment of the view */
+      vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view));
+
+      /* fake a scroll event to generate thumbnail requests */
+      thunar_standard_view_scrolled (vadjustment, standard_view);
+    }
+  else
+    {
+      /* cancel any pending thumbnail requests */
+      thunar_standard_view_cancel_thumbnailing (standard_view);
+    }
+}
+
+
+
+static void
+thunar_standard_view_scrolled (GtkAdjustment      *adjustment,
+                               ThunarStandardView *standard_view)
+{
+  gdouble value;
+
+  _thunar_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* ignore adjustment changes when the view is still loading */
+  if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
+    return;
+
+  /* remember the scroll direction for prefetching thumbnails */
+  value = gtk_adjustment_get_value (adjustment);
+  if (adjustment == gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view)))
+    {
+      if (value != standard_view->priv->thumbnail_vvalue)
+        standard_view->priv->thumbnail_scroll_backward = (value < standard_view->priv->thumbnail_vvalue);
+      standard_view->priv->thumbnail_vvalue = value;
+    }
+  else
+    {
+      if (value != standard_view->priv->thumbnail_hvalue)
+        standard_view->priv->thumbnail_scroll_backward = (value < standard_view->priv->thumbnail_hvalue);
+      standard_view->priv->thumbnail_hvalue = value;
+    }
+
+  /* reschedule a thumbnail request timeout */
+  thunar_standard_view_schedule_thumbnail_timeout (standard_view);
+}
+
+
+
+static void
+thunar_standard_view_size_allocate (ThunarStandardView *standard_view,
+                                    GtkAllocation      *allocation)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* ignore size changes when the view is still loading */
+  if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
+    return;
+
+  /* to avoid a flow of updates, don't update if there is already a request pending */
+  if (standard_view->priv->thumbnail_source_id == 0)
+    {
+      /* reschedule a thumbnail request timeout */
+      thunar_standard_view_schedule_thumbnail_timeout (standard_view);
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_trace_draw_begin (ThunarStandardView *standard_view,
+                                       cairo_t            *cr)
+{
+  standard_view->priv->trace_draw_time = thunar_trace_begin ();
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_standard_view_trace_draw_end (ThunarStandardView *standard_view,
+                                     cairo_t            *cr)
+{
+  thunar_trace_end (standard_view->priv->trace_draw_time, "view", "draw", G_OBJECT_TYPE_NAME (standard_view));
+  return FALSE;
+}
+
 
 
 /**
@@ -3635,6 +4270,7 @@ thunar_standard_view_context_menu (ThunarStandardView *standard_view)
                                             | THUNAR_MENU_SECTION_RESTORE
                                             | THUNAR_MENU_SECTION_RENAME
                                             | THUNAR_MENU_SECTION_CUSTOM_ACTIONS
+                                            | THUNAR_MENU_SECTION_THUMBNAILS
                                             | THUNAR_MENU_SECTION_PROPERTIES);
     }
   else /* right click on some empty space */
@@ -3645,7 +4281,8 @@ thunar_standard_view_context_menu (ThunarStandardView *standard_view)
                                             | THUNAR_MENU_SECTION_CUSTOM_ACTIONS);
       thunar_standard_view_append_menu_items (standard_view, GTK_MENU (context_menu), NULL);
       xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (context_menu));
-      thunar_menu_add_sections (context_menu, THUNAR_MENU_SECTION_ZOOM
+      thunar_menu_add_sections (context_menu, THUNAR_MENU_SECTION_THUMBNAILS
+                                            | THUNAR_MENU_SECTION_ZOOM
                                             | THUNAR_MENU_SECTION_PROPERTIES);
     }
   thunar_menu_hide_accel_labels (context_menu);
@@ -3739,11 +4376,19 @@ thunar_standard_view_queue_popup (ThunarStandardView *standard_view,
 void
 thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
 {
-  GtkTreeIter iter;
-  GList      *lp, *selected_thunar_files;
+  GList *paths;
+  GList *lp;
 
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
+  /* handled once the selection is thawed */
+  if (G_UNLIKELY (standard_view->priv->selection_frozen > 0))
+    {
+      standard_view->priv->selection_pending = TRUE;
+      return;
+    }
+  standard_view->priv->selection_pending = FALSE;
+
   /* drop any existing "new-files" closure */
   if (G_UNLIKELY (standard_view->priv->new_files_closure != NULL))
     {
@@ -3752,25 +4397,30 @@ thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
       standard_view->priv->new_files_closure = NULL;
     }
 
-  /* release the previously selected files */
+  /* release the previously selected files, the new list is built on demand */
   thunar_g_list_free_full (standard_view->priv->selected_files);
+  standard_view->priv->selected_files = NULL;
+  standard_view->priv->selected_files_valid = FALSE;
 
-  /* determine the new list of selected files (replacing GtkTreePath's with ThunarFile's) */
-  selected_thunar_files = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_items) (standard_view);
-  for (lp = selected_thunar_files; lp != NULL; lp = lp->next)
+  /* determine the selected rows */
+  g_array_unref (standard_view->priv->selection_ranges);
+  if (THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_ranges != NULL)
     {
-      /* determine the iterator for the path */
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model), &iter, lp->data);
-
-      /* release the tree path... */
-      gtk_tree_path_free (lp->data);
-
-      /* ...and replace it with the file */
-      lp->data = thunar_list_model_get_file (standard_view->model, &iter);
+      standard_view->priv->selection_ranges = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_ranges) (standard_view);
+    }
+  else
+    {
+      standard_view->priv->selection_ranges = thunar_selection_ranges_new ();
+      paths = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_items) (standard_view);
+      for (lp = paths; lp != NULL; lp = lp->next)
+        thunar_selection_ranges_add_path (standard_view->priv->selection_ranges, lp->data);
+      thunar_selection_ranges_normalize (standard_view->priv->selection_ranges);
+      g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
     }
 
-  /* and setup the new selected files list */
-  standard_view->priv->selected_files = selected_thunar_files;
+  /* a single selected folder is likely to be opened next */
+  if (thunar_selection_ranges_count (standard_view->priv->selection_ranges) == 1)
+    thunar_standard_view_prefetch_folder (standard_view, thunar_standard_view_get_selected_files_list (standard_view)->data);
 
   /* update the statusbar text */
   thunar_standard_view_update_statusbar_text (standard_view);
@@ -3781,6 +4431,43 @@ thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
 
 
 
+/**
+ * thunar_standard_view_freeze_selection:
+ * @standard_view : a #ThunarStandardView instance.
+ *
+ * Defers the handling of selection changes until the matching
+ * thunar_standard_view_thaw_selection(), so selecting many rows one by
+ * one updates the selected files only once.
+ **/
+void
+thunar_standard_view_freeze_selection (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  standard_view->priv->selection_frozen++;
+}
+
+
+
+/**
+ * thunar_standard_view_thaw_selection:
+ * @standard_view : a #ThunarStandardView instance.
+ *
+ * Reverts the effect of thunar_standard_view_freeze_selection(), and
+ * handles the selection changes that happened in the meantime.
+ **/
+void
+thunar_standard_view_thaw_selection (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (standard_view->priv->selection_frozen > 0);
+
+  if (--standard_view->priv->selection_frozen == 0 && standard_view->priv->selection_pending)
+    thunar_standard_view_selection_changed (standard_view);
+}
+
+
+
 /**
  * thunar_standard_view_set_history:
  * @standard_view : a #ThunarStandardView instance.
@@ -3912,7 +4599,7 @@ thunar_standard_view_append_menu_item (ThunarStandardView      *standard_view,
   item = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (action), G_OBJECT (standard_view), GTK_MENU_SHELL (menu));
 
   if (action == THUNAR_STANDARD_VIEW_ACTION_UNSELECT_ALL_FILES)
-    gtk_widget_set_sensitive (item, standard_view->priv->selected_files != NULL);
+    gtk_widget_set_sensitive (item, standard_view->priv->selection_ranges->len > 0);
 
   return item;
 }
@@ -4023,3 +4710,418 @@ _thunar_standard_view_open_on_middle_click (ThunarStandardView *standard_view,
       g_object_unref (G_OBJECT (file));
     }
 }
+
+
+
+static void
+thunar_standard_view_suspended_clear (ThunarStandardView *standard_view)
+{
+  standard_view->priv->suspended = FALSE;
+
+  thunar_g_list_free_full (standard_view->priv->suspended_selection);
+  standard_view->priv->suspended_selection = NULL;
+
+  if (standard_view->priv->suspended_scroll_file != NULL)
+    {
+      g_object_unref (standard_view->priv->suspended_scroll_file);
+      standard_view->priv->suspended_scroll_file = NULL;
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_suspend_timer (gpointer user_data)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (user_data);
+  ThunarFile         *first_file;
+
+  standard_view->priv->suspend_timer_id = 0;
+
+  /* a folder that is still loading is shown again soon anyway, and the
+   * results of a search cannot be loaded again */
+  if (standard_view->priv->current_directory == NULL
+      || standard_view->loading
+      || standard_view->priv->search_query != NULL)
+    return FALSE;
+
+  /* remember what the user saw, the folder is loaded again on resume */
+  if (standard_view->priv->suspended_scroll_file == NULL
+      && thunar_view_get_visible_range (THUNAR_VIEW (standard_view), &first_file, NULL))
+    standard_view->priv->suspended_scroll_file = first_file;
+  standard_view->priv->suspended_selection = thunar_g_list_copy_deep (thunar_standard_view_get_selected_files_list (standard_view));
+  standard_view->priv->suspended = TRUE;
+
+  thunar_standard_view_release_folder (standard_view);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_standard_view_release_folder (ThunarStandardView *standard_view)
+{
+  GtkWidget *view = gtk_bin_get_child (GTK_BIN (standard_view));
+
+  /* cancel pending thumbnail sources and requests */
+  thunar_standard_view_cancel_thumbnailing (standard_view);
+
+  /* release the prefetched folders */
+  thunar_standard_view_prefetch_cancel (standard_view);
+
+  if (G_LIKELY (standard_view->loading_binding != NULL))
+    {
+      g_object_unref (standard_view->loading_binding);
+      standard_view->loading_binding = NULL;
+    }
+
+  /* release the folder with its files and monitor, the model is
+   * disconnected for the same reason as in set_current_directory */
+  g_object_set (G_OBJECT (view), "model", NULL, NULL);
+  thunar_list_model_set_folder (standard_view->model, NULL);
+  g_object_set (G_OBJECT (view), "model", standard_view->model, NULL);
+}
+
+
+
+/**
+ * thunar_standard_view_schedule_suspend:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Schedules the suspension of @standard_view, whose tab is about to be
+ * moved to the background. Once the tab stayed in the background for the
+ * time set in #ThunarPreferences:misc-tab-suspend-timeout, the folder of
+ * the view is released, keeping only its location, scroll position and
+ * selection.
+ *
+ * The view is loaded again by thunar_standard_view_resume().
+ **/
+void
+thunar_standard_view_schedule_suspend (ThunarStandardView *standard_view)
+{
+  ThunarFile *first_file;
+  guint       timeout;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (standard_view->priv->suspend_timer_id != 0 || standard_view->priv->suspended)
+    return;
+
+  /* the visible range is only known while the tab is still shown */
+  if (standard_view->priv->suspended_scroll_file != NULL)
+    {
+      g_object_unref (standard_view->priv->suspended_scroll_file);
+      standard_view->priv->suspended_scroll_file = NULL;
+    }
+  if (thunar_view_get_visible_range (THUNAR_VIEW (standard_view), &first_file, NULL))
+    standard_view->priv->suspended_scroll_file = first_file;
+
+  g_object_get (G_OBJECT (standard_view->preferences), "misc-tab-suspend-timeout", &timeout, NULL);
+  if (timeout > 0)
+    standard_view->priv->suspend_timer_id = g_timeout_add_seconds (timeout, thunar_standard_view_suspend_timer, standard_view);
+}
+
+
+
+/**
+ * thunar_standard_view_resume:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Cancels a scheduled suspension of @standard_view, and loads the folder
+ * of a suspended view again, restoring its scroll position and selection.
+ **/
+void
+thunar_standard_view_resume (ThunarStandardView *standard_view)
+{
+  ThunarFile *scroll_file;
+  GList      *selection;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (standard_view->priv->suspend_timer_id != 0)
+    {
+      g_source_remove (standard_view->priv->suspend_timer_id);
+      standard_view->priv->suspend_timer_id = 0;
+    }
+
+  if (!standard_view->priv->suspended)
+    return;
+
+  selection = standard_view->priv->suspended_selection;
+  scroll_file = standard_view->priv->suspended_scroll_file;
+  standard_view->priv->suspended_selection = NULL;
+  standard_view->priv->suspended_scroll_file = NULL;
+  standard_view->priv->suspended = FALSE;
+  standard_view->priv->load_deferred = FALSE;
+
+  thunar_standard_view_load_folder (standard_view, standard_view->priv->current_directory);
+
+  /* both are applied once the folder is loaded */
+  if (selection != NULL)
+    thunar_component_set_selected_files (THUNAR_COMPONENT (standard_view), selection);
+  if (scroll_file != NULL)
+    {
+      thunar_view_scroll_to_file (THUNAR_VIEW (standard_view), scroll_file, FALSE, TRUE, 0.0f, 0.0f);
+      g_object_unref (scroll_file);
+    }
+
+  thunar_g_list_free_full (selection);
+}
+
+
+
+/**
+ * thunar_standard_view_defer_load:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Makes @standard_view start suspended: its next current directory is
+ * only loaded once thunar_standard_view_resume() is called. This is used
+ * for the background tabs of restored windows.
+ **/
+void
+thunar_standard_view_defer_load (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  standard_view->priv->load_deferred = TRUE;
+}
+
+
+
+/**
+ * thunar_standard_view_get_load_deferred:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Return value: %TRUE if @standard_view was set up with
+ *               thunar_standard_view_defer_load() and was not resumed yet.
+ **/
+gboolean
+thunar_standard_view_get_load_deferred (ThunarStandardView *standard_view)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+
+  return standard_view->priv->load_deferred;
+}
+
+
+
+static gboolean
+thunar_standard_view_search_files_ready (ThunarJob          *job,
+                                         GList              *files,
+                                         ThunarStandardView *standard_view)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+  _thunar_return_val_if_fail (standard_view->priv->search_job == job, FALSE);
+
+  thunar_list_model_add_files (standard_view->model, files);
+
+  /* the job releases the list */
+  return FALSE;
+}
+
+
+
+static void
+thunar_standard_view_search_info_message (ThunarJob          *job,
+                                          const gchar        *message,
+                                          ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (standard_view->priv->search_job == job);
+
+  g_free (standard_view->priv->search_message);
+  standard_view->priv->search_message = g_strdup (message);
+  thunar_standard_view_update_statusbar_text (standard_view);
+}
+
+
+
+static void
+thunar_standard_view_search_finished (ThunarJob          *job,
+                                      ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (standard_view->priv->search_job == job);
+
+  thunar_standard_view_search_cancel (standard_view);
+}
+
+
+
+static void
+thunar_standard_view_search_cancel (ThunarStandardView *standard_view)
+{
+  if (standard_view->priv->search_job == NULL)
+    return;
+
+  g_signal_handlers_disconnect_matched (standard_view->priv->search_job, G_SIGNAL_MATCH_DATA,
+                                        0, 0, NULL, NULL, standard_view);
+  exo_job_cancel (EXO_JOB (standard_view->priv->search_job));
+  g_object_unref (standard_view->priv->search_job);
+  standard_view->priv->search_job = NULL;
+
+  thunar_standard_view_set_loading (standard_view, FALSE);
+}
+
+
+
+/**
+ * thunar_standard_view_set_search_query:
+ * @standard_view : a #ThunarStandardView.
+ * @query         : the text to search for or %NULL.
+ *
+ * Searches the current directory of @standard_view and its subfolders
+ * for files whose name contains @query, see
+ * thunar_io_jobs_search_directory(). The view shows the results instead
+ * of the directory and adds them while the search runs. A running
+ * search is cancelled first, so this can be called on every change of
+ * the query.
+ *
+ * An empty or %NULL @query ends the search and shows the current
+ * directory again. Changing the directory ends the search as well.
+ **/
+void
+thunar_standard_view_set_search_query (ThunarStandardView *standard_view,
+                                       const gchar        *query)
+{
+  gboolean use_index;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (query != NULL && *query == '\0')
+    query = NULL;
+
+  if (g_strcmp0 (standard_view->priv->search_query, query) == 0)
+    return;
+
+  thunar_standard_view_search_cancel (standard_view);
+
+  g_free (standard_view->priv->search_message);
+  standard_view->priv->search_message = NULL;
+
+  if (query == NULL)
+    {
+      g_free (standard_view->priv->search_query);
+      standard_view->priv->search_query = NULL;
+
+      /* show the directory again, which drops the results */
+      if (standard_view->priv->current_directory != NULL && !standard_view->priv->suspended)
+        thunar_standard_view_load_folder (standard_view, standard_view->priv->current_directory);
+      return;
+    }
+
+  if (G_UNLIKELY (standard_view->priv->current_directory == NULL))
+    return;
+
+  /* a suspended view shows no folder, which is fine for the results */
+  if (standard_view->priv->suspend_timer_id != 0)
+    {
+      g_source_remove (standard_view->priv->suspend_timer_id);
+      standard_view->priv->suspend_timer_id = 0;
+    }
+  thunar_standard_view_suspended_clear (standard_view);
+  standard_view->priv->load_deferred = FALSE;
+
+  /* drop the folder or the results of the previous query */
+  thunar_standard_view_release_folder (standard_view);
+
+  g_free (standard_view->priv->search_query);
+  standard_view->priv->search_query = g_strdup (query);
+
+  g_object_get (G_OBJECT (standard_view->preferences), "misc-search-index", &use_index, NULL);
+
+  standard_view->priv->search_job =
+    thunar_io_jobs_search_directory (thunar_file_get_file (standard_view->priv->current_directory),
+                                     query, thunar_view_get_show_hidden (THUNAR_VIEW (standard_view)),
+                                     use_index);
+  g_signal_connect (standard_view->priv->search_job, "files-ready",
+                    G_CALLBACK (thunar_standard_view_search_files_ready), standard_view);
+  g_signal_connect (standard_view->priv->search_job, "info-message",
+                    G_CALLBACK (thunar_standard_view_search_info_message), standard_view);
+  g_signal_connect (standard_view->priv->search_job, "finished",
+                    G_CALLBACK (thunar_standard_view_search_finished), standard_view);
+  exo_job_launch (EXO_JOB (standard_view->priv->search_job));
+
+  thunar_standard_view_set_loading (standard_view, TRUE);
+}
+
+
+
+/**
+ * thunar_standard_view_file_cell_data:
+ * @layout    : the #GtkCellLayout of @renderer.
+ * @renderer  : a #ThunarIconRenderer.
+ * @model     : the #GtkTreeModel of the view.
+ * @iter      : the row to render.
+ * @user_data : unused.
+ *
+ * Cell data function for the icon renderer of the views. For a
+ * #ThunarListModel it hands the file of the row to the renderer
+ * directly, instead of binding the "file" attribute, which copies
+ * the file into a #GValue and sets the property for every cell.
+ **/
+void
+thunar_standard_view_file_cell_data (GtkCellLayout   *layout,
+                                     GtkCellRenderer *renderer,
+                                     GtkTreeModel    *model,
+                                     GtkTreeIter     *iter,
+                                     gpointer         user_data)
+{
+  ThunarFile *file;
+
+  _thunar_return_if_fail (THUNAR_IS_ICON_RENDERER (renderer));
+
+  if (G_LIKELY (THUNAR_IS_LIST_MODEL (model)))
+    {
+      thunar_icon_renderer_set_file (THUNAR_ICON_RENDERER (renderer),
+                                     thunar_list_model_peek_file (THUNAR_LIST_MODEL (model), iter));
+    }
+  else
+    {
+      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
+      thunar_icon_renderer_set_file (THUNAR_ICON_RENDERER (renderer), file);
+      if (G_LIKELY (file != NULL))
+        g_object_unref (G_OBJECT (file));
+    }
+}
+
+
+
+/**
+ * thunar_standard_view_text_cell_data:
+ * @layout    : the #GtkCellLayout of @renderer.
+ * @renderer  : a #GtkCellRendererText.
+ * @model     : the #GtkTreeModel of the view.
+ * @iter      : the row to render.
+ * @user_data : the #ThunarColumn to render, see GINT_TO_POINTER().
+ *
+ * Cell data function for the text renderers of the views. For
+ * a #ThunarListModel the text is looked up without going through
+ * a #GValue, which saves copying the text for every cell.
+ **/
+void
+thunar_standard_view_text_cell_data (GtkCellLayout   *layout,
+                                     GtkCellRenderer *renderer,
+                                     GtkTreeModel    *model,
+                                     GtkTreeIter     *iter,
+                                     gpointer         user_data)
+{
+  ThunarColumn column = GPOINTER_TO_INT (user_data);
+  gchar       *text;
+
+  _thunar_return_if_fail (GTK_IS_CELL_RENDERER_TEXT (renderer));
+
+  if (G_LIKELY (THUNAR_IS_LIST_MODEL (model)))
+    {
+      g_object_set (G_OBJECT (renderer), "text",
+                    thunar_list_model_peek_text (THUNAR_LIST_MODEL (model), iter, column),
+                    NULL);
+    }
+  else
+    {
+      gtk_tree_model_get (model, iter, column, &text, -1);
+      g_object_set (G_OBJECT (renderer), "text", text, NULL);
+      g_free (text);
+    }
+}
@@ -25,6 +25,7 @@
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-list-model.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-selection-ranges.h>
 #include <thunar/thunar-view.h>
 
 G_BEGIN_DECLS;
@@ -67,6 +68,10 @@ struct _ThunarStandardViewClass
    * both the list and the items are owned by the caller. */
   GList       *(*get_selected_items)    (ThunarStandardView *standard_view);
 
+  /* Returns the currently selected rows as a normalized GArray of
+   * ThunarSelectionRange's, owned by the caller. */
+  GArray      *(*get_selected_ranges)   (ThunarStandardView *standard_view);
+
   /* Selects all items in the view */
   void         (*select_all)            (ThunarStandardView *standard_view);
 
@@ -164,6 +169,8 @@ void           thunar_standard_view_context_menu          (ThunarStandardView
 void           thunar_standard_view_queue_popup           (ThunarStandardView       *standard_view,
                                                            GdkEventButton           *event);
 void           thunar_standard_view_selection_changed     (ThunarStandardView       *standard_view);
+void           thunar_standard_view_freeze_selection      (ThunarStandardView       *standard_view);
+void           thunar_standard_view_thaw_selection        (ThunarStandardView       *standard_view);
 void           thunar_standard_view_set_history           (ThunarStandardView       *standard_view,
                                                            ThunarHistory            *history);
 ThunarHistory *thunar_standard_view_get_history           (ThunarStandardView       *standard_view);
@@ -177,6 +184,23 @@ GtkWidget     *thunar_standard_view_append_menu_item      (ThunarStandardView
 void           _thunar_standard_view_open_on_middle_click (ThunarStandardView       *standard_view,
                                                            GtkTreePath              *tree_path,
                                                            guint                     event_state);
+void           thunar_standard_view_schedule_suspend      (ThunarStandardView       *standard_view);
+void           thunar_standard_view_resume                (ThunarStandardView       *standard_view);
+void           thunar_standard_view_defer_load            (ThunarStandardView       *standard_view);
+gboolean       thunar_standard_view_get_load_deferred     (ThunarStandardView       *standard_view);
+void           thunar_standard_view_set_search_query      (ThunarStandardView       *standard_view,
+                                                           const gchar              *query);
+
+void           thunar_standard_view_file_cell_data        (GtkCellLayout            *layout,
+                                                           GtkCellRenderer          *renderer,
+                                                           GtkTreeModel             *model,
+                                                           GtkTreeIter              *iter,
+                                                           gpointer                  user_data);
+void           thunar_standard_view_text_cell_data        (GtkCellLayout            *layout,
+                                                           GtkCellRenderer          *renderer,
+                                                           GtkTreeModel             *model,
+                                                           GtkTreeIter              *iter,
+                                                           gpointer                  user_data);
 
 G_END_DECLS;
 
@@ -0,0 +1,300 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-state-writer.h>
+
+
+
+/* The state writer saves the small configuration files of Thunar, like
+ * the bookmarks and the accel map, on a background thread, so a slow
+ * home directory (e.g. on NFS) does not block the main loop. Every file
+ * is written with g_file_set_contents(), which replaces it atomically.
+ * The writes of a file are delayed and coalesced: scheduling new
+ * contents for a file that is still waiting only replaces the contents.
+ * All writes are done by a single thread in the order they were
+ * started, so a file is never written twice at the same time.
+ */
+
+
+
+typedef struct
+{
+  ThunarStateWriterFunc func;
+  gpointer              user_data;
+} ThunarStateWriterCallback;
+
+typedef struct
+{
+  gchar   *path;
+  GBytes  *contents;
+  GSList  *callbacks;
+  guint    timer_id;
+  GError  *error;
+} ThunarStateWrite;
+
+
+
+static void     thunar_state_writer_free     (ThunarStateWrite *write);
+static void     thunar_state_writer_thread   (gpointer          data,
+                                              gpointer          user_data);
+static gboolean thunar_state_writer_dispatch (gpointer          user_data);
+static void     thunar_state_writer_push     (ThunarStateWrite *write);
+static gboolean thunar_state_writer_timer    (gpointer          user_data);
+
+
+
+/* the writes that wait for their timer, only used in the main thread */
+static GHashTable  *state_writer_pending = NULL;
+
+static GThreadPool *state_writer_pool = NULL;
+
+/* the writes that are queued or done, protected by the lock */
+static GMutex       state_writer_lock;
+static GCond        state_writer_cond;
+static guint        state_writer_n_queued = 0;
+static GSList      *state_writer_done = NULL;
+static guint        state_writer_done_id = 0;
+
+
+
+static void
+thunar_state_writer_free (ThunarStateWrite *write)
+{
+  g_slist_free_full (write->callbacks, g_free);
+  g_bytes_unref (write->contents);
+  g_clear_error (&write->error);
+  g_free (write->path);
+  g_slice_free (ThunarStateWrite, write);
+}
+
+
+
+static void
+thunar_state_writer_thread (gpointer data,
+                            gpointer user_data)
+{
+  ThunarStateWrite *write = data;
+  gconstpointer     contents;
+  gchar            *dirname;
+  gsize             length;
+  gint              errsv;
+
+  dirname = g_path_get_dirname (write->path);
+  if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+      errsv = errno;
+      g_set_error (&write->error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                   "%s", g_strerror (errsv));
+    }
+  else
+    {
+      contents = g_bytes_get_data (write->contents, &length);
+      g_file_set_contents (write->path, contents, length, &write->error);
+    }
+  g_free (dirname);
+
+  /* report back to the main loop */
+  g_mutex_lock (&state_writer_lock);
+  state_writer_done = g_slist_prepend (state_writer_done, write);
+  state_writer_n_queued--;
+  if (state_writer_done_id == 0)
+    state_writer_done_id = g_idle_add (thunar_state_writer_dispatch, NULL);
+  g_cond_broadcast (&state_writer_cond);
+  g_mutex_unlock (&state_writer_lock);
+}
+
+
+
+static gboolean
+thunar_state_writer_dispatch (gpointer user_data)
+{
+  ThunarStateWriterCallback *callback;
+  ThunarStateWrite          *write;
+  GSList                    *done;
+  GSList                    *lp;
+
+  g_mutex_lock (&state_writer_lock);
+  done = g_slist_reverse (state_writer_done);
+  state_writer_done = NULL;
+  state_writer_done_id = 0;
+  g_mutex_unlock (&state_writer_lock);
+
+  while (done != NULL)
+    {
+      write = done->data;
+      done = g_slist_delete_link (done, done);
+
+      if (G_UNLIKELY (write->error != NULL))
+        g_warning ("Failed to write \"%s\": %s", write->path, write->error->message);
+
+      for (lp = write->callbacks; lp != NULL; lp = lp->next)
+        {
+          callback = lp->data;
+          (*callback->func) (write->path, write->error, callback->user_data);
+        }
+
+      thunar_state_writer_free (write);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_state_writer_push (ThunarStateWrite *write)
+{
+  /* a single thread keeps the writes in order */
+  if (G_UNLIKELY (state_writer_pool == NULL))
+    state_writer_pool = g_thread_pool_new (thunar_state_writer_thread, NULL, 1, FALSE, NULL);
+
+  g_mutex_lock (&state_writer_lock);
+  state_writer_n_queued++;
+  g_mutex_unlock (&state_writer_lock);
+
+  g_thread_pool_push (state_writer_pool, write, NULL);
+}
+
+
+
+static gboolean
+thunar_state_writer_timer (gpointer user_data)
+{
+  ThunarStateWrite *write = user_data;
+
+  write->timer_id = 0;
+  g_hash_table_steal (state_writer_pending, write->path);
+  thunar_state_writer_push (write);
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_state_writer_schedule:
+ * @path      : the local path of the file to write.
+ * @contents  : the new contents of @path.
+ * @delay     : the time in milliseconds to wait for newer contents.
+ * @func      : the function to call once @path was written or %NULL.
+ * @user_data : the data to pass to @func.
+ *
+ * Writes @contents to @path on the background thread after @delay
+ * milliseconds. If new contents for @path are scheduled before, they
+ * replace @contents without postponing the write, and all the @func<!---->s
+ * are called once the latest contents were written. The parent folders
+ * of @path are created if necessary.
+ **/
+void
+thunar_state_writer_schedule (const gchar           *path,
+                              GBytes                *contents,
+                              guint                  delay,
+                              ThunarStateWriterFunc  func,
+                              gpointer               user_data)
+{
+  ThunarStateWriterCallback *callback;
+  ThunarStateWrite          *write;
+
+  _thunar_return_if_fail (g_path_is_absolute (path));
+  _thunar_return_if_fail (contents != NULL);
+
+  if (G_UNLIKELY (state_writer_pending == NULL))
+    state_writer_pending = g_hash_table_new (g_str_hash, g_str_equal);
+
+  write = g_hash_table_lookup (state_writer_pending, path);
+  if (write == NULL)
+    {
+      write = g_slice_new0 (ThunarStateWrite);
+      write->path = g_strdup (path);
+      g_hash_table_insert (state_writer_pending, write->path, write);
+    }
+  else
+    {
+      g_bytes_unref (write->contents);
+    }
+
+  write->contents = g_bytes_ref (contents);
+
+  if (func != NULL)
+    {
+      callback = g_new (ThunarStateWriterCallback, 1);
+      callback->func = func;
+      callback->user_data = user_data;
+      write->callbacks = g_slist_append (write->callbacks, callback);
+    }
+
+  if (delay == 0)
+    {
+      if (write->timer_id != 0)
+        g_source_remove (write->timer_id);
+      thunar_state_writer_timer (write);
+    }
+  else if (write->timer_id == 0)
+    {
+      write->timer_id = g_timeout_add (delay, thunar_state_writer_timer, write);
+    }
+}
+
+
+
+/**
+ * thunar_state_writer_flush:
+ *
+ * Starts all the delayed writes and waits until every file is written,
+ * which calls the pending #ThunarStateWriterFunc<!---->s. Used when Thunar
+ * shuts down.
+ **/
+void
+thunar_state_writer_flush (void)
+{
+  ThunarStateWrite *write;
+  GHashTableIter    iter;
+
+  if (state_writer_pending != NULL)
+    {
+      g_hash_table_iter_init (&iter, state_writer_pending);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &write))
+        {
+          if (write->timer_id != 0)
+            g_source_remove (write->timer_id);
+          write->timer_id = 0;
+          g_hash_table_iter_steal (&iter);
+          thunar_state_writer_push (write);
+        }
+    }
+
+  g_mutex_lock (&state_writer_lock);
+  while (state_writer_n_queued > 0)
+    g_cond_wait (&state_writer_cond, &state_writer_lock);
+  g_mutex_unlock (&state_writer_lock);
+
+  thunar_state_writer_dispatch (NULL);
+}
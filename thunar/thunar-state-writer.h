@@ -0,0 +1,50 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_STATE_WRITER_H__
+#define __THUNAR_STATE_WRITER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * ThunarStateWriterFunc:
+ * @path      : the file that was written.
+ * @error     : the reason why the write failed or %NULL.
+ * @user_data : the data passed to thunar_state_writer_schedule().
+ *
+ * Called in the main loop once the contents were written to @path.
+ **/
+typedef void (*ThunarStateWriterFunc) (const gchar  *path,
+                                       const GError *error,
+                                       gpointer      user_data);
+
+void thunar_state_writer_schedule (const gchar           *path,
+                                   GBytes                *contents,
+                                   guint                  delay,
+                                   ThunarStateWriterFunc  func,
+                                   gpointer               user_data);
+
+void thunar_state_writer_flush    (void);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_STATE_WRITER_H__ */
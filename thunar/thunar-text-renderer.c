@@ -0,0 +1,307 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-text-renderer.h>
+
+
+
+/* The text renderer draws the file names in the views. It keeps the
+ * shaped layouts of the recently drawn names, so redrawing the views,
+ * for example while scrolling, does not shape, wrap and ellipsize the
+ * same names over and over again.
+ *
+ * A layout is looked up by its name and width, all other properties
+ * affecting the layouts drop the cache when they change. Measuring the
+ * cells is still left to GtkCellRendererText.
+ */
+#define TEXT_RENDERER_CACHE_SIZE (512)
+
+
+
+typedef struct
+{
+  gchar       *key;
+  PangoLayout *layout;
+}
+TextRendererLayout;
+
+
+
+static void         thunar_text_renderer_finalize   (GObject              *object);
+static void         thunar_text_renderer_notify     (GObject              *object,
+                                                     GParamSpec           *pspec);
+static void         thunar_text_renderer_render     (GtkCellRenderer      *renderer,
+                                                     cairo_t              *cr,
+                                                     GtkWidget            *widget,
+                                                     const GdkRectangle   *background_area,
+                                                     const GdkRectangle   *cell_area,
+                                                     GtkCellRendererState  flags);
+static void         thunar_text_renderer_clear      (ThunarTextRenderer   *text_renderer);
+
+
+
+G_DEFINE_TYPE (ThunarTextRenderer, thunar_text_renderer, GTK_TYPE_CELL_RENDERER_TEXT)
+
+
+
+static void
+thunar_text_renderer_class_init (ThunarTextRendererClass *klass)
+{
+  GtkCellRendererClass *gtkcell_renderer_class;
+  GObjectClass         *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_text_renderer_finalize;
+  gobject_class->notify = thunar_text_renderer_notify;
+
+  gtkcell_renderer_class = GTK_CELL_RENDERER_CLASS (klass);
+  gtkcell_renderer_class->render = thunar_text_renderer_render;
+}
+
+
+
+static void
+thunar_text_renderer_init (ThunarTextRenderer *text_renderer)
+{
+  g_queue_init (&text_renderer->layouts);
+  text_renderer->layouts_table = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+
+
+static void
+thunar_text_renderer_finalize (GObject *object)
+{
+  ThunarTextRenderer *text_renderer = THUNAR_TEXT_RENDERER (object);
+
+  thunar_text_renderer_clear (text_renderer);
+  g_hash_table_destroy (text_renderer->layouts_table);
+
+  if (text_renderer->context != NULL)
+    g_object_unref (text_renderer->context);
+
+  (*G_OBJECT_CLASS (thunar_text_renderer_parent_class)->finalize) (object);
+}
+
+
+
+static void
+thunar_text_renderer_notify (GObject    *object,
+                             GParamSpec *pspec)
+{
+  const gchar *name = g_param_spec_get_name (pspec);
+
+  /* the text is part of the key, these shape all the layouts */
+  if (strcmp (name, "alignment") == 0
+      || strcmp (name, "attributes") == 0
+      || strcmp (name, "ellipsize") == 0
+      || strcmp (name, "wrap-mode") == 0
+      || strcmp (name, "wrap-width") == 0)
+    {
+      thunar_text_renderer_clear (THUNAR_TEXT_RENDERER (object));
+    }
+
+  if (G_OBJECT_CLASS (thunar_text_renderer_parent_class)->notify != NULL)
+    (*G_OBJECT_CLASS (thunar_text_renderer_parent_class)->notify) (object, pspec);
+}
+
+
+
+static void
+thunar_text_renderer_clear (ThunarTextRenderer *text_renderer)
+{
+  TextRendererLayout *entry;
+
+  g_hash_table_remove_all (text_renderer->layouts_table);
+
+  while ((entry = g_queue_pop_head (&text_renderer->layouts)) != NULL)
+    {
+      g_object_unref (entry->layout);
+      g_free (entry->key);
+      g_slice_free (TextRendererLayout, entry);
+    }
+}
+
+
+
+static PangoLayout *
+thunar_text_renderer_get_layout (ThunarTextRenderer *text_renderer,
+                                 GtkWidget          *widget,
+                                 const gchar        *text,
+                                 gint                width)
+{
+  TextRendererLayout *entry;
+  PangoEllipsizeMode  ellipsize;
+  PangoAttrList      *attributes;
+  PangoAlignment      alignment;
+  PangoWrapMode       wrap_mode;
+  PangoContext       *context;
+  GList              *lp;
+  gchar              *key;
+
+  /* layouts of another context or font setup are of no use anymore */
+  context = gtk_widget_get_pango_context (widget);
+  if (G_UNLIKELY (text_renderer->context != context
+                  || text_renderer->context_serial != pango_context_get_serial (context)))
+    {
+      thunar_text_renderer_clear (text_renderer);
+
+      if (text_renderer->context != NULL)
+        g_object_unref (text_renderer->context);
+      text_renderer->context = g_object_ref (context);
+      text_renderer->context_serial = pango_context_get_serial (context);
+    }
+
+  key = g_strdup_printf ("%d:%s", width, text);
+  lp = g_hash_table_lookup (text_renderer->layouts_table, key);
+  if (G_LIKELY (lp != NULL))
+    {
+      g_free (key);
+
+      /* move the layout to the front of the queue */
+      g_queue_unlink (&text_renderer->layouts, lp);
+      g_queue_push_head_link (&text_renderer->layouts, lp);
+
+      return ((TextRendererLayout *) lp->data)->layout;
+    }
+
+  g_object_get (G_OBJECT (text_renderer),
+                "alignment", &alignment,
+                "attributes", &attributes,
+                "ellipsize", &ellipsize,
+                "wrap-mode", &wrap_mode,
+                NULL);
+
+  entry = g_slice_new (TextRendererLayout);
+  entry->key = key;
+  entry->layout = pango_layout_new (context);
+  pango_layout_set_text (entry->layout, text, -1);
+  pango_layout_set_attributes (entry->layout, attributes);
+  pango_layout_set_alignment (entry->layout, alignment);
+  pango_layout_set_ellipsize (entry->layout, ellipsize);
+  pango_layout_set_wrap (entry->layout, wrap_mode);
+  pango_layout_set_width (entry->layout, width);
+
+  if (attributes != NULL)
+    pango_attr_list_unref (attributes);
+
+  g_queue_push_head (&text_renderer->layouts, entry);
+  g_hash_table_insert (text_renderer->layouts_table, entry->key, text_renderer->layouts.head);
+
+  /* drop the least recently used layouts */
+  while (text_renderer->layouts.length > TEXT_RENDERER_CACHE_SIZE)
+    {
+      entry = g_queue_pop_tail (&text_renderer->layouts);
+      g_hash_table_remove (text_renderer->layouts_table, entry->key);
+      g_object_unref (entry->layout);
+      g_free (entry->key);
+      g_slice_free (TextRendererLayout, entry);
+    }
+
+  return ((TextRendererLayout *) text_renderer->layouts.head->data)->layout;
+}
+
+
+
+static void
+thunar_text_renderer_render (GtkCellRenderer      *renderer,
+                             cairo_t              *cr,
+                             GtkWidget            *widget,
+                             const GdkRectangle   *background_area,
+                             const GdkRectangle   *cell_area,
+                             GtkCellRendererState  flags)
+{
+  ThunarTextRenderer *text_renderer = THUNAR_TEXT_RENDERER (renderer);
+  PangoEllipsizeMode  ellipsize;
+  PangoRectangle      rect;
+  PangoLayout        *layout;
+  gfloat              xalign, yalign;
+  gchar              *text;
+  gint                wrap_width;
+  gint                width;
+  gint                xpad, ypad;
+  gint                x_offset, y_offset;
+
+  g_object_get (G_OBJECT (renderer), "text", &text, "ellipsize", &ellipsize, "wrap-width", &wrap_width, NULL);
+  if (G_UNLIKELY (text == NULL))
+    return;
+
+  gtk_cell_renderer_get_padding (renderer, &xpad, &ypad);
+  gtk_cell_renderer_get_alignment (renderer, &xalign, &yalign);
+
+  /* ellipsized names fill the cell, others wrap at the wrap width */
+  if (ellipsize != PANGO_ELLIPSIZE_NONE)
+    width = MAX (cell_area->width - 2 * xpad, 0) * PANGO_SCALE;
+  else if (wrap_width >= 0)
+    width = wrap_width * PANGO_SCALE;
+  else
+    width = -1;
+
+  layout = thunar_text_renderer_get_layout (text_renderer, widget, text, width);
+  g_free (text);
+
+  /* align the text inside the cell like GtkCellRendererText does */
+  pango_layout_get_pixel_extents (layout, NULL, &rect);
+  rect.width = MIN (rect.width, cell_area->width - 2 * xpad);
+  rect.height = MIN (rect.height, cell_area->height - 2 * ypad);
+
+  if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
+    x_offset = (1.0 - xalign) * (cell_area->width - (rect.width + 2 * xpad));
+  else
+    x_offset = xalign * (cell_area->width - (rect.width + 2 * xpad));
+  if (width != -1)
+    x_offset = MAX (x_offset, 0);
+  y_offset = MAX (yalign * (cell_area->height - (rect.height + 2 * ypad)), 0);
+
+  cairo_save (cr);
+  gdk_cairo_rectangle (cr, cell_area);
+  cairo_clip (cr);
+  gtk_render_layout (gtk_widget_get_style_context (widget), cr,
+                     cell_area->x + x_offset + xpad - rect.x,
+                     cell_area->y + y_offset + ypad,
+                     layout);
+  cairo_restore (cr);
+}
+
+
+
+/**
+ * thunar_text_renderer_new:
+ *
+ * Creates a new #ThunarTextRenderer. It is used like a
+ * #GtkCellRendererText, but only supports the properties
+ * the views use for the file names.
+ *
+ * Return value: the newly allocated #ThunarTextRenderer.
+ **/
+GtkCellRenderer*
+thunar_text_renderer_new (void)
+{
+  return g_object_new (THUNAR_TYPE_TEXT_RENDERER, NULL);
+}
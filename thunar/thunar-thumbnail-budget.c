@@ -0,0 +1,217 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-enum-types.h>
+#include <thunar/thunar-preferences.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-thumbnail-budget.h>
+
+
+
+/* With THUNAR_THUMBNAIL_MODE_BUDGETED, the thumbnails of remote files are
+ * generated within a read budget per share, so a folder of photos on an
+ * SMB share does not saturate the link for everybody else. Every share
+ * has a token bucket that is refilled with "misc-thumbnail-remote-budget"
+ * KiB per second, and a file is only queued if the bucket holds its size.
+ * Files that usually carry an embedded preview, which is all the D-Bus
+ * thumbnailer reads of them, only cost THUNAR_THUMBNAIL_BUDGET_PREVIEW_COST.
+ * The budget is only used on the main thread.
+ */
+
+
+
+/* number of seconds of the budget that can be saved up for a burst */
+#define THUNAR_THUMBNAIL_BUDGET_BURST (4)
+
+/* bytes charged for a file with an embedded preview */
+#define THUNAR_THUMBNAIL_BUDGET_PREVIEW_COST (256 * 1024)
+
+
+
+typedef struct
+{
+  gdouble bytes;
+  gint64  time;
+} ThunarThumbnailBudgetBucket;
+
+
+
+static GHashTable         *budget_buckets = NULL;
+static ThunarThumbnailMode budget_mode = THUNAR_THUMBNAIL_MODE_ONLY_LOCAL;
+static guint               budget_rate = 0;
+static guint               budget_max_file_size = 0;
+static gboolean            budget_prefer_embedded = TRUE;
+
+
+
+static void
+thunar_thumbnail_budget_changed (ThunarPreferences *preferences)
+{
+  g_object_get (G_OBJECT (preferences),
+                "misc-thumbnail-mode", &budget_mode,
+                "misc-thumbnail-remote-budget", &budget_rate,
+                "misc-thumbnail-remote-max-file-size", &budget_max_file_size,
+                "misc-thumbnail-remote-prefer-embedded", &budget_prefer_embedded,
+                NULL);
+
+  /* start over with full buckets */
+  g_hash_table_remove_all (budget_buckets);
+}
+
+
+
+static gchar *
+thunar_thumbnail_budget_share (ThunarFile *file)
+{
+  gchar *uri;
+  gchar *p;
+  guint  n;
+
+  /* the share is the first folder on the host, like smb://host/share/,
+   * which is the mount for SMB and close enough for the other schemes */
+  uri = thunar_file_dup_uri (file);
+  p = strstr (uri, "://");
+  if (G_LIKELY (p != NULL))
+    {
+      for (p += 3, n = 0; *p != '\0'; ++p)
+        if (*p == '/' && ++n == 2)
+          {
+            p[1] = '\0';
+            break;
+          }
+    }
+
+  return uri;
+}
+
+
+
+static gboolean
+thunar_thumbnail_budget_has_preview (ThunarFile *file)
+{
+  const gchar *content_type;
+
+  /* the thumbnailers of tumbler use the EXIF thumbnail of JPEG
+   * images and the embedded preview of camera raw images */
+  content_type = thunar_file_get_content_type (file);
+  return content_type != NULL
+         && (g_content_type_equals (content_type, "image/jpeg")
+             || g_content_type_is_a (content_type, "image/x-dcraw"));
+}
+
+
+
+/**
+ * thunar_thumbnail_budget_charge:
+ * @file : a #ThunarFile about to be queued for thumbnailing.
+ *
+ * Checks whether @file fits into the budget of its share with
+ * %THUNAR_THUMBNAIL_MODE_BUDGETED, and charges the data the D-Bus
+ * thumbnailer will read of it if so. Local files and all files in
+ * the other thumbnail modes are admitted without a charge.
+ *
+ * Return value: whether @file may be thumbnailed now, later or never.
+ **/
+ThunarThumbnailBudgetResult
+thunar_thumbnail_budget_charge (ThunarFile *file)
+{
+  ThunarThumbnailBudgetBucket *bucket;
+  ThunarPreferences           *preferences;
+  gboolean                     has_preview;
+  guint64                      size;
+  gdouble                      capacity;
+  gdouble                      cost;
+  gint64                       now;
+  gchar                       *share;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), THUNAR_THUMBNAIL_BUDGET_ADMIT);
+
+  if (G_UNLIKELY (budget_buckets == NULL))
+    {
+      budget_buckets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+      /* the preferences are kept alive by the application */
+      preferences = thunar_preferences_get ();
+      thunar_thumbnail_budget_changed (preferences);
+      g_signal_connect (G_OBJECT (preferences), "notify::misc-thumbnail-mode",
+                        G_CALLBACK (thunar_thumbnail_budget_changed), NULL);
+      g_signal_connect (G_OBJECT (preferences), "notify::misc-thumbnail-remote-budget",
+                        G_CALLBACK (thunar_thumbnail_budget_changed), NULL);
+      g_signal_connect (G_OBJECT (preferences), "notify::misc-thumbnail-remote-max-file-size",
+                        G_CALLBACK (thunar_thumbnail_budget_changed), NULL);
+      g_signal_connect (G_OBJECT (preferences), "notify::misc-thumbnail-remote-prefer-embedded",
+                        G_CALLBACK (thunar_thumbnail_budget_changed), NULL);
+      g_object_unref (G_OBJECT (preferences));
+    }
+
+  if (budget_mode != THUNAR_THUMBNAIL_MODE_BUDGETED || thunar_file_is_local (file))
+    return THUNAR_THUMBNAIL_BUDGET_ADMIT;
+
+  /* only the preview is read of files that have one */
+  size = thunar_file_get_size (file);
+  has_preview = budget_prefer_embedded && thunar_thumbnail_budget_has_preview (file);
+  if (has_preview)
+    size = MIN (size, THUNAR_THUMBNAIL_BUDGET_PREVIEW_COST);
+  else if (budget_max_file_size > 0 && size > (guint64) budget_max_file_size * 1024)
+    return THUNAR_THUMBNAIL_BUDGET_REJECT;
+
+  if (budget_rate == 0)
+    return THUNAR_THUMBNAIL_BUDGET_ADMIT;
+
+  /* look up the bucket of the share, new buckets start full */
+  capacity = (gdouble) budget_rate * 1024 * THUNAR_THUMBNAIL_BUDGET_BURST;
+  now = g_get_monotonic_time ();
+  share = thunar_thumbnail_budget_share (file);
+  bucket = g_hash_table_lookup (budget_buckets, share);
+  if (bucket == NULL)
+    {
+      bucket = g_new (ThunarThumbnailBudgetBucket, 1);
+      bucket->bytes = capacity;
+      bucket->time = now;
+      g_hash_table_insert (budget_buckets, share, bucket);
+    }
+  else
+    {
+      g_free (share);
+    }
+
+  /* refill the bucket for the time since the last charge */
+  bucket->bytes += (gdouble) budget_rate * 1024 * (now - bucket->time) / G_USEC_PER_SEC;
+  bucket->bytes = MIN (bucket->bytes, capacity);
+  bucket->time = now;
+
+  /* a file larger than the bucket is admitted once the bucket is full,
+   * the debt delays the files after it */
+  cost = size;
+  if (bucket->bytes < cost && bucket->bytes < capacity)
+    return THUNAR_THUMBNAIL_BUDGET_DEFER;
+
+  bucket->bytes -= cost;
+
+  return THUNAR_THUMBNAIL_BUDGET_ADMIT;
+}
@@ -0,0 +1,45 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_THUMBNAIL_BUDGET_H__
+#define __THUNAR_THUMBNAIL_BUDGET_H__
+
+#include <thunar/thunar-file.h>
+
+G_BEGIN_DECLS
+
+/**
+ * ThunarThumbnailBudgetResult:
+ * @THUNAR_THUMBNAIL_BUDGET_ADMIT  : the file may be thumbnailed now.
+ * @THUNAR_THUMBNAIL_BUDGET_DEFER  : the budget of the share is used up, try again later.
+ * @THUNAR_THUMBNAIL_BUDGET_REJECT : the file is too large to be thumbnailed.
+ **/
+typedef enum
+{
+  THUNAR_THUMBNAIL_BUDGET_ADMIT,
+  THUNAR_THUMBNAIL_BUDGET_DEFER,
+  THUNAR_THUMBNAIL_BUDGET_REJECT,
+} ThunarThumbnailBudgetResult;
+
+ThunarThumbnailBudgetResult thunar_thumbnail_budget_charge (ThunarFile *file);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_THUMBNAIL_BUDGET_H__ */
@@ -37,7 +37,26 @@
 
 
 
-static void thunar_thumbnail_cache_finalize (GObject *object);
+/* maximum number of URIs sent to the cache service in one call */
+#define THUNAR_THUMBNAIL_CACHE_BATCH_SIZE (1000)
+
+
+
+typedef enum
+{
+  THUNAR_THUMBNAIL_CACHE_MOVE,
+  THUNAR_THUMBNAIL_CACHE_COPY,
+  THUNAR_THUMBNAIL_CACHE_DELETE,
+  THUNAR_THUMBNAIL_CACHE_CLEANUP,
+  THUNAR_THUMBNAIL_CACHE_N_OPERATIONS
+} ThunarThumbnailCacheOperation;
+
+typedef struct _ThunarThumbnailCacheQueue ThunarThumbnailCacheQueue;
+
+
+
+static void thunar_thumbnail_cache_finalize (GObject                   *object);
+static void thunar_thumbnail_cache_schedule (ThunarThumbnailCacheQueue *queue);
 
 
 
@@ -53,6 +72,31 @@ struct _ThunarThumbnailCacheClass
   GObjectClass __parent__;
 };
 
+/* an operation on the thumbnails of one file, the target is only
+ * set for move and copy operations */
+typedef struct
+{
+  GFile *source;
+  GFile *target;
+}
+ThunarThumbnailCacheItem;
+
+/* the pending items of one operation, in the order they were queued. The
+ * index maps the target (or the file for delete and cleanup) of an item to
+ * its link in the queue, so operations on the same file can be merged.
+ * Only one call per operation is sent to the cache service at a time */
+struct _ThunarThumbnailCacheQueue
+{
+  ThunarThumbnailCache          *cache;
+  ThunarThumbnailCacheOperation  operation;
+
+  GQueue                         items;
+  GHashTable                    *index;
+
+  guint                          timeout_id;
+  gboolean                       in_flight;
+};
+
 struct _ThunarThumbnailCache
 {
   GObject     __parent__;
@@ -60,21 +104,28 @@ struct _ThunarThumbnailCache
   ThunarThumbnailCacheDBus *cache_proxy;
   int                       proxy_state;
 
-  GList      *move_source_queue;
-  GList      *move_target_queue;
-  guint       move_queue_idle_id;
+  ThunarThumbnailCacheQueue queues[THUNAR_THUMBNAIL_CACHE_N_OPERATIONS];
 
-  GList      *copy_source_queue;
-  GList      *copy_target_queue;
-  guint       copy_queue_idle_id;
+  GMutex      lock;
+};
 
-  GList      *delete_queue;
-  guint       delete_queue_idle_id;
+typedef struct
+{
+  ThunarThumbnailCacheQueue *queue;
+  GList                     *targets;
+}
+ThunarThumbnailCacheReply;
 
-  GList      *cleanup_queue;
-  guint       cleanup_queue_idle_id;
 
-  GMutex      lock;
+
+/* delay before a queue is sent to the cache service (in ms), so the
+ * items of a bulk operation end up in a few batches */
+static const guint thunar_thumbnail_cache_delays[THUNAR_THUMBNAIL_CACHE_N_OPERATIONS] =
+{
+  250,  /* move */
+  500,  /* copy */
+  500,  /* delete */
+  1000, /* cleanup */
 };
 
 
@@ -98,34 +149,38 @@ thunar_thumbnail_cache_class_init (ThunarThumbnailCacheClass *klass)
 
 
 static void
-thunar_thumbnail_cache_finalize (GObject *object)
+thunar_thumbnail_cache_item_free (gpointer data)
 {
-  ThunarThumbnailCache *cache = THUNAR_THUMBNAIL_CACHE (object);
+  ThunarThumbnailCacheItem *item = data;
+
+  g_object_unref (item->source);
+  if (item->target != NULL)
+    g_object_unref (item->target);
+  g_slice_free (ThunarThumbnailCacheItem, item);
+}
 
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
 
-  /* drop the move queue idle and all queued files */
-  if (cache->move_queue_idle_id > 0)
-    g_source_remove (cache->move_queue_idle_id);
-  g_list_free_full (cache->move_source_queue, g_object_unref);
-  g_list_free_full (cache->move_target_queue, g_object_unref);
 
-  /* drop the copy queue idle and all queued files */
-  if (cache->copy_queue_idle_id > 0)
-    g_source_remove (cache->copy_queue_idle_id);
-  g_list_free_full (cache->copy_source_queue, g_object_unref);
-  g_list_free_full (cache->copy_target_queue, g_object_unref);
+static void
+thunar_thumbnail_cache_finalize (GObject *object)
+{
+  ThunarThumbnailCache      *cache = THUNAR_THUMBNAIL_CACHE (object);
+  ThunarThumbnailCacheQueue *queue;
+  guint                      n;
 
-  /* drop the delete queue idle and all queued files */
-  if (cache->delete_queue_idle_id > 0)
-    g_source_remove (cache->delete_queue_idle_id);
-  g_list_free_full (cache->delete_queue, g_object_unref);
+  /* acquire a cache lock */
+  _thumbnail_cache_lock (cache);
 
-  /* drop the cleanup queue idle and all queued files */
-  if (cache->cleanup_queue_idle_id > 0)
-    g_source_remove (cache->cleanup_queue_idle_id);
-  g_list_free_full (cache->cleanup_queue, g_object_unref);
+  /* drop the queue timeouts and all queued files */
+  for (n = 0; n < THUNAR_THUMBNAIL_CACHE_N_OPERATIONS; ++n)
+    {
+      queue = &cache->queues[n];
+      if (queue->timeout_id > 0)
+        g_source_remove (queue->timeout_id);
+      g_hash_table_destroy (queue->index);
+      g_queue_foreach (&queue->items, (GFunc) (void (*)(void)) thunar_thumbnail_cache_item_free, NULL);
+      g_queue_clear (&queue->items);
+    }
 
   /* check if we have a valid cache proxy */
   if (cache->cache_proxy != NULL)
@@ -142,376 +197,340 @@ thunar_thumbnail_cache_finalize (GObject *object)
 
 
 
-static void
-thunar_thumbnail_cache_copy_async_reply (ThunarThumbnailCacheDBus *proxy,
-                                         GAsyncResult             *res,
-                                         gpointer                  user_data)
+static GFile *
+thunar_thumbnail_cache_item_key (ThunarThumbnailCacheItem *item)
 {
-  GList      *li;
-  ThunarFile *file;
-  GError     *error = NULL;
-
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE_DBUS (proxy));
-
-  if (!thunar_thumbnail_cache_dbus_call_copy_finish (proxy, res, &error))
-    {
-      g_printerr ("ThunarThumbnailCache: failed to call Copy(): %s\n", error->message);
-    }
-  g_clear_error (&error);
-
-  for (li = user_data; li != NULL; li = li->next)
-    {
-      file = thunar_file_cache_lookup (G_FILE (li->data));
-
-      if (G_LIKELY (file != NULL))
-        {
-          /* if visible, let the view know there might be a thumb */
-          thunar_file_changed (file);
-          g_object_unref (file);
-        }
-    }
-
-  g_list_free_full (user_data, g_object_unref);
+  return (item->target != NULL) ? item->target : item->source;
 }
 
 
 
 static void
-thunar_thumbnail_cache_move_async_reply (ThunarThumbnailCacheDBus *proxy,
-                                         GAsyncResult             *res,
-                                         gpointer                  user_data)
+thunar_thumbnail_cache_queue_remove (ThunarThumbnailCacheQueue *queue,
+                                     GList                     *link)
 {
-  GList      *li;
-  ThunarFile *file;
-  GError     *error = NULL;
-
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE_DBUS (proxy));
-
-  if (!thunar_thumbnail_cache_dbus_call_move_finish (proxy, res, &error))
-    {
-      g_printerr ("ThunarThumbnailCache: failed to call Move(): %s\n", error->message);
-    }
-  g_clear_error (&error);
+  ThunarThumbnailCacheItem *item = link->data;
 
-  for (li = user_data; li != NULL; li = li->next)
-    {
-      file = thunar_file_cache_lookup (G_FILE (li->data));
-
-      if (G_LIKELY (file != NULL))
-        {
-          /* if visible, let the view know there might be a thumb */
-          thunar_file_changed (file);
-          g_object_unref (file);
-        }
-    }
-
-  g_list_free_full (user_data, g_object_unref);
+  g_hash_table_remove (queue->index, thunar_thumbnail_cache_item_key (item));
+  g_queue_delete_link (&queue->items, link);
+  thunar_thumbnail_cache_item_free (item);
 }
 
 
 
 static void
-thunar_thumbnail_cache_move_async (ThunarThumbnailCache *cache,
-                                   const gchar         **source_uris,
-                                   const gchar         **target_uris,
-                                   gpointer              user_data)
+thunar_thumbnail_cache_queue_push (ThunarThumbnailCacheQueue *queue,
+                                   GFile                     *source,
+                                   GFile                     *target)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (source_uris != NULL);
-  _thunar_return_if_fail (target_uris != NULL);
-
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_dbus_call_move (cache->cache_proxy,
-                                         source_uris, target_uris,
-                                         NULL,
-                                         (GAsyncReadyCallback)thunar_thumbnail_cache_move_async_reply,
-                                         user_data);
-}
+  ThunarThumbnailCacheItem *item;
 
+  item = g_slice_new (ThunarThumbnailCacheItem);
+  item->source = g_object_ref (source);
+  item->target = (target != NULL) ? g_object_ref (target) : NULL;
 
-
-static void
-thunar_thumbnail_cache_copy_async (ThunarThumbnailCache *cache,
-                                   const gchar         **source_uris,
-                                   const gchar         **target_uris,
-                                   gpointer              user_data)
-{
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (source_uris != NULL);
-  _thunar_return_if_fail (target_uris != NULL);
-
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_dbus_call_copy (cache->cache_proxy,
-                                         source_uris, target_uris,
-                                         NULL,
-                                         (GAsyncReadyCallback)thunar_thumbnail_cache_copy_async_reply,
-                                         user_data);
+  g_queue_push_tail (&queue->items, item);
+  g_hash_table_insert (queue->index, thunar_thumbnail_cache_item_key (item), queue->items.tail);
 }
 
 
 
 static void
-thunar_thumbnail_cache_delete_async (ThunarThumbnailCache *cache,
-                                     const gchar         **uris)
+thunar_thumbnail_cache_queue_retarget (ThunarThumbnailCacheQueue *queue,
+                                       GList                     *link,
+                                       GFile                     *target)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (uris != NULL);
+  ThunarThumbnailCacheItem *item = link->data;
 
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_dbus_call_delete (cache->cache_proxy, uris,
-                                           NULL, NULL, NULL);
+  g_hash_table_remove (queue->index, item->target);
+  g_object_unref (item->target);
+  item->target = g_object_ref (target);
+  g_hash_table_insert (queue->index, item->target, link);
 }
 
 
 
 static void
-thunar_thumbnail_cache_cleanup_async (ThunarThumbnailCache *cache,
-                                      const gchar *const    *base_uris)
+thunar_thumbnail_cache_queue_delete (ThunarThumbnailCache *cache,
+                                     GFile                *file)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (base_uris != NULL);
+  ThunarThumbnailCacheQueue *queue = &cache->queues[THUNAR_THUMBNAIL_CACHE_DELETE];
 
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_dbus_call_cleanup (cache->cache_proxy,
-                                            (const gchar **)base_uris, 0,
-                                            NULL, NULL, NULL);
+  if (!g_hash_table_contains (queue->index, file))
+    {
+      thunar_thumbnail_cache_queue_push (queue, file, NULL);
+      thunar_thumbnail_cache_schedule (queue);
+    }
 }
 
 
 
-static gboolean
-thunar_thumbnail_cache_process_queue (ThunarThumbnailCache *cache,
-                                      gboolean              copy_async)
+static void
+thunar_thumbnail_cache_queue_transfer (ThunarThumbnailCache          *cache,
+                                       ThunarThumbnailCacheOperation  operation,
+                                       GFile                         *source_file,
+                                       GFile                         *target_file)
 {
-  GList  *sp;
-  GList  *tp;
-  gchar **source_uris;
-  gchar **target_uris;
-  guint   n_uris;
-  guint   n;
-  GList  *source_queue;
-  GList  *target_queue;
-
-  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
-
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
-
-  /* steal the lists */
-  if (copy_async)
+  ThunarThumbnailCacheQueue *queue = &cache->queues[operation];
+  ThunarThumbnailCacheQueue *moves = &cache->queues[THUNAR_THUMBNAIL_CACHE_MOVE];
+  ThunarThumbnailCacheQueue *copies = &cache->queues[THUNAR_THUMBNAIL_CACHE_COPY];
+  ThunarThumbnailCacheItem  *item;
+  GList                     *link;
+
+  /* the target gets a new thumbnail, so a pending delete is moot */
+  link = g_hash_table_lookup (cache->queues[THUNAR_THUMBNAIL_CACHE_DELETE].index, target_file);
+  if (link != NULL)
+    thunar_thumbnail_cache_queue_remove (&cache->queues[THUNAR_THUMBNAIL_CACHE_DELETE], link);
+
+  /* the target is overwritten, so whatever was queued for it is replaced */
+  link = g_hash_table_lookup (moves->index, target_file);
+  if (link != NULL)
     {
-      source_queue = cache->copy_source_queue;
-      cache->copy_source_queue = NULL;
-      target_queue = cache->copy_target_queue;
-      cache->copy_target_queue = NULL;
-    }
-  else
-    {
-      source_queue = cache->move_source_queue;
-      cache->move_source_queue = NULL;
-      target_queue = cache->move_target_queue;
-      cache->move_target_queue = NULL;
+      /* the thumbnail is still stored for the source of the move */
+      item = link->data;
+      thunar_thumbnail_cache_queue_delete (cache, item->source);
+      thunar_thumbnail_cache_queue_remove (moves, link);
     }
 
-  /* compute how many URIs there are */
-  n_uris = g_list_length (source_queue);
+  link = g_hash_table_lookup (copies->index, target_file);
+  if (link != NULL)
+    thunar_thumbnail_cache_queue_remove (copies, link);
 
-  /* allocate a string array for the URIs */
-  source_uris = g_new0 (gchar *, n_uris + 1);
-  target_uris = g_new0 (gchar *, n_uris + 1);
-
-  /* fill URI array with file URIs from the move queue */
-  for (n = 0,
-       sp = g_list_last (source_queue),
-       tp = g_list_last (target_queue);
-       sp != NULL && tp != NULL;
-       sp = sp->prev, tp = tp->prev, ++n)
+  if (operation == THUNAR_THUMBNAIL_CACHE_MOVE)
     {
-      source_uris[n] = g_file_get_uri (sp->data);
-      target_uris[n] = g_file_get_uri (tp->data);
-
-      /* release the source object */
-      g_object_unref (sp->data);
-    }
-
-  /* NULL-terminate the URI arrays */
-  source_uris[n] = NULL;
-  target_uris[n] = NULL;
+      /* a file that is moved again: A -> B, B -> C becomes A -> C */
+      link = g_hash_table_lookup (moves->index, source_file);
+      if (link != NULL)
+        {
+          item = link->data;
+          if (g_file_equal (item->source, target_file))
+            thunar_thumbnail_cache_queue_remove (moves, link);
+          else
+            thunar_thumbnail_cache_queue_retarget (moves, link, target_file);
+          thunar_thumbnail_cache_schedule (moves);
+          return;
+        }
 
-  if (copy_async)
-    {
-      /* asynchronously copy the thumbnails */
-      thunar_thumbnail_cache_copy_async (cache,
-                                         (const gchar **)source_uris,
-                                         (const gchar **)target_uris,
-                                         target_queue);
-    }
-  else
-    {
-      /* asynchronously move the thumbnails */
-      thunar_thumbnail_cache_move_async (cache,
-                                         (const gchar **)source_uris,
-                                         (const gchar **)target_uris,
-                                         target_queue);
+      /* a copy that is moved before it was sent: copy A -> B, move B -> C
+       * becomes copy A -> C */
+      link = g_hash_table_lookup (copies->index, source_file);
+      if (link != NULL)
+        {
+          thunar_thumbnail_cache_queue_retarget (copies, link, target_file);
+          thunar_thumbnail_cache_schedule (copies);
+          return;
+        }
     }
 
-  /* free the URI arrays */
-  g_strfreev (source_uris);
-  g_strfreev (target_uris);
-
-  /* release the move queue lists */
-  g_list_free (source_queue);
-
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
-
-  return FALSE;
-}
-
-
-
-static gboolean
-thunar_thumbnail_cache_process_move_queue (gpointer user_data)
-{
-  return thunar_thumbnail_cache_process_queue (user_data, FALSE);
+  thunar_thumbnail_cache_queue_push (queue, source_file, target_file);
+  thunar_thumbnail_cache_schedule (queue);
 }
 
 
 
 static void
-thunar_thumbnail_cache_process_move_queue_destroy (gpointer user_data)
+thunar_thumbnail_cache_reply (GObject      *object,
+                              GAsyncResult *res,
+                              gpointer      user_data)
 {
-  THUNAR_THUMBNAIL_CACHE (user_data)->move_queue_idle_id = 0;
-}
-
+  ThunarThumbnailCacheDBus  *proxy = THUNAR_THUMBNAIL_CACHE_DBUS (object);
+  ThunarThumbnailCacheReply *reply = user_data;
+  ThunarThumbnailCacheQueue *queue = reply->queue;
+  ThunarThumbnailCache      *cache = queue->cache;
+  ThunarFile                *file;
+  const gchar               *method = NULL;
+  gboolean                   succeed = FALSE;
+  GError                    *error = NULL;
+  GList                     *li;
+
+  switch (queue->operation)
+    {
+    case THUNAR_THUMBNAIL_CACHE_MOVE:
+      method = "Move";
+      succeed = thunar_thumbnail_cache_dbus_call_move_finish (proxy, res, &error);
+      break;
+
+    case THUNAR_THUMBNAIL_CACHE_COPY:
+      method = "Copy";
+      succeed = thunar_thumbnail_cache_dbus_call_copy_finish (proxy, res, &error);
+      break;
+
+    case THUNAR_THUMBNAIL_CACHE_DELETE:
+      method = "Delete";
+      succeed = thunar_thumbnail_cache_dbus_call_delete_finish (proxy, res, &error);
+      break;
+
+    case THUNAR_THUMBNAIL_CACHE_CLEANUP:
+      method = "Cleanup";
+      succeed = thunar_thumbnail_cache_dbus_call_cleanup_finish (proxy, res, &error);
+      break;
+
+    default:
+      _thunar_assert_not_reached ();
+    }
 
+  if (!succeed)
+    g_printerr ("ThunarThumbnailCache: failed to call %s(): %s\n", method, error->message);
+  g_clear_error (&error);
 
-static gboolean
-thunar_thumbnail_cache_process_copy_queue (gpointer user_data)
-{
-  return thunar_thumbnail_cache_process_queue (user_data, TRUE);
-}
+  for (li = reply->targets; li != NULL; li = li->next)
+    {
+      file = thunar_file_cache_lookup (G_FILE (li->data));
 
+      if (G_LIKELY (file != NULL))
+        {
+          /* if visible, let the view know there might be a thumb */
+          thunar_file_changed (file);
+          g_object_unref (file);
+        }
+    }
 
+  /* send the items queued while this call was running */
+  _thumbnail_cache_lock (cache);
+  queue->in_flight = FALSE;
+  thunar_thumbnail_cache_schedule (queue);
+  _thumbnail_cache_unlock (cache);
 
-static void
-thunar_thumbnail_cache_process_copy_queue_destroy (gpointer user_data)
-{
-  THUNAR_THUMBNAIL_CACHE (user_data)->copy_queue_idle_id = 0;
+  g_list_free_full (reply->targets, g_object_unref);
+  g_slice_free (ThunarThumbnailCacheReply, reply);
+  g_object_unref (cache);
 }
 
 
 
 static gboolean
-thunar_thumbnail_cache_process_delete_queue (gpointer user_data)
+thunar_thumbnail_cache_process_queue (gpointer user_data)
 {
-  ThunarThumbnailCache *cache = user_data;
-  GList  *lp;
-  gchar **uris;
-  guint   n_uris;
-  guint   n;
+  ThunarThumbnailCacheQueue *queue = user_data;
+  ThunarThumbnailCache      *cache = queue->cache;
+  ThunarThumbnailCacheReply *reply;
+  ThunarThumbnailCacheItem  *item;
+  gchar                    **source_uris;
+  gchar                    **target_uris;
+  guint                      n_uris;
+  guint                      n;
 
   _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
 
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
-  /* compute how many URIs there are */
-  n_uris = g_list_length (cache->delete_queue);
+  queue->timeout_id = 0;
 
-  /* allocate a string array for the URIs */
-  uris = g_new0 (gchar *, n_uris + 1);
-
-  /* fill URI array with file URIs from the delete queue */
-  for (lp = g_list_last (cache->delete_queue), n = 0; lp != NULL; lp = lp->prev, ++n)
+  /* send at most one batch, the rest follows when the reply arrives */
+  n_uris = MIN (queue->items.length, THUNAR_THUMBNAIL_CACHE_BATCH_SIZE);
+  if (G_UNLIKELY (n_uris == 0 || queue->in_flight))
     {
-      uris[n] = g_file_get_uri (lp->data);
-
-      /* release the file object */
-      g_object_unref (lp->data);
+      _thumbnail_cache_unlock (cache);
+      return FALSE;
     }
 
-  /* NULL-terminate the URI array */
-  uris[n] = NULL;
-
-  /* asynchronously delete the thumbnails */
-  thunar_thumbnail_cache_delete_async (cache, (const gchar **)uris);
-
-  /* free the URI array */
-  g_strfreev (uris);
-
-  /* release the delete queue list */
-  g_list_free (cache->delete_queue);
-  cache->delete_queue = NULL;
-
-  /* reset the delete queue idle ID */
-  cache->delete_queue_idle_id = 0;
-
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
-
-  return FALSE;
-}
-
+  reply = g_slice_new0 (ThunarThumbnailCacheReply);
+  reply->queue = queue;
 
+  /* allocate string arrays for the URIs */
+  source_uris = g_new0 (gchar *, n_uris + 1);
+  target_uris = g_new0 (gchar *, n_uris + 1);
 
-static gboolean
-thunar_thumbnail_cache_process_cleanup_queue (gpointer user_data)
-{
-  ThunarThumbnailCache *cache = user_data;
-  GList  *lp;
-  gchar **uris;
-  guint   n_uris;
-  guint   n;
+  /* fill the URI arrays in the order the items were queued */
+  for (n = 0; n < n_uris; ++n)
+    {
+      item = g_queue_pop_head (&queue->items);
+      g_hash_table_remove (queue->index, thunar_thumbnail_cache_item_key (item));
 
-  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
+      source_uris[n] = g_file_get_uri (item->source);
+      if (item->target != NULL)
+        {
+          target_uris[n] = g_file_get_uri (item->target);
 
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
+          /* the reply notifies the targets */
+          reply->targets = g_list_prepend (reply->targets, g_object_ref (item->target));
+        }
 
-  /* compute how many URIs there are */
-  n_uris = g_list_length (cache->cleanup_queue);
+      thunar_thumbnail_cache_item_free (item);
+    }
 
-  /* allocate a string array for the URIs */
-  uris = g_new0 (gchar *, n_uris + 1);
+  queue->in_flight = TRUE;
 
-#ifndef NDEBUG
-  g_debug ("cleanup:");
-#endif
+  /* keep the cache alive until the reply arrives */
+  g_object_ref (cache);
 
-  /* fill URI array with file URIs from the cleanup queue */
-  for (lp = g_list_last (cache->cleanup_queue), n = 0; lp != NULL; lp = lp->prev, ++n)
+  /* request a thumbnail cache update asynchronously */
+  switch (queue->operation)
     {
-      uris[n] = g_file_get_uri (lp->data);
-
+    case THUNAR_THUMBNAIL_CACHE_MOVE:
+      thunar_thumbnail_cache_dbus_call_move (cache->cache_proxy,
+                                             (const gchar **) source_uris,
+                                             (const gchar **) target_uris,
+                                             NULL, thunar_thumbnail_cache_reply, reply);
+      break;
+
+    case THUNAR_THUMBNAIL_CACHE_COPY:
+      thunar_thumbnail_cache_dbus_call_copy (cache->cache_proxy,
+                                             (const gchar **) source_uris,
+                                             (const gchar **) target_uris,
+                                             NULL, thunar_thumbnail_cache_reply, reply);
+      break;
+
+    case THUNAR_THUMBNAIL_CACHE_DELETE:
+      thunar_thumbnail_cache_dbus_call_delete (cache->cache_proxy,
+                                               (const gchar **) source_uris,
+                                               NULL, thunar_thumbnail_cache_reply, reply);
+      break;
+
+    case THUNAR_THUMBNAIL_CACHE_CLEANUP:
 #ifndef NDEBUG
-      g_debug ("  %s", uris[n]);
+      g_debug ("cleanup:");
+      for (n = 0; source_uris[n] != NULL; ++n)
+        g_debug ("  %s", source_uris[n]);
 #endif
 
-      /* release the file object */
-      g_object_unref (lp->data);
+      thunar_thumbnail_cache_dbus_call_cleanup (cache->cache_proxy,
+                                                (const gchar **) source_uris, 0,
+                                                NULL, thunar_thumbnail_cache_reply, reply);
+      break;
+
+    default:
+      _thunar_assert_not_reached ();
     }
 
-  /* NULL-terminate the URI array */
-  uris[n] = NULL;
+  /* free the URI arrays */
+  g_strfreev (source_uris);
+  g_strfreev (target_uris);
 
-  /* asynchronously cleanup the thumbnails */
-  thunar_thumbnail_cache_cleanup_async (cache, (const gchar *const *)uris);
+  /* release the cache lock */
+  _thumbnail_cache_unlock (cache);
 
-  /* free the URI array */
-  g_strfreev (uris);
+  return FALSE;
+}
 
-  /* release the cleanup queue list */
-  g_list_free (cache->cleanup_queue);
-  cache->cleanup_queue = NULL;
 
-  /* reset the cleanup queue idle ID */
-  cache->cleanup_queue_idle_id = 0;
 
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+/* must be called with the cache lock held */
+static void
+thunar_thumbnail_cache_schedule (ThunarThumbnailCacheQueue *queue)
+{
+  guint delay;
 
-  return FALSE;
+  /* wait for the proxy or for the running call */
+  if (queue->cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE
+      || queue->in_flight
+      || queue->items.length == 0)
+    return;
+
+  /* cancel any pending timeout to process the queue */
+  if (queue->timeout_id > 0)
+    g_source_remove (queue->timeout_id);
+
+  /* send full batches right away, wait for more items otherwise */
+  if (queue->items.length >= THUNAR_THUMBNAIL_CACHE_BATCH_SIZE)
+    delay = 0;
+  else
+    delay = thunar_thumbnail_cache_delays[queue->operation];
+
+  queue->timeout_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, delay,
+                                          thunar_thumbnail_cache_process_queue,
+                                          queue, NULL);
 }
 
 
@@ -540,25 +559,8 @@ thunar_thumbnail_cache_move_file (ThunarThumbnailCache *cache,
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
       /* add the files to the move queue */
-      cache->move_source_queue = g_list_prepend (cache->move_source_queue,
-                                                 g_object_ref (source_file));
-      cache->move_target_queue = g_list_prepend (cache->move_target_queue,
-                                                 g_object_ref (target_file));
-    }
-
-  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
-    {
-      /* cancel any pending timeout to process the move queue */
-      if (cache->move_queue_idle_id > 0)
-        {
-          g_source_remove (cache->move_queue_idle_id);
-          cache->move_queue_idle_id = 0;
-        }
-
-      /* process the move queue in a 250ms timeout */
-      cache->move_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 250, thunar_thumbnail_cache_process_move_queue,
-                            cache, thunar_thumbnail_cache_process_move_queue_destroy);
+      thunar_thumbnail_cache_queue_transfer (cache, THUNAR_THUMBNAIL_CACHE_MOVE,
+                                             source_file, target_file);
     }
 
   /* release the cache lock */
@@ -582,26 +584,9 @@ thunar_thumbnail_cache_copy_file (ThunarThumbnailCache *cache,
   /* check if we have a valid proxy for the cache service */
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
-      /* add the files to the copy queues */
-      cache->copy_source_queue = g_list_prepend (cache->copy_source_queue,
-                                                 g_object_ref (source_file));
-      cache->copy_target_queue = g_list_prepend (cache->copy_target_queue,
-                                                 g_object_ref (target_file));
-    }
-
-  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
-    {
-      /* cancel any pending timeout to process the copy queue */
-      if (cache->copy_queue_idle_id > 0)
-        {
-          g_source_remove (cache->copy_queue_idle_id);
-          cache->copy_queue_idle_id = 0;
-        }
-
-      /* process the copy queue in a 250ms timeout */
-      cache->copy_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 500, thunar_thumbnail_cache_process_copy_queue,
-                            cache, thunar_thumbnail_cache_process_copy_queue_destroy);
+      /* add the files to the copy queue */
+      thunar_thumbnail_cache_queue_transfer (cache, THUNAR_THUMBNAIL_CACHE_COPY,
+                                             source_file, target_file);
     }
 
   /* release the cache lock */
@@ -614,6 +599,10 @@ void
 thunar_thumbnail_cache_delete_file (ThunarThumbnailCache *cache,
                                     GFile                *file)
 {
+  ThunarThumbnailCacheQueue *queue;
+  ThunarThumbnailCacheItem  *item;
+  GList                     *link;
+
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
   _thunar_return_if_fail (G_IS_FILE (file));
 
@@ -623,22 +612,25 @@ thunar_thumbnail_cache_delete_file (ThunarThumbnailCache *cache,
   /* check if we have a valid proxy for the cache service */
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
-      /* add the file to the delete queue */
-      cache->delete_queue = g_list_prepend (cache->delete_queue, g_object_ref (file));
-    }
-
-  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
-    {
-      /* cancel any pending timeout to process the delete queue */
-      if (cache->delete_queue_idle_id > 0)
+      /* a file moved here before is deleted: the thumbnail is still
+       * stored for the source of the move */
+      queue = &cache->queues[THUNAR_THUMBNAIL_CACHE_MOVE];
+      link = g_hash_table_lookup (queue->index, file);
+      if (link != NULL)
         {
-          g_source_remove (cache->delete_queue_idle_id);
-          cache->delete_queue_idle_id = 0;
+          item = link->data;
+          thunar_thumbnail_cache_queue_delete (cache, item->source);
+          thunar_thumbnail_cache_queue_remove (queue, link);
         }
 
-      /* process the delete queue in a 250ms timeout */
-      cache->delete_queue_idle_id =
-        g_timeout_add (500, thunar_thumbnail_cache_process_delete_queue, cache);
+      /* a file copied here before is deleted: drop the copy */
+      queue = &cache->queues[THUNAR_THUMBNAIL_CACHE_COPY];
+      link = g_hash_table_lookup (queue->index, file);
+      if (link != NULL)
+        thunar_thumbnail_cache_queue_remove (queue, link);
+
+      /* add the file to the delete queue */
+      thunar_thumbnail_cache_queue_delete (cache, file);
     }
 
   /* release the cache lock */
@@ -651,6 +643,8 @@ void
 thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
                                      GFile                *file)
 {
+  ThunarThumbnailCacheQueue *queue;
+
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
   _thunar_return_if_fail (G_IS_FILE (file));
 
@@ -661,21 +655,12 @@ thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
       /* add the file to the cleanup queue */
-      cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (file));
-    }
-
-  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
-    {
-      /* cancel any pending timeout to process the cleanup queue */
-      if (cache->cleanup_queue_idle_id > 0)
+      queue = &cache->queues[THUNAR_THUMBNAIL_CACHE_CLEANUP];
+      if (!g_hash_table_contains (queue->index, file))
         {
-          g_source_remove (cache->cleanup_queue_idle_id);
-          cache->cleanup_queue_idle_id = 0;
+          thunar_thumbnail_cache_queue_push (queue, file, NULL);
+          thunar_thumbnail_cache_schedule (queue);
         }
-
-      /* process the cleanup queue in a 250ms timeout */
-      cache->cleanup_queue_idle_id =
-        g_timeout_add (1000, thunar_thumbnail_cache_process_cleanup_queue, cache);
     }
 
   /* release the cache lock */
@@ -692,6 +677,7 @@ thunar_thumbnail_cache_proxy_created (GObject      *source,
   ThunarThumbnailCache     *cache = THUNAR_THUMBNAIL_CACHE (userdata);
   ThunarThumbnailCacheDBus *proxy;
   GError                   *error = NULL;
+  guint                     n;
 
   _thumbnail_cache_lock (cache);
 
@@ -699,6 +685,10 @@ thunar_thumbnail_cache_proxy_created (GObject      *source,
     {
       cache->cache_proxy = proxy;
       cache->proxy_state = THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE;
+
+      /* process the items queued while we were waiting */
+      for (n = 0; n < THUNAR_THUMBNAIL_CACHE_N_OPERATIONS; ++n)
+        thunar_thumbnail_cache_schedule (&cache->queues[n]);
     }
   else
     {
@@ -709,28 +699,6 @@ thunar_thumbnail_cache_proxy_created (GObject      *source,
 
   g_clear_error (&error);
 
-  /* process the move queue in a 250ms timeout */
-  if (cache->move_source_queue)
-      cache->move_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 250, thunar_thumbnail_cache_process_move_queue,
-                            cache, thunar_thumbnail_cache_process_move_queue_destroy);
-
-  /* process the copy queue in a 250ms timeout */
-  if (cache->copy_source_queue)
-      cache->copy_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 500, thunar_thumbnail_cache_process_copy_queue,
-                            cache, thunar_thumbnail_cache_process_copy_queue_destroy);
-
-  /* process the delete queue in a 250ms timeout */
-  if (cache->delete_queue)
-      cache->delete_queue_idle_id =
-        g_timeout_add (500, thunar_thumbnail_cache_process_delete_queue, cache);
-
-  /* process the cleanup queue in a 250ms timeout */
-  if (cache->cleanup_queue)
-      cache->cleanup_queue_idle_id =
-        g_timeout_add (1000, thunar_thumbnail_cache_process_cleanup_queue, cache);
-
   _thumbnail_cache_unlock (cache);
 
   /* drop additional reference */
@@ -742,9 +710,20 @@ thunar_thumbnail_cache_proxy_created (GObject      *source,
 static void
 thunar_thumbnail_cache_init (ThunarThumbnailCache *cache)
 {
+  guint n;
+
   /* create a new mutex for accessing the cache from different threads */
   g_mutex_init (&cache->lock);
 
+  /* setup the operation queues */
+  for (n = 0; n < THUNAR_THUMBNAIL_CACHE_N_OPERATIONS; ++n)
+    {
+      cache->queues[n].cache = cache;
+      cache->queues[n].operation = n;
+      cache->queues[n].index = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+      g_queue_init (&cache->queues[n].items);
+    }
+
   /* add an additional reference to keep us alive while tre proxy initializes */
   g_object_ref (cache);
 
@@ -758,5 +737,3 @@ thunar_thumbnail_cache_init (ThunarThumbnailCache *cache)
                                                  thunar_thumbnail_cache_proxy_created,
                                                  cache);
 }
-
-
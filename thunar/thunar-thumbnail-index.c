@@ -0,0 +1,281 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <thunar/thunar-thumbnail-index.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The thumbnail index keeps the names of the files in each thumbnail
+ * directory in memory, so checking whether a thumbnail exists does not
+ * stat the file in the cache directory, which is slow on network homes.
+ *
+ * A directory is read asynchronously the first time it is used and a
+ * file monitor keeps the names up to date afterwards. Until a directory
+ * has been read completely, the file system is asked directly.
+ */
+#define THUMBNAIL_INDEX_BATCH_SIZE (256)
+
+
+
+typedef struct
+{
+  GFile        *file;
+  GHashTable   *names;
+  GFileMonitor *monitor;
+  GCancellable *cancellable;
+  gboolean      loaded;
+}
+ThumbnailDirectory;
+
+
+
+static void thunar_thumbnail_index_next_files (GObject      *object,
+                                               GAsyncResult *result,
+                                               gpointer      user_data);
+
+
+
+/* the indexed directories, only used from the main thread */
+static GHashTable *thumbnail_directories = NULL;
+
+
+
+static void
+thunar_thumbnail_index_remove (ThumbnailDirectory *directory,
+                               GFile              *file)
+{
+  gchar *name;
+
+  name = g_file_get_basename (file);
+  g_hash_table_remove (directory->names, name);
+  g_free (name);
+}
+
+
+
+static void
+thunar_thumbnail_index_changed (GFileMonitor       *monitor,
+                                GFile              *file,
+                                GFile              *other_file,
+                                GFileMonitorEvent   event_type,
+                                ThumbnailDirectory *directory)
+{
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+      g_hash_table_add (directory->names, g_file_get_basename (file));
+      break;
+
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+      thunar_thumbnail_index_remove (directory, file);
+      break;
+
+    case G_FILE_MONITOR_EVENT_RENAMED:
+      /* thumbnailers write a temporary file and rename it */
+      thunar_thumbnail_index_remove (directory, file);
+      if (other_file != NULL)
+        g_hash_table_add (directory->names, g_file_get_basename (other_file));
+      break;
+
+    default:
+      break;
+    }
+}
+
+
+
+static void
+thunar_thumbnail_index_next_files (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  GFileEnumerator    *enumerator = G_FILE_ENUMERATOR (object);
+  ThumbnailDirectory *directory = user_data;
+  GError             *error = NULL;
+  GList              *infos;
+  GList              *lp;
+
+  infos = g_file_enumerator_next_files_finish (enumerator, result, &error);
+  if (infos == NULL)
+    {
+      /* the directory is complete unless reading it failed */
+      if (G_LIKELY (error == NULL))
+        directory->loaded = TRUE;
+      else
+        g_error_free (error);
+
+      g_object_unref (enumerator);
+      return;
+    }
+
+  for (lp = infos; lp != NULL; lp = lp->next)
+    {
+      g_hash_table_add (directory->names, g_strdup (g_file_info_get_name (lp->data)));
+      g_object_unref (lp->data);
+    }
+  g_list_free (infos);
+
+  g_file_enumerator_next_files_async (enumerator, THUMBNAIL_INDEX_BATCH_SIZE,
+                                      G_PRIORITY_LOW, directory->cancellable,
+                                      thunar_thumbnail_index_next_files, directory);
+}
+
+
+
+static void
+thunar_thumbnail_index_enumerated (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  ThumbnailDirectory *directory = user_data;
+  GFileEnumerator    *enumerator;
+
+  enumerator = g_file_enumerate_children_finish (G_FILE (object), result, NULL);
+
+  /* without a directory the file system is always asked, if the index
+   * was cleared in the meantime, the directory is already gone */
+  if (G_UNLIKELY (enumerator == NULL))
+    return;
+
+  g_file_enumerator_next_files_async (enumerator, THUMBNAIL_INDEX_BATCH_SIZE,
+                                      G_PRIORITY_LOW, directory->cancellable,
+                                      thunar_thumbnail_index_next_files, directory);
+}
+
+
+
+static void
+thunar_thumbnail_index_free_directory (gpointer data)
+{
+  ThumbnailDirectory *directory = data;
+
+  /* a pending enumeration fails once cancelled and leaves the directory alone */
+  g_cancellable_cancel (directory->cancellable);
+  g_object_unref (directory->cancellable);
+
+  if (directory->monitor != NULL)
+    {
+      g_signal_handlers_disconnect_matched (directory->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, directory);
+      g_file_monitor_cancel (directory->monitor);
+      g_object_unref (directory->monitor);
+    }
+
+  g_hash_table_destroy (directory->names);
+  g_object_unref (directory->file);
+  g_slice_free (ThumbnailDirectory, directory);
+}
+
+
+
+static ThumbnailDirectory *
+thunar_thumbnail_index_get_directory (const gchar *path)
+{
+  ThumbnailDirectory *directory;
+
+  if (G_UNLIKELY (thumbnail_directories == NULL))
+    thumbnail_directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                   thunar_thumbnail_index_free_directory);
+
+  directory = g_hash_table_lookup (thumbnail_directories, path);
+  if (G_LIKELY (directory != NULL))
+    return directory;
+
+  directory = g_slice_new0 (ThumbnailDirectory);
+  directory->file = g_file_new_for_path (path);
+  directory->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  directory->cancellable = g_cancellable_new ();
+  g_hash_table_insert (thumbnail_directories, g_strdup (path), directory);
+
+  /* watch the directory before reading it, so no thumbnail is missed */
+  directory->monitor = g_file_monitor_directory (directory->file, G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+  if (G_LIKELY (directory->monitor != NULL))
+    {
+      g_signal_connect (directory->monitor, "changed",
+                        G_CALLBACK (thunar_thumbnail_index_changed), directory);
+
+      g_file_enumerate_children_async (directory->file, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, G_PRIORITY_LOW,
+                                       directory->cancellable,
+                                       thunar_thumbnail_index_enumerated, directory);
+    }
+
+  return directory;
+}
+
+
+
+/**
+ * thunar_thumbnail_index_contains:
+ * @path : the absolute path of a thumbnail.
+ *
+ * Checks whether the thumbnail @path exists. Once the directory of @path
+ * has been indexed, this is answered from memory.
+ *
+ * This function may only be used from the main thread.
+ *
+ * Return value: %TRUE if the thumbnail exists.
+ **/
+gboolean
+thunar_thumbnail_index_contains (const gchar *path)
+{
+  ThumbnailDirectory *directory;
+  const gchar        *basename;
+  gchar              *dirname;
+
+  _thunar_return_val_if_fail (path != NULL && g_path_is_absolute (path), FALSE);
+
+  basename = strrchr (path, G_DIR_SEPARATOR);
+  dirname = g_strndup (path, basename - path);
+  directory = thunar_thumbnail_index_get_directory (dirname);
+  g_free (dirname);
+
+  if (G_LIKELY (directory->loaded))
+    return g_hash_table_contains (directory->names, basename + 1);
+
+  return g_file_test (path, G_FILE_TEST_EXISTS);
+}
+
+
+
+/**
+ * thunar_thumbnail_index_clear:
+ *
+ * Forgets all indexed thumbnail directories to release their memory.
+ * They are indexed again the next time they are used.
+ **/
+void
+thunar_thumbnail_index_clear (void)
+{
+  if (thumbnail_directories != NULL)
+    g_hash_table_remove_all (thumbnail_directories);
+}
@@ -23,10 +23,18 @@
 #include <config.h>
 #endif
 
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-counters.h>
 #include <thunar/thunar-thumbnailer-proxy.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-recorder.h>
+#include <thunar/thunar-thumbnail-budget.h>
+#include <thunar/thunar-thumbnail-index.h>
 #include <thunar/thunar-thumbnailer.h>
+#include <thunar/thunar-trace.h>
+#include <thunar/thunar-watchdog.h>
 
 
 
@@ -46,14 +54,21 @@
  * that arrive beforehand will be cached and sent out as soon as the initialization
  * is completed.
  *
- * When a request call is sent out, an internal request ID is created and tied
- * to the dbus call. While the call is running, an additional reference is held
- * to the thumbnailer so it cannot be finalized.
+ * When a request is queued, an internal request ID is created for it and its
+ * files are added to a batch, which collects the requests of all views and
+ * windows until the main loop is idle, or until the batch is full. The batch
+ * is then sent out with a single Queue call. While the call is running, an
+ * additional reference is held to the thumbnailer so it cannot be finalized.
+ *
+ * The size of the batches adapts to the time the D-Bus thumbnailer needs per
+ * file, so a batch is finished within about THUNAR_THUMBNAILER_BATCH_TIME and
+ * views still get their thumbnails early.
  *
  * The D-Bus reply handler then checks if there was an delivery error or
  * not. If the request method was sent successfully, the handle returned by the
- * D-Bus thumbnailer is associated bidirectionally with the internal request ID via
- * the request and handle values in the job structure.
+ * D-Bus thumbnailer is stored in the batch, which knows the requests it
+ * contains. A dequeued request is dropped from its batch, the batch itself
+ * is only dequeued once none of its requests is left.
  *
  *
  * Ready / Error
@@ -63,17 +78,55 @@
  * the Ready idle function sets the thumb state of the corresponding
  * ThunarFile objects to _READY and the Error signal sets the state to _NONE.
  *
+ * The thumbnails themselves are not transferred over D-Bus. The
+ * org.freedesktop.thumbnails.Thumbnailer1 interface only reports the URIs
+ * whose PNG was written to the thumbnail cache, so the PNG is always read
+ * back from disk. Views load it through
+ * thunar_icon_factory_load_file_icon_deferred(), which decodes it in a
+ * worker thread, so the round trip does not block the user interface.
+ *
  *
  * Finished
  * ========
  *
- * The Finished signal handler looks up the internal request ID based on
- * the D-Bus thumbnailer handle. It then drops all corresponding information
- * from handle_request_mapping and request_handle_mapping.
+ * The Finished signal handler looks up the batch based on the D-Bus
+ * thumbnailer handle and finishes all the requests it contains.
+ *
+ *
+ * Failures
+ * ========
+ *
+ * Files the D-Bus thumbnailer failed on are recorded in the fail directory
+ * of the thumbnail specification, $XDG_CACHE_HOME/thumbnails/fail/thunar-VERSION,
+ * and are not queued again until they are modified or Thunar is updated.
+ *
+ *
+ * Budget
+ * ======
+ *
+ * With THUNAR_THUMBNAIL_MODE_BUDGETED, every remote file is checked against
+ * the read budget of its share before it is queued, see
+ * thunar-thumbnail-budget.c. Files that do not fit in yet are deferred and
+ * queued again with the background scheduler once the budget was refilled.
  */
 
 
 
+/* time the D-Bus thumbnailer should need for one batch */
+#define THUNAR_THUMBNAILER_BATCH_TIME (G_USEC_PER_SEC / 2)
+
+/* limits and initial value of the number of files in one batch */
+#define THUNAR_THUMBNAILER_BATCH_SIZE_MIN     (16)
+#define THUNAR_THUMBNAILER_BATCH_SIZE_MAX     (1024)
+#define THUNAR_THUMBNAILER_BATCH_SIZE_DEFAULT (128)
+
+/* interval in milliseconds to retry the files deferred by the budget,
+ * and the maximum number of files that are deferred */
+#define THUNAR_THUMBNAILER_DEFERRED_INTERVAL (250)
+#define THUNAR_THUMBNAILER_DEFERRED_MAX      (4096)
+
+
+
 typedef enum
 {
   THUNAR_THUMBNAILER_IDLE_ERROR,
@@ -91,8 +144,10 @@ typedef enum
 
 
 
-typedef struct _ThunarThumbnailerJob  ThunarThumbnailerJob;
-typedef struct _ThunarThumbnailerIdle ThunarThumbnailerIdle;
+typedef struct _ThunarThumbnailerBatch ThunarThumbnailerBatch;
+typedef struct _ThunarThumbnailerFail  ThunarThumbnailerFail;
+typedef struct _ThunarThumbnailerJob   ThunarThumbnailerJob;
+typedef struct _ThunarThumbnailerIdle  ThunarThumbnailerIdle;
 
 /* Signal identifiers */
 enum
@@ -111,6 +166,16 @@ enum
 
 static void                   thunar_thumbnailer_finalize               (GObject                    *object);
 static void                   thunar_thumbnailer_init_thumbnailer_proxy (ThunarThumbnailer          *thumbnailer);
+static void                   thunar_thumbnailer_batch_flush            (ThunarThumbnailerBatch     *batch);
+static gboolean               thunar_thumbnailer_batch_flush_idle       (gpointer                    user_data);
+static void                   thunar_thumbnailer_defer_file             (ThunarThumbnailer          *thumbnailer,
+                                                                         ThunarFile                 *file);
+static gboolean               thunar_thumbnailer_deferred_timer         (gpointer                    user_data);
+static gboolean               thunar_thumbnailer_queue_job              (ThunarThumbnailer          *thumbnailer,
+                                                                         gboolean                    lazy_checks,
+                                                                         gboolean                    prefetch,
+                                                                         GList                      *files,
+                                                                         guint                      *request);
 static gboolean               thunar_thumbnailer_file_is_supported      (ThunarThumbnailer          *thumbnailer,
                                                                          ThunarFile                 *file);
 static void                   thunar_thumbnailer_thumbnailer_finished   (GDBusProxy                 *proxy,
@@ -163,9 +228,26 @@ struct _ThunarThumbnailer
   /* running jobs */
   GSList     *jobs;
 
+  /* batches collecting the files of new jobs, for the foreground
+   * and the background scheduler of the D-Bus thumbnailer */
+  ThunarThumbnailerBatch *pending[2];
+  guint                   flush_idle_id;
+
+  /* batches sent to the D-Bus thumbnailer */
+  GSList     *batches;
+
+  /* files that exceeded the budget of their share, and the
+   * timer source that queues them again */
+  GHashTable *deferred;
+  guint       deferred_timer_id;
+
+  /* adaptive batch size and the average time needed per file */
+  guint       batch_size;
+  gint64      file_time;
+
   GMutex      lock;
 
-  /* cached MIME types -> URI schemes for which thumbs can be generated */
+  /* URI schemes -> set of MIME types for which thumbs can be generated */
   GHashTable *supported;
 
   /* last ThunarThumbnailer request ID */
@@ -178,24 +260,51 @@ struct _ThunarThumbnailer
   GSList     *idles;
 };
 
-struct _ThunarThumbnailerJob
+struct _ThunarThumbnailerBatch
 {
   ThunarThumbnailer *thumbnailer;
 
-  /* if this job is cancelled */
-  guint              cancelled : 1;
+  /* the jobs whose files are in this batch */
+  GSList            *jobs;
+  guint              n_files;
+
+  /* if the batch uses the background scheduler */
+  guint              prefetch : 1;
+
+  /* if the Queue call was sent */
+  guint              sent : 1;
+  gint64             queue_time;
+
+  /* handle returned by the tumbler dbus service */
+  guint              handle;
+};
+
+struct _ThunarThumbnailerJob
+{
+  ThunarThumbnailer *thumbnailer;
 
   guint              lazy_checks : 1;
 
-  /* data is saved here in case the queueing is delayed */
-  /* If this is NULL, the request has been sent off. */
+  /* if this job prefetches files near the visible range */
+  guint              prefetch : 1;
+
+  /* data is saved here in case the queueing is delayed, once the
+   * job is in a batch, only the supported files are left. If this
+   * is NULL, the request has been sent off. */
   GList             *files; /* element type: ThunarFile */
 
+  /* the batch the files of this job are sent with */
+  ThunarThumbnailerBatch *batch;
+
   /* request number returned by ThunarThumbnailer */
   guint              request;
+};
 
-  /* handle returned by the tumbler dbus service */
-  guint              handle;
+struct _ThunarThumbnailerFail
+{
+  gchar   *path;
+  gchar   *uri;
+  guint64  mtime;
 };
 
 struct _ThunarThumbnailerIdle
@@ -303,31 +412,116 @@ thunar_thumbnailer_set_property (GObject      *object,
 static void
 thunar_thumbnailer_free_job (ThunarThumbnailerJob *job)
 {
+  if (job->request != 0)
+    {
+      thunar_trace_async_end ("thumbnail", "thumbnail request", job);
+      thunar_counters_dec (THUNAR_COUNTER_THUMBNAIL_REQUESTS);
+    }
+
   if (job->files)
     g_list_free_full (job->files, g_object_unref);
 
-  if (job->thumbnailer && job->thumbnailer->thumbnailer_proxy && job->handle)
-    thunar_thumbnailer_dbus_call_dequeue (job->thumbnailer->thumbnailer_proxy, job->handle, NULL, NULL, NULL);
-
   g_slice_free (ThunarThumbnailerJob, job);
 }
 
 
 
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_batch_free (ThunarThumbnailerBatch *batch)
+{
+  ThunarThumbnailer *thumbnailer = batch->thumbnailer;
+
+  _thunar_assert (batch->jobs == NULL);
+
+  thumbnailer->batches = g_slist_remove (thumbnailer->batches, batch);
+  g_slice_free (ThunarThumbnailerBatch, batch);
+}
+
+
+
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_batch_finished (ThunarThumbnailerBatch *batch)
+{
+  ThunarThumbnailer    *thumbnailer = batch->thumbnailer;
+  ThunarThumbnailerJob *job;
+  GSList               *lp;
+
+  for (lp = batch->jobs; lp != NULL; lp = lp->next)
+    {
+      job = lp->data;
+      job->batch = NULL;
+
+      /* tell everybody we're done here */
+      g_signal_emit (G_OBJECT (thumbnailer), thumbnailer_signals[REQUEST_FINISHED], 0, job->request);
+
+      /* remove job from the list */
+      thumbnailer->jobs = g_slist_remove (thumbnailer->jobs, job);
+      thunar_thumbnailer_free_job (job);
+    }
+
+  g_slist_free (batch->jobs);
+  batch->jobs = NULL;
+
+  thunar_thumbnailer_batch_free (batch);
+}
+
+
+
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_batch_add (ThunarThumbnailer    *thumbnailer,
+                              ThunarThumbnailerJob *job,
+                              guint                 n_files)
+{
+  ThunarThumbnailerBatch *batch;
+
+  /* requests are never split, a batch that cannot take all the
+   * files of the job is sent before */
+  batch = thumbnailer->pending[job->prefetch];
+  if (batch != NULL && batch->n_files + n_files > thumbnailer->batch_size)
+    {
+      thunar_thumbnailer_batch_flush (batch);
+      batch = NULL;
+    }
+
+  if (batch == NULL)
+    {
+      batch = g_slice_new0 (ThunarThumbnailerBatch);
+      batch->thumbnailer = thumbnailer;
+      batch->prefetch = job->prefetch;
+      thumbnailer->pending[job->prefetch] = batch;
+    }
+
+  batch->jobs = g_slist_prepend (batch->jobs, job);
+  batch->n_files += n_files;
+  job->batch = batch;
+
+  /* send full batches right away, the others once the requests of
+   * all views are in */
+  if (batch->n_files >= thumbnailer->batch_size)
+    thunar_thumbnailer_batch_flush (batch);
+  else if (thumbnailer->flush_idle_id == 0)
+    thumbnailer->flush_idle_id = g_idle_add (thunar_thumbnailer_batch_flush_idle, thumbnailer);
+}
+
+
+
 static void
 thunar_thumbnailer_queue_async_reply (GObject      *proxy,
                                       GAsyncResult *res,
                                       gpointer      user_data)
 {
-  ThunarThumbnailerJob *job = user_data;
-  ThunarThumbnailer    *thumbnailer;
-  GError               *error = NULL;
-  guint                 handle;
+  ThunarThumbnailerBatch *batch = user_data;
+  ThunarThumbnailer      *thumbnailer;
+  GError                 *error = NULL;
+  guint                   handle = 0;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER_DBUS (proxy));
-  _thunar_return_if_fail (job != NULL);
+  _thunar_return_if_fail (batch != NULL);
 
-  thumbnailer = THUNAR_THUMBNAILER (job->thumbnailer);
+  thumbnailer = THUNAR_THUMBNAILER (batch->thumbnailer);
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
 
@@ -335,30 +529,29 @@ thunar_thumbnailer_queue_async_reply (GObject      *proxy,
 
   thunar_thumbnailer_dbus_call_queue_finish (THUNAR_THUMBNAILER_DBUS (proxy), &handle, res, &error);
 
-  if (job->cancelled)
+  if (batch->jobs == NULL)
     {
-      /* job is cancelled while there was no handle jet, so dequeue it now */
-      thunar_thumbnailer_dbus_call_dequeue (THUNAR_THUMBNAILER_DBUS (proxy), handle, NULL, NULL, NULL);
+      /* all jobs were cancelled while there was no handle yet, so dequeue it now */
+      if (error == NULL && handle != 0)
+        thunar_thumbnailer_dbus_call_dequeue (THUNAR_THUMBNAILER_DBUS (proxy), handle, NULL, NULL, NULL);
 
       /* cleanup */
-      thumbnailer->jobs = g_slist_remove (thumbnailer->jobs, job);
-      thunar_thumbnailer_free_job (job);
+      thunar_thumbnailer_batch_free (batch);
     }
-  else if (error == NULL)
+  else if (error == NULL && handle != 0)
     {
-      if (handle == 0)
-        {
-          g_printerr ("ThunarThumbnailer: got 0 handle (Queue)\n");
-        }
-      else
-        {
-          /* store the handle returned by tumbler */
-          job->handle = handle;
-        }
+      /* store the handle returned by tumbler */
+      batch->handle = handle;
     }
   else
     {
-      g_printerr ("ThunarThumbnailer: Queue failed: %s\n", error->message);
+      if (error != NULL)
+        g_printerr ("ThunarThumbnailer: Queue failed: %s\n", error->message);
+      else
+        g_printerr ("ThunarThumbnailer: got 0 handle (Queue)\n");
+
+      /* tumbler will never finish the batch */
+      thunar_thumbnailer_batch_finished (batch);
     }
 
   _thumbnailer_unlock (thumbnailer);
@@ -370,21 +563,270 @@ thunar_thumbnailer_queue_async_reply (GObject      *proxy,
 
 
 
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_batch_flush (ThunarThumbnailerBatch *batch)
+{
+  ThunarThumbnailer    *thumbnailer = batch->thumbnailer;
+  ThunarThumbnailerJob *job;
+  const gchar         **mime_hints;
+  gchar               **uris;
+  GSList               *lp;
+  GList                *fp;
+  guint                 n = 0;
+
+  /* new jobs go to a new batch */
+  thumbnailer->pending[batch->prefetch] = NULL;
+
+  /* all jobs were dequeued before it was sent */
+  if (batch->jobs == NULL)
+    {
+      g_slice_free (ThunarThumbnailerBatch, batch);
+      return;
+    }
+
+  /* allocate arrays for URIs and mime hints */
+  uris = g_new0 (gchar *, batch->n_files + 1);
+  mime_hints = g_new0 (const gchar *, batch->n_files + 1);
+
+  /* fill URI and MIME hint arrays with the files of all jobs */
+  for (lp = batch->jobs; lp != NULL; lp = lp->next)
+    {
+      job = lp->data;
+      for (fp = job->files; fp != NULL && n < batch->n_files; fp = fp->next, ++n)
+        {
+          uris[n] = thunar_file_dup_uri (fp->data);
+          mime_hints[n] = thunar_file_get_content_type (fp->data);
+        }
+    }
+
+  batch->n_files = n;
+  batch->sent = TRUE;
+  batch->queue_time = g_get_monotonic_time ();
+  thumbnailer->batches = g_slist_prepend (thumbnailer->batches, batch);
+
+  /* increase the reference count while the dbus call is running */
+  g_object_ref (thumbnailer);
+
+  /* queue the request - asynchronously, of course */
+  thunar_thumbnailer_dbus_call_queue (thumbnailer->thumbnailer_proxy,
+                                      (const gchar *const *)uris,
+                                      (const gchar *const *)mime_hints,
+                                      thunar_thumbnail_size_get_nick (thumbnailer->thumbnail_size),
+                                      batch->prefetch ? "background" : "foreground", 0,
+                                      NULL,
+                                      thunar_thumbnailer_queue_async_reply,
+                                      batch);
+
+  /* free mime hints array */
+  g_free (mime_hints);
+  g_strfreev (uris);
+
+  /* the files of the jobs were sent off */
+  for (lp = batch->jobs; lp != NULL; lp = lp->next)
+    {
+      job = lp->data;
+      g_list_free_full (job->files, g_object_unref);
+      job->files = NULL;
+    }
+}
+
+
+
+static gboolean
+thunar_thumbnailer_batch_flush_idle (gpointer user_data)
+{
+  ThunarThumbnailer *thumbnailer = THUNAR_THUMBNAILER (user_data);
+  guint              n;
+
+  _thumbnailer_lock (thumbnailer);
+
+  thumbnailer->flush_idle_id = 0;
+
+  for (n = 0; n < G_N_ELEMENTS (thumbnailer->pending); ++n)
+    if (thumbnailer->pending[n] != NULL)
+      thunar_thumbnailer_batch_flush (thumbnailer->pending[n]);
+
+  _thumbnailer_unlock (thumbnailer);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_defer_file (ThunarThumbnailer *thumbnailer,
+                               ThunarFile        *file)
+{
+  if (G_UNLIKELY (thumbnailer->deferred == NULL))
+    thumbnailer->deferred = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+  /* the files beyond the limit keep their thumb state, so the
+   * views ask for them again */
+  if (g_hash_table_size (thumbnailer->deferred) < THUNAR_THUMBNAILER_DEFERRED_MAX
+      && !g_hash_table_contains (thumbnailer->deferred, file))
+    g_hash_table_add (thumbnailer->deferred, g_object_ref (file));
+
+  if (thumbnailer->deferred_timer_id == 0)
+    {
+      thumbnailer->deferred_timer_id = g_timeout_add (THUNAR_THUMBNAILER_DEFERRED_INTERVAL,
+                                                      thunar_thumbnailer_deferred_timer, thumbnailer);
+    }
+}
+
+
+
+static gboolean
+thunar_thumbnailer_deferred_timer (gpointer user_data)
+{
+  ThunarThumbnailer *thumbnailer = THUNAR_THUMBNAILER (user_data);
+  GList             *files;
+
+  _thumbnailer_lock (thumbnailer);
+
+  thumbnailer->deferred_timer_id = 0;
+
+  /* take over the references of the deferred files */
+  files = g_hash_table_get_keys (thumbnailer->deferred);
+  g_hash_table_steal_all (thumbnailer->deferred);
+
+  _thumbnailer_unlock (thumbnailer);
+
+  /* queue them in the background, the files that still do
+   * not fit into the budget are deferred again */
+  if (G_LIKELY (files != NULL))
+    thunar_thumbnailer_queue_job (thumbnailer, TRUE, TRUE, files, NULL);
+
+  g_list_free_full (files, g_object_unref);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static gchar *
+thunar_thumbnailer_fail_path (const gchar *uri)
+{
+  gchar *checksum;
+  gchar *filename;
+  gchar *path;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  filename = g_strconcat (checksum, ".png", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "thumbnails", "fail",
+                           PACKAGE_NAME "-" PACKAGE_VERSION, filename, NULL);
+  g_free (filename);
+  g_free (checksum);
+
+  return path;
+}
+
+
+
+static gboolean
+thunar_thumbnailer_file_failed (ThunarFile *file)
+{
+  struct stat statb;
+  gboolean    failed = FALSE;
+  gchar      *path;
+  gchar      *uri;
+
+  uri = thunar_file_dup_uri (file);
+  path = thunar_thumbnailer_fail_path (uri);
+  g_free (uri);
+
+  /* the failure only counts if the file was not modified afterwards */
+  if (thunar_thumbnail_index_contains (path)
+      && g_stat (path, &statb) == 0
+      && (guint64) statb.st_mtime >= thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED))
+    failed = TRUE;
+
+  g_free (path);
+
+  return failed;
+}
+
+
+
+static void
+thunar_thumbnailer_fail_free (gpointer data)
+{
+  ThunarThumbnailerFail *fail = data;
+
+  g_free (fail->path);
+  g_free (fail->uri);
+  g_slice_free (ThunarThumbnailerFail, fail);
+}
+
+
+
+static void
+thunar_thumbnailer_fail_write_thread (GTask        *task,
+                                      gpointer      source_object,
+                                      gpointer      task_data,
+                                      GCancellable *cancellable)
+{
+  ThunarThumbnailerFail *fail;
+  GPtrArray             *fails = task_data;
+  GdkPixbuf             *pixbuf;
+  gchar                 *dirname;
+  gchar                 *tmp_path;
+  gchar                  mtime[21];
+  guint                  n;
+
+  if (fails->len == 0)
+    return;
+
+  fail = g_ptr_array_index (fails, 0);
+  dirname = g_path_get_dirname (fail->path);
+  if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+      g_free (dirname);
+      return;
+    }
+  g_free (dirname);
+
+  /* the specification asks for an empty image with the uri and mtime */
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 1, 1);
+  gdk_pixbuf_fill (pixbuf, 0);
+
+  for (n = 0; n < fails->len; ++n)
+    {
+      fail = g_ptr_array_index (fails, n);
+      g_snprintf (mtime, sizeof (mtime), "%" G_GUINT64_FORMAT, fail->mtime);
+
+      /* write to a temporary file, so no reader sees a partial image */
+      tmp_path = g_strconcat (fail->path, ".XXXXXX", NULL);
+      if (gdk_pixbuf_save (pixbuf, tmp_path, "png", NULL,
+                           "tEXt::Thumb::URI", fail->uri,
+                           "tEXt::Thumb::MTime", mtime,
+                           NULL))
+        {
+          if (g_rename (tmp_path, fail->path) != 0)
+            g_unlink (tmp_path);
+        }
+      g_free (tmp_path);
+    }
+
+  g_object_unref (pixbuf);
+}
+
+
+
 /* NOTE: assumes that the lock is held by the caller */
 static gboolean
 thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
                               ThunarThumbnailerJob *job)
 {
-  gboolean               success = FALSE;
-  const gchar          **mime_hints;
-  gchar                **uris;
-  GList                 *lp;
-  GList                 *supported_files = NULL;
-  guint                  n;
-  guint                  n_items = 0;
-  ThunarFileThumbState   thumb_state;
-  const gchar           *thumbnail_path;
-  gint                   request_no;
+  gboolean                    success = FALSE;
+  GList                      *lp;
+  GList                      *supported_files = NULL;
+  guint                       n_items = 0;
+  ThunarFileThumbState        thumb_state;
+  ThunarThumbnailBudgetResult budget;
+  gchar                      *thumbnail_path;
+  gint                        request_no;
 
   if (thumbnailer->proxy_state == THUNAR_THUMBNAILER_PROXY_WAITING)
     {
@@ -421,10 +863,31 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
             continue;
         }
 
+      /* files the thumbnailer failed on before are not queued again */
+      if (thumb_state != THUNAR_FILE_THUMB_STATE_READY
+          && thunar_thumbnailer_file_failed (lp->data))
+        {
+          thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_NONE);
+          continue;
+        }
+
       /* check if the file is supported, assume it is when the state was ready previously */
       if (thumb_state == THUNAR_FILE_THUMB_STATE_READY
           || thunar_thumbnailer_file_is_supported (thumbnailer, lp->data))
         {
+          /* remote files must fit into the read budget of their share */
+          budget = thunar_thumbnail_budget_charge (lp->data);
+          if (budget == THUNAR_THUMBNAIL_BUDGET_REJECT)
+            {
+              thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_NONE);
+              continue;
+            }
+          else if (budget == THUNAR_THUMBNAIL_BUDGET_DEFER)
+            {
+              thunar_thumbnailer_defer_file (thumbnailer, lp->data);
+              continue;
+            }
+
           supported_files = g_list_prepend (supported_files, lp->data);
           n_items++;
         }
@@ -432,39 +895,25 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
         {
           /* still a regular file, but the type is now known to tumbler but
            * maybe the application created a thumbnail */
-          thumbnail_path = thunar_file_get_thumbnail_path (lp->data, thumbnailer->thumbnail_size);
+          thumbnail_path = thunar_file_dup_thumbnail_path (lp->data, thumbnailer->thumbnail_size);
 
           /* test if a thumbnail can be found */
           if (thumbnail_path != NULL && g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
             thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_READY);
           else
             thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_NONE);
+
+          g_free (thumbnail_path);
         }
     }
 
   /* check if we have any supported files */
   if (n_items > 0)
     {
-      /* allocate arrays for URIs and mime hints */
-      uris = g_new0 (gchar *, n_items + 1);
-      mime_hints = g_new0 (const gchar *, n_items + 1);
-
-      /* fill URI and MIME hint arrays with items from the wait queue */
-      for (lp = supported_files, n = 0; lp != NULL; lp = lp->next, ++n)
-        {
-          /* set the thumbnail state to loading */
-          thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_LOADING);
-
-          /* save URI and MIME hint in the arrays */
-          uris[n] = thunar_file_dup_uri (lp->data);
-          mime_hints[n] = thunar_file_get_content_type (lp->data);
-        }
+      /* set the thumbnail state to loading */
+      for (lp = supported_files; lp != NULL; lp = lp->next)
+        thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_LOADING);
 
-      /* NULL-terminate both arrays */
-      uris[n] = NULL;
-      mime_hints[n] = NULL;
-
-      /* queue a thumbnail request for the URIs from the wait queue */
       /* compute the next request ID, making sure it's never 0 */
       request_no = thumbnailer->last_request + 1;
       request_no = MAX (request_no, 1);
@@ -475,33 +924,22 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
       /* save the request number */
       job->request = request_no;
 
-      /* increase the reference count while the dbus call is running */
-      g_object_ref (thumbnailer);
-
-      /* queue the request - asynchronously, of course */
-      thunar_thumbnailer_dbus_call_queue (thumbnailer->thumbnailer_proxy,
-                                          (const gchar *const *)uris,
-                                          (const gchar *const *)mime_hints,
-                                          thunar_thumbnail_size_get_nick (thumbnailer->thumbnail_size),
-                                          "foreground", 0,
-                                          NULL,
-                                          thunar_thumbnailer_queue_async_reply,
-                                          job);
-
-      /* free mime hints array */
-      g_free (mime_hints);
-      g_strfreev (uris);
-
-      /* free the list of supported files */
-      g_list_free (supported_files);
-
-      /* free the list of files passed in */
+      /* only keep the supported files of the job until its batch is sent */
+      g_list_foreach (supported_files, (GFunc) (void (*)(void)) g_object_ref, NULL);
       g_list_free_full (job->files, g_object_unref);
-      job->files = NULL;
+      job->files = supported_files;
+
+      /* queue the files with the next batch */
+      thunar_thumbnailer_batch_add (thumbnailer, job, n_items);
 
       /* we assume success if we've come so far */
       success = TRUE;
     }
+  else
+    {
+      /* free the list of supported files */
+      g_list_free (supported_files);
+    }
 
   return success;
 }
@@ -513,6 +951,8 @@ thunar_thumbnailer_init (ThunarThumbnailer *thumbnailer)
 {
   g_mutex_init (&thumbnailer->lock);
 
+  thumbnailer->batch_size = THUNAR_THUMBNAILER_BATCH_SIZE_DEFAULT;
+
   /* initialize the proxies */
   thunar_thumbnailer_init_thumbnailer_proxy (thumbnailer);
 }
@@ -522,9 +962,11 @@ thunar_thumbnailer_init (ThunarThumbnailer *thumbnailer)
 static void
 thunar_thumbnailer_finalize (GObject *object)
 {
-  ThunarThumbnailer     *thumbnailer = THUNAR_THUMBNAILER (object);
-  ThunarThumbnailerIdle *idle;
-  GSList                *lp;
+  ThunarThumbnailer      *thumbnailer = THUNAR_THUMBNAILER (object);
+  ThunarThumbnailerIdle  *idle;
+  ThunarThumbnailerBatch *batch;
+  GSList                 *lp;
+  guint                   n;
 
   /* acquire the thumbnailer lock */
   _thumbnailer_lock (thumbnailer);
@@ -545,9 +987,37 @@ thunar_thumbnailer_finalize (GObject *object)
     }
   g_slist_free (thumbnailer->idles);
 
+  /* drop the batches that were not sent yet */
+  if (thumbnailer->flush_idle_id != 0)
+    g_source_remove (thumbnailer->flush_idle_id);
+  for (n = 0; n < G_N_ELEMENTS (thumbnailer->pending); ++n)
+    if (thumbnailer->pending[n] != NULL)
+      {
+        g_slist_free (thumbnailer->pending[n]->jobs);
+        g_slice_free (ThunarThumbnailerBatch, thumbnailer->pending[n]);
+      }
+
+  /* dequeue the batches tumbler is working on, no Queue call is running
+   * since it holds a reference on the thumbnailer */
+  for (lp = thumbnailer->batches; lp != NULL; lp = lp->next)
+    {
+      batch = lp->data;
+      if (thumbnailer->thumbnailer_proxy != NULL && batch->handle != 0)
+        thunar_thumbnailer_dbus_call_dequeue (thumbnailer->thumbnailer_proxy, batch->handle, NULL, NULL, NULL);
+      g_slist_free (batch->jobs);
+      g_slice_free (ThunarThumbnailerBatch, batch);
+    }
+  g_slist_free (thumbnailer->batches);
+
   /* remove all jobs */
   g_slist_free_full (thumbnailer->jobs, (GDestroyNotify)thunar_thumbnailer_free_job);
 
+  /* forget the files deferred by the budget */
+  if (thumbnailer->deferred_timer_id != 0)
+    g_source_remove (thumbnailer->deferred_timer_id);
+  if (thumbnailer->deferred != NULL)
+    g_hash_table_unref (thumbnailer->deferred);
+
   /* release the thumbnailer proxy */
   if (thumbnailer->thumbnailer_proxy != NULL)
     g_object_unref (thumbnailer->thumbnailer_proxy);
@@ -567,41 +1037,6 @@ thunar_thumbnailer_finalize (GObject *object)
 
 
 
-static gint
-thunar_thumbnailer_file_schemes_compare (gconstpointer a,
-                                         gconstpointer b)
-{
-  const gchar *scheme_a = *(gconstpointer *) a;
-  const gchar *scheme_b = *(gconstpointer *) b;
-
-  /* sort file before other schemes */
-  if (strcmp (scheme_a, "file") == 0)
-    return -1;
-  if (strcmp (scheme_b, "file") == 0)
-    return 1;
-
-  /* sort trash before other schemes */
-  if (strcmp (scheme_a, "trash") == 0)
-    return -1;
-  if (strcmp (scheme_b, "trash") == 0)
-    return 1;
-
-  /* other order is just fine */
-  return 0;
-}
-
-
-
-static void
-thunar_thumbnailer_file_sort_schemes (gpointer mime_type,
-                                      gpointer schemes,
-                                      gpointer user_data)
-{
-  g_ptr_array_sort (schemes, thunar_thumbnailer_file_schemes_compare);
-}
-
-
-
 static void
 thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
                                              GAsyncResult           *result,
@@ -610,7 +1045,7 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
   guint       n;
   gchar     **schemes = NULL;
   gchar     **types = NULL;
-  GPtrArray  *schemes_array;
+  GHashTable *types_set;
   GSList     *lp = NULL;
   GError     *error = NULL;
 
@@ -639,33 +1074,32 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
 
   if (G_LIKELY (schemes != NULL && types != NULL))
     {
-      /* combine content types and uri schemes */
-      for (n = 0; types[n] != NULL; ++n)
+      /* index the content types by uri scheme, there are only a few
+       * schemes, so a file is checked with two lookups */
+      for (n = 0; types[n] != NULL && schemes[n] != NULL; ++n)
         {
-          schemes_array = g_hash_table_lookup (thumbnailer->supported, types[n]);
-          if (G_UNLIKELY (schemes_array == NULL))
+          types_set = g_hash_table_lookup (thumbnailer->supported, schemes[n]);
+          if (G_UNLIKELY (types_set == NULL))
             {
-              /* create an array for the uri schemes this content type supports */
-              schemes_array = g_ptr_array_new_with_free_func (g_free);
-              g_ptr_array_add (schemes_array, schemes[n]);
-              g_hash_table_insert (thumbnailer->supported, types[n], schemes_array);
+              /* create a set for the content types of this uri scheme */
+              types_set = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+              g_hash_table_insert (thumbnailer->supported, schemes[n], types_set);
             }
           else
             {
-              /* add the uri scheme to the array of the content type */
-              g_ptr_array_add (schemes_array, schemes[n]);
-
               /* cleanup */
-              g_free (types[n]);
+              g_free (schemes[n]);
             }
+
+          /* the set takes the content type */
+          g_hash_table_add (types_set, types[n]);
         }
 
       /* remove arrays, we stole the values */
+      g_strfreev (types + n);
+      g_strfreev (schemes + n);
       g_free (types);
       g_free (schemes);
-
-      /* sort array to optimize for local files */
-      g_hash_table_foreach (thumbnailer->supported, thunar_thumbnailer_file_sort_schemes, NULL);
     }
 
   thumbnailer->proxy_state = THUNAR_THUMBNAILER_PROXY_AVAILABLE;
@@ -736,7 +1170,7 @@ thunar_thumbnailer_proxy_created (GObject       *object,
   g_clear_pointer (&thumbnailer->supported, g_hash_table_unref);
   thumbnailer->supported = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                   g_free,
-                                                  (GDestroyNotify) g_ptr_array_unref);
+                                                  (GDestroyNotify) g_hash_table_unref);
 
   /* request the supported types from the thumbnailer D-Bus service. */
   thunar_thumbnailer_dbus_call_get_supported (proxy, NULL,
@@ -776,10 +1210,8 @@ thunar_thumbnailer_file_is_supported (ThunarThumbnailer *thumbnailer,
                                       ThunarFile        *file)
 {
   const gchar *content_type;
-  gboolean     supported = FALSE;
-  guint        n;
-  GPtrArray   *schemes_array;
-  const gchar *scheme;
+  GHashTable  *types_set;
+  gchar       *scheme;
 
   _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
@@ -793,21 +1225,19 @@ thunar_thumbnailer_file_is_supported (ThunarThumbnailer *thumbnailer,
   if (content_type == NULL)
     return FALSE;
 
-  /* lazy lookup the content type, no difficult parent type matching here */
-  schemes_array = g_hash_table_lookup (thumbnailer->supported, content_type);
-  if (schemes_array != NULL)
+  /* lookup the content types of the URI scheme, local files are
+   * checked without building the scheme string */
+  if (G_LIKELY (thunar_file_is_local (file)))
+    types_set = g_hash_table_lookup (thumbnailer->supported, "file");
+  else
     {
-      /* go through all the URI schemes this type supports */
-      for (n = 0; !supported && n < schemes_array->len; ++n)
-        {
-          /* check if the file has the current URI scheme */
-          scheme = g_ptr_array_index (schemes_array, n);
-          if (thunar_file_has_uri_scheme (file, scheme))
-            supported = TRUE;
-        }
+      scheme = g_file_get_uri_scheme (thunar_file_get_file (file));
+      types_set = scheme != NULL ? g_hash_table_lookup (thumbnailer->supported, scheme) : NULL;
+      g_free (scheme);
     }
 
-  return supported;
+  /* lazy lookup the content type, no difficult parent type matching here */
+  return types_set != NULL && g_hash_table_contains (types_set, content_type);
 }
 
 
@@ -854,8 +1284,9 @@ thunar_thumbnailer_thumbnailer_finished (GDBusProxy        *proxy,
                                          guint              handle,
                                          ThunarThumbnailer *thumbnailer)
 {
-  ThunarThumbnailerJob *job;
-  GSList               *lp;
+  ThunarThumbnailerBatch *batch;
+  GSList                 *lp;
+  gint64                  file_time;
 
   _thunar_return_if_fail (G_IS_DBUS_PROXY (proxy));
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
@@ -868,22 +1299,30 @@ thunar_thumbnailer_thumbnailer_finished (GDBusProxy        *proxy,
 
   _thumbnailer_lock (thumbnailer);
 
-  for (lp = thumbnailer->jobs; lp != NULL; lp = lp->next)
+  for (lp = thumbnailer->batches; lp != NULL; lp = lp->next)
     {
-      job = lp->data;
+      batch = lp->data;
 
-      if (job->handle == handle)
+      if (batch->handle == handle)
         {
-          /* this job is finished, forget about the handle */
-          job->handle = 0;
-
-          /* tell everybody we're done here */
-          g_signal_emit (G_OBJECT (thumbnailer), thumbnailer_signals[REQUEST_FINISHED], 0, job->request);
-
-          /* remove job from the list */
-          thumbnailer->jobs = g_slist_delete_link (thumbnailer->jobs, lp);
+          /* adapt the batch size to the time tumbler needs per file, the
+           * background scheduler waits for the foreground, so only the
+           * foreground batches are taken into account */
+          if (!batch->prefetch && batch->n_files > 0)
+            {
+              file_time = (g_get_monotonic_time () - batch->queue_time) / batch->n_files;
+              if (thumbnailer->file_time == 0)
+                thumbnailer->file_time = file_time;
+              else
+                thumbnailer->file_time = (3 * thumbnailer->file_time + file_time) / 4;
+
+              thumbnailer->batch_size = CLAMP (THUNAR_THUMBNAILER_BATCH_TIME / MAX (thumbnailer->file_time, 1),
+                                               THUNAR_THUMBNAILER_BATCH_SIZE_MIN,
+                                               THUNAR_THUMBNAILER_BATCH_SIZE_MAX);
+            }
 
-          thunar_thumbnailer_free_job (job);
+          /* finish all the jobs of the batch */
+          thunar_thumbnailer_batch_finished (batch);
           break;
         }
     }
@@ -899,9 +1338,9 @@ thunar_thumbnailer_idle (ThunarThumbnailer          *thumbnailer,
                          ThunarThumbnailerIdleType   type,
                          const gchar               **uris)
 {
-  GSList                *lp;
-  ThunarThumbnailerIdle *idle;
-  ThunarThumbnailerJob  *job;
+  GSList                 *lp;
+  ThunarThumbnailerIdle  *idle;
+  ThunarThumbnailerBatch *batch;
 
   /* leave if there are no uris */
   if (G_UNLIKELY (uris == NULL))
@@ -920,11 +1359,11 @@ thunar_thumbnailer_idle (ThunarThumbnailer          *thumbnailer,
    * want each window (because they all have a connection to the
    * same proxy) emit the file change, only the window that requested
    * the data */
-  for (lp = thumbnailer->jobs; lp != NULL; lp = lp->next)
+  for (lp = thumbnailer->batches; lp != NULL; lp = lp->next)
     {
-      job = lp->data;
+      batch = lp->data;
 
-      if (job->handle == handle)
+      if (batch->handle == handle)
         {
           /* allocate a new idle struct */
           idle = g_slice_new0 (ThunarThumbnailerIdle);
@@ -955,8 +1394,11 @@ static gboolean
 thunar_thumbnailer_idle_func (gpointer user_data)
 {
   ThunarThumbnailerIdle *idle = user_data;
+  ThunarThumbnailerFail *fail;
   ThunarFile            *file;
+  GPtrArray             *fails = NULL;
   GFile                 *gfile;
+  GTask                 *task;
   guint                  n;
 
   _thunar_return_val_if_fail (idle != NULL, FALSE);
@@ -978,7 +1420,18 @@ thunar_thumbnailer_idle_func (gpointer user_data)
               /* set thumbnail state to none unless the thumbnail has already been created.
                * This is to prevent race conditions with the other idle functions */
               if (thunar_file_get_thumb_state (file) != THUNAR_FILE_THUMB_STATE_READY)
-                thunar_file_set_thumb_state (file, THUNAR_FILE_THUMB_STATE_NONE);
+                {
+                  thunar_file_set_thumb_state (file, THUNAR_FILE_THUMB_STATE_NONE);
+
+                  /* remember the failure for the next visits */
+                  if (fails == NULL)
+                    fails = g_ptr_array_new_with_free_func (thunar_thumbnailer_fail_free);
+                  fail = g_slice_new (ThunarThumbnailerFail);
+                  fail->uri = g_strdup (idle->uris[n]);
+                  fail->path = thunar_thumbnailer_fail_path (fail->uri);
+                  fail->mtime = thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED);
+                  g_ptr_array_add (fails, fail);
+                }
             }
           else if (idle->type == THUNAR_THUMBNAILER_IDLE_READY)
             {
@@ -993,6 +1446,15 @@ thunar_thumbnailer_idle_func (gpointer user_data)
         }
     }
 
+  /* write the failures in the background */
+  if (fails != NULL)
+    {
+      task = g_task_new (NULL, NULL, NULL, NULL);
+      g_task_set_task_data (task, fails, (GDestroyNotify) g_ptr_array_unref);
+      g_task_run_in_thread (task, thunar_thumbnailer_fail_write_thread);
+      g_object_unref (task);
+    }
+
   /* remove the idle struct */
   _thumbnailer_lock (idle->thumbnailer);
   idle->thumbnailer->idles = g_slist_remove (idle->thumbnailer->idles, idle);
@@ -1072,17 +1534,16 @@ thunar_thumbnailer_queue_file (ThunarThumbnailer *thumbnailer,
 
 
 
-gboolean
-thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
-                                gboolean           lazy_checks,
-                                GList             *files,
-                                guint             *request)
+static gboolean
+thunar_thumbnailer_queue_job (ThunarThumbnailer *thumbnailer,
+                              gboolean           lazy_checks,
+                              gboolean           prefetch,
+                              GList             *files,
+                              guint             *request)
 {
   gboolean               success = FALSE;
   ThunarThumbnailerJob  *job = NULL;
-
-  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer), FALSE);
-  _thunar_return_val_if_fail (files != NULL, FALSE);
+  gchar                 *detail;
 
   /* acquire the thumbnailer lock */
   _thumbnailer_lock (thumbnailer);
@@ -1092,13 +1553,30 @@ thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
   job->thumbnailer = thumbnailer;
   job->files = g_list_copy_deep (files, (GCopyFunc) (void (*)(void)) g_object_ref, NULL);
   job->lazy_checks = lazy_checks ? 1 : 0;
+  job->prefetch = prefetch ? 1 : 0;
 
+  thunar_watchdog_push_operation ("thumbnail request", NULL);
   success = thunar_thumbnailer_begin_job (thumbnailer, job);
+  thunar_watchdog_pop_operation ();
   if (success)
     {
       thumbnailer->jobs = g_slist_prepend (thumbnailer->jobs, job);
-      if (*request)
+      if (request != NULL)
         *request = job->request;
+
+      if (job->request != 0)
+        thunar_counters_inc (THUNAR_COUNTER_THUMBNAIL_REQUESTS);
+
+      /* the span lasts until the job is finished or dequeued */
+      if (THUNAR_TRACE_ENABLED () && job->request != 0)
+        {
+          detail = g_strdup_printf ("%u files", g_list_length (files));
+          thunar_trace_async_begin ("thumbnail", "thumbnail request", job, detail);
+          g_free (detail);
+        }
+
+      if (THUNAR_RECORDER_ENABLED () && job->request != 0)
+        thunar_recorder_thumbnail_request (files);
     }
   else
     {
@@ -1113,12 +1591,53 @@ thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
 
 
 
+gboolean
+thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
+                                gboolean           lazy_checks,
+                                GList             *files,
+                                guint             *request)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer), FALSE);
+  _thunar_return_val_if_fail (files != NULL, FALSE);
+
+  return thunar_thumbnailer_queue_job (thumbnailer, lazy_checks, FALSE, files, request);
+}
+
+
+
+/**
+ * thunar_thumbnailer_prefetch_files:
+ * @thumbnailer : a #ThunarThumbnailer.
+ * @files       : the #ThunarFile<!---->s that will probably be shown next.
+ * @request     : return location for the request id or %NULL.
+ *
+ * Like thunar_thumbnailer_queue_files() with lazy checks, but the request
+ * uses the background scheduler of the thumbnailer service, so it does not
+ * delay the thumbnails of the files which are visible right now.
+ *
+ * Return value: %TRUE if the request was queued.
+ **/
+gboolean
+thunar_thumbnailer_prefetch_files (ThunarThumbnailer *thumbnailer,
+                                   GList             *files,
+                                   guint             *request)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer), FALSE);
+  _thunar_return_val_if_fail (files != NULL, FALSE);
+
+  return thunar_thumbnailer_queue_job (thumbnailer, TRUE, TRUE, files, request);
+}
+
+
+
 void
 thunar_thumbnailer_dequeue (ThunarThumbnailer *thumbnailer,
                             guint              request)
 {
-  ThunarThumbnailerJob *job;
-  GSList               *lp;
+  ThunarThumbnailerBatch *batch;
+  ThunarThumbnailerJob   *job;
+  GSList                 *lp;
+  GList                  *fp;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
 
@@ -1132,17 +1651,34 @@ thunar_thumbnailer_dequeue (ThunarThumbnailer *thumbnailer,
       /* find the request in the list */
       if (job->request == request)
         {
-          /* this job is cancelled */
-          job->cancelled = TRUE;
+          /* remove job */
+          thumbnailer->jobs = g_slist_delete_link (thumbnailer->jobs, lp);
 
-          if (job->handle != 0)
+          batch = job->batch;
+          if (batch != NULL)
             {
-              /* remove job */
-              thumbnailer->jobs = g_slist_delete_link (thumbnailer->jobs, lp);
-
-              thunar_thumbnailer_free_job (job);
+              batch->jobs = g_slist_remove (batch->jobs, job);
+
+              if (!batch->sent)
+                {
+                  /* the files were never queued, so a later request tries again */
+                  for (fp = job->files; fp != NULL; fp = fp->next)
+                    {
+                      if (thunar_file_get_thumb_state (fp->data) == THUNAR_FILE_THUMB_STATE_LOADING)
+                        thunar_file_set_thumb_state (fp->data, THUNAR_FILE_THUMB_STATE_UNKNOWN);
+                      batch->n_files--;
+                    }
+                }
+              else if (batch->jobs == NULL && batch->handle != 0)
+                {
+                  /* one Dequeue for the whole batch, once no job is left in it,
+                   * with the Queue call still running, the reply dequeues it */
+                  thunar_thumbnailer_dbus_call_dequeue (thumbnailer->thumbnailer_proxy, batch->handle, NULL, NULL, NULL);
+                  thunar_thumbnailer_batch_free (batch);
+                }
             }
 
+          thunar_thumbnailer_free_job (job);
           break;
         }
     }
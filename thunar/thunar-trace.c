@@ -0,0 +1,280 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-trace.h>
+
+
+
+/* If the THUNAR_TRACE environment variable names a file, spans of jobs,
+ * folder loads, thumbnail requests, sorting and drawing are written to
+ * it as trace events in the JSON array format, which the Perfetto UI,
+ * chrome://tracing and most other trace viewers open directly. The
+ * array is closed on shutdown, but viewers also accept a trace that
+ * ends early, for example because Thunar crashed.
+ *
+ * When tracing is disabled, a span costs the check of a global flag.
+ */
+
+
+
+gboolean thunar_trace_enabled = FALSE;
+
+static GMutex   trace_mutex;
+static FILE    *trace_stream = NULL;
+static GPrivate trace_thread_id;
+static gint     trace_n_threads = 0;
+
+
+
+static gint
+thunar_trace_get_thread_id (void)
+{
+  gint id;
+
+  /* small numbers read better than addresses in the viewers */
+  id = GPOINTER_TO_INT (g_private_get (&trace_thread_id));
+  if (G_UNLIKELY (id == 0))
+    {
+      id = g_atomic_int_add (&trace_n_threads, 1) + 1;
+      g_private_set (&trace_thread_id, GINT_TO_POINTER (id));
+    }
+
+  return id;
+}
+
+
+
+static void
+thunar_trace_append_string (GString     *line,
+                            const gchar *string)
+{
+  const gchar *p;
+
+  g_string_append_c (line, '"');
+  for (p = string; *p != '\0'; ++p)
+    {
+      if (*p == '"' || *p == '\\')
+        g_string_append_printf (line, "\\%c", *p);
+      else if ((guchar) *p < 0x20)
+        g_string_append_printf (line, "\\u%04x", (guint) (guchar) *p);
+      else
+        g_string_append_c (line, *p);
+    }
+  g_string_append_c (line, '"');
+}
+
+
+
+static void
+thunar_trace_write (const gchar   *phase,
+                    const gchar   *category,
+                    const gchar   *name,
+                    gint64         time,
+                    gint64         duration,
+                    gconstpointer  id,
+                    const gchar   *detail)
+{
+  GString *line;
+
+  line = g_string_sized_new (160);
+  g_string_append_printf (line, "{\"ph\":\"%s\",\"cat\":", phase);
+  thunar_trace_append_string (line, category);
+  g_string_append (line, ",\"name\":");
+  thunar_trace_append_string (line, name);
+  g_string_append_printf (line, ",\"pid\":%d,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT,
+                          (gint) getpid (), thunar_trace_get_thread_id (), time);
+
+  if (duration >= 0)
+    g_string_append_printf (line, ",\"dur\":%" G_GINT64_FORMAT, duration);
+  if (id != NULL)
+    g_string_append_printf (line, ",\"id\":\"%p\"", id);
+  if (detail != NULL)
+    {
+      g_string_append (line, ",\"args\":{\"detail\":");
+      thunar_trace_append_string (line, detail);
+      g_string_append_c (line, '}');
+    }
+  g_string_append (line, "},\n");
+
+  g_mutex_lock (&trace_mutex);
+  if (G_LIKELY (trace_stream != NULL))
+    fputs (line->str, trace_stream);
+  g_mutex_unlock (&trace_mutex);
+
+  g_string_free (line, TRUE);
+}
+
+
+
+/**
+ * thunar_trace_init:
+ *
+ * Starts writing trace events to the file named by the THUNAR_TRACE
+ * environment variable, if it is set. Must be called from the main
+ * thread before any other thread is started.
+ **/
+void
+thunar_trace_init (void)
+{
+  const gchar *path;
+
+  path = g_getenv ("THUNAR_TRACE");
+  if (G_LIKELY (path == NULL || *path == '\0'))
+    return;
+
+  trace_stream = g_fopen (path, "w");
+  if (G_UNLIKELY (trace_stream == NULL))
+    {
+      g_warning ("Failed to open trace file \"%s\": %s", path, g_strerror (errno));
+      return;
+    }
+
+  /* the main thread is always the first one */
+  fputs ("[\n", trace_stream);
+  thunar_trace_get_thread_id ();
+  thunar_trace_enabled = TRUE;
+}
+
+
+
+/**
+ * thunar_trace_shutdown:
+ *
+ * Closes the trace file opened by thunar_trace_init(). Spans which
+ * end afterwards are dropped.
+ **/
+void
+thunar_trace_shutdown (void)
+{
+  if (trace_stream == NULL)
+    return;
+
+  g_mutex_lock (&trace_mutex);
+  fprintf (trace_stream, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":1,"
+           "\"args\":{\"name\":\"main\"}}\n]\n", (gint) getpid ());
+  fclose (trace_stream);
+  trace_stream = NULL;
+  g_mutex_unlock (&trace_mutex);
+}
+
+
+
+/**
+ * thunar_trace_begin:
+ *
+ * Starts a span on the calling thread, which is written once it
+ * is passed to thunar_trace_end().
+ *
+ * Return value: the start time of the span, or 0 if tracing is disabled.
+ **/
+gint64
+thunar_trace_begin (void)
+{
+  if (G_LIKELY (!thunar_trace_enabled))
+    return 0;
+
+  return g_get_monotonic_time ();
+}
+
+
+
+/**
+ * thunar_trace_end:
+ * @begin_time : the return value of thunar_trace_begin().
+ * @category   : the category of the span, for example "job".
+ * @name       : the name of the span.
+ * @detail     : additional information like the folder or %NULL.
+ *
+ * Writes the span started by thunar_trace_begin() on the same thread.
+ **/
+void
+thunar_trace_end (gint64       begin_time,
+                  const gchar *category,
+                  const gchar *name,
+                  const gchar *detail)
+{
+  if (G_LIKELY (begin_time == 0))
+    return;
+
+  thunar_trace_write ("X", category, name, begin_time,
+                      g_get_monotonic_time () - begin_time,
+                      NULL, detail);
+}
+
+
+
+/**
+ * thunar_trace_async_begin:
+ * @category : the category of the span.
+ * @name     : the name of the span.
+ * @id       : the object the span belongs to.
+ * @detail   : additional information like the folder or %NULL.
+ *
+ * Starts a span which may end on another thread or in another main
+ * loop iteration, once thunar_trace_async_end() is called with the
+ * same @category, @name and @id.
+ **/
+void
+thunar_trace_async_begin (const gchar   *category,
+                          const gchar   *name,
+                          gconstpointer  id,
+                          const gchar   *detail)
+{
+  if (G_LIKELY (!thunar_trace_enabled))
+    return;
+
+  thunar_trace_write ("b", category, name, g_get_monotonic_time (), -1, id, detail);
+}
+
+
+
+/**
+ * thunar_trace_async_end:
+ * @category : the category of the span.
+ * @name     : the name of the span.
+ * @id       : the object the span belongs to.
+ *
+ * Ends the span started by thunar_trace_async_begin().
+ **/
+void
+thunar_trace_async_end (const gchar   *category,
+                        const gchar   *name,
+                        gconstpointer  id)
+{
+  if (G_LIKELY (!thunar_trace_enabled))
+    return;
+
+  thunar_trace_write ("e", category, name, g_get_monotonic_time (), -1, id, NULL);
+}
@@ -23,9 +23,39 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 
 #include <thunar/thunar-application.h>
+#include <thunar/thunar-free-space.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-io-scan-directory.h>
 #include <thunar/thunar-io-jobs-util.h>
@@ -33,13 +63,55 @@
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-thumbnail-cache.h>
+#include <thunar/thunar-trace.h>
 #include <thunar/thunar-transfer-job.h>
+#include <thunar/thunar-transfer-journal.h>
+#include <thunar/thunar-trash-count.h>
 
 
 
 /* seconds before we show the transfer rate + remaining time */
 #define MINIMUM_TRANSFER_TIME (10 * G_USEC_PER_SEC) /* 10 seconds */
 
+/* interval in which the progress is published to the UI */
+#define PROGRESS_UPDATE_INTERVAL (100) /* 10 Hz */
+
+/* time constant of the moving average of the transfer rate */
+#define TRANSFER_RATE_TIME_CONSTANT (5 * G_USEC_PER_SEC) /* 5 seconds */
+
+/* number of bytes copied in the kernel between two progress updates */
+#define LOCAL_COPY_CHUNK_SIZE (8 * 1024 * 1024) /* 8 MiB */
+
+/* local copies from this size on reserve the space of the target
+ * up front, see ttj_copy_file_local() */
+#define LOCAL_PREALLOCATE_MIN_SIZE (1024 * 1024) /* 1 MiB */
+
+/* files which are copied in userspace are copied in blocks of this size,
+ * see ttj_copy_file_blocks() */
+#define COPY_BLOCK_SIZE (1024 * 1024) /* 1 MiB */
+
+/* files from this size on can be resumed when copied from or to
+ * remote devices */
+#define RESUME_MIN_FILE_SIZE   (64 * 1024 * 1024) /* 64 MiB */
+#define RESUME_CHECKPOINT_SIZE (32 * COPY_BLOCK_SIZE)
+
+/* the number of blocks in flight to the hash thread when a copy is
+ * read back, see ttj_hash_target() */
+#define VERIFY_MAX_BLOCKS (4)
+
+/* removable targets are written back in ranges of this size while
+ * copying, see ttj_flush_target() */
+#define FLUSH_RANGE_SIZE (8 * COPY_BLOCK_SIZE) /* 8 MiB */
+
+/* files up to this size are copied in parallel by the copy pool */
+#define PIPELINE_MAX_FILE_SIZE (1024 * 1024) /* 1 MiB */
+#define PIPELINE_MAX_THREADS   (8)
+
+/* the streams of ttj_copy_file_ranges() take parts of this size from the
+ * file one after the other, so a slow stream does not hold up the copy */
+#define RANGE_CHUNK_SIZE  (32 * COPY_BLOCK_SIZE) /* 32 MiB */
+#define RANGE_MAX_STREAMS (16)
+
 
 
 /* Property identifiers */
@@ -48,11 +120,25 @@ enum
   PROP_0,
   PROP_FILE_SIZE_BINARY,
   PROP_PARALLEL_COPY_MODE,
+  PROP_JOBS_PER_DEVICE,
+  PROP_VERIFY,
+  PROP_BUFFER_SIZE,
+  PROP_PRESERVE_HARD_LINKS,
+  PROP_OVERLAP_COLLECTION,
+  PROP_RANGE_STREAMS,
+  PROP_RANGE_MIN_SIZE,
 };
 
 
 
-typedef struct _ThunarTransferNode ThunarTransferNode;
+typedef struct _ThunarTransferNode   ThunarTransferNode;
+typedef struct _ThunarTransferCopy   ThunarTransferCopy;
+typedef struct _ThunarTransferBlock  ThunarTransferBlock;
+typedef struct _ThunarTransferPool   ThunarTransferPool;
+typedef struct _ThunarTransferHasher ThunarTransferHasher;
+typedef struct _ThunarTransferReader ThunarTransferReader;
+typedef struct _ThunarTransferHardLink ThunarTransferHardLink;
+typedef struct _ThunarTransferRanges ThunarTransferRanges;
 
 
 
@@ -67,9 +153,11 @@ static void     thunar_transfer_job_set_property (GObject      *object,
                                                   GParamSpec   *pspec);
 
 static void     thunar_transfer_job_finalize     (GObject                *object);
+static void     thunar_transfer_hard_link_free   (gpointer                data);
 static gboolean thunar_transfer_job_execute      (ExoJob                 *job,
                                                   GError                **error);
 static void     thunar_transfer_node_free        (gpointer                data);
+static gpointer thunar_transfer_job_collect_thread (gpointer              data);
 
 
 
@@ -84,35 +172,179 @@ struct _ThunarTransferJob
 
   ThunarTransferJobType   type;
   GList                  *source_node_list;
+  gboolean                device_info_valid;
   gchar                  *source_device_fs_id;
   gboolean                is_source_device_local;
   GList                  *target_file_list;
   gchar                  *target_device_fs_id;
   gboolean                is_target_device_local;
 
+  /* updated from the main loop, see thunar_transfer_job_progress_timer() */
   gint64                  start_time;
   gint64                  last_update_time;
-  guint64                 last_total_progress;
+  guint64                 last_data_progress;
+  guint                   progress_timer_id;
 
   guint64                 total_size;
   guint64                 total_progress;
   guint64                 file_progress;
   guint64                 transfer_rate;
 
+  /* the holes of sparse files, which are part of the sizes above but
+   * are not read, so the transfer rate only counts the data */
+  guint64                 total_hole_size;
+  guint64                 hole_progress;
+
+  /* atomic, the files are copied from worker threads */
+  gint                    n_files_total;
+  gint                    n_files_done;
+
   ThunarPreferences      *preferences;
   gboolean                file_size_binary;
   ThunarParallelCopyMode  parallel_copy_mode;
+  guint                   jobs_per_device;
+  gboolean                verify;
+  guint                   buffer_size;
+  gboolean                preserve_hard_links;
+  gboolean                overlap_collection;
+  guint                   range_streams;
+  guint                   range_min_size;
+  gchar                 **range_mounts;
+
+  /* the source files with more than one hard link, see
+   * thunar_transfer_job_collect_node(), maps "device:inode"
+   * to a ThunarTransferHardLink */
+  GHashTable             *hard_links;
+
+  /* pool copying small files in parallel, see thunar_transfer_job_copy_node() */
+  GThreadPool            *copy_pool;
+  guint                   copy_pool_size;
+
+  /* protects the progress counters and the copies in flight */
+  GMutex                  copy_mutex;
+  GCond                   copy_cond;
+  guint                   n_copies;
+  GError                 *copy_error;
+
+  /* serializes the questions of the copy pool */
+  GMutex                  ask_mutex;
+
+  /* the thread collecting the source files while they are copied,
+   * see thunar_transfer_job_collect_thread(). collect_stop is atomic */
+  GThread                *collect_thread;
+  GMutex                  collect_mutex;
+  GCond                   collect_cond;
+  gboolean                collecting;
+  gint                    collect_stop;
+  GError                 *collect_error;
 };
 
+/* ways to copy the data of a local file in the kernel */
+typedef enum
+{
+  LOCAL_COPY_FILE_RANGE,
+  LOCAL_COPY_SENDFILE,
+  LOCAL_COPY_NONE,
+} LocalCopyMethod;
+
 struct _ThunarTransferNode
 {
   ThunarTransferNode *next;
   ThunarTransferNode *children;
   GFile              *source_file;
+  guint64             size;
   gboolean            replace_confirmed;
   gboolean            rename_confirmed;
+
+  /* whether the size and the children of the node are known, which
+   * is protected by the collect_mutex while the collect thread runs */
+  gboolean            collected;
+
+  /* the hard link the source file is part of, owned by the job */
+  ThunarTransferHardLink *hard_link;
+};
+
+/* a source file with several hard links, which is copied once */
+struct _ThunarTransferHardLink
+{
+  /* the copy of the first link, the others are linked to it */
+  GFile *target_file;
+};
+
+struct _ThunarTransferBlock
+{
+  gsize  length;
+  guchar data[COPY_BLOCK_SIZE];
 };
 
+/* the blocks of a copy, which are passed between its threads */
+struct _ThunarTransferPool
+{
+  GAsyncQueue *spare;
+  guint        n_blocks;
+  guint        max_blocks;
+};
+
+/* hashes the blocks of a file in a separate thread, so verifying a
+ * copy does not add the hashing time to the copy time */
+struct _ThunarTransferHasher
+{
+  ThunarTransferPool *pool;
+  GChecksum          *checksum;
+  GThread            *thread;
+  GAsyncQueue        *blocks;
+};
+
+/* reads the source of a copy in a separate thread, so the next blocks
+ * are read while the previous ones are written */
+struct _ThunarTransferReader
+{
+  ThunarTransferPool *pool;
+  GInputStream       *input;
+  GCancellable       *cancellable;
+  GThread            *thread;
+  GAsyncQueue        *blocks;
+  GError             *error;
+  gboolean            done;
+  gint                stopped; /* atomic */
+};
+
+struct _ThunarTransferCopy
+{
+  GFile                *source_file;
+  GFile                *target_file;
+  guint64               size;
+  gboolean              replace_confirmed;
+  gboolean              rename_confirmed;
+  ThunarThumbnailCache *thumbnail_cache;
+};
+
+/* a large file copied by several streams, see ttj_copy_file_ranges() */
+struct _ThunarTransferRanges
+{
+  ThunarTransferJob *job;
+  GFile             *source_file;
+  GFile             *target_file;
+  GCancellable      *cancellable;
+  guint64            size;
+  gint               failed; /* atomic */
+
+  /* protected by the lock */
+  GMutex             lock;
+  GCond              cond;
+  guint64            next_offset;
+  guint64            copied;
+  guint              n_running;
+  GError            *error;
+};
+
+
+
+/* the pairs of shares whose backend cannot copy between them on the
+ * server, see ttj_copy_file_server_side(), protected by the lock */
+static GMutex      server_copy_lock;
+static GHashTable *server_copy_unsupported = NULL;
+
 
 
 G_DEFINE_TYPE (ThunarTransferJob, thunar_transfer_job, THUNAR_TYPE_JOB)
@@ -160,6 +392,103 @@ thunar_transfer_job_class_init (ThunarTransferJobClass *klass)
                                                       THUNAR_TYPE_PARALLEL_COPY_MODE,
                                                       THUNAR_PARALLEL_COPY_MODE_ONLY_LOCAL,
                                                       EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:jobs-per-device:
+   *
+   * The number of jobs which may use a busy device at the same time.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_JOBS_PER_DEVICE,
+                                   g_param_spec_uint ("jobs-per-device",
+                                                      "JobsPerDevice",
+                                                      NULL,
+                                                      1u, G_MAXUINT, 1u,
+                                                      EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:verify:
+   *
+   * Whether copied files are read back and compared to the checksum
+   * of the source data.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_VERIFY,
+                                   g_param_spec_boolean ("verify",
+                                                         "Verify",
+                                                         NULL,
+                                                         FALSE,
+                                                         EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:buffer-size:
+   *
+   * The number of MiB which may be read ahead of the target when a
+   * file is copied in blocks.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_BUFFER_SIZE,
+                                   g_param_spec_uint ("buffer-size",
+                                                      "BufferSize",
+                                                      NULL,
+                                                      2u, 1024u, 16u,
+                                                      EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:preserve-hard-links:
+   *
+   * Whether files that are hard links of the same source file are
+   * copied once and linked to that copy at the target.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_PRESERVE_HARD_LINKS,
+                                   g_param_spec_boolean ("preserve-hard-links",
+                                                         "PreserveHardLinks",
+                                                         NULL,
+                                                         FALSE,
+                                                         EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:overlap-collection:
+   *
+   * Whether copies from remote or FUSE filesystems start while the
+   * source files are still being collected.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_OVERLAP_COLLECTION,
+                                   g_param_spec_boolean ("overlap-collection",
+                                                         "OverlapCollection",
+                                                         NULL,
+                                                         TRUE,
+                                                         EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:range-streams:
+   *
+   * The number of streams which copy a large remote file at the same
+   * time, see ttj_copy_file_ranges().
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_RANGE_STREAMS,
+                                   g_param_spec_uint ("range-streams",
+                                                      "RangeStreams",
+                                                      NULL,
+                                                      1u, RANGE_MAX_STREAMS, 1u,
+                                                      EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:range-min-size:
+   *
+   * The size in MiB from which remote files are copied with
+   * #ThunarTransferJob:range-streams streams.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_RANGE_MIN_SIZE,
+                                   g_param_spec_uint ("range-min-size",
+                                                      "RangeMinSize",
+                                                      NULL,
+                                                      1u, G_MAXUINT, 256u,
+                                                      EXO_PARAM_READWRITE));
 }
 
 
@@ -174,6 +503,30 @@ thunar_transfer_job_init (ThunarTransferJob *job)
   g_object_bind_property (job->preferences, "misc-parallel-copy-mode",
                           job,              "parallel-copy-mode",
                           G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-transfer-jobs-per-device",
+                          job,              "jobs-per-device",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-verify-transfers",
+                          job,              "verify",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-transfer-buffer-size",
+                          job,              "buffer-size",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-transfer-preserve-hard-links",
+                          job,              "preserve-hard-links",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-transfer-overlap-collection",
+                          job,              "overlap-collection",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-transfer-range-streams",
+                          job,              "range-streams",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (job->preferences, "misc-transfer-range-min-size",
+                          job,              "range-min-size",
+                          G_BINDING_SYNC_CREATE);
+
+  /* read once, the copy threads use it while the job runs */
+  g_object_get (job->preferences, "misc-transfer-range-mounts", &job->range_mounts, NULL);
 
   job->type = 0;
   job->source_node_list = NULL;
@@ -186,9 +539,16 @@ thunar_transfer_job_init (ThunarTransferJob *job)
   job->total_progress = 0;
   job->file_progress = 0;
   job->last_update_time = 0;
-  job->last_total_progress = 0;
+  job->last_data_progress = 0;
   job->transfer_rate = 0;
   job->start_time = 0;
+  job->hard_links = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, thunar_transfer_hard_link_free);
+
+  g_mutex_init (&job->copy_mutex);
+  g_cond_init (&job->copy_cond);
+  g_mutex_init (&job->ask_mutex);
+  g_mutex_init (&job->collect_mutex);
+  g_cond_init (&job->collect_cond);
 }
 
 
@@ -207,7 +567,16 @@ thunar_transfer_job_finalize (GObject *object)
 
   thunar_g_list_free_full (job->target_file_list);
 
+  g_hash_table_destroy (job->hard_links);
+
   g_object_unref (job->preferences);
+  g_strfreev (job->range_mounts);
+
+  g_mutex_clear (&job->copy_mutex);
+  g_cond_clear (&job->copy_cond);
+  g_mutex_clear (&job->ask_mutex);
+  g_mutex_clear (&job->collect_mutex);
+  g_cond_clear (&job->collect_cond);
 
   (*G_OBJECT_CLASS (thunar_transfer_job_parent_class)->finalize) (object);
 }
@@ -230,6 +599,27 @@ thunar_transfer_job_get_property (GObject     *object,
     case PROP_PARALLEL_COPY_MODE:
       g_value_set_enum (value, job->parallel_copy_mode);
       break;
+    case PROP_JOBS_PER_DEVICE:
+      g_value_set_uint (value, job->jobs_per_device);
+      break;
+    case PROP_VERIFY:
+      g_value_set_boolean (value, job->verify);
+      break;
+    case PROP_BUFFER_SIZE:
+      g_value_set_uint (value, job->buffer_size);
+      break;
+    case PROP_PRESERVE_HARD_LINKS:
+      g_value_set_boolean (value, job->preserve_hard_links);
+      break;
+    case PROP_OVERLAP_COLLECTION:
+      g_value_set_boolean (value, job->overlap_collection);
+      break;
+    case PROP_RANGE_STREAMS:
+      g_value_set_uint (value, job->range_streams);
+      break;
+    case PROP_RANGE_MIN_SIZE:
+      g_value_set_uint (value, job->range_min_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -254,6 +644,27 @@ thunar_transfer_job_set_property (GObject      *object,
     case PROP_PARALLEL_COPY_MODE:
       job->parallel_copy_mode = g_value_get_enum (value);
       break;
+    case PROP_JOBS_PER_DEVICE:
+      job->jobs_per_device = g_value_get_uint (value);
+      break;
+    case PROP_VERIFY:
+      job->verify = g_value_get_boolean (value);
+      break;
+    case PROP_BUFFER_SIZE:
+      job->buffer_size = g_value_get_uint (value);
+      break;
+    case PROP_PRESERVE_HARD_LINKS:
+      job->preserve_hard_links = g_value_get_boolean (value);
+      break;
+    case PROP_OVERLAP_COLLECTION:
+      job->overlap_collection = g_value_get_boolean (value);
+      break;
+    case PROP_RANGE_STREAMS:
+      job->range_streams = g_value_get_uint (value);
+      break;
+    case PROP_RANGE_MIN_SIZE:
+      job->range_min_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -274,56 +685,176 @@ thunar_transfer_job_check_pause (ThunarTransferJob *job)
 
 
 
+static gboolean
+thunar_transfer_job_progress_timer (gpointer user_data)
+{
+  ThunarTransferJob *job = THUNAR_TRANSFER_JOB (user_data);
+  guint64            total_progress;
+  guint64            data_progress;
+  gdouble            transfer_rate;
+  gdouble            new_percentage;
+  gint64             current_time;
+  gint64             expired_time;
+
+  current_time = g_get_real_time ();
+  expired_time = current_time - job->last_update_time;
+  if (G_UNLIKELY (expired_time <= 0))
+    return TRUE;
+
+  g_mutex_lock (&job->copy_mutex);
+
+  total_progress = MIN (job->total_progress, job->total_size);
+  data_progress = total_progress - MIN (job->hole_progress, total_progress);
+
+  /* the exponential moving average of the rate in the last expired time,
+   * weighted by the time, so the output is less jumpy at any interval */
+  transfer_rate = (data_progress - MIN (job->last_data_progress, data_progress)) * ((gdouble) G_USEC_PER_SEC / expired_time);
+  if (job->transfer_rate > 0)
+    job->transfer_rate = ((job->transfer_rate * (gdouble) TRANSFER_RATE_TIME_CONSTANT) + (transfer_rate * expired_time))
+                         / (TRANSFER_RATE_TIME_CONSTANT + expired_time);
+  else
+    job->transfer_rate = transfer_rate;
+
+  g_mutex_unlock (&job->copy_mutex);
+
+  /* update internals */
+  job->last_update_time = current_time;
+  job->last_data_progress = data_progress;
+
+  /* emit the percent signal, we're in the main thread already */
+  new_percentage = (job->total_size > 0) ? (total_progress * 100.0) / job->total_size : 0.0;
+  g_signal_emit_by_name (job, "percent", new_percentage);
+
+  return TRUE;
+}
+
+
+
 static void
 thunar_transfer_job_progress (goffset  current_num_bytes,
                               goffset  total_num_bytes,
                               gpointer user_data)
 {
   ThunarTransferJob *job = user_data;
-  guint64            new_percentage;
-  gint64             current_time;
-  gint64             expired_time;
-  guint64            transfer_rate;
 
   _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
 
   thunar_transfer_job_check_pause (job);
 
-  if (G_LIKELY (job->total_size > 0))
-    {
-      /* update total progress */
-      job->total_progress += (current_num_bytes - job->file_progress);
+  /* only account the bytes, thunar_transfer_job_progress_timer()
+   * publishes them, so this stays cheap for every chunk */
+  g_mutex_lock (&job->copy_mutex);
 
-      /* update file progress */
-      job->file_progress = current_num_bytes;
+  /* update total progress */
+  job->total_progress += (current_num_bytes - job->file_progress);
 
-      /* compute the new percentage after the progress we've made */
-      new_percentage = (job->total_progress * 100.0) / job->total_size;
+  /* update file progress */
+  job->file_progress = current_num_bytes;
 
-      /* get current time */
-      current_time = g_get_real_time ();
-      expired_time = current_time - job->last_update_time;
+  g_mutex_unlock (&job->copy_mutex);
+}
 
-      /* notify callers not more then every 500ms */
-      if (expired_time > (500 * 1000))
-        {
-          /* calculate the transfer rate in the last expired time */
-          transfer_rate = (job->total_progress - job->last_total_progress) / ((gfloat) expired_time / G_USEC_PER_SEC);
 
-          /* take the average of the last 10 rates (5 sec), so the output is less jumpy */
-          if (job->transfer_rate > 0)
-            job->transfer_rate = ((job->transfer_rate * 10) + transfer_rate) / 11;
-          else
-            job->transfer_rate = transfer_rate;
 
-          /* emit the percent signal */
-          exo_job_percent (EXO_JOB (job), new_percentage);
+static ThunarJobResponse
+thunar_transfer_job_ask_replace (ThunarTransferJob *job,
+                                 GFile             *source_file,
+                                 GFile             *target_file,
+                                 GError           **error)
+{
+  ThunarJobResponse response;
 
-          /* update internals */
-          job->last_update_time = current_time;
-          job->last_total_progress = job->total_progress;
-        }
-    }
+  /* only one question at a time, even when the copy pool is running */
+  g_mutex_lock (&job->ask_mutex);
+  response = thunar_job_ask_replace (THUNAR_JOB (job), source_file, target_file, error);
+  g_mutex_unlock (&job->ask_mutex);
+
+  return response;
+}
+
+
+
+static ThunarJobResponse
+thunar_transfer_job_ask_resume (ThunarTransferJob *job,
+                                GFile             *target_file)
+{
+  ThunarJobResponse response;
+  gchar            *display_name;
+
+  display_name = thunar_g_file_get_display_name (target_file);
+
+  g_mutex_lock (&job->ask_mutex);
+  response = thunar_job_ask_resume (THUNAR_JOB (job), _("The file \"%s\" was only copied partially before"), display_name);
+  g_mutex_unlock (&job->ask_mutex);
+
+  g_free (display_name);
+
+  return response;
+}
+
+
+
+static ThunarJobResponse
+thunar_transfer_job_ask_skip (ThunarTransferJob *job,
+                              const gchar       *message)
+{
+  ThunarJobResponse response;
+
+  g_mutex_lock (&job->ask_mutex);
+  response = thunar_job_ask_skip (THUNAR_JOB (job), "%s", message);
+  g_mutex_unlock (&job->ask_mutex);
+
+  return response;
+}
+
+
+
+static void
+thunar_transfer_job_node_collected (ThunarTransferJob  *job,
+                                    ThunarTransferNode *node)
+{
+  /* wake up the copy waiting for the node, if any */
+  g_mutex_lock (&job->collect_mutex);
+  node->collected = TRUE;
+  g_cond_broadcast (&job->collect_cond);
+  g_mutex_unlock (&job->collect_mutex);
+}
+
+
+
+/**
+ * thunar_transfer_job_wait_collected:
+ * @job   : a #ThunarTransferJob.
+ * @node  : the #ThunarTransferNode to copy next.
+ * @error : return location for errors or %NULL.
+ *
+ * Waits until the collect thread has collected @node, if the job
+ * copies the files while they are collected.
+ *
+ * Return value: %FALSE if the collection failed before @node.
+ **/
+static gboolean
+thunar_transfer_job_wait_collected (ThunarTransferJob  *job,
+                                    ThunarTransferNode *node,
+                                    GError            **error)
+{
+  gboolean collected;
+
+  if (job->collect_thread == NULL)
+    return TRUE;
+
+  g_mutex_lock (&job->collect_mutex);
+
+  while (!node->collected && job->collecting)
+    g_cond_wait (&job->collect_cond, &job->collect_mutex);
+
+  collected = node->collected;
+  if (!collected && job->collect_error != NULL)
+    g_propagate_error (error, g_error_copy (job->collect_error));
+
+  g_mutex_unlock (&job->collect_mutex);
+
+  return collected;
 }
 
 
@@ -334,10 +865,14 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
                                   GError            **error)
 {
   ThunarTransferNode *child_node;
+  ThunarTransferNode *next_node;
   GFileInfo          *info;
   GError             *err = NULL;
   GList              *file_list;
   GList              *lp;
+  guint64             allocated_size;
+  gboolean            linked = FALSE;
+  gchar              *key;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
   _thunar_return_val_if_fail (node != NULL && G_IS_FILE (node->source_file), FALSE);
@@ -346,9 +881,20 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
 
+  /* the copy failed, so the collect thread is not needed anymore */
+  if (G_UNLIKELY (g_atomic_int_get (&job->collect_stop)))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CANCELLED, g_strerror (ECANCELED));
+      return FALSE;
+    }
+
   info = g_file_query_info (node->source_file,
                             G_FILE_ATTRIBUTE_STANDARD_SIZE ","
-                            G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                            G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE ","
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                            G_FILE_ATTRIBUTE_UNIX_DEVICE ","
+                            G_FILE_ATTRIBUTE_UNIX_INODE ","
+                            G_FILE_ATTRIBUTE_UNIX_NLINK,
                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                             exo_job_get_cancellable (EXO_JOB (job)),
                             &err);
@@ -356,7 +902,52 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
   if (G_UNLIKELY (info == NULL))
     return FALSE;
 
-  job->total_size += g_file_info_get_size (info);
+  node->size = g_file_info_get_size (info);
+
+  /* remember files with several hard links, they are copied only once */
+  if (job->preserve_hard_links
+      && g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR
+      && g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_NLINK) > 1)
+    {
+      key = g_strdup_printf ("%u:%" G_GUINT64_FORMAT,
+                             g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_DEVICE),
+                             g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE));
+      node->hard_link = g_hash_table_lookup (job->hard_links, key);
+      if (node->hard_link != NULL)
+        {
+          /* another link of a file collected before, which is linked
+           * at the target, so none of its data is transferred */
+          linked = TRUE;
+          g_free (key);
+        }
+      else
+        {
+          node->hard_link = g_slice_new0 (ThunarTransferHardLink);
+          g_hash_table_insert (job->hard_links, key, node->hard_link);
+        }
+    }
+
+  /* the totals are read by the progress timer while the files are
+   * collected by the collect thread */
+  g_mutex_lock (&job->copy_mutex);
+
+  if (!linked)
+    job->total_size += node->size;
+
+  /* files with less space allocated than their size have holes,
+   * which ttj_copy_file_local() skips instead of reading them */
+  if (!linked
+      && g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR
+      && g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE))
+    {
+      allocated_size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE);
+      if (allocated_size < node->size)
+        job->total_hole_size += node->size - allocated_size;
+    }
+
+  g_mutex_unlock (&job->copy_mutex);
+
+  g_atomic_int_inc (&job->n_files_total);
 
   /* check if we have a directory here */
   if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
@@ -369,8 +960,6 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
       /* add children to the transfer node */
       for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
         {
-          thunar_transfer_job_check_pause (job);
-
           /* allocate a new transfer node for the child */
           child_node = g_slice_new0 (ThunarTransferNode);
           child_node->source_file = g_object_ref (lp->data);
@@ -380,9 +969,6 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
           /* hook the child node into the child list */
           child_node->next = node->children;
           node->children = child_node;
-
-          /* collect the child node */
-          thunar_transfer_job_collect_node (job, child_node, &err);
         }
 
       /* release the child files */
@@ -392,6 +978,27 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
   /* release file info */
   g_object_unref (info);
 
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  /* the node can be copied now. it may be released by the copy
+   * as soon as all its children are collected too, so only the
+   * children are touched from here on */
+  child_node = node->children;
+  thunar_transfer_job_node_collected (job, node);
+
+  /* collect the children in the order in which they are copied */
+  for (; err == NULL && child_node != NULL; child_node = next_node)
+    {
+      thunar_transfer_job_check_pause (job);
+
+      next_node = child_node->next;
+      thunar_transfer_job_collect_node (job, child_node, &err);
+    }
+
   if (G_UNLIKELY (err != NULL))
     {
       g_propagate_error (error, err);
@@ -403,60 +1010,1611 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
 
 
 
-static gboolean
-ttj_copy_file (ThunarTransferJob *job,
-               GFile             *source_file,
-               GFile             *target_file,
-               GFileCopyFlags     copy_flags,
-               gboolean           merge_directories,
-               GError           **error)
+/* collects the source nodes of a copy while thunar_transfer_job_copy_node()
+ * already copies the nodes collected so far, see thunar_transfer_job_transfer() */
+static gpointer
+thunar_transfer_job_collect_thread (gpointer data)
 {
-  GFileType source_type;
-  GFileType target_type;
-  gboolean  target_exists;
-  GError   *err = NULL;
-
-  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
-  _thunar_return_val_if_fail (G_IS_FILE (source_file), FALSE);
-  _thunar_return_val_if_fail (G_IS_FILE (target_file), FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  ThunarTransferJob *job = THUNAR_TRANSFER_JOB (data);
+  GError            *err = NULL;
+  GList             *lp;
 
-  /* reset the file progress */
-  job->file_progress = 0;
+  for (lp = job->source_node_list; err == NULL && lp != NULL; lp = lp->next)
+    thunar_transfer_job_collect_node (job, lp->data, &err);
 
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
-  thunar_transfer_job_check_pause (job);
+  /* the nodes which are not collected by now never will be */
+  g_mutex_lock (&job->collect_mutex);
+  job->collecting = FALSE;
+  job->collect_error = err;
+  g_cond_broadcast (&job->collect_cond);
+  g_mutex_unlock (&job->collect_mutex);
 
-  source_type = g_file_query_file_type (source_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                        exo_job_get_cancellable (EXO_JOB (job)));
+  return NULL;
+}
 
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
-  thunar_transfer_job_check_pause (job);
 
-  target_type = g_file_query_file_type (target_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                        exo_job_get_cancellable (EXO_JOB (job)));
+
+/**
+ * ttj_link_file:
+ * @existing_file : a local file.
+ * @target_file   : the local destination, which must not exist yet.
+ *
+ * Creates @target_file as another hard link to @existing_file. This fails
+ * for remote files, across filesystems or if @target_file already exists,
+ * and the caller should copy the file instead then.
+ *
+ * Return value: %TRUE if the link was created, %FALSE otherwise.
+ **/
+static gboolean
+ttj_link_file (GFile *existing_file,
+               GFile *target_file)
+{
+  gboolean  linked = FALSE;
+  gchar    *existing_path;
+  gchar    *target_path;
+
+  existing_path = g_file_get_path (existing_file);
+  target_path = g_file_get_path (target_file);
+
+  if (existing_path != NULL && target_path != NULL)
+    linked = (link (existing_path, target_path) == 0);
+
+  g_free (existing_path);
+  g_free (target_path);
+
+  return linked;
+}
+
+
+
+/**
+ * ttj_copy_file_local:
+ * @job         : a #ThunarTransferJob.
+ * @source_file : the local regular file to copy.
+ * @target_file : the local destination, which must not exist yet.
+ * @progress    : whether to report the progress of the copy.
+ * @error       : return location for errors or %NULL.
+ *
+ * Copies the data of @source_file into a new @target_file without passing
+ * it through userspace: the file is cloned if the filesystem supports
+ * reflinks, otherwise the data is copied with copy_file_range() or
+ * sendfile(). The holes of sparse files are found with SEEK_DATA and
+ * SEEK_HOLE and recreated in @target_file instead of writing zeros.
+ *
+ * The space for larger files without holes is reserved with fallocate()
+ * before copying, so the target is allocated in few extents and a full
+ * disk is reported right away instead of at the end of the copy.
+ *
+ * If none of these methods work for the two files, %FALSE is returned
+ * without setting @error and the caller should fall back to g_file_copy().
+ *
+ * Return value: %TRUE if the file was copied, %FALSE otherwise.
+ **/
+static gboolean
+ttj_copy_file_local (ThunarTransferJob *job,
+                     GFile             *source_file,
+                     GFile             *target_file,
+                     gboolean           progress,
+                     GError           **error)
+{
+#if defined (FICLONE) || defined (HAVE_COPY_FILE_RANGE) || defined (HAVE_SYS_SENDFILE_H)
+  LocalCopyMethod method = LOCAL_COPY_FILE_RANGE;
+  struct stat     statb;
+  gboolean        cloned = FALSE;
+  gboolean        started = FALSE;
+  gboolean        sparse = FALSE;
+  gchar          *source_path;
+  gchar          *target_path;
+  goffset         offset = 0;
+  goffset         data_end;
+  off_t           in_offset;
+#ifdef HAVE_COPY_FILE_RANGE
+  off_t           out_offset;
+#endif
+#ifdef SEEK_DATA
+  goffset         data;
+#endif
+  gssize          n;
+  gsize           count;
+  gint            source_fd;
+  gint            target_fd;
+  gint            errsv = 0;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  source_path = g_file_get_path (source_file);
+  target_path = g_file_get_path (target_file);
+  if (G_UNLIKELY (source_path == NULL || target_path == NULL))
+    goto fallback;
+
+  /* leave all errors on opening the files to gio, so they
+   * are reported the same way as for other transfers */
+  source_fd = g_open (source_path, O_RDONLY | O_NOFOLLOW, 0);
+  if (G_UNLIKELY (source_fd < 0))
+    goto fallback;
+
+  if (fstat (source_fd, &statb) != 0 || !S_ISREG (statb.st_mode))
+    {
+      close (source_fd);
+      goto fallback;
+    }
+
+  target_fd = g_open (target_path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+  if (G_UNLIKELY (target_fd < 0))
+    {
+      close (source_fd);
+      goto fallback;
+    }
+
+#ifdef FICLONE
+  /* share the extents of the source if the filesystem supports it */
+  if (ioctl (target_fd, FICLONE, source_fd) == 0)
+    {
+      cloned = TRUE;
+      offset = statb.st_size;
+      if (progress)
+        thunar_transfer_job_progress (offset, statb.st_size, job);
+    }
+#endif
+
+#ifdef SEEK_DATA
+  /* only files with fewer blocks than their size can have holes */
+  sparse = ((goffset) statb.st_blocks * 512 < statb.st_size);
+#endif
+  data_end = sparse ? 0 : statb.st_size;
+
+#if defined (HAVE_FALLOCATE) && defined (FALLOC_FL_KEEP_SIZE)
+  /* reserve the space of the target, the size is only set by the data
+   * copied so a truncated source or an aborted copy is not padded */
+  if (!cloned && !sparse && statb.st_size >= LOCAL_PREALLOCATE_MIN_SIZE
+      && fallocate (target_fd, FALLOC_FL_KEEP_SIZE, 0, statb.st_size) != 0
+      && errno == ENOSPC)
+    errsv = ENOSPC;
+#endif
+
+  while (!cloned && errsv == 0 && offset < statb.st_size)
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        break;
+
+#ifdef SEEK_DATA
+      if (sparse && offset >= data_end)
+        {
+          /* find the next data extent, the hole before it is skipped */
+          data = lseek (source_fd, offset, SEEK_DATA);
+          if (data < 0 && errno == ENXIO)
+            {
+              /* only a hole is left up to the end of the file */
+              data = data_end = statb.st_size;
+            }
+          else if (data < 0)
+            {
+              /* the filesystem cannot tell, so copy everything */
+              sparse = FALSE;
+              data_end = statb.st_size;
+              continue;
+            }
+          else
+            {
+              data_end = lseek (source_fd, data, SEEK_HOLE);
+              if (data_end < 0)
+                data_end = statb.st_size;
+            }
+
+          if (data > offset)
+            {
+              g_mutex_lock (&job->copy_mutex);
+              job->hole_progress += data - offset;
+              g_mutex_unlock (&job->copy_mutex);
+
+              offset = data;
+              if (progress)
+                thunar_transfer_job_progress (offset, statb.st_size, job);
+            }
+          continue;
+        }
+#endif
+
+      count = MIN (data_end - offset, LOCAL_COPY_CHUNK_SIZE);
+
+      /* the offsets are explicit, so the holes are left in the target */
+      in_offset = offset;
+      n = -1;
+      errno = ENOSYS;
+#ifdef HAVE_COPY_FILE_RANGE
+      if (method == LOCAL_COPY_FILE_RANGE)
+        {
+          out_offset = offset;
+          n = copy_file_range (source_fd, &in_offset, target_fd, &out_offset, count, 0);
+        }
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+      if (method == LOCAL_COPY_SENDFILE)
+        {
+          if (lseek (target_fd, offset, SEEK_SET) == offset)
+            n = sendfile (target_fd, source_fd, &in_offset, count);
+        }
+#endif
+
+      if (G_UNLIKELY (n < 0))
+        {
+          if (errno == EINTR)
+            continue;
+
+          /* try the next method if the kernel or filesystem does not
+           * support this one, which is only reported on the first call */
+          if (!started
+              && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+            {
+              if (++method == LOCAL_COPY_NONE)
+                break;
+              continue;
+            }
+
+          errsv = errno;
+          break;
+        }
+
+      /* the source file was truncated while copying */
+      if (G_UNLIKELY (n == 0))
+        break;
+
+      started = TRUE;
+      offset += n;
+      if (progress)
+        thunar_transfer_job_progress (offset, statb.st_size, job);
+    }
+
+  close (source_fd);
+
+  if (G_LIKELY (errsv == 0 && method != LOCAL_COPY_NONE && !exo_job_is_cancelled (EXO_JOB (job))))
+    {
+      /* a hole at the end of the file is recreated by the size */
+      if (sparse && offset >= statb.st_size && ftruncate (target_fd, statb.st_size) != 0)
+        errsv = errno;
+
+      /* gio copies the permissions of the file too */
+      if (errsv == 0 && fchmod (target_fd, statb.st_mode & 07777) != 0 && errno != EPERM)
+        errsv = errno;
+
+      if (close (target_fd) != 0 && errsv == 0)
+        errsv = errno;
+
+      if (G_LIKELY (errsv == 0))
+        {
+          g_free (source_path);
+          g_free (target_path);
+          return TRUE;
+        }
+    }
+  else
+    {
+      close (target_fd);
+    }
+
+  /* remove the incomplete target file */
+  g_unlink (target_path);
+
+  if (!exo_job_set_error_if_cancelled (EXO_JOB (job), error) && errsv != 0)
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                 _("Error writing to file: %s"), g_strerror (errsv));
+
+fallback:
+  g_free (source_path);
+  g_free (target_path);
+#endif
+
+  return FALSE;
+}
+
+
+
+static gchar*
+ttj_get_share (GFile *file,
+               gsize *server_length)
+{
+  const gchar *authority;
+  const gchar *path;
+  gchar       *uri;
+  gchar       *share;
+
+  if (g_file_is_native (file))
+    return NULL;
+
+  /* the scheme and host, and the first folder, which is the share
+   * on smb:// and the like, e.g. "smb://server/share/" */
+  uri = g_file_get_uri (file);
+  authority = strstr (uri, "://");
+  if (G_UNLIKELY (authority == NULL))
+    {
+      g_free (uri);
+      return NULL;
+    }
+
+  authority += 3;
+  path = strchr (authority, '/');
+  if (path == NULL)
+    path = authority + strlen (authority);
+  *server_length = path - uri;
+
+  if (*path == '/')
+    {
+      path = strchr (path + 1, '/');
+      if (path == NULL)
+        path = uri + strlen (uri);
+    }
+
+  share = g_strndup (uri, path - uri);
+  g_free (uri);
+
+  return share;
+}
+
+
+
+/**
+ * ttj_copy_file_server_side:
+ * @job         : a #ThunarTransferJob.
+ * @source_file : the remote #GFile to copy.
+ * @target_file : the destination #GFile on the same server.
+ * @copy_flags  : the #GFileCopyFlags for the copy.
+ * @progress    : whether to report the progress of the copy.
+ * @error       : return location for errors or %NULL.
+ *
+ * Asks the server that stores both files to copy @source_file to
+ * @target_file, so the data is not downloaded and uploaded again through
+ * this machine. Only the copy of the GIO backend is used, which does
+ * whatever the protocol offers, like a COPY request on WebDAV, and
+ * reports %G_IO_ERROR_NOT_SUPPORTED otherwise. The shares for which
+ * this failed are remembered and not tried again.
+ *
+ * If the files are not on the same server or the backend cannot copy
+ * them itself, %FALSE is returned without setting @error and the caller
+ * should fall back to the regular copy.
+ *
+ * Return value: %TRUE if the file was copied, %FALSE otherwise.
+ **/
+static gboolean
+ttj_copy_file_server_side (ThunarTransferJob *job,
+                           GFile             *source_file,
+                           GFile             *target_file,
+                           GFileCopyFlags     copy_flags,
+                           gboolean           progress,
+                           GError           **error)
+{
+  GFileIface *iface;
+  gboolean    unsupported;
+  gboolean    copied = FALSE;
+  GError     *err = NULL;
+  gchar      *source_share;
+  gchar      *target_share;
+  gchar      *key;
+  gsize       source_length = 0;
+  gsize       target_length = 0;
+
+  source_share = ttj_get_share (source_file, &source_length);
+  target_share = ttj_get_share (target_file, &target_length);
+  if (source_share == NULL || target_share == NULL
+      || source_length != target_length
+      || strncmp (source_share, target_share, source_length) != 0
+      || G_TYPE_FROM_INSTANCE (source_file) != G_TYPE_FROM_INSTANCE (target_file))
+    {
+      g_free (source_share);
+      g_free (target_share);
+      return FALSE;
+    }
+
+  key = g_strconcat (source_share, " ", target_share, NULL);
+  g_free (source_share);
+  g_free (target_share);
+
+  g_mutex_lock (&server_copy_lock);
+  unsupported = (server_copy_unsupported != NULL
+                 && g_hash_table_contains (server_copy_unsupported, key));
+  g_mutex_unlock (&server_copy_lock);
+
+  /* not g_file_copy(), which falls back to streaming the data */
+  iface = G_FILE_GET_IFACE (target_file);
+  if (!unsupported && iface->copy != NULL)
+    {
+      copied = (*iface->copy) (source_file, target_file, copy_flags,
+                               exo_job_get_cancellable (EXO_JOB (job)),
+                               progress ? thunar_transfer_job_progress : NULL, job, &err);
+
+      if (!copied && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        {
+          g_clear_error (&err);
+
+          g_mutex_lock (&server_copy_lock);
+          if (server_copy_unsupported == NULL)
+            server_copy_unsupported = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+          g_hash_table_add (server_copy_unsupported, key);
+          key = NULL;
+          g_mutex_unlock (&server_copy_lock);
+        }
+      else if (!copied)
+        {
+          g_propagate_error (error, err);
+        }
+    }
+
+  g_free (key);
+
+  return copied;
+}
+
+
+
+/**
+ * ttj_get_resume_offset:
+ * @job         : a #ThunarTransferJob.
+ * @source_file : the #GFile to copy.
+ * @target_file : the existing target of an earlier copy.
+ *
+ * Checks whether @target_file is the partial copy of @source_file left by
+ * an interrupted ttj_copy_file_blocks(), by comparing the last block
+ * before the recorded checkpoint with its checksum in the journal.
+ *
+ * Return value: the offset to continue the copy from, or 0 if
+ *               @target_file cannot be resumed.
+ **/
+static guint64
+ttj_get_resume_offset (ThunarTransferJob *job,
+                       GFile             *source_file,
+                       GFile             *target_file)
+{
+  GFileInputStream *stream;
+  GFileInfo        *source_info;
+  GChecksum        *checksum;
+  guint64           offset = 0;
+  guchar           *buffer;
+  gchar            *journal_checksum = NULL;
+  gsize             n_read = 0;
+
+  source_info = g_file_query_info (source_file,
+                                   G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                   G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  if (G_UNLIKELY (source_info == NULL))
+    return 0;
+
+  if (thunar_transfer_journal_load (source_file, source_info, target_file, &offset, &journal_checksum))
+    {
+      stream = g_file_read (target_file, exo_job_get_cancellable (EXO_JOB (job)), NULL);
+      if (G_LIKELY (stream != NULL))
+        {
+          /* checkpoints are always at the end of a full block */
+          buffer = g_malloc (COPY_BLOCK_SIZE);
+          if (!g_seekable_seek (G_SEEKABLE (stream), offset - COPY_BLOCK_SIZE, G_SEEK_SET,
+                                exo_job_get_cancellable (EXO_JOB (job)), NULL)
+              || !g_input_stream_read_all (G_INPUT_STREAM (stream), buffer, COPY_BLOCK_SIZE, &n_read,
+                                           exo_job_get_cancellable (EXO_JOB (job)), NULL))
+            n_read = 0;
+
+          checksum = g_checksum_new (G_CHECKSUM_SHA1);
+          g_checksum_update (checksum, buffer, n_read);
+          if (n_read != COPY_BLOCK_SIZE || g_strcmp0 (g_checksum_get_string (checksum), journal_checksum) != 0)
+            offset = 0;
+          g_checksum_free (checksum);
+
+          g_free (buffer);
+          g_object_unref (stream);
+        }
+      else
+        {
+          offset = 0;
+        }
+
+      /* the partial target does not match, start over next time */
+      if (offset == 0)
+        thunar_transfer_journal_remove (target_file);
+
+      g_free (journal_checksum);
+    }
+
+  g_object_unref (source_info);
+
+  return offset;
+}
+
+
+
+static ThunarTransferPool *
+ttj_pool_new (guint max_blocks)
+{
+  ThunarTransferPool *pool;
+
+  pool = g_slice_new0 (ThunarTransferPool);
+  pool->spare = g_async_queue_new ();
+  pool->max_blocks = MAX (max_blocks, 2);
+
+  return pool;
+}
+
+
+
+static ThunarTransferBlock *
+ttj_pool_get_block (ThunarTransferPool *pool)
+{
+  ThunarTransferBlock *block;
+
+  /* blocks are only taken by one thread at a time, the thread
+   * reading the data, so n_blocks needs no lock */
+  block = g_async_queue_try_pop (pool->spare);
+  if (block == NULL)
+    {
+      /* wait for the other threads if enough blocks are in flight */
+      if (pool->n_blocks >= pool->max_blocks)
+        return g_async_queue_pop (pool->spare);
+
+      block = g_malloc (sizeof (ThunarTransferBlock));
+      pool->n_blocks++;
+    }
+
+  return block;
+}
+
+
+
+static void
+ttj_pool_put_block (ThunarTransferPool  *pool,
+                    ThunarTransferBlock *block)
+{
+  g_async_queue_push (pool->spare, block);
+}
+
+
+
+static void
+ttj_pool_free (ThunarTransferPool *pool)
+{
+  ThunarTransferBlock *block;
+
+  /* all blocks are back once the other threads are gone */
+  while ((block = g_async_queue_try_pop (pool->spare)) != NULL)
+    g_free (block);
+  g_async_queue_unref (pool->spare);
+  g_slice_free (ThunarTransferPool, pool);
+}
+
+
+
+static gpointer
+ttj_hasher_thread (gpointer data)
+{
+  ThunarTransferHasher *hasher = data;
+  ThunarTransferBlock  *block;
+
+  for (;;)
+    {
+      /* an empty block marks the end of the file */
+      block = g_async_queue_pop (hasher->blocks);
+      if (block->length == 0)
+        {
+          ttj_pool_put_block (hasher->pool, block);
+          break;
+        }
+
+      g_checksum_update (hasher->checksum, block->data, block->length);
+      ttj_pool_put_block (hasher->pool, block);
+    }
+
+  return NULL;
+}
+
+
+
+static ThunarTransferHasher *
+ttj_hasher_new (ThunarTransferPool *pool,
+                gboolean            threaded)
+{
+  ThunarTransferHasher *hasher;
+
+  hasher = g_slice_new0 (ThunarTransferHasher);
+  hasher->pool = pool;
+  hasher->checksum = g_checksum_new (G_CHECKSUM_MD5);
+
+  /* files of a single block are not worth a thread */
+  if (threaded)
+    {
+      hasher->blocks = g_async_queue_new ();
+      hasher->thread = g_thread_new ("ttj-hasher", ttj_hasher_thread, hasher);
+    }
+
+  return hasher;
+}
+
+
+
+static void
+ttj_hasher_push (ThunarTransferHasher *hasher,
+                 ThunarTransferBlock  *block)
+{
+  if (hasher->thread != NULL)
+    {
+      g_async_queue_push (hasher->blocks, block);
+    }
+  else
+    {
+      g_checksum_update (hasher->checksum, block->data, block->length);
+      ttj_pool_put_block (hasher->pool, block);
+    }
+}
+
+
+
+static gchar *
+ttj_hasher_finish (ThunarTransferHasher *hasher)
+{
+  ThunarTransferBlock *block;
+  gchar               *digest;
+
+  if (hasher->thread != NULL)
+    {
+      block = ttj_pool_get_block (hasher->pool);
+      block->length = 0;
+      g_async_queue_push (hasher->blocks, block);
+      g_thread_join (hasher->thread);
+      g_async_queue_unref (hasher->blocks);
+    }
+
+  digest = g_strdup (g_checksum_get_string (hasher->checksum));
+  g_checksum_free (hasher->checksum);
+  g_slice_free (ThunarTransferHasher, hasher);
+
+  return digest;
+}
+
+
+
+static gpointer
+ttj_reader_thread (gpointer data)
+{
+  ThunarTransferReader *reader = data;
+  ThunarTransferBlock  *block;
+  gsize                 length;
+
+  do
+    {
+      block = ttj_pool_get_block (reader->pool);
+      if (g_atomic_int_get (&reader->stopped)
+          || !g_input_stream_read_all (reader->input, block->data, COPY_BLOCK_SIZE,
+                                       &block->length, reader->cancellable, &reader->error))
+        block->length = 0;
+
+      /* an empty block marks the end of the file, the block is
+       * owned by the writer once it is pushed */
+      length = block->length;
+      g_async_queue_push (reader->blocks, block);
+    }
+  while (length > 0);
+
+  return NULL;
+}
+
+
+
+static ThunarTransferReader *
+ttj_reader_new (ThunarTransferPool *pool,
+                GInputStream       *input,
+                GCancellable       *cancellable)
+{
+  ThunarTransferReader *reader;
+
+  reader = g_slice_new0 (ThunarTransferReader);
+  reader->pool = pool;
+  reader->input = g_object_ref (input);
+  reader->cancellable = (cancellable != NULL) ? g_object_ref (cancellable) : NULL;
+  reader->blocks = g_async_queue_new ();
+  reader->thread = g_thread_new ("ttj-reader", ttj_reader_thread, reader);
+
+  return reader;
+}
+
+
+
+static ThunarTransferBlock *
+ttj_reader_pop (ThunarTransferReader *reader)
+{
+  ThunarTransferBlock *block;
+
+  if (G_UNLIKELY (reader->done))
+    return NULL;
+
+  block = g_async_queue_pop (reader->blocks);
+  if (block->length == 0)
+    {
+      ttj_pool_put_block (reader->pool, block);
+      reader->done = TRUE;
+      return NULL;
+    }
+
+  return block;
+}
+
+
+
+static void
+ttj_reader_finish (ThunarTransferReader  *reader,
+                   GError               **error)
+{
+  ThunarTransferBlock *block;
+
+  /* stop reading ahead and give back the blocks that were not written */
+  g_atomic_int_set (&reader->stopped, TRUE);
+  while ((block = ttj_reader_pop (reader)) != NULL)
+    ttj_pool_put_block (reader->pool, block);
+
+  g_thread_join (reader->thread);
+  g_async_queue_unref (reader->blocks);
+
+  if (reader->error != NULL)
+    {
+      if (error != NULL && *error == NULL)
+        g_propagate_error (error, reader->error);
+      else
+        g_error_free (reader->error);
+    }
+
+  if (reader->cancellable != NULL)
+    g_object_unref (reader->cancellable);
+  g_object_unref (reader->input);
+  g_slice_free (ThunarTransferReader, reader);
+}
+
+
+
+/**
+ * ttj_flush_target:
+ * @fd      : a file descriptor of the target.
+ * @flushed : the end of the data known to be on the device.
+ * @started : the end of the data the device is writing.
+ * @offset  : the end of the data written so far.
+ *
+ * Writes the data of a copy to a removable device while copying, instead
+ * of leaving it in the page cache until the device is unmounted. The
+ * written data is dropped from the page cache, so the copy does not push
+ * out everything else.
+ *
+ * If possible, the device writes one range in the background while the
+ * next range is copied.
+ **/
+static void
+ttj_flush_target (gint     fd,
+                  guint64 *flushed,
+                  guint64 *started,
+                  guint64  offset)
+{
+#ifdef HAVE_SYNC_FILE_RANGE
+  /* start writing the new range and wait for the previous one */
+  sync_file_range (fd, *started, offset - *started, SYNC_FILE_RANGE_WRITE);
+  if (*started > *flushed
+      && sync_file_range (fd, *flushed, *started - *flushed,
+                          SYNC_FILE_RANGE_WAIT_BEFORE
+                          | SYNC_FILE_RANGE_WRITE
+                          | SYNC_FILE_RANGE_WAIT_AFTER) == 0)
+    {
+#ifdef HAVE_POSIX_FADVISE
+      posix_fadvise (fd, *flushed, *started - *flushed, POSIX_FADV_DONTNEED);
+#endif
+      *flushed = *started;
+    }
+  *started = offset;
+#else
+  if (fdatasync (fd) == 0)
+    {
+#ifdef HAVE_POSIX_FADVISE
+      posix_fadvise (fd, *flushed, offset - *flushed, POSIX_FADV_DONTNEED);
+#endif
+      *flushed = offset;
+    }
+  *started = offset;
+#endif
+}
+
+
+
+/**
+ * ttj_hash_target:
+ * @job         : a #ThunarTransferJob.
+ * @target_file : the copied file.
+ * @size        : the size of the file.
+ * @error       : return location for errors or %NULL.
+ *
+ * Reads @target_file back and returns the checksum of its data. Local
+ * files are synced to disk and dropped from the page cache first, so the
+ * data is really read from the disk instead of from memory.
+ *
+ * Return value: the checksum of @target_file or %NULL on error.
+ **/
+static gchar *
+ttj_hash_target (ThunarTransferJob *job,
+                 GFile             *target_file,
+                 guint64            size,
+                 GError           **error)
+{
+  ThunarTransferHasher *hasher;
+  ThunarTransferBlock  *block;
+  ThunarTransferPool   *pool;
+  GFileInputStream     *stream;
+  GCancellable         *cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  gboolean              succeed = TRUE;
+  gchar                *digest;
+  gchar                *path;
+  gint                  fd;
+
+  path = g_file_get_path (target_file);
+  if (path != NULL)
+    {
+      fd = g_open (path, O_RDONLY, 0);
+      if (G_LIKELY (fd >= 0))
+        {
+          /* only clean pages can be dropped */
+          if (fsync (fd) == 0)
+            {
+#ifdef HAVE_POSIX_FADVISE
+              posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+            }
+          close (fd);
+        }
+      g_free (path);
+    }
+
+  stream = g_file_read (target_file, cancellable, error);
+  if (G_UNLIKELY (stream == NULL))
+    return NULL;
+
+  pool = ttj_pool_new (VERIFY_MAX_BLOCKS);
+  hasher = ttj_hasher_new (pool, size > COPY_BLOCK_SIZE);
+
+  for (;;)
+    {
+      block = ttj_pool_get_block (pool);
+      succeed = g_input_stream_read_all (G_INPUT_STREAM (stream), block->data, COPY_BLOCK_SIZE,
+                                         &block->length, cancellable, error);
+      if (!succeed || block->length == 0)
+        {
+          ttj_pool_put_block (pool, block);
+          break;
+        }
+
+      ttj_hasher_push (hasher, block);
+    }
+
+  g_object_unref (stream);
+
+  digest = ttj_hasher_finish (hasher);
+  ttj_pool_free (pool);
+  if (G_UNLIKELY (!succeed))
+    {
+      g_free (digest);
+      return NULL;
+    }
+
+  return digest;
+}
+
+
+
+/**
+ * ttj_copy_file_blocks:
+ * @job           : a #ThunarTransferJob.
+ * @source_file   : the regular file to copy.
+ * @source_info   : the #GFileInfo of @source_file, with its size and
+ *                  modification time.
+ * @target_file   : the destination of the copy.
+ * @copy_flags    : the #GFileCopyFlags of the copy.
+ * @resumable     : whether to record checkpoints for resuming the copy.
+ * @resume_offset : the offset returned by ttj_get_resume_offset() to
+ *                  continue an interrupted copy, or 0.
+ * @progress      : whether to report the progress of the copy.
+ * @error         : return location for errors or %NULL.
+ *
+ * Copies @source_file block by block. The source is read in a separate
+ * thread, up to #ThunarTransferJob:buffer-size ahead of the target.
+ *
+ * If @resumable is %TRUE, a checkpoint is recorded in the transfer journal
+ * every few blocks. If the copy is cancelled or fails, the partial target
+ * is kept once a checkpoint was recorded, so a later copy can continue
+ * from there instead of starting from byte zero.
+ *
+ * If the job verifies its copies, the source data is hashed in a separate
+ * thread while it is copied, and the target is read back afterwards and
+ * compared with it. The source is not read twice.
+ *
+ * Targets on removable devices are written to the device while copying,
+ * see ttj_flush_target(), and the progress only counts the data that
+ * reached the device.
+ *
+ * Return value: %TRUE if the file was copied, %FALSE otherwise.
+ **/
+static gboolean
+ttj_copy_file_blocks (ThunarTransferJob *job,
+                      GFile             *source_file,
+                      GFileInfo         *source_info,
+                      GFile             *target_file,
+                      GFileCopyFlags     copy_flags,
+                      gboolean           resumable,
+                      guint64            resume_offset,
+                      gboolean           progress,
+                      GError           **error)
+{
+  ThunarTransferHasher *hasher = NULL;
+  ThunarTransferReader *reader = NULL;
+  ThunarTransferBlock  *block;
+  ThunarTransferPool   *pool;
+  GFileInputStream     *input;
+  GFileIOStream        *iostream = NULL;
+  GOutputStream        *output = NULL;
+  GCancellable         *cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  gboolean              checkpointed = (resume_offset > 0);
+  guint64               size = g_file_info_get_size (source_info);
+  guint64               offset = 0;
+  guint64               flushed;
+  guint64               started;
+  GError               *err = NULL;
+  gchar                *source_digest = NULL;
+  gchar                *target_digest;
+  gchar                *display_name;
+  gchar                *block_checksum;
+  gchar                *path;
+  gint                  flush_fd = -1;
+  gint                  errsv;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  input = g_file_read (source_file, cancellable, &err);
+  if (G_UNLIKELY (input == NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  /* the buffer size is in MiB, which is one block each */
+  pool = ttj_pool_new (job->buffer_size * (1024 * 1024 / COPY_BLOCK_SIZE));
+  if (job->verify)
+    hasher = ttj_hasher_new (pool, size > COPY_BLOCK_SIZE);
+
+  if (resume_offset > 0)
+    {
+      /* drop whatever was written after the checkpoint */
+      iostream = g_file_open_readwrite (target_file, cancellable, &err);
+      if (G_LIKELY (iostream != NULL)
+          && g_seekable_truncate (G_SEEKABLE (iostream), resume_offset, cancellable, &err)
+          && g_seekable_seek (G_SEEKABLE (iostream), resume_offset, G_SEEK_SET, cancellable, &err))
+        {
+          output = g_object_ref (g_io_stream_get_output_stream (G_IO_STREAM (iostream)));
+        }
+
+      /* the data before the checkpoint has to be hashed too when verifying */
+      if (hasher == NULL)
+        {
+          if (output != NULL && g_seekable_seek (G_SEEKABLE (input), resume_offset, G_SEEK_SET, cancellable, &err))
+            offset = resume_offset;
+        }
+      else
+        {
+          while (output != NULL && err == NULL && offset < resume_offset)
+            {
+              block = ttj_pool_get_block (pool);
+              if (!g_input_stream_read_all (G_INPUT_STREAM (input), block->data, COPY_BLOCK_SIZE,
+                                            &block->length, cancellable, &err)
+                  || block->length == 0)
+                {
+                  ttj_pool_put_block (pool, block);
+                  break;
+                }
+
+              offset += block->length;
+              ttj_hasher_push (hasher, block);
+            }
+        }
+    }
+  else
+    {
+      /* replace the target by a new file, gio would only write to a
+       * temporary file that is deleted when the copy is interrupted */
+      if ((copy_flags & G_FILE_COPY_OVERWRITE) != 0
+          && !g_file_delete (target_file, cancellable, &err)
+          && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+        g_clear_error (&err);
+
+      if (resumable)
+        thunar_transfer_journal_remove (target_file);
+
+      if (G_LIKELY (err == NULL))
+        output = G_OUTPUT_STREAM (g_file_create (target_file, G_FILE_CREATE_NONE, cancellable, &err));
+    }
+
+  /* write targets on removable devices while copying */
+  if (output != NULL && !job->is_target_device_local && g_file_is_native (target_file))
+    {
+      path = g_file_get_path (target_file);
+      if (G_LIKELY (path != NULL))
+        flush_fd = g_open (path, O_WRONLY, 0);
+      g_free (path);
+    }
+  flushed = started = offset;
+
+  if (output != NULL && err == NULL && offset < size)
+    reader = ttj_reader_new (pool, G_INPUT_STREAM (input), cancellable);
+
+  while (reader != NULL && err == NULL && offset < size)
+    {
+      thunar_transfer_job_check_pause (job);
+
+      /* the source file was truncated while copying or could not be read */
+      block = ttj_reader_pop (reader);
+      if (block == NULL)
+        break;
+
+      if (!g_output_stream_write_all (output, block->data, block->length, NULL, cancellable, &err))
+        {
+          ttj_pool_put_block (pool, block);
+          break;
+        }
+
+      offset += block->length;
+      if (flush_fd >= 0 && offset - started >= FLUSH_RANGE_SIZE)
+        ttj_flush_target (flush_fd, &flushed, &started, offset);
+
+      if (progress)
+        thunar_transfer_job_progress (flush_fd >= 0 ? flushed : offset, size, job);
+
+      /* a checkpoint only counts once its data reached the target */
+      if (resumable && offset % RESUME_CHECKPOINT_SIZE == 0 && offset < size
+          && g_output_stream_flush (output, cancellable, &err))
+        {
+          block_checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, block->data, block->length);
+          thunar_transfer_journal_save (source_file, source_info, target_file, offset, block_checksum);
+          g_free (block_checksum);
+          checkpointed = TRUE;
+        }
+
+      /* the block belongs to the hash thread from now on */
+      if (hasher != NULL)
+        ttj_hasher_push (hasher, block);
+      else
+        ttj_pool_put_block (pool, block);
+    }
+
+  if (reader != NULL)
+    ttj_reader_finish (reader, &err);
+  if (hasher != NULL)
+    source_digest = ttj_hasher_finish (hasher);
+  ttj_pool_free (pool);
+
+  if (flush_fd >= 0)
+    {
+      /* the copy is only done once all of it is on the device */
+      if (err == NULL)
+        {
+          if (fdatasync (flush_fd) == 0)
+            {
+#ifdef HAVE_POSIX_FADVISE
+              posix_fadvise (flush_fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+              if (progress)
+                thunar_transfer_job_progress (offset, size, job);
+            }
+          else
+            {
+              errsv = errno;
+              g_set_error (&err, G_IO_ERROR, g_io_error_from_errno (errsv),
+                           _("Error writing to file: %s"), g_strerror (errsv));
+            }
+        }
+      close (flush_fd);
+    }
+
+  if (output != NULL)
+    {
+      /* don't hide the first error behind a failed close */
+      if (iostream != NULL)
+        g_io_stream_close (G_IO_STREAM (iostream), err == NULL ? cancellable : NULL, err == NULL ? &err : NULL);
+      else
+        g_output_stream_close (output, err == NULL ? cancellable : NULL, err == NULL ? &err : NULL);
+      g_object_unref (output);
+    }
+
+  if (iostream != NULL)
+    g_object_unref (iostream);
+  g_object_unref (input);
+
+  /* compare the target with the data that was read from the source */
+  if (source_digest != NULL && err == NULL)
+    {
+      target_digest = ttj_hash_target (job, target_file, offset, &err);
+      if (target_digest != NULL && g_strcmp0 (source_digest, target_digest) != 0)
+        {
+          display_name = thunar_g_file_get_display_name (target_file);
+          g_set_error (&err, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("The copy of \"%s\" does not match the original"), display_name);
+          g_free (display_name);
+
+          /* the partial target is broken, don't resume it */
+          checkpointed = FALSE;
+        }
+      g_free (target_digest);
+    }
+  g_free (source_digest);
+
+  if (G_LIKELY (err == NULL))
+    {
+      /* copy the attributes gio would copy with the file */
+      g_file_copy_attributes (source_file, target_file, copy_flags & ~G_FILE_COPY_OVERWRITE, cancellable, NULL);
+      if (resumable)
+        thunar_transfer_journal_remove (target_file);
+      return TRUE;
+    }
+
+  /* remove the partial target if it cannot be resumed */
+  if (!checkpointed && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_EXISTS))
+    {
+      g_file_delete (target_file, NULL, NULL);
+      if (resumable)
+        thunar_transfer_journal_remove (target_file);
+    }
+
+  g_propagate_error (error, err);
+  return FALSE;
+}
+
+
+
+/**
+ * ttj_get_range_streams:
+ * @job         : a #ThunarTransferJob.
+ * @source_file : the #GFile to copy.
+ * @size        : the size of @source_file.
+ *
+ * Looks up the number of streams to copy @source_file with, from the
+ * #ThunarTransferJob:range-streams and the entry of the range mounts
+ * with the longest URI @source_file is in.
+ *
+ * Return value: the number of streams, 1 for a regular copy.
+ **/
+static guint
+ttj_get_range_streams (ThunarTransferJob *job,
+                       GFile             *source_file,
+                       guint64            size)
+{
+  const gchar *value;
+  guint64      min_size = job->range_min_size;
+  guint        n_streams = job->range_streams;
+  gsize        length;
+  gsize        best_length = 0;
+  gchar       *end;
+  gchar       *uri;
+  guint        n;
+
+  if (g_file_is_native (source_file))
+    return 1;
+
+  if (job->range_mounts != NULL)
+    {
+      uri = g_file_get_uri (source_file);
+      for (n = 0; job->range_mounts[n] != NULL; ++n)
+        {
+          value = strchr (job->range_mounts[n], '=');
+          if (value == NULL)
+            continue;
+
+          length = value - job->range_mounts[n];
+          if (length <= best_length || strncmp (uri, job->range_mounts[n], length) != 0)
+            continue;
+
+          best_length = length;
+          n_streams = g_ascii_strtoull (value + 1, &end, 10);
+          if (*end == ',')
+            min_size = g_ascii_strtoull (end + 1, NULL, 10);
+          else
+            min_size = job->range_min_size;
+        }
+      g_free (uri);
+    }
+
+  if (size < min_size * 1024 * 1024 || size < 2 * RANGE_CHUNK_SIZE)
+    return 1;
+
+  return CLAMP (n_streams, 1, RANGE_MAX_STREAMS);
+}
+
+
+
+static gpointer
+ttj_range_thread (gpointer data)
+{
+  ThunarTransferRanges *ranges = data;
+  GFileInputStream     *input;
+  GFileIOStream        *iostream = NULL;
+  GOutputStream        *output;
+  guint64               offset;
+  guint64               end;
+  GError               *err = NULL;
+  gssize                n_read;
+  gchar                *buffer;
+
+  input = g_file_read (ranges->source_file, ranges->cancellable, &err);
+  if (G_LIKELY (input != NULL))
+    iostream = g_file_open_readwrite (ranges->target_file, ranges->cancellable, &err);
+
+  buffer = g_malloc (COPY_BLOCK_SIZE);
+  while (iostream != NULL && err == NULL)
+    {
+      /* take the next chunk of the file */
+      g_mutex_lock (&ranges->lock);
+      offset = ranges->next_offset;
+      end = MIN (offset + RANGE_CHUNK_SIZE, ranges->size);
+      ranges->next_offset = end;
+      g_mutex_unlock (&ranges->lock);
+
+      if (offset >= end || g_atomic_int_get (&ranges->failed))
+        break;
+
+      if (!g_seekable_seek (G_SEEKABLE (input), offset, G_SEEK_SET, ranges->cancellable, &err)
+          || !g_seekable_seek (G_SEEKABLE (iostream), offset, G_SEEK_SET, ranges->cancellable, &err))
+        break;
+
+      output = g_io_stream_get_output_stream (G_IO_STREAM (iostream));
+      while (offset < end && !g_atomic_int_get (&ranges->failed))
+        {
+          thunar_transfer_job_check_pause (ranges->job);
+
+          n_read = g_input_stream_read (G_INPUT_STREAM (input), buffer, MIN (COPY_BLOCK_SIZE, end - offset),
+                                        ranges->cancellable, &err);
+          if (n_read <= 0)
+            {
+              /* the source file was truncated while copying */
+              if (n_read == 0)
+                g_set_error (&err, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             _("The file was changed while it was copied"));
+              break;
+            }
+
+          if (!g_output_stream_write_all (output, buffer, n_read, NULL, ranges->cancellable, &err))
+            break;
+
+          offset += n_read;
+
+          g_mutex_lock (&ranges->lock);
+          ranges->copied += n_read;
+          g_cond_signal (&ranges->cond);
+          g_mutex_unlock (&ranges->lock);
+        }
+    }
+  g_free (buffer);
+
+  if (iostream != NULL)
+    {
+      g_io_stream_close (G_IO_STREAM (iostream), err == NULL ? ranges->cancellable : NULL, err == NULL ? &err : NULL);
+      g_object_unref (iostream);
+    }
+  if (input != NULL)
+    g_object_unref (input);
+
+  /* keep the first error, which stops the other streams too */
+  g_mutex_lock (&ranges->lock);
+  if (err != NULL)
+    {
+      g_atomic_int_set (&ranges->failed, TRUE);
+      if (ranges->error == NULL)
+        ranges->error = g_steal_pointer (&err);
+      g_clear_error (&err);
+    }
+  ranges->n_running--;
+  g_cond_signal (&ranges->cond);
+  g_mutex_unlock (&ranges->lock);
+
+  return NULL;
+}
+
+
+
+/**
+ * ttj_copy_file_ranges:
+ * @job         : a #ThunarTransferJob.
+ * @source_file : the remote #GFile to copy.
+ * @source_info : the #GFileInfo of @source_file with its size.
+ * @target_file : the destination #GFile.
+ * @copy_flags  : the #GFileCopyFlags for the copy.
+ * @n_streams   : the number of streams, see ttj_get_range_streams().
+ * @progress    : whether to report the progress of the copy.
+ * @error       : return location for errors or %NULL.
+ *
+ * Copies @source_file with @n_streams streams at the same time, each of
+ * them reading other chunks of the file and writing them at the same
+ * offset of @target_file. On links with a high latency a single stream
+ * only uses a fraction of the bandwidth.
+ *
+ * If the source cannot seek, or the target cannot be resized and opened
+ * for writing at an offset, %FALSE is returned without setting @error
+ * and the caller should fall back to a copy with a single stream.
+ *
+ * Return value: %TRUE if the file was copied, %FALSE otherwise.
+ **/
+static gboolean
+ttj_copy_file_ranges (ThunarTransferJob *job,
+                      GFile             *source_file,
+                      GFileInfo         *source_info,
+                      GFile             *target_file,
+                      GFileCopyFlags     copy_flags,
+                      guint              n_streams,
+                      gboolean           progress,
+                      GError           **error)
+{
+  ThunarTransferRanges  ranges = { 0, };
+  GFileOutputStream    *output;
+  GFileInputStream     *input;
+  GFileIOStream        *iostream;
+  GCancellable         *cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  gboolean              seekable;
+  GThread             **threads;
+  guint64               copied;
+  GError               *err = NULL;
+  guint                 n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (n_streams > 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  input = g_file_read (source_file, cancellable, &err);
+  if (G_UNLIKELY (input == NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  seekable = g_seekable_can_seek (G_SEEKABLE (input));
+  g_object_unref (input);
+  if (!seekable)
+    return FALSE;
+
+  if ((copy_flags & G_FILE_COPY_OVERWRITE) != 0
+      && !g_file_delete (target_file, cancellable, &err)
+      && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+    g_clear_error (&err);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  /* create the target with its final size, so every stream can write
+   * its chunks at their offset */
+  output = g_file_create (target_file, G_FILE_CREATE_NONE, cancellable, &err);
+  if (G_UNLIKELY (output == NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  seekable = (g_seekable_can_truncate (G_SEEKABLE (output))
+              && g_seekable_truncate (G_SEEKABLE (output), g_file_info_get_size (source_info), cancellable, NULL));
+  g_output_stream_close (G_OUTPUT_STREAM (output), cancellable, seekable ? &err : NULL);
+  g_object_unref (output);
+
+  /* the backend has to write at an offset of an existing file */
+  if (seekable && err == NULL)
+    {
+      iostream = g_file_open_readwrite (target_file, cancellable, &err);
+      if (iostream != NULL)
+        {
+          seekable = g_seekable_can_seek (G_SEEKABLE (iostream));
+          g_io_stream_close (G_IO_STREAM (iostream), NULL, NULL);
+          g_object_unref (iostream);
+        }
+      else if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        {
+          seekable = FALSE;
+          g_clear_error (&err);
+        }
+    }
+
+  if (!seekable || err != NULL)
+    {
+      g_file_delete (target_file, NULL, NULL);
+      if (err != NULL)
+        g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  ranges.job = job;
+  ranges.source_file = source_file;
+  ranges.target_file = target_file;
+  ranges.cancellable = cancellable;
+  ranges.size = g_file_info_get_size (source_info);
+  ranges.n_running = n_streams;
+  g_mutex_init (&ranges.lock);
+  g_cond_init (&ranges.cond);
+
+  threads = g_new (GThread *, n_streams);
+  for (n = 0; n < n_streams; ++n)
+    threads[n] = g_thread_new ("ttj-range", ttj_range_thread, &ranges);
+
+  /* report the progress of all the streams until they are done */
+  g_mutex_lock (&ranges.lock);
+  while (ranges.n_running > 0)
+    {
+      g_cond_wait_until (&ranges.cond, &ranges.lock,
+                         g_get_monotonic_time () + PROGRESS_UPDATE_INTERVAL * G_TIME_SPAN_MILLISECOND);
+      copied = ranges.copied;
+
+      if (progress)
+        {
+          g_mutex_unlock (&ranges.lock);
+          thunar_transfer_job_progress (copied, ranges.size, job);
+          g_mutex_lock (&ranges.lock);
+        }
+    }
+  g_mutex_unlock (&ranges.lock);
+
+  for (n = 0; n < n_streams; ++n)
+    g_thread_join (threads[n]);
+  g_free (threads);
+
+  g_mutex_clear (&ranges.lock);
+  g_cond_clear (&ranges.cond);
+
+  if (G_LIKELY (ranges.error == NULL))
+    {
+      /* copy the attributes gio would copy with the file */
+      g_file_copy_attributes (source_file, target_file, copy_flags & ~G_FILE_COPY_OVERWRITE, cancellable, NULL);
+      return TRUE;
+    }
+
+  g_file_delete (target_file, NULL, NULL);
+  g_propagate_error (error, ranges.error);
+  return FALSE;
+}
+
+
+
+static gboolean
+ttj_copy_file (ThunarTransferJob *job,
+               GFile             *source_file,
+               GFile             *target_file,
+               GFileCopyFlags     copy_flags,
+               gboolean           merge_directories,
+               guint64            resume_offset,
+               gboolean           progress,
+               GError           **error)
+{
+  GFileInfo *source_info;
+  GFileType  source_type = G_FILE_TYPE_UNKNOWN;
+  GFileType  target_type;
+  gboolean   target_exists;
+  gboolean   resumable;
+  gboolean   copied = FALSE;
+  GError    *err = NULL;
+  guint      n_streams;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (source_file), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (target_file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* reset the file progress */
+  if (progress)
+    job->file_progress = 0;
 
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
   thunar_transfer_job_check_pause (job);
 
+  source_info = g_file_query_info (source_file,
+                                   G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                   G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                   G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  if (G_LIKELY (source_info != NULL))
+    source_type = g_file_info_get_file_type (source_info);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      if (source_info != NULL)
+        g_object_unref (source_info);
+      return FALSE;
+    }
+  thunar_transfer_job_check_pause (job);
+
+  target_type = g_file_query_file_type (target_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                        exo_job_get_cancellable (EXO_JOB (job)));
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      if (source_info != NULL)
+        g_object_unref (source_info);
+      return FALSE;
+    }
+  thunar_transfer_job_check_pause (job);
+
   /* check if the target is a symlink and we are in overwrite mode */
   if (target_type == G_FILE_TYPE_SYMBOLIC_LINK && (copy_flags & G_FILE_COPY_OVERWRITE) != 0)
     {
       /* try to delete the symlink */
       if (!g_file_delete (target_file, exo_job_get_cancellable (EXO_JOB (job)), &err))
         {
+          if (source_info != NULL)
+            g_object_unref (source_info);
           g_propagate_error (error, err);
           return FALSE;
         }
+      target_type = G_FILE_TYPE_UNKNOWN;
+    }
+
+  /* large files from or to remote devices are copied in blocks with
+   * checkpoints, so an interrupted copy does not start from byte zero */
+  resumable = (source_type == G_FILE_TYPE_REGULAR
+               && (resume_offset > 0
+                   || ((guint64) g_file_info_get_size (source_info) >= RESUME_MIN_FILE_SIZE
+                       && !(job->is_source_device_local && job->is_target_device_local))));
+
+  /* files moved around on the same server are copied by the server if
+   * it can, instead of downloading and uploading them again */
+  if (source_type == G_FILE_TYPE_REGULAR
+      && resume_offset == 0
+      && !job->verify
+      && (target_type == G_FILE_TYPE_UNKNOWN || target_type == G_FILE_TYPE_REGULAR))
+    {
+      copied = ttj_copy_file_server_side (job, source_file, target_file,
+                                          copy_flags, progress, &err);
+    }
+
+  /* large remote files are copied with several streams at once, which
+   * uses much more of a link with a high latency than a single stream */
+  if (!copied && err == NULL
+      && source_type == G_FILE_TYPE_REGULAR
+      && resume_offset == 0
+      && !job->verify
+      && (target_type == G_FILE_TYPE_UNKNOWN || target_type == G_FILE_TYPE_REGULAR))
+    {
+      n_streams = ttj_get_range_streams (job, source_file, g_file_info_get_size (source_info));
+      if (n_streams > 1)
+        copied = ttj_copy_file_ranges (job, source_file, source_info, target_file,
+                                       copy_flags, n_streams, progress, &err);
+    }
+
+  /* verified copies are hashed while they are copied in blocks, and files
+   * copied to removable devices are written to the device while copying */
+  if (!copied && err == NULL
+      && source_type == G_FILE_TYPE_REGULAR
+      && (resumable
+          || job->verify
+          || (job->device_info_valid && !job->is_target_device_local && g_file_is_native (target_file)))
+      && (target_type == G_FILE_TYPE_UNKNOWN || target_type == G_FILE_TYPE_REGULAR))
+    {
+      copied = ttj_copy_file_blocks (job, source_file, source_info, target_file,
+                                     copy_flags, resumable, resume_offset, progress, &err);
+    }
+
+  if (source_info != NULL)
+    g_object_unref (source_info);
+
+  /* let the kernel copy local files into new targets, this also takes
+   * care of reflinks on filesystems like btrfs or xfs */
+  if (!copied && err == NULL
+      && source_type == G_FILE_TYPE_REGULAR
+      && target_type == G_FILE_TYPE_UNKNOWN
+      && g_file_is_native (source_file)
+      && g_file_is_native (target_file))
+    {
+      copied = ttj_copy_file_local (job, source_file, target_file, progress, &err);
     }
 
   /* try to copy the file */
-  g_file_copy (source_file, target_file, copy_flags,
-               exo_job_get_cancellable (EXO_JOB (job)),
-               thunar_transfer_job_progress, job, &err);
+  if (!copied && err == NULL)
+    {
+      g_file_copy (source_file, target_file, copy_flags,
+                   exo_job_get_cancellable (EXO_JOB (job)),
+                   progress ? thunar_transfer_job_progress : NULL, job, &err);
+    }
 
   /* check if there were errors */
   if (G_UNLIKELY (err != NULL && err->domain == G_IO_ERROR))
@@ -521,6 +2679,7 @@ ttj_copy_file (ThunarTransferJob *job,
     }
   else
     {
+      g_atomic_int_inc (&job->n_files_done);
       return TRUE;
     }
 }
@@ -534,6 +2693,7 @@ ttj_copy_file (ThunarTransferJob *job,
  * @target_file        : the destination #GFile to copy to.
  * @replace_confirmed  : whether the user has already confirmed that this file should replace an existing one
  * @rename_confirmed   : whether the user has already confirmed that this file should be renamed to a new unique file name
+ * @progress           : whether to report the progress of the copy.
  * @error              : return location for errors or %NULL.
  *
  * Tries to copy @source_file to @target_file. The real destination is the
@@ -559,12 +2719,14 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
                                GFile             *target_file,
                                gboolean           replace_confirmed,
                                gboolean           rename_confirmed,
+                               gboolean           progress,
                                GError           **error)
 {
   ThunarJobResponse response;
   GFile            *dest_file = target_file;
   GFileCopyFlags    copy_flags = G_FILE_COPY_NOFOLLOW_SYMLINKS;
   GError           *err = NULL;
+  guint64           resume_offset = 0;
   gint              n;
   gint              n_rename = 0;
 
@@ -584,7 +2746,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
       if (G_LIKELY (!g_file_equal (source_file, dest_file)))
         {
           /* try to copy the file from source_file to the dest_file */
-          if (ttj_copy_file (job, source_file, dest_file, copy_flags, TRUE, &err))
+          if (ttj_copy_file (job, source_file, dest_file, copy_flags, TRUE, resume_offset, progress, &err))
             {
               /* return the real target file */
               return g_object_ref (dest_file);
@@ -602,7 +2764,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
               if (err == NULL)
                 {
                   /* try to copy the file from source file to the duplicate file */
-                  if (ttj_copy_file (job, source_file, duplicate_file, copy_flags, FALSE, &err))
+                  if (ttj_copy_file (job, source_file, duplicate_file, copy_flags, FALSE, 0, progress, &err))
                     {
                       /* return the real target file */
                       return duplicate_file;
@@ -625,54 +2787,220 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
           /* reset the error */
           g_clear_error (&err);
 
+          /* the target may be left from an interrupted copy of the source */
+          resume_offset = 0;
+          if (!replace_confirmed && !rename_confirmed)
+            resume_offset = ttj_get_resume_offset (job, source_file, dest_file);
+
           /* if necessary, ask the user whether to replace or rename the target file */
           if (replace_confirmed)
             response = THUNAR_JOB_RESPONSE_REPLACE;
           else if (rename_confirmed)
             response = THUNAR_JOB_RESPONSE_RENAME;
+          else if (resume_offset > 0)
+            response = thunar_transfer_job_ask_resume (job, dest_file);
           else
-            response = thunar_job_ask_replace (THUNAR_JOB (job), source_file,
-                                               dest_file, &err);
+            response = thunar_transfer_job_ask_replace (job, source_file,
+                                                        dest_file, &err);
+
+          if (err != NULL)
+            break;
+
+          /* continue the copy from the last checkpoint */
+          if (response == THUNAR_JOB_RESPONSE_RESUME)
+            continue;
+          resume_offset = 0;
+
+          /* add overwrite flag and retry if we should overwrite */
+          if (response == THUNAR_JOB_RESPONSE_REPLACE)
+            {
+              copy_flags |= G_FILE_COPY_OVERWRITE;
+              continue;
+            }
+          else if (response == THUNAR_JOB_RESPONSE_RENAME)
+            {
+              GFile *renamed_file;
+              renamed_file = thunar_io_jobs_util_next_renamed_file (THUNAR_JOB (job),
+                                                                    source_file,
+                                                                    dest_file,
+                                                                    ++n_rename, &err);
+              if (renamed_file != NULL)
+                {
+                  if (err != NULL)
+                    g_object_unref (renamed_file);
+                  else
+                    {
+                      dest_file = renamed_file;
+                      rename_confirmed = TRUE;
+                    }
+                }
+            }
+
+          /* tell the caller we skipped the file if the user
+           * doesn't want to retry/overwrite */
+          if (response == THUNAR_JOB_RESPONSE_SKIP)
+            return g_object_ref (source_file);
+        }
+    }
+
+  _thunar_assert (err != NULL);
+
+  g_propagate_error (error, err);
+  return NULL;
+}
+
+
+
+static void
+thunar_transfer_job_copy_worker (gpointer data,
+                                 gpointer user_data)
+{
+  ThunarTransferCopy *copy = data;
+  ThunarTransferJob  *job = THUNAR_TRANSFER_JOB (user_data);
+  ThunarJobResponse   response;
+  GError             *err = NULL;
+  GFile              *real_target_file;
+
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    goto done;
+
+retry_copy:
+  thunar_transfer_job_check_pause (job);
+
+  /* copy the file, the progress is updated when we're done */
+  real_target_file = thunar_transfer_job_copy_file (job, copy->source_file,
+                                                    copy->target_file,
+                                                    copy->replace_confirmed,
+                                                    copy->rename_confirmed,
+                                                    FALSE, &err);
+  if (G_LIKELY (real_target_file != NULL))
+    {
+      /* copy->source_file == real_target_file means to skip the file */
+      if (G_LIKELY (copy->source_file != real_target_file))
+        {
+          /* notify the thumbnail cache of the copy operation */
+          thunar_thumbnail_cache_copy_file (copy->thumbnail_cache,
+                                            copy->source_file,
+                                            real_target_file);
+        }
+
+      g_object_unref (real_target_file);
+    }
+  else if (err != NULL)
+    {
+      /* we can only skip if there is space left on the device */
+      if (err->domain != G_IO_ERROR || err->code != G_IO_ERROR_NO_SPACE)
+        {
+          /* ask the user to skip this file */
+          response = thunar_transfer_job_ask_skip (job, err->message);
+
+          /* reset the error */
+          g_clear_error (&err);
+
+          /* check whether to retry */
+          if (G_UNLIKELY (response == THUNAR_JOB_RESPONSE_RETRY))
+            goto retry_copy;
+        }
+    }
+
+done:
+  g_mutex_lock (&job->copy_mutex);
+
+  /* remember the first error, this stops the job */
+  if (G_UNLIKELY (err != NULL))
+    {
+      if (job->copy_error == NULL)
+        job->copy_error = err;
+      else
+        g_error_free (err);
+    }
+
+  job->total_progress += copy->size;
+  job->n_copies--;
+  g_cond_signal (&job->copy_cond);
+
+  g_mutex_unlock (&job->copy_mutex);
+
+  g_object_unref (copy->source_file);
+  g_object_unref (copy->target_file);
+  g_object_unref (copy->thumbnail_cache);
+  g_slice_free (ThunarTransferCopy, copy);
+}
+
+
+
+static gboolean
+thunar_transfer_job_copy_push (ThunarTransferJob    *job,
+                               ThunarTransferNode   *node,
+                               GFile                *target_file,
+                               ThunarThumbnailCache *thumbnail_cache,
+                               GError              **error)
+{
+  ThunarTransferCopy *copy;
+  GError             *err = NULL;
+
+  g_mutex_lock (&job->copy_mutex);
+
+  /* don't queue more than a couple of copies per thread, so
+   * the progress stays close to what was really copied */
+  while (job->n_copies >= 4 * job->copy_pool_size && job->copy_error == NULL)
+    g_cond_wait (&job->copy_cond, &job->copy_mutex);
+
+  /* stop when one of the copies failed */
+  if (G_UNLIKELY (job->copy_error != NULL))
+    {
+      err = job->copy_error;
+      job->copy_error = NULL;
+    }
+  else
+    {
+      job->n_copies++;
+    }
+
+  g_mutex_unlock (&job->copy_mutex);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  copy = g_slice_new0 (ThunarTransferCopy);
+  copy->source_file = g_object_ref (node->source_file);
+  copy->target_file = g_object_ref (target_file);
+  copy->size = node->size;
+  copy->replace_confirmed = node->replace_confirmed;
+  copy->rename_confirmed = node->rename_confirmed;
+  copy->thumbnail_cache = g_object_ref (thumbnail_cache);
 
-          if (err != NULL)
-            break;
+  g_thread_pool_push (job->copy_pool, copy, NULL);
 
-          /* add overwrite flag and retry if we should overwrite */
-          if (response == THUNAR_JOB_RESPONSE_REPLACE)
-            {
-              copy_flags |= G_FILE_COPY_OVERWRITE;
-              continue;
-            }
-          else if (response == THUNAR_JOB_RESPONSE_RENAME)
-            {
-              GFile *renamed_file;
-              renamed_file = thunar_io_jobs_util_next_renamed_file (THUNAR_JOB (job),
-                                                                    source_file,
-                                                                    dest_file,
-                                                                    ++n_rename, &err);
-              if (renamed_file != NULL)
-                {
-                  if (err != NULL)
-                    g_object_unref (renamed_file);
-                  else
-                    {
-                      dest_file = renamed_file;
-                      rename_confirmed = TRUE;
-                    }
-                }
-            }
+  return TRUE;
+}
 
-          /* tell the caller we skipped the file if the user
-           * doesn't want to retry/overwrite */
-          if (response == THUNAR_JOB_RESPONSE_SKIP)
-            return g_object_ref (source_file);
-        }
-    }
 
-  _thunar_assert (err != NULL);
 
-  g_propagate_error (error, err);
-  return NULL;
+static void
+thunar_transfer_job_copy_wait (ThunarTransferJob *job,
+                               GError           **error)
+{
+  GError *err = NULL;
+
+  /* wait until all copies in flight are done */
+  g_mutex_lock (&job->copy_mutex);
+  while (job->n_copies > 0)
+    g_cond_wait (&job->copy_cond, &job->copy_mutex);
+  err = job->copy_error;
+  job->copy_error = NULL;
+  g_mutex_unlock (&job->copy_mutex);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      if (error != NULL && *error == NULL)
+        g_propagate_error (error, err);
+      else
+        g_error_free (err);
+    }
 }
 
 
@@ -711,6 +3039,10 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
 
   for (; err == NULL && node != NULL; node = node->next)
     {
+      /* the node may still be collected by the collect thread */
+      if (!thunar_transfer_job_wait_collected (job, node, &err))
+        break;
+
       /* guess the target file for this node (unless already provided) */
       if (G_LIKELY (target_file == NULL))
         {
@@ -721,6 +3053,21 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
       else
         target_file = g_object_ref (target_file);
 
+      /* hand small files and empty directories below the toplevel over to the
+       * copy pool, their parent directory has already been created by now.
+       * Hard links are copied here, so the first one is copied before the others */
+      if (job->copy_pool != NULL
+          && target_parent_file != NULL
+          && node->children == NULL
+          && node->hard_link == NULL
+          && node->size <= PIPELINE_MAX_FILE_SIZE)
+        {
+          thunar_transfer_job_copy_push (job, node, target_file, thumbnail_cache, &err);
+          g_object_unref (target_file);
+          target_file = NULL;
+          continue;
+        }
+
       /* query file info */
       info = g_file_query_info (node->source_file,
                                 G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
@@ -741,12 +3088,31 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
 retry_copy:
       thunar_transfer_job_check_pause (job);
 
-      /* copy the item specified by this node (not recursively) */
-      real_target_file = thunar_transfer_job_copy_file (job, node->source_file,
-                                                        target_file,
-                                                        node->replace_confirmed,
-                                                        node->rename_confirmed,
-                                                        &err);
+      /* link to the copy of another hard link of the source file, or
+       * copy the item specified by this node (not recursively) */
+      if (node->hard_link != NULL
+          && node->hard_link->target_file != NULL
+          && ttj_link_file (node->hard_link->target_file, target_file))
+        {
+          real_target_file = g_object_ref (target_file);
+          g_atomic_int_inc (&job->n_files_done);
+        }
+      else
+        {
+          real_target_file = thunar_transfer_job_copy_file (job, node->source_file,
+                                                            target_file,
+                                                            node->replace_confirmed,
+                                                            node->rename_confirmed,
+                                                            TRUE, &err);
+
+          /* the other links of the source file are linked to this copy */
+          if (node->hard_link != NULL
+              && node->hard_link->target_file == NULL
+              && real_target_file != NULL
+              && real_target_file != node->source_file)
+            node->hard_link->target_file = g_object_ref (real_target_file);
+        }
+
       if (G_LIKELY (real_target_file != NULL))
         {
           /* node->source_file == real_target_file means to skip the file */
@@ -823,7 +3189,7 @@ retry_remove:
           if (err->domain != G_IO_ERROR || err->code != G_IO_ERROR_NO_SPACE)
             {
               /* ask the user to skip this node and all subnodes */
-              response = thunar_job_ask_skip (THUNAR_JOB (job), "%s", err->message);
+              response = thunar_transfer_job_ask_skip (job, err->message);
 
               /* reset the error */
               g_clear_error (&err);
@@ -856,7 +3222,6 @@ static gboolean
 thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
                                         GError            **error)
 {
-  GFileInfo         *filesystem_info;
   guint64            free_space;
   GFile             *dest;
   GFileInfo         *dest_info;
@@ -879,14 +3244,12 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
    * although not all files are checked, this should work nicely */
   dest = g_file_get_parent (G_FILE (transfer_job->target_file_list->data));
 
-  /* query information about the filesystem */
-  filesystem_info = g_file_query_filesystem_info (dest, THUNARX_FILESYSTEM_INFO_NAMESPACE,
-                                                  exo_job_get_cancellable (EXO_JOB (transfer_job)),
-                                                  NULL);
-
-  /* unable to query the info, this could happen on some backends */
-  if (filesystem_info == NULL)
+  /* query the free space of the volume, shared with the views and given
+   * up after a few seconds, so a stalled mount does not hold the job */
+  if (!thunar_free_space_query (dest, exo_job_get_cancellable (EXO_JOB (transfer_job)),
+                                &free_space, NULL, NULL))
     {
+      /* unable to query the info, this could happen on some backends */
       g_object_unref (G_OBJECT (dest));
       return TRUE;
     }
@@ -908,19 +3271,15 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
       g_free (base_name);
     }
 
-  if (g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE))
+  if (transfer_job->total_size > free_space)
     {
-      free_space = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
-      if (transfer_job->total_size > free_space)
-        {
-          size_string = g_format_size_full (transfer_job->total_size - free_space,
-                                            transfer_job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-          succeed = thunar_job_ask_no_size (THUNAR_JOB (transfer_job),
-                                             _("Error while copying to \"%s\": %s more space is "
-                                               "required to copy to the destination"),
-                                            dest_name, size_string);
-          g_free (size_string);
-        }
+      size_string = g_format_size_full (transfer_job->total_size - free_space,
+                                        transfer_job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+      succeed = thunar_job_ask_no_size (THUNAR_JOB (transfer_job),
+                                         _("Error while copying to \"%s\": %s more space is "
+                                           "required to copy to the destination"),
+                                        dest_name, size_string);
+      g_free (size_string);
     }
 
   /* We used to check G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE here,
@@ -929,7 +3288,6 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
    * error message.
    * More details: https://bugzilla.xfce.org/show_bug.cgi?id=15367#c16 */
 
-  g_object_unref (filesystem_info);
   g_object_unref (G_OBJECT (dest));
   g_free (dest_name);
 
@@ -938,95 +3296,141 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
 
 
 static gboolean
-thunar_transfer_job_prepare_untrash_file (ExoJob     *job,
-                                          GFileInfo  *info,
-                                          GFile      *file,
-                                          GError    **error)
+thunar_transfer_job_prepare_untrash (ThunarTransferJob *transfer_job,
+                                     GError           **error)
 {
   ThunarJobResponse  response;
+  GHashTableIter     iter;
+  GHashTable        *parents;
+  ExoJob            *job = EXO_JOB (transfer_job);
   GFile             *target_parent;
-  gboolean           parent_exists;
-  gchar             *base_name;
-  gchar             *parent_display_name;
+  GList             *missing = NULL;
+  GList             *lp;
+  GList             *sp;
+  GList             *tp;
+  gpointer           exists;
+  gchar             *display_name;
+  guint              n_missing;
+  guint              n_conflicts = 0;
+  GError            *err = NULL;
+
+  exo_job_info_message (job, _("Checking the original locations..."));
+
+  /* the items of a large restore usually come from a few folders, so
+   * each original folder is only looked up once. The value tells whether
+   * the folder exists */
+  parents = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
 
-  /* update progress information */
-  exo_job_info_message (job, _("Trying to restore \"%s\""),
-                        g_file_info_get_display_name (info));
+  for (sp = transfer_job->source_node_list, tp = transfer_job->target_file_list;
+       sp != NULL && tp != NULL && !exo_job_is_cancelled (job);
+       sp = sp->next, tp = tp->next)
+    {
+      if (!thunar_g_file_is_trashed (((ThunarTransferNode *) sp->data)->source_file))
+        continue;
 
-  /* determine the parent file */
-  target_parent = g_file_get_parent (file);
-  /* check if the parent exists */
-  if (target_parent != NULL)
-    parent_exists = g_file_query_exists (target_parent, exo_job_get_cancellable (job));
-  else
-    parent_exists = FALSE;
+      target_parent = g_file_get_parent (tp->data);
+      if (G_UNLIKELY (target_parent == NULL))
+        continue;
+
+      if (!g_hash_table_lookup_extended (parents, target_parent, NULL, &exists))
+        {
+          exists = GINT_TO_POINTER (g_file_query_exists (target_parent, exo_job_get_cancellable (job)));
+          g_hash_table_insert (parents, g_object_ref (target_parent), exists);
+        }
+
+      /* files can only collide in folders that are still there */
+      if (GPOINTER_TO_INT (exists) && g_file_query_exists (tp->data, exo_job_get_cancellable (job)))
+        n_conflicts++;
+
+      g_object_unref (target_parent);
+    }
 
-  /* abort on cancellation */
   if (exo_job_set_error_if_cancelled (job, error))
     {
-      g_object_unref (info);
-      if (target_parent != NULL)
-        g_object_unref (target_parent);
+      g_hash_table_destroy (parents);
       return FALSE;
     }
 
-  if (target_parent != NULL && !parent_exists)
-    {
-      /* determine the display name of the parent */
-      base_name = g_file_get_basename (target_parent);
-      parent_display_name = g_filename_display_name (base_name);
-      g_free (base_name);
+  g_hash_table_iter_init (&iter, parents);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &target_parent, &exists))
+    if (!GPOINTER_TO_INT (exists))
+      missing = g_list_prepend (missing, target_parent);
 
-      /* ask the user whether he wants to create the parent folder because its gone */
-      response = thunar_job_ask_create (THUNAR_JOB (job),
-                                        _("The folder \"%s\" does not exist anymore but is "
-                                          "required to restore the file \"%s\" from the "
-                                          "trash"),
-                                        parent_display_name,
-                                        g_file_info_get_display_name (info));
-
-      /* abort if cancelled */
-      if (G_UNLIKELY (response == THUNAR_JOB_RESPONSE_CANCEL))
-        {
-          g_free (parent_display_name);
-          g_object_unref (info);
-          if (target_parent != NULL)
-            g_object_unref (target_parent);
-          return FALSE;
+  if (missing != NULL)
+    {
+      /* ask once for all the folders that are gone */
+      n_missing = g_list_length (missing);
+      display_name = thunar_g_file_get_display_name (missing->data);
+      if (n_missing == 1)
+        {
+          response = thunar_job_ask_create (THUNAR_JOB (job),
+                                            _("The folder \"%s\" does not exist anymore but is "
+                                              "required to restore files from the trash"),
+                                            display_name);
+        }
+      else
+        {
+          response = thunar_job_ask_create (THUNAR_JOB (job),
+                                            ngettext ("The folder \"%s\" and %u other folder do not exist "
+                                                      "anymore but are required to restore files from the trash",
+                                                      "The folder \"%s\" and %u other folders do not exist "
+                                                      "anymore but are required to restore files from the trash",
+                                                      n_missing - 1),
+                                            display_name, n_missing - 1);
         }
 
-      /* try to create the parent directory */
-      if (!g_file_make_directory_with_parents (target_parent,
-                                               exo_job_get_cancellable (job),
-                                               error))
+      for (lp = missing; lp != NULL && response != THUNAR_JOB_RESPONSE_CANCEL; lp = lp->next)
         {
+          /* an earlier folder may have created this one as its parent */
+          if (g_file_make_directory_with_parents (lp->data, exo_job_get_cancellable (job), &err)
+              || g_error_matches (err, G_IO_ERROR, G_IO_ERROR_EXISTS))
+            {
+              g_clear_error (&err);
+              continue;
+            }
+
           if (!exo_job_is_cancelled (job))
             {
-              g_clear_error (error);
+              g_clear_error (&err);
+              g_free (display_name);
+              display_name = thunar_g_file_get_display_name (lp->data);
 
               /* overwrite the internal GIO error with something more user-friendly */
-              g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+              g_set_error (&err, G_IO_ERROR, G_IO_ERROR_FAILED,
                            _("Failed to restore the folder \"%s\""),
-                           parent_display_name);
+                           display_name);
             }
-
-          g_free (parent_display_name);
-          g_object_unref (info);
-          if (target_parent != NULL)
-            g_object_unref (target_parent);
-          return FALSE;
+          break;
         }
 
-      /* clean up */
-      g_free (parent_display_name);
+      g_free (display_name);
+      g_list_free (missing);
     }
 
-  if (target_parent != NULL)
-    g_object_unref (target_parent);
-  return TRUE;
+  g_hash_table_destroy (parents);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  /* one question for all the collisions instead of one per file, the
+   * answer is picked up by thunar_job_ask_replace() in the move loop */
+  if (n_conflicts > 1)
+    {
+      thunar_job_ask_replace_many (THUNAR_JOB (job),
+                                   ngettext ("%u file already exists at its original location",
+                                             "%u files already exist at their original location",
+                                             n_conflicts),
+                                   n_conflicts);
+    }
+
+  return !exo_job_set_error_if_cancelled (job, error);
 }
 
 
+
 static gboolean
 thunar_transfer_job_move_file_with_rename (ExoJob             *job,
                                            ThunarTransferNode *node,
@@ -1065,6 +3469,165 @@ thunar_transfer_job_move_file_with_rename (ExoJob             *job,
 }
 
 
+static gboolean
+thunar_transfer_job_is_same_filesystem (ExoJob *job,
+                                        GFile  *source_file,
+                                        GFile  *target_file)
+{
+  GFileInfo *source_info;
+  GFileInfo *target_info;
+  gboolean   same = FALSE;
+
+  source_info = g_file_query_info (source_file, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (job), NULL);
+  target_info = g_file_query_info (target_file, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (job), NULL);
+
+  if (source_info != NULL && target_info != NULL)
+    same = g_strcmp0 (g_file_info_get_attribute_string (source_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM),
+                      g_file_info_get_attribute_string (target_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM)) == 0;
+
+  if (source_info != NULL)
+    g_object_unref (source_info);
+  if (target_info != NULL)
+    g_object_unref (target_info);
+
+  return same;
+}
+
+
+
+/* merges the folder @source_file into the existing folder @target_file by
+ * moving its children, so a move within one filesystem never copies data.
+ * Conflicts are resolved per item, and subfolders which exist on both sides
+ * are merged the same way. A child that cannot be renamed fails the merge
+ * with G_IO_ERROR_NOT_SUPPORTED, then the caller copies what is left. */
+static gboolean
+thunar_transfer_job_merge_directory (ExoJob               *job,
+                                     GFile                *source_file,
+                                     GFile                *target_file,
+                                     GFileCopyFlags        move_flags,
+                                     ThunarThumbnailCache *thumbnail_cache,
+                                     GError              **error)
+{
+  ThunarJobResponse  response;
+  GFileEnumerator   *enumerator;
+  GFileInfo         *info;
+  GFileType          target_type;
+  GFile             *source_child;
+  GFile             *target_child;
+  GFile             *renamed_file;
+  GError            *err = NULL;
+  gboolean           moved;
+  guint              n_rename;
+
+  enumerator = g_file_enumerate_children (source_file,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          exo_job_get_cancellable (job), error);
+  if (G_UNLIKELY (enumerator == NULL))
+    return FALSE;
+
+  while (err == NULL)
+    {
+      info = g_file_enumerator_next_file (enumerator, exo_job_get_cancellable (job), &err);
+      if (info == NULL)
+        break;
+
+      source_child = g_file_get_child (source_file, g_file_info_get_name (info));
+      target_child = g_file_get_child (target_file, g_file_info_get_name (info));
+
+      moved = g_file_move (source_child, target_child, move_flags,
+                           exo_job_get_cancellable (job), NULL, NULL, &err);
+      if (!moved && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_EXISTS))
+        {
+          g_clear_error (&err);
+          target_type = g_file_query_file_type (target_child, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                exo_job_get_cancellable (job));
+
+          /* folders on both sides are merged without asking, like the copy does */
+          if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY
+              && target_type == G_FILE_TYPE_DIRECTORY)
+            {
+              moved = thunar_transfer_job_merge_directory (job, source_child, target_child,
+                                                           move_flags, thumbnail_cache, &err);
+            }
+          else
+            {
+              response = thunar_job_ask_replace (THUNAR_JOB (job), source_child, target_child, &err);
+              if (response == THUNAR_JOB_RESPONSE_REPLACE)
+                {
+                  moved = g_file_move (source_child, target_child, move_flags | G_FILE_COPY_OVERWRITE,
+                                       exo_job_get_cancellable (job), NULL, NULL, &err);
+                }
+              else if (response == THUNAR_JOB_RESPONSE_RENAME)
+                {
+                  for (n_rename = 1; err == NULL; ++n_rename)
+                    {
+                      renamed_file = thunar_io_jobs_util_next_renamed_file (THUNAR_JOB (job), source_child,
+                                                                            target_child, n_rename, &err);
+                      if (renamed_file == NULL)
+                        break;
+
+                      moved = g_file_move (source_child, renamed_file, move_flags,
+                                           exo_job_get_cancellable (job), NULL, NULL, &err);
+                      if (moved)
+                        thunar_thumbnail_cache_move_file (thumbnail_cache, source_child, renamed_file);
+                      g_object_unref (renamed_file);
+
+                      if (moved || !g_error_matches (err, G_IO_ERROR_EXISTS))
+                        break;
+                      g_clear_error (&err);
+                    }
+
+                  /* the thumbnail was already moved to the renamed file */
+                  moved = FALSE;
+                }
+              else if (response == THUNAR_JOB_RESPONSE_CANCEL)
+                {
+                  /* the job was cancelled by thunar_job_ask_replace() */
+                  exo_job_set_error_if_cancelled (job, &err);
+                }
+
+              /* skipped files stay in the source folder */
+            }
+        }
+
+      if (moved)
+        thunar_thumbnail_cache_move_file (thumbnail_cache, source_child, target_child);
+
+      g_object_unref (target_child);
+      g_object_unref (source_child);
+      g_object_unref (info);
+    }
+
+  g_object_unref (enumerator);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  /* remove the source folder, unless some of its files were skipped */
+  if (!g_file_delete (source_file, exo_job_get_cancellable (job), &err))
+    {
+      if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_EMPTY))
+        {
+          g_propagate_error (error, err);
+          return FALSE;
+        }
+      g_error_free (err);
+    }
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_transfer_job_move_file (ExoJob                *job,
                                GFileInfo             *info,
@@ -1104,6 +3667,17 @@ thunar_transfer_job_move_file (ExoJob                *job,
                                          move_flags | G_FILE_COPY_OVERWRITE,
                                          exo_job_get_cancellable (job),
                                          NULL, NULL, error);
+
+          /* merge folders by moving their contents, unless this means copying */
+          if (!move_successful
+              && g_error_matches (*error, G_IO_ERROR, G_IO_ERROR_WOULD_MERGE)
+              && thunar_transfer_job_is_same_filesystem (job, node->source_file, tp->data))
+            {
+              g_clear_error (error);
+              exo_job_info_message (job, _("Merging \"%s\""), g_file_info_get_display_name (info));
+              move_successful = thunar_transfer_job_merge_directory (job, node->source_file, tp->data,
+                                                                     move_flags, thumbnail_cache, error);
+            }
         }
       /* if the user chose to rename then try to do so */
       else if (response == THUNAR_JOB_RESPONSE_RENAME)
@@ -1134,6 +3708,9 @@ thunar_transfer_job_move_file (ExoJob                *job,
                                             node->source_file,
                                             tp->data);
 
+          /* restored files leave the trash */
+          thunar_trash_count_remove_file (node->source_file);
+
           /* add the target file to the new files list */
           *new_files_list_p = thunar_g_list_prepend_deep (*new_files_list_p, tp->data);
         }
@@ -1169,24 +3746,28 @@ thunar_transfer_job_move_file (ExoJob                *job,
 
 
 
-static gboolean
-thunar_transfer_job_device_id_in_job_list (const char *device_fs_id,
-                                           GList      *jobs)
+static guint
+thunar_transfer_job_count_device_jobs (const gchar *device_fs_id,
+                                       GList       *jobs)
 {
   ThunarTransferJob *job;
+  guint              n_jobs = 0;
+
+  if (device_fs_id == NULL)
+    return 0;
 
-  for (GList *ljobs = jobs; device_fs_id != NULL && ljobs != NULL; ljobs = ljobs->next)
+  for (GList *ljobs = jobs; ljobs != NULL; ljobs = ljobs->next)
     {
       if (THUNAR_IS_TRANSFER_JOB (ljobs->data))
         {
           job = THUNAR_TRANSFER_JOB (ljobs->data);
-          if (g_strcmp0 (device_fs_id, job->source_device_fs_id) == 0)
-            return TRUE;
-          if (g_strcmp0 (device_fs_id, job->target_device_fs_id) == 0)
-            return TRUE;
+          if (g_strcmp0 (device_fs_id, job->source_device_fs_id) == 0
+              || g_strcmp0 (device_fs_id, job->target_device_fs_id) == 0)
+            n_jobs++;
         }
     }
-  return FALSE;
+
+  return n_jobs;
 }
 
 
@@ -1397,10 +3978,18 @@ thunar_transfer_job_can_start (ThunarTransferJob *transfer_job,
   /* no source node list nor target file list */
   if (transfer_job->source_node_list == NULL || transfer_job->target_file_list == NULL)
     return TRUE;
-  /* first source file */
-  thunar_transfer_job_fill_source_device_info (transfer_job, ((ThunarTransferNode*) transfer_job->source_node_list->data)->source_file);
-  /* first target file */
-  thunar_transfer_job_fill_target_device_info (transfer_job, G_FILE (transfer_job->target_file_list->data));
+
+  /* waiting jobs are checked whenever another job finishes, so only
+   * query the devices once, this is blocking i/o in the main loop */
+  if (!transfer_job->device_info_valid)
+    {
+      /* first source file */
+      thunar_transfer_job_fill_source_device_info (transfer_job, ((ThunarTransferNode*) transfer_job->source_node_list->data)->source_file);
+      /* first target file */
+      thunar_transfer_job_fill_target_device_info (transfer_job, G_FILE (transfer_job->target_file_list->data));
+      transfer_job->device_info_valid = TRUE;
+    }
+
   thunar_transfer_job_determine_copy_behavior (transfer_job,
                                                &freeze_if_src_busy,
                                                &freeze_if_tgt_busy,
@@ -1409,9 +3998,14 @@ thunar_transfer_job_can_start (ThunarTransferJob *transfer_job,
 
   if (should_freeze_on_any_other_job && running_job_list != NULL)
     return FALSE;
-  if (freeze_if_src_busy && thunar_transfer_job_device_id_in_job_list (transfer_job->source_device_fs_id, running_job_list))
+
+  /* every device runs a limited number of jobs, so jobs on other
+   * devices are not held back by a slow one */
+  if (freeze_if_src_busy
+      && thunar_transfer_job_count_device_jobs (transfer_job->source_device_fs_id, running_job_list) >= transfer_job->jobs_per_device)
     return FALSE;
-  if (freeze_if_tgt_busy && thunar_transfer_job_device_id_in_job_list (transfer_job->target_device_fs_id, running_job_list))
+  if (freeze_if_tgt_busy
+      && thunar_transfer_job_count_device_jobs (transfer_job->target_device_fs_id, running_job_list) >= transfer_job->jobs_per_device)
     return FALSE;
 
   return TRUE;
@@ -1419,9 +4013,35 @@ thunar_transfer_job_can_start (ThunarTransferJob *transfer_job,
 
 
 
+/**
+ * thunar_transfer_job_uses_device:
+ * @transfer_job : a #ThunarTransferJob.
+ * @device_fs_id : the filesystem id of a device.
+ *
+ * Tells whether @transfer_job reads from or writes to the filesystem
+ * with the id @device_fs_id. The devices of a job are known once
+ * thunar_transfer_job_can_start() was called for it.
+ *
+ * Return value: %TRUE if @transfer_job works on @device_fs_id.
+ **/
+gboolean
+thunar_transfer_job_uses_device (ThunarTransferJob *transfer_job,
+                                 const gchar       *device_fs_id)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (transfer_job), FALSE);
+
+  if (device_fs_id == NULL || !transfer_job->device_info_valid)
+    return FALSE;
+
+  return g_strcmp0 (device_fs_id, transfer_job->source_device_fs_id) == 0
+      || g_strcmp0 (device_fs_id, transfer_job->target_device_fs_id) == 0;
+}
+
+
+
 static gboolean
-thunar_transfer_job_execute (ExoJob  *job,
-                             GError **error)
+thunar_transfer_job_transfer (ExoJob  *job,
+                              GError **error)
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarTransferNode   *node;
@@ -1441,15 +4061,37 @@ thunar_transfer_job_execute (ExoJob  *job,
   if (exo_job_set_error_if_cancelled (job, error))
     return FALSE;
 
+  /* look up the original folders of trashed files all at once */
+  if (transfer_job->type == THUNAR_TRANSFER_JOB_MOVE
+      && !thunar_transfer_job_prepare_untrash (transfer_job, error))
+    return FALSE;
+
   exo_job_info_message (job, _("Collecting files..."));
 
+  /* collecting a large tree on a network share takes long, so such
+   * copies already start with the files collected so far */
+  if (transfer_job->type == THUNAR_TRANSFER_JOB_COPY
+      && transfer_job->overlap_collection
+      && transfer_job->source_node_list != NULL)
+    {
+      node = transfer_job->source_node_list->data;
+      if (thunar_g_file_is_on_slow_filesystem (node->source_file, exo_job_get_cancellable (job)))
+        {
+          transfer_job->collecting = TRUE;
+          transfer_job->collect_thread = g_thread_new ("ThunarTransferCollect",
+                                                       thunar_transfer_job_collect_thread,
+                                                       transfer_job);
+        }
+    }
+
   /* take a reference on the thumbnail cache */
   application = thunar_application_get ();
   thumbnail_cache = thunar_application_get_thumbnail_cache (application);
   g_object_unref (application);
 
+  /* the collect thread collects the copies by itself */
   for (sp = transfer_job->source_node_list, tp = transfer_job->target_file_list;
-       sp != NULL && tp != NULL && err == NULL;
+       sp != NULL && tp != NULL && err == NULL && transfer_job->collect_thread == NULL;
        sp = snext, tp = tnext)
     {
       thunar_transfer_job_check_pause (transfer_job);
@@ -1474,8 +4116,6 @@ thunar_transfer_job_execute (ExoJob  *job,
       if (transfer_job->type == THUNAR_TRANSFER_JOB_MOVE
           && thunar_g_file_is_trashed (node->source_file))
         {
-          if (!thunar_transfer_job_prepare_untrash_file (job, info, tp->data, &err))
-            break;
           if (!thunar_transfer_job_move_file (job, info, sp, node, tp,
                                               G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_ALL_METADATA,
                                               thumbnail_cache, &new_files_list, &err))
@@ -1503,8 +4143,10 @@ thunar_transfer_job_execute (ExoJob  *job,
   /* continue if there were no errors yet */
   if (G_LIKELY (err == NULL))
     {
-      /* check destination */
-      if (!thunar_transfer_job_verify_destination (transfer_job, &err))
+      /* check destination, the total size is not known yet if the
+       * files are still collected */
+      if (transfer_job->collect_thread == NULL
+          && !thunar_transfer_job_verify_destination (transfer_job, &err))
         {
           if (err != NULL)
             {
@@ -1520,6 +4162,27 @@ thunar_transfer_job_execute (ExoJob  *job,
 
       /* transfer starts now */
       transfer_job->start_time = g_get_real_time ();
+      transfer_job->last_update_time = transfer_job->start_time;
+
+      /* publish the progress from the main loop at a fixed rate, the
+       * source keeps a reference on the job while it is running */
+      if (G_LIKELY (transfer_job->total_size > 0 || transfer_job->collect_thread != NULL))
+        {
+          transfer_job->progress_timer_id =
+              g_timeout_add_full (G_PRIORITY_DEFAULT, PROGRESS_UPDATE_INTERVAL,
+                                  thunar_transfer_job_progress_timer,
+                                  g_object_ref (transfer_job), g_object_unref);
+        }
+
+      /* the per-file latency dominates when copying many small files, so keep
+       * several of them in flight. a move falls back to copying here too, but
+       * it has to delete the source directories after their children */
+      if (transfer_job->type == THUNAR_TRANSFER_JOB_COPY)
+        {
+          transfer_job->copy_pool_size = CLAMP (g_get_num_processors (), 2, PIPELINE_MAX_THREADS);
+          transfer_job->copy_pool = g_thread_pool_new (thunar_transfer_job_copy_worker, transfer_job,
+                                                       transfer_job->copy_pool_size, FALSE, NULL);
+        }
 
       /* perform the copy recursively for all source transfer nodes */
       for (sp = transfer_job->source_node_list, tp = transfer_job->target_file_list;
@@ -1529,6 +4192,40 @@ thunar_transfer_job_execute (ExoJob  *job,
           thunar_transfer_job_copy_node (transfer_job, sp->data, tp->data, NULL,
                                          &new_files_list, &err);
         }
+
+      if (transfer_job->copy_pool != NULL)
+        {
+          /* wait for the remaining copies */
+          thunar_transfer_job_copy_wait (transfer_job, &err);
+          g_thread_pool_free (transfer_job->copy_pool, FALSE, TRUE);
+          transfer_job->copy_pool = NULL;
+        }
+
+      if (transfer_job->collect_thread != NULL)
+        {
+          /* the collect thread may still be in a folder that was
+           * skipped, or the copy failed, so it is not needed anymore */
+          g_atomic_int_set (&transfer_job->collect_stop, TRUE);
+          g_thread_join (transfer_job->collect_thread);
+          transfer_job->collect_thread = NULL;
+
+          /* report the errors of the collection unless they were
+           * caused by stopping it */
+          if (err == NULL
+              && transfer_job->collect_error != NULL
+              && !g_error_matches (transfer_job->collect_error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            err = transfer_job->collect_error;
+          else if (transfer_job->collect_error != NULL)
+            g_error_free (transfer_job->collect_error);
+          transfer_job->collect_error = NULL;
+        }
+
+      /* stop publishing the progress */
+      if (G_LIKELY (transfer_job->progress_timer_id != 0))
+        {
+          g_source_remove (transfer_job->progress_timer_id);
+          transfer_job->progress_timer_id = 0;
+        }
     }
 
   /* check if we failed */
@@ -1547,6 +4244,34 @@ thunar_transfer_job_execute (ExoJob  *job,
 
 
 
+static gboolean
+thunar_transfer_job_execute (ExoJob  *job,
+                             GError **error)
+{
+  static const gchar *names[] = { "copy", "link", "move", "trash" };
+  ThunarTransferJob  *transfer_job = THUNAR_TRANSFER_JOB (job);
+  gboolean            succeed;
+  gint64              trace_time;
+
+  /* wait until the job may run in its priority class */
+  if (!thunar_job_enter (THUNAR_JOB (job)))
+    {
+      exo_job_set_error_if_cancelled (job, error);
+      return FALSE;
+    }
+
+  /* the span covers collecting the files too */
+  trace_time = thunar_trace_begin ();
+  succeed = thunar_transfer_job_transfer (job, error);
+  thunar_trace_end (trace_time, "job", names[transfer_job->type], NULL);
+
+  thunar_job_leave (THUNAR_JOB (job));
+
+  return succeed;
+}
+
+
+
 static void
 thunar_transfer_node_free (gpointer data)
 {
@@ -1575,6 +4300,18 @@ thunar_transfer_node_free (gpointer data)
 
 
 
+static void
+thunar_transfer_hard_link_free (gpointer data)
+{
+  ThunarTransferHardLink *hard_link = data;
+
+  if (hard_link->target_file != NULL)
+    g_object_unref (hard_link->target_file);
+  g_slice_free (ThunarTransferHardLink, hard_link);
+}
+
+
+
 ThunarJob *
 thunar_transfer_job_new (GList                *source_node_list,
                          GList                *target_file_list,
@@ -1624,6 +4361,40 @@ thunar_transfer_job_new (GList                *source_node_list,
 
 
 
+/**
+ * thunar_transfer_job_get_progress:
+ * @job            : a #ThunarTransferJob.
+ * @total_size     : return location for the number of bytes to transfer.
+ * @total_progress : return location for the number of bytes transferred.
+ * @transfer_rate  : return location for the average bytes per second.
+ * @n_files_total  : return location for the number of files to transfer.
+ * @n_files_done   : return location for the number of files transferred.
+ *
+ * Returns the current progress of @job, without formatting it like
+ * thunar_transfer_job_get_status().
+ **/
+void
+thunar_transfer_job_get_progress (ThunarTransferJob *job,
+                                  guint64           *total_size,
+                                  guint64           *total_progress,
+                                  guint64           *transfer_rate,
+                                  guint             *n_files_total,
+                                  guint             *n_files_done)
+{
+  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+
+  g_mutex_lock (&job->copy_mutex);
+  *total_size = job->total_size;
+  *total_progress = MIN (job->total_progress, job->total_size);
+  *transfer_rate = job->transfer_rate;
+  g_mutex_unlock (&job->copy_mutex);
+
+  *n_files_total = g_atomic_int_get (&job->n_files_total);
+  *n_files_done = g_atomic_int_get (&job->n_files_done);
+}
+
+
+
 gchar *
 thunar_transfer_job_get_status (ThunarTransferJob *job)
 {
@@ -1632,25 +4403,41 @@ thunar_transfer_job_get_status (ThunarTransferJob *job)
   gchar             *transfer_rate_str;
   GString           *status;
   gulong             remaining_time;
+  guint64            data_size;
+  guint64            data_progress;
+  gboolean           collecting;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), NULL);
 
   status = g_string_sized_new (100);
 
-  /* transfer status like "22.6MB of 134.1MB" */
+  g_mutex_lock (&job->collect_mutex);
+  collecting = job->collecting;
+  g_mutex_unlock (&job->collect_mutex);
+
+  /* transfer status like "22.6MB of 134.1MB", the total only grows
+   * while the files are still collected */
   total_size_str = g_format_size_full (job->total_size, job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
   total_progress_str = g_format_size_full (job->total_progress, job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-  g_string_append_printf (status, _("%s of %s"), total_progress_str, total_size_str);
+  if (collecting)
+    g_string_append_printf (status, _("%s of at least %s"), total_progress_str, total_size_str);
+  else
+    g_string_append_printf (status, _("%s of %s"), total_progress_str, total_size_str);
   g_free (total_size_str);
   g_free (total_progress_str);
 
-  /* show time and transfer rate after 10 seconds */
-  if (job->transfer_rate > 0
+  /* show time and transfer rate after 10 seconds, and once the
+   * total is known */
+  if (!collecting
+      && job->transfer_rate > 0
       && (job->last_update_time - job->start_time) > MINIMUM_TRANSFER_TIME)
     {
       /* remaining time based on the transfer speed */
       transfer_rate_str = g_format_size_full (job->transfer_rate, job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-      remaining_time = (job->total_size - job->total_progress) / job->transfer_rate;
+      /* the rate only counts data, so leave out the holes of sparse files */
+      data_size = job->total_size - MIN (job->total_hole_size, job->total_size);
+      data_progress = job->total_progress - MIN (job->hole_progress, job->total_progress);
+      remaining_time = (data_size > data_progress) ? (data_size - data_progress) / job->transfer_rate : 0;
 
       if (remaining_time > 0)
         {
@@ -57,9 +57,19 @@ ThunarJob *thunar_transfer_job_new        (GList                *source_file_lis
 
 gchar     *thunar_transfer_job_get_status (ThunarTransferJob    *job);
 
+void       thunar_transfer_job_get_progress (ThunarTransferJob  *job,
+                                             guint64            *total_size,
+                                             guint64            *total_progress,
+                                             guint64            *transfer_rate,
+                                             guint              *n_files_total,
+                                             guint              *n_files_done);
+
 gboolean   thunar_transfer_job_can_start  (ThunarTransferJob *transfer_job,
                                            GList             *running_job_list);
 
+gboolean   thunar_transfer_job_uses_device (ThunarTransferJob *transfer_job,
+                                            const gchar       *device_fs_id);
+
 G_END_DECLS
 
 #endif /* !__THUNAR_TRANSFER_JOB_H__ */
@@ -0,0 +1,210 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-transfer-journal.h>
+
+
+
+/* The journal of a resumable transfer records how much of the target was
+ * written, together with the checksum of the last block before that offset,
+ * so a later attempt can verify the partial target and continue from there.
+ *
+ * It is kept in the cache directory of the user instead of next to the
+ * target, so it can still be written when the target is on a share that
+ * just went away, and it does not show up in the target folder.
+ */
+#define JOURNAL_GROUP "Transfer"
+
+
+
+static gchar *
+thunar_transfer_journal_get_path (GFile *target_file)
+{
+  gchar *checksum;
+  gchar *filename;
+  gchar *path;
+  gchar *uri;
+
+  uri = g_file_get_uri (target_file);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  filename = g_strconcat (checksum, ".journal", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "Thunar", "transfers", filename, NULL);
+  g_free (filename);
+  g_free (checksum);
+  g_free (uri);
+
+  return path;
+}
+
+
+
+/**
+ * thunar_transfer_journal_load:
+ * @source_file     : the #GFile being copied.
+ * @source_info     : the #GFileInfo of @source_file, with its size and
+ *                    modification time.
+ * @target_file     : the partial target of the copy.
+ * @offset_return   : return location for the number of bytes written.
+ * @checksum_return : return location for the checksum of the block that
+ *                    ends at @offset_return.
+ *
+ * Looks up the last checkpoint of an interrupted copy of @source_file to
+ * @target_file. The checkpoint is only returned if @source_file did not
+ * change since it was recorded.
+ *
+ * The caller is responsible to free @checksum_return using g_free().
+ *
+ * Return value: %TRUE if a checkpoint was found.
+ **/
+gboolean
+thunar_transfer_journal_load (GFile      *source_file,
+                              GFileInfo  *source_info,
+                              GFile      *target_file,
+                              guint64    *offset_return,
+                              gchar     **checksum_return)
+{
+  GKeyFile *key_file;
+  gboolean  valid = FALSE;
+  guint64   offset;
+  gchar    *source_uri;
+  gchar    *uri;
+  gchar    *path;
+
+  _thunar_return_val_if_fail (G_IS_FILE (source_file), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (source_info), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (target_file), FALSE);
+
+  key_file = g_key_file_new ();
+  path = thunar_transfer_journal_get_path (target_file);
+
+  if (g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
+    {
+      uri = g_key_file_get_string (key_file, JOURNAL_GROUP, "Source", NULL);
+      source_uri = g_file_get_uri (source_file);
+      offset = g_key_file_get_uint64 (key_file, JOURNAL_GROUP, "Offset", NULL);
+
+      /* the source must be the same file in the same version */
+      valid = (g_strcmp0 (uri, source_uri) == 0
+               && offset > 0
+               && offset <= (guint64) g_file_info_get_size (source_info)
+               && g_key_file_get_uint64 (key_file, JOURNAL_GROUP, "Size", NULL) == (guint64) g_file_info_get_size (source_info)
+               && g_key_file_get_uint64 (key_file, JOURNAL_GROUP, "Modified", NULL) == g_file_info_get_attribute_uint64 (source_info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+
+      if (valid)
+        {
+          *checksum_return = g_key_file_get_string (key_file, JOURNAL_GROUP, "Checksum", NULL);
+          *offset_return = offset;
+          valid = (*checksum_return != NULL);
+        }
+
+      g_free (source_uri);
+      g_free (uri);
+    }
+
+  g_key_file_free (key_file);
+  g_free (path);
+
+  return valid;
+}
+
+
+
+/**
+ * thunar_transfer_journal_save:
+ * @source_file : the #GFile being copied.
+ * @source_info : the #GFileInfo of @source_file, with its size and
+ *                modification time.
+ * @target_file : the target of the copy.
+ * @offset      : the number of bytes written to @target_file.
+ * @checksum    : the checksum of the block that ends at @offset.
+ *
+ * Records a checkpoint of the copy of @source_file to @target_file,
+ * replacing the previous one. Failing to write the journal only means
+ * that the copy cannot be resumed, so errors are ignored.
+ **/
+void
+thunar_transfer_journal_save (GFile       *source_file,
+                              GFileInfo   *source_info,
+                              GFile       *target_file,
+                              guint64      offset,
+                              const gchar *checksum)
+{
+  GKeyFile *key_file;
+  gchar    *dirname;
+  gchar    *path;
+  gchar    *uri;
+
+  _thunar_return_if_fail (G_IS_FILE (source_file));
+  _thunar_return_if_fail (G_IS_FILE_INFO (source_info));
+  _thunar_return_if_fail (G_IS_FILE (target_file));
+  _thunar_return_if_fail (checksum != NULL);
+
+  path = thunar_transfer_journal_get_path (target_file);
+  dirname = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dirname, 0700) == 0)
+    {
+      key_file = g_key_file_new ();
+
+      uri = g_file_get_uri (source_file);
+      g_key_file_set_string (key_file, JOURNAL_GROUP, "Source", uri);
+      g_free (uri);
+
+      g_key_file_set_uint64 (key_file, JOURNAL_GROUP, "Size", g_file_info_get_size (source_info));
+      g_key_file_set_uint64 (key_file, JOURNAL_GROUP, "Modified", g_file_info_get_attribute_uint64 (source_info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+      g_key_file_set_uint64 (key_file, JOURNAL_GROUP, "Offset", offset);
+      g_key_file_set_string (key_file, JOURNAL_GROUP, "Checksum", checksum);
+
+      /* written atomically, so a crash leaves the previous checkpoint */
+      g_key_file_save_to_file (key_file, path, NULL);
+      g_key_file_free (key_file);
+    }
+
+  g_free (dirname);
+  g_free (path);
+}
+
+
+
+/**
+ * thunar_transfer_journal_remove:
+ * @target_file : the target of a copy.
+ *
+ * Forgets the checkpoint of the copy to @target_file, once the copy
+ * completed or started over.
+ **/
+void
+thunar_transfer_journal_remove (GFile *target_file)
+{
+  gchar *path;
+
+  _thunar_return_if_fail (G_IS_FILE (target_file));
+
+  path = thunar_transfer_journal_get_path (target_file);
+  g_unlink (path);
+  g_free (path);
+}
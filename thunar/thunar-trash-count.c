@@ -0,0 +1,192 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-file.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-trash-count.h>
+
+
+
+/* The number of items in the trash is known from the trash::item-count
+ * attribute of the trash root, which is only updated when gvfsd-trash
+ * noticed the change and the root was reloaded. The jobs that trash,
+ * restore or remove files adjust the cached count right away, and the
+ * trash root emits "changed" from the main loop, so the trash icons and
+ * the D-Bus clients follow without asking again. Every reload of the
+ * trash root replaces the count with the real one.
+ */
+
+
+
+/* the number of toplevel items in the trash, -1 until the trash root was loaded */
+static gint trash_count = -1;
+
+/* whether "changed" is about to be emitted on the trash root */
+static gint trash_count_idle_pending = 0;
+
+
+
+static gboolean
+thunar_trash_count_idle (gpointer user_data)
+{
+  ThunarFile *trash_bin;
+  GFile      *trash_file;
+
+  g_atomic_int_set (&trash_count_idle_pending, 0);
+
+  /* only the loaded trash root has to be updated */
+  trash_file = thunar_g_file_new_for_trash ();
+  trash_bin = thunar_file_cache_lookup (trash_file);
+  g_object_unref (trash_file);
+
+  if (trash_bin != NULL)
+    {
+      thunar_file_changed (trash_bin);
+      g_object_unref (trash_bin);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_trash_count_changed (void)
+{
+  /* the jobs run in other threads, so notify from the main loop */
+  if (g_atomic_int_compare_and_exchange (&trash_count_idle_pending, 0, 1))
+    g_idle_add (thunar_trash_count_idle, NULL);
+}
+
+
+
+/**
+ * thunar_trash_count_get:
+ *
+ * Return value: the number of toplevel items in the trash or -1 if
+ *               the trash was not loaded yet.
+ **/
+gint
+thunar_trash_count_get (void)
+{
+  return g_atomic_int_get (&trash_count);
+}
+
+
+
+/**
+ * thunar_trash_count_set:
+ * @count : the number of items reported for the trash root.
+ *
+ * Replaces the cached count, called whenever the trash root is loaded.
+ * No "changed" signal is emitted, the trash root emits it itself.
+ **/
+void
+thunar_trash_count_set (guint count)
+{
+  g_atomic_int_set (&trash_count, MIN (count, G_MAXINT));
+}
+
+
+
+/**
+ * thunar_trash_count_add:
+ * @delta : the number of items added to (or removed from, if negative)
+ *          the trash.
+ *
+ * Adjusts the cached count after a job changed the trash. This
+ * function may be used from any thread.
+ **/
+void
+thunar_trash_count_add (gint delta)
+{
+  gint count;
+  gint new_count;
+
+  if (delta == 0)
+    return;
+
+  do
+    {
+      count = g_atomic_int_get (&trash_count);
+
+      /* an unknown count is left to the next reload */
+      if (count < 0)
+        return;
+
+      new_count = MAX (count + delta, 0);
+    }
+  while (!g_atomic_int_compare_and_exchange (&trash_count, count, new_count));
+
+  if (new_count != count)
+    thunar_trash_count_changed ();
+}
+
+
+
+/**
+ * thunar_trash_count_reset:
+ *
+ * Sets the cached count to zero after the trash was emptied. This
+ * function may be used from any thread.
+ **/
+void
+thunar_trash_count_reset (void)
+{
+  if (g_atomic_int_get (&trash_count) > 0)
+    {
+      g_atomic_int_set (&trash_count, 0);
+      thunar_trash_count_changed ();
+    }
+}
+
+
+
+/**
+ * thunar_trash_count_remove_file:
+ * @file : a #GFile that was removed or moved away.
+ *
+ * Decrements the cached count if @file was a toplevel item of the
+ * trash, all other files are ignored. This function may be used
+ * from any thread.
+ **/
+void
+thunar_trash_count_remove_file (GFile *file)
+{
+  GFile *parent;
+
+  _thunar_return_if_fail (G_IS_FILE (file));
+
+  if (!g_file_has_uri_scheme (file, "trash"))
+    return;
+
+  parent = g_file_get_parent (file);
+  if (parent != NULL)
+    {
+      if (thunar_g_file_is_trash (parent))
+        thunar_trash_count_add (-1);
+      g_object_unref (parent);
+    }
+}
@@ -35,6 +35,7 @@
 #include <thunar/thunar-pango-extensions.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-scheduler.h>
 #include <thunar/thunar-tree-model.h>
 #include <thunar/thunar-device-monitor.h>
 #include <thunar/thunar-util.h>
@@ -153,8 +154,18 @@ static void                 thunar_tree_model_node_drop_dummy         (GNode
                                                                        ThunarTreeModel        *model);
 static gboolean             thunar_tree_model_node_traverse_cleanup   (GNode                  *node,
                                                                        gpointer                user_data);
-static gboolean             thunar_tree_model_node_traverse_changed   (GNode                  *node,
+static void                 thunar_tree_model_node_changed            (ThunarTreeModel        *model,
+                                                                       GNode                  *node);
+static void                 thunar_tree_model_file_nodes_add          (ThunarTreeModel        *model,
+                                                                       GNode                  *node);
+static void                 thunar_tree_model_file_nodes_remove       (ThunarTreeModel        *model,
+                                                                       GNode                  *node);
+static gint                 thunar_tree_model_cmp_files               (gconstpointer           a,
+                                                                       gconstpointer           b,
                                                                        gpointer                user_data);
+static void                 thunar_tree_model_insert_children         (ThunarTreeModel        *model,
+                                                                       GNode                  *node,
+                                                                       GPtrArray              *files);
 static gboolean             thunar_tree_model_node_traverse_remove    (GNode                  *node,
                                                                        gpointer                user_data);
 static gboolean             thunar_tree_model_node_traverse_sort      (GNode                  *node,
@@ -200,6 +211,9 @@ struct _ThunarTreeModel
   GNode                      *file_system;
   GNode                      *network;
 
+  /* maps ThunarFile's to the GSList of nodes showing them */
+  GHashTable                 *file_nodes;
+
   guint                       cleanup_idle_id;
 };
 
@@ -211,6 +225,7 @@ struct _ThunarTreeModelItem
   ThunarFolder    *folder;
   ThunarDevice    *device;
   ThunarTreeModel *model;
+  GNode           *node;
 
   /* list of children of this node that are
    * not visible in the treeview */
@@ -306,6 +321,7 @@ thunar_tree_model_init (ThunarTreeModel *model)
 
   /* allocate the "virtual root node" */
   model->root = g_node_new (NULL);
+  model->file_nodes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_slist_free);
 
   /* inititalize references to certain toplevel nodes */
   model->file_system = NULL;
@@ -351,6 +367,8 @@ thunar_tree_model_init (ThunarTreeModel *model)
           /* create and append the new node */
           item = thunar_tree_model_item_new_with_file (model, file);
           node = g_node_append_data (model->root, item);
+          item->node = node;
+          thunar_tree_model_file_nodes_add (model, node);
 
           /* store reference to the "File System" node */
           if (thunar_file_has_uri_scheme (file, "file") && thunar_file_is_root (file))
@@ -392,7 +410,7 @@ thunar_tree_model_finalize (GObject *object)
 
   /* remove the cleanup idle */
   if (model->cleanup_idle_id != 0)
-    g_source_remove (model->cleanup_idle_id);
+    thunar_scheduler_remove (model->cleanup_idle_id);
 
   /* disconnect from the file monitor */
   g_signal_handlers_disconnect_by_func (model->file_monitor, thunar_tree_model_file_changed, model);
@@ -401,6 +419,7 @@ thunar_tree_model_finalize (GObject *object)
   /* release all resources allocated to the model */
   g_node_traverse (model->root, G_POST_ORDER, G_TRAVERSE_ALL, -1, thunar_tree_model_node_traverse_free, NULL);
   g_node_destroy (model->root);
+  g_hash_table_destroy (model->file_nodes);
 
   /* disconnect from the volume monitor */
   g_signal_handlers_disconnect_matched (model->device_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, model);
@@ -624,7 +643,7 @@ thunar_tree_model_get_value (GtkTreeModel *tree_model,
     case THUNAR_TREE_MODEL_COLUMN_NAME:
       g_value_init (value, G_TYPE_STRING);
       if (G_LIKELY (item != NULL && item->device != NULL))
-        g_value_take_string (value, thunar_device_get_name (item->device));
+        g_value_set_static_string (value, thunar_device_peek_name (item->device));
       else if (G_LIKELY (item != NULL && item->file != NULL))
         g_value_set_static_string (value, thunar_file_get_display_name (item->file));
       else
@@ -956,14 +975,16 @@ thunar_tree_model_file_changed (ThunarFileMonitor *file_monitor,
                                 ThunarFile        *file,
                                 ThunarTreeModel   *model)
 {
+  GSList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
   _thunar_return_if_fail (model->file_monitor == file_monitor);
   _thunar_return_if_fail (THUNAR_IS_TREE_MODEL (model));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  /* traverse the model and emit "row-changed" for the file's nodes */
-  if (thunar_file_is_directory (file))
-    g_node_traverse (model->root, G_PRE_ORDER, G_TRAVERSE_ALL, -1, thunar_tree_model_node_traverse_changed, file);
+  /* emit "row-changed" for the file's nodes */
+  for (lp = g_hash_table_lookup (model->file_nodes, file); lp != NULL; lp = lp->next)
+    thunar_tree_model_node_changed (model, lp->data);
 }
 
 
@@ -1004,6 +1025,7 @@ thunar_tree_model_device_changed (ThunarDeviceMonitor *device_monitor,
         {
           /* try to determine the file for the mount point */
           item->file = thunar_file_get (mount_point, NULL);
+          thunar_tree_model_file_nodes_add (model, node);
 
           /* because the volume node is already reffed, we need to load the folder manually here */
           thunar_tree_model_item_load_folder (item);
@@ -1113,6 +1135,8 @@ thunar_tree_model_device_added (ThunarDeviceMonitor *device_monitor,
 
   /* insert the new node */
   node = g_node_insert_data_after (model->root, node, item);
+  item->node = node;
+  thunar_tree_model_file_nodes_add (model, node);
 
   /* determine the iterator for the new node */
   GTK_TREE_ITER_INIT (iter, model->stamp, node);
@@ -1219,7 +1243,7 @@ thunar_tree_model_item_reset (ThunarTreeModelItem *item)
 {
   /* cancel any pending load idle source */
   if (G_UNLIKELY (item->load_idle_id != 0))
-    g_source_remove (item->load_idle_id);
+    thunar_scheduler_remove (item->load_idle_id);
 
   /* disconnect from the folder */
   if (G_LIKELY (item->folder != NULL))
@@ -1239,6 +1263,10 @@ thunar_tree_model_item_reset (ThunarTreeModelItem *item)
   /* disconnect from the file */
   if (G_LIKELY (item->file != NULL))
     {
+      /* the node no longer shows the file */
+      if (G_LIKELY (item->node != NULL))
+        thunar_tree_model_file_nodes_remove (item->model, item->node);
+
       /* unwatch the trash */
       if (thunar_file_is_trash (item->file))
         thunar_file_unwatch (item->file);
@@ -1259,8 +1287,8 @@ thunar_tree_model_item_load_folder (ThunarTreeModelItem *item)
   /* schedule the "load" idle source (if not already done) */
   if (G_LIKELY (item->load_idle_id == 0 && item->folder == NULL))
     {
-      item->load_idle_id = g_idle_add_full (G_PRIORITY_HIGH, thunar_tree_model_item_load_idle,
-                                            item, thunar_tree_model_item_load_idle_destroy);
+      item->load_idle_id = thunar_scheduler_add_idle (G_PRIORITY_HIGH, thunar_tree_model_item_load_idle,
+                                                      item, thunar_tree_model_item_load_idle_destroy);
     }
 }
 
@@ -1273,12 +1301,16 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
 {
   ThunarTreeModel     *model = THUNAR_TREE_MODEL (item->model);
   ThunarFile          *file;
-  GNode               *node = NULL;
+  GPtrArray           *children;
+  GSList              *np;
   GList               *lp;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (item->folder == folder);
   _thunar_return_if_fail (model->visible_func != NULL);
+  _thunar_return_if_fail (item->node != NULL);
+
+  children = g_ptr_array_new ();
 
   /* process all specified files */
   for (lp = files; lp != NULL; lp = lp->next)
@@ -1297,17 +1329,20 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
           continue;
         }
 
-      /* lookup the node for the item (on-demand) */
-      if (G_UNLIKELY (node == NULL))
-        node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
-      _thunar_return_if_fail (node != NULL);
+      /* skip folders already shown below the node */
+      for (np = g_hash_table_lookup (model->file_nodes, file); np != NULL; np = np->next)
+        if (G_NODE (np->data)->parent == item->node)
+          break;
 
-      thunar_tree_model_add_child (model, node, file);
+      if (G_LIKELY (np == NULL))
+        g_ptr_array_add (children, file);
     }
 
-  /* sort the folders if any new ones were added */
-  if (G_LIKELY (node != NULL))
-    thunar_tree_model_sort (model, node);
+  /* merge the new folders into the sorted children */
+  if (G_LIKELY (children->len > 0))
+    thunar_tree_model_insert_children (model, item->node, children);
+
+  g_ptr_array_free (children, TRUE);
 }
 
 
@@ -1321,15 +1356,13 @@ thunar_tree_model_item_files_removed (ThunarTreeModelItem *item,
   GtkTreePath     *path;
   GtkTreeIter      iter;
   GNode           *child_node;
-  GNode           *node;
+  GNode           *node = item->node;
   GList           *lp;
+  GSList          *np;
   GSList          *inv_link;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (item->folder == folder);
-
-  /* determine the node for the folder */
-  node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
   _thunar_return_if_fail (node != NULL);
 
   /* check if the node has any visible children */
@@ -1339,9 +1372,12 @@ thunar_tree_model_item_files_removed (ThunarTreeModelItem *item,
       for (lp = files; lp != NULL; lp = lp->next)
         {
           /* find the child node for the file */
-          for (child_node = g_node_first_child (node); child_node != NULL; child_node = g_node_next_sibling (child_node))
-            if (child_node->data != NULL && THUNAR_TREE_MODEL_ITEM (child_node->data)->file == lp->data)
-              break;
+          for (np = g_hash_table_lookup (model->file_nodes, lp->data), child_node = NULL; np != NULL; np = np->next)
+            if (G_NODE (np->data)->parent == node)
+              {
+                child_node = np->data;
+                break;
+              }
 
           /* drop the child node (and all descendant nodes) from the model */
           if (G_LIKELY (child_node != NULL))
@@ -1397,7 +1433,7 @@ thunar_tree_model_item_notify_loading (ThunarTreeModelItem *item,
   if (G_LIKELY (!thunar_folder_get_loading (folder)))
     {
       /* lookup the node for the item... */
-      node = g_node_find (item->model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
+      node = item->node;
       _thunar_return_if_fail (node != NULL);
 
       /* ...and drop the dummy for the node */
@@ -1414,21 +1450,12 @@ thunar_tree_model_item_load_idle (gpointer user_data)
   ThunarTreeModelItem *item = user_data;
   GFile               *mount_point;
   GList               *files;
-#ifndef NDEBUG
-  GNode               *node;
-#endif
 
   _thunar_return_val_if_fail (item->folder == NULL, FALSE);
 
-#ifndef NDEBUG
-      /* find the node in the tree */
-      node = g_node_find (item->model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
-
-      /* debug check to make sure the node is empty or contains a dummy node.
-       * if this is not true, the node already contains sub folders which means
-       * something went wrong. */
-      _thunar_return_val_if_fail (node->children == NULL || G_NODE_HAS_DUMMY (node), FALSE);
-#endif
+  /* the node may contain sub folders already, which the tree view added
+   * on the way to its current directory, see thunar_tree_model_add_child().
+   * thunar_tree_model_item_files_added() skips those when merging. */
 
 THUNAR_THREADS_ENTER
 
@@ -1440,6 +1467,7 @@ THUNAR_THREADS_ENTER
         {
           /* try to determine the file for the mount point */
           item->file = thunar_file_get (mount_point, NULL);
+          thunar_tree_model_file_nodes_add (item->model, item->node);
           g_object_unref (mount_point);
         }
     }
@@ -1574,47 +1602,147 @@ thunar_tree_model_node_traverse_cleanup (GNode    *node,
 
 
 
-static gboolean
-thunar_tree_model_node_traverse_changed (GNode   *node,
-                                         gpointer user_data)
+static void
+thunar_tree_model_node_changed (ThunarTreeModel *model,
+                                GNode           *node)
+{
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+
+  /* determine the iterator for the node */
+  GTK_TREE_ITER_INIT (iter, model->stamp, node);
+
+  /* check if the changed node is not one of the root nodes */
+  if (G_LIKELY (node->parent != model->root))
+    {
+      /* need to re-sort as the name of the file may have changed */
+      thunar_tree_model_sort (model, node->parent);
+    }
+
+  /* determine the path for the node */
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), &iter);
+  if (G_LIKELY (path != NULL))
+    {
+      /* emit "row-changed" */
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+
+
+static void
+thunar_tree_model_file_nodes_add (ThunarTreeModel *model,
+                                  GNode           *node)
+{
+  ThunarTreeModelItem *item = THUNAR_TREE_MODEL_ITEM (node->data);
+  GSList              *nodes;
+
+  if (G_UNLIKELY (item->file == NULL))
+    return;
+
+  /* the table owns the list, steal it while prepending */
+  nodes = g_hash_table_lookup (model->file_nodes, item->file);
+  if (nodes != NULL)
+    g_hash_table_steal (model->file_nodes, item->file);
+  g_hash_table_insert (model->file_nodes, item->file, g_slist_prepend (nodes, node));
+}
+
+
+
+static void
+thunar_tree_model_file_nodes_remove (ThunarTreeModel *model,
+                                     GNode           *node)
 {
-  ThunarTreeModel     *model;
-  GtkTreePath         *path;
-  GtkTreeIter          iter;
-  ThunarFile          *file = THUNAR_FILE (user_data);
   ThunarTreeModelItem *item = THUNAR_TREE_MODEL_ITEM (node->data);
+  GSList              *nodes;
+
+  nodes = g_hash_table_lookup (model->file_nodes, item->file);
+  if (G_UNLIKELY (nodes == NULL))
+    return;
+
+  g_hash_table_steal (model->file_nodes, item->file);
+  nodes = g_slist_remove (nodes, node);
+  if (nodes != NULL)
+    g_hash_table_insert (model->file_nodes, item->file, nodes);
+}
+
+
+
+static gint
+thunar_tree_model_cmp_files (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  return thunar_file_compare_by_name (*(ThunarFile *const *) a,
+                                      *(ThunarFile *const *) b,
+                                      THUNAR_TREE_MODEL (user_data)->sort_case_sensitive);
+}
+
+
+
+static void
+thunar_tree_model_insert_children (ThunarTreeModel *model,
+                                   GNode           *node,
+                                   GPtrArray       *files)
+{
+  ThunarTreeModelItem *child_item;
+  GtkTreePath         *node_path;
+  GtkTreePath         *child_path;
+  GtkTreeIter          child_iter;
+  GtkTreeIter          iter;
+  ThunarFile          *file;
+  GNode               *sibling;
+  GNode               *child_node;
+  guint                position;
+  guint                n;
+
+  _thunar_return_if_fail (THUNAR_IS_TREE_MODEL (model));
+  _thunar_return_if_fail (node != model->root);
+
+  /* the children are kept sorted, so sort the new ones and merge
+   * them in a single walk over the siblings */
+  g_ptr_array_sort_with_data (files, thunar_tree_model_cmp_files, model);
+
+  n = 0;
 
-  /* check if the node's file is the file that changed */
-  if (G_UNLIKELY (item != NULL && item->file == file))
+  /* the first folder replaces the dummy */
+  if (G_NODE_HAS_DUMMY (node))
+    thunar_tree_model_add_child (model, node, g_ptr_array_index (files, n++));
+
+  if (n >= files->len)
+    return;
+
+  GTK_TREE_ITER_INIT (iter, model->stamp, node);
+  node_path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), &iter);
+
+  for (sibling = node->children, position = 0; n < files->len; ++n)
     {
-      /* determine the tree model from the item */
-      model = THUNAR_TREE_MODEL_ITEM (node->data)->model;
+      file = g_ptr_array_index (files, n);
 
-      /* determine the iterator for the node */
-      GTK_TREE_ITER_INIT (iter, model->stamp, node);
+      /* skip the siblings sorted before the file */
+      for (; sibling != NULL; sibling = sibling->next, ++position)
+        if (thunar_file_compare_by_name (THUNAR_TREE_MODEL_ITEM (sibling->data)->file, file, model->sort_case_sensitive) > 0)
+          break;
 
-      /* check if the changed node is not one of the root nodes */
-      if (G_LIKELY (node->parent != model->root))
-        {
-          /* need to re-sort as the name of the file may have changed */
-          thunar_tree_model_sort (model, node->parent);
-        }
+      /* insert a new item for the child */
+      child_item = thunar_tree_model_item_new_with_file (model, file);
+      child_node = g_node_insert_data_before (node, sibling, child_item);
+      child_item->node = child_node;
+      thunar_tree_model_file_nodes_add (model, child_node);
 
-      /* determine the path for the node */
-      path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), &iter);
-      if (G_LIKELY (path != NULL))
-        {
-          /* emit "row-changed" */
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
-          gtk_tree_path_free (path);
-        }
+      /* emit a "row-inserted" for the new node */
+      GTK_TREE_ITER_INIT (child_iter, model->stamp, child_node);
+      child_path = gtk_tree_path_copy (node_path);
+      gtk_tree_path_append_index (child_path, position++);
+      gtk_tree_model_row_inserted (GTK_TREE_MODEL (model), child_path, &child_iter);
+      gtk_tree_path_free (child_path);
 
-      /* stop traversing */
-      return TRUE;
+      /* add a dummy to the new child */
+      thunar_tree_model_node_insert_dummy (child_node, model);
     }
 
-  /* continue traversing */
-  return FALSE;
+  gtk_tree_path_free (node_path);
 }
 
 
@@ -1742,6 +1870,8 @@ thunar_tree_model_node_traverse_visible (GNode    *node,
 
                   /* insert a new node for the child */
                   child_node = g_node_append_data (node, child);
+                  child->node = child_node;
+                  thunar_tree_model_file_nodes_add (model, child_node);
 
                   /* determine the tree iter for the child */
                   GTK_TREE_ITER_INIT (iter, model->stamp, child_node);
@@ -1883,8 +2013,8 @@ thunar_tree_model_cleanup (ThunarTreeModel *model)
   /* schedule an idle cleanup, if not already done */
   if (model->cleanup_idle_id == 0)
     {
-      model->cleanup_idle_id = g_timeout_add_full (G_PRIORITY_LOW, 500, thunar_tree_model_cleanup_idle,
-                                                   model, thunar_tree_model_cleanup_idle_destroy);
+      model->cleanup_idle_id = thunar_scheduler_add_timeout (G_PRIORITY_LOW, 500, thunar_tree_model_cleanup_idle,
+                                                             model, thunar_tree_model_cleanup_idle_destroy);
     }
 }
 
@@ -1940,6 +2070,8 @@ thunar_tree_model_add_child (ThunarTreeModel *model,
       /* replace the dummy node with the new node */
       child_node = g_node_first_child (node);
       child_node->data = child_item;
+      child_item->node = child_node;
+      thunar_tree_model_file_nodes_add (model, child_node);
 
       /* determine the tree iter for the child */
       GTK_TREE_ITER_INIT (child_iter, model->stamp, child_node);
@@ -1953,6 +2085,8 @@ thunar_tree_model_add_child (ThunarTreeModel *model,
     {
       /* insert a new item for the child */
       child_node = g_node_append_data (node, child_item);
+      child_item->node = child_node;
+      thunar_tree_model_file_nodes_add (model, child_node);
 
       /* determine the tree iter for the child */
       GTK_TREE_ITER_INIT (child_iter, model->stamp, child_node);
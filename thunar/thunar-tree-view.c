@@ -153,6 +153,14 @@ static gboolean                 thunar_tree_view_selection_func               (G
                                                                                GtkTreePath             *path,
                                                                                gboolean                 path_currently_selected,
                                                                                gpointer                 user_data);
+static void                     thunar_tree_view_cursor_resolve               (ThunarTreeView          *view,
+                                                                               ThunarFile              *file);
+static void                     thunar_tree_view_cursor_resolved              (GFile                   *location,
+                                                                               ThunarFile              *file,
+                                                                               GError                  *error,
+                                                                               gpointer                 user_data);
+static gboolean                 thunar_tree_view_cursor_chain_is_hidden       (ThunarTreeView          *view);
+static void                     thunar_tree_view_cursor_row_inserted          (ThunarTreeView          *view);
 static gboolean                 thunar_tree_view_cursor_idle                  (gpointer                 user_data);
 static void                     thunar_tree_view_cursor_idle_destroy          (gpointer                 user_data);
 static gboolean                 thunar_tree_view_drag_scroll_timer            (gpointer                 user_data);
@@ -216,6 +224,15 @@ struct _ThunarTreeView
   /* set cursor to current directory idle source */
   guint                   cursor_idle_id;
 
+  /* the current directory and its ancestors, the root first, which
+   * are resolved in the background for the cursor idle source */
+  GList                  *cursor_chain;
+  GCancellable           *cursor_cancellable;
+
+  /* whether the cursor idle source waits for a folder of the
+   * chain to appear in the listing of its parent */
+  gboolean                cursor_waiting;
+
   /* autoscroll during drag timer source */
   guint                   drag_scroll_timer_id;
 
@@ -351,6 +368,10 @@ thunar_tree_view_init (ThunarTreeView *view)
   thunar_tree_model_set_visible_func (view->model, thunar_tree_view_visible_func, view);
   gtk_tree_view_set_model (GTK_TREE_VIEW (view), GTK_TREE_MODEL (view->model));
 
+  /* continue to expand the tree towards the current directory as the folders are loaded */
+  g_signal_connect_swapped (G_OBJECT (view->model), "row-inserted", G_CALLBACK (thunar_tree_view_cursor_row_inserted), view);
+  g_signal_connect_swapped (G_OBJECT (view->model), "row-changed", G_CALLBACK (thunar_tree_view_cursor_row_inserted), view);
+
   /* configure the tree view */
   gtk_tree_view_set_enable_search (GTK_TREE_VIEW (view), FALSE);
   gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (view), FALSE);
@@ -520,8 +541,6 @@ thunar_tree_view_set_current_directory (ThunarNavigator *navigator,
                                         ThunarFile      *current_directory)
 {
   ThunarTreeView *view = THUNAR_TREE_VIEW (navigator);
-  ThunarFile     *file;
-  ThunarFile     *file_parent;
   gboolean        needs_refiltering = FALSE;
 
   /* check if we already use that directory */
@@ -532,35 +551,26 @@ thunar_tree_view_set_current_directory (ThunarNavigator *navigator,
   if (G_LIKELY (view->current_directory != NULL))
     {
       /* update the filter if the old current directory, or one of it's parents, is hidden */
-      if (!view->show_hidden)
+      if (!view->show_hidden && thunar_tree_view_cursor_chain_is_hidden (view))
         {
-          /* look if the file or one of it's parents is hidden */
-          for (file = THUNAR_FILE (g_object_ref (G_OBJECT (view->current_directory))); file != NULL; file = file_parent)
-            {
-              /* check if this file is hidden */
-              if (thunar_file_is_hidden (file))
-                {
-                  /* schedule an update of the filter after the current directory has been changed */
-                  needs_refiltering = TRUE;
-
-                  /* release the file */
-                  g_object_unref (G_OBJECT (file));
-
-                  break;
-                }
-
-              /* get the file parent */
-              file_parent = thunar_file_get_parent (file, NULL);
-
-              /* release the file */
-              g_object_unref (G_OBJECT (file));
-            }
+          /* schedule an update of the filter after the current directory has been changed */
+          needs_refiltering = TRUE;
         }
 
       /* disconnect from the previous current directory */
       g_object_unref (G_OBJECT (view->current_directory));
     }
 
+  /* stop resolving the ancestors of the previous directory */
+  if (view->cursor_cancellable != NULL)
+    {
+      g_cancellable_cancel (view->cursor_cancellable);
+      g_clear_object (&view->cursor_cancellable);
+    }
+  g_list_free_full (view->cursor_chain, g_object_unref);
+  view->cursor_chain = NULL;
+  view->cursor_waiting = FALSE;
+
   /* activate the new current directory */
   view->current_directory = current_directory;
 
@@ -570,42 +580,21 @@ thunar_tree_view_set_current_directory (ThunarNavigator *navigator,
       /* take a reference on the directory */
       g_object_ref (G_OBJECT (current_directory));
 
-      /* update the filter if the new current directory, or one of it's parents, is
-       * hidden. we don't have to check this if refiltering needs to be done
-       * anyway */
-      if (!needs_refiltering && !view->show_hidden)
-        {
-          /* look if the file or one of it's parents is hidden */
-          for (file = THUNAR_FILE (g_object_ref (G_OBJECT (current_directory))); file != NULL; file = file_parent)
-            {
-              /* check if this file is hidden */
-              if (thunar_file_is_hidden (file))
-                {
-                  /* update the filter */
-                  thunar_tree_model_refilter (view->model);
-
-                  /* release the file */
-                  g_object_unref (G_OBJECT (file));
-
-                  break;
-                }
-
-              /* get the file parent */
-              file_parent = thunar_file_get_parent (file, NULL);
-
-              /* release the file */
-              g_object_unref (G_OBJECT (file));
-            }
-        }
+      /* refilter the model first if necessary, the filter of the new
+       * directory is updated once its ancestors are known */
+      if (needs_refiltering)
+        thunar_tree_model_refilter (view->model);
 
-      /* schedule an idle source to set the cursor to the current directory */
-      if (G_LIKELY (view->cursor_idle_id == 0))
-        view->cursor_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_tree_view_cursor_idle, view, thunar_tree_view_cursor_idle_destroy);
+      /* resolve the ancestors of the directory, the cursor idle source
+       * is scheduled once they are known */
+      view->cursor_cancellable = g_cancellable_new ();
+      thunar_tree_view_cursor_resolve (view, current_directory);
+    }
+  else if (needs_refiltering)
+    {
+      /* refilter the model if necessary */
+      thunar_tree_model_refilter (view->model);
     }
-
-  /* refilter the model if necessary */
-  if (needs_refiltering)
-    thunar_tree_model_refilter (view->model);
 
   /* notify listeners */
   g_object_notify (G_OBJECT (view), "current-directory");
@@ -1603,23 +1592,129 @@ thunar_tree_view_selection_func (GtkTreeSelection *selection,
 
 
 
+static void
+thunar_tree_view_cursor_resolve (ThunarTreeView *view,
+                                 ThunarFile     *file)
+{
+  GFile *parent_file;
+
+  _thunar_return_if_fail (THUNAR_IS_TREE_VIEW (view));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  g_object_ref (G_OBJECT (file));
+  while (file != NULL)
+    {
+      view->cursor_chain = g_list_prepend (view->cursor_chain, file);
+
+      /* check if we reached the root of the file system */
+      parent_file = g_file_get_parent (thunar_file_get_file (file));
+      if (parent_file == NULL)
+        break;
+
+      /* continue with the parent right away if it is known, otherwise
+       * load it in the background, which does not block the main
+       * loop for every level of a deep path on a remote mount */
+      file = thunar_file_cache_lookup (parent_file);
+      if (file == NULL)
+        {
+          thunar_file_get_async (parent_file, view->cursor_cancellable,
+                                 thunar_tree_view_cursor_resolved, g_object_ref (G_OBJECT (view)));
+          g_object_unref (parent_file);
+          return;
+        }
+
+      g_object_unref (parent_file);
+    }
+
+  /* the chain is complete now */
+  g_clear_object (&view->cursor_cancellable);
+
+  /* update the filter if the new current directory, or one of it's parents, is hidden */
+  if (!view->show_hidden && thunar_tree_view_cursor_chain_is_hidden (view))
+    thunar_tree_model_refilter (view->model);
+
+  /* schedule an idle source to set the cursor to the current directory */
+  if (G_LIKELY (view->cursor_idle_id == 0))
+    view->cursor_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_tree_view_cursor_idle, view, thunar_tree_view_cursor_idle_destroy);
+}
+
+
+
+static void
+thunar_tree_view_cursor_resolved (GFile      *location,
+                                  ThunarFile *file,
+                                  GError     *error,
+                                  gpointer    user_data)
+{
+  ThunarTreeView *view = THUNAR_TREE_VIEW (user_data);
+
+  /* the current directory was changed meanwhile */
+  if (error != NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_object_unref (G_OBJECT (view));
+      return;
+    }
+
+  /* continue with the parent, or try with the ancestors known so far */
+  if (G_LIKELY (error == NULL))
+    {
+      thunar_tree_view_cursor_resolve (view, file);
+    }
+  else
+    {
+      g_clear_object (&view->cursor_cancellable);
+      if (G_LIKELY (view->cursor_idle_id == 0))
+        view->cursor_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_tree_view_cursor_idle, view, thunar_tree_view_cursor_idle_destroy);
+    }
+
+  g_object_unref (G_OBJECT (view));
+}
+
+
+
+static gboolean
+thunar_tree_view_cursor_chain_is_hidden (ThunarTreeView *view)
+{
+  GList *lp;
+
+  /* look if the current directory or one of it's parents is hidden */
+  for (lp = view->cursor_chain; lp != NULL; lp = lp->next)
+    if (thunar_file_is_hidden (THUNAR_FILE (lp->data)))
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_tree_view_cursor_row_inserted (ThunarTreeView *view)
+{
+  /* the cursor idle source waits for the next folder on the way to
+   * the current directory, which may have been inserted now */
+  if (view->cursor_waiting && view->cursor_idle_id == 0)
+    view->cursor_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_tree_view_cursor_idle, view, thunar_tree_view_cursor_idle_destroy);
+}
+
+
+
 static gboolean
 thunar_tree_view_cursor_idle (gpointer user_data)
 {
   ThunarTreeView *view = THUNAR_TREE_VIEW (user_data);
+  GtkTreeModel   *model = GTK_TREE_MODEL (view->model);
   GtkTreePath    *path;
   GtkTreeIter     iter;
-  ThunarFile     *file;
-  ThunarFolder   *folder;
-  GFileInfo      *file_info;
   GtkTreeIter     child_iter;
   ThunarFile     *file_in_tree;
-  gboolean        done = FALSE;
+  ThunarFile     *child;
+  gboolean        found;
   GList          *lp;
-  GList          *path_as_list = NULL;
 
 THUNAR_THREADS_ENTER
 
+  view->cursor_waiting = FALSE;
+
   /* for easier navigation, we sometimes want to force/keep selection of a certain path */
   if (view->select_path != NULL)
     {
@@ -1629,8 +1724,8 @@ THUNAR_THREADS_ENTER
       return FALSE;
     }
 
-  /* verify that we still have a current directory */
-  if (G_UNLIKELY (view->current_directory == NULL))
+  /* verify that we still have a current directory, whose ancestors are known */
+  if (G_UNLIKELY (view->current_directory == NULL || view->cursor_cancellable != NULL))
     return FALSE;
 
   /* get the preferred toplevel path for the current directory */
@@ -1645,106 +1740,72 @@ THUNAR_THREADS_ENTER
       return FALSE;
     }
 
-  gtk_tree_model_get_iter (GTK_TREE_MODEL (view->model), &iter, path);
+  gtk_tree_model_get_iter (model, &iter, path);
   gtk_tree_path_free (path);
 
-  /* collect all ThunarFiles in the path of current_directory in a List. root is on the very left side */
-  for (file = view->current_directory; file != NULL; file = thunar_file_get_parent (file, NULL))
-      path_as_list = g_list_prepend (path_as_list, file);
-
-  /* 1. skip files on path_as_list till we found the beginning of the tree (which e.g. may start at $HOME */
-  gtk_tree_model_get (GTK_TREE_MODEL (view->model), &iter, THUNAR_TREE_MODEL_COLUMN_FILE, &file_in_tree, -1);
-  for (lp = path_as_list; lp != NULL; lp = lp->next)
-    {
-      if (THUNAR_FILE (lp->data) == file_in_tree)
-          break;
-    }
+  /* 1. skip the ancestors till we found the beginning of the tree (which e.g. may start at $HOME) */
+  gtk_tree_model_get (model, &iter, THUNAR_TREE_MODEL_COLUMN_FILE, &file_in_tree, -1);
+  lp = g_list_find (view->cursor_chain, file_in_tree);
   if (file_in_tree)
     g_object_unref (file_in_tree);
 
-  /* 2. loop on the remaining path_as_list */
+  /* 2. descend one tree level for every remaining ancestor */
   for (; lp != NULL; lp = lp->next)
     {
-      file = THUNAR_FILE (lp->data);
-
-      /* 3. Check if the contents of the corresponding folder is still being loaded */
-      folder = thunar_folder_get_for_file (file);
-      if (folder != NULL && thunar_folder_get_loading (folder))
+      /* 3. Did we already find the full path ? */
+      if (lp->next == NULL)
         {
-          g_object_unref (folder);
+          path = gtk_tree_model_get_path (model, &iter);
+          gtk_tree_view_set_cursor (GTK_TREE_VIEW (view), path, NULL, FALSE);
+          gtk_tree_path_free (path);
           break;
         }
-      if (folder)
-        g_object_unref (folder);
 
-      /* 4. Loop on all items of current tree-level to see if any folder matches the path we search */
-      while (TRUE)
+      /* 4. Loop on the children of the current tree iter to find the next folder of the path */
+      child = THUNAR_FILE (lp->next->data);
+      found = FALSE;
+      if (gtk_tree_model_iter_children (model, &child_iter, &iter))
         {
-          gtk_tree_model_get (GTK_TREE_MODEL (view->model), &iter, THUNAR_TREE_MODEL_COLUMN_FILE, &file_in_tree, -1);
-          if (file == file_in_tree)
+          do
             {
-              g_object_unref (file_in_tree);
-              break;
+              gtk_tree_model_get (model, &child_iter, THUNAR_TREE_MODEL_COLUMN_FILE, &file_in_tree, -1);
+              found = (file_in_tree == child);
+              if (file_in_tree)
+                g_object_unref (file_in_tree);
             }
-          if (file_in_tree)
-            g_object_unref (file_in_tree);
-
-          if (!gtk_tree_model_iter_next (GTK_TREE_MODEL (view->model), &iter))
-            break;
+          while (!found && gtk_tree_model_iter_next (model, &child_iter));
         }
 
-      /* 5. Did we already find the full path ?*/
-      if (lp->next == NULL)
+      if (!found)
         {
-          path = gtk_tree_model_get_path (GTK_TREE_MODEL (view->model), &iter);
-          gtk_tree_view_set_cursor (GTK_TREE_VIEW (view), path, NULL, FALSE);
-          gtk_tree_path_free (path);
-          done = TRUE;
-          break;
-        }
-
-      /* 6. Get all children of the current tree iter */
-      /* Try to create missing children on the tree if there are none */
-      if (!gtk_tree_model_iter_children (GTK_TREE_MODEL (view->model), &child_iter, &iter))
-        {
-          if (file == NULL) /* e.g root has no parent .. skip it */
-            continue;
+          /* 5. The folder was not listed yet, or cannot be listed at all (e.g. missing read
+           *    permission). We KNOW that the next folder exists, so create the tree-node right
+           *    away instead of waiting for the whole folder. The listing merges with it later. */
+          if (!gtk_tree_model_iter_has_child (model, &iter) || thunar_tree_model_node_has_dummy (view->model, iter.user_data))
+            {
+              thunar_tree_model_add_child (view->model, iter.user_data, child);
+              found = gtk_tree_model_iter_children (model, &child_iter, &iter);
+            }
 
-          file_info = thunar_file_get_info (file);
-          if (file_info != NULL)
+          /* 6. Otherwise the folder is being listed, continue once the next folder was inserted */
+          if (!found)
             {
-              /* E.g. folders for which we do not have read permission dont have any child in the tree */
-              /* Make sure that missing read permissions are the problem */
-              if (!g_file_info_get_attribute_boolean (file_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ))
-                {
-                  /* We KNOW that there is a File. Lets just create the required tree-node */
-                  thunar_tree_model_add_child (view->model, iter.user_data,  THUNAR_FILE (lp->next->data));
-                }
+              view->cursor_waiting = TRUE;
+              break;
             }
-          break; /* we dont have a valid child_iter by now, so we cannot continue.                         */
-                 /* Since done is FALSE, the next iteration on thunar_tree_view_cursor_idle will go deeper */
         }
 
       /* expand path up to the current tree level */
-      path = gtk_tree_model_get_path (GTK_TREE_MODEL (view->model), &iter);
+      path = gtk_tree_model_get_path (model, &iter);
       gtk_tree_view_expand_to_path (GTK_TREE_VIEW (view), path);
       gtk_tree_path_free (path);
 
       iter = child_iter; /* next tree level */
     }
 
-  /* tidy up */
-  for (lp = path_as_list; lp != NULL; lp = lp->next)
-    {
-      file = THUNAR_FILE (lp->data);
-      if (file != NULL && file != view->current_directory)
-        g_object_unref (file);
-    }
-  g_list_free (path_as_list);
-
 THUNAR_THREADS_LEAVE
 
-  return !done;
+  return FALSE;
 }
 
 
@@ -27,6 +27,9 @@
 #include <sys/types.h>
 #endif
 
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
 #ifdef HAVE_GRP_H
 #include <grp.h>
 #endif
@@ -50,19 +53,51 @@
 
 #include <exo/exo.h>
 
+#include <thunar/thunar-private.h>
 #include <thunar/thunar-user.h>
 #include <thunar/thunar-util.h>
 
 
 
-/* the interval in which the user/group cache is flushed (in seconds) */
-#define THUNAR_USER_MANAGER_FLUSH_INTERVAL (10 * 60)
+/* the time after which a user or group is looked up again (in seconds) */
+#define THUNAR_USER_MANAGER_TTL (10 * 60)
+
+/* the number of threads resolving users and groups in the background */
+#define THUNAR_USER_MANAGER_LOOKUP_THREADS (4)
+
+
+
+/* the result of looking up a user or a group, either directly or
+ * by the lookup threads of the user manager */
+typedef struct
+{
+  GObject  *object;
+  guint32   id;
+  gboolean  found;
+  gchar    *name;
+
+  /* only for users */
+  gchar    *real_name;
+  guint32   gid;
+  gchar    *group_name;
+}
+ThunarUserLookup;
+
+
+
+static gboolean     thunar_user_lookup_passwd        (guint32           id,
+                                                      ThunarUserLookup *lookup);
+static gchar       *thunar_user_lookup_group_name    (guint32           id);
+static void         thunar_user_manager_queue_lookup (GObject          *object,
+                                                      guint32           id);
 
 
 
 
 static void         thunar_group_finalize   (GObject          *object);
 static ThunarGroup *thunar_group_new        (guint32           id);
+static void         thunar_group_set_name   (ThunarGroup      *group,
+                                             gchar            *name);
 
 
 
@@ -77,6 +112,13 @@ struct _ThunarGroup
 
   guint32 id;
   gchar  *name;
+
+  /* the numeric placeholder shown until the name is known */
+  gchar   id_text[11];
+
+  /* when the name was looked up, and whether a lookup is queued */
+  gint64  load_time;
+  guint   lookup_pending : 1;
 };
 
 
@@ -123,12 +165,32 @@ thunar_group_new (guint32 id)
 
   group = g_object_new (THUNAR_TYPE_GROUP, NULL);
   group->id = id;
+  g_snprintf (group->id_text, sizeof (group->id_text), "%u", (guint) id);
 
   return group;
 }
 
 
 
+static void
+thunar_group_set_name (ThunarGroup *group,
+                       gchar       *name)
+{
+  g_free (group->name);
+  group->name = (name != NULL) ? name : g_strdup (group->id_text);
+  group->load_time = g_get_monotonic_time ();
+}
+
+
+
+static gboolean
+thunar_group_is_stale (ThunarGroup *group)
+{
+  return g_get_monotonic_time () - group->load_time > THUNAR_USER_MANAGER_TTL * G_USEC_PER_SEC;
+}
+
+
+
 /**
  * thunar_group_get_id:
  * @group : a #ThunarGroup.
@@ -159,27 +221,47 @@ thunar_group_get_id (ThunarGroup *group)
 const gchar*
 thunar_group_get_name (ThunarGroup *group)
 {
-  struct group *grp;
-
   g_return_val_if_fail (THUNAR_IS_GROUP (group), NULL);
 
   /* determine the name on-demand */
   if (G_UNLIKELY (group->name == NULL))
-    {
-      grp = getgrgid (group->id);
-      if (G_LIKELY (grp != NULL))
-        group->name = g_strdup (grp->gr_name);
-      else
-        group->name = g_strdup_printf ("%u", (guint) group->id);
-    }
+    thunar_group_set_name (group, thunar_user_lookup_group_name (group->id));
+  else if (G_UNLIKELY (thunar_group_is_stale (group)))
+    thunar_user_manager_queue_lookup (G_OBJECT (group), group->id);
 
   return group->name;
 }
 
 
 
-static void        thunar_user_finalize          (GObject         *object);
-static void        thunar_user_load              (ThunarUser      *user);
+/**
+ * thunar_group_peek_name:
+ * @group : a #ThunarGroup.
+ *
+ * Like thunar_group_get_name(), but never blocks. If the name of
+ * @group is not known yet, it is looked up in the background and
+ * the group id is returned as string meanwhile. The
+ * #ThunarUserManager::changed signal tells when the name is known.
+ *
+ * Return value: the name of @group, or its id as string.
+ **/
+const gchar*
+thunar_group_peek_name (ThunarGroup *group)
+{
+  g_return_val_if_fail (THUNAR_IS_GROUP (group), NULL);
+
+  if (G_UNLIKELY (group->name == NULL || thunar_group_is_stale (group)))
+    thunar_user_manager_queue_lookup (G_OBJECT (group), group->id);
+
+  return (group->name != NULL) ? group->name : group->id_text;
+}
+
+
+
+static void        thunar_user_finalize          (GObject          *object);
+static void        thunar_user_load              (ThunarUser       *user);
+static void        thunar_user_apply             (ThunarUser       *user,
+                                                  ThunarUserLookup *lookup);
 static ThunarUser *thunar_user_new               (guint32          id);
 static ThunarGroup*thunar_user_get_primary_group (ThunarUser      *user);
 
@@ -198,6 +280,13 @@ struct _ThunarUser
   guint32      id;
   gchar       *name;
   gchar       *real_name;
+
+  /* the numeric placeholder shown until the name is known */
+  gchar        id_text[11];
+
+  /* when the account was looked up, and whether a lookup is queued */
+  gint64       load_time;
+  guint        lookup_pending : 1;
 };
 
 
@@ -255,59 +344,165 @@ thunar_user_finalize (GObject *object)
 
 
 
-static void
-thunar_user_load (ThunarUser *user)
+static gboolean
+thunar_user_lookup_passwd (guint32           id,
+                           ThunarUserLookup *lookup)
 {
-  ThunarUserManager *manager;
-  struct passwd     *pw;
-  const gchar       *s;
-  gchar             *name;
-  gchar             *t;
-
-  g_return_if_fail (user->name == NULL);
+  struct passwd  pwd;
+  struct passwd *pw = NULL;
+  const gchar   *s;
+  gchar         *buffer;
+  gchar         *name;
+  gchar         *t;
+  glong          size;
+  gint           error;
+
+  /* the reentrant version, so this also works in the lookup threads */
+  size = sysconf (_SC_GETPW_R_SIZE_MAX);
+  if (size <= 0)
+    size = 16384;
+  for (;;)
+    {
+      buffer = g_malloc (size);
+      error = getpwuid_r (id, &pwd, buffer, size, &pw);
+      if (G_LIKELY (error != ERANGE))
+        break;
+      g_free (buffer);
+      size *= 2;
+    }
 
-  pw = getpwuid (user->id);
+  lookup->found = (pw != NULL);
   if (G_LIKELY (pw != NULL))
     {
-      manager = thunar_user_manager_get_default ();
-
       /* query name and primary group */
-      user->name = g_strdup (pw->pw_name);
-      user->primary_group = thunar_user_manager_get_group_by_id (manager, pw->pw_gid);
+      lookup->name = g_strdup (pw->pw_name);
+      lookup->gid = pw->pw_gid;
 
       /* try to figure out the real name */
       s = strchr (pw->pw_gecos, ',');
       if (s != NULL)
-        user->real_name = g_strndup (pw->pw_gecos, s - pw->pw_gecos);
+        lookup->real_name = g_strndup (pw->pw_gecos, s - pw->pw_gecos);
       else if (pw->pw_gecos[0] != '\0')
-        user->real_name = g_strdup (pw->pw_gecos);
+        lookup->real_name = g_strdup (pw->pw_gecos);
 
       /* substitute '&' in the real_name with the account name */
-      if (G_LIKELY (user->real_name != NULL && strchr (user->real_name, '&') != NULL))
+      if (G_LIKELY (lookup->real_name != NULL && strchr (lookup->real_name, '&') != NULL))
         {
           /* generate a version of the username with the first char upper'd */
-          name = g_strdup (user->name);
+          name = g_strdup (lookup->name);
           name[0] = g_ascii_toupper (name[0]);
 
           /* replace all occurances of '&' */
-          t = exo_str_replace (user->real_name, "&", name);
-          g_free (user->real_name);
-          user->real_name = t;
+          t = exo_str_replace (lookup->real_name, "&", name);
+          g_free (lookup->real_name);
+          lookup->real_name = t;
 
           /* clean up */
           g_free (name);
         }
+    }
+
+  g_free (buffer);
+
+  return lookup->found;
+}
+
+
+
+static gchar*
+thunar_user_lookup_group_name (guint32 id)
+{
+  struct group  grp;
+  struct group *gr = NULL;
+  gchar        *buffer;
+  gchar        *name = NULL;
+  glong         size;
+  gint          error;
+
+  size = sysconf (_SC_GETGR_R_SIZE_MAX);
+  if (size <= 0)
+    size = 16384;
+  for (;;)
+    {
+      buffer = g_malloc (size);
+      error = getgrgid_r (id, &grp, buffer, size, &gr);
+      if (G_LIKELY (error != ERANGE))
+        break;
+      g_free (buffer);
+      size *= 2;
+    }
+
+  if (G_LIKELY (gr != NULL))
+    name = g_strdup (gr->gr_name);
+
+  g_free (buffer);
+
+  return name;
+}
+
+
 
-      g_object_unref (G_OBJECT (manager));
+static void
+thunar_user_apply (ThunarUser       *user,
+                   ThunarUserLookup *lookup)
+{
+  ThunarUserManager *manager;
+
+  g_free (user->name);
+  g_free (user->real_name);
+  user->real_name = NULL;
+  user->load_time = g_get_monotonic_time ();
+
+  if (G_LIKELY (lookup->found))
+    {
+      /* take over the names */
+      user->name = lookup->name;
+      user->real_name = lookup->real_name;
+      lookup->name = NULL;
+      lookup->real_name = NULL;
+
+      /* the primary group of an account rarely changes */
+      if (user->primary_group == NULL || thunar_group_get_id (user->primary_group) != lookup->gid)
+        {
+          if (user->primary_group != NULL)
+            g_object_unref (G_OBJECT (user->primary_group));
+
+          manager = thunar_user_manager_get_default ();
+          user->primary_group = thunar_user_manager_get_group_by_id (manager, lookup->gid);
+          g_object_unref (G_OBJECT (manager));
+        }
     }
   else
     {
-      user->name = g_strdup_printf ("%u", (guint) user->id);
+      user->name = g_strdup (user->id_text);
     }
 }
 
 
 
+static void
+thunar_user_load (ThunarUser *user)
+{
+  ThunarUserLookup lookup = { NULL, };
+
+  g_return_if_fail (user->name == NULL);
+
+  thunar_user_lookup_passwd (user->id, &lookup);
+  thunar_user_apply (user, &lookup);
+  g_free (lookup.name);
+  g_free (lookup.real_name);
+}
+
+
+
+static gboolean
+thunar_user_is_stale (ThunarUser *user)
+{
+  return g_get_monotonic_time () - user->load_time > THUNAR_USER_MANAGER_TTL * G_USEC_PER_SEC;
+}
+
+
+
 static ThunarUser*
 thunar_user_new (guint32 id)
 {
@@ -315,6 +510,7 @@ thunar_user_new (guint32 id)
 
   user = g_object_new (THUNAR_TYPE_USER, NULL);
   user->id = id;
+  g_snprintf (user->id_text, sizeof (user->id_text), "%u", (guint) id);
 
   return user;
 }
@@ -417,12 +613,38 @@ thunar_user_get_name (ThunarUser *user)
   /* load the user's data on-demand */
   if (G_UNLIKELY (user->name == NULL))
     thunar_user_load (user);
+  else if (G_UNLIKELY (thunar_user_is_stale (user)))
+    thunar_user_manager_queue_lookup (G_OBJECT (user), user->id);
 
   return user->name;
 }
 
 
 
+/**
+ * thunar_user_peek_name:
+ * @user : a #ThunarUser.
+ *
+ * Like thunar_user_get_name(), but never blocks. If the account of
+ * @user is not known yet, it is looked up in the background and
+ * the user id is returned as string meanwhile. The
+ * #ThunarUserManager::changed signal tells when the account is known.
+ *
+ * Return value: the name of @user, or its id as string.
+ **/
+const gchar*
+thunar_user_peek_name (ThunarUser *user)
+{
+  g_return_val_if_fail (THUNAR_IS_USER (user), NULL);
+
+  if (G_UNLIKELY (user->name == NULL || thunar_user_is_stale (user)))
+    thunar_user_manager_queue_lookup (G_OBJECT (user), user->id);
+
+  return (user->name != NULL) ? user->name : user->id_text;
+}
+
+
+
 /**
  * thunar_user_get_real_name:
  * @user : a #ThunarUser.
@@ -447,6 +669,28 @@ thunar_user_get_real_name (ThunarUser *user)
 
 
 
+/**
+ * thunar_user_peek_real_name:
+ * @user : a #ThunarUser.
+ *
+ * Like thunar_user_get_real_name(), but never blocks, see
+ * thunar_user_peek_name().
+ *
+ * Return value: the real name for @user or %NULL.
+ **/
+const gchar*
+thunar_user_peek_real_name (ThunarUser *user)
+{
+  g_return_val_if_fail (THUNAR_IS_USER (user), NULL);
+
+  if (G_UNLIKELY (user->name == NULL || thunar_user_is_stale (user)))
+    thunar_user_manager_queue_lookup (G_OBJECT (user), user->id);
+
+  return user->real_name;
+}
+
+
+
 /**
  * thunar_user_is_me:
  * @user : a #ThunarUser.
@@ -467,9 +711,19 @@ thunar_user_is_me (ThunarUser *user)
 
 
 
-static void     thunar_user_manager_finalize            (GObject                *object);
-static gboolean thunar_user_manager_flush_timer         (gpointer                user_data);
-static void     thunar_user_manager_flush_timer_destroy (gpointer                user_data);
+static void     thunar_user_manager_finalize      (GObject                *object);
+static void     thunar_user_manager_lookup_worker (gpointer                data,
+                                                   gpointer                user_data);
+static gboolean thunar_user_manager_lookup_idle   (gpointer                user_data);
+
+
+
+/* Signal identifiers */
+enum
+{
+  CHANGED,
+  LAST_SIGNAL,
+};
 
 
 
@@ -484,12 +738,21 @@ struct _ThunarUserManager
 
   GHashTable *groups;
   GHashTable *users;
-
-  guint       flush_timer_id;
 };
 
 
 
+static guint              user_manager_signals[LAST_SIGNAL];
+static ThunarUserManager *user_manager_default = NULL;
+
+/* the lookups done by the threads, applied in the main loop */
+static GThreadPool       *lookup_pool = NULL;
+static GSList            *lookup_results = NULL;
+static guint              lookup_idle_id = 0;
+G_LOCK_DEFINE_STATIC (lookup_results);
+
+
+
 G_DEFINE_TYPE (ThunarUserManager, thunar_user_manager, G_TYPE_OBJECT)
 
 
@@ -501,6 +764,21 @@ thunar_user_manager_class_init (ThunarUserManagerClass *klass)
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_user_manager_finalize;
+
+  /**
+   * ThunarUserManager::changed:
+   * @manager : the default #ThunarUserManager.
+   *
+   * Emitted whenever the background lookups, see thunar_user_peek_name()
+   * and thunar_group_peek_name(), determined the names of users or groups.
+   **/
+  user_manager_signals[CHANGED] =
+    g_signal_new (I_("changed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_NO_HOOKS,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
 }
 
 
@@ -520,11 +798,6 @@ thunar_user_manager_init (ThunarUserManager *manager)
 #ifdef HAVE_SETPASSENT
   setpassent (TRUE);
 #endif
-
-  /* start the flush timer */
-  manager->flush_timer_id = g_timeout_add_seconds_full (G_PRIORITY_LOW, THUNAR_USER_MANAGER_FLUSH_INTERVAL,
-                                                        thunar_user_manager_flush_timer, manager,
-                                                        thunar_user_manager_flush_timer_destroy);
 }
 
 
@@ -534,11 +807,7 @@ thunar_user_manager_finalize (GObject *object)
 {
   ThunarUserManager *manager = THUNAR_USER_MANAGER (object);
 
-  /* stop the flush timer */
-  if (G_LIKELY (manager->flush_timer_id != 0))
-    g_source_remove (manager->flush_timer_id);
-
-  /* destroy the hash tables */
+  /* destroy the hash tables, pending lookups keep their objects alive */
   g_hash_table_destroy (manager->groups);
   g_hash_table_destroy (manager->users);
 
@@ -553,50 +822,122 @@ thunar_user_manager_finalize (GObject *object)
 
 
 
-static gboolean
-thunar_user_manager_flush_timer (gpointer user_data)
+static void
+thunar_user_manager_queue_lookup (GObject *object,
+                                  guint32  id)
 {
-  ThunarUserManager *manager = THUNAR_USER_MANAGER (user_data);
-  guint              size = 0;
+  ThunarUserLookup *lookup;
 
-THUNAR_THREADS_ENTER
+  /* only one lookup per user or group at a time */
+  if (THUNAR_IS_USER (object))
+    {
+      if (THUNAR_USER (object)->lookup_pending)
+        return;
+      THUNAR_USER (object)->lookup_pending = TRUE;
+    }
+  else
+    {
+      if (THUNAR_GROUP (object)->lookup_pending)
+        return;
+      THUNAR_GROUP (object)->lookup_pending = TRUE;
+    }
 
-  /* drop all cached groups */
-  size += g_hash_table_foreach_remove (manager->groups,
-                                       (GHRFunc) (void (*)(void)) gtk_true,
-                                       NULL);
+  /* NSS may ask a directory server, so don't block the main loop */
+  if (G_UNLIKELY (lookup_pool == NULL))
+    {
+      lookup_pool = g_thread_pool_new (thunar_user_manager_lookup_worker, NULL,
+                                       THUNAR_USER_MANAGER_LOOKUP_THREADS, FALSE, NULL);
+    }
 
-  /* drop all cached users */
-  size += g_hash_table_foreach_remove (manager->users,
-                                       (GHRFunc) (void (*)(void)) gtk_true,
-                                       NULL);
+  lookup = g_slice_new0 (ThunarUserLookup);
+  lookup->object = g_object_ref (object);
+  lookup->id = id;
+  g_thread_pool_push (lookup_pool, lookup, NULL);
+}
 
-  /* reload groups and passwd files if we had cached entities */
-  if (G_LIKELY (size > 0))
-    {
-      endgrent ();
-      endpwent ();
 
-#ifdef HAVE_SETGROUPENT
-      setgroupent (TRUE);
-#endif
 
-#ifdef HAVE_SETPASSENT
-      setpassent (TRUE);
-#endif
-    }
+static void
+thunar_user_manager_lookup_worker (gpointer data,
+                                   gpointer user_data)
+{
+  ThunarUserLookup *lookup = data;
 
-THUNAR_THREADS_LEAVE
+  if (THUNAR_IS_USER (lookup->object))
+    {
+      /* resolve the primary group on the way, it is usually shown as well */
+      if (thunar_user_lookup_passwd (lookup->id, lookup))
+        lookup->group_name = thunar_user_lookup_group_name (lookup->gid);
+    }
+  else
+    {
+      lookup->name = thunar_user_lookup_group_name (lookup->id);
+      lookup->found = (lookup->name != NULL);
+    }
 
-  return TRUE;
+  /* hand the result back to the main loop, which owns the objects */
+  G_LOCK (lookup_results);
+  lookup_results = g_slist_prepend (lookup_results, lookup);
+  if (lookup_idle_id == 0)
+    lookup_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_user_manager_lookup_idle, NULL, NULL);
+  G_UNLOCK (lookup_results);
 }
 
 
 
-static void
-thunar_user_manager_flush_timer_destroy (gpointer user_data)
+static gboolean
+thunar_user_manager_lookup_idle (gpointer user_data)
 {
-  THUNAR_USER_MANAGER (user_data)->flush_timer_id = 0;
+  ThunarUserLookup *lookup;
+  ThunarGroup      *group;
+  ThunarUser       *user;
+  GSList           *results;
+  GSList           *lp;
+
+  G_LOCK (lookup_results);
+  results = lookup_results;
+  lookup_results = NULL;
+  lookup_idle_id = 0;
+  G_UNLOCK (lookup_results);
+
+  for (lp = results; lp != NULL; lp = lp->next)
+    {
+      lookup = lp->data;
+      if (THUNAR_IS_USER (lookup->object))
+        {
+          user = THUNAR_USER (lookup->object);
+          user->lookup_pending = FALSE;
+          thunar_user_apply (user, lookup);
+
+          /* take the prefetched name of the primary group */
+          group = user->primary_group;
+          if (group != NULL && lookup->group_name != NULL && group->name == NULL)
+            {
+              thunar_group_set_name (group, lookup->group_name);
+              lookup->group_name = NULL;
+            }
+        }
+      else
+        {
+          group = THUNAR_GROUP (lookup->object);
+          group->lookup_pending = FALSE;
+          thunar_group_set_name (group, lookup->name);
+          lookup->name = NULL;
+        }
+
+      g_object_unref (lookup->object);
+      g_free (lookup->name);
+      g_free (lookup->real_name);
+      g_free (lookup->group_name);
+      g_slice_free (ThunarUserLookup, lookup);
+    }
+  g_slist_free (results);
+
+  /* tell the views to show the names instead of the ids */
+  if (G_LIKELY (user_manager_default != NULL))
+    g_signal_emit (G_OBJECT (user_manager_default), user_manager_signals[CHANGED], 0);
+
+  return FALSE;
 }
 
 
@@ -613,19 +954,17 @@ thunar_user_manager_flush_timer_destroy (gpointer user_data)
 ThunarUserManager*
 thunar_user_manager_get_default (void)
 {
-  static ThunarUserManager *manager = NULL;
-
-  if (G_UNLIKELY (manager == NULL))
+  if (G_UNLIKELY (user_manager_default == NULL))
     {
-      manager = g_object_new (THUNAR_TYPE_USER_MANAGER, NULL);
-      g_object_add_weak_pointer (G_OBJECT (manager), (gpointer) &manager);
+      user_manager_default = g_object_new (THUNAR_TYPE_USER_MANAGER, NULL);
+      g_object_add_weak_pointer (G_OBJECT (user_manager_default), (gpointer) &user_manager_default);
     }
   else
     {
-      g_object_ref (G_OBJECT (manager));
+      g_object_ref (G_OBJECT (user_manager_default));
     }
 
-  return manager;
+  return user_manager_default;
 }
 
 
@@ -744,3 +1083,56 @@ thunar_user_manager_get_all_groups (ThunarUserManager *manager)
 
   return groups;
 }
+
+
+
+/**
+ * thunar_user_manager_get_memory:
+ * @manager  : a #ThunarUserManager.
+ * @n_users  : return location for the number of cached users.
+ * @n_groups : return location for the number of cached groups.
+ * @n_bytes  : return location for the estimated memory of both tables.
+ *
+ * Estimates the memory held by the user and group tables of @manager.
+ * This function may only be used from the main thread.
+ **/
+void
+thunar_user_manager_get_memory (ThunarUserManager *manager,
+                                guint             *n_users,
+                                guint             *n_groups,
+                                guint64           *n_bytes)
+{
+  GHashTableIter iter;
+  ThunarGroup   *group;
+  ThunarUser    *user;
+  guint64        bytes = 0;
+
+  _thunar_return_if_fail (THUNAR_IS_USER_MANAGER (manager));
+
+  /* every table entry is two pointers and a hash */
+  g_hash_table_iter_init (&iter, manager->users);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &user))
+    {
+      bytes += sizeof (ThunarUser) + 2 * sizeof (gpointer) + sizeof (guint);
+      bytes += g_list_length (user->groups) * 3 * sizeof (gpointer);
+      if (user->name != NULL)
+        bytes += strlen (user->name) + 1;
+      if (user->real_name != NULL)
+        bytes += strlen (user->real_name) + 1;
+    }
+
+  g_hash_table_iter_init (&iter, manager->groups);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &group))
+    {
+      bytes += sizeof (ThunarGroup) + 2 * sizeof (gpointer) + sizeof (guint);
+      if (group->name != NULL)
+        bytes += strlen (group->name) + 1;
+    }
+
+  if (n_users != NULL)
+    *n_users = g_hash_table_size (manager->users);
+  if (n_groups != NULL)
+    *n_groups = g_hash_table_size (manager->groups);
+  if (n_bytes != NULL)
+    *n_bytes = bytes;
+}
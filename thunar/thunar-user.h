@@ -40,6 +40,7 @@ GType         thunar_group_get_type  (void) G_GNUC_CONST;
 
 guint32       thunar_group_get_id    (ThunarGroup *group);
 const gchar  *thunar_group_get_name  (ThunarGroup *group);
+const gchar  *thunar_group_peek_name (ThunarGroup *group);
 
 
 typedef struct _ThunarUserClass ThunarUserClass;
@@ -57,6 +58,8 @@ GType         thunar_user_get_type          (void) G_GNUC_CONST;
 GList        *thunar_user_get_groups        (ThunarUser *user);
 const gchar  *thunar_user_get_name          (ThunarUser *user);
 const gchar  *thunar_user_get_real_name     (ThunarUser *user);
+const gchar  *thunar_user_peek_name         (ThunarUser *user);
+const gchar  *thunar_user_peek_real_name    (ThunarUser *user);
 gboolean      thunar_user_is_me             (ThunarUser *user);
 
 
@@ -81,6 +84,11 @@ ThunarUser        *thunar_user_manager_get_user_by_id  (ThunarUserManager *manag
 
 GList             *thunar_user_manager_get_all_groups  (ThunarUserManager *manager) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+void               thunar_user_manager_get_memory      (ThunarUserManager *manager,
+                                                        guint             *n_users,
+                                                        guint             *n_groups,
+                                                        guint64           *n_bytes);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_USER_H__ */
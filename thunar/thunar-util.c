@@ -646,6 +646,50 @@ thunar_util_change_working_directory (const gchar *new_directory)
   return old_directory;
 }
 
+
+
+/**
+ * thunar_util_startup_trace:
+ * @phase : the name of the startup phase that just finished.
+ *
+ * Prints the time since the first call and since the previous call
+ * for @phase to stderr, if the THUNAR_STARTUP_TRACE environment
+ * variable is set. Otherwise this does nothing.
+ **/
+void
+thunar_util_startup_trace (const gchar *phase)
+{
+  static gint    enabled = -1;
+  static gint64  start_time = 0;
+  static gint64  last_time = 0;
+  gint64         now;
+
+  _thunar_return_if_fail (phase != NULL);
+
+  if (G_LIKELY (enabled == 0))
+    return;
+
+  if (G_UNLIKELY (enabled < 0))
+    {
+      enabled = (g_getenv ("THUNAR_STARTUP_TRACE") != NULL) ? 1 : 0;
+      if (G_LIKELY (enabled == 0))
+        return;
+    }
+
+  now = g_get_monotonic_time ();
+  if (G_UNLIKELY (start_time == 0))
+    start_time = last_time = now;
+
+  g_printerr ("thunar-startup: %9.3f ms (+%8.3f ms) %s\n",
+              (now - start_time) / 1000.0,
+              (now - last_time) / 1000.0,
+              phase);
+
+  last_time = now;
+}
+
+
+
 void
 thunar_setup_display_cb (gpointer data)
 {
@@ -257,7 +257,8 @@ thunar_view_reset_zoom_level (ThunarView *view)
  *
  * Tells @view to reread the currently displayed folder
  * contents from the underlying media. If reload_info is
- * TRUE, it will reload information for all files too.
+ * TRUE, it will reload information for all files too,
+ * else the folder is only read again if it changed.
  **/
 void
 thunar_view_reload (ThunarView *view,
@@ -0,0 +1,392 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Thunar development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-counters.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-watchdog.h>
+
+
+
+/* If the THUNAR_WATCHDOG environment variable is set, a thread watches
+ * the main loop and reports every dispatch that takes longer than the
+ * number of milliseconds in the variable (250 if it is not a number).
+ * A report names the innermost operation pushed with
+ * thunar_watchdog_push_operation() and, where the platform allows it,
+ * carries a backtrace of the main thread taken while it was blocked.
+ * Reports are printed to stderr and kept for the GetStalls method of
+ * org.xfce.Thunar.Debug.
+ */
+
+#define THUNAR_WATCHDOG_DEFAULT_THRESHOLD (250)
+#define THUNAR_WATCHDOG_MAX_DEPTH         (8)
+#define THUNAR_WATCHDOG_MAX_STALLS        (16)
+#define THUNAR_WATCHDOG_MAX_FRAMES        (64)
+
+#if defined (HAVE_EXECINFO_H) && defined (HAVE_BACKTRACE) && defined (HAVE_PTHREAD_H) \
+    && defined (HAVE_PTHREAD_KILL) && defined (HAVE_SIGNAL_H)
+#define THUNAR_WATCHDOG_BACKTRACES
+#endif
+
+
+
+typedef struct
+{
+  guint64  duration_ms;
+  gchar   *operation;
+  gchar   *backtrace;
+}
+ThunarWatchdogStall;
+
+
+
+gboolean thunar_watchdog_enabled = FALSE;
+
+static GMutex   watchdog_mutex;
+static GThread *watchdog_main_thread = NULL;
+static guint    watchdog_threshold = 0;
+
+/* the operations of the main thread and the recent stalls, newest
+ * first, both protected by the mutex */
+static gchar   *watchdog_operations[THUNAR_WATCHDOG_MAX_DEPTH];
+static guint    watchdog_depth = 0;
+static GQueue   watchdog_stalls = G_QUEUE_INIT;
+
+#ifdef THUNAR_WATCHDOG_BACKTRACES
+/* written by the signal handler on the main thread */
+static pthread_t  watchdog_main_pthread;
+static void      *watchdog_frames[THUNAR_WATCHDOG_MAX_FRAMES];
+static gint       watchdog_n_frames = 0;
+#endif
+
+
+
+#ifdef THUNAR_WATCHDOG_BACKTRACES
+static void
+thunar_watchdog_sample (gint signum)
+{
+  /* backtrace() was called once in thunar_watchdog_init(), so its
+   * library is loaded and it does not allocate anymore */
+  g_atomic_int_set (&watchdog_n_frames, backtrace (watchdog_frames, THUNAR_WATCHDOG_MAX_FRAMES));
+}
+#endif
+
+
+
+static gchar *
+thunar_watchdog_backtrace (void)
+{
+#ifdef THUNAR_WATCHDOG_BACKTRACES
+  GString  *string;
+  gchar   **symbols;
+  gint      n_frames = -1;
+  gint      n;
+
+  /* interrupt the main thread to take the backtrace */
+  g_atomic_int_set (&watchdog_n_frames, -1);
+  if (pthread_kill (watchdog_main_pthread, SIGUSR1) != 0)
+    return NULL;
+
+  for (n = 0; n < 100; ++n)
+    {
+      n_frames = g_atomic_int_get (&watchdog_n_frames);
+      if (n_frames >= 0)
+        break;
+      g_usleep (1000);
+    }
+
+  if (n_frames <= 0)
+    return NULL;
+
+  symbols = backtrace_symbols (watchdog_frames, n_frames);
+  if (G_UNLIKELY (symbols == NULL))
+    return NULL;
+
+  /* skip the signal handler and the signal trampoline */
+  string = g_string_new (NULL);
+  for (n = MIN (2, n_frames - 1); n < n_frames; ++n)
+    g_string_append_printf (string, "  #%d %s\n", n, symbols[n]);
+  free (symbols);
+
+  return g_string_free (string, FALSE);
+#else
+  return NULL;
+#endif
+}
+
+
+
+static ThunarWatchdogStall *
+thunar_watchdog_report (gint64 busy_time)
+{
+  ThunarWatchdogStall *stall;
+
+  stall = g_slice_new0 (ThunarWatchdogStall);
+  stall->duration_ms = busy_time / 1000;
+
+  g_mutex_lock (&watchdog_mutex);
+  if (watchdog_depth > 0)
+    stall->operation = g_strdup (watchdog_operations[MIN (watchdog_depth, THUNAR_WATCHDOG_MAX_DEPTH) - 1]);
+  g_mutex_unlock (&watchdog_mutex);
+
+  stall->backtrace = thunar_watchdog_backtrace ();
+
+  g_printerr ("thunar-watchdog: main loop blocked for %" G_GUINT64_FORMAT " ms during %s\n%s",
+              stall->duration_ms,
+              stall->operation != NULL ? stall->operation : "an unknown operation",
+              stall->backtrace != NULL ? stall->backtrace : "");
+
+  /* remember the stall, dropping the oldest ones */
+  g_mutex_lock (&watchdog_mutex);
+  g_queue_push_head (&watchdog_stalls, stall);
+  while (watchdog_stalls.length > THUNAR_WATCHDOG_MAX_STALLS)
+    {
+      stall = g_queue_pop_tail (&watchdog_stalls);
+      g_free (stall->operation);
+      g_free (stall->backtrace);
+      g_slice_free (ThunarWatchdogStall, stall);
+    }
+  stall = g_queue_peek_head (&watchdog_stalls);
+  g_mutex_unlock (&watchdog_mutex);
+
+  return stall;
+}
+
+
+
+static gpointer
+thunar_watchdog_thread (gpointer data)
+{
+  ThunarWatchdogStall *stall = NULL;
+  gint64               busy_since = 0;
+  gint64               now;
+  guint                last_iteration = 0;
+  guint                iteration;
+  gulong               interval;
+
+  /* sample often enough to notice a stall soon after the threshold */
+  interval = MAX (watchdog_threshold / 4, 10) * 1000;
+
+  for (;;)
+    {
+      g_usleep (interval);
+
+      iteration = thunar_counters_get_main_loop_iteration ();
+      now = g_get_monotonic_time ();
+
+      if (iteration != last_iteration)
+        {
+          /* the main loop moved on, the reported stall ended */
+          if (stall != NULL)
+            {
+              g_mutex_lock (&watchdog_mutex);
+              stall->duration_ms = (now - busy_since) / 1000;
+              g_mutex_unlock (&watchdog_mutex);
+              stall = NULL;
+            }
+
+          last_iteration = iteration;
+          busy_since = now;
+          continue;
+        }
+
+      /* report every stall once, while the main loop dispatches */
+      if ((iteration & 1) != 0 && stall == NULL
+          && now - busy_since >= (gint64) watchdog_threshold * 1000)
+        stall = thunar_watchdog_report (now - busy_since);
+    }
+
+  return NULL;
+}
+
+
+
+/**
+ * thunar_watchdog_init:
+ *
+ * Starts the watchdog thread if the THUNAR_WATCHDOG environment
+ * variable is set. Must be called from the main thread, after
+ * thunar_counters_watch_main_loop().
+ **/
+void
+thunar_watchdog_init (void)
+{
+  const gchar *value;
+  GThread     *thread;
+#ifdef THUNAR_WATCHDOG_BACKTRACES
+  struct sigaction action;
+  void            *frame;
+#endif
+
+  value = g_getenv ("THUNAR_WATCHDOG");
+  if (G_LIKELY (value == NULL))
+    return;
+
+  watchdog_threshold = strtoul (value, NULL, 10);
+  if (watchdog_threshold == 0)
+    watchdog_threshold = THUNAR_WATCHDOG_DEFAULT_THRESHOLD;
+
+  watchdog_main_thread = g_thread_self ();
+
+#ifdef THUNAR_WATCHDOG_BACKTRACES
+  watchdog_main_pthread = pthread_self ();
+  backtrace (&frame, 1);
+
+  /* restart the system calls the sample interrupts, the main thread
+   * is most likely blocked in one of them */
+  memset (&action, 0, sizeof (action));
+  action.sa_handler = thunar_watchdog_sample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset (&action.sa_mask);
+  sigaction (SIGUSR1, &action, NULL);
+#endif
+
+  thunar_watchdog_enabled = TRUE;
+
+  thread = g_thread_new ("thunar-watchdog", thunar_watchdog_thread, NULL);
+  g_thread_unref (thread);
+}
+
+
+
+/**
+ * thunar_watchdog_push_operation:
+ * @operation : a short description of what the main thread does, like "folder load".
+ * @file      : the file the operation works on or %NULL.
+ *
+ * Names the operation of the main thread until the matching
+ * thunar_watchdog_pop_operation(), so stalls in it can be attributed.
+ * Calls from other threads are ignored, as are all calls if the
+ * watchdog is disabled.
+ **/
+void
+thunar_watchdog_push_operation (const gchar *operation,
+                                GFile       *file)
+{
+  gchar *name = NULL;
+  gchar *uri;
+
+  _thunar_return_if_fail (operation != NULL);
+  _thunar_return_if_fail (file == NULL || G_IS_FILE (file));
+
+  if (G_LIKELY (!thunar_watchdog_enabled) || g_thread_self () != watchdog_main_thread)
+    return;
+
+  if (G_LIKELY (watchdog_depth < THUNAR_WATCHDOG_MAX_DEPTH))
+    {
+      if (file != NULL)
+        {
+          uri = g_file_get_uri (file);
+          name = g_strdup_printf ("%s of %s", operation, uri);
+          g_free (uri);
+        }
+      else
+        {
+          name = g_strdup (operation);
+        }
+    }
+
+  g_mutex_lock (&watchdog_mutex);
+  if (G_LIKELY (watchdog_depth < THUNAR_WATCHDOG_MAX_DEPTH))
+    watchdog_operations[watchdog_depth] = name;
+  watchdog_depth++;
+  g_mutex_unlock (&watchdog_mutex);
+}
+
+
+
+/**
+ * thunar_watchdog_pop_operation:
+ *
+ * Ends the operation of the last thunar_watchdog_push_operation().
+ **/
+void
+thunar_watchdog_pop_operation (void)
+{
+  gchar *name = NULL;
+
+  if (G_LIKELY (!thunar_watchdog_enabled) || g_thread_self () != watchdog_main_thread)
+    return;
+
+  _thunar_return_if_fail (watchdog_depth > 0);
+
+  g_mutex_lock (&watchdog_mutex);
+  watchdog_depth--;
+  if (G_LIKELY (watchdog_depth < THUNAR_WATCHDOG_MAX_DEPTH))
+    {
+      name = watchdog_operations[watchdog_depth];
+      watchdog_operations[watchdog_depth] = NULL;
+    }
+  g_mutex_unlock (&watchdog_mutex);
+
+  g_free (name);
+}
+
+
+
+/**
+ * thunar_watchdog_get_stalls:
+ *
+ * Returns the recent stalls of the main loop, newest first, as an
+ * array of the duration in milliseconds, the operation ("" if unknown)
+ * and the backtrace ("" if none was taken).
+ *
+ * Return value: a floating #GVariant of the type a(tss).
+ **/
+GVariant *
+thunar_watchdog_get_stalls (void)
+{
+  ThunarWatchdogStall *stall;
+  GVariantBuilder      builder;
+  GList               *lp;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(tss)"));
+
+  g_mutex_lock (&watchdog_mutex);
+  for (lp = watchdog_stalls.head; lp != NULL; lp = lp->next)
+    {
+      stall = lp->data;
+      g_variant_builder_add (&builder, "(tss)", stall->duration_ms,
+                             stall->operation != NULL ? stall->operation : "",
+                             stall->backtrace != NULL ? stall->backtrace : "");
+    }
+  g_mutex_unlock (&watchdog_mutex);
+
+  return g_variant_builder_end (&builder);
+}
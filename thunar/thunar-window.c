@@ -49,6 +49,7 @@
 #include <thunar/thunar-location-entry.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-menu.h>
+#include <thunar/thunar-mount-health.h>
 #include <thunar/thunar-pango-extensions.h>
 #include <thunar/thunar-preferences-dialog.h>
 #include <thunar/thunar-preferences.h>
@@ -156,7 +157,8 @@ static GtkWidget*thunar_window_notebook_insert_page       (ThunarWindow
                                                            ThunarFile             *directory,
                                                            GType                   view_type,
                                                            gint                    position,
-                                                           ThunarHistory          *history);
+                                                           ThunarHistory          *history,
+                                                           gboolean                load_deferred);
 static void      thunar_window_notebook_select_current_page(ThunarWindow           *window);
 
 static GtkWidget*thunar_window_paned_notebooks_add        (ThunarWindow           *window);
@@ -189,6 +191,8 @@ static void      thunar_window_action_preferences         (ThunarWindow
                                                            GtkWidget              *menu_item);
 static void      thunar_window_action_reload              (ThunarWindow           *window,
                                                            GtkWidget              *menu_item);
+static void      thunar_window_action_reload_hard         (ThunarWindow           *window,
+                                                           GtkWidget              *menu_item);
 static void      thunar_window_action_toggle_split_view   (ThunarWindow           *window);
 static void      thunar_window_action_switch_next_tab     (ThunarWindow           *window);
 static void      thunar_window_action_switch_previous_tab (ThunarWindow           *window);
@@ -219,6 +223,11 @@ static void      thunar_window_action_open_trash          (ThunarWindow
 static void      thunar_window_action_open_network        (ThunarWindow           *window);
 static void      thunar_window_action_open_bookmark       (GFile                  *g_file);
 static void      thunar_window_action_open_location       (ThunarWindow           *window);
+static void      thunar_window_action_search              (ThunarWindow           *window);
+static void      thunar_window_search_changed             (ThunarWindow           *window);
+static void      thunar_window_search_mode_changed        (ThunarWindow           *window);
+static void      thunar_window_search_close               (ThunarWindow           *window,
+                                                           gboolean                show_directory);
 static void      thunar_window_action_contents            (ThunarWindow           *window);
 static void      thunar_window_action_about               (ThunarWindow           *window);
 static void      thunar_window_action_show_hidden         (ThunarWindow           *window);
@@ -242,13 +251,18 @@ static void      thunar_window_device_pre_unmount         (ThunarDeviceMonitor
 static void      thunar_window_device_changed             (ThunarDeviceMonitor    *device_monitor,
                                                            ThunarDevice           *device,
                                                            ThunarWindow           *window);
+static void      thunar_window_notify_tab_availability    (ThunarView             *view,
+                                                           GParamSpec             *pspec,
+                                                           ThunarWindow           *window);
+static void      thunar_window_mount_health_changed       (ThunarWindow           *window);
 static gboolean  thunar_window_save_paned                 (ThunarWindow           *window);
 static gboolean  thunar_window_save_geometry_timer        (gpointer                user_data);
 static void      thunar_window_save_geometry_timer_destroy(gpointer                user_data);
+static gboolean  thunar_window_restore_tabs_timer         (gpointer                user_data);
 static void      thunar_window_set_zoom_level             (ThunarWindow           *window,
                                                            ThunarZoomLevel         zoom_level);
 static void      thunar_window_update_window_icon         (ThunarWindow           *window);
-static void      thunar_window_create_menu                (ThunarWindow           *window,
+static GtkWidget*thunar_window_create_menu                (ThunarWindow           *window,
                                                            ThunarWindowAction      action,
                                                            GCallback               cb_update_menu);
 static void      thunar_window_update_file_menu           (ThunarWindow           *window,
@@ -257,6 +271,9 @@ static void      thunar_window_update_edit_menu           (ThunarWindow
                                                            GtkWidget              *menu);
 static void      thunar_window_update_view_menu           (ThunarWindow           *window,
                                                            GtkWidget              *menu);
+static gboolean  thunar_window_trash_is_full              (void);
+static void      thunar_window_build_go_menu              (ThunarWindow           *window,
+                                                           GtkWidget              *menu);
 static void      thunar_window_update_go_menu             (ThunarWindow           *window,
                                                            GtkWidget              *menu);
 static void      thunar_window_update_bookmarks_menu      (ThunarWindow           *window,
@@ -286,6 +303,8 @@ static void      thunar_window_update_bookmarks           (ThunarWindow
 static void      thunar_window_free_bookmarks             (ThunarWindow           *window);
 static void      thunar_window_menu_add_bookmarks         (ThunarWindow           *window,
                                                            GtkMenuShell           *view_menu);
+static void      thunar_window_redirect_menu_tooltips_to_statusbar_recursive (GtkWidget    *menu_item,
+                                                                              ThunarWindow *window);
 static gboolean  thunar_window_check_uca_key_activation   (ThunarWindow           *window,
                                                            GdkEventKey            *key_event,
                                                            gpointer                user_data);
@@ -321,7 +340,6 @@ struct _ThunarWindow
 
   /* support for custom preferences actions */
   ThunarxProviderFactory *provider_factory;
-  GList                  *thunarx_preferences_providers;
 
   GFile                  *bookmark_file;
   GList                  *bookmarks;
@@ -336,6 +354,9 @@ struct _ThunarWindow
   /* to be able to change folder on "device-pre-unmount" if required */
   ThunarDeviceMonitor    *device_monitor;
 
+  /* to show the tabs on stalled mounts as unavailable */
+  ThunarMountHealth      *mount_health;
+
   GtkWidget              *grid;
   GtkWidget              *menubar;
   GtkWidget              *spinner;
@@ -343,6 +364,8 @@ struct _ThunarWindow
   GtkWidget              *sidepane;
   GtkWidget              *view_box;
   GtkWidget              *trash_infobar;
+  GtkWidget              *search_bar;
+  GtkWidget              *search_entry;
   GtkWidget              *trash_infobar_restore_button;
   GtkWidget              *trash_infobar_empty_button;
 
@@ -362,6 +385,17 @@ struct _ThunarWindow
   GtkWidget              *location_bar;
   GtkWidget              *location_toolbar;
 
+  /* the menus which are built once, with the items whose
+   * sensitivity is updated when they are shown */
+  GtkWidget              *go_menu_item_parent;
+  GtkWidget              *go_menu_item_back;
+  GtkWidget              *go_menu_item_forward;
+  gboolean                go_menu_trash_full;
+  GtkWidget              *bookmarks_menu;
+  GtkWidget              *bookmarks_menu_item_sendto;
+  gboolean                bookmarks_menu_built;
+  gboolean                help_menu_built;
+
   /* we need to maintain pointers to be able to toggle sensitivity */
   GtkWidget              *location_toolbar_item_back;
   GtkWidget              *location_toolbar_item_forward;
@@ -385,6 +419,10 @@ struct _ThunarWindow
   /* support to remember window geometry */
   guint                   save_geometry_timer_id;
 
+  /* background tabs of a restored window, see thunar_window_set_directories() */
+  guint                   restore_tabs_timer_id;
+  gint64                  restore_start_time;
+
   /* support to toggle side pane using F9,
    * see the toggle_sidepane() function.
    */
@@ -409,6 +447,7 @@ static XfceGtkActionEntry thunar_window_action_entries[] =
     { THUNAR_WINDOW_ACTION_VIEW_MENU,                      "<Actions>/ThunarWindow/view-menu",                       "",                     XFCE_GTK_MENU_ITEM,       N_ ("_View"),                  NULL,                                                                                NULL,                      NULL,                                                 },
     { THUNAR_WINDOW_ACTION_RELOAD,                         "<Actions>/ThunarWindow/reload",                          "<Primary>r",           XFCE_GTK_IMAGE_MENU_ITEM, N_ ("_Reload"),                N_ ("Reload the current folder"),                                                    "view-refresh-symbolic",   G_CALLBACK (thunar_window_action_reload),             },
     { THUNAR_WINDOW_ACTION_RELOAD_ALT,                     "<Actions>/ThunarWindow/reload-alt",                      "F5",                   XFCE_GTK_IMAGE_MENU_ITEM, NULL,                          NULL,                                                                                NULL,                      G_CALLBACK (thunar_window_action_reload),             },
+    { THUNAR_WINDOW_ACTION_RELOAD_HARD,                    "<Actions>/ThunarWindow/reload-hard",                     "<Primary><Shift>r",    XFCE_GTK_IMAGE_MENU_ITEM, N_ ("Reload _Completely"),     N_ ("Read the current folder and all file information again"),                        NULL,                      G_CALLBACK (thunar_window_action_reload_hard),        },
     { THUNAR_WINDOW_ACTION_VIEW_SPLIT,                     "<Actions>/ThunarWindow/toggle-split-view",               "F3",                   XFCE_GTK_CHECK_MENU_ITEM, N_ ("Spl_it View"),            N_ ("Open/Close Split View"),                                                        NULL,                      G_CALLBACK (thunar_window_action_toggle_split_view),  },
     { THUNAR_WINDOW_ACTION_VIEW_LOCATION_SELECTOR_MENU,    "<Actions>/ThunarWindow/view-location-selector-menu",     "",                     XFCE_GTK_MENU_ITEM,       N_ ("_Location Selector"),     NULL,                                                                                NULL,                      NULL,                                                 },
     { THUNAR_WINDOW_ACTION_VIEW_LOCATION_SELECTOR_PATHBAR, "<Actions>/ThunarWindow/view-location-selector-pathbar",  "",                     XFCE_GTK_CHECK_MENU_ITEM, N_ ("_Pathbar Style"),         N_ ("Modern approach with buttons that correspond to folders"),                      NULL,                      G_CALLBACK (thunar_window_action_pathbar_changed),    },
@@ -442,6 +481,7 @@ static XfceGtkActionEntry thunar_window_action_entries[] =
     { THUNAR_WINDOW_ACTION_OPEN_PARENT,                    "<Actions>/ThunarWindow/open-parent",                     "<Alt>Up",              XFCE_GTK_IMAGE_MENU_ITEM, N_ ("Open _Parent"),           N_ ("Open the parent folder"),                                                       "go-up-symbolic",          G_CALLBACK (thunar_window_action_go_up),              },
     { THUNAR_WINDOW_ACTION_OPEN_LOCATION,                  "<Actions>/ThunarWindow/open-location",                   "<Primary>l",           XFCE_GTK_IMAGE_MENU_ITEM, N_ ("_Open Location..."),      N_ ("Specify a location to open"),                                                   NULL,                      G_CALLBACK (thunar_window_action_open_location),      },
     { THUNAR_WINDOW_ACTION_OPEN_LOCATION_ALT,              "<Actions>/ThunarWindow/open-location-alt",               "<Alt>d",               XFCE_GTK_MENU_ITEM,       "open-location-alt",           NULL,                                                                                NULL,                      G_CALLBACK (thunar_window_action_open_location),      },
+    { THUNAR_WINDOW_ACTION_SEARCH,                         "<Actions>/ThunarWindow/search",                          "<Primary>f",           XFCE_GTK_IMAGE_MENU_ITEM, N_ ("_Search for Files..."),   N_ ("Search for files in the current folder and its subfolders"),                    "system-search",           G_CALLBACK (thunar_window_action_search),             },
     { THUNAR_WINDOW_ACTION_OPEN_TEMPLATES,                 "<Actions>/ThunarWindow/open-templates",                  "",                     XFCE_GTK_IMAGE_MENU_ITEM, N_("T_emplates"),              N_ ("Go to the templates folder"),                                                   "text-x-generic-template", G_CALLBACK (thunar_window_action_open_templates),     },
     { THUNAR_WINDOW_ACTION_OPEN_NETWORK,                   "<Actions>/ThunarWindow/open-network",                    "",                     XFCE_GTK_IMAGE_MENU_ITEM, N_("B_rowse Network"),         N_ ("Browse local network connections"),                                             "network-workgroup",       G_CALLBACK (thunar_window_action_open_network),       },
 
@@ -456,6 +496,10 @@ static XfceGtkActionEntry thunar_window_action_entries[] =
     { 0,                                                   "<Actions>/ThunarWindow/open-file-menu",                  "F10",                  0,                        NULL,                          NULL,                                                                                NULL,                      G_CALLBACK (thunar_window_action_open_file_menu),      },
 };
 
+/* the interval in ms to check whether the next background tab of a
+ * restored window can be loaded, see thunar_window_restore_tabs_timer() */
+#define RESTORE_TABS_INTERVAL (100)
+
 #define get_action_entry(id) xfce_gtk_get_action_entry_by_id(thunar_window_action_entries,G_N_ELEMENTS(thunar_window_action_entries),id)
 
 
@@ -676,9 +720,8 @@ thunar_window_init (ThunarWindow *window)
   /* unset the view type */
   window->view_type = G_TYPE_NONE;
 
-  /* grab a reference on the provider factory and load the providers*/
+  /* grab a reference on the provider factory, the providers are loaded when the menus are built */
   window->provider_factory = thunarx_provider_factory_get_default ();
-  window->thunarx_preferences_providers = thunarx_provider_factory_list_providers (window->provider_factory, THUNARX_TYPE_PREFERENCES_PROVIDER);
 
   /* grab a reference on the preferences */
   window->preferences = thunar_preferences_get ();
@@ -721,6 +764,9 @@ thunar_window_init (ThunarWindow *window)
   g_signal_connect (window->device_monitor, "device-removed", G_CALLBACK (thunar_window_device_changed), window);
   g_signal_connect (window->device_monitor, "device-changed", G_CALLBACK (thunar_window_device_changed), window);
 
+  window->mount_health = thunar_mount_health_get ();
+  g_signal_connect_swapped (window->mount_health, "changed", G_CALLBACK (thunar_window_mount_health_changed), window);
+
   window->icon_factory = thunar_icon_factory_get_default ();
 
   /* Catch key events before accelerators get processed */
@@ -756,7 +802,7 @@ thunar_window_init (ThunarWindow *window)
   thunar_window_create_menu (window, THUNAR_WINDOW_ACTION_EDIT_MENU, G_CALLBACK (thunar_window_update_edit_menu));
   thunar_window_create_menu (window, THUNAR_WINDOW_ACTION_VIEW_MENU, G_CALLBACK (thunar_window_update_view_menu));
   thunar_window_create_menu (window, THUNAR_WINDOW_ACTION_GO_MENU, G_CALLBACK (thunar_window_update_go_menu));
-  thunar_window_create_menu (window, THUNAR_WINDOW_ACTION_BOOKMARKS_MENU, G_CALLBACK (thunar_window_update_bookmarks_menu));
+  window->bookmarks_menu = thunar_window_create_menu (window, THUNAR_WINDOW_ACTION_BOOKMARKS_MENU, G_CALLBACK (thunar_window_update_bookmarks_menu));
   thunar_window_create_menu (window, THUNAR_WINDOW_ACTION_HELP_MENU, G_CALLBACK (thunar_window_update_help_menu));
   gtk_widget_show_all (window->menubar);
 
@@ -830,9 +876,23 @@ thunar_window_init (ThunarWindow *window)
   window->paned_notebooks = gtk_paned_new (GTK_ORIENTATION_HORIZONTAL);
   gtk_paned_add2 (GTK_PANED (window->paned), window->view_box);
   gtk_widget_add_events (window->paned_notebooks, GDK_ENTER_NOTIFY_MASK | GDK_LEAVE_NOTIFY_MASK | GDK_BUTTON_PRESS_MASK);
-  gtk_grid_attach (GTK_GRID (window->view_box), window->paned_notebooks, 0, 1, 1, 2);
+  gtk_grid_attach (GTK_GRID (window->view_box), window->paned_notebooks, 0, 2, 1, 1);
   gtk_widget_show (window->paned_notebooks);
 
+  /* recursive search in the current directory, hidden until it is started */
+  window->search_bar = gtk_search_bar_new ();
+  gtk_search_bar_set_show_close_button (GTK_SEARCH_BAR (window->search_bar), TRUE);
+  gtk_grid_attach (GTK_GRID (window->view_box), window->search_bar, 0, 1, 1, 1);
+  gtk_widget_show (window->search_bar);
+  g_signal_connect_swapped (window->search_bar, "notify::search-mode-enabled", G_CALLBACK (thunar_window_search_mode_changed), window);
+
+  window->search_entry = gtk_search_entry_new ();
+  gtk_entry_set_width_chars (GTK_ENTRY (window->search_entry), 40);
+  gtk_container_add (GTK_CONTAINER (window->search_bar), window->search_entry);
+  gtk_search_bar_connect_entry (GTK_SEARCH_BAR (window->search_bar), GTK_ENTRY (window->search_entry));
+  gtk_widget_show (window->search_entry);
+  g_signal_connect_swapped (window->search_entry, "search-changed", G_CALLBACK (thunar_window_search_changed), window);
+
   /** close notebooks on window-remove signal because later on window property
    *  pointers are broken.
    **/
@@ -969,7 +1029,7 @@ thunar_window_select_files (ThunarWindow *window,
   thunar_folder = thunar_folder_get_for_file (window->current_directory);
   if (thunar_folder != NULL)
     {
-      thunar_folder_reload (thunar_folder, FALSE);
+      thunar_folder_refresh (thunar_folder);
       g_object_unref (thunar_folder);
     }
 
@@ -981,7 +1041,7 @@ thunar_window_select_files (ThunarWindow *window,
 
 
 
-static void
+static GtkWidget*
 thunar_window_create_menu (ThunarWindow       *window,
                            ThunarWindowAction  action,
                            GCallback           cb_update_menu)
@@ -989,7 +1049,7 @@ thunar_window_create_menu (ThunarWindow       *window,
   GtkWidget *item;
   GtkWidget *submenu;
 
-  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+  _thunar_return_val_if_fail (THUNAR_IS_WINDOW (window), NULL);
 
   item = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (action), G_OBJECT (window), GTK_MENU_SHELL (window->menubar));
 
@@ -997,6 +1057,8 @@ thunar_window_create_menu (ThunarWindow       *window,
   gtk_menu_set_accel_group (GTK_MENU (submenu), window->accel_group);
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (item), GTK_WIDGET (submenu));
   g_signal_connect_swapped (G_OBJECT (submenu), "show", G_CALLBACK (cb_update_menu), window);
+
+  return submenu;
 }
 
 
@@ -1038,6 +1100,7 @@ thunar_window_update_edit_menu (ThunarWindow *window,
 {
   GtkWidget       *gtk_menu_item;
   GList           *thunarx_menu_items;
+  GList           *providers;
   GList           *pp, *lp;
 
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
@@ -1064,10 +1127,11 @@ thunar_window_update_edit_menu (ThunarWindow *window,
                                               | THUNAR_MENU_SECTION_RESTORE);
 
   /* determine the available preferences providers */
-  if (G_LIKELY (window->thunarx_preferences_providers != NULL))
+  providers = thunarx_provider_factory_list_providers (window->provider_factory, THUNARX_TYPE_PREFERENCES_PROVIDER);
+  if (G_LIKELY (providers != NULL))
     {
       /* add menu items from all providers */
-      for (pp = window->thunarx_preferences_providers; pp != NULL; pp = pp->next)
+      for (pp = providers; pp != NULL; pp = pp->next)
         {
           /* determine the available menu items for the provider */
           thunarx_menu_items = thunarx_preferences_provider_get_menu_items (THUNARX_PREFERENCES_PROVIDER (pp->data), GTK_WIDGET (window));
@@ -1082,6 +1146,9 @@ thunar_window_update_edit_menu (ThunarWindow *window,
           /* release the list */
           g_list_free (thunarx_menu_items);
         }
+
+      /* release the providers */
+      g_list_free_full (providers, g_object_unref);
     }
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_PREFERENCES), G_OBJECT (window), GTK_MENU_SHELL (menu));
   gtk_widget_show_all (GTK_WIDGET (menu));
@@ -1165,58 +1232,59 @@ thunar_window_update_view_menu (ThunarWindow *window,
 
 
 
+static gboolean
+thunar_window_trash_is_full (void)
+{
+  ThunarFile *trash_folder;
+  GFile      *gfile;
+  gboolean    is_full = FALSE;
+
+  /* try to connect to the trash bin */
+  gfile = thunar_g_file_new_for_trash ();
+  if (gfile != NULL)
+    {
+      trash_folder = thunar_file_get (gfile, NULL);
+      if (trash_folder != NULL)
+        {
+          is_full = thunar_file_get_item_count (trash_folder) > 0;
+          g_object_unref (trash_folder);
+        }
+      g_object_unref (gfile);
+    }
+
+  return is_full;
+}
+
+
+
 static void
-thunar_window_update_go_menu (ThunarWindow *window,
-                              GtkWidget    *menu)
+thunar_window_build_go_menu (ThunarWindow *window,
+                             GtkWidget    *menu)
 {
-  gchar                    *icon_name;
+  const gchar              *icon_name;
   const XfceGtkActionEntry *action_entry;
-  ThunarHistory            *history = NULL;
-  GtkWidget                *item;
 
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
 
-  if (window->view != NULL)
-    history = thunar_standard_view_get_history (THUNAR_STANDARD_VIEW (window->view));
-
   thunar_gtk_menu_clean (GTK_MENU (menu));
-  item = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_PARENT), G_OBJECT (window), GTK_MENU_SHELL (menu));
-  gtk_widget_set_sensitive (item, !thunar_g_file_is_root (thunar_file_get_file (window->current_directory)));
-  item = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_BACK), G_OBJECT (window), GTK_MENU_SHELL (menu));
-  if (history != NULL)
-    gtk_widget_set_sensitive (item, thunar_history_has_back (history));
-  item = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_FORWARD), G_OBJECT (window), GTK_MENU_SHELL (menu));
-  if (history != NULL)
-    gtk_widget_set_sensitive (item, thunar_history_has_forward (history));
+  window->go_menu_item_parent = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_PARENT), G_OBJECT (window), GTK_MENU_SHELL (menu));
+  window->go_menu_item_back = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_BACK), G_OBJECT (window), GTK_MENU_SHELL (menu));
+  window->go_menu_item_forward = xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_FORWARD), G_OBJECT (window), GTK_MENU_SHELL (menu));
   xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (menu));
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_COMPUTER), G_OBJECT (window), GTK_MENU_SHELL (menu));
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_HOME), G_OBJECT (window), GTK_MENU_SHELL (menu));
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_DESKTOP), G_OBJECT (window), GTK_MENU_SHELL (menu));
   if (thunar_g_vfs_is_uri_scheme_supported ("trash"))
     {
-      GFile      *gfile;
-      ThunarFile *trash_folder;
-
-      /* try to connect to the trash bin */
-      gfile = thunar_g_file_new_for_trash ();
-      if (gfile != NULL)
+      action_entry = get_action_entry (THUNAR_WINDOW_ACTION_OPEN_TRASH);
+      if (action_entry != NULL)
         {
-          trash_folder = thunar_file_get (gfile, NULL);
-          if (trash_folder != NULL)
-            {
-              action_entry = get_action_entry (THUNAR_WINDOW_ACTION_OPEN_TRASH);
-              if (action_entry != NULL)
-                {
-                  if (thunar_file_get_item_count (trash_folder) > 0)
-                    icon_name = "user-trash-full";
-                  else
-                    icon_name = "user-trash";
-                  xfce_gtk_image_menu_item_new_from_icon_name (action_entry->menu_item_label_text, action_entry->menu_item_tooltip_text,
-                                                               action_entry->accel_path, action_entry->callback, G_OBJECT (window), icon_name, GTK_MENU_SHELL (menu));
-                }
-              g_object_unref (trash_folder);
-            }
-          g_object_unref (gfile);
+          if (window->go_menu_trash_full)
+            icon_name = "user-trash-full";
+          else
+            icon_name = "user-trash";
+          xfce_gtk_image_menu_item_new_from_icon_name (action_entry->menu_item_label_text, action_entry->menu_item_tooltip_text,
+                                                       action_entry->accel_path, action_entry->callback, G_OBJECT (window), icon_name, GTK_MENU_SHELL (menu));
         }
     }
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_TEMPLATES), G_OBJECT (window), GTK_MENU_SHELL (menu));
@@ -1226,6 +1294,7 @@ thunar_window_update_go_menu (ThunarWindow *window,
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_NETWORK), G_OBJECT (window), GTK_MENU_SHELL (menu));
   xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (menu));
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_OPEN_LOCATION), G_OBJECT (window), GTK_MENU_SHELL (menu));
+  xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_SEARCH), G_OBJECT (window), GTK_MENU_SHELL (menu));
   gtk_widget_show_all (GTK_WIDGET (menu));
 
   thunar_window_redirect_menu_tooltips_to_statusbar (window, GTK_MENU (menu));
@@ -1233,21 +1302,64 @@ thunar_window_update_go_menu (ThunarWindow *window,
 
 
 
+static void
+thunar_window_update_go_menu (ThunarWindow *window,
+                              GtkWidget    *menu)
+{
+  ThunarHistory *history = NULL;
+  gboolean       trash_full;
+
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  /* the items only change with the icon of the trash */
+  trash_full = thunar_g_vfs_is_uri_scheme_supported ("trash") && thunar_window_trash_is_full ();
+  if (window->go_menu_item_parent == NULL || window->go_menu_trash_full != trash_full)
+    {
+      window->go_menu_trash_full = trash_full;
+      thunar_window_build_go_menu (window, menu);
+    }
+
+  if (window->view != NULL)
+    history = thunar_standard_view_get_history (THUNAR_STANDARD_VIEW (window->view));
+
+  gtk_widget_set_sensitive (window->go_menu_item_parent, !thunar_g_file_is_root (thunar_file_get_file (window->current_directory)));
+  gtk_widget_set_sensitive (window->go_menu_item_back, history == NULL || thunar_history_has_back (history));
+  gtk_widget_set_sensitive (window->go_menu_item_forward, history == NULL || thunar_history_has_forward (history));
+}
+
+
+
 static void
 thunar_window_update_bookmarks_menu (ThunarWindow *window,
                                      GtkWidget    *menu)
 {
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
 
-  thunar_gtk_menu_clean (GTK_MENU (menu));
+  /* the bookmarks are only added again after the bookmarks file changed */
+  if (!window->bookmarks_menu_built)
+    {
+      thunar_gtk_menu_clean (GTK_MENU (menu));
+      window->bookmarks_menu_item_sendto = NULL;
 
-  thunar_launcher_append_menu_item (window->launcher, GTK_MENU_SHELL (menu),THUNAR_LAUNCHER_ACTION_SENDTO_SHORTCUTS, FALSE);
-  xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (menu));
-  thunar_window_menu_add_bookmarks (window, GTK_MENU_SHELL (menu));
+      xfce_gtk_menu_append_seperator (GTK_MENU_SHELL (menu));
+      thunar_window_menu_add_bookmarks (window, GTK_MENU_SHELL (menu));
+      gtk_widget_show_all (GTK_WIDGET (menu));
 
-  gtk_widget_show_all (GTK_WIDGET (menu));
+      thunar_window_redirect_menu_tooltips_to_statusbar (window, GTK_MENU (menu));
+      window->bookmarks_menu_built = TRUE;
+    }
 
-  thunar_window_redirect_menu_tooltips_to_statusbar (window, GTK_MENU (menu));
+  /* the first item depends on the selection */
+  if (window->bookmarks_menu_item_sendto != NULL)
+    gtk_widget_destroy (window->bookmarks_menu_item_sendto);
+  window->bookmarks_menu_item_sendto = thunar_launcher_append_menu_item (window->launcher, GTK_MENU_SHELL (menu),
+                                                                         THUNAR_LAUNCHER_ACTION_SENDTO_SHORTCUTS, FALSE);
+  if (window->bookmarks_menu_item_sendto != NULL)
+    {
+      gtk_menu_reorder_child (GTK_MENU (menu), window->bookmarks_menu_item_sendto, 0);
+      gtk_widget_show (window->bookmarks_menu_item_sendto);
+      thunar_window_redirect_menu_tooltips_to_statusbar_recursive (window->bookmarks_menu_item_sendto, window);
+    }
 }
 
 
@@ -1258,7 +1370,11 @@ thunar_window_update_help_menu (ThunarWindow *window,
 {
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
 
-  thunar_gtk_menu_clean (GTK_MENU (menu));
+  /* the help menu never changes */
+  if (window->help_menu_built)
+    return;
+  window->help_menu_built = TRUE;
+
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_CONTENTS), G_OBJECT (window), GTK_MENU_SHELL (menu));
   xfce_gtk_menu_item_new_from_action_entry (get_action_entry (THUNAR_WINDOW_ACTION_ABOUT), G_OBJECT (window), GTK_MENU_SHELL (menu));
   gtk_widget_show_all (GTK_WIDGET (menu));
@@ -1289,6 +1405,13 @@ thunar_window_dispose (GObject *object)
   if (G_UNLIKELY (window->save_geometry_timer_id != 0))
     g_source_remove (window->save_geometry_timer_id);
 
+  /* stop loading the background tabs of a restored window */
+  if (G_UNLIKELY (window->restore_tabs_timer_id != 0))
+    {
+      g_source_remove (window->restore_tabs_timer_id);
+      window->restore_tabs_timer_id = 0;
+    }
+
   /* disconnect from the current-directory */
   thunar_window_set_current_directory (window, NULL);
 
@@ -1306,6 +1429,9 @@ thunar_window_finalize (GObject *object)
   g_signal_handlers_disconnect_matched (window->device_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, window);
   g_object_unref (window->device_monitor);
 
+  g_signal_handlers_disconnect_by_func (window->mount_health, thunar_window_mount_health_changed, window);
+  g_object_unref (window->mount_health);
+
   g_object_unref (window->icon_factory);
   g_object_unref (window->launcher);
 
@@ -1729,15 +1855,28 @@ thunar_window_notebook_switch_page (GtkWidget    *notebook,
   GSList        *view_bindings;
   ThunarFile    *current_directory;
   ThunarHistory *history;
+  GtkWidget     *previous_page;
 
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
   _thunar_return_if_fail (GTK_IS_NOTEBOOK (notebook));
   _thunar_return_if_fail (THUNAR_IS_VIEW (page));
 
+  /* the previous tab of the notebook is still shown, so it can remember
+   * its scroll position before it is suspended in the background */
+  previous_page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebook),
+                                             gtk_notebook_get_current_page (GTK_NOTEBOOK (notebook)));
+  if (previous_page != NULL && previous_page != page && THUNAR_IS_STANDARD_VIEW (previous_page))
+    thunar_standard_view_schedule_suspend (THUNAR_STANDARD_VIEW (previous_page));
+  if (THUNAR_IS_STANDARD_VIEW (page))
+    thunar_standard_view_resume (THUNAR_STANDARD_VIEW (page));
+
   /* leave if nothing changed */
   if (window->view == page)
     return;
 
+  /* the search belongs to the previous tab */
+  thunar_window_search_close (window, TRUE);
+
   /* Use accelerators only on the current active tab */
   if (window->view != NULL)
     g_object_set (G_OBJECT (window->view), "accel-group", NULL, NULL);
@@ -1885,6 +2024,8 @@ thunar_window_notebook_page_added (GtkWidget    *notebook,
   g_signal_connect_swapped (G_OBJECT (page), "start-open-location", G_CALLBACK (thunar_window_start_open_location), window);
   g_signal_connect_swapped (G_OBJECT (page), "change-directory", G_CALLBACK (thunar_window_set_current_directory), window);
   g_signal_connect_swapped (G_OBJECT (page), "open-new-tab", G_CALLBACK (thunar_window_notebook_open_new_tab), window);
+  g_signal_connect (G_OBJECT (page), "notify::current-directory", G_CALLBACK (thunar_window_notify_tab_availability), window);
+  thunar_window_notify_tab_availability (THUNAR_VIEW (page), NULL, window);
 
   /* update tab visibility */
   thunar_window_notebook_show_tabs (window);
@@ -2086,7 +2227,8 @@ thunar_window_notebook_insert_page (ThunarWindow  *window,
                                     ThunarFile    *directory,
                                     GType          view_type,
                                     gint           position,
-                                    ThunarHistory *history)
+                                    ThunarHistory *history,
+                                    gboolean       load_deferred)
 {
   GtkWidget      *view;
   GtkWidget      *label;
@@ -2099,8 +2241,12 @@ thunar_window_notebook_insert_page (ThunarWindow  *window,
   _thunar_return_val_if_fail (view_type != G_TYPE_NONE, NULL);
   _thunar_return_val_if_fail (history == NULL || THUNAR_IS_HISTORY (history), NULL);
 
-  /* allocate and setup a new view */
-  view = g_object_new (view_type, "current-directory", directory, NULL);
+  /* allocate and setup a new view, a deferred view only loads its
+   * directory once it is resumed */
+  view = g_object_new (view_type, NULL);
+  if (load_deferred)
+    thunar_standard_view_defer_load (THUNAR_STANDARD_VIEW (view));
+  thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (view), directory);
   thunar_view_set_show_hidden (THUNAR_VIEW (view), window->show_hidden);
   gtk_widget_show (view);
 
@@ -2311,7 +2457,7 @@ thunar_window_notebook_add_new_tab (ThunarWindow *window,
 
   /* insert the new view */
   page_num = gtk_notebook_get_current_page (GTK_NOTEBOOK (window->notebook_selected));
-  view = thunar_window_notebook_insert_page (window, directory, view_type, page_num + 1, history);
+  view = thunar_window_notebook_insert_page (window, directory, view_type, page_num + 1, history, FALSE);
 
   /* switch to the new view */
   g_object_get (G_OBJECT (window->preferences), "misc-switch-to-new-tab", &switch_to_new_tab, NULL);
@@ -2634,6 +2780,14 @@ thunar_window_update_bookmarks (ThunarWindow *window)
 
   thunar_window_free_bookmarks (window);
 
+  /* the menu items refer to the old bookmarks */
+  if (window->bookmarks_menu_built)
+    {
+      thunar_gtk_menu_clean (GTK_MENU (window->bookmarks_menu));
+      window->bookmarks_menu_item_sendto = NULL;
+      window->bookmarks_menu_built = FALSE;
+    }
+
   /* re-create our internal bookmarks according to the bookmark file */
   thunar_util_load_bookmarks (window->bookmark_file,
                               thunar_window_update_bookmark,
@@ -2826,7 +2980,25 @@ thunar_window_action_reload (ThunarWindow *window,
 
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
 
-  /* force the view to reload */
+  /* reload the view, the folder is only read again if it changed */
+  g_signal_emit (G_OBJECT (window), window_signals[RELOAD], 0, FALSE, &result);
+
+  /* update the location bar to show the current directory */
+  if (window->location_bar != NULL)
+    g_object_notify (G_OBJECT (window->location_bar), "current-directory");
+}
+
+
+
+static void
+thunar_window_action_reload_hard (ThunarWindow *window,
+                                  GtkWidget    *menu_item)
+{
+  gboolean result;
+
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  /* force the view to read the folder and all file information again */
   g_signal_emit (G_OBJECT (window), window_signals[RELOAD], 0, TRUE, &result);
 
   /* update the location bar to show the current directory */
@@ -2883,7 +3055,7 @@ thunar_window_action_toggle_split_view (ThunarWindow *window)
 
       /* insert the new view */
       page_num = gtk_notebook_get_current_page (GTK_NOTEBOOK (window->notebook_selected));
-      thunar_window_notebook_insert_page (window, directory, view_type, page_num+1, history);
+      thunar_window_notebook_insert_page (window, directory, view_type, page_num+1, history, FALSE);
 
       /* Prevent notebook expand on tab creation */
       gtk_widget_get_allocation (GTK_WIDGET (window->paned_notebooks), &allocation);
@@ -3140,7 +3312,7 @@ thunar_window_replace_view (ThunarWindow *window,
     page_num = -1;
 
   /* insert the new view */
-  new_view = thunar_window_notebook_insert_page (window, current_directory, view_type, page_num + 1, history);
+  new_view = thunar_window_notebook_insert_page (window, current_directory, view_type, page_num + 1, history, FALSE);
 
   /* if we are replacing the active view, make the new view the active view */
   if (is_current_view)
@@ -3658,6 +3830,64 @@ thunar_window_action_open_location (ThunarWindow *window)
 
 
 
+static void
+thunar_window_action_search (ThunarWindow *window)
+{
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  gtk_search_bar_set_search_mode (GTK_SEARCH_BAR (window->search_bar), TRUE);
+  gtk_widget_grab_focus (window->search_entry);
+}
+
+
+
+static void
+thunar_window_search_changed (ThunarWindow *window)
+{
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  /* the previous search is cancelled as soon as the query changes */
+  if (THUNAR_IS_STANDARD_VIEW (window->view))
+    thunar_standard_view_set_search_query (THUNAR_STANDARD_VIEW (window->view),
+                                           gtk_entry_get_text (GTK_ENTRY (window->search_entry)));
+}
+
+
+
+static void
+thunar_window_search_mode_changed (ThunarWindow *window)
+{
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  /* closed with the button or the escape key */
+  if (!gtk_search_bar_get_search_mode (GTK_SEARCH_BAR (window->search_bar)))
+    thunar_window_search_close (window, TRUE);
+}
+
+
+
+static void
+thunar_window_search_close (ThunarWindow *window,
+                            gboolean      show_directory)
+{
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  if (G_UNLIKELY (window->search_bar == NULL))
+    return;
+
+  g_signal_handlers_block_by_func (window->search_bar, thunar_window_search_mode_changed, window);
+  g_signal_handlers_block_by_func (window->search_entry, thunar_window_search_changed, window);
+  gtk_search_bar_set_search_mode (GTK_SEARCH_BAR (window->search_bar), FALSE);
+  gtk_entry_set_text (GTK_ENTRY (window->search_entry), "");
+  g_signal_handlers_unblock_by_func (window->search_entry, thunar_window_search_changed, window);
+  g_signal_handlers_unblock_by_func (window->search_bar, thunar_window_search_mode_changed, window);
+
+  if (show_directory && THUNAR_IS_STANDARD_VIEW (window->view))
+    thunar_standard_view_set_search_query (THUNAR_STANDARD_VIEW (window->view), NULL);
+}
+
+
+
 static void
 thunar_window_action_contents (ThunarWindow *window)
 {
@@ -3873,6 +4103,65 @@ thunar_window_device_changed (ThunarDeviceMonitor *device_monitor,
 
 
 
+static void
+thunar_window_notify_tab_availability (ThunarView   *view,
+                                       GParamSpec   *pspec,
+                                       ThunarWindow *window)
+{
+  ThunarFile *directory;
+  GtkWidget  *notebook;
+  GtkWidget  *label_box;
+  GList      *children;
+  GList      *lp;
+  gboolean    available = TRUE;
+
+  _thunar_return_if_fail (THUNAR_IS_VIEW (view));
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  notebook = gtk_widget_get_parent (GTK_WIDGET (view));
+  if (G_UNLIKELY (!GTK_IS_NOTEBOOK (notebook)))
+    return;
+
+  directory = thunar_navigator_get_current_directory (THUNAR_NAVIGATOR (view));
+  if (directory != NULL)
+    available = thunar_mount_health_is_available (thunar_file_get_file (directory));
+
+  /* grey out the title, but keep the close button working */
+  label_box = gtk_notebook_get_tab_label (GTK_NOTEBOOK (notebook), GTK_WIDGET (view));
+  if (G_UNLIKELY (!GTK_IS_CONTAINER (label_box)))
+    return;
+
+  children = gtk_container_get_children (GTK_CONTAINER (label_box));
+  for (lp = children; lp != NULL; lp = lp->next)
+    if (GTK_IS_LABEL (lp->data))
+      gtk_widget_set_sensitive (lp->data, available);
+  g_list_free (children);
+}
+
+
+
+static void
+thunar_window_mount_health_changed (ThunarWindow *window)
+{
+  GtkWidget *notebooks[2] = { window->notebook_left, window->notebook_right };
+  GtkWidget *page;
+  guint      n;
+  gint       i;
+
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  for (n = 0; n < G_N_ELEMENTS (notebooks); ++n)
+    {
+      if (notebooks[n] == NULL)
+        continue;
+
+      for (i = 0; (page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebooks[n]), i)) != NULL; ++i)
+        thunar_window_notify_tab_availability (THUNAR_VIEW (page), NULL, window);
+    }
+}
+
+
+
 static gboolean
 thunar_window_save_paned (ThunarWindow *window)
 {
@@ -4065,6 +4354,9 @@ thunar_window_set_current_directory (ThunarWindow *window,
   if (G_UNLIKELY (window->current_directory == current_directory))
     return;
 
+  /* the view ends its search itself when it changes the directory */
+  thunar_window_search_close (window, FALSE);
+
   /* disconnect from the previously active directory */
   if (G_LIKELY (window->current_directory != NULL))
     {
@@ -4224,17 +4516,83 @@ thunar_window_get_directories (ThunarWindow *window,
 
 
 
+static gboolean
+thunar_window_restore_tabs_timer (gpointer user_data)
+{
+  ThunarWindow *window = THUNAR_WINDOW (user_data);
+  GtkWidget    *notebooks[] = { window->notebook_left, window->notebook_right };
+  GtkWidget    *deferred_view = NULL;
+  GtkWidget    *page;
+  guint         n;
+  gint          n_pages;
+  gint          i;
+
+  for (n = 0; n < G_N_ELEMENTS (notebooks); n++)
+    {
+      if (notebooks[n] == NULL)
+        continue;
+
+      n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (notebooks[n]));
+      for (i = 0; i < n_pages; i++)
+        {
+          page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebooks[n]), i);
+          if (!THUNAR_IS_STANDARD_VIEW (page))
+            continue;
+
+          /* load one folder at a time */
+          if (thunar_view_get_loading (THUNAR_VIEW (page)))
+            return TRUE;
+
+          if (deferred_view == NULL && thunar_standard_view_get_load_deferred (THUNAR_STANDARD_VIEW (page)))
+            deferred_view = page;
+        }
+    }
+
+  if (deferred_view != NULL)
+    {
+      thunar_standard_view_resume (THUNAR_STANDARD_VIEW (deferred_view));
+      return TRUE;
+    }
+
+  g_debug ("Restored the tabs of window \"%s\" in %" G_GINT64_FORMAT " ms",
+           gtk_window_get_role (GTK_WINDOW (window)),
+           (g_get_monotonic_time () - window->restore_start_time) / 1000);
+
+  window->restore_tabs_timer_id = 0;
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_window_set_directories:
+ * @window      : a #ThunarWindow.
+ * @uris        : the URIs of the directories to open in tabs.
+ * @active_page : the tab to select.
+ *
+ * Opens a tab for each directory in @uris, used to restore a window of
+ * the previous session. Only the first and the selected tab load their
+ * folder right away. The other tabs are created without loading their
+ * folder. They are loaded one after the other at low priority, or as
+ * soon as they are selected.
+ *
+ * Return value: %TRUE if at least one tab was opened.
+ **/
 gboolean
 thunar_window_set_directories (ThunarWindow   *window,
                                gchar         **uris,
                                gint            active_page)
 {
   ThunarFile *directory;
+  GType       view_type;
+  gint        n_pages;
   guint       n;
 
   _thunar_return_val_if_fail (THUNAR_IS_WINDOW (window), FALSE);
   _thunar_return_val_if_fail (uris != NULL, FALSE);
 
+  window->restore_start_time = g_get_monotonic_time ();
+
   for (n = 0; uris[n] != NULL; n++)
     {
       /* check if the string looks like an uri */
@@ -4249,10 +4607,16 @@ thunar_window_set_directories (ThunarWindow   *window,
       /* open the directory in a new notebook */
       if (thunar_file_is_directory (directory))
         {
-          if (gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected)) == 0)
-            thunar_window_set_current_directory (window, directory);
+          n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected));
+          if (n_pages == 0)
+            {
+              thunar_window_set_current_directory (window, directory);
+            }
           else
-            thunar_window_notebook_open_new_tab (window, directory);
+            {
+              view_type = thunar_window_view_type_for_directory (window, directory);
+              thunar_window_notebook_insert_page (window, directory, view_type, n_pages, NULL, n_pages != active_page);
+            }
         }
 
       g_object_unref (G_OBJECT (directory));
@@ -4261,8 +4625,19 @@ thunar_window_set_directories (ThunarWindow   *window,
   /* select the page */
   gtk_notebook_set_current_page (GTK_NOTEBOOK (window->notebook_selected), active_page);
 
+  n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected));
+  g_debug ("Created %d tabs of window \"%s\" in %" G_GINT64_FORMAT " ms", n_pages,
+           gtk_window_get_role (GTK_WINDOW (window)),
+           (g_get_monotonic_time () - window->restore_start_time) / 1000);
+
+  /* load the background tabs once the window is shown */
+  if (n_pages > 1 && window->restore_tabs_timer_id == 0)
+    window->restore_tabs_timer_id = g_timeout_add_full (G_PRIORITY_LOW, RESTORE_TABS_INTERVAL,
+                                                        thunar_window_restore_tabs_timer,
+                                                        window, NULL);
+
   /* we succeeded if new pages have been opened */
-  return gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected)) > 0;
+  return n_pages > 0;
 }
 
 
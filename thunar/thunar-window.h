@@ -53,6 +53,7 @@ typedef enum
   THUNAR_WINDOW_ACTION_VIEW_MENU,
   THUNAR_WINDOW_ACTION_RELOAD,
   THUNAR_WINDOW_ACTION_RELOAD_ALT,
+  THUNAR_WINDOW_ACTION_RELOAD_HARD,
   THUNAR_WINDOW_ACTION_VIEW_SPLIT,
   THUNAR_WINDOW_ACTION_VIEW_LOCATION_SELECTOR_MENU,
   THUNAR_WINDOW_ACTION_VIEW_LOCATION_SELECTOR_PATHBAR,
@@ -88,6 +89,7 @@ typedef enum
   THUNAR_WINDOW_ACTION_OPEN_TRASH,
   THUNAR_WINDOW_ACTION_OPEN_LOCATION,
   THUNAR_WINDOW_ACTION_OPEN_LOCATION_ALT,
+  THUNAR_WINDOW_ACTION_SEARCH,
   THUNAR_WINDOW_ACTION_OPEN_TEMPLATES,
   THUNAR_WINDOW_ACTION_OPEN_NETWORK,
   THUNAR_WINDOW_ACTION_HELP_MENU,
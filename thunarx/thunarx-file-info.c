@@ -38,7 +38,18 @@ enum
 
 
 
-static guint file_info_signals[LAST_SIGNAL];
+static void thunarx_file_info_list_prepare_thread (GTask        *task,
+                                                   gpointer      source_object,
+                                                   gpointer      task_data,
+                                                   GCancellable *cancellable);
+
+
+
+static guint  file_info_signals[LAST_SIGNAL];
+static GQuark thunarx_file_info_peek_name_quark;
+static GQuark thunarx_file_info_peek_mime_type_quark;
+static GQuark thunarx_file_info_peek_file_info_quark;
+static GQuark thunarx_file_info_peek_location_quark;
 
 /**
  * SECTION: thunarx-file-info
@@ -109,6 +120,12 @@ thunarx_file_info_get_type (void)
                       g_cclosure_marshal_VOID__VOID,
                       G_TYPE_NONE, 0);
 
+      /* quarks for the fallbacks of the peek methods */
+      thunarx_file_info_peek_name_quark = g_quark_from_static_string ("thunarx-file-info-peek-name");
+      thunarx_file_info_peek_mime_type_quark = g_quark_from_static_string ("thunarx-file-info-peek-mime-type");
+      thunarx_file_info_peek_file_info_quark = g_quark_from_static_string ("thunarx-file-info-peek-file-info");
+      thunarx_file_info_peek_location_quark = g_quark_from_static_string ("thunarx-file-info-peek-location");
+
       g_once_init_leave (&type__volatile, type);
     }
 
@@ -358,6 +375,160 @@ thunarx_file_info_get_location (ThunarxFileInfo *file_info)
 
 
 
+/**
+ * thunarx_file_info_peek_name:
+ * @file_info : a #ThunarxFileInfo.
+ *
+ * Like thunarx_file_info_get_name(), but returns a string
+ * owned by @file_info instead of a newly allocated copy.
+ * This avoids an allocation per call when an extension
+ * inspects many files, for example in a menu provider.
+ *
+ * Returns: (transfer none): the real name of the file represented
+ *          by @file_info. The string is owned by @file_info and
+ *          must not be freed.
+ *
+ * Since: 4.18
+ **/
+const gchar*
+thunarx_file_info_peek_name (ThunarxFileInfo *file_info)
+{
+  ThunarxFileInfoIface *iface;
+  gchar                *name;
+
+  g_return_val_if_fail (THUNARX_IS_FILE_INFO (file_info), NULL);
+
+  iface = THUNARX_FILE_INFO_GET_IFACE (file_info);
+  if (G_LIKELY (iface->peek_name != NULL))
+    return (*iface->peek_name) (file_info);
+
+  /* keep the result of get_name() around for implementations without peek_name() */
+  name = g_object_get_qdata (G_OBJECT (file_info), thunarx_file_info_peek_name_quark);
+  if (name == NULL)
+    {
+      name = (*iface->get_name) (file_info);
+      g_object_set_qdata_full (G_OBJECT (file_info), thunarx_file_info_peek_name_quark, name, g_free);
+    }
+
+  return name;
+}
+
+
+
+/**
+ * thunarx_file_info_peek_mime_type:
+ * @file_info : a #ThunarxFileInfo.
+ *
+ * Like thunarx_file_info_get_mime_type(), but returns a string
+ * owned by @file_info instead of a newly allocated copy.
+ *
+ * Determining the MIME-type may require I/O. Use
+ * thunarx_file_info_list_prepare_async() to have it loaded in
+ * the background first, if possible.
+ *
+ * Returns: (transfer none) (nullable): the MIME-type of @file_info.
+ *          The string is owned by @file_info and must not be freed.
+ *
+ * Since: 4.18
+ **/
+const gchar*
+thunarx_file_info_peek_mime_type (ThunarxFileInfo *file_info)
+{
+  ThunarxFileInfoIface *iface;
+  gchar                *mime_type;
+
+  g_return_val_if_fail (THUNARX_IS_FILE_INFO (file_info), NULL);
+
+  iface = THUNARX_FILE_INFO_GET_IFACE (file_info);
+  if (G_LIKELY (iface->peek_mime_type != NULL))
+    return (*iface->peek_mime_type) (file_info);
+
+  /* keep the result of get_mime_type() around for implementations without peek_mime_type() */
+  mime_type = g_object_get_qdata (G_OBJECT (file_info), thunarx_file_info_peek_mime_type_quark);
+  if (mime_type == NULL)
+    {
+      mime_type = (*iface->get_mime_type) (file_info);
+      g_object_set_qdata_full (G_OBJECT (file_info), thunarx_file_info_peek_mime_type_quark, mime_type, g_free);
+    }
+
+  return mime_type;
+}
+
+
+
+/**
+ * thunarx_file_info_peek_file_info:
+ * @file_info : a #ThunarxFileInfo.
+ *
+ * Like thunarx_file_info_get_file_info(), but does not take
+ * a reference on the returned #GFileInfo.
+ *
+ * Returns: (transfer none) (nullable): the #GFileInfo for @file_info.
+ *          It is owned by @file_info and must not be released.
+ *
+ * Since: 4.18
+ **/
+GFileInfo*
+thunarx_file_info_peek_file_info (ThunarxFileInfo *file_info)
+{
+  ThunarxFileInfoIface *iface;
+  GFileInfo            *info;
+
+  g_return_val_if_fail (THUNARX_IS_FILE_INFO (file_info), NULL);
+
+  iface = THUNARX_FILE_INFO_GET_IFACE (file_info);
+  if (G_LIKELY (iface->peek_file_info != NULL))
+    return (*iface->peek_file_info) (file_info);
+
+  info = g_object_get_qdata (G_OBJECT (file_info), thunarx_file_info_peek_file_info_quark);
+  if (info == NULL)
+    {
+      info = (*iface->get_file_info) (file_info);
+      if (G_LIKELY (info != NULL))
+        g_object_set_qdata_full (G_OBJECT (file_info), thunarx_file_info_peek_file_info_quark, info, g_object_unref);
+    }
+
+  return info;
+}
+
+
+
+/**
+ * thunarx_file_info_peek_location:
+ * @file_info : a #ThunarxFileInfo.
+ *
+ * Like thunarx_file_info_get_location(), but does not take
+ * a reference on the returned #GFile.
+ *
+ * Returns: (transfer none): the #GFile to which @file_info points.
+ *          It is owned by @file_info and must not be released.
+ *
+ * Since: 4.18
+ **/
+GFile*
+thunarx_file_info_peek_location (ThunarxFileInfo *file_info)
+{
+  ThunarxFileInfoIface *iface;
+  GFile                *location;
+
+  g_return_val_if_fail (THUNARX_IS_FILE_INFO (file_info), NULL);
+
+  iface = THUNARX_FILE_INFO_GET_IFACE (file_info);
+  if (G_LIKELY (iface->peek_location != NULL))
+    return (*iface->peek_location) (file_info);
+
+  location = g_object_get_qdata (G_OBJECT (file_info), thunarx_file_info_peek_location_quark);
+  if (location == NULL)
+    {
+      location = (*iface->get_location) (file_info);
+      g_object_set_qdata_full (G_OBJECT (file_info), thunarx_file_info_peek_location_quark, location, g_object_unref);
+    }
+
+  return location;
+}
+
+
+
 /**
  * thunarx_file_info_changed:
  * @file_info : a #ThunarxFileInfo.
@@ -444,3 +615,89 @@ thunarx_file_info_list_free (GList *file_infos)
 {
   g_list_free_full (file_infos, g_object_unref);
 }
+
+
+
+static void
+thunarx_file_info_list_prepare_thread (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable)
+{
+  ThunarxFileInfoIface *iface;
+  GList                *lp;
+
+  for (lp = task_data; lp != NULL; lp = lp->next)
+    {
+      if (g_task_return_error_if_cancelled (task))
+        return;
+
+      /* implementations without prepare() load everything on demand */
+      iface = THUNARX_FILE_INFO_GET_IFACE (lp->data);
+      if (iface->prepare != NULL)
+        (*iface->prepare) (lp->data, cancellable);
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+
+/**
+ * thunarx_file_info_list_prepare_async:
+ * @file_infos  : (element-type ThunarxFileInfo): a #GList of #ThunarxFileInfo<!---->s.
+ * @cancellable : (nullable): a #GCancellable or %NULL.
+ * @callback    : (scope async): the function to call when the files are prepared.
+ * @user_data   : (closure): data to pass to @callback.
+ *
+ * Loads the information of all @file_infos that may require I/O,
+ * like the MIME-type and the #GFileInfo, in a worker thread. Once
+ * @callback is invoked, the peek methods of the prepared files
+ * return without blocking.
+ *
+ * This allows extensions to inspect large selections without
+ * stalling the user interface on one synchronous query per file.
+ * The list is copied, so @file_infos may be released right away.
+ *
+ * Since: 4.18
+ **/
+void
+thunarx_file_info_list_prepare_async (GList              *file_infos,
+                                      GCancellable       *cancellable,
+                                      GAsyncReadyCallback callback,
+                                      gpointer            user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, thunarx_file_info_list_prepare_async);
+  g_task_set_task_data (task, thunarx_file_info_list_copy (file_infos), (GDestroyNotify) thunarx_file_info_list_free);
+  g_task_run_in_thread (task, thunarx_file_info_list_prepare_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * thunarx_file_info_list_prepare_finish:
+ * @result : the #GAsyncResult passed to the callback.
+ * @error  : return location for errors or %NULL.
+ *
+ * Finishes an operation started with thunarx_file_info_list_prepare_async().
+ *
+ * Returns: %TRUE if the files were prepared, %FALSE if the operation
+ *          was cancelled.
+ *
+ * Since: 4.18
+ **/
+gboolean
+thunarx_file_info_list_prepare_finish (GAsyncResult *result,
+                                       GError      **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
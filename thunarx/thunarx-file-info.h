@@ -80,6 +80,13 @@ typedef struct _ThunarxFileInfo      ThunarxFileInfo;
  * @get_file_info: See thunarx_file_info_get_file_info().
  * @get_filesystem_info: See thunarx_filesystem_info_get_filesystem_info().
  * @get_location: See thunarx_location_get_location().
+ * @peek_name: See thunarx_file_info_peek_name(). Since: 4.18
+ * @peek_mime_type: See thunarx_file_info_peek_mime_type(). Since: 4.18
+ * @peek_file_info: See thunarx_file_info_peek_file_info(). Since: 4.18
+ * @peek_location: See thunarx_file_info_peek_location(). Since: 4.18
+ * @prepare: Loads the information returned by the peek methods of a
+ *           single file. Called from a worker thread by
+ *           thunarx_file_info_list_prepare_async(). Since: 4.18
  * @changed: See thunarx_file_info_changed().
  * @renamed: See thunarx_file_info_renamed().
  *
@@ -111,13 +118,15 @@ struct _ThunarxFileInfoIface
   GFileInfo *(*get_filesystem_info) (ThunarxFileInfo *file_info);
   GFile     *(*get_location)        (ThunarxFileInfo *file_info);
 
+  const gchar *(*peek_name)         (ThunarxFileInfo *file_info);
+  const gchar *(*peek_mime_type)    (ThunarxFileInfo *file_info);
+  GFileInfo   *(*peek_file_info)    (ThunarxFileInfo *file_info);
+  GFile       *(*peek_location)     (ThunarxFileInfo *file_info);
+
+  void         (*prepare)           (ThunarxFileInfo *file_info,
+                                     GCancellable    *cancellable);
+
   /*< private >*/
-  void (*reserved0) (void);
-  void (*reserved1) (void);
-  void (*reserved2) (void);
-  void (*reserved3) (void);
-  void (*reserved4) (void);
-  void (*reserved5) (void);
   void (*reserved6) (void);
 
   /*< public >*/
@@ -149,6 +158,11 @@ GFileInfo *thunarx_file_info_get_file_info       (ThunarxFileInfo *file_info);
 GFileInfo *thunarx_file_info_get_filesystem_info (ThunarxFileInfo *file_info);
 GFile     *thunarx_file_info_get_location        (ThunarxFileInfo *file_info);
 
+const gchar *thunarx_file_info_peek_name         (ThunarxFileInfo *file_info);
+const gchar *thunarx_file_info_peek_mime_type    (ThunarxFileInfo *file_info);
+GFileInfo   *thunarx_file_info_peek_file_info    (ThunarxFileInfo *file_info);
+GFile       *thunarx_file_info_peek_location     (ThunarxFileInfo *file_info);
+
 void       thunarx_file_info_changed             (ThunarxFileInfo *file_info);
 void       thunarx_file_info_renamed             (ThunarxFileInfo *file_info);
 
@@ -160,6 +174,13 @@ GType      thunarx_file_info_list_get_type       (void) G_GNUC_CONST;
 GList     *thunarx_file_info_list_copy           (GList           *file_infos);
 void       thunarx_file_info_list_free           (GList           *file_infos);
 
+void       thunarx_file_info_list_prepare_async  (GList              *file_infos,
+                                                  GCancellable       *cancellable,
+                                                  GAsyncReadyCallback callback,
+                                                  gpointer            user_data);
+gboolean   thunarx_file_info_list_prepare_finish (GAsyncResult       *result,
+                                                  GError            **error);
+
 G_END_DECLS
 
 #endif /* !__THUNARX_FILE_INFO_H__ */
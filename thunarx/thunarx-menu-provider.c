@@ -22,6 +22,7 @@
 #include <config.h>
 #endif
 
+#include <thunarx/thunarx-menu.h>
 #include <thunarx/thunarx-menu-provider.h>
 #include <thunarx/thunarx-private.h>
 
@@ -51,6 +52,12 @@
  * menu items and menu items provided by other extensions. For example, the menu item provided
  * by the <systemitem class="library">ThunarOpenTerminal</systemitem> extension should be
  * called <literal>ThunarOpenTerminal::open-terminal</literal>.
+ *
+ * Extensions which cannot avoid slow operations, like querying the state of a
+ * version control system, should implement the get_file_menu_items_async() and
+ * get_file_menu_items_finish() virtual methods. The file manager then shows the
+ * context menu right away and adds the items once they are available, or drops
+ * them if the extension takes too long.
  */
 
 GType
@@ -252,3 +259,97 @@ thunarx_menu_provider_get_dnd_menu_items (ThunarxMenuProvider *provider,
 
   return items;
 }
+
+
+
+/**
+ * thunarx_menu_provider_get_file_menu_items_async: (skip)
+ * @provider    : a #ThunarxMenuProvider.
+ * @window      : the #GtkWindow within which the menu items will be used.
+ * @files       : (element-type ThunarxFileInfo): the list of #ThunarxFileInfo<!---->s
+ *                to which the menu items will be applied.
+ * @cancellable : (nullable): a #GCancellable or %NULL.
+ * @callback    : (scope async): the function to call when the menu items are available.
+ * @user_data   : (closure): data to pass to @callback.
+ *
+ * Asynchronous version of thunarx_menu_provider_get_file_menu_items(). If
+ * @provider does not implement the asynchronous virtual methods, the
+ * synchronous method is used and @callback is invoked from the main loop.
+ *
+ * The caller should cancel @cancellable if it is no longer interested
+ * in the result, i.e. when the menu was closed.
+ *
+ * Since: 4.18
+ **/
+void
+thunarx_menu_provider_get_file_menu_items_async (ThunarxMenuProvider *provider,
+                                                 GtkWidget           *window,
+                                                 GList               *files,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data)
+{
+  ThunarxMenuProviderIface *iface;
+  GTask                    *task;
+  GList                    *items = NULL;
+
+  g_return_if_fail (THUNARX_IS_MENU_PROVIDER (provider));
+  g_return_if_fail (GTK_IS_WINDOW (window));
+  g_return_if_fail (files != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  iface = THUNARX_MENU_PROVIDER_GET_IFACE (provider);
+  if (iface->get_file_menu_items_async != NULL && iface->get_file_menu_items_finish != NULL)
+    {
+      (*iface->get_file_menu_items_async) (provider, window, files, cancellable, callback, user_data);
+      return;
+    }
+
+  /* fall back to the synchronous method */
+  if (iface->get_file_menu_items != NULL)
+    items = (*iface->get_file_menu_items) (provider, window, files);
+
+  task = g_task_new (provider, cancellable, callback, user_data);
+  g_task_set_source_tag (task, thunarx_menu_provider_get_file_menu_items_async);
+  g_task_return_pointer (task, items, (GDestroyNotify) thunarx_menu_item_list_free);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * thunarx_menu_provider_get_file_menu_items_finish: (skip)
+ * @provider : a #ThunarxMenuProvider.
+ * @result   : the #GAsyncResult passed to the callback.
+ * @error    : return location for errors or %NULL.
+ *
+ * Finishes an operation started with thunarx_menu_provider_get_file_menu_items_async().
+ * Like thunarx_menu_provider_get_file_menu_items(), this takes a reference
+ * on @provider for every returned #ThunarxMenuItem.
+ *
+ * Returns: (transfer full) (element-type ThunarxMenuItem): the list of #ThunarxMenuItem<!---->s
+ *          that @provider has to offer, or %NULL on error.
+ *
+ * Since: 4.18
+ **/
+GList*
+thunarx_menu_provider_get_file_menu_items_finish (ThunarxMenuProvider *provider,
+                                                  GAsyncResult        *result,
+                                                  GError             **error)
+{
+  GList *items;
+
+  g_return_val_if_fail (THUNARX_IS_MENU_PROVIDER (provider), NULL);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (g_async_result_is_tagged (result, thunarx_menu_provider_get_file_menu_items_async))
+    items = g_task_propagate_pointer (G_TASK (result), error);
+  else
+    items = (*THUNARX_MENU_PROVIDER_GET_IFACE (provider)->get_file_menu_items_finish) (provider, result, error);
+
+  /* take a reference on the provider for each menu item */
+  thunarx_object_list_take_reference (items, provider);
+
+  return items;
+}
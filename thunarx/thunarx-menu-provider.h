@@ -44,6 +44,8 @@ typedef struct _ThunarxMenuProvider      ThunarxMenuProvider;
  * @get_file_menu_items: See thunarx_menu_provider_get_file_menu_items().
  * @get_folder_menu_items: See thunarx_menu_provider_get_folder_menu_items().
  * @get_dnd_menu_items: See thunarx_menu_provider_get_dnd_menu_items().
+ * @get_file_menu_items_async: See thunarx_menu_provider_get_file_menu_items_async(). Since: 4.18
+ * @get_file_menu_items_finish: See thunarx_menu_provider_get_file_menu_items_finish(). Since: 4.18
  *
  * Interface with virtual methods implemented by extensions that provide
  * additional menu items for the file manager's context menus.
@@ -70,9 +72,17 @@ struct _ThunarxMenuProviderIface
                                     ThunarxFileInfo     *folder,
                                     GList               *files);
 
+  void   (*get_file_menu_items_async)  (ThunarxMenuProvider *provider,
+                                        GtkWidget           *window,
+                                        GList               *files,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data);
+  GList *(*get_file_menu_items_finish) (ThunarxMenuProvider *provider,
+                                        GAsyncResult        *result,
+                                        GError             **error);
+
   /*< private >*/
-  void (*reserved1) (void);
-  void (*reserved2) (void);
   void (*reserved3) (void);
 };
 
@@ -91,6 +101,17 @@ GList *thunarx_menu_provider_get_dnd_menu_items    (ThunarxMenuProvider *provide
                                                     ThunarxFileInfo     *folder,
                                                     GList               *files) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+void   thunarx_menu_provider_get_file_menu_items_async  (ThunarxMenuProvider *provider,
+                                                         GtkWidget           *window,
+                                                         GList               *files,
+                                                         GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data);
+
+GList *thunarx_menu_provider_get_file_menu_items_finish (ThunarxMenuProvider *provider,
+                                                         GAsyncResult        *result,
+                                                         GError             **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
 G_END_DECLS
 
 #endif /* !__THUNARX_MENU_PROVIDER_H__ */
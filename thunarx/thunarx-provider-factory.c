@@ -22,6 +22,10 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <gdk/gdk.h>
 
 #include <thunarx/thunarx-private.h>
@@ -34,12 +38,26 @@
 /* "provider cache" cleanup interval (in seconds) */
 #define THUNARX_PROVIDER_FACTORY_INTERVAL (45)
 
+/* suffix and group of the file next to a module, which lists the
+ * provider interfaces the module implements, e.g. "foo.providers":
+ *
+ *   [Thunarx Extension]
+ *   Providers=ThunarxMenuProvider;ThunarxPreferencesProvider;
+ *
+ * Modules with such a file are only loaded once one of the listed
+ * interfaces is requested, all others on the first request.
+ */
+#define THUNARX_PROVIDER_FACTORY_MANIFEST_SUFFIX ".providers"
+#define THUNARX_PROVIDER_FACTORY_MANIFEST_GROUP  "Thunarx Extension"
+
 
 
 static void     thunarx_provider_factory_finalize       (GObject                     *object);
 static void     thunarx_provider_factory_add            (ThunarxProviderFactory      *factory,
                                                          ThunarxProviderModule       *module);
 static GList   *thunarx_provider_factory_load_modules   (ThunarxProviderFactory      *factory);
+static GList   *thunarx_provider_factory_load_pending   (ThunarxProviderFactory      *factory,
+                                                         GType                        type);
 static gboolean thunarx_provider_factory_timer          (gpointer                     user_data);
 static void     thunarx_provider_factory_timer_destroy  (gpointer                     user_data);
 
@@ -60,6 +78,12 @@ typedef struct
   GType    type;      /* provider GType */
 } ThunarxProviderInfo;
 
+typedef struct
+{
+  ThunarxProviderModule  *module;     /* the module, not loaded yet */
+  gchar                 **providers;  /* the interfaces implemented by the module */
+} ThunarxProviderPending;
+
 struct _ThunarxProviderFactoryClass
 {
   GObjectClass __parent__;
@@ -72,6 +96,8 @@ struct _ThunarxProviderFactory
   ThunarxProviderInfo *infos;     /* provider types and cached provider references */
   gint                 n_infos;   /* number of items in the infos array */
 
+  GList               *pending;   /* modules loaded once their interfaces are requested */
+
   guint                timer_id;  /* GSource timer to cleanup cached providers */
 };
 
@@ -103,12 +129,26 @@ thunarx_provider_factory_init (ThunarxProviderFactory *factory)
 
 
 
+static void
+thunarx_provider_pending_free (gpointer data)
+{
+  ThunarxProviderPending *pending = data;
+
+  g_strfreev (pending->providers);
+  g_slice_free (ThunarxProviderPending, pending);
+}
+
+
+
 static void
 thunarx_provider_factory_finalize (GObject *object)
 {
   ThunarxProviderFactory *factory = THUNARX_PROVIDER_FACTORY (object);
   gint                    n;
 
+  /* forget about the modules that were never needed */
+  g_list_free_full (factory->pending, thunarx_provider_pending_free);
+
   /* stop the "provider cache" cleanup timer */
   if (G_LIKELY (factory->timer_id != 0))
     g_source_remove (factory->timer_id);
@@ -146,14 +186,42 @@ thunarx_provider_factory_add (ThunarxProviderFactory *factory,
 
 
 
+static gchar**
+thunarx_provider_factory_read_manifest (const gchar *name)
+{
+  GKeyFile  *key_file;
+  gchar    **providers;
+  gchar     *basename;
+  gchar     *path;
+
+  basename = g_strconcat (name, THUNARX_PROVIDER_FACTORY_MANIFEST_SUFFIX, NULL);
+  path = g_build_filename (THUNARX_DIRECTORY, basename, NULL);
+  g_free (basename);
+
+  key_file = g_key_file_new ();
+  if (g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
+    providers = g_key_file_get_string_list (key_file, THUNARX_PROVIDER_FACTORY_MANIFEST_GROUP, "Providers", NULL, NULL);
+  else
+    providers = NULL;
+  g_key_file_free (key_file);
+  g_free (path);
+
+  return providers;
+}
+
+
+
 static GList*
 thunarx_provider_factory_load_modules (ThunarxProviderFactory *factory)
 {
-  ThunarxProviderModule *module;
-  const gchar           *name;
-  GList                 *modules = NULL;
-  GList                 *lp;
-  GDir                  *dp;
+  ThunarxProviderPending *pending;
+  ThunarxProviderModule  *module;
+  const gchar            *name;
+  GList                  *modules = NULL;
+  GList                  *lp;
+  GDir                   *dp;
+  gchar                 **providers;
+  gchar                  *module_name;
 
   dp = g_dir_open (THUNARX_DIRECTORY, 0, NULL);
   if (G_LIKELY (dp != NULL))
@@ -187,8 +255,19 @@ thunarx_provider_factory_load_modules (ThunarxProviderFactory *factory)
                   thunarx_provider_modules = g_list_prepend (thunarx_provider_modules, module);
                 }
 
-              /* try to load the module */
-              if (g_type_module_use (G_TYPE_MODULE (module)))
+              /* check if the module tells which interfaces it implements */
+              module_name = g_strndup (name, strlen (name) - strlen ("." G_MODULE_SUFFIX));
+              providers = thunarx_provider_factory_read_manifest (module_name);
+              g_free (module_name);
+              if (providers != NULL)
+                {
+                  /* load the module once one of the interfaces is requested */
+                  pending = g_slice_new (ThunarxProviderPending);
+                  pending->module = module;
+                  pending->providers = providers;
+                  factory->pending = g_list_prepend (factory->pending, pending);
+                }
+              else if (g_type_module_use (G_TYPE_MODULE (module)))
                 {
                   /* add the types provided by the module */
                   thunarx_provider_factory_add (factory, module);
@@ -207,6 +286,66 @@ thunarx_provider_factory_load_modules (ThunarxProviderFactory *factory)
 
 
 
+static gboolean
+thunarx_provider_factory_provides (ThunarxProviderPending *pending,
+                                   GType                   type)
+{
+  GType provider_type;
+  guint n;
+
+  for (n = 0; pending->providers[n] != NULL; ++n)
+    {
+      /* the interface may not be registered yet */
+      if (strcmp (pending->providers[n], g_type_name (type)) == 0)
+        return TRUE;
+
+      provider_type = g_type_from_name (pending->providers[n]);
+      if (provider_type != 0 && g_type_is_a (provider_type, type))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+
+static GList*
+thunarx_provider_factory_load_pending (ThunarxProviderFactory *factory,
+                                       GType                   type)
+{
+  ThunarxProviderPending *pending;
+  GList                  *modules = NULL;
+  GList                  *lp;
+  GList                  *next;
+
+  for (lp = factory->pending; lp != NULL; lp = next)
+    {
+      next = lp->next;
+      pending = lp->data;
+
+      if (!thunarx_provider_factory_provides (pending, type))
+        continue;
+
+      /* try to load the module */
+      if (g_type_module_use (G_TYPE_MODULE (pending->module)))
+        {
+          /* add the types provided by the module */
+          thunarx_provider_factory_add (factory, pending->module);
+
+          /* add the module to our list */
+          modules = g_list_prepend (modules, pending->module);
+        }
+
+      /* the module is never tried again */
+      factory->pending = g_list_delete_link (factory->pending, lp);
+      thunarx_provider_pending_free (pending);
+    }
+
+  return modules;
+}
+
+
+
 static gboolean
 thunarx_provider_factory_timer (gpointer user_data)
 {
@@ -313,6 +452,10 @@ thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
                                                       thunarx_provider_factory_timer_destroy);
     }
 
+  /* load the modules that wait for this type of provider */
+  if (factory->pending != NULL)
+    modules = g_list_concat (modules, thunarx_provider_factory_load_pending (factory, type));
+
   /* determine all available providers for the type */
   for (info = factory->infos, n = factory->n_infos; --n >= 0; ++info)
     if (G_LIKELY (g_type_is_a (info->type, type)))
@@ -332,7 +475,7 @@ thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
         providers = g_list_append (providers, info->provider);
       }
 
-  /* check if we were initialized by this method invocation */
+  /* check if modules were loaded by this method invocation */
   if (G_UNLIKELY (modules != NULL))
     {
       /* unload all non-persistent modules */
@@ -345,3 +488,42 @@ thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
 
   return providers;
 }
+
+
+
+/**
+ * thunarx_provider_factory_get_stats:
+ * @factory   : a #ThunarxProviderFactory instance.
+ * @n_types   : (out) (optional): return location for the number of provider types or %NULL.
+ * @n_cached  : (out) (optional): return location for the number of cached providers or %NULL.
+ * @n_modules : (out) (optional): return location for the number of loaded modules or %NULL.
+ *
+ * Returns how many provider types @factory knows, how many providers
+ * it currently keeps in its cache and how many extension modules were
+ * loaded. Applications can use this to account for the memory held
+ * by extensions.
+ *
+ * Since: 4.18
+ **/
+void
+thunarx_provider_factory_get_stats (ThunarxProviderFactory *factory,
+                                    guint                  *n_types,
+                                    guint                  *n_cached,
+                                    guint                  *n_modules)
+{
+  guint cached = 0;
+  gint  n;
+
+  g_return_if_fail (THUNARX_IS_PROVIDER_FACTORY (factory));
+
+  for (n = 0; n < factory->n_infos; ++n)
+    if (factory->infos[n].provider != NULL)
+      ++cached;
+
+  if (n_types != NULL)
+    *n_types = factory->n_infos;
+  if (n_cached != NULL)
+    *n_cached = cached;
+  if (n_modules != NULL)
+    *n_modules = g_list_length (thunarx_provider_modules);
+}
@@ -46,6 +46,11 @@ ThunarxProviderFactory *thunarx_provider_factory_get_default    (void);
 GList                  *thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
                                                                  GType                   type) G_GNUC_MALLOC;
 
+void                    thunarx_provider_factory_get_stats      (ThunarxProviderFactory *factory,
+                                                                 guint                  *n_types,
+                                                                 guint                  *n_cached,
+                                                                 guint                  *n_modules);
+
 G_END_DECLS
 
 #endif /* !__THUNARX_PROVIDER_FACTORY_H__ */
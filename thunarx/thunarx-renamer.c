@@ -725,3 +725,123 @@ thunarx_renamer_changed (ThunarxRenamer *renamer)
   g_return_if_fail (THUNARX_IS_RENAMER (renamer));
   g_signal_emit (G_OBJECT (renamer), renamer_signals[CHANGED], 0);
 }
+
+
+
+/**
+ * thunarx_renamer_supports_snapshots:
+ * @renamer : a #ThunarxRenamer.
+ *
+ * Checks whether @renamer implements the snapshot methods of
+ * #ThunarxRenamerClass, so names can be processed outside the
+ * main thread, see thunarx_renamer_snapshot().
+ *
+ * Return value: %TRUE if @renamer supports snapshots.
+ *
+ * Since: 4.18
+ **/
+gboolean
+thunarx_renamer_supports_snapshots (ThunarxRenamer *renamer)
+{
+  ThunarxRenamerClass *klass;
+
+  g_return_val_if_fail (THUNARX_IS_RENAMER (renamer), FALSE);
+
+  klass = THUNARX_RENAMER_GET_CLASS (renamer);
+  return (klass->snapshot != NULL && klass->process_snapshot != NULL && klass->free_snapshot != NULL);
+}
+
+
+
+/**
+ * thunarx_renamer_snapshot:
+ * @renamer : a #ThunarxRenamer.
+ *
+ * Takes a snapshot of the current settings of @renamer. The
+ * snapshot must contain everything the renamer needs to process
+ * names, it is used with thunarx_renamer_process_snapshot() from
+ * other threads while the settings of @renamer keep changing.
+ *
+ * Renamers implement this by overriding the snapshot, process_snapshot
+ * and free_snapshot methods of #ThunarxRenamerClass together. The
+ * implementation may return %NULL if the current settings cannot be
+ * processed from other threads, thunarx_renamer_process() is used
+ * then.
+ *
+ * This method may only be called from the main thread.
+ *
+ * The caller is responsible to free the returned snapshot using
+ * thunarx_renamer_free_snapshot() when no longer needed.
+ *
+ * Return value: the snapshot of the settings of @renamer or %NULL.
+ *
+ * Since: 4.18
+ **/
+gpointer
+thunarx_renamer_snapshot (ThunarxRenamer *renamer)
+{
+  g_return_val_if_fail (thunarx_renamer_supports_snapshots (renamer), NULL);
+  return (*THUNARX_RENAMER_GET_CLASS (renamer)->snapshot) (renamer);
+}
+
+
+
+/**
+ * thunarx_renamer_process_snapshot:
+ * @renamer  : a #ThunarxRenamer.
+ * @snapshot : a snapshot from thunarx_renamer_snapshot().
+ * @file     : the #ThunarxFileInfo for the file whose new
+ *             name should be determined.
+ * @text     : the part of the filename to which the
+ *             @renamer should be applied.
+ * @index    : the index of the file in the list, used
+ *             for renamers that work on numbering.
+ *
+ * Works like thunarx_renamer_process(), but uses the settings
+ * stored in @snapshot instead of the current settings of @renamer.
+ *
+ * This method may be called from any thread, also for the same
+ * @snapshot at the same time. Implementations must not touch
+ * @renamer or call into GTK+, and must only read from @file.
+ *
+ * The caller is responsible to free the returned string using
+ * g_free() when no longer needed.
+ *
+ * Return value: the string with which to replace @text.
+ *
+ * Since: 4.18
+ **/
+gchar*
+thunarx_renamer_process_snapshot (ThunarxRenamer  *renamer,
+                                  gconstpointer    snapshot,
+                                  ThunarxFileInfo *file,
+                                  const gchar     *text,
+                                  guint            index)
+{
+  g_return_val_if_fail (THUNARX_IS_FILE_INFO (file), NULL);
+  g_return_val_if_fail (THUNARX_IS_RENAMER (renamer), NULL);
+  g_return_val_if_fail (snapshot != NULL, NULL);
+  g_return_val_if_fail (g_utf8_validate (text, -1, NULL), NULL);
+  return (*THUNARX_RENAMER_GET_CLASS (renamer)->process_snapshot) (snapshot, file, text, index);
+}
+
+
+
+/**
+ * thunarx_renamer_free_snapshot:
+ * @renamer  : a #ThunarxRenamer.
+ * @snapshot : a snapshot from thunarx_renamer_snapshot().
+ *
+ * Releases the @snapshot previously taken from @renamer.
+ *
+ * Since: 4.18
+ **/
+void
+thunarx_renamer_free_snapshot (ThunarxRenamer *renamer,
+                               gpointer        snapshot)
+{
+  g_return_if_fail (THUNARX_IS_RENAMER (renamer));
+
+  if (G_LIKELY (snapshot != NULL))
+    (*THUNARX_RENAMER_GET_CLASS (renamer)->free_snapshot) (snapshot);
+}
@@ -48,6 +48,9 @@ typedef struct _ThunarxRenamer        ThunarxRenamer;
  * @load:           see thunarx_renamer_load().
  * @save:           see thunarx_renamer_save().
  * @get_menu_items: see thunarx_renamer_get_menu_items().
+ * @snapshot:       see thunarx_renamer_snapshot().
+ * @process_snapshot: see thunarx_renamer_process_snapshot().
+ * @free_snapshot:  see thunarx_renamer_free_snapshot().
  * @changed:        see thunarx_renamer_changed().
  *
  * Abstract base class with virtual methods implemented by extensions
@@ -78,10 +81,15 @@ struct _ThunarxRenamerClass
                             GtkWindow       *window,
                             GList           *files);
 
+  /* thread-safe processing (optional) */
+  gpointer (*snapshot)         (ThunarxRenamer  *renamer);
+  gchar   *(*process_snapshot) (gconstpointer    snapshot,
+                                ThunarxFileInfo *file,
+                                const gchar     *text,
+                                guint            index);
+  void     (*free_snapshot)    (gpointer         snapshot);
+
   /*< private >*/
-  void (*reserved0) (void);
-  void (*reserved1) (void);
-  void (*reserved2) (void);
   void (*reserved3) (void);
   void (*reserved4) (void);
 
@@ -130,6 +138,16 @@ GList       *thunarx_renamer_get_menu_items (ThunarxRenamer   *renamer,
 
 void         thunarx_renamer_changed        (ThunarxRenamer   *renamer);
 
+gboolean     thunarx_renamer_supports_snapshots (ThunarxRenamer  *renamer);
+gpointer     thunarx_renamer_snapshot           (ThunarxRenamer  *renamer);
+gchar       *thunarx_renamer_process_snapshot   (ThunarxRenamer  *renamer,
+                                                 gconstpointer    snapshot,
+                                                 ThunarxFileInfo *file,
+                                                 const gchar     *text,
+                                                 guint            index) G_GNUC_MALLOC;
+void         thunarx_renamer_free_snapshot      (ThunarxRenamer  *renamer,
+                                                 gpointer         snapshot);
+
 G_END_DECLS
 
 #endif /* !__THUNARX_RENAMER_H__ */